@@ -17,12 +17,38 @@
 #ifndef TINK_AEAD_H_
 #define TINK_AEAD_H_
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/util/output_buffer_factory.h"
+#include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
 namespace crypto {
 namespace tink {
 
+///////////////////////////////////////////////////////////////////////////////
+// An AEAD bound to one fixed associated data, as returned by
+// Aead::PrepareAssociatedData(). Encrypting and decrypting with it is the
+// same as calling the Aead with that associated data.
+class PreparedAead {
+ public:
+  virtual crypto::tink::util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext) const = 0;
+
+  virtual crypto::tink::util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext) const = 0;
+
+  virtual ~PreparedAead() {}
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // The interface for authenticated encryption with associated data.
 // Implementations of this interface are secure against adaptive
@@ -49,9 +75,325 @@ class Aead {
       absl::string_view ciphertext,
       absl::string_view associated_data) const = 0;
 
+  // Returns the size of the ciphertext that Encrypt() and EncryptInto()
+  // produce for a plaintext of 'plaintext_size' bytes. Implementations which
+  // cannot compute the size in advance return an UNIMPLEMENTED status.
+  virtual crypto::tink::util::StatusOr<int64_t> CiphertextSize(
+      int64_t plaintext_size) const {
+    return crypto::tink::util::Status(
+        crypto::tink::util::error::UNIMPLEMENTED,
+        "CiphertextSize() is not supported by this Aead");
+  }
+
+  // Encrypts 'plaintext' like Encrypt(), but writes the ciphertext to
+  // 'ciphertext_buffer' and returns the number of bytes written.
+  // 'ciphertext_buffer' must hold at least CiphertextSize(plaintext.size())
+  // bytes and must not overlap with 'plaintext'.
+  //
+  // Implementations which can encrypt directly into the buffer should
+  // override this method; the default implementation calls Encrypt() and
+  // copies the result.
+  virtual crypto::tink::util::StatusOr<int64_t> EncryptInto(
+      absl::string_view plaintext, absl::string_view associated_data,
+      absl::Span<char> ciphertext_buffer) const {
+    auto ciphertext_result = Encrypt(plaintext, associated_data);
+    if (!ciphertext_result.ok()) return ciphertext_result.status();
+    const std::string& ciphertext = ciphertext_result.ValueOrDie();
+    if (ciphertext_buffer.size() < ciphertext.size()) {
+      return crypto::tink::util::Status(
+          crypto::tink::util::error::INVALID_ARGUMENT,
+          "ciphertext_buffer is too small");
+    }
+    if (!ciphertext.empty()) {
+      std::memcpy(ciphertext_buffer.data(), ciphertext.data(),
+                  ciphertext.size());
+    }
+    return ciphertext.size();
+  }
+
+  // Decrypts 'ciphertext' like Decrypt(), but writes the plaintext to
+  // 'plaintext_buffer' and returns the number of bytes written.
+  // 'plaintext_buffer' must not overlap with 'ciphertext' and must be large
+  // enough to hold the plaintext; ciphertext.size() bytes always suffice.
+  // If decryption fails the contents of 'plaintext_buffer' are unspecified.
+  //
+  // Implementations which can decrypt directly into the buffer should
+  // override this method; the default implementation calls Decrypt() and
+  // copies the result.
+  virtual crypto::tink::util::StatusOr<int64_t> DecryptInto(
+      absl::string_view ciphertext, absl::string_view associated_data,
+      absl::Span<char> plaintext_buffer) const {
+    auto plaintext_result = Decrypt(ciphertext, associated_data);
+    if (!plaintext_result.ok()) return plaintext_result.status();
+    const std::string& plaintext = plaintext_result.ValueOrDie();
+    if (plaintext_buffer.size() < plaintext.size()) {
+      return crypto::tink::util::Status(
+          crypto::tink::util::error::INVALID_ARGUMENT,
+          "plaintext_buffer is too small");
+    }
+    if (!plaintext.empty()) {
+      std::memcpy(plaintext_buffer.data(), plaintext.data(), plaintext.size());
+    }
+    return plaintext.size();
+  }
+
+  // Encrypts the concatenation of 'plaintext_parts' like EncryptInto(),
+  // without requiring the caller to concatenate the parts first. The
+  // ciphertext is the same as that of EncryptInto() on the concatenation.
+  // 'ciphertext_buffer' must not overlap with any of the parts.
+  //
+  // Implementations which can consume the parts one by one should override
+  // this method; the default implementation concatenates the parts and calls
+  // EncryptInto().
+  virtual crypto::tink::util::StatusOr<int64_t> EncryptGatherInto(
+      absl::Span<const absl::string_view> plaintext_parts,
+      absl::string_view associated_data,
+      absl::Span<char> ciphertext_buffer) const {
+    if (plaintext_parts.size() == 1) {
+      return EncryptInto(plaintext_parts[0], associated_data,
+                         ciphertext_buffer);
+    }
+    std::string plaintext;
+    for (absl::string_view part : plaintext_parts) {
+      plaintext.append(part.data(), part.size());
+    }
+    return EncryptInto(plaintext, associated_data, ciphertext_buffer);
+  }
+
+  // Decrypts 'ciphertext' like DecryptInto(), but writes the plaintext to
+  // 'plaintext_buffers', filling each of them completely before moving on to
+  // the next one, and returns the total number of bytes written. The buffers
+  // must not overlap with 'ciphertext' or with each other.
+  // If decryption fails the contents of the buffers are unspecified.
+  //
+  // Implementations which can decrypt directly into the buffers should
+  // override this method; the default implementation decrypts into a
+  // temporary buffer and copies the result.
+  virtual crypto::tink::util::StatusOr<int64_t> DecryptScatterInto(
+      absl::string_view ciphertext, absl::string_view associated_data,
+      absl::Span<const absl::Span<char>> plaintext_buffers) const {
+    if (plaintext_buffers.size() == 1) {
+      return DecryptInto(ciphertext, associated_data, plaintext_buffers[0]);
+    }
+    std::string plaintext(ciphertext.size(), '\0');
+    auto written_result = DecryptInto(ciphertext, associated_data,
+                                      absl::MakeSpan(&plaintext[0],
+                                                     plaintext.size()));
+    if (!written_result.ok()) return written_result.status();
+    absl::string_view remaining(plaintext.data(), written_result.ValueOrDie());
+    for (absl::Span<char> buffer : plaintext_buffers) {
+      size_t count = std::min(buffer.size(), remaining.size());
+      if (count > 0) std::memcpy(buffer.data(), remaining.data(), count);
+      remaining.remove_prefix(count);
+    }
+    if (!remaining.empty()) {
+      return crypto::tink::util::Status(
+          crypto::tink::util::error::INVALID_ARGUMENT,
+          "plaintext_buffers are too small");
+    }
+    return written_result.ValueOrDie();
+  }
+
+  // Decrypts 'ciphertext' with 'associated_data' as associated data in
+  // place, and returns the part of 'ciphertext' which holds the plaintext.
+  // If decryption fails the contents of 'ciphertext' are unspecified; in
+  // particular, they may have been overwritten.
+  //
+  // Implementations which can decrypt without a separate output buffer
+  // should override this method; the default implementation decrypts into a
+  // temporary buffer and copies the result to the start of 'ciphertext'.
+  virtual crypto::tink::util::StatusOr<absl::Span<char>> DecryptInPlace(
+      absl::Span<char> ciphertext, absl::string_view associated_data) const {
+    std::string plaintext(ciphertext.size(), '\0');
+    auto written_result = DecryptInto(
+        absl::string_view(ciphertext.data(), ciphertext.size()),
+        associated_data, absl::MakeSpan(&plaintext[0], plaintext.size()));
+    if (!written_result.ok()) return written_result.status();
+    size_t written = written_result.ValueOrDie();
+    if (written > 0) std::memcpy(ciphertext.data(), plaintext.data(), written);
+    return ciphertext.subspan(0, written);
+  }
+
+  // Encrypts 'plaintext' like Encrypt(), but writes the ciphertext to a
+  // buffer from 'new_buffer' and returns the part of it holding the
+  // ciphertext.
+  //
+  // The default implementation asks for CiphertextSize() bytes and calls
+  // EncryptInto() if the size is known, and copies the result of Encrypt()
+  // otherwise.
+  virtual crypto::tink::util::StatusOr<absl::Span<char>> EncryptToBuffer(
+      absl::string_view plaintext, absl::string_view associated_data,
+      const crypto::tink::util::OutputBufferFactory& new_buffer) const {
+    auto size_result = CiphertextSize(plaintext.size());
+    if (!size_result.ok()) {
+      auto ciphertext_result = Encrypt(plaintext, associated_data);
+      if (!ciphertext_result.ok()) return ciphertext_result.status();
+      return crypto::tink::util::internal::CopyToNewBuffer(
+          ciphertext_result.ValueOrDie(), new_buffer);
+    }
+    auto buffer_result = crypto::tink::util::internal::NewOutputBuffer(
+        new_buffer, size_result.ValueOrDie());
+    if (!buffer_result.ok()) return buffer_result.status();
+    absl::Span<char> buffer = buffer_result.ValueOrDie();
+    auto written_result = EncryptInto(plaintext, associated_data, buffer);
+    if (!written_result.ok()) return written_result.status();
+    return buffer.subspan(0, written_result.ValueOrDie());
+  }
+
+  // Decrypts 'ciphertext' like Decrypt(), but writes the plaintext to a
+  // buffer from 'new_buffer' and returns the part of it holding the
+  // plaintext.
+  //
+  // The default implementation asks for ciphertext.size() bytes and calls
+  // DecryptInto().
+  virtual crypto::tink::util::StatusOr<absl::Span<char>> DecryptToBuffer(
+      absl::string_view ciphertext, absl::string_view associated_data,
+      const crypto::tink::util::OutputBufferFactory& new_buffer) const {
+    auto buffer_result = crypto::tink::util::internal::NewOutputBuffer(
+        new_buffer, ciphertext.size());
+    if (!buffer_result.ok()) return buffer_result.status();
+    absl::Span<char> buffer = buffer_result.ValueOrDie();
+    auto written_result = DecryptInto(ciphertext, associated_data, buffer);
+    if (!written_result.ok()) return written_result.status();
+    return buffer.subspan(0, written_result.ValueOrDie());
+  }
+
+  // Encrypts each of 'plaintexts' with the corresponding entry of
+  // 'associated_data' as associated data, which must have the same number of
+  // elements. The ciphertexts are stored back to back in 'ciphertexts', and
+  // 'offsets' is set to plaintexts.size() + 1 positions such that ciphertext i
+  // occupies the bytes [offsets[i], offsets[i + 1]) of 'ciphertexts'.
+  // Fails as a whole if any of the records cannot be encrypted.
+  //
+  // Implementations should override this method if they can amortize
+  // per-call work over the batch; the default implementation calls
+  // EncryptInto() for each record if CiphertextSize() is supported, and
+  // Encrypt() otherwise.
+  virtual crypto::tink::util::Status EncryptBatch(
+      absl::Span<const absl::string_view> plaintexts,
+      absl::Span<const absl::string_view> associated_data,
+      std::string* ciphertexts, std::vector<int64_t>* offsets) const {
+    if (plaintexts.size() != associated_data.size()) {
+      return crypto::tink::util::Status(
+          crypto::tink::util::error::INVALID_ARGUMENT,
+          "plaintexts and associated_data must have the same size");
+    }
+    ciphertexts->clear();
+    offsets->assign(1, 0);
+    offsets->reserve(plaintexts.size() + 1);
+
+    // If the ciphertext sizes are known in advance, encrypt all records in
+    // place into a single buffer.
+    int64_t total_size = 0;
+    for (absl::string_view plaintext : plaintexts) {
+      auto size_result = CiphertextSize(plaintext.size());
+      if (!size_result.ok()) {
+        total_size = -1;
+        break;
+      }
+      total_size += size_result.ValueOrDie();
+    }
+    if (total_size >= 0) {
+      ciphertexts->resize(total_size);
+      absl::Span<char> buffer = absl::MakeSpan(&(*ciphertexts)[0], total_size);
+      int64_t position = 0;
+      for (size_t i = 0; i < plaintexts.size(); i++) {
+        auto written = EncryptInto(plaintexts[i], associated_data[i],
+                                   buffer.subspan(position));
+        if (!written.ok()) {
+          ciphertexts->clear();
+          offsets->clear();
+          return written.status();
+        }
+        position += written.ValueOrDie();
+        offsets->push_back(position);
+      }
+      ciphertexts->resize(position);
+      return crypto::tink::util::Status::OK;
+    }
+
+    for (size_t i = 0; i < plaintexts.size(); i++) {
+      auto ciphertext_result = Encrypt(plaintexts[i], associated_data[i]);
+      if (!ciphertext_result.ok()) return ciphertext_result.status();
+      ciphertexts->append(ciphertext_result.ValueOrDie());
+      offsets->push_back(ciphertexts->size());
+    }
+    return crypto::tink::util::Status::OK;
+  }
+
+  // Decrypts each of 'ciphertexts' with the corresponding entry of
+  // 'associated_data' as associated data. The plaintexts are stored in
+  // 'plaintexts' and 'offsets' in the same layout as produced by
+  // EncryptBatch(). Fails as a whole if any of the records does not decrypt.
+  //
+  // The default implementation calls Decrypt() for each record.
+  virtual crypto::tink::util::Status DecryptBatch(
+      absl::Span<const absl::string_view> ciphertexts,
+      absl::Span<const absl::string_view> associated_data,
+      std::string* plaintexts, std::vector<int64_t>* offsets) const {
+    if (ciphertexts.size() != associated_data.size()) {
+      return crypto::tink::util::Status(
+          crypto::tink::util::error::INVALID_ARGUMENT,
+          "ciphertexts and associated_data must have the same size");
+    }
+    plaintexts->clear();
+    offsets->assign(1, 0);
+    offsets->reserve(ciphertexts.size() + 1);
+    for (size_t i = 0; i < ciphertexts.size(); i++) {
+      auto plaintext_result = Decrypt(ciphertexts[i], associated_data[i]);
+      if (!plaintext_result.ok()) return plaintext_result.status();
+      plaintexts->append(plaintext_result.ValueOrDie());
+      offsets->push_back(plaintexts->size());
+    }
+    return crypto::tink::util::Status::OK;
+  }
+
+  // Returns a PreparedAead for 'associated_data', to be used when many
+  // messages are encrypted or decrypted with the same associated data (e.g. a
+  // table or row type name). The returned object refers to this Aead, which
+  // must outlive it.
+  //
+  // Implementations should override this method if they can precompute the
+  // work on 'associated_data'; the default implementation stores a copy of
+  // 'associated_data' and forwards to this Aead.
+  virtual crypto::tink::util::StatusOr<std::unique_ptr<PreparedAead>>
+  PrepareAssociatedData(absl::string_view associated_data) const;
+
   virtual ~Aead() {}
 };
 
+namespace internal {
+
+// The PreparedAead returned by the default implementation of
+// Aead::PrepareAssociatedData().
+class ForwardingPreparedAead : public PreparedAead {
+ public:
+  ForwardingPreparedAead(const Aead* aead, absl::string_view associated_data)
+      : aead_(aead), associated_data_(associated_data) {}
+
+  crypto::tink::util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext) const override {
+    return aead_->Encrypt(plaintext, associated_data_);
+  }
+
+  crypto::tink::util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext) const override {
+    return aead_->Decrypt(ciphertext, associated_data_);
+  }
+
+ private:
+  const Aead* aead_;
+  const std::string associated_data_;
+};
+
+}  // namespace internal
+
+inline crypto::tink::util::StatusOr<std::unique_ptr<PreparedAead>>
+Aead::PrepareAssociatedData(absl::string_view associated_data) const {
+  return {absl::make_unique<internal::ForwardingPreparedAead>(
+      this, associated_data)};
+}
+
 }  // namespace tink
 }  // namespace crypto
 
@@ -0,0 +1,49 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/aead/aead_router.h"
+
+#include <string>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+util::StatusOr<std::string> AeadRouter::Decrypt(
+    absl::string_view ciphertext, absl::string_view associated_data,
+    std::string* keyset_name) const {
+  Route route = Find(ciphertext);
+  if (route.empty()) {
+    return util::Status(util::error::NOT_FOUND,
+                        "no keyset has a key for the ciphertext");
+  }
+  for (const Keyset* keyset : route) {
+    auto decrypt_result =
+        keyset->primitive->Decrypt(ciphertext, associated_data);
+    if (decrypt_result.ok()) {
+      if (keyset_name != nullptr) *keyset_name = keyset->name;
+      return std::move(decrypt_result.ValueOrDie());
+    }
+  }
+  return util::Status(util::error::INVALID_ARGUMENT, "decryption failed");
+}
+
+}  // namespace tink
+}  // namespace crypto
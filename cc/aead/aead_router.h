@@ -0,0 +1,50 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_AEAD_AEAD_ROUTER_H_
+#define TINK_AEAD_AEAD_ROUTER_H_
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "tink/aead.h"
+#include "tink/keyset_router.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+// Decrypts ciphertexts of many AEAD keysets, e.g. those of the tenants of a
+// service, without knowing in advance which keyset a ciphertext belongs to.
+// The keyset is found by the output prefix of the ciphertext, see
+// KeysetRouter; ciphertexts of RAW keys cannot be decrypted.
+class AeadRouter : public KeysetRouter<Aead> {
+ public:
+  AeadRouter() {}
+
+  // Decrypts 'ciphertext' with the keyset it was encrypted with. If
+  // 'keyset_name' is non-null, it is set to the name of that keyset. Fails
+  // with NOT_FOUND if no keyset has a key with the output prefix of
+  // 'ciphertext'.
+  crypto::tink::util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext, absl::string_view associated_data,
+      std::string* keyset_name = nullptr) const;
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_AEAD_AEAD_ROUTER_H_
@@ -0,0 +1,123 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/aead/aead_router.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_wrapper.h"
+#include "tink/primitive_set.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+#include "proto/tink.pb.h"
+
+using ::crypto::tink::test::DummyAead;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::google::crypto::tink::KeysetInfo;
+using ::google::crypto::tink::KeyStatusType;
+using ::google::crypto::tink::OutputPrefixType;
+
+namespace crypto {
+namespace tink {
+namespace {
+
+// A keyset with a single key, and its wrapped Aead.
+struct TestKeyset {
+  KeysetInfo keyset_info;
+  std::shared_ptr<Aead> aead;
+};
+
+TestKeyset GetTestKeyset(uint32_t key_id, absl::string_view aead_name) {
+  TestKeyset keyset;
+  KeysetInfo::KeyInfo* key_info = keyset.keyset_info.add_key_info();
+  key_info->set_key_id(key_id);
+  key_info->set_output_prefix_type(OutputPrefixType::TINK);
+  key_info->set_status(KeyStatusType::ENABLED);
+  auto aead_set = absl::make_unique<PrimitiveSet<Aead>>();
+  auto entry_result = aead_set->AddPrimitive(
+      absl::make_unique<DummyAead>(aead_name), *key_info);
+  EXPECT_THAT(entry_result.status(), IsOk());
+  EXPECT_THAT(aead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  auto aead_result = AeadWrapper().Wrap(std::move(aead_set));
+  EXPECT_THAT(aead_result.status(), IsOk());
+  keyset.aead = std::move(aead_result.ValueOrDie());
+  return keyset;
+}
+
+TEST(AeadRouterTest, DecryptsWithTheKeysetOfTheCiphertext) {
+  AeadRouter router;
+  TestKeyset keyset1 = GetTestKeyset(1111, "aead1");
+  TestKeyset keyset2 = GetTestKeyset(2222, "aead2");
+  ASSERT_THAT(router.AddKeyset("tenant1", keyset1.keyset_info, keyset1.aead),
+              IsOk());
+  ASSERT_THAT(router.AddKeyset("tenant2", keyset2.keyset_info, keyset2.aead),
+              IsOk());
+
+  std::string ciphertext =
+      keyset2.aead->Encrypt("plaintext", "aad").ValueOrDie();
+  std::string keyset_name;
+  auto decrypt_result = router.Decrypt(ciphertext, "aad", &keyset_name);
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ("plaintext", decrypt_result.ValueOrDie());
+  EXPECT_EQ("tenant2", keyset_name);
+
+  EXPECT_THAT(router.Decrypt(ciphertext, "other aad").status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+
+  ASSERT_THAT(router.RemoveKeyset("tenant2"), IsOk());
+  EXPECT_THAT(router.Decrypt(ciphertext, "aad").status(),
+              StatusIs(util::error::NOT_FOUND));
+}
+
+TEST(AeadRouterTest, TriesAllKeysetsWithTheKeyId) {
+  AeadRouter router;
+  TestKeyset keyset1 = GetTestKeyset(1234, "aead1");
+  TestKeyset keyset2 = GetTestKeyset(1234, "aead2");
+  ASSERT_THAT(router.AddKeyset("tenant1", keyset1.keyset_info, keyset1.aead),
+              IsOk());
+  ASSERT_THAT(router.AddKeyset("tenant2", keyset2.keyset_info, keyset2.aead),
+              IsOk());
+
+  std::string ciphertext =
+      keyset2.aead->Encrypt("plaintext", "aad").ValueOrDie();
+  std::string keyset_name;
+  auto decrypt_result = router.Decrypt(ciphertext, "aad", &keyset_name);
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ("plaintext", decrypt_result.ValueOrDie());
+  EXPECT_EQ("tenant2", keyset_name);
+}
+
+TEST(AeadRouterTest, UnknownCiphertext) {
+  AeadRouter router;
+  TestKeyset keyset = GetTestKeyset(1111, "aead");
+  ASSERT_THAT(router.AddKeyset("tenant", keyset.keyset_info, keyset.aead),
+              IsOk());
+  EXPECT_THAT(router.Decrypt("", "aad").status(),
+              StatusIs(util::error::NOT_FOUND));
+  EXPECT_THAT(router.Decrypt("some unprefixed ciphertext", "aad").status(),
+              StatusIs(util::error::NOT_FOUND));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
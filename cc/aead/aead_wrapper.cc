@@ -16,16 +16,35 @@
 
 #include "tink/aead/aead_wrapper.h"
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tink/aead.h"
 #include "tink/crypto_format.h"
+#include "tink/monitoring_client.h"
 #include "tink/primitive_set.h"
+#include "tink/raw_key_fallback_policy.h"
+#include "tink/subtle/subtle_util.h"
 #include "tink/subtle/subtle_util_boringssl.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
 
 namespace crypto {
 namespace tink {
 
+using google::crypto::tink::OutputPrefixType;
+
 namespace {
 
 util::Status Validate(PrimitiveSet<Aead>* aead_set) {
@@ -41,8 +60,10 @@ util::Status Validate(PrimitiveSet<Aead>* aead_set) {
 
 class AeadSetWrapper : public Aead {
  public:
-  explicit AeadSetWrapper(std::unique_ptr<PrimitiveSet<Aead>> aead_set)
-      : aead_set_(std::move(aead_set)) {}
+  AeadSetWrapper(std::unique_ptr<PrimitiveSet<Aead>> aead_set,
+                 const RawKeyFallbackPolicy& raw_key_fallback_policy)
+      : aead_set_(std::move(aead_set)),
+        raw_key_fallback_policy_(raw_key_fallback_policy) {}
 
   crypto::tink::util::StatusOr<std::string> Encrypt(
       absl::string_view plaintext,
@@ -52,10 +73,77 @@ class AeadSetWrapper : public Aead {
       absl::string_view ciphertext,
       absl::string_view associated_data) const override;
 
+  crypto::tink::util::StatusOr<int64_t> CiphertextSize(
+      int64_t plaintext_size) const override;
+
+  crypto::tink::util::StatusOr<int64_t> EncryptInto(
+      absl::string_view plaintext, absl::string_view associated_data,
+      absl::Span<char> ciphertext_buffer) const override;
+
+  crypto::tink::util::StatusOr<int64_t> DecryptInto(
+      absl::string_view ciphertext, absl::string_view associated_data,
+      absl::Span<char> plaintext_buffer) const override;
+
+  crypto::tink::util::StatusOr<int64_t> EncryptGatherInto(
+      absl::Span<const absl::string_view> plaintext_parts,
+      absl::string_view associated_data,
+      absl::Span<char> ciphertext_buffer) const override;
+
+  crypto::tink::util::StatusOr<int64_t> DecryptScatterInto(
+      absl::string_view ciphertext, absl::string_view associated_data,
+      absl::Span<const absl::Span<char>> plaintext_buffers) const override;
+
+  crypto::tink::util::StatusOr<absl::Span<char>> DecryptInPlace(
+      absl::Span<char> ciphertext,
+      absl::string_view associated_data) const override;
+
+  crypto::tink::util::Status EncryptBatch(
+      absl::Span<const absl::string_view> plaintexts,
+      absl::Span<const absl::string_view> associated_data,
+      std::string* ciphertexts, std::vector<int64_t>* offsets) const override;
+
+  crypto::tink::util::Status DecryptBatch(
+      absl::Span<const absl::string_view> ciphertexts,
+      absl::Span<const absl::string_view> associated_data,
+      std::string* plaintexts, std::vector<int64_t>* offsets) const override;
+
+  crypto::tink::util::StatusOr<std::unique_ptr<PreparedAead>>
+  PrepareAssociatedData(absl::string_view associated_data) const override;
+
   ~AeadSetWrapper() override {}
 
  private:
+  // Decrypts 'ciphertext' by calling 'decrypt', first with the entries in
+  // 'prefixed' (after stripping the key prefix) and then with the entries in
+  // 'raw' allowed by the policy, until one of the calls succeeds. Either of
+  // the two may be null.
+  crypto::tink::util::StatusOr<int64_t> DecryptWith(
+      const PrimitiveSet<Aead>::Primitives* prefixed,
+      const PrimitiveSet<Aead>::Primitives* raw, absl::string_view ciphertext,
+      absl::FunctionRef<crypto::tink::util::StatusOr<int64_t>(
+          const Aead& aead, absl::string_view raw_ciphertext)>
+          decrypt) const;
+
+  // Returns the entries matching the key prefix of 'ciphertext', or null if
+  // there are none.
+  const PrimitiveSet<Aead>::Primitives* GetPrefixedPrimitives(
+      absl::string_view ciphertext) const;
+
+  // Returns the entries with RAW prefix, or null if there are none.
+  const PrimitiveSet<Aead>::Primitives* GetRawPrimitives() const;
+
+  // If all of 'ciphertexts' carry the non-RAW prefix of the primary, and no
+  // other key has that prefix, decrypts them with a single DecryptBatch() call
+  // of the primary, which may be faster than record by record. Returns false
+  // if that is not possible or fails, in which case DecryptBatch() tries the
+  // candidate keys of each record.
+  bool DecryptBatchWithPrimary(
+      absl::Span<const absl::string_view> ciphertexts,
+      absl::Span<const absl::string_view> associated_data,
+      std::string* plaintexts, std::vector<int64_t>* offsets) const;
+
   std::unique_ptr<PrimitiveSet<Aead>> aead_set_;
+  const RawKeyFallbackPolicy raw_key_fallback_policy_;
 };
 
 util::StatusOr<std::string> AeadSetWrapper::Encrypt(
@@ -64,31 +152,83 @@ util::StatusOr<std::string> AeadSetWrapper::Encrypt(
   // regardless of whether the size is 0.
   plaintext = subtle::SubtleUtilBoringSSL::EnsureNonNull(plaintext);
   associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+  internal::MonitoredOperation monitored("aead", "encrypt", plaintext.size());
+
+  auto ciphertext_size = CiphertextSize(plaintext.size());
+  if (ciphertext_size.ok()) {
+    // Encrypt directly into the result, writing the key prefix in place.
+    std::string result;
+    subtle::ResizeStringUninitialized(&result, ciphertext_size.ValueOrDie());
+    auto written = EncryptInto(plaintext, associated_data,
+                               absl::MakeSpan(&result[0], result.size()));
+    if (!written.ok()) return written.status();
+    result.resize(written.ValueOrDie());
+    monitored.Success(aead_set_->get_primary()->get_key_id());
+    return result;
+  }
 
   auto encrypt_result = aead_set_->get_primary()->get_primitive()
       .Encrypt(plaintext, associated_data);
   if (!encrypt_result.ok()) return encrypt_result.status();
+  monitored.Success(aead_set_->get_primary()->get_key_id());
   const std::string& key_id = aead_set_->get_primary()->get_identifier();
   return key_id + encrypt_result.ValueOrDie();
 }
 
+util::StatusOr<int64_t> AeadSetWrapper::CiphertextSize(
+    int64_t plaintext_size) const {
+  auto raw_size = aead_set_->get_primary()->get_primitive().CiphertextSize(
+      plaintext_size);
+  if (!raw_size.ok()) return raw_size.status();
+  return aead_set_->get_primary()->get_identifier().size() +
+         raw_size.ValueOrDie();
+}
+
+util::StatusOr<int64_t> AeadSetWrapper::EncryptInto(
+    absl::string_view plaintext, absl::string_view associated_data,
+    absl::Span<char> ciphertext_buffer) const {
+  // BoringSSL expects a non-null pointer for plaintext and additional_data,
+  // regardless of whether the size is 0.
+  plaintext = subtle::SubtleUtilBoringSSL::EnsureNonNull(plaintext);
+  associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+
+  const std::string& key_id = aead_set_->get_primary()->get_identifier();
+  if (ciphertext_buffer.size() < key_id.size()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_buffer is too small");
+  }
+  std::copy(key_id.begin(), key_id.end(), ciphertext_buffer.begin());
+  auto written =
+      aead_set_->get_primary()->get_primitive().EncryptInto(
+          plaintext, associated_data,
+          ciphertext_buffer.subspan(key_id.size()));
+  if (!written.ok()) return written.status();
+  return key_id.size() + written.ValueOrDie();
+}
+
 util::StatusOr<std::string> AeadSetWrapper::Decrypt(
     absl::string_view ciphertext, absl::string_view associated_data) const {
   // BoringSSL expects a non-null pointer for plaintext and additional_data,
   // regardless of whether the size is 0.
   associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+  internal::MonitoredOperation monitored("aead", "decrypt", ciphertext.size());
 
+  bool prefix_matched = false;
   if (ciphertext.length() > CryptoFormat::kNonRawPrefixSize) {
     absl::string_view key_id =
         ciphertext.substr(0, CryptoFormat::kNonRawPrefixSize);
-    auto primitives_result = aead_set_->get_primitives(key_id);
-    if (primitives_result.ok()) {
+    const auto* primitives = aead_set_->find_primitives(key_id);
+    if (primitives != nullptr) {
+      prefix_matched = true;
       absl::string_view raw_ciphertext =
           ciphertext.substr(CryptoFormat::kNonRawPrefixSize);
-      for (auto& aead_entry : *(primitives_result.ValueOrDie())) {
-        Aead& aead = aead_entry->get_primitive();
-        auto decrypt_result = aead.Decrypt(raw_ciphertext, associated_data);
+      for (auto& aead_entry : *primitives) {
+        auto aead_result = aead_entry->GetOrCreatePrimitive();
+        if (!aead_result.ok()) continue;
+        auto decrypt_result =
+            aead_result.ValueOrDie()->Decrypt(raw_ciphertext, associated_data);
         if (decrypt_result.ok()) {
+          monitored.Success(aead_entry->get_key_id());
           return std::move(decrypt_result.ValueOrDie());
         } else {
           // LOG that a matching key didn't decrypt the ciphertext.
@@ -97,18 +237,505 @@ util::StatusOr<std::string> AeadSetWrapper::Decrypt(
     }
   }
 
-  // No matching key succeeded with decryption, try all RAW keys.
-  auto raw_primitives_result = aead_set_->get_raw_primitives();
-  if (raw_primitives_result.ok()) {
-    for (auto& aead_entry : *(raw_primitives_result.ValueOrDie())) {
-      Aead& aead = aead_entry->get_primitive();
-      auto decrypt_result = aead.Decrypt(ciphertext, associated_data);
+  // No matching key succeeded with decryption, try the RAW keys.
+  const auto* raw_primitives = aead_set_->find_raw_primitives();
+  if (raw_primitives != nullptr) {
+    const PrimitiveSet<Aead>::Primitives& raw = *raw_primitives;
+    size_t max_attempts = internal::RawKeysToTry(raw_key_fallback_policy_,
+                                                 prefix_matched, raw.size());
+    size_t attempts = 0;
+    while (attempts < max_attempts) {
+      const auto& aead_entry = raw[attempts++];
+      auto aead_result = aead_entry->GetOrCreatePrimitive();
+      if (!aead_result.ok()) continue;
+      auto decrypt_result =
+          aead_result.ValueOrDie()->Decrypt(ciphertext, associated_data);
       if (decrypt_result.ok()) {
+        monitored.Success(aead_entry->get_key_id());
+        internal::RecordRawKeyFallback(raw_key_fallback_policy_, raw.size(),
+                                       attempts, /*success=*/true);
         return std::move(decrypt_result.ValueOrDie());
       }
     }
+    internal::RecordRawKeyFallback(raw_key_fallback_policy_, raw.size(),
+                                   attempts, /*success=*/false);
   }
-  return util::Status(util::error::INVALID_ARGUMENT, "decryption failed");
+  static const util::Status* kDecryptionFailed =
+      util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                              "decryption failed");
+  return *kDecryptionFailed;
+}
+
+const PrimitiveSet<Aead>::Primitives* AeadSetWrapper::GetPrefixedPrimitives(
+    absl::string_view ciphertext) const {
+  if (ciphertext.length() <= CryptoFormat::kNonRawPrefixSize) return nullptr;
+  return aead_set_->find_primitives(
+      ciphertext.substr(0, CryptoFormat::kNonRawPrefixSize));
+}
+
+const PrimitiveSet<Aead>::Primitives* AeadSetWrapper::GetRawPrimitives() const {
+  return aead_set_->find_raw_primitives();
+}
+
+util::StatusOr<int64_t> AeadSetWrapper::DecryptWith(
+    const PrimitiveSet<Aead>::Primitives* prefixed,
+    const PrimitiveSet<Aead>::Primitives* raw, absl::string_view ciphertext,
+    absl::FunctionRef<util::StatusOr<int64_t>(
+        const Aead& aead, absl::string_view raw_ciphertext)>
+        decrypt) const {
+  if (prefixed != nullptr) {
+    absl::string_view raw_ciphertext =
+        ciphertext.substr(CryptoFormat::kNonRawPrefixSize);
+    for (auto& aead_entry : *prefixed) {
+      auto aead_result = aead_entry->GetOrCreatePrimitive();
+      if (!aead_result.ok()) continue;
+      auto decrypt_result = decrypt(*aead_result.ValueOrDie(), raw_ciphertext);
+      if (decrypt_result.ok()) {
+        return decrypt_result.ValueOrDie();
+      } else {
+        // LOG that a matching key didn't decrypt the ciphertext.
+      }
+    }
+  }
+
+  // No matching key succeeded with decryption, try the RAW keys.
+  if (raw != nullptr) {
+    size_t max_attempts = internal::RawKeysToTry(
+        raw_key_fallback_policy_, prefixed != nullptr, raw->size());
+    size_t attempts = 0;
+    while (attempts < max_attempts) {
+      auto aead_result = (*raw)[attempts++]->GetOrCreatePrimitive();
+      if (!aead_result.ok()) continue;
+      auto decrypt_result = decrypt(*aead_result.ValueOrDie(), ciphertext);
+      if (decrypt_result.ok()) {
+        internal::RecordRawKeyFallback(raw_key_fallback_policy_, raw->size(),
+                                       attempts, /*success=*/true);
+        return decrypt_result.ValueOrDie();
+      }
+    }
+    internal::RecordRawKeyFallback(raw_key_fallback_policy_, raw->size(),
+                                   attempts, /*success=*/false);
+  }
+  static const util::Status* kDecryptionFailed =
+      util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                              "decryption failed");
+  return *kDecryptionFailed;
+}
+
+util::StatusOr<int64_t> AeadSetWrapper::DecryptInto(
+    absl::string_view ciphertext, absl::string_view associated_data,
+    absl::Span<char> plaintext_buffer) const {
+  // BoringSSL expects a non-null pointer for plaintext and additional_data,
+  // regardless of whether the size is 0.
+  associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+
+  return DecryptWith(
+      GetPrefixedPrimitives(ciphertext), GetRawPrimitives(), ciphertext,
+      [&](const Aead& aead, absl::string_view raw_ciphertext) {
+        return aead.DecryptInto(raw_ciphertext, associated_data,
+                                plaintext_buffer);
+      });
+}
+
+util::StatusOr<int64_t> AeadSetWrapper::EncryptGatherInto(
+    absl::Span<const absl::string_view> plaintext_parts,
+    absl::string_view associated_data,
+    absl::Span<char> ciphertext_buffer) const {
+  // BoringSSL expects a non-null pointer for additional_data, regardless of
+  // whether the size is 0.
+  associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+
+  const std::string& key_id = aead_set_->get_primary()->get_identifier();
+  if (ciphertext_buffer.size() < key_id.size()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_buffer is too small");
+  }
+  std::copy(key_id.begin(), key_id.end(), ciphertext_buffer.begin());
+  auto written =
+      aead_set_->get_primary()->get_primitive().EncryptGatherInto(
+          plaintext_parts, associated_data,
+          ciphertext_buffer.subspan(key_id.size()));
+  if (!written.ok()) return written.status();
+  return key_id.size() + written.ValueOrDie();
+}
+
+util::StatusOr<int64_t> AeadSetWrapper::DecryptScatterInto(
+    absl::string_view ciphertext, absl::string_view associated_data,
+    absl::Span<const absl::Span<char>> plaintext_buffers) const {
+  // BoringSSL expects a non-null pointer for additional_data, regardless of
+  // whether the size is 0.
+  associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+
+  return DecryptWith(
+      GetPrefixedPrimitives(ciphertext), GetRawPrimitives(), ciphertext,
+      [&](const Aead& aead, absl::string_view raw_ciphertext) {
+        return aead.DecryptScatterInto(raw_ciphertext, associated_data,
+                                       plaintext_buffers);
+      });
+}
+
+util::StatusOr<absl::Span<char>> AeadSetWrapper::DecryptInPlace(
+    absl::Span<char> ciphertext, absl::string_view associated_data) const {
+  // BoringSSL expects a non-null pointer for additional_data, regardless of
+  // whether the size is 0.
+  associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+
+  const PrimitiveSet<Aead>::Primitives* prefixed = GetPrefixedPrimitives(
+      absl::string_view(ciphertext.data(), ciphertext.size()));
+  const PrimitiveSet<Aead>::Primitives* raw = GetRawPrimitives();
+  size_t candidates =
+      (prefixed != nullptr ? prefixed->size() : 0) +
+      (raw != nullptr ? internal::RawKeysToTry(raw_key_fallback_policy_,
+                                               prefixed != nullptr, raw->size())
+                      : 0);
+  if (candidates != 1) {
+    // A failed attempt may overwrite the ciphertext, so it can only be
+    // decrypted in place if there is a single key to try.
+    return Aead::DecryptInPlace(ciphertext, associated_data);
+  }
+  const auto& aead_entry = prefixed != nullptr ? prefixed->front()
+                                               : raw->front();
+  auto aead_result = aead_entry->GetOrCreatePrimitive();
+  bool decrypted = false;
+  absl::Span<char> plaintext;
+  if (aead_result.ok()) {
+    auto decrypt_result = aead_result.ValueOrDie()->DecryptInPlace(
+        prefixed != nullptr
+            ? ciphertext.subspan(CryptoFormat::kNonRawPrefixSize)
+            : ciphertext,
+        associated_data);
+    if (decrypt_result.ok()) {
+      decrypted = true;
+      plaintext = decrypt_result.ValueOrDie();
+    }
+  }
+  if (raw != nullptr && (prefixed == nullptr || !decrypted)) {
+    internal::RecordRawKeyFallback(raw_key_fallback_policy_, raw->size(),
+                                   /*attempts=*/prefixed == nullptr ? 1 : 0,
+                                   decrypted);
+  }
+  if (!decrypted) {
+    static const util::Status* kDecryptionFailed =
+        util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                                "decryption failed");
+    return *kDecryptionFailed;
+  }
+  return plaintext;
+}
+
+util::Status AeadSetWrapper::EncryptBatch(
+    absl::Span<const absl::string_view> plaintexts,
+    absl::Span<const absl::string_view> associated_data,
+    std::string* ciphertexts, std::vector<int64_t>* offsets) const {
+  if (plaintexts.size() != associated_data.size()) {
+    return util::Status(
+        util::error::INVALID_ARGUMENT,
+        "plaintexts and associated_data must have the same size");
+  }
+  // The primary encrypts the whole batch, which may be faster than record by
+  // record (e.g. AES-GCM with AesGcmMultiBuffer). Its key prefix is inserted
+  // afterwards.
+  const std::string& key_id = aead_set_->get_primary()->get_identifier();
+  util::Status status =
+      aead_set_->get_primary()->get_primitive().EncryptBatch(
+          plaintexts, associated_data, ciphertexts, offsets);
+  if (!status.ok()) return status;
+  if (key_id.empty()) return util::Status::OK;
+
+  // Move the ciphertexts into place from the last one backwards, so that each
+  // is moved only once.
+  const int64_t prefix_size = key_id.size();
+  subtle::ResizeStringUninitialized(
+      ciphertexts, ciphertexts->size() + plaintexts.size() * prefix_size);
+  char* data = &(*ciphertexts)[0];
+  for (size_t i = plaintexts.size(); i > 0; i--) {
+    int64_t begin = (*offsets)[i - 1];
+    int64_t size = (*offsets)[i] - begin;
+    std::memmove(data + begin + i * prefix_size, data + begin, size);
+    std::memcpy(data + begin + (i - 1) * prefix_size, key_id.data(),
+                prefix_size);
+  }
+  for (size_t i = 1; i < offsets->size(); i++) {
+    (*offsets)[i] += i * prefix_size;
+  }
+  return util::Status::OK;
+}
+
+bool AeadSetWrapper::DecryptBatchWithPrimary(
+    absl::Span<const absl::string_view> ciphertexts,
+    absl::Span<const absl::string_view> associated_data,
+    std::string* plaintexts, std::vector<int64_t>* offsets) const {
+  const std::string& key_id = aead_set_->get_primary()->get_identifier();
+  if (key_id.empty() || ciphertexts.empty()) return false;
+  const auto* prefixed = aead_set_->find_primitives(key_id);
+  if (prefixed == nullptr || prefixed->size() != 1) {
+    return false;
+  }
+  std::vector<absl::string_view> raw_ciphertexts;
+  raw_ciphertexts.reserve(ciphertexts.size());
+  for (absl::string_view ciphertext : ciphertexts) {
+    if (ciphertext.size() <= key_id.size() ||
+        ciphertext.substr(0, key_id.size()) != key_id) {
+      return false;
+    }
+    raw_ciphertexts.push_back(ciphertext.substr(key_id.size()));
+  }
+  return aead_set_->get_primary()
+      ->get_primitive()
+      .DecryptBatch(raw_ciphertexts, associated_data, plaintexts, offsets)
+      .ok();
+}
+
+util::Status AeadSetWrapper::DecryptBatch(
+    absl::Span<const absl::string_view> ciphertexts,
+    absl::Span<const absl::string_view> associated_data,
+    std::string* plaintexts, std::vector<int64_t>* offsets) const {
+  if (ciphertexts.size() != associated_data.size()) {
+    return util::Status(
+        util::error::INVALID_ARGUMENT,
+        "ciphertexts and associated_data must have the same size");
+  }
+  if (DecryptBatchWithPrimary(ciphertexts, associated_data, plaintexts,
+                              offsets)) {
+    return util::Status::OK;
+  }
+
+  // A plaintext is never longer than its ciphertext, so the sum of the
+  // ciphertext sizes bounds the size of the output arena.
+  int64_t total_size = 0;
+  for (absl::string_view ciphertext : ciphertexts) {
+    total_size += ciphertext.size();
+  }
+  subtle::ResizeStringUninitialized(plaintexts, total_size);
+  absl::Span<char> arena = absl::MakeSpan(&(*plaintexts)[0], total_size);
+  offsets->assign(1, 0);
+  offsets->reserve(ciphertexts.size() + 1);
+
+  // Look up the entries of each distinct key prefix only once per batch.
+  const PrimitiveSet<Aead>::Primitives* raw = GetRawPrimitives();
+  absl::flat_hash_map<absl::string_view, const PrimitiveSet<Aead>::Primitives*>
+      prefixed_by_key_id;
+  int64_t position = 0;
+  for (size_t i = 0; i < ciphertexts.size(); i++) {
+    absl::string_view ciphertext = ciphertexts[i];
+    const PrimitiveSet<Aead>::Primitives* prefixed = nullptr;
+    if (ciphertext.length() > CryptoFormat::kNonRawPrefixSize) {
+      absl::string_view key_id =
+          ciphertext.substr(0, CryptoFormat::kNonRawPrefixSize);
+      auto found = prefixed_by_key_id.find(key_id);
+      if (found == prefixed_by_key_id.end()) {
+        found = prefixed_by_key_id
+                    .emplace(key_id, GetPrefixedPrimitives(ciphertext))
+                    .first;
+      }
+      prefixed = found->second;
+    }
+    absl::string_view record_associated_data =
+        subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data[i]);
+    absl::Span<char> record = arena.subspan(position);
+    auto written = DecryptWith(
+        prefixed, raw, ciphertext,
+        [&](const Aead& aead, absl::string_view raw_ciphertext) {
+          return aead.DecryptInto(raw_ciphertext, record_associated_data,
+                                  record);
+        });
+    if (!written.ok()) {
+      plaintexts->clear();
+      offsets->clear();
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          absl::StrCat("decryption failed for record ", i));
+    }
+    position += written.ValueOrDie();
+    offsets->push_back(position);
+  }
+  plaintexts->resize(position);
+  return util::Status::OK;
+}
+
+// The keyset counterpart of Aead::PrepareAssociatedData(): encrypts with the
+// prepared primitive of the primary key, which also decrypts ciphertexts
+// carrying the primary's prefix. Other ciphertexts, and those the primary
+// fails to decrypt, are passed to the keyset with the associated data.
+class PreparedAeadSetWrapper : public PreparedAead {
+ public:
+  PreparedAeadSetWrapper(const Aead* aead, absl::string_view associated_data,
+                         const std::string& primary_prefix,
+                         std::unique_ptr<PreparedAead> primary)
+      : aead_(aead),
+        associated_data_(associated_data),
+        primary_prefix_(primary_prefix),
+        primary_(std::move(primary)) {}
+
+  crypto::tink::util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext) const override {
+    plaintext = subtle::SubtleUtilBoringSSL::EnsureNonNull(plaintext);
+    auto encrypt_result = primary_->Encrypt(plaintext);
+    if (!encrypt_result.ok()) return encrypt_result.status();
+    return primary_prefix_ + encrypt_result.ValueOrDie();
+  }
+
+  crypto::tink::util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext) const override {
+    if (!primary_prefix_.empty() &&
+        ciphertext.size() > primary_prefix_.size() &&
+        ciphertext.substr(0, primary_prefix_.size()) == primary_prefix_) {
+      auto decrypt_result =
+          primary_->Decrypt(ciphertext.substr(primary_prefix_.size()));
+      if (decrypt_result.ok()) return std::move(decrypt_result.ValueOrDie());
+    }
+
+    // The plaintext is never longer than the ciphertext.
+    std::string plaintext;
+    subtle::ResizeStringUninitialized(&plaintext, ciphertext.size());
+    auto written = aead_->DecryptInto(
+        ciphertext, associated_data_,
+        absl::MakeSpan(&plaintext[0], plaintext.size()));
+    if (!written.ok()) return written.status();
+    plaintext.resize(written.ValueOrDie());
+    return plaintext;
+  }
+
+ private:
+  const Aead* aead_;
+  const std::string associated_data_;
+  const std::string& primary_prefix_;
+  const std::unique_ptr<PreparedAead> primary_;
+};
+
+util::StatusOr<std::unique_ptr<PreparedAead>>
+AeadSetWrapper::PrepareAssociatedData(
+    absl::string_view associated_data) const {
+  associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+  const auto* primary = aead_set_->get_primary();
+  auto prepare_result =
+      primary->get_primitive().PrepareAssociatedData(associated_data);
+  if (!prepare_result.ok()) return prepare_result.status();
+  return {absl::make_unique<PreparedAeadSetWrapper>(
+      this, associated_data, primary->get_identifier(),
+      std::move(prepare_result.ValueOrDie()))};
+}
+
+// Wraps a set holding a single key with a non-RAW prefix, which is the case
+// for most keysets. Encryption and decryption use the primitive and key
+// prefix directly instead of looking the entries up by prefix; a ciphertext
+// without the prefix cannot be decrypted, since the set has no RAW keys.
+class SingleKeyAeadWrapper : public AeadSetWrapper {
+ public:
+  SingleKeyAeadWrapper(std::unique_ptr<PrimitiveSet<Aead>> aead_set,
+                       const RawKeyFallbackPolicy& raw_key_fallback_policy,
+                       const PrimitiveSet<Aead>::Entry<Aead>& entry)
+      : AeadSetWrapper(std::move(aead_set), raw_key_fallback_policy),
+        aead_(entry.get_primitive()),
+        prefix_(entry.get_identifier()),
+        key_id_(entry.get_key_id()) {}
+
+  crypto::tink::util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view associated_data) const override;
+
+  crypto::tink::util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view associated_data) const override;
+
+  crypto::tink::util::StatusOr<int64_t> CiphertextSize(
+      int64_t plaintext_size) const override;
+
+  crypto::tink::util::StatusOr<int64_t> EncryptInto(
+      absl::string_view plaintext, absl::string_view associated_data,
+      absl::Span<char> ciphertext_buffer) const override;
+
+  crypto::tink::util::StatusOr<int64_t> DecryptInto(
+      absl::string_view ciphertext, absl::string_view associated_data,
+      absl::Span<char> plaintext_buffer) const override;
+
+ private:
+  bool HasPrefix(absl::string_view ciphertext) const {
+    return ciphertext.size() > prefix_.size() &&
+           ciphertext.substr(0, prefix_.size()) == prefix_;
+  }
+
+  static util::Status DecryptionFailed() {
+    static const util::Status* kDecryptionFailed =
+        util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                                "decryption failed");
+    return *kDecryptionFailed;
+  }
+
+  const Aead& aead_;
+  const std::string& prefix_;
+  const uint32_t key_id_;
+};
+
+util::StatusOr<std::string> SingleKeyAeadWrapper::Encrypt(
+    absl::string_view plaintext, absl::string_view associated_data) const {
+  plaintext = subtle::SubtleUtilBoringSSL::EnsureNonNull(plaintext);
+  associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+  internal::MonitoredOperation monitored("aead", "encrypt", plaintext.size());
+
+  auto raw_size = aead_.CiphertextSize(plaintext.size());
+  if (!raw_size.ok()) {
+    auto encrypt_result = aead_.Encrypt(plaintext, associated_data);
+    if (!encrypt_result.ok()) return encrypt_result.status();
+    monitored.Success(key_id_);
+    return prefix_ + encrypt_result.ValueOrDie();
+  }
+  std::string result;
+  subtle::ResizeStringUninitialized(&result,
+                                    prefix_.size() + raw_size.ValueOrDie());
+  std::copy(prefix_.begin(), prefix_.end(), result.begin());
+  auto written = aead_.EncryptInto(
+      plaintext, associated_data,
+      absl::MakeSpan(&result[prefix_.size()], raw_size.ValueOrDie()));
+  if (!written.ok()) return written.status();
+  result.resize(prefix_.size() + written.ValueOrDie());
+  monitored.Success(key_id_);
+  return result;
+}
+
+util::StatusOr<int64_t> SingleKeyAeadWrapper::CiphertextSize(
+    int64_t plaintext_size) const {
+  auto raw_size = aead_.CiphertextSize(plaintext_size);
+  if (!raw_size.ok()) return raw_size.status();
+  return prefix_.size() + raw_size.ValueOrDie();
+}
+
+util::StatusOr<int64_t> SingleKeyAeadWrapper::EncryptInto(
+    absl::string_view plaintext, absl::string_view associated_data,
+    absl::Span<char> ciphertext_buffer) const {
+  plaintext = subtle::SubtleUtilBoringSSL::EnsureNonNull(plaintext);
+  associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+  if (ciphertext_buffer.size() < prefix_.size()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_buffer is too small");
+  }
+  std::copy(prefix_.begin(), prefix_.end(), ciphertext_buffer.begin());
+  auto written = aead_.EncryptInto(plaintext, associated_data,
+                                   ciphertext_buffer.subspan(prefix_.size()));
+  if (!written.ok()) return written.status();
+  return prefix_.size() + written.ValueOrDie();
+}
+
+util::StatusOr<std::string> SingleKeyAeadWrapper::Decrypt(
+    absl::string_view ciphertext, absl::string_view associated_data) const {
+  associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+  internal::MonitoredOperation monitored("aead", "decrypt", ciphertext.size());
+  if (!HasPrefix(ciphertext)) return DecryptionFailed();
+  auto decrypt_result =
+      aead_.Decrypt(ciphertext.substr(prefix_.size()), associated_data);
+  if (!decrypt_result.ok()) return DecryptionFailed();
+  monitored.Success(key_id_);
+  return std::move(decrypt_result.ValueOrDie());
+}
+
+util::StatusOr<int64_t> SingleKeyAeadWrapper::DecryptInto(
+    absl::string_view ciphertext, absl::string_view associated_data,
+    absl::Span<char> plaintext_buffer) const {
+  associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+  if (!HasPrefix(ciphertext)) return DecryptionFailed();
+  auto written = aead_.DecryptInto(ciphertext.substr(prefix_.size()),
+                                   associated_data, plaintext_buffer);
+  if (!written.ok()) return DecryptionFailed();
+  return written.ValueOrDie();
 }
 
 }  // anonymous namespace
@@ -117,7 +744,16 @@ util::StatusOr<std::unique_ptr<Aead>> AeadWrapper::Wrap(
     std::unique_ptr<PrimitiveSet<Aead>> aead_set) const {
   util::Status status = Validate(aead_set.get());
   if (!status.ok()) return status;
-  std::unique_ptr<Aead> aead(new AeadSetWrapper(std::move(aead_set)));
+  const PrimitiveSet<Aead>::Entry<Aead>* single_entry =
+      aead_set->get_single_entry();
+  if (single_entry != nullptr &&
+      single_entry->get_output_prefix_type() != OutputPrefixType::RAW) {
+    std::unique_ptr<Aead> aead(new SingleKeyAeadWrapper(
+        std::move(aead_set), raw_key_fallback_policy_, *single_entry));
+    return std::move(aead);
+  }
+  std::unique_ptr<Aead> aead(
+      new AeadSetWrapper(std::move(aead_set), raw_key_fallback_policy_));
   return std::move(aead);
 }
 
@@ -21,6 +21,7 @@
 #include "tink/aead.h"
 #include "tink/primitive_set.h"
 #include "tink/primitive_wrapper.h"
+#include "tink/raw_key_fallback_policy.h"
 #include "tink/util/statusor.h"
 #include "proto/tink.pb.h"
 
@@ -32,12 +33,23 @@ namespace tink {
 // instances, depending on the context:
 //   * Aead::Encrypt(...) uses the primary instance from the set
 //   * Aead::Decrypt(...) uses the instance that matches the ciphertext prefix.
+//     If none of them decrypts the ciphertext, Decrypt() tries the instances
+//     with RAW prefix, as allowed by the RawKeyFallbackPolicy.
 class AeadWrapper : public PrimitiveWrapper<Aead, Aead> {
  public:
+  AeadWrapper() = default;
+  explicit AeadWrapper(const RawKeyFallbackPolicy& raw_key_fallback_policy)
+      : raw_key_fallback_policy_(raw_key_fallback_policy) {}
+
   // Returns an Aead-primitive that uses Aead-instances provided in 'aead_set',
   // which must be non-NULL and must contain a primary instance.
   util::StatusOr<std::unique_ptr<Aead>> Wrap(
       std::unique_ptr<PrimitiveSet<Aead>> aead_set) const override;
+
+  bool SupportsLazyPrimitives() const override { return true; }
+
+ private:
+  RawKeyFallbackPolicy raw_key_fallback_policy_;
 };
 
 }  // namespace tink
@@ -16,10 +16,23 @@
 
 #include "tink/aead/aead_wrapper.h"
 
+#include <string>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tink/aead.h"
+#include "tink/crypto_format.h"
 #include "tink/primitive_set.h"
+#include "tink/raw_key_fallback_policy.h"
+#include "tink/subtle/aes_gcm_boringssl.h"
+#include "tink/subtle/random.h"
+#include "tink/util/secret_data.h"
 #include "tink/util/status.h"
 #include "tink/util/test_matchers.h"
 #include "tink/util/test_util.h"
@@ -27,6 +40,7 @@
 
 using ::crypto::tink::test::DummyAead;
 using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
 using ::google::crypto::tink::KeysetInfo;
 using ::google::crypto::tink::KeyStatusType;
 using ::google::crypto::tink::OutputPrefixType;
@@ -186,6 +200,592 @@ TEST(AeadSetWrapperTest, DecryptNonPrimary) {
   auto decrypt_result = aead->Decrypt(ciphertext, aad);
   EXPECT_TRUE(decrypt_result.ok()) << decrypt_result.status();
 }
+
+TEST(AeadSetWrapperTest, PrepareAssociatedData) {
+  KeysetInfo keyset_info;
+  KeysetInfo::KeyInfo* key_info = keyset_info.add_key_info();
+  key_info->set_output_prefix_type(OutputPrefixType::TINK);
+  key_info->set_key_id(1234543);
+  key_info->set_status(KeyStatusType::ENABLED);
+  key_info = keyset_info.add_key_info();
+  key_info->set_output_prefix_type(OutputPrefixType::RAW);
+  key_info->set_key_id(726329);
+  key_info->set_status(KeyStatusType::ENABLED);
+
+  auto aead_set = absl::make_unique<PrimitiveSet<Aead>>();
+  auto entry_result = aead_set->AddPrimitive(
+      absl::make_unique<DummyAead>("aead0"), keyset_info.key_info(0));
+  ASSERT_TRUE(entry_result.ok());
+  ASSERT_THAT(aead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  ASSERT_TRUE(aead_set
+                  ->AddPrimitive(absl::make_unique<DummyAead>("aead1"),
+                                 keyset_info.key_info(1))
+                  .ok());
+  auto aead_result = AeadWrapper().Wrap(std::move(aead_set));
+  ASSERT_THAT(aead_result.status(), IsOk());
+  std::unique_ptr<Aead> aead = std::move(aead_result.ValueOrDie());
+
+  std::string aad = "some_aad";
+  auto prepared_result = aead->PrepareAssociatedData(aad);
+  ASSERT_THAT(prepared_result.status(), IsOk());
+  std::unique_ptr<PreparedAead> prepared =
+      std::move(prepared_result.ValueOrDie());
+
+  auto encrypt_result = prepared->Encrypt("some_plaintext");
+  ASSERT_THAT(encrypt_result.status(), IsOk());
+  auto decrypt_result = aead->Decrypt(encrypt_result.ValueOrDie(), aad);
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ(decrypt_result.ValueOrDie(), "some_plaintext");
+  decrypt_result = prepared->Decrypt(encrypt_result.ValueOrDie());
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ(decrypt_result.ValueOrDie(), "some_plaintext");
+
+  // Ciphertexts of the RAW key are decrypted through the keyset.
+  std::string raw_ciphertext =
+      DummyAead("aead1").Encrypt("raw_plaintext", aad).ValueOrDie();
+  decrypt_result = prepared->Decrypt(raw_ciphertext);
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ(decrypt_result.ValueOrDie(), "raw_plaintext");
+
+  // The associated data is bound to the prepared object.
+  auto other_result = aead->Encrypt("some_plaintext", "other_aad");
+  ASSERT_THAT(other_result.status(), IsOk());
+  EXPECT_FALSE(prepared->Decrypt(other_result.ValueOrDie()).ok());
+  EXPECT_FALSE(prepared->Decrypt("bad").ok());
+}
+
+TEST(AeadSetWrapperTest, EncryptIntoDecryptInto) {
+  KeysetInfo keyset_info;
+  KeysetInfo::KeyInfo* key_info = keyset_info.add_key_info();
+  key_info->set_output_prefix_type(OutputPrefixType::TINK);
+  key_info->set_key_id(1234543);
+  key_info->set_status(KeyStatusType::ENABLED);
+
+  auto gcm_result = subtle::AesGcmBoringSsl::New(
+      subtle::Random::GetRandomKeyBytes(16));
+  ASSERT_THAT(gcm_result.status(), IsOk());
+  std::unique_ptr<PrimitiveSet<Aead>> aead_set(new PrimitiveSet<Aead>());
+  auto entry_result = aead_set->AddPrimitive(
+      std::move(gcm_result.ValueOrDie()), keyset_info.key_info(0));
+  ASSERT_THAT(entry_result.status(), IsOk());
+  ASSERT_THAT(aead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  std::string prefix = entry_result.ValueOrDie()->get_identifier();
+
+  AeadWrapper wrapper;
+  auto aead_result = wrapper.Wrap(std::move(aead_set));
+  ASSERT_THAT(aead_result.status(), IsOk());
+  std::unique_ptr<Aead> aead = std::move(aead_result.ValueOrDie());
+  std::string plaintext = "some_plaintext";
+  std::string aad = "some_aad";
+
+  auto size_result = aead->CiphertextSize(plaintext.size());
+  ASSERT_THAT(size_result.status(), IsOk());
+  EXPECT_EQ(size_result.ValueOrDie(),
+            CryptoFormat::kNonRawPrefixSize + 12 + plaintext.size() + 16);
+
+  std::vector<char> ciphertext(size_result.ValueOrDie());
+  auto encrypt_result =
+      aead->EncryptInto(plaintext, aad, absl::MakeSpan(ciphertext));
+  ASSERT_THAT(encrypt_result.status(), IsOk());
+  EXPECT_EQ(encrypt_result.ValueOrDie(), ciphertext.size());
+  EXPECT_EQ(prefix, std::string(ciphertext.data(), prefix.size()));
+
+  // EncryptInto() output is accepted by Decrypt() and vice versa.
+  absl::string_view ciphertext_view(ciphertext.data(), ciphertext.size());
+  auto decrypt_result = aead->Decrypt(ciphertext_view, aad);
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ(plaintext, decrypt_result.ValueOrDie());
+
+  std::string ciphertext_str = aead->Encrypt(plaintext, aad).ValueOrDie();
+  std::vector<char> decrypted(ciphertext_str.size());
+  auto decrypt_into_result =
+      aead->DecryptInto(ciphertext_str, aad, absl::MakeSpan(decrypted));
+  ASSERT_THAT(decrypt_into_result.status(), IsOk());
+  EXPECT_EQ(plaintext,
+            std::string(decrypted.data(), decrypt_into_result.ValueOrDie()));
+
+  std::vector<char> too_small(ciphertext.size() - 1);
+  EXPECT_THAT(
+      aead->EncryptInto(plaintext, aad, absl::MakeSpan(too_small)).status(),
+      StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(AeadSetWrapperTest, EncryptIntoFallsBackForLegacyPrimitives) {
+  KeysetInfo keyset_info;
+  KeysetInfo::KeyInfo* key_info = keyset_info.add_key_info();
+  key_info->set_output_prefix_type(OutputPrefixType::TINK);
+  key_info->set_key_id(1234543);
+  key_info->set_status(KeyStatusType::ENABLED);
+
+  std::unique_ptr<PrimitiveSet<Aead>> aead_set(new PrimitiveSet<Aead>());
+  auto entry_result = aead_set->AddPrimitive(
+      absl::make_unique<DummyAead>("aead0"), keyset_info.key_info(0));
+  ASSERT_THAT(entry_result.status(), IsOk());
+  ASSERT_THAT(aead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+
+  AeadWrapper wrapper;
+  auto aead_result = wrapper.Wrap(std::move(aead_set));
+  ASSERT_THAT(aead_result.status(), IsOk());
+  std::unique_ptr<Aead> aead = std::move(aead_result.ValueOrDie());
+  std::string plaintext = "some_plaintext";
+  std::string aad = "some_aad";
+
+  // DummyAead does not report a ciphertext size, so neither does the wrapper.
+  EXPECT_THAT(aead->CiphertextSize(plaintext.size()).status(),
+              StatusIs(util::error::UNIMPLEMENTED));
+
+  std::string expected = aead->Encrypt(plaintext, aad).ValueOrDie();
+  std::vector<char> ciphertext(expected.size());
+  auto encrypt_result =
+      aead->EncryptInto(plaintext, aad, absl::MakeSpan(ciphertext));
+  ASSERT_THAT(encrypt_result.status(), IsOk());
+  EXPECT_EQ(expected, std::string(ciphertext.data(),
+                                  encrypt_result.ValueOrDie()));
+
+  std::vector<char> decrypted(expected.size());
+  auto decrypt_result =
+      aead->DecryptInto(expected, aad, absl::MakeSpan(decrypted));
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ(plaintext,
+            std::string(decrypted.data(), decrypt_result.ValueOrDie()));
+}
+// Returns a wrapped Aead over an AES-GCM primary with TINK prefix, a
+// DummyAead with LEGACY prefix and a DummyAead with RAW prefix.
+std::unique_ptr<Aead> NewBatchTestAead() {
+  KeysetInfo keyset_info;
+  KeysetInfo::KeyInfo* key_info = keyset_info.add_key_info();
+  key_info->set_output_prefix_type(OutputPrefixType::TINK);
+  key_info->set_key_id(1234543);
+  key_info->set_status(KeyStatusType::ENABLED);
+  key_info = keyset_info.add_key_info();
+  key_info->set_output_prefix_type(OutputPrefixType::LEGACY);
+  key_info->set_key_id(726329);
+  key_info->set_status(KeyStatusType::ENABLED);
+  key_info = keyset_info.add_key_info();
+  key_info->set_output_prefix_type(OutputPrefixType::RAW);
+  key_info->set_key_id(7213743);
+  key_info->set_status(KeyStatusType::ENABLED);
+
+  std::unique_ptr<PrimitiveSet<Aead>> aead_set(new PrimitiveSet<Aead>());
+  auto entry_result = aead_set->AddPrimitive(
+      subtle::AesGcmBoringSsl::New(subtle::Random::GetRandomKeyBytes(16))
+          .ValueOrDie(),
+      keyset_info.key_info(0));
+  EXPECT_THAT(aead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  EXPECT_THAT(aead_set
+                  ->AddPrimitive(absl::make_unique<DummyAead>("aead1"),
+                                 keyset_info.key_info(1))
+                  .status(),
+              IsOk());
+  EXPECT_THAT(aead_set
+                  ->AddPrimitive(absl::make_unique<DummyAead>("aead2"),
+                                 keyset_info.key_info(2))
+                  .status(),
+              IsOk());
+  return std::move(AeadWrapper().Wrap(std::move(aead_set)).ValueOrDie());
+}
+
+TEST(AeadSetWrapperTest, EncryptBatchDecryptBatch) {
+  std::unique_ptr<Aead> aead = NewBatchTestAead();
+  std::vector<absl::string_view> plaintexts = {"first", "", "third record"};
+  std::vector<absl::string_view> aads = {"aad0", "aad1", ""};
+
+  std::string ciphertexts;
+  std::vector<int64_t> ciphertext_offsets;
+  ASSERT_THAT(aead->EncryptBatch(plaintexts, aads, &ciphertexts,
+                                 &ciphertext_offsets),
+              IsOk());
+  ASSERT_EQ(ciphertext_offsets.size(), plaintexts.size() + 1);
+  EXPECT_EQ(ciphertext_offsets.front(), 0);
+  EXPECT_EQ(ciphertext_offsets.back(), ciphertexts.size());
+
+  std::vector<absl::string_view> ciphertext_views;
+  for (size_t i = 0; i < plaintexts.size(); i++) {
+    absl::string_view ciphertext = absl::string_view(ciphertexts).substr(
+        ciphertext_offsets[i],
+        ciphertext_offsets[i + 1] - ciphertext_offsets[i]);
+    auto decrypt_result = aead->Decrypt(ciphertext, aads[i]);
+    ASSERT_THAT(decrypt_result.status(), IsOk());
+    EXPECT_EQ(plaintexts[i], decrypt_result.ValueOrDie());
+    ciphertext_views.push_back(ciphertext);
+  }
+
+  // Mix in ciphertexts of the non-primary LEGACY and RAW keys.
+  KeysetInfo::KeyInfo legacy_key_info;
+  legacy_key_info.set_output_prefix_type(OutputPrefixType::LEGACY);
+  legacy_key_info.set_key_id(726329);
+  std::string legacy_ciphertext = absl::StrCat(
+      CryptoFormat::GetOutputPrefix(legacy_key_info).ValueOrDie(),
+      DummyAead("aead1").Encrypt("legacy", "aad3").ValueOrDie());
+  std::string raw_ciphertext =
+      DummyAead("aead2").Encrypt("raw", "aad4").ValueOrDie();
+  ciphertext_views.push_back(legacy_ciphertext);
+  ciphertext_views.push_back(raw_ciphertext);
+  aads.push_back("aad3");
+  aads.push_back("aad4");
+
+  std::string decrypted;
+  std::vector<int64_t> plaintext_offsets;
+  ASSERT_THAT(aead->DecryptBatch(ciphertext_views, aads, &decrypted,
+                                 &plaintext_offsets),
+              IsOk());
+  EXPECT_EQ(decrypted, "firstthird recordlegacyraw");
+  EXPECT_THAT(plaintext_offsets, testing::ElementsAre(0, 5, 5, 17, 23, 26));
+
+  // A single bad record fails the whole batch.
+  std::string tampered(ciphertext_views[0]);
+  tampered.back() ^= 1;
+  ciphertext_views[0] = tampered;
+  EXPECT_THAT(aead->DecryptBatch(ciphertext_views, aads, &decrypted,
+                                 &plaintext_offsets),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(AeadSetWrapperTest, BatchOfPrimaryCiphertexts) {
+  std::unique_ptr<Aead> aead = NewBatchTestAead();
+  std::vector<std::string> records;
+  for (int i = 0; i < 20; i++) records.push_back(std::string(i * 7, 'a' + i));
+  std::vector<absl::string_view> plaintexts(records.begin(), records.end());
+  std::vector<absl::string_view> aads(plaintexts.size(), "aad");
+
+  std::string ciphertexts;
+  std::vector<int64_t> ciphertext_offsets;
+  ASSERT_THAT(aead->EncryptBatch(plaintexts, aads, &ciphertexts,
+                                 &ciphertext_offsets),
+              IsOk());
+  ASSERT_EQ(ciphertext_offsets.size(), plaintexts.size() + 1);
+  std::vector<absl::string_view> ciphertext_views;
+  for (size_t i = 0; i < plaintexts.size(); i++) {
+    ciphertext_views.push_back(absl::string_view(ciphertexts).substr(
+        ciphertext_offsets[i],
+        ciphertext_offsets[i + 1] - ciphertext_offsets[i]));
+    auto decrypt_result = aead->Decrypt(ciphertext_views[i], aads[i]);
+    ASSERT_THAT(decrypt_result.status(), IsOk());
+    EXPECT_EQ(plaintexts[i], decrypt_result.ValueOrDie());
+  }
+
+  std::string decrypted;
+  std::vector<int64_t> plaintext_offsets;
+  ASSERT_THAT(aead->DecryptBatch(ciphertext_views, aads, &decrypted,
+                                 &plaintext_offsets),
+              IsOk());
+  EXPECT_EQ(decrypted, absl::StrJoin(records, ""));
+  ASSERT_EQ(plaintext_offsets.size(), records.size() + 1);
+  EXPECT_EQ(plaintext_offsets[5], 7 * (0 + 1 + 2 + 3 + 4));
+
+  // A tampered record fails the batch, also when tried record by record.
+  std::string tampered(ciphertext_views[3]);
+  tampered.back() ^= 1;
+  ciphertext_views[3] = tampered;
+  EXPECT_THAT(aead->DecryptBatch(ciphertext_views, aads, &decrypted,
+                                 &plaintext_offsets),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(AeadSetWrapperTest, BatchSizeMismatch) {
+  std::unique_ptr<Aead> aead = NewBatchTestAead();
+  std::vector<absl::string_view> inputs = {"a", "b"};
+  std::vector<absl::string_view> aads = {"aad"};
+  std::string output;
+  std::vector<int64_t> offsets;
+  EXPECT_THAT(aead->EncryptBatch(inputs, aads, &output, &offsets),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(aead->DecryptBatch(inputs, aads, &output, &offsets),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(AeadSetWrapperTest, EncryptBatchFallsBackForLegacyPrimitives) {
+  KeysetInfo keyset_info;
+  KeysetInfo::KeyInfo* key_info = keyset_info.add_key_info();
+  key_info->set_output_prefix_type(OutputPrefixType::TINK);
+  key_info->set_key_id(1234543);
+  key_info->set_status(KeyStatusType::ENABLED);
+  std::unique_ptr<PrimitiveSet<Aead>> aead_set(new PrimitiveSet<Aead>());
+  auto entry_result = aead_set->AddPrimitive(
+      absl::make_unique<DummyAead>("aead0"), keyset_info.key_info(0));
+  ASSERT_THAT(entry_result.status(), IsOk());
+  ASSERT_THAT(aead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  std::unique_ptr<Aead> aead =
+      std::move(AeadWrapper().Wrap(std::move(aead_set)).ValueOrDie());
+
+  std::vector<absl::string_view> plaintexts = {"first", "second"};
+  std::vector<absl::string_view> aads = {"aad0", "aad1"};
+  std::string ciphertexts;
+  std::vector<int64_t> offsets;
+  ASSERT_THAT(aead->EncryptBatch(plaintexts, aads, &ciphertexts, &offsets),
+              IsOk());
+  ASSERT_EQ(offsets.size(), 3);
+  EXPECT_EQ(ciphertexts,
+            absl::StrCat(aead->Encrypt("first", "aad0").ValueOrDie(),
+                         aead->Encrypt("second", "aad1").ValueOrDie()));
+}
+
+TEST(AeadSetWrapperTest, EncryptGatherIntoDecryptScatterInto) {
+  std::unique_ptr<Aead> aead = NewBatchTestAead();
+  std::string plaintext = "header|body fragment 1|body fragment 2";
+  std::vector<absl::string_view> parts = {
+      absl::string_view(plaintext).substr(0, 7),
+      absl::string_view(plaintext).substr(7, 16),
+      absl::string_view(plaintext).substr(23)};
+  std::string aad = "some_aad";
+
+  std::vector<char> ciphertext(
+      aead->CiphertextSize(plaintext.size()).ValueOrDie());
+  auto encrypt_result =
+      aead->EncryptGatherInto(parts, aad, absl::MakeSpan(ciphertext));
+  ASSERT_THAT(encrypt_result.status(), IsOk());
+  EXPECT_EQ(encrypt_result.ValueOrDie(), ciphertext.size());
+  absl::string_view ciphertext_view(ciphertext.data(), ciphertext.size());
+  auto decrypt_result = aead->Decrypt(ciphertext_view, aad);
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ(plaintext, decrypt_result.ValueOrDie());
+
+  std::vector<char> decrypted(plaintext.size());
+  std::vector<absl::Span<char>> buffers = {
+      absl::MakeSpan(decrypted).subspan(0, 10),
+      absl::MakeSpan(decrypted).subspan(10)};
+  auto decrypt_scatter_result =
+      aead->DecryptScatterInto(ciphertext_view, aad, buffers);
+  ASSERT_THAT(decrypt_scatter_result.status(), IsOk());
+  EXPECT_EQ(plaintext, std::string(decrypted.data(),
+                                   decrypt_scatter_result.ValueOrDie()));
+
+  EXPECT_THAT(aead->DecryptScatterInto(ciphertext_view, "other_aad", buffers)
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(AeadSetWrapperTest, EncryptGatherIntoFallsBackForLegacyPrimitives) {
+  KeysetInfo keyset_info;
+  KeysetInfo::KeyInfo* key_info = keyset_info.add_key_info();
+  key_info->set_output_prefix_type(OutputPrefixType::TINK);
+  key_info->set_key_id(1234543);
+  key_info->set_status(KeyStatusType::ENABLED);
+  std::unique_ptr<PrimitiveSet<Aead>> aead_set(new PrimitiveSet<Aead>());
+  auto entry_result = aead_set->AddPrimitive(
+      absl::make_unique<DummyAead>("aead0"), keyset_info.key_info(0));
+  ASSERT_THAT(entry_result.status(), IsOk());
+  ASSERT_THAT(aead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  std::unique_ptr<Aead> aead =
+      std::move(AeadWrapper().Wrap(std::move(aead_set)).ValueOrDie());
+
+  std::vector<absl::string_view> parts = {"first", "", "second"};
+  std::string expected = aead->Encrypt("firstsecond", "aad").ValueOrDie();
+  std::vector<char> ciphertext(expected.size());
+  auto encrypt_result =
+      aead->EncryptGatherInto(parts, "aad", absl::MakeSpan(ciphertext));
+  ASSERT_THAT(encrypt_result.status(), IsOk());
+  EXPECT_EQ(expected,
+            std::string(ciphertext.data(), encrypt_result.ValueOrDie()));
+
+  std::vector<char> decrypted(expected.size());
+  std::vector<absl::Span<char>> buffers = {
+      absl::MakeSpan(decrypted).subspan(0, 3),
+      absl::MakeSpan(decrypted).subspan(3)};
+  auto decrypt_result = aead->DecryptScatterInto(expected, "aad", buffers);
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ("firstsecond",
+            std::string(decrypted.data(), decrypt_result.ValueOrDie()));
+}
+
+TEST(AeadSetWrapperTest, DecryptInPlace) {
+  KeysetInfo keyset_info;
+  KeysetInfo::KeyInfo* key_info = keyset_info.add_key_info();
+  key_info->set_output_prefix_type(OutputPrefixType::TINK);
+  key_info->set_key_id(1234543);
+  key_info->set_status(KeyStatusType::ENABLED);
+  std::unique_ptr<PrimitiveSet<Aead>> aead_set(new PrimitiveSet<Aead>());
+  auto entry_result = aead_set->AddPrimitive(
+      subtle::AesGcmBoringSsl::New(subtle::Random::GetRandomKeyBytes(16))
+          .ValueOrDie(),
+      keyset_info.key_info(0));
+  ASSERT_THAT(entry_result.status(), IsOk());
+  ASSERT_THAT(aead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  std::unique_ptr<Aead> aead =
+      std::move(AeadWrapper().Wrap(std::move(aead_set)).ValueOrDie());
+  std::string plaintext = "some_plaintext";
+  std::string aad = "some_aad";
+  std::string ciphertext = aead->Encrypt(plaintext, aad).ValueOrDie();
+
+  // With a single matching key, the plaintext is decrypted in place, right
+  // after the key prefix and the IV.
+  std::string buffer = ciphertext;
+  auto decrypt_result =
+      aead->DecryptInPlace(absl::MakeSpan(&buffer[0], buffer.size()), aad);
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ(decrypt_result.ValueOrDie().data(),
+            &buffer[CryptoFormat::kNonRawPrefixSize + 12]);
+  EXPECT_EQ(plaintext, std::string(decrypt_result.ValueOrDie().data(),
+                                   decrypt_result.ValueOrDie().size()));
+
+  buffer = ciphertext;
+  EXPECT_THAT(aead->DecryptInPlace(absl::MakeSpan(&buffer[0], buffer.size()),
+                                   "other_aad")
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(AeadSetWrapperTest, DecryptInPlaceWithSeveralKeys) {
+  std::unique_ptr<Aead> aead = NewBatchTestAead();
+  std::string plaintext = "some_plaintext";
+  std::string aad = "some_aad";
+
+  // The RAW DummyAead is also a candidate for every ciphertext, so the
+  // ciphertext can no longer be decrypted in place, but the result is still
+  // returned in the ciphertext buffer.
+  std::string buffer = aead->Encrypt(plaintext, aad).ValueOrDie();
+  auto decrypt_result =
+      aead->DecryptInPlace(absl::MakeSpan(&buffer[0], buffer.size()), aad);
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ(decrypt_result.ValueOrDie().data(), &buffer[0]);
+  EXPECT_EQ(plaintext, std::string(decrypt_result.ValueOrDie().data(),
+                                   decrypt_result.ValueOrDie().size()));
+
+  std::string raw_ciphertext =
+      DummyAead("aead2").Encrypt(plaintext, aad).ValueOrDie();
+  auto raw_decrypt_result = aead->DecryptInPlace(
+      absl::MakeSpan(&raw_ciphertext[0], raw_ciphertext.size()), aad);
+  ASSERT_THAT(raw_decrypt_result.status(), IsOk());
+  EXPECT_EQ(plaintext, std::string(raw_decrypt_result.ValueOrDie().data(),
+                                   raw_decrypt_result.ValueOrDie().size()));
+}
+
+// Returns a wrapped Aead over a DummyAead "tink" with TINK prefix, which is
+// the primary, and DummyAeads "raw1" and "raw2" with RAW prefix.
+std::unique_ptr<Aead> NewRawFallbackTestAead(
+    const RawKeyFallbackPolicy& policy) {
+  KeysetInfo keyset_info;
+  std::unique_ptr<PrimitiveSet<Aead>> aead_set(new PrimitiveSet<Aead>());
+  const char* const kNames[] = {"tink", "raw1", "raw2"};
+  for (int i = 0; i < 3; i++) {
+    KeysetInfo::KeyInfo* key_info = keyset_info.add_key_info();
+    key_info->set_output_prefix_type(i == 0 ? OutputPrefixType::TINK
+                                            : OutputPrefixType::RAW);
+    key_info->set_key_id(1000 + i);
+    key_info->set_status(KeyStatusType::ENABLED);
+    auto entry_result = aead_set->AddPrimitive(
+        absl::make_unique<DummyAead>(kNames[i]), *key_info);
+    EXPECT_THAT(entry_result.status(), IsOk());
+    if (i == 0) {
+      EXPECT_THAT(aead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+    }
+  }
+  return std::move(AeadWrapper(policy).Wrap(std::move(aead_set)).ValueOrDie());
+}
+
+TEST(AeadSetWrapperTest, RawKeyFallbackPolicy) {
+  std::string aad = "some_aad";
+  std::string raw2_ciphertext =
+      DummyAead("raw2").Encrypt("plaintext", aad).ValueOrDie();
+
+  RawKeyFallbackCounters counters;
+  RawKeyFallbackPolicy policy;
+  policy.counters = &counters;
+  std::unique_ptr<Aead> aead = NewRawFallbackTestAead(policy);
+  std::string ciphertext = aead->Encrypt("plaintext", aad).ValueOrDie();
+  EXPECT_THAT(aead->Decrypt(ciphertext, aad).status(), IsOk());
+  EXPECT_EQ(counters.fallbacks, 0);
+  EXPECT_THAT(aead->Decrypt(raw2_ciphertext, aad).status(), IsOk());
+  EXPECT_EQ(counters.fallbacks, 1);
+  EXPECT_EQ(counters.raw_attempts, 2);
+  EXPECT_EQ(counters.raw_successes, 1);
+  EXPECT_EQ(counters.skipped, 0);
+
+  // The second RAW key is no longer tried.
+  RawKeyFallbackCounters limited_counters;
+  policy.max_raw_attempts = 1;
+  policy.counters = &limited_counters;
+  aead = NewRawFallbackTestAead(policy);
+  EXPECT_THAT(aead->Decrypt(raw2_ciphertext, aad).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  std::string plaintext(raw2_ciphertext.size(), '\0');
+  EXPECT_THAT(aead->DecryptInto(raw2_ciphertext, aad,
+                                absl::MakeSpan(&plaintext[0], plaintext.size()))
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_EQ(limited_counters.fallbacks, 2);
+  EXPECT_EQ(limited_counters.raw_attempts, 2);
+  EXPECT_EQ(limited_counters.raw_successes, 0);
+  EXPECT_EQ(limited_counters.skipped, 2);
+
+  // Ciphertexts with the prefix of the TINK key are not tried with RAW keys.
+  RawKeyFallbackCounters skip_counters;
+  policy.max_raw_attempts = -1;
+  policy.skip_if_prefix_matched = true;
+  policy.counters = &skip_counters;
+  aead = NewRawFallbackTestAead(policy);
+  EXPECT_THAT(aead->Decrypt(ciphertext, "other aad").status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(aead->Decrypt(raw2_ciphertext, aad).status(), IsOk());
+  EXPECT_EQ(skip_counters.fallbacks, 1);
+  EXPECT_EQ(skip_counters.raw_successes, 1);
+  EXPECT_EQ(skip_counters.skipped, 1);
+}
+
+// Wraps a set with a single AES-GCM primitive for 'key' and 'key_info',
+// frozen if 'freeze', in which case the wrapper takes the single-key path.
+std::unique_ptr<Aead> WrapSingleAesGcm(const util::SecretData& key,
+                                       const KeysetInfo::KeyInfo& key_info,
+                                       bool freeze) {
+  std::unique_ptr<PrimitiveSet<Aead>> aead_set(new PrimitiveSet<Aead>());
+  auto entry_result = aead_set->AddPrimitive(
+      std::move(subtle::AesGcmBoringSsl::New(key).ValueOrDie()), key_info);
+  EXPECT_THAT(entry_result.status(), IsOk());
+  EXPECT_THAT(aead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  if (freeze) aead_set->Freeze();
+  return std::move(AeadWrapper().Wrap(std::move(aead_set)).ValueOrDie());
+}
+
+TEST(AeadSetWrapperTest, SingleKeyMatchesGeneralWrapper) {
+  util::SecretData key = subtle::Random::GetRandomKeyBytes(16);
+  for (OutputPrefixType prefix_type :
+       {OutputPrefixType::TINK, OutputPrefixType::LEGACY,
+        OutputPrefixType::CRUNCHY, OutputPrefixType::RAW}) {
+    SCOPED_TRACE(prefix_type);
+    KeysetInfo::KeyInfo key_info;
+    key_info.set_output_prefix_type(prefix_type);
+    key_info.set_key_id(1234543);
+    key_info.set_status(KeyStatusType::ENABLED);
+    std::unique_ptr<Aead> single = WrapSingleAesGcm(key, key_info, true);
+    std::unique_ptr<Aead> general = WrapSingleAesGcm(key, key_info, false);
+    std::string plaintext = "some_plaintext";
+    std::string aad = "some_aad";
+
+    // Each wrapper decrypts the ciphertexts of the other.
+    auto ciphertext = single->Encrypt(plaintext, aad);
+    ASSERT_THAT(ciphertext.status(), IsOk());
+    auto decrypted = general->Decrypt(ciphertext.ValueOrDie(), aad);
+    ASSERT_THAT(decrypted.status(), IsOk());
+    EXPECT_EQ(decrypted.ValueOrDie(), plaintext);
+    decrypted = single->Decrypt(
+        general->Encrypt(plaintext, aad).ValueOrDie(), aad);
+    ASSERT_THAT(decrypted.status(), IsOk());
+    EXPECT_EQ(decrypted.ValueOrDie(), plaintext);
+    EXPECT_EQ(single->CiphertextSize(plaintext.size()).ValueOrDie(),
+              general->CiphertextSize(plaintext.size()).ValueOrDie());
+
+    std::vector<char> buffer(ciphertext.ValueOrDie().size());
+    auto written = single->EncryptInto(plaintext, aad, absl::MakeSpan(buffer));
+    ASSERT_THAT(written.status(), IsOk());
+    std::string ciphertext_into(buffer.data(), written.ValueOrDie());
+    EXPECT_EQ(general->Decrypt(ciphertext_into, aad).ValueOrDie(), plaintext);
+    auto read = single->DecryptInto(ciphertext.ValueOrDie(), aad,
+                                    absl::MakeSpan(buffer));
+    ASSERT_THAT(read.status(), IsOk());
+    EXPECT_EQ(std::string(buffer.data(), read.ValueOrDie()), plaintext);
+
+    // Ciphertexts with another or no key prefix are rejected by both.
+    std::string other_prefix = ciphertext.ValueOrDie();
+    other_prefix[1] ^= 1;
+    for (const std::string& bad_ciphertext :
+         {other_prefix, std::string(ciphertext.ValueOrDie(), 0, 3)}) {
+      EXPECT_FALSE(single->Decrypt(bad_ciphertext, aad).ok());
+      EXPECT_FALSE(general->Decrypt(bad_ciphertext, aad).ok());
+    }
+    EXPECT_FALSE(single->Decrypt(ciphertext.ValueOrDie(), "other aad").ok());
+  }
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
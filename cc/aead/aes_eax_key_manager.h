@@ -22,7 +22,7 @@
 #include "absl/strings/str_cat.h"
 #include "tink/aead.h"
 #include "tink/core/key_type_manager.h"
-#include "tink/subtle/aes_eax_boringssl.h"
+#include "tink/subtle/aes_eax_dispatch.h"
 #include "tink/subtle/random.h"
 #include "tink/util/constants.h"
 #include "tink/util/errors.h"
@@ -43,7 +43,7 @@ class AesEaxKeyManager
   class AeadFactory : public PrimitiveFactory<Aead> {
     crypto::tink::util::StatusOr<std::unique_ptr<Aead>> Create(
         const google::crypto::tink::AesEaxKey& key) const override {
-      return subtle::AesEaxBoringSsl::New(
+      return subtle::NewAesEax(
           util::SecretDataFromStringView(key.key_value()),
           key.params().iv_size());
     }
@@ -0,0 +1,90 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/aead/aes_gcm_primary_aead.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tink/aead.h"
+#include "tink/aead/aes_gcm_key_manager.h"
+#include "tink/cleartext_keyset_handle.h"
+#include "tink/crypto_format.h"
+#include "tink/internal/key_info.h"
+#include "tink/subtle/aes_gcm_boringssl.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/aes_gcm.pb.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+using ::google::crypto::tink::AesGcmKey;
+using ::google::crypto::tink::Keyset;
+
+util::StatusOr<std::unique_ptr<AesGcmPrimaryAead>> AesGcmPrimaryAead::New(
+    const KeysetHandle& keyset_handle) {
+  const Keyset& keyset = CleartextKeysetHandle::GetKeyset(keyset_handle);
+  const Keyset::Key* primary = nullptr;
+  for (const Keyset::Key& key : keyset.key()) {
+    if (key.key_id() == keyset.primary_key_id()) primary = &key;
+  }
+  if (primary == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "The keyset has no primary key.");
+  }
+  AesGcmKeyManager key_manager;
+  if (primary->key_data().type_url() != key_manager.get_key_type()) {
+    return util::Status(
+        util::error::FAILED_PRECONDITION,
+        absl::StrCat("The primary key is not an AES-GCM key, but of type ",
+                     primary->key_data().type_url()));
+  }
+  // The keyset primitive validates the whole keyset, including the primary.
+  auto keyset_aead_result = keyset_handle.GetPrimitive<Aead>();
+  if (!keyset_aead_result.ok()) return keyset_aead_result.status();
+
+  AesGcmKey key;
+  if (!key.ParseFromString(primary->key_data().value())) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "Could not parse the primary AES-GCM key.");
+  }
+  util::Status status = key_manager.ValidateKey(key);
+  if (!status.ok()) return status;
+  auto aes_gcm_result = subtle::AesGcmBoringSsl::New(
+      util::SecretDataFromStringView(key.key_value()));
+  if (!aes_gcm_result.ok()) return aes_gcm_result.status();
+  // AesGcmBoringSsl::New() always returns an AesGcmBoringSsl.
+  std::unique_ptr<subtle::AesGcmBoringSsl> aes_gcm(
+      static_cast<subtle::AesGcmBoringSsl*>(
+          aes_gcm_result.ValueOrDie().release()));
+
+  auto prefix_result =
+      CryptoFormat::GetOutputPrefix(KeyInfoFromKey(*primary));
+  if (!prefix_result.ok()) return prefix_result.status();
+  return absl::WrapUnique(new AesGcmPrimaryAead(
+      std::move(aes_gcm), prefix_result.ValueOrDie(),
+      std::move(keyset_aead_result.ValueOrDie())));
+}
+
+}  // namespace tink
+}  // namespace crypto
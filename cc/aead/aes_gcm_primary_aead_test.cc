@@ -0,0 +1,125 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/aead/aes_gcm_primary_aead.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/types/span.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_config.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/keyset_handle.h"
+#include "tink/keyset_manager.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+class AesGcmPrimaryAeadTest : public ::testing::Test {
+ protected:
+  void SetUp() override { ASSERT_THAT(AeadConfig::Register(), IsOk()); }
+};
+
+TEST_F(AesGcmPrimaryAeadTest, InteroperatesWithKeysetAead) {
+  for (const auto* key_template : {&AeadKeyTemplates::Aes128Gcm(),
+                                   &AeadKeyTemplates::Aes256GcmNoPrefix()}) {
+    auto handle = KeysetHandle::GenerateNew(*key_template);
+    ASSERT_THAT(handle.status(), IsOk());
+    auto fast = AesGcmPrimaryAead::New(*handle.ValueOrDie());
+    ASSERT_THAT(fast.status(), IsOk());
+    auto aead = handle.ValueOrDie()->GetPrimitive<Aead>();
+    ASSERT_THAT(aead.status(), IsOk());
+    std::string plaintext = "some plaintext";
+    std::string aad = "some aad";
+
+    auto ciphertext = fast.ValueOrDie()->Encrypt(plaintext, aad);
+    ASSERT_THAT(ciphertext.status(), IsOk());
+    EXPECT_EQ(ciphertext.ValueOrDie().size(),
+              fast.ValueOrDie()->CiphertextSize(plaintext.size()));
+    EXPECT_EQ(aead.ValueOrDie()->CiphertextSize(plaintext.size()).ValueOrDie(),
+              fast.ValueOrDie()->CiphertextSize(plaintext.size()));
+    auto decrypted = aead.ValueOrDie()->Decrypt(ciphertext.ValueOrDie(), aad);
+    ASSERT_THAT(decrypted.status(), IsOk());
+    EXPECT_EQ(decrypted.ValueOrDie(), plaintext);
+
+    decrypted = fast.ValueOrDie()->Decrypt(
+        aead.ValueOrDie()->Encrypt(plaintext, aad).ValueOrDie(), aad);
+    ASSERT_THAT(decrypted.status(), IsOk());
+    EXPECT_EQ(decrypted.ValueOrDie(), plaintext);
+    EXPECT_FALSE(
+        fast.ValueOrDie()->Decrypt(ciphertext.ValueOrDie(), "other aad").ok());
+
+    std::vector<char> buffer(
+        fast.ValueOrDie()->CiphertextSize(plaintext.size()));
+    auto written = fast.ValueOrDie()->EncryptInto(plaintext, aad,
+                                                  absl::MakeSpan(buffer));
+    ASSERT_THAT(written.status(), IsOk());
+    EXPECT_EQ(written.ValueOrDie(), buffer.size());
+    decrypted = aead.ValueOrDie()->Decrypt(
+        absl::string_view(buffer.data(), buffer.size()), aad);
+    ASSERT_THAT(decrypted.status(), IsOk());
+    EXPECT_EQ(decrypted.ValueOrDie(), plaintext);
+    buffer.pop_back();
+    EXPECT_THAT(fast.ValueOrDie()
+                    ->EncryptInto(plaintext, aad, absl::MakeSpan(buffer))
+                    .status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+}
+
+TEST_F(AesGcmPrimaryAeadTest, DecryptsCiphertextsOfOtherKeys) {
+  auto manager = KeysetManager::New(AeadKeyTemplates::Aes128CtrHmacSha256());
+  ASSERT_THAT(manager.status(), IsOk());
+  auto old_aead =
+      manager.ValueOrDie()->GetKeysetHandle()->GetPrimitive<Aead>();
+  ASSERT_THAT(old_aead.status(), IsOk());
+  std::string old_ciphertext =
+      old_aead.ValueOrDie()->Encrypt("old plaintext", "aad").ValueOrDie();
+
+  ASSERT_THAT(
+      manager.ValueOrDie()->Rotate(AeadKeyTemplates::Aes128Gcm()).status(),
+      IsOk());
+  auto fast =
+      AesGcmPrimaryAead::New(*manager.ValueOrDie()->GetKeysetHandle());
+  ASSERT_THAT(fast.status(), IsOk());
+  auto decrypted = fast.ValueOrDie()->Decrypt(old_ciphertext, "aad");
+  ASSERT_THAT(decrypted.status(), IsOk());
+  EXPECT_EQ(decrypted.ValueOrDie(), "old plaintext");
+}
+
+TEST_F(AesGcmPrimaryAeadTest, RejectsOtherPrimaryKeyTypes) {
+  auto handle =
+      KeysetHandle::GenerateNew(AeadKeyTemplates::Aes128CtrHmacSha256());
+  ASSERT_THAT(handle.status(), IsOk());
+  EXPECT_THAT(AesGcmPrimaryAead::New(*handle.ValueOrDie()).status(),
+              StatusIs(util::error::FAILED_PRECONDITION));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -21,6 +21,8 @@
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "tink/aead.h"
+#include "tink/aead/cord_aead.h"
+#include "tink/aead/internal/cord_aead_from_aead.h"
 #include "tink/core/key_type_manager.h"
 #include "tink/subtle/aes_gcm_siv_boringssl.h"
 #include "tink/subtle/random.h"
@@ -38,7 +40,7 @@ namespace tink {
 class AesGcmSivKeyManager
     : public KeyTypeManager<google::crypto::tink::AesGcmSivKey,
                             google::crypto::tink::AesGcmSivKeyFormat,
-                            List<Aead>> {
+                            List<Aead, CordAead>> {
  public:
   class AeadFactory : public PrimitiveFactory<Aead> {
     crypto::tink::util::StatusOr<std::unique_ptr<Aead>> Create(
@@ -47,8 +49,19 @@ class AesGcmSivKeyManager
           util::SecretDataFromStringView(key.key_value()));
     }
   };
+  class CordAeadFactory : public PrimitiveFactory<CordAead> {
+    crypto::tink::util::StatusOr<std::unique_ptr<CordAead>> Create(
+        const google::crypto::tink::AesGcmSivKey& key) const override {
+      auto aes_gcm_siv_result = subtle::AesGcmSivBoringSsl::New(
+          util::SecretDataFromStringView(key.key_value()));
+      if (!aes_gcm_siv_result.ok()) return aes_gcm_siv_result.status();
+      return CordAeadFromAead::New(std::move(aes_gcm_siv_result.ValueOrDie()));
+    }
+  };
 
-  AesGcmSivKeyManager() : KeyTypeManager(absl::make_unique<AeadFactory>()) {}
+  AesGcmSivKeyManager()
+      : KeyTypeManager(absl::make_unique<AeadFactory>(),
+                       absl::make_unique<CordAeadFactory>()) {}
 
   uint32_t get_version() const override { return 0; }
 
@@ -18,7 +18,9 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/cord.h"
 #include "tink/aead.h"
+#include "tink/aead/cord_aead.h"
 #include "tink/subtle/aead_test_util.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/status.h"
@@ -173,6 +175,40 @@ TEST(AesGcmSivKeyManagerTest, CreateAead) {
               IsOk());
 }
 
+TEST(AesGcmSivKeyManagerTest, CreateCordAead) {
+  AesGcmSivKeyFormat format;
+  format.set_key_size(32);
+  StatusOr<AesGcmSivKey> key_or = AesGcmSivKeyManager().CreateKey(format);
+  ASSERT_THAT(key_or.status(), IsOk());
+
+  StatusOr<std::unique_ptr<CordAead>> cord_aead_or =
+      AesGcmSivKeyManager().GetPrimitive<CordAead>(key_or.ValueOrDie());
+  ASSERT_THAT(cord_aead_or.status(), IsOk());
+  StatusOr<std::unique_ptr<Aead>> aead_or =
+      AesGcmSivKeyManager().GetPrimitive<Aead>(key_or.ValueOrDie());
+  ASSERT_THAT(aead_or.status(), IsOk());
+
+  // Ciphertexts of the CordAead are ordinary ciphertexts of the key.
+  StatusOr<absl::Cord> ciphertext_or =
+      cord_aead_or.ValueOrDie()->Encrypt(absl::Cord("message"),
+                                         absl::Cord("aad"));
+  ASSERT_THAT(ciphertext_or.status(), IsOk());
+  StatusOr<std::string> plaintext_or = aead_or.ValueOrDie()->Decrypt(
+      std::string(ciphertext_or.ValueOrDie()), "aad");
+  ASSERT_THAT(plaintext_or.status(), IsOk());
+  EXPECT_THAT(plaintext_or.ValueOrDie(), Eq("message"));
+
+  StatusOr<std::string> other_ciphertext_or =
+      aead_or.ValueOrDie()->Encrypt("other message", "aad");
+  ASSERT_THAT(other_ciphertext_or.status(), IsOk());
+  StatusOr<absl::Cord> other_plaintext_or =
+      cord_aead_or.ValueOrDie()->Decrypt(
+          absl::Cord(other_ciphertext_or.ValueOrDie()), absl::Cord("aad"));
+  ASSERT_THAT(other_plaintext_or.status(), IsOk());
+  EXPECT_THAT(std::string(other_plaintext_or.ValueOrDie()),
+              Eq("other message"));
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
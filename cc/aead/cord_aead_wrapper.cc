@@ -99,7 +99,10 @@ util::StatusOr<absl::Cord> CordAeadSetWrapper::Decrypt(
       }
     }
   }
-  return util::Status(util::error::INVALID_ARGUMENT, "decryption failed");
+  static const util::Status* kDecryptionFailed =
+      util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                              "decryption failed");
+  return *kDecryptionFailed;
 }
 }  // anonymous namespace
 
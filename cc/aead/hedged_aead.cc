@@ -0,0 +1,244 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/aead/hedged_aead.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "tink/aead.h"
+#include "tink/async_aead.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+using crypto::tink::util::Status;
+using crypto::tink::util::StatusOr;
+
+namespace {
+
+// The hedge delay is the percentile of up to this many recent latencies...
+constexpr int kMaxLatencies = 256;
+// ... once at least this many have been observed.
+constexpr int kMinLatencies = 20;
+
+}  // namespace
+
+struct HedgedAead::State {
+  std::vector<std::unique_ptr<Aead>> replicas;
+  std::vector<const AsyncAead*> async_replicas;
+
+  absl::Mutex mutex;
+  // The latencies of successful requests, overwritten round-robin.
+  std::vector<absl::Duration> latencies ABSL_GUARDED_BY(mutex);
+  int64_t num_latencies ABSL_GUARDED_BY(mutex) = 0;
+  Stats stats ABSL_GUARDED_BY(mutex);
+
+  void RecordLatency(absl::Duration latency) {
+    absl::MutexLock lock(&mutex);
+    if (latencies.size() < kMaxLatencies) {
+      latencies.push_back(latency);
+    } else {
+      latencies[num_latencies % kMaxLatencies] = latency;
+    }
+    ++num_latencies;
+  }
+
+  absl::Duration HedgeDelay(const Options& options) {
+    std::vector<absl::Duration> sorted;
+    {
+      absl::MutexLock lock(&mutex);
+      if (latencies.size() < kMinLatencies) {
+        return std::max(options.initial_hedge_delay, options.min_hedge_delay);
+      }
+      sorted = latencies;
+    }
+    auto nth = sorted.begin() + static_cast<int64_t>(options.hedge_percentile *
+                                                     (sorted.size() - 1));
+    std::nth_element(sorted.begin(), nth, sorted.end());
+    return std::max(*nth, options.min_hedge_delay);
+  }
+};
+
+// The requests of one Encrypt() or Decrypt() call.
+struct HedgedAead::Call {
+  absl::Mutex mutex;
+  int pending ABSL_GUARDED_BY(mutex) = 0;
+  bool done ABSL_GUARDED_BY(mutex) = false;
+  bool hedge_won ABSL_GUARDED_BY(mutex) = false;
+  std::string output ABSL_GUARDED_BY(mutex);
+  // The first error returned by a replica.
+  Status status ABSL_GUARDED_BY(mutex);
+
+  bool DoneOrIdle() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex) {
+    return done || pending == 0;
+  }
+};
+
+// static
+StatusOr<std::unique_ptr<HedgedAead>> HedgedAead::New(
+    std::vector<std::unique_ptr<Aead>> replicas, const Options& options) {
+  if (replicas.empty()) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "At least one replica is required.");
+  }
+  if (options.hedge_percentile < 0 || options.hedge_percentile >= 1) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "hedge_percentile must be in [0, 1).");
+  }
+  if (options.deadline <= absl::ZeroDuration()) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "deadline must be positive.");
+  }
+  auto state = std::make_shared<State>();
+  for (auto& replica : replicas) {
+    if (replica == nullptr) {
+      return Status(util::error::INVALID_ARGUMENT,
+                    "Replicas must not be null.");
+    }
+    auto* async_replica = dynamic_cast<const AsyncAead*>(replica.get());
+    if (async_replica == nullptr) {
+      return Status(util::error::INVALID_ARGUMENT,
+                    "Replicas must implement AsyncAead.");
+    }
+    state->async_replicas.push_back(async_replica);
+  }
+  state->replicas = std::move(replicas);
+  return absl::WrapUnique(new HedgedAead(std::move(state), options));
+}
+
+StatusOr<std::string> HedgedAead::Encrypt(
+    absl::string_view plaintext, absl::string_view associated_data) const {
+  return Run(/*encrypt=*/true, plaintext, associated_data);
+}
+
+StatusOr<std::string> HedgedAead::Decrypt(
+    absl::string_view ciphertext, absl::string_view associated_data) const {
+  return Run(/*encrypt=*/false, ciphertext, associated_data);
+}
+
+StatusOr<std::string> HedgedAead::Run(
+    bool encrypt, absl::string_view input,
+    absl::string_view associated_data) const {
+  const std::shared_ptr<State> state = state_;
+  const auto call = std::make_shared<Call>();
+  const auto send = [&](int replica, bool hedge) {
+    {
+      absl::MutexLock lock(&call->mutex);
+      ++call->pending;
+    }
+    const absl::Time sent = absl::Now();
+    AsyncAead::Callback done = [state, call, hedge,
+                                sent](StatusOr<std::string> result) {
+      if (result.ok()) state->RecordLatency(absl::Now() - sent);
+      absl::MutexLock lock(&call->mutex);
+      --call->pending;
+      if (call->done) return;
+      if (result.ok()) {
+        call->done = true;
+        call->hedge_won = hedge;
+        call->output = std::move(result.ValueOrDie());
+      } else if (call->status.ok()) {
+        call->status = result.status();
+      }
+    };
+    if (encrypt) {
+      state->async_replicas[replica]->EncryptAsync(input, associated_data,
+                                                   std::move(done));
+    } else {
+      state->async_replicas[replica]->DecryptAsync(input, associated_data,
+                                                   std::move(done));
+    }
+  };
+
+  const int num_replicas = state->async_replicas.size();
+  const absl::Time start = absl::Now();
+  const absl::Time deadline = start + options_.deadline;
+  absl::Time hedge_time = options_.hedge_percentile > 0
+                              ? start + state->HedgeDelay(options_)
+                              : absl::InfiniteFuture();
+  Stats stats;
+  stats.calls = 1;
+  int next_replica = 0;
+  send(next_replica++, /*hedge=*/false);
+
+  call->mutex.Lock();
+  while (!call->done) {
+    if (call->pending == 0) {
+      // All requests so far failed.
+      if (next_replica == num_replicas) break;
+      call->mutex.Unlock();
+      ++stats.fallbacks;
+      send(next_replica++, /*hedge=*/false);
+      call->mutex.Lock();
+      continue;
+    }
+    const absl::Time now = absl::Now();
+    if (now >= deadline) break;
+    if (now >= hedge_time) {
+      hedge_time = absl::InfiniteFuture();
+      call->mutex.Unlock();
+      ++stats.hedges_fired;
+      send(next_replica < num_replicas ? next_replica++ : 0, /*hedge=*/true);
+      call->mutex.Lock();
+      continue;
+    }
+    call->mutex.AwaitWithDeadline(
+        absl::Condition(call.get(), &Call::DoneOrIdle),
+        std::min(deadline, hedge_time));
+  }
+  Status status = call->status;
+  std::string output;
+  if (call->done) {
+    status = util::OkStatus();
+    output = std::move(call->output);
+    if (call->hedge_won) stats.hedges_won = 1;
+  } else if (call->pending > 0) {
+    stats.deadlines_exceeded = 1;
+    status = Status(util::error::DEADLINE_EXCEEDED,
+                    "Remote AEAD call exceeded its deadline.");
+  }
+  call->mutex.Unlock();
+
+  absl::MutexLock lock(&state->mutex);
+  state->stats.calls += stats.calls;
+  state->stats.hedges_fired += stats.hedges_fired;
+  state->stats.hedges_won += stats.hedges_won;
+  state->stats.fallbacks += stats.fallbacks;
+  state->stats.deadlines_exceeded += stats.deadlines_exceeded;
+  if (!status.ok()) return status;
+  return output;
+}
+
+HedgedAead::Stats HedgedAead::GetStats() const {
+  absl::MutexLock lock(&state_->mutex);
+  return state_->stats;
+}
+
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,111 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_AEAD_HEDGED_AEAD_H_
+#define TINK_AEAD_HEDGED_AEAD_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "tink/aead.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+// An Aead for remote AEADs such as AwsKmsAead and GcpKmsAead, which bounds
+// the tail latency of the remote calls:
+//  - Hedging: if a call has not completed after a high percentile of the
+//    recently observed latencies, a second request is sent, and whichever
+//    succeeds first is returned.
+//  - Deadlines: calls fail with DEADLINE_EXCEEDED once the deadline passes.
+//  - Fallback: if a request fails, the call is retried on the next replica.
+//
+// The replicas are AEADs for the same key material, most preferred first,
+// e.g. AwsKmsAeads for the regional replicas of an AWS multi-region key, or
+// GcpKmsAeads using stubs for different regional endpoints of one key. Any
+// replica must decrypt the ciphertexts of all others. Hedged requests go to
+// the next replica that has not been tried yet, or to the first replica if
+// all have been tried.
+//
+// The replicas must implement AsyncAead, which lets the calling thread wait
+// for the first result. Requests that lose the race or outlive the deadline
+// are not cancelled; their results are discarded when they complete.
+class HedgedAead : public Aead {
+ public:
+  struct Options {
+    // Hedges a call once it took longer than this percentile (in (0, 1))
+    // of the latencies of recent requests, but never before
+    // 'min_hedge_delay'. 0 disables hedging. Hedging at the 0.95 percentile
+    // sends roughly 5% more requests.
+    double hedge_percentile = 0;
+    absl::Duration min_hedge_delay = absl::Milliseconds(5);
+    // The hedge delay used until enough latencies have been observed.
+    absl::Duration initial_hedge_delay = absl::Milliseconds(100);
+    // Time after which a call fails, including all hedges and fallbacks.
+    absl::Duration deadline = absl::InfiniteDuration();
+  };
+
+  // Counts the requests sent to the replicas. A hedge is won if the hedged
+  // request returned the result of the call.
+  struct Stats {
+    int64_t calls = 0;
+    int64_t hedges_fired = 0;
+    int64_t hedges_won = 0;
+    int64_t fallbacks = 0;
+    int64_t deadlines_exceeded = 0;
+  };
+
+  static crypto::tink::util::StatusOr<std::unique_ptr<HedgedAead>> New(
+      std::vector<std::unique_ptr<Aead>> replicas, const Options& options);
+
+  crypto::tink::util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view associated_data) const override;
+
+  crypto::tink::util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view associated_data) const override;
+
+  Stats GetStats() const;
+
+  ~HedgedAead() override {}
+
+ private:
+  // Shared with the pending requests, which may outlive the HedgedAead.
+  struct State;
+  struct Call;
+
+  HedgedAead(std::shared_ptr<State> state, const Options& options)
+      : state_(std::move(state)), options_(options) {}
+
+  crypto::tink::util::StatusOr<std::string> Run(
+      bool encrypt, absl::string_view input,
+      absl::string_view associated_data) const;
+
+  const std::shared_ptr<State> state_;
+  const Options options_;
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_AEAD_HEDGED_AEAD_H_
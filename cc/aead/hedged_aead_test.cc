@@ -0,0 +1,226 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/aead/hedged_aead.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/time/time.h"
+#include "tink/aead.h"
+#include "tink/async_aead.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using crypto::tink::test::DummyAead;
+using crypto::tink::test::IsOk;
+using crypto::tink::test::StatusIs;
+
+// A replica of a remote AEAD which answers immediately, fails, or holds the
+// requests until the test runs them.
+class FakeReplica : public Aead, public AsyncAead {
+ public:
+  enum class Mode { kAnswer, kFail, kHold };
+
+  explicit FakeReplica(Mode mode) : aead_("kms-key"), mode_(mode) {}
+
+  util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view associated_data) const override {
+    return aead_.Encrypt(plaintext, associated_data);
+  }
+
+  util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view associated_data) const override {
+    return aead_.Decrypt(ciphertext, associated_data);
+  }
+
+  void EncryptAsync(absl::string_view plaintext,
+                    absl::string_view associated_data,
+                    Callback done) const override {
+    Answer(Encrypt(plaintext, associated_data), std::move(done));
+  }
+
+  void DecryptAsync(absl::string_view ciphertext,
+                    absl::string_view associated_data,
+                    Callback done) const override {
+    Answer(Decrypt(ciphertext, associated_data), std::move(done));
+  }
+
+  // Shared with the test, which no longer owns the FakeReplica.
+  std::shared_ptr<std::vector<std::function<void()>>> held() { return held_; }
+
+ private:
+  void Answer(util::StatusOr<std::string> result, Callback done) const {
+    switch (mode_) {
+      case Mode::kAnswer:
+        done(std::move(result));
+        break;
+      case Mode::kFail:
+        done(util::Status(util::error::UNAVAILABLE, "replica is down"));
+        break;
+      case Mode::kHold:
+        held_->push_back([result, done]() { done(result); });
+        break;
+    }
+  }
+
+  DummyAead aead_;
+  Mode mode_;
+  std::shared_ptr<std::vector<std::function<void()>>> held_ =
+      std::make_shared<std::vector<std::function<void()>>>();
+};
+
+std::unique_ptr<Aead> Replica(FakeReplica::Mode mode) {
+  return absl::make_unique<FakeReplica>(mode);
+}
+
+void RunHeld(std::vector<std::function<void()>>* held) {
+  std::vector<std::function<void()>> calls;
+  calls.swap(*held);
+  for (auto& call : calls) call();
+}
+
+std::unique_ptr<HedgedAead> NewHedgedAead(
+    std::vector<std::unique_ptr<Aead>> replicas,
+    const HedgedAead::Options& options) {
+  auto result = HedgedAead::New(std::move(replicas), options);
+  EXPECT_THAT(result.status(), IsOk());
+  return std::move(result.ValueOrDie());
+}
+
+TEST(HedgedAeadTest, InvalidArguments) {
+  EXPECT_THAT(HedgedAead::New({}, HedgedAead::Options()).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+
+  std::vector<std::unique_ptr<Aead>> sync_replicas;
+  sync_replicas.push_back(absl::make_unique<DummyAead>("kms-key"));
+  EXPECT_THAT(
+      HedgedAead::New(std::move(sync_replicas), HedgedAead::Options())
+          .status(),
+      StatusIs(util::error::INVALID_ARGUMENT));
+
+  HedgedAead::Options options;
+  options.hedge_percentile = 1;
+  std::vector<std::unique_ptr<Aead>> replicas;
+  replicas.push_back(Replica(FakeReplica::Mode::kAnswer));
+  EXPECT_THAT(HedgedAead::New(std::move(replicas), options).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(HedgedAeadTest, EncryptDecrypt) {
+  std::vector<std::unique_ptr<Aead>> replicas;
+  replicas.push_back(Replica(FakeReplica::Mode::kAnswer));
+  HedgedAead::Options options;
+  options.hedge_percentile = 0.95;
+  auto aead = NewHedgedAead(std::move(replicas), options);
+
+  auto ciphertext = aead->Encrypt("message", "aad");
+  ASSERT_THAT(ciphertext.status(), IsOk());
+  auto plaintext = aead->Decrypt(ciphertext.ValueOrDie(), "aad");
+  ASSERT_THAT(plaintext.status(), IsOk());
+  EXPECT_EQ(plaintext.ValueOrDie(), "message");
+  EXPECT_THAT(aead->Decrypt(ciphertext.ValueOrDie(), "other aad").status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+
+  HedgedAead::Stats stats = aead->GetStats();
+  EXPECT_EQ(stats.calls, 3);
+  EXPECT_EQ(stats.hedges_fired, 0);
+  EXPECT_EQ(stats.fallbacks, 0);
+}
+
+TEST(HedgedAeadTest, FallsBackToNextReplica) {
+  std::vector<std::unique_ptr<Aead>> replicas;
+  replicas.push_back(Replica(FakeReplica::Mode::kFail));
+  replicas.push_back(Replica(FakeReplica::Mode::kFail));
+  replicas.push_back(Replica(FakeReplica::Mode::kAnswer));
+  auto aead = NewHedgedAead(std::move(replicas), HedgedAead::Options());
+
+  auto ciphertext = aead->Encrypt("message", "aad");
+  ASSERT_THAT(ciphertext.status(), IsOk());
+  EXPECT_EQ(aead->GetStats().fallbacks, 2);
+
+  DummyAead expected("kms-key");
+  EXPECT_EQ(ciphertext.ValueOrDie(),
+            expected.Encrypt("message", "aad").ValueOrDie());
+}
+
+TEST(HedgedAeadTest, ReturnsFirstErrorIfAllReplicasFail) {
+  std::vector<std::unique_ptr<Aead>> replicas;
+  replicas.push_back(Replica(FakeReplica::Mode::kFail));
+  replicas.push_back(Replica(FakeReplica::Mode::kFail));
+  auto aead = NewHedgedAead(std::move(replicas), HedgedAead::Options());
+
+  EXPECT_THAT(aead->Encrypt("message", "aad").status(),
+              StatusIs(util::error::UNAVAILABLE));
+  EXPECT_EQ(aead->GetStats().fallbacks, 1);
+}
+
+TEST(HedgedAeadTest, HedgesSlowRequests) {
+  auto slow = absl::make_unique<FakeReplica>(FakeReplica::Mode::kHold);
+  auto held = slow->held();
+  std::vector<std::unique_ptr<Aead>> replicas;
+  replicas.push_back(std::move(slow));
+  replicas.push_back(Replica(FakeReplica::Mode::kAnswer));
+  HedgedAead::Options options;
+  options.hedge_percentile = 0.95;
+  options.initial_hedge_delay = absl::Milliseconds(1);
+  options.min_hedge_delay = absl::Milliseconds(1);
+  auto aead = NewHedgedAead(std::move(replicas), options);
+
+  auto ciphertext = aead->Encrypt("message", "aad");
+  ASSERT_THAT(ciphertext.status(), IsOk());
+  HedgedAead::Stats stats = aead->GetStats();
+  EXPECT_EQ(stats.hedges_fired, 1);
+  EXPECT_EQ(stats.hedges_won, 1);
+
+  // The late answer of the slow replica is discarded, even once the
+  // HedgedAead is gone.
+  EXPECT_EQ(held->size(), 1);
+  aead.reset();
+  RunHeld(held.get());
+}
+
+TEST(HedgedAeadTest, DeadlineExceeded) {
+  auto slow = absl::make_unique<FakeReplica>(FakeReplica::Mode::kHold);
+  auto held = slow->held();
+  std::vector<std::unique_ptr<Aead>> replicas;
+  replicas.push_back(std::move(slow));
+  HedgedAead::Options options;
+  options.deadline = absl::Milliseconds(10);
+  auto aead = NewHedgedAead(std::move(replicas), options);
+
+  EXPECT_THAT(aead->Encrypt("message", "aad").status(),
+              StatusIs(util::error::DEADLINE_EXCEEDED));
+  EXPECT_EQ(aead->GetStats().deadlines_exceeded, 1);
+  RunHeld(held.get());
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,122 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/aead/internal/cord_aead_from_aead.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "absl/types/span.h"
+#include "tink/aead.h"
+#include "tink/aead/cord_aead.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+namespace {
+
+// Returns a view of the contents of 'cord'. Flat Cords are not copied;
+// otherwise the contents are copied into 'storage'.
+absl::string_view GetFlatView(const absl::Cord& cord, std::string* storage) {
+  absl::optional<absl::string_view> flat = cord.TryFlat();
+  if (flat.has_value()) return flat.value();
+  *storage = std::string(cord);
+  return *storage;
+}
+
+// Returns a Cord holding the first 'used_size' bytes of 'buffer', which must
+// have been allocated with std::allocator<char> for 'size' bytes. The Cord
+// takes ownership of 'buffer'.
+absl::Cord MakeCordFromBuffer(char* buffer, size_t size, size_t used_size) {
+  return absl::MakeCordFromExternal(
+      absl::string_view(buffer, used_size), [buffer, size]() {
+        std::allocator<char>().deallocate(buffer, size);
+      });
+}
+
+}  // namespace
+
+util::StatusOr<std::unique_ptr<CordAead>> CordAeadFromAead::New(
+    std::unique_ptr<Aead> aead) {
+  if (aead == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT, "aead must be non-null");
+  }
+  auto overhead_result = aead->CiphertextSize(0);
+  if (!overhead_result.ok()) return overhead_result.status();
+  return {absl::WrapUnique(
+      new CordAeadFromAead(std::move(aead), overhead_result.ValueOrDie()))};
+}
+
+util::StatusOr<absl::Cord> CordAeadFromAead::Encrypt(
+    absl::Cord plaintext, absl::Cord additional_data) const {
+  std::string plaintext_storage, additional_data_storage;
+  absl::string_view plaintext_view = GetFlatView(plaintext, &plaintext_storage);
+  absl::string_view additional_data_view =
+      GetFlatView(additional_data, &additional_data_storage);
+
+  size_t ciphertext_size = plaintext_view.size() + overhead_;
+  char* buffer = std::allocator<char>().allocate(ciphertext_size);
+  auto written_result =
+      aead_->EncryptInto(plaintext_view, additional_data_view,
+                         absl::MakeSpan(buffer, ciphertext_size));
+  if (!written_result.ok()) {
+    std::allocator<char>().deallocate(buffer, ciphertext_size);
+    return written_result.status();
+  }
+  return MakeCordFromBuffer(buffer, ciphertext_size,
+                            written_result.ValueOrDie());
+}
+
+util::StatusOr<absl::Cord> CordAeadFromAead::Decrypt(
+    absl::Cord ciphertext, absl::Cord additional_data) const {
+  if (static_cast<int64_t>(ciphertext.size()) < overhead_) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Ciphertext too short");
+  }
+  std::string ciphertext_storage, additional_data_storage;
+  absl::string_view ciphertext_view =
+      GetFlatView(ciphertext, &ciphertext_storage);
+  absl::string_view additional_data_view =
+      GetFlatView(additional_data, &additional_data_storage);
+
+  size_t plaintext_size = ciphertext_view.size() - overhead_;
+  if (plaintext_size == 0) {
+    auto written_result = aead_->DecryptInto(
+        ciphertext_view, additional_data_view, absl::Span<char>());
+    if (!written_result.ok()) return written_result.status();
+    return absl::Cord();
+  }
+  char* buffer = std::allocator<char>().allocate(plaintext_size);
+  auto written_result =
+      aead_->DecryptInto(ciphertext_view, additional_data_view,
+                         absl::MakeSpan(buffer, plaintext_size));
+  if (!written_result.ok()) {
+    std::allocator<char>().deallocate(buffer, plaintext_size);
+    return written_result.status();
+  }
+  return MakeCordFromBuffer(buffer, plaintext_size,
+                            written_result.ValueOrDie());
+}
+
+}  // namespace tink
+}  // namespace crypto
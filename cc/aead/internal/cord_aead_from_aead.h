@@ -0,0 +1,65 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_AEAD_INTERNAL_CORD_AEAD_FROM_AEAD_H_
+#define TINK_AEAD_INTERNAL_CORD_AEAD_FROM_AEAD_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/strings/cord.h"
+#include "tink/aead.h"
+#include "tink/aead/cord_aead.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+// A CordAead on top of an Aead whose ciphertexts have a fixed overhead, such
+// as AES-GCM-SIV or XChaCha20-Poly1305. The underlying one-shot BoringSSL
+// AEADs need contiguous input, so non-flat input Cords are copied once;
+// the output is written directly into a single buffer owned by the returned
+// Cord and is never copied.
+//
+// Must only be used with Aeads whose CiphertextSize() is implemented and
+// whose ciphertext overhead does not depend on the plaintext size.
+class CordAeadFromAead : public CordAead {
+ public:
+  static crypto::tink::util::StatusOr<std::unique_ptr<CordAead>> New(
+      std::unique_ptr<Aead> aead);
+
+  crypto::tink::util::StatusOr<absl::Cord> Encrypt(
+      absl::Cord plaintext, absl::Cord additional_data) const override;
+
+  crypto::tink::util::StatusOr<absl::Cord> Decrypt(
+      absl::Cord ciphertext, absl::Cord additional_data) const override;
+
+  ~CordAeadFromAead() override {}
+
+ private:
+  CordAeadFromAead(std::unique_ptr<Aead> aead, int64_t overhead)
+      : aead_(std::move(aead)), overhead_(overhead) {}
+
+  const std::unique_ptr<Aead> aead_;
+  // Number of bytes by which a ciphertext is longer than its plaintext.
+  const int64_t overhead_;
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_AEAD_INTERNAL_CORD_AEAD_FROM_AEAD_H_
@@ -0,0 +1,166 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/aead/internal/cord_aead_from_aead.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/cord_test_helpers.h"
+#include "absl/strings/str_split.h"
+#include "tink/aead.h"
+#include "tink/aead/cord_aead.h"
+#include "tink/subtle/aes_gcm_siv_boringssl.h"
+#include "tink/subtle/xchacha20_poly1305_boringssl.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::testing::Eq;
+
+enum class AeadType { kAesGcmSiv, kXChaCha20Poly1305 };
+
+util::StatusOr<std::unique_ptr<Aead>> NewAead(AeadType type) {
+  util::SecretData key = util::SecretDataFromStringView(test::HexDecodeOrDie(
+      "000102030405060708090a0b0c0d0e0f000102030405060708090a0b0c0d0e0f"));
+  switch (type) {
+    case AeadType::kAesGcmSiv:
+      return subtle::AesGcmSivBoringSsl::New(key);
+    case AeadType::kXChaCha20Poly1305:
+      return subtle::XChacha20Poly1305BoringSsl::New(key);
+  }
+  return util::Status(util::error::INVALID_ARGUMENT, "unknown aead type");
+}
+
+class CordAeadFromAeadTest : public ::testing::TestWithParam<AeadType> {
+ protected:
+  void SetUp() override {
+    auto aead_result = NewAead(GetParam());
+    ASSERT_THAT(aead_result.status(), IsOk());
+    aead_ = std::move(aead_result.ValueOrDie());
+    auto other_aead_result = NewAead(GetParam());
+    ASSERT_THAT(other_aead_result.status(), IsOk());
+    auto cord_aead_result =
+        CordAeadFromAead::New(std::move(other_aead_result.ValueOrDie()));
+    ASSERT_THAT(cord_aead_result.status(), IsOk());
+    cord_aead_ = std::move(cord_aead_result.ValueOrDie());
+  }
+
+  std::unique_ptr<Aead> aead_;
+  std::unique_ptr<CordAead> cord_aead_;
+};
+
+TEST_P(CordAeadFromAeadTest, EncryptDecrypt) {
+  for (const std::string& message :
+       {std::string(""), std::string("Some data to encrypt."),
+        std::string(10000, 'x')}) {
+    SCOPED_TRACE(message.size());
+    absl::Cord aad("Some data to authenticate.");
+    auto ct = cord_aead_->Encrypt(absl::Cord(message), aad);
+    ASSERT_THAT(ct.status(), IsOk());
+    EXPECT_THAT(ct.ValueOrDie().size(),
+                Eq(aead_->CiphertextSize(message.size()).ValueOrDie()));
+
+    auto pt = cord_aead_->Decrypt(ct.ValueOrDie(), aad);
+    ASSERT_THAT(pt.status(), IsOk());
+    EXPECT_THAT(std::string(pt.ValueOrDie()), Eq(message));
+  }
+}
+
+TEST_P(CordAeadFromAeadTest, FragmentedCords) {
+  std::string message = "This is some long message which will be fragmented.";
+  std::string aad = "Some data to authenticate.";
+  absl::Cord fragmented_aad =
+      absl::MakeFragmentedCord(absl::StrSplit(aad, absl::ByLength(5)));
+
+  auto ct = cord_aead_->Encrypt(
+      absl::MakeFragmentedCord(absl::StrSplit(message, absl::ByLength(3))),
+      fragmented_aad);
+  ASSERT_THAT(ct.status(), IsOk());
+
+  std::string flat_ct = std::string(ct.ValueOrDie());
+  auto pt = cord_aead_->Decrypt(
+      absl::MakeFragmentedCord(absl::StrSplit(flat_ct, absl::ByLength(3))),
+      fragmented_aad);
+  ASSERT_THAT(pt.status(), IsOk());
+  EXPECT_THAT(std::string(pt.ValueOrDie()), Eq(message));
+}
+
+TEST_P(CordAeadFromAeadTest, SameResultAsString) {
+  std::string message = "Some data to encrypt.";
+  std::string aad = "Some data to authenticate.";
+
+  auto ct = cord_aead_->Encrypt(absl::Cord(message), absl::Cord(aad));
+  ASSERT_THAT(ct.status(), IsOk());
+  auto pt = aead_->Decrypt(std::string(ct.ValueOrDie()), aad);
+  ASSERT_THAT(pt.status(), IsOk());
+  EXPECT_THAT(pt.ValueOrDie(), Eq(message));
+
+  auto string_ct = aead_->Encrypt(message, aad);
+  ASSERT_THAT(string_ct.status(), IsOk());
+  auto cord_pt =
+      cord_aead_->Decrypt(absl::Cord(string_ct.ValueOrDie()), absl::Cord(aad));
+  ASSERT_THAT(cord_pt.status(), IsOk());
+  EXPECT_THAT(std::string(cord_pt.ValueOrDie()), Eq(message));
+}
+
+TEST_P(CordAeadFromAeadTest, ModifiedCord) {
+  absl::Cord aad("Some data to authenticate.");
+  auto ct_result =
+      cord_aead_->Encrypt(absl::Cord("Some data to encrypt."), aad);
+  ASSERT_THAT(ct_result.status(), IsOk());
+  std::string ct = std::string(ct_result.ValueOrDie());
+  EXPECT_THAT(cord_aead_->Decrypt(absl::Cord(ct), aad).status(), IsOk());
+  // Modify the ciphertext.
+  for (size_t i = 0; i < ct.size() * 8; i++) {
+    std::string modified_ct = ct;
+    modified_ct[i / 8] ^= 1 << (i % 8);
+    EXPECT_FALSE(cord_aead_->Decrypt(absl::Cord(modified_ct), aad).ok()) << i;
+  }
+  // Truncate the ciphertext.
+  for (size_t i = 0; i < ct.size(); i++) {
+    EXPECT_FALSE(cord_aead_->Decrypt(absl::Cord(ct.substr(0, i)), aad).ok())
+        << i;
+  }
+  // Modify the associated data.
+  EXPECT_FALSE(
+      cord_aead_->Decrypt(absl::Cord(ct), absl::Cord("Other data")).ok());
+}
+
+INSTANTIATE_TEST_SUITE_P(CordAeadFromAeadTests, CordAeadFromAeadTest,
+                         ::testing::Values(AeadType::kAesGcmSiv,
+                                           AeadType::kXChaCha20Poly1305));
+
+TEST(CordAeadFromAeadNullTest, NullAead) {
+  EXPECT_THAT(CordAeadFromAead::New(nullptr).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
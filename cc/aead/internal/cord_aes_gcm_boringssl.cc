@@ -20,9 +20,12 @@
 #include <iterator>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/cord.h"
+#include "absl/types/span.h"
 #include "openssl/aead.h"
 #include "openssl/base.h"
 #include "openssl/cipher.h"
@@ -31,6 +34,7 @@
 #include "tink/subtle/random.h"
 #include "tink/subtle/subtle_util.h"
 #include "tink/subtle/subtle_util_boringssl.h"
+#include "tink/subtle/thread_local_context.h"
 #include "tink/util/errors.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/status.h"
@@ -39,45 +43,55 @@
 namespace crypto {
 namespace tink {
 
-util::Status CordAesGcmBoringSsl::Init(util::SecretData key_value) {
-  cipher_ =
-      subtle::SubtleUtilBoringSSL::GetAesGcmCipherForKeySize(key_value.size());
-
-  if (cipher_ == nullptr) {
-    return util::Status(util::error::INTERNAL, "invalid key size");
-  }
-
-  key_ = key_value;
-  return util::OkStatus();
-}
+CordAesGcmBoringSsl::CordAesGcmBoringSsl(
+    bssl::UniquePtr<EVP_CIPHER_CTX> keyed_ctx)
+    : keyed_ctx_(std::move(keyed_ctx)),
+      ctx_([this]()
+               -> util::StatusOr<std::unique_ptr<bssl::ScopedEVP_CIPHER_CTX>> {
+        auto ctx = absl::make_unique<bssl::ScopedEVP_CIPHER_CTX>();
+        if (!EVP_CIPHER_CTX_copy(ctx->get(), keyed_ctx_.get())) {
+          return util::Status(util::error::INTERNAL,
+                              "Could not copy EVP_CIPHER_CTX");
+        }
+        return std::move(ctx);
+      }) {}
 
 util::StatusOr<std::unique_ptr<CordAead>> CordAesGcmBoringSsl::New(
     util::SecretData key_value) {
-  std::unique_ptr<CordAesGcmBoringSsl> aead(new CordAesGcmBoringSsl);
-  auto status = aead->Init(key_value);
-  if (!status.ok()) {
-    return status;
+  const EVP_CIPHER* cipher =
+      subtle::SubtleUtilBoringSSL::GetAesGcmCipherForKeySize(key_value.size());
+  if (cipher == nullptr) {
+    return util::Status(util::error::INTERNAL, "invalid key size");
   }
-  return util::StatusOr<std::unique_ptr<CordAead>>(std::move(aead));
-}
-
-util::StatusOr<absl::Cord> CordAesGcmBoringSsl::Encrypt(
-    absl::Cord plaintext, absl::Cord additional_data) const {
-  std::string iv = subtle::Random::GetRandomBytes(kIvSizeInBytes);
-
-  bssl::UniquePtr<EVP_CIPHER_CTX> ctx(EVP_CIPHER_CTX_new());
 
-  if (!EVP_EncryptInit_ex(ctx.get(), cipher_, nullptr, nullptr, nullptr)) {
+  bssl::UniquePtr<EVP_CIPHER_CTX> keyed_ctx(EVP_CIPHER_CTX_new());
+  if (keyed_ctx.get() == nullptr ||
+      !EVP_EncryptInit_ex(keyed_ctx.get(), cipher, nullptr, nullptr,
+                          nullptr)) {
     return util::Status(util::error::INTERNAL, "Encryption init failed");
   }
-
-  if (!EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_IVLEN, kIvSizeInBytes,
-                           nullptr)) {
+  if (!EVP_CIPHER_CTX_ctrl(keyed_ctx.get(), EVP_CTRL_GCM_SET_IVLEN,
+                           kIvSizeInBytes, nullptr)) {
     return util::Status(util::error::INTERNAL, "Setting IV size failed");
   }
+  if (!EVP_EncryptInit_ex(keyed_ctx.get(), nullptr, nullptr,
+                          reinterpret_cast<const uint8_t*>(key_value.data()),
+                          nullptr)) {
+    return util::Status(util::error::INTERNAL, "Encryption init failed");
+  }
+  return {absl::WrapUnique(new CordAesGcmBoringSsl(std::move(keyed_ctx)))};
+}
 
-  if (!EVP_EncryptInit_ex(ctx.get(), nullptr, nullptr,
-                          reinterpret_cast<const uint8_t*>(key_.data()),
+util::StatusOr<absl::Cord> CordAesGcmBoringSsl::Encrypt(
+    absl::Cord plaintext, absl::Cord additional_data) const {
+  std::string iv(kIvSizeInBytes, '\0');
+  subtle::Random::GetRandomNonceBytes(absl::MakeSpan(&iv[0], iv.size()));
+
+  // The context of the thread keeps the key schedule, only the IV is set.
+  auto ctx_result = ctx_.Get();
+  if (!ctx_result.ok()) return ctx_result.status();
+  EVP_CIPHER_CTX* ctx = ctx_result.ValueOrDie()->get();
+  if (!EVP_EncryptInit_ex(ctx, nullptr, nullptr, nullptr,
                           reinterpret_cast<const uint8_t*>(iv.data()))) {
     return util::Status(util::error::INTERNAL, "Encryption init failed");
   }
@@ -85,7 +99,7 @@ util::StatusOr<absl::Cord> CordAesGcmBoringSsl::Encrypt(
   int len = 0;
   // Process AD
   for (auto ad_chunk : additional_data.Chunks()) {
-    if (!EVP_EncryptUpdate(ctx.get(), nullptr, &len,
+    if (!EVP_EncryptUpdate(ctx, nullptr, &len,
                            reinterpret_cast<const uint8_t*>(ad_chunk.data()),
                            ad_chunk.size())) {
       return util::Status(util::error::INTERNAL, "Encryption failed");
@@ -102,7 +116,7 @@ util::StatusOr<absl::Cord> CordAesGcmBoringSsl::Encrypt(
 
   for (auto plaintext_chunk : plaintext.Chunks()) {
     if (!EVP_EncryptUpdate(
-            ctx.get(),
+            ctx,
             reinterpret_cast<uint8_t*>(&(buffer[ciphertext_buffer_offset])),
             &len, reinterpret_cast<const uint8_t*>(plaintext_chunk.data()),
             plaintext_chunk.size())) {
@@ -110,13 +124,13 @@ util::StatusOr<absl::Cord> CordAesGcmBoringSsl::Encrypt(
     }
     ciphertext_buffer_offset += plaintext_chunk.size();
   }
-  if (!EVP_EncryptFinal_ex(ctx.get(), nullptr, &len)) {
+  if (!EVP_EncryptFinal_ex(ctx, nullptr, &len)) {
     return util::Status(util::error::INTERNAL, "Encryption failed");
   }
 
   std::string tag;
   subtle::ResizeStringUninitialized(&tag, kTagSizeInBytes);
-  if (!EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_GET_TAG, kTagSizeInBytes,
+  if (!EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, kTagSizeInBytes,
                            reinterpret_cast<uint8_t*>(&tag[0]))) {
     return util::Status(util::error::INTERNAL, "Encryption failed");
   }
@@ -140,18 +154,11 @@ util::StatusOr<absl::Cord> CordAesGcmBoringSsl::Decrypt(
   absl::Cord raw_ciphertext = ciphertext.Subcord(
       kIvSizeInBytes, ciphertext.size() - kIvSizeInBytes - kTagSizeInBytes);
 
-  bssl::UniquePtr<EVP_CIPHER_CTX> ctx(EVP_CIPHER_CTX_new());
-  if (!EVP_DecryptInit_ex(ctx.get(), cipher_, nullptr, nullptr, nullptr)) {
-    return util::Status(util::error::INTERNAL, "Decryption init failed");
-  }
-
-  if (!EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_IVLEN, kIvSizeInBytes,
-                           nullptr)) {
-    return util::Status(util::error::INTERNAL, "Setting IV size failed");
-  }
-
-  if (!EVP_DecryptInit_ex(ctx.get(), nullptr, nullptr,
-                          reinterpret_cast<const uint8_t*>(key_.data()),
+  // As in Encrypt(), only the IV is set on the context of the thread.
+  auto ctx_result = ctx_.Get();
+  if (!ctx_result.ok()) return ctx_result.status();
+  EVP_CIPHER_CTX* ctx = ctx_result.ValueOrDie()->get();
+  if (!EVP_DecryptInit_ex(ctx, nullptr, nullptr, nullptr,
                           reinterpret_cast<const uint8_t*>(iv.data()))) {
     return util::Status(util::error::INTERNAL, "Decryption init failed");
   }
@@ -159,7 +166,7 @@ util::StatusOr<absl::Cord> CordAesGcmBoringSsl::Decrypt(
   int len = 0;
   // Process AD
   for (auto ad_chunk : additional_data.Chunks()) {
-    if (!EVP_DecryptUpdate(ctx.get(), nullptr, &len,
+    if (!EVP_DecryptUpdate(ctx, nullptr, &len,
                            reinterpret_cast<const uint8_t*>(ad_chunk.data()),
                            ad_chunk.size())) {
       return util::Status(util::error::INTERNAL, "Decryption failed");
@@ -178,7 +185,7 @@ util::StatusOr<absl::Cord> CordAesGcmBoringSsl::Decrypt(
       });
 
   for (auto ct_chunk : raw_ciphertext.Chunks()) {
-    if (!EVP_DecryptUpdate(ctx.get(),
+    if (!EVP_DecryptUpdate(ctx,
                            reinterpret_cast<uint8_t*>(
                                &plaintext_buffer[plaintext_buffer_offset]),
                            &len,
@@ -193,14 +200,16 @@ util::StatusOr<absl::Cord> CordAesGcmBoringSsl::Decrypt(
   std::string tag = std::string(
       ciphertext.Subcord(ciphertext.size() - kTagSizeInBytes, kTagSizeInBytes));
 
-  if (!EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_TAG, kTagSizeInBytes,
+  if (!EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, kTagSizeInBytes,
                            &tag[0])) {
     return util::Status(util::error::INTERNAL,
                         "Could not set authentication tag");
   }
   // Verify authentication tag
-  if (!EVP_DecryptFinal_ex(ctx.get(), nullptr, &len)) {
-    return util::Status(util::error::INTERNAL, "Authentication failed");
+  if (!EVP_DecryptFinal_ex(ctx, nullptr, &len)) {
+    static const util::Status* kAuthenticationFailed =
+        util::Status::NewStatic(util::error::INTERNAL, "Authentication failed");
+    return *kAuthenticationFailed;
   }
   return result;
 }
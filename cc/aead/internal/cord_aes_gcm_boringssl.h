@@ -18,12 +18,14 @@
 #define TINK_AEAD_INTERNAL_CORD_AES_GCM_BORINGSSL_H_
 
 #include <memory>
+#include <utility>
 
 #include "absl/strings/string_view.h"
 #include "openssl/aead.h"
 #include "openssl/base.h"
 #include "openssl/cipher.h"
 #include "tink/aead/cord_aead.h"
+#include "tink/subtle/thread_local_context.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
@@ -48,11 +50,13 @@ class CordAesGcmBoringSsl : public CordAead {
   static constexpr int kIvSizeInBytes = 12;
   static constexpr int kTagSizeInBytes = 16;
 
-  CordAesGcmBoringSsl() {}
-  crypto::tink::util::Status Init(crypto::tink::util::SecretData key_value);
+  explicit CordAesGcmBoringSsl(bssl::UniquePtr<EVP_CIPHER_CTX> keyed_ctx);
 
-  const EVP_CIPHER *cipher_;
-  crypto::tink::util::SecretData key_;
+  // Keyed once in New(), with the IV size set. Encrypt() and Decrypt() work on
+  // a per-thread copy of it, so neither the key schedule nor the context is
+  // set up again for every message.
+  const bssl::UniquePtr<EVP_CIPHER_CTX> keyed_ctx_;
+  const subtle::ThreadLocalContext<bssl::ScopedEVP_CIPHER_CTX> ctx_;
 };
 
 }  // namespace tink
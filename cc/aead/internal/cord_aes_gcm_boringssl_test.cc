@@ -17,6 +17,7 @@
 #include "tink/aead/internal/cord_aes_gcm_boringssl.h"
 
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -108,6 +109,30 @@ TEST(CordAesGcmBoringSslTest, ChunkyCordDecrypt) {
   EXPECT_THAT(pt.ValueOrDie(), Eq(message));
 }
 
+TEST(CordAesGcmBoringSslTest, ConcurrentUse) {
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  auto res = CordAesGcmBoringSsl::New(key);
+  ASSERT_THAT(res.status(), IsOk());
+  const CordAead& cipher = *res.ValueOrDie();
+  const absl::Cord aad_cord = absl::Cord("Some data to authenticate.");
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&cipher, &aad_cord, i]() {
+      for (int j = 0; j < 1000; j++) {
+        std::string message = absl::StrCat("Message ", i, " ", j);
+        auto ct = cipher.Encrypt(absl::Cord(message), aad_cord);
+        ASSERT_THAT(ct.status(), IsOk());
+        auto pt = cipher.Decrypt(ct.ValueOrDie(), aad_cord);
+        ASSERT_THAT(pt.status(), IsOk());
+        EXPECT_THAT(pt.ValueOrDie(), Eq(message));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+}
+
 TEST(CordAesGcmBoringSslTest, SameResultAsString) {
   util::SecretData key = util::SecretDataFromStringView(
       test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
@@ -16,14 +16,24 @@
 
 #include "tink/aead/kms_envelope_aead.h"
 
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/base/internal/endian.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "tink/aead.h"
 #include "tink/registry.h"
+#include "tink/tracing.h"
 #include "tink/util/errors.h"
+#include "tink/util/secret_data.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "proto/tink.pb.h"
@@ -50,63 +60,298 @@ std::string GetEnvelopeCiphertext(absl::string_view encrypted_dek,
                       encrypted_dek, encrypted_plaintext);
 }
 
+// The state of an EncryptAsync() call while the DEK is being encrypted.
+struct PendingEncryption {
+  std::unique_ptr<google::crypto::tink::KeyData> dek;
+  std::string plaintext;
+  std::string associated_data;
+  AsyncAead::Callback done;
+  // The span of the remote encryption of the DEK.
+  std::unique_ptr<TraceSpan> span;
+};
+
+// The state of a DecryptAsync() call while the DEK is being decrypted.
+struct PendingDecryption {
+  std::string payload;
+  std::string associated_data;
+  AsyncAead::Callback done;
+};
+
 }  // namespace
 
 // static
 util::StatusOr<std::unique_ptr<Aead>> KmsEnvelopeAead::New(
     const google::crypto::tink::KeyTemplate& dek_template,
     std::unique_ptr<Aead> remote_aead) {
+  auto envelope_aead_result = NewWithDekCache(
+      dek_template, std::move(remote_aead), DekCacheOptions());
+  if (!envelope_aead_result.ok()) return envelope_aead_result.status();
+  std::unique_ptr<Aead> envelope_aead =
+      std::move(envelope_aead_result.ValueOrDie());
+  return std::move(envelope_aead);
+}
+
+// static
+util::StatusOr<std::unique_ptr<KmsEnvelopeAead>>
+KmsEnvelopeAead::NewWithDekCache(
+    const google::crypto::tink::KeyTemplate& dek_template,
+    std::unique_ptr<Aead> remote_aead, const DekCacheOptions& options) {
   if (remote_aead == nullptr) {
     return util::Status(util::error::INVALID_ARGUMENT,
                         "remote_aead must be non-null");
   }
+  if (options.max_messages_per_dek < 0 ||
+      options.max_cached_decryption_deks < 0) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "DEK cache sizes must not be negative");
+  }
+  bool caching = options.max_messages_per_dek > 1 ||
+                 options.max_cached_decryption_deks > 0;
+  if (caching && options.dek_lifetime <= absl::ZeroDuration()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "dek_lifetime must be positive");
+  }
+  if (options.max_dek_encryptions_per_second < 0 ||
+      (options.max_dek_encryptions_per_second > 0 &&
+       options.dek_encryption_burst < 1)) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "invalid DEK encryption rate limit");
+  }
   auto km_result = Registry::get_key_manager<Aead>(dek_template.type_url());
   if (!km_result.ok()) return km_result.status();
-  std::unique_ptr<Aead> envelope_aead(
-      new KmsEnvelopeAead(dek_template, std::move(remote_aead)));
-  return std::move(envelope_aead);
+  return absl::WrapUnique(
+      new KmsEnvelopeAead(dek_template, std::move(remote_aead), options));
 }
 
-util::StatusOr<std::string> KmsEnvelopeAead::Encrypt(
-    absl::string_view plaintext, absl::string_view associated_data) const {
-  // Generate DEK.
-  auto dek_result = Registry::NewKeyData(dek_template_);
-  if (!dek_result.ok()) return dek_result.status();
-  auto dek = std::move(dek_result.ValueOrDie());
-
-  // Wrap DEK key values with remote.
-  auto dek_encrypt_result =
-      remote_aead_->Encrypt(dek->value(), kEmptyAssociatedData);
-  if (!dek_encrypt_result.ok()) return dek_encrypt_result.status();
+util::StatusOr<std::unique_ptr<google::crypto::tink::KeyData>>
+KmsEnvelopeAead::GenerateDek() const {
+  return Registry::NewKeyData(dek_template_);
+}
 
-  // Encrypt plaintext using DEK.
+util::StatusOr<std::shared_ptr<const KmsEnvelopeAead::EncryptionDek>>
+KmsEnvelopeAead::MakeEncryptionDek(google::crypto::tink::KeyData* dek,
+                                   std::string encrypted_dek) const {
+  // Create AEAD from DEK.
   auto aead_result = Registry::GetPrimitive<Aead>(*dek);
+  util::SafeZeroString(dek->mutable_value());
   if (!aead_result.ok()) return aead_result.status();
-  auto aead = std::move(aead_result.ValueOrDie());
-  auto encrypt_result = aead->Encrypt(plaintext, associated_data);
+  auto encryption_dek = std::make_shared<EncryptionDek>();
+  encryption_dek->aead = std::move(aead_result.ValueOrDie());
+  encryption_dek->encrypted_dek = std::move(encrypted_dek);
+  encryption_dek->expiry = absl::Now() + options_.dek_lifetime;
+  return std::shared_ptr<const EncryptionDek>(std::move(encryption_dek));
+}
+
+bool KmsEnvelopeAead::TakeDekToken(absl::Time now,
+                                   absl::Duration* wait) const {
+  const double rate = options_.max_dek_encryptions_per_second;
+  if (rate <= 0) return true;
+  if (dek_tokens_time_ != absl::InfinitePast() && now > dek_tokens_time_) {
+    dek_tokens_ = std::min<double>(
+        options_.dek_encryption_burst,
+        dek_tokens_ + absl::ToDoubleSeconds(now - dek_tokens_time_) * rate);
+  }
+  dek_tokens_time_ = now;
+  if (dek_tokens_ >= 1) {
+    dek_tokens_ -= 1;
+    return true;
+  }
+  *wait = absl::Seconds((1 - dek_tokens_) / rate);
+  return false;
+}
+
+util::StatusOr<std::shared_ptr<const KmsEnvelopeAead::EncryptionDek>>
+KmsEnvelopeAead::GetEncryptionDek(
+    std::shared_ptr<DekEncryption>* in_flight) const {
+  absl::MutexLock lock(&mutex_);
+  while (true) {
+    const absl::Time now = absl::Now();
+    // Only set if DEKs are cached.
+    const bool unexpired =
+        encryption_dek_ != nullptr && now < encryption_dek_->expiry;
+    if (unexpired &&
+        encryption_dek_messages_ < options_.max_messages_per_dek) {
+      ++encryption_hits_;
+      ++encryption_dek_messages_;
+      return encryption_dek_;
+    }
+    if (dek_encryption_ != nullptr) {
+      // Wait for the concurrent encryption of the next DEK.
+      ++coalesced_encryptions_;
+      if (in_flight != nullptr) {
+        *in_flight = dek_encryption_;
+        return std::shared_ptr<const EncryptionDek>();
+      }
+      std::shared_ptr<DekEncryption> encryption = dek_encryption_;
+      mutex_.Await(absl::Condition(&encryption->done));
+      if (!encryption->status.ok()) return encryption->status;
+      continue;
+    }
+    absl::Duration wait;
+    if (TakeDekToken(now, &wait)) break;
+    if (unexpired) {
+      // Over the rate limit, keep using the cached DEK.
+      ++encryption_hits_;
+      ++rate_limited_encryptions_;
+      ++encryption_dek_messages_;
+      return encryption_dek_;
+    }
+    ++rate_limit_waits_;
+    mutex_.Unlock();
+    absl::SleepFor(wait);
+    mutex_.Lock();
+  }
+  ++encryption_misses_;
+  if (options_.max_messages_per_dek > 1) {
+    dek_encryption_ = std::make_shared<DekEncryption>();
+  }
+  return std::shared_ptr<const EncryptionDek>();
+}
+
+void KmsEnvelopeAead::FinishDekEncryption(
+    const util::StatusOr<std::shared_ptr<const EncryptionDek>>& dek_result)
+    const {
+  if (options_.max_messages_per_dek <= 1) return;
+  std::shared_ptr<DekEncryption> encryption;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (dek_result.ok()) {
+      encryption_dek_ = dek_result.ValueOrDie();
+      encryption_dek_messages_ = 1;
+    }
+    encryption.swap(dek_encryption_);
+    encryption->status = dek_result.status();
+    encryption->done = true;
+  }
+  // No retries are added once 'done' is set.
+  for (const auto& retry : encryption->retries) retry(encryption->status);
+}
+
+util::StatusOr<std::string> KmsEnvelopeAead::EncryptWithDek(
+    const EncryptionDek& dek, absl::string_view plaintext,
+    absl::string_view associated_data) {
+  // Encrypt plaintext using DEK.
+  auto encrypt_result = dek.aead->Encrypt(plaintext, associated_data);
   if (!encrypt_result.ok()) return encrypt_result.status();
 
   // Build and return ciphertext.
-  return GetEnvelopeCiphertext(dek_encrypt_result.ValueOrDie(),
-                               encrypt_result.ValueOrDie());
+  return GetEnvelopeCiphertext(dek.encrypted_dek, encrypt_result.ValueOrDie());
 }
 
-util::StatusOr<std::string> KmsEnvelopeAead::Decrypt(
-    absl::string_view ciphertext, absl::string_view associated_data) const {
-  // Parse the ciphertext.
-  if (ciphertext.size() < kEncryptedDekPrefixSize) {
-    return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too short");
+util::StatusOr<std::shared_ptr<const KmsEnvelopeAead::EncryptionDek>>
+KmsEnvelopeAead::NewEncryptionDek() const {
+  // Generate DEK.
+  auto dek_result = GenerateDek();
+  if (!dek_result.ok()) return dek_result.status();
+  auto key_data = std::move(dek_result.ValueOrDie());
+
+  // Wrap DEK key values with remote.
+  std::unique_ptr<TraceSpan> span =
+      internal::StartSpan("tink.kms_envelope_aead.encrypt_dek");
+  auto dek_encrypt_result =
+      remote_aead_->Encrypt(key_data->value(), kEmptyAssociatedData);
+  internal::EndSpan(span.get(), dek_encrypt_result.status());
+  if (!dek_encrypt_result.ok()) {
+    util::SafeZeroString(key_data->mutable_value());
+    return dek_encrypt_result.status();
   }
-  auto enc_dek_size = absl::big_endian::Load32(
-      reinterpret_cast<const uint8_t*>(ciphertext.data()));
-  if (enc_dek_size > ciphertext.size() - kEncryptedDekPrefixSize ||
-      enc_dek_size < 0) {
-    return util::Status(util::error::INVALID_ARGUMENT, "invalid ciphertext");
+  return MakeEncryptionDek(key_data.get(),
+                           std::move(dek_encrypt_result.ValueOrDie()));
+}
+
+util::StatusOr<std::string> KmsEnvelopeAead::Encrypt(
+    absl::string_view plaintext, absl::string_view associated_data) const {
+  auto dek_result = GetEncryptionDek(/*in_flight=*/nullptr);
+  if (!dek_result.ok()) return dek_result.status();
+  std::shared_ptr<const EncryptionDek> dek =
+      std::move(dek_result.ValueOrDie());
+  if (dek == nullptr) {
+    auto new_dek_result = NewEncryptionDek();
+    FinishDekEncryption(new_dek_result);
+    if (!new_dek_result.ok()) return new_dek_result.status();
+    dek = std::move(new_dek_result.ValueOrDie());
   }
-  // Decrypt the DEK with remote.
-  auto dek_decrypt_result = remote_aead_->Decrypt(
-      ciphertext.substr(kEncryptedDekPrefixSize, enc_dek_size),
-      kEmptyAssociatedData);
+  return EncryptWithDek(*dek, plaintext, associated_data);
+}
+
+void KmsEnvelopeAead::EncryptAsync(absl::string_view plaintext,
+                                   absl::string_view associated_data,
+                                   Callback done) const {
+  if (remote_async_aead_ == nullptr) {
+    done(Encrypt(plaintext, associated_data));
+    return;
+  }
+  std::shared_ptr<DekEncryption> in_flight;
+  auto encryption_dek_result = GetEncryptionDek(&in_flight);
+  if (!encryption_dek_result.ok()) {
+    done(encryption_dek_result.status());
+    return;
+  }
+  if (encryption_dek_result.ValueOrDie() != nullptr) {
+    done(EncryptWithDek(*encryption_dek_result.ValueOrDie(), plaintext,
+                        associated_data));
+    return;
+  }
+  if (in_flight != nullptr) {
+    // Start over once the concurrent encryption of the next DEK finished.
+    std::string plaintext_copy(plaintext);
+    std::string associated_data_copy(associated_data);
+    auto retry = [this, plaintext_copy, associated_data_copy,
+                  done](const util::Status& status) {
+      if (!status.ok()) {
+        done(status);
+        return;
+      }
+      EncryptAsync(plaintext_copy, associated_data_copy, done);
+    };
+    {
+      absl::MutexLock lock(&mutex_);
+      if (!in_flight->done) {
+        in_flight->retries.push_back(std::move(retry));
+        return;
+      }
+    }
+    retry(in_flight->status);
+    return;
+  }
+
+  auto dek_result = GenerateDek();
+  if (!dek_result.ok()) {
+    FinishDekEncryption(dek_result.status());
+    done(dek_result.status());
+    return;
+  }
+  auto pending = std::make_shared<PendingEncryption>();
+  pending->dek = std::move(dek_result.ValueOrDie());
+  pending->plaintext = std::string(plaintext);
+  pending->associated_data = std::string(associated_data);
+  pending->done = std::move(done);
+  pending->span = internal::StartSpan("tink.kms_envelope_aead.encrypt_dek");
+  remote_async_aead_->EncryptAsync(
+      pending->dek->value(), kEmptyAssociatedData,
+      [this, pending](util::StatusOr<std::string> dek_encrypt_result) {
+        internal::EndSpan(pending->span.get(), dek_encrypt_result.status());
+        if (!dek_encrypt_result.ok()) {
+          util::SafeZeroString(pending->dek->mutable_value());
+          FinishDekEncryption(dek_encrypt_result.status());
+          pending->done(dek_encrypt_result.status());
+          return;
+        }
+        auto encryption_dek_result = MakeEncryptionDek(
+            pending->dek.get(), std::move(dek_encrypt_result.ValueOrDie()));
+        FinishDekEncryption(encryption_dek_result);
+        if (!encryption_dek_result.ok()) {
+          pending->done(encryption_dek_result.status());
+          return;
+        }
+        pending->done(EncryptWithDek(*encryption_dek_result.ValueOrDie(),
+                                     pending->plaintext,
+                                     pending->associated_data));
+      });
+}
+
+util::StatusOr<std::shared_ptr<Aead>> KmsEnvelopeAead::MakeDecryptionDek(
+    util::StatusOr<std::string> dek_decrypt_result) const {
   if (!dek_decrypt_result.ok()) {
     return util::Status(
         util::error::INVALID_ARGUMENT,
@@ -117,16 +362,208 @@ util::StatusOr<std::string> KmsEnvelopeAead::Decrypt(
   // Create AEAD from DEK.
   google::crypto::tink::KeyData dek;
   dek.set_type_url(dek_template_.type_url());
-  dek.set_value(dek_decrypt_result.ValueOrDie());
+  dek.set_value(std::move(dek_decrypt_result.ValueOrDie()));
   dek.set_key_material_type(google::crypto::tink::KeyData::SYMMETRIC);
-
-  // Encrypt plaintext using DEK.
   auto aead_result = Registry::GetPrimitive<Aead>(dek);
+  util::SafeZeroString(dek.mutable_value());
   if (!aead_result.ok()) return aead_result.status();
-  auto aead = std::move(aead_result.ValueOrDie());
-  return aead->Decrypt(
-      ciphertext.substr(kEncryptedDekPrefixSize + enc_dek_size),
-      associated_data);
+  return std::shared_ptr<Aead>(std::move(aead_result.ValueOrDie()));
+}
+
+std::shared_ptr<Aead> KmsEnvelopeAead::GetCachedDecryptionDek(
+    absl::string_view encrypted_dek) const {
+  if (options_.max_cached_decryption_deks == 0) {
+    ++decryption_misses_;
+    return nullptr;
+  }
+  auto it = decryption_dek_index_.find(encrypted_dek);
+  if (it == decryption_dek_index_.end()) {
+    ++decryption_misses_;
+    return nullptr;
+  }
+  auto entry = it->second;
+  if (absl::Now() >= entry->expiry) {
+    decryption_dek_index_.erase(it);
+    decryption_deks_.erase(entry);
+    ++decryption_misses_;
+    return nullptr;
+  }
+  ++decryption_hits_;
+  decryption_deks_.splice(decryption_deks_.begin(), decryption_deks_, entry);
+  return entry->aead;
+}
+
+void KmsEnvelopeAead::CacheDecryptionDek(absl::string_view encrypted_dek,
+                                         std::shared_ptr<Aead> aead) const {
+  if (options_.max_cached_decryption_deks == 0) return;
+  if (decryption_dek_index_.contains(encrypted_dek)) return;
+  decryption_deks_.push_front(
+      {std::string(encrypted_dek), std::move(aead),
+       absl::Now() + options_.dek_lifetime});
+  decryption_dek_index_.emplace(decryption_deks_.front().encrypted_dek,
+                                decryption_deks_.begin());
+  if (decryption_deks_.size() >
+      static_cast<size_t>(options_.max_cached_decryption_deks)) {
+    decryption_dek_index_.erase(decryption_deks_.back().encrypted_dek);
+    decryption_deks_.pop_back();
+  }
+}
+
+util::StatusOr<std::shared_ptr<Aead>> KmsEnvelopeAead::GetDecryptionDek(
+    absl::string_view encrypted_dek) const {
+  {
+    absl::MutexLock lock(&mutex_);
+    std::shared_ptr<Aead> aead = GetCachedDecryptionDek(encrypted_dek);
+    if (aead != nullptr) return aead;
+    auto it = dek_decryptions_.find(encrypted_dek);
+    if (it != dek_decryptions_.end()) {
+      // Wait for the concurrent decryption of the same DEK.
+      ++coalesced_decryptions_;
+      std::shared_ptr<DekDecryption> decryption = it->second;
+      mutex_.Await(absl::Condition(&decryption->done));
+      return decryption->result;
+    }
+    dek_decryptions_.emplace(std::string(encrypted_dek),
+                             std::make_shared<DekDecryption>());
+  }
+
+  // Decrypt the DEK with remote.
+  std::unique_ptr<TraceSpan> span =
+      internal::StartSpan("tink.kms_envelope_aead.decrypt_dek");
+  auto dek_decrypt_result =
+      remote_aead_->Decrypt(encrypted_dek, kEmptyAssociatedData);
+  internal::EndSpan(span.get(), dek_decrypt_result.status());
+  auto aead_result = MakeDecryptionDek(std::move(dek_decrypt_result));
+  FinishDekDecryption(encrypted_dek, aead_result);
+  return aead_result;
+}
+
+void KmsEnvelopeAead::FinishDekDecryption(
+    absl::string_view encrypted_dek,
+    const util::StatusOr<std::shared_ptr<Aead>>& aead_result) const {
+  std::vector<DekCallback> callbacks;
+  {
+    absl::MutexLock lock(&mutex_);
+    if (aead_result.ok()) {
+      CacheDecryptionDek(encrypted_dek, aead_result.ValueOrDie());
+    }
+    auto it = dek_decryptions_.find(encrypted_dek);
+    DekDecryption& decryption = *it->second;
+    decryption.result = aead_result;
+    decryption.done = true;
+    callbacks.swap(decryption.callbacks);
+    dek_decryptions_.erase(it);
+  }
+  for (const auto& callback : callbacks) callback(aead_result);
+}
+
+// static
+util::Status KmsEnvelopeAead::ParseCiphertext(
+    absl::string_view ciphertext, absl::string_view* encrypted_dek,
+    absl::string_view* payload) {
+  if (ciphertext.size() < kEncryptedDekPrefixSize) {
+    return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too short");
+  }
+  auto enc_dek_size = absl::big_endian::Load32(
+      reinterpret_cast<const uint8_t*>(ciphertext.data()));
+  if (enc_dek_size > ciphertext.size() - kEncryptedDekPrefixSize ||
+      enc_dek_size < 0) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid ciphertext");
+  }
+  *encrypted_dek = ciphertext.substr(kEncryptedDekPrefixSize, enc_dek_size);
+  *payload = ciphertext.substr(kEncryptedDekPrefixSize + enc_dek_size);
+  return util::Status::OK;
+}
+
+util::StatusOr<std::string> KmsEnvelopeAead::Decrypt(
+    absl::string_view ciphertext, absl::string_view associated_data) const {
+  absl::string_view encrypted_dek;
+  absl::string_view payload;
+  auto status = ParseCiphertext(ciphertext, &encrypted_dek, &payload);
+  if (!status.ok()) return status;
+
+  auto aead_result = GetDecryptionDek(encrypted_dek);
+  if (!aead_result.ok()) return aead_result.status();
+
+  // Decrypt ciphertext using DEK.
+  return aead_result.ValueOrDie()->Decrypt(payload, associated_data);
+}
+
+void KmsEnvelopeAead::DecryptAsync(absl::string_view ciphertext,
+                                   absl::string_view associated_data,
+                                   Callback done) const {
+  if (remote_async_aead_ == nullptr) {
+    done(Decrypt(ciphertext, associated_data));
+    return;
+  }
+  absl::string_view encrypted_dek;
+  absl::string_view payload;
+  auto status = ParseCiphertext(ciphertext, &encrypted_dek, &payload);
+  if (!status.ok()) {
+    done(status);
+    return;
+  }
+
+  std::shared_ptr<Aead> aead;
+  {
+    absl::MutexLock lock(&mutex_);
+    aead = GetCachedDecryptionDek(encrypted_dek);
+    if (aead == nullptr) {
+      auto pending = std::make_shared<PendingDecryption>();
+      pending->payload = std::string(payload);
+      pending->associated_data = std::string(associated_data);
+      pending->done = std::move(done);
+      DekCallback callback =
+          [pending](const util::StatusOr<std::shared_ptr<Aead>>& aead_result) {
+            if (!aead_result.ok()) {
+              pending->done(aead_result.status());
+              return;
+            }
+            pending->done(aead_result.ValueOrDie()->Decrypt(
+                pending->payload, pending->associated_data));
+          };
+      auto it = dek_decryptions_.find(encrypted_dek);
+      if (it != dek_decryptions_.end()) {
+        // Wait for the concurrent decryption of the same DEK.
+        ++coalesced_decryptions_;
+        it->second->callbacks.push_back(std::move(callback));
+        return;
+      }
+      auto decryption = std::make_shared<DekDecryption>();
+      decryption->callbacks.push_back(std::move(callback));
+      dek_decryptions_.emplace(std::string(encrypted_dek),
+                               std::move(decryption));
+    }
+  }
+  if (aead != nullptr) {
+    done(aead->Decrypt(payload, associated_data));
+    return;
+  }
+
+  std::string encrypted_dek_copy(encrypted_dek);
+  std::shared_ptr<TraceSpan> span =
+      internal::StartSpan("tink.kms_envelope_aead.decrypt_dek");
+  remote_async_aead_->DecryptAsync(
+      encrypted_dek, kEmptyAssociatedData,
+      [this, encrypted_dek_copy, span](
+          util::StatusOr<std::string> dek_decrypt_result) {
+        internal::EndSpan(span.get(), dek_decrypt_result.status());
+        FinishDekDecryption(encrypted_dek_copy,
+                            MakeDecryptionDek(std::move(dek_decrypt_result)));
+      });
+}
+
+KmsEnvelopeAead::DekCacheStats KmsEnvelopeAead::GetDekCacheStats() const {
+  DekCacheStats stats;
+  stats.encryption_hits = encryption_hits_.load();
+  stats.encryption_misses = encryption_misses_.load();
+  stats.decryption_hits = decryption_hits_.load();
+  stats.decryption_misses = decryption_misses_.load();
+  stats.coalesced_decryptions = coalesced_decryptions_.load();
+  stats.coalesced_encryptions = coalesced_encryptions_.load();
+  stats.rate_limited_encryptions = rate_limited_encryptions_.load();
+  stats.rate_limit_waits = rate_limit_waits_.load();
+  return stats;
 }
 
 }  // namespace tink
@@ -17,10 +17,21 @@
 #ifndef TINK_AEAD_KMS_ENVELOPE_AEAD_H_
 #define TINK_AEAD_KMS_ENVELOPE_AEAD_H_
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
 #include <memory>
+#include <string>
+#include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
 #include "tink/aead.h"
+#include "tink/async_aead.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "proto/tink.pb.h"
@@ -42,12 +53,71 @@ namespace tink {
 //  - Encrypted DEK: variable length that is equal to the value
 //    specified in the last 4 bytes.
 //  - AEAD payload: variable length.
-class KmsEnvelopeAead : public Aead {
+//
+// If the remote AEAD also implements AsyncAead, EncryptAsync() and
+// DecryptAsync() do not block while the remote AEAD processes the DEK;
+// otherwise they run synchronously.
+class KmsEnvelopeAead : public Aead, public AsyncAead {
  public:
+  // Bounds for caching data encryption keys, which saves the generation of a
+  // DEK and the remote call for most messages. With the default values
+  // nothing is cached.
+  //
+  // Caching trades some security for speed: all messages encrypted with one
+  // DEK are exposed if that DEK leaks, and the usage limits of the DEK type
+  // (e.g. the number of messages per AES-GCM key) apply to all of them.
+  // Also, cached DEKs are used for decryption without asking the KMS again,
+  // so revoking access to a KMS key only takes effect after 'dek_lifetime'.
+  struct DekCacheOptions {
+    // Encrypt() uses each DEK for up to this many messages; values up to 1
+    // create a new DEK for every message.
+    int64_t max_messages_per_dek = 0;
+    // Decrypt() keeps up to this many decrypted DEKs, and evicts the least
+    // recently used one when the cache is full. 0 disables the cache.
+    int max_cached_decryption_deks = 0;
+    // Cached DEKs are used for at most this long after they were generated
+    // or decrypted.
+    absl::Duration dek_lifetime = absl::Minutes(5);
+    // Limits the remote encryptions of new DEKs to this many per second, in
+    // bursts of up to 'dek_encryption_burst', to stay within the KMS quota.
+    // 0 disables the limit. Over the limit, Encrypt() keeps using the cached
+    // DEK beyond 'max_messages_per_dek' messages until it expires, and
+    // otherwise waits until a new DEK may be encrypted; so does
+    // EncryptAsync(), on the calling thread.
+    double max_dek_encryptions_per_second = 0;
+    int dek_encryption_burst = 1;
+  };
+
+  // Counts DEK cache lookups. Misses are the DEKs that were generated or
+  // decrypted remotely; without caching, every call is a miss.
+  // Concurrent decryptions of the same DEK share one remote call, so
+  // 'coalesced_decryptions' of the decryption misses made no remote call.
+  // Likewise, with DEK caching, encryptions that miss while a new DEK is
+  // being encrypted wait for it; they are counted in
+  // 'coalesced_encryptions', and once more as hits or misses afterwards.
+  // 'rate_limited_encryptions' counts the hits beyond
+  // 'max_messages_per_dek', and 'rate_limit_waits' the waits for the limit.
+  struct DekCacheStats {
+    int64_t encryption_hits = 0;
+    int64_t encryption_misses = 0;
+    int64_t decryption_hits = 0;
+    int64_t decryption_misses = 0;
+    int64_t coalesced_decryptions = 0;
+    int64_t coalesced_encryptions = 0;
+    int64_t rate_limited_encryptions = 0;
+    int64_t rate_limit_waits = 0;
+  };
+
   static crypto::tink::util::StatusOr<std::unique_ptr<Aead>> New(
       const google::crypto::tink::KeyTemplate& dek_template,
       std::unique_ptr<Aead> remote_aead);
 
+  // Same as New(), but caches DEKs as configured by 'options'.
+  static crypto::tink::util::StatusOr<std::unique_ptr<KmsEnvelopeAead>>
+  NewWithDekCache(const google::crypto::tink::KeyTemplate& dek_template,
+                  std::unique_ptr<Aead> remote_aead,
+                  const DekCacheOptions& options);
+
   crypto::tink::util::StatusOr<std::string> Encrypt(
       absl::string_view plaintext,
       absl::string_view associated_data) const override;
@@ -56,15 +126,154 @@ class KmsEnvelopeAead : public Aead {
       absl::string_view ciphertext,
       absl::string_view associated_data) const override;
 
+  void EncryptAsync(absl::string_view plaintext,
+                    absl::string_view associated_data,
+                    Callback done) const override;
+
+  void DecryptAsync(absl::string_view ciphertext,
+                    absl::string_view associated_data,
+                    Callback done) const override;
+
+  DekCacheStats GetDekCacheStats() const;
+
   ~KmsEnvelopeAead() override {}
 
  private:
+  // A DEK used for encryption, together with its encrypted form.
+  struct EncryptionDek {
+    std::unique_ptr<Aead> aead;
+    std::string encrypted_dek;
+    absl::Time expiry;
+  };
+
+  // A decrypted DEK, in the list of cached DEKs.
+  struct DecryptionDek {
+    std::string encrypted_dek;
+    std::shared_ptr<Aead> aead;
+    absl::Time expiry;
+  };
+
+  using DekCallback = std::function<void(
+      const crypto::tink::util::StatusOr<std::shared_ptr<Aead>>&)>;
+
+  // The remote encryption of a new DEK for the cache, which concurrent
+  // encryptions wait for instead of encrypting a DEK of their own.
+  struct DekEncryption {
+    bool done = false;
+    crypto::tink::util::Status status;
+    // Called with 'status' by FinishDekEncryption(), to retry the waiting
+    // EncryptAsync() calls.
+    std::vector<std::function<void(const crypto::tink::util::Status&)>>
+        retries;
+  };
+
+  // A remote decryption of a DEK, which concurrent decryptions of the same
+  // DEK wait for instead of making their own remote call.
+  struct DekDecryption {
+    bool done = false;
+    crypto::tink::util::StatusOr<std::shared_ptr<Aead>> result;
+    // Called with the result by FinishDekDecryption().
+    std::vector<DekCallback> callbacks;
+  };
+
   KmsEnvelopeAead(const google::crypto::tink::KeyTemplate& dek_template,
-                  std::unique_ptr<Aead> remote_aead) :
-      dek_template_(dek_template), remote_aead_(std::move(remote_aead)) {}
+                  std::unique_ptr<Aead> remote_aead,
+                  const DekCacheOptions& options)
+      : dek_template_(dek_template),
+        remote_aead_(std::move(remote_aead)),
+        remote_async_aead_(dynamic_cast<const AsyncAead*>(remote_aead_.get())),
+        options_(options),
+        dek_tokens_(options.dek_encryption_burst) {}
+
+  crypto::tink::util::StatusOr<std::unique_ptr<google::crypto::tink::KeyData>>
+  GenerateDek() const;
+  // Creates the primitive for 'dek' and wipes its key material.
+  crypto::tink::util::StatusOr<std::shared_ptr<const EncryptionDek>>
+  MakeEncryptionDek(google::crypto::tink::KeyData* dek,
+                    std::string encrypted_dek) const;
+  // Returns the DEK to encrypt the next message with: the cached one, or
+  // the one a concurrent call is encrypting. Returns nullptr if the caller
+  // has to encrypt a new DEK with NewEncryptionDek() and pass the result to
+  // FinishDekEncryption(). If 'in_flight' is set, the concurrent encryption
+  // is returned there instead of waiting for it.
+  crypto::tink::util::StatusOr<std::shared_ptr<const EncryptionDek>>
+  GetEncryptionDek(std::shared_ptr<DekEncryption>* in_flight) const
+      ABSL_LOCKS_EXCLUDED(mutex_);
+  // Generates a DEK and encrypts it with the remote AEAD.
+  crypto::tink::util::StatusOr<std::shared_ptr<const EncryptionDek>>
+  NewEncryptionDek() const;
+  // Caches the new DEK and wakes up the calls waiting for it.
+  void FinishDekEncryption(
+      const crypto::tink::util::StatusOr<std::shared_ptr<const EncryptionDek>>&
+          dek_result) const ABSL_LOCKS_EXCLUDED(mutex_);
+  // Takes a token for the remote encryption of a DEK, or returns false and
+  // sets *wait to the time until the next token.
+  bool TakeDekToken(absl::Time now, absl::Duration* wait) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  static crypto::tink::util::StatusOr<std::string> EncryptWithDek(
+      const EncryptionDek& dek, absl::string_view plaintext,
+      absl::string_view associated_data);
+
+  // Creates the primitive for a DEK decrypted by the remote AEAD.
+  crypto::tink::util::StatusOr<std::shared_ptr<Aead>> MakeDecryptionDek(
+      crypto::tink::util::StatusOr<std::string> dek_decrypt_result) const;
+  // Returns the cached decrypted DEK for 'encrypted_dek', or nullptr.
+  std::shared_ptr<Aead> GetCachedDecryptionDek(
+      absl::string_view encrypted_dek) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void CacheDecryptionDek(absl::string_view encrypted_dek,
+                          std::shared_ptr<Aead> aead) const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Returns the decrypted DEK, from the cache, from a concurrent remote
+  // decryption of the same DEK, or from a new remote call.
+  crypto::tink::util::StatusOr<std::shared_ptr<Aead>> GetDecryptionDek(
+      absl::string_view encrypted_dek) const ABSL_LOCKS_EXCLUDED(mutex_);
+  // Caches and publishes the result of the remote decryption of
+  // 'encrypted_dek' started by the caller.
+  void FinishDekDecryption(
+      absl::string_view encrypted_dek,
+      const crypto::tink::util::StatusOr<std::shared_ptr<Aead>>& aead_result)
+      const ABSL_LOCKS_EXCLUDED(mutex_);
+  // Splits 'ciphertext' into the encrypted DEK and the AEAD payload.
+  static crypto::tink::util::Status ParseCiphertext(
+      absl::string_view ciphertext, absl::string_view* encrypted_dek,
+      absl::string_view* payload);
 
   google::crypto::tink::KeyTemplate dek_template_;
   std::unique_ptr<Aead> remote_aead_;
+  // 'remote_aead_' if it implements AsyncAead, nullptr otherwise.
+  const AsyncAead* remote_async_aead_;
+  const DekCacheOptions options_;
+
+  mutable absl::Mutex mutex_;
+  mutable std::shared_ptr<const EncryptionDek> encryption_dek_
+      ABSL_GUARDED_BY(mutex_);
+  mutable int64_t encryption_dek_messages_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The remote encryption of the next cached DEK, if one is in flight.
+  mutable std::shared_ptr<DekEncryption> dek_encryption_
+      ABSL_GUARDED_BY(mutex_);
+  // The token bucket of 'max_dek_encryptions_per_second'.
+  mutable double dek_tokens_ ABSL_GUARDED_BY(mutex_);
+  mutable absl::Time dek_tokens_time_ ABSL_GUARDED_BY(mutex_) =
+      absl::InfinitePast();
+  // Most recently used first; the index points into the list, and is keyed
+  // by views of the encrypted DEKs stored there.
+  mutable std::list<DecryptionDek> decryption_deks_ ABSL_GUARDED_BY(mutex_);
+  mutable absl::flat_hash_map<absl::string_view,
+                              std::list<DecryptionDek>::iterator>
+      decryption_dek_index_ ABSL_GUARDED_BY(mutex_);
+  // The remote decryptions in flight, by encrypted DEK.
+  mutable absl::flat_hash_map<std::string, std::shared_ptr<DekDecryption>>
+      dek_decryptions_ ABSL_GUARDED_BY(mutex_);
+
+  mutable std::atomic<int64_t> encryption_hits_{0};
+  mutable std::atomic<int64_t> encryption_misses_{0};
+  mutable std::atomic<int64_t> decryption_hits_{0};
+  mutable std::atomic<int64_t> decryption_misses_{0};
+  mutable std::atomic<int64_t> coalesced_decryptions_{0};
+  mutable std::atomic<int64_t> coalesced_encryptions_{0};
+  mutable std::atomic<int64_t> rate_limited_encryptions_{0};
+  mutable std::atomic<int64_t> rate_limit_waits_{0};
 };
 
 }  // namespace tink
@@ -16,15 +16,24 @@
 
 #include "tink/aead/kms_envelope_aead.h"
 
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
 #include "absl/base/internal/endian.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "tink/aead/aead_config.h"
 #include "tink/aead/aead_key_templates.h"
+#include "tink/async_aead.h"
 #include "tink/mac/mac_key_templates.h"
 #include "tink/registry.h"
 #include "tink/util/status.h"
@@ -42,6 +51,116 @@ using crypto::tink::test::IsOk;
 using crypto::tink::test::StatusIs;
 using testing::HasSubstr;
 
+// A remote AEAD that counts the calls made to it.
+class CountingAead : public Aead {
+ public:
+  CountingAead(int* encryptions, int* decryptions)
+      : aead_("kms-backed-aead"),
+        encryptions_(encryptions),
+        decryptions_(decryptions) {}
+
+  util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view associated_data) const override {
+    ++*encryptions_;
+    return aead_.Encrypt(plaintext, associated_data);
+  }
+
+  util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view associated_data) const override {
+    ++*decryptions_;
+    return aead_.Decrypt(ciphertext, associated_data);
+  }
+
+ private:
+  DummyAead aead_;
+  int* encryptions_;
+  int* decryptions_;
+};
+
+// A remote AEAD whose asynchronous operations complete when RunPending() is
+// called.
+class DeferredAead : public Aead, public AsyncAead {
+ public:
+  DeferredAead() : aead_("kms-backed-aead") {}
+
+  util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view associated_data) const override {
+    return util::Status(util::error::UNIMPLEMENTED, "use EncryptAsync()");
+  }
+
+  util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view associated_data) const override {
+    return util::Status(util::error::UNIMPLEMENTED, "use DecryptAsync()");
+  }
+
+  void EncryptAsync(absl::string_view plaintext,
+                    absl::string_view associated_data,
+                    Callback done) const override {
+    auto result = aead_.Encrypt(plaintext, associated_data);
+    pending_->push_back([result, done]() { done(result); });
+  }
+
+  void DecryptAsync(absl::string_view ciphertext,
+                    absl::string_view associated_data,
+                    Callback done) const override {
+    auto result = aead_.Decrypt(ciphertext, associated_data);
+    pending_->push_back([result, done]() { done(result); });
+  }
+
+  // Shared with the test, which no longer owns the DeferredAead.
+  std::shared_ptr<std::vector<std::function<void()>>> pending() {
+    return pending_;
+  }
+
+ private:
+  DummyAead aead_;
+  std::shared_ptr<std::vector<std::function<void()>>> pending_ =
+      std::make_shared<std::vector<std::function<void()>>>();
+};
+
+void RunPending(std::vector<std::function<void()>>* pending) {
+  std::vector<std::function<void()>> calls;
+  calls.swap(*pending);
+  for (auto& call : calls) call();
+}
+
+// A remote AEAD whose Decrypt() blocks until 'release' is notified.
+class BlockingAead : public Aead {
+ public:
+  BlockingAead(absl::Notification* release, std::atomic<int>* decryptions)
+      : aead_("kms-backed-aead"),
+        release_(release),
+        decryptions_(decryptions) {}
+
+  util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view associated_data) const override {
+    return aead_.Encrypt(plaintext, associated_data);
+  }
+
+  util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view associated_data) const override {
+    ++*decryptions_;
+    release_->WaitForNotification();
+    return aead_.Decrypt(ciphertext, associated_data);
+  }
+
+ private:
+  DummyAead aead_;
+  absl::Notification* release_;
+  std::atomic<int>* decryptions_;
+};
+
+std::string EncryptedDek(absl::string_view ciphertext) {
+  auto enc_dek_size = absl::big_endian::Load32(
+      reinterpret_cast<const uint8_t*>(ciphertext.data()));
+  return std::string(ciphertext.substr(4, enc_dek_size));
+}
 
 TEST(KmsEnvelopeAeadTest, BasicEncryptDecrypt) {
   EXPECT_THAT(AeadConfig::Register(), IsOk());
@@ -169,6 +288,437 @@ TEST(KmsEnvelopeAeadTest, KeyFormat) {
   EXPECT_THAT(key.key_value().size(), testing::Eq(16));
 }
 
+TEST(KmsEnvelopeAeadTest, DekCacheReusesEncryptionDek) {
+  EXPECT_THAT(AeadConfig::Register(), IsOk());
+  int encryptions = 0;
+  int decryptions = 0;
+  KmsEnvelopeAead::DekCacheOptions options;
+  options.max_messages_per_dek = 3;
+  auto aead_result = KmsEnvelopeAead::NewWithDekCache(
+      AeadKeyTemplates::Aes128Gcm(),
+      absl::make_unique<CountingAead>(&encryptions, &decryptions), options);
+  ASSERT_THAT(aead_result.status(), IsOk());
+  auto aead = std::move(aead_result.ValueOrDie());
+
+  std::vector<std::string> ciphertexts;
+  for (int i = 0; i < 7; i++) {
+    auto encrypt_result = aead->Encrypt(absl::StrCat("message ", i), "aad");
+    ASSERT_THAT(encrypt_result.status(), IsOk());
+    ciphertexts.push_back(encrypt_result.ValueOrDie());
+  }
+  // Messages 0-2 and 3-5 share a DEK, message 6 starts a third one.
+  EXPECT_EQ(encryptions, 3);
+  EXPECT_EQ(EncryptedDek(ciphertexts[0]), EncryptedDek(ciphertexts[2]));
+  EXPECT_NE(EncryptedDek(ciphertexts[2]), EncryptedDek(ciphertexts[3]));
+  EXPECT_NE(ciphertexts[0], ciphertexts[1]);
+  for (int i = 0; i < 7; i++) {
+    auto decrypt_result = aead->Decrypt(ciphertexts[i], "aad");
+    ASSERT_THAT(decrypt_result.status(), IsOk());
+    EXPECT_EQ(decrypt_result.ValueOrDie(), absl::StrCat("message ", i));
+  }
+  // The decryption cache is disabled.
+  EXPECT_EQ(decryptions, 7);
+
+  auto stats = aead->GetDekCacheStats();
+  EXPECT_EQ(stats.encryption_hits, 4);
+  EXPECT_EQ(stats.encryption_misses, 3);
+  EXPECT_EQ(stats.decryption_hits, 0);
+  EXPECT_EQ(stats.decryption_misses, 7);
+}
+
+TEST(KmsEnvelopeAeadTest, DekCacheEvictsLeastRecentlyUsedDecryptionDek) {
+  EXPECT_THAT(AeadConfig::Register(), IsOk());
+  auto encrypt = [](const std::string& message) {
+    auto aead = KmsEnvelopeAead::New(AeadKeyTemplates::Aes128Gcm(),
+                                     absl::make_unique<DummyAead>(
+                                         "kms-backed-aead")).ValueOrDie();
+    return aead->Encrypt(message, "aad").ValueOrDie();
+  };
+  std::string ct1 = encrypt("message 1");
+  std::string ct2 = encrypt("message 2");
+  std::string ct3 = encrypt("message 3");
+
+  int encryptions = 0;
+  int decryptions = 0;
+  KmsEnvelopeAead::DekCacheOptions options;
+  options.max_cached_decryption_deks = 2;
+  auto aead_result = KmsEnvelopeAead::NewWithDekCache(
+      AeadKeyTemplates::Aes128Gcm(),
+      absl::make_unique<CountingAead>(&encryptions, &decryptions), options);
+  ASSERT_THAT(aead_result.status(), IsOk());
+  auto aead = std::move(aead_result.ValueOrDie());
+
+  EXPECT_EQ(aead->Decrypt(ct1, "aad").ValueOrDie(), "message 1");
+  EXPECT_EQ(aead->Decrypt(ct2, "aad").ValueOrDie(), "message 2");
+  EXPECT_EQ(aead->Decrypt(ct1, "aad").ValueOrDie(), "message 1");
+  EXPECT_EQ(decryptions, 2);
+  // Evicts the DEK of ct2, which was used least recently.
+  EXPECT_EQ(aead->Decrypt(ct3, "aad").ValueOrDie(), "message 3");
+  EXPECT_EQ(aead->Decrypt(ct1, "aad").ValueOrDie(), "message 1");
+  EXPECT_EQ(decryptions, 3);
+  EXPECT_EQ(aead->Decrypt(ct2, "aad").ValueOrDie(), "message 2");
+  EXPECT_EQ(decryptions, 4);
+
+  // The cached DEK still authenticates the payload.
+  EXPECT_THAT(aead->Decrypt(ct1, "wrong aad").status(),
+              StatusIs(util::error::INTERNAL));
+  // DEKs the remote AEAD rejects are not cached.
+  std::string corrupted = ct3;
+  corrupted[4] ^= 1;
+  EXPECT_THAT(aead->Decrypt(corrupted, "aad").status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(aead->Decrypt(corrupted, "aad").status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_EQ(decryptions, 6);
+
+  auto stats = aead->GetDekCacheStats();
+  EXPECT_EQ(stats.decryption_hits, 3);
+  EXPECT_EQ(stats.decryption_misses, 6);
+  EXPECT_EQ(encryptions, 0);
+}
+
+TEST(KmsEnvelopeAeadTest, DekCacheExpiresDeks) {
+  EXPECT_THAT(AeadConfig::Register(), IsOk());
+  int encryptions = 0;
+  int decryptions = 0;
+  KmsEnvelopeAead::DekCacheOptions options;
+  options.max_messages_per_dek = 100;
+  options.max_cached_decryption_deks = 10;
+  options.dek_lifetime = absl::Milliseconds(50);
+  auto aead_result = KmsEnvelopeAead::NewWithDekCache(
+      AeadKeyTemplates::Aes128Gcm(),
+      absl::make_unique<CountingAead>(&encryptions, &decryptions), options);
+  ASSERT_THAT(aead_result.status(), IsOk());
+  auto aead = std::move(aead_result.ValueOrDie());
+
+  std::string ct = aead->Encrypt("message", "aad").ValueOrDie();
+  EXPECT_EQ(aead->Decrypt(ct, "aad").ValueOrDie(), "message");
+  EXPECT_EQ(encryptions, 1);
+  EXPECT_EQ(decryptions, 1);
+
+  absl::SleepFor(absl::Milliseconds(100));
+  std::string ct2 = aead->Encrypt("message", "aad").ValueOrDie();
+  EXPECT_NE(EncryptedDek(ct), EncryptedDek(ct2));
+  EXPECT_EQ(aead->Decrypt(ct, "aad").ValueOrDie(), "message");
+  EXPECT_EQ(encryptions, 2);
+  EXPECT_EQ(decryptions, 2);
+}
+
+TEST(KmsEnvelopeAeadTest, DekCacheInvalidOptions) {
+  EXPECT_THAT(AeadConfig::Register(), IsOk());
+  auto new_aead = [](const KmsEnvelopeAead::DekCacheOptions& options) {
+    return KmsEnvelopeAead::NewWithDekCache(
+               AeadKeyTemplates::Aes128Gcm(),
+               absl::make_unique<DummyAead>("kms-backed-aead"), options)
+        .status();
+  };
+  KmsEnvelopeAead::DekCacheOptions options;
+  options.max_messages_per_dek = -1;
+  EXPECT_THAT(new_aead(options), StatusIs(util::error::INVALID_ARGUMENT));
+
+  options = KmsEnvelopeAead::DekCacheOptions();
+  options.max_cached_decryption_deks = -1;
+  EXPECT_THAT(new_aead(options), StatusIs(util::error::INVALID_ARGUMENT));
+
+  options = KmsEnvelopeAead::DekCacheOptions();
+  options.max_cached_decryption_deks = 1;
+  options.dek_lifetime = absl::ZeroDuration();
+  EXPECT_THAT(new_aead(options), StatusIs(util::error::INVALID_ARGUMENT));
+
+  // Without caching the lifetime does not matter.
+  options.max_cached_decryption_deks = 0;
+  EXPECT_THAT(new_aead(options), IsOk());
+
+  options = KmsEnvelopeAead::DekCacheOptions();
+  options.max_dek_encryptions_per_second = -1;
+  EXPECT_THAT(new_aead(options), StatusIs(util::error::INVALID_ARGUMENT));
+
+  options = KmsEnvelopeAead::DekCacheOptions();
+  options.max_dek_encryptions_per_second = 10;
+  options.dek_encryption_burst = 0;
+  EXPECT_THAT(new_aead(options), StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(KmsEnvelopeAeadTest, RateLimitKeepsUsingCachedDek) {
+  EXPECT_THAT(AeadConfig::Register(), IsOk());
+  int encryptions = 0;
+  int decryptions = 0;
+  KmsEnvelopeAead::DekCacheOptions options;
+  options.max_messages_per_dek = 2;
+  options.max_dek_encryptions_per_second = 0.001;
+  options.dek_encryption_burst = 2;
+  auto aead_result = KmsEnvelopeAead::NewWithDekCache(
+      AeadKeyTemplates::Aes128Gcm(),
+      absl::make_unique<CountingAead>(&encryptions, &decryptions), options);
+  ASSERT_THAT(aead_result.status(), IsOk());
+  auto aead = std::move(aead_result.ValueOrDie());
+
+  std::vector<std::string> ciphertexts;
+  for (int i = 0; i < 6; i++) {
+    auto encrypt_result = aead->Encrypt(absl::StrCat("message ", i), "aad");
+    ASSERT_THAT(encrypt_result.status(), IsOk());
+    ciphertexts.push_back(encrypt_result.ValueOrDie());
+  }
+  // The burst allows two DEKs; messages 2-5 share the second one.
+  EXPECT_EQ(encryptions, 2);
+  EXPECT_EQ(EncryptedDek(ciphertexts[2]), EncryptedDek(ciphertexts[5]));
+  for (int i = 0; i < 6; i++) {
+    auto decrypt_result = aead->Decrypt(ciphertexts[i], "aad");
+    ASSERT_THAT(decrypt_result.status(), IsOk());
+    EXPECT_EQ(decrypt_result.ValueOrDie(), absl::StrCat("message ", i));
+  }
+
+  auto stats = aead->GetDekCacheStats();
+  EXPECT_EQ(stats.encryption_hits, 4);
+  EXPECT_EQ(stats.encryption_misses, 2);
+  EXPECT_EQ(stats.rate_limited_encryptions, 2);
+  EXPECT_EQ(stats.rate_limit_waits, 0);
+}
+
+TEST(KmsEnvelopeAeadTest, RateLimitWaitsWithoutCachedDek) {
+  EXPECT_THAT(AeadConfig::Register(), IsOk());
+  int encryptions = 0;
+  int decryptions = 0;
+  KmsEnvelopeAead::DekCacheOptions options;
+  options.max_dek_encryptions_per_second = 100;
+  auto aead_result = KmsEnvelopeAead::NewWithDekCache(
+      AeadKeyTemplates::Aes128Gcm(),
+      absl::make_unique<CountingAead>(&encryptions, &decryptions), options);
+  ASSERT_THAT(aead_result.status(), IsOk());
+  auto aead = std::move(aead_result.ValueOrDie());
+
+  absl::Time start = absl::Now();
+  for (int i = 0; i < 3; i++) {
+    EXPECT_THAT(aead->Encrypt("message", "aad").status(), IsOk());
+  }
+  // The second and third DEK each wait for 10ms.
+  EXPECT_GE(absl::Now() - start, absl::Milliseconds(15));
+  EXPECT_EQ(encryptions, 3);
+  EXPECT_GE(aead->GetDekCacheStats().rate_limit_waits, 2);
+}
+
+TEST(KmsEnvelopeAeadTest, AsyncEncryptDecrypt) {
+  EXPECT_THAT(AeadConfig::Register(), IsOk());
+  auto remote_aead = absl::make_unique<DeferredAead>();
+  auto pending = remote_aead->pending();
+  auto aead_result = KmsEnvelopeAead::NewWithDekCache(
+      AeadKeyTemplates::Aes128Gcm(), std::move(remote_aead),
+      KmsEnvelopeAead::DekCacheOptions());
+  ASSERT_THAT(aead_result.status(), IsOk());
+  auto aead = std::move(aead_result.ValueOrDie());
+
+  const int kMessages = 10;
+  std::vector<util::StatusOr<std::string>> ciphertexts(
+      kMessages, util::Status(util::error::UNKNOWN, "not called"));
+  for (int i = 0; i < kMessages; i++) {
+    aead->EncryptAsync(absl::StrCat("message ", i), "aad",
+                       [&ciphertexts, i](util::StatusOr<std::string> result) {
+                         ciphertexts[i] = result;
+                       });
+  }
+  // All encryptions wait for the remote AEAD.
+  EXPECT_EQ(pending->size(), kMessages);
+  EXPECT_THAT(ciphertexts[0].status(), StatusIs(util::error::UNKNOWN));
+  RunPending(pending.get());
+
+  std::vector<util::StatusOr<std::string>> plaintexts(
+      kMessages, util::Status(util::error::UNKNOWN, "not called"));
+  for (int i = 0; i < kMessages; i++) {
+    ASSERT_THAT(ciphertexts[i].status(), IsOk());
+    aead->DecryptAsync(ciphertexts[i].ValueOrDie(), "aad",
+                       [&plaintexts, i](util::StatusOr<std::string> result) {
+                         plaintexts[i] = result;
+                       });
+  }
+  EXPECT_EQ(pending->size(), kMessages);
+  RunPending(pending.get());
+  for (int i = 0; i < kMessages; i++) {
+    ASSERT_THAT(plaintexts[i].status(), IsOk());
+    EXPECT_EQ(plaintexts[i].ValueOrDie(), absl::StrCat("message ", i));
+  }
+
+  // Errors are passed to the callback as well.
+  util::Status status;
+  std::string ct = ciphertexts[0].ValueOrDie();
+  ct[4] ^= 1;
+  aead->DecryptAsync(ct, "aad", [&status](util::StatusOr<std::string> result) {
+    status = result.status();
+  });
+  RunPending(pending.get());
+  EXPECT_THAT(status, StatusIs(util::error::INVALID_ARGUMENT));
+  aead->DecryptAsync("sh", "aad",
+                     [&status](util::StatusOr<std::string> result) {
+                       status = result.status();
+                     });
+  EXPECT_THAT(status,
+              StatusIs(util::error::INVALID_ARGUMENT, HasSubstr("too short")));
+}
+
+TEST(KmsEnvelopeAeadTest, AsyncUsesDekCache) {
+  EXPECT_THAT(AeadConfig::Register(), IsOk());
+  auto remote_aead = absl::make_unique<DeferredAead>();
+  auto pending = remote_aead->pending();
+  KmsEnvelopeAead::DekCacheOptions options;
+  options.max_messages_per_dek = 10;
+  options.max_cached_decryption_deks = 10;
+  auto aead_result = KmsEnvelopeAead::NewWithDekCache(
+      AeadKeyTemplates::Aes128Gcm(), std::move(remote_aead), options);
+  ASSERT_THAT(aead_result.status(), IsOk());
+  auto aead = std::move(aead_result.ValueOrDie());
+
+  std::string ciphertext;
+  auto set_ciphertext = [&ciphertext](util::StatusOr<std::string> result) {
+    ASSERT_THAT(result.status(), IsOk());
+    ciphertext = result.ValueOrDie();
+  };
+  aead->EncryptAsync("message", "aad", set_ciphertext);
+  EXPECT_EQ(pending->size(), 1);
+  RunPending(pending.get());
+  // Completes immediately with the cached DEK.
+  aead->EncryptAsync("message", "aad", set_ciphertext);
+  EXPECT_TRUE(pending->empty());
+
+  std::string plaintext;
+  auto set_plaintext = [&plaintext](util::StatusOr<std::string> result) {
+    ASSERT_THAT(result.status(), IsOk());
+    plaintext = result.ValueOrDie();
+  };
+  aead->DecryptAsync(ciphertext, "aad", set_plaintext);
+  EXPECT_EQ(pending->size(), 1);
+  RunPending(pending.get());
+  EXPECT_EQ(plaintext, "message");
+  plaintext.clear();
+  aead->DecryptAsync(ciphertext, "aad", set_plaintext);
+  EXPECT_TRUE(pending->empty());
+  EXPECT_EQ(plaintext, "message");
+}
+
+TEST(KmsEnvelopeAeadTest, AsyncWithSynchronousRemoteAead) {
+  EXPECT_THAT(AeadConfig::Register(), IsOk());
+  auto aead_result = KmsEnvelopeAead::NewWithDekCache(
+      AeadKeyTemplates::Aes128Gcm(),
+      absl::make_unique<DummyAead>("kms-backed-aead"),
+      KmsEnvelopeAead::DekCacheOptions());
+  ASSERT_THAT(aead_result.status(), IsOk());
+  auto aead = std::move(aead_result.ValueOrDie());
+
+  std::string ciphertext;
+  aead->EncryptAsync("message", "aad",
+                     [&ciphertext](util::StatusOr<std::string> result) {
+                       ASSERT_THAT(result.status(), IsOk());
+                       ciphertext = result.ValueOrDie();
+                     });
+  ASSERT_FALSE(ciphertext.empty());
+  EXPECT_EQ(aead->Decrypt(ciphertext, "aad").ValueOrDie(), "message");
+}
+
+TEST(KmsEnvelopeAeadTest, CoalescesConcurrentDekDecryptions) {
+  EXPECT_THAT(AeadConfig::Register(), IsOk());
+  absl::Notification release;
+  std::atomic<int> decryptions(0);
+  // Without caching, so that every call needs the remote AEAD.
+  auto aead_result = KmsEnvelopeAead::NewWithDekCache(
+      AeadKeyTemplates::Aes128Gcm(),
+      absl::make_unique<BlockingAead>(&release, &decryptions),
+      KmsEnvelopeAead::DekCacheOptions());
+  ASSERT_THAT(aead_result.status(), IsOk());
+  auto aead = std::move(aead_result.ValueOrDie());
+  std::string ciphertext = aead->Encrypt("message", "aad").ValueOrDie();
+
+  const int kThreads = 8;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; i++) {
+    threads.emplace_back([&aead, &ciphertext]() {
+      auto decrypt_result = aead->Decrypt(ciphertext, "aad");
+      ASSERT_THAT(decrypt_result.status(), IsOk());
+      EXPECT_EQ(decrypt_result.ValueOrDie(), "message");
+    });
+  }
+  // Release the remote call once all other threads wait for it.
+  while (aead->GetDekCacheStats().coalesced_decryptions < kThreads - 1) {
+    absl::SleepFor(absl::Milliseconds(1));
+  }
+  release.Notify();
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(decryptions, 1);
+
+  // Later calls make their own remote call.
+  EXPECT_EQ(aead->Decrypt(ciphertext, "aad").ValueOrDie(), "message");
+  EXPECT_EQ(decryptions, 2);
+  auto stats = aead->GetDekCacheStats();
+  EXPECT_EQ(stats.decryption_misses, kThreads + 1);
+  EXPECT_EQ(stats.coalesced_decryptions, kThreads - 1);
+}
+
+TEST(KmsEnvelopeAeadTest, AsyncCoalescesConcurrentDekDecryptions) {
+  EXPECT_THAT(AeadConfig::Register(), IsOk());
+  auto remote_aead = absl::make_unique<DeferredAead>();
+  auto pending = remote_aead->pending();
+  auto aead_result = KmsEnvelopeAead::NewWithDekCache(
+      AeadKeyTemplates::Aes128Gcm(), std::move(remote_aead),
+      KmsEnvelopeAead::DekCacheOptions());
+  ASSERT_THAT(aead_result.status(), IsOk());
+  auto aead = std::move(aead_result.ValueOrDie());
+
+  std::string ciphertext;
+  aead->EncryptAsync("message", "aad",
+                     [&ciphertext](util::StatusOr<std::string> result) {
+                       ASSERT_THAT(result.status(), IsOk());
+                       ciphertext = result.ValueOrDie();
+                     });
+  RunPending(pending.get());
+
+  std::vector<std::string> plaintexts;
+  for (int i = 0; i < 3; i++) {
+    aead->DecryptAsync(ciphertext, "aad",
+                       [&plaintexts](util::StatusOr<std::string> result) {
+                         ASSERT_THAT(result.status(), IsOk());
+                         plaintexts.push_back(result.ValueOrDie());
+                       });
+  }
+  EXPECT_EQ(pending->size(), 1);
+  RunPending(pending.get());
+  EXPECT_EQ(plaintexts,
+            std::vector<std::string>({"message", "message", "message"}));
+  EXPECT_EQ(aead->GetDekCacheStats().coalesced_decryptions, 2);
+}
+
+TEST(KmsEnvelopeAeadTest, AsyncCoalescesConcurrentDekEncryptions) {
+  EXPECT_THAT(AeadConfig::Register(), IsOk());
+  auto remote_aead = absl::make_unique<DeferredAead>();
+  auto pending = remote_aead->pending();
+  KmsEnvelopeAead::DekCacheOptions options;
+  options.max_messages_per_dek = 2;
+  auto aead_result = KmsEnvelopeAead::NewWithDekCache(
+      AeadKeyTemplates::Aes128Gcm(), std::move(remote_aead), options);
+  ASSERT_THAT(aead_result.status(), IsOk());
+  auto aead = std::move(aead_result.ValueOrDie());
+
+  std::vector<std::string> ciphertexts;
+  for (int i = 0; i < 3; i++) {
+    aead->EncryptAsync("message", "aad",
+                       [&ciphertexts](util::StatusOr<std::string> result) {
+                         ASSERT_THAT(result.status(), IsOk());
+                         ciphertexts.push_back(result.ValueOrDie());
+                       });
+  }
+  // The second and third call wait for the first DEK. Only the second one
+  // fits on it, so the third one encrypts another DEK.
+  EXPECT_EQ(pending->size(), 1);
+  RunPending(pending.get());
+  EXPECT_EQ(ciphertexts.size(), 2);
+  EXPECT_EQ(pending->size(), 1);
+  RunPending(pending.get());
+  ASSERT_EQ(ciphertexts.size(), 3);
+  EXPECT_EQ(EncryptedDek(ciphertexts[0]), EncryptedDek(ciphertexts[1]));
+  EXPECT_NE(EncryptedDek(ciphertexts[1]), EncryptedDek(ciphertexts[2]));
+
+  auto stats = aead->GetDekCacheStats();
+  EXPECT_EQ(stats.coalesced_encryptions, 2);
+  EXPECT_EQ(stats.encryption_misses, 2);
+  EXPECT_EQ(stats.encryption_hits, 1);
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
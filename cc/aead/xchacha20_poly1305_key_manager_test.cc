@@ -18,7 +18,9 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/cord.h"
 #include "tink/aead.h"
+#include "tink/aead/cord_aead.h"
 #include "tink/subtle/aead_test_util.h"
 #include "tink/util/istream_input_stream.h"
 #include "tink/util/secret_data.h"
@@ -186,6 +188,39 @@ TEST(XChaCha20Poly1305KeyManagerTest, CreateAead) {
       IsOk());
 }
 
+TEST(XChaCha20Poly1305KeyManagerTest, CreateCordAead) {
+  StatusOr<XChaCha20Poly1305Key> key_or =
+      XChaCha20Poly1305KeyManager().CreateKey(XChaCha20Poly1305KeyFormat());
+  ASSERT_THAT(key_or.status(), IsOk());
+
+  StatusOr<std::unique_ptr<CordAead>> cord_aead_or =
+      XChaCha20Poly1305KeyManager().GetPrimitive<CordAead>(key_or.ValueOrDie());
+  ASSERT_THAT(cord_aead_or.status(), IsOk());
+  StatusOr<std::unique_ptr<Aead>> aead_or =
+      XChaCha20Poly1305KeyManager().GetPrimitive<Aead>(key_or.ValueOrDie());
+  ASSERT_THAT(aead_or.status(), IsOk());
+
+  // Ciphertexts of the CordAead are ordinary ciphertexts of the key.
+  StatusOr<absl::Cord> ciphertext_or =
+      cord_aead_or.ValueOrDie()->Encrypt(absl::Cord("message"),
+                                         absl::Cord("aad"));
+  ASSERT_THAT(ciphertext_or.status(), IsOk());
+  StatusOr<std::string> plaintext_or = aead_or.ValueOrDie()->Decrypt(
+      std::string(ciphertext_or.ValueOrDie()), "aad");
+  ASSERT_THAT(plaintext_or.status(), IsOk());
+  EXPECT_THAT(plaintext_or.ValueOrDie(), Eq("message"));
+
+  StatusOr<std::string> other_ciphertext_or =
+      aead_or.ValueOrDie()->Encrypt("other message", "aad");
+  ASSERT_THAT(other_ciphertext_or.status(), IsOk());
+  StatusOr<absl::Cord> other_plaintext_or =
+      cord_aead_or.ValueOrDie()->Decrypt(
+          absl::Cord(other_ciphertext_or.ValueOrDie()), absl::Cord("aad"));
+  ASSERT_THAT(other_plaintext_or.status(), IsOk());
+  EXPECT_THAT(std::string(other_plaintext_or.ValueOrDie()),
+              Eq("other message"));
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
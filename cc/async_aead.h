@@ -0,0 +1,64 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_ASYNC_AEAD_H_
+#define TINK_ASYNC_AEAD_H_
+
+#include <functional>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+///////////////////////////////////////////////////////////////////////////////
+// A non-blocking variant of the Aead interface, for AEADs whose operations
+// wait on I/O, e.g. on a remote KMS. It lets callers such as event-loop
+// servers have many operations in flight without blocking a thread on each.
+//
+// Implementations call 'done' exactly once with the result, either before
+// the call returns or later on an arbitrary thread. The inputs are copied
+// as needed, so they need not outlive the call; the AsyncAead itself must
+// outlive all pending operations.
+//
+// Implementations are expected to be thread safe.
+class AsyncAead {
+ public:
+  using Callback =
+      std::function<void(crypto::tink::util::StatusOr<std::string>)>;
+
+  // Encrypts 'plaintext' with 'associated_data' as associated data, like
+  // Aead::Encrypt(), and passes the resulting ciphertext to 'done'.
+  virtual void EncryptAsync(absl::string_view plaintext,
+                            absl::string_view associated_data,
+                            Callback done) const = 0;
+
+  // Decrypts 'ciphertext' with 'associated_data' as associated data, like
+  // Aead::Decrypt(), and passes the resulting plaintext to 'done'.
+  virtual void DecryptAsync(absl::string_view ciphertext,
+                            absl::string_view associated_data,
+                            Callback done) const = 0;
+
+  virtual ~AsyncAead() {}
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_ASYNC_AEAD_H_
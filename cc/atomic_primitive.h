@@ -0,0 +1,159 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_ATOMIC_PRIMITIVE_H_
+#define TINK_ATOMIC_PRIMITIVE_H_
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "tink/internal/key_info.h"
+#include "tink/internal/registry_impl.h"
+#include "tink/keyset_handle.h"
+#include "tink/primitive_set.h"
+#include "tink/registry.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "tink/util/validation.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+///////////////////////////////////////////////////////////////////////////////
+// Holds the wrapped primitive of a keyset that changes over time, e.g. on key
+// rotation, such as an AtomicPrimitive<Aead>.
+//
+// Update() wraps a new version of the keyset. Keys whose id and key data did
+// not change keep their primitives, so only added or changed keys are parsed
+// and instantiated. The new wrapped primitive is then published atomically:
+// Get() returns either the old or the new one, and callers that still use the
+// old one may keep doing so. Get() only takes a shared lock to copy the
+// pointer to the current primitive, and never waits for an update to build
+// its primitives.
+//
+// Like KeysetHandle::GetPrimitive(), this uses the key managers and the
+// wrapper for P in the global registry. The wrapper must wrap P into P.
+template <class P>
+class AtomicPrimitive {
+ public:
+  // What an update changed.
+  struct UpdateStats {
+    // Enabled keys that were new or had changed.
+    int created = 0;
+    // Enabled keys that kept their primitive.
+    int reused = 0;
+  };
+
+  // Returns an AtomicPrimitive holding the primitive of 'keyset_handle'.
+  static crypto::tink::util::StatusOr<std::unique_ptr<AtomicPrimitive<P>>> New(
+      const KeysetHandle& keyset_handle) {
+    std::unique_ptr<AtomicPrimitive<P>> atomic_primitive(
+        new AtomicPrimitive<P>());
+    auto update_result = atomic_primitive->Update(keyset_handle);
+    if (!update_result.ok()) return update_result.status();
+    return std::move(atomic_primitive);
+  }
+
+  AtomicPrimitive(const AtomicPrimitive&) = delete;
+  AtomicPrimitive& operator=(const AtomicPrimitive&) = delete;
+
+  // Replaces the primitive with that of 'keyset_handle'. On errors, the
+  // current primitive is kept.
+  crypto::tink::util::StatusOr<UpdateStats> Update(
+      const KeysetHandle& keyset_handle) ABSL_LOCKS_EXCLUDED(update_mutex_) {
+    const google::crypto::tink::Keyset& keyset = keyset_handle.get_keyset();
+    crypto::tink::util::Status status = ValidateKeyset(keyset);
+    if (!status.ok()) return status;
+
+    // Updates are serialized, so that each one reuses the keys of the last.
+    absl::MutexLock lock(&update_mutex_);
+    UpdateStats stats;
+    auto primitives = absl::make_unique<PrimitiveSet<P>>();
+    KeyPrimitives key_primitives;
+    for (const google::crypto::tink::Keyset::Key& key : keyset.key()) {
+      if (key.status() != google::crypto::tink::KeyStatusType::ENABLED) {
+        continue;
+      }
+      std::shared_ptr<P> primitive;
+      auto it = key_primitives_.find(key.key_id());
+      if (it != key_primitives_.end() &&
+          it->second.key_data.type_url() == key.key_data().type_url() &&
+          it->second.key_data.value() == key.key_data().value()) {
+        primitive = it->second.primitive;
+        stats.reused++;
+      } else {
+        auto primitive_result =
+            internal::RegistryImpl::GlobalInstance().GetSharedPrimitive<P>(
+                key.key_data());
+        if (!primitive_result.ok()) return primitive_result.status();
+        primitive = std::move(primitive_result.ValueOrDie());
+        stats.created++;
+      }
+      // If enabled keys share an id, only the last one is reused by the
+      // next update.
+      KeyPrimitive& key_primitive = key_primitives[key.key_id()];
+      key_primitive.key_data = key.key_data();
+      key_primitive.primitive = primitive;
+      auto entry = primitives->AddSharedPrimitive(std::move(primitive),
+                                                  KeyInfoFromKey(key));
+      if (!entry.ok()) return entry.status();
+      if (key.key_id() == keyset.primary_key_id()) {
+        auto primary_result = primitives->set_primary(entry.ValueOrDie());
+        if (!primary_result.ok()) return primary_result;
+      }
+    }
+    auto wrap_result = Registry::Wrap<P>(std::move(primitives));
+    if (!wrap_result.ok()) return wrap_result.status();
+    std::shared_ptr<P> wrapped(std::move(wrap_result.ValueOrDie()));
+    key_primitives_ = std::move(key_primitives);
+    absl::MutexLock primitive_lock(&primitive_mutex_);
+    primitive_ = std::move(wrapped);
+    return stats;
+  }
+
+  // Returns the current wrapped primitive.
+  std::shared_ptr<P> Get() const ABSL_LOCKS_EXCLUDED(primitive_mutex_) {
+    absl::ReaderMutexLock lock(&primitive_mutex_);
+    return primitive_;
+  }
+
+ private:
+  // The primitive of an enabled key of the current keyset.
+  struct KeyPrimitive {
+    google::crypto::tink::KeyData key_data;
+    std::shared_ptr<P> primitive;
+  };
+  using KeyPrimitives = absl::flat_hash_map<uint32_t, KeyPrimitive>;
+
+  AtomicPrimitive() {}
+
+  absl::Mutex update_mutex_;
+  // By key id.
+  KeyPrimitives key_primitives_ ABSL_GUARDED_BY(update_mutex_);
+  mutable absl::Mutex primitive_mutex_;
+  std::shared_ptr<P> primitive_ ABSL_GUARDED_BY(primitive_mutex_);
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_ATOMIC_PRIMITIVE_H_
@@ -0,0 +1,184 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/strings/string_view.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+using ::google::crypto::tink::KeyTemplate;
+using ::google::crypto::tink::OutputPrefixType;
+
+constexpr char kAssociatedData[] = "benchmark associated data";
+
+void BM_AeadEncrypt(benchmark::State& state,
+                    const KeyTemplate& (*key_template)()) {
+  auto aead_result = SharedPrimitive<Aead>(key_template());
+  if (!aead_result.ok()) return SkipWithError(&state, aead_result.status());
+  const Aead& aead = *aead_result.ValueOrDie();
+  std::string plaintext = Payload(state.range(0));
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto ciphertext = aead.Encrypt(plaintext, kAssociatedData);
+      if (!ciphertext.ok()) return SkipWithError(&state, ciphertext.status());
+      benchmark::DoNotOptimize(ciphertext.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, plaintext.size());
+}
+
+void BM_AeadDecrypt(benchmark::State& state,
+                    const KeyTemplate& (*key_template)()) {
+  auto aead_result = SharedPrimitive<Aead>(key_template());
+  if (!aead_result.ok()) return SkipWithError(&state, aead_result.status());
+  const Aead& aead = *aead_result.ValueOrDie();
+  auto ciphertext_result =
+      aead.Encrypt(Payload(state.range(0)), kAssociatedData);
+  if (!ciphertext_result.ok()) {
+    return SkipWithError(&state, ciphertext_result.status());
+  }
+  const std::string& ciphertext = ciphertext_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto plaintext = aead.Decrypt(ciphertext, kAssociatedData);
+      if (!plaintext.ok()) return SkipWithError(&state, plaintext.status());
+      benchmark::DoNotOptimize(plaintext.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, state.range(0));
+}
+
+// Records per EncryptBatch() or DecryptBatch() call; enough to fill the
+// lanes of the multi-buffer AES-GCM several times.
+constexpr int kBatchSize = 64;
+
+void BM_AeadEncryptBatch(benchmark::State& state,
+                         const KeyTemplate& (*key_template)()) {
+  auto aead_result = SharedPrimitive<Aead>(key_template());
+  if (!aead_result.ok()) return SkipWithError(&state, aead_result.status());
+  const Aead& aead = *aead_result.ValueOrDie();
+  std::vector<std::string> records(kBatchSize, Payload(state.range(0)));
+  std::vector<absl::string_view> plaintexts(records.begin(), records.end());
+  std::vector<absl::string_view> associated_data(kBatchSize, kAssociatedData);
+  std::string ciphertexts;
+  std::vector<int64_t> offsets;
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      util::Status status = aead.EncryptBatch(plaintexts, associated_data,
+                                              &ciphertexts, &offsets);
+      if (!status.ok()) return SkipWithError(&state, status);
+      benchmark::DoNotOptimize(ciphertexts);
+    }
+  }
+  SetThroughput(&state, kBatchSize * state.range(0));
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+void BM_AeadDecryptBatch(benchmark::State& state,
+                         const KeyTemplate& (*key_template)()) {
+  auto aead_result = SharedPrimitive<Aead>(key_template());
+  if (!aead_result.ok()) return SkipWithError(&state, aead_result.status());
+  const Aead& aead = *aead_result.ValueOrDie();
+  std::vector<std::string> records(kBatchSize, Payload(state.range(0)));
+  std::vector<absl::string_view> plaintexts(records.begin(), records.end());
+  std::vector<absl::string_view> associated_data(kBatchSize, kAssociatedData);
+  std::string ciphertexts;
+  std::vector<int64_t> ciphertext_offsets;
+  util::Status status = aead.EncryptBatch(plaintexts, associated_data,
+                                          &ciphertexts, &ciphertext_offsets);
+  if (!status.ok()) return SkipWithError(&state, status);
+  std::vector<absl::string_view> ciphertext_views;
+  for (int i = 0; i < kBatchSize; i++) {
+    ciphertext_views.push_back(absl::string_view(ciphertexts).substr(
+        ciphertext_offsets[i],
+        ciphertext_offsets[i + 1] - ciphertext_offsets[i]));
+  }
+  std::string decrypted;
+  std::vector<int64_t> offsets;
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      status = aead.DecryptBatch(ciphertext_views, associated_data,
+                                 &decrypted, &offsets);
+      if (!status.ok()) return SkipWithError(&state, status);
+      benchmark::DoNotOptimize(decrypted);
+    }
+  }
+  SetThroughput(&state, kBatchSize * state.range(0));
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+#define TINK_AEAD_BENCHMARK(template_name)                               \
+  BENCHMARK_CAPTURE(BM_AeadEncrypt, template_name,                       \
+                    &AeadKeyTemplates::template_name)                    \
+      ->Apply(PayloadSizesAndThreads);                                   \
+  BENCHMARK_CAPTURE(BM_AeadDecrypt, template_name,                       \
+                    &AeadKeyTemplates::template_name)                    \
+      ->Apply(PayloadSizesAndThreads);                                   \
+  BENCHMARK_CAPTURE(BM_AeadEncryptBatch, template_name,                  \
+                    &AeadKeyTemplates::template_name)                    \
+      ->Apply(PayloadSizesAndThreads);                                   \
+  BENCHMARK_CAPTURE(BM_AeadDecryptBatch, template_name,                  \
+                    &AeadKeyTemplates::template_name)                    \
+      ->Apply(PayloadSizesAndThreads)
+
+TINK_AEAD_BENCHMARK(Aes128Gcm);
+TINK_AEAD_BENCHMARK(Aes256Gcm);
+TINK_AEAD_BENCHMARK(Aes128GcmSiv);
+TINK_AEAD_BENCHMARK(Aes256GcmSiv);
+TINK_AEAD_BENCHMARK(Aes128Eax);
+TINK_AEAD_BENCHMARK(Aes256Eax);
+TINK_AEAD_BENCHMARK(Aes128CtrHmacSha256);
+TINK_AEAD_BENCHMARK(Aes256CtrHmacSha256);
+TINK_AEAD_BENCHMARK(XChaCha20Poly1305);
+
+// Aes128Gcm with RAW output prefix. Decryption first misses the lookup by key
+// prefix, which should not allocate: allocs_per_op is 1, for the plaintext.
+const KeyTemplate& RawAes128Gcm() {
+  static const KeyTemplate* key_template = [] {
+    KeyTemplate* raw_template = new KeyTemplate(AeadKeyTemplates::Aes128Gcm());
+    raw_template->set_output_prefix_type(OutputPrefixType::RAW);
+    return raw_template;
+  }();
+  return *key_template;
+}
+
+BENCHMARK_CAPTURE(BM_AeadDecrypt, RawAes128Gcm, &RawAes128Gcm)
+    ->Apply(PayloadSizesAndThreads);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,115 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Compares the AES-NI and ARMv8 implementations of AES-EAX with the BoringSSL
+// based one. AesEaxAesni is only available when compiled with SSE4.1 and
+// AES-NI enabled (e.g. --copt=-msse4.1 --copt=-maes), and AesEaxArmCe when
+// compiled for aarch64 with the crypto extension (e.g.
+// --copt=-march=armv8-a+crypto); otherwise only AesEaxBoringSsl is
+// benchmarked.
+
+#include <memory>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "tink/aead.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/subtle/aes_eax_aesni.h"
+#include "tink/subtle/aes_eax_armce.h"
+#include "tink/subtle/aes_eax_boringssl.h"
+#include "tink/subtle/random.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+constexpr char kAssociatedData[] = "benchmark associated data";
+constexpr size_t kNonceSize = 16;
+
+using AeadFactory = util::StatusOr<std::unique_ptr<Aead>> (*)(
+    const util::SecretData& key, size_t nonce_size_in_bytes);
+
+void BM_AesEaxEncrypt(benchmark::State& state, AeadFactory factory,
+                      size_t key_size) {
+  auto aead_result = factory(
+      util::SecretDataFromStringView(subtle::Random::GetRandomBytes(key_size)),
+      kNonceSize);
+  if (!aead_result.ok()) return SkipWithError(&state, aead_result.status());
+  const Aead& aead = *aead_result.ValueOrDie();
+  std::string plaintext = Payload(state.range(0));
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto ciphertext = aead.Encrypt(plaintext, kAssociatedData);
+      if (!ciphertext.ok()) return SkipWithError(&state, ciphertext.status());
+      benchmark::DoNotOptimize(ciphertext.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, plaintext.size());
+}
+
+void BM_AesEaxDecrypt(benchmark::State& state, AeadFactory factory,
+                      size_t key_size) {
+  auto aead_result = factory(
+      util::SecretDataFromStringView(subtle::Random::GetRandomBytes(key_size)),
+      kNonceSize);
+  if (!aead_result.ok()) return SkipWithError(&state, aead_result.status());
+  const Aead& aead = *aead_result.ValueOrDie();
+  auto ciphertext_result =
+      aead.Encrypt(Payload(state.range(0)), kAssociatedData);
+  if (!ciphertext_result.ok()) {
+    return SkipWithError(&state, ciphertext_result.status());
+  }
+  const std::string& ciphertext = ciphertext_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto plaintext = aead.Decrypt(ciphertext, kAssociatedData);
+      if (!plaintext.ok()) return SkipWithError(&state, plaintext.status());
+      benchmark::DoNotOptimize(plaintext.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, state.range(0));
+}
+
+#define TINK_AES_EAX_BENCHMARK(name, factory, key_size)                      \
+  BENCHMARK_CAPTURE(BM_AesEaxEncrypt, name, &factory, key_size)              \
+      ->Apply(PayloadSizesAndThreads);                                       \
+  BENCHMARK_CAPTURE(BM_AesEaxDecrypt, name, &factory, key_size)              \
+      ->Apply(PayloadSizesAndThreads)
+
+TINK_AES_EAX_BENCHMARK(Aes128EaxBoringSsl, subtle::AesEaxBoringSsl::New, 16);
+TINK_AES_EAX_BENCHMARK(Aes256EaxBoringSsl, subtle::AesEaxBoringSsl::New, 32);
+#if defined(__SSE4_1__) && defined(__AES__)
+TINK_AES_EAX_BENCHMARK(Aes128EaxAesni, subtle::AesEaxAesni::New, 16);
+TINK_AES_EAX_BENCHMARK(Aes256EaxAesni, subtle::AesEaxAesni::New, 32);
+#endif
+#if defined(__aarch64__) && \
+    (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+TINK_AES_EAX_BENCHMARK(Aes128EaxArmCe, subtle::AesEaxArmCe::New, 16);
+TINK_AES_EAX_BENCHMARK(Aes256EaxArmCe, subtle::AesEaxArmCe::New, 32);
+#endif
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,165 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/benchmarks/benchmark_util.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+#include "benchmark/benchmark.h"
+#include "tink/config/tink_config.h"
+#include "tink/keyset_handle.h"
+#include "tink/subtle/random.h"
+#include "tink/util/buffer.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace {
+
+// Number of calls to operator new made by the current thread, and the bytes
+// it allocated minus those it freed. Plain thread_local integers are used so
+// that counting never allocates itself.
+thread_local int64_t allocation_count = 0;
+thread_local int64_t allocated_bytes = 0;
+
+// Every block starts with a header holding its size, so that deallocations
+// can be subtracted from allocated_bytes. The header keeps the alignment
+// malloc() guarantees.
+constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+void* Allocate(size_t size) noexcept {
+  char* block = static_cast<char*>(std::malloc(kHeaderSize + size));
+  if (block == nullptr) return nullptr;
+  ++allocation_count;
+  allocated_bytes += size;
+  *reinterpret_cast<size_t*>(block) = size;
+  return block + kHeaderSize;
+}
+
+void Deallocate(void* ptr) noexcept {
+  if (ptr == nullptr) return;
+  char* block = static_cast<char*>(ptr) - kHeaderSize;
+  allocated_bytes -= *reinterpret_cast<size_t*>(block);
+  std::free(block);
+}
+
+}  // namespace
+
+// Replacements of the global allocation functions, which count every
+// allocation made by the benchmark binary and the bytes in use.
+void* operator new(size_t size) {
+  void* ptr = Allocate(size);
+  if (ptr == nullptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  return Allocate(size);
+}
+
+void operator delete(void* ptr) noexcept { Deallocate(ptr); }
+void operator delete[](void* ptr) noexcept { Deallocate(ptr); }
+void operator delete(void* ptr, size_t) noexcept { Deallocate(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { Deallocate(ptr); }
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+
+using ::google::crypto::tink::KeyTemplate;
+
+void PayloadSizesAndThreads(benchmark::internal::Benchmark* benchmark) {
+  for (int threads = 1; threads <= 8; threads *= 2) {
+    for (int64_t size = kMinPayloadSize; size <= kMaxPayloadSize; size *= 16) {
+      benchmark->Args({size})->Threads(threads);
+    }
+  }
+  benchmark->UseRealTime();
+}
+
+util::StatusOr<const KeysetHandle*> SharedKeysetHandle(
+    const KeyTemplate& key_template) {
+  static util::Status* register_status =
+      new util::Status(TinkConfig::Register());
+  if (!register_status->ok()) return *register_status;
+
+  static absl::Mutex* mutex = new absl::Mutex();
+  static auto* handles =
+      new absl::flat_hash_map<std::string, std::unique_ptr<KeysetHandle>>();
+
+  std::string cache_key = key_template.SerializeAsString();
+  absl::MutexLock lock(mutex);
+  auto it = handles->find(cache_key);
+  if (it != handles->end()) return it->second.get();
+
+  auto handle_result = KeysetHandle::GenerateNew(key_template);
+  if (!handle_result.ok()) return handle_result.status();
+  const KeysetHandle* handle = handle_result.ValueOrDie().get();
+  (*handles)[cache_key] = std::move(handle_result.ValueOrDie());
+  return handle;
+}
+
+std::string Payload(int64_t size) {
+  return subtle::Random::GetRandomBytes(size);
+}
+
+util::Status StringRandomAccessStream::PRead(int64_t position, int count,
+                                             util::Buffer* dest_buffer) {
+  if (position < 0 || count <= 0 || dest_buffer == nullptr ||
+      count > dest_buffer->allocated_size()) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid PRead");
+  }
+  int64_t available = position < data_.size() ? data_.size() - position : 0;
+  int read = count < available ? count : available;
+  if (read > 0) data_.copy(dest_buffer->get_mem_block(), read, position);
+  util::Status status = dest_buffer->set_size(read);
+  if (!status.ok()) return status;
+  if (read < count) return util::Status(util::error::OUT_OF_RANGE, "EOF");
+  return util::OkStatus();
+}
+
+int64_t ThreadAllocationCount() { return allocation_count; }
+
+int64_t ThreadAllocatedBytes() { return allocated_bytes; }
+
+AllocationCounter::~AllocationCounter() {
+  state_->counters["allocs_per_op"] = benchmark::Counter(
+      ThreadAllocationCount() - start_, benchmark::Counter::kAvgIterations);
+}
+
+void SetThroughput(benchmark::State* state, int64_t bytes_per_op) {
+  state->SetItemsProcessed(state->iterations());
+  state->SetBytesProcessed(state->iterations() * bytes_per_op);
+}
+
+void SkipWithError(benchmark::State* state, const util::Status& status) {
+  state->SkipWithError(status.ToString().c_str());
+}
+
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
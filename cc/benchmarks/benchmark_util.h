@@ -0,0 +1,146 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_BENCHMARKS_BENCHMARK_UTIL_H_
+#define TINK_BENCHMARKS_BENCHMARK_UTIL_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "benchmark/benchmark.h"
+#include "tink/keyset_handle.h"
+#include "tink/random_access_stream.h"
+#include "tink/util/buffer.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+
+// Smallest and largest payload sizes used by the throughput benchmarks.
+constexpr int64_t kMinPayloadSize = 16;
+constexpr int64_t kMaxPayloadSize = 16 << 20;
+
+// Adds the payload sizes kMinPayloadSize .. kMaxPayloadSize (in steps of 16x)
+// and 1, 2, 4 and 8 threads to 'benchmark'.
+void PayloadSizesAndThreads(benchmark::internal::Benchmark* benchmark);
+
+// Returns a shared KeysetHandle containing a single key generated from
+// 'key_template'. The handle is generated on first use, and every benchmark
+// thread asking for the same template gets the same handle. Registers all
+// Tink primitives on first use.
+crypto::tink::util::StatusOr<const KeysetHandle*> SharedKeysetHandle(
+    const google::crypto::tink::KeyTemplate& key_template);
+
+// Returns a shared primitive of type P for the key generated from
+// 'key_template' (or for the corresponding public key, if 'public_key' is
+// true). As with SharedKeysetHandle(), the primitive is created once and then
+// shared between all benchmark threads; Tink primitives are thread safe.
+template <class P>
+crypto::tink::util::StatusOr<P*> SharedPrimitive(
+    const google::crypto::tink::KeyTemplate& key_template,
+    bool public_key = false) {
+  static absl::Mutex* mutex = new absl::Mutex();
+  static auto* primitives =
+      new absl::flat_hash_map<std::string, std::unique_ptr<P>>();
+
+  std::string cache_key =
+      absl::StrCat(public_key ? "public:" : "private:",
+                   key_template.SerializeAsString());
+  absl::MutexLock lock(mutex);
+  auto it = primitives->find(cache_key);
+  if (it != primitives->end()) return it->second.get();
+
+  auto handle_result = SharedKeysetHandle(key_template);
+  if (!handle_result.ok()) return handle_result.status();
+  const KeysetHandle* handle = handle_result.ValueOrDie();
+  std::unique_ptr<KeysetHandle> public_handle;
+  if (public_key) {
+    auto public_handle_result = handle->GetPublicKeysetHandle();
+    if (!public_handle_result.ok()) return public_handle_result.status();
+    public_handle = std::move(public_handle_result.ValueOrDie());
+    handle = public_handle.get();
+  }
+  auto primitive_result = handle->GetPrimitive<P>();
+  if (!primitive_result.ok()) return primitive_result.status();
+  P* primitive = primitive_result.ValueOrDie().get();
+  (*primitives)[cache_key] = std::move(primitive_result.ValueOrDie());
+  return primitive;
+}
+
+// Returns a string of 'size' pseudorandom bytes.
+std::string Payload(int64_t size);
+
+// A RandomAccessStream reading from an in-memory string, for benchmarking
+// random access decryption without I/O. Thread safe.
+class StringRandomAccessStream : public RandomAccessStream {
+ public:
+  explicit StringRandomAccessStream(std::string data)
+      : data_(std::move(data)) {}
+
+  crypto::tink::util::Status PRead(
+      int64_t position, int count,
+      crypto::tink::util::Buffer* dest_buffer) override;
+
+  crypto::tink::util::StatusOr<int64_t> size() override {
+    return data_.size();
+  }
+
+ private:
+  const std::string data_;
+};
+
+// Returns the number of heap allocations made so far by the calling thread.
+int64_t ThreadAllocationCount();
+
+// Returns the heap bytes allocated so far by the calling thread, minus those
+// it freed. Allocator overhead is not included.
+int64_t ThreadAllocatedBytes();
+
+// Measures allocations made by the calling thread while it is in scope, and
+// reports them as the "allocs_per_op" counter of 'state' on destruction.
+class AllocationCounter {
+ public:
+  explicit AllocationCounter(benchmark::State* state)
+      : state_(state), start_(ThreadAllocationCount()) {}
+  ~AllocationCounter();
+
+ private:
+  benchmark::State* state_;
+  int64_t start_;
+};
+
+// Sets the throughput counters of 'state', given that each iteration
+// processed 'bytes_per_op' bytes. Reports ops/s via the items processed and
+// bytes/s via the bytes processed.
+void SetThroughput(benchmark::State* state, int64_t bytes_per_op);
+
+// Aborts the benchmark 'state' with the message of 'status'.
+void SkipWithError(benchmark::State* state,
+                   const crypto::tink::util::Status& status);
+
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_BENCHMARKS_BENCHMARK_UTIL_H_
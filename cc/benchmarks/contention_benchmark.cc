@@ -0,0 +1,263 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Runs a single shared primitive with 1 to 64 threads. Besides the aggregate
+// items_per_second, every run reports the average throughput per thread and
+// its ratio to the single-threaded throughput ("scaling_efficiency"), so that
+// shared state serializing the threads (wrapper and registry mutexes, the
+// random number generator) shows up as an efficiency well below 1.
+
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/mac.h"
+#include "tink/mac/mac_key_templates.h"
+#include "tink/public_key_sign.h"
+#include "tink/public_key_verify.h"
+#include "tink/random_access_stream.h"
+#include "tink/signature/signature_key_templates.h"
+#include "tink/streaming_aead.h"
+#include "tink/streamingaead/streaming_aead_key_templates.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/buffer.h"
+#include "tink/util/ostream_output_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+using ::crypto::tink::subtle::test::WriteToStream;
+using ::crypto::tink::util::OstreamOutputStream;
+
+constexpr char kAssociatedData[] = "benchmark associated data";
+
+// Size of the streaming ciphertext, and of each random access read from it.
+constexpr int kStreamSize = 1 << 20;
+constexpr int kReadSize = 4 << 10;
+
+// Registers each benchmark with 1, 2, 4, ..., 64 threads. The thread count is
+// also passed as state.range(0), so that the benchmark can tell its
+// single-threaded run apart.
+void ThreadCounts(benchmark::internal::Benchmark* benchmark) {
+  for (int threads = 1; threads <= 64; threads *= 2) {
+    benchmark->Arg(threads)->Threads(threads);
+  }
+  benchmark->UseRealTime();
+}
+
+// Per-thread throughput of the single-threaded run of one benchmark, which
+// is the baseline of its multi-threaded runs.
+class ScalingBaseline {
+ public:
+  void Set(double ops_per_second) {
+    absl::MutexLock lock(&mutex_);
+    ops_per_second_ = ops_per_second;
+  }
+
+  double Get() {
+    absl::MutexLock lock(&mutex_);
+    return ops_per_second_;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  double ops_per_second_ = 0;
+};
+
+// Runs the benchmark loop of 'state', calling 'op' once per iteration, and
+// reports the scaling counters against 'baseline'. 'op' returns a
+// util::Status.
+template <class Op>
+void RunScaling(benchmark::State& state, ScalingBaseline* baseline, Op op) {
+  absl::Time start;
+  for (auto _ : state) {
+    // Starts the clock once all threads passed the start barrier.
+    if (start == absl::Time()) start = absl::Now();
+    util::Status status = op();
+    if (!status.ok()) return SkipWithError(&state, status);
+  }
+  double ops_per_second =
+      state.iterations() / absl::ToDoubleSeconds(absl::Now() - start);
+  if (state.range(0) == 1) baseline->Set(ops_per_second);
+
+  state.SetItemsProcessed(state.iterations());
+  state.counters["ops_per_second_per_thread"] =
+      benchmark::Counter(ops_per_second, benchmark::Counter::kAvgThreads);
+  double baseline_ops_per_second = baseline->Get();
+  if (baseline_ops_per_second > 0) {
+    state.counters["scaling_efficiency"] =
+        benchmark::Counter(ops_per_second / baseline_ops_per_second,
+                           benchmark::Counter::kAvgThreads);
+  }
+}
+
+// Every Encrypt() draws a fresh nonce from the random number generator.
+void BM_AeadEncrypt(benchmark::State& state) {
+  static ScalingBaseline* baseline = new ScalingBaseline();
+  auto aead_result = SharedPrimitive<Aead>(AeadKeyTemplates::Aes128Gcm());
+  if (!aead_result.ok()) return SkipWithError(&state, aead_result.status());
+  const Aead& aead = *aead_result.ValueOrDie();
+  std::string plaintext = Payload(kMinPayloadSize);
+
+  RunScaling(state, baseline, [&]() -> util::Status {
+    auto ciphertext = aead.Encrypt(plaintext, kAssociatedData);
+    if (!ciphertext.ok()) return ciphertext.status();
+    benchmark::DoNotOptimize(ciphertext.ValueOrDie());
+    return util::OkStatus();
+  });
+}
+
+// Decrypt() looks up the primitives of the key id prefix in the PrimitiveSet.
+void BM_AeadDecrypt(benchmark::State& state) {
+  static ScalingBaseline* baseline = new ScalingBaseline();
+  auto aead_result = SharedPrimitive<Aead>(AeadKeyTemplates::Aes128Gcm());
+  if (!aead_result.ok()) return SkipWithError(&state, aead_result.status());
+  const Aead& aead = *aead_result.ValueOrDie();
+  auto ciphertext_result =
+      aead.Encrypt(Payload(kMinPayloadSize), kAssociatedData);
+  if (!ciphertext_result.ok()) {
+    return SkipWithError(&state, ciphertext_result.status());
+  }
+  const std::string& ciphertext = ciphertext_result.ValueOrDie();
+
+  RunScaling(state, baseline, [&]() -> util::Status {
+    auto plaintext = aead.Decrypt(ciphertext, kAssociatedData);
+    if (!plaintext.ok()) return plaintext.status();
+    benchmark::DoNotOptimize(plaintext.ValueOrDie());
+    return util::OkStatus();
+  });
+}
+
+void BM_MacVerify(benchmark::State& state) {
+  static ScalingBaseline* baseline = new ScalingBaseline();
+  auto mac_result = SharedPrimitive<Mac>(MacKeyTemplates::HmacSha256());
+  if (!mac_result.ok()) return SkipWithError(&state, mac_result.status());
+  const Mac& mac = *mac_result.ValueOrDie();
+  std::string data = Payload(kMinPayloadSize);
+  auto tag_result = mac.ComputeMac(data);
+  if (!tag_result.ok()) return SkipWithError(&state, tag_result.status());
+  const std::string& tag = tag_result.ValueOrDie();
+
+  RunScaling(state, baseline, [&]() { return mac.VerifyMac(tag, data); });
+}
+
+void BM_SignatureVerify(benchmark::State& state) {
+  static ScalingBaseline* baseline = new ScalingBaseline();
+  auto signer_result =
+      SharedPrimitive<PublicKeySign>(SignatureKeyTemplates::EcdsaP256());
+  if (!signer_result.ok()) return SkipWithError(&state, signer_result.status());
+  auto verifier_result = SharedPrimitive<PublicKeyVerify>(
+      SignatureKeyTemplates::EcdsaP256(), /*public_key=*/true);
+  if (!verifier_result.ok()) {
+    return SkipWithError(&state, verifier_result.status());
+  }
+  const PublicKeyVerify& verifier = *verifier_result.ValueOrDie();
+  std::string data = Payload(kMinPayloadSize);
+  auto signature_result = signer_result.ValueOrDie()->Sign(data);
+  if (!signature_result.ok()) {
+    return SkipWithError(&state, signature_result.status());
+  }
+  const std::string& signature = signature_result.ValueOrDie();
+
+  RunScaling(state, baseline,
+             [&]() { return verifier.Verify(signature, data); });
+}
+
+// Creates the primitive from a shared KeysetHandle on every iteration, which
+// goes through the key manager lookup of the Registry.
+void BM_GetPrimitive(benchmark::State& state) {
+  static ScalingBaseline* baseline = new ScalingBaseline();
+  auto handle_result = SharedKeysetHandle(AeadKeyTemplates::Aes128Gcm());
+  if (!handle_result.ok()) return SkipWithError(&state, handle_result.status());
+  const KeysetHandle& handle = *handle_result.ValueOrDie();
+
+  RunScaling(state, baseline, [&]() -> util::Status {
+    auto aead = handle.GetPrimitive<Aead>();
+    if (!aead.ok()) return aead.status();
+    benchmark::DoNotOptimize(aead.ValueOrDie());
+    return util::OkStatus();
+  });
+}
+
+// Returns a decrypting random access stream over a kStreamSize ciphertext,
+// created once and read concurrently by all benchmark threads.
+util::StatusOr<std::unique_ptr<RandomAccessStream>> NewDecryptingStream() {
+  auto streaming_aead_result = SharedPrimitive<StreamingAead>(
+      StreamingAeadKeyTemplates::Aes128GcmHkdf4KB());
+  if (!streaming_aead_result.ok()) return streaming_aead_result.status();
+  StreamingAead* streaming_aead = streaming_aead_result.ValueOrDie();
+
+  auto ciphertext_stream = absl::make_unique<std::stringstream>();
+  std::stringstream* ciphertext_stream_ptr = ciphertext_stream.get();
+  auto encrypting_stream_result = streaming_aead->NewEncryptingStream(
+      absl::make_unique<OstreamOutputStream>(std::move(ciphertext_stream)),
+      kAssociatedData);
+  if (!encrypting_stream_result.ok()) return encrypting_stream_result.status();
+  util::Status status = WriteToStream(
+      encrypting_stream_result.ValueOrDie().get(), Payload(kStreamSize));
+  if (!status.ok()) return status;
+
+  return streaming_aead->NewDecryptingRandomAccessStream(
+      absl::make_unique<StringRandomAccessStream>(ciphertext_stream_ptr->str()),
+      kAssociatedData);
+}
+
+void BM_StreamingAeadRandomAccessDecrypt(benchmark::State& state) {
+  static ScalingBaseline* baseline = new ScalingBaseline();
+  static auto* stream_result =
+      new util::StatusOr<std::unique_ptr<RandomAccessStream>>(
+          NewDecryptingStream());
+  if (!stream_result->ok()) {
+    return SkipWithError(&state, stream_result->status());
+  }
+  RandomAccessStream* stream = stream_result->ValueOrDie().get();
+  auto buffer_result = util::Buffer::New(kReadSize);
+  if (!buffer_result.ok()) return SkipWithError(&state, buffer_result.status());
+  std::unique_ptr<util::Buffer> buffer = std::move(buffer_result.ValueOrDie());
+
+  int64_t read = 0;
+  RunScaling(state, baseline, [&]() -> util::Status {
+    int64_t position = (read++ % (kStreamSize / kReadSize)) * kReadSize;
+    return stream->PRead(position, kReadSize, buffer.get());
+  });
+}
+
+BENCHMARK(BM_AeadEncrypt)->Apply(ThreadCounts);
+BENCHMARK(BM_AeadDecrypt)->Apply(ThreadCounts);
+BENCHMARK(BM_MacVerify)->Apply(ThreadCounts);
+BENCHMARK(BM_SignatureVerify)->Apply(ThreadCounts);
+BENCHMARK(BM_GetPrimitive)->Apply(ThreadCounts);
+BENCHMARK(BM_StreamingAeadRandomAccessDecrypt)->Apply(ThreadCounts);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,110 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Measures CordAesGcmBoringSsl on Cords split into 1 to 1024 chunks, to show
+// the per-chunk cost of feeding each chunk to BoringSSL separately.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/cord.h"
+#include "absl/strings/cord_test_helpers.h"
+#include "benchmark/benchmark.h"
+#include "tink/aead/cord_aead.h"
+#include "tink/aead/internal/cord_aes_gcm_boringssl.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/subtle/random.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+constexpr char kAssociatedData[] = "benchmark associated data";
+
+// Returns a Cord holding 'data' in 'chunks' chunks of about the same size.
+absl::Cord ChunkedCord(const std::string& data, int64_t chunks) {
+  std::vector<std::string> pieces;
+  size_t piece_size = (data.size() + chunks - 1) / chunks;
+  for (size_t pos = 0; pos < data.size(); pos += piece_size) {
+    pieces.push_back(data.substr(pos, piece_size));
+  }
+  return absl::MakeFragmentedCord(pieces);
+}
+
+// Payloads of 1 KiB and 1 MiB, each split into 1 .. 1024 chunks.
+void PayloadSizesAndChunks(benchmark::internal::Benchmark* benchmark) {
+  for (int64_t size : {int64_t{1} << 10, int64_t{1} << 20}) {
+    for (int64_t chunks = 1; chunks <= 1024; chunks *= 4) {
+      benchmark->Args({size, chunks});
+    }
+  }
+}
+
+void BM_CordAesGcmEncrypt(benchmark::State& state) {
+  auto aead_result =
+      CordAesGcmBoringSsl::New(subtle::Random::GetRandomKeyBytes(16));
+  if (!aead_result.ok()) return SkipWithError(&state, aead_result.status());
+  const CordAead& aead = *aead_result.ValueOrDie();
+  absl::Cord plaintext = ChunkedCord(Payload(state.range(0)), state.range(1));
+  absl::Cord associated_data(kAssociatedData);
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto ciphertext = aead.Encrypt(plaintext, associated_data);
+      if (!ciphertext.ok()) return SkipWithError(&state, ciphertext.status());
+      benchmark::DoNotOptimize(ciphertext.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, plaintext.size());
+}
+
+void BM_CordAesGcmDecrypt(benchmark::State& state) {
+  auto aead_result =
+      CordAesGcmBoringSsl::New(subtle::Random::GetRandomKeyBytes(16));
+  if (!aead_result.ok()) return SkipWithError(&state, aead_result.status());
+  const CordAead& aead = *aead_result.ValueOrDie();
+  absl::Cord associated_data(kAssociatedData);
+  auto ciphertext_result =
+      aead.Encrypt(absl::Cord(Payload(state.range(0))), associated_data);
+  if (!ciphertext_result.ok()) {
+    return SkipWithError(&state, ciphertext_result.status());
+  }
+  absl::Cord ciphertext = ChunkedCord(
+      std::string(ciphertext_result.ValueOrDie()), state.range(1));
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto plaintext = aead.Decrypt(ciphertext, associated_data);
+      if (!plaintext.ok()) return SkipWithError(&state, plaintext.status());
+      benchmark::DoNotOptimize(plaintext.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, state.range(0));
+}
+
+BENCHMARK(BM_CordAesGcmEncrypt)->Apply(PayloadSizesAndChunks);
+BENCHMARK(BM_CordAesGcmDecrypt)->Apply(PayloadSizesAndChunks);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
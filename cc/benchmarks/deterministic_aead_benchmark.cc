@@ -0,0 +1,88 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/daead/deterministic_aead_key_templates.h"
+#include "tink/deterministic_aead.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+using ::google::crypto::tink::KeyTemplate;
+
+constexpr char kAssociatedData[] = "benchmark associated data";
+
+void BM_DeterministicAeadEncrypt(benchmark::State& state,
+                                 const KeyTemplate& (*key_template)()) {
+  auto daead_result = SharedPrimitive<DeterministicAead>(key_template());
+  if (!daead_result.ok()) return SkipWithError(&state, daead_result.status());
+  const DeterministicAead& daead = *daead_result.ValueOrDie();
+  std::string plaintext = Payload(state.range(0));
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto ciphertext =
+          daead.EncryptDeterministically(plaintext, kAssociatedData);
+      if (!ciphertext.ok()) return SkipWithError(&state, ciphertext.status());
+      benchmark::DoNotOptimize(ciphertext.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, plaintext.size());
+}
+
+void BM_DeterministicAeadDecrypt(benchmark::State& state,
+                                 const KeyTemplate& (*key_template)()) {
+  auto daead_result = SharedPrimitive<DeterministicAead>(key_template());
+  if (!daead_result.ok()) return SkipWithError(&state, daead_result.status());
+  const DeterministicAead& daead = *daead_result.ValueOrDie();
+  auto ciphertext_result = daead.EncryptDeterministically(
+      Payload(state.range(0)), kAssociatedData);
+  if (!ciphertext_result.ok()) {
+    return SkipWithError(&state, ciphertext_result.status());
+  }
+  const std::string& ciphertext = ciphertext_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto plaintext =
+          daead.DecryptDeterministically(ciphertext, kAssociatedData);
+      if (!plaintext.ok()) return SkipWithError(&state, plaintext.status());
+      benchmark::DoNotOptimize(plaintext.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, state.range(0));
+}
+
+BENCHMARK_CAPTURE(BM_DeterministicAeadEncrypt, Aes256Siv,
+                  &DeterministicAeadKeyTemplates::Aes256Siv)
+    ->Apply(PayloadSizesAndThreads);
+BENCHMARK_CAPTURE(BM_DeterministicAeadDecrypt, Aes256Siv,
+                  &DeterministicAeadKeyTemplates::Aes256Siv)
+    ->Apply(PayloadSizesAndThreads);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
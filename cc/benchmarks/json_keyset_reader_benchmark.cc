@@ -0,0 +1,165 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "benchmark/benchmark.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/json_keyset_reader.h"
+#include "tink/json_keyset_writer.h"
+#include "tink/keyset_reader.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+using ::google::crypto::tink::EncryptedKeyset;
+using ::google::crypto::tink::KeyData;
+using ::google::crypto::tink::Keyset;
+using ::google::crypto::tink::KeysetInfo;
+using ::google::crypto::tink::KeyStatusType;
+using ::google::crypto::tink::OutputPrefixType;
+
+constexpr char kTypeUrl[] = "type.googleapis.com/google.crypto.tink.AesGcmKey";
+
+// Returns a keyset with 'num_keys' keys, each with a random 34-byte value,
+// the size of a serialized 256-bit AesGcmKey.
+Keyset TestKeyset(int num_keys) {
+  Keyset keyset;
+  for (int i = 0; i < num_keys; ++i) {
+    Keyset::Key* key = keyset.add_key();
+    key->set_key_id(1000 + i);
+    key->set_status(KeyStatusType::ENABLED);
+    key->set_output_prefix_type(OutputPrefixType::TINK);
+    key->mutable_key_data()->set_type_url(kTypeUrl);
+    key->mutable_key_data()->set_value(Payload(34));
+    key->mutable_key_data()->set_key_material_type(KeyData::SYMMETRIC);
+  }
+  keyset.set_primary_key_id(1000);
+  return keyset;
+}
+
+EncryptedKeyset TestEncryptedKeyset(int num_keys) {
+  Keyset keyset = TestKeyset(num_keys);
+  EncryptedKeyset encrypted_keyset;
+  encrypted_keyset.set_encrypted_keyset(
+      Payload(keyset.SerializeAsString().size() + 28));
+  KeysetInfo* keyset_info = encrypted_keyset.mutable_keyset_info();
+  keyset_info->set_primary_key_id(keyset.primary_key_id());
+  for (const Keyset::Key& key : keyset.key()) {
+    KeysetInfo::KeyInfo* key_info = keyset_info->add_key_info();
+    key_info->set_type_url(key.key_data().type_url());
+    key_info->set_status(key.status());
+    key_info->set_key_id(key.key_id());
+    key_info->set_output_prefix_type(key.output_prefix_type());
+  }
+  return encrypted_keyset;
+}
+
+// Returns the JSON serialization of 'keyset', which is either a Keyset or an
+// EncryptedKeyset.
+template <class K>
+util::StatusOr<std::string> ToJson(const K& keyset) {
+  auto stream = absl::make_unique<std::stringstream>();
+  std::stringstream* stream_ptr = stream.get();
+  auto writer_result = JsonKeysetWriter::New(std::move(stream));
+  if (!writer_result.ok()) return writer_result.status();
+  util::Status status = writer_result.ValueOrDie()->Write(keyset);
+  if (!status.ok()) return status;
+  return stream_ptr->str();
+}
+
+void BM_ReadFromString(benchmark::State& state) {
+  auto json_result = ToJson(TestKeyset(state.range(0)));
+  if (!json_result.ok()) return SkipWithError(&state, json_result.status());
+  const std::string& json = json_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto reader_result = JsonKeysetReader::New(json);
+      if (!reader_result.ok()) {
+        return SkipWithError(&state, reader_result.status());
+      }
+      auto keyset = reader_result.ValueOrDie()->Read();
+      if (!keyset.ok()) return SkipWithError(&state, keyset.status());
+      benchmark::DoNotOptimize(keyset.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, json.size());
+}
+
+void BM_ReadFromStream(benchmark::State& state) {
+  auto json_result = ToJson(TestKeyset(state.range(0)));
+  if (!json_result.ok()) return SkipWithError(&state, json_result.status());
+  const std::string& json = json_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      // Includes copying the JSON into the stream, which BM_ReadFromString
+      // measures on its own.
+      auto stream = absl::make_unique<std::stringstream>(json);
+      auto reader_result = JsonKeysetReader::New(std::move(stream));
+      if (!reader_result.ok()) {
+        return SkipWithError(&state, reader_result.status());
+      }
+      auto keyset = reader_result.ValueOrDie()->Read();
+      if (!keyset.ok()) return SkipWithError(&state, keyset.status());
+      benchmark::DoNotOptimize(keyset.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, json.size());
+}
+
+void BM_ReadEncryptedFromString(benchmark::State& state) {
+  auto json_result = ToJson(TestEncryptedKeyset(state.range(0)));
+  if (!json_result.ok()) return SkipWithError(&state, json_result.status());
+  const std::string& json = json_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto reader_result = JsonKeysetReader::New(json);
+      if (!reader_result.ok()) {
+        return SkipWithError(&state, reader_result.status());
+      }
+      auto encrypted_keyset = reader_result.ValueOrDie()->ReadEncrypted();
+      if (!encrypted_keyset.ok()) {
+        return SkipWithError(&state, encrypted_keyset.status());
+      }
+      benchmark::DoNotOptimize(encrypted_keyset.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, json.size());
+}
+
+// Keysets with 1 to 4096 keys.
+BENCHMARK(BM_ReadFromString)->RangeMultiplier(8)->Range(1, 4096);
+BENCHMARK(BM_ReadFromStream)->RangeMultiplier(8)->Range(1, 4096);
+BENCHMARK(BM_ReadEncryptedFromString)->RangeMultiplier(8)->Range(1, 4096);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,378 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/jwt/internal/jwt_format.h"
+#include "tink/jwt/jwt_key_templates.h"
+#include "tink/jwt/jwt_mac.h"
+#include "tink/jwt/jwt_mac_config.h"
+#include "tink/jwt/jwt_public_key_sign.h"
+#include "tink/jwt/jwt_public_key_verify.h"
+#include "tink/jwt/jwt_signature_config.h"
+#include "tink/jwt/jwt_validator.h"
+#include "tink/jwt/raw_jwt.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+using ::google::crypto::tink::KeyTemplate;
+
+constexpr char kIssuer[] = "https://issuer.example.com";
+constexpr char kAudience[] = "https://api.example.com";
+// Size of the value of each custom claim.
+constexpr int64_t kCustomClaimSize = 64;
+
+// Adds claim sets with no, 1 KiB and 8 KiB of custom claims to 'benchmark'.
+void ClaimSetSizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->Arg(0)->Arg(1 << 10)->Arg(8 << 10);
+}
+
+// TinkConfig, which SharedPrimitive() registers, has no JWT primitives.
+util::Status RegisterJwt() {
+  static const util::Status* status = [] {
+    util::Status mac_status = JwtMacRegister();
+    if (!mac_status.ok()) return new util::Status(mac_status);
+    return new util::Status(JwtSignatureRegister());
+  }();
+  return *status;
+}
+
+// Returns a builder for a token with the registered claims of a typical
+// access token, and string custom claims of 'custom_claims_size' bytes.
+util::StatusOr<RawJwtBuilder> ClaimSet(int64_t custom_claims_size) {
+  absl::Time now = absl::FromUnixSeconds(absl::ToUnixSeconds(absl::Now()));
+  RawJwtBuilder builder;
+  builder.SetIssuer(kIssuer)
+      .SetSubject("user-0123456789")
+      .AddAudience(kAudience)
+      .SetJwtId("0123456789abcdef")
+      .SetIssuedAt(now)
+      .SetNotBefore(now)
+      .SetExpiration(now + absl::Hours(1));
+  for (int64_t i = 0; i * kCustomClaimSize < custom_claims_size; i++) {
+    util::Status status = builder.AddStringClaim(
+        absl::StrCat("claim_", i), std::string(kCustomClaimSize, 'a' + i % 26));
+    if (!status.ok()) return status;
+  }
+  return builder;
+}
+
+util::StatusOr<RawJwt> Token(int64_t custom_claims_size) {
+  auto builder_result = ClaimSet(custom_claims_size);
+  if (!builder_result.ok()) return builder_result.status();
+  return builder_result.ValueOrDie().Build();
+}
+
+JwtValidator Validator() {
+  return JwtValidatorBuilder().SetIssuer(kIssuer).SetAudience(kAudience)
+      .Build();
+}
+
+// The costs of the steps of creating and verifying a token other than the
+// MAC or signature, whose costs mac_benchmark and signature_benchmark show.
+
+void BM_RawJwtBuild(benchmark::State& state) {
+  auto builder_result = ClaimSet(state.range(0));
+  if (!builder_result.ok()) return SkipWithError(&state, builder_result.status());
+  RawJwtBuilder& builder = builder_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto token = builder.Build();
+      if (!token.ok()) return SkipWithError(&state, token.status());
+      benchmark::DoNotOptimize(token.ValueOrDie());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RawJwtBuild)->Apply(ClaimSetSizes);
+
+// Serializes the payload to JSON.
+void BM_RawJwtToJson(benchmark::State& state) {
+  auto token_result = Token(state.range(0));
+  if (!token_result.ok()) return SkipWithError(&state, token_result.status());
+  const RawJwt& token = token_result.ValueOrDie();
+  int64_t json_size = 0;
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto json = token.ToString();
+      if (!json.ok()) return SkipWithError(&state, json.status());
+      json_size = json.ValueOrDie().size();
+    }
+  }
+  SetThroughput(&state, json_size);
+}
+BENCHMARK(BM_RawJwtToJson)->Apply(ClaimSetSizes);
+
+// Parses the JSON payload, as verification does after checking the MAC or
+// signature.
+void BM_RawJwtFromJson(benchmark::State& state) {
+  auto token_result = Token(state.range(0));
+  if (!token_result.ok()) return SkipWithError(&state, token_result.status());
+  auto json_result = token_result.ValueOrDie().ToString();
+  if (!json_result.ok()) return SkipWithError(&state, json_result.status());
+  const std::string& json = json_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto token = RawJwt::FromString(json);
+      if (!token.ok()) return SkipWithError(&state, token.status());
+      benchmark::DoNotOptimize(token.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, json.size());
+}
+BENCHMARK(BM_RawJwtFromJson)->Apply(ClaimSetSizes);
+
+void BM_Base64UrlEncodePayload(benchmark::State& state) {
+  auto token_result = Token(state.range(0));
+  if (!token_result.ok()) return SkipWithError(&state, token_result.status());
+  auto json_result = token_result.ValueOrDie().ToString();
+  if (!json_result.ok()) return SkipWithError(&state, json_result.status());
+  const std::string& json = json_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(jwt_internal::EncodePayload(json));
+    }
+  }
+  SetThroughput(&state, json.size());
+}
+BENCHMARK(BM_Base64UrlEncodePayload)->Apply(ClaimSetSizes);
+
+void BM_Base64UrlDecodePayload(benchmark::State& state) {
+  auto token_result = Token(state.range(0));
+  if (!token_result.ok()) return SkipWithError(&state, token_result.status());
+  auto json_result = token_result.ValueOrDie().ToString();
+  if (!json_result.ok()) return SkipWithError(&state, json_result.status());
+  std::string encoded = jwt_internal::EncodePayload(json_result.ValueOrDie());
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      std::string json;
+      if (!jwt_internal::DecodePayload(encoded, &json)) {
+        return SkipWithError(&state,
+                             util::Status(util::error::INTERNAL,
+                                          "could not decode the payload"));
+      }
+      benchmark::DoNotOptimize(json);
+    }
+  }
+  SetThroughput(&state, encoded.size());
+}
+BENCHMARK(BM_Base64UrlDecodePayload)->Apply(ClaimSetSizes);
+
+// Everything signing does but the signature: serializing the payload and
+// encoding the header and payload.
+void BM_CreateUnsignedCompact(benchmark::State& state) {
+  auto token_result = Token(state.range(0));
+  if (!token_result.ok()) return SkipWithError(&state, token_result.status());
+  const RawJwt& token = token_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto json = token.ToString();
+      if (!json.ok()) return SkipWithError(&state, json.status());
+      benchmark::DoNotOptimize(
+          jwt_internal::CreateUnsignedCompact("HS256", json.ValueOrDie()));
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CreateUnsignedCompact)->Apply(ClaimSetSizes);
+
+// Everything verification does but the signature: checking the header,
+// decoding the payload and parsing it.
+void BM_DecodeAndParseCompact(benchmark::State& state) {
+  auto token_result = Token(state.range(0));
+  if (!token_result.ok()) return SkipWithError(&state, token_result.status());
+  auto json_result = token_result.ValueOrDie().ToString();
+  if (!json_result.ok()) return SkipWithError(&state, json_result.status());
+  std::string compact =
+      jwt_internal::CreateUnsignedCompact("HS256", json_result.ValueOrDie());
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      std::vector<absl::string_view> parts = absl::StrSplit(compact, '.');
+      util::Status status = jwt_internal::ValidateHeader(parts[0], "HS256");
+      if (!status.ok()) return SkipWithError(&state, status);
+      std::string json;
+      if (!jwt_internal::DecodePayload(parts[1], &json)) {
+        return SkipWithError(&state,
+                             util::Status(util::error::INTERNAL,
+                                          "could not decode the payload"));
+      }
+      auto token = RawJwt::FromString(json);
+      if (!token.ok()) return SkipWithError(&state, token.status());
+      benchmark::DoNotOptimize(token.ValueOrDie());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DecodeAndParseCompact)->Apply(ClaimSetSizes);
+
+// End to end, through the keyset wrappers.
+
+void BM_ComputeMacAndEncode(benchmark::State& state,
+                            const KeyTemplate& (*key_template)()) {
+  util::Status status = RegisterJwt();
+  if (!status.ok()) return SkipWithError(&state, status);
+  auto jwt_mac_result = SharedPrimitive<JwtMac>(key_template());
+  if (!jwt_mac_result.ok()) {
+    return SkipWithError(&state, jwt_mac_result.status());
+  }
+  const JwtMac& jwt_mac = *jwt_mac_result.ValueOrDie();
+  auto token_result = Token(state.range(0));
+  if (!token_result.ok()) return SkipWithError(&state, token_result.status());
+  const RawJwt& token = token_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto compact = jwt_mac.ComputeMacAndEncode(token);
+      if (!compact.ok()) return SkipWithError(&state, compact.status());
+      benchmark::DoNotOptimize(compact.ValueOrDie());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_VerifyMacAndDecode(benchmark::State& state,
+                           const KeyTemplate& (*key_template)()) {
+  util::Status status = RegisterJwt();
+  if (!status.ok()) return SkipWithError(&state, status);
+  auto jwt_mac_result = SharedPrimitive<JwtMac>(key_template());
+  if (!jwt_mac_result.ok()) {
+    return SkipWithError(&state, jwt_mac_result.status());
+  }
+  const JwtMac& jwt_mac = *jwt_mac_result.ValueOrDie();
+  auto token_result = Token(state.range(0));
+  if (!token_result.ok()) return SkipWithError(&state, token_result.status());
+  auto compact_result = jwt_mac.ComputeMacAndEncode(token_result.ValueOrDie());
+  if (!compact_result.ok()) {
+    return SkipWithError(&state, compact_result.status());
+  }
+  const std::string& compact = compact_result.ValueOrDie();
+  JwtValidator validator = Validator();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto verified = jwt_mac.VerifyMacAndDecode(compact, validator);
+      if (!verified.ok()) return SkipWithError(&state, verified.status());
+      benchmark::DoNotOptimize(verified.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, compact.size());
+}
+
+void BM_SignAndEncode(benchmark::State& state,
+                      const KeyTemplate& (*key_template)()) {
+  util::Status status = RegisterJwt();
+  if (!status.ok()) return SkipWithError(&state, status);
+  auto signer_result = SharedPrimitive<JwtPublicKeySign>(key_template());
+  if (!signer_result.ok()) return SkipWithError(&state, signer_result.status());
+  const JwtPublicKeySign& signer = *signer_result.ValueOrDie();
+  auto token_result = Token(state.range(0));
+  if (!token_result.ok()) return SkipWithError(&state, token_result.status());
+  const RawJwt& token = token_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto compact = signer.SignAndEncode(token);
+      if (!compact.ok()) return SkipWithError(&state, compact.status());
+      benchmark::DoNotOptimize(compact.ValueOrDie());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_VerifyAndDecode(benchmark::State& state,
+                        const KeyTemplate& (*key_template)()) {
+  util::Status status = RegisterJwt();
+  if (!status.ok()) return SkipWithError(&state, status);
+  auto signer_result = SharedPrimitive<JwtPublicKeySign>(key_template());
+  if (!signer_result.ok()) return SkipWithError(&state, signer_result.status());
+  auto verifier_result =
+      SharedPrimitive<JwtPublicKeyVerify>(key_template(), /*public_key=*/true);
+  if (!verifier_result.ok()) {
+    return SkipWithError(&state, verifier_result.status());
+  }
+  const JwtPublicKeyVerify& verifier = *verifier_result.ValueOrDie();
+  auto token_result = Token(state.range(0));
+  if (!token_result.ok()) return SkipWithError(&state, token_result.status());
+  auto compact_result =
+      signer_result.ValueOrDie()->SignAndEncode(token_result.ValueOrDie());
+  if (!compact_result.ok()) {
+    return SkipWithError(&state, compact_result.status());
+  }
+  const std::string& compact = compact_result.ValueOrDie();
+  JwtValidator validator = Validator();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto verified = verifier.VerifyAndDecode(compact, validator);
+      if (!verified.ok()) return SkipWithError(&state, verified.status());
+      benchmark::DoNotOptimize(verified.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, compact.size());
+}
+
+BENCHMARK_CAPTURE(BM_ComputeMacAndEncode, HS256, &JwtHs256Template)
+    ->Apply(ClaimSetSizes);
+BENCHMARK_CAPTURE(BM_VerifyMacAndDecode, HS256, &JwtHs256Template)
+    ->Apply(ClaimSetSizes);
+
+#define TINK_JWT_SIGNATURE_BENCHMARK(name, key_template)                 \
+  BENCHMARK_CAPTURE(BM_SignAndEncode, name, &key_template)               \
+      ->Apply(ClaimSetSizes);                                            \
+  BENCHMARK_CAPTURE(BM_VerifyAndDecode, name, &key_template)             \
+      ->Apply(ClaimSetSizes)
+
+TINK_JWT_SIGNATURE_BENCHMARK(ES256, JwtEs256Template);
+TINK_JWT_SIGNATURE_BENCHMARK(RS256, JwtRs256_2048_F4_Template);
+TINK_JWT_SIGNATURE_BENCHMARK(PS256, JwtPs256_2048_F4_Template);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
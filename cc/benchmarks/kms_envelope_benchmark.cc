@@ -0,0 +1,223 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Measures KmsEnvelopeAead against a FakeKmsClient that simulates the latency
+// and errors of a remote KMS, with and without DEK caching, synchronously and
+// asynchronously, and with 1 to 64 threads sharing one envelope AEAD.
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "benchmark/benchmark.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_config.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/aead/kms_envelope_aead.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/util/fake_kms_client.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+using ::crypto::tink::test::FakeKmsClient;
+
+constexpr char kAssociatedData[] = "benchmark associated data";
+
+// Number of operations each EncryptAsync() iteration has in flight.
+constexpr int kAsyncBatchSize = 16;
+
+// Adds the simulated KMS conditions as arguments: a latency of 1 or 10 ms
+// (state.range(0)), with up to half of it as jitter, and no or 1% of the KMS
+// calls failing (state.range(1), in per mille); each with 1, 4, 16 and 64
+// threads.
+void KmsConditions(benchmark::internal::Benchmark* benchmark) {
+  for (int threads = 1; threads <= 64; threads *= 4) {
+    for (int64_t latency_ms : {1, 10}) {
+      for (int64_t errors_per_mille : {0, 10}) {
+        benchmark->Args({latency_ms, errors_per_mille})->Threads(threads);
+      }
+    }
+  }
+  benchmark->UseRealTime();
+}
+
+KmsEnvelopeAead::DekCacheOptions NoDekCache() {
+  return KmsEnvelopeAead::DekCacheOptions();
+}
+
+KmsEnvelopeAead::DekCacheOptions DekCache() {
+  KmsEnvelopeAead::DekCacheOptions options;
+  options.max_messages_per_dek = 1000;
+  options.max_cached_decryption_deks = 100;
+  return options;
+}
+
+// Returns the KmsEnvelopeAead shared by all threads of the benchmark run
+// described by 'state', using a FakeKmsClient with the conditions of
+// state.range(0) and state.range(1) and DEK caching as in 'options'.
+util::StatusOr<const KmsEnvelopeAead*> SharedEnvelopeAead(
+    const benchmark::State& state,
+    KmsEnvelopeAead::DekCacheOptions (*options)()) {
+  static util::Status* register_status =
+      new util::Status(AeadConfig::Register());
+  if (!register_status->ok()) return *register_status;
+
+  static absl::Mutex* mutex = new absl::Mutex();
+  static auto* envelope_aeads =
+      new std::map<std::string, std::unique_ptr<KmsEnvelopeAead>>();
+  std::string cache_key =
+      absl::StrCat(reinterpret_cast<uintptr_t>(options), ":", state.range(0),
+                   ":", state.range(1));
+  absl::MutexLock lock(mutex);
+  auto it = envelope_aeads->find(cache_key);
+  if (it != envelope_aeads->end()) return it->second.get();
+
+  FakeKmsClient::Conditions conditions;
+  conditions.latency = absl::Milliseconds(state.range(0));
+  conditions.jitter = conditions.latency / 2;
+  conditions.error_rate = state.range(1) / 1000.0;
+  auto key_uri_result = FakeKmsClient::CreateFakeKeyUri();
+  if (!key_uri_result.ok()) return key_uri_result.status();
+  const std::string& key_uri = key_uri_result.ValueOrDie();
+  auto client_result =
+      FakeKmsClient::NewWithConditions(key_uri, "", conditions);
+  if (!client_result.ok()) return client_result.status();
+  auto remote_aead_result = client_result.ValueOrDie()->GetAead(key_uri);
+  if (!remote_aead_result.ok()) return remote_aead_result.status();
+  auto envelope_aead_result = KmsEnvelopeAead::NewWithDekCache(
+      AeadKeyTemplates::Aes128Gcm(),
+      std::move(remote_aead_result.ValueOrDie()), options());
+  if (!envelope_aead_result.ok()) return envelope_aead_result.status();
+  const KmsEnvelopeAead* envelope_aead =
+      envelope_aead_result.ValueOrDie().get();
+  (*envelope_aeads)[cache_key] = std::move(envelope_aead_result.ValueOrDie());
+  return envelope_aead;
+}
+
+// Reports the fraction of the operations that failed with the simulated
+// KMS errors as the "failed_ops" counter.
+void SetFailedOps(benchmark::State* state, int64_t failed_ops,
+                  int64_t ops) {
+  state->counters["failed_ops"] = benchmark::Counter(
+      ops > 0 ? static_cast<double>(failed_ops) / ops : 0,
+      benchmark::Counter::kAvgThreads);
+}
+
+void BM_Encrypt(benchmark::State& state,
+                KmsEnvelopeAead::DekCacheOptions (*options)()) {
+  auto envelope_aead_result = SharedEnvelopeAead(state, options);
+  if (!envelope_aead_result.ok()) {
+    return SkipWithError(&state, envelope_aead_result.status());
+  }
+  const Aead& envelope_aead = *envelope_aead_result.ValueOrDie();
+  std::string plaintext = Payload(kMinPayloadSize);
+
+  int64_t failed_ops = 0;
+  for (auto _ : state) {
+    auto ciphertext = envelope_aead.Encrypt(plaintext, kAssociatedData);
+    if (!ciphertext.ok()) ++failed_ops;
+    benchmark::DoNotOptimize(ciphertext);
+  }
+  state.SetItemsProcessed(state.iterations());
+  SetFailedOps(&state, failed_ops, state.iterations());
+}
+
+// All threads decrypt the same ciphertext, so that concurrent decryptions
+// of its DEK are coalesced.
+void BM_Decrypt(benchmark::State& state,
+                KmsEnvelopeAead::DekCacheOptions (*options)()) {
+  auto envelope_aead_result = SharedEnvelopeAead(state, options);
+  if (!envelope_aead_result.ok()) {
+    return SkipWithError(&state, envelope_aead_result.status());
+  }
+  const Aead& envelope_aead = *envelope_aead_result.ValueOrDie();
+  // Retries the simulated errors.
+  util::StatusOr<std::string> ciphertext_result;
+  for (int i = 0; i < 10 && !ciphertext_result.ok(); ++i) {
+    ciphertext_result =
+        envelope_aead.Encrypt(Payload(kMinPayloadSize), kAssociatedData);
+  }
+  if (!ciphertext_result.ok()) {
+    return SkipWithError(&state, ciphertext_result.status());
+  }
+  const std::string& ciphertext = ciphertext_result.ValueOrDie();
+
+  int64_t failed_ops = 0;
+  for (auto _ : state) {
+    auto plaintext = envelope_aead.Decrypt(ciphertext, kAssociatedData);
+    if (!plaintext.ok()) ++failed_ops;
+    benchmark::DoNotOptimize(plaintext);
+  }
+  state.SetItemsProcessed(state.iterations());
+  SetFailedOps(&state, failed_ops, state.iterations());
+}
+
+// Each iteration starts kAsyncBatchSize EncryptAsync() calls and waits for
+// all of them, so that a single thread has that many KMS calls in flight.
+void BM_EncryptAsync(benchmark::State& state,
+                     KmsEnvelopeAead::DekCacheOptions (*options)()) {
+  auto envelope_aead_result = SharedEnvelopeAead(state, options);
+  if (!envelope_aead_result.ok()) {
+    return SkipWithError(&state, envelope_aead_result.status());
+  }
+  const AsyncAead& envelope_aead = *envelope_aead_result.ValueOrDie();
+  std::string plaintext = Payload(kMinPayloadSize);
+
+  std::atomic<int64_t> failed_ops(0);
+  for (auto _ : state) {
+    absl::BlockingCounter pending(kAsyncBatchSize);
+    for (int i = 0; i < kAsyncBatchSize; ++i) {
+      envelope_aead.EncryptAsync(
+          plaintext, kAssociatedData,
+          [&pending, &failed_ops](util::StatusOr<std::string> ciphertext) {
+            if (!ciphertext.ok()) ++failed_ops;
+            pending.DecrementCount();
+          });
+    }
+    pending.Wait();
+  }
+  state.SetItemsProcessed(state.iterations() * kAsyncBatchSize);
+  SetFailedOps(&state, failed_ops.load(),
+               state.iterations() * kAsyncBatchSize);
+}
+
+#define TINK_KMS_ENVELOPE_BENCHMARK(options)                    \
+  BENCHMARK_CAPTURE(BM_Encrypt, options, &options)              \
+      ->Apply(KmsConditions);                                   \
+  BENCHMARK_CAPTURE(BM_Decrypt, options, &options)              \
+      ->Apply(KmsConditions);                                   \
+  BENCHMARK_CAPTURE(BM_EncryptAsync, options, &options)         \
+      ->Apply(KmsConditions)
+
+TINK_KMS_ENVELOPE_BENCHMARK(NoDekCache);
+TINK_KMS_ENVELOPE_BENCHMARK(DekCache);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,120 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/strings/string_view.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/mac.h"
+#include "tink/mac/mac_key_templates.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+using ::google::crypto::tink::KeyTemplate;
+
+void BM_ComputeMac(benchmark::State& state,
+                   const KeyTemplate& (*key_template)()) {
+  auto mac_result = SharedPrimitive<Mac>(key_template());
+  if (!mac_result.ok()) return SkipWithError(&state, mac_result.status());
+  const Mac& mac = *mac_result.ValueOrDie();
+  std::string data = Payload(state.range(0));
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto tag = mac.ComputeMac(data);
+      if (!tag.ok()) return SkipWithError(&state, tag.status());
+      benchmark::DoNotOptimize(tag.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, data.size());
+}
+
+void BM_VerifyMac(benchmark::State& state,
+                  const KeyTemplate& (*key_template)()) {
+  auto mac_result = SharedPrimitive<Mac>(key_template());
+  if (!mac_result.ok()) return SkipWithError(&state, mac_result.status());
+  const Mac& mac = *mac_result.ValueOrDie();
+  std::string data = Payload(state.range(0));
+  auto tag_result = mac.ComputeMac(data);
+  if (!tag_result.ok()) return SkipWithError(&state, tag_result.status());
+  const std::string& tag = tag_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      util::Status status = mac.VerifyMac(tag, data);
+      if (!status.ok()) return SkipWithError(&state, status);
+    }
+  }
+  SetThroughput(&state, data.size());
+}
+
+// Messages per ComputeMacBatch() call; enough to fill the lanes of the
+// multi-buffer HMAC-SHA256 several times.
+constexpr int kBatchSize = 64;
+
+void BM_ComputeMacBatch(benchmark::State& state,
+                        const KeyTemplate& (*key_template)()) {
+  auto mac_result = SharedPrimitive<Mac>(key_template());
+  if (!mac_result.ok()) return SkipWithError(&state, mac_result.status());
+  const Mac& mac = *mac_result.ValueOrDie();
+  std::vector<std::string> messages(kBatchSize, Payload(state.range(0)));
+  std::vector<absl::string_view> data(messages.begin(), messages.end());
+  std::string macs;
+  std::vector<int64_t> offsets;
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      util::Status status = mac.ComputeMacBatch(data, &macs, &offsets);
+      if (!status.ok()) return SkipWithError(&state, status);
+      benchmark::DoNotOptimize(macs);
+    }
+  }
+  SetThroughput(&state, kBatchSize * state.range(0));
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+#define TINK_MAC_BENCHMARK(template_name)                                  \
+  BENCHMARK_CAPTURE(BM_ComputeMac, template_name,                          \
+                    &MacKeyTemplates::template_name)                       \
+      ->Apply(PayloadSizesAndThreads);                                     \
+  BENCHMARK_CAPTURE(BM_VerifyMac, template_name,                           \
+                    &MacKeyTemplates::template_name)                       \
+      ->Apply(PayloadSizesAndThreads);                                     \
+  BENCHMARK_CAPTURE(BM_ComputeMacBatch, template_name,                     \
+                    &MacKeyTemplates::template_name)                       \
+      ->Apply(PayloadSizesAndThreads)
+
+TINK_MAC_BENCHMARK(HmacSha256HalfSizeTag);
+TINK_MAC_BENCHMARK(HmacSha256);
+TINK_MAC_BENCHMARK(HmacSha512HalfSizeTag);
+TINK_MAC_BENCHMARK(HmacSha512);
+TINK_MAC_BENCHMARK(AesCmac);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
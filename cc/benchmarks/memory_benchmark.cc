@@ -0,0 +1,165 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "benchmark/benchmark.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/config/tink_config.h"
+#include "tink/daead/deterministic_aead_key_templates.h"
+#include "tink/deterministic_aead.h"
+#include "tink/hybrid/hybrid_key_templates.h"
+#include "tink/hybrid_decrypt.h"
+#include "tink/keyset_handle.h"
+#include "tink/keyset_manager.h"
+#include "tink/mac.h"
+#include "tink/mac/mac_key_templates.h"
+#include "tink/prf/prf_key_templates.h"
+#include "tink/prf/prf_set.h"
+#include "tink/public_key_sign.h"
+#include "tink/signature/signature_key_templates.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+using ::google::crypto::tink::KeyTemplate;
+
+// Returns a handle for a keyset of 'num_keys' keys generated from
+// 'key_template'.
+util::StatusOr<std::unique_ptr<KeysetHandle>> NewKeysetHandle(
+    const KeyTemplate& key_template, int64_t num_keys) {
+  auto manager_result = KeysetManager::New(key_template);
+  if (!manager_result.ok()) return manager_result.status();
+  KeysetManager& manager = *manager_result.ValueOrDie();
+  for (int64_t i = 1; i < num_keys; ++i) {
+    auto add_result = manager.Add(key_template);
+    if (!add_result.ok()) return add_result.status();
+  }
+  return manager.GetKeysetHandle();
+}
+
+// Measures the heap memory held by a KeysetHandle with state.range(0) keys
+// generated from 'key_template' and by the wrapped primitive of type P
+// obtained from it. Reports, per key:
+//
+//   handle_bytes_per_key: measured bytes of the handle,
+//   estimated_handle_bytes_per_key: KeysetHandle::EstimateMemoryUsage(),
+//   primitive_bytes_per_key: measured bytes of the primitive.
+//
+// Each iteration creates a new keyset; the time is that of key generation
+// and primitive creation.
+template <class P>
+void MeasureKeysetMemory(benchmark::State& state,
+                         const KeyTemplate& (*key_template)()) {
+  util::Status status = TinkConfig::Register();
+  if (!status.ok()) return SkipWithError(&state, status);
+  int64_t num_keys = state.range(0);
+
+  // Static state, e.g. of the Registry, is allocated on first use; keep it
+  // out of the measurements.
+  {
+    auto handle_result = NewKeysetHandle(key_template(), 1);
+    if (!handle_result.ok()) {
+      return SkipWithError(&state, handle_result.status());
+    }
+    auto primitive_result = handle_result.ValueOrDie()->GetPrimitive<P>();
+    if (!primitive_result.ok()) {
+      return SkipWithError(&state, primitive_result.status());
+    }
+  }
+
+  int64_t handle_bytes = 0;
+  int64_t estimated_handle_bytes = 0;
+  int64_t primitive_bytes = 0;
+  for (auto _ : state) {
+    int64_t start = ThreadAllocatedBytes();
+    auto handle_result = NewKeysetHandle(key_template(), num_keys);
+    if (!handle_result.ok()) {
+      return SkipWithError(&state, handle_result.status());
+    }
+    std::unique_ptr<KeysetHandle> handle =
+        std::move(handle_result.ValueOrDie());
+    int64_t handle_end = ThreadAllocatedBytes();
+    auto primitive_result = handle->GetPrimitive<P>();
+    if (!primitive_result.ok()) {
+      return SkipWithError(&state, primitive_result.status());
+    }
+    std::unique_ptr<P> primitive = std::move(primitive_result.ValueOrDie());
+    handle_bytes = handle_end - start;
+    estimated_handle_bytes = handle->EstimateMemoryUsage();
+    primitive_bytes = ThreadAllocatedBytes() - handle_end;
+  }
+  state.counters["handle_bytes_per_key"] =
+      benchmark::Counter(static_cast<double>(handle_bytes) / num_keys);
+  state.counters["estimated_handle_bytes_per_key"] = benchmark::Counter(
+      static_cast<double>(estimated_handle_bytes) / num_keys);
+  state.counters["primitive_bytes_per_key"] =
+      benchmark::Counter(static_cast<double>(primitive_bytes) / num_keys);
+}
+
+#define TINK_MEMORY_BENCHMARK(primitive, templates, template_name) \
+  BENCHMARK_CAPTURE(BM_##primitive##Memory, template_name,         \
+                    &templates::template_name)                     \
+      ->Arg(1)                                                     \
+      ->Arg(100)
+
+// BENCHMARK_CAPTURE() needs plain function names.
+#define TINK_DEFINE_MEMORY_BENCHMARK(primitive)                       \
+  void BM_##primitive##Memory(benchmark::State& state,                \
+                              const KeyTemplate& (*key_template)()) { \
+    MeasureKeysetMemory<primitive>(state, key_template);              \
+  }
+
+TINK_DEFINE_MEMORY_BENCHMARK(Aead)
+TINK_DEFINE_MEMORY_BENCHMARK(DeterministicAead)
+TINK_DEFINE_MEMORY_BENCHMARK(Mac)
+TINK_DEFINE_MEMORY_BENCHMARK(PrfSet)
+TINK_DEFINE_MEMORY_BENCHMARK(PublicKeySign)
+TINK_DEFINE_MEMORY_BENCHMARK(HybridDecrypt)
+
+TINK_MEMORY_BENCHMARK(Aead, AeadKeyTemplates, Aes128Gcm);
+TINK_MEMORY_BENCHMARK(Aead, AeadKeyTemplates, Aes256Gcm);
+TINK_MEMORY_BENCHMARK(Aead, AeadKeyTemplates, Aes256GcmSiv);
+TINK_MEMORY_BENCHMARK(Aead, AeadKeyTemplates, Aes128Eax);
+TINK_MEMORY_BENCHMARK(Aead, AeadKeyTemplates, Aes128CtrHmacSha256);
+TINK_MEMORY_BENCHMARK(Aead, AeadKeyTemplates, XChaCha20Poly1305);
+TINK_MEMORY_BENCHMARK(DeterministicAead, DeterministicAeadKeyTemplates,
+                      Aes256Siv);
+TINK_MEMORY_BENCHMARK(Mac, MacKeyTemplates, HmacSha256);
+TINK_MEMORY_BENCHMARK(Mac, MacKeyTemplates, HmacSha512);
+TINK_MEMORY_BENCHMARK(Mac, MacKeyTemplates, AesCmac);
+TINK_MEMORY_BENCHMARK(PrfSet, PrfKeyTemplates, HmacSha256);
+TINK_MEMORY_BENCHMARK(PrfSet, PrfKeyTemplates, HkdfSha256);
+TINK_MEMORY_BENCHMARK(PublicKeySign, SignatureKeyTemplates, EcdsaP256);
+TINK_MEMORY_BENCHMARK(PublicKeySign, SignatureKeyTemplates, Ed25519);
+TINK_MEMORY_BENCHMARK(PublicKeySign, SignatureKeyTemplates,
+                      RsaSsaPss3072Sha256Sha256F4);
+TINK_MEMORY_BENCHMARK(HybridDecrypt, HybridKeyTemplates,
+                      EciesP256HkdfHmacSha256Aes128Gcm);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,107 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/strings/string_view.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/prf/prf_key_templates.h"
+#include "tink/prf/prf_set.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+using ::google::crypto::tink::KeyTemplate;
+
+// Largest output length supported by every PRF key template below.
+constexpr size_t kOutputLength = 16;
+
+void BM_ComputePrimaryPrf(benchmark::State& state,
+                          const KeyTemplate& (*key_template)()) {
+  auto prf_set_result = SharedPrimitive<PrfSet>(key_template());
+  if (!prf_set_result.ok()) {
+    return SkipWithError(&state, prf_set_result.status());
+  }
+  const PrfSet& prf_set = *prf_set_result.ValueOrDie();
+  std::string input = Payload(state.range(0));
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto output = prf_set.ComputePrimary(input, kOutputLength);
+      if (!output.ok()) return SkipWithError(&state, output.status());
+      benchmark::DoNotOptimize(output.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, input.size());
+}
+
+// Inputs per ComputePrimaryBatch() call; enough to fill the lanes of the
+// multi-buffer HMAC-SHA256 several times.
+constexpr int kBatchSize = 64;
+
+void BM_ComputePrimaryPrfBatch(benchmark::State& state,
+                               const KeyTemplate& (*key_template)()) {
+  auto prf_set_result = SharedPrimitive<PrfSet>(key_template());
+  if (!prf_set_result.ok()) {
+    return SkipWithError(&state, prf_set_result.status());
+  }
+  const PrfSet& prf_set = *prf_set_result.ValueOrDie();
+  std::vector<std::string> inputs(kBatchSize, Payload(state.range(0)));
+  std::vector<absl::string_view> input_views(inputs.begin(), inputs.end());
+  std::string outputs;
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      util::Status status =
+          prf_set.ComputePrimaryBatch(input_views, kOutputLength, &outputs);
+      if (!status.ok()) return SkipWithError(&state, status);
+      benchmark::DoNotOptimize(outputs);
+    }
+  }
+  SetThroughput(&state, kBatchSize * state.range(0));
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+BENCHMARK_CAPTURE(BM_ComputePrimaryPrf, HkdfSha256,
+                  &PrfKeyTemplates::HkdfSha256)
+    ->Apply(PayloadSizesAndThreads);
+BENCHMARK_CAPTURE(BM_ComputePrimaryPrf, HmacSha256,
+                  &PrfKeyTemplates::HmacSha256)
+    ->Apply(PayloadSizesAndThreads);
+BENCHMARK_CAPTURE(BM_ComputePrimaryPrf, HmacSha512,
+                  &PrfKeyTemplates::HmacSha512)
+    ->Apply(PayloadSizesAndThreads);
+BENCHMARK_CAPTURE(BM_ComputePrimaryPrf, AesCmac, &PrfKeyTemplates::AesCmac)
+    ->Apply(PayloadSizesAndThreads);
+BENCHMARK_CAPTURE(BM_ComputePrimaryPrfBatch, HmacSha256,
+                  &PrfKeyTemplates::HmacSha256)
+    ->Apply(PayloadSizesAndThreads);
+BENCHMARK_CAPTURE(BM_ComputePrimaryPrfBatch, HmacSha512,
+                  &PrfKeyTemplates::HmacSha512)
+    ->Apply(PayloadSizesAndThreads);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,158 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/public_key_sign.h"
+#include "tink/public_key_verify.h"
+#include "tink/signature/signature_key_templates.h"
+#include "proto/rsa_ssa_pkcs1.pb.h"
+#include "proto/rsa_ssa_pss.pb.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+using ::google::crypto::tink::KeyTemplate;
+using ::google::crypto::tink::RsaSsaPkcs1KeyFormat;
+using ::google::crypto::tink::RsaSsaPssKeyFormat;
+
+// Returns 'key_template' with the modulus size of its key format of type F
+// set to 'modulus_size_in_bits'.
+template <class F>
+KeyTemplate WithModulusSize(const KeyTemplate& key_template,
+                            int modulus_size_in_bits) {
+  KeyTemplate result = key_template;
+  F key_format;
+  key_format.ParseFromString(key_template.value());
+  key_format.set_modulus_size_in_bits(modulus_size_in_bits);
+  key_format.SerializeToString(result.mutable_value());
+  return result;
+}
+
+// SignatureKeyTemplates has no 2048-bit RSA templates, which are still the
+// most common RSA keys in practice.
+const KeyTemplate& RsaSsaPkcs12048Sha256F4() {
+  static const KeyTemplate* key_template =
+      new KeyTemplate(WithModulusSize<RsaSsaPkcs1KeyFormat>(
+          SignatureKeyTemplates::RsaSsaPkcs13072Sha256F4(), 2048));
+  return *key_template;
+}
+
+const KeyTemplate& RsaSsaPss2048Sha256Sha256F4() {
+  static const KeyTemplate* key_template =
+      new KeyTemplate(WithModulusSize<RsaSsaPssKeyFormat>(
+          SignatureKeyTemplates::RsaSsaPss3072Sha256Sha256F4(), 2048));
+  return *key_template;
+}
+
+// Adds 1 to 64 threads with the smallest payload size to 'benchmark'. RSA
+// verification is dominated by the modular exponentiation, so this shows how
+// verification scales with the number of threads sharing a key.
+void SmallPayloadManyThreads(benchmark::internal::Benchmark* benchmark) {
+  for (int threads = 1; threads <= 64; threads *= 2) {
+    benchmark->Args({kMinPayloadSize})->Threads(threads);
+  }
+  benchmark->UseRealTime();
+}
+
+void BM_Sign(benchmark::State& state, const KeyTemplate& (*key_template)()) {
+  auto signer_result = SharedPrimitive<PublicKeySign>(key_template());
+  if (!signer_result.ok()) return SkipWithError(&state, signer_result.status());
+  const PublicKeySign& signer = *signer_result.ValueOrDie();
+  std::string data = Payload(state.range(0));
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto signature = signer.Sign(data);
+      if (!signature.ok()) return SkipWithError(&state, signature.status());
+      benchmark::DoNotOptimize(signature.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, data.size());
+}
+
+void BM_Verify(benchmark::State& state, const KeyTemplate& (*key_template)()) {
+  auto signer_result = SharedPrimitive<PublicKeySign>(key_template());
+  if (!signer_result.ok()) return SkipWithError(&state, signer_result.status());
+  auto verifier_result =
+      SharedPrimitive<PublicKeyVerify>(key_template(), /*public_key=*/true);
+  if (!verifier_result.ok()) {
+    return SkipWithError(&state, verifier_result.status());
+  }
+  const PublicKeyVerify& verifier = *verifier_result.ValueOrDie();
+  std::string data = Payload(state.range(0));
+  auto signature_result = signer_result.ValueOrDie()->Sign(data);
+  if (!signature_result.ok()) {
+    return SkipWithError(&state, signature_result.status());
+  }
+  const std::string& signature = signature_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      util::Status status = verifier.Verify(signature, data);
+      if (!status.ok()) return SkipWithError(&state, status);
+    }
+  }
+  SetThroughput(&state, data.size());
+}
+
+#define TINK_SIGNATURE_BENCHMARK(template_name)                            \
+  BENCHMARK_CAPTURE(BM_Sign, template_name,                                \
+                    &SignatureKeyTemplates::template_name)                 \
+      ->Apply(PayloadSizesAndThreads);                                     \
+  BENCHMARK_CAPTURE(BM_Verify, template_name,                              \
+                    &SignatureKeyTemplates::template_name)                 \
+      ->Apply(PayloadSizesAndThreads)
+
+TINK_SIGNATURE_BENCHMARK(EcdsaP256);
+TINK_SIGNATURE_BENCHMARK(EcdsaP384);
+TINK_SIGNATURE_BENCHMARK(EcdsaP521);
+TINK_SIGNATURE_BENCHMARK(EcdsaP256Ieee);
+TINK_SIGNATURE_BENCHMARK(RsaSsaPkcs13072Sha256F4);
+TINK_SIGNATURE_BENCHMARK(RsaSsaPss3072Sha256Sha256F4);
+TINK_SIGNATURE_BENCHMARK(Ed25519);
+
+#define TINK_RSA_VERIFY_CONCURRENCY_BENCHMARK(name, key_template) \
+  BENCHMARK_CAPTURE(BM_Verify, name##_Concurrency, &key_template) \
+      ->Apply(SmallPayloadManyThreads)
+
+TINK_RSA_VERIFY_CONCURRENCY_BENCHMARK(RsaSsaPkcs12048Sha256F4,
+                                      RsaSsaPkcs12048Sha256F4);
+TINK_RSA_VERIFY_CONCURRENCY_BENCHMARK(
+    RsaSsaPkcs13072Sha256F4, SignatureKeyTemplates::RsaSsaPkcs13072Sha256F4);
+TINK_RSA_VERIFY_CONCURRENCY_BENCHMARK(
+    RsaSsaPkcs14096Sha512F4, SignatureKeyTemplates::RsaSsaPkcs14096Sha512F4);
+TINK_RSA_VERIFY_CONCURRENCY_BENCHMARK(RsaSsaPss2048Sha256Sha256F4,
+                                      RsaSsaPss2048Sha256Sha256F4);
+TINK_RSA_VERIFY_CONCURRENCY_BENCHMARK(
+    RsaSsaPss3072Sha256Sha256F4,
+    SignatureKeyTemplates::RsaSsaPss3072Sha256Sha256F4);
+TINK_RSA_VERIFY_CONCURRENCY_BENCHMARK(
+    RsaSsaPss4096Sha512Sha512F4,
+    SignatureKeyTemplates::RsaSsaPss4096Sha512Sha512F4);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
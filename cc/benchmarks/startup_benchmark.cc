@@ -0,0 +1,330 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+// Measures the steps a process takes before its first cryptographic
+// operation: registering the key managers, reading a keyset and creating the
+// primitive from it.
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "benchmark/benchmark.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_config.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/binary_keyset_reader.h"
+#include "tink/binary_keyset_writer.h"
+#include "tink/cleartext_keyset_handle.h"
+#include "tink/config/tink_config.h"
+#include "tink/daead/deterministic_aead_key_templates.h"
+#include "tink/deterministic_aead.h"
+#include "tink/hybrid/hybrid_key_templates.h"
+#include "tink/hybrid_decrypt.h"
+#include "tink/json_keyset_reader.h"
+#include "tink/json_keyset_writer.h"
+#include "tink/keyset_handle.h"
+#include "tink/keyset_manager.h"
+#include "tink/mac.h"
+#include "tink/mac/mac_key_templates.h"
+#include "tink/prf/prf_key_templates.h"
+#include "tink/prf/prf_set.h"
+#include "tink/public_key_sign.h"
+#include "tink/registry.h"
+#include "tink/signature/signature_key_templates.h"
+#include "tink/util/fake_kms_client.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+using ::crypto::tink::test::FakeKmsClient;
+using ::google::crypto::tink::KeyTemplate;
+
+// Registers a fresh Registry with 'config_register' in each iteration. The
+// Registry is reset outside of the measured time, and left with all of Tink
+// registered, which the other benchmarks rely on.
+void MeasureRegister(benchmark::State& state,
+                     util::Status (*config_register)()) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    Registry::Reset();
+    state.ResumeTiming();
+    util::Status status = config_register();
+    if (!status.ok()) return SkipWithError(&state, status);
+  }
+  state.PauseTiming();
+  Registry::Reset();
+  util::Status status = TinkConfig::Register();
+  if (!status.ok()) return SkipWithError(&state, status);
+  state.ResumeTiming();
+}
+
+void BM_TinkConfigRegister(benchmark::State& state) {
+  MeasureRegister(state, &TinkConfig::Register);
+}
+
+void BM_AeadConfigRegister(benchmark::State& state) {
+  MeasureRegister(state, &AeadConfig::Register);
+}
+
+// Registering again is what processes calling Register() before each use
+// pay; all key managers are already present.
+void BM_TinkConfigRegisterAgain(benchmark::State& state) {
+  util::Status status = TinkConfig::Register();
+  if (!status.ok()) return SkipWithError(&state, status);
+  for (auto _ : state) {
+    status = TinkConfig::Register();
+    if (!status.ok()) return SkipWithError(&state, status);
+  }
+}
+
+BENCHMARK(BM_TinkConfigRegister);
+BENCHMARK(BM_AeadConfigRegister);
+BENCHMARK(BM_TinkConfigRegisterAgain);
+
+// The serialized forms of one keyset, as a process would load them.
+struct SerializedKeyset {
+  std::string binary;
+  std::string json;
+  // The keyset encrypted with the FakeKmsClient key 'kms_key_uri'.
+  std::string encrypted;
+  std::string kms_key_uri;
+};
+
+util::StatusOr<SerializedKeyset> NewSerializedKeyset(
+    const KeyTemplate& key_template, int64_t num_keys) {
+  auto manager_result = KeysetManager::New(key_template);
+  if (!manager_result.ok()) return manager_result.status();
+  KeysetManager& manager = *manager_result.ValueOrDie();
+  for (int64_t i = 1; i < num_keys; ++i) {
+    auto add_result = manager.Add(key_template);
+    if (!add_result.ok()) return add_result.status();
+  }
+  std::unique_ptr<KeysetHandle> handle = manager.GetKeysetHandle();
+
+  SerializedKeyset result;
+  result.binary = CleartextKeysetHandle::GetKeyset(*handle).SerializeAsString();
+
+  auto json_stream = absl::make_unique<std::stringstream>();
+  std::stringstream* json_stream_ptr = json_stream.get();
+  auto json_writer_result = JsonKeysetWriter::New(std::move(json_stream));
+  if (!json_writer_result.ok()) return json_writer_result.status();
+  util::Status status = CleartextKeysetHandle::Write(
+      json_writer_result.ValueOrDie().get(), *handle);
+  if (!status.ok()) return status;
+  result.json = json_stream_ptr->str();
+
+  auto key_uri_result = FakeKmsClient::CreateFakeKeyUri();
+  if (!key_uri_result.ok()) return key_uri_result.status();
+  result.kms_key_uri = key_uri_result.ValueOrDie();
+  auto client_result = FakeKmsClient::New(result.kms_key_uri, "");
+  if (!client_result.ok()) return client_result.status();
+  auto kms_aead_result =
+      client_result.ValueOrDie()->GetAead(result.kms_key_uri);
+  if (!kms_aead_result.ok()) return kms_aead_result.status();
+  auto encrypted_stream = absl::make_unique<std::stringstream>();
+  std::stringstream* encrypted_stream_ptr = encrypted_stream.get();
+  auto binary_writer_result =
+      BinaryKeysetWriter::New(std::move(encrypted_stream));
+  if (!binary_writer_result.ok()) return binary_writer_result.status();
+  status = handle->Write(binary_writer_result.ValueOrDie().get(),
+                         *kms_aead_result.ValueOrDie());
+  if (!status.ok()) return status;
+  result.encrypted = encrypted_stream_ptr->str();
+  return result;
+}
+
+// Returns the serialized keyset with state.range(0) keys generated from
+// 'key_template'. Keysets are generated once, as generating 1000 asymmetric
+// keys takes far longer than reading them.
+util::StatusOr<const SerializedKeyset*> SharedSerializedKeyset(
+    const benchmark::State& state, const KeyTemplate& key_template) {
+  util::Status status = TinkConfig::Register();
+  if (!status.ok()) return status;
+
+  static absl::Mutex* mutex = new absl::Mutex();
+  static auto* keysets =
+      new std::map<std::pair<std::string, int64_t>, SerializedKeyset>();
+  std::pair<std::string, int64_t> cache_key(key_template.SerializeAsString(),
+                                            state.range(0));
+  absl::MutexLock lock(mutex);
+  auto it = keysets->find(cache_key);
+  if (it != keysets->end()) return &it->second;
+  auto keyset_result = NewSerializedKeyset(key_template, state.range(0));
+  if (!keyset_result.ok()) return keyset_result.status();
+  return &keysets->emplace(cache_key, std::move(keyset_result.ValueOrDie()))
+              .first->second;
+}
+
+void BM_ReadBinary(benchmark::State& state,
+                   const KeyTemplate& (*key_template)()) {
+  auto keyset_result = SharedSerializedKeyset(state, key_template());
+  if (!keyset_result.ok()) return SkipWithError(&state, keyset_result.status());
+  const SerializedKeyset& keyset = *keyset_result.ValueOrDie();
+
+  for (auto _ : state) {
+    auto reader_result = BinaryKeysetReader::New(keyset.binary);
+    if (!reader_result.ok()) {
+      return SkipWithError(&state, reader_result.status());
+    }
+    auto handle_result =
+        CleartextKeysetHandle::Read(std::move(reader_result.ValueOrDie()));
+    if (!handle_result.ok()) {
+      return SkipWithError(&state, handle_result.status());
+    }
+    benchmark::DoNotOptimize(handle_result.ValueOrDie());
+  }
+  SetThroughput(&state, keyset.binary.size());
+}
+
+void BM_ReadJson(benchmark::State& state,
+                 const KeyTemplate& (*key_template)()) {
+  auto keyset_result = SharedSerializedKeyset(state, key_template());
+  if (!keyset_result.ok()) return SkipWithError(&state, keyset_result.status());
+  const SerializedKeyset& keyset = *keyset_result.ValueOrDie();
+
+  for (auto _ : state) {
+    auto reader_result = JsonKeysetReader::New(keyset.json);
+    if (!reader_result.ok()) {
+      return SkipWithError(&state, reader_result.status());
+    }
+    auto handle_result =
+        CleartextKeysetHandle::Read(std::move(reader_result.ValueOrDie()));
+    if (!handle_result.ok()) {
+      return SkipWithError(&state, handle_result.status());
+    }
+    benchmark::DoNotOptimize(handle_result.ValueOrDie());
+  }
+  SetThroughput(&state, keyset.json.size());
+}
+
+// Includes creating the KMS client and its Aead, as a process starting up
+// has to.
+void BM_ReadEncrypted(benchmark::State& state,
+                      const KeyTemplate& (*key_template)()) {
+  auto keyset_result = SharedSerializedKeyset(state, key_template());
+  if (!keyset_result.ok()) return SkipWithError(&state, keyset_result.status());
+  const SerializedKeyset& keyset = *keyset_result.ValueOrDie();
+
+  for (auto _ : state) {
+    auto client_result = FakeKmsClient::New(keyset.kms_key_uri, "");
+    if (!client_result.ok()) {
+      return SkipWithError(&state, client_result.status());
+    }
+    auto kms_aead_result =
+        client_result.ValueOrDie()->GetAead(keyset.kms_key_uri);
+    if (!kms_aead_result.ok()) {
+      return SkipWithError(&state, kms_aead_result.status());
+    }
+    auto reader_result = BinaryKeysetReader::New(keyset.encrypted);
+    if (!reader_result.ok()) {
+      return SkipWithError(&state, reader_result.status());
+    }
+    auto handle_result =
+        KeysetHandle::Read(std::move(reader_result.ValueOrDie()),
+                           *kms_aead_result.ValueOrDie());
+    if (!handle_result.ok()) {
+      return SkipWithError(&state, handle_result.status());
+    }
+    benchmark::DoNotOptimize(handle_result.ValueOrDie());
+  }
+  SetThroughput(&state, keyset.encrypted.size());
+}
+
+// KeysetHandle does not cache primitives, so every GetPrimitive() call does
+// the work of the first one.
+template <class P>
+void MeasureGetPrimitive(benchmark::State& state,
+                         const KeyTemplate& (*key_template)()) {
+  auto keyset_result = SharedSerializedKeyset(state, key_template());
+  if (!keyset_result.ok()) return SkipWithError(&state, keyset_result.status());
+  auto reader_result =
+      BinaryKeysetReader::New(keyset_result.ValueOrDie()->binary);
+  if (!reader_result.ok()) return SkipWithError(&state, reader_result.status());
+  auto handle_result =
+      CleartextKeysetHandle::Read(std::move(reader_result.ValueOrDie()));
+  if (!handle_result.ok()) return SkipWithError(&state, handle_result.status());
+  const KeysetHandle& handle = *handle_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto primitive_result = handle.GetPrimitive<P>();
+      if (!primitive_result.ok()) {
+        return SkipWithError(&state, primitive_result.status());
+      }
+      benchmark::DoNotOptimize(primitive_result.ValueOrDie());
+    }
+  }
+}
+
+// BENCHMARK_CAPTURE() needs plain function names.
+#define TINK_DEFINE_GET_PRIMITIVE_BENCHMARK(primitive)                      \
+  void BM_##primitive##GetPrimitive(benchmark::State& state,                \
+                                    const KeyTemplate& (*key_template)()) { \
+    MeasureGetPrimitive<primitive>(state, key_template);                    \
+  }
+
+TINK_DEFINE_GET_PRIMITIVE_BENCHMARK(Aead)
+TINK_DEFINE_GET_PRIMITIVE_BENCHMARK(DeterministicAead)
+TINK_DEFINE_GET_PRIMITIVE_BENCHMARK(Mac)
+TINK_DEFINE_GET_PRIMITIVE_BENCHMARK(PrfSet)
+TINK_DEFINE_GET_PRIMITIVE_BENCHMARK(PublicKeySign)
+TINK_DEFINE_GET_PRIMITIVE_BENCHMARK(HybridDecrypt)
+
+// Keysets with 1, 10, 100 and 1000 keys.
+void KeysetSizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->RangeMultiplier(10)->Range(1, 1000);
+}
+
+#define TINK_STARTUP_BENCHMARK(primitive, templates, template_name)     \
+  BENCHMARK_CAPTURE(BM_ReadBinary, primitive##_##template_name,         \
+                    &templates::template_name)                          \
+      ->Apply(KeysetSizes);                                             \
+  BENCHMARK_CAPTURE(BM_ReadJson, primitive##_##template_name,           \
+                    &templates::template_name)                          \
+      ->Apply(KeysetSizes);                                             \
+  BENCHMARK_CAPTURE(BM_ReadEncrypted, primitive##_##template_name,      \
+                    &templates::template_name)                          \
+      ->Apply(KeysetSizes);                                             \
+  BENCHMARK_CAPTURE(BM_##primitive##GetPrimitive, template_name,        \
+                    &templates::template_name)                          \
+      ->Apply(KeysetSizes)
+
+TINK_STARTUP_BENCHMARK(Aead, AeadKeyTemplates, Aes128Gcm);
+TINK_STARTUP_BENCHMARK(DeterministicAead, DeterministicAeadKeyTemplates,
+                       Aes256Siv);
+TINK_STARTUP_BENCHMARK(Mac, MacKeyTemplates, HmacSha256);
+TINK_STARTUP_BENCHMARK(PrfSet, PrfKeyTemplates, HmacSha256);
+TINK_STARTUP_BENCHMARK(PublicKeySign, SignatureKeyTemplates, EcdsaP256);
+TINK_STARTUP_BENCHMARK(HybridDecrypt, HybridKeyTemplates,
+                       EciesP256HkdfHmacSha256Aes128Gcm);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
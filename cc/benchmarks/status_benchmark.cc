@@ -0,0 +1,93 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string>
+
+#include "absl/base/attributes.h"
+#include "benchmark/benchmark.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+// A value which does not fit the small string buffer, like most ciphertexts.
+constexpr char kValue[] = "a value longer than the small string buffer";
+
+ABSL_ATTRIBUTE_NOINLINE std::string ReturnString() { return kValue; }
+
+ABSL_ATTRIBUTE_NOINLINE util::StatusOr<std::string> ReturnStatusOr() {
+  return std::string(kValue);
+}
+
+ABSL_ATTRIBUTE_NOINLINE util::StatusOr<std::string> ReturnError() {
+  return util::Status(util::error::INTERNAL, "Authentication failed");
+}
+
+ABSL_ATTRIBUTE_NOINLINE util::StatusOr<std::string> ReturnStaticError() {
+  static const util::Status* kAuthenticationFailed =
+      util::Status::NewStatic(util::error::INTERNAL, "Authentication failed");
+  return *kAuthenticationFailed;
+}
+
+// Baseline for BM_ReturnStatusOr.
+void BM_ReturnString(benchmark::State& state) {
+  AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    std::string value = ReturnString();
+    benchmark::DoNotOptimize(value);
+  }
+}
+
+void BM_ReturnStatusOr(benchmark::State& state) {
+  AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    util::StatusOr<std::string> result = ReturnStatusOr();
+    if (!result.ok()) return SkipWithError(&state, result.status());
+    benchmark::DoNotOptimize(result.ValueOrDie());
+  }
+}
+
+void BM_ReturnError(benchmark::State& state) {
+  AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    util::StatusOr<std::string> result = ReturnError();
+    benchmark::DoNotOptimize(result.ok());
+  }
+}
+
+// Errors made with Status::NewStatic(), as returned by the AEAD primitives
+// on failed authentication, which trial decryption hits for every key.
+void BM_ReturnStaticError(benchmark::State& state) {
+  AllocationCounter allocations(&state);
+  for (auto _ : state) {
+    util::StatusOr<std::string> result = ReturnStaticError();
+    benchmark::DoNotOptimize(result.ok());
+  }
+}
+
+BENCHMARK(BM_ReturnString);
+BENCHMARK(BM_ReturnStatusOr);
+BENCHMARK(BM_ReturnError);
+BENCHMARK(BM_ReturnStaticError);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,434 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "benchmark/benchmark.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/config/tink_config.h"
+#include "tink/keyset_handle.h"
+#include "tink/keyset_manager.h"
+#include "tink/random_access_stream.h"
+#include "tink/streaming_aead.h"
+#include "tink/streamingaead/streaming_aead_key_templates.h"
+#include "tink/subtle/aes_ctr_hmac_streaming.h"
+#include "tink/subtle/aes_gcm_hkdf_streaming.h"
+#include "tink/subtle/common_enums.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/buffer.h"
+#include "tink/util/istream_input_stream.h"
+#include "tink/util/ostream_output_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+using ::crypto::tink::subtle::test::ReadFromStream;
+using ::crypto::tink::subtle::test::WriteToStream;
+using ::crypto::tink::util::IstreamInputStream;
+using ::crypto::tink::util::OstreamOutputStream;
+using ::google::crypto::tink::KeyTemplate;
+
+constexpr char kAssociatedData[] = "benchmark associated data";
+
+// Encrypts 'plaintext' with 'streaming_aead' into an in-memory buffer and
+// returns the resulting ciphertext.
+util::StatusOr<std::string> EncryptToString(StreamingAead* streaming_aead,
+                                            absl::string_view plaintext) {
+  auto ciphertext_stream = absl::make_unique<std::stringstream>();
+  std::stringstream* ciphertext_stream_ptr = ciphertext_stream.get();
+  auto encrypting_stream_result = streaming_aead->NewEncryptingStream(
+      absl::make_unique<OstreamOutputStream>(std::move(ciphertext_stream)),
+      kAssociatedData);
+  if (!encrypting_stream_result.ok()) return encrypting_stream_result.status();
+  util::Status status =
+      WriteToStream(encrypting_stream_result.ValueOrDie().get(), plaintext);
+  if (!status.ok()) return status;
+  return ciphertext_stream_ptr->str();
+}
+
+void BM_StreamingAeadEncrypt(benchmark::State& state,
+                             const KeyTemplate& (*key_template)()) {
+  auto streaming_aead_result = SharedPrimitive<StreamingAead>(key_template());
+  if (!streaming_aead_result.ok()) {
+    return SkipWithError(&state, streaming_aead_result.status());
+  }
+  StreamingAead* streaming_aead = streaming_aead_result.ValueOrDie();
+  std::string plaintext = Payload(state.range(0));
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto ciphertext = EncryptToString(streaming_aead, plaintext);
+      if (!ciphertext.ok()) return SkipWithError(&state, ciphertext.status());
+      benchmark::DoNotOptimize(ciphertext.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, plaintext.size());
+}
+
+void BM_StreamingAeadDecrypt(benchmark::State& state,
+                             const KeyTemplate& (*key_template)()) {
+  auto streaming_aead_result = SharedPrimitive<StreamingAead>(key_template());
+  if (!streaming_aead_result.ok()) {
+    return SkipWithError(&state, streaming_aead_result.status());
+  }
+  StreamingAead* streaming_aead = streaming_aead_result.ValueOrDie();
+  auto ciphertext_result =
+      EncryptToString(streaming_aead, Payload(state.range(0)));
+  if (!ciphertext_result.ok()) {
+    return SkipWithError(&state, ciphertext_result.status());
+  }
+  const std::string& ciphertext = ciphertext_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto decrypting_stream_result = streaming_aead->NewDecryptingStream(
+          absl::make_unique<IstreamInputStream>(
+              absl::make_unique<std::stringstream>(ciphertext)),
+          kAssociatedData);
+      if (!decrypting_stream_result.ok()) {
+        return SkipWithError(&state, decrypting_stream_result.status());
+      }
+      std::string plaintext;
+      util::Status status = ReadFromStream(
+          decrypting_stream_result.ValueOrDie().get(), &plaintext);
+      if (!status.ok()) return SkipWithError(&state, status);
+      benchmark::DoNotOptimize(plaintext);
+    }
+  }
+  SetThroughput(&state, state.range(0));
+}
+
+// Returns AES-CTR-HMAC-SHA256 streaming parameters with the given ciphertext
+// segment size.
+subtle::AesCtrHmacStreaming::Params SegmentParams(int ciphertext_segment_size) {
+  subtle::AesCtrHmacStreaming::Params params;
+  params.ikm = subtle::Random::GetRandomKeyBytes(32);
+  params.hkdf_algo = subtle::SHA256;
+  params.key_size = 16;
+  params.ciphertext_segment_size = ciphertext_segment_size;
+  params.ciphertext_offset = 0;
+  params.tag_algo = subtle::SHA256;
+  params.tag_size = 32;
+  return params;
+}
+
+// Measures the per-segment cost of the AES-CTR-HMAC segment encrypter, without
+// the stream and key derivation overhead.
+void BM_AesCtrHmacEncryptSegment(benchmark::State& state) {
+  auto encrypter_result = subtle::AesCtrHmacStreamSegmentEncrypter::New(
+      SegmentParams(state.range(0)), kAssociatedData);
+  if (!encrypter_result.ok()) {
+    return SkipWithError(&state, encrypter_result.status());
+  }
+  auto encrypter = std::move(encrypter_result.ValueOrDie());
+  std::vector<uint8_t> plaintext(encrypter->get_plaintext_segment_size(), 'p');
+  std::vector<uint8_t> ciphertext;
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      util::Status status =
+          encrypter->EncryptSegment(plaintext, false, &ciphertext);
+      if (!status.ok()) return SkipWithError(&state, status);
+      benchmark::DoNotOptimize(ciphertext.data());
+    }
+  }
+  SetThroughput(&state, plaintext.size());
+}
+
+void BM_AesCtrHmacDecryptSegment(benchmark::State& state) {
+  subtle::AesCtrHmacStreaming::Params params = SegmentParams(state.range(0));
+  auto encrypter_result =
+      subtle::AesCtrHmacStreamSegmentEncrypter::New(params, kAssociatedData);
+  auto decrypter_result =
+      subtle::AesCtrHmacStreamSegmentDecrypter::New(params, kAssociatedData);
+  if (!encrypter_result.ok()) {
+    return SkipWithError(&state, encrypter_result.status());
+  }
+  if (!decrypter_result.ok()) {
+    return SkipWithError(&state, decrypter_result.status());
+  }
+  auto encrypter = std::move(encrypter_result.ValueOrDie());
+  auto decrypter = std::move(decrypter_result.ValueOrDie());
+  util::Status status = decrypter->Init(encrypter->get_header());
+  if (!status.ok()) return SkipWithError(&state, status);
+  std::vector<uint8_t> plaintext(encrypter->get_plaintext_segment_size(), 'p');
+  std::vector<uint8_t> ciphertext;
+  status = encrypter->EncryptSegment(plaintext, false, &ciphertext);
+  if (!status.ok()) return SkipWithError(&state, status);
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      status = decrypter->DecryptSegment(ciphertext, 0, false, &plaintext);
+      if (!status.ok()) return SkipWithError(&state, status);
+      benchmark::DoNotOptimize(plaintext.data());
+    }
+  }
+  SetThroughput(&state, plaintext.size());
+}
+
+BENCHMARK(BM_AesCtrHmacEncryptSegment)->Arg(4 << 10)->Arg(64 << 10);
+BENCHMARK(BM_AesCtrHmacDecryptSegment)->Arg(4 << 10)->Arg(64 << 10);
+
+// Plaintext size of the segment size benchmarks, and the size of each PRead()
+// of their random access benchmarks.
+constexpr int64_t kStreamSize = 16 << 20;
+constexpr int kPReadSize = 64 << 10;
+
+util::StatusOr<std::unique_ptr<StreamingAead>> NewAesGcmHkdfStreaming(
+    int ciphertext_segment_size) {
+  subtle::AesGcmHkdfStreaming::Params params;
+  params.ikm = subtle::Random::GetRandomKeyBytes(32);
+  params.hkdf_hash = subtle::SHA256;
+  params.derived_key_size = 16;
+  params.ciphertext_segment_size = ciphertext_segment_size;
+  params.ciphertext_offset = 0;
+  auto streaming_result = subtle::AesGcmHkdfStreaming::New(std::move(params));
+  if (!streaming_result.ok()) return streaming_result.status();
+  return {std::move(streaming_result.ValueOrDie())};
+}
+
+util::StatusOr<std::unique_ptr<StreamingAead>> NewAesCtrHmacStreaming(
+    int ciphertext_segment_size) {
+  auto streaming_result = subtle::AesCtrHmacStreaming::New(
+      SegmentParams(ciphertext_segment_size));
+  if (!streaming_result.ok()) return streaming_result.status();
+  return {std::move(streaming_result.ValueOrDie())};
+}
+
+using StreamingAeadFactory =
+    util::StatusOr<std::unique_ptr<StreamingAead>> (*)(int);
+
+// A streaming AEAD with ciphertext segments of state.range(0) bytes, and
+// the ciphertext of kStreamSize bytes encrypted with it.
+struct SegmentSizeFixture {
+  std::unique_ptr<StreamingAead> streaming_aead;
+  std::string ciphertext;
+};
+
+util::StatusOr<SegmentSizeFixture> NewSegmentSizeFixture(
+    const benchmark::State& state, StreamingAeadFactory factory) {
+  auto streaming_aead_result = factory(state.range(0));
+  if (!streaming_aead_result.ok()) return streaming_aead_result.status();
+  SegmentSizeFixture fixture;
+  fixture.streaming_aead = std::move(streaming_aead_result.ValueOrDie());
+  auto ciphertext_result =
+      EncryptToString(fixture.streaming_aead.get(), Payload(kStreamSize));
+  if (!ciphertext_result.ok()) return ciphertext_result.status();
+  fixture.ciphertext = std::move(ciphertext_result.ValueOrDie());
+  return std::move(fixture);
+}
+
+void BM_SegmentSizeEncrypt(benchmark::State& state,
+                           StreamingAeadFactory factory) {
+  auto streaming_aead_result = factory(state.range(0));
+  if (!streaming_aead_result.ok()) {
+    return SkipWithError(&state, streaming_aead_result.status());
+  }
+  StreamingAead* streaming_aead = streaming_aead_result.ValueOrDie().get();
+  std::string plaintext = Payload(kStreamSize);
+
+  for (auto _ : state) {
+    auto ciphertext = EncryptToString(streaming_aead, plaintext);
+    if (!ciphertext.ok()) return SkipWithError(&state, ciphertext.status());
+    benchmark::DoNotOptimize(ciphertext.ValueOrDie());
+  }
+  SetThroughput(&state, kStreamSize);
+}
+
+// Decrypts the whole ciphertext through a decrypting InputStream.
+void BM_SegmentSizeDecrypt(benchmark::State& state,
+                           StreamingAeadFactory factory) {
+  auto fixture_result = NewSegmentSizeFixture(state, factory);
+  if (!fixture_result.ok()) {
+    return SkipWithError(&state, fixture_result.status());
+  }
+  const SegmentSizeFixture& fixture = fixture_result.ValueOrDie();
+
+  for (auto _ : state) {
+    auto decrypting_stream_result =
+        fixture.streaming_aead->NewDecryptingStream(
+            absl::make_unique<IstreamInputStream>(
+                absl::make_unique<std::stringstream>(fixture.ciphertext)),
+            kAssociatedData);
+    if (!decrypting_stream_result.ok()) {
+      return SkipWithError(&state, decrypting_stream_result.status());
+    }
+    std::string plaintext;
+    util::Status status = ReadFromStream(
+        decrypting_stream_result.ValueOrDie().get(), &plaintext);
+    if (!status.ok()) return SkipWithError(&state, status);
+    benchmark::DoNotOptimize(plaintext);
+  }
+  SetThroughput(&state, kStreamSize);
+}
+
+// Decrypts kStreamSize bytes through a decrypting RandomAccessStream, with
+// PRead() calls of kPReadSize bytes at 'positions'.
+void MeasurePRead(benchmark::State& state, StreamingAeadFactory factory,
+                  const std::vector<int64_t>& positions) {
+  auto fixture_result = NewSegmentSizeFixture(state, factory);
+  if (!fixture_result.ok()) {
+    return SkipWithError(&state, fixture_result.status());
+  }
+  const SegmentSizeFixture& fixture = fixture_result.ValueOrDie();
+  auto buffer_result = util::Buffer::New(kPReadSize);
+  if (!buffer_result.ok()) return SkipWithError(&state, buffer_result.status());
+  std::unique_ptr<util::Buffer> buffer = std::move(buffer_result.ValueOrDie());
+
+  for (auto _ : state) {
+    auto decrypting_stream_result =
+        fixture.streaming_aead->NewDecryptingRandomAccessStream(
+            absl::make_unique<StringRandomAccessStream>(fixture.ciphertext),
+            kAssociatedData);
+    if (!decrypting_stream_result.ok()) {
+      return SkipWithError(&state, decrypting_stream_result.status());
+    }
+    RandomAccessStream* decrypting_stream =
+        decrypting_stream_result.ValueOrDie().get();
+    for (int64_t position : positions) {
+      util::Status status =
+          decrypting_stream->PRead(position, kPReadSize, buffer.get());
+      if (!status.ok()) return SkipWithError(&state, status);
+    }
+    benchmark::DoNotOptimize(buffer->get_mem_block());
+  }
+  SetThroughput(&state, kStreamSize);
+}
+
+void BM_SegmentSizePReadSequential(benchmark::State& state,
+                                   StreamingAeadFactory factory) {
+  std::vector<int64_t> positions;
+  for (int64_t position = 0; position < kStreamSize; position += kPReadSize) {
+    positions.push_back(position);
+  }
+  MeasurePRead(state, factory, positions);
+}
+
+// Reads as many bytes as BM_SegmentSizePReadSequential, at random positions.
+void BM_SegmentSizePReadRandom(benchmark::State& state,
+                               StreamingAeadFactory factory) {
+  std::vector<int64_t> positions;
+  for (int64_t i = 0; i < kStreamSize / kPReadSize; ++i) {
+    positions.push_back(subtle::Random::GetRandomUInt32() %
+                        (kStreamSize - kPReadSize + 1));
+  }
+  MeasurePRead(state, factory, positions);
+}
+
+// Ciphertext segment sizes of 4 KiB to 4 MiB.
+void SegmentSizes(benchmark::internal::Benchmark* benchmark) {
+  benchmark->RangeMultiplier(4)->Range(4 << 10, 4 << 20);
+}
+
+#define TINK_SEGMENT_SIZE_BENCHMARK(factory)                         \
+  BENCHMARK_CAPTURE(BM_SegmentSizeEncrypt, factory, &factory)        \
+      ->Apply(SegmentSizes);                                         \
+  BENCHMARK_CAPTURE(BM_SegmentSizeDecrypt, factory, &factory)        \
+      ->Apply(SegmentSizes);                                         \
+  BENCHMARK_CAPTURE(BM_SegmentSizePReadSequential, factory, &factory) \
+      ->Apply(SegmentSizes);                                         \
+  BENCHMARK_CAPTURE(BM_SegmentSizePReadRandom, factory, &factory)    \
+      ->Apply(SegmentSizes)
+
+TINK_SEGMENT_SIZE_BENCHMARK(NewAesGcmHkdfStreaming);
+TINK_SEGMENT_SIZE_BENCHMARK(NewAesCtrHmacStreaming);
+
+// Decrypts a 64 KiB ciphertext through the StreamingAeadWrapper of a keyset
+// with state.range(0) keys. The wrapper tries the keys in keyset order, and
+// the ciphertext is encrypted with the last one, as with a keyset whose
+// newest key has just been made primary.
+void BM_WrapperDecrypt(benchmark::State& state) {
+  const KeyTemplate& key_template =
+      StreamingAeadKeyTemplates::Aes128GcmHkdf4KB();
+  util::Status status = TinkConfig::Register();
+  if (!status.ok()) return SkipWithError(&state, status);
+  auto manager_result = KeysetManager::New(key_template);
+  if (!manager_result.ok()) {
+    return SkipWithError(&state, manager_result.status());
+  }
+  KeysetManager& manager = *manager_result.ValueOrDie();
+  for (int64_t i = 1; i < state.range(0); ++i) {
+    auto add_result = manager.Add(key_template);
+    if (!add_result.ok()) return SkipWithError(&state, add_result.status());
+    status = manager.SetPrimary(add_result.ValueOrDie());
+    if (!status.ok()) return SkipWithError(&state, status);
+  }
+  auto streaming_aead_result =
+      manager.GetKeysetHandle()->GetPrimitive<StreamingAead>();
+  if (!streaming_aead_result.ok()) {
+    return SkipWithError(&state, streaming_aead_result.status());
+  }
+  StreamingAead* streaming_aead = streaming_aead_result.ValueOrDie().get();
+  auto ciphertext_result = EncryptToString(streaming_aead, Payload(64 << 10));
+  if (!ciphertext_result.ok()) {
+    return SkipWithError(&state, ciphertext_result.status());
+  }
+  const std::string& ciphertext = ciphertext_result.ValueOrDie();
+
+  for (auto _ : state) {
+    auto decrypting_stream_result = streaming_aead->NewDecryptingStream(
+        absl::make_unique<IstreamInputStream>(
+            absl::make_unique<std::stringstream>(ciphertext)),
+        kAssociatedData);
+    if (!decrypting_stream_result.ok()) {
+      return SkipWithError(&state, decrypting_stream_result.status());
+    }
+    std::string plaintext;
+    status = ReadFromStream(decrypting_stream_result.ValueOrDie().get(),
+                            &plaintext);
+    if (!status.ok()) return SkipWithError(&state, status);
+    benchmark::DoNotOptimize(plaintext);
+  }
+  SetThroughput(&state, 64 << 10);
+}
+
+// Keysets with 1, 10 and 100 keys.
+BENCHMARK(BM_WrapperDecrypt)->RangeMultiplier(10)->Range(1, 100);
+
+#define TINK_STREAMING_AEAD_BENCHMARK(template_name)                       \
+  BENCHMARK_CAPTURE(BM_StreamingAeadEncrypt, template_name,                \
+                    &StreamingAeadKeyTemplates::template_name)             \
+      ->Apply(PayloadSizesAndThreads);                                     \
+  BENCHMARK_CAPTURE(BM_StreamingAeadDecrypt, template_name,                \
+                    &StreamingAeadKeyTemplates::template_name)             \
+      ->Apply(PayloadSizesAndThreads)
+
+TINK_STREAMING_AEAD_BENCHMARK(Aes128GcmHkdf4KB);
+TINK_STREAMING_AEAD_BENCHMARK(Aes256GcmHkdf4KB);
+TINK_STREAMING_AEAD_BENCHMARK(Aes256GcmHkdf1MB);
+TINK_STREAMING_AEAD_BENCHMARK(Aes128CtrHmacSha256Segment4KB);
+TINK_STREAMING_AEAD_BENCHMARK(Aes256CtrHmacSha256Segment4KB);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
@@ -18,8 +18,10 @@
 #define TINK_BINARY_KEYSET_WRITER_H_
 
 #include <ostream>
+#include <string>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tink/keyset_writer.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
@@ -31,6 +33,9 @@ namespace tink {
 // A KeysetWriter that can write to some destination cleartext
 // or encrypted keysets in proto binary wire format, cf.
 // https://developers.google.com/protocol-buffers/docs/encoding
+//
+// Keysets are serialized into a buffer of their exact size, which is reused
+// by later writes, and written to the destination with a single write.
 class BinaryKeysetWriter : public KeysetWriter {
  public:
   static crypto::tink::util::StatusOr<std::unique_ptr<BinaryKeysetWriter>> New(
@@ -42,11 +47,22 @@ class BinaryKeysetWriter : public KeysetWriter {
   crypto::tink::util::Status
   Write(const google::crypto::tink::EncryptedKeyset& encrypted_keyset) override;
 
+  // Writes all of 'encrypted_keysets' with a single write, e.g. for backups.
+  // Each keyset is preceded by its size as a varint, as written by
+  // protobuf's SerializeDelimitedToOstream(), so that they can be read back
+  // one by one. The pointers must be non-null.
+  crypto::tink::util::Status WriteBatch(
+      absl::Span<const google::crypto::tink::EncryptedKeyset* const>
+          encrypted_keysets);
+
  private:
   explicit BinaryKeysetWriter(std::unique_ptr<std::ostream> destination_stream)
       : destination_stream_(std::move(destination_stream)) {}
 
   std::unique_ptr<std::ostream> destination_stream_;
+  // Holds the serialized keysets of the current write. Cleartext keysets are
+  // wiped from it after they have been written.
+  std::string buffer_;
 };
 
 }  // namespace tink
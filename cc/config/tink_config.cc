@@ -16,14 +16,53 @@
 
 #include "tink/config/tink_config.h"
 
+#include "absl/memory/memory.h"
+#include "tink/aead/aead_wrapper.h"
+#include "tink/aead/aes_ctr_hmac_aead_key_manager.h"
+#include "tink/aead/aes_eax_key_manager.h"
+#include "tink/aead/aes_gcm_key_manager.h"
+#include "tink/aead/aes_gcm_siv_key_manager.h"
+#include "tink/aead/kms_aead_key_manager.h"
+#include "tink/aead/kms_envelope_aead_key_manager.h"
+#include "tink/aead/xchacha20_poly1305_key_manager.h"
 #include "tink/config.h"
+#include "tink/config/tink_fips.h"
+#include "tink/daead/aes_siv_key_manager.h"
 #include "tink/daead/deterministic_aead_config.h"
+#include "tink/daead/deterministic_aead_wrapper.h"
+#include "tink/hybrid/ecies_aead_hkdf_private_key_manager.h"
+#include "tink/hybrid/ecies_aead_hkdf_public_key_manager.h"
 #include "tink/hybrid/hybrid_config.h"
+#include "tink/hybrid/hybrid_decrypt_wrapper.h"
+#include "tink/hybrid/hybrid_encrypt_wrapper.h"
+#include "tink/hybrid/streaming_hybrid_decrypt_wrapper.h"
+#include "tink/hybrid/streaming_hybrid_encrypt_wrapper.h"
 #include "tink/key_manager.h"
+#include "tink/mac/aes_cmac_key_manager.h"
+#include "tink/mac/hmac_key_manager.h"
+#include "tink/mac/mac_wrapper.h"
+#include "tink/prf/aes_cmac_prf_key_manager.h"
+#include "tink/prf/hkdf_prf_key_manager.h"
+#include "tink/prf/hmac_prf_key_manager.h"
 #include "tink/prf/prf_config.h"
+#include "tink/prf/prf_set_wrapper.h"
 #include "tink/registry.h"
+#include "tink/signature/ecdsa_sign_key_manager.h"
+#include "tink/signature/ecdsa_verify_key_manager.h"
+#include "tink/signature/ed25519_sign_key_manager.h"
+#include "tink/signature/ed25519_verify_key_manager.h"
+#include "tink/signature/public_key_sign_wrapper.h"
+#include "tink/signature/public_key_verify_wrapper.h"
+#include "tink/signature/rsa_ssa_pkcs1_sign_key_manager.h"
+#include "tink/signature/rsa_ssa_pkcs1_verify_key_manager.h"
+#include "tink/signature/rsa_ssa_pss_sign_key_manager.h"
+#include "tink/signature/rsa_ssa_pss_verify_key_manager.h"
 #include "tink/signature/signature_config.h"
+#include "tink/streamingaead/aes_ctr_hmac_streaming_key_manager.h"
+#include "tink/streamingaead/aes_gcm_hkdf_streaming_key_manager.h"
 #include "tink/streamingaead/streaming_aead_config.h"
+#include "tink/streamingaead/streaming_aead_wrapper.h"
+#include "tink/subtle/prf/streaming_prf_wrapper.h"
 #include "tink/util/status.h"
 #include "proto/config.pb.h"
 
@@ -51,5 +90,107 @@ util::Status TinkConfig::Register() {
   return StreamingAeadConfig::Register();
 }
 
+// static
+util::Status TinkConfig::RegisterLazily() {
+  // Registers the same wrappers and key managers as Register(). The
+  // wrappers are cheap, and needed to find primitives by type.
+  util::Status status =
+      Registry::RegisterPrimitiveWrapper(absl::make_unique<MacWrapper>());
+  if (!status.ok()) return status;
+  status = Registry::RegisterPrimitiveWrapper(absl::make_unique<AeadWrapper>());
+  if (!status.ok()) return status;
+  status = Registry::RegisterPrimitiveWrapper(
+      absl::make_unique<HybridEncryptWrapper>());
+  if (!status.ok()) return status;
+  status = Registry::RegisterPrimitiveWrapper(
+      absl::make_unique<HybridDecryptWrapper>());
+  if (!status.ok()) return status;
+  status = Registry::RegisterPrimitiveWrapper(
+      absl::make_unique<StreamingHybridEncryptWrapper>());
+  if (!status.ok()) return status;
+  status = Registry::RegisterPrimitiveWrapper(
+      absl::make_unique<StreamingHybridDecryptWrapper>());
+  if (!status.ok()) return status;
+  status = Registry::RegisterPrimitiveWrapper(
+      absl::make_unique<PrfSetWrapper>());
+  if (!status.ok()) return status;
+  status = Registry::RegisterPrimitiveWrapper(
+      absl::make_unique<StreamingPrfWrapper>());
+  if (!status.ok()) return status;
+  status = Registry::RegisterPrimitiveWrapper(
+      absl::make_unique<PublicKeySignWrapper>());
+  if (!status.ok()) return status;
+  status = Registry::RegisterPrimitiveWrapper(
+      absl::make_unique<PublicKeyVerifyWrapper>());
+  if (!status.ok()) return status;
+  status = Registry::RegisterPrimitiveWrapper(
+      absl::make_unique<StreamingAeadWrapper>());
+  if (!status.ok()) return status;
+
+  // Key managers which utilize the FIPS validated BoringCrypto
+  // implementations.
+  status = Registry::RegisterKeyTypeManagerLazily<HmacKeyManager>(true);
+  if (!status.ok()) return status;
+  status =
+      Registry::RegisterKeyTypeManagerLazily<AesCtrHmacAeadKeyManager>(true);
+  if (!status.ok()) return status;
+  status = Registry::RegisterKeyTypeManagerLazily<AesGcmKeyManager>(true);
+  if (!status.ok()) return status;
+  status = Registry::RegisterKeyTypeManagerLazily<HmacPrfKeyManager>(true);
+  if (!status.ok()) return status;
+  status = Registry::RegisterAsymmetricKeyManagersLazily<
+      EcdsaSignKeyManager, EcdsaVerifyKeyManager>(true);
+  if (!status.ok()) return status;
+  status = Registry::RegisterAsymmetricKeyManagersLazily<
+      RsaSsaPssSignKeyManager, RsaSsaPssVerifyKeyManager>(true);
+  if (!status.ok()) return status;
+  status = Registry::RegisterAsymmetricKeyManagersLazily<
+      RsaSsaPkcs1SignKeyManager, RsaSsaPkcs1VerifyKeyManager>(true);
+  if (!status.ok()) return status;
+
+  if (kUseOnlyFips) {
+    return util::OkStatus();
+  }
+
+  status = Registry::RegisterPrimitiveWrapper(
+      absl::make_unique<DeterministicAeadWrapper>());
+  if (!status.ok()) return status;
+
+  // All the other key managers.
+  status = Registry::RegisterKeyTypeManagerLazily<AesCmacKeyManager>(true);
+  if (!status.ok()) return status;
+  status = Registry::RegisterKeyTypeManagerLazily<AesGcmSivKeyManager>(true);
+  if (!status.ok()) return status;
+  status = Registry::RegisterKeyTypeManagerLazily<AesEaxKeyManager>(true);
+  if (!status.ok()) return status;
+  status = Registry::RegisterKeyTypeManagerLazily<XChaCha20Poly1305KeyManager>(
+      true);
+  if (!status.ok()) return status;
+  status = Registry::RegisterKeyTypeManagerLazily<KmsAeadKeyManager>(true);
+  if (!status.ok()) return status;
+  status =
+      Registry::RegisterKeyTypeManagerLazily<KmsEnvelopeAeadKeyManager>(true);
+  if (!status.ok()) return status;
+  status = Registry::RegisterKeyTypeManagerLazily<AesSivKeyManager>(true);
+  if (!status.ok()) return status;
+  status = Registry::RegisterKeyTypeManagerLazily<HkdfPrfKeyManager>(true);
+  if (!status.ok()) return status;
+  status = Registry::RegisterKeyTypeManagerLazily<AesCmacPrfKeyManager>(true);
+  if (!status.ok()) return status;
+  status = Registry::RegisterAsymmetricKeyManagersLazily<
+      Ed25519SignKeyManager, Ed25519VerifyKeyManager>(true);
+  if (!status.ok()) return status;
+  status =
+      Registry::RegisterKeyTypeManagerLazily<AesGcmHkdfStreamingKeyManager>(
+          true);
+  if (!status.ok()) return status;
+  status =
+      Registry::RegisterKeyTypeManagerLazily<AesCtrHmacStreamingKeyManager>(
+          true);
+  if (!status.ok()) return status;
+  return Registry::RegisterAsymmetricKeyManagersLazily<
+      EciesAeadHkdfPrivateKeyManager, EciesAeadHkdfPublicKeyManager>(true);
+}
+
 }  // namespace tink
 }  // namespace crypto
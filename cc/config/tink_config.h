@@ -43,6 +43,12 @@ class TinkConfig {
   // supported in the current Tink release.
   static crypto::tink::util::Status Register();
 
+  // Same as Register(), but only the primitive wrappers are registered
+  // right away. Each key manager is created and registered when its key type
+  // is first used, see Registry::RegisterKeyTypeManagerLazily(). This makes
+  // registration cheaper for short-lived processes which use few key types.
+  static crypto::tink::util::Status RegisterLazily();
+
  private:
   TinkConfig() {}
 };
@@ -27,6 +27,8 @@
 #include "tink/public_key_sign.h"
 #include "tink/public_key_verify.h"
 #include "tink/registry.h"
+#include "tink/signature/ecdsa_sign_key_manager.h"
+#include "tink/signature/ecdsa_verify_key_manager.h"
 #include "tink/streaming_aead.h"
 #include "tink/util/status.h"
 #include "tink/util/test_matchers.h"
@@ -48,6 +50,26 @@ TEST(TinkConfigTest, RegisterWorks) {
               IsOk());
 }
 
+TEST(TinkConfigTest, RegisterLazilyWorks) {
+  Registry::Reset();
+  EXPECT_THAT(TinkConfig::RegisterLazily(), IsOk());
+  EXPECT_THAT(Registry::get_key_manager<Aead>(AesGcmKeyManager().get_key_type())
+                  .status(),
+              IsOk());
+  // Either key type of an asymmetric pair registers both key managers.
+  EXPECT_THAT(Registry::get_key_manager<PublicKeyVerify>(
+                  EcdsaVerifyKeyManager().get_key_type())
+                  .status(),
+              IsOk());
+  EXPECT_THAT(Registry::get_key_manager<PublicKeySign>(
+                  EcdsaSignKeyManager().get_key_type())
+                  .status(),
+              IsOk());
+  // Registering eagerly as well is fine.
+  EXPECT_THAT(TinkConfig::Register(), IsOk());
+  Registry::Reset();
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
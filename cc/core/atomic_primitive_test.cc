@@ -0,0 +1,164 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/atomic_primitive.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/config/tink_config.h"
+#include "tink/keyset_handle.h"
+#include "tink/keyset_manager.h"
+#include "tink/mac/mac_key_templates.h"
+#include "tink/util/test_matchers.h"
+#include "proto/tink.pb.h"
+
+using ::crypto::tink::test::IsOk;
+using ::google::crypto::tink::KeyTemplate;
+
+namespace crypto {
+namespace tink {
+namespace {
+
+class AtomicPrimitiveTest : public ::testing::Test {
+ protected:
+  void SetUp() override { ASSERT_THAT(TinkConfig::Register(), IsOk()); }
+};
+
+std::unique_ptr<KeysetManager> NewKeysetManager(
+    const KeyTemplate& key_template) {
+  auto manager_result = KeysetManager::New(key_template);
+  EXPECT_THAT(manager_result.status(), IsOk());
+  return std::move(manager_result.ValueOrDie());
+}
+
+TEST_F(AtomicPrimitiveTest, UpdateReusesUnchangedKeys) {
+  auto manager = NewKeysetManager(AeadKeyTemplates::Aes128Gcm());
+  auto new_result = AtomicPrimitive<Aead>::New(*manager->GetKeysetHandle());
+  ASSERT_THAT(new_result.status(), IsOk());
+  std::unique_ptr<AtomicPrimitive<Aead>> atomic_aead =
+      std::move(new_result.ValueOrDie());
+  std::shared_ptr<Aead> old_aead = atomic_aead->Get();
+  std::string old_ciphertext =
+      old_aead->Encrypt("plaintext", "aad").ValueOrDie();
+
+  // Rotating to a new primary key only creates the primitive of that key.
+  ASSERT_THAT(manager->Rotate(AeadKeyTemplates::Aes256Gcm()).status(), IsOk());
+  auto update_result = atomic_aead->Update(*manager->GetKeysetHandle());
+  ASSERT_THAT(update_result.status(), IsOk());
+  EXPECT_EQ(1, update_result.ValueOrDie().created);
+  EXPECT_EQ(1, update_result.ValueOrDie().reused);
+
+  std::shared_ptr<Aead> new_aead = atomic_aead->Get();
+  EXPECT_NE(old_aead, new_aead);
+  EXPECT_EQ("plaintext", new_aead->Decrypt(old_ciphertext, "aad").ValueOrDie());
+  std::string new_ciphertext =
+      new_aead->Encrypt("plaintext", "aad").ValueOrDie();
+  EXPECT_FALSE(old_aead->Decrypt(new_ciphertext, "aad").ok());
+
+  // Primitives obtained before an update keep working.
+  EXPECT_EQ("plaintext", old_aead->Decrypt(old_ciphertext, "aad").ValueOrDie());
+
+  // Updating to the same keyset creates nothing.
+  update_result = atomic_aead->Update(*manager->GetKeysetHandle());
+  ASSERT_THAT(update_result.status(), IsOk());
+  EXPECT_EQ(0, update_result.ValueOrDie().created);
+  EXPECT_EQ(2, update_result.ValueOrDie().reused);
+}
+
+TEST_F(AtomicPrimitiveTest, DisabledKeysAreDropped) {
+  auto manager = NewKeysetManager(AeadKeyTemplates::Aes128Gcm());
+  uint32_t old_key_id =
+      manager->GetKeysetHandle()->GetKeysetInfo().primary_key_id();
+  auto atomic_aead =
+      std::move(AtomicPrimitive<Aead>::New(*manager->GetKeysetHandle())
+                    .ValueOrDie());
+  std::string old_ciphertext =
+      atomic_aead->Get()->Encrypt("plaintext", "aad").ValueOrDie();
+
+  ASSERT_THAT(manager->Rotate(AeadKeyTemplates::Aes128Gcm()).status(), IsOk());
+  ASSERT_THAT(manager->Disable(old_key_id), IsOk());
+  auto update_result = atomic_aead->Update(*manager->GetKeysetHandle());
+  ASSERT_THAT(update_result.status(), IsOk());
+  EXPECT_EQ(1, update_result.ValueOrDie().created);
+  EXPECT_EQ(0, update_result.ValueOrDie().reused);
+  EXPECT_FALSE(atomic_aead->Get()->Decrypt(old_ciphertext, "aad").ok());
+
+  // Enabling the key again creates its primitive again.
+  ASSERT_THAT(manager->Enable(old_key_id), IsOk());
+  update_result = atomic_aead->Update(*manager->GetKeysetHandle());
+  ASSERT_THAT(update_result.status(), IsOk());
+  EXPECT_EQ(1, update_result.ValueOrDie().created);
+  EXPECT_EQ(1, update_result.ValueOrDie().reused);
+  EXPECT_EQ("plaintext",
+            atomic_aead->Get()->Decrypt(old_ciphertext, "aad").ValueOrDie());
+}
+
+TEST_F(AtomicPrimitiveTest, FailedUpdateKeepsThePrimitive) {
+  auto manager = NewKeysetManager(AeadKeyTemplates::Aes128Gcm());
+  auto atomic_aead =
+      std::move(AtomicPrimitive<Aead>::New(*manager->GetKeysetHandle())
+                    .ValueOrDie());
+  std::shared_ptr<Aead> aead = atomic_aead->Get();
+
+  // The keys of a MAC keyset have no AEAD primitive.
+  auto mac_manager = NewKeysetManager(MacKeyTemplates::HmacSha256());
+  EXPECT_FALSE(atomic_aead->Update(*mac_manager->GetKeysetHandle()).ok());
+  EXPECT_EQ(aead, atomic_aead->Get());
+}
+
+TEST_F(AtomicPrimitiveTest, ConcurrentGetAndUpdate) {
+  auto manager = NewKeysetManager(AeadKeyTemplates::Aes128Gcm());
+  auto atomic_aead =
+      std::move(AtomicPrimitive<Aead>::New(*manager->GetKeysetHandle())
+                    .ValueOrDie());
+  std::string ciphertext =
+      atomic_aead->Get()->Encrypt("plaintext", "aad").ValueOrDie();
+  std::atomic<bool> done(false);
+  std::thread updater([&manager, &atomic_aead, &done]() {
+    for (int i = 0; i < 20; i++) {
+      EXPECT_THAT(manager->Rotate(AeadKeyTemplates::Aes128Gcm()).status(),
+                  IsOk());
+      EXPECT_THAT(atomic_aead->Update(*manager->GetKeysetHandle()).status(),
+                  IsOk());
+    }
+    done = true;
+  });
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&atomic_aead, &done, &ciphertext]() {
+      while (!done) {
+        std::shared_ptr<Aead> aead = atomic_aead->Get();
+        auto decrypt_result = aead->Decrypt(ciphertext, "aad");
+        ASSERT_THAT(decrypt_result.status(), IsOk());
+        EXPECT_EQ("plaintext", decrypt_result.ValueOrDie());
+      }
+    });
+  }
+  updater.join();
+  for (auto& reader : readers) reader.join();
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -16,12 +16,16 @@
 
 #include "tink/binary_keyset_writer.h"
 
+#include <cstdint>
 #include <ostream>
 #include <istream>
 #include <sstream>
 
+#include "absl/types/span.h"
+#include "tink/subtle/subtle_util.h"
 #include "tink/util/errors.h"
 #include "tink/util/protobuf_helper.h"
+#include "tink/util/secret_data.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "proto/tink.pb.h"
@@ -35,10 +39,33 @@ namespace tink {
 
 namespace {
 
-util::Status WriteProto(const portable_proto::MessageLite& proto,
-                        std::ostream* destination) {
-  std::string serialized_proto;
-  (*destination) << proto.SerializeAsString();
+// Serializes 'proto', whose size must have been computed with ByteSizeLong(),
+// to 'buffer' and returns the position after it.
+char* SerializeProto(const portable_proto::MessageLite& proto, char* buffer) {
+  return reinterpret_cast<char*>(proto.SerializeWithCachedSizesToArray(
+      reinterpret_cast<uint8_t*>(buffer)));
+}
+
+size_t VarintSize(uint64_t value) {
+  size_t size = 1;
+  while (value >= 0x80) {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+char* WriteVarint(uint64_t value, char* buffer) {
+  while (value >= 0x80) {
+    *buffer++ = static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  *buffer++ = static_cast<char>(value);
+  return buffer;
+}
+
+util::Status WriteBuffer(absl::string_view buffer, std::ostream* destination) {
+  destination->write(buffer.data(), buffer.size());
   if (destination->fail()) {
     return util::Status(util::error::UNKNOWN,
                         "Error writing to the destination stream.");
@@ -46,6 +73,14 @@ util::Status WriteProto(const portable_proto::MessageLite& proto,
   return util::Status::OK;
 }
 
+util::Status WriteProto(const portable_proto::MessageLite& proto,
+                        std::string* buffer, std::ostream* destination) {
+  size_t size = proto.ByteSizeLong();
+  subtle::ResizeStringUninitialized(buffer, size);
+  if (size > 0) SerializeProto(proto, &(*buffer)[0]);
+  return WriteBuffer(*buffer, destination);
+}
+
 }  // anonymous namespace
 
 
@@ -62,12 +97,37 @@ util::StatusOr<std::unique_ptr<BinaryKeysetWriter>> BinaryKeysetWriter::New(
 }
 
 util::Status BinaryKeysetWriter::Write(const Keyset& keyset) {
-  return WriteProto(keyset, destination_stream_.get());
+  util::Status status =
+      WriteProto(keyset, &buffer_, destination_stream_.get());
+  util::SafeZeroMemory(&buffer_[0], buffer_.size());
+  return status;
 }
 
 util::Status BinaryKeysetWriter::Write(
     const EncryptedKeyset& encrypted_keyset) {
-  return WriteProto(encrypted_keyset, destination_stream_.get());
+  return WriteProto(encrypted_keyset, &buffer_, destination_stream_.get());
+}
+
+util::Status BinaryKeysetWriter::WriteBatch(
+    absl::Span<const EncryptedKeyset* const> encrypted_keysets) {
+  size_t total_size = 0;
+  for (const EncryptedKeyset* encrypted_keyset : encrypted_keysets) {
+    if (encrypted_keyset == nullptr) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "encrypted keysets must be non-null.");
+    }
+    size_t size = encrypted_keyset->ByteSizeLong();
+    total_size += VarintSize(size) + size;
+  }
+  subtle::ResizeStringUninitialized(&buffer_, total_size);
+  char* position = &buffer_[0];
+  for (const EncryptedKeyset* encrypted_keyset : encrypted_keysets) {
+    // ByteSizeLong() above cached the size.
+    size_t size = encrypted_keyset->GetCachedSize();
+    position = WriteVarint(size, position);
+    position = SerializeProto(*encrypted_keyset, position);
+  }
+  return WriteBuffer(buffer_, destination_stream_.get());
 }
 
 }  // namespace tink
@@ -18,7 +18,11 @@
 
 #include <ostream>
 #include <sstream>
+#include <string>
+#include <vector>
 
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 #include "tink/util/test_util.h"
 #include "gtest/gtest.h"
 #include "proto/tink.pb.h"
@@ -87,6 +91,11 @@ TEST_F(BinaryKeysetWriterTest, testWriteKeyset) {
   auto status = writer->Write(keyset_);
   EXPECT_TRUE(status.ok()) << status;
   EXPECT_EQ(binary_keyset_, buffer.str());
+
+  // The buffer of the writer is reused.
+  status = writer->Write(keyset_);
+  EXPECT_TRUE(status.ok()) << status;
+  EXPECT_EQ(binary_keyset_ + binary_keyset_, buffer.str());
 }
 
 TEST_F(BinaryKeysetWriterTest, testWriteEncryptedKeyset) {
@@ -100,6 +109,38 @@ TEST_F(BinaryKeysetWriterTest, testWriteEncryptedKeyset) {
   EXPECT_EQ(binary_encrypted_keyset_, buffer.str());
 }
 
+TEST_F(BinaryKeysetWriterTest, WriteBatch) {
+  std::stringbuf buffer;
+  std::unique_ptr<std::ostream> destination_stream(new std::ostream(&buffer));
+  auto writer_result = BinaryKeysetWriter::New(std::move(destination_stream));
+  ASSERT_TRUE(writer_result.ok()) << writer_result.status();
+  auto writer = std::move(writer_result.ValueOrDie());
+  EncryptedKeyset other_keyset;
+  other_keyset.set_encrypted_keyset(std::string(300, 'x'));
+  std::vector<const EncryptedKeyset*> keysets = {&encrypted_keyset_,
+                                                 &other_keyset};
+  auto status = writer->WriteBatch(keysets);
+  EXPECT_TRUE(status.ok()) << status;
+
+  // The keysets are length-delimited.
+  std::string written = buffer.str();
+  google::protobuf::io::ArrayInputStream array_stream(written.data(),
+                                                      written.size());
+  google::protobuf::io::CodedInputStream input(&array_stream);
+  for (const EncryptedKeyset* keyset : keysets) {
+    uint32_t size;
+    ASSERT_TRUE(input.ReadVarint32(&size));
+    std::string serialized;
+    ASSERT_TRUE(input.ReadString(&serialized, size));
+    EXPECT_EQ(keyset->SerializeAsString(), serialized);
+  }
+  EXPECT_EQ(written.size(), input.CurrentPosition());
+
+  keysets.push_back(nullptr);
+  EXPECT_EQ(util::error::INVALID_ARGUMENT,
+            writer->WriteBatch(keysets).error_code());
+}
+
 TEST_F(BinaryKeysetWriterTest, testDestinationStreamErrors) {
   std::stringbuf buffer;
   std::unique_ptr<std::ostream> destination_stream(new std::ostream(&buffer));
@@ -117,6 +158,11 @@ TEST_F(BinaryKeysetWriterTest, testDestinationStreamErrors) {
     EXPECT_FALSE(status.ok()) << status;
     EXPECT_EQ(util::error::UNKNOWN, status.error_code());
   }
+  {  // Write a batch.
+    auto status = writer->WriteBatch({&encrypted_keyset_});
+    EXPECT_FALSE(status.ok()) << status;
+    EXPECT_EQ(util::error::UNKNOWN, status.error_code());
+  }
 }
 
 }  // namespace
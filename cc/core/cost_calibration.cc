@@ -0,0 +1,324 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/cost_calibration.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "tink/keyset_handle.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+using ::google::crypto::tink::KeyTemplate;
+
+namespace {
+
+constexpr absl::string_view kAssociatedData = "Tink calibration context";
+
+using ProduceFunction =
+    std::function<util::StatusOr<std::string>(absl::string_view payload)>;
+using ConsumeFunction = std::function<util::Status(absl::string_view output,
+                                                   absl::string_view payload)>;
+
+util::Status ValidateOptions(const CostCalibrationOptions& options) {
+  if (options.small_size < 0 || options.small_size >= options.large_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "payload sizes must satisfy 0 <= small < large");
+  }
+  if (options.min_time <= absl::ZeroDuration()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "min_time must be positive");
+  }
+  return util::OkStatus();
+}
+
+// Returns the mean time of 'operation' in nanoseconds, running it back to back
+// until that takes at least 'min_time'. Like Google Benchmark, the number of
+// iterations is grown from the time the previous run took.
+util::StatusOr<double> MeanNanos(const std::function<util::Status()>& operation,
+                                 absl::Duration min_time) {
+  // The first call pays for lazy initialization, and is not counted.
+  util::Status status = operation();
+  if (!status.ok()) return status;
+  int64_t iterations = 1;
+  while (true) {
+    auto start = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < iterations; i++) {
+      status = operation();
+      if (!status.ok()) return status;
+    }
+    absl::Duration elapsed =
+        absl::FromChrono(std::chrono::steady_clock::now() - start);
+    if (elapsed >= min_time) {
+      return absl::ToDoubleNanoseconds(elapsed) / iterations;
+    }
+    double growth = elapsed > absl::ZeroDuration()
+                        ? 1.4 * absl::FDivDuration(min_time, elapsed)
+                        : 10.0;
+    iterations = std::max(iterations + 1,
+                          static_cast<int64_t>(iterations *
+                                               std::min(growth, 10.0)));
+  }
+}
+
+// Fits the cost model to the mean times on the two payload sizes. Noise can
+// make the larger payload look cheaper, hence the clamping.
+OperationCost Fit(double small_nanos, double large_nanos,
+                  const CostCalibrationOptions& options) {
+  OperationCost cost;
+  cost.nanos_per_byte =
+      std::max(0.0, (large_nanos - small_nanos) /
+                        (options.large_size - options.small_size));
+  cost.nanos_per_call =
+      std::max(0.0, small_nanos - cost.nanos_per_byte * options.small_size);
+  return cost;
+}
+
+// Measures 'produce' and 'consume', which is given the outputs of 'produce'.
+util::StatusOr<PrimitiveCost> Calibrate(const ProduceFunction& produce,
+                                        const ConsumeFunction& consume,
+                                        const CostCalibrationOptions& options) {
+  util::Status status = ValidateOptions(options);
+  if (!status.ok()) return status;
+  double produce_nanos[2];
+  double consume_nanos[2];
+  const int64_t sizes[2] = {options.small_size, options.large_size};
+  for (int i = 0; i < 2; i++) {
+    const std::string payload(sizes[i], 'x');
+    std::string output;
+    auto produce_result = MeanNanos(
+        [&produce, &payload, &output]() -> util::Status {
+          auto output_result = produce(payload);
+          if (!output_result.ok()) return output_result.status();
+          output = std::move(output_result.ValueOrDie());
+          return util::OkStatus();
+        },
+        options.min_time);
+    if (!produce_result.ok()) return produce_result.status();
+    produce_nanos[i] = produce_result.ValueOrDie();
+
+    auto consume_result = MeanNanos(
+        [&consume, &payload, &output]() { return consume(output, payload); },
+        options.min_time);
+    if (!consume_result.ok()) return consume_result.status();
+    consume_nanos[i] = consume_result.ValueOrDie();
+  }
+  PrimitiveCost cost;
+  cost.produce = Fit(produce_nanos[0], produce_nanos[1], options);
+  cost.consume = Fit(consume_nanos[0], consume_nanos[1], options);
+  return cost;
+}
+
+// Returns the status of the result of an operation returning its payload,
+// which is dropped.
+template <class T>
+util::Status StatusOf(const util::StatusOr<T>& result) {
+  return result.status();
+}
+
+// Creates the primitive of 'keyset_handle' and calibrates it, or returns
+// UNIMPLEMENTED if the keys are not of a key type of primitive P.
+template <class P>
+util::StatusOr<PrimitiveCost> CalibrateKeyset(
+    const KeysetHandle& keyset_handle, const CostCalibrationOptions& options) {
+  auto primitive_result = keyset_handle.GetPrimitive<P>();
+  if (!primitive_result.ok()) {
+    return util::Status(util::error::UNIMPLEMENTED,
+                        primitive_result.status().error_message());
+  }
+  return CalibrateCost(*primitive_result.ValueOrDie(), options);
+}
+
+// Orders the primitives of a key pair as CalibrateCost() takes them.
+util::StatusOr<PrimitiveCost> CalibratePair(
+    const PublicKeySign& sign, const PublicKeyVerify& verify,
+    const CostCalibrationOptions& options) {
+  return CalibrateCost(sign, verify, options);
+}
+
+util::StatusOr<PrimitiveCost> CalibratePair(
+    const HybridDecrypt& decrypt, const HybridEncrypt& encrypt,
+    const CostCalibrationOptions& options) {
+  return CalibrateCost(encrypt, decrypt, options);
+}
+
+// As CalibrateKeyset(), for the primitives of key pairs. 'P' is that of the
+// private key, 'Q' that of the public key.
+template <class P, class Q>
+util::StatusOr<PrimitiveCost> CalibrateKeyPair(
+    const KeysetHandle& keyset_handle, const CostCalibrationOptions& options) {
+  auto private_result = keyset_handle.GetPrimitive<P>();
+  if (!private_result.ok()) {
+    return util::Status(util::error::UNIMPLEMENTED,
+                        private_result.status().error_message());
+  }
+  auto public_handle_result = keyset_handle.GetPublicKeysetHandle();
+  if (!public_handle_result.ok()) return public_handle_result.status();
+  auto public_result = public_handle_result.ValueOrDie()->GetPrimitive<Q>();
+  if (!public_result.ok()) return public_result.status();
+  return CalibratePair(*private_result.ValueOrDie(),
+                       *public_result.ValueOrDie(), options);
+}
+
+}  // namespace
+
+absl::Duration OperationCost::Estimate(int64_t payload_size) const {
+  return absl::Nanoseconds(nanos_per_call + nanos_per_byte * payload_size);
+}
+
+util::StatusOr<PrimitiveCost> CalibrateCost(
+    const Aead& primitive, const CostCalibrationOptions& options) {
+  return Calibrate(
+      [&primitive](absl::string_view payload) {
+        return primitive.Encrypt(payload, kAssociatedData);
+      },
+      [&primitive](absl::string_view output, absl::string_view payload) {
+        return StatusOf(primitive.Decrypt(output, kAssociatedData));
+      },
+      options);
+}
+
+util::StatusOr<PrimitiveCost> CalibrateCost(
+    const DeterministicAead& primitive, const CostCalibrationOptions& options) {
+  return Calibrate(
+      [&primitive](absl::string_view payload) {
+        return primitive.EncryptDeterministically(payload, kAssociatedData);
+      },
+      [&primitive](absl::string_view output, absl::string_view payload) {
+        return StatusOf(
+            primitive.DecryptDeterministically(output, kAssociatedData));
+      },
+      options);
+}
+
+util::StatusOr<PrimitiveCost> CalibrateCost(
+    const Mac& primitive, const CostCalibrationOptions& options) {
+  return Calibrate(
+      [&primitive](absl::string_view payload) {
+        return primitive.ComputeMac(payload);
+      },
+      [&primitive](absl::string_view output, absl::string_view payload) {
+        return primitive.VerifyMac(output, payload);
+      },
+      options);
+}
+
+util::StatusOr<PrimitiveCost> CalibrateCost(
+    const PublicKeySign& sign, const PublicKeyVerify& verify,
+    const CostCalibrationOptions& options) {
+  return Calibrate(
+      [&sign](absl::string_view payload) { return sign.Sign(payload); },
+      [&verify](absl::string_view output, absl::string_view payload) {
+        return verify.Verify(output, payload);
+      },
+      options);
+}
+
+util::StatusOr<PrimitiveCost> CalibrateCost(
+    const HybridEncrypt& encrypt, const HybridDecrypt& decrypt,
+    const CostCalibrationOptions& options) {
+  return Calibrate(
+      [&encrypt](absl::string_view payload) {
+        return encrypt.Encrypt(payload, kAssociatedData);
+      },
+      [&decrypt](absl::string_view output, absl::string_view payload) {
+        return StatusOf(decrypt.Decrypt(output, kAssociatedData));
+      },
+      options);
+}
+
+CostCatalog& CostCatalog::Global() {
+  static CostCatalog* catalog = new CostCatalog();
+  return *catalog;
+}
+
+util::StatusOr<PrimitiveCost> CostCatalog::Calibrate(
+    const KeyTemplate& key_template, const CostCalibrationOptions& options) {
+  auto handle_result = KeysetHandle::GenerateNew(key_template);
+  if (!handle_result.ok()) return handle_result.status();
+  const KeysetHandle& handle = *handle_result.ValueOrDie();
+
+  // The key type is that of the first primitive the handle can create.
+  using CalibrateFunction = util::StatusOr<PrimitiveCost> (*)(
+      const KeysetHandle&, const CostCalibrationOptions&);
+  static const CalibrateFunction kCalibrateFunctions[] = {
+      &CalibrateKeyset<Aead>,
+      &CalibrateKeyset<DeterministicAead>,
+      &CalibrateKeyset<Mac>,
+      &CalibrateKeyPair<PublicKeySign, PublicKeyVerify>,
+      &CalibrateKeyPair<HybridDecrypt, HybridEncrypt>,
+  };
+  for (CalibrateFunction calibrate : kCalibrateFunctions) {
+    auto cost_result = calibrate(handle, options);
+    if (!cost_result.ok() &&
+        cost_result.status().error_code() == util::error::UNIMPLEMENTED) {
+      continue;
+    }
+    if (!cost_result.ok()) return cost_result.status();
+    absl::MutexLock lock(&mutex_);
+    costs_[key_template.type_url()] = cost_result.ValueOrDie();
+    return cost_result;
+  }
+  return util::Status(
+      util::error::UNIMPLEMENTED,
+      absl::StrCat("No cost calibration for key type ",
+                   key_template.type_url()));
+}
+
+util::Status CostCatalog::CalibrateAll(
+    const std::vector<KeyTemplate>& key_templates,
+    const CostCalibrationOptions& options) {
+  for (const KeyTemplate& key_template : key_templates) {
+    auto cost_result = Calibrate(key_template, options);
+    if (!cost_result.ok()) return cost_result.status();
+  }
+  return util::OkStatus();
+}
+
+util::StatusOr<PrimitiveCost> CostCatalog::Get(
+    absl::string_view type_url) const {
+  absl::MutexLock lock(&mutex_);
+  auto it = costs_.find(type_url);
+  if (it == costs_.end()) {
+    return util::Status(
+        util::error::NOT_FOUND,
+        absl::StrCat("No costs recorded for key type ", type_url));
+  }
+  return it->second;
+}
+
+absl::flat_hash_map<std::string, PrimitiveCost> CostCatalog::GetAll() const {
+  absl::MutexLock lock(&mutex_);
+  return costs_;
+}
+
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,154 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/cost_calibration.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_config.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/mac/mac_config.h"
+#include "tink/mac/mac_key_templates.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+#include "proto/tink.pb.h"
+
+using ::crypto::tink::test::DummyAead;
+using ::crypto::tink::test::DummyMac;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::google::crypto::tink::KeyTemplate;
+
+namespace crypto {
+namespace tink {
+namespace {
+
+CostCalibrationOptions FastOptions() {
+  CostCalibrationOptions options;
+  options.small_size = 0;
+  options.large_size = 1000;
+  options.min_time = absl::Milliseconds(5);
+  return options;
+}
+
+// A DummyAead whose encryption takes 1 microsecond per byte.
+class SlowAead : public DummyAead {
+ public:
+  SlowAead() : DummyAead("slow") {}
+
+  util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view associated_data) const override {
+    auto end = std::chrono::steady_clock::now() +
+               std::chrono::microseconds(plaintext.size());
+    while (std::chrono::steady_clock::now() < end) {
+    }
+    return DummyAead::Encrypt(plaintext, associated_data);
+  }
+};
+
+// An Aead whose ciphertexts cannot be decrypted.
+class BrokenAead : public DummyAead {
+ public:
+  BrokenAead() : DummyAead("broken") {}
+
+  util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view associated_data) const override {
+    return util::Status(util::error::INVALID_ARGUMENT, "decryption failed");
+  }
+};
+
+TEST(CostCalibrationTest, FitsCostPerByte) {
+  auto cost_result = CalibrateCost(SlowAead(), FastOptions());
+  ASSERT_THAT(cost_result.status(), IsOk());
+  const PrimitiveCost& cost = cost_result.ValueOrDie();
+  EXPECT_NEAR(1000, cost.produce.nanos_per_byte, 250);
+  EXPECT_GE(cost.produce.nanos_per_call, 0);
+  EXPECT_LT(cost.consume.nanos_per_byte, cost.produce.nanos_per_byte);
+  EXPECT_GE(cost.produce.Estimate(2000), absl::Microseconds(1500));
+}
+
+TEST(CostCalibrationTest, EstimateIsLinear) {
+  OperationCost cost;
+  cost.nanos_per_call = 500;
+  cost.nanos_per_byte = 0.5;
+  EXPECT_EQ(absl::Nanoseconds(500), cost.Estimate(0));
+  EXPECT_EQ(absl::Nanoseconds(1000), cost.Estimate(1000));
+}
+
+TEST(CostCalibrationTest, MacCostsAreNonNegative) {
+  auto cost_result = CalibrateCost(DummyMac("mac"), FastOptions());
+  ASSERT_THAT(cost_result.status(), IsOk());
+  EXPECT_GE(cost_result.ValueOrDie().produce.nanos_per_call, 0);
+  EXPECT_GE(cost_result.ValueOrDie().produce.nanos_per_byte, 0);
+  EXPECT_GE(cost_result.ValueOrDie().consume.nanos_per_call, 0);
+  EXPECT_GE(cost_result.ValueOrDie().consume.nanos_per_byte, 0);
+}
+
+TEST(CostCalibrationTest, FailsIfOutputsCannotBeConsumed) {
+  EXPECT_THAT(CalibrateCost(BrokenAead(), FastOptions()).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(CostCalibrationTest, InvalidOptions) {
+  CostCalibrationOptions options = FastOptions();
+  options.small_size = options.large_size;
+  EXPECT_THAT(CalibrateCost(DummyAead("aead"), options).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  options = FastOptions();
+  options.min_time = absl::ZeroDuration();
+  EXPECT_THAT(CalibrateCost(DummyAead("aead"), options).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(CostCatalogTest, RecordsCostsByKeyType) {
+  ASSERT_THAT(AeadConfig::Register(), IsOk());
+  ASSERT_THAT(MacConfig::Register(), IsOk());
+  const KeyTemplate& aead_template = AeadKeyTemplates::Aes128Gcm();
+  const KeyTemplate& mac_template = MacKeyTemplates::HmacSha256();
+
+  CostCatalog catalog;
+  EXPECT_THAT(catalog.Get(aead_template.type_url()).status(),
+              StatusIs(util::error::NOT_FOUND));
+  ASSERT_THAT(catalog.CalibrateAll({aead_template, mac_template},
+                                   FastOptions()),
+              IsOk());
+  auto aead_cost = catalog.Get(aead_template.type_url());
+  ASSERT_THAT(aead_cost.status(), IsOk());
+  EXPECT_GT(aead_cost.ValueOrDie().produce.Estimate(1024),
+            absl::ZeroDuration());
+  EXPECT_THAT(catalog.Get(mac_template.type_url()).status(), IsOk());
+  EXPECT_EQ(2, catalog.GetAll().size());
+}
+
+TEST(CostCatalogTest, UnknownKeyType) {
+  KeyTemplate key_template;
+  key_template.set_type_url("type.googleapis.com/google.crypto.tink.Unknown");
+  CostCatalog catalog;
+  EXPECT_FALSE(catalog.Calibrate(key_template, FastOptions()).ok());
+  EXPECT_TRUE(catalog.GetAll().empty());
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
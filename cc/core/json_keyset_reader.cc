@@ -16,18 +16,20 @@
 
 #include "tink/json_keyset_reader.h"
 
-#include <iostream>
+#include <array>
+#include <cstdint>
 #include <istream>
-#include <sstream>
+#include <streambuf>
+#include <string>
 
 #include "absl/memory/memory.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_cat.h"
-#include "include/rapidjson/document.h"
+#include "absl/strings/string_view.h"
 #include "include/rapidjson/error/en.h"
+#include "include/rapidjson/reader.h"
 #include "tink/util/enums.h"
 #include "tink/util/errors.h"
-#include "tink/util/protobuf_helper.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "proto/tink.pb.h"
@@ -44,184 +46,452 @@ using crypto::tink::util::Enums;
 
 namespace {
 
+// The JSON values a KeysetJsonHandler writes into a proto.
+enum class JsonElement {
+  kKeyset,
+  kKeyList,
+  kKey,
+  kKeyData,
+  kEncryptedKeyset,
+  kKeysetInfo,
+  kKeyInfoList,
+  kKeyInfo,
+};
 
-// Helpers for validating and parsing JSON strings with EncryptedKeyset-protos.
-util::Status ValidateEncryptedKeyset(const rapidjson::Document& json_doc) {
-  if (!json_doc.HasMember("encryptedKeyset") ||
-      !json_doc["encryptedKeyset"].IsString() ||
-      (json_doc.HasMember("keysetInfo") &&
-       !json_doc["keysetInfo"].IsObject())) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                            "Invalid JSON EncryptedKeyset");
+// The members of the JSON objects above, one bit each, so that the members
+// seen in an object fit into a mask.
+enum JsonMember : uint32_t {
+  kNoMember = 0,
+  kPrimaryKeyIdMember = 1 << 0,
+  kKeyMember = 1 << 1,
+  kKeyDataMember = 1 << 2,
+  kStatusMember = 1 << 3,
+  kKeyIdMember = 1 << 4,
+  kOutputPrefixTypeMember = 1 << 5,
+  kTypeUrlMember = 1 << 6,
+  kValueMember = 1 << 7,
+  kKeyMaterialTypeMember = 1 << 8,
+  kEncryptedKeysetMember = 1 << 9,
+  kKeysetInfoMember = 1 << 10,
+  kKeyInfoMember = 1 << 11,
+};
+
+const char* ElementName(JsonElement element) {
+  switch (element) {
+    case JsonElement::kKeyset:
+    case JsonElement::kKeyList:
+      return "Keyset";
+    case JsonElement::kKey:
+      return "Key";
+    case JsonElement::kKeyData:
+      return "KeyData";
+    case JsonElement::kEncryptedKeyset:
+      return "EncryptedKeyset";
+    case JsonElement::kKeysetInfo:
+    case JsonElement::kKeyInfoList:
+      return "KeysetInfo";
+    case JsonElement::kKeyInfo:
+      return "KeyInfo";
   }
-  return util::Status::OK;
+  return "";
 }
 
-util::Status ValidateKeysetInfo(const rapidjson::Value& json_value) {
-  if (!json_value.HasMember("primaryKeyId") ||
-      !json_value["primaryKeyId"].IsUint() ||
-      !json_value.HasMember("keyInfo") ||
-      !json_value["keyInfo"].IsArray() ||
-      json_value["keyInfo"].Size() < 1) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                            "Invalid JSON KeysetInfo");
+// Returns the members 'element' must have. Only the "keysetInfo" of an
+// EncryptedKeyset is optional.
+uint32_t RequiredMembers(JsonElement element) {
+  switch (element) {
+    case JsonElement::kKeyset:
+      return kPrimaryKeyIdMember | kKeyMember;
+    case JsonElement::kKey:
+      return kKeyDataMember | kStatusMember | kKeyIdMember |
+             kOutputPrefixTypeMember;
+    case JsonElement::kKeyData:
+      return kTypeUrlMember | kValueMember | kKeyMaterialTypeMember;
+    case JsonElement::kEncryptedKeyset:
+      return kEncryptedKeysetMember;
+    case JsonElement::kKeysetInfo:
+      return kPrimaryKeyIdMember | kKeyInfoMember;
+    case JsonElement::kKeyInfo:
+      return kTypeUrlMember | kStatusMember | kKeyIdMember |
+             kOutputPrefixTypeMember;
+    default:
+      return kNoMember;
   }
-  return util::Status::OK;
 }
 
-util::Status ValidateKeyInfo(const rapidjson::Value& json_value) {
-  if (!json_value.HasMember("typeUrl") ||
-      !json_value["typeUrl"].IsString() ||
-      !json_value.HasMember("status") ||
-      !json_value["status"].IsString() ||
-      !json_value.HasMember("keyId") ||
-      !json_value["keyId"].IsUint() ||
-      !json_value.HasMember("outputPrefixType") ||
-      !json_value["outputPrefixType"].IsString()) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                            "Invalid JSON KeyInfo");
+// Returns the member of 'element' called 'name', or kNoMember if 'element'
+// has no such member.
+uint32_t FindMember(JsonElement element, absl::string_view name) {
+  uint32_t member = kNoMember;
+  if (name == "primaryKeyId") {
+    member = kPrimaryKeyIdMember;
+  } else if (name == "key") {
+    member = kKeyMember;
+  } else if (name == "keyData") {
+    member = kKeyDataMember;
+  } else if (name == "status") {
+    member = kStatusMember;
+  } else if (name == "keyId") {
+    member = kKeyIdMember;
+  } else if (name == "outputPrefixType") {
+    member = kOutputPrefixTypeMember;
+  } else if (name == "typeUrl") {
+    member = kTypeUrlMember;
+  } else if (name == "value") {
+    member = kValueMember;
+  } else if (name == "keyMaterialType") {
+    member = kKeyMaterialTypeMember;
+  } else if (name == "encryptedKeyset") {
+    member = kEncryptedKeysetMember;
+  } else if (name == "keysetInfo") {
+    member = kKeysetInfoMember;
+  } else if (name == "keyInfo") {
+    member = kKeyInfoMember;
+  }
+  uint32_t known_members = RequiredMembers(element);
+  if (element == JsonElement::kEncryptedKeyset) {
+    known_members |= kKeysetInfoMember;
   }
-  return util::Status::OK;
+  return member & known_members;
 }
 
-util::StatusOr<std::unique_ptr<KeysetInfo::KeyInfo>>
-KeyInfoFromJson(const rapidjson::Value& json_value) {
-  auto status = ValidateKeyInfo(json_value);
-  if (!status.ok()) return status;
+// A rapidjson SAX handler which writes a JSON Keyset or EncryptedKeyset
+// directly into the proto, without building a DOM first. Unknown members are
+// skipped, and for duplicate members the first one is used, as with a DOM
+// lookup. All keysets have the same fixed structure, so the handler keeps
+// track of where it is with a small stack of the open objects and lists.
+class KeysetJsonHandler
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>,
+                                          KeysetJsonHandler> {
+ public:
+  explicit KeysetJsonHandler(Keyset* keyset)
+      : root_(JsonElement::kKeyset), keyset_(keyset) {}
+  explicit KeysetJsonHandler(EncryptedKeyset* encrypted_keyset)
+      : root_(JsonElement::kEncryptedKeyset),
+        encrypted_keyset_(encrypted_keyset) {}
 
-  auto key_info = absl::make_unique<KeysetInfo::KeyInfo>();
-  key_info->set_type_url(json_value["typeUrl"].GetString());
-  key_info->set_status(Enums::KeyStatus(json_value["status"].GetString()));
-  key_info->set_key_id(json_value["keyId"].GetUint());
-  key_info->set_output_prefix_type(
-      Enums::OutputPrefix(json_value["outputPrefixType"].GetString()));
-  return std::move(key_info);
-}
+  // The error which made a handler function return false.
+  const util::Status& status() const { return status_; }
+  const char* root_name() const { return ElementName(root_); }
 
-util::StatusOr<std::unique_ptr<KeysetInfo>>
-KeysetInfoFromJson(const rapidjson::Value& json_value) {
-  auto status = ValidateKeysetInfo(json_value);
-  if (!status.ok()) return status;
-  auto keyset_info = absl::make_unique<KeysetInfo>();
-  keyset_info->set_primary_key_id(json_value["primaryKeyId"].GetUint());
-  for (const auto& json_key_info : json_value["keyInfo"].GetArray()) {
-    auto key_info_result = KeyInfoFromJson(json_key_info);
-    if (!key_info_result.ok()) return key_info_result.status();
-    *(keyset_info->add_key_info()) = *(key_info_result.ValueOrDie());
+  bool Key(const char* str, rapidjson::SizeType length, bool /* copy */) {
+    if (skipping_) return true;
+    Frame& frame = frames_[depth_ - 1];
+    uint32_t member = FindMember(frame.element, absl::string_view(str, length));
+    if (member == kNoMember || (frame.seen_members & member) != 0) {
+      skipping_ = true;
+      skip_depth_ = 0;
+      return true;
+    }
+    frame.seen_members |= member;
+    frame.pending_member = member;
+    return true;
   }
-  return std::move(keyset_info);
-}
 
-util::StatusOr<std::unique_ptr<EncryptedKeyset>>
-EncryptedKeysetFromJson(const rapidjson::Document& json_doc) {
-  auto status = ValidateEncryptedKeyset(json_doc);
-  if (!status.ok()) return status;
-  std::string enc_keyset;
-  if (!absl::Base64Unescape(
-          json_doc["encryptedKeyset"].GetString(), &enc_keyset)) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                            "Invalid JSON EncryptedKeyset");
+  bool String(const char* str, rapidjson::SizeType length, bool /* copy */) {
+    if (SkipScalar()) return true;
+    JsonElement element;
+    uint32_t member;
+    if (!TakePendingMember(&element, &member)) return false;
+    absl::string_view value(str, length);
+    switch (element) {
+      case JsonElement::kKey:
+        if (member == kStatusMember) {
+          key_->set_status(Enums::KeyStatus(value));
+          return true;
+        }
+        if (member == kOutputPrefixTypeMember) {
+          key_->set_output_prefix_type(Enums::OutputPrefix(value));
+          return true;
+        }
+        break;
+      case JsonElement::kKeyData:
+        if (member == kTypeUrlMember) {
+          key_data_->set_type_url(str, length);
+          return true;
+        }
+        if (member == kValueMember) {
+          return absl::Base64Unescape(value, key_data_->mutable_value()) ||
+                 Fail(element);
+        }
+        if (member == kKeyMaterialTypeMember) {
+          key_data_->set_key_material_type(Enums::KeyMaterial(value));
+          return true;
+        }
+        break;
+      case JsonElement::kEncryptedKeyset:
+        if (member == kEncryptedKeysetMember) {
+          return absl::Base64Unescape(
+                     value, encrypted_keyset_->mutable_encrypted_keyset()) ||
+                 Fail(element);
+        }
+        break;
+      case JsonElement::kKeyInfo:
+        if (member == kTypeUrlMember) {
+          key_info_->set_type_url(str, length);
+          return true;
+        }
+        if (member == kStatusMember) {
+          key_info_->set_status(Enums::KeyStatus(value));
+          return true;
+        }
+        if (member == kOutputPrefixTypeMember) {
+          key_info_->set_output_prefix_type(Enums::OutputPrefix(value));
+          return true;
+        }
+        break;
+      default:
+        break;
+    }
+    return Fail(element);
   }
-  auto encrypted_keyset = absl::make_unique<EncryptedKeyset>();
-  encrypted_keyset->set_encrypted_keyset(enc_keyset);
-  if (json_doc.HasMember("keysetInfo")) {
-    auto keyset_info_result =
-        KeysetInfoFromJson(json_doc["keysetInfo"]);
-    if (!keyset_info_result.ok()) {
-      return keyset_info_result.status();
+
+  bool Uint(unsigned value) {
+    if (SkipScalar()) return true;
+    JsonElement element;
+    uint32_t member;
+    if (!TakePendingMember(&element, &member)) return false;
+    if (element == JsonElement::kKeyset && member == kPrimaryKeyIdMember) {
+      keyset_->set_primary_key_id(value);
+    } else if (element == JsonElement::kKey && member == kKeyIdMember) {
+      key_->set_key_id(value);
+    } else if (element == JsonElement::kKeysetInfo &&
+               member == kPrimaryKeyIdMember) {
+      keyset_info_->set_primary_key_id(value);
+    } else if (element == JsonElement::kKeyInfo && member == kKeyIdMember) {
+      key_info_->set_key_id(value);
+    } else {
+      return Fail(element);
     }
-    *(encrypted_keyset->mutable_keyset_info()) =
-        *(keyset_info_result.ValueOrDie());
+    return true;
   }
-  return std::move(encrypted_keyset);
-}
 
-// Helpers for validating and parsing JSON strings with Keyset-protos.
-util::Status ValidateKeyset(const rapidjson::Document& json_doc) {
-  if (!json_doc.HasMember("primaryKeyId") ||
-      !json_doc["primaryKeyId"].IsUint() ||
-      !json_doc.HasMember("key") ||
-      !json_doc["key"].IsArray() ||
-      json_doc["key"].Size() < 1) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                            "Invalid JSON Keyset");
+  // rapidjson reports "-0" through Int(), but it is still a valid uint.
+  bool Int(int value) {
+    if (value >= 0) return Uint(static_cast<unsigned>(value));
+    return Default();
   }
-  return util::Status::OK;
-}
 
-util::Status ValidateKey(const rapidjson::Value& json_value) {
-  if (!json_value.HasMember("keyData") ||
-      !json_value["keyData"].IsObject() ||
-      !json_value.HasMember("status") ||
-      !json_value["status"].IsString() ||
-      !json_value.HasMember("keyId") ||
-      !json_value["keyId"].IsUint() ||
-      !json_value.HasMember("outputPrefixType") ||
-      !json_value["outputPrefixType"].IsString()) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                            "Invalid JSON Key");
+  // Called for all other scalars (null, booleans, 64-bit and floating point
+  // numbers), none of which is valid in a keyset.
+  bool Default() {
+    if (SkipScalar()) return true;
+    JsonElement element;
+    uint32_t member;
+    if (!TakePendingMember(&element, &member)) return false;
+    return Fail(element);
   }
-  return util::Status::OK;
-}
 
-util::Status ValidateKeyData(const rapidjson::Value& json_value) {
-  if (!json_value.HasMember("typeUrl") ||
-      !json_value["typeUrl"].IsString() ||
-      !json_value.HasMember("value") ||
-      !json_value["value"].IsString() ||
-      !json_value.HasMember("keyMaterialType") ||
-      !json_value["keyMaterialType"].IsString()) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                            "Invalid JSON KeyData");
+  bool StartObject() {
+    if (skipping_) {
+      ++skip_depth_;
+      return true;
+    }
+    if (depth_ == 0) return Push(root_);
+    Frame& frame = frames_[depth_ - 1];
+    switch (frame.element) {
+      case JsonElement::kKeyList:
+        key_ = keyset_->add_key();
+        return Push(JsonElement::kKey);
+      case JsonElement::kKeyInfoList:
+        key_info_ = keyset_info_->add_key_info();
+        return Push(JsonElement::kKeyInfo);
+      case JsonElement::kKey:
+        if (frame.pending_member == kKeyDataMember) {
+          frame.pending_member = kNoMember;
+          key_data_ = key_->mutable_key_data();
+          return Push(JsonElement::kKeyData);
+        }
+        break;
+      case JsonElement::kEncryptedKeyset:
+        if (frame.pending_member == kKeysetInfoMember) {
+          frame.pending_member = kNoMember;
+          keyset_info_ = encrypted_keyset_->mutable_keyset_info();
+          return Push(JsonElement::kKeysetInfo);
+        }
+        break;
+      default:
+        break;
+    }
+    return Fail(frame.element);
   }
-  return util::Status::OK;
-}
 
-util::StatusOr<std::unique_ptr<KeyData>>
-KeyDataFromJson(const rapidjson::Value& json_value) {
-  auto status = ValidateKeyData(json_value);
-  if (!status.ok()) return status;
-  std::string value_field;
-  if (!absl::Base64Unescape(json_value["value"].GetString(), &value_field)) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                            "Invalid JSON KeyData");
+  bool EndObject(rapidjson::SizeType /* member_count */) {
+    if (skipping_) return EndSkippedValue();
+    const Frame& frame = frames_[depth_ - 1];
+    uint32_t required_members = RequiredMembers(frame.element);
+    if ((frame.seen_members & required_members) != required_members) {
+      return Fail(frame.element);
+    }
+    --depth_;
+    return true;
   }
-  auto key_data = absl::make_unique<KeyData>();
-  key_data->set_type_url(json_value["typeUrl"].GetString());
-  key_data->set_value(value_field);
-  key_data->set_key_material_type(
-      Enums::KeyMaterial(json_value["keyMaterialType"].GetString()));
-  return std::move(key_data);
-}
 
-util::StatusOr<std::unique_ptr<Keyset::Key>>
-KeyFromJson(const rapidjson::Value& json_value) {
-  auto status = ValidateKey(json_value);
-  if (!status.ok()) return status;
-  auto key_data_result = KeyDataFromJson(json_value["keyData"]);
-  if (!key_data_result.ok()) return key_data_result.status();
-
-  auto key = absl::make_unique<Keyset::Key>();
-  key->set_key_id(json_value["keyId"].GetUint());
-  key->set_status(Enums::KeyStatus(json_value["status"].GetString()));
-  key->set_output_prefix_type(
-      Enums::OutputPrefix(json_value["outputPrefixType"].GetString()));
-  *(key->mutable_key_data()) = *(key_data_result.ValueOrDie());
-  return std::move(key);
-}
+  bool StartArray() {
+    if (skipping_) {
+      ++skip_depth_;
+      return true;
+    }
+    if (depth_ == 0) return Fail(root_);
+    Frame& frame = frames_[depth_ - 1];
+    if (frame.element == JsonElement::kKeyset &&
+        frame.pending_member == kKeyMember) {
+      frame.pending_member = kNoMember;
+      return Push(JsonElement::kKeyList);
+    }
+    if (frame.element == JsonElement::kKeysetInfo &&
+        frame.pending_member == kKeyInfoMember) {
+      frame.pending_member = kNoMember;
+      return Push(JsonElement::kKeyInfoList);
+    }
+    return Fail(ItemElement(frame.element));
+  }
 
-util::StatusOr<std::unique_ptr<Keyset>>
-KeysetFromJson(const rapidjson::Document& json_doc) {
-  auto status = ValidateKeyset(json_doc);
-  if (!status.ok()) return status;
-  auto keyset = absl::make_unique<Keyset>();
-  keyset->set_primary_key_id(json_doc["primaryKeyId"].GetUint());
-  for (const auto& json_key : json_doc["key"].GetArray()) {
-    auto key_result = KeyFromJson(json_key);
-    if (!key_result.ok()) return key_result.status();
-    *(keyset->add_key()) = *(key_result.ValueOrDie());
+  bool EndArray(rapidjson::SizeType element_count) {
+    if (skipping_) return EndSkippedValue();
+    // Keysets and KeysetInfos must have at least one key.
+    if (element_count < 1) return Fail(frames_[depth_ - 1].element);
+    --depth_;
+    return true;
   }
-  return std::move(keyset);
+
+ private:
+  // An open object or list. Objects remember which members they have seen,
+  // and the member whose value comes next.
+  struct Frame {
+    JsonElement element;
+    uint32_t seen_members;
+    uint32_t pending_member;
+  };
+
+  // The deepest nesting is Keyset > key list > Key > KeyData, or
+  // EncryptedKeyset > KeysetInfo > key info list > KeyInfo.
+  static constexpr int kMaxDepth = 4;
+
+  // The elements of lists, and the objects themselves otherwise.
+  static JsonElement ItemElement(JsonElement element) {
+    switch (element) {
+      case JsonElement::kKeyList:
+        return JsonElement::kKey;
+      case JsonElement::kKeyInfoList:
+        return JsonElement::kKeyInfo;
+      default:
+        return element;
+    }
+  }
+
+  bool Push(JsonElement element) {
+    if (depth_ == kMaxDepth) return Fail(element);
+    frames_[depth_++] = {element, kNoMember, kNoMember};
+    return true;
+  }
+
+  // Sets 'element' and 'member' to the object and member a scalar value
+  // belongs to. Fails if scalars are not allowed at this point, i.e. for the
+  // root value and for list elements.
+  bool TakePendingMember(JsonElement* element, uint32_t* member) {
+    if (depth_ == 0) return Fail(root_);
+    Frame& frame = frames_[depth_ - 1];
+    *element = ItemElement(frame.element);
+    if (*element != frame.element) return Fail(*element);
+    *member = frame.pending_member;
+    frame.pending_member = kNoMember;
+    return true;
+  }
+
+  // Returns true if the current scalar is (part of) a skipped member value.
+  bool SkipScalar() {
+    if (!skipping_) return false;
+    if (skip_depth_ == 0) skipping_ = false;
+    return true;
+  }
+
+  bool EndSkippedValue() {
+    if (--skip_depth_ == 0) skipping_ = false;
+    return true;
+  }
+
+  bool Fail(JsonElement element) {
+    status_ = util::Status(util::error::INVALID_ARGUMENT,
+                           absl::StrCat("Invalid JSON ", ElementName(element)));
+    return false;
+  }
+
+  const JsonElement root_;
+  Keyset* keyset_ = nullptr;
+  EncryptedKeyset* encrypted_keyset_ = nullptr;
+  // The innermost open objects of each type.
+  Keyset::Key* key_ = nullptr;
+  KeyData* key_data_ = nullptr;
+  KeysetInfo* keyset_info_ = nullptr;
+  KeysetInfo::KeyInfo* key_info_ = nullptr;
+
+  std::array<Frame, kMaxDepth> frames_;
+  int depth_ = 0;
+  // Whether the value of an unknown or duplicate member is being skipped,
+  // and how many objects and arrays of it are open.
+  bool skipping_ = false;
+  int skip_depth_ = 0;
+  util::Status status_;
+};
+
+// A rapidjson input stream which reads from a std::streambuf, so that
+// keysets are parsed as they are read instead of being copied into a
+// string first.
+class StreambufStream {
+ public:
+  typedef char Ch;
+
+  explicit StreambufStream(std::streambuf* buffer) : buffer_(buffer) {}
+
+  Ch Peek() const {
+    int c = buffer_->sgetc();
+    return c == std::char_traits<char>::eof() ? '\0' : static_cast<Ch>(c);
+  }
+
+  Ch Take() {
+    int c = buffer_->sbumpc();
+    if (c == std::char_traits<char>::eof()) return '\0';
+    ++count_;
+    return static_cast<Ch>(c);
+  }
+
+  size_t Tell() const { return count_; }
+
+  // Only needed for in situ parsing, which is not used.
+  Ch* PutBegin() { return nullptr; }
+  void Put(Ch) {}
+  void Flush() {}
+  size_t PutEnd(Ch*) { return 0; }
+
+ private:
+  std::streambuf* buffer_;
+  size_t count_ = 0;
+};
+
+// Parses the JSON from 'keyset_stream' if it is not null, and from
+// 'serialized_keyset' otherwise, into the proto of 'handler'.
+util::Status ParseJson(const std::string& serialized_keyset,
+                       std::istream* keyset_stream,
+                       KeysetJsonHandler* handler) {
+  rapidjson::Reader reader;
+  if (keyset_stream != nullptr && keyset_stream->rdbuf() != nullptr) {
+    StreambufStream stream(keyset_stream->rdbuf());
+    reader.Parse(stream, *handler);
+  } else {
+    rapidjson::StringStream stream(
+        keyset_stream == nullptr ? serialized_keyset.c_str() : "");
+    reader.Parse(stream, *handler);
+  }
+  if (!reader.HasParseError()) return util::Status::OK;
+  if (reader.GetParseErrorCode() == rapidjson::kParseErrorTermination) {
+    return handler->status();
+  }
+  return util::Status(
+      util::error::INVALID_ARGUMENT,
+      absl::StrCat("Invalid JSON ", handler->root_name(), ": Error (offset ",
+                   reader.GetErrorOffset(), "): ",
+                   rapidjson::GetParseError_En(reader.GetParseErrorCode())));
 }
 
 }  // namespace
@@ -247,46 +517,22 @@ util::StatusOr<std::unique_ptr<KeysetReader>> JsonKeysetReader::New(
 }
 
 util::StatusOr<std::unique_ptr<Keyset>> JsonKeysetReader::Read() {
-  std::string serialized_keyset_from_stream;
-  std::string* serialized_keyset;
-  if (keyset_stream_ == nullptr) {
-    serialized_keyset = &serialized_keyset_;
-  } else {
-    serialized_keyset_from_stream =
-        std::string(std::istreambuf_iterator<char>(*keyset_stream_), {});
-    serialized_keyset = &serialized_keyset_from_stream;
-  }
-  rapidjson::Document json_doc(rapidjson::kObjectType);
-  if (json_doc.Parse(serialized_keyset->c_str()).HasParseError()) {
-    return util::Status(
-        util::error::INVALID_ARGUMENT,
-        absl::StrCat(
-            "Invalid JSON Keyset: Error (offset ", json_doc.GetErrorOffset(),
-            "): ", rapidjson::GetParseError_En(json_doc.GetParseError())));
-  }
-  return KeysetFromJson(json_doc);
+  auto keyset = absl::make_unique<Keyset>();
+  KeysetJsonHandler handler(keyset.get());
+  util::Status status =
+      ParseJson(serialized_keyset_, keyset_stream_.get(), &handler);
+  if (!status.ok()) return status;
+  return std::move(keyset);
 }
 
 util::StatusOr<std::unique_ptr<EncryptedKeyset>>
 JsonKeysetReader::ReadEncrypted() {
-  std::string serialized_keyset_from_stream;
-  std::string* serialized_keyset;
-  if (keyset_stream_ == nullptr) {
-    serialized_keyset = &serialized_keyset_;
-  } else {
-    serialized_keyset_from_stream =
-        std::string(std::istreambuf_iterator<char>(*keyset_stream_), {});
-    serialized_keyset = &serialized_keyset_from_stream;
-  }
-  rapidjson::Document json_doc;
-  if (json_doc.Parse(serialized_keyset->c_str()).HasParseError()) {
-    return util::Status(
-        util::error::INVALID_ARGUMENT,
-        absl::StrCat("Invalid JSON EncryptedKeyset: Error (offset ",
-                     json_doc.GetErrorOffset(), "): ",
-                     rapidjson::GetParseError_En(json_doc.GetParseError())));
-  }
-  return EncryptedKeysetFromJson(json_doc);
+  auto encrypted_keyset = absl::make_unique<EncryptedKeyset>();
+  KeysetJsonHandler handler(encrypted_keyset.get());
+  util::Status status =
+      ParseJson(serialized_keyset_, keyset_stream_.get(), &handler);
+  if (!status.ok()) return status;
+  return std::move(encrypted_keyset);
 }
 
 }  // namespace tink
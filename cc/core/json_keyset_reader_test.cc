@@ -19,6 +19,8 @@
 #include <iostream>
 #include <istream>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "absl/strings/escaping.h"
@@ -36,6 +38,7 @@ namespace tink {
 using ::crypto::tink::test::AddRawKey;
 using ::crypto::tink::test::AddTinkKey;
 using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
 
 using ::google::crypto::tink::AesEaxKey;
 using ::google::crypto::tink::AesGcmKey;
@@ -345,6 +348,124 @@ TEST_F(JsonKeysetReaderTest, ReadNegativeKeyId) {
   EXPECT_THAT(read_result.status(), Not(IsOk()));
 }
 
+TEST_F(JsonKeysetReaderTest, ReadIgnoresUnknownMembers) {
+  std::string json_serialization = absl::Substitute(
+      R"(
+      {
+         "unknown": {"nested": [1, {"key": []}, "x"], "more": null},
+         "primaryKeyId": 42,
+         "key":[
+            {
+               "keyData":{
+                  "typeUrl":"type.googleapis.com/google.crypto.tink.AesGcmKey",
+                  "keyMaterialType":"SYMMETRIC",
+                  "value": "$0",
+                  "unknown": [true, false]
+               },
+               "outputPrefixType":"TINK",
+               "keyId":42,
+               "status":"ENABLED",
+               "unknown": 1.5
+            }
+         ],
+         "primaryKeyId": 43
+      })",
+      absl::Base64Escape(gcm_key_.SerializeAsString()));
+  auto reader =
+      std::move(JsonKeysetReader::New(json_serialization).ValueOrDie());
+  auto read_result = reader->Read();
+  ASSERT_THAT(read_result.status(), IsOk());
+  // Duplicate members are ignored, the first one is used.
+  EXPECT_THAT(read_result.ValueOrDie()->primary_key_id(), Eq(42));
+  ASSERT_THAT(read_result.ValueOrDie()->key_size(), Eq(1));
+  EXPECT_EQ(read_result.ValueOrDie()->key(0).SerializeAsString(),
+            keyset_.key(0).SerializeAsString());
+}
+
+TEST_F(JsonKeysetReaderTest, ReadRejectsInvalidKeysets) {
+  std::string value = absl::Base64Escape(gcm_key_.SerializeAsString());
+  std::string key_data = absl::Substitute(
+      R"("keyData":{"typeUrl":"some type", "keyMaterialType":"SYMMETRIC",
+                    "value":"$0"})",
+      value);
+  std::string key_fields = R"("outputPrefixType":"TINK", "status":"ENABLED")";
+  std::vector<std::string> invalid_keysets = {
+      "[]",
+      "42",
+      "{}",
+      "{\"primaryKeyId\": 42}",
+      "{\"primaryKeyId\": 42, \"key\": []}",
+      "{\"primaryKeyId\": 42, \"key\": {}}",
+      "{\"primaryKeyId\": 42, \"key\": [42]}",
+      "{\"primaryKeyId\": \"42\", \"key\": [{" + key_data + ", " + key_fields +
+          ", \"keyId\": 42}]}",
+      "{\"primaryKeyId\": 4.2, \"key\": [{" + key_data + ", " + key_fields +
+          ", \"keyId\": 42}]}",
+      "{\"primaryKeyId\": 42, \"key\": [{" + key_data + ", " + key_fields +
+          "}]}",
+      "{\"primaryKeyId\": 42, \"key\": [{" + key_data + ", " + key_fields +
+          ", \"keyId\": 4294967296}]}",
+      "{\"primaryKeyId\": 42, \"key\": [{\"keyData\": \"x\", " + key_fields +
+          ", \"keyId\": 42}]}",
+      "{\"primaryKeyId\": 42, \"key\": [{\"keyData\": {\"typeUrl\": \"t\", "
+          "\"keyMaterialType\": \"SYMMETRIC\", \"value\": \"!!\"}, " +
+          key_fields + ", \"keyId\": 42}]}",
+      "{\"primaryKeyId\": 42, \"key\": [{" + key_data + ", " + key_fields +
+          ", \"keyId\": 42}]} trailing",
+  };
+  for (const std::string& json_serialization : invalid_keysets) {
+    auto reader =
+        std::move(JsonKeysetReader::New(json_serialization).ValueOrDie());
+    EXPECT_THAT(reader->Read().status(),
+                StatusIs(util::error::INVALID_ARGUMENT))
+        << json_serialization;
+  }
+  // The last entry without the trailing data is valid.
+  std::string valid = "{\"primaryKeyId\": 42, \"key\": [{" + key_data + ", " +
+                      key_fields + ", \"keyId\": 42}]}";
+  EXPECT_THAT(JsonKeysetReader::New(valid).ValueOrDie()->Read().status(),
+              IsOk());
+}
+
+TEST_F(JsonKeysetReaderTest, ReadEncryptedWithoutKeysetInfo) {
+  auto reader = std::move(
+      JsonKeysetReader::New("{\"encryptedKeyset\": \"YWJj\"}").ValueOrDie());
+  auto read_result = reader->ReadEncrypted();
+  ASSERT_THAT(read_result.status(), IsOk());
+  EXPECT_THAT(read_result.ValueOrDie()->encrypted_keyset(), Eq("abc"));
+  EXPECT_FALSE(read_result.ValueOrDie()->has_keyset_info());
+}
+
+TEST_F(JsonKeysetReaderTest, ReadEncryptedRejectsInvalidKeysets) {
+  std::vector<std::string> invalid_keysets = {
+      "{}",
+      "{\"encryptedKeyset\": 42}",
+      "{\"encryptedKeyset\": \"!!\"}",
+      "{\"encryptedKeyset\": \"YWJj\", \"keysetInfo\": []}",
+      "{\"encryptedKeyset\": \"YWJj\", \"keysetInfo\": {\"primaryKeyId\": 1, "
+      "\"keyInfo\": []}}",
+      "{\"encryptedKeyset\": \"YWJj\", \"keysetInfo\": {\"primaryKeyId\": 1, "
+      "\"keyInfo\": [{\"typeUrl\": \"t\", \"status\": \"ENABLED\"}]}}",
+  };
+  for (const std::string& json_serialization : invalid_keysets) {
+    auto reader =
+        std::move(JsonKeysetReader::New(json_serialization).ValueOrDie());
+    EXPECT_THAT(reader->ReadEncrypted().status(),
+                StatusIs(util::error::INVALID_ARGUMENT))
+        << json_serialization;
+  }
+}
+
+TEST_F(JsonKeysetReaderTest, ReadFromStreamRejectsTrailingData) {
+  std::unique_ptr<std::istream> keyset_stream(new std::stringstream(
+      good_json_keyset_ + good_json_keyset_, std::ios_base::in));
+  auto reader =
+      std::move(JsonKeysetReader::New(std::move(keyset_stream)).ValueOrDie());
+  // The stream holds two keysets, which is not a valid keyset.
+  EXPECT_THAT(reader->Read().status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
@@ -19,13 +19,16 @@
 #include <ostream>
 #include <istream>
 #include <sstream>
+#include <string>
 
 #include "absl/strings/escaping.h"
-#include "include/rapidjson/document.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "include/rapidjson/prettywriter.h"
 #include "tink/util/enums.h"
 #include "tink/util/errors.h"
 #include "tink/util/protobuf_helper.h"
+#include "tink/util/secret_data.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "proto/tink.pb.h"
@@ -43,138 +46,121 @@ using util::Enums;
 
 namespace {
 
-// Helpers for transoforming Keyset-protos to  JSON strings.
-util::Status ToJson(const KeyData& key_data,
-                        rapidjson::Value* json_key_data,
-                        rapidjson::Document::AllocatorType* allocator) {
-  rapidjson::Value type_url(rapidjson::kStringType);
-  type_url.SetString(key_data.type_url().c_str(), *allocator);
-  json_key_data->AddMember("typeUrl", type_url, *allocator);
-
-  rapidjson::Value material_type(rapidjson::kStringType);
-  material_type.SetString(Enums::KeyMaterialName(key_data.key_material_type()),
-                          *allocator);
-  json_key_data->AddMember("keyMaterialType", material_type, *allocator);
-
-  std::string base64_string;
-  absl::Base64Escape(key_data.value(), &base64_string);
-  rapidjson::Value key_value(rapidjson::kStringType);
-  key_value.SetString(base64_string.c_str(), *allocator);
-  json_key_data->AddMember("value", key_value, *allocator);
+// A rapidjson output stream appending to a std::string, so that the JSON is
+// written into a buffer that is reused across writes.
+class StringOutput {
+ public:
+  typedef char Ch;
 
-  return util::Status::OK;
+  explicit StringOutput(std::string* output) : output_(output) {}
+
+  void Put(char c) { output_->push_back(c); }
+  void Flush() {}
+
+ private:
+  std::string* output_;
+};
+
+using JsonWriter = rapidjson::PrettyWriter<StringOutput>;
+
+// Helpers for writing Keyset-protos as JSON, without building a DOM. The
+// output is the same as that of a PrettyWriter on the equivalent DOM.
+void WriteString(absl::string_view value, JsonWriter* writer) {
+  writer->String(value.data(),
+                 static_cast<rapidjson::SizeType>(value.size()));
 }
 
-util::Status ToJson(const Keyset::Key& key,
-                        rapidjson::Value* json_key,
-                        rapidjson::Document::AllocatorType* allocator) {
-  rapidjson::Value key_id(rapidjson::kNumberType);
-  key_id.SetUint(key.key_id());
-  json_key->AddMember("keyId", key_id, *allocator);
-
-  rapidjson::Value key_status(rapidjson::kStringType);
-  key_status.SetString(Enums::KeyStatusName(key.status()), *allocator);
-  json_key->AddMember("status", key_status, *allocator);
-
-  rapidjson::Value prefix_type(rapidjson::kStringType);
-  prefix_type.SetString(Enums::OutputPrefixName(key.output_prefix_type()),
-                        *allocator);
-  json_key->AddMember("outputPrefixType", prefix_type, *allocator);
-
-  rapidjson::Value json_key_data(rapidjson::kObjectType);
-  auto status = ToJson(key.key_data(), &json_key_data, allocator);
-  if (!status.ok()) return status;
-  json_key->AddMember("keyData", json_key_data, *allocator);
-  return util::Status::OK;
+void WriteBase64(absl::string_view value, std::string* scratch,
+                 JsonWriter* writer) {
+  absl::Base64Escape(value, scratch);
+  WriteString(*scratch, writer);
 }
 
-util::StatusOr<std::string> ToJsonString(const Keyset& keyset) {
-  rapidjson::Document json_doc(rapidjson::kObjectType);
-  auto& allocator = json_doc.GetAllocator();
+void ToJson(const KeyData& key_data, std::string* scratch,
+            JsonWriter* writer) {
+  writer->StartObject();
+  writer->Key("typeUrl");
+  WriteString(key_data.type_url(), writer);
+  writer->Key("keyMaterialType");
+  writer->String(Enums::KeyMaterialName(key_data.key_material_type()));
+  writer->Key("value");
+  WriteBase64(key_data.value(), scratch, writer);
+  writer->EndObject();
+}
 
-  rapidjson::Value primary_key_id(rapidjson::kNumberType);
-  primary_key_id.SetUint(keyset.primary_key_id());
-  json_doc.AddMember("primaryKeyId", primary_key_id, allocator);
+void ToJson(const Keyset::Key& key, std::string* scratch, JsonWriter* writer) {
+  writer->StartObject();
+  writer->Key("keyId");
+  writer->Uint(key.key_id());
+  writer->Key("status");
+  writer->String(Enums::KeyStatusName(key.status()));
+  writer->Key("outputPrefixType");
+  writer->String(Enums::OutputPrefixName(key.output_prefix_type()));
+  writer->Key("keyData");
+  ToJson(key.key_data(), scratch, writer);
+  writer->EndObject();
+}
 
-  rapidjson::Value key_array(rapidjson::kArrayType);
+void ToJson(const Keyset& keyset, std::string* scratch, JsonWriter* writer) {
+  writer->StartObject();
+  writer->Key("primaryKeyId");
+  writer->Uint(keyset.primary_key_id());
+  writer->Key("key");
+  writer->StartArray();
   for (const Keyset::Key& key : keyset.key()) {
-    rapidjson::Value json_key(rapidjson::kObjectType);
-    auto status = ToJson(key, &json_key, &allocator);
-    if (!status.ok()) return status;
-    key_array.PushBack(json_key, allocator);
+    ToJson(key, scratch, writer);
   }
-  json_doc.AddMember("key", key_array, allocator);
-  rapidjson::StringBuffer string_buffer;
-  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(string_buffer);
-  json_doc.Accept(writer);
-  return std::string(string_buffer.GetString());
+  writer->EndArray();
+  writer->EndObject();
 }
 
-util::Status ToJson(const KeysetInfo::KeyInfo& key_info,
-                        rapidjson::Value* json_key_info,
-                        rapidjson::Document::AllocatorType* allocator) {
-  rapidjson::Value type_url(rapidjson::kStringType);
-  type_url.SetString(key_info.type_url().c_str(), *allocator);
-  json_key_info->AddMember("typeUrl", type_url, *allocator);
-
-  rapidjson::Value key_id(rapidjson::kNumberType);
-  key_id.SetUint(key_info.key_id());
-  json_key_info->AddMember("keyId", key_id, *allocator);
-
-  rapidjson::Value key_status(rapidjson::kStringType);
-  key_status.SetString(Enums::KeyStatusName(key_info.status()), *allocator);
-  json_key_info->AddMember("status", key_status, *allocator);
-
-  rapidjson::Value prefix_type(rapidjson::kStringType);
-  prefix_type.SetString(Enums::OutputPrefixName(key_info.output_prefix_type()),
-                        *allocator);
-  json_key_info->AddMember("outputPrefixType", prefix_type, *allocator);
-  return util::Status::OK;
+void ToJson(const KeysetInfo::KeyInfo& key_info, JsonWriter* writer) {
+  writer->StartObject();
+  writer->Key("typeUrl");
+  WriteString(key_info.type_url(), writer);
+  writer->Key("keyId");
+  writer->Uint(key_info.key_id());
+  writer->Key("status");
+  writer->String(Enums::KeyStatusName(key_info.status()));
+  writer->Key("outputPrefixType");
+  writer->String(Enums::OutputPrefixName(key_info.output_prefix_type()));
+  writer->EndObject();
 }
 
-util::Status ToJson(const KeysetInfo& keyset_info,
-                        rapidjson::Value* json_keyset_info,
-                        rapidjson::Document::AllocatorType* allocator) {
-  rapidjson::Value primary_key_id(rapidjson::kNumberType);
-  primary_key_id.SetUint(keyset_info.primary_key_id());
-  json_keyset_info->AddMember("primaryKeyId", primary_key_id, *allocator);
-
-  rapidjson::Value key_info_array(rapidjson::kArrayType);
+void ToJson(const KeysetInfo& keyset_info, JsonWriter* writer) {
+  writer->StartObject();
+  writer->Key("primaryKeyId");
+  writer->Uint(keyset_info.primary_key_id());
+  writer->Key("keyInfo");
+  writer->StartArray();
   for (const KeysetInfo::KeyInfo& key_info : keyset_info.key_info()) {
-    rapidjson::Value json_key_info(rapidjson::kObjectType);
-    auto status = ToJson(key_info, &json_key_info, allocator);
-    if (!status.ok()) return status;
-    key_info_array.PushBack(json_key_info, *allocator);
+    ToJson(key_info, writer);
   }
-  json_keyset_info->AddMember("keyInfo", key_info_array, *allocator);
-  return util::Status::OK;
+  writer->EndArray();
+  writer->EndObject();
 }
 
-util::StatusOr<std::string> ToJsonString(const EncryptedKeyset& keyset) {
-  rapidjson::Document json_doc(rapidjson::kObjectType);
-  auto& allocator = json_doc.GetAllocator();
-
-  std::string base64_string;
-  absl::Base64Escape(keyset.encrypted_keyset(), &base64_string);
-  rapidjson::Value encrypted_keyset(rapidjson::kStringType);
-  encrypted_keyset.SetString(base64_string.c_str(), allocator);
-  json_doc.AddMember("encryptedKeyset", encrypted_keyset, allocator);
-
+void ToJson(const EncryptedKeyset& keyset, std::string* scratch,
+            JsonWriter* writer) {
+  writer->StartObject();
+  writer->Key("encryptedKeyset");
+  WriteBase64(keyset.encrypted_keyset(), scratch, writer);
   if (keyset.has_keyset_info()) {
-    rapidjson::Value json_keyset_info(rapidjson::kObjectType);
-    auto status = ToJson(keyset.keyset_info(), &json_keyset_info, &allocator);
-    if (!status.ok()) return status;
-    json_doc.AddMember("keysetInfo", json_keyset_info, allocator);
+    writer->Key("keysetInfo");
+    ToJson(keyset.keyset_info(), writer);
   }
+  writer->EndObject();
+}
 
-  rapidjson::StringBuffer string_buffer;
-  rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(string_buffer);
-  json_doc.Accept(writer);
-  return std::string(string_buffer.GetString());
+// Clears 'buffer' and reserves room for the JSON of a proto of 'proto_size'
+// bytes, whose binary data grows by a third in base64.
+void PrepareBuffer(size_t proto_size, std::string* buffer) {
+  buffer->clear();
+  buffer->reserve(2 * proto_size + 256);
 }
 
 util::Status WriteData(absl::string_view data, std::ostream* destination) {
-  (*destination) << data;
+  destination->write(data.data(), data.size());
   if (destination->fail()) {
     return util::Status(util::error::UNKNOWN,
                             "Error writing to the destination stream.");
@@ -198,16 +184,44 @@ util::StatusOr<std::unique_ptr<JsonKeysetWriter>> JsonKeysetWriter::New(
 }
 
 util::Status JsonKeysetWriter::Write(const Keyset& keyset) {
-  auto json_string_result = ToJsonString(keyset);
-  if (!json_string_result.ok()) return json_string_result.status();
-  return WriteData(json_string_result.ValueOrDie(), destination_stream_.get());
+  PrepareBuffer(keyset.ByteSizeLong(), &buffer_);
+  StringOutput output(&buffer_);
+  JsonWriter writer(output);
+  ToJson(keyset, &scratch_, &writer);
+  util::Status status = WriteData(buffer_, destination_stream_.get());
+  util::SafeZeroMemory(&buffer_[0], buffer_.size());
+  util::SafeZeroMemory(&scratch_[0], scratch_.size());
+  return status;
 }
 
 util::Status JsonKeysetWriter::Write(
     const EncryptedKeyset& encrypted_keyset) {
-  auto json_string_result = ToJsonString(encrypted_keyset);
-  if (!json_string_result.ok()) return json_string_result.status();
-  return WriteData(json_string_result.ValueOrDie(), destination_stream_.get());
+  PrepareBuffer(encrypted_keyset.ByteSizeLong(), &buffer_);
+  StringOutput output(&buffer_);
+  JsonWriter writer(output);
+  ToJson(encrypted_keyset, &scratch_, &writer);
+  return WriteData(buffer_, destination_stream_.get());
+}
+
+util::Status JsonKeysetWriter::WriteBatch(
+    absl::Span<const EncryptedKeyset* const> encrypted_keysets) {
+  size_t total_size = 0;
+  for (const EncryptedKeyset* encrypted_keyset : encrypted_keysets) {
+    if (encrypted_keyset == nullptr) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "encrypted keysets must be non-null.");
+    }
+    total_size += encrypted_keyset->ByteSizeLong();
+  }
+  PrepareBuffer(total_size, &buffer_);
+  StringOutput output(&buffer_);
+  JsonWriter writer(output);
+  writer.StartArray();
+  for (const EncryptedKeyset* encrypted_keyset : encrypted_keysets) {
+    ToJson(*encrypted_keyset, &scratch_, &writer);
+  }
+  writer.EndArray();
+  return WriteData(buffer_, destination_stream_.get());
 }
 
 }  // namespace tink
@@ -18,6 +18,8 @@
 
 #include <ostream>
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "absl/strings/escaping.h"
@@ -220,6 +222,32 @@ TEST_F(JsonKeysetWriterTest, testWriteAndReadEncryptedKeyset) {
             encrypted_keyset->SerializeAsString());
 }
 
+TEST_F(JsonKeysetWriterTest, WriteBatch) {
+  std::stringbuf buffer;
+  std::unique_ptr<std::ostream> destination_stream(new std::ostream(&buffer));
+  auto writer_result = JsonKeysetWriter::New(std::move(destination_stream));
+  ASSERT_THAT(writer_result.status(), IsOk());
+  auto writer = std::move(writer_result.ValueOrDie());
+  EncryptedKeyset other_keyset;
+  other_keyset.set_encrypted_keyset("some other ciphertext");
+  std::vector<const EncryptedKeyset*> keysets = {&encrypted_keyset_,
+                                                 &other_keyset};
+  ASSERT_THAT(writer->WriteBatch(keysets), IsOk());
+
+  rapidjson::Document json_keysets;
+  ASSERT_FALSE(json_keysets.Parse(buffer.str().c_str()).HasParseError());
+  ASSERT_TRUE(json_keysets.IsArray());
+  ASSERT_EQ(2, json_keysets.Size());
+  EXPECT_TRUE(good_json_encrypted_keyset_ == json_keysets[0]);
+  EXPECT_EQ(absl::Base64Escape("some other ciphertext"),
+            json_keysets[1]["encryptedKeyset"].GetString());
+  EXPECT_FALSE(json_keysets[1].HasMember("keysetInfo"));
+
+  keysets.push_back(nullptr);
+  EXPECT_EQ(util::error::INVALID_ARGUMENT,
+            writer->WriteBatch(keysets).error_code());
+}
+
 TEST_F(JsonKeysetWriterTest, testDestinationStreamErrors) {
   std::stringbuf buffer;
   std::unique_ptr<std::ostream> destination_stream(new std::ostream(&buffer));
@@ -237,6 +265,11 @@ TEST_F(JsonKeysetWriterTest, testDestinationStreamErrors) {
     EXPECT_FALSE(status.ok()) << status;
     EXPECT_EQ(util::error::UNKNOWN, status.error_code());
   }
+  {  // Write a batch.
+    auto status = writer->WriteBatch({&encrypted_keyset_});
+    EXPECT_FALSE(status.ok()) << status;
+    EXPECT_EQ(util::error::UNKNOWN, status.error_code());
+  }
 }
 
 TEST_F(JsonKeysetWriterTest, WriteLargeKeyId) {
@@ -0,0 +1,155 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/key_usage_counter.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/crypto_format.h"
+#include "tink/input_stream.h"
+#include "tink/util/input_stream_util.h"
+#include "tink/util/status.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+using ::google::crypto::tink::KeysetInfo;
+using ::google::crypto::tink::OutputPrefixType;
+
+constexpr uint64_t KeyUsageCounter::kRawKey;
+
+// static
+uint64_t KeyUsageCounter::GetKey(absl::string_view output) {
+  if (output.size() < CryptoFormat::kNonRawPrefixSize) return kRawKey;
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(output.data());
+  if (bytes[0] != CryptoFormat::kTinkStartByte &&
+      bytes[0] != CryptoFormat::kLegacyStartByte) {
+    return kRawKey;
+  }
+  return (uint64_t{bytes[0]} << 32) | (uint64_t{bytes[1]} << 24) |
+         (uint64_t{bytes[2]} << 16) | (uint64_t{bytes[3]} << 8) |
+         uint64_t{bytes[4]};
+}
+
+void KeyUsageCounter::AddBatch(absl::Span<const absl::string_view> outputs) {
+  // Outputs of a batch mostly come from the same key, so runs of equal keys
+  // are counted with a single lookup.
+  size_t i = 0;
+  while (i < outputs.size()) {
+    uint64_t key = GetKey(outputs[i]);
+    size_t end = i + 1;
+    while (end < outputs.size() && GetKey(outputs[end]) == key) end++;
+    AddCount(key, end - i);
+    i = end;
+  }
+}
+
+void KeyUsageCounter::AddBatch(absl::string_view outputs,
+                               absl::Span<const int64_t> offsets) {
+  if (offsets.empty()) return;
+  auto output = [&outputs, &offsets](size_t index) {
+    return outputs.substr(offsets[index], offsets[index + 1] - offsets[index]);
+  };
+  const size_t num_outputs = offsets.size() - 1;
+  size_t i = 0;
+  while (i < num_outputs) {
+    uint64_t key = GetKey(output(i));
+    size_t end = i + 1;
+    while (end < num_outputs && GetKey(output(end)) == key) end++;
+    AddCount(key, end - i);
+    i = end;
+  }
+}
+
+util::Status KeyUsageCounter::AddFromStream(InputStream* input_stream) {
+  std::string storage;
+  auto prefix_result = ReadBytesFromStreamView(CryptoFormat::kNonRawPrefixSize,
+                                               input_stream, &storage);
+  if (!prefix_result.ok()) {
+    if (prefix_result.status().error_code() != util::error::OUT_OF_RANGE) {
+      return prefix_result.status();
+    }
+    AddCount(kRawKey, 1);
+    return util::OkStatus();
+  }
+  Add(prefix_result.ValueOrDie());
+  return util::OkStatus();
+}
+
+void KeyUsageCounter::Merge(const KeyUsageCounter& other) {
+  for (const auto& key_and_count : other.counts_) {
+    AddCount(key_and_count.first, key_and_count.second);
+  }
+}
+
+int64_t KeyUsageCounter::GetCount(const KeysetInfo::KeyInfo& key_info) const {
+  uint64_t key;
+  switch (key_info.output_prefix_type()) {
+    case OutputPrefixType::TINK:
+      key = (uint64_t{CryptoFormat::kTinkStartByte} << 32) | key_info.key_id();
+      break;
+    case OutputPrefixType::CRUNCHY:
+      // FALLTHROUGH
+    case OutputPrefixType::LEGACY:
+      key =
+          (uint64_t{CryptoFormat::kLegacyStartByte} << 32) | key_info.key_id();
+      break;
+    case OutputPrefixType::RAW:
+      key = kRawKey;
+      break;
+    default:
+      return 0;
+  }
+  auto it = counts_.find(key);
+  return it == counts_.end() ? 0 : it->second;
+}
+
+std::vector<KeyUsageCounter::KeyCount> KeyUsageCounter::GetCounts() const {
+  std::vector<KeyCount> counts;
+  counts.reserve(counts_.size());
+  for (const auto& key_and_count : counts_) {
+    KeyCount count;
+    uint64_t key = key_and_count.first;
+    if (key == kRawKey) {
+      count.output_prefix_type = OutputPrefixType::RAW;
+      count.key_id = 0;
+    } else {
+      count.output_prefix_type = (key >> 32) == CryptoFormat::kTinkStartByte
+                                     ? OutputPrefixType::TINK
+                                     : OutputPrefixType::LEGACY;
+      count.key_id = static_cast<uint32_t>(key);
+    }
+    count.count = key_and_count.second;
+    counts.push_back(count);
+  }
+  std::sort(counts.begin(), counts.end(),
+            [](const KeyCount& a, const KeyCount& b) {
+              if (a.output_prefix_type != b.output_prefix_type) {
+                return a.output_prefix_type < b.output_prefix_type;
+              }
+              return a.key_id < b.key_id;
+            });
+  return counts;
+}
+
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,141 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/key_usage_counter.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tink/crypto_format.h"
+#include "tink/util/istream_input_stream.h"
+#include "tink/util/test_matchers.h"
+#include "proto/tink.pb.h"
+
+using ::crypto::tink::test::IsOk;
+using ::google::crypto::tink::KeysetInfo;
+using ::google::crypto::tink::OutputPrefixType;
+
+namespace crypto {
+namespace tink {
+namespace {
+
+KeysetInfo::KeyInfo GetKeyInfo(uint32_t key_id,
+                               OutputPrefixType output_prefix_type) {
+  KeysetInfo::KeyInfo key_info;
+  key_info.set_key_id(key_id);
+  key_info.set_output_prefix_type(output_prefix_type);
+  return key_info;
+}
+
+std::string GetPrefixedData(uint32_t key_id,
+                            OutputPrefixType output_prefix_type) {
+  return absl::StrCat(
+      CryptoFormat::GetOutputPrefix(GetKeyInfo(key_id, output_prefix_type))
+          .ValueOrDie(),
+      "some data");
+}
+
+TEST(KeyUsageCounterTest, CountsByKey) {
+  KeyUsageCounter counter;
+  counter.Add(GetPrefixedData(1234, OutputPrefixType::TINK));
+  counter.Add(GetPrefixedData(1234, OutputPrefixType::TINK));
+  counter.Add(GetPrefixedData(1234, OutputPrefixType::LEGACY));
+  counter.Add(GetPrefixedData(5678, OutputPrefixType::CRUNCHY));
+  counter.Add(GetPrefixedData(0xffffffff, OutputPrefixType::TINK));
+  counter.Add("some unprefixed data");
+  counter.Add("");
+  EXPECT_EQ(7, counter.total());
+
+  EXPECT_EQ(2, counter.GetCount(GetKeyInfo(1234, OutputPrefixType::TINK)));
+  EXPECT_EQ(1, counter.GetCount(GetKeyInfo(1234, OutputPrefixType::LEGACY)));
+  EXPECT_EQ(1, counter.GetCount(GetKeyInfo(5678, OutputPrefixType::LEGACY)));
+  EXPECT_EQ(1, counter.GetCount(GetKeyInfo(5678, OutputPrefixType::CRUNCHY)));
+  EXPECT_EQ(1,
+            counter.GetCount(GetKeyInfo(0xffffffff, OutputPrefixType::TINK)));
+  EXPECT_EQ(2, counter.GetCount(GetKeyInfo(42, OutputPrefixType::RAW)));
+  EXPECT_EQ(0, counter.GetCount(GetKeyInfo(5678, OutputPrefixType::TINK)));
+  EXPECT_EQ(0, counter.GetCount(GetKeyInfo(42, OutputPrefixType::TINK)));
+
+  std::vector<KeyUsageCounter::KeyCount> counts = counter.GetCounts();
+  ASSERT_EQ(5, counts.size());
+  EXPECT_EQ(OutputPrefixType::TINK, counts[0].output_prefix_type);
+  EXPECT_EQ(1234, counts[0].key_id);
+  EXPECT_EQ(2, counts[0].count);
+  EXPECT_EQ(OutputPrefixType::TINK, counts[1].output_prefix_type);
+  EXPECT_EQ(0xffffffff, counts[1].key_id);
+  EXPECT_EQ(1, counts[1].count);
+  EXPECT_EQ(OutputPrefixType::LEGACY, counts[2].output_prefix_type);
+  EXPECT_EQ(1234, counts[2].key_id);
+  EXPECT_EQ(OutputPrefixType::LEGACY, counts[3].output_prefix_type);
+  EXPECT_EQ(5678, counts[3].key_id);
+  EXPECT_EQ(OutputPrefixType::RAW, counts[4].output_prefix_type);
+  EXPECT_EQ(0, counts[4].key_id);
+  EXPECT_EQ(2, counts[4].count);
+}
+
+TEST(KeyUsageCounterTest, Batches) {
+  std::string tink1 = GetPrefixedData(1, OutputPrefixType::TINK);
+  std::string tink2 = GetPrefixedData(2, OutputPrefixType::TINK);
+  std::vector<absl::string_view> outputs = {tink1, tink1, tink2, "raw",
+                                            tink1, tink1, tink1};
+  KeyUsageCounter counter;
+  counter.AddBatch(outputs);
+  EXPECT_EQ(5, counter.GetCount(GetKeyInfo(1, OutputPrefixType::TINK)));
+  EXPECT_EQ(1, counter.GetCount(GetKeyInfo(2, OutputPrefixType::TINK)));
+  EXPECT_EQ(1, counter.GetCount(GetKeyInfo(2, OutputPrefixType::RAW)));
+
+  std::string concatenated;
+  std::vector<int64_t> offsets = {0};
+  for (absl::string_view output : outputs) {
+    concatenated.append(output.data(), output.size());
+    offsets.push_back(concatenated.size());
+  }
+  KeyUsageCounter concatenated_counter;
+  concatenated_counter.AddBatch(concatenated, offsets);
+  concatenated_counter.AddBatch(concatenated, {});
+  EXPECT_EQ(7, concatenated_counter.total());
+  EXPECT_EQ(5, concatenated_counter.GetCount(
+                   GetKeyInfo(1, OutputPrefixType::TINK)));
+
+  counter.Merge(concatenated_counter);
+  EXPECT_EQ(14, counter.total());
+  EXPECT_EQ(10, counter.GetCount(GetKeyInfo(1, OutputPrefixType::TINK)));
+  EXPECT_EQ(2, counter.GetCount(GetKeyInfo(2, OutputPrefixType::RAW)));
+}
+
+TEST(KeyUsageCounterTest, Streams) {
+  KeyUsageCounter counter;
+  util::IstreamInputStream prefixed(absl::make_unique<std::stringstream>(
+      GetPrefixedData(1234, OutputPrefixType::TINK)));
+  EXPECT_THAT(counter.AddFromStream(&prefixed), IsOk());
+  util::IstreamInputStream short_stream(
+      absl::make_unique<std::stringstream>("\x01\x02"));
+  EXPECT_THAT(counter.AddFromStream(&short_stream), IsOk());
+  EXPECT_EQ(2, counter.total());
+  EXPECT_EQ(1, counter.GetCount(GetKeyInfo(1234, OutputPrefixType::TINK)));
+  EXPECT_EQ(1, counter.GetCount(GetKeyInfo(1, OutputPrefixType::RAW)));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
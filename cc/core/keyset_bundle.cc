@@ -0,0 +1,262 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/keyset_bundle.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TINK_KEYSET_BUNDLE_MMAP 1
+#endif
+
+#include "absl/strings/string_view.h"
+#include "openssl/sha.h"
+#include "tink/aead.h"
+#include "tink/cleartext_keyset_handle.h"
+#include "tink/keyset_handle.h"
+#include "tink/util/errors.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "tink/util/validation.h"
+#include "proto/tink.pb.h"
+
+using google::crypto::tink::Keyset;
+
+namespace crypto {
+namespace tink {
+
+constexpr uint8_t KeysetBundle::kVersion;
+
+namespace {
+
+constexpr char kMagic[] = "TINKBNDL";
+constexpr size_t kMagicSize = 8;
+constexpr size_t kVersionOffset = 8;
+constexpr size_t kFlagsOffset = 9;
+constexpr size_t kPrimaryKeyIdOffset = 12;
+constexpr size_t kKeyCountOffset = 16;
+constexpr size_t kPayloadSizeOffset = 20;
+// The part of the header covered by the checksum and, for encrypted
+// payloads, used as associated data.
+constexpr size_t kPrefixSize = 24;
+constexpr size_t kHeaderSize = kPrefixSize + SHA256_DIGEST_LENGTH;
+constexpr uint8_t kEncryptedFlag = 0x01;
+
+void PutUint32(uint32_t value, char* out) {
+  out[0] = static_cast<char>(value >> 24);
+  out[1] = static_cast<char>(value >> 16);
+  out[2] = static_cast<char>(value >> 8);
+  out[3] = static_cast<char>(value);
+}
+
+uint32_t GetUint32(const char* in) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(in);
+  return (static_cast<uint32_t>(bytes[0]) << 24) |
+         (static_cast<uint32_t>(bytes[1]) << 16) |
+         (static_cast<uint32_t>(bytes[2]) << 8) |
+         static_cast<uint32_t>(bytes[3]);
+}
+
+void Checksum(absl::string_view prefix, absl::string_view payload,
+              uint8_t digest[SHA256_DIGEST_LENGTH]) {
+  SHA256_CTX context;
+  SHA256_Init(&context);
+  SHA256_Update(&context, prefix.data(), prefix.size());
+  SHA256_Update(&context, payload.data(), payload.size());
+  SHA256_Final(digest, &context);
+}
+
+}  // namespace
+
+// static
+util::StatusOr<std::string> KeysetBundle::Build(
+    const KeysetHandle& keyset_handle, const Aead* kek) {
+  const Keyset& keyset = CleartextKeysetHandle::GetKeyset(keyset_handle);
+  util::Status status = ValidateKeyset(keyset);
+  if (!status.ok()) return status;
+  util::SecretData serialized_keyset(keyset.ByteSizeLong());
+  if (!keyset.SerializeToArray(serialized_keyset.data(),
+                               serialized_keyset.size())) {
+    return util::Status(util::error::INTERNAL,
+                        "Could not serialize the keyset.");
+  }
+
+  std::string prefix(kPrefixSize, '\0');
+  memcpy(&prefix[0], kMagic, kMagicSize);
+  prefix[kVersionOffset] = static_cast<char>(kVersion);
+  prefix[kFlagsOffset] = static_cast<char>(kek == nullptr ? 0 : kEncryptedFlag);
+  PutUint32(keyset.primary_key_id(), &prefix[kPrimaryKeyIdOffset]);
+  PutUint32(keyset.key_size(), &prefix[kKeyCountOffset]);
+
+  std::string encrypted_keyset;
+  absl::string_view payload = util::SecretDataAsStringView(serialized_keyset);
+  if (kek != nullptr) {
+    auto encrypt_result = kek->Encrypt(payload, prefix);
+    if (!encrypt_result.ok()) return encrypt_result.status();
+    encrypted_keyset = std::move(encrypt_result.ValueOrDie());
+    payload = encrypted_keyset;
+  }
+  if (payload.size() > UINT32_MAX) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "The keyset is too large for a bundle.");
+  }
+  PutUint32(payload.size(), &prefix[kPayloadSizeOffset]);
+
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  Checksum(prefix, payload, digest);
+  std::string bundle;
+  bundle.reserve(kHeaderSize + payload.size());
+  bundle.append(prefix);
+  bundle.append(reinterpret_cast<const char*>(digest), sizeof(digest));
+  bundle.append(payload.data(), payload.size());
+  return bundle;
+}
+
+// static
+util::StatusOr<std::unique_ptr<KeysetHandle>> KeysetBundle::Load(
+    absl::string_view bundle, const Aead* kek) {
+  if (bundle.size() < kHeaderSize ||
+      memcmp(bundle.data(), kMagic, kMagicSize) != 0) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Not a keyset bundle.");
+  }
+  uint8_t version = static_cast<uint8_t>(bundle[kVersionOffset]);
+  if (version != kVersion) {
+    return ToStatusF(util::error::UNIMPLEMENTED,
+                     "Unsupported keyset bundle version: %d", version);
+  }
+  uint8_t flags = static_cast<uint8_t>(bundle[kFlagsOffset]);
+  if ((flags & ~kEncryptedFlag) != 0) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "Unknown keyset bundle flags.");
+  }
+  bool encrypted = (flags & kEncryptedFlag) != 0;
+  if (encrypted != (kek != nullptr)) {
+    return util::Status(util::error::FAILED_PRECONDITION,
+                        encrypted ? "The keyset bundle is encrypted."
+                                  : "The keyset bundle is not encrypted.");
+  }
+  uint32_t payload_size = GetUint32(bundle.data() + kPayloadSizeOffset);
+  if (bundle.size() - kHeaderSize != payload_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "The keyset bundle is truncated.");
+  }
+  absl::string_view prefix = bundle.substr(0, kPrefixSize);
+  absl::string_view payload = bundle.substr(kHeaderSize);
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  Checksum(prefix, payload, digest);
+  if (memcmp(digest, bundle.data() + kPrefixSize, sizeof(digest)) != 0) {
+    return util::Status(util::error::DATA_LOSS,
+                        "The keyset bundle checksum does not match.");
+  }
+
+  Keyset keyset;
+  bool parsed;
+  if (encrypted) {
+    auto decrypt_result = kek->Decrypt(payload, prefix);
+    if (!decrypt_result.ok()) return decrypt_result.status();
+    util::SecretData serialized_keyset =
+        util::SecretDataFromStringView(decrypt_result.ValueOrDie());
+    util::SafeZeroString(&decrypt_result.ValueOrDie());
+    parsed = keyset.ParseFromArray(serialized_keyset.data(),
+                                   serialized_keyset.size());
+  } else {
+    parsed = keyset.ParseFromArray(payload.data(), payload.size());
+  }
+  if (!parsed) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "Could not parse the keyset bundle as a Keyset-proto.");
+  }
+  // The keyset was validated by Build(); only check that it is the one the
+  // header describes.
+  uint32_t primary_key_id = GetUint32(bundle.data() + kPrimaryKeyIdOffset);
+  uint32_t key_count = GetUint32(bundle.data() + kKeyCountOffset);
+  if (keyset.primary_key_id() != primary_key_id ||
+      static_cast<uint32_t>(keyset.key_size()) != key_count) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "The keyset does not match the keyset bundle header.");
+  }
+  return CleartextKeysetHandle::GetKeysetHandle(keyset);
+}
+
+#ifdef TINK_KEYSET_BUNDLE_MMAP
+
+// static
+util::StatusOr<std::unique_ptr<KeysetHandle>> KeysetBundle::LoadFile(
+    const std::string& path, const Aead* kek) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return ToStatusF(util::error::NOT_FOUND, "Could not open '%s': %d",
+                     path.c_str(), errno);
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) < 0) {
+    int stat_errno = errno;
+    close(fd);
+    return ToStatusF(util::error::INTERNAL, "I/O error upon fstat: %d",
+                     stat_errno);
+  }
+  size_t size = file_stat.st_size;
+  if (size == 0) {
+    close(fd);
+    return Load(absl::string_view(), kek);
+  }
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  int map_errno = errno;
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return ToStatusF(util::error::INTERNAL, "Could not map '%s': %d",
+                     path.c_str(), map_errno);
+  }
+  auto result =
+      Load(absl::string_view(static_cast<const char*>(mapping), size), kek);
+  munmap(mapping, size);
+  return result;
+}
+
+#else
+
+// static
+util::StatusOr<std::unique_ptr<KeysetHandle>> KeysetBundle::LoadFile(
+    const std::string& path, const Aead* kek) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return ToStatusF(util::error::NOT_FOUND, "Could not open '%s'.",
+                     path.c_str());
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  if (file.bad()) {
+    return ToStatusF(util::error::INTERNAL, "Could not read '%s'.",
+                     path.c_str());
+  }
+  return Load(buffer.str(), kek);
+}
+
+#endif
+
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,154 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/keyset_bundle.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/cleartext_keyset_handle.h"
+#include "tink/config/tink_config.h"
+#include "tink/keyset_handle.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+class KeysetBundleTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_THAT(TinkConfig::Register(), IsOk());
+    auto handle_result =
+        KeysetHandle::GenerateNew(AeadKeyTemplates::Aes128Gcm());
+    ASSERT_THAT(handle_result.status(), IsOk());
+    handle_ = std::move(handle_result.ValueOrDie());
+  }
+
+  void ExpectSameKeyset(const KeysetHandle& loaded) {
+    EXPECT_EQ(CleartextKeysetHandle::GetKeyset(*handle_).SerializeAsString(),
+              CleartextKeysetHandle::GetKeyset(loaded).SerializeAsString());
+  }
+
+  std::unique_ptr<KeysetHandle> handle_;
+};
+
+TEST_F(KeysetBundleTest, BuildAndLoad) {
+  auto bundle_result = KeysetBundle::Build(*handle_);
+  ASSERT_THAT(bundle_result.status(), IsOk());
+  auto loaded_result = KeysetBundle::Load(bundle_result.ValueOrDie());
+  ASSERT_THAT(loaded_result.status(), IsOk());
+  ExpectSameKeyset(*loaded_result.ValueOrDie());
+
+  // The loaded keyset is usable.
+  auto aead_result = loaded_result.ValueOrDie()->GetPrimitive<Aead>();
+  ASSERT_THAT(aead_result.status(), IsOk());
+  auto ciphertext =
+      handle_->GetPrimitive<Aead>().ValueOrDie()->Encrypt("plaintext", "ad");
+  ASSERT_THAT(ciphertext.status(), IsOk());
+  auto plaintext =
+      aead_result.ValueOrDie()->Decrypt(ciphertext.ValueOrDie(), "ad");
+  ASSERT_THAT(plaintext.status(), IsOk());
+  EXPECT_EQ(plaintext.ValueOrDie(), "plaintext");
+}
+
+TEST_F(KeysetBundleTest, EncryptedWithKek) {
+  test::DummyAead kek("kek");
+  auto bundle_result = KeysetBundle::Build(*handle_, &kek);
+  ASSERT_THAT(bundle_result.status(), IsOk());
+  const std::string& bundle = bundle_result.ValueOrDie();
+  auto loaded_result = KeysetBundle::Load(bundle, &kek);
+  ASSERT_THAT(loaded_result.status(), IsOk());
+  ExpectSameKeyset(*loaded_result.ValueOrDie());
+
+  test::DummyAead other_kek("other kek");
+  EXPECT_FALSE(KeysetBundle::Load(bundle, &other_kek).ok());
+  EXPECT_THAT(KeysetBundle::Load(bundle).status(),
+              StatusIs(util::error::FAILED_PRECONDITION));
+  EXPECT_THAT(
+      KeysetBundle::Load(KeysetBundle::Build(*handle_).ValueOrDie(), &kek)
+          .status(),
+      StatusIs(util::error::FAILED_PRECONDITION));
+}
+
+TEST_F(KeysetBundleTest, DetectsCorruption) {
+  std::string bundle = KeysetBundle::Build(*handle_).ValueOrDie();
+  for (size_t i : {size_t{12}, size_t{30}, bundle.size() - 1}) {
+    std::string corrupted = bundle;
+    corrupted[i] ^= 1;
+    EXPECT_THAT(KeysetBundle::Load(corrupted).status(),
+                StatusIs(util::error::DATA_LOSS))
+        << i;
+  }
+  EXPECT_THAT(KeysetBundle::Load(bundle.substr(0, bundle.size() - 1)).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(KeysetBundle::Load(absl::StrCat(bundle, "x")).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(KeysetBundleTest, RejectsOtherFormats) {
+  std::string bundle = KeysetBundle::Build(*handle_).ValueOrDie();
+  EXPECT_THAT(KeysetBundle::Load("").status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  std::string serialized_keyset =
+      CleartextKeysetHandle::GetKeyset(*handle_).SerializeAsString();
+  EXPECT_THAT(KeysetBundle::Load(serialized_keyset).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  std::string future_version = bundle;
+  future_version[8] = KeysetBundle::kVersion + 1;
+  EXPECT_THAT(KeysetBundle::Load(future_version).status(),
+              StatusIs(util::error::UNIMPLEMENTED));
+}
+
+TEST_F(KeysetBundleTest, BuildValidatesKeyset) {
+  google::crypto::tink::Keyset keyset =
+      CleartextKeysetHandle::GetKeyset(*handle_);
+  keyset.set_primary_key_id(keyset.primary_key_id() + 1);
+  auto invalid_handle = CleartextKeysetHandle::GetKeysetHandle(keyset);
+  EXPECT_THAT(KeysetBundle::Build(*invalid_handle).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(KeysetBundleTest, LoadFile) {
+  test::DummyAead kek("kek");
+  std::string path = absl::StrCat(test::TmpDir(), "/keyset_bundle_test.bin");
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << KeysetBundle::Build(*handle_, &kek).ValueOrDie();
+  }
+  auto loaded_result = KeysetBundle::LoadFile(path, &kek);
+  ASSERT_THAT(loaded_result.status(), IsOk());
+  ExpectSameKeyset(*loaded_result.ValueOrDie());
+
+  EXPECT_THAT(KeysetBundle::LoadFile(absl::StrCat(path, ".missing"), &kek)
+                  .status(),
+              StatusIs(util::error::NOT_FOUND));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
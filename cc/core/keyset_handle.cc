@@ -15,16 +15,28 @@
 ///////////////////////////////////////////////////////////////////////////////
 #include "tink/keyset_handle.h"
 
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <typeindex>
+#include <utility>
+#include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
 #include "tink/aead.h"
 #include "tink/internal/key_info.h"
+#include "tink/internal/memory_usage.h"
+#include "tink/keyset_read_cache.h"
 #include "tink/keyset_reader.h"
 #include "tink/keyset_writer.h"
 #include "tink/registry.h"
+#include "tink/tracing.h"
 #include "tink/util/errors.h"
+#include "tink/util/executor.h"
 #include "tink/util/keyset_util.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/validation.h"
 #include "proto/tink.pb.h"
 
 using google::crypto::tink::EncryptedKeyset;
@@ -62,6 +74,39 @@ Decrypt(const EncryptedKeyset& enc_keyset, const Aead& master_key_aead) {
   return std::move(keyset);
 }
 
+// Returns the keyset in 'enc_keyset' from 'cache', where it has the given
+// 'digest', or decrypts it with 'master_key_aead' and adds it to 'cache'.
+util::StatusOr<std::unique_ptr<Keyset>> DecryptCached(
+    const EncryptedKeyset& enc_keyset, const Aead& master_key_aead,
+    KeysetReadCache* cache, absl::string_view digest) {
+  auto keyset = absl::make_unique<Keyset>();
+  auto cached_keyset = cache->Get(digest);
+  if (cached_keyset != nullptr) {
+    if (!keyset->ParseFromArray(cached_keyset->data(),
+                                cached_keyset->size())) {
+      return util::Status(util::error::INTERNAL,
+                          "Could not parse the cached Keyset-proto.");
+    }
+    return std::move(keyset);
+  }
+  internal::ScopedSpan span("tink.keyset_handle.decrypt_keyset");
+  auto decrypt_result = master_key_aead.Decrypt(
+          enc_keyset.encrypted_keyset(), /* associated_data= */ "");
+  span.set_status(decrypt_result.status());
+  if (!decrypt_result.ok()) return decrypt_result.status();
+  std::string& serialized_keyset = decrypt_result.ValueOrDie();
+  bool parsed = keyset->ParseFromString(serialized_keyset);
+  if (parsed) {
+    cache->Put(digest, util::SecretDataFromStringView(serialized_keyset));
+  }
+  util::SafeZeroString(&serialized_keyset);
+  if (!parsed) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+        "Could not parse the decrypted data as a Keyset-proto.");
+  }
+  return std::move(keyset);
+}
+
 util::Status ValidateNoSecret(const Keyset& keyset) {
   for (const Keyset::Key& key : keyset.key()) {
     if (key.key_data().key_material_type() == KeyData::UNKNOWN_KEYMATERIAL ||
@@ -88,8 +133,10 @@ util::StatusOr<std::unique_ptr<KeysetHandle>> KeysetHandle::Read(
                      enc_keyset_result.status().error_message());
   }
 
+  internal::ScopedSpan span("tink.keyset_handle.decrypt_keyset");
   auto keyset_result =
       Decrypt(*enc_keyset_result.ValueOrDie(), master_key_aead);
+  span.set_status(keyset_result.status());
   if (!keyset_result.ok()) {
     return ToStatusF(util::error::INVALID_ARGUMENT,
                      "Error decrypting encrypted keyset: %s",
@@ -101,6 +148,144 @@ util::StatusOr<std::unique_ptr<KeysetHandle>> KeysetHandle::Read(
   return std::move(handle);
 }
 
+// static
+util::StatusOr<std::unique_ptr<KeysetHandle>> KeysetHandle::Read(
+    std::unique_ptr<KeysetReader> reader, const Aead& master_key_aead,
+    KeysetReadCache* cache) {
+  if (cache == nullptr) return Read(std::move(reader), master_key_aead);
+  auto enc_keyset_result = reader->ReadEncrypted();
+  if (!enc_keyset_result.ok()) {
+    return ToStatusF(util::error::INVALID_ARGUMENT,
+                     "Error reading encrypted keyset data: %s",
+                     enc_keyset_result.status().error_message());
+  }
+  const EncryptedKeyset& enc_keyset = *enc_keyset_result.ValueOrDie();
+  auto keyset_result =
+      DecryptCached(enc_keyset, master_key_aead, cache,
+                    KeysetReadCache::Digest(enc_keyset.encrypted_keyset()));
+  if (!keyset_result.ok()) {
+    return ToStatusF(util::error::INVALID_ARGUMENT,
+                     "Error decrypting encrypted keyset: %s",
+                     keyset_result.status().error_message());
+  }
+  return absl::WrapUnique(
+      new KeysetHandle(std::move(keyset_result.ValueOrDie())));
+}
+
+// static
+util::StatusOr<std::unique_ptr<KeysetHandle>> KeysetHandle::ReadIfChanged(
+    std::unique_ptr<KeysetReader> reader, const Aead& master_key_aead,
+    KeysetReadCache* cache, std::string* digest) {
+  if (digest == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "digest must be non-null");
+  }
+  auto enc_keyset_result = reader->ReadEncrypted();
+  if (!enc_keyset_result.ok()) {
+    return ToStatusF(util::error::INVALID_ARGUMENT,
+                     "Error reading encrypted keyset data: %s",
+                     enc_keyset_result.status().error_message());
+  }
+  const EncryptedKeyset& enc_keyset = *enc_keyset_result.ValueOrDie();
+  std::string new_digest =
+      KeysetReadCache::Digest(enc_keyset.encrypted_keyset());
+  if (new_digest == *digest) return std::unique_ptr<KeysetHandle>(nullptr);
+  auto keyset_result = [&]() -> util::StatusOr<std::unique_ptr<Keyset>> {
+    if (cache != nullptr) {
+      return DecryptCached(enc_keyset, master_key_aead, cache, new_digest);
+    }
+    internal::ScopedSpan span("tink.keyset_handle.decrypt_keyset");
+    auto result = Decrypt(enc_keyset, master_key_aead);
+    span.set_status(result.status());
+    return result;
+  }();
+  if (!keyset_result.ok()) {
+    return ToStatusF(util::error::INVALID_ARGUMENT,
+                     "Error decrypting encrypted keyset: %s",
+                     keyset_result.status().error_message());
+  }
+  *digest = std::move(new_digest);
+  return absl::WrapUnique(
+      new KeysetHandle(std::move(keyset_result.ValueOrDie())));
+}
+
+// static
+util::StatusOr<std::vector<std::unique_ptr<KeysetHandle>>>
+KeysetHandle::ReadMany(std::vector<std::unique_ptr<KeysetReader>> readers,
+                       const Aead& master_key_aead, int num_threads) {
+  if (num_threads < 1) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "num_threads must be positive");
+  }
+  std::vector<std::unique_ptr<EncryptedKeyset>> enc_keysets;
+  enc_keysets.reserve(readers.size());
+  for (size_t i = 0; i < readers.size(); i++) {
+    if (readers[i] == nullptr) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "Readers must be non-null");
+    }
+    auto enc_keyset_result = readers[i]->ReadEncrypted();
+    if (!enc_keyset_result.ok()) {
+      return ToStatusF(util::error::INVALID_ARGUMENT,
+                       "Error reading encrypted keyset data %d: %s", i,
+                       enc_keyset_result.status().error_message());
+    }
+    enc_keysets.push_back(std::move(enc_keyset_result.ValueOrDie()));
+  }
+
+  std::vector<absl::string_view> ciphertexts;
+  ciphertexts.reserve(enc_keysets.size());
+  for (const auto& enc_keyset : enc_keysets) {
+    ciphertexts.push_back(enc_keyset->encrypted_keyset());
+  }
+  std::vector<absl::string_view> associated_data(ciphertexts.size(), "");
+  std::string plaintexts;
+  std::vector<int64_t> offsets;
+  util::Status status;
+  {
+    internal::ScopedSpan span("tink.keyset_handle.decrypt_keysets");
+    span.SetAttribute("keysets", ciphertexts.size());
+    status = master_key_aead.DecryptBatch(ciphertexts, associated_data,
+                                          &plaintexts, &offsets);
+    span.set_status(status);
+  }
+  if (!status.ok()) {
+    return ToStatusF(util::error::INVALID_ARGUMENT,
+                     "Error decrypting encrypted keysets: %s",
+                     status.error_message());
+  }
+
+  // The errors are reported for the first failing keyset, independent of
+  // 'num_threads'.
+  std::vector<std::unique_ptr<Keyset>> keysets(enc_keysets.size());
+  std::vector<util::Status> statuses(enc_keysets.size());
+  util::ParallelFor(keysets.size(), num_threads, [&](int64_t i) {
+    auto keyset = absl::make_unique<Keyset>();
+    if (!keyset->ParseFromArray(plaintexts.data() + offsets[i],
+                                offsets[i + 1] - offsets[i])) {
+      statuses[i] = util::Status(
+          util::error::INVALID_ARGUMENT,
+          "Could not parse the decrypted data as a Keyset-proto.");
+      return;
+    }
+    statuses[i] = ValidateKeyset(*keyset);
+    keysets[i] = std::move(keyset);
+  });
+
+  std::vector<std::unique_ptr<KeysetHandle>> handles;
+  handles.reserve(keysets.size());
+  for (size_t i = 0; i < keysets.size(); i++) {
+    if (!statuses[i].ok()) {
+      return ToStatusF(util::error::INVALID_ARGUMENT,
+                       "Error loading encrypted keyset %d: %s", i,
+                       statuses[i].error_message());
+    }
+    handles.push_back(
+        absl::WrapUnique(new KeysetHandle(std::move(keysets[i]))));
+  }
+  return std::move(handles);
+}
+
 // static
 util::StatusOr<std::unique_ptr<KeysetHandle>> KeysetHandle::ReadNoSecret(
     const std::string& serialized_keyset) {
@@ -207,11 +392,24 @@ KeysetInfo KeysetHandle::GetKeysetInfo() const {
   return KeysetInfoFromKeyset(get_keyset());
 }
 
+size_t KeysetHandle::EstimateMemoryUsage() const {
+  size_t usage = sizeof(*this) + internal::KeysetMemoryUsage(get_keyset());
+  // The cache is shared between copies of a handle; count it in full anyway.
+  // Each slot of the map holds an entry and a control byte.
+  absl::MutexLock lock(&primitive_cache_->mutex);
+  usage += sizeof(PrimitiveCache) +
+           primitive_cache_->primitives.capacity() *
+               (sizeof(std::pair<std::type_index, std::shared_ptr<void>>) + 1);
+  return usage;
+}
+
 KeysetHandle::KeysetHandle(Keyset keyset)
-    : keyset_(std::move(keyset)) {}
+    : keyset_(std::move(keyset)),
+      primitive_cache_(std::make_shared<PrimitiveCache>()) {}
 
 KeysetHandle::KeysetHandle(std::unique_ptr<Keyset> keyset)
-    : keyset_(std::move(*keyset)) {}
+    : keyset_(std::move(*keyset)),
+      primitive_cache_(std::make_shared<PrimitiveCache>()) {}
 
 const Keyset& KeysetHandle::get_keyset() const {
   return keyset_;
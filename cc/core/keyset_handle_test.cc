@@ -17,6 +17,11 @@
 #include "tink/core/key_manager_impl.h"
 #include "tink/keyset_handle.h"
 
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "tink/aead/aead_key_templates.h"
 #include "tink/aead/aead_wrapper.h"
@@ -25,8 +30,10 @@
 #include "tink/binary_keyset_reader.h"
 #include "tink/cleartext_keyset_handle.h"
 #include "tink/config/tink_config.h"
+#include "tink/crypto_format.h"
 #include "tink/json_keyset_reader.h"
 #include "tink/json_keyset_writer.h"
+#include "tink/keyset_read_cache.h"
 #include "tink/signature/ecdsa_sign_key_manager.h"
 #include "tink/signature/signature_key_templates.h"
 #include "tink/util/protobuf_helper.h"
@@ -460,6 +467,148 @@ TEST_F(KeysetHandleTest, GetPrimitiveCustomKeyManager) {
   ASSERT_TRUE(handle->GetPrimitive<Aead>(key_manager.get()).ok());
 }
 
+TEST_F(KeysetHandleTest, GetPrimitiveInParallel) {
+  Keyset keyset;
+  for (int i = 0; i < 20; ++i) {
+    AddKeyData(
+        *Registry::NewKeyData(AeadKeyTemplates::Aes128Gcm()).ValueOrDie(),
+        /*key_id=*/i, OutputPrefixType::TINK, KeyStatusType::ENABLED, &keyset);
+  }
+  keyset.set_primary_key_id(13);
+  std::unique_ptr<KeysetHandle> keyset_handle =
+      TestKeysetHandle::GetKeysetHandle(keyset);
+
+  auto sequential_result = keyset_handle->GetPrimitive<Aead>();
+  ASSERT_THAT(sequential_result.status(), IsOk());
+  auto parallel_result = keyset_handle->GetPrimitiveInParallel<Aead>(4);
+  ASSERT_THAT(parallel_result.status(), IsOk());
+
+  // Both use the same primary, and can decrypt each other's ciphertexts.
+  std::string ciphertext =
+      parallel_result.ValueOrDie()->Encrypt("plaintext", "aad").ValueOrDie();
+  std::unique_ptr<Aead> primary =
+      Registry::GetPrimitive<Aead>(keyset.key(13).key_data()).ValueOrDie();
+  std::string raw_ciphertext =
+      ciphertext.substr(CryptoFormat::kNonRawPrefixSize);
+  EXPECT_THAT(primary->Decrypt(raw_ciphertext, "aad").status(), IsOk());
+  auto decrypt_result =
+      sequential_result.ValueOrDie()->Decrypt(ciphertext, "aad");
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ(decrypt_result.ValueOrDie(), "plaintext");
+
+  EXPECT_THAT(keyset_handle->GetPrimitiveInParallel<Aead>(0).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(KeysetHandleTest, GetLazyPrimitive) {
+  Keyset keyset;
+  for (int i = 0; i < 5; ++i) {
+    AddKeyData(
+        *Registry::NewKeyData(AeadKeyTemplates::Aes128Gcm()).ValueOrDie(),
+        /*key_id=*/i, OutputPrefixType::TINK, KeyStatusType::ENABLED, &keyset);
+  }
+  keyset.set_primary_key_id(3);
+  std::unique_ptr<KeysetHandle> keyset_handle =
+      TestKeysetHandle::GetKeysetHandle(keyset);
+  auto eager_result = keyset_handle->GetPrimitive<Aead>();
+  ASSERT_THAT(eager_result.status(), IsOk());
+  auto lazy_result = keyset_handle->GetLazyPrimitive<Aead>();
+  ASSERT_THAT(lazy_result.status(), IsOk());
+
+  // Ciphertexts of a non-primary key are decrypted with the primitive that is
+  // created on first use.
+  keyset.set_primary_key_id(1);
+  std::string ciphertext = TestKeysetHandle::GetKeysetHandle(keyset)
+                               ->GetPrimitive<Aead>()
+                               .ValueOrDie()
+                               ->Encrypt("plaintext", "aad")
+                               .ValueOrDie();
+  for (int i = 0; i < 2; ++i) {
+    auto decrypt_result = lazy_result.ValueOrDie()->Decrypt(ciphertext, "aad");
+    ASSERT_THAT(decrypt_result.status(), IsOk());
+    EXPECT_EQ(decrypt_result.ValueOrDie(), "plaintext");
+  }
+
+  // The primary key is used for encryption, just as with GetPrimitive().
+  std::string primary_ciphertext =
+      lazy_result.ValueOrDie()->Encrypt("plaintext", "aad").ValueOrDie();
+  auto decrypt_result =
+      eager_result.ValueOrDie()->Decrypt(primary_ciphertext, "aad");
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ(decrypt_result.ValueOrDie(), "plaintext");
+}
+
+TEST_F(KeysetHandleTest, GetCachedPrimitive) {
+  auto handle_result = KeysetHandle::GenerateNew(AeadKeyTemplates::Aes128Gcm());
+  ASSERT_TRUE(handle_result.ok()) << handle_result.status();
+  std::unique_ptr<KeysetHandle> handle = std::move(handle_result.ValueOrDie());
+
+  auto first_result = handle->GetCachedPrimitive<Aead>();
+  ASSERT_THAT(first_result.status(), IsOk());
+  auto second_result = handle->GetCachedPrimitive<Aead>();
+  ASSERT_THAT(second_result.status(), IsOk());
+  EXPECT_EQ(first_result.ValueOrDie(), second_result.ValueOrDie());
+
+  // The cached primitive is interchangeable with an uncached one.
+  std::unique_ptr<Aead> aead = handle->GetPrimitive<Aead>().ValueOrDie();
+  std::string ciphertext = aead->Encrypt("plaintext", "aad").ValueOrDie();
+  auto decrypt_result = first_result.ValueOrDie()->Decrypt(ciphertext, "aad");
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ(decrypt_result.ValueOrDie(), "plaintext");
+}
+
+TEST_F(KeysetHandleTest, GetCachedPrimitiveSharedByCopies) {
+  auto handle_result = KeysetHandle::GenerateNew(AeadKeyTemplates::Aes128Gcm());
+  ASSERT_TRUE(handle_result.ok()) << handle_result.status();
+  std::unique_ptr<KeysetHandle> handle = std::move(handle_result.ValueOrDie());
+  std::shared_ptr<Aead> aead = handle->GetCachedPrimitive<Aead>().ValueOrDie();
+
+  KeysetHandle handle_copy = *handle;
+  EXPECT_EQ(handle_copy.GetCachedPrimitive<Aead>().ValueOrDie(), aead);
+
+  // A handle with a different keyset has its own cache, also after being
+  // assigned to a copy.
+  auto other_result = KeysetHandle::GenerateNew(AeadKeyTemplates::Aes128Gcm());
+  ASSERT_TRUE(other_result.ok()) << other_result.status();
+  handle_copy = *other_result.ValueOrDie();
+  std::shared_ptr<Aead> other_aead =
+      handle_copy.GetCachedPrimitive<Aead>().ValueOrDie();
+  EXPECT_NE(other_aead, aead);
+  std::string ciphertext = aead->Encrypt("plaintext", "aad").ValueOrDie();
+  EXPECT_FALSE(other_aead->Decrypt(ciphertext, "aad").ok());
+}
+
+TEST_F(KeysetHandleTest, GetCachedPrimitiveDoesNotCacheErrors) {
+  auto handle_result = KeysetHandle::GenerateNew(AeadKeyTemplates::Aes128Gcm());
+  ASSERT_TRUE(handle_result.ok()) << handle_result.status();
+  std::unique_ptr<KeysetHandle> handle = std::move(handle_result.ValueOrDie());
+  Registry::Reset();
+  EXPECT_FALSE(handle->GetCachedPrimitive<Aead>().ok());
+
+  ASSERT_THAT(TinkConfig::Register(), IsOk());
+  EXPECT_THAT(handle->GetCachedPrimitive<Aead>().status(), IsOk());
+}
+
+TEST_F(KeysetHandleTest, GetCachedPrimitiveConcurrently) {
+  auto handle_result = KeysetHandle::GenerateNew(AeadKeyTemplates::Aes128Gcm());
+  ASSERT_TRUE(handle_result.ok()) << handle_result.status();
+  std::unique_ptr<KeysetHandle> handle = std::move(handle_result.ValueOrDie());
+
+  const int kThreads = 8;
+  std::vector<std::shared_ptr<Aead>> aeads(kThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&handle, &aeads, i]() {
+      aeads[i] = handle->GetCachedPrimitive<Aead>().ValueOrDie();
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (const auto& aead : aeads) {
+    EXPECT_NE(aead, nullptr);
+    EXPECT_EQ(aead, aeads[0]);
+  }
+}
+
 // Compile time check: ensures that the KeysetHandle can be copied.
 TEST_F(KeysetHandleTest, Copiable) {
   auto handle_result = KeysetHandle::GenerateNew(AeadKeyTemplates::Aes128Eax());
@@ -468,6 +617,226 @@ TEST_F(KeysetHandleTest, Copiable) {
   KeysetHandle handle_copy = *handle;
 }
 
+// Returns a reader for 'keyset' encrypted with 'aead'.
+std::unique_ptr<KeysetReader> EncryptedKeysetReader(const Keyset& keyset,
+                                                    const Aead& aead) {
+  EncryptedKeyset encrypted_keyset;
+  encrypted_keyset.set_encrypted_keyset(
+      aead.Encrypt(keyset.SerializeAsString(), /* associated_data= */ "")
+          .ValueOrDie());
+  return std::move(
+      BinaryKeysetReader::New(encrypted_keyset.SerializeAsString())
+          .ValueOrDie());
+}
+
+TEST_F(KeysetHandleTest, ReadMany) {
+  DummyAead aead("dummy aead 42");
+  std::vector<Keyset> keysets(10);
+  for (size_t i = 0; i < keysets.size(); i++) {
+    Keyset::Key key;
+    AddTinkKey("some key type", 42 + i, key, KeyStatusType::ENABLED,
+               KeyData::SYMMETRIC, &keysets[i]);
+    AddRawKey("some other key type", 711, key, KeyStatusType::ENABLED,
+              KeyData::SYMMETRIC, &keysets[i]);
+    keysets[i].set_primary_key_id(42 + i);
+  }
+
+  for (int num_threads : {1, 3, 20}) {
+    std::vector<std::unique_ptr<KeysetReader>> readers;
+    for (const Keyset& keyset : keysets) {
+      readers.push_back(EncryptedKeysetReader(keyset, aead));
+    }
+    auto result = KeysetHandle::ReadMany(std::move(readers), aead, num_threads);
+    ASSERT_THAT(result.status(), IsOk());
+    ASSERT_EQ(result.ValueOrDie().size(), keysets.size());
+    for (size_t i = 0; i < keysets.size(); i++) {
+      EXPECT_EQ(keysets[i].SerializeAsString(),
+                TestKeysetHandle::GetKeyset(*result.ValueOrDie()[i])
+                    .SerializeAsString());
+    }
+  }
+
+  auto empty_result = KeysetHandle::ReadMany({}, aead);
+  ASSERT_THAT(empty_result.status(), IsOk());
+  EXPECT_TRUE(empty_result.ValueOrDie().empty());
+}
+
+TEST_F(KeysetHandleTest, ReadManyFailures) {
+  DummyAead aead("dummy aead 42");
+  Keyset keyset;
+  Keyset::Key key;
+  AddTinkKey("some key type", 42, key, KeyStatusType::ENABLED,
+             KeyData::SYMMETRIC, &keyset);
+  keyset.set_primary_key_id(42);
+  Keyset keyset_without_primary = keyset;
+  keyset_without_primary.set_primary_key_id(43);
+
+  {  // AEAD does not match one of the ciphertexts.
+    std::vector<std::unique_ptr<KeysetReader>> readers;
+    readers.push_back(EncryptedKeysetReader(keyset, aead));
+    readers.push_back(EncryptedKeysetReader(keyset, DummyAead("wrong aead")));
+    EXPECT_THAT(KeysetHandle::ReadMany(std::move(readers), aead).status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+
+  {  // One of the keysets is invalid.
+    std::vector<std::unique_ptr<KeysetReader>> readers;
+    readers.push_back(EncryptedKeysetReader(keyset, aead));
+    readers.push_back(EncryptedKeysetReader(keyset_without_primary, aead));
+    EXPECT_THAT(KeysetHandle::ReadMany(std::move(readers), aead, 2).status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+
+  {  // Ciphertext does not contain an actual keyset.
+    EncryptedKeyset encrypted_keyset;
+    encrypted_keyset.set_encrypted_keyset(
+        aead.Encrypt("not a serialized keyset", "").ValueOrDie());
+    std::vector<std::unique_ptr<KeysetReader>> readers;
+    readers.push_back(std::move(
+        BinaryKeysetReader::New(encrypted_keyset.SerializeAsString())
+            .ValueOrDie()));
+    EXPECT_THAT(KeysetHandle::ReadMany(std::move(readers), aead).status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+
+  {  // Not a positive number of threads.
+    std::vector<std::unique_ptr<KeysetReader>> readers;
+    readers.push_back(EncryptedKeysetReader(keyset, aead));
+    EXPECT_THAT(KeysetHandle::ReadMany(std::move(readers), aead, 0).status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+}
+
+// An Aead that counts the calls to Decrypt() and otherwise behaves like
+// DummyAead.
+class CountingAead : public Aead {
+ public:
+  explicit CountingAead(absl::string_view name) : aead_(name) {}
+
+  util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view associated_data) const override {
+    return aead_.Encrypt(plaintext, associated_data);
+  }
+
+  util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view associated_data) const override {
+    decrypt_count_++;
+    return aead_.Decrypt(ciphertext, associated_data);
+  }
+
+  int decrypt_count() const { return decrypt_count_; }
+
+ private:
+  DummyAead aead_;
+  mutable int decrypt_count_ = 0;
+};
+
+TEST_F(KeysetHandleTest, ReadWithCache) {
+  CountingAead aead("dummy aead 42");
+  Keyset keyset;
+  Keyset::Key key;
+  AddTinkKey("some key type", 42, key, KeyStatusType::ENABLED,
+             KeyData::SYMMETRIC, &keyset);
+  keyset.set_primary_key_id(42);
+  Keyset other_keyset = keyset;
+  other_keyset.set_primary_key_id(43);
+
+  KeysetReadCache cache;
+  for (int i = 0; i < 3; i++) {
+    auto result =
+        KeysetHandle::Read(EncryptedKeysetReader(keyset, aead), aead, &cache);
+    ASSERT_THAT(result.status(), IsOk());
+    EXPECT_EQ(keyset.SerializeAsString(),
+              TestKeysetHandle::GetKeyset(*result.ValueOrDie())
+                  .SerializeAsString());
+  }
+  EXPECT_EQ(aead.decrypt_count(), 1);
+
+  auto result = KeysetHandle::Read(EncryptedKeysetReader(other_keyset, aead),
+                                   aead, &cache);
+  ASSERT_THAT(result.status(), IsOk());
+  EXPECT_EQ(other_keyset.SerializeAsString(),
+            TestKeysetHandle::GetKeyset(*result.ValueOrDie())
+                .SerializeAsString());
+  EXPECT_EQ(aead.decrypt_count(), 2);
+
+  // Failures are not cached.
+  EXPECT_THAT(KeysetHandle::Read(EncryptedKeysetReader(keyset, aead),
+                                 DummyAead("wrong aead"), nullptr)
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  KeysetReadCache other_cache;
+  CountingAead wrong_aead("wrong aead");
+  for (int i = 0; i < 2; i++) {
+    EXPECT_THAT(KeysetHandle::Read(EncryptedKeysetReader(keyset, aead),
+                                   wrong_aead, &other_cache)
+                    .status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+  EXPECT_EQ(wrong_aead.decrypt_count(), 2);
+}
+
+TEST_F(KeysetHandleTest, ReadIfChanged) {
+  CountingAead aead("dummy aead 42");
+  Keyset keyset;
+  Keyset::Key key;
+  AddTinkKey("some key type", 42, key, KeyStatusType::ENABLED,
+             KeyData::SYMMETRIC, &keyset);
+  keyset.set_primary_key_id(42);
+  Keyset other_keyset = keyset;
+  other_keyset.set_primary_key_id(43);
+
+  for (bool use_cache : {false, true}) {
+    SCOPED_TRACE(absl::StrCat("use_cache = ", use_cache));
+    KeysetReadCache cache;
+    KeysetReadCache* cache_ptr = use_cache ? &cache : nullptr;
+    std::string digest;
+    auto result = KeysetHandle::ReadIfChanged(
+        EncryptedKeysetReader(keyset, aead), aead, cache_ptr, &digest);
+    ASSERT_THAT(result.status(), IsOk());
+    ASSERT_NE(result.ValueOrDie(), nullptr);
+    EXPECT_EQ(keyset.SerializeAsString(),
+              TestKeysetHandle::GetKeyset(*result.ValueOrDie())
+                  .SerializeAsString());
+    EXPECT_FALSE(digest.empty());
+    int decrypt_count = aead.decrypt_count();
+
+    // Unchanged: no handle and no decryption.
+    auto unchanged_result = KeysetHandle::ReadIfChanged(
+        EncryptedKeysetReader(keyset, aead), aead, cache_ptr, &digest);
+    ASSERT_THAT(unchanged_result.status(), IsOk());
+    EXPECT_EQ(unchanged_result.ValueOrDie(), nullptr);
+    EXPECT_EQ(aead.decrypt_count(), decrypt_count);
+
+    // Changed.
+    std::string old_digest = digest;
+    auto changed_result = KeysetHandle::ReadIfChanged(
+        EncryptedKeysetReader(other_keyset, aead), aead, cache_ptr, &digest);
+    ASSERT_THAT(changed_result.status(), IsOk());
+    ASSERT_NE(changed_result.ValueOrDie(), nullptr);
+    EXPECT_EQ(other_keyset.SerializeAsString(),
+              TestKeysetHandle::GetKeyset(*changed_result.ValueOrDie())
+                  .SerializeAsString());
+    EXPECT_NE(digest, old_digest);
+
+    // A failed read leaves the digest unchanged.
+    old_digest = digest;
+    EXPECT_THAT(
+        KeysetHandle::ReadIfChanged(EncryptedKeysetReader(keyset, aead),
+                                    DummyAead("wrong aead"), nullptr, &digest)
+            .status(),
+        StatusIs(util::error::INVALID_ARGUMENT));
+    EXPECT_EQ(digest, old_digest);
+  }
+
+  EXPECT_THAT(KeysetHandle::ReadIfChanged(EncryptedKeysetReader(keyset, aead),
+                                          aead, nullptr, nullptr)
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
 TEST_F(KeysetHandleTest, ReadNoSecret) {
   Keyset keyset;
   Keyset::Key key;
@@ -675,6 +1044,25 @@ TEST_F(KeysetHandleTest, GetKeysetInfo) {
   }
 }
 
+TEST_F(KeysetHandleTest, EstimateMemoryUsage) {
+  Keyset keyset;
+  Keyset::Key key;
+  AddTinkKey("some key type", 42, key, KeyStatusType::ENABLED,
+             KeyData::SYMMETRIC, &keyset);
+  keyset.set_primary_key_id(42);
+  auto handle = TestKeysetHandle::GetKeysetHandle(keyset);
+  size_t one_key_usage = handle->EstimateMemoryUsage();
+  EXPECT_GE(one_key_usage, sizeof(KeysetHandle) + sizeof(Keyset::Key));
+
+  for (int i = 0; i < 10; ++i) {
+    AddTinkKey(absl::StrCat("more key type", i), i, key,
+               KeyStatusType::ENABLED, KeyData::SYMMETRIC, &keyset);
+  }
+  handle = TestKeysetHandle::GetKeysetHandle(keyset);
+  EXPECT_GE(handle->EstimateMemoryUsage(),
+            one_key_usage + 10 * sizeof(Keyset::Key));
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
@@ -16,19 +16,27 @@
 
 #include "tink/keyset_manager.h"
 
+#include <algorithm>
 #include <random>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
 #include "tink/keyset_handle.h"
 #include "tink/keyset_reader.h"
 #include "tink/registry.h"
 #include "tink/util/enums.h"
 #include "tink/util/errors.h"
+#include "tink/util/executor.h"
 #include "proto/tink.pb.h"
 
 namespace crypto {
 namespace tink {
 
+using google::crypto::tink::EncryptedKeyset;
 using google::crypto::tink::Keyset;
 using google::crypto::tink::KeyStatusType;
 using google::crypto::tink::KeyTemplate;
@@ -54,6 +62,100 @@ StatusOr<std::unique_ptr<KeysetManager>> KeysetManager::New(
   return std::move(manager);
 }
 
+namespace {
+
+// The number of keysets RotateMany() encrypts with one EncryptBatch() call.
+// Large enough to amortize a remote call to a KMS, small enough to keep all
+// threads busy for a few thousand keysets.
+constexpr int64_t kRotationChunkSize = 256;
+
+}  // namespace
+
+// static
+StatusOr<KeysetManager::BulkRotation> KeysetManager::RotateMany(
+    absl::Span<const KeysetHandle* const> keyset_handles,
+    const KeyTemplate& key_template, const Aead& master_key_aead,
+    int num_threads) {
+  if (num_threads < 1) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "num_threads must be positive");
+  }
+  for (const KeysetHandle* keyset_handle : keyset_handles) {
+    if (keyset_handle == nullptr) {
+      return Status(util::error::INVALID_ARGUMENT,
+                    "keyset handles must be non-null");
+    }
+  }
+  absl::Time start = absl::Now();
+  const size_t num_keysets = keyset_handles.size();
+  BulkRotation rotation;
+  rotation.statuses.resize(num_keysets);
+  rotation.keyset_handles.resize(num_keysets);
+  rotation.encrypted_keysets.resize(num_keysets);
+  rotation.key_ids.resize(num_keysets, 0);
+
+  // Generates the new keys and serializes the rotated keysets.
+  std::vector<std::string> serialized_keysets(num_keysets);
+  util::ParallelFor(num_keysets, num_threads, [&](int64_t i) {
+    auto keyset = absl::make_unique<Keyset>(keyset_handles[i]->get_keyset());
+    auto key_id_result =
+        KeysetHandle::AddToKeyset(key_template, /*as_primary=*/true,
+                                  keyset.get());
+    if (!key_id_result.ok()) {
+      rotation.statuses[i] = key_id_result.status();
+      return;
+    }
+    rotation.key_ids[i] = key_id_result.ValueOrDie();
+    serialized_keysets[i] = keyset->SerializeAsString();
+    rotation.keyset_handles[i] =
+        absl::WrapUnique(new KeysetHandle(std::move(keyset)));
+  });
+
+  // Encrypts the rotated keysets in chunks. A chunk that fails to encrypt
+  // fails all its keysets.
+  std::vector<size_t> rotated;
+  for (size_t i = 0; i < num_keysets; i++) {
+    if (rotation.statuses[i].ok()) rotated.push_back(i);
+  }
+  int64_t num_chunks =
+      (rotated.size() + kRotationChunkSize - 1) / kRotationChunkSize;
+  util::ParallelFor(num_chunks, num_threads, [&](int64_t chunk) {
+    size_t begin = chunk * kRotationChunkSize;
+    size_t end = std::min(rotated.size(), begin + kRotationChunkSize);
+    std::vector<absl::string_view> plaintexts;
+    plaintexts.reserve(end - begin);
+    for (size_t j = begin; j < end; j++) {
+      plaintexts.push_back(serialized_keysets[rotated[j]]);
+    }
+    std::vector<absl::string_view> associated_data(plaintexts.size(), "");
+    std::string ciphertexts;
+    std::vector<int64_t> offsets;
+    Status status = master_key_aead.EncryptBatch(plaintexts, associated_data,
+                                                 &ciphertexts, &offsets);
+    for (size_t j = begin; j < end; j++) {
+      size_t i = rotated[j];
+      if (!status.ok()) {
+        rotation.statuses[i] =
+            ToStatusF(status.CanonicalCode(),
+                      "Encryption of the keyset failed: %s",
+                      status.error_message());
+        rotation.keyset_handles[i].reset();
+        rotation.key_ids[i] = 0;
+        continue;
+      }
+      rotation.encrypted_keysets[i].set_encrypted_keyset(
+          ciphertexts.substr(offsets[j - begin],
+                             offsets[j - begin + 1] - offsets[j - begin]));
+    }
+  });
+
+  for (const Status& status : rotation.statuses) {
+    if (status.ok()) rotation.num_rotated++;
+  }
+  rotation.duration = absl::Now() - start;
+  return std::move(rotation);
+}
+
 std::unique_ptr<KeysetHandle> KeysetManager::GetKeysetHandle() {
   absl::MutexLock lock(&keyset_mutex_);
   std::unique_ptr<Keyset> keyset_copy(new Keyset(keyset_));
@@ -15,19 +15,27 @@
 ////////////////////////////////////////////////////////////////////////////////
 #include "tink/keyset_manager.h"
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
+#include "tink/aead.h"
 #include "tink/aead/aead_config.h"
 #include "tink/aead/aes_gcm_key_manager.h"
 #include "tink/config.h"
 #include "tink/keyset_handle.h"
 #include "tink/util/test_keyset_handle.h"
+#include "tink/util/test_util.h"
 #include "proto/aes_gcm.pb.h"
 #include "proto/tink.pb.h"
 
 using crypto::tink::TestKeysetHandle;
+using crypto::tink::test::DummyAead;
 
 using google::crypto::tink::AesGcmKeyFormat;
 using google::crypto::tink::KeyData;
+using google::crypto::tink::Keyset;
 using google::crypto::tink::KeyStatusType;
 using google::crypto::tink::KeyTemplate;
 using google::crypto::tink::OutputPrefixType;
@@ -44,6 +52,32 @@ class KeysetManagerTest : public ::testing::Test {
   void TearDown() override {}
 };
 
+KeyTemplate AesGcmKeyTemplate() {
+  AesGcmKeyFormat key_format;
+  key_format.set_key_size(16);
+  KeyTemplate key_template;
+  key_template.set_type_url(AesGcmKeyManager().get_key_type());
+  key_template.set_output_prefix_type(OutputPrefixType::TINK);
+  key_template.set_value(key_format.SerializeAsString());
+  return key_template;
+}
+
+// An Aead whose encryption always fails.
+class FailingAead : public Aead {
+ public:
+  util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view associated_data) const override {
+    return util::Status(util::error::UNAVAILABLE, "KMS unavailable");
+  }
+
+  util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view associated_data) const override {
+    return util::Status(util::error::UNAVAILABLE, "KMS unavailable");
+  }
+};
+
 TEST_F(KeysetManagerTest, testBasicOperations) {
   AesGcmKeyFormat key_format;
   key_format.set_key_size(16);
@@ -230,5 +264,81 @@ TEST_F(KeysetManagerTest, testBasicOperations) {
   EXPECT_EQ(1, keyset_manager->KeyCount());
 }
 
+TEST_F(KeysetManagerTest, RotateMany) {
+  KeyTemplate key_template = AesGcmKeyTemplate();
+  // More keysets than fit into one encryption chunk.
+  std::vector<std::unique_ptr<KeysetHandle>> keyset_handles;
+  std::vector<const KeysetHandle*> keyset_handle_ptrs;
+  for (int i = 0; i < 300; i++) {
+    keyset_handles.push_back(
+        KeysetHandle::GenerateNew(key_template).ValueOrDie());
+    keyset_handle_ptrs.push_back(keyset_handles.back().get());
+  }
+  DummyAead master_key_aead("master key");
+  for (int num_threads : {1, 4}) {
+    auto rotation_result = KeysetManager::RotateMany(
+        keyset_handle_ptrs, key_template, master_key_aead, num_threads);
+    ASSERT_TRUE(rotation_result.ok()) << rotation_result.status();
+    const KeysetManager::BulkRotation& rotation = rotation_result.ValueOrDie();
+    EXPECT_EQ(300, rotation.num_rotated);
+    ASSERT_EQ(300, rotation.statuses.size());
+    for (int i = 0; i < 300; i++) {
+      EXPECT_TRUE(rotation.statuses[i].ok()) << rotation.statuses[i];
+      Keyset keyset = TestKeysetHandle::GetKeyset(*rotation.keyset_handles[i]);
+      ASSERT_EQ(2, keyset.key_size());
+      EXPECT_EQ(TestKeysetHandle::GetKeyset(*keyset_handles[i])
+                    .key(0)
+                    .SerializeAsString(),
+                keyset.key(0).SerializeAsString());
+      EXPECT_EQ(rotation.key_ids[i], keyset.primary_key_id());
+      EXPECT_EQ(rotation.key_ids[i], keyset.key(1).key_id());
+      auto decrypt_result = master_key_aead.Decrypt(
+          rotation.encrypted_keysets[i].encrypted_keyset(), "");
+      ASSERT_TRUE(decrypt_result.ok()) << decrypt_result.status();
+      EXPECT_EQ(keyset.SerializeAsString(), decrypt_result.ValueOrDie());
+    }
+  }
+}
+
+TEST_F(KeysetManagerTest, RotateManyFailures) {
+  KeyTemplate key_template = AesGcmKeyTemplate();
+  auto keyset_handle = KeysetHandle::GenerateNew(key_template).ValueOrDie();
+  std::vector<const KeysetHandle*> keyset_handles = {keyset_handle.get(),
+                                                     keyset_handle.get()};
+  DummyAead master_key_aead("master key");
+
+  // Failing encryption fails the keysets, but not the call.
+  auto rotation_result = KeysetManager::RotateMany(
+      keyset_handles, key_template, FailingAead(), /*num_threads=*/2);
+  ASSERT_TRUE(rotation_result.ok()) << rotation_result.status();
+  EXPECT_EQ(0, rotation_result.ValueOrDie().num_rotated);
+  for (int i = 0; i < 2; i++) {
+    EXPECT_EQ(util::error::UNAVAILABLE,
+              rotation_result.ValueOrDie().statuses[i].error_code());
+    EXPECT_EQ(nullptr, rotation_result.ValueOrDie().keyset_handles[i]);
+  }
+
+  // So do keys that cannot be generated.
+  KeyTemplate unknown_template = key_template;
+  unknown_template.set_type_url("type.googleapis.com/some.UnknownKey");
+  auto unknown_result = KeysetManager::RotateMany(
+      keyset_handles, unknown_template, master_key_aead);
+  ASSERT_TRUE(unknown_result.ok()) << unknown_result.status();
+  EXPECT_EQ(0, unknown_result.ValueOrDie().num_rotated);
+  EXPECT_FALSE(unknown_result.ValueOrDie().statuses[0].ok());
+
+  keyset_handles.push_back(nullptr);
+  EXPECT_EQ(util::error::INVALID_ARGUMENT,
+            KeysetManager::RotateMany(keyset_handles, key_template,
+                                      master_key_aead)
+                .status()
+                .error_code());
+  EXPECT_EQ(util::error::INVALID_ARGUMENT,
+            KeysetManager::RotateMany({}, key_template, master_key_aead,
+                                      /*num_threads=*/0)
+                .status()
+                .error_code());
+}
+
 }  // namespace tink
 }  // namespace crypto
@@ -0,0 +1,80 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/keyset_read_cache.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "openssl/sha.h"
+#include "tink/util/secret_data.h"
+
+namespace crypto {
+namespace tink {
+
+// static
+std::string KeysetReadCache::Digest(absl::string_view encrypted_keyset) {
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  ::SHA256(reinterpret_cast<const uint8_t*>(encrypted_keyset.data()),
+           encrypted_keyset.size(), digest);
+  return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+std::shared_ptr<const util::SecretData> KeysetReadCache::Get(
+    absl::string_view digest) {
+  absl::Time now = absl::Now();
+  absl::MutexLock lock(&mutex_);
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (it->digest == digest) {
+      if (it->expiration <= now) {
+        entries_.erase(it);
+        return nullptr;
+      }
+      entries_.splice(entries_.begin(), entries_, it);
+      return entries_.front().serialized_keyset;
+    }
+  }
+  return nullptr;
+}
+
+void KeysetReadCache::Put(absl::string_view digest,
+                          util::SecretData serialized_keyset) {
+  if (options_.capacity <= 0) return;
+  Entry entry;
+  entry.digest = std::string(digest);
+  entry.expiration = absl::Now() + options_.ttl;
+  entry.serialized_keyset =
+      std::make_shared<const util::SecretData>(std::move(serialized_keyset));
+  absl::MutexLock lock(&mutex_);
+  for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+    if (it->digest == digest) {
+      entries_.erase(it);
+      break;
+    }
+  }
+  entries_.push_front(std::move(entry));
+  while (entries_.size() > static_cast<size_t>(options_.capacity)) {
+    entries_.pop_back();
+  }
+}
+
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,80 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/keyset_read_cache.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+#include "tink/util/secret_data.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::util::SecretDataAsStringView;
+using ::crypto::tink::util::SecretDataFromStringView;
+
+TEST(KeysetReadCacheTest, GetPut) {
+  KeysetReadCache cache;
+  std::string digest = KeysetReadCache::Digest("encrypted keyset");
+  EXPECT_EQ(digest.size(), 32);
+  EXPECT_NE(digest, KeysetReadCache::Digest("other encrypted keyset"));
+  EXPECT_EQ(cache.Get(digest), nullptr);
+  cache.Put(digest, SecretDataFromStringView("keyset"));
+  auto cached = cache.Get(digest);
+  ASSERT_NE(cached, nullptr);
+  EXPECT_EQ(SecretDataAsStringView(*cached), "keyset");
+  EXPECT_EQ(cache.Get(KeysetReadCache::Digest("other encrypted keyset")),
+            nullptr);
+  cache.Put(digest, SecretDataFromStringView("new keyset"));
+  EXPECT_EQ(SecretDataAsStringView(*cache.Get(digest)), "new keyset");
+}
+
+TEST(KeysetReadCacheTest, EvictsLeastRecentlyUsed) {
+  KeysetReadCache::Options options;
+  options.capacity = 2;
+  KeysetReadCache cache(options);
+  cache.Put("a", SecretDataFromStringView("keyset a"));
+  cache.Put("b", SecretDataFromStringView("keyset b"));
+  EXPECT_NE(cache.Get("a"), nullptr);
+  cache.Put("c", SecretDataFromStringView("keyset c"));
+  EXPECT_NE(cache.Get("a"), nullptr);
+  EXPECT_EQ(cache.Get("b"), nullptr);
+  EXPECT_NE(cache.Get("c"), nullptr);
+}
+
+TEST(KeysetReadCacheTest, Expires) {
+  KeysetReadCache::Options options;
+  options.ttl = absl::ZeroDuration();
+  KeysetReadCache cache(options);
+  cache.Put("a", SecretDataFromStringView("keyset a"));
+  EXPECT_EQ(cache.Get("a"), nullptr);
+}
+
+TEST(KeysetReadCacheTest, ZeroCapacity) {
+  KeysetReadCache::Options options;
+  options.capacity = 0;
+  KeysetReadCache cache(options);
+  cache.Put("a", SecretDataFromStringView("keyset a"));
+  EXPECT_EQ(cache.Get("a"), nullptr);
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,224 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/keyset_router.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "tink/crypto_format.h"
+#include "tink/util/test_matchers.h"
+#include "proto/tink.pb.h"
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::google::crypto::tink::KeysetInfo;
+using ::google::crypto::tink::KeyStatusType;
+using ::google::crypto::tink::OutputPrefixType;
+using ::testing::ElementsAre;
+
+namespace crypto {
+namespace tink {
+namespace {
+
+// The router only hands out primitives, so any type will do.
+struct FakePrimitive {
+  std::string id;
+};
+
+using Router = KeysetRouter<FakePrimitive>;
+
+void AddKey(uint32_t key_id, OutputPrefixType output_prefix_type,
+            KeyStatusType status, KeysetInfo* keyset_info) {
+  KeysetInfo::KeyInfo* key_info = keyset_info->add_key_info();
+  key_info->set_key_id(key_id);
+  key_info->set_output_prefix_type(output_prefix_type);
+  key_info->set_status(status);
+}
+
+KeysetInfo GetKeysetInfo(uint32_t key_id) {
+  KeysetInfo keyset_info;
+  AddKey(key_id, OutputPrefixType::TINK, KeyStatusType::ENABLED,
+         &keyset_info);
+  return keyset_info;
+}
+
+std::string GetPrefixedData(uint32_t key_id,
+                            OutputPrefixType output_prefix_type) {
+  KeysetInfo::KeyInfo key_info;
+  key_info.set_key_id(key_id);
+  key_info.set_output_prefix_type(output_prefix_type);
+  return absl::StrCat(CryptoFormat::GetOutputPrefix(key_info).ValueOrDie(),
+                      "some data");
+}
+
+std::shared_ptr<FakePrimitive> NewPrimitive(const std::string& id) {
+  return std::make_shared<FakePrimitive>(FakePrimitive{id});
+}
+
+// Returns the names of the keysets Find() returns for 'data'.
+std::vector<std::string> FindNames(const Router& router,
+                                   absl::string_view data) {
+  std::vector<std::string> names;
+  for (const Router::Keyset* keyset : router.Find(data)) {
+    names.push_back(keyset->name);
+  }
+  return names;
+}
+
+TEST(KeysetRouterTest, RoutesByKeyPrefix) {
+  Router router;
+  KeysetInfo keyset_info;
+  AddKey(1234, OutputPrefixType::TINK, KeyStatusType::ENABLED, &keyset_info);
+  AddKey(5678, OutputPrefixType::LEGACY, KeyStatusType::ENABLED, &keyset_info);
+  ASSERT_THAT(router.AddKeyset("tenant1", keyset_info, NewPrimitive("p1")),
+              IsOk());
+  ASSERT_THAT(
+      router.AddKeyset("tenant2", GetKeysetInfo(42), NewPrimitive("p2")),
+      IsOk());
+  EXPECT_EQ(2, router.size());
+
+  auto route = router.Find(GetPrefixedData(1234, OutputPrefixType::TINK));
+  ASSERT_EQ(1, route.size());
+  EXPECT_EQ("tenant1", (*route.begin())->name);
+  EXPECT_EQ("p1", (*route.begin())->primitive->id);
+  EXPECT_THAT(
+      FindNames(router, GetPrefixedData(5678, OutputPrefixType::LEGACY)),
+      ElementsAre("tenant1"));
+  EXPECT_THAT(FindNames(router, GetPrefixedData(42, OutputPrefixType::TINK)),
+              ElementsAre("tenant2"));
+
+  // Unknown key ids, other prefix types and data shorter than a prefix.
+  EXPECT_TRUE(router.Find(GetPrefixedData(43, OutputPrefixType::TINK)).empty());
+  EXPECT_TRUE(
+      router.Find(GetPrefixedData(1234, OutputPrefixType::LEGACY)).empty());
+  EXPECT_TRUE(router.Find(GetPrefixedData(42, OutputPrefixType::TINK)
+                              .substr(0, CryptoFormat::kNonRawPrefixSize - 1))
+                  .empty());
+  EXPECT_TRUE(router.Find("").empty());
+}
+
+TEST(KeysetRouterTest, RawAndDisabledKeysAreNotRouted) {
+  Router router;
+  KeysetInfo keyset_info;
+  AddKey(1, OutputPrefixType::RAW, KeyStatusType::ENABLED, &keyset_info);
+  AddKey(2, OutputPrefixType::TINK, KeyStatusType::DISABLED, &keyset_info);
+  AddKey(3, OutputPrefixType::TINK, KeyStatusType::ENABLED, &keyset_info);
+  ASSERT_THAT(router.AddKeyset("tenant", keyset_info, NewPrimitive("p")),
+              IsOk());
+  EXPECT_TRUE(router.Find(GetPrefixedData(1, OutputPrefixType::RAW)).empty());
+  EXPECT_TRUE(router.Find(GetPrefixedData(2, OutputPrefixType::TINK)).empty());
+  EXPECT_THAT(FindNames(router, GetPrefixedData(3, OutputPrefixType::TINK)),
+              ElementsAre("tenant"));
+}
+
+TEST(KeysetRouterTest, SharedKeyIds) {
+  Router router;
+  ASSERT_THAT(router.AddKeyset("a", GetKeysetInfo(7), NewPrimitive("a")),
+              IsOk());
+  ASSERT_THAT(router.AddKeyset("b", GetKeysetInfo(8), NewPrimitive("b")),
+              IsOk());
+  ASSERT_THAT(router.AddKeyset("c", GetKeysetInfo(7), NewPrimitive("c")),
+              IsOk());
+  EXPECT_THAT(FindNames(router, GetPrefixedData(7, OutputPrefixType::TINK)),
+              ElementsAre("a", "c"));
+
+  // Keys of the same keyset with the same id route to it once.
+  KeysetInfo keyset_info = GetKeysetInfo(9);
+  AddKey(9, OutputPrefixType::TINK, KeyStatusType::ENABLED, &keyset_info);
+  ASSERT_THAT(router.AddKeyset("d", keyset_info, NewPrimitive("d")), IsOk());
+  EXPECT_THAT(FindNames(router, GetPrefixedData(9, OutputPrefixType::TINK)),
+              ElementsAre("d"));
+}
+
+TEST(KeysetRouterTest, ReplaceAndRemove) {
+  Router router;
+  ASSERT_THAT(router.AddKeyset("a", GetKeysetInfo(1), NewPrimitive("a1")),
+              IsOk());
+  ASSERT_THAT(router.AddKeyset("b", GetKeysetInfo(2), NewPrimitive("b")),
+              IsOk());
+  auto old_route = router.Find(GetPrefixedData(1, OutputPrefixType::TINK));
+
+  // Replacing a keyset drops the keys it no longer has.
+  ASSERT_THAT(router.AddKeyset("a", GetKeysetInfo(3), NewPrimitive("a2")),
+              IsOk());
+  EXPECT_EQ(2, router.size());
+  EXPECT_TRUE(router.Find(GetPrefixedData(1, OutputPrefixType::TINK)).empty());
+  EXPECT_THAT(FindNames(router, GetPrefixedData(3, OutputPrefixType::TINK)),
+              ElementsAre("a"));
+
+  EXPECT_THAT(router.RemoveKeyset("b"), IsOk());
+  EXPECT_THAT(router.RemoveKeyset("b"), StatusIs(util::error::NOT_FOUND));
+  EXPECT_EQ(1, router.size());
+  EXPECT_TRUE(router.Find(GetPrefixedData(2, OutputPrefixType::TINK)).empty());
+
+  // Routes found before the changes still hold their keysets.
+  ASSERT_EQ(1, old_route.size());
+  EXPECT_EQ("a1", (*old_route.begin())->primitive->id);
+}
+
+TEST(KeysetRouterTest, NullPrimitive) {
+  Router router;
+  EXPECT_THAT(router.AddKeyset("a", GetKeysetInfo(1), nullptr),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_EQ(0, router.size());
+}
+
+TEST(KeysetRouterTest, ConcurrentFindAndUpdate) {
+  Router router;
+  const int kKeysets = 50;
+  for (int i = 0; i < kKeysets; i++) {
+    ASSERT_THAT(router.AddKeyset(absl::StrCat("stable", i), GetKeysetInfo(i),
+                                 NewPrimitive(absl::StrCat(i))),
+                IsOk());
+  }
+  std::atomic<bool> done(false);
+  std::thread updater([&router, &done]() {
+    for (int round = 0; round < 200; round++) {
+      std::string name = absl::StrCat("changing", round % 5);
+      EXPECT_THAT(router.AddKeyset(name, GetKeysetInfo(1000 + round),
+                                   NewPrimitive(name)),
+                  IsOk());
+      if (round % 2 == 1) EXPECT_THAT(router.RemoveKeyset(name), IsOk());
+    }
+    done = true;
+  });
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&router, &done, t]() {
+      int i = t;
+      while (!done) {
+        int key_id = i++ % kKeysets;
+        auto route =
+            router.Find(GetPrefixedData(key_id, OutputPrefixType::TINK));
+        ASSERT_EQ(1, route.size());
+        EXPECT_EQ(absl::StrCat(key_id), (*route.begin())->primitive->id);
+      }
+    });
+  }
+  updater.join();
+  for (auto& reader : readers) reader.join();
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,163 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/latency_histogram_monitoring_client.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "tink/monitoring_client.h"
+
+namespace crypto {
+namespace tink {
+
+namespace {
+
+// Returns the shard used by the calling thread; threads are assigned shards
+// round-robin on their first operation.
+int ThreadShard() {
+  static std::atomic<int> next_shard(0);
+  thread_local int shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) %
+      LatencyHistogramMonitoringClient::kNumShards;
+  return shard;
+}
+
+// Returns floor(log2(value)) for a positive 'value'.
+int Log2Floor(uint64_t value) {
+  int log = 0;
+  while (value >>= 1) ++log;
+  return log;
+}
+
+}  // namespace
+
+constexpr int LatencyHistogram::kSubBucketBits;
+constexpr int LatencyHistogram::kSubBuckets;
+constexpr int LatencyHistogram::kMaxExponent;
+constexpr int LatencyHistogram::kNumBuckets;
+constexpr int LatencyHistogramMonitoringClient::kNumShards;
+
+// static
+int LatencyHistogram::BucketIndex(absl::Duration latency) {
+  int64_t nanos = absl::ToInt64Nanoseconds(latency);
+  if (nanos < kSubBuckets) return nanos < 0 ? 0 : static_cast<int>(nanos);
+  int exponent = Log2Floor(nanos);
+  if (exponent >= kMaxExponent) return kNumBuckets - 1;
+  // The kSubBucketBits bits below the leading one select the sub-bucket.
+  int sub_bucket = (nanos >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+  return (exponent - kSubBucketBits + 1) * kSubBuckets + sub_bucket;
+}
+
+// static
+absl::Duration LatencyHistogram::BucketLowerBound(int bucket) {
+  if (bucket < kSubBuckets) return absl::Nanoseconds(bucket);
+  int exponent = bucket / kSubBuckets + kSubBucketBits - 1;
+  int64_t mantissa = kSubBuckets + bucket % kSubBuckets;
+  return absl::Nanoseconds(mantissa << (exponent - kSubBucketBits));
+}
+
+absl::Duration LatencyHistogram::Percentile(double quantile) const {
+  if (count == 0) return absl::ZeroDuration();
+  int64_t rank = static_cast<int64_t>(std::ceil(quantile * count));
+  rank = std::min(std::max<int64_t>(rank, 1), count);
+  int64_t seen = 0;
+  for (int bucket = 0; bucket < buckets.size(); ++bucket) {
+    seen += buckets[bucket];
+    if (seen >= rank) {
+      if (bucket == kNumBuckets - 1) return absl::InfiniteDuration();
+      return BucketLowerBound(bucket + 1);
+    }
+  }
+  return absl::InfiniteDuration();
+}
+
+LatencyHistogramMonitoringClient::Shard::Shard() {
+  for (std::atomic<int64_t>& bucket : buckets) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+void LatencyHistogramMonitoringClient::Log(const MonitoringEvent& event) {
+  Shard& shard = GetSeries(event)->shards[ThreadShard()];
+  shard.total_bytes.fetch_add(event.num_bytes, std::memory_order_relaxed);
+  shard.buckets[LatencyHistogram::BucketIndex(event.latency)].fetch_add(
+      1, std::memory_order_relaxed);
+}
+
+LatencyHistogramMonitoringClient::Series*
+LatencyHistogramMonitoringClient::GetSeries(const MonitoringEvent& event) {
+  SeriesKey key(event.primitive, event.api_function, event.key_id);
+  {
+    absl::ReaderMutexLock lock(&mutex_);
+    auto it = series_.find(key);
+    if (it != series_.end()) return it->second.get();
+  }
+  absl::MutexLock lock(&mutex_);
+  auto it = series_.find(key);
+  if (it != series_.end()) return it->second.get();
+  auto series = absl::make_unique<Series>();
+  series->primitive = std::string(event.primitive);
+  series->api_function = std::string(event.api_function);
+  series->key_id = event.key_id;
+  Series* result = series.get();
+  series_.emplace(SeriesKey(result->primitive, result->api_function,
+                            result->key_id),
+                  std::move(series));
+  return result;
+}
+
+std::vector<LatencyHistogram> LatencyHistogramMonitoringClient::Snapshot()
+    const {
+  absl::ReaderMutexLock lock(&mutex_);
+  std::vector<LatencyHistogram> histograms;
+  histograms.reserve(series_.size());
+  for (const auto& key_and_series : series_) {
+    const Series& series = *key_and_series.second;
+    LatencyHistogram histogram;
+    histogram.primitive = series.primitive;
+    histogram.api_function = series.api_function;
+    histogram.key_id = series.key_id;
+    histogram.buckets.assign(LatencyHistogram::kNumBuckets, 0);
+    for (const Shard& shard : series.shards) {
+      histogram.total_bytes +=
+          shard.total_bytes.load(std::memory_order_relaxed);
+      for (int i = 0; i < LatencyHistogram::kNumBuckets; ++i) {
+        int64_t count = shard.buckets[i].load(std::memory_order_relaxed);
+        histogram.buckets[i] += count;
+        histogram.count += count;
+      }
+    }
+    while (!histogram.buckets.empty() && histogram.buckets.back() == 0) {
+      histogram.buckets.pop_back();
+    }
+    histograms.push_back(std::move(histogram));
+  }
+  return histograms;
+}
+
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,140 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/latency_histogram_monitoring_client.h"
+
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+#include "tink/monitoring_client.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+MonitoringEvent Event(absl::string_view api_function, uint32_t key_id,
+                      absl::Duration latency) {
+  MonitoringEvent event;
+  event.primitive = "aead";
+  event.api_function = api_function;
+  event.key_id = key_id;
+  event.num_bytes = 10;
+  event.success = key_id != 0;
+  event.latency = latency;
+  return event;
+}
+
+TEST(LatencyHistogramTest, BucketsAreContiguous) {
+  EXPECT_EQ(LatencyHistogram::BucketIndex(absl::ZeroDuration()), 0);
+  EXPECT_EQ(LatencyHistogram::BucketIndex(absl::Nanoseconds(-5)), 0);
+  for (int bucket = 0; bucket < LatencyHistogram::kNumBuckets; ++bucket) {
+    absl::Duration lower = LatencyHistogram::BucketLowerBound(bucket);
+    EXPECT_EQ(LatencyHistogram::BucketIndex(lower), bucket);
+    if (bucket > 0) {
+      EXPECT_EQ(LatencyHistogram::BucketIndex(lower - absl::Nanoseconds(1)),
+                bucket - 1);
+    }
+  }
+  EXPECT_EQ(LatencyHistogram::BucketIndex(absl::Hours(10)),
+            LatencyHistogram::kNumBuckets - 1);
+}
+
+TEST(LatencyHistogramTest, RelativeErrorIsBounded) {
+  for (int64_t nanos : {9, 100, 1000, 12345, 999999, 123456789}) {
+    int bucket = LatencyHistogram::BucketIndex(absl::Nanoseconds(nanos));
+    absl::Duration width = LatencyHistogram::BucketLowerBound(bucket + 1) -
+                           LatencyHistogram::BucketLowerBound(bucket);
+    EXPECT_LE(width, absl::Nanoseconds(nanos) / LatencyHistogram::kSubBuckets);
+  }
+}
+
+TEST(LatencyHistogramTest, Percentile) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.Percentile(0.5), absl::ZeroDuration());
+
+  histogram.buckets.assign(LatencyHistogram::kNumBuckets, 0);
+  for (int i = 1; i <= 100; ++i) {
+    histogram.buckets[LatencyHistogram::BucketIndex(absl::Microseconds(i))]++;
+    histogram.count++;
+  }
+  absl::Duration p50 = histogram.Percentile(0.5);
+  EXPECT_GE(p50, absl::Microseconds(50));
+  EXPECT_LE(p50, absl::Microseconds(50) * 9 / 8);
+  absl::Duration p99 = histogram.Percentile(0.99);
+  EXPECT_GE(p99, absl::Microseconds(99));
+  EXPECT_LE(p99, absl::Microseconds(99) * 9 / 8);
+  EXPECT_GE(histogram.Percentile(1), absl::Microseconds(100));
+}
+
+TEST(LatencyHistogramMonitoringClientTest, RecordsLatency) {
+  LatencyHistogramMonitoringClient client;
+  EXPECT_TRUE(client.RecordsLatency());
+  EXPECT_TRUE(client.Snapshot().empty());
+}
+
+TEST(LatencyHistogramMonitoringClientTest, SeparatesFunctionsAndKeys) {
+  LatencyHistogramMonitoringClient client;
+  client.Log(Event("encrypt", 42, absl::Microseconds(3)));
+  client.Log(Event("encrypt", 42, absl::Microseconds(5)));
+  client.Log(Event("encrypt", 7, absl::Microseconds(5)));
+  client.Log(Event("decrypt", 42, absl::Microseconds(5)));
+  client.Log(Event("decrypt", 0, absl::Microseconds(1)));
+
+  std::vector<LatencyHistogram> histograms = client.Snapshot();
+  ASSERT_EQ(histograms.size(), 4);
+  EXPECT_EQ(histograms[0].api_function, "decrypt");
+  EXPECT_EQ(histograms[0].key_id, 0);
+  EXPECT_EQ(histograms[1].api_function, "decrypt");
+  EXPECT_EQ(histograms[1].key_id, 42);
+  EXPECT_EQ(histograms[2].api_function, "encrypt");
+  EXPECT_EQ(histograms[2].key_id, 7);
+  const LatencyHistogram& histogram = histograms[3];
+  EXPECT_EQ(histogram.primitive, "aead");
+  EXPECT_EQ(histogram.api_function, "encrypt");
+  EXPECT_EQ(histogram.key_id, 42);
+  EXPECT_EQ(histogram.count, 2);
+  EXPECT_EQ(histogram.total_bytes, 20);
+  EXPECT_EQ(histogram.buckets.size(),
+            LatencyHistogram::BucketIndex(absl::Microseconds(5)) + 1);
+  EXPECT_LE(histogram.Percentile(0.5), absl::Microseconds(4));
+  EXPECT_GE(histogram.Percentile(0.99), absl::Microseconds(5));
+}
+
+TEST(LatencyHistogramMonitoringClientTest, MergesThreads) {
+  LatencyHistogramMonitoringClient client;
+  constexpr int kThreads = 8;
+  constexpr int kEventsPerThread = 1000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&client, i]() {
+      for (int j = 0; j < kEventsPerThread; ++j) {
+        client.Log(Event("encrypt", 1 + j % 2, absl::Nanoseconds(i * j)));
+      }
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  std::vector<LatencyHistogram> histograms = client.Snapshot();
+  ASSERT_EQ(histograms.size(), 2);
+  EXPECT_EQ(histograms[0].count + histograms[1].count,
+            kThreads * kEventsPerThread);
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
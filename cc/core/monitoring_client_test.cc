@@ -0,0 +1,120 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/monitoring_client.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+// Stores the events it is passed.
+class RecordingMonitoringClient : public MonitoringClient {
+ public:
+  explicit RecordingMonitoringClient(bool records_latency)
+      : records_latency_(records_latency) {}
+
+  bool RecordsLatency() const override { return records_latency_; }
+  void Log(const MonitoringEvent& event) override { events_.push_back(event); }
+
+  const std::vector<MonitoringEvent>& events() const { return events_; }
+
+ private:
+  const bool records_latency_;
+  std::vector<MonitoringEvent> events_;
+};
+
+class MonitoringClientTest : public ::testing::Test {
+ protected:
+  void TearDown() override { SetMonitoringClient(nullptr); }
+};
+
+TEST_F(MonitoringClientTest, NoClientByDefault) {
+  EXPECT_EQ(GetMonitoringClient(), nullptr);
+  internal::MonitoredOperation monitored("aead", "encrypt", 10);
+  monitored.Success(1234);
+}
+
+TEST_F(MonitoringClientTest, SetAndRemoveClient) {
+  RecordingMonitoringClient client(/*records_latency=*/false);
+  SetMonitoringClient(&client);
+  EXPECT_EQ(GetMonitoringClient(), &client);
+  SetMonitoringClient(nullptr);
+  EXPECT_EQ(GetMonitoringClient(), nullptr);
+  { internal::MonitoredOperation monitored("aead", "encrypt", 10); }
+  EXPECT_TRUE(client.events().empty());
+}
+
+TEST_F(MonitoringClientTest, ReportsSuccess) {
+  RecordingMonitoringClient client(/*records_latency=*/false);
+  SetMonitoringClient(&client);
+  {
+    internal::MonitoredOperation monitored("aead", "encrypt", 10);
+    monitored.Success(1234);
+  }
+  ASSERT_EQ(client.events().size(), 1);
+  const MonitoringEvent& event = client.events()[0];
+  EXPECT_EQ(event.primitive, "aead");
+  EXPECT_EQ(event.api_function, "encrypt");
+  EXPECT_EQ(event.key_id, 1234);
+  EXPECT_EQ(event.num_bytes, 10);
+  EXPECT_TRUE(event.success);
+  EXPECT_EQ(event.latency, absl::ZeroDuration());
+}
+
+TEST_F(MonitoringClientTest, ReportsFailureWithoutSuccess) {
+  RecordingMonitoringClient client(/*records_latency=*/false);
+  SetMonitoringClient(&client);
+  { internal::MonitoredOperation monitored("mac", "verify", 20); }
+  ASSERT_EQ(client.events().size(), 1);
+  const MonitoringEvent& event = client.events()[0];
+  EXPECT_EQ(event.primitive, "mac");
+  EXPECT_EQ(event.api_function, "verify");
+  EXPECT_EQ(event.key_id, 0);
+  EXPECT_EQ(event.num_bytes, 20);
+  EXPECT_FALSE(event.success);
+}
+
+TEST_F(MonitoringClientTest, ReportsLatencyIfRequested) {
+  RecordingMonitoringClient client(/*records_latency=*/true);
+  SetMonitoringClient(&client);
+  {
+    internal::MonitoredOperation monitored("mac", "compute", 20);
+    absl::SleepFor(absl::Milliseconds(1));
+    monitored.Success(1);
+  }
+  ASSERT_EQ(client.events().size(), 1);
+  EXPECT_GE(client.events()[0].latency, absl::Milliseconds(1));
+}
+
+TEST_F(MonitoringClientTest, ReportsOnlyOnce) {
+  RecordingMonitoringClient client(/*records_latency=*/false);
+  SetMonitoringClient(&client);
+  {
+    internal::MonitoredOperation monitored("aead", "decrypt", 10);
+    monitored.Success(1);
+  }
+  EXPECT_EQ(client.events().size(), 1);
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -16,10 +16,14 @@
 
 #include "tink/primitive_set.h"
 
+#include <atomic>
+#include <memory>
 #include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/memory/memory.h"
 #include "tink/crypto_format.h"
 #include "tink/mac.h"
 #include "tink/util/test_matchers.h"
@@ -28,9 +32,11 @@
 
 using ::crypto::tink::test::DummyMac;
 using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
 using ::google::crypto::tink::KeysetInfo;
 using ::google::crypto::tink::KeyStatusType;
 using ::google::crypto::tink::OutputPrefixType;
+using ::testing::Contains;
 using ::testing::UnorderedElementsAreArray;
 
 namespace crypto {
@@ -438,6 +444,218 @@ TEST_F(PrimitiveSetTest, GetAll) {
   EXPECT_THAT(mac_and_id, UnorderedElementsAreArray(expected_result));
 }
 
+TEST_F(PrimitiveSetTest, Freeze) {
+  PrimitiveSet<Mac> pset;
+  auto entry_or = pset.AddPrimitive(
+      absl::make_unique<DummyMac>("MAC1"),
+      CreateKey(0x01010101, OutputPrefixType::TINK, KeyStatusType::ENABLED));
+  ASSERT_THAT(entry_or.status(), IsOk());
+  ASSERT_THAT(pset.set_primary(entry_or.ValueOrDie()), IsOk());
+  EXPECT_THAT(pset.AddPrimitive(absl::make_unique<DummyMac>("MAC2"),
+                                CreateKey(0x02020202, OutputPrefixType::RAW,
+                                          KeyStatusType::ENABLED))
+                  .status(),
+              IsOk());
+  EXPECT_FALSE(pset.is_frozen());
+
+  pset.Freeze();
+  EXPECT_TRUE(pset.is_frozen());
+  pset.Freeze();  // No-op.
+  EXPECT_TRUE(pset.is_frozen());
+
+  // Lookups are served by the frozen index.
+  auto tink_or = pset.get_primitives("\1\1\1\1\1");
+  ASSERT_THAT(tink_or.status(), IsOk());
+  ASSERT_EQ(1, tink_or.ValueOrDie()->size());
+  EXPECT_EQ(entry_or.ValueOrDie(), (*tink_or.ValueOrDie())[0].get());
+  auto raw_or = pset.get_raw_primitives();
+  ASSERT_THAT(raw_or.status(), IsOk());
+  EXPECT_EQ(1, raw_or.ValueOrDie()->size());
+  EXPECT_THAT(pset.get_primitives("\1\2\2\2\2").status(),
+              StatusIs(util::error::NOT_FOUND));
+  EXPECT_EQ(entry_or.ValueOrDie(), pset.get_primary());
+  std::vector<PrimitiveSet<Mac>::Entry<Mac>*> all = pset.get_all();
+  ASSERT_EQ(2, all.size());
+  EXPECT_THAT(all, Contains(entry_or.ValueOrDie()));
+  EXPECT_THAT(all, Contains((*raw_or.ValueOrDie())[0].get()));
+
+  // The set can no longer be modified.
+  EXPECT_THAT(pset.AddPrimitive(absl::make_unique<DummyMac>("MAC3"),
+                                CreateKey(0x03030303, OutputPrefixType::TINK,
+                                          KeyStatusType::ENABLED))
+                  .status(),
+              StatusIs(util::error::FAILED_PRECONDITION));
+  EXPECT_THAT(pset.set_primary(entry_or.ValueOrDie()),
+              StatusIs(util::error::FAILED_PRECONDITION));
+}
+
+TEST_F(PrimitiveSetTest, FindPrimitives) {
+  PrimitiveSet<Mac> pset;
+  auto entry_or = pset.AddPrimitive(
+      absl::make_unique<DummyMac>("MAC1"),
+      CreateKey(0x01010101, OutputPrefixType::TINK, KeyStatusType::ENABLED));
+  ASSERT_THAT(entry_or.status(), IsOk());
+  ASSERT_THAT(pset.set_primary(entry_or.ValueOrDie()), IsOk());
+  EXPECT_EQ(nullptr, pset.find_raw_primitives());
+
+  for (bool frozen : {false, true}) {
+    SCOPED_TRACE(frozen);
+    if (frozen) pset.Freeze();
+    const PrimitiveSet<Mac>::Primitives* found =
+        pset.find_primitives("\1\1\1\1\1");
+    ASSERT_NE(nullptr, found);
+    ASSERT_EQ(1, found->size());
+    EXPECT_EQ(entry_or.ValueOrDie(), (*found)[0].get());
+    EXPECT_EQ(found, pset.get_primitives("\1\1\1\1\1").ValueOrDie());
+    EXPECT_EQ(nullptr, pset.find_primitives("\1\2\2\2\2"));
+    EXPECT_EQ(nullptr, pset.find_primitives(""));
+    EXPECT_EQ(nullptr, pset.find_raw_primitives());
+  }
+}
+
+TEST_F(PrimitiveSetTest, ConcurrentFrozenReads) {
+  PrimitiveSet<Mac> mac_set;
+  int offset = 100;
+  int count = 100;
+  add_primitives(&mac_set, offset, count);
+  mac_set.Freeze();
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back(access_primitives, &mac_set, offset, count);
+  }
+  for (auto& reader : readers) reader.join();
+}
+
+KeysetInfo::KeyInfo TinkKeyInfo(int key_id) {
+  KeysetInfo::KeyInfo key_info;
+  key_info.set_output_prefix_type(OutputPrefixType::TINK);
+  key_info.set_key_id(key_id);
+  key_info.set_status(KeyStatusType::ENABLED);
+  return key_info;
+}
+
+TEST_F(PrimitiveSetTest, LazyPrimitive) {
+  PrimitiveSet<Mac> mac_set;
+  std::atomic<int> factory_calls(0);
+  auto add_result = mac_set.AddLazyPrimitive(
+      [&factory_calls]() -> util::StatusOr<std::unique_ptr<Mac>> {
+        ++factory_calls;
+        return {absl::make_unique<DummyMac>("lazy MAC")};
+      },
+      TinkKeyInfo(42));
+  ASSERT_THAT(add_result.status(), IsOk());
+  auto* entry = add_result.ValueOrDie();
+  EXPECT_TRUE(entry->is_lazy());
+  EXPECT_EQ(entry->get_key_id(), 42);
+  EXPECT_EQ(factory_calls, 0);
+
+  // The primitive is created once, even if requested from several threads.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([entry]() {
+      auto mac_result = entry->GetOrCreatePrimitive();
+      ASSERT_THAT(mac_result.status(), IsOk());
+      EXPECT_THAT(mac_result.ValueOrDie()->ComputeMac("data").status(),
+                  IsOk());
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(factory_calls, 1);
+  EXPECT_EQ(&entry->get_primitive(),
+            entry->GetOrCreatePrimitive().ValueOrDie());
+  EXPECT_EQ(factory_calls, 1);
+}
+
+TEST_F(PrimitiveSetTest, LazyPrimitiveFailure) {
+  PrimitiveSet<Mac> mac_set;
+  std::atomic<int> factory_calls(0);
+  auto add_result = mac_set.AddLazyPrimitive(
+      [&factory_calls]() -> util::StatusOr<std::unique_ptr<Mac>> {
+        ++factory_calls;
+        return util::Status(util::error::INVALID_ARGUMENT, "bad key");
+      },
+      TinkKeyInfo(42));
+  ASSERT_THAT(add_result.status(), IsOk());
+  auto* entry = add_result.ValueOrDie();
+
+  // The error is kept, and the factory is not called again.
+  EXPECT_THAT(entry->GetOrCreatePrimitive().status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(entry->GetOrCreatePrimitive().status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_EQ(factory_calls, 1);
+}
+
+TEST_F(PrimitiveSetTest, LazyPrimitiveCannotBePrimary) {
+  PrimitiveSet<Mac> mac_set;
+  auto add_result = mac_set.AddLazyPrimitive(
+      []() -> util::StatusOr<std::unique_ptr<Mac>> {
+        return {absl::make_unique<DummyMac>("lazy MAC")};
+      },
+      TinkKeyInfo(42));
+  ASSERT_THAT(add_result.status(), IsOk());
+  EXPECT_THAT(mac_set.set_primary(add_result.ValueOrDie()),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(PrimitiveSetTest, LazyPrimitiveNullFactory) {
+  PrimitiveSet<Mac> mac_set;
+  EXPECT_THAT(mac_set.AddLazyPrimitive(nullptr, TinkKeyInfo(42)).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(PrimitiveSetTest, EagerPrimitiveIsNotLazy) {
+  PrimitiveSet<Mac> mac_set;
+  auto add_result = mac_set.AddPrimitive(
+      absl::make_unique<DummyMac>("dummy MAC"), TinkKeyInfo(42));
+  ASSERT_THAT(add_result.status(), IsOk());
+  auto* entry = add_result.ValueOrDie();
+  EXPECT_FALSE(entry->is_lazy());
+  EXPECT_EQ(entry->GetOrCreatePrimitive().ValueOrDie(),
+            &entry->get_primitive());
+}
+
+TEST_F(PrimitiveSetTest, SharedPrimitive) {
+  std::shared_ptr<Mac> mac = std::make_shared<DummyMac>("shared MAC");
+  PrimitiveSet<Mac> mac_set;
+  PrimitiveSet<Mac> other_mac_set;
+  auto add_result = mac_set.AddSharedPrimitive(mac, TinkKeyInfo(42));
+  auto other_add_result = other_mac_set.AddSharedPrimitive(mac, TinkKeyInfo(7));
+  ASSERT_THAT(add_result.status(), IsOk());
+  ASSERT_THAT(other_add_result.status(), IsOk());
+  EXPECT_EQ(&add_result.ValueOrDie()->get_primitive(), mac.get());
+  EXPECT_EQ(&other_add_result.ValueOrDie()->get_primitive(), mac.get());
+  EXPECT_THAT(mac_set.AddSharedPrimitive(nullptr, TinkKeyInfo(43)).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+
+  auto lazy_result = mac_set.AddLazySharedPrimitive(
+      [mac]() -> util::StatusOr<std::shared_ptr<Mac>> { return mac; },
+      TinkKeyInfo(44));
+  ASSERT_THAT(lazy_result.status(), IsOk());
+  EXPECT_EQ(lazy_result.ValueOrDie()->GetOrCreatePrimitive().ValueOrDie(),
+            mac.get());
+}
+
+TEST_F(PrimitiveSetTest, EstimateMemoryUsage) {
+  PrimitiveSet<Mac> mac_set;
+  size_t empty_usage = mac_set.EstimateMemoryUsage();
+  EXPECT_GE(empty_usage, sizeof(mac_set));
+
+  for (uint32_t key_id = 1; key_id <= 10; ++key_id) {
+    ASSERT_THAT(mac_set
+                    .AddPrimitive(absl::make_unique<DummyMac>("MAC"),
+                                  TinkKeyInfo(key_id))
+                    .status(),
+                IsOk());
+  }
+  size_t usage = mac_set.EstimateMemoryUsage();
+  EXPECT_GE(usage, empty_usage + 10 * sizeof(PrimitiveSet<Mac>::Entry<Mac>));
+
+  mac_set.Freeze();
+  EXPECT_GT(mac_set.EstimateMemoryUsage(), usage);
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
@@ -0,0 +1,108 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/replicated_primitive.h"
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tink/aead.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+
+using ::crypto::tink::test::DummyAead;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+namespace crypto {
+namespace tink {
+namespace {
+
+// Returns a factory of DummyAeads named "replica0", "replica1", ...
+std::function<util::StatusOr<std::unique_ptr<Aead>>()> NewFactory(
+    int* count) {
+  return [count]() -> util::StatusOr<std::unique_ptr<Aead>> {
+    return {absl::make_unique<DummyAead>(absl::StrCat("replica", (*count)++))};
+  };
+}
+
+std::vector<int> AllCpus() {
+  std::vector<int> cpus;
+  for (const std::vector<int>& node : internal::NumaNodeCpus()) {
+    cpus.insert(cpus.end(), node.begin(), node.end());
+  }
+  return cpus;
+}
+
+TEST(ReplicatedPrimitiveTest, OneReplicaPerCpuGroup) {
+  int count = 0;
+  auto result =
+      ReplicatedPrimitive<Aead>::New(NewFactory(&count), {{}, AllCpus(), {}});
+  ASSERT_THAT(result.status(), IsOk());
+  const ReplicatedPrimitive<Aead>& replicated = *result.ValueOrDie();
+  EXPECT_EQ(3, count);
+  EXPECT_EQ(3, replicated.num_replicas());
+
+  // All CPUs are in the second group.
+  std::string ciphertext = replicated.Get().Encrypt("data", "").ValueOrDie();
+  EXPECT_THAT(replicated.replica(1).Decrypt(ciphertext, "").status(), IsOk());
+  EXPECT_FALSE(replicated.replica(0).Decrypt(ciphertext, "").ok());
+  EXPECT_FALSE(replicated.replica(2).Decrypt(ciphertext, "").ok());
+}
+
+TEST(ReplicatedPrimitiveTest, DefaultsToNumaNodes) {
+  int count = 0;
+  auto result = ReplicatedPrimitive<Aead>::New(NewFactory(&count));
+  ASSERT_THAT(result.status(), IsOk());
+  EXPECT_EQ(internal::NumaNodeCpus().size(),
+            result.ValueOrDie()->num_replicas());
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&result]() {
+      const Aead& aead = result.ValueOrDie()->Get();
+      EXPECT_THAT(aead.Encrypt("data", "").status(), IsOk());
+    });
+  }
+  for (auto& thread : threads) thread.join();
+}
+
+TEST(ReplicatedPrimitiveTest, Errors) {
+  int count = 0;
+  EXPECT_THAT(ReplicatedPrimitive<Aead>::New(NewFactory(&count), {}).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+
+  auto failing_factory = []() -> util::StatusOr<std::unique_ptr<Aead>> {
+    return util::Status(util::error::FAILED_PRECONDITION, "no key");
+  };
+  EXPECT_THAT(ReplicatedPrimitive<Aead>::New(failing_factory).status(),
+              StatusIs(util::error::FAILED_PRECONDITION));
+
+  auto null_factory = []() -> util::StatusOr<std::unique_ptr<Aead>> {
+    return {std::unique_ptr<Aead>()};
+  };
+  EXPECT_THAT(ReplicatedPrimitive<Aead>::New(null_factory).status(),
+              StatusIs(util::error::INTERNAL));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
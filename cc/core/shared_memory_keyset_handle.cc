@@ -0,0 +1,182 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/shared_memory_keyset_handle.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "absl/memory/memory.h"
+#include "tink/cleartext_keyset_handle.h"
+#include "tink/keyset_handle.h"
+#include "tink/util/errors.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+using google::crypto::tink::Keyset;
+
+namespace crypto {
+namespace tink {
+
+#if defined(__linux__) && defined(MFD_ALLOW_SEALING) && defined(F_ADD_SEALS)
+
+namespace {
+
+constexpr int kRequiredSeals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE;
+
+util::Status WriteFully(int fd, const uint8_t* data, std::size_t size) {
+  while (size > 0) {
+    ssize_t result = write(fd, data, size);
+    if (result < 0) {
+      if (errno == EINTR) continue;
+      return ToStatusF(util::error::INTERNAL,
+                       "I/O error upon write: %d", errno);
+    }
+    data += result;
+    size -= result;
+  }
+  return util::OkStatus();
+}
+
+}  // namespace
+
+SharedMemoryKeysetHandle::Segment::~Segment() {
+  if (mapping_ != nullptr) {
+    munlock(mapping_, size_);
+    munmap(mapping_, size_);
+  }
+  close(fd_);
+}
+
+// static
+util::StatusOr<std::unique_ptr<SharedMemoryKeysetHandle::Segment>>
+SharedMemoryKeysetHandle::Export(const KeysetHandle& keyset_handle) {
+  const Keyset& keyset = CleartextKeysetHandle::GetKeyset(keyset_handle);
+  util::SecretData serialized_keyset(keyset.ByteSizeLong());
+  if (!keyset.SerializeToArray(serialized_keyset.data(),
+                               serialized_keyset.size())) {
+    return util::Status(util::error::INTERNAL,
+                        "Could not serialize the keyset.");
+  }
+  int fd = memfd_create("tink_keyset", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    return ToStatusF(util::error::INTERNAL,
+                     "Could not create a memory file: %d", errno);
+  }
+  // The keyset is written with write() rather than through a mapping, since
+  // F_SEAL_WRITE cannot be added while writable shared mappings exist.
+  auto status =
+      WriteFully(fd, serialized_keyset.data(), serialized_keyset.size());
+  if (!status.ok()) {
+    close(fd);
+    return status;
+  }
+  if (fcntl(fd, F_ADD_SEALS, kRequiredSeals | F_SEAL_SEAL) < 0) {
+    int seal_errno = errno;
+    close(fd);
+    return ToStatusF(util::error::INTERNAL,
+                     "Could not seal the memory file: %d", seal_errno);
+  }
+  // Keep a locked mapping, so that the keyset is not swapped out while this
+  // process exports it. Both steps are best effort.
+  void* mapping = nullptr;
+  if (!serialized_keyset.empty()) {
+    mapping = mmap(nullptr, serialized_keyset.size(), PROT_READ, MAP_SHARED,
+                   fd, 0);
+    if (mapping == MAP_FAILED) {
+      mapping = nullptr;
+    } else {
+      mlock(mapping, serialized_keyset.size());
+#ifdef MADV_DONTDUMP
+      madvise(mapping, serialized_keyset.size(), MADV_DONTDUMP);
+#endif
+    }
+  }
+  return absl::WrapUnique(new Segment(fd, mapping, serialized_keyset.size()));
+}
+
+// static
+util::StatusOr<std::unique_ptr<KeysetHandle>>
+SharedMemoryKeysetHandle::Import(int fd) {
+  int seals = fcntl(fd, F_GET_SEALS);
+  if (seals < 0) {
+    return ToStatusF(util::error::INVALID_ARGUMENT,
+                     "Not a sealable memory file: %d", errno);
+  }
+  if ((seals & kRequiredSeals) != kRequiredSeals) {
+    return util::Status(util::error::FAILED_PRECONDITION,
+                        "The memory file is not sealed.");
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) < 0) {
+    return ToStatusF(util::error::INTERNAL, "I/O error upon fstat: %d", errno);
+  }
+  std::size_t size = file_stat.st_size;
+  Keyset keyset;
+  if (size > 0) {
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+      return ToStatusF(util::error::INTERNAL,
+                       "Could not map the memory file: %d", errno);
+    }
+    bool parsed = keyset.ParseFromArray(mapping, size);
+    munmap(mapping, size);
+    if (!parsed) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "Could not parse the memory file as a Keyset-proto.");
+    }
+  }
+  return CleartextKeysetHandle::GetKeysetHandle(keyset);
+}
+
+#else
+
+namespace {
+
+constexpr char kUnsupported[] =
+    "Sealed memory files are not supported on this platform.";
+
+}  // namespace
+
+SharedMemoryKeysetHandle::Segment::~Segment() {}
+
+// static
+util::StatusOr<std::unique_ptr<SharedMemoryKeysetHandle::Segment>>
+SharedMemoryKeysetHandle::Export(const KeysetHandle& keyset_handle) {
+  return util::Status(util::error::UNIMPLEMENTED, kUnsupported);
+}
+
+// static
+util::StatusOr<std::unique_ptr<KeysetHandle>>
+SharedMemoryKeysetHandle::Import(int fd) {
+  return util::Status(util::error::UNIMPLEMENTED, kUnsupported);
+}
+
+#endif
+
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,107 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/shared_memory_keyset_handle.h"
+
+#include <memory>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "gtest/gtest.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/cleartext_keyset_handle.h"
+#include "tink/config/tink_config.h"
+#include "tink/keyset_handle.h"
+#include "tink/util/test_matchers.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+class SharedMemoryKeysetHandleTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_THAT(TinkConfig::Register(), IsOk());
+  }
+};
+
+TEST_F(SharedMemoryKeysetHandleTest, ExportImport) {
+  auto handle_result = KeysetHandle::GenerateNew(AeadKeyTemplates::Aes128Gcm());
+  ASSERT_THAT(handle_result.status(), IsOk());
+  auto handle = std::move(handle_result.ValueOrDie());
+  auto segment_result = SharedMemoryKeysetHandle::Export(*handle);
+  if (segment_result.status().error_code() == util::error::UNIMPLEMENTED) {
+    GTEST_SKIP() << "Not supported on this platform";
+  }
+  ASSERT_THAT(segment_result.status(), IsOk());
+  auto segment = std::move(segment_result.ValueOrDie());
+
+  for (int i = 0; i < 2; i++) {
+    auto imported_result = SharedMemoryKeysetHandle::Import(segment->fd());
+    ASSERT_THAT(imported_result.status(), IsOk());
+    EXPECT_EQ(CleartextKeysetHandle::GetKeyset(*handle).SerializeAsString(),
+              CleartextKeysetHandle::GetKeyset(*imported_result.ValueOrDie())
+                  .SerializeAsString());
+  }
+
+  // The imported keyset is usable.
+  auto aead_result = SharedMemoryKeysetHandle::Import(segment->fd())
+                         .ValueOrDie()
+                         ->GetPrimitive<Aead>();
+  ASSERT_THAT(aead_result.status(), IsOk());
+  auto ciphertext =
+      handle->GetPrimitive<Aead>().ValueOrDie()->Encrypt("plaintext", "ad");
+  ASSERT_THAT(ciphertext.status(), IsOk());
+  auto plaintext =
+      aead_result.ValueOrDie()->Decrypt(ciphertext.ValueOrDie(), "ad");
+  ASSERT_THAT(plaintext.status(), IsOk());
+  EXPECT_EQ(plaintext.ValueOrDie(), "plaintext");
+
+  // The memory file cannot be modified.
+  EXPECT_LT(write(segment->fd(), "x", 1), 0);
+}
+
+#if defined(__linux__) && defined(MFD_ALLOW_SEALING)
+
+TEST_F(SharedMemoryKeysetHandleTest, ImportRequiresSeals) {
+  int fd = memfd_create("unsealed", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  ASSERT_GE(fd, 0);
+  EXPECT_THAT(SharedMemoryKeysetHandle::Import(fd).status(),
+              StatusIs(util::error::FAILED_PRECONDITION));
+  close(fd);
+
+  int pipe_fds[2];
+  ASSERT_EQ(pipe(pipe_fds), 0);
+  EXPECT_THAT(SharedMemoryKeysetHandle::Import(pipe_fds[0]).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  close(pipe_fds[0]);
+  close(pipe_fds[1]);
+}
+
+#endif
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,208 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/static_config.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_wrapper.h"
+#include "tink/core/key_type_manager.h"
+#include "tink/keyset_handle.h"
+#include "tink/mac.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "tink/util/test_keyset_handle.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+#include "proto/aes_gcm.pb.h"
+#include "proto/hmac.pb.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::DummyAead;
+using ::crypto::tink::test::DummyMac;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::google::crypto::tink::AesGcmKey;
+using ::google::crypto::tink::HmacKey;
+using ::google::crypto::tink::KeyData;
+using ::google::crypto::tink::Keyset;
+using ::google::crypto::tink::KeyStatusType;
+using ::google::crypto::tink::OutputPrefixType;
+
+// Creates DummyAeads named after the key value.
+class FakeAeadKeyManager
+    : public KeyTypeManager<AesGcmKey, void, List<Aead>> {
+ public:
+  class AeadFactory : public PrimitiveFactory<Aead> {
+   public:
+    util::StatusOr<std::unique_ptr<Aead>> Create(
+        const AesGcmKey& key) const override {
+      return {absl::make_unique<DummyAead>(key.key_value())};
+    }
+  };
+
+  FakeAeadKeyManager() : KeyTypeManager(absl::make_unique<AeadFactory>()) {}
+
+  KeyData::KeyMaterialType key_material_type() const override {
+    return KeyData::SYMMETRIC;
+  }
+  uint32_t get_version() const override { return 0; }
+  const std::string& get_key_type() const override { return key_type_; }
+
+  util::Status ValidateKey(const AesGcmKey& key) const override {
+    if (key.key_value().empty()) {
+      return util::Status(util::error::INVALID_ARGUMENT, "empty key");
+    }
+    return util::OkStatus();
+  }
+
+ private:
+  const std::string key_type_ = "type.googleapis.com/test.FakeAeadKey";
+};
+
+// Creates DummyMacs named after the key value.
+class FakeMacKeyManager : public KeyTypeManager<HmacKey, void, List<Mac>> {
+ public:
+  class MacFactory : public PrimitiveFactory<Mac> {
+   public:
+    util::StatusOr<std::unique_ptr<Mac>> Create(
+        const HmacKey& key) const override {
+      return {absl::make_unique<DummyMac>(key.key_value())};
+    }
+  };
+
+  FakeMacKeyManager() : KeyTypeManager(absl::make_unique<MacFactory>()) {}
+
+  KeyData::KeyMaterialType key_material_type() const override {
+    return KeyData::SYMMETRIC;
+  }
+  uint32_t get_version() const override { return 0; }
+  const std::string& get_key_type() const override { return key_type_; }
+
+  util::Status ValidateKey(const HmacKey& key) const override {
+    return util::OkStatus();
+  }
+
+ private:
+  const std::string key_type_ = "type.googleapis.com/test.FakeMacKey";
+};
+
+// Manages the same key type as FakeAeadKeyManager.
+class OtherFakeAeadKeyManager : public FakeAeadKeyManager {};
+
+using Config = StaticConfig<FakeAeadKeyManager, FakeMacKeyManager>;
+
+KeyData AeadKeyData(const std::string& name) {
+  AesGcmKey key;
+  key.set_key_value(name);
+  KeyData key_data;
+  key_data.set_type_url("type.googleapis.com/test.FakeAeadKey");
+  key_data.set_value(key.SerializeAsString());
+  key_data.set_key_material_type(KeyData::SYMMETRIC);
+  return key_data;
+}
+
+TEST(StaticConfigTest, GetPrimitiveForKeyData) {
+  auto config_result = Config::New();
+  ASSERT_THAT(config_result.status(), IsOk());
+  const Config& config = *config_result.ValueOrDie();
+  EXPECT_TRUE(config.DoesSupport("type.googleapis.com/test.FakeAeadKey"));
+  EXPECT_TRUE(config.DoesSupport("type.googleapis.com/test.FakeMacKey"));
+  EXPECT_FALSE(config.DoesSupport("type.googleapis.com/test.OtherKey"));
+  EXPECT_FALSE(config.DoesSupport(""));
+  EXPECT_EQ("type.googleapis.com/test.FakeMacKey",
+            config.get_key_type_manager<FakeMacKeyManager>().get_key_type());
+
+  auto aead_result = config.GetPrimitive<Aead>(AeadKeyData("aead"));
+  ASSERT_THAT(aead_result.status(), IsOk());
+  std::string ciphertext =
+      aead_result.ValueOrDie()->Encrypt("plaintext", "aad").ValueOrDie();
+  EXPECT_THAT(DummyAead("aead").Decrypt(ciphertext, "aad").status(), IsOk());
+
+  // The manager of the key type does not create Macs.
+  EXPECT_THAT(config.GetPrimitive<Mac>(AeadKeyData("aead")).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  // Keys that do not parse or validate.
+  KeyData bad_key_data = AeadKeyData("aead");
+  bad_key_data.set_value("not a key");
+  EXPECT_THAT(config.GetPrimitive<Aead>(bad_key_data).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(config.GetPrimitive<Aead>(AeadKeyData("")).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  // Key types that are not in the config.
+  KeyData other_key_data = AeadKeyData("aead");
+  other_key_data.set_type_url("type.googleapis.com/test.OtherKey");
+  EXPECT_THAT(config.GetPrimitive<Aead>(other_key_data).status(),
+              StatusIs(util::error::NOT_FOUND));
+}
+
+TEST(StaticConfigTest, GetPrimitiveForKeyset) {
+  Keyset keyset;
+  for (uint32_t key_id : {1, 2}) {
+    Keyset::Key* key = keyset.add_key();
+    *key->mutable_key_data() = AeadKeyData(absl::StrCat("aead", key_id));
+    key->set_key_id(key_id);
+    key->set_output_prefix_type(OutputPrefixType::TINK);
+    key->set_status(KeyStatusType::ENABLED);
+  }
+  keyset.set_primary_key_id(2);
+  std::unique_ptr<KeysetHandle> keyset_handle =
+      TestKeysetHandle::GetKeysetHandle(keyset);
+
+  auto config_result = Config::New();
+  ASSERT_THAT(config_result.status(), IsOk());
+  auto aead_result = config_result.ValueOrDie()->GetPrimitive<Aead>(
+      *keyset_handle, AeadWrapper());
+  ASSERT_THAT(aead_result.status(), IsOk());
+  const Aead& aead = *aead_result.ValueOrDie();
+  std::string ciphertext = aead.Encrypt("plaintext", "aad").ValueOrDie();
+  auto plaintext_result = aead.Decrypt(ciphertext, "aad");
+  ASSERT_THAT(plaintext_result.status(), IsOk());
+  EXPECT_EQ("plaintext", plaintext_result.ValueOrDie());
+  // The primary key encrypted.
+  EXPECT_THAT(ciphertext, testing::HasSubstr("aead2"));
+
+  keyset.mutable_key(0)->mutable_key_data()->set_type_url(
+      "type.googleapis.com/test.OtherKey");
+  EXPECT_THAT(config_result.ValueOrDie()
+                  ->GetPrimitive<Aead>(
+                      *TestKeysetHandle::GetKeysetHandle(keyset), AeadWrapper())
+                  .status(),
+              StatusIs(util::error::NOT_FOUND));
+}
+
+TEST(StaticConfigTest, DuplicateKeyTypes) {
+  EXPECT_THAT(
+      (StaticConfig<FakeAeadKeyManager, OtherFakeAeadKeyManager>::New()
+           .status()),
+      StatusIs(util::error::ALREADY_EXISTS));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,39 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/tracing.h"
+
+#include <atomic>
+
+namespace crypto {
+namespace tink {
+
+namespace {
+
+// Constant-initialized, so it can be used during static initialization.
+std::atomic<Tracer*> tracer{nullptr};
+
+}  // namespace
+
+void SetTracer(Tracer* new_tracer) {
+  tracer.store(new_tracer, std::memory_order_release);
+}
+
+Tracer* GetTracer() { return tracer.load(std::memory_order_acquire); }
+
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,135 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/tracing.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+// The data of a span created by RecordingTracer.
+struct SpanRecord {
+  std::string name;
+  std::map<std::string, int64_t> attributes;
+  bool ended = false;
+  util::Status status;
+};
+
+// Records the spans it creates in 'spans'.
+class RecordingTracer : public Tracer {
+ public:
+  std::unique_ptr<TraceSpan> StartSpan(absl::string_view name) override {
+    spans.push_back(std::make_shared<SpanRecord>());
+    spans.back()->name = std::string(name);
+    return std::unique_ptr<TraceSpan>(new Span(spans.back()));
+  }
+
+  std::vector<std::shared_ptr<SpanRecord>> spans;
+
+ private:
+  class Span : public TraceSpan {
+   public:
+    explicit Span(std::shared_ptr<SpanRecord> record)
+        : record_(std::move(record)) {}
+
+    void SetAttribute(absl::string_view key, int64_t value) override {
+      record_->attributes[std::string(key)] = value;
+    }
+
+    void End(const util::Status& status) override {
+      EXPECT_FALSE(record_->ended);
+      record_->ended = true;
+      record_->status = status;
+    }
+
+   private:
+    std::shared_ptr<SpanRecord> record_;
+  };
+};
+
+class TracingTest : public ::testing::Test {
+ protected:
+  void TearDown() override { SetTracer(nullptr); }
+};
+
+TEST_F(TracingTest, NoTracerByDefault) {
+  EXPECT_EQ(GetTracer(), nullptr);
+  EXPECT_EQ(internal::StartSpan("tink.test"), nullptr);
+  internal::EndSpan(nullptr, util::Status::OK);
+  internal::ScopedSpan span("tink.test");
+  span.SetAttribute("bytes", 1);
+  span.set_status(util::Status(util::error::INTERNAL, "error"));
+}
+
+TEST_F(TracingTest, StartAndEndSpan) {
+  RecordingTracer tracer;
+  SetTracer(&tracer);
+  EXPECT_EQ(GetTracer(), &tracer);
+  std::unique_ptr<TraceSpan> span = internal::StartSpan("tink.test");
+  ASSERT_NE(span, nullptr);
+  ASSERT_EQ(tracer.spans.size(), 1);
+  EXPECT_EQ(tracer.spans[0]->name, "tink.test");
+  EXPECT_FALSE(tracer.spans[0]->ended);
+  internal::EndSpan(span.get(), util::Status(util::error::INTERNAL, "error"));
+  EXPECT_TRUE(tracer.spans[0]->ended);
+  EXPECT_THAT(tracer.spans[0]->status, StatusIs(util::error::INTERNAL));
+}
+
+TEST_F(TracingTest, ScopedSpanEndsWithLastStatus) {
+  RecordingTracer tracer;
+  SetTracer(&tracer);
+  {
+    internal::ScopedSpan span("tink.test");
+    span.SetAttribute("bytes", 42);
+  }
+  {
+    internal::ScopedSpan span("tink.test.failing");
+    span.set_status(util::Status(util::error::UNAVAILABLE, "unavailable"));
+  }
+  ASSERT_EQ(tracer.spans.size(), 2);
+  EXPECT_TRUE(tracer.spans[0]->ended);
+  EXPECT_THAT(tracer.spans[0]->status, IsOk());
+  EXPECT_EQ(tracer.spans[0]->attributes["bytes"], 42);
+  EXPECT_EQ(tracer.spans[1]->name, "tink.test.failing");
+  EXPECT_TRUE(tracer.spans[1]->ended);
+  EXPECT_THAT(tracer.spans[1]->status, StatusIs(util::error::UNAVAILABLE));
+}
+
+TEST_F(TracingTest, RemoveTracer) {
+  RecordingTracer tracer;
+  SetTracer(&tracer);
+  SetTracer(nullptr);
+  { internal::ScopedSpan span("tink.test"); }
+  EXPECT_TRUE(tracer.spans.empty());
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
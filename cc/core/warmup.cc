@@ -0,0 +1,166 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/warmup.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "tink/crypto_format.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+using ::google::crypto::tink::KeysetInfo;
+using ::google::crypto::tink::KeyStatusType;
+
+namespace {
+
+constexpr absl::string_view kMessage = "Tink warm-up message";
+constexpr absl::string_view kContext = "Tink warm-up context";
+
+// Returns dummy outputs with the distinct output prefixes of the enabled keys
+// in 'keyset_info', followed by 'length' zero bytes, which is long enough to
+// get past the length checks of all primitives. The RAW prefix is the empty
+// one.
+util::StatusOr<std::vector<std::string>> DummyOutputs(
+    const KeysetInfo& keyset_info, int length) {
+  absl::flat_hash_set<std::string> prefixes;
+  std::vector<std::string> outputs;
+  for (const KeysetInfo::KeyInfo& key_info : keyset_info.key_info()) {
+    if (key_info.status() != KeyStatusType::ENABLED) continue;
+    auto prefix_result = CryptoFormat::GetOutputPrefix(key_info);
+    if (!prefix_result.ok()) return prefix_result.status();
+    if (!prefixes.insert(prefix_result.ValueOrDie()).second) continue;
+    outputs.push_back(
+        absl::StrCat(prefix_result.ValueOrDie(), std::string(length, '\0')));
+  }
+  return outputs;
+}
+
+// Large enough for the tags, nonces and encapsulated keys of all key types.
+constexpr int kDummyOutputLength = 1024;
+
+util::Status CheckRoundTrip(const util::StatusOr<std::string>& result) {
+  if (!result.ok()) return result.status();
+  if (result.ValueOrDie() != kMessage) {
+    return util::Status(util::error::INTERNAL,
+                        "warm-up round trip returned a different message");
+  }
+  return util::OkStatus();
+}
+
+}  // namespace
+
+util::StatusOr<absl::Duration> Warmup(const Aead& primitive,
+                                      const KeysetInfo& keyset_info) {
+  absl::Time start = absl::Now();
+  auto outputs_result = DummyOutputs(keyset_info, kDummyOutputLength);
+  if (!outputs_result.ok()) return outputs_result.status();
+  auto encrypt_result = primitive.Encrypt(kMessage, kContext);
+  if (!encrypt_result.ok()) return encrypt_result.status();
+  util::Status status =
+      CheckRoundTrip(primitive.Decrypt(encrypt_result.ValueOrDie(), kContext));
+  if (!status.ok()) return status;
+  for (const std::string& output : outputs_result.ValueOrDie()) {
+    primitive.Decrypt(output, kContext).status().IgnoreError();
+  }
+  return absl::Now() - start;
+}
+
+util::StatusOr<absl::Duration> Warmup(const DeterministicAead& primitive,
+                                      const KeysetInfo& keyset_info) {
+  absl::Time start = absl::Now();
+  auto outputs_result = DummyOutputs(keyset_info, kDummyOutputLength);
+  if (!outputs_result.ok()) return outputs_result.status();
+  auto encrypt_result = primitive.EncryptDeterministically(kMessage, kContext);
+  if (!encrypt_result.ok()) return encrypt_result.status();
+  util::Status status = CheckRoundTrip(primitive.DecryptDeterministically(
+      encrypt_result.ValueOrDie(), kContext));
+  if (!status.ok()) return status;
+  for (const std::string& output : outputs_result.ValueOrDie()) {
+    primitive.DecryptDeterministically(output, kContext)
+        .status()
+        .IgnoreError();
+  }
+  return absl::Now() - start;
+}
+
+util::StatusOr<absl::Duration> Warmup(const Mac& primitive,
+                                      const KeysetInfo& keyset_info) {
+  absl::Time start = absl::Now();
+  auto outputs_result = DummyOutputs(keyset_info, kDummyOutputLength);
+  if (!outputs_result.ok()) return outputs_result.status();
+  auto compute_result = primitive.ComputeMac(kMessage);
+  if (!compute_result.ok()) return compute_result.status();
+  util::Status status =
+      primitive.VerifyMac(compute_result.ValueOrDie(), kMessage);
+  if (!status.ok()) return status;
+  for (const std::string& output : outputs_result.ValueOrDie()) {
+    primitive.VerifyMac(output, kMessage).IgnoreError();
+  }
+  return absl::Now() - start;
+}
+
+util::StatusOr<absl::Duration> Warmup(const PublicKeySign& primitive,
+                                      const KeysetInfo& keyset_info) {
+  absl::Time start = absl::Now();
+  auto sign_result = primitive.Sign(kMessage);
+  if (!sign_result.ok()) return sign_result.status();
+  return absl::Now() - start;
+}
+
+util::StatusOr<absl::Duration> Warmup(const PublicKeyVerify& primitive,
+                                      const KeysetInfo& keyset_info) {
+  absl::Time start = absl::Now();
+  auto outputs_result = DummyOutputs(keyset_info, kDummyOutputLength);
+  if (!outputs_result.ok()) return outputs_result.status();
+  for (const std::string& output : outputs_result.ValueOrDie()) {
+    primitive.Verify(output, kMessage).IgnoreError();
+  }
+  return absl::Now() - start;
+}
+
+util::StatusOr<absl::Duration> Warmup(const HybridEncrypt& primitive,
+                                      const KeysetInfo& keyset_info) {
+  absl::Time start = absl::Now();
+  auto encrypt_result = primitive.Encrypt(kMessage, kContext);
+  if (!encrypt_result.ok()) return encrypt_result.status();
+  return absl::Now() - start;
+}
+
+util::StatusOr<absl::Duration> Warmup(const HybridDecrypt& primitive,
+                                      const KeysetInfo& keyset_info) {
+  absl::Time start = absl::Now();
+  auto outputs_result = DummyOutputs(keyset_info, kDummyOutputLength);
+  if (!outputs_result.ok()) return outputs_result.status();
+  for (const std::string& output : outputs_result.ValueOrDie()) {
+    primitive.Decrypt(output, kContext).status().IgnoreError();
+  }
+  return absl::Now() - start;
+}
+
+}  // namespace tink
+}  // namespace crypto
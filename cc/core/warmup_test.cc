@@ -0,0 +1,171 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/warmup.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_wrapper.h"
+#include "tink/mac/mac_wrapper.h"
+#include "tink/primitive_set.h"
+#include "tink/signature/public_key_sign_wrapper.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+#include "proto/tink.pb.h"
+
+using ::crypto::tink::test::DummyAead;
+using ::crypto::tink::test::DummyMac;
+using ::crypto::tink::test::DummyPublicKeySign;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::google::crypto::tink::KeysetInfo;
+using ::google::crypto::tink::KeyStatusType;
+using ::google::crypto::tink::OutputPrefixType;
+
+namespace crypto {
+namespace tink {
+namespace {
+
+// A DummyAead that counts the calls of Decrypt() per name.
+class CountingAead : public DummyAead {
+ public:
+  CountingAead(absl::string_view name,
+               absl::flat_hash_map<std::string, int>* decrypt_calls)
+      : DummyAead(name), name_(name), decrypt_calls_(decrypt_calls) {}
+
+  util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view associated_data) const override {
+    (*decrypt_calls_)[name_]++;
+    return DummyAead::Decrypt(ciphertext, associated_data);
+  }
+
+ private:
+  const std::string name_;
+  absl::flat_hash_map<std::string, int>* decrypt_calls_;
+};
+
+// An Aead whose ciphertexts cannot be decrypted.
+class BrokenAead : public DummyAead {
+ public:
+  BrokenAead() : DummyAead("broken") {}
+
+  util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view associated_data) const override {
+    return util::Status(util::error::INVALID_ARGUMENT, "decryption failed");
+  }
+};
+
+KeysetInfo::KeyInfo* AddKey(uint32_t key_id,
+                            OutputPrefixType output_prefix_type,
+                            KeyStatusType status, KeysetInfo* keyset_info) {
+  KeysetInfo::KeyInfo* key_info = keyset_info->add_key_info();
+  key_info->set_key_id(key_id);
+  key_info->set_output_prefix_type(output_prefix_type);
+  key_info->set_status(status);
+  return key_info;
+}
+
+TEST(WarmupTest, AeadUsesEveryEnabledKey) {
+  KeysetInfo keyset_info;
+  AddKey(1, OutputPrefixType::TINK, KeyStatusType::ENABLED, &keyset_info);
+  AddKey(2, OutputPrefixType::LEGACY, KeyStatusType::ENABLED, &keyset_info);
+  AddKey(3, OutputPrefixType::RAW, KeyStatusType::ENABLED, &keyset_info);
+  AddKey(4, OutputPrefixType::TINK, KeyStatusType::DISABLED, &keyset_info);
+  keyset_info.set_primary_key_id(1);
+
+  absl::flat_hash_map<std::string, int> decrypt_calls;
+  auto aead_set = absl::make_unique<PrimitiveSet<Aead>>();
+  for (const KeysetInfo::KeyInfo& key_info : keyset_info.key_info()) {
+    if (key_info.status() != KeyStatusType::ENABLED) continue;
+    auto entry_result = aead_set->AddPrimitive(
+        absl::make_unique<CountingAead>(std::to_string(key_info.key_id()),
+                                        &decrypt_calls),
+        key_info);
+    ASSERT_THAT(entry_result.status(), IsOk());
+    if (key_info.key_id() == keyset_info.primary_key_id()) {
+      ASSERT_THAT(aead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+    }
+  }
+  auto aead_result = AeadWrapper().Wrap(std::move(aead_set));
+  ASSERT_THAT(aead_result.status(), IsOk());
+
+  auto warmup_result = Warmup(*aead_result.ValueOrDie(), keyset_info);
+  ASSERT_THAT(warmup_result.status(), IsOk());
+  EXPECT_GE(warmup_result.ValueOrDie(), absl::ZeroDuration());
+  // The primary key decrypts the round trip and its dummy ciphertext.
+  EXPECT_EQ(2, decrypt_calls["1"]);
+  EXPECT_EQ(1, decrypt_calls["2"]);
+  // The RAW key is tried for every dummy ciphertext whose prefix did not
+  // match, and for the one without a prefix.
+  EXPECT_GE(decrypt_calls["3"], 1);
+}
+
+TEST(WarmupTest, FailsIfThePrimaryKeyIsBroken) {
+  KeysetInfo keyset_info;
+  KeysetInfo::KeyInfo* key_info =
+      AddKey(1, OutputPrefixType::TINK, KeyStatusType::ENABLED, &keyset_info);
+  keyset_info.set_primary_key_id(1);
+  auto aead_set = absl::make_unique<PrimitiveSet<Aead>>();
+  auto entry_result =
+      aead_set->AddPrimitive(absl::make_unique<BrokenAead>(), *key_info);
+  ASSERT_THAT(entry_result.status(), IsOk());
+  ASSERT_THAT(aead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  auto aead_result = AeadWrapper().Wrap(std::move(aead_set));
+  ASSERT_THAT(aead_result.status(), IsOk());
+
+  EXPECT_THAT(Warmup(*aead_result.ValueOrDie(), keyset_info).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(WarmupTest, MacAndPublicKeySign) {
+  KeysetInfo keyset_info;
+  KeysetInfo::KeyInfo* key_info =
+      AddKey(7, OutputPrefixType::TINK, KeyStatusType::ENABLED, &keyset_info);
+  keyset_info.set_primary_key_id(7);
+
+  auto mac_set = absl::make_unique<PrimitiveSet<Mac>>();
+  auto mac_entry =
+      mac_set->AddPrimitive(absl::make_unique<DummyMac>("mac"), *key_info);
+  ASSERT_THAT(mac_entry.status(), IsOk());
+  ASSERT_THAT(mac_set->set_primary(mac_entry.ValueOrDie()), IsOk());
+  auto mac_result = MacWrapper().Wrap(std::move(mac_set));
+  ASSERT_THAT(mac_result.status(), IsOk());
+  EXPECT_THAT(Warmup(*mac_result.ValueOrDie(), keyset_info).status(), IsOk());
+
+  auto sign_set = absl::make_unique<PrimitiveSet<PublicKeySign>>();
+  auto sign_entry = sign_set->AddPrimitive(
+      absl::make_unique<DummyPublicKeySign>("sign"), *key_info);
+  ASSERT_THAT(sign_entry.status(), IsOk());
+  ASSERT_THAT(sign_set->set_primary(sign_entry.ValueOrDie()), IsOk());
+  auto sign_result = PublicKeySignWrapper().Wrap(std::move(sign_set));
+  ASSERT_THAT(sign_result.status(), IsOk());
+  EXPECT_THAT(Warmup(*sign_result.ValueOrDie(), keyset_info).status(),
+              IsOk());
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,149 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_COST_CALIBRATION_H_
+#define TINK_COST_CALIBRATION_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "tink/aead.h"
+#include "tink/deterministic_aead.h"
+#include "tink/hybrid_decrypt.h"
+#include "tink/hybrid_encrypt.h"
+#include "tink/mac.h"
+#include "tink/public_key_sign.h"
+#include "tink/public_key_verify.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+///////////////////////////////////////////////////////////////////////////////
+// Measured cost of cryptographic operations on the current machine, for
+// capacity planning: schedulers can estimate how long a request takes before
+// running it, and route or throttle requests accordingly.
+//
+// The cost of an operation is modeled as a fixed cost per call plus a cost
+// per byte of payload, fitted to the mean time of the operation on a small
+// and on a large payload. The times are those of a single thread running
+// the operation back to back, so they approximate its CPU time; they include
+// the keyset wrapper if the primitive is a wrapped one.
+
+// The cost of one operation.
+struct OperationCost {
+  double nanos_per_call = 0;
+  double nanos_per_byte = 0;
+
+  // Returns the expected time of one operation on 'payload_size' bytes.
+  absl::Duration Estimate(int64_t payload_size) const;
+};
+
+// The costs of the operation producing an output (encrypt, compute a MAC,
+// sign) and of the one consuming it (decrypt, verify).
+struct PrimitiveCost {
+  OperationCost produce;
+  OperationCost consume;
+};
+
+struct CostCalibrationOptions {
+  // The payload sizes the costs are fitted to, with small_size < large_size.
+  int64_t small_size = 16;
+  int64_t large_size = 16 << 10;
+  // How long each operation runs on each size. Calibrating one primitive
+  // takes about 8 times as long.
+  absl::Duration min_time = absl::Milliseconds(20);
+};
+
+// Measures the costs of 'primitive'. The outputs of the produce operation
+// are consumed, so errors of either operation are returned.
+crypto::tink::util::StatusOr<PrimitiveCost> CalibrateCost(
+    const Aead& primitive,
+    const CostCalibrationOptions& options = CostCalibrationOptions());
+
+crypto::tink::util::StatusOr<PrimitiveCost> CalibrateCost(
+    const DeterministicAead& primitive,
+    const CostCalibrationOptions& options = CostCalibrationOptions());
+
+crypto::tink::util::StatusOr<PrimitiveCost> CalibrateCost(
+    const Mac& primitive,
+    const CostCalibrationOptions& options = CostCalibrationOptions());
+
+// 'verify' must hold the public keys of the keys of 'sign'.
+crypto::tink::util::StatusOr<PrimitiveCost> CalibrateCost(
+    const PublicKeySign& sign, const PublicKeyVerify& verify,
+    const CostCalibrationOptions& options = CostCalibrationOptions());
+
+// 'encrypt' must hold the public keys of the keys of 'decrypt'.
+crypto::tink::util::StatusOr<PrimitiveCost> CalibrateCost(
+    const HybridEncrypt& encrypt, const HybridDecrypt& decrypt,
+    const CostCalibrationOptions& options = CostCalibrationOptions());
+
+///////////////////////////////////////////////////////////////////////////////
+// The measured costs by key type, filled at startup or on demand by calling
+// Calibrate() with the key templates in use, and read by schedulers with
+// Get(). Thread safe; calibrating concurrently skews the measurements,
+// though.
+class CostCatalog {
+ public:
+  CostCatalog() = default;
+  CostCatalog(const CostCatalog&) = delete;
+  CostCatalog& operator=(const CostCatalog&) = delete;
+
+  // The catalog shared by the process.
+  static CostCatalog& Global();
+
+  // Generates a key from 'key_template', creates the primitive of its key
+  // type, which must be registered, measures its costs and records them for
+  // the type URL of the template, replacing earlier ones. Since parameters
+  // like the key size are not part of the key type, calibrate the template
+  // used for serving. Supports the key types of Aead, DeterministicAead,
+  // Mac, PublicKeySign and HybridDecrypt.
+  crypto::tink::util::StatusOr<PrimitiveCost> Calibrate(
+      const google::crypto::tink::KeyTemplate& key_template,
+      const CostCalibrationOptions& options = CostCalibrationOptions());
+
+  // Calibrates each of 'key_templates', stopping at the first error.
+  crypto::tink::util::Status CalibrateAll(
+      const std::vector<google::crypto::tink::KeyTemplate>& key_templates,
+      const CostCalibrationOptions& options = CostCalibrationOptions());
+
+  // Returns the costs recorded for 'type_url', or NOT_FOUND.
+  crypto::tink::util::StatusOr<PrimitiveCost> Get(
+      absl::string_view type_url) const;
+
+  // Returns all recorded costs, by type URL.
+  absl::flat_hash_map<std::string, PrimitiveCost> GetAll() const;
+
+ private:
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, PrimitiveCost> costs_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_COST_CALIBRATION_H_
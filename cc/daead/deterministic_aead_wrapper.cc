@@ -16,16 +16,33 @@
 
 #include "tink/daead/deterministic_aead_wrapper.h"
 
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/memory/memory.h"
+#include "absl/types/span.h"
 #include "tink/crypto_format.h"
 #include "tink/deterministic_aead.h"
+#include "tink/monitoring_client.h"
 #include "tink/primitive_set.h"
+#include "tink/raw_key_fallback_policy.h"
+#include "tink/subtle/subtle_util.h"
 #include "tink/subtle/subtle_util_boringssl.h"
+#include "tink/util/output_buffer_factory.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
 
 namespace crypto {
 namespace tink {
 
+using google::crypto::tink::OutputPrefixType;
+
 namespace {
 
 util::Status Validate(PrimitiveSet<DeterministicAead>* daead_set) {
@@ -41,9 +58,11 @@ util::Status Validate(PrimitiveSet<DeterministicAead>* daead_set) {
 
 class  DeterministicAeadSetWrapper : public DeterministicAead {
  public:
-  explicit DeterministicAeadSetWrapper(
-      std::unique_ptr<PrimitiveSet<DeterministicAead>> daead_set)
-      : daead_set_(std::move(daead_set)) {}
+  DeterministicAeadSetWrapper(
+      std::unique_ptr<PrimitiveSet<DeterministicAead>> daead_set,
+      const RawKeyFallbackPolicy& raw_key_fallback_policy)
+      : daead_set_(std::move(daead_set)),
+        raw_key_fallback_policy_(raw_key_fallback_policy) {}
 
   crypto::tink::util::StatusOr<std::string> EncryptDeterministically(
       absl::string_view plaintext,
@@ -53,10 +72,30 @@ class  DeterministicAeadSetWrapper : public DeterministicAead {
       absl::string_view ciphertext,
       absl::string_view associated_data) const override;
 
+  crypto::tink::util::StatusOr<absl::Span<char>>
+  EncryptDeterministicallyToBuffer(
+      absl::string_view plaintext, absl::string_view associated_data,
+      const crypto::tink::util::OutputBufferFactory& new_buffer)
+      const override;
+
+  crypto::tink::util::Status EncryptDeterministicallyBatch(
+      absl::Span<const absl::string_view> plaintexts,
+      absl::string_view associated_data, std::string* ciphertexts,
+      std::vector<int64_t>* offsets) const override;
+
+  crypto::tink::util::Status DecryptDeterministicallyBatch(
+      absl::Span<const absl::string_view> ciphertexts,
+      absl::string_view associated_data, std::string* plaintexts,
+      std::vector<int64_t>* offsets) const override;
+
+  crypto::tink::util::StatusOr<std::unique_ptr<PreparedDeterministicAead>>
+  PrepareAssociatedData(absl::string_view associated_data) const override;
+
   ~DeterministicAeadSetWrapper() override {}
 
  private:
   std::unique_ptr<PrimitiveSet<DeterministicAead>> daead_set_;
+  const RawKeyFallbackPolicy raw_key_fallback_policy_;
 };
 
 util::StatusOr<std::string>
@@ -66,34 +105,60 @@ DeterministicAeadSetWrapper::EncryptDeterministically(
   // regardless of whether the size is 0.
   plaintext = subtle::SubtleUtilBoringSSL::EnsureNonNull(plaintext);
   associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+  internal::MonitoredOperation monitored("daead", "encrypt", plaintext.size());
 
   auto encrypt_result =
       daead_set_->get_primary()->get_primitive().EncryptDeterministically(
           plaintext, associated_data);
   if (!encrypt_result.ok()) return encrypt_result.status();
+  monitored.Success(daead_set_->get_primary()->get_key_id());
   const std::string& key_id = daead_set_->get_primary()->get_identifier();
   return key_id + encrypt_result.ValueOrDie();
 }
 
+util::StatusOr<absl::Span<char>>
+DeterministicAeadSetWrapper::EncryptDeterministicallyToBuffer(
+    absl::string_view plaintext, absl::string_view associated_data,
+    const util::OutputBufferFactory& new_buffer) const {
+  plaintext = subtle::SubtleUtilBoringSSL::EnsureNonNull(plaintext);
+  associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+  internal::MonitoredOperation monitored("daead", "encrypt", plaintext.size());
+
+  auto primary = daead_set_->get_primary();
+  auto encrypt_result = util::internal::WriteToBufferWithPrefix(
+      primary->get_identifier(), new_buffer,
+      [&](const util::OutputBufferFactory& new_raw_buffer) {
+        return primary->get_primitive().EncryptDeterministicallyToBuffer(
+            plaintext, associated_data, new_raw_buffer);
+      });
+  if (!encrypt_result.ok()) return encrypt_result.status();
+  monitored.Success(primary->get_key_id());
+  return encrypt_result;
+}
+
 util::StatusOr<std::string>
 DeterministicAeadSetWrapper::DecryptDeterministically(
     absl::string_view ciphertext, absl::string_view associated_data) const {
   // BoringSSL expects a non-null pointer for plaintext and additional_data,
   // regardless of whether the size is 0.
   associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+  internal::MonitoredOperation monitored("daead", "decrypt", ciphertext.size());
 
+  bool prefix_matched = false;
   if (ciphertext.length() > CryptoFormat::kNonRawPrefixSize) {
     absl::string_view key_id =
         ciphertext.substr(0, CryptoFormat::kNonRawPrefixSize);
-    auto primitives_result = daead_set_->get_primitives(key_id);
-    if (primitives_result.ok()) {
+    const auto* primitives = daead_set_->find_primitives(key_id);
+    if (primitives != nullptr) {
+      prefix_matched = true;
       absl::string_view raw_ciphertext =
           ciphertext.substr(CryptoFormat::kNonRawPrefixSize);
-      for (auto& daead_entry : *(primitives_result.ValueOrDie())) {
+      for (auto& daead_entry : *primitives) {
         DeterministicAead& daead = daead_entry->get_primitive();
         auto decrypt_result =
             daead.DecryptDeterministically(raw_ciphertext, associated_data);
         if (decrypt_result.ok()) {
+          monitored.Success(daead_entry->get_key_id());
           return std::move(decrypt_result.ValueOrDie());
         } else {
           // LOG that a matching key didn't decrypt the ciphertext.
@@ -102,21 +167,330 @@ DeterministicAeadSetWrapper::DecryptDeterministically(
     }
   }
 
-  // No matching key succeeded with decryption, try all RAW keys.
-  auto raw_primitives_result = daead_set_->get_raw_primitives();
-  if (raw_primitives_result.ok()) {
-    for (auto& daead_entry : *(raw_primitives_result.ValueOrDie())) {
-      DeterministicAead& daead = daead_entry->get_primitive();
+  // No matching key succeeded with decryption, try the RAW keys.
+  const auto* raw_primitives = daead_set_->find_raw_primitives();
+  if (raw_primitives != nullptr) {
+    const PrimitiveSet<DeterministicAead>::Primitives& raw = *raw_primitives;
+    size_t max_attempts = internal::RawKeysToTry(raw_key_fallback_policy_,
+                                                 prefix_matched, raw.size());
+    size_t attempts = 0;
+    while (attempts < max_attempts) {
+      const auto& daead_entry = raw[attempts++];
       auto decrypt_result =
-          daead.DecryptDeterministically(ciphertext, associated_data);
+          daead_entry->get_primitive().DecryptDeterministically(
+              ciphertext, associated_data);
       if (decrypt_result.ok()) {
+        monitored.Success(daead_entry->get_key_id());
+        internal::RecordRawKeyFallback(raw_key_fallback_policy_, raw.size(),
+                                       attempts, /*success=*/true);
         return std::move(decrypt_result.ValueOrDie());
       }
     }
+    internal::RecordRawKeyFallback(raw_key_fallback_policy_, raw.size(),
+                                   attempts, /*success=*/false);
+  }
+  static const util::Status* kDecryptionFailed =
+      util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                              "decryption failed");
+  return *kDecryptionFailed;
+}
+
+util::Status DeterministicAeadSetWrapper::EncryptDeterministicallyBatch(
+    absl::Span<const absl::string_view> plaintexts,
+    absl::string_view associated_data, std::string* ciphertexts,
+    std::vector<int64_t>* offsets) const {
+  associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+
+  // Encrypt the whole batch with the primary, then prefix each record with
+  // the key id.
+  std::string raw_ciphertexts;
+  std::vector<int64_t> raw_offsets;
+  util::Status status =
+      daead_set_->get_primary()->get_primitive().EncryptDeterministicallyBatch(
+          plaintexts, associated_data, &raw_ciphertexts, &raw_offsets);
+  if (!status.ok()) return status;
+  const std::string& key_id = daead_set_->get_primary()->get_identifier();
+  subtle::ResizeStringUninitialized(
+      ciphertexts, raw_ciphertexts.size() + plaintexts.size() * key_id.size());
+  offsets->assign(1, 0);
+  offsets->reserve(plaintexts.size() + 1);
+  char* out = &(*ciphertexts)[0];
+  int64_t position = 0;
+  for (size_t i = 0; i < plaintexts.size(); i++) {
+    std::copy(key_id.begin(), key_id.end(), out + position);
+    position += key_id.size();
+    std::copy(raw_ciphertexts.begin() + raw_offsets[i],
+              raw_ciphertexts.begin() + raw_offsets[i + 1], out + position);
+    position += raw_offsets[i + 1] - raw_offsets[i];
+    offsets->push_back(position);
+  }
+  return util::Status::OK;
+}
+
+util::Status DeterministicAeadSetWrapper::DecryptDeterministicallyBatch(
+    absl::Span<const absl::string_view> ciphertexts,
+    absl::string_view associated_data, std::string* plaintexts,
+    std::vector<int64_t>* offsets) const {
+  associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+
+  // Group the ciphertexts by their key id, so that each key decrypts all of
+  // its ciphertexts with a single batch call. Groups which no key with a
+  // matching id decrypts as a whole, and ciphertexts too short to carry a
+  // key id, are decrypted one by one as in DecryptDeterministically().
+  absl::flat_hash_map<absl::string_view, std::vector<size_t>> by_key_id;
+  std::vector<size_t> one_by_one;
+  for (size_t i = 0; i < ciphertexts.size(); i++) {
+    if (ciphertexts[i].length() > CryptoFormat::kNonRawPrefixSize) {
+      by_key_id[ciphertexts[i].substr(0, CryptoFormat::kNonRawPrefixSize)]
+          .push_back(i);
+    } else {
+      one_by_one.push_back(i);
+    }
+  }
+
+  // Holds the decrypted groups; a deque, so that the views into earlier
+  // elements stay valid.
+  std::deque<std::string> storage;
+  std::vector<absl::string_view> results(ciphertexts.size());
+  for (const auto& key_id_and_indices : by_key_id) {
+    const std::vector<size_t>& indices = key_id_and_indices.second;
+    bool decrypted = false;
+    const auto* primitives =
+        daead_set_->find_primitives(key_id_and_indices.first);
+    if (primitives != nullptr) {
+      std::vector<absl::string_view> raw_ciphertexts;
+      raw_ciphertexts.reserve(indices.size());
+      for (size_t i : indices) {
+        raw_ciphertexts.push_back(
+            ciphertexts[i].substr(CryptoFormat::kNonRawPrefixSize));
+      }
+      for (auto& daead_entry : *primitives) {
+        std::string group_plaintexts;
+        std::vector<int64_t> group_offsets;
+        util::Status status =
+            daead_entry->get_primitive().DecryptDeterministicallyBatch(
+                raw_ciphertexts, associated_data, &group_plaintexts,
+                &group_offsets);
+        if (!status.ok()) continue;
+        storage.push_back(std::move(group_plaintexts));
+        const std::string& stored = storage.back();
+        for (size_t j = 0; j < indices.size(); j++) {
+          results[indices[j]] = absl::string_view(stored).substr(
+              group_offsets[j], group_offsets[j + 1] - group_offsets[j]);
+        }
+        decrypted = true;
+        break;
+      }
+    }
+    if (!decrypted) {
+      one_by_one.insert(one_by_one.end(), indices.begin(), indices.end());
+    }
+  }
+  for (size_t i : one_by_one) {
+    auto decrypt_result =
+        DecryptDeterministically(ciphertexts[i], associated_data);
+    if (!decrypt_result.ok()) return decrypt_result.status();
+    storage.push_back(std::move(decrypt_result.ValueOrDie()));
+    results[i] = storage.back();
   }
-  return util::Status(util::error::INVALID_ARGUMENT, "decryption failed");
+
+  int64_t total_size = 0;
+  for (absl::string_view result : results) total_size += result.size();
+  subtle::ResizeStringUninitialized(plaintexts, total_size);
+  offsets->assign(1, 0);
+  offsets->reserve(ciphertexts.size() + 1);
+  char* out = &(*plaintexts)[0];
+  int64_t position = 0;
+  for (absl::string_view result : results) {
+    std::copy(result.begin(), result.end(), out + position);
+    position += result.size();
+    offsets->push_back(position);
+  }
+  return util::Status::OK;
 }
 
+// The keyset counterpart of DeterministicAead::PrepareAssociatedData(): holds
+// the prepared primitives of all keys, grouped by their output prefix.
+class PreparedDeterministicAeadSetWrapper : public PreparedDeterministicAead {
+ public:
+  typedef absl::flat_hash_map<
+      std::string, std::vector<std::unique_ptr<PreparedDeterministicAead>>>
+      PreparedByPrefix;
+
+  PreparedDeterministicAeadSetWrapper(
+      std::string primary_prefix,
+      const PreparedDeterministicAead* primary,
+      PreparedByPrefix prepared_by_prefix,
+      const RawKeyFallbackPolicy& raw_key_fallback_policy)
+      : primary_prefix_(std::move(primary_prefix)),
+        primary_(primary),
+        prepared_by_prefix_(std::move(prepared_by_prefix)),
+        raw_key_fallback_policy_(raw_key_fallback_policy) {}
+
+  crypto::tink::util::StatusOr<std::string> EncryptDeterministically(
+      absl::string_view plaintext) const override {
+    plaintext = subtle::SubtleUtilBoringSSL::EnsureNonNull(plaintext);
+    auto encrypt_result = primary_->EncryptDeterministically(plaintext);
+    if (!encrypt_result.ok()) return encrypt_result.status();
+    return primary_prefix_ + encrypt_result.ValueOrDie();
+  }
+
+  crypto::tink::util::StatusOr<std::string> DecryptDeterministically(
+      absl::string_view ciphertext) const override {
+    bool prefix_matched = false;
+    if (ciphertext.length() > CryptoFormat::kNonRawPrefixSize) {
+      auto found = prepared_by_prefix_.find(
+          ciphertext.substr(0, CryptoFormat::kNonRawPrefixSize));
+      if (found != prepared_by_prefix_.end()) {
+        prefix_matched = true;
+        absl::string_view raw_ciphertext =
+            ciphertext.substr(CryptoFormat::kNonRawPrefixSize);
+        for (const auto& prepared : found->second) {
+          auto decrypt_result =
+              prepared->DecryptDeterministically(raw_ciphertext);
+          if (decrypt_result.ok()) {
+            return std::move(decrypt_result.ValueOrDie());
+          }
+        }
+      }
+    }
+
+    // No matching key succeeded with decryption, try the RAW keys.
+    auto found = prepared_by_prefix_.find(CryptoFormat::kRawPrefix);
+    if (found != prepared_by_prefix_.end()) {
+      const auto& raw = found->second;
+      size_t max_attempts = internal::RawKeysToTry(
+          raw_key_fallback_policy_, prefix_matched, raw.size());
+      size_t attempts = 0;
+      while (attempts < max_attempts) {
+        auto decrypt_result =
+            raw[attempts++]->DecryptDeterministically(ciphertext);
+        if (decrypt_result.ok()) {
+          internal::RecordRawKeyFallback(raw_key_fallback_policy_, raw.size(),
+                                         attempts, /*success=*/true);
+          return std::move(decrypt_result.ValueOrDie());
+        }
+      }
+      internal::RecordRawKeyFallback(raw_key_fallback_policy_, raw.size(),
+                                     attempts, /*success=*/false);
+    }
+    static const util::Status* kDecryptionFailed =
+        util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                                "decryption failed");
+    return *kDecryptionFailed;
+  }
+
+ private:
+  const std::string primary_prefix_;
+  // Points into prepared_by_prefix_.
+  const PreparedDeterministicAead* primary_;
+  const PreparedByPrefix prepared_by_prefix_;
+  const RawKeyFallbackPolicy raw_key_fallback_policy_;
+};
+
+util::StatusOr<std::unique_ptr<PreparedDeterministicAead>>
+DeterministicAeadSetWrapper::PrepareAssociatedData(
+    absl::string_view associated_data) const {
+  associated_data = subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+
+  PreparedDeterministicAeadSetWrapper::PreparedByPrefix prepared_by_prefix;
+  const PreparedDeterministicAead* primary = nullptr;
+  for (const auto* daead_entry : daead_set_->get_all()) {
+    auto prepare_result =
+        daead_entry->get_primitive().PrepareAssociatedData(associated_data);
+    if (!prepare_result.ok()) return prepare_result.status();
+    if (daead_entry == daead_set_->get_primary()) {
+      primary = prepare_result.ValueOrDie().get();
+    }
+    prepared_by_prefix[daead_entry->get_identifier()].push_back(
+        std::move(prepare_result.ValueOrDie()));
+  }
+  if (primary == nullptr) {
+    return util::Status(util::error::INTERNAL, "primary not in daead_set");
+  }
+  return {absl::make_unique<PreparedDeterministicAeadSetWrapper>(
+      daead_set_->get_primary()->get_identifier(), primary,
+      std::move(prepared_by_prefix), raw_key_fallback_policy_)};
+}
+
+// Wraps a set holding a single key with a non-RAW prefix, using the
+// primitive and key prefix directly instead of looking the entries up by
+// prefix.
+class SingleKeyDeterministicAeadWrapper : public DeterministicAeadSetWrapper {
+ public:
+  SingleKeyDeterministicAeadWrapper(
+      std::unique_ptr<PrimitiveSet<DeterministicAead>> daead_set,
+      const RawKeyFallbackPolicy& raw_key_fallback_policy,
+      const PrimitiveSet<DeterministicAead>::Entry<DeterministicAead>& entry)
+      : DeterministicAeadSetWrapper(std::move(daead_set),
+                                    raw_key_fallback_policy),
+        daead_(entry.get_primitive()),
+        prefix_(entry.get_identifier()),
+        key_id_(entry.get_key_id()) {}
+
+  crypto::tink::util::StatusOr<std::string> EncryptDeterministically(
+      absl::string_view plaintext,
+      absl::string_view associated_data) const override {
+    plaintext = subtle::SubtleUtilBoringSSL::EnsureNonNull(plaintext);
+    associated_data =
+        subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+    internal::MonitoredOperation monitored("daead", "encrypt",
+                                           plaintext.size());
+    auto encrypt_result =
+        daead_.EncryptDeterministically(plaintext, associated_data);
+    if (!encrypt_result.ok()) return encrypt_result.status();
+    monitored.Success(key_id_);
+    return prefix_ + encrypt_result.ValueOrDie();
+  }
+
+  crypto::tink::util::StatusOr<absl::Span<char>>
+  EncryptDeterministicallyToBuffer(
+      absl::string_view plaintext, absl::string_view associated_data,
+      const crypto::tink::util::OutputBufferFactory& new_buffer)
+      const override {
+    plaintext = subtle::SubtleUtilBoringSSL::EnsureNonNull(plaintext);
+    associated_data =
+        subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+    internal::MonitoredOperation monitored("daead", "encrypt",
+                                           plaintext.size());
+    auto encrypt_result = util::internal::WriteToBufferWithPrefix(
+        prefix_, new_buffer,
+        [&](const util::OutputBufferFactory& new_raw_buffer) {
+          return daead_.EncryptDeterministicallyToBuffer(
+              plaintext, associated_data, new_raw_buffer);
+        });
+    if (!encrypt_result.ok()) return encrypt_result.status();
+    monitored.Success(key_id_);
+    return encrypt_result;
+  }
+
+  crypto::tink::util::StatusOr<std::string> DecryptDeterministically(
+      absl::string_view ciphertext,
+      absl::string_view associated_data) const override {
+    associated_data =
+        subtle::SubtleUtilBoringSSL::EnsureNonNull(associated_data);
+    internal::MonitoredOperation monitored("daead", "decrypt",
+                                           ciphertext.size());
+    static const util::Status* kDecryptionFailed =
+        util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                                "decryption failed");
+    if (ciphertext.size() <= prefix_.size() ||
+        ciphertext.substr(0, prefix_.size()) != prefix_) {
+      return *kDecryptionFailed;
+    }
+    auto decrypt_result = daead_.DecryptDeterministically(
+        ciphertext.substr(prefix_.size()), associated_data);
+    if (!decrypt_result.ok()) return *kDecryptionFailed;
+    monitored.Success(key_id_);
+    return std::move(decrypt_result.ValueOrDie());
+  }
+
+ private:
+  const DeterministicAead& daead_;
+  const std::string& prefix_;
+  const uint32_t key_id_;
+};
+
 }  // anonymous namespace
 
 util::StatusOr<std::unique_ptr<DeterministicAead>>
@@ -124,8 +498,19 @@ DeterministicAeadWrapper::Wrap(
     std::unique_ptr<PrimitiveSet<DeterministicAead>> primitive_set) const {
   util::Status status = Validate(primitive_set.get());
   if (!status.ok()) return status;
+  const PrimitiveSet<DeterministicAead>::Entry<DeterministicAead>*
+      single_entry = primitive_set->get_single_entry();
+  if (single_entry != nullptr &&
+      single_entry->get_output_prefix_type() != OutputPrefixType::RAW) {
+    std::unique_ptr<DeterministicAead> daead(
+        new SingleKeyDeterministicAeadWrapper(
+            std::move(primitive_set), raw_key_fallback_policy_,
+            *single_entry));
+    return std::move(daead);
+  }
   std::unique_ptr<DeterministicAead> daead(
-      new DeterministicAeadSetWrapper(std::move(primitive_set)));
+      new DeterministicAeadSetWrapper(std::move(primitive_set),
+                                      raw_key_fallback_policy_));
   return std::move(daead);
 }
 
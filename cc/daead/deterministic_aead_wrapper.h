@@ -21,6 +21,7 @@
 #include "tink/deterministic_aead.h"
 #include "tink/primitive_set.h"
 #include "tink/primitive_wrapper.h"
+#include "tink/raw_key_fallback_policy.h"
 #include "tink/util/statusor.h"
 #include "proto/tink.pb.h"
 
@@ -33,15 +34,25 @@ namespace tink {
 //   * DeterministicAead::EncryptDeterministically(...) uses the primary
 //     instance from the set
 //   * DeterministicAead::DecryptDeterministically(...) uses the instance
-//     that matches the ciphertext prefix.
+//     that matches the ciphertext prefix. If none of them decrypts the
+//     ciphertext, the instances with RAW prefix are tried, as allowed by the
+//     RawKeyFallbackPolicy.
 class DeterministicAeadWrapper
     : public PrimitiveWrapper<DeterministicAead, DeterministicAead> {
  public:
+  DeterministicAeadWrapper() = default;
+  explicit DeterministicAeadWrapper(
+      const RawKeyFallbackPolicy& raw_key_fallback_policy)
+      : raw_key_fallback_policy_(raw_key_fallback_policy) {}
+
   // Returns a DeterministicAead-primitive that uses Daead-instances provided
   // in 'daead_set', which must be non-NULL and must contain a primary instance.
   crypto::tink::util::StatusOr<std::unique_ptr<DeterministicAead>> Wrap(
       std::unique_ptr<PrimitiveSet<DeterministicAead>> primitive_set)
       const override;
+
+ private:
+  RawKeyFallbackPolicy raw_key_fallback_policy_;
 };
 
 }  // namespace tink
@@ -16,10 +16,17 @@
 
 #include "tink/daead/deterministic_aead_wrapper.h"
 
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tink/deterministic_aead.h"
 #include "tink/primitive_set.h"
+#include "tink/raw_key_fallback_policy.h"
+#include "tink/util/output_buffer_factory.h"
 #include "tink/util/status.h"
 #include "tink/util/test_matchers.h"
 #include "tink/util/test_util.h"
@@ -134,6 +141,297 @@ TEST_F(DeterministicAeadSetWrapperTest, testBasic) {
   }
 }
 
+TEST_F(DeterministicAeadSetWrapperTest, testBatch) {
+  KeysetInfo keyset_info;
+  KeysetInfo::KeyInfo* key_info = keyset_info.add_key_info();
+  key_info->set_output_prefix_type(OutputPrefixType::TINK);
+  key_info->set_key_id(1234543);
+  key_info->set_status(KeyStatusType::ENABLED);
+  key_info = keyset_info.add_key_info();
+  key_info->set_output_prefix_type(OutputPrefixType::RAW);
+  key_info->set_key_id(726329);
+  key_info->set_status(KeyStatusType::ENABLED);
+
+  // The primary encrypts with a TINK prefix, the second key with none.
+  auto daead_set = absl::make_unique<PrimitiveSet<DeterministicAead>>();
+  auto entry_result = daead_set->AddPrimitive(
+      absl::make_unique<DummyDeterministicAead>("daead0"),
+      keyset_info.key_info(0));
+  ASSERT_TRUE(entry_result.ok());
+  ASSERT_THAT(daead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  ASSERT_TRUE(daead_set
+                  ->AddPrimitive(
+                      absl::make_unique<DummyDeterministicAead>("daead1"),
+                      keyset_info.key_info(1))
+                  .ok());
+  auto daead_result = DeterministicAeadWrapper().Wrap(std::move(daead_set));
+  ASSERT_TRUE(daead_result.ok()) << daead_result.status();
+  std::unique_ptr<DeterministicAead> daead =
+      std::move(daead_result.ValueOrDie());
+
+  std::string aad = "some_aad";
+  std::vector<absl::string_view> plaintexts = {"first", "", "third"};
+  std::string ciphertexts;
+  std::vector<int64_t> offsets;
+  ASSERT_THAT(daead->EncryptDeterministicallyBatch(plaintexts, aad,
+                                                   &ciphertexts, &offsets),
+              IsOk());
+  ASSERT_EQ(offsets.size(), plaintexts.size() + 1);
+  std::vector<absl::string_view> ciphertext_views;
+  for (size_t i = 0; i < plaintexts.size(); i++) {
+    ciphertext_views.push_back(absl::string_view(ciphertexts).substr(
+        offsets[i], offsets[i + 1] - offsets[i]));
+    auto encrypt_result = daead->EncryptDeterministically(plaintexts[i], aad);
+    ASSERT_TRUE(encrypt_result.ok()) << encrypt_result.status();
+    EXPECT_EQ(ciphertext_views[i], encrypt_result.ValueOrDie());
+  }
+
+  // Mix in a ciphertext of the RAW key, which carries no key id.
+  std::string raw_ciphertext =
+      DummyDeterministicAead("daead1")
+          .EncryptDeterministically("fourth", aad)
+          .ValueOrDie();
+  ciphertext_views.push_back(raw_ciphertext);
+  plaintexts.push_back("fourth");
+
+  std::string decrypted;
+  ASSERT_THAT(daead->DecryptDeterministicallyBatch(ciphertext_views, aad,
+                                                   &decrypted, &offsets),
+              IsOk());
+  ASSERT_EQ(offsets.size(), plaintexts.size() + 1);
+  for (size_t i = 0; i < plaintexts.size(); i++) {
+    EXPECT_EQ(absl::string_view(decrypted).substr(
+                  offsets[i], offsets[i + 1] - offsets[i]),
+              plaintexts[i]);
+  }
+
+  // A single bad ciphertext fails the whole batch.
+  ciphertext_views[1] = "some bad ciphertext";
+  EXPECT_FALSE(daead->DecryptDeterministicallyBatch(ciphertext_views, aad,
+                                                    &decrypted, &offsets)
+                   .ok());
+}
+
+TEST_F(DeterministicAeadSetWrapperTest, testPrepareAssociatedData) {
+  KeysetInfo keyset_info;
+  KeysetInfo::KeyInfo* key_info = keyset_info.add_key_info();
+  key_info->set_output_prefix_type(OutputPrefixType::TINK);
+  key_info->set_key_id(1234543);
+  key_info->set_status(KeyStatusType::ENABLED);
+  key_info = keyset_info.add_key_info();
+  key_info->set_output_prefix_type(OutputPrefixType::RAW);
+  key_info->set_key_id(726329);
+  key_info->set_status(KeyStatusType::ENABLED);
+
+  auto daead_set = absl::make_unique<PrimitiveSet<DeterministicAead>>();
+  auto entry_result = daead_set->AddPrimitive(
+      absl::make_unique<DummyDeterministicAead>("daead0"),
+      keyset_info.key_info(0));
+  ASSERT_TRUE(entry_result.ok());
+  ASSERT_THAT(daead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  ASSERT_TRUE(daead_set
+                  ->AddPrimitive(
+                      absl::make_unique<DummyDeterministicAead>("daead1"),
+                      keyset_info.key_info(1))
+                  .ok());
+  auto daead_result = DeterministicAeadWrapper().Wrap(std::move(daead_set));
+  ASSERT_TRUE(daead_result.ok()) << daead_result.status();
+  std::unique_ptr<DeterministicAead> daead =
+      std::move(daead_result.ValueOrDie());
+
+  std::string aad = "some_aad";
+  auto prepared_result = daead->PrepareAssociatedData(aad);
+  ASSERT_TRUE(prepared_result.ok()) << prepared_result.status();
+  std::unique_ptr<PreparedDeterministicAead> prepared =
+      std::move(prepared_result.ValueOrDie());
+
+  auto encrypt_result = prepared->EncryptDeterministically("some_plaintext");
+  ASSERT_TRUE(encrypt_result.ok()) << encrypt_result.status();
+  auto expected_result = daead->EncryptDeterministically("some_plaintext", aad);
+  ASSERT_TRUE(expected_result.ok()) << expected_result.status();
+  EXPECT_EQ(encrypt_result.ValueOrDie(), expected_result.ValueOrDie());
+
+  auto decrypt_result =
+      prepared->DecryptDeterministically(encrypt_result.ValueOrDie());
+  ASSERT_TRUE(decrypt_result.ok()) << decrypt_result.status();
+  EXPECT_EQ(decrypt_result.ValueOrDie(), "some_plaintext");
+
+  // Ciphertexts of the RAW key carry no key id.
+  std::string raw_ciphertext =
+      DummyDeterministicAead("daead1")
+          .EncryptDeterministically("raw_plaintext", aad)
+          .ValueOrDie();
+  decrypt_result = prepared->DecryptDeterministically(raw_ciphertext);
+  ASSERT_TRUE(decrypt_result.ok()) << decrypt_result.status();
+  EXPECT_EQ(decrypt_result.ValueOrDie(), "raw_plaintext");
+
+  // The associated data is bound to the prepared object.
+  auto other_result = daead->EncryptDeterministically("some_plaintext", "x");
+  ASSERT_TRUE(other_result.ok()) << other_result.status();
+  EXPECT_FALSE(
+      prepared->DecryptDeterministically(other_result.ValueOrDie()).ok());
+  EXPECT_FALSE(prepared->DecryptDeterministically("bad").ok());
+}
+
+TEST_F(DeterministicAeadSetWrapperTest, testRawKeyFallbackPolicy) {
+  std::string aad = "some_aad";
+  std::string raw2_ciphertext = DummyDeterministicAead("raw2")
+                                    .EncryptDeterministically("plaintext", aad)
+                                    .ValueOrDie();
+  const char* const kNames[] = {"tink", "raw1", "raw2"};
+  auto new_wrapped_daead = [&kNames](const RawKeyFallbackPolicy& policy)
+      -> std::unique_ptr<DeterministicAead> {
+    std::unique_ptr<PrimitiveSet<DeterministicAead>> daead_set(
+        new PrimitiveSet<DeterministicAead>());
+    for (int i = 0; i < 3; i++) {
+      KeysetInfo::KeyInfo key_info;
+      key_info.set_output_prefix_type(i == 0 ? OutputPrefixType::TINK
+                                             : OutputPrefixType::RAW);
+      key_info.set_key_id(1000 + i);
+      key_info.set_status(KeyStatusType::ENABLED);
+      auto entry = daead_set->AddPrimitive(
+          absl::make_unique<DummyDeterministicAead>(kNames[i]), key_info);
+      EXPECT_THAT(entry.status(), IsOk());
+      if (i == 0) {
+        EXPECT_THAT(daead_set->set_primary(entry.ValueOrDie()), IsOk());
+      }
+    }
+    return std::move(DeterministicAeadWrapper(policy)
+                         .Wrap(std::move(daead_set))
+                         .ValueOrDie());
+  };
+
+  RawKeyFallbackCounters counters;
+  RawKeyFallbackPolicy policy;
+  policy.counters = &counters;
+  std::unique_ptr<DeterministicAead> daead = new_wrapped_daead(policy);
+  std::string ciphertext =
+      daead->EncryptDeterministically("plaintext", aad).ValueOrDie();
+  EXPECT_THAT(daead->DecryptDeterministically(ciphertext, aad).status(),
+              IsOk());
+  EXPECT_THAT(daead->DecryptDeterministically(raw2_ciphertext, aad).status(),
+              IsOk());
+  EXPECT_EQ(counters.fallbacks, 1);
+  EXPECT_EQ(counters.raw_attempts, 2);
+  EXPECT_EQ(counters.raw_successes, 1);
+  EXPECT_EQ(counters.skipped, 0);
+
+  RawKeyFallbackCounters limited_counters;
+  policy.max_raw_attempts = 1;
+  policy.counters = &limited_counters;
+  daead = new_wrapped_daead(policy);
+  EXPECT_FALSE(daead->DecryptDeterministically(raw2_ciphertext, aad).ok());
+  EXPECT_EQ(limited_counters.raw_attempts, 1);
+  EXPECT_EQ(limited_counters.skipped, 1);
+
+  RawKeyFallbackCounters skip_counters;
+  policy.max_raw_attempts = -1;
+  policy.skip_if_prefix_matched = true;
+  policy.counters = &skip_counters;
+  daead = new_wrapped_daead(policy);
+  EXPECT_FALSE(daead->DecryptDeterministically(ciphertext, "other aad").ok());
+  EXPECT_THAT(daead->DecryptDeterministically(raw2_ciphertext, aad).status(),
+              IsOk());
+  EXPECT_EQ(skip_counters.fallbacks, 1);
+  EXPECT_EQ(skip_counters.raw_successes, 1);
+  EXPECT_EQ(skip_counters.skipped, 1);
+}
+
+std::unique_ptr<DeterministicAead> WrapSingleDummyDeterministicAead(
+    const KeysetInfo::KeyInfo& key_info, bool freeze) {
+  std::unique_ptr<PrimitiveSet<DeterministicAead>> daead_set(
+      new PrimitiveSet<DeterministicAead>());
+  auto entry_result = daead_set->AddPrimitive(
+      absl::make_unique<DummyDeterministicAead>("single_daead"), key_info);
+  EXPECT_THAT(entry_result.status(), IsOk());
+  EXPECT_THAT(daead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  if (freeze) daead_set->Freeze();
+  return std::move(
+      DeterministicAeadWrapper().Wrap(std::move(daead_set)).ValueOrDie());
+}
+
+TEST_F(DeterministicAeadSetWrapperTest, testSingleKeyMatchesGeneralWrapper) {
+  for (OutputPrefixType prefix_type :
+       {OutputPrefixType::TINK, OutputPrefixType::LEGACY,
+        OutputPrefixType::CRUNCHY, OutputPrefixType::RAW}) {
+    SCOPED_TRACE(prefix_type);
+    KeysetInfo::KeyInfo key_info;
+    key_info.set_output_prefix_type(prefix_type);
+    key_info.set_key_id(1234543);
+    key_info.set_status(KeyStatusType::ENABLED);
+    // Only the frozen set takes the single-key fast path.
+    std::unique_ptr<DeterministicAead> single =
+        WrapSingleDummyDeterministicAead(key_info, true);
+    std::unique_ptr<DeterministicAead> general =
+        WrapSingleDummyDeterministicAead(key_info, false);
+    std::string plaintext = "some_plaintext";
+    std::string aad = "some_aad";
+
+    auto ciphertext = single->EncryptDeterministically(plaintext, aad);
+    ASSERT_THAT(ciphertext.status(), IsOk());
+    EXPECT_EQ(ciphertext.ValueOrDie(),
+              general->EncryptDeterministically(plaintext, aad).ValueOrDie());
+    auto decrypted =
+        single->DecryptDeterministically(ciphertext.ValueOrDie(), aad);
+    ASSERT_THAT(decrypted.status(), IsOk());
+    EXPECT_EQ(decrypted.ValueOrDie(), plaintext);
+
+    std::string other_prefix = ciphertext.ValueOrDie();
+    other_prefix[1] ^= 1;
+    for (const std::string& bad_ciphertext :
+         {other_prefix, std::string(ciphertext.ValueOrDie(), 0, 3)}) {
+      EXPECT_EQ(single->DecryptDeterministically(bad_ciphertext, aad).ok(),
+                general->DecryptDeterministically(bad_ciphertext, aad).ok());
+    }
+  }
+}
+
+TEST_F(DeterministicAeadSetWrapperTest, testToBuffer) {
+  for (OutputPrefixType prefix_type :
+       {OutputPrefixType::TINK, OutputPrefixType::RAW}) {
+    for (bool single_key : {true, false}) {
+      SCOPED_TRACE(prefix_type);
+      SCOPED_TRACE(single_key);
+      KeysetInfo::KeyInfo key_info;
+      key_info.set_output_prefix_type(prefix_type);
+      key_info.set_key_id(1234543);
+      key_info.set_status(KeyStatusType::ENABLED);
+      std::unique_ptr<DeterministicAead> daead =
+          WrapSingleDummyDeterministicAead(key_info, single_key);
+      std::string plaintext = "some_plaintext";
+      std::string aad = "some_aad";
+
+      // Takes all buffers from a single arena.
+      std::string arena(512, '\0');
+      size_t used = 0;
+      util::OutputBufferFactory new_buffer = [&arena, &used](int64_t size) {
+        absl::Span<char> buffer(&arena[used], size);
+        used += size;
+        return buffer;
+      };
+      auto ciphertext_result = daead->EncryptDeterministicallyToBuffer(
+          plaintext, aad, new_buffer);
+      ASSERT_THAT(ciphertext_result.status(), IsOk());
+      absl::string_view ciphertext(ciphertext_result.ValueOrDie().data(),
+                                   ciphertext_result.ValueOrDie().size());
+      EXPECT_EQ(arena.data(), ciphertext.data());
+      EXPECT_EQ(daead->EncryptDeterministically(plaintext, aad).ValueOrDie(),
+                ciphertext);
+
+      auto plaintext_result =
+          daead->DecryptDeterministicallyToBuffer(ciphertext, aad, new_buffer);
+      ASSERT_THAT(plaintext_result.status(), IsOk());
+      EXPECT_EQ(plaintext,
+                absl::string_view(plaintext_result.ValueOrDie().data(),
+                                  plaintext_result.ValueOrDie().size()));
+      EXPECT_FALSE(
+          daead->DecryptDeterministicallyToBuffer(ciphertext, "other_aad",
+                                                  new_buffer)
+              .ok());
+    }
+  }
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
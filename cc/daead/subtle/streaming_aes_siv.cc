@@ -0,0 +1,289 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/daead/subtle/streaming_aes_siv.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "openssl/aes.h"
+#include "openssl/cipher.h"
+#include "openssl/cmac.h"
+#include "openssl/mem.h"
+#include "tink/util/buffer.h"
+#include "tink/util/errors.h"
+#include "tink/util/executor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+namespace {
+
+constexpr int kBlockSize = 16;
+constexpr size_t kKeySize = 64;
+
+// Multiplies a block by x in GF(2^128), see RFC 5297.
+void MultiplyByX(uint8_t block[kBlockSize]) {
+  uint8_t carry = 0x87 & -(block[0] >> 7);
+  for (int i = 0; i < kBlockSize - 1; ++i) {
+    block[i] = (block[i] << 1) | (block[i + 1] >> 7);
+  }
+  block[kBlockSize - 1] = (block[kBlockSize - 1] << 1) ^ carry;
+}
+
+util::StatusOr<bssl::UniquePtr<CMAC_CTX>> NewCmac(const util::SecretData& key) {
+  bssl::UniquePtr<CMAC_CTX> ctx(CMAC_CTX_new());
+  if (ctx == nullptr || CMAC_Init(ctx.get(), key.data(), key.size(),
+                                  EVP_aes_256_cbc(), nullptr) != 1) {
+    return util::Status(util::error::INTERNAL, "could not initialize CMAC");
+  }
+  return std::move(ctx);
+}
+
+util::Status FinishCmac(CMAC_CTX* ctx, uint8_t mac[kBlockSize]) {
+  size_t mac_size;
+  if (CMAC_Final(ctx, mac, &mac_size) != 1 || mac_size != kBlockSize) {
+    return util::Status(util::error::INTERNAL, "CMAC failed");
+  }
+  return util::OkStatus();
+}
+
+util::Status Cmac(const util::SecretData& key, absl::string_view data,
+                  uint8_t mac[kBlockSize]) {
+  auto ctx = NewCmac(key);
+  if (!ctx.ok()) return ctx.status();
+  if (CMAC_Update(ctx.ValueOrDie().get(), data.data(), data.size()) != 1) {
+    return util::Status(util::error::INTERNAL, "CMAC failed");
+  }
+  return FinishCmac(ctx.ValueOrDie().get(), mac);
+}
+
+util::Status ReadFully(RandomAccessStream* source, int64_t position,
+                       int count, uint8_t* dest) {
+  int read_count = 0;
+  while (read_count < count) {
+    auto buffer_result = util::Buffer::NewNonOwning(
+        reinterpret_cast<char*>(dest) + read_count, count - read_count);
+    if (!buffer_result.ok()) return buffer_result.status();
+    auto buffer = std::move(buffer_result.ValueOrDie());
+    auto status = source->PRead(position + read_count, count - read_count,
+                                buffer.get());
+    read_count += buffer->size();
+    if (status.error_code() == util::error::OUT_OF_RANGE) {
+      if (read_count < count) {
+        return util::Status(util::error::INVALID_ARGUMENT,
+                            "stream is shorter than its size");
+      }
+    } else if (!status.ok()) {
+      return status;
+    }
+  }
+  return util::OkStatus();
+}
+
+util::Status WriteFully(OutputStream* dest, const uint8_t* data, int64_t size) {
+  while (size > 0) {
+    void* buffer;
+    auto next_result = dest->Next(&buffer);
+    if (!next_result.ok()) return next_result.status();
+    int available = next_result.ValueOrDie();
+    int count = static_cast<int>(std::min<int64_t>(available, size));
+    std::memcpy(buffer, data, count);
+    if (count < available) dest->BackUp(available - count);
+    data += count;
+    size -= count;
+  }
+  return util::OkStatus();
+}
+
+}  // namespace
+
+// static
+util::StatusOr<std::unique_ptr<StreamingAesSiv>> StreamingAesSiv::New(
+    const util::SecretData& key) {
+  auto status = CheckFipsCompatibility<StreamingAesSiv>();
+  if (!status.ok()) return status;
+  if (key.size() != kKeySize) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid key size");
+  }
+  util::SecretData k1(key.begin(), key.begin() + kKeySize / 2);
+  util::SecretUniquePtr<AES_KEY> k2 = util::MakeSecretUniquePtr<AES_KEY>();
+  if (AES_set_encrypt_key(key.data() + kKeySize / 2, 8 * kKeySize / 2,
+                          k2.get()) != 0) {
+    return util::Status(util::error::INTERNAL, "could not initialize aes key");
+  }
+  return {absl::WrapUnique(new StreamingAesSiv(std::move(k1), std::move(k2)))};
+}
+
+util::Status StreamingAesSiv::S2v(absl::string_view associated_data,
+                                  int64_t size, const PlaintextReader& reader,
+                                  uint8_t siv[kBlockSize]) const {
+  // D = dbl(CMAC(0)) xor CMAC(associated_data).
+  uint8_t d[kBlockSize] = {0};
+  auto status = Cmac(k1_, absl::string_view(reinterpret_cast<char*>(d),
+                                            kBlockSize), d);
+  if (!status.ok()) return status;
+  MultiplyByX(d);
+  uint8_t aad_mac[kBlockSize];
+  status = Cmac(k1_, associated_data, aad_mac);
+  if (!status.ok()) return status;
+  for (int i = 0; i < kBlockSize; i++) d[i] ^= aad_mac[i];
+
+  if (size < kBlockSize) {
+    // T = dbl(D) xor pad(plaintext).
+    uint8_t plaintext[kBlockSize];
+    status = reader(0, size, plaintext);
+    if (!status.ok()) return status;
+    MultiplyByX(d);
+    for (int i = 0; i < size; i++) d[i] ^= plaintext[i];
+    d[size] ^= 0x80;
+    OPENSSL_cleanse(plaintext, sizeof(plaintext));
+    return Cmac(k1_, absl::string_view(reinterpret_cast<char*>(d), kBlockSize),
+                siv);
+  }
+
+  // T = plaintext xorend D.
+  auto ctx = NewCmac(k1_);
+  if (!ctx.ok()) return ctx.status();
+  util::SecretData chunk(std::min<int64_t>(size, kChunkSize));
+  const int64_t xorend_start = size - kBlockSize;
+  for (int64_t position = 0; position < size; position += chunk.size()) {
+    int count = static_cast<int>(std::min<int64_t>(chunk.size(),
+                                                   size - position));
+    status = reader(position, count, chunk.data());
+    if (!status.ok()) return status;
+    for (int64_t i = std::max(position, xorend_start); i < position + count;
+         i++) {
+      chunk[i - position] ^= d[i - xorend_start];
+    }
+    if (CMAC_Update(ctx.ValueOrDie().get(), chunk.data(), count) != 1) {
+      return util::Status(util::error::INTERNAL, "CMAC failed");
+    }
+  }
+  return FinishCmac(ctx.ValueOrDie().get(), siv);
+}
+
+void StreamingAesSiv::CtrCrypt(const uint8_t siv[kBlockSize],
+                               int64_t block_offset, uint8_t* data,
+                               size_t size) const {
+  // The initial counter is the SIV with two bits cleared, see RFC 5297,
+  // advanced by 'block_offset' as a 128-bit big endian integer.
+  uint8_t iv[kBlockSize];
+  std::copy_n(siv, kBlockSize, iv);
+  iv[8] &= 0x7f;
+  iv[12] &= 0x7f;
+  uint64_t carry = static_cast<uint64_t>(block_offset);
+  for (int i = kBlockSize - 1; i >= 0 && carry != 0; i--) {
+    carry += iv[i];
+    iv[i] = static_cast<uint8_t>(carry);
+    carry >>= 8;
+  }
+  unsigned int num = 0;
+  uint8_t ecount_buf[kBlockSize] = {0};
+  AES_ctr128_encrypt(data, data, size, k2_.get(), iv, ecount_buf, &num);
+}
+
+util::Status StreamingAesSiv::CtrPass(RandomAccessStream* source,
+                                      int64_t source_offset, int64_t size,
+                                      const uint8_t siv[kBlockSize],
+                                      OutputStream* dest,
+                                      int num_threads) const {
+  const int64_t num_chunks = (size + kChunkSize - 1) / kChunkSize;
+  std::vector<util::SecretData> chunks(
+      std::max<int64_t>(1, std::min<int64_t>(num_threads, num_chunks)));
+  for (int64_t first = 0; first < num_chunks; first += chunks.size()) {
+    int batch = static_cast<int>(
+        std::min<int64_t>(chunks.size(), num_chunks - first));
+    for (int i = 0; i < batch; i++) {
+      int64_t position = (first + i) * kChunkSize;
+      chunks[i].resize(std::min<int64_t>(kChunkSize, size - position));
+      auto status = ReadFully(source, source_offset + position,
+                              chunks[i].size(), chunks[i].data());
+      if (!status.ok()) return status;
+    }
+    util::ParallelFor(batch, batch, [this, siv, first, &chunks](int64_t i) {
+      CtrCrypt(siv, (first + i) * (kChunkSize / kBlockSize), chunks[i].data(),
+               chunks[i].size());
+    });
+    for (int i = 0; i < batch; i++) {
+      auto status = WriteFully(dest, chunks[i].data(), chunks[i].size());
+      if (!status.ok()) return status;
+    }
+  }
+  return util::OkStatus();
+}
+
+util::Status StreamingAesSiv::Encrypt(RandomAccessStream* plaintext,
+                                      absl::string_view associated_data,
+                                      OutputStream* ciphertext,
+                                      int num_threads) const {
+  auto size_result = plaintext->size();
+  if (!size_result.ok()) return size_result.status();
+  const int64_t size = size_result.ValueOrDie();
+  uint8_t siv[kBlockSize];
+  auto status = S2v(associated_data, size,
+                    [plaintext](int64_t position, int count, uint8_t* dest) {
+                      return ReadFully(plaintext, position, count, dest);
+                    },
+                    siv);
+  if (!status.ok()) return status;
+  status = WriteFully(ciphertext, siv, kBlockSize);
+  if (!status.ok()) return status;
+  return CtrPass(plaintext, 0, size, siv, ciphertext, num_threads);
+}
+
+util::Status StreamingAesSiv::Decrypt(RandomAccessStream* ciphertext,
+                                      absl::string_view associated_data,
+                                      OutputStream* plaintext,
+                                      int num_threads) const {
+  auto size_result = ciphertext->size();
+  if (!size_result.ok()) return size_result.status();
+  if (size_result.ValueOrDie() < kBlockSize) {
+    return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too short");
+  }
+  const int64_t size = size_result.ValueOrDie() - kBlockSize;
+  uint8_t siv[kBlockSize];
+  auto status = ReadFully(ciphertext, 0, kBlockSize, siv);
+  if (!status.ok()) return status;
+
+  // The plaintext chunks the reader returns start at multiples of
+  // kChunkSize, and hence at block boundaries.
+  uint8_t s2v[kBlockSize];
+  status = S2v(associated_data, size,
+               [this, ciphertext, &siv](int64_t position, int count,
+                                        uint8_t* dest) {
+                 auto status =
+                     ReadFully(ciphertext, kBlockSize + position, count, dest);
+                 if (!status.ok()) return status;
+                 CtrCrypt(siv, position / kBlockSize, dest, count);
+                 return util::OkStatus();
+               },
+               s2v);
+  if (!status.ok()) return status;
+  if (CRYPTO_memcmp(siv, s2v, kBlockSize) != 0) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid ciphertext");
+  }
+  return CtrPass(ciphertext, kBlockSize, size, siv, plaintext, num_threads);
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,112 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_DAEAD_SUBTLE_STREAMING_AES_SIV_H_
+#define TINK_DAEAD_SUBTLE_STREAMING_AES_SIV_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "openssl/aes.h"
+#include "tink/config/tink_fips.h"
+#include "tink/output_stream.h"
+#include "tink/random_access_stream.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// AES-SIV (RFC 5297) for values too large to be kept in memory, with the
+// same keys and ciphertexts as AesSivBoringSsl: the SIV, followed by the CTR
+// encryption of the plaintext.
+//
+// Since the SIV depends on the whole plaintext, the input is read twice.
+// Encryption computes the SIV in a first pass over the plaintext, and then
+// encrypts it in a second pass. Decryption decrypts the ciphertext and
+// verifies the SIV in a first pass, and decrypts it again to write the
+// plaintext in a second pass, so that no unverified plaintext is written.
+// The second passes can use several threads. Only chunks of kChunkSize
+// bytes per thread are kept in memory.
+//
+// Thread safety: This class is thread safe.
+class StreamingAesSiv {
+ public:
+  static crypto::tink::util::StatusOr<std::unique_ptr<StreamingAesSiv>> New(
+      const util::SecretData& key);
+
+  // Writes the encryption of 'plaintext' to 'ciphertext', which is not
+  // closed. The size of 'plaintext' must be available.
+  crypto::tink::util::Status Encrypt(RandomAccessStream* plaintext,
+                                     absl::string_view associated_data,
+                                     OutputStream* ciphertext,
+                                     int num_threads = 1) const;
+
+  // Writes the decryption of 'ciphertext' to 'plaintext', which is not
+  // closed. Nothing is written if the ciphertext is invalid.
+  crypto::tink::util::Status Decrypt(RandomAccessStream* ciphertext,
+                                     absl::string_view associated_data,
+                                     OutputStream* plaintext,
+                                     int num_threads = 1) const;
+
+  static constexpr crypto::tink::FipsCompatibility kFipsStatus =
+      crypto::tink::FipsCompatibility::kNotFips;
+
+  // The number of bytes each thread processes at once.
+  static constexpr int kChunkSize = 1 << 20;
+
+ private:
+  static constexpr int kBlockSize = 16;
+
+  // Reads 'count' bytes at 'position' of the plaintext into 'dest'.
+  using PlaintextReader = std::function<crypto::tink::util::Status(
+      int64_t position, int count, uint8_t* dest)>;
+
+  StreamingAesSiv(util::SecretData k1, util::SecretUniquePtr<AES_KEY> k2)
+      : k1_(std::move(k1)), k2_(std::move(k2)) {}
+
+  // Computes the SIV of the 'size' bytes of plaintext given by 'reader'.
+  crypto::tink::util::Status S2v(absl::string_view associated_data,
+                                 int64_t size, const PlaintextReader& reader,
+                                 uint8_t siv[kBlockSize]) const;
+
+  // Encrypts or decrypts 'size' bytes at 'data' in place, which start at
+  // block 'block_offset' of the key stream for 'siv'.
+  void CtrCrypt(const uint8_t siv[kBlockSize], int64_t block_offset,
+                uint8_t* data, size_t size) const;
+
+  // Encrypts or decrypts the 'size' bytes of 'source' at 'source_offset' and
+  // writes them to 'dest', on up to 'num_threads' threads.
+  crypto::tink::util::Status CtrPass(RandomAccessStream* source,
+                                     int64_t source_offset, int64_t size,
+                                     const uint8_t siv[kBlockSize],
+                                     OutputStream* dest,
+                                     int num_threads) const;
+
+  const util::SecretData k1_;
+  const util::SecretUniquePtr<AES_KEY> k2_;
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_DAEAD_SUBTLE_STREAMING_AES_SIV_H_
@@ -0,0 +1,180 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/daead/subtle/streaming_aes_siv.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tink/config/tink_fips.h"
+#include "tink/output_stream.h"
+#include "tink/random_access_stream.h"
+#include "tink/subtle/aes_siv_boringssl.h"
+#include "tink/subtle/random.h"
+#include "tink/util/file_random_access_stream.h"
+#include "tink/util/ostream_output_stream.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+using ::crypto::tink::test::GetTestFileDescriptor;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+// Creates a RandomAccessStream with the specified contents.
+std::unique_ptr<RandomAccessStream> GetRandomAccessStream(
+    absl::string_view contents) {
+  static int index = 1;
+  std::string filename = absl::StrCat("streaming_aes_siv_", index, ".txt");
+  index++;
+  int input_fd = GetTestFileDescriptor(filename, contents);
+  return {absl::make_unique<util::FileRandomAccessStream>(input_fd)};
+}
+
+// Runs 'crypt' from a stream with 'input' and returns its output.
+template <typename Crypt>
+util::StatusOr<std::string> RunOnStream(absl::string_view input,
+                                        Crypt crypt) {
+  auto output_stream = absl::make_unique<std::stringstream>();
+  auto output_buf = output_stream->rdbuf();
+  util::OstreamOutputStream output(std::move(output_stream));
+  auto status = crypt(GetRandomAccessStream(input).get(), &output);
+  if (!status.ok()) return status;
+  status = output.Close();
+  if (!status.ok()) return status;
+  return output_buf->str();
+}
+
+class StreamingAesSivThreadsTest : public ::testing::TestWithParam<int> {
+ protected:
+  void SetUp() override {
+    if (kUseOnlyFips) {
+      GTEST_SKIP() << "Not supported in FIPS-only mode";
+    }
+  }
+};
+
+TEST_P(StreamingAesSivThreadsTest, MatchesAesSivBoringSsl) {
+  util::SecretData key = Random::GetRandomKeyBytes(64);
+  auto streaming = StreamingAesSiv::New(key);
+  ASSERT_THAT(streaming.status(), IsOk());
+  auto daead = AesSivBoringSsl::New(key);
+  ASSERT_THAT(daead.status(), IsOk());
+  const int num_threads = GetParam();
+  const std::string aad = "some associated data";
+
+  for (int size : {0, 1, 15, 16, 17, 1000, StreamingAesSiv::kChunkSize - 1,
+                   StreamingAesSiv::kChunkSize + 17,
+                   3 * StreamingAesSiv::kChunkSize}) {
+    SCOPED_TRACE(size);
+    std::string plaintext = Random::GetRandomBytes(size);
+    auto ciphertext = RunOnStream(
+        plaintext, [&](RandomAccessStream* in, OutputStream* out) {
+          return streaming.ValueOrDie()->Encrypt(in, aad, out, num_threads);
+        });
+    ASSERT_THAT(ciphertext.status(), IsOk());
+    auto expected =
+        daead.ValueOrDie()->EncryptDeterministically(plaintext, aad);
+    ASSERT_THAT(expected.status(), IsOk());
+    EXPECT_EQ(ciphertext.ValueOrDie(), expected.ValueOrDie());
+
+    auto decrypted = RunOnStream(
+        ciphertext.ValueOrDie(),
+        [&](RandomAccessStream* in, OutputStream* out) {
+          return streaming.ValueOrDie()->Decrypt(in, aad, out, num_threads);
+        });
+    ASSERT_THAT(decrypted.status(), IsOk());
+    EXPECT_EQ(decrypted.ValueOrDie(), plaintext);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(StreamingAesSivThreadsTests,
+                         StreamingAesSivThreadsTest,
+                         ::testing::Values(1, 2, 4));
+
+TEST(StreamingAesSivTest, ModifiedCiphertextWritesNothing) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  auto streaming = StreamingAesSiv::New(Random::GetRandomKeyBytes(64));
+  ASSERT_THAT(streaming.status(), IsOk());
+  std::string plaintext = Random::GetRandomBytes(StreamingAesSiv::kChunkSize);
+  auto ciphertext = RunOnStream(
+      plaintext, [&](RandomAccessStream* in, OutputStream* out) {
+        return streaming.ValueOrDie()->Encrypt(in, "aad", out);
+      });
+  ASSERT_THAT(ciphertext.status(), IsOk());
+
+  for (int position : {0, 15, 16, StreamingAesSiv::kChunkSize + 15}) {
+    SCOPED_TRACE(position);
+    std::string modified = ciphertext.ValueOrDie();
+    modified[position] ^= 1;
+    auto output_stream = absl::make_unique<std::stringstream>();
+    auto output_buf = output_stream->rdbuf();
+    util::OstreamOutputStream output(std::move(output_stream));
+    EXPECT_THAT(streaming.ValueOrDie()->Decrypt(
+                    GetRandomAccessStream(modified).get(), "aad", &output, 2),
+                StatusIs(util::error::INVALID_ARGUMENT));
+    ASSERT_THAT(output.Close(), IsOk());
+    EXPECT_EQ(output_buf->str(), "");
+  }
+
+  auto output_stream = absl::make_unique<std::stringstream>();
+  util::OstreamOutputStream output(std::move(output_stream));
+  EXPECT_THAT(
+      streaming.ValueOrDie()->Decrypt(
+          GetRandomAccessStream(ciphertext.ValueOrDie()).get(), "bad", &output),
+      StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(streaming.ValueOrDie()->Decrypt(
+                  GetRandomAccessStream("too short").get(), "aad", &output),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(StreamingAesSivTest, InvalidKeySize) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  for (int size : {0, 16, 32, 48, 63, 65}) {
+    EXPECT_THAT(
+        StreamingAesSiv::New(Random::GetRandomKeyBytes(size)).status(),
+        StatusIs(util::error::INVALID_ARGUMENT));
+  }
+}
+
+TEST(StreamingAesSivTest, FipsMode) {
+  if (!kUseOnlyFips) {
+    GTEST_SKIP() << "Only supported in FIPS-only mode";
+  }
+  EXPECT_THAT(StreamingAesSiv::New(Random::GetRandomKeyBytes(64)).status(),
+              StatusIs(util::error::INTERNAL));
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
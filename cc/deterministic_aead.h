@@ -17,12 +17,36 @@
 #ifndef TINK_DETERMINISTIC_AEAD_H_
 #define TINK_DETERMINISTIC_AEAD_H_
 
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/util/output_buffer_factory.h"
+#include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
 namespace crypto {
 namespace tink {
 
+///////////////////////////////////////////////////////////////////////////////
+// A deterministic AEAD bound to one fixed associated data, as returned by
+// DeterministicAead::PrepareAssociatedData(). Encrypting and decrypting with
+// it is the same as calling the DeterministicAead with that associated data.
+class PreparedDeterministicAead {
+ public:
+  virtual crypto::tink::util::StatusOr<std::string> EncryptDeterministically(
+      absl::string_view plaintext) const = 0;
+
+  virtual crypto::tink::util::StatusOr<std::string> DecryptDeterministically(
+      absl::string_view ciphertext) const = 0;
+
+  virtual ~PreparedDeterministicAead() {}
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // The interface for deterministic authenticated encryption with associated
 // data.
@@ -51,9 +75,143 @@ class DeterministicAead {
       absl::string_view ciphertext,
       absl::string_view associated_data) const = 0;
 
+  // Encrypts each of 'plaintexts' deterministically with the same
+  // 'associated_data'. The ciphertexts are stored back to back in
+  // 'ciphertexts', and 'offsets' is set to plaintexts.size() + 1 positions
+  // such that ciphertext i occupies the bytes [offsets[i], offsets[i + 1]) of
+  // 'ciphertexts'. Each ciphertext is the same as that of
+  // EncryptDeterministically(). Fails as a whole if any of the records cannot
+  // be encrypted.
+  //
+  // Implementations should override this method if they can amortize the
+  // work on 'associated_data' over the batch; the default implementation
+  // calls EncryptDeterministically() for each record.
+  virtual crypto::tink::util::Status EncryptDeterministicallyBatch(
+      absl::Span<const absl::string_view> plaintexts,
+      absl::string_view associated_data, std::string* ciphertexts,
+      std::vector<int64_t>* offsets) const {
+    ciphertexts->clear();
+    offsets->assign(1, 0);
+    offsets->reserve(plaintexts.size() + 1);
+    for (absl::string_view plaintext : plaintexts) {
+      auto ciphertext_result =
+          EncryptDeterministically(plaintext, associated_data);
+      if (!ciphertext_result.ok()) return ciphertext_result.status();
+      ciphertexts->append(ciphertext_result.ValueOrDie());
+      offsets->push_back(ciphertexts->size());
+    }
+    return crypto::tink::util::Status::OK;
+  }
+
+  // Decrypts each of 'ciphertexts' with the same 'associated_data'. The
+  // plaintexts are stored in 'plaintexts' and 'offsets' in the same layout as
+  // produced by EncryptDeterministicallyBatch(). Fails as a whole if any of
+  // the records does not decrypt.
+  //
+  // The default implementation calls DecryptDeterministically() for each
+  // record.
+  virtual crypto::tink::util::Status DecryptDeterministicallyBatch(
+      absl::Span<const absl::string_view> ciphertexts,
+      absl::string_view associated_data, std::string* plaintexts,
+      std::vector<int64_t>* offsets) const {
+    plaintexts->clear();
+    offsets->assign(1, 0);
+    offsets->reserve(ciphertexts.size() + 1);
+    for (absl::string_view ciphertext : ciphertexts) {
+      auto plaintext_result =
+          DecryptDeterministically(ciphertext, associated_data);
+      if (!plaintext_result.ok()) return plaintext_result.status();
+      plaintexts->append(plaintext_result.ValueOrDie());
+      offsets->push_back(plaintexts->size());
+    }
+    return crypto::tink::util::Status::OK;
+  }
+
+  // Encrypts 'plaintext' like EncryptDeterministically(), but writes the
+  // ciphertext to a buffer from 'new_buffer' and returns the part of it
+  // holding the ciphertext.
+  //
+  // Implementations which can encrypt directly into the buffer should
+  // override this method; the default implementation calls
+  // EncryptDeterministically() and copies the result.
+  virtual crypto::tink::util::StatusOr<absl::Span<char>>
+  EncryptDeterministicallyToBuffer(
+      absl::string_view plaintext, absl::string_view associated_data,
+      const crypto::tink::util::OutputBufferFactory& new_buffer) const {
+    auto ciphertext_result =
+        EncryptDeterministically(plaintext, associated_data);
+    if (!ciphertext_result.ok()) return ciphertext_result.status();
+    return crypto::tink::util::internal::CopyToNewBuffer(
+        ciphertext_result.ValueOrDie(), new_buffer);
+  }
+
+  // Decrypts 'ciphertext' like DecryptDeterministically(), but writes the
+  // plaintext to a buffer from 'new_buffer' and returns the part of it
+  // holding the plaintext.
+  //
+  // Implementations which can decrypt directly into the buffer should
+  // override this method; the default implementation calls
+  // DecryptDeterministically() and copies the result.
+  virtual crypto::tink::util::StatusOr<absl::Span<char>>
+  DecryptDeterministicallyToBuffer(
+      absl::string_view ciphertext, absl::string_view associated_data,
+      const crypto::tink::util::OutputBufferFactory& new_buffer) const {
+    auto plaintext_result =
+        DecryptDeterministically(ciphertext, associated_data);
+    if (!plaintext_result.ok()) return plaintext_result.status();
+    return crypto::tink::util::internal::CopyToNewBuffer(
+        plaintext_result.ValueOrDie(), new_buffer);
+  }
+
+  // Returns a PreparedDeterministicAead for 'associated_data', to be used when
+  // many messages are encrypted or decrypted with the same associated data
+  // (e.g. a table and column name). The returned object refers to this
+  // DeterministicAead, which must outlive it.
+  //
+  // Implementations should override this method if they can precompute the
+  // work on 'associated_data'; the default implementation stores a copy of
+  // 'associated_data' and forwards to this DeterministicAead.
+  virtual crypto::tink::util::StatusOr<
+      std::unique_ptr<PreparedDeterministicAead>>
+  PrepareAssociatedData(absl::string_view associated_data) const;
+
   virtual ~DeterministicAead() {}
 };
 
+namespace internal {
+
+// The PreparedDeterministicAead returned by the default implementation of
+// DeterministicAead::PrepareAssociatedData().
+class ForwardingPreparedDeterministicAead : public PreparedDeterministicAead {
+ public:
+  ForwardingPreparedDeterministicAead(const DeterministicAead* daead,
+                                      absl::string_view associated_data)
+      : daead_(daead), associated_data_(associated_data) {}
+
+  crypto::tink::util::StatusOr<std::string> EncryptDeterministically(
+      absl::string_view plaintext) const override {
+    return daead_->EncryptDeterministically(plaintext, associated_data_);
+  }
+
+  crypto::tink::util::StatusOr<std::string> DecryptDeterministically(
+      absl::string_view ciphertext) const override {
+    return daead_->DecryptDeterministically(ciphertext, associated_data_);
+  }
+
+ private:
+  const DeterministicAead* daead_;
+  const std::string associated_data_;
+};
+
+}  // namespace internal
+
+inline crypto::tink::util::StatusOr<std::unique_ptr<PreparedDeterministicAead>>
+DeterministicAead::PrepareAssociatedData(
+    absl::string_view associated_data) const {
+  return {absl::make_unique<internal::ForwardingPreparedDeterministicAead>(
+      this, associated_data)};
+}
+
 }  // namespace tink
 }  // namespace crypto
 
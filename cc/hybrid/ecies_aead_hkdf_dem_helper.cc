@@ -19,12 +19,16 @@
 #include <utility>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
 #include "tink/aead.h"
 #include "tink/deterministic_aead.h"
-#include "tink/key_manager.h"
-#include "tink/registry.h"
+#include "tink/subtle/aes_ctr_hmac_boringssl.h"
+#include "tink/subtle/aes_gcm_boringssl.h"
+#include "tink/subtle/aes_siv_boringssl.h"
+#include "tink/subtle/xchacha20_poly1305_boringssl.h"
+#include "tink/util/enums.h"
 #include "tink/util/errors.h"
-#include "tink/util/protobuf_helper.h"
+#include "tink/util/secret_data.h"
 #include "tink/util/statusor.h"
 #include "proto/aes_ctr_hmac_aead.pb.h"
 #include "proto/aes_gcm.pb.h"
@@ -37,46 +41,26 @@ namespace tink {
 namespace {
 
 using ::crypto::tink::subtle::AeadOrDaead;
-using ::google::crypto::tink::AesCtrHmacAeadKey;
 using ::google::crypto::tink::AesCtrHmacAeadKeyFormat;
-using ::google::crypto::tink::AesGcmKey;
 using ::google::crypto::tink::AesGcmKeyFormat;
-using ::google::crypto::tink::AesSivKey;
 using ::google::crypto::tink::AesSivKeyFormat;
 using ::google::crypto::tink::KeyTemplate;
-using ::google::crypto::tink::XChaCha20Poly1305Key;
 using ::google::crypto::tink::XChaCha20Poly1305KeyFormat;
 
-// Internal implementaton of the EciesAeadHkdfDemHelper class, paremetrized by
-// the Primitive used for data encapsulation (i.e Aead or DeterministicAead).
 template <class EncryptionPrimitive>
+util::StatusOr<std::unique_ptr<AeadOrDaead>> ToAeadOrDaead(
+    util::StatusOr<std::unique_ptr<EncryptionPrimitive>> primitive_or) {
+  if (!primitive_or.ok()) return primitive_or.status();
+  return absl::make_unique<AeadOrDaead>(std::move(primitive_or.ValueOrDie()));
+}
+
+// Builds the DEM primitive with the subtle implementations the key managers
+// use, without going through key protos and the registry for every message.
 class EciesAeadHkdfDemHelperImpl : public EciesAeadHkdfDemHelper {
  public:
-  static util::StatusOr<std::unique_ptr<const EciesAeadHkdfDemHelper>> New(
-      const google::crypto::tink::KeyTemplate& dem_key_template,
-      const DemKeyParams& key_params, const std::string& dem_type_url) {
-    auto key_manager_or =
-        Registry::get_key_manager<EncryptionPrimitive>(dem_type_url);
-    if (!key_manager_or.ok()) {
-      return ToStatusF(
-          util::error::FAILED_PRECONDITION,
-          "No manager for DEM key type '%s' found in the registry.",
-          dem_type_url);
-    }
-    const KeyManager<EncryptionPrimitive>* key_manager =
-        key_manager_or.ValueOrDie();
-    return {absl::make_unique<EciesAeadHkdfDemHelperImpl<EncryptionPrimitive>>(
-        key_manager, dem_key_template, key_params)};
-  }
+  explicit EciesAeadHkdfDemHelperImpl(DemKeyParams key_params)
+      : EciesAeadHkdfDemHelper(key_params) {}
 
-  EciesAeadHkdfDemHelperImpl(
-      const KeyManager<EncryptionPrimitive>* key_manager,
-      const google::crypto::tink::KeyTemplate& key_template,
-      DemKeyParams key_params)
-      : EciesAeadHkdfDemHelper(key_template, key_params),
-        key_manager_(key_manager) {}
-
- protected:
   crypto::tink::util::StatusOr<
       std::unique_ptr<crypto::tink::subtle::AeadOrDaead>>
   GetAeadOrDaead(const util::SecretData& symmetric_key_value) const override {
@@ -84,24 +68,28 @@ class EciesAeadHkdfDemHelperImpl : public EciesAeadHkdfDemHelper {
       return util::Status(util::error::INTERNAL,
                           "Wrong length of symmetric key.");
     }
-    auto key_or = key_manager_->get_key_factory().NewKey(key_template_.value());
-    if (!key_or.ok()) return key_or.status();
-    auto key = std::move(key_or).ValueOrDie();
-    if (!ReplaceKeyBytes(symmetric_key_value, key.get())) {
-      return util::Status(util::error::INTERNAL,
-                          "Generation of DEM-key failed.");
+    switch (key_params_.key_type) {
+      case AES_GCM_KEY:
+        return ToAeadOrDaead(subtle::AesGcmBoringSsl::New(symmetric_key_value));
+      case AES_CTR_HMAC_AEAD_KEY: {
+        absl::string_view key_bytes =
+            util::SecretDataAsStringView(symmetric_key_value);
+        return ToAeadOrDaead(subtle::AesCtrHmacBoringSsl::New(
+            util::SecretDataFromStringView(
+                key_bytes.substr(0, key_params_.aes_ctr_key_size_in_bytes)),
+            key_params_.aes_ctr_iv_size, key_params_.hmac_hash,
+            util::SecretDataFromStringView(
+                key_bytes.substr(key_params_.aes_ctr_key_size_in_bytes)),
+            key_params_.hmac_tag_size));
+      }
+      case XCHACHA20_POLY1305_KEY:
+        return ToAeadOrDaead(
+            subtle::XChacha20Poly1305BoringSsl::New(symmetric_key_value));
+      case AES_SIV_KEY:
+        return ToAeadOrDaead(subtle::AesSivBoringSsl::New(symmetric_key_value));
     }
-
-    util::StatusOr<std::unique_ptr<EncryptionPrimitive>> primitive_or =
-        key_manager_->GetPrimitive(*key);
-    ZeroKeyBytes(key.get());
-
-    if (!primitive_or.ok()) return primitive_or.status();
-    return absl::make_unique<AeadOrDaead>(std::move(primitive_or.ValueOrDie()));
+    return util::Status(util::error::INTERNAL, "Unknown DEM key type.");
   }
-
- private:
-  const KeyManager<EncryptionPrimitive>* key_manager_;  // not owned
 };
 
 }  // namespace
@@ -126,7 +114,13 @@ EciesAeadHkdfDemHelper::GetKeyParams(const KeyTemplate& key_template) {
     uint32_t dem_key_size = key_format.aes_ctr_key_format().key_size() +
                             key_format.hmac_key_format().key_size();
     return {{AES_CTR_HMAC_AEAD_KEY, dem_key_size,
-             key_format.aes_ctr_key_format().key_size()}};
+             key_format.aes_ctr_key_format().key_size(),
+             static_cast<int>(
+                 key_format.aes_ctr_key_format().params().iv_size()),
+             util::Enums::ProtoToSubtle(
+                 key_format.hmac_key_format().params().hash()),
+             static_cast<int>(
+                 key_format.hmac_key_format().params().tag_size())}};
   }
   if (type_url ==
       "type.googleapis.com/google.crypto.tink.XChaCha20Poly1305Key") {
@@ -154,88 +148,14 @@ util::StatusOr<std::unique_ptr<const EciesAeadHkdfDemHelper>>
 EciesAeadHkdfDemHelper::New(const KeyTemplate& dem_key_template) {
   auto key_params_or = GetKeyParams(dem_key_template);
   if (!key_params_or.ok()) return key_params_or.status();
-  DemKeyParams key_params = key_params_or.ValueOrDie();
-  const std::string& dem_type_url = dem_key_template.type_url();
-
-  if (key_params.key_type == AES_SIV_KEY) {
-    return EciesAeadHkdfDemHelperImpl<DeterministicAead>::New(
-        dem_key_template, key_params, dem_type_url);
-  } else {
-    return EciesAeadHkdfDemHelperImpl<Aead>::New(dem_key_template, key_params,
-                                                 dem_type_url);
-  }
-}
-
-bool EciesAeadHkdfDemHelper::ReplaceKeyBytes(
-    const util::SecretData& key_bytes,
-    portable_proto::MessageLite* proto) const {
-  switch (key_params_.key_type) {
-    case AES_GCM_KEY: {
-      AesGcmKey* key = static_cast<AesGcmKey*>(proto);
-      key->set_key_value(std::string(util::SecretDataAsStringView(key_bytes)));
-      return true;
-    }
-    case AES_CTR_HMAC_AEAD_KEY: {
-      AesCtrHmacAeadKey* key = static_cast<AesCtrHmacAeadKey*>(proto);
-      auto aes_ctr_key = key->mutable_aes_ctr_key();
-      aes_ctr_key->set_key_value(
-          std::string(util::SecretDataAsStringView(key_bytes).substr(
-              0, key_params_.aes_ctr_key_size_in_bytes)));
-      auto hmac_key = key->mutable_hmac_key();
-      hmac_key->set_key_value(
-          std::string(util::SecretDataAsStringView(key_bytes).substr(
-              key_params_.aes_ctr_key_size_in_bytes)));
-      return true;
-    }
-    case XCHACHA20_POLY1305_KEY: {
-      XChaCha20Poly1305Key* key = static_cast<XChaCha20Poly1305Key*>(proto);
-      key->set_key_value(std::string(util::SecretDataAsStringView(key_bytes)));
-      return true;
-    }
-    case AES_SIV_KEY: {
-      AesSivKey* key = static_cast<AesSivKey*>(proto);
-      key->set_key_value(std::string(util::SecretDataAsStringView(key_bytes)));
-      return true;
-    }
-  }
-  return false;
-}
-
-void EciesAeadHkdfDemHelper::ZeroKeyBytes(
-    portable_proto::MessageLite* proto) const {
-  switch (key_params_.key_type) {
-    case AES_GCM_KEY: {
-      AesGcmKey* key = static_cast<AesGcmKey*>(proto);
-      std::unique_ptr<std::string> key_value =
-          absl::WrapUnique(key->release_key_value());
-      util::SafeZeroString(key_value.get());
-      break;
-    }
-    case AES_CTR_HMAC_AEAD_KEY: {
-      AesCtrHmacAeadKey* key = static_cast<AesCtrHmacAeadKey*>(proto);
-      std::unique_ptr<std::string> aes_ctr_key_value =
-          absl::WrapUnique(key->mutable_aes_ctr_key()->release_key_value());
-      util::SafeZeroString(aes_ctr_key_value.get());
-      std::unique_ptr<std::string> hmac_key_value =
-          absl::WrapUnique(key->mutable_hmac_key()->release_key_value());
-      util::SafeZeroString(hmac_key_value.get());
-      break;
-    }
-    case XCHACHA20_POLY1305_KEY: {
-      XChaCha20Poly1305Key* key = static_cast<XChaCha20Poly1305Key*>(proto);
-      std::unique_ptr<std::string> key_value =
-          absl::WrapUnique(key->release_key_value());
-      util::SafeZeroString(key_value.get());
-      break;
-    }
-    case AES_SIV_KEY: {
-      AesSivKey* key = static_cast<AesSivKey*>(proto);
-      std::unique_ptr<std::string> key_value =
-          absl::WrapUnique(key->release_key_value());
-      util::SafeZeroString(key_value.get());
-      break;
-    }
-  }
+  auto helper = absl::make_unique<EciesAeadHkdfDemHelperImpl>(
+      key_params_or.ValueOrDie());
+  // Checks the parameters once, so that GetAeadOrDaead() can only fail on
+  // keys of the wrong size.
+  auto dem_or = helper->GetAeadOrDaead(
+      util::SecretData(helper->dem_key_size_in_bytes(), 0));
+  if (!dem_or.ok()) return dem_or.status();
+  return {std::move(helper)};
 }
 
 }  // namespace tink
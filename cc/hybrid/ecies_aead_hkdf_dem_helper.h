@@ -21,8 +21,7 @@
 
 #include "tink/aead.h"
 #include "tink/daead/subtle/aead_or_daead.h"
-#include "tink/key_manager.h"
-#include "tink/util/protobuf_helper.h"
+#include "tink/subtle/common_enums.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/statusor.h"
 #include "proto/tink.pb.h"
@@ -60,25 +59,24 @@ class EciesAeadHkdfDemHelper {
     AES_SIV_KEY,
   };
 
+  // Everything about the DEM but the key bytes, resolved from the key
+  // template once, so that GetAeadOrDaead() builds the primitive directly.
   struct DemKeyParams {
     DemKeyType key_type;
     uint32_t key_size_in_bytes;
+    // Only for AES_CTR_HMAC_AEAD_KEY.
     uint32_t aes_ctr_key_size_in_bytes;
+    int aes_ctr_iv_size;
+    subtle::HashType hmac_hash;
+    int hmac_tag_size;
   };
 
-  EciesAeadHkdfDemHelper(const google::crypto::tink::KeyTemplate& key_template,
-                         DemKeyParams key_params)
-      : key_template_(key_template), key_params_(key_params) {}
+  explicit EciesAeadHkdfDemHelper(DemKeyParams key_params)
+      : key_params_(key_params) {}
 
   static util::StatusOr<DemKeyParams> GetKeyParams(
       const ::google::crypto::tink::KeyTemplate& key_template);
 
-  bool ReplaceKeyBytes(const util::SecretData& key_bytes,
-                       portable_proto::MessageLite* proto) const;
-
-  void ZeroKeyBytes(portable_proto::MessageLite* proto) const;
-
-  const google::crypto::tink::KeyTemplate key_template_;
   const DemKeyParams key_params_;
 };
 
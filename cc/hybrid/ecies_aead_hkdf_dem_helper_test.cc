@@ -24,6 +24,10 @@
 #include "tink/util/secret_data.h"
 #include "tink/util/test_matchers.h"
 #include "tink/util/test_util.h"
+#include "proto/aes_ctr_hmac_aead.pb.h"
+#include "proto/aes_gcm.pb.h"
+#include "proto/aes_siv.pb.h"
+#include "proto/common.pb.h"
 
 namespace crypto {
 namespace tink {
@@ -115,6 +119,85 @@ TEST(EciesAeadHkdfDemHelperTest, DemHelperWithSomeDeterministicAeadKeyType) {
               IsOk());
 }
 
+TEST(EciesAeadHkdfDemHelperTest, DemHelperWithAesCtrHmacAeadKeyType) {
+  google::crypto::tink::AesCtrHmacAeadKeyFormat key_format;
+  key_format.mutable_aes_ctr_key_format()->set_key_size(16);
+  key_format.mutable_aes_ctr_key_format()->mutable_params()->set_iv_size(16);
+  key_format.mutable_hmac_key_format()->set_key_size(32);
+  key_format.mutable_hmac_key_format()->mutable_params()->set_hash(
+      google::crypto::tink::SHA256);
+  key_format.mutable_hmac_key_format()->mutable_params()->set_tag_size(16);
+
+  google::crypto::tink::KeyTemplate dem_key_template;
+  dem_key_template.set_type_url(
+      "type.googleapis.com/google.crypto.tink.AesCtrHmacAeadKey");
+  dem_key_template.set_value(key_format.SerializeAsString());
+
+  auto dem_helper_or = EciesAeadHkdfDemHelper::New(dem_key_template);
+  ASSERT_THAT(dem_helper_or.status(), IsOk());
+  auto dem_helper = std::move(dem_helper_or.ValueOrDie());
+  EXPECT_EQ(48, dem_helper->dem_key_size_in_bytes());
+
+  auto aead_or_daead_or =
+      dem_helper->GetAeadOrDaead(util::SecretData(48, 0x42));
+  ASSERT_THAT(aead_or_daead_or.status(), IsOk());
+  EXPECT_THAT(EncryptThenDecrypt(*aead_or_daead_or.ValueOrDie(),
+                                 "test_plaintext", "test_ad"),
+              IsOk());
+  EXPECT_THAT(dem_helper->GetAeadOrDaead(util::SecretData(47, 0x42)).status(),
+              StatusIs(util::error::INTERNAL));
+}
+
+TEST(EciesAeadHkdfDemHelperTest, InvalidKeyFormat) {
+  google::crypto::tink::AesGcmKeyFormat key_format;
+  key_format.set_key_size(17);
+  google::crypto::tink::KeyTemplate dem_key_template;
+  dem_key_template.set_type_url(
+      "type.googleapis.com/google.crypto.tink.AesGcmKey");
+  dem_key_template.set_value(key_format.SerializeAsString());
+  EXPECT_THAT(EciesAeadHkdfDemHelper::New(dem_key_template).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(EciesAeadHkdfDemHelperTest, DemDependsOnlyOnSymmetricKey) {
+  google::crypto::tink::AesGcmKeyFormat key_format;
+  key_format.set_key_size(16);
+  std::unique_ptr<AesGcmKeyManager> key_manager(new AesGcmKeyManager());
+  std::string dem_key_type = key_manager->get_key_type();
+  ASSERT_THAT(Registry::RegisterKeyTypeManager(std::move(key_manager), true),
+              IsOk());
+
+  google::crypto::tink::KeyTemplate dem_key_template;
+  dem_key_template.set_type_url(dem_key_type);
+  dem_key_template.set_value(key_format.SerializeAsString());
+
+  auto dem_helper_or = EciesAeadHkdfDemHelper::New(dem_key_template);
+  ASSERT_THAT(dem_helper_or.status(), IsOk());
+  auto dem_helper = std::move(dem_helper_or.ValueOrDie());
+
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  util::SecretData other_key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("0f0e0d0c0b0a09080706050403020100"));
+  auto encrypting_dem_or = dem_helper->GetAeadOrDaead(key);
+  ASSERT_THAT(encrypting_dem_or.status(), IsOk());
+  auto ciphertext_or =
+      encrypting_dem_or.ValueOrDie()->Encrypt("test_plaintext", "");
+  ASSERT_THAT(ciphertext_or.status(), IsOk());
+
+  // A DEM created later from the same key decrypts, one from another key
+  // does not.
+  auto other_dem_or = dem_helper->GetAeadOrDaead(other_key);
+  ASSERT_THAT(other_dem_or.status(), IsOk());
+  EXPECT_FALSE(
+      other_dem_or.ValueOrDie()->Decrypt(ciphertext_or.ValueOrDie(), "").ok());
+  auto decrypting_dem_or = dem_helper->GetAeadOrDaead(key);
+  ASSERT_THAT(decrypting_dem_or.status(), IsOk());
+  EXPECT_THAT(
+      decrypting_dem_or.ValueOrDie()->Decrypt(ciphertext_or.ValueOrDie(), ""),
+      test::IsOkAndHolds("test_plaintext"));
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
@@ -23,8 +23,10 @@
 #include "tink/core/key_type_manager.h"
 #include "tink/core/private_key_type_manager.h"
 #include "tink/hybrid/ecies_aead_hkdf_hybrid_decrypt.h"
+#include "tink/hybrid/ecies_aead_hkdf_streaming_decrypt.h"
 #include "tink/hybrid_decrypt.h"
 #include "tink/key_manager.h"
+#include "tink/streaming_hybrid_decrypt.h"
 #include "tink/util/constants.h"
 #include "tink/util/errors.h"
 #include "tink/util/protobuf_helper.h"
@@ -40,7 +42,8 @@ class EciesAeadHkdfPrivateKeyManager
     : public PrivateKeyTypeManager<
           google::crypto::tink::EciesAeadHkdfPrivateKey,
           google::crypto::tink::EciesAeadHkdfKeyFormat,
-          google::crypto::tink::EciesAeadHkdfPublicKey, List<HybridDecrypt>> {
+          google::crypto::tink::EciesAeadHkdfPublicKey,
+          List<HybridDecrypt, StreamingHybridDecrypt>> {
  public:
   class HybridDecryptFactory : public PrimitiveFactory<HybridDecrypt> {
     crypto::tink::util::StatusOr<std::unique_ptr<HybridDecrypt>> Create(
@@ -50,8 +53,20 @@ class EciesAeadHkdfPrivateKeyManager
     }
   };
 
+  // Only for keys whose DEM is a streaming AEAD key template.
+  class StreamingHybridDecryptFactory
+      : public PrimitiveFactory<StreamingHybridDecrypt> {
+    crypto::tink::util::StatusOr<std::unique_ptr<StreamingHybridDecrypt>>
+    Create(const google::crypto::tink::EciesAeadHkdfPrivateKey&
+               ecies_private_key) const override {
+      return EciesAeadHkdfStreamingDecrypt::New(ecies_private_key);
+    }
+  };
+
   EciesAeadHkdfPrivateKeyManager()
-      : PrivateKeyTypeManager(absl::make_unique<HybridDecryptFactory>()) {}
+      : PrivateKeyTypeManager(
+            absl::make_unique<HybridDecryptFactory>(),
+            absl::make_unique<StreamingHybridDecryptFactory>()) {}
 
   uint32_t get_version() const override { return 0; }
 
@@ -22,8 +22,10 @@
 #include "absl/strings/str_cat.h"
 #include "tink/core/key_type_manager.h"
 #include "tink/hybrid/ecies_aead_hkdf_hybrid_encrypt.h"
+#include "tink/hybrid/ecies_aead_hkdf_streaming_encrypt.h"
 #include "tink/hybrid_encrypt.h"
 #include "tink/key_manager.h"
+#include "tink/streaming_hybrid_encrypt.h"
 #include "tink/util/constants.h"
 #include "tink/util/errors.h"
 #include "tink/util/protobuf_helper.h"
@@ -37,7 +39,7 @@ namespace tink {
 
 class EciesAeadHkdfPublicKeyManager
     : public KeyTypeManager<google::crypto::tink::EciesAeadHkdfPublicKey, void,
-                            List<HybridEncrypt>> {
+                            List<HybridEncrypt, StreamingHybridEncrypt>> {
  public:
   class HybridEncryptFactory : public PrimitiveFactory<HybridEncrypt> {
     crypto::tink::util::StatusOr<std::unique_ptr<HybridEncrypt>> Create(
@@ -47,8 +49,19 @@ class EciesAeadHkdfPublicKeyManager
     }
   };
 
+  // Only for keys whose DEM is a streaming AEAD key template.
+  class StreamingHybridEncryptFactory
+      : public PrimitiveFactory<StreamingHybridEncrypt> {
+    crypto::tink::util::StatusOr<std::unique_ptr<StreamingHybridEncrypt>>
+    Create(const google::crypto::tink::EciesAeadHkdfPublicKey&
+               ecies_public_key) const override {
+      return EciesAeadHkdfStreamingEncrypt::New(ecies_public_key);
+    }
+  };
+
   EciesAeadHkdfPublicKeyManager()
-      : KeyTypeManager(absl::make_unique<HybridEncryptFactory>()) {}
+      : KeyTypeManager(absl::make_unique<HybridEncryptFactory>(),
+                       absl::make_unique<StreamingHybridEncryptFactory>()) {}
 
   uint32_t get_version() const override { return 0; }
 
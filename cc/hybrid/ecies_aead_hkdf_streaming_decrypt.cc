@@ -0,0 +1,129 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/hybrid/ecies_aead_hkdf_streaming_decrypt.h"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "tink/input_stream.h"
+#include "tink/streaming_aead.h"
+#include "tink/subtle/ec_util.h"
+#include "tink/util/enums.h"
+#include "tink/util/input_stream_util.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "proto/ecies_aead_hkdf.pb.h"
+
+using ::google::crypto::tink::EciesAeadHkdfPrivateKey;
+using ::google::crypto::tink::EllipticCurveType;
+
+namespace crypto {
+namespace tink {
+
+namespace {
+util::Status Validate(const EciesAeadHkdfPrivateKey& key) {
+  if (!key.has_public_key() || !key.public_key().has_params() ||
+      key.public_key().x().empty() || key.key_value().empty()) {
+    return util::Status(
+        util::error::INVALID_ARGUMENT,
+        "Invalid EciesAeadHkdfPublicKey: missing required fields.");
+  }
+
+  if (key.public_key().params().has_kem_params() &&
+      key.public_key().params().kem_params().curve_type() ==
+          EllipticCurveType::CURVE25519) {
+    if (!key.public_key().y().empty()) {
+      return util::Status(
+          util::error::INVALID_ARGUMENT,
+          "Invalid EciesAeadHkdfPublicKey: has unexpected field.");
+    }
+  } else if (key.public_key().y().empty()) {
+    return util::Status(
+        util::error::INVALID_ARGUMENT,
+        "Invalid EciesAeadHkdfPublicKey: missing required fields.");
+  }
+  return util::Status::OK;
+}
+}  // namespace
+
+// static
+util::StatusOr<std::unique_ptr<StreamingHybridDecrypt>>
+EciesAeadHkdfStreamingDecrypt::New(
+    const EciesAeadHkdfPrivateKey& recipient_key) {
+  util::Status status = Validate(recipient_key);
+  if (!status.ok()) return status;
+
+  auto kem_result = subtle::EciesHkdfRecipientKemBoringSsl::New(
+      util::Enums::ProtoToSubtle(
+          recipient_key.public_key().params().kem_params().curve_type()),
+      util::SecretDataFromStringView(recipient_key.key_value()));
+  if (!kem_result.ok()) return kem_result.status();
+
+  auto dem_result = EciesAeadHkdfStreamingDemHelper::New(
+      recipient_key.public_key().params().dem_params().aead_dem());
+  if (!dem_result.ok()) return dem_result.status();
+
+  return {absl::WrapUnique(new EciesAeadHkdfStreamingDecrypt(
+      recipient_key.public_key().params(), std::move(kem_result).ValueOrDie(),
+      std::move(dem_result).ValueOrDie()))};
+}
+
+util::StatusOr<std::unique_ptr<InputStream>>
+EciesAeadHkdfStreamingDecrypt::NewDecryptingStream(
+    std::unique_ptr<InputStream> ciphertext_source,
+    absl::string_view context_info) const {
+  if (ciphertext_source == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_source must be non-null");
+  }
+  // Read KEM-bytes from the ciphertext.
+  auto header_size_result = subtle::EcUtil::EncodingSizeInBytes(
+      util::Enums::ProtoToSubtle(
+          recipient_key_params_.kem_params().curve_type()),
+      util::Enums::ProtoToSubtle(recipient_key_params_.ec_point_format()));
+  if (!header_size_result.ok()) return header_size_result.status();
+  auto kem_bytes_result = ReadBytesFromStream(header_size_result.ValueOrDie(),
+                                              ciphertext_source.get());
+  if (!kem_bytes_result.ok()) {
+    if (kem_bytes_result.status().error_code() == util::error::OUT_OF_RANGE) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "ciphertext too short");
+    }
+    return kem_bytes_result.status();
+  }
+
+  // Use KEM to get a symmetric key.
+  auto symmetric_key_result = recipient_kem_->GenerateKey(
+      kem_bytes_result.ValueOrDie(),
+      util::Enums::ProtoToSubtle(
+          recipient_key_params_.kem_params().hkdf_hash_type()),
+      recipient_key_params_.kem_params().hkdf_salt(), context_info,
+      dem_helper_->dem_key_size_in_bytes(),
+      util::Enums::ProtoToSubtle(recipient_key_params_.ec_point_format()));
+  if (!symmetric_key_result.ok()) return symmetric_key_result.status();
+
+  // Use the symmetric key to get a StreamingAead-primitive, and decrypt
+  // the rest of the ciphertext with it.
+  auto streaming_aead_result =
+      dem_helper_->GetStreamingAead(symmetric_key_result.ValueOrDie());
+  if (!streaming_aead_result.ok()) return streaming_aead_result.status();
+  return streaming_aead_result.ValueOrDie()->NewDecryptingStream(
+      std::move(ciphertext_source), "");  // empty aad
+}
+
+}  // namespace tink
+}  // namespace crypto
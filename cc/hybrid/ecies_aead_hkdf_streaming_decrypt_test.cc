@@ -0,0 +1,161 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/hybrid/ecies_aead_hkdf_streaming_decrypt.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "tink/hybrid/ecies_aead_hkdf_streaming_encrypt.h"
+#include "tink/streamingaead/streaming_aead_config.h"
+#include "tink/streamingaead/streaming_aead_key_templates.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/istream_input_stream.h"
+#include "tink/util/ostream_output_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+#include "proto/common.pb.h"
+#include "proto/ecies_aead_hkdf.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::google::crypto::tink::EciesAeadHkdfPrivateKey;
+using ::google::crypto::tink::EcPointFormat;
+using ::google::crypto::tink::EllipticCurveType;
+using ::google::crypto::tink::HashType;
+using ::testing::HasSubstr;
+
+// Returns a fresh P-256 key with AES128-GCM-HKDF streaming as DEM.
+EciesAeadHkdfPrivateKey GetTestKey() {
+  EciesAeadHkdfPrivateKey key = test::GetEciesAesGcmHkdfTestKey(
+      EllipticCurveType::NIST_P256, EcPointFormat::UNCOMPRESSED,
+      HashType::SHA256, 16);
+  *key.mutable_public_key()
+       ->mutable_params()
+       ->mutable_dem_params()
+       ->mutable_aead_dem() = StreamingAeadKeyTemplates::Aes128GcmHkdf4KB();
+  return key;
+}
+
+class EciesAeadHkdfStreamingDecryptTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_THAT(StreamingAeadConfig::Register(), IsOk());
+    key_ = GetTestKey();
+    auto encrypt_result =
+        EciesAeadHkdfStreamingEncrypt::New(key_.public_key());
+    ASSERT_THAT(encrypt_result.status(), IsOk());
+    auto ct_stream = absl::make_unique<std::stringstream>();
+    auto ct_buf = ct_stream.get();
+    auto enc_stream_result =
+        encrypt_result.ValueOrDie()->NewEncryptingStream(
+            absl::make_unique<util::OstreamOutputStream>(std::move(ct_stream)),
+            kContextInfo);
+    ASSERT_THAT(enc_stream_result.status(), IsOk());
+    plaintext_ = subtle::Random::GetRandomBytes(10000);
+    ASSERT_THAT(subtle::test::WriteToStream(
+                    enc_stream_result.ValueOrDie().get(), plaintext_),
+                IsOk());
+    ciphertext_ = ct_buf->str();
+  }
+
+  // Decrypts 'ciphertext' with 'key', returning the plaintext.
+  util::StatusOr<std::string> Decrypt(const EciesAeadHkdfPrivateKey& key,
+                                      absl::string_view ciphertext,
+                                      absl::string_view context_info) {
+    auto decrypt_result = EciesAeadHkdfStreamingDecrypt::New(key);
+    if (!decrypt_result.ok()) return decrypt_result.status();
+    auto dec_stream_result = decrypt_result.ValueOrDie()->NewDecryptingStream(
+        absl::make_unique<util::IstreamInputStream>(
+            absl::make_unique<std::stringstream>(std::string(ciphertext))),
+        context_info);
+    if (!dec_stream_result.ok()) return dec_stream_result.status();
+    std::string plaintext;
+    auto status = subtle::test::ReadFromStream(
+        dec_stream_result.ValueOrDie().get(), &plaintext);
+    if (!status.ok()) return status;
+    return plaintext;
+  }
+
+  static constexpr char kContextInfo[] = "some context info";
+  EciesAeadHkdfPrivateKey key_;
+  std::string plaintext_;
+  std::string ciphertext_;
+};
+
+constexpr char EciesAeadHkdfStreamingDecryptTest::kContextInfo[];
+
+TEST_F(EciesAeadHkdfStreamingDecryptTest, InvalidKeys) {
+  EciesAeadHkdfPrivateKey recipient_key;
+  EXPECT_THAT(EciesAeadHkdfStreamingDecrypt::New(recipient_key).status(),
+              StatusIs(util::error::INVALID_ARGUMENT,
+                       HasSubstr("missing required fields")));
+}
+
+TEST_F(EciesAeadHkdfStreamingDecryptTest, Decrypt) {
+  auto plaintext_result = Decrypt(key_, ciphertext_, kContextInfo);
+  ASSERT_THAT(plaintext_result.status(), IsOk());
+  EXPECT_EQ(plaintext_, plaintext_result.ValueOrDie());
+}
+
+TEST_F(EciesAeadHkdfStreamingDecryptTest, WrongContextInfo) {
+  EXPECT_FALSE(Decrypt(key_, ciphertext_, "other context info").ok());
+}
+
+TEST_F(EciesAeadHkdfStreamingDecryptTest, WrongKey) {
+  EXPECT_FALSE(Decrypt(GetTestKey(), ciphertext_, kContextInfo).ok());
+}
+
+TEST_F(EciesAeadHkdfStreamingDecryptTest, ModifiedCiphertext) {
+  for (int pos : {0, 64, 65, 1000, static_cast<int>(ciphertext_.size()) - 1}) {
+    std::string modified_ciphertext = ciphertext_;
+    modified_ciphertext[pos] ^= 1;
+    EXPECT_FALSE(Decrypt(key_, modified_ciphertext, kContextInfo).ok())
+        << "position: " << pos;
+  }
+  EXPECT_FALSE(Decrypt(key_, ciphertext_.substr(0, ciphertext_.size() - 1),
+                       kContextInfo)
+                   .ok());
+}
+
+TEST_F(EciesAeadHkdfStreamingDecryptTest, CiphertextTooShort) {
+  // Shorter than the uncompressed P-256 point of the KEM.
+  EXPECT_THAT(Decrypt(key_, ciphertext_.substr(0, 64), kContextInfo).status(),
+              StatusIs(util::error::INVALID_ARGUMENT,
+                       HasSubstr("ciphertext too short")));
+}
+
+TEST_F(EciesAeadHkdfStreamingDecryptTest, NullSource) {
+  auto decrypt_result = EciesAeadHkdfStreamingDecrypt::New(key_);
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_THAT(
+      decrypt_result.ValueOrDie()->NewDecryptingStream(nullptr, "").status(),
+      StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,126 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/hybrid/ecies_aead_hkdf_streaming_dem_helper.h"
+
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "tink/key_manager.h"
+#include "tink/registry.h"
+#include "tink/streaming_aead.h"
+#include "tink/util/errors.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/aes_ctr_hmac_streaming.pb.h"
+#include "proto/aes_gcm_hkdf_streaming.pb.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::google::crypto::tink::AesCtrHmacStreamingKey;
+using ::google::crypto::tink::AesCtrHmacStreamingKeyFormat;
+using ::google::crypto::tink::AesGcmHkdfStreamingKey;
+using ::google::crypto::tink::AesGcmHkdfStreamingKeyFormat;
+using ::google::crypto::tink::KeyTemplate;
+
+// Internal implementation of the EciesAeadHkdfStreamingDemHelper class,
+// parametrized by the key proto of the DEM and its key format. Both streaming
+// key types consist of 'params' and the input key material in 'key_value'.
+template <class KeyProto, class KeyFormatProto>
+class EciesAeadHkdfStreamingDemHelperImpl
+    : public EciesAeadHkdfStreamingDemHelper {
+ public:
+  static util::StatusOr<std::unique_ptr<const EciesAeadHkdfStreamingDemHelper>>
+  New(const KeyTemplate& dem_key_template) {
+    KeyFormatProto key_format;
+    if (!key_format.ParseFromString(dem_key_template.value())) {
+      return ToStatusF(util::error::INVALID_ARGUMENT,
+                       "Invalid key format in DEM key template '%s'.",
+                       dem_key_template.type_url());
+    }
+    auto key_manager_or =
+        Registry::get_key_manager<StreamingAead>(dem_key_template.type_url());
+    if (!key_manager_or.ok()) {
+      return ToStatusF(
+          util::error::FAILED_PRECONDITION,
+          "No manager for DEM key type '%s' found in the registry.",
+          dem_key_template.type_url());
+    }
+    KeyProto key_prototype;
+    *key_prototype.mutable_params() = key_format.params();
+    return {absl::WrapUnique(new EciesAeadHkdfStreamingDemHelperImpl(
+        key_manager_or.ValueOrDie(), key_format.key_size(),
+        std::move(key_prototype)))};
+  }
+
+  util::StatusOr<std::unique_ptr<StreamingAead>> GetStreamingAead(
+      const util::SecretData& symmetric_key_value) const override {
+    if (symmetric_key_value.size() != dem_key_size_in_bytes()) {
+      return util::Status(util::error::INTERNAL,
+                          "Wrong length of symmetric key.");
+    }
+    KeyProto key = key_prototype_;
+    key.set_key_value(
+        std::string(util::SecretDataAsStringView(symmetric_key_value)));
+    auto primitive_or = key_manager_->GetPrimitive(key);
+    std::unique_ptr<std::string> key_value =
+        absl::WrapUnique(key.release_key_value());
+    util::SafeZeroString(key_value.get());
+    return primitive_or;
+  }
+
+ private:
+  EciesAeadHkdfStreamingDemHelperImpl(
+      const KeyManager<StreamingAead>* key_manager, uint32_t key_size_in_bytes,
+      KeyProto key_prototype)
+      : EciesAeadHkdfStreamingDemHelper(key_size_in_bytes),
+        key_manager_(key_manager),
+        key_prototype_(std::move(key_prototype)) {}
+
+  const KeyManager<StreamingAead>* key_manager_;  // not owned
+  // A DEM key without key bytes.
+  const KeyProto key_prototype_;
+};
+
+}  // namespace
+
+// static
+util::StatusOr<std::unique_ptr<const EciesAeadHkdfStreamingDemHelper>>
+EciesAeadHkdfStreamingDemHelper::New(const KeyTemplate& dem_key_template) {
+  const std::string& type_url = dem_key_template.type_url();
+  if (type_url ==
+      "type.googleapis.com/google.crypto.tink.AesGcmHkdfStreamingKey") {
+    return EciesAeadHkdfStreamingDemHelperImpl<
+        AesGcmHkdfStreamingKey,
+        AesGcmHkdfStreamingKeyFormat>::New(dem_key_template);
+  }
+  if (type_url ==
+      "type.googleapis.com/google.crypto.tink.AesCtrHmacStreamingKey") {
+    return EciesAeadHkdfStreamingDemHelperImpl<
+        AesCtrHmacStreamingKey,
+        AesCtrHmacStreamingKeyFormat>::New(dem_key_template);
+  }
+  return ToStatusF(util::error::INVALID_ARGUMENT,
+                   "Unsupported streaming DEM key type '%s'.", type_url);
+}
+
+}  // namespace tink
+}  // namespace crypto
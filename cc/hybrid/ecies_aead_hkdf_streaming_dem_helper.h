@@ -0,0 +1,65 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_HYBRID_ECIES_AEAD_HKDF_STREAMING_DEM_HELPER_H_
+#define TINK_HYBRID_ECIES_AEAD_HKDF_STREAMING_DEM_HELPER_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "tink/streaming_aead.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+// A helper for the streaming DEM (data encapsulation mechanism) of
+// ECIES-AEAD-HKDF, which encrypts the plaintext stream with a StreamingAead
+// keyed with the symmetric key from the KEM. The DEM key template is the
+// template of an AesGcmHkdfStreamingKey or an AesCtrHmacStreamingKey, and the
+// corresponding key manager must be registered.
+class EciesAeadHkdfStreamingDemHelper {
+ public:
+  // Constructs a new helper for the specified DEM key template.
+  static crypto::tink::util::StatusOr<
+      std::unique_ptr<const EciesAeadHkdfStreamingDemHelper>>
+  New(const google::crypto::tink::KeyTemplate& dem_key_template);
+
+  virtual ~EciesAeadHkdfStreamingDemHelper() {}
+
+  // Returns the size of the DEM-key in bytes.
+  uint32_t dem_key_size_in_bytes() const { return key_size_in_bytes_; }
+
+  // Creates and returns a new StreamingAead object that uses the key material
+  // given in 'symmetric_key_value', which must be of length
+  // dem_key_size_in_bytes().
+  virtual crypto::tink::util::StatusOr<std::unique_ptr<StreamingAead>>
+  GetStreamingAead(const util::SecretData& symmetric_key_value) const = 0;
+
+ protected:
+  explicit EciesAeadHkdfStreamingDemHelper(uint32_t key_size_in_bytes)
+      : key_size_in_bytes_(key_size_in_bytes) {}
+
+ private:
+  const uint32_t key_size_in_bytes_;
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_HYBRID_ECIES_AEAD_HKDF_STREAMING_DEM_HELPER_H_
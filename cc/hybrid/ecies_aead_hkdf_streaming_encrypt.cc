@@ -0,0 +1,134 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/hybrid/ecies_aead_hkdf_streaming_encrypt.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "tink/output_stream.h"
+#include "tink/streaming_aead.h"
+#include "tink/util/enums.h"
+#include "tink/util/status.h"
+#include "proto/ecies_aead_hkdf.pb.h"
+
+using ::google::crypto::tink::EciesAeadHkdfPublicKey;
+using ::google::crypto::tink::EllipticCurveType;
+
+namespace crypto {
+namespace tink {
+
+namespace {
+
+util::Status Validate(const EciesAeadHkdfPublicKey& key) {
+  if (key.x().empty() || !key.has_params()) {
+    return util::Status(
+        util::error::INVALID_ARGUMENT,
+        "Invalid EciesAeadHkdfPublicKey: missing required fields.");
+  }
+
+  if (key.params().has_kem_params() &&
+      key.params().kem_params().curve_type() == EllipticCurveType::CURVE25519) {
+    if (!key.y().empty()) {
+      return util::Status(
+          util::error::INVALID_ARGUMENT,
+          "Invalid EciesAeadHkdfPublicKey: has unexpected field.");
+    }
+  } else if (key.y().empty()) {
+    return util::Status(
+        util::error::INVALID_ARGUMENT,
+        "Invalid EciesAeadHkdfPublicKey: missing required fields.");
+  }
+
+  return util::Status::OK;
+}
+
+// Writes 'contents' to 'output_stream'.
+util::Status WriteToStream(absl::string_view contents,
+                           OutputStream* output_stream) {
+  while (!contents.empty()) {
+    void* buffer;
+    auto next_result = output_stream->Next(&buffer);
+    if (!next_result.ok()) return next_result.status();
+    int count = std::min<int>(next_result.ValueOrDie(), contents.size());
+    std::memcpy(buffer, contents.data(), count);
+    output_stream->BackUp(next_result.ValueOrDie() - count);
+    contents.remove_prefix(count);
+  }
+  return util::Status::OK;
+}
+
+}  // namespace
+
+// static
+util::StatusOr<std::unique_ptr<StreamingHybridEncrypt>>
+EciesAeadHkdfStreamingEncrypt::New(
+    const EciesAeadHkdfPublicKey& recipient_key) {
+  util::Status status = Validate(recipient_key);
+  if (!status.ok()) return status;
+
+  auto kem_result = subtle::EciesHkdfSenderKemBoringSsl::New(
+      util::Enums::ProtoToSubtle(
+          recipient_key.params().kem_params().curve_type()),
+      recipient_key.x(), recipient_key.y());
+  if (!kem_result.ok()) return kem_result.status();
+
+  auto dem_result = EciesAeadHkdfStreamingDemHelper::New(
+      recipient_key.params().dem_params().aead_dem());
+  if (!dem_result.ok()) return dem_result.status();
+
+  return {absl::WrapUnique(new EciesAeadHkdfStreamingEncrypt(
+      recipient_key, std::move(kem_result).ValueOrDie(),
+      std::move(dem_result).ValueOrDie()))};
+}
+
+// The streams of the DEM do not refer to its StreamingAead, which is
+// therefore not kept beyond the creation of the stream.
+util::StatusOr<std::unique_ptr<OutputStream>>
+EciesAeadHkdfStreamingEncrypt::NewEncryptingStream(
+    std::unique_ptr<OutputStream> ciphertext_destination,
+    absl::string_view context_info) const {
+  if (ciphertext_destination == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_destination must be non-null");
+  }
+  // Use KEM to get a symmetric key.
+  auto kem_key_result = sender_kem_->GenerateKey(
+      util::Enums::ProtoToSubtle(
+          recipient_key_.params().kem_params().hkdf_hash_type()),
+      recipient_key_.params().kem_params().hkdf_salt(), context_info,
+      dem_helper_->dem_key_size_in_bytes(),
+      util::Enums::ProtoToSubtle(recipient_key_.params().ec_point_format()));
+  if (!kem_key_result.ok()) return kem_key_result.status();
+  auto kem_key = std::move(kem_key_result.ValueOrDie());
+
+  // Use the symmetric key to get a StreamingAead-primitive.
+  auto streaming_aead_result =
+      dem_helper_->GetStreamingAead(kem_key->get_symmetric_key());
+  if (!streaming_aead_result.ok()) return streaming_aead_result.status();
+
+  // Write the KEM bytes, followed by the stream encrypted with the DEM.
+  auto status = WriteToStream(kem_key->get_kem_bytes(),
+                              ciphertext_destination.get());
+  if (!status.ok()) return status;
+  return streaming_aead_result.ValueOrDie()->NewEncryptingStream(
+      std::move(ciphertext_destination), "");  // empty aad
+}
+
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,195 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/hybrid/ecies_aead_hkdf_streaming_encrypt.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/hybrid/ecies_aead_hkdf_streaming_decrypt.h"
+#include "tink/streamingaead/streaming_aead_config.h"
+#include "tink/streamingaead/streaming_aead_key_templates.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/istream_input_stream.h"
+#include "tink/util/ostream_output_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+#include "proto/common.pb.h"
+#include "proto/ecies_aead_hkdf.pb.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::google::crypto::tink::EciesAeadHkdfPrivateKey;
+using ::google::crypto::tink::EciesAeadHkdfPublicKey;
+using ::google::crypto::tink::EcPointFormat;
+using ::google::crypto::tink::EllipticCurveType;
+using ::google::crypto::tink::HashType;
+using ::google::crypto::tink::KeyTemplate;
+using ::testing::HasSubstr;
+
+// Returns a fresh ECIES key for the given curve, with 'dem_key_template' as
+// DEM key template.
+EciesAeadHkdfPrivateKey GetTestKey(EllipticCurveType curve_type,
+                                   EcPointFormat ec_point_format,
+                                   const KeyTemplate& dem_key_template) {
+  EciesAeadHkdfPrivateKey key = test::GetEciesAesGcmHkdfTestKey(
+      curve_type, ec_point_format, HashType::SHA256, 16);
+  *key.mutable_public_key()
+       ->mutable_params()
+       ->mutable_dem_params()
+       ->mutable_aead_dem() = dem_key_template;
+  return key;
+}
+
+// Encrypts 'plaintext' with 'encrypter', returning the ciphertext.
+util::StatusOr<std::string> Encrypt(const StreamingHybridEncrypt& encrypter,
+                                    absl::string_view plaintext,
+                                    absl::string_view context_info) {
+  auto ct_stream = absl::make_unique<std::stringstream>();
+  auto ct_buf = ct_stream.get();
+  auto enc_stream_result = encrypter.NewEncryptingStream(
+      absl::make_unique<util::OstreamOutputStream>(std::move(ct_stream)),
+      context_info);
+  if (!enc_stream_result.ok()) return enc_stream_result.status();
+  auto status = subtle::test::WriteToStream(
+      enc_stream_result.ValueOrDie().get(), plaintext);
+  if (!status.ok()) return status;
+  return ct_buf->str();
+}
+
+// Decrypts 'ciphertext' with 'decrypter', returning the plaintext.
+util::StatusOr<std::string> Decrypt(const StreamingHybridDecrypt& decrypter,
+                                    absl::string_view ciphertext,
+                                    absl::string_view context_info) {
+  auto dec_stream_result = decrypter.NewDecryptingStream(
+      absl::make_unique<util::IstreamInputStream>(
+          absl::make_unique<std::stringstream>(std::string(ciphertext))),
+      context_info);
+  if (!dec_stream_result.ok()) return dec_stream_result.status();
+  std::string plaintext;
+  auto status = subtle::test::ReadFromStream(
+      dec_stream_result.ValueOrDie().get(), &plaintext);
+  if (!status.ok()) return status;
+  return plaintext;
+}
+
+class EciesAeadHkdfStreamingEncryptTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_THAT(StreamingAeadConfig::Register(), IsOk());
+  }
+};
+
+TEST_F(EciesAeadHkdfStreamingEncryptTest, InvalidKeys) {
+  {  // No fields set.
+    EciesAeadHkdfPublicKey recipient_key;
+    EXPECT_THAT(EciesAeadHkdfStreamingEncrypt::New(recipient_key).status(),
+                StatusIs(util::error::INVALID_ARGUMENT,
+                         HasSubstr("missing required fields")));
+  }
+  {  // An AEAD instead of a streaming AEAD as DEM.
+    EciesAeadHkdfPrivateKey key =
+        GetTestKey(EllipticCurveType::NIST_P256, EcPointFormat::UNCOMPRESSED,
+                   AeadKeyTemplates::Aes128Gcm());
+    EXPECT_THAT(
+        EciesAeadHkdfStreamingEncrypt::New(key.public_key()).status(),
+        StatusIs(util::error::INVALID_ARGUMENT,
+                 HasSubstr("Unsupported streaming DEM key type")));
+  }
+}
+
+TEST_F(EciesAeadHkdfStreamingEncryptTest, EncryptDecrypt) {
+  struct TestCase {
+    EllipticCurveType curve;
+    EcPointFormat point_format;
+    KeyTemplate dem_key_template;
+  };
+  std::vector<TestCase> test_cases = {
+      {EllipticCurveType::NIST_P256, EcPointFormat::UNCOMPRESSED,
+       StreamingAeadKeyTemplates::Aes128GcmHkdf4KB()},
+      {EllipticCurveType::NIST_P384, EcPointFormat::COMPRESSED,
+       StreamingAeadKeyTemplates::Aes256GcmHkdf1MB()},
+      {EllipticCurveType::CURVE25519, EcPointFormat::COMPRESSED,
+       StreamingAeadKeyTemplates::Aes256GcmHkdf4KB()},
+  };
+  for (const TestCase& test_case : test_cases) {
+    EciesAeadHkdfPrivateKey key = GetTestKey(
+        test_case.curve, test_case.point_format, test_case.dem_key_template);
+    auto encrypt_result = EciesAeadHkdfStreamingEncrypt::New(key.public_key());
+    ASSERT_THAT(encrypt_result.status(), IsOk());
+    auto decrypt_result = EciesAeadHkdfStreamingDecrypt::New(key);
+    ASSERT_THAT(decrypt_result.status(), IsOk());
+    for (int plaintext_size : {0, 1, 1000, 10000, 100000}) {
+      SCOPED_TRACE(absl::StrCat("curve: ", test_case.curve,
+                                ", plaintext_size: ", plaintext_size));
+      std::string plaintext = subtle::Random::GetRandomBytes(plaintext_size);
+      std::string context_info = "some context info";
+      auto ciphertext_result =
+          Encrypt(*encrypt_result.ValueOrDie(), plaintext, context_info);
+      ASSERT_THAT(ciphertext_result.status(), IsOk());
+      EXPECT_GT(ciphertext_result.ValueOrDie().size(), plaintext.size());
+      auto plaintext_result = Decrypt(*decrypt_result.ValueOrDie(),
+                                      ciphertext_result.ValueOrDie(),
+                                      context_info);
+      ASSERT_THAT(plaintext_result.status(), IsOk());
+      EXPECT_EQ(plaintext, plaintext_result.ValueOrDie());
+    }
+  }
+}
+
+TEST_F(EciesAeadHkdfStreamingEncryptTest, FreshKeyPerStream) {
+  EciesAeadHkdfPrivateKey key =
+      GetTestKey(EllipticCurveType::NIST_P256, EcPointFormat::UNCOMPRESSED,
+                 StreamingAeadKeyTemplates::Aes128GcmHkdf4KB());
+  auto encrypt_result = EciesAeadHkdfStreamingEncrypt::New(key.public_key());
+  ASSERT_THAT(encrypt_result.status(), IsOk());
+  auto ciphertext1 = Encrypt(*encrypt_result.ValueOrDie(), "plaintext", "");
+  auto ciphertext2 = Encrypt(*encrypt_result.ValueOrDie(), "plaintext", "");
+  ASSERT_THAT(ciphertext1.status(), IsOk());
+  ASSERT_THAT(ciphertext2.status(), IsOk());
+  // The uncompressed P-256 point of the ephemeral key comes first.
+  EXPECT_NE(ciphertext1.ValueOrDie().substr(0, 65),
+            ciphertext2.ValueOrDie().substr(0, 65));
+}
+
+TEST_F(EciesAeadHkdfStreamingEncryptTest, NullDestination) {
+  EciesAeadHkdfPrivateKey key =
+      GetTestKey(EllipticCurveType::NIST_P256, EcPointFormat::UNCOMPRESSED,
+                 StreamingAeadKeyTemplates::Aes128GcmHkdf4KB());
+  auto encrypt_result = EciesAeadHkdfStreamingEncrypt::New(key.public_key());
+  ASSERT_THAT(encrypt_result.status(), IsOk());
+  EXPECT_THAT(
+      encrypt_result.ValueOrDie()->NewEncryptingStream(nullptr, "").status(),
+      StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -25,6 +25,9 @@
 #include "tink/registry.h"
 #include "tink/hybrid/hybrid_decrypt_wrapper.h"
 #include "tink/hybrid/hybrid_encrypt_wrapper.h"
+#include "tink/hybrid/streaming_hybrid_decrypt_wrapper.h"
+#include "tink/hybrid/streaming_hybrid_encrypt_wrapper.h"
+#include "tink/streamingaead/streaming_aead_config.h"
 #include "tink/util/status.h"
 #include "proto/config.pb.h"
 
@@ -50,6 +53,12 @@ util::Status HybridConfig::Register() {
   status = Registry::RegisterPrimitiveWrapper(
       absl::make_unique<HybridDecryptWrapper>());
   if (!status.ok()) return status;
+  status = Registry::RegisterPrimitiveWrapper(
+      absl::make_unique<StreamingHybridEncryptWrapper>());
+  if (!status.ok()) return status;
+  status = Registry::RegisterPrimitiveWrapper(
+      absl::make_unique<StreamingHybridDecryptWrapper>());
+  if (!status.ok()) return status;
 
   // Currently there are no hybrid encryption key managers which only use
   // FIPS-validated implementations, therefore none will be registered in
@@ -58,7 +67,9 @@ util::Status HybridConfig::Register() {
     return util::OkStatus();
   }
 
-  // Register non-FIPS key managers.
+  // Register non-FIPS key managers. The streaming AEAD key managers provide
+  // the DEM of streaming hybrid encryption.
+  status = StreamingAeadConfig::Register();
   if (!status.ok()) return status;
   status = Registry::RegisterAsymmetricKeyManagers(
       absl::make_unique<EciesAeadHkdfPrivateKeyManager>(),
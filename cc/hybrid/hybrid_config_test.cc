@@ -17,6 +17,9 @@
 #include "tink/hybrid/hybrid_config.h"
 
 #include <list>
+#include <sstream>
+#include <string>
+#include <utility>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -29,6 +32,11 @@
 #include "tink/hybrid_encrypt.h"
 #include "tink/keyset_handle.h"
 #include "tink/registry.h"
+#include "tink/streaming_hybrid_decrypt.h"
+#include "tink/streaming_hybrid_encrypt.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/istream_input_stream.h"
+#include "tink/util/ostream_output_stream.h"
 #include "tink/util/status.h"
 #include "tink/util/test_matchers.h"
 #include "tink/util/test_util.h"
@@ -143,6 +151,49 @@ TEST_F(HybridConfigTest, DecryptWrapperRegistered) {
             "secret");
 }
 
+// Tests streaming hybrid encryption with the keysets of a public and the
+// corresponding private key.
+TEST_F(HybridConfigTest, StreamingHybridKeysets) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+
+  ASSERT_THAT(HybridConfig::Register(), IsOk());
+  auto private_handle_result = KeysetHandle::GenerateNew(
+      HybridKeyTemplates::EciesP256HkdfHmacSha256Aes128GcmHkdf4KB());
+  ASSERT_THAT(private_handle_result.status(), IsOk());
+  auto public_handle_result =
+      private_handle_result.ValueOrDie()->GetPublicKeysetHandle();
+  ASSERT_THAT(public_handle_result.status(), IsOk());
+
+  auto encrypt_result = public_handle_result.ValueOrDie()
+                            ->GetPrimitive<StreamingHybridEncrypt>();
+  ASSERT_THAT(encrypt_result.status(), IsOk());
+  auto ct_stream = absl::make_unique<std::stringstream>();
+  auto ct_buf = ct_stream.get();
+  auto enc_stream_result = encrypt_result.ValueOrDie()->NewEncryptingStream(
+      absl::make_unique<util::OstreamOutputStream>(std::move(ct_stream)),
+      "context");
+  ASSERT_THAT(enc_stream_result.status(), IsOk());
+  ASSERT_THAT(subtle::test::WriteToStream(enc_stream_result.ValueOrDie().get(),
+                                          "some plaintext"),
+              IsOk());
+
+  auto decrypt_result = private_handle_result.ValueOrDie()
+                            ->GetPrimitive<StreamingHybridDecrypt>();
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  auto dec_stream_result = decrypt_result.ValueOrDie()->NewDecryptingStream(
+      absl::make_unique<util::IstreamInputStream>(
+          absl::make_unique<std::stringstream>(ct_buf->str())),
+      "context");
+  ASSERT_THAT(dec_stream_result.status(), IsOk());
+  std::string plaintext;
+  ASSERT_THAT(subtle::test::ReadFromStream(
+                  dec_stream_result.ValueOrDie().get(), &plaintext),
+              IsOk());
+  EXPECT_EQ(plaintext, "some plaintext");
+}
+
 // FIPS-only mode tests
 TEST_F(HybridConfigTest, RegisterNonFipsTemplates) {
   if (!kUseOnlyFips) {
@@ -16,8 +16,17 @@
 
 #include "tink/hybrid/hybrid_decrypt_wrapper.h"
 
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tink/crypto_format.h"
 #include "tink/hybrid_decrypt.h"
+#include "tink/monitoring_client.h"
 #include "tink/primitive_set.h"
 #include "tink/subtle/subtle_util_boringssl.h"
 #include "tink/util/status.h"
@@ -38,9 +47,27 @@ class HybridDecryptSetWrapper : public HybridDecrypt {
       absl::string_view ciphertext,
       absl::string_view context_info) const override;
 
+  std::vector<crypto::tink::util::StatusOr<std::string>> DecryptBatch(
+      absl::Span<const absl::string_view> ciphertexts,
+      absl::Span<const absl::string_view> context_info,
+      int num_threads) const override;
+
   ~HybridDecryptSetWrapper() override {}
 
  private:
+  using Entry = PrimitiveSet<HybridDecrypt>::Entry<HybridDecrypt>;
+
+  // Decrypts the ciphertexts of the batch at 'indices', without their first
+  // 'prefix_size' bytes, with 'entry'. Stores the plaintexts and the key id
+  // for the ciphertexts that decrypt, and returns the indices of the others.
+  std::vector<int64_t> DecryptWithEntry(
+      const Entry& entry, size_t prefix_size,
+      const std::vector<int64_t>& indices,
+      absl::Span<const absl::string_view> ciphertexts,
+      absl::Span<const absl::string_view> context_info, int num_threads,
+      std::vector<crypto::tink::util::StatusOr<std::string>>* plaintexts,
+      absl::flat_hash_map<uint32_t, int64_t>* key_counts) const;
+
   std::unique_ptr<PrimitiveSet<HybridDecrypt>> hybrid_decrypt_set_;
 };
 
@@ -49,19 +76,22 @@ util::StatusOr<std::string> HybridDecryptSetWrapper::Decrypt(
   // BoringSSL expects a non-null pointer for context_info,
   // regardless of whether the size is 0.
   context_info = subtle::SubtleUtilBoringSSL::EnsureNonNull(context_info);
+  internal::MonitoredOperation monitored("hybrid_decrypt", "decrypt",
+                                         ciphertext.size());
 
   if (ciphertext.length() > CryptoFormat::kNonRawPrefixSize) {
     absl::string_view key_id =
         ciphertext.substr(0, CryptoFormat::kNonRawPrefixSize);
-    auto primitives_result = hybrid_decrypt_set_->get_primitives(key_id);
-    if (primitives_result.ok()) {
+    const auto* primitives = hybrid_decrypt_set_->find_primitives(key_id);
+    if (primitives != nullptr) {
       absl::string_view raw_ciphertext =
           ciphertext.substr(CryptoFormat::kNonRawPrefixSize);
-      for (auto& hybrid_decrypt_entry : *(primitives_result.ValueOrDie())) {
+      for (auto& hybrid_decrypt_entry : *primitives) {
         HybridDecrypt& hybrid_decrypt = hybrid_decrypt_entry->get_primitive();
         auto decrypt_result =
             hybrid_decrypt.Decrypt(raw_ciphertext, context_info);
         if (decrypt_result.ok()) {
+          monitored.Success(hybrid_decrypt_entry->get_key_id());
           return std::move(decrypt_result.ValueOrDie());
         } else {
           // LOG that a matching key didn't decrypt the ciphertext.
@@ -71,17 +101,136 @@ util::StatusOr<std::string> HybridDecryptSetWrapper::Decrypt(
   }
 
   // No matching key succeeded with decryption, try all RAW keys.
-  auto raw_primitives_result = hybrid_decrypt_set_->get_raw_primitives();
-  if (raw_primitives_result.ok()) {
-    for (auto& hybrid_decrypt_entry : *(raw_primitives_result.ValueOrDie())) {
+  const auto* raw_primitives = hybrid_decrypt_set_->find_raw_primitives();
+  if (raw_primitives != nullptr) {
+    for (auto& hybrid_decrypt_entry : *raw_primitives) {
         HybridDecrypt& hybrid_decrypt = hybrid_decrypt_entry->get_primitive();
       auto decrypt_result = hybrid_decrypt.Decrypt(ciphertext, context_info);
       if (decrypt_result.ok()) {
+        monitored.Success(hybrid_decrypt_entry->get_key_id());
         return std::move(decrypt_result.ValueOrDie());
       }
     }
   }
-  return util::Status(util::error::INVALID_ARGUMENT, "decryption failed");
+  static const util::Status* kDecryptionFailed =
+      util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                              "decryption failed");
+  return *kDecryptionFailed;
+}
+
+std::vector<int64_t> HybridDecryptSetWrapper::DecryptWithEntry(
+    const Entry& entry, size_t prefix_size, const std::vector<int64_t>& indices,
+    absl::Span<const absl::string_view> ciphertexts,
+    absl::Span<const absl::string_view> context_info, int num_threads,
+    std::vector<util::StatusOr<std::string>>* plaintexts,
+    absl::flat_hash_map<uint32_t, int64_t>* key_counts) const {
+  std::vector<absl::string_view> entry_ciphertexts;
+  std::vector<absl::string_view> entry_context_info;
+  entry_ciphertexts.reserve(indices.size());
+  entry_context_info.reserve(indices.size());
+  for (int64_t i : indices) {
+    entry_ciphertexts.push_back(ciphertexts[i].substr(prefix_size));
+    entry_context_info.push_back(context_info[i]);
+  }
+  std::vector<util::StatusOr<std::string>> entry_plaintexts =
+      entry.get_primitive().DecryptBatch(entry_ciphertexts, entry_context_info,
+                                         num_threads);
+  std::vector<int64_t> failed;
+  for (size_t j = 0; j < indices.size(); j++) {
+    if (j < entry_plaintexts.size() && entry_plaintexts[j].ok()) {
+      (*plaintexts)[indices[j]] = std::move(entry_plaintexts[j]);
+      (*key_counts)[entry.get_key_id()]++;
+    } else {
+      failed.push_back(indices[j]);
+    }
+  }
+  return failed;
+}
+
+std::vector<util::StatusOr<std::string>> HybridDecryptSetWrapper::DecryptBatch(
+    absl::Span<const absl::string_view> ciphertexts,
+    absl::Span<const absl::string_view> context_info, int num_threads) const {
+  if (ciphertexts.size() != context_info.size()) {
+    return HybridDecrypt::DecryptBatch(ciphertexts, context_info, num_threads);
+  }
+  int64_t num_bytes = 0;
+  for (absl::string_view ciphertext : ciphertexts) {
+    num_bytes += ciphertext.size();
+  }
+  internal::MonitoredOperation monitored("hybrid_decrypt", "decrypt_batch",
+                                         num_bytes);
+
+  // BoringSSL expects a non-null pointer for context_info,
+  // regardless of whether the size is 0.
+  std::vector<absl::string_view> non_null_context_info;
+  non_null_context_info.reserve(context_info.size());
+  for (absl::string_view element : context_info) {
+    non_null_context_info.push_back(
+        subtle::SubtleUtilBoringSSL::EnsureNonNull(element));
+  }
+
+  // The ciphertexts are grouped by output prefix, so that the keys of each
+  // prefix are looked up once and decrypt all of its ciphertexts in a single
+  // DecryptBatch() call. Like Decrypt(), each ciphertext is tried with the
+  // keys of its prefix, then with the RAW keys.
+  std::vector<util::StatusOr<std::string>> plaintexts(ciphertexts.size());
+  absl::flat_hash_map<uint32_t, int64_t> key_counts;
+  absl::flat_hash_map<absl::string_view, std::vector<int64_t>> by_prefix;
+  std::vector<int64_t> raw_pending;
+  for (size_t i = 0; i < ciphertexts.size(); i++) {
+    if (ciphertexts[i].length() > CryptoFormat::kNonRawPrefixSize) {
+      by_prefix[ciphertexts[i].substr(0, CryptoFormat::kNonRawPrefixSize)]
+          .push_back(i);
+    } else {
+      raw_pending.push_back(i);
+    }
+  }
+  for (auto& prefix_and_indices : by_prefix) {
+    std::vector<int64_t> pending = std::move(prefix_and_indices.second);
+    const auto* primitives =
+        hybrid_decrypt_set_->find_primitives(prefix_and_indices.first);
+    if (primitives != nullptr) {
+      for (auto& hybrid_decrypt_entry : *primitives) {
+        if (pending.empty()) break;
+        pending = DecryptWithEntry(
+            *hybrid_decrypt_entry, CryptoFormat::kNonRawPrefixSize, pending,
+            ciphertexts, non_null_context_info, num_threads, &plaintexts,
+            &key_counts);
+      }
+    }
+    raw_pending.insert(raw_pending.end(), pending.begin(), pending.end());
+  }
+
+  // No matching key succeeded with decryption, try all RAW keys.
+  const auto* raw_primitives = hybrid_decrypt_set_->find_raw_primitives();
+  if (raw_primitives != nullptr) {
+    for (auto& hybrid_decrypt_entry : *raw_primitives) {
+      if (raw_pending.empty()) break;
+      raw_pending = DecryptWithEntry(
+          *hybrid_decrypt_entry, CryptoFormat::kRawPrefixSize, raw_pending,
+          ciphertexts, non_null_context_info, num_threads, &plaintexts,
+          &key_counts);
+    }
+  }
+  static const util::Status* kDecryptionFailed =
+      util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                              "decryption failed");
+  for (int64_t i : raw_pending) plaintexts[i] = *kDecryptionFailed;
+
+  // The batch is reported as one operation, which succeeds if all
+  // ciphertexts decrypt, by the key that decrypted most of them.
+  if (raw_pending.empty()) {
+    uint32_t key_id = hybrid_decrypt_set_->get_primary()->get_key_id();
+    int64_t max_count = 0;
+    for (const auto& key_and_count : key_counts) {
+      if (key_and_count.second > max_count) {
+        key_id = key_and_count.first;
+        max_count = key_and_count.second;
+      }
+    }
+    monitored.Success(key_id);
+  }
+  return plaintexts;
 }
 
 util::Status Validate(PrimitiveSet<HybridDecrypt>* hybrid_decrypt_set) {
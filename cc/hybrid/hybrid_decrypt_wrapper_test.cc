@@ -16,7 +16,13 @@
 
 #include "tink/hybrid/hybrid_decrypt_wrapper.h"
 
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "tink/hybrid_decrypt.h"
 #include "tink/primitive_set.h"
 #include "tink/util/status.h"
@@ -27,6 +33,7 @@
 using ::crypto::tink::test::DummyHybridDecrypt;
 using ::crypto::tink::test::DummyHybridEncrypt;
 using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
 using ::google::crypto::tink::KeysetInfo;
 using ::google::crypto::tink::KeyStatusType;
 using ::google::crypto::tink::OutputPrefixType;
@@ -160,6 +167,81 @@ TEST_F(HybridDecryptSetWrapperTest, Basic) {
   }
 }
 
+TEST_F(HybridDecryptSetWrapperTest, DecryptBatch) {
+  KeysetInfo keyset;
+  KeysetInfo::KeyInfo* key = keyset.add_key_info();
+  key->set_output_prefix_type(OutputPrefixType::RAW);
+  key->set_key_id(1234543);
+  key->set_status(KeyStatusType::ENABLED);
+  key = keyset.add_key_info();
+  key->set_output_prefix_type(OutputPrefixType::TINK);
+  key->set_key_id(7213743);
+  key->set_status(KeyStatusType::ENABLED);
+
+  auto hybrid_decrypt_set = absl::make_unique<PrimitiveSet<HybridDecrypt>>();
+  auto entry_result = hybrid_decrypt_set->AddPrimitive(
+      absl::make_unique<DummyHybridDecrypt>("raw"), keyset.key_info(0));
+  ASSERT_THAT(entry_result.status(), IsOk());
+  entry_result = hybrid_decrypt_set->AddPrimitive(
+      absl::make_unique<DummyHybridDecrypt>("tink"), keyset.key_info(1));
+  ASSERT_THAT(entry_result.status(), IsOk());
+  std::string tink_prefix = entry_result.ValueOrDie()->get_identifier();
+  ASSERT_THAT(hybrid_decrypt_set->set_primary(entry_result.ValueOrDie()),
+              IsOk());
+  auto hybrid_decrypt_result =
+      HybridDecryptWrapper().Wrap(std::move(hybrid_decrypt_set));
+  ASSERT_THAT(hybrid_decrypt_result.status(), IsOk());
+  std::unique_ptr<HybridDecrypt> hybrid_decrypt =
+      std::move(hybrid_decrypt_result.ValueOrDie());
+
+  // Ciphertexts of both keys, where every fifth one is decrypted with the
+  // wrong context_info, and a ciphertext of no key.
+  std::vector<std::string> ciphertexts;
+  std::vector<std::string> contexts;
+  for (int i = 0; i < 20; i++) {
+    std::string plaintext = absl::StrCat("plaintext ", i);
+    std::string context = absl::StrCat("context ", i % 3);
+    if (i % 2 == 0) {
+      ciphertexts.push_back(absl::StrCat(
+          tink_prefix,
+          DummyHybridEncrypt("tink").Encrypt(plaintext, context).ValueOrDie()));
+    } else {
+      ciphertexts.push_back(
+          DummyHybridEncrypt("raw").Encrypt(plaintext, context).ValueOrDie());
+    }
+    contexts.push_back(i % 5 == 4 ? "other context" : context);
+  }
+  ciphertexts.push_back("bad");
+  contexts.push_back("");
+  std::vector<absl::string_view> ciphertext_views(ciphertexts.begin(),
+                                                  ciphertexts.end());
+  std::vector<absl::string_view> context_info(contexts.begin(),
+                                              contexts.end());
+
+  for (int num_threads : {1, 4}) {
+    std::vector<util::StatusOr<std::string>> plaintexts =
+        hybrid_decrypt->DecryptBatch(ciphertext_views, context_info,
+                                     num_threads);
+    ASSERT_EQ(ciphertexts.size(), plaintexts.size());
+    for (int i = 0; i < 20; i++) {
+      if (i % 5 == 4) {
+        EXPECT_THAT(plaintexts[i].status(),
+                    StatusIs(util::error::INVALID_ARGUMENT));
+      } else {
+        ASSERT_THAT(plaintexts[i].status(), IsOk());
+        EXPECT_EQ(absl::StrCat("plaintext ", i), plaintexts[i].ValueOrDie());
+      }
+    }
+    EXPECT_THAT(plaintexts.back().status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+
+  std::vector<util::StatusOr<std::string>> plaintexts =
+      hybrid_decrypt->DecryptBatch(ciphertext_views, {}, 1);
+  ASSERT_EQ(ciphertexts.size(), plaintexts.size());
+  EXPECT_THAT(plaintexts[0].status(), StatusIs(util::error::INVALID_ARGUMENT));
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
@@ -18,6 +18,7 @@
 
 #include "tink/crypto_format.h"
 #include "tink/hybrid_encrypt.h"
+#include "tink/monitoring_client.h"
 #include "tink/primitive_set.h"
 #include "tink/subtle/subtle_util_boringssl.h"
 #include "tink/util/status.h"
@@ -66,11 +67,14 @@ util::StatusOr<std::string> HybridEncryptSetWrapper::Encrypt(
   // regardless of whether the size is 0.
   plaintext = subtle::SubtleUtilBoringSSL::EnsureNonNull(plaintext);
   context_info = subtle::SubtleUtilBoringSSL::EnsureNonNull(context_info);
+  internal::MonitoredOperation monitored("hybrid_encrypt", "encrypt",
+                                         plaintext.size());
 
   auto primary = hybrid_encrypt_set_->get_primary();
   auto encrypt_result =
       primary->get_primitive().Encrypt(plaintext, context_info);
   if (!encrypt_result.ok()) return encrypt_result.status();
+  monitored.Success(primary->get_key_id());
   const std::string& key_id = primary->get_identifier();
   return key_id + encrypt_result.ValueOrDie();
 }
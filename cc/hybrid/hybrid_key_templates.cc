@@ -19,6 +19,7 @@
 #include "absl/strings/string_view.h"
 #include "tink/aead/aead_key_templates.h"
 #include "tink/daead/deterministic_aead_key_templates.h"
+#include "tink/streamingaead/streaming_aead_key_templates.h"
 #include "proto/common.pb.h"
 #include "proto/ecies_aead_hkdf.pb.h"
 #include "proto/tink.pb.h"
@@ -163,5 +164,16 @@ HybridKeyTemplates::EciesX25519HkdfHmacSha256DeterministicAesSiv() {
   return *key_template;
 }
 
+// static
+const KeyTemplate&
+HybridKeyTemplates::EciesP256HkdfHmacSha256Aes128GcmHkdf4KB() {
+  static const KeyTemplate* key_template = NewEciesAeadHkdfKeyTemplate(
+      EllipticCurveType::NIST_P256, HashType::SHA256,
+      EcPointFormat::UNCOMPRESSED, StreamingAeadKeyTemplates::Aes128GcmHkdf4KB(),
+      OutputPrefixType::RAW,
+      /* hkdf_salt= */ "");
+  return *key_template;
+}
+
 }  // namespace tink
 }  // namespace crypto
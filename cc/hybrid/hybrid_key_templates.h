@@ -34,6 +34,12 @@ namespace tink {
 //        HybridKeyTemplates::EciesP256HkdfHmacSha256Aes128Gcm());
 //   if (!handle_result.ok()) { /* fail with error */ }
 //   auto keyset_handle = std::move(handle_result.ValueOrDie());
+//
+// For short messages the cost of hybrid encryption and decryption is
+// dominated by the KEM. The X25519 templates avoid the point encoding,
+// decoding and validation of the NIST P-curves, and are the faster choice
+// where all parties support them; benchmarks/hybrid_benchmark.cc compares
+// both.
 class HybridKeyTemplates {
  public:
   // Returns a KeyTemplate that generates new instances of
@@ -139,6 +145,19 @@ class HybridKeyTemplates {
   //   - OutputPrefixType: TINK
   static const google::crypto::tink::KeyTemplate&
   EciesX25519HkdfHmacSha256DeterministicAesSiv();
+
+  // Returns a KeyTemplate that generates new instances of
+  // EciesAeadHkdfPrivateKey for streaming hybrid encryption
+  // (StreamingHybridEncrypt and StreamingHybridDecrypt), with the following
+  // parameters:
+  //   - KEM: ECDH over NIST P-256
+  //   - DEM: AES128-GCM-HKDF streaming with 4KB ciphertext segments
+  //          (cf. StreamingAeadKeyTemplates::Aes128GcmHkdf4KB())
+  //   - KDF: HKDF-HMAC-SHA256 with an empty salt
+  //   - EC Point Format: Uncompressed
+  //   - OutputPrefixType: RAW
+  static const google::crypto::tink::KeyTemplate&
+  EciesP256HkdfHmacSha256Aes128GcmHkdf4KB();
 };
 
 }  // namespace tink
@@ -0,0 +1,111 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/hybrid/multi_recipient_hybrid_decrypt.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tink/aead.h"
+#include "tink/subtle/aes_gcm_boringssl.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+
+namespace crypto {
+namespace tink {
+
+namespace {
+
+constexpr char kFormatVersion = 0x01;
+constexpr int kMessageKeySizeInBytes = 32;
+
+// Reads a big endian uint32_t from the start of 'input' and removes it from
+// 'input'. Returns false if 'input' is shorter than 4 bytes.
+bool ReadBigEndian32(absl::string_view* input, uint32_t* value) {
+  if (input->size() < 4) return false;
+  *value = 0;
+  for (int i = 0; i < 4; i++) {
+    *value = (*value << 8) | static_cast<uint8_t>((*input)[i]);
+  }
+  input->remove_prefix(4);
+  return true;
+}
+
+}  // namespace
+
+// static
+util::StatusOr<std::unique_ptr<HybridDecrypt>>
+MultiRecipientHybridDecrypt::New(std::unique_ptr<HybridDecrypt> recipient) {
+  if (recipient == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "recipient must not be nullptr");
+  }
+  return {absl::WrapUnique(new MultiRecipientHybridDecrypt(
+      std::move(recipient)))};
+}
+
+util::StatusOr<std::string> MultiRecipientHybridDecrypt::Decrypt(
+    absl::string_view ciphertext, absl::string_view context_info) const {
+  absl::string_view rest = ciphertext;
+  if (rest.empty() || rest[0] != kFormatVersion) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "unknown ciphertext format");
+  }
+  rest.remove_prefix(1);
+  uint32_t num_keys;
+  if (!ReadBigEndian32(&rest, &num_keys)) {
+    return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too short");
+  }
+
+  util::SecretData message_key;
+  for (uint32_t i = 0; i < num_keys; i++) {
+    uint32_t encrypted_key_size;
+    if (!ReadBigEndian32(&rest, &encrypted_key_size) ||
+        rest.size() < encrypted_key_size) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "ciphertext too short");
+    }
+    absl::string_view encrypted_key = rest.substr(0, encrypted_key_size);
+    rest.remove_prefix(encrypted_key_size);
+    // Keep parsing after a success, so that the offset of the message does
+    // not depend on which key this recipient could decrypt.
+    if (!message_key.empty()) continue;
+    auto key_result = recipient_->Decrypt(encrypted_key, context_info);
+    if (key_result.ok() &&
+        key_result.ValueOrDie().size() == kMessageKeySizeInBytes) {
+      message_key = util::SecretDataFromStringView(key_result.ValueOrDie());
+      util::SafeZeroString(&key_result.ValueOrDie());
+    }
+  }
+  if (message_key.empty()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "no message key could be decrypted");
+  }
+
+  auto aead_result = subtle::AesGcmBoringSsl::New(message_key);
+  if (!aead_result.ok()) return aead_result.status();
+  absl::string_view header =
+      ciphertext.substr(0, ciphertext.size() - rest.size());
+  return aead_result.ValueOrDie()->Decrypt(
+      rest, absl::StrCat(header, context_info));
+}
+
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,55 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_HYBRID_MULTI_RECIPIENT_HYBRID_DECRYPT_H_
+#define TINK_HYBRID_MULTI_RECIPIENT_HYBRID_DECRYPT_H_
+
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "tink/hybrid_decrypt.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+// Decrypts ciphertexts of MultiRecipientHybridEncrypt for one of their
+// recipients. Each of the encrypted message keys is decrypted with the
+// recipient's HybridDecrypt until one succeeds; the message is then
+// decrypted with that key.
+class MultiRecipientHybridDecrypt : public HybridDecrypt {
+ public:
+  // 'recipient' must not be nullptr. Typically it is the HybridDecrypt
+  // primitive of the recipient's private keyset.
+  static crypto::tink::util::StatusOr<std::unique_ptr<HybridDecrypt>> New(
+      std::unique_ptr<HybridDecrypt> recipient);
+
+  crypto::tink::util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view context_info) const override;
+
+ private:
+  explicit MultiRecipientHybridDecrypt(std::unique_ptr<HybridDecrypt> recipient)
+      : recipient_(std::move(recipient)) {}
+
+  const std::unique_ptr<HybridDecrypt> recipient_;
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_HYBRID_MULTI_RECIPIENT_HYBRID_DECRYPT_H_
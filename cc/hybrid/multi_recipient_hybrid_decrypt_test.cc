@@ -0,0 +1,126 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/hybrid/multi_recipient_hybrid_decrypt.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "tink/hybrid/multi_recipient_hybrid_encrypt.h"
+#include "tink/hybrid_decrypt.h"
+#include "tink/hybrid_encrypt.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::DummyHybridDecrypt;
+using ::crypto::tink::test::DummyHybridEncrypt;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::testing::Eq;
+using ::testing::Not;
+
+class MultiRecipientHybridDecryptTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::vector<std::unique_ptr<HybridEncrypt>> recipients;
+    recipients.push_back(absl::make_unique<DummyHybridEncrypt>("alice"));
+    recipients.push_back(absl::make_unique<DummyHybridEncrypt>("bob"));
+    auto encrypt_result =
+        MultiRecipientHybridEncrypt::New(std::move(recipients));
+    ASSERT_THAT(encrypt_result.status(), IsOk());
+    auto ciphertext_result =
+        encrypt_result.ValueOrDie()->Encrypt(kPlaintext, kContextInfo);
+    ASSERT_THAT(ciphertext_result.status(), IsOk());
+    ciphertext_ = ciphertext_result.ValueOrDie();
+
+    auto decrypt_result = MultiRecipientHybridDecrypt::New(
+        absl::make_unique<DummyHybridDecrypt>("bob"));
+    ASSERT_THAT(decrypt_result.status(), IsOk());
+    decrypt_ = std::move(decrypt_result.ValueOrDie());
+  }
+
+  static constexpr char kPlaintext[] = "some plaintext";
+  static constexpr char kContextInfo[] = "some context info";
+  std::string ciphertext_;
+  std::unique_ptr<HybridDecrypt> decrypt_;
+};
+
+constexpr char MultiRecipientHybridDecryptTest::kPlaintext[];
+constexpr char MultiRecipientHybridDecryptTest::kContextInfo[];
+
+TEST_F(MultiRecipientHybridDecryptTest, NewWithNullRecipient) {
+  EXPECT_THAT(MultiRecipientHybridDecrypt::New(nullptr).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(MultiRecipientHybridDecryptTest, Decrypt) {
+  auto result = decrypt_->Decrypt(ciphertext_, kContextInfo);
+  ASSERT_THAT(result.status(), IsOk());
+  EXPECT_THAT(result.ValueOrDie(), Eq(kPlaintext));
+}
+
+TEST_F(MultiRecipientHybridDecryptTest, WrongContextInfo) {
+  EXPECT_THAT(decrypt_->Decrypt(ciphertext_, "other context info").status(),
+              Not(IsOk()));
+}
+
+TEST_F(MultiRecipientHybridDecryptTest, ModifiedCiphertext) {
+  for (size_t i = 0; i < ciphertext_.size(); i++) {
+    std::string modified = ciphertext_;
+    modified[i] ^= 1;
+    EXPECT_THAT(decrypt_->Decrypt(modified, kContextInfo).status(),
+                Not(IsOk()))
+        << "modified byte " << i;
+  }
+}
+
+TEST_F(MultiRecipientHybridDecryptTest, TruncatedCiphertext) {
+  for (size_t size = 0; size < ciphertext_.size(); size++) {
+    EXPECT_THAT(
+        decrypt_->Decrypt(ciphertext_.substr(0, size), kContextInfo).status(),
+        Not(IsOk()))
+        << "size " << size;
+  }
+}
+
+TEST_F(MultiRecipientHybridDecryptTest, UnknownVersion) {
+  std::string modified = ciphertext_;
+  modified[0] = 0x02;
+  EXPECT_THAT(decrypt_->Decrypt(modified, kContextInfo).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(MultiRecipientHybridDecryptTest, TooManyEncryptedKeys) {
+  std::string modified = ciphertext_;
+  modified[1] = 0x7f;
+  EXPECT_THAT(decrypt_->Decrypt(modified, kContextInfo).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,86 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/hybrid/multi_recipient_hybrid_encrypt.h"
+
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tink/aead.h"
+#include "tink/subtle/aes_gcm_boringssl.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/subtle_util.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+
+namespace crypto {
+namespace tink {
+
+namespace {
+
+constexpr char kFormatVersion = 0x01;
+constexpr int kMessageKeySizeInBytes = 32;
+
+}  // namespace
+
+// static
+util::StatusOr<std::unique_ptr<HybridEncrypt>>
+MultiRecipientHybridEncrypt::New(
+    std::vector<std::unique_ptr<HybridEncrypt>> recipients) {
+  if (recipients.empty()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "recipients must not be empty");
+  }
+  for (const auto& recipient : recipients) {
+    if (recipient == nullptr) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "recipients must not contain nullptr");
+    }
+  }
+  return {absl::WrapUnique(
+      new MultiRecipientHybridEncrypt(std::move(recipients)))};
+}
+
+util::StatusOr<std::string> MultiRecipientHybridEncrypt::Encrypt(
+    absl::string_view plaintext, absl::string_view context_info) const {
+  util::SecretData message_key =
+      subtle::Random::GetRandomKeyBytes(kMessageKeySizeInBytes);
+  auto aead_result = subtle::AesGcmBoringSsl::New(message_key);
+  if (!aead_result.ok()) return aead_result.status();
+
+  std::string header(1, kFormatVersion);
+  header.append(subtle::BigEndian32(recipients_.size()));
+  for (const auto& recipient : recipients_) {
+    auto encrypted_key_result = recipient->Encrypt(
+        util::SecretDataAsStringView(message_key), context_info);
+    if (!encrypted_key_result.ok()) return encrypted_key_result.status();
+    const std::string& encrypted_key = encrypted_key_result.ValueOrDie();
+    absl::StrAppend(&header, subtle::BigEndian32(encrypted_key.size()),
+                    encrypted_key);
+  }
+
+  auto ciphertext_result = aead_result.ValueOrDie()->Encrypt(
+      plaintext, absl::StrCat(header, context_info));
+  if (!ciphertext_result.ok()) return ciphertext_result.status();
+  header.append(ciphertext_result.ValueOrDie());
+  return header;
+}
+
+}  // namespace tink
+}  // namespace crypto
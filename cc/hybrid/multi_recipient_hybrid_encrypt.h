@@ -0,0 +1,76 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_HYBRID_MULTI_RECIPIENT_HYBRID_ENCRYPT_H_
+#define TINK_HYBRID_MULTI_RECIPIENT_HYBRID_ENCRYPT_H_
+
+#include <memory>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tink/hybrid_encrypt.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+// Encrypts a message once for several recipients. The message is encrypted
+// with AES256-GCM under a fresh random key, and only that key is encrypted
+// for each recipient, with the recipient's HybridEncrypt. This makes the cost
+// of encrypting for n recipients one encryption of the message plus n
+// hybrid encryptions of a 32-byte key, instead of n hybrid encryptions of
+// the message.
+//
+// The ciphertexts can be decrypted with MultiRecipientHybridDecrypt, by any
+// of the recipients. The list of recipients is not hidden: the ciphertext
+// contains one encrypted key per recipient, in the order of 'recipients',
+// and each of them may carry the recipient's key id prefix. As all recipients
+// share the message key, a recipient can produce ciphertexts that the other
+// recipients accept; like HybridEncrypt, this provides no sender
+// authentication.
+//
+// The ciphertext format is
+//   version (1 byte, 0x01) || n (4 bytes, big endian) ||
+//   n times (length (4 bytes, big endian) || encrypted key) ||
+//   AES256-GCM ciphertext of the message,
+// where the AES-GCM associated data are all bytes before the AES-GCM
+// ciphertext, followed by 'context_info'. 'context_info' is also passed to
+// the HybridEncrypt of each recipient.
+class MultiRecipientHybridEncrypt : public HybridEncrypt {
+ public:
+  // 'recipients' must not be empty, and must not contain nullptr. Typically
+  // each of them is the HybridEncrypt primitive of a recipient's public
+  // keyset.
+  static crypto::tink::util::StatusOr<std::unique_ptr<HybridEncrypt>> New(
+      std::vector<std::unique_ptr<HybridEncrypt>> recipients);
+
+  crypto::tink::util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view context_info) const override;
+
+ private:
+  explicit MultiRecipientHybridEncrypt(
+      std::vector<std::unique_ptr<HybridEncrypt>> recipients)
+      : recipients_(std::move(recipients)) {}
+
+  const std::vector<std::unique_ptr<HybridEncrypt>> recipients_;
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_HYBRID_MULTI_RECIPIENT_HYBRID_ENCRYPT_H_
@@ -0,0 +1,127 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/hybrid/multi_recipient_hybrid_encrypt.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "tink/hybrid/multi_recipient_hybrid_decrypt.h"
+#include "tink/hybrid_decrypt.h"
+#include "tink/hybrid_encrypt.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::DummyHybridDecrypt;
+using ::crypto::tink::test::DummyHybridEncrypt;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::testing::Eq;
+using ::testing::Not;
+
+std::unique_ptr<HybridEncrypt> NewMultiRecipientEncrypt(
+    const std::vector<std::string>& names) {
+  std::vector<std::unique_ptr<HybridEncrypt>> recipients;
+  for (const std::string& name : names) {
+    recipients.push_back(absl::make_unique<DummyHybridEncrypt>(name));
+  }
+  auto result = MultiRecipientHybridEncrypt::New(std::move(recipients));
+  EXPECT_THAT(result.status(), IsOk());
+  return std::move(result.ValueOrDie());
+}
+
+std::unique_ptr<HybridDecrypt> NewMultiRecipientDecrypt(
+    absl::string_view name) {
+  auto result = MultiRecipientHybridDecrypt::New(
+      absl::make_unique<DummyHybridDecrypt>(name));
+  EXPECT_THAT(result.status(), IsOk());
+  return std::move(result.ValueOrDie());
+}
+
+TEST(MultiRecipientHybridEncryptTest, NewWithoutRecipients) {
+  EXPECT_THAT(MultiRecipientHybridEncrypt::New({}).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(MultiRecipientHybridEncryptTest, NewWithNullRecipient) {
+  std::vector<std::unique_ptr<HybridEncrypt>> recipients;
+  recipients.push_back(absl::make_unique<DummyHybridEncrypt>("alice"));
+  recipients.push_back(nullptr);
+  EXPECT_THAT(MultiRecipientHybridEncrypt::New(std::move(recipients)).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(MultiRecipientHybridEncryptTest, EveryRecipientDecrypts) {
+  std::vector<std::string> names = {"alice", "bob", "carol"};
+  auto encrypt = NewMultiRecipientEncrypt(names);
+  std::string plaintext = "some plaintext";
+  std::string context_info = "some context info";
+  auto ciphertext_result = encrypt->Encrypt(plaintext, context_info);
+  ASSERT_THAT(ciphertext_result.status(), IsOk());
+
+  for (const std::string& name : names) {
+    SCOPED_TRACE(name);
+    auto decrypt_result = NewMultiRecipientDecrypt(name)->Decrypt(
+        ciphertext_result.ValueOrDie(), context_info);
+    ASSERT_THAT(decrypt_result.status(), IsOk());
+    EXPECT_THAT(decrypt_result.ValueOrDie(), Eq(plaintext));
+  }
+}
+
+TEST(MultiRecipientHybridEncryptTest, EmptyPlaintext) {
+  auto encrypt = NewMultiRecipientEncrypt({"alice"});
+  auto ciphertext_result = encrypt->Encrypt("", "");
+  ASSERT_THAT(ciphertext_result.status(), IsOk());
+  auto decrypt_result =
+      NewMultiRecipientDecrypt("alice")->Decrypt(ciphertext_result.ValueOrDie(),
+                                                 "");
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_THAT(decrypt_result.ValueOrDie(), Eq(""));
+}
+
+TEST(MultiRecipientHybridEncryptTest, NonRecipientCannotDecrypt) {
+  auto encrypt = NewMultiRecipientEncrypt({"alice", "bob"});
+  auto ciphertext_result = encrypt->Encrypt("some plaintext", "context");
+  ASSERT_THAT(ciphertext_result.status(), IsOk());
+  EXPECT_THAT(NewMultiRecipientDecrypt("eve")
+                  ->Decrypt(ciphertext_result.ValueOrDie(), "context")
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(MultiRecipientHybridEncryptTest, CiphertextsAreRandomized) {
+  auto encrypt = NewMultiRecipientEncrypt({"alice"});
+  auto ciphertext1 = encrypt->Encrypt("some plaintext", "context");
+  auto ciphertext2 = encrypt->Encrypt("some plaintext", "context");
+  ASSERT_THAT(ciphertext1.status(), IsOk());
+  ASSERT_THAT(ciphertext2.status(), IsOk());
+  EXPECT_THAT(ciphertext1.ValueOrDie(), Not(Eq(ciphertext2.ValueOrDie())));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
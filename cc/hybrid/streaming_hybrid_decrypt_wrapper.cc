@@ -0,0 +1,149 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/hybrid/streaming_hybrid_decrypt_wrapper.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "tink/input_stream.h"
+#include "tink/output_stream.h"
+#include "tink/primitive_set.h"
+#include "tink/random_access_stream.h"
+#include "tink/streaming_aead.h"
+#include "tink/streaming_hybrid_decrypt.h"
+#include "tink/streamingaead/decrypting_input_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+namespace {
+
+using DecryptEntry =
+    PrimitiveSet<StreamingHybridDecrypt>::Entry<StreamingHybridDecrypt>;
+
+util::Status Validate(PrimitiveSet<StreamingHybridDecrypt>* primitives) {
+  if (primitives == nullptr) {
+    return util::Status(util::error::INTERNAL,
+                        "primitive set must be non-NULL");
+  }
+  if (primitives->get_primary() == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "primitive set has no primary");
+  }
+  if (!primitives->get_raw_primitives().ok()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "primitive set has no raw primitives");
+  }
+  return util::Status::OK;
+}
+
+// Presents the decryption of a StreamingHybridDecrypt-entry as a
+// StreamingAead, with 'context_info' as associated data, so that the
+// matching of ciphertext streams of DecryptingInputStream can be reused.
+class DecryptOnlyStreamingAead : public StreamingAead {
+ public:
+  explicit DecryptOnlyStreamingAead(const DecryptEntry* entry)
+      : entry_(entry) {}
+
+  util::StatusOr<std::unique_ptr<OutputStream>> NewEncryptingStream(
+      std::unique_ptr<OutputStream> ciphertext_destination,
+      absl::string_view associated_data) override {
+    return util::Status(util::error::UNIMPLEMENTED,
+                        "encryption is not supported");
+  }
+
+  util::StatusOr<std::unique_ptr<InputStream>> NewDecryptingStream(
+      std::unique_ptr<InputStream> ciphertext_source,
+      absl::string_view associated_data) override {
+    auto primitive_result = entry_->GetOrCreatePrimitive();
+    if (!primitive_result.ok()) return primitive_result.status();
+    return primitive_result.ValueOrDie()->NewDecryptingStream(
+        std::move(ciphertext_source), associated_data);
+  }
+
+  util::StatusOr<std::unique_ptr<RandomAccessStream>>
+  NewDecryptingRandomAccessStream(
+      std::unique_ptr<RandomAccessStream> ciphertext_source,
+      absl::string_view associated_data) override {
+    return util::Status(util::error::UNIMPLEMENTED,
+                        "random access decryption is not supported");
+  }
+
+ private:
+  const DecryptEntry* entry_;  // not owned
+};
+
+class StreamingHybridDecryptSetWrapper : public StreamingHybridDecrypt {
+ public:
+  StreamingHybridDecryptSetWrapper(
+      std::unique_ptr<PrimitiveSet<StreamingHybridDecrypt>> primitives,
+      std::shared_ptr<PrimitiveSet<StreamingAead>> decrypters)
+      : primitives_(std::move(primitives)),
+        decrypters_(std::move(decrypters)) {}
+
+  util::StatusOr<std::unique_ptr<InputStream>> NewDecryptingStream(
+      std::unique_ptr<InputStream> ciphertext_source,
+      absl::string_view context_info) const override {
+    return streamingaead::DecryptingInputStream::New(
+        decrypters_, std::move(ciphertext_source), context_info);
+  }
+
+  ~StreamingHybridDecryptSetWrapper() override {}
+
+ private:
+  // Owns the entries that 'decrypters_' refers to.
+  std::unique_ptr<PrimitiveSet<StreamingHybridDecrypt>> primitives_;
+  std::shared_ptr<PrimitiveSet<StreamingAead>> decrypters_;
+};
+
+}  // anonymous namespace
+
+util::StatusOr<std::unique_ptr<StreamingHybridDecrypt>>
+StreamingHybridDecryptWrapper::Wrap(
+    std::unique_ptr<PrimitiveSet<StreamingHybridDecrypt>> primitive_set)
+    const {
+  util::Status status = Validate(primitive_set.get());
+  if (!status.ok()) return status;
+
+  auto decrypters = std::make_shared<PrimitiveSet<StreamingAead>>();
+  for (const auto& entry : *primitive_set->get_raw_primitives().ValueOrDie()) {
+    google::crypto::tink::KeysetInfo::KeyInfo key_info;
+    key_info.set_key_id(entry->get_key_id());
+    key_info.set_status(entry->get_status());
+    key_info.set_output_prefix_type(
+        google::crypto::tink::OutputPrefixType::RAW);
+    auto decrypter_result = decrypters->AddPrimitive(
+        absl::make_unique<DecryptOnlyStreamingAead>(entry.get()), key_info);
+    if (!decrypter_result.ok()) return decrypter_result.status();
+    if (entry.get() == primitive_set->get_primary()) {
+      status = decrypters->set_primary(decrypter_result.ValueOrDie());
+      if (!status.ok()) return status;
+    }
+  }
+  decrypters->Freeze();
+  std::unique_ptr<StreamingHybridDecrypt> streaming_hybrid_decrypt(
+      new StreamingHybridDecryptSetWrapper(std::move(primitive_set),
+                                           std::move(decrypters)));
+  return std::move(streaming_hybrid_decrypt);
+}
+
+}  // namespace tink
+}  // namespace crypto
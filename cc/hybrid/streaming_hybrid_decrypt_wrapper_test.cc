@@ -0,0 +1,169 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/hybrid/streaming_hybrid_decrypt_wrapper.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "tink/hybrid/ecies_aead_hkdf_streaming_decrypt.h"
+#include "tink/hybrid/ecies_aead_hkdf_streaming_encrypt.h"
+#include "tink/primitive_set.h"
+#include "tink/streaming_hybrid_decrypt.h"
+#include "tink/streamingaead/streaming_aead_config.h"
+#include "tink/streamingaead/streaming_aead_key_templates.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/istream_input_stream.h"
+#include "tink/util/ostream_output_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+#include "proto/ecies_aead_hkdf.pb.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::google::crypto::tink::EciesAeadHkdfPrivateKey;
+using ::google::crypto::tink::EcPointFormat;
+using ::google::crypto::tink::EllipticCurveType;
+using ::google::crypto::tink::HashType;
+using ::google::crypto::tink::KeysetInfo;
+using ::google::crypto::tink::KeyStatusType;
+using ::google::crypto::tink::OutputPrefixType;
+
+// Returns a fresh P-256 key with AES128-GCM-HKDF streaming as DEM.
+EciesAeadHkdfPrivateKey GetTestKey() {
+  EciesAeadHkdfPrivateKey key = test::GetEciesAesGcmHkdfTestKey(
+      EllipticCurveType::NIST_P256, EcPointFormat::UNCOMPRESSED,
+      HashType::SHA256, 16);
+  *key.mutable_public_key()
+       ->mutable_params()
+       ->mutable_dem_params()
+       ->mutable_aead_dem() = StreamingAeadKeyTemplates::Aes128GcmHkdf4KB();
+  return key;
+}
+
+// Returns the encryption of 'plaintext' to the public key of 'key'.
+std::string Encrypt(const EciesAeadHkdfPrivateKey& key,
+                    absl::string_view plaintext,
+                    absl::string_view context_info) {
+  auto ct_stream = absl::make_unique<std::stringstream>();
+  auto ct_buf = ct_stream.get();
+  auto enc_stream =
+      std::move(EciesAeadHkdfStreamingEncrypt::New(key.public_key())
+                    .ValueOrDie()
+                    ->NewEncryptingStream(
+                        absl::make_unique<util::OstreamOutputStream>(
+                            std::move(ct_stream)),
+                        context_info)
+                    .ValueOrDie());
+  EXPECT_THAT(subtle::test::WriteToStream(enc_stream.get(), plaintext),
+              IsOk());
+  return ct_buf->str();
+}
+
+// Decrypts 'ciphertext' with 'decrypter', returning the plaintext.
+util::StatusOr<std::string> Decrypt(const StreamingHybridDecrypt& decrypter,
+                                    absl::string_view ciphertext,
+                                    absl::string_view context_info) {
+  auto dec_stream_result = decrypter.NewDecryptingStream(
+      absl::make_unique<util::IstreamInputStream>(
+          absl::make_unique<std::stringstream>(std::string(ciphertext))),
+      context_info);
+  if (!dec_stream_result.ok()) return dec_stream_result.status();
+  std::string plaintext;
+  auto status = subtle::test::ReadFromStream(
+      dec_stream_result.ValueOrDie().get(), &plaintext);
+  if (!status.ok()) return status;
+  return plaintext;
+}
+
+// Adds a primitive for 'key' to 'primitive_set'.
+PrimitiveSet<StreamingHybridDecrypt>::Entry<StreamingHybridDecrypt>* AddKey(
+    const EciesAeadHkdfPrivateKey& key, uint32_t key_id,
+    OutputPrefixType prefix_type,
+    PrimitiveSet<StreamingHybridDecrypt>* primitive_set) {
+  KeysetInfo::KeyInfo key_info;
+  key_info.set_key_id(key_id);
+  key_info.set_status(KeyStatusType::ENABLED);
+  key_info.set_output_prefix_type(prefix_type);
+  return primitive_set
+      ->AddPrimitive(
+          std::move(EciesAeadHkdfStreamingDecrypt::New(key).ValueOrDie()),
+          key_info)
+      .ValueOrDie();
+}
+
+class StreamingHybridDecryptWrapperTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_THAT(StreamingAeadConfig::Register(), IsOk());
+  }
+};
+
+TEST_F(StreamingHybridDecryptWrapperTest, WrapNullptr) {
+  EXPECT_THAT(StreamingHybridDecryptWrapper().Wrap(nullptr).status(),
+              StatusIs(util::error::INTERNAL));
+}
+
+TEST_F(StreamingHybridDecryptWrapperTest, WrapWithoutRawPrimitives) {
+  auto primitive_set = absl::make_unique<PrimitiveSet<StreamingHybridDecrypt>>();
+  ASSERT_THAT(primitive_set->set_primary(AddKey(
+                  GetTestKey(), 1, OutputPrefixType::TINK, primitive_set.get())),
+              IsOk());
+  EXPECT_THAT(
+      StreamingHybridDecryptWrapper().Wrap(std::move(primitive_set)).status(),
+      StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(StreamingHybridDecryptWrapperTest, DecryptsWithAnyRawKey) {
+  EciesAeadHkdfPrivateKey old_key = GetTestKey();
+  EciesAeadHkdfPrivateKey new_key = GetTestKey();
+  auto primitive_set = absl::make_unique<PrimitiveSet<StreamingHybridDecrypt>>();
+  AddKey(old_key, 1, OutputPrefixType::RAW, primitive_set.get());
+  ASSERT_THAT(primitive_set->set_primary(AddKey(
+                  new_key, 2, OutputPrefixType::RAW, primitive_set.get())),
+              IsOk());
+  auto wrap_result =
+      StreamingHybridDecryptWrapper().Wrap(std::move(primitive_set));
+  ASSERT_THAT(wrap_result.status(), IsOk());
+  const StreamingHybridDecrypt& decrypter = *wrap_result.ValueOrDie();
+
+  for (const EciesAeadHkdfPrivateKey* key : {&old_key, &new_key}) {
+    std::string plaintext(10000, 'x');
+    std::string ciphertext = Encrypt(*key, plaintext, "context");
+    auto plaintext_result = Decrypt(decrypter, ciphertext, "context");
+    ASSERT_THAT(plaintext_result.status(), IsOk());
+    EXPECT_EQ(plaintext, plaintext_result.ValueOrDie());
+    EXPECT_FALSE(Decrypt(decrypter, ciphertext, "other context").ok());
+  }
+
+  std::string ciphertext = Encrypt(GetTestKey(), "plaintext", "context");
+  EXPECT_THAT(Decrypt(decrypter, ciphertext, "context").status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
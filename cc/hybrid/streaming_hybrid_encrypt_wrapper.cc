@@ -0,0 +1,84 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/hybrid/streaming_hybrid_encrypt_wrapper.h"
+
+#include <memory>
+#include <utility>
+
+#include "tink/output_stream.h"
+#include "tink/primitive_set.h"
+#include "tink/streaming_hybrid_encrypt.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+namespace {
+
+util::Status Validate(PrimitiveSet<StreamingHybridEncrypt>* primitives) {
+  if (primitives == nullptr) {
+    return util::Status(util::error::INTERNAL,
+                        "primitive set must be non-NULL");
+  }
+  if (primitives->get_primary() == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "primitive set has no primary");
+  }
+  if (primitives->get_primary()->get_output_prefix_type() !=
+      google::crypto::tink::OutputPrefixType::RAW) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "primary key must use the RAW output prefix");
+  }
+  return util::Status::OK;
+}
+
+class StreamingHybridEncryptSetWrapper : public StreamingHybridEncrypt {
+ public:
+  explicit StreamingHybridEncryptSetWrapper(
+      std::unique_ptr<PrimitiveSet<StreamingHybridEncrypt>> primitives)
+      : primitives_(std::move(primitives)) {}
+
+  util::StatusOr<std::unique_ptr<OutputStream>> NewEncryptingStream(
+      std::unique_ptr<OutputStream> ciphertext_destination,
+      absl::string_view context_info) const override {
+    return primitives_->get_primary()->get_primitive().NewEncryptingStream(
+        std::move(ciphertext_destination), context_info);
+  }
+
+  ~StreamingHybridEncryptSetWrapper() override {}
+
+ private:
+  std::unique_ptr<PrimitiveSet<StreamingHybridEncrypt>> primitives_;
+};
+
+}  // anonymous namespace
+
+util::StatusOr<std::unique_ptr<StreamingHybridEncrypt>>
+StreamingHybridEncryptWrapper::Wrap(
+    std::unique_ptr<PrimitiveSet<StreamingHybridEncrypt>> primitive_set)
+    const {
+  util::Status status = Validate(primitive_set.get());
+  if (!status.ok()) return status;
+  std::unique_ptr<StreamingHybridEncrypt> streaming_hybrid_encrypt(
+      new StreamingHybridEncryptSetWrapper(std::move(primitive_set)));
+  return std::move(streaming_hybrid_encrypt);
+}
+
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,46 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_HYBRID_STREAMING_HYBRID_ENCRYPT_WRAPPER_H_
+#define TINK_HYBRID_STREAMING_HYBRID_ENCRYPT_WRAPPER_H_
+
+#include <memory>
+
+#include "tink/primitive_set.h"
+#include "tink/primitive_wrapper.h"
+#include "tink/streaming_hybrid_encrypt.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+// Wraps a set of StreamingHybridEncrypt-instances that correspond to a keyset,
+// and combines them into a single StreamingHybridEncrypt-primitive, that uses
+// the primary instance to do the actual encryption. As with StreamingAead,
+// the ciphertext streams carry no key prefix, so the primary key must use
+// the RAW output prefix.
+class StreamingHybridEncryptWrapper
+    : public PrimitiveWrapper<StreamingHybridEncrypt, StreamingHybridEncrypt> {
+ public:
+  util::StatusOr<std::unique_ptr<StreamingHybridEncrypt>> Wrap(
+      std::unique_ptr<PrimitiveSet<StreamingHybridEncrypt>> primitive_set)
+      const override;
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_HYBRID_STREAMING_HYBRID_ENCRYPT_WRAPPER_H_
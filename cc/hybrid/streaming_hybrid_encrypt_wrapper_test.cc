@@ -0,0 +1,143 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/hybrid/streaming_hybrid_encrypt_wrapper.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "tink/hybrid/ecies_aead_hkdf_streaming_decrypt.h"
+#include "tink/hybrid/ecies_aead_hkdf_streaming_encrypt.h"
+#include "tink/primitive_set.h"
+#include "tink/streaming_hybrid_encrypt.h"
+#include "tink/streamingaead/streaming_aead_config.h"
+#include "tink/streamingaead/streaming_aead_key_templates.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/istream_input_stream.h"
+#include "tink/util/ostream_output_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+#include "proto/ecies_aead_hkdf.pb.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::google::crypto::tink::EciesAeadHkdfPrivateKey;
+using ::google::crypto::tink::EcPointFormat;
+using ::google::crypto::tink::EllipticCurveType;
+using ::google::crypto::tink::HashType;
+using ::google::crypto::tink::KeysetInfo;
+using ::google::crypto::tink::KeyStatusType;
+using ::google::crypto::tink::OutputPrefixType;
+
+// Returns a fresh P-256 key with AES128-GCM-HKDF streaming as DEM.
+EciesAeadHkdfPrivateKey GetTestKey() {
+  EciesAeadHkdfPrivateKey key = test::GetEciesAesGcmHkdfTestKey(
+      EllipticCurveType::NIST_P256, EcPointFormat::UNCOMPRESSED,
+      HashType::SHA256, 16);
+  *key.mutable_public_key()
+       ->mutable_params()
+       ->mutable_dem_params()
+       ->mutable_aead_dem() = StreamingAeadKeyTemplates::Aes128GcmHkdf4KB();
+  return key;
+}
+
+// Returns a primitive set with a single primitive for 'key', as primary.
+std::unique_ptr<PrimitiveSet<StreamingHybridEncrypt>> GetPrimitiveSet(
+    const EciesAeadHkdfPrivateKey& key, OutputPrefixType prefix_type) {
+  KeysetInfo::KeyInfo key_info;
+  key_info.set_key_id(1234);
+  key_info.set_status(KeyStatusType::ENABLED);
+  key_info.set_output_prefix_type(prefix_type);
+  auto primitive_set = absl::make_unique<PrimitiveSet<StreamingHybridEncrypt>>();
+  auto entry = primitive_set->AddPrimitive(
+      std::move(
+          EciesAeadHkdfStreamingEncrypt::New(key.public_key()).ValueOrDie()),
+      key_info);
+  EXPECT_THAT(primitive_set->set_primary(entry.ValueOrDie()), IsOk());
+  return primitive_set;
+}
+
+class StreamingHybridEncryptWrapperTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_THAT(StreamingAeadConfig::Register(), IsOk());
+  }
+};
+
+TEST_F(StreamingHybridEncryptWrapperTest, WrapNullptr) {
+  EXPECT_THAT(StreamingHybridEncryptWrapper().Wrap(nullptr).status(),
+              StatusIs(util::error::INTERNAL));
+}
+
+TEST_F(StreamingHybridEncryptWrapperTest, WrapEmpty) {
+  EXPECT_THAT(
+      StreamingHybridEncryptWrapper()
+          .Wrap(absl::make_unique<PrimitiveSet<StreamingHybridEncrypt>>())
+          .status(),
+      StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(StreamingHybridEncryptWrapperTest, NonRawPrimary) {
+  EXPECT_THAT(StreamingHybridEncryptWrapper()
+                  .Wrap(GetPrimitiveSet(GetTestKey(), OutputPrefixType::TINK))
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(StreamingHybridEncryptWrapperTest, EncryptsWithPrimary) {
+  EciesAeadHkdfPrivateKey key = GetTestKey();
+  auto wrap_result = StreamingHybridEncryptWrapper().Wrap(
+      GetPrimitiveSet(key, OutputPrefixType::RAW));
+  ASSERT_THAT(wrap_result.status(), IsOk());
+
+  auto ct_stream = absl::make_unique<std::stringstream>();
+  auto ct_buf = ct_stream.get();
+  auto enc_stream_result = wrap_result.ValueOrDie()->NewEncryptingStream(
+      absl::make_unique<util::OstreamOutputStream>(std::move(ct_stream)),
+      "context");
+  ASSERT_THAT(enc_stream_result.status(), IsOk());
+  ASSERT_THAT(subtle::test::WriteToStream(enc_stream_result.ValueOrDie().get(),
+                                          "some plaintext"),
+              IsOk());
+
+  // The ciphertext has no key prefix.
+  auto decrypt_result = EciesAeadHkdfStreamingDecrypt::New(key);
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  auto dec_stream_result = decrypt_result.ValueOrDie()->NewDecryptingStream(
+      absl::make_unique<util::IstreamInputStream>(
+          absl::make_unique<std::stringstream>(ct_buf->str())),
+      "context");
+  ASSERT_THAT(dec_stream_result.status(), IsOk());
+  std::string plaintext;
+  ASSERT_THAT(subtle::test::ReadFromStream(
+                  dec_stream_result.ValueOrDie().get(), &plaintext),
+              IsOk());
+  EXPECT_EQ(plaintext, "some plaintext");
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -17,7 +17,15 @@
 #ifndef TINK_HYBRID_DECRYPT_H_
 #define TINK_HYBRID_DECRYPT_H_
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/util/executor.h"
+#include "tink/util/output_buffer_factory.h"
+#include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
 namespace crypto {
@@ -59,6 +67,51 @@ class HybridDecrypt {
   virtual crypto::tink::util::StatusOr<std::string> Decrypt(
       absl::string_view ciphertext, absl::string_view context_info) const = 0;
 
+  // Decrypts 'ciphertext' like Decrypt(), but writes the plaintext to a
+  // buffer from 'new_buffer' and returns the part of it holding the
+  // plaintext.
+  //
+  // Implementations which can decrypt directly into the buffer should
+  // override this method; the default implementation calls Decrypt() and
+  // copies the result.
+  virtual crypto::tink::util::StatusOr<absl::Span<char>> DecryptToBuffer(
+      absl::string_view ciphertext, absl::string_view context_info,
+      const crypto::tink::util::OutputBufferFactory& new_buffer) const {
+    auto plaintext_result = Decrypt(ciphertext, context_info);
+    if (!plaintext_result.ok()) return plaintext_result.status();
+    return crypto::tink::util::internal::CopyToNewBuffer(
+        plaintext_result.ValueOrDie(), new_buffer);
+  }
+
+  // Decrypts each of 'ciphertexts' like Decrypt(), with the corresponding
+  // entry of 'context_info', which must have the same number of elements, on
+  // the calling thread and up to num_threads - 1 tasks on
+  // util::Executor::Global() (num_threads values below 1 are treated as 1).
+  // Element i of the result holds the plaintext of ciphertexts[i], or the
+  // error decrypting it.
+  //
+  // Implementations should override this method if they can amortize
+  // per-ciphertext work over the batch; the default implementation calls
+  // Decrypt() for each element.
+  virtual std::vector<crypto::tink::util::StatusOr<std::string>> DecryptBatch(
+      absl::Span<const absl::string_view> ciphertexts,
+      absl::Span<const absl::string_view> context_info,
+      int num_threads) const {
+    if (ciphertexts.size() != context_info.size()) {
+      return std::vector<crypto::tink::util::StatusOr<std::string>>(
+          ciphertexts.size(),
+          crypto::tink::util::Status(
+              crypto::tink::util::error::INVALID_ARGUMENT,
+              "ciphertexts and context_info must have the same size"));
+    }
+    std::vector<crypto::tink::util::StatusOr<std::string>> plaintexts(
+        ciphertexts.size());
+    util::ParallelFor(ciphertexts.size(), num_threads, [&](int64_t i) {
+      plaintexts[i] = Decrypt(ciphertexts[i], context_info[i]);
+    });
+    return plaintexts;
+  }
+
   virtual ~HybridDecrypt() {}
 };
 
@@ -16,6 +16,9 @@
 
 #include "tink/integration/awskms/aws_kms_aead.h"
 
+#include <memory>
+#include <utility>
+
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
@@ -30,6 +33,7 @@
 #include "aws/kms/model/EncryptRequest.h"
 #include "aws/kms/model/EncryptResult.h"
 #include "tink/aead.h"
+#include "tink/tracing.h"
 #include "tink/util/errors.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
@@ -84,7 +88,7 @@ AwsKmsAead::New(absl::string_view key_arn,
   return std::move(aead);
 }
 
-StatusOr<std::string> AwsKmsAead::Encrypt(
+Aws::KMS::Model::EncryptRequest AwsKmsAead::MakeEncryptRequest(
     absl::string_view plaintext, absl::string_view associated_data) const {
   Aws::KMS::Model::EncryptRequest req;
   req.SetKeyId(key_arn_.c_str());
@@ -96,21 +100,10 @@ StatusOr<std::string> AwsKmsAead::Encrypt(
     req.AddEncryptionContext("associatedData",
                              HexEncode(associated_data).c_str());
   }
-  auto outcome = aws_client_->Encrypt(req);
-  if (outcome.IsSuccess()) {
-    auto& blob = outcome.GetResult().GetCiphertextBlob();
-    std::string ciphertext(
-        reinterpret_cast<const char*>(blob.GetUnderlyingData()),
-        blob.GetLength());
-    return ciphertext;
-  }
-  auto& err = outcome.GetError();
-  return ToStatusF(util::error::INVALID_ARGUMENT,
-                   "AWS KMS encryption failed with error: %s",
-                   AwsErrorToString(err));
+  return req;
 }
 
-StatusOr<std::string> AwsKmsAead::Decrypt(
+Aws::KMS::Model::DecryptRequest AwsKmsAead::MakeDecryptRequest(
     absl::string_view ciphertext, absl::string_view associated_data) const {
   Aws::KMS::Model::DecryptRequest req;
   req.SetKeyId(key_arn_.c_str());
@@ -122,7 +115,27 @@ StatusOr<std::string> AwsKmsAead::Decrypt(
     req.AddEncryptionContext("associatedData",
                              HexEncode(associated_data).c_str());
   }
-  auto outcome = aws_client_->Decrypt(req);
+  return req;
+}
+
+// static
+StatusOr<std::string> AwsKmsAead::GetCiphertext(
+    const Aws::KMS::Model::EncryptOutcome& outcome) {
+  if (outcome.IsSuccess()) {
+    auto& blob = outcome.GetResult().GetCiphertextBlob();
+    std::string ciphertext(
+        reinterpret_cast<const char*>(blob.GetUnderlyingData()),
+        blob.GetLength());
+    return ciphertext;
+  }
+  auto& err = outcome.GetError();
+  return ToStatusF(util::error::INVALID_ARGUMENT,
+                   "AWS KMS encryption failed with error: %s",
+                   AwsErrorToString(err));
+}
+
+StatusOr<std::string> AwsKmsAead::GetPlaintext(
+    const Aws::KMS::Model::DecryptOutcome& outcome) const {
   if (outcome.IsSuccess()) {
     if (outcome.GetResult().GetKeyId() != Aws::String(key_arn_.c_str())) {
       return util::Status(util::error::INVALID_ARGUMENT,
@@ -140,6 +153,59 @@ StatusOr<std::string> AwsKmsAead::Decrypt(
                    AwsErrorToString(err));
 }
 
+StatusOr<std::string> AwsKmsAead::Encrypt(
+    absl::string_view plaintext, absl::string_view associated_data) const {
+  internal::ScopedSpan span("tink.aws_kms.encrypt");
+  auto ciphertext_result = GetCiphertext(
+      aws_client_->Encrypt(MakeEncryptRequest(plaintext, associated_data)));
+  span.set_status(ciphertext_result.status());
+  return ciphertext_result;
+}
+
+StatusOr<std::string> AwsKmsAead::Decrypt(
+    absl::string_view ciphertext, absl::string_view associated_data) const {
+  internal::ScopedSpan span("tink.aws_kms.decrypt");
+  auto plaintext_result = GetPlaintext(
+      aws_client_->Decrypt(MakeDecryptRequest(ciphertext, associated_data)));
+  span.set_status(plaintext_result.status());
+  return plaintext_result;
+}
+
+void AwsKmsAead::EncryptAsync(absl::string_view plaintext,
+                              absl::string_view associated_data,
+                              Callback done) const {
+  std::shared_ptr<TraceSpan> span =
+      internal::StartSpan("tink.aws_kms.encrypt");
+  // The client copies the request, and calls the handler on its executor.
+  aws_client_->EncryptAsync(
+      MakeEncryptRequest(plaintext, associated_data),
+      [done, span](
+          const Aws::KMS::KMSClient*, const Aws::KMS::Model::EncryptRequest&,
+          const Aws::KMS::Model::EncryptOutcome& outcome,
+          const std::shared_ptr<const Aws::Client::AsyncCallerContext>&) {
+        auto ciphertext_result = GetCiphertext(outcome);
+        internal::EndSpan(span.get(), ciphertext_result.status());
+        done(std::move(ciphertext_result));
+      });
+}
+
+void AwsKmsAead::DecryptAsync(absl::string_view ciphertext,
+                              absl::string_view associated_data,
+                              Callback done) const {
+  std::shared_ptr<TraceSpan> span =
+      internal::StartSpan("tink.aws_kms.decrypt");
+  aws_client_->DecryptAsync(
+      MakeDecryptRequest(ciphertext, associated_data),
+      [this, done, span](
+          const Aws::KMS::KMSClient*, const Aws::KMS::Model::DecryptRequest&,
+          const Aws::KMS::Model::DecryptOutcome& outcome,
+          const std::shared_ptr<const Aws::Client::AsyncCallerContext>&) {
+        auto plaintext_result = GetPlaintext(outcome);
+        internal::EndSpan(span.get(), plaintext_result.status());
+        done(std::move(plaintext_result));
+      });
+}
+
 }  // namespace awskms
 }  // namespace integration
 }  // namespace tink
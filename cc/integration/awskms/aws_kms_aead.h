@@ -20,6 +20,7 @@
 #include "absl/strings/string_view.h"
 #include "aws/kms/KMSClient.h"
 #include "tink/aead.h"
+#include "tink/async_aead.h"
 #include "tink/util/statusor.h"
 
 namespace crypto {
@@ -30,7 +31,11 @@ namespace awskms {
 // AwsKmsAead is an implementation of AEAD that forwards
 // encryption/decryption requests to a key managed by
 // <a href="https://aws.amazon.com/kms/">AWS KMS</a>.
-class AwsKmsAead : public Aead {
+// The AsyncAead methods use the asynchronous calls of the AWS client, which
+// run on the executor configured in its ClientConfiguration.
+// For hedged requests, deadlines and fallback to other regions, wrap
+// several instances in a HedgedAead (tink/aead/hedged_aead.h).
+class AwsKmsAead : public Aead, public AsyncAead {
  public:
   // Creates a new AwsKmsAead that is bound to the key specified in 'key_arn',
   // and that uses the given client when communicating with the KMS.
@@ -46,11 +51,27 @@ class AwsKmsAead : public Aead {
       absl::string_view ciphertext,
       absl::string_view associated_data) const override;
 
+  void EncryptAsync(absl::string_view plaintext,
+                    absl::string_view associated_data,
+                    Callback done) const override;
+
+  void DecryptAsync(absl::string_view ciphertext,
+                    absl::string_view associated_data,
+                    Callback done) const override;
+
   virtual ~AwsKmsAead() {}
 
  private:
   AwsKmsAead(absl::string_view key_arn,
              std::shared_ptr<Aws::KMS::KMSClient> aws_client);
+  Aws::KMS::Model::EncryptRequest MakeEncryptRequest(
+      absl::string_view plaintext, absl::string_view associated_data) const;
+  Aws::KMS::Model::DecryptRequest MakeDecryptRequest(
+      absl::string_view ciphertext, absl::string_view associated_data) const;
+  static crypto::tink::util::StatusOr<std::string> GetCiphertext(
+      const Aws::KMS::Model::EncryptOutcome& outcome);
+  crypto::tink::util::StatusOr<std::string> GetPlaintext(
+      const Aws::KMS::Model::DecryptOutcome& outcome) const;
   std::string key_arn_;  // The location of a crypto key in AWS KMS.
   std::shared_ptr<Aws::KMS::KMSClient> aws_client_;
 };
@@ -18,9 +18,14 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/match.h"
 #include "absl/strings/ascii.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
@@ -61,7 +66,8 @@ std::string GetKeyArn(absl::string_view key_uri) {
 // Returns ClientConfiguration with region set to the value
 // extracted from 'key_arn'.
 StatusOr<Aws::Client::ClientConfiguration>
-    GetAwsClientConfig(absl::string_view key_arn) {
+    GetAwsClientConfig(absl::string_view key_arn,
+                       const AwsKmsClient::ConnectionOptions& options) {
   std::vector<std::string> key_arn_parts = absl::StrSplit(key_arn, ':');
   if (key_arn_parts.size() < 6) {
     return ToStatusF(util::error::INVALID_ARGUMENT, "Invalid key ARN '%s'.",
@@ -70,11 +76,44 @@ StatusOr<Aws::Client::ClientConfiguration>
   Aws::Client::ClientConfiguration config;
   config.region = key_arn_parts[3].c_str();  // 4th part of key arn
   config.scheme = Aws::Http::Scheme::HTTPS;
-  config.connectTimeoutMs = 30000;
-  config.requestTimeoutMs = 60000;
+  config.connectTimeoutMs = options.connect_timeout_ms;
+  config.requestTimeoutMs = options.request_timeout_ms;
+  config.maxConnections = options.max_connections;
+  config.enableTcpKeepAlive = options.enable_tcp_keep_alive;
+  config.tcpKeepAliveIntervalMs = options.tcp_keep_alive_interval_ms;
   return config;
 }
 
+// Returns the AWS KMSClient for the region of 'key_arn'. All clients with the
+// same credentials and options share one KMSClient per region, i.e. one pool
+// of connections, for all key URIs.
+StatusOr<std::shared_ptr<Aws::KMS::KMSClient>> GetAwsKmsClient(
+    absl::string_view key_arn, const Aws::Auth::AWSCredentials& credentials,
+    const AwsKmsClient::ConnectionOptions& options) {
+  auto config_result = GetAwsClientConfig(key_arn, options);
+  if (!config_result.ok()) return config_result.status();
+  const Aws::Client::ClientConfiguration& config = config_result.ValueOrDie();
+
+  static absl::Mutex* mutex = new absl::Mutex();
+  static auto* pool = new absl::flat_hash_map<
+      std::string, std::shared_ptr<Aws::KMS::KMSClient>>();
+  std::string pool_key = absl::StrCat(
+      config.region.c_str(), "\n", options.max_connections, "\n",
+      options.connect_timeout_ms, "\n", options.request_timeout_ms, "\n",
+      options.enable_tcp_keep_alive, "\n",
+      options.tcp_keep_alive_interval_ms, "\n",
+      credentials.GetAWSAccessKeyId().c_str(), "\n",
+      credentials.GetAWSSecretKey().c_str(), "\n",
+      credentials.GetSessionToken().c_str());
+  absl::MutexLock lock(mutex);
+  auto it = pool->find(pool_key);
+  if (it != pool->end()) return it->second;
+  auto aws_client = Aws::MakeShared<Aws::KMS::KMSClient>(
+      kAwsCryptoAllocationTag, credentials, config);
+  pool->emplace(pool_key, aws_client);
+  return aws_client;
+}
+
 // Reads the specified file and returns the content as a string.
 StatusOr<std::string> Read(const std::string& filename) {
   std::ifstream input_stream;
@@ -183,8 +222,29 @@ void AwsKmsClient::InitAwsApi() {
 StatusOr<std::unique_ptr<AwsKmsClient>>
 AwsKmsClient::New(absl::string_view key_uri,
                   absl::string_view credentials_path) {
+  return New(key_uri, credentials_path, ConnectionOptions());
+}
+
+// static
+StatusOr<std::unique_ptr<AwsKmsClient>>
+AwsKmsClient::New(absl::string_view key_uri,
+                  absl::string_view credentials_path,
+                  const ConnectionOptions& options) {
+  if (options.max_connections < 1) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "max_connections must be positive");
+  }
+  if (options.connect_timeout_ms < 1 || options.request_timeout_ms < 1) {
+    return Status(util::error::INVALID_ARGUMENT, "timeouts must be positive");
+  }
+  if (options.enable_tcp_keep_alive &&
+      options.tcp_keep_alive_interval_ms < 15000) {
+    // The SDK does not accept shorter intervals.
+    return Status(util::error::INVALID_ARGUMENT,
+                  "tcp_keep_alive_interval_ms must be at least 15000");
+  }
   if (!aws_api_is_initialized_) InitAwsApi();
-  std::unique_ptr<AwsKmsClient> client(new AwsKmsClient());
+  std::unique_ptr<AwsKmsClient> client(new AwsKmsClient(options));
 
   // Read credentials.
   auto credentials_result = GetAwsCredentials(credentials_path);
@@ -200,13 +260,10 @@ AwsKmsClient::New(absl::string_view key_uri,
       return ToStatusF(util::error::INVALID_ARGUMENT, "Key '%s' not supported",
                        key_uri);
     }
-    auto config_result = GetAwsClientConfig(client->key_arn_);
-    if (!config_result.ok()) return config_result.status();
-    // Create AWS KMSClient.
-    client->aws_client_ = Aws::MakeShared<Aws::KMS::KMSClient>(
-        kAwsCryptoAllocationTag,
-        client->credentials_,
-        config_result.ValueOrDie());
+    auto aws_client_result =
+        GetAwsKmsClient(client->key_arn_, client->credentials_, options);
+    if (!aws_client_result.ok()) return aws_client_result.status();
+    client->aws_client_ = std::move(aws_client_result.ValueOrDie());
   }
   return std::move(client);
 }
@@ -232,13 +289,11 @@ AwsKmsClient::GetAead(absl::string_view key_uri) const {
   }
   if (!key_arn_.empty()) {  // This client is bound to a specific key.
     return AwsKmsAead::New(key_arn_, aws_client_);
-  } else {  // Create an AWS KMSClient for the given key.
+  } else {  // Get an AWS KMSClient for the region of the given key.
     auto key_arn = GetKeyArn(key_uri);
-    auto config_result = GetAwsClientConfig(key_arn);
-    if (!config_result.ok()) return config_result.status();
-    auto aws_client = Aws::MakeShared<Aws::KMS::KMSClient>(
-        kAwsCryptoAllocationTag, credentials_, config_result.ValueOrDie());
-    return AwsKmsAead::New(key_arn, aws_client);
+    auto aws_client_result = GetAwsKmsClient(key_arn, credentials_, options_);
+    if (!aws_client_result.ok()) return aws_client_result.status();
+    return AwsKmsAead::New(key_arn, aws_client_result.ValueOrDie());
   }
 }
 
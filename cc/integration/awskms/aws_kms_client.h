@@ -17,6 +17,7 @@
 #ifndef TINK_INTEGRATION_AWSKMS_AWS_KMS_CLIENT_H_
 #define TINK_INTEGRATION_AWSKMS_AWS_KMS_CLIENT_H_
 
+#include <cstdint>
 #include <memory>
 
 #include "absl/strings/string_view.h"
@@ -39,6 +40,23 @@ namespace awskms {
 // <a href="https://aws.amazon.com/kms/">AWS KMS</a>
 class AwsKmsClient : public crypto::tink::KmsClient  {
  public:
+  // Options for the connections to the KMS. All clients created with the
+  // same credentials and options share one AWS KMSClient, and thus one pool
+  // of HTTP connections, per region, for all key URIs.
+  struct ConnectionOptions {
+    // The maximum number of concurrent HTTP connections per region.
+    int max_connections = 25;
+    // Timeouts for establishing a connection and for receiving data on it.
+    int64_t connect_timeout_ms = 30000;
+    int64_t request_timeout_ms = 60000;
+    // Whether idle pooled connections send TCP keep-alive probes, and how
+    // often, so that they are not closed by the KMS endpoint or by NATs
+    // between calls and need no new TLS handshake. The SDK requires an
+    // interval of at least 15 seconds.
+    bool enable_tcp_keep_alive = true;
+    int64_t tcp_keep_alive_interval_ms = 30000;
+  };
+
   // Creates a new AwsKmsClient that is bound to the key specified in 'key_uri',
   // and that uses the specifed credentials when communicating with the KMS.
   //
@@ -48,6 +66,11 @@ class AwsKmsClient : public crypto::tink::KmsClient  {
   static crypto::tink::util::StatusOr<std::unique_ptr<AwsKmsClient>>
   New(absl::string_view key_uri, absl::string_view credentials_path);
 
+  // Same as above, using the connections configured by 'options'.
+  static crypto::tink::util::StatusOr<std::unique_ptr<AwsKmsClient>>
+  New(absl::string_view key_uri, absl::string_view credentials_path,
+      const ConnectionOptions& options);
+
   // Creates a new client and registers it in KMSClients.
   static crypto::tink::util::Status RegisterNewClient(
       absl::string_view key_uri, absl::string_view credentials_path);
@@ -61,12 +84,14 @@ class AwsKmsClient : public crypto::tink::KmsClient  {
   GetAead(absl::string_view key_uri) const override;
 
  private:
-  AwsKmsClient() {}
+  explicit AwsKmsClient(const ConnectionOptions& options)
+      : options_(options) {}
   // Initializes AWS API.
   static void InitAwsApi();
   static bool aws_api_is_initialized_;
   static absl::Mutex aws_api_init_mutex_;
 
+  const ConnectionOptions options_;
   std::string key_arn_;
   Aws::Auth::AWSCredentials credentials_;
   std::shared_ptr<Aws::KMS::KMSClient> aws_client_;
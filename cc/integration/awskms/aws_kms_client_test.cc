@@ -88,6 +88,44 @@ TEST(AwsKmsClientTest, ClientCreationInvalidRegistry) {
   EXPECT_THAT(client_result, StatusIs(util::error::INVALID_ARGUMENT));
 }
 
+TEST(AwsKmsClientTest, ClientWithConnectionOptions) {
+  std::string aws_key1 = "aws-kms://arn:aws:kms:us-east-1:acc:some/key1";
+  std::string aws_key2 = "aws-kms://arn:aws:kms:us-east-1:acc:some/key2";
+  std::string aws_key3 = "aws-kms://arn:aws:kms:us-west-2:acc:other/key3";
+  std::string creds_file = absl::StrCat(
+      getenv("TEST_SRCDIR"), "/tink_base/testdata/aws_credentials_cc.txt");
+
+  AwsKmsClient::ConnectionOptions options;
+  options.max_connections = 100;
+  options.request_timeout_ms = 5000;
+  options.tcp_keep_alive_interval_ms = 20000;
+  auto client_result = AwsKmsClient::New("", creds_file, options);
+  ASSERT_THAT(client_result.status(), IsOk());
+  auto client = std::move(client_result.ValueOrDie());
+  EXPECT_THAT(client->GetAead(aws_key1).status(), IsOk());
+  EXPECT_THAT(client->GetAead(aws_key2).status(), IsOk());
+  EXPECT_THAT(client->GetAead(aws_key3).status(), IsOk());
+  EXPECT_THAT(client->GetAead("aws-kms://invalid-arn").status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+
+  AwsKmsClient::ConnectionOptions invalid_options = options;
+  invalid_options.max_connections = 0;
+  EXPECT_THAT(AwsKmsClient::New("", creds_file, invalid_options).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  invalid_options = options;
+  invalid_options.connect_timeout_ms = 0;
+  EXPECT_THAT(AwsKmsClient::New("", creds_file, invalid_options).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  invalid_options = options;
+  invalid_options.tcp_keep_alive_interval_ms = 1000;
+  EXPECT_THAT(AwsKmsClient::New("", creds_file, invalid_options).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  // Without keep-alive probes, their interval is not used.
+  invalid_options.enable_tcp_keep_alive = false;
+  EXPECT_THAT(AwsKmsClient::New("", creds_file, invalid_options).status(),
+              IsOk());
+}
+
 }  // namespace
 }  // namespace awskms
 }  // namespace integration
@@ -16,12 +16,18 @@
 
 #include "tink/integration/gcpkms/gcp_kms_aead.h"
 
+#include <memory>
+#include <string>
+#include <utility>
+
 #include "absl/memory/memory.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "google/cloud/kms/v1/service.grpc.pb.h"
 #include "tink/aead.h"
+#include "tink/async_aead.h"
+#include "tink/tracing.h"
 #include "tink/util/errors.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
@@ -40,6 +46,18 @@ using google::cloud::kms::v1::EncryptResponse;
 using google::cloud::kms::v1::KeyManagementService;
 using grpc::ClientContext;
 
+namespace {
+
+// The state of an asynchronous call, which must outlive the call.
+template <typename Request, typename Response>
+struct AsyncCall {
+  ClientContext context;
+  Request req;
+  Response resp;
+};
+
+}  // namespace
+
 GcpKmsAead::GcpKmsAead(
     absl::string_view key_name,
     std::shared_ptr<KeyManagementService::Stub> kms_stub)
@@ -72,11 +90,15 @@ StatusOr<std::string> GcpKmsAead::Encrypt(
   context.AddMetadata("x-goog-request-params",
                       absl::StrCat("name=", key_name_));
 
+  internal::ScopedSpan span("tink.gcp_kms.encrypt");
   auto status =  kms_stub_->Encrypt(&context, req, &resp);
 
   if (status.ok()) return resp.ciphertext();
-  return ToStatusF(util::error::INVALID_ARGUMENT,
-                   "GCP KMS encryption failed: %s", status.error_message());
+  util::Status error = ToStatusF(util::error::INVALID_ARGUMENT,
+                                 "GCP KMS encryption failed: %s",
+                                 status.error_message());
+  span.set_status(error);
+  return error;
 }
 
 StatusOr<std::string> GcpKmsAead::Decrypt(
@@ -91,11 +113,71 @@ StatusOr<std::string> GcpKmsAead::Decrypt(
   context.AddMetadata("x-goog-request-params",
                       absl::StrCat("name=", key_name_));
 
+  internal::ScopedSpan span("tink.gcp_kms.decrypt");
   auto status =  kms_stub_->Decrypt(&context, req, &resp);
 
   if (status.ok()) return resp.plaintext();
-  return ToStatusF(util::error::INVALID_ARGUMENT,
-                   "GCP KMS encryption failed: %s", status.error_message());
+  util::Status error = ToStatusF(util::error::INVALID_ARGUMENT,
+                                 "GCP KMS encryption failed: %s",
+                                 status.error_message());
+  span.set_status(error);
+  return error;
+}
+
+void GcpKmsAead::EncryptAsync(absl::string_view plaintext,
+                              absl::string_view associated_data,
+                              Callback done) const {
+  auto call = std::make_shared<AsyncCall<EncryptRequest, EncryptResponse>>();
+  call->req.set_name(key_name_);
+  call->req.set_plaintext(std::string(plaintext));
+  call->req.set_additional_authenticated_data(std::string(associated_data));
+  call->context.AddMetadata("x-goog-request-params",
+                            absl::StrCat("name=", key_name_));
+
+  std::shared_ptr<TraceSpan> span =
+      internal::StartSpan("tink.gcp_kms.encrypt");
+  kms_stub_->experimental_async()->Encrypt(
+      &call->context, &call->req, &call->resp,
+      [call, done, span](grpc::Status status) {
+        if (status.ok()) {
+          internal::EndSpan(span.get(), util::Status::OK);
+          done(std::string(call->resp.ciphertext()));
+          return;
+        }
+        util::Status error = ToStatusF(util::error::INVALID_ARGUMENT,
+                                       "GCP KMS encryption failed: %s",
+                                       status.error_message());
+        internal::EndSpan(span.get(), error);
+        done(std::move(error));
+      });
+}
+
+void GcpKmsAead::DecryptAsync(absl::string_view ciphertext,
+                              absl::string_view associated_data,
+                              Callback done) const {
+  auto call = std::make_shared<AsyncCall<DecryptRequest, DecryptResponse>>();
+  call->req.set_name(key_name_);
+  call->req.set_ciphertext(std::string(ciphertext));
+  call->req.set_additional_authenticated_data(std::string(associated_data));
+  call->context.AddMetadata("x-goog-request-params",
+                            absl::StrCat("name=", key_name_));
+
+  std::shared_ptr<TraceSpan> span =
+      internal::StartSpan("tink.gcp_kms.decrypt");
+  kms_stub_->experimental_async()->Decrypt(
+      &call->context, &call->req, &call->resp,
+      [call, done, span](grpc::Status status) {
+        if (status.ok()) {
+          internal::EndSpan(span.get(), util::Status::OK);
+          done(std::string(call->resp.plaintext()));
+          return;
+        }
+        util::Status error = ToStatusF(util::error::INVALID_ARGUMENT,
+                                       "GCP KMS decryption failed: %s",
+                                       status.error_message());
+        internal::EndSpan(span.get(), error);
+        done(std::move(error));
+      });
 }
 
 }  // namespace gcpkms
@@ -22,6 +22,7 @@
 #include "google/cloud/kms/v1/service.grpc.pb.h"
 
 #include "tink/aead.h"
+#include "tink/async_aead.h"
 #include "tink/util/statusor.h"
 
 namespace crypto {
@@ -32,7 +33,11 @@ namespace gcpkms {
 // GcpKmsAead is an implementation of AEAD that forwards
 // encryption/decryption requests to a key managed by
 // <a href="https://cloud.google.com/kms/">Google Cloud KMS</a>.
-class GcpKmsAead : public Aead {
+// The AsyncAead methods use the callback API of the gRPC stub, and call
+// 'done' on a gRPC thread.
+// For hedged requests, deadlines and fallback to other regions, wrap
+// several instances in a HedgedAead (tink/aead/hedged_aead.h).
+class GcpKmsAead : public Aead, public AsyncAead {
  public:
   // Creates a new GcpKmsAead that is bound to the key specified in 'key_name',
   // and that uses the channel when communicating with the KMS.
@@ -52,6 +57,14 @@ class GcpKmsAead : public Aead {
       absl::string_view ciphertext,
       absl::string_view associated_data) const override;
 
+  void EncryptAsync(absl::string_view plaintext,
+                    absl::string_view associated_data,
+                    Callback done) const override;
+
+  void DecryptAsync(absl::string_view ciphertext,
+                    absl::string_view associated_data,
+                    Callback done) const override;
+
   virtual ~GcpKmsAead() {}
 
  private:
@@ -0,0 +1,202 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/integration/gcpkms/gcp_kms_async_aead.h"
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "google/cloud/kms/v1/service.grpc.pb.h"
+#include "grpcpp/completion_queue.h"
+#include "tink/async_aead.h"
+#include "tink/tracing.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace integration {
+namespace gcpkms {
+
+using crypto::tink::util::Status;
+using crypto::tink::util::StatusOr;
+using google::cloud::kms::v1::DecryptRequest;
+using google::cloud::kms::v1::DecryptResponse;
+using google::cloud::kms::v1::EncryptRequest;
+using google::cloud::kms::v1::EncryptResponse;
+using google::cloud::kms::v1::KeyManagementService;
+
+namespace {
+
+// A call on the completion queue, whose address is its tag. The reaper
+// that takes it from the queue completes and deletes it.
+class PendingCall {
+ public:
+  virtual ~PendingCall() {}
+
+  virtual void Complete() = 0;
+};
+
+// The state of an Encrypt or Decrypt call. 'result' is the accessor of the
+// ciphertext or plaintext of 'Response'.
+template <typename Request, typename Response>
+class AsyncCall : public PendingCall {
+ public:
+  using Result = const std::string& (Response::*)() const;
+
+  AsyncCall(absl::string_view span_name, absl::string_view error_prefix,
+            Result result, AsyncAead::Callback done)
+      : span_(internal::StartSpan(span_name)),
+        error_prefix_(error_prefix),
+        result_(result),
+        done_(std::move(done)) {}
+
+  // Sets up the request and metadata for the key 'key_name'.
+  Request* Prepare(const std::string& key_name) {
+    request_.set_name(key_name);
+    context_.AddMetadata("x-goog-request-params",
+                         absl::StrCat("name=", key_name));
+    return &request_;
+  }
+
+  // Starts the call with 'start', the Async... method of the stub for it,
+  // and hands the call over to 'queue'.
+  template <typename StartFunction>
+  void Start(StartFunction start, grpc::CompletionQueue* queue) {
+    reader_ = start(&context_, request_, queue);
+    reader_->Finish(&response_, &status_, this);
+  }
+
+  void Complete() override {
+    if (status_.ok()) {
+      internal::EndSpan(span_.get(), util::Status::OK);
+      done_(std::string((response_.*result_)()));
+      return;
+    }
+    Status error(util::error::INVALID_ARGUMENT,
+                 absl::StrCat(error_prefix_, status_.error_message()));
+    internal::EndSpan(span_.get(), error);
+    done_(std::move(error));
+  }
+
+ private:
+  std::unique_ptr<TraceSpan> span_;
+  absl::string_view error_prefix_;
+  Result result_;
+  AsyncAead::Callback done_;
+  grpc::ClientContext context_;
+  Request request_;
+  Response response_;
+  grpc::Status status_;
+  std::unique_ptr<grpc::ClientAsyncResponseReader<Response>> reader_;
+};
+
+}  // namespace
+
+GcpKmsAsyncAead::GcpKmsAsyncAead(
+    absl::string_view key_name,
+    std::shared_ptr<KeyManagementService::Stub> kms_stub,
+    int num_reaper_threads)
+    : key_name_(key_name), kms_stub_(std::move(kms_stub)) {
+  for (int i = 0; i < num_reaper_threads; i++) {
+    reapers_.emplace_back(&GcpKmsAsyncAead::Reap, this);
+  }
+}
+
+// static
+StatusOr<std::unique_ptr<AsyncAead>> GcpKmsAsyncAead::New(
+    absl::string_view key_name,
+    std::shared_ptr<KeyManagementService::Stub> kms_stub,
+    int num_reaper_threads) {
+  if (key_name.empty()) {
+    return Status(util::error::INVALID_ARGUMENT, "Key URI cannot be empty.");
+  }
+  if (kms_stub == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "KMS stub cannot be null.");
+  }
+  if (num_reaper_threads < 1) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "num_reaper_threads must be positive.");
+  }
+  std::unique_ptr<AsyncAead> aead(
+      new GcpKmsAsyncAead(key_name, std::move(kms_stub), num_reaper_threads));
+  return std::move(aead);
+}
+
+GcpKmsAsyncAead::~GcpKmsAsyncAead() {
+  // The queue still delivers the outstanding calls after Shutdown(), and
+  // Next() only returns false once it has been drained.
+  queue_.Shutdown();
+  for (std::thread& reaper : reapers_) reaper.join();
+}
+
+void GcpKmsAsyncAead::Reap() {
+  void* tag;
+  bool ok;
+  while (queue_.Next(&tag, &ok)) {
+    // Finish() of a unary call always completes with ok set; errors are in
+    // the status of the call.
+    std::unique_ptr<PendingCall> call(static_cast<PendingCall*>(tag));
+    call->Complete();
+  }
+}
+
+void GcpKmsAsyncAead::EncryptAsync(absl::string_view plaintext,
+                                   absl::string_view associated_data,
+                                   Callback done) const {
+  auto call = new AsyncCall<EncryptRequest, EncryptResponse>(
+      "tink.gcp_kms.encrypt", "GCP KMS encryption failed: ",
+      &EncryptResponse::ciphertext, std::move(done));
+  EncryptRequest* request = call->Prepare(key_name_);
+  request->set_plaintext(std::string(plaintext));
+  request->set_additional_authenticated_data(std::string(associated_data));
+  KeyManagementService::Stub* stub = kms_stub_.get();
+  call->Start(
+      [stub](grpc::ClientContext* context, const EncryptRequest& request,
+             grpc::CompletionQueue* queue) {
+        return stub->AsyncEncrypt(context, request, queue);
+      },
+      &queue_);
+}
+
+void GcpKmsAsyncAead::DecryptAsync(absl::string_view ciphertext,
+                                   absl::string_view associated_data,
+                                   Callback done) const {
+  auto call = new AsyncCall<DecryptRequest, DecryptResponse>(
+      "tink.gcp_kms.decrypt", "GCP KMS decryption failed: ",
+      &DecryptResponse::plaintext, std::move(done));
+  DecryptRequest* request = call->Prepare(key_name_);
+  request->set_ciphertext(std::string(ciphertext));
+  request->set_additional_authenticated_data(std::string(associated_data));
+  KeyManagementService::Stub* stub = kms_stub_.get();
+  call->Start(
+      [stub](grpc::ClientContext* context, const DecryptRequest& request,
+             grpc::CompletionQueue* queue) {
+        return stub->AsyncDecrypt(context, request, queue);
+      },
+      &queue_);
+}
+
+}  // namespace gcpkms
+}  // namespace integration
+}  // namespace tink
+}  // namespace crypto
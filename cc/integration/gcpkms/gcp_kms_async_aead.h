@@ -0,0 +1,93 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_INTEGRATION_GCPKMS_GCP_KMS_ASYNC_AEAD_H_
+#define TINK_INTEGRATION_GCPKMS_GCP_KMS_ASYNC_AEAD_H_
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "google/cloud/kms/v1/service.grpc.pb.h"
+#include "grpcpp/completion_queue.h"
+#include "tink/async_aead.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace integration {
+namespace gcpkms {
+
+// GcpKmsAsyncAead is an AsyncAead that forwards encryption/decryption
+// requests to a key managed by Google Cloud KMS, like GcpKmsAead, but uses
+// the completion queue API of gRPC rather than its callback API.
+//
+// All calls are started on a single CompletionQueue owned by the object and
+// multiplexed over the channel of the stub. A small pool of reaper threads,
+// also owned by the object, waits on the queue and calls 'done' for each
+// completed call, so outstanding calls occupy no thread, and 'done' always
+// runs on a reaper thread. Callbacks that block delay the completion of
+// other calls; use more reaper threads if they do.
+//
+// The destructor waits for the outstanding calls to complete.
+class GcpKmsAsyncAead : public AsyncAead {
+ public:
+  // Creates a new GcpKmsAsyncAead bound to the key specified in 'key_name',
+  // with 'num_reaper_threads' threads waiting on the completion queue.
+  // See GcpKmsAead::New() for the format of 'key_name'.
+  static crypto::tink::util::StatusOr<std::unique_ptr<AsyncAead>> New(
+      absl::string_view key_name,
+      std::shared_ptr<google::cloud::kms::v1::KeyManagementService::Stub>
+          kms_stub,
+      int num_reaper_threads = 1);
+
+  void EncryptAsync(absl::string_view plaintext,
+                    absl::string_view associated_data,
+                    Callback done) const override;
+
+  void DecryptAsync(absl::string_view ciphertext,
+                    absl::string_view associated_data,
+                    Callback done) const override;
+
+  ~GcpKmsAsyncAead() override;
+
+ private:
+  GcpKmsAsyncAead(
+      absl::string_view key_name,
+      std::shared_ptr<google::cloud::kms::v1::KeyManagementService::Stub>
+          kms_stub,
+      int num_reaper_threads);
+
+  // Completes the calls of 'queue_' until it is shut down.
+  void Reap();
+
+  std::string key_name_;  // The location of a crypto key in GCP KMS.
+  std::shared_ptr<google::cloud::kms::v1::KeyManagementService::Stub>
+      kms_stub_;
+  // Starting a call adds it to the queue, which is thread safe.
+  mutable grpc::CompletionQueue queue_;
+  std::vector<std::thread> reapers_;
+};
+
+}  // namespace gcpkms
+}  // namespace integration
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_INTEGRATION_GCPKMS_GCP_KMS_ASYNC_AEAD_H_
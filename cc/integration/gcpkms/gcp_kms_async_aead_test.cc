@@ -0,0 +1,113 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/integration/gcpkms/gcp_kms_async_aead.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "google/cloud/kms/v1/service.grpc.pb.h"
+#include "grpcpp/create_channel.h"
+#include "grpcpp/security/credentials.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace integration {
+namespace gcpkms {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::google::cloud::kms::v1::KeyManagementService;
+
+constexpr char kKeyName[] =
+    "projects/p/locations/global/keyRings/r/cryptoKeys/k";
+
+// Returns a stub whose calls fail, since nothing listens on its socket.
+std::shared_ptr<KeyManagementService::Stub> NewUnreachableStub() {
+  return KeyManagementService::NewStub(grpc::CreateChannel(
+      "unix:/nonexistent/tink_gcp_kms_async_aead_test",
+      grpc::InsecureChannelCredentials()));
+}
+
+TEST(GcpKmsAsyncAeadTest, New) {
+  EXPECT_THAT(GcpKmsAsyncAead::New("", NewUnreachableStub()).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(GcpKmsAsyncAead::New(kKeyName, nullptr).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(GcpKmsAsyncAead::New(kKeyName, NewUnreachableStub(), 0).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(GcpKmsAsyncAead::New(kKeyName, NewUnreachableStub(), 4).status(),
+              IsOk());
+}
+
+TEST(GcpKmsAsyncAeadTest, CompletesEachCallOnce) {
+  const int kCalls = 50;
+  absl::Mutex mutex;
+  std::vector<util::Status> results;
+  absl::BlockingCounter pending(2 * kCalls);
+  {
+    auto aead_result = GcpKmsAsyncAead::New(kKeyName, NewUnreachableStub(), 2);
+    ASSERT_THAT(aead_result.status(), IsOk());
+    std::unique_ptr<AsyncAead> aead = std::move(aead_result.ValueOrDie());
+    auto done = [&](util::StatusOr<std::string> result) {
+      {
+        absl::MutexLock lock(&mutex);
+        results.push_back(result.status());
+      }
+      pending.DecrementCount();
+    };
+    for (int i = 0; i < kCalls; i++) {
+      aead->EncryptAsync("plaintext", "aad", done);
+      aead->DecryptAsync("ciphertext", "aad", done);
+    }
+    pending.Wait();
+  }
+  ASSERT_EQ(2 * kCalls, results.size());
+  for (const util::Status& status : results) {
+    EXPECT_THAT(status, StatusIs(util::error::INVALID_ARGUMENT));
+  }
+}
+
+TEST(GcpKmsAsyncAeadTest, DestructorWaitsForCalls) {
+  int completed = 0;
+  {
+    auto aead_result = GcpKmsAsyncAead::New(kKeyName, NewUnreachableStub());
+    ASSERT_THAT(aead_result.status(), IsOk());
+    for (int i = 0; i < 10; i++) {
+      aead_result.ValueOrDie()->EncryptAsync(
+          "plaintext", "aad",
+          [&completed](util::StatusOr<std::string> result) { completed++; });
+    }
+  }
+  // A single reaper thread ran the callbacks one after the other.
+  EXPECT_EQ(10, completed);
+}
+
+}  // namespace
+}  // namespace gcpkms
+}  // namespace integration
+}  // namespace tink
+}  // namespace crypto
@@ -18,15 +18,21 @@
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "grpcpp/channel.h"
 #include "grpcpp/create_channel.h"
 #include "grpcpp/security/credentials.h"
+#include "grpcpp/support/channel_arguments.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "tink/integration/gcpkms/gcp_kms_aead.h"
 #include "tink/kms_clients.h"
 #include "tink/util/errors.h"
@@ -99,12 +105,64 @@ std::string GetKeyName(absl::string_view key_uri) {
   return std::string(key_uri.substr(std::string(kKeyUriPrefix).length()));
 }
 
+// Returns the stubs for the channels to the KMS. All clients with the same
+// credentials and options share their channels, so that they create at most
+// 'num_channels' connections to the KMS, independent of the number of keys.
+StatusOr<std::vector<std::shared_ptr<KeyManagementService::Stub>>>
+GetKmsStubs(absl::string_view credentials_path,
+            const GcpKmsClient::ConnectionOptions& options) {
+  static absl::Mutex* mutex = new absl::Mutex();
+  static auto* pool = new absl::flat_hash_map<
+      std::string,
+      std::vector<std::shared_ptr<KeyManagementService::Stub>>>();
+  std::string pool_key =
+      absl::StrCat(options.num_channels, ":", credentials_path);
+  absl::MutexLock lock(mutex);
+  auto it = pool->find(pool_key);
+  if (it != pool->end()) return it->second;
+
+  // Read credentials.
+  auto creds_result = GetCredentials(credentials_path);
+  if (!creds_result.ok()) {
+    return creds_result.status();
+  }
+
+  // Create the KMS stubs.
+  std::vector<std::shared_ptr<KeyManagementService::Stub>> stubs;
+  for (int i = 0; i < options.num_channels; i++) {
+    ChannelArguments args;
+    args.SetUserAgentPrefix(absl::StrCat(kTinkUserAgentPrefix,
+                                         Version::kTinkVersion, " CPP-Python"));
+    // Channels with equal arguments share their connection; give each of
+    // the channels its own.
+    if (options.num_channels > 1) {
+      args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+    }
+    stubs.push_back(KeyManagementService::NewStub(grpc::CreateCustomChannel(
+        kGcpKmsServer, creds_result.ValueOrDie(), args)));
+  }
+  pool->emplace(pool_key, stubs);
+  return stubs;
+}
+
 }  // namespace
 
 // static
 StatusOr<std::unique_ptr<GcpKmsClient>>
 GcpKmsClient::New(absl::string_view key_uri,
                   absl::string_view credentials_path) {
+  return New(key_uri, credentials_path, ConnectionOptions());
+}
+
+// static
+StatusOr<std::unique_ptr<GcpKmsClient>>
+GcpKmsClient::New(absl::string_view key_uri,
+                  absl::string_view credentials_path,
+                  const ConnectionOptions& options) {
+  if (options.num_channels < 1) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "num_channels must be positive");
+  }
   std::unique_ptr<GcpKmsClient> client(new GcpKmsClient());
 
   // If a specific key is given, create a GCP KMSClient.
@@ -115,18 +173,11 @@ GcpKmsClient::New(absl::string_view key_uri,
                        key_uri);
     }
   }
-  // Read credentials.
-  auto creds_result = GetCredentials(credentials_path);
-  if (!creds_result.ok()) {
-    return creds_result.status();
-  }
 
-  // Create a KMS stub.
-  ChannelArguments args;
-  args.SetUserAgentPrefix(
-      absl::StrCat(kTinkUserAgentPrefix, Version::kTinkVersion, " CPP-Python"));
-  client->kms_stub_ = KeyManagementService::NewStub(grpc::CreateCustomChannel(
-      kGcpKmsServer, creds_result.ValueOrDie(), args));
+  // Get the KMS stubs.
+  auto stubs_result = GetKmsStubs(credentials_path, options);
+  if (!stubs_result.ok()) return stubs_result.status();
+  client->kms_stubs_ = std::move(stubs_result.ValueOrDie());
   return std::move(client);
 }
 
@@ -149,11 +200,13 @@ GcpKmsClient::GetAead(absl::string_view key_uri) const {
                        "This client does not support key '%s'.", key_uri);
     }
   }
+  // Spread the Aeads over the channels.
+  const auto& kms_stub = kms_stubs_[next_stub_++ % kms_stubs_.size()];
   if (!key_name_.empty()) {  // This client is bound to a specific key.
-    return GcpKmsAead::New(key_name_, kms_stub_);
+    return GcpKmsAead::New(key_name_, kms_stub);
   } else {  // Create an GCP KMSClient for the given key.
     auto key_name = GetKeyName(key_uri);
-    return GcpKmsAead::New(key_name, kms_stub_);
+    return GcpKmsAead::New(key_name, kms_stub);
   }
 }
 
@@ -17,7 +17,10 @@
 #ifndef TINK_INTEGRATION_GCPKMS_GCP_KMS_CLIENT_H_
 #define TINK_INTEGRATION_GCPKMS_GCP_KMS_CLIENT_H_
 
+#include <atomic>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 #include "google/cloud/kms/v1/service.grpc.pb.h"
@@ -37,6 +40,16 @@ namespace gcpkms {
 // <a href="https://cloud.google.com/kms/">Google Cloud KMS</a>.
 class GcpKmsClient : public crypto::tink::KmsClient  {
  public:
+  // Options for the connections to the KMS. All clients created with the
+  // same credentials path and options share their connections, for all key
+  // URIs.
+  struct ConnectionOptions {
+    // The number of gRPC channels to the KMS, each with its own connection.
+    // A channel multiplexes concurrent calls (up to the HTTP/2 stream limit
+    // of the server, typically 100); Aeads are spread over the channels.
+    int num_channels = 1;
+  };
+
   // Creates a new GcpKmsClient that is bound to the key specified in 'key_uri',
   // and that uses the specifed credentials when communicating with the KMS.
   //
@@ -46,6 +59,11 @@ class GcpKmsClient : public crypto::tink::KmsClient  {
   static crypto::tink::util::StatusOr<std::unique_ptr<GcpKmsClient>>
   New(absl::string_view key_uri, absl::string_view credentials_path);
 
+  // Same as above, using the connections configured by 'options'.
+  static crypto::tink::util::StatusOr<std::unique_ptr<GcpKmsClient>>
+  New(absl::string_view key_uri, absl::string_view credentials_path,
+      const ConnectionOptions& options);
+
   // Creates a new client and registers it in KMSClients.
   static crypto::tink::util::Status RegisterNewClient(
       absl::string_view key_uri, absl::string_view credentials_path);
@@ -62,7 +80,10 @@ class GcpKmsClient : public crypto::tink::KmsClient  {
   GcpKmsClient() {}
 
   std::string key_name_;
-  std::shared_ptr<google::cloud::kms::v1::KeyManagementService::Stub> kms_stub_;
+  std::vector<
+      std::shared_ptr<google::cloud::kms::v1::KeyManagementService::Stub>>
+      kms_stubs_;
+  mutable std::atomic<size_t> next_stub_{0};
 };
 
 
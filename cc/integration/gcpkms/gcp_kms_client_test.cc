@@ -91,6 +91,30 @@ TEST(GcpKmsClientTest, ClientCreationInvalidRegistry) {
               StatusIs(util::error::INVALID_ARGUMENT));
 }
 
+TEST(GcpKmsClientTest, ClientWithConnectionOptions) {
+  std::string gcp_key1 = "gcp-kms://projects/someProject/.../cryptoKeys/key1";
+  std::string gcp_key2 = "gcp-kms://projects/otherProject/.../cryptoKeys/key2";
+  std::string creds_file = absl::StrCat(getenv("TEST_SRCDIR"),
+                                        "/tink_base/testdata/credential.json");
+
+  GcpKmsClient::ConnectionOptions options;
+  options.num_channels = 3;
+  auto client_result = GcpKmsClient::New("", creds_file, options);
+  ASSERT_THAT(client_result.status(), IsOk());
+  auto client = std::move(client_result.ValueOrDie());
+  for (int i = 0; i < 4; i++) {
+    EXPECT_THAT(client->GetAead(gcp_key1).status(), IsOk());
+    EXPECT_THAT(client->GetAead(gcp_key2).status(), IsOk());
+  }
+  // Shares the channels of the first client.
+  EXPECT_THAT(GcpKmsClient::New(gcp_key1, creds_file, options).status(),
+              IsOk());
+
+  options.num_channels = 0;
+  EXPECT_THAT(GcpKmsClient::New("", creds_file, options).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
 }  // namespace
 }  // namespace gcpkms
 }  // namespace integration
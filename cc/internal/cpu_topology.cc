@@ -0,0 +1,127 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/internal/cpu_topology.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/strings/strip.h"
+
+namespace crypto {
+namespace tink {
+namespace internal {
+
+namespace {
+
+// Numbers of NUMA nodes and CPUs larger than any real machine, which bound
+// the work done for a corrupt sysfs.
+constexpr int kMaxNodes = 1024;
+constexpr int kMaxCpus = 1 << 16;
+
+std::vector<int> AllCpus() {
+  std::vector<int> cpus(std::max<int>(1, std::thread::hardware_concurrency()));
+  for (int i = 0; i < cpus.size(); i++) cpus[i] = i;
+  return cpus;
+}
+
+}  // namespace
+
+std::vector<int> ParseCpuList(absl::string_view cpu_list) {
+  std::vector<int> cpus;
+  cpu_list = absl::StripSuffix(cpu_list, "\n");
+  if (cpu_list.empty()) return cpus;
+  for (absl::string_view range : absl::StrSplit(cpu_list, ',')) {
+    std::vector<absl::string_view> bounds = absl::StrSplit(range, '-');
+    int first, last;
+    if (bounds.size() > 2 || !absl::SimpleAtoi(bounds[0], &first) ||
+        !absl::SimpleAtoi(bounds.back(), &last) || first < 0 ||
+        last < first || last >= kMaxCpus) {
+      return {};
+    }
+    for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+std::vector<std::vector<int>> NumaNodeCpus() {
+  std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+  for (int node = 0; node < kMaxNodes; node++) {
+    std::ifstream file(
+        absl::StrCat("/sys/devices/system/node/node", node, "/cpulist"));
+    // Node numbers may have gaps, but rarely many.
+    if (!file.is_open()) {
+      if (node >= 64) break;
+      continue;
+    }
+    std::string cpu_list((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+    std::vector<int> cpus = ParseCpuList(cpu_list);
+    if (!cpus.empty()) nodes.push_back(std::move(cpus));
+  }
+#endif
+  if (nodes.empty()) nodes.push_back(AllCpus());
+  return nodes;
+}
+
+int CurrentCpu() {
+#ifdef __linux__
+  return sched_getcpu();
+#else
+  return -1;
+#endif
+}
+
+void RunOnCpus(const std::vector<int>& cpus,
+               const std::function<void()>& task) {
+#ifdef __linux__
+  std::thread thread([&cpus, &task]() {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : cpus) {
+      if (cpu < CPU_SETSIZE) CPU_SET(cpu, &cpu_set);
+    }
+    // If pinning fails, e.g. because of a cgroup restriction, the task still
+    // runs, only without the locality.
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    task();
+  });
+  thread.join();
+#else
+  task();
+#endif
+}
+
+}  // namespace internal
+}  // namespace tink
+}  // namespace crypto
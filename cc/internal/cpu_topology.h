@@ -0,0 +1,54 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_INTERNAL_CPU_TOPOLOGY_H_
+#define TINK_INTERNAL_CPU_TOPOLOGY_H_
+
+#include <functional>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+
+namespace crypto {
+namespace tink {
+namespace internal {
+
+// Helpers for ReplicatedPrimitive. Only Linux is supported; on other
+// platforms all CPUs form a single group and threads are not pinned.
+
+// Returns the CPUs of each NUMA node that has any, as listed in
+// /sys/devices/system/node. Returns a single group with all CPUs if the
+// nodes cannot be read.
+std::vector<std::vector<int>> NumaNodeCpus();
+
+// Parses a sysfs CPU list such as "0-3,8,10-11". Returns an empty list if
+// 'cpu_list' is malformed.
+std::vector<int> ParseCpuList(absl::string_view cpu_list);
+
+// Returns the CPU the calling thread runs on, or -1 if unknown.
+int CurrentCpu();
+
+// Runs 'task' on a new thread that may only run on 'cpus', and waits for it.
+// Memory the task touches first is thus usually allocated on the NUMA node of
+// 'cpus'. Runs 'task' on the calling thread if threads cannot be pinned.
+void RunOnCpus(const std::vector<int>& cpus, const std::function<void()>& task);
+
+}  // namespace internal
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_INTERNAL_CPU_TOPOLOGY_H_
@@ -0,0 +1,75 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/internal/cpu_topology.h"
+
+#include <algorithm>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace crypto {
+namespace tink {
+namespace internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+TEST(CpuTopologyTest, ParseCpuList) {
+  EXPECT_THAT(ParseCpuList("0"), ElementsAre(0));
+  EXPECT_THAT(ParseCpuList("0-3,8,10-11\n"),
+              ElementsAre(0, 1, 2, 3, 8, 10, 11));
+  EXPECT_THAT(ParseCpuList(""), IsEmpty());
+  EXPECT_THAT(ParseCpuList("\n"), IsEmpty());
+  EXPECT_THAT(ParseCpuList("3-1"), IsEmpty());
+  EXPECT_THAT(ParseCpuList("1-2-3"), IsEmpty());
+  EXPECT_THAT(ParseCpuList("a"), IsEmpty());
+  EXPECT_THAT(ParseCpuList("1,,2"), IsEmpty());
+}
+
+TEST(CpuTopologyTest, NumaNodeCpus) {
+  std::vector<std::vector<int>> nodes = NumaNodeCpus();
+  ASSERT_FALSE(nodes.empty());
+  for (const std::vector<int>& cpus : nodes) EXPECT_FALSE(cpus.empty());
+}
+
+TEST(CpuTopologyTest, RunOnCpus) {
+  std::vector<int> cpus = NumaNodeCpus()[0];
+  bool ran = false;
+  int cpu = -1;
+  RunOnCpus(cpus, [&ran, &cpu]() {
+    ran = true;
+    cpu = CurrentCpu();
+  });
+  EXPECT_TRUE(ran);
+#ifdef __linux__
+  EXPECT_NE(std::find(cpus.begin(), cpus.end(), cpu), cpus.end());
+#endif
+
+  // Tasks that cannot be pinned still run.
+  ran = false;
+  RunOnCpus({}, [&ran]() { ran = true; });
+  EXPECT_TRUE(ran);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,79 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/internal/key_pool.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "proto/tink.pb.h"
+
+using google::crypto::tink::KeyData;
+
+namespace crypto {
+namespace tink {
+namespace internal {
+
+KeyPool::KeyPool(Generator generator, int capacity)
+    : generator_(std::move(generator)), capacity_(capacity) {
+  thread_ = std::thread(&KeyPool::Run, this);
+}
+
+KeyPool::~KeyPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopping_ = true;
+  }
+  thread_.join();
+}
+
+std::unique_ptr<KeyData> KeyPool::Take() {
+  absl::MutexLock lock(&mutex_);
+  if (keys_.empty()) return nullptr;
+  std::unique_ptr<KeyData> key_data = std::move(keys_.front());
+  keys_.pop_front();
+  return key_data;
+}
+
+int KeyPool::WaitUntilFull() {
+  absl::MutexLock lock(&mutex_);
+  mutex_.Await(absl::Condition(this, &KeyPool::IsFullOrStopped));
+  return keys_.size();
+}
+
+void KeyPool::Run() {
+  while (true) {
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(this, &KeyPool::NeedsKeyOrStopping));
+      if (stopping_) break;
+    }
+    // Keys are generated without holding the lock, so that Take() does not
+    // wait for a generation in progress.
+    auto key_data_result = generator_();
+    absl::MutexLock lock(&mutex_);
+    if (!key_data_result.ok()) break;
+    keys_.push_back(std::move(key_data_result.ValueOrDie()));
+  }
+  absl::MutexLock lock(&mutex_);
+  stopped_ = true;
+}
+
+}  // namespace internal
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,86 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_INTERNAL_KEY_POOL_H_
+#define TINK_INTERNAL_KEY_POOL_H_
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace internal {
+
+// Keeps up to 'capacity' keys generated ahead of time by 'generator' on a
+// background thread, so that taking a key for templates with expensive key
+// generation (e.g. RSA) does not have to wait for it. The thread refills the
+// pool whenever a key has been taken. If 'generator' fails, the thread stops
+// and the pool stays empty, so that callers generate keys themselves and see
+// the error. This class is thread-safe.
+class KeyPool {
+ public:
+  using Generator = std::function<crypto::tink::util::StatusOr<
+      std::unique_ptr<google::crypto::tink::KeyData>>()>;
+
+  KeyPool(Generator generator, int capacity);
+
+  // Stops the background thread, waiting for a key generation in progress.
+  ~KeyPool();
+
+  KeyPool(const KeyPool&) = delete;
+  KeyPool& operator=(const KeyPool&) = delete;
+
+  // Returns a pregenerated key, or nullptr if none is available. Each key is
+  // returned at most once.
+  std::unique_ptr<google::crypto::tink::KeyData> Take()
+      ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Blocks until the pool is full or the background thread stopped, and
+  // returns the number of keys in the pool.
+  int WaitUntilFull() ABSL_LOCKS_EXCLUDED(mutex_);
+
+ private:
+  void Run() ABSL_LOCKS_EXCLUDED(mutex_);
+
+  bool NeedsKeyOrStopping() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return stopping_ || keys_.size() < static_cast<size_t>(capacity_);
+  }
+  bool IsFullOrStopped() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return stopped_ || keys_.size() >= static_cast<size_t>(capacity_);
+  }
+
+  const Generator generator_;
+  const int capacity_;
+  absl::Mutex mutex_;
+  std::deque<std::unique_ptr<google::crypto::tink::KeyData>> keys_
+      ABSL_GUARDED_BY(mutex_);
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+  bool stopped_ ABSL_GUARDED_BY(mutex_) = false;
+  std::thread thread_;
+};
+
+}  // namespace internal
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_INTERNAL_KEY_POOL_H_
@@ -0,0 +1,129 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_INTERNAL_KEY_PREFIX_INDEX_H_
+#define TINK_INTERNAL_KEY_PREFIX_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/crypto_format.h"
+#include "tink/internal/memory_usage.h"
+
+namespace crypto {
+namespace tink {
+namespace internal {
+
+// An immutable map from output prefixes (as computed by
+// CryptoFormat::GetOutputPrefix) to values of type 'const V*'.
+//
+// Non-raw prefixes consist of a start byte followed by the big-endian key id,
+// so they are packed into a single 64-bit integer and stored in a small
+// open-addressing table with linear probing. Lookups therefore neither
+// allocate nor hash a string. The RAW (empty) prefix has a dedicated slot.
+template <class V>
+class KeyPrefixIndex {
+ public:
+  // Constructs an empty index.
+  KeyPrefixIndex() : mask_(0), raw_value_(nullptr) {}
+
+  // Constructs an index over 'entries'. The prefixes must be distinct and the
+  // values non-null.
+  explicit KeyPrefixIndex(
+      absl::Span<const std::pair<absl::string_view, const V*>> entries)
+      : mask_(0), raw_value_(nullptr) {
+    size_t capacity = 8;
+    while (capacity < 2 * entries.size()) capacity *= 2;
+    slots_.resize(capacity);
+    mask_ = capacity - 1;
+    for (const auto& entry : entries) {
+      if (entry.first.empty()) {
+        raw_value_ = entry.second;
+      } else if (entry.first.size() == CryptoFormat::kNonRawPrefixSize) {
+        uint64_t key = Pack(entry.first);
+        size_t i = Hash(key) & mask_;
+        while (slots_[i].value != nullptr) i = (i + 1) & mask_;
+        slots_[i].key = key;
+        slots_[i].value = entry.second;
+      } else {
+        // CryptoFormat produces no such prefixes; keep them for completeness.
+        other_.emplace_back(std::string(entry.first), entry.second);
+      }
+    }
+  }
+
+  // Returns the value for 'prefix', or nullptr if there is none.
+  const V* Find(absl::string_view prefix) const {
+    if (prefix.size() == CryptoFormat::kNonRawPrefixSize) {
+      if (slots_.empty()) return nullptr;
+      uint64_t key = Pack(prefix);
+      for (size_t i = Hash(key) & mask_; slots_[i].value != nullptr;
+           i = (i + 1) & mask_) {
+        if (slots_[i].key == key) return slots_[i].value;
+      }
+      return nullptr;
+    }
+    if (prefix.empty()) return raw_value_;
+    for (const auto& entry : other_) {
+      if (entry.first == prefix) return entry.second;
+    }
+    return nullptr;
+  }
+
+  // Returns the heap bytes held by this index, see memory_usage.h.
+  size_t EstimateMemoryUsage() const {
+    size_t usage = slots_.capacity() * sizeof(Slot) +
+                   other_.capacity() * sizeof(other_[0]);
+    for (const auto& entry : other_) {
+      usage += StringMemoryUsage(entry.first);
+    }
+    return usage;
+  }
+
+ private:
+  struct Slot {
+    uint64_t key = 0;
+    const V* value = nullptr;  // nullptr marks an empty slot
+  };
+
+  // Packs a kNonRawPrefixSize-byte prefix into the low 40 bits of a word.
+  static uint64_t Pack(absl::string_view prefix) {
+    uint64_t key = 0;
+    for (char c : prefix) key = (key << 8) | static_cast<uint8_t>(c);
+    return key;
+  }
+
+  // Fibonacci hashing: key ids are often sequential or random, either way
+  // the high bits of the product are well mixed.
+  static size_t Hash(uint64_t key) {
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32);
+  }
+
+  std::vector<Slot> slots_;
+  size_t mask_;
+  const V* raw_value_;
+  std::vector<std::pair<std::string, const V*>> other_;
+};
+
+}  // namespace internal
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_INTERNAL_KEY_PREFIX_INDEX_H_
@@ -0,0 +1,99 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/internal/key_prefix_index.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "tink/crypto_format.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace internal {
+namespace {
+
+using ::google::crypto::tink::KeysetInfo;
+using ::google::crypto::tink::OutputPrefixType;
+
+std::string Prefix(uint32_t key_id, OutputPrefixType output_prefix_type) {
+  KeysetInfo::KeyInfo key_info;
+  key_info.set_key_id(key_id);
+  key_info.set_output_prefix_type(output_prefix_type);
+  return CryptoFormat::GetOutputPrefix(key_info).ValueOrDie();
+}
+
+TEST(KeyPrefixIndexTest, Empty) {
+  KeyPrefixIndex<int> index;
+  EXPECT_EQ(index.Find(""), nullptr);
+  EXPECT_EQ(index.Find(Prefix(1, OutputPrefixType::TINK)), nullptr);
+  EXPECT_EQ(index.Find("abc"), nullptr);
+}
+
+TEST(KeyPrefixIndexTest, FindsAllEntries) {
+  std::vector<int> values(1000);
+  std::vector<std::string> prefixes;
+  for (int i = 0; i < values.size(); i++) {
+    values[i] = i;
+    // Mix TINK and LEGACY prefixes which share the key id space.
+    prefixes.push_back(Prefix(i / 2, i % 2 == 0 ? OutputPrefixType::TINK
+                                                : OutputPrefixType::LEGACY));
+  }
+  std::vector<std::pair<absl::string_view, const int*>> entries;
+  for (int i = 0; i < values.size(); i++) {
+    entries.emplace_back(prefixes[i], &values[i]);
+  }
+  KeyPrefixIndex<int> index(entries);
+
+  for (int i = 0; i < values.size(); i++) {
+    EXPECT_EQ(index.Find(prefixes[i]), &values[i]) << i;
+  }
+  EXPECT_EQ(index.Find(Prefix(5000, OutputPrefixType::TINK)), nullptr);
+  EXPECT_EQ(index.Find(""), nullptr);
+}
+
+TEST(KeyPrefixIndexTest, RawPrefix) {
+  int raw = 1;
+  int tink = 2;
+  std::string tink_prefix = Prefix(0, OutputPrefixType::TINK);
+  std::vector<std::pair<absl::string_view, const int*>> entries = {
+      {"", &raw}, {tink_prefix, &tink}};
+  KeyPrefixIndex<int> index(entries);
+  EXPECT_EQ(index.Find(""), &raw);
+  EXPECT_EQ(index.Find(tink_prefix), &tink);
+  // The LEGACY prefix of key id 0 packs to 0 and must not be confused with an
+  // empty slot or with the RAW entry.
+  EXPECT_EQ(index.Find(Prefix(0, OutputPrefixType::LEGACY)), nullptr);
+}
+
+TEST(KeyPrefixIndexTest, OtherPrefixLengths) {
+  int value = 1;
+  std::vector<std::pair<absl::string_view, const int*>> entries = {
+      {"abc", &value}};
+  KeyPrefixIndex<int> index(entries);
+  EXPECT_EQ(index.Find("abc"), &value);
+  EXPECT_EQ(index.Find("abd"), nullptr);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace tink
+}  // namespace crypto
@@ -41,6 +41,17 @@ class KeysetWrapper {
 
   virtual crypto::tink::util::StatusOr<std::unique_ptr<Primitive>> Wrap(
       const google::crypto::tink::Keyset& keyset) const = 0;
+
+  // Same as Wrap(keyset), but may create the primitives of the individual
+  // keys on up to 'num_threads' threads. 'num_threads' must be positive.
+  virtual crypto::tink::util::StatusOr<std::unique_ptr<Primitive>> Wrap(
+      const google::crypto::tink::Keyset& keyset, int num_threads) const = 0;
+
+  // Same as Wrap(keyset), but if the underlying PrimitiveWrapper supports it,
+  // only creates the primitive of the primary key, and those of the other
+  // keys when they are first used.
+  virtual crypto::tink::util::StatusOr<std::unique_ptr<Primitive>> WrapLazily(
+      const google::crypto::tink::Keyset& keyset) const = 0;
 };
 
 }  // namespace tink
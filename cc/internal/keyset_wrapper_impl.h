@@ -16,10 +16,19 @@
 #ifndef TINK_INTERNAL_KEYSET_WRAPPER_IMPL_H_
 #define TINK_INTERNAL_KEYSET_WRAPPER_IMPL_H_
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
 #include "tink/internal/key_info.h"
 #include "tink/internal/keyset_wrapper.h"
 #include "tink/primitive_set.h"
 #include "tink/primitive_wrapper.h"
+#include "tink/util/executor.h"
+#include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "tink/util/validation.h"
 #include "proto/tink.pb.h"
@@ -37,11 +46,70 @@ class KeysetWrapperImpl : public KeysetWrapper<Q> {
       std::function<crypto::tink::util::StatusOr<std::unique_ptr<P>>(
           const google::crypto::tink::KeyData& key_data)>
           primitive_getter)
-      : primitive_getter_(primitive_getter),
+      : primitive_getter_(ToSharedGetter(std::move(primitive_getter))),
         transforming_wrapper_(*transforming_wrapper) {}
 
+  // Same as the constructor, but the primitives returned by
+  // 'primitive_getter' may be shared with other keysets, as done by
+  // RegistryImpl::GetSharedPrimitive().
+  static std::unique_ptr<KeysetWrapperImpl<P, Q>> NewWithSharedPrimitives(
+      const PrimitiveWrapper<P, Q>* transforming_wrapper,
+      std::function<crypto::tink::util::StatusOr<std::shared_ptr<P>>(
+          const google::crypto::tink::KeyData& key_data)>
+          primitive_getter) {
+    return absl::WrapUnique(new KeysetWrapperImpl<P, Q>(
+        transforming_wrapper, std::move(primitive_getter), SharedTag()));
+  }
+
+  crypto::tink::util::StatusOr<std::unique_ptr<Q>> Wrap(
+      const google::crypto::tink::Keyset& keyset) const override {
+    return Wrap(keyset, /*num_threads=*/1);
+  }
+
+  // The primitives are created concurrently, but added to the primitive set
+  // in keyset order afterwards, so the result does not depend on
+  // 'num_threads'. On failure, the error of the first failing key in keyset
+  // order is returned.
   crypto::tink::util::StatusOr<std::unique_ptr<Q>> Wrap(
+      const google::crypto::tink::Keyset& keyset,
+      int num_threads) const override {
+    if (num_threads < 1) {
+      return crypto::tink::util::Status(
+          crypto::tink::util::error::INVALID_ARGUMENT,
+          "num_threads must be positive");
+    }
+    crypto::tink::util::Status status = ValidateKeyset(keyset);
+    if (!status.ok()) return status;
+    std::vector<const google::crypto::tink::Keyset::Key*> enabled_keys;
+    for (const google::crypto::tink::Keyset::Key& key : keyset.key()) {
+      if (key.status() == google::crypto::tink::KeyStatusType::ENABLED) {
+        enabled_keys.push_back(&key);
+      }
+    }
+    std::vector<std::shared_ptr<P>> key_primitives(enabled_keys.size());
+    status = CreatePrimitives(enabled_keys, num_threads, &key_primitives);
+    if (!status.ok()) return status;
+
+    std::unique_ptr<PrimitiveSet<P>> primitives =
+        absl::make_unique<PrimitiveSet<P>>();
+    for (size_t i = 0; i < enabled_keys.size(); ++i) {
+      const google::crypto::tink::Keyset::Key& key = *enabled_keys[i];
+      auto entry = primitives->AddSharedPrimitive(std::move(key_primitives[i]),
+                                                  KeyInfoFromKey(key));
+      if (!entry.ok()) return entry.status();
+      if (key.key_id() == keyset.primary_key_id()) {
+        auto primary_result = primitives->set_primary(entry.ValueOrDie());
+        if (!primary_result.ok()) return primary_result;
+      }
+    }
+    // The wrapper owns the set from now on and only reads from it.
+    primitives->Freeze();
+    return transforming_wrapper_.Wrap(std::move(primitives));
+  }
+
+  crypto::tink::util::StatusOr<std::unique_ptr<Q>> WrapLazily(
       const google::crypto::tink::Keyset& keyset) const override {
+    if (!transforming_wrapper_.SupportsLazyPrimitives()) return Wrap(keyset);
     crypto::tink::util::Status status = ValidateKeyset(keyset);
     if (!status.ok()) return status;
     std::unique_ptr<PrimitiveSet<P>> primitives =
@@ -50,23 +118,83 @@ class KeysetWrapperImpl : public KeysetWrapper<Q> {
       if (key.status() != google::crypto::tink::KeyStatusType::ENABLED) {
         continue;
       }
+      if (key.key_id() != keyset.primary_key_id()) {
+        // The factory keeps its own copies, as the wrapped primitive may
+        // outlive both the keyset and this wrapper.
+        SharedGetter getter = primitive_getter_;
+        google::crypto::tink::KeyData key_data = key.key_data();
+        auto entry = primitives->AddLazySharedPrimitive(
+            [getter, key_data]() { return getter(key_data); },
+            KeyInfoFromKey(key));
+        if (!entry.ok()) return entry.status();
+        continue;
+      }
       auto primitive = primitive_getter_(key.key_data());
       if (!primitive.ok()) return primitive.status();
-      auto entry = primitives->AddPrimitive(std::move(primitive.ValueOrDie()),
-                                            KeyInfoFromKey(key));
+      auto entry = primitives->AddSharedPrimitive(
+          std::move(primitive.ValueOrDie()), KeyInfoFromKey(key));
       if (!entry.ok()) return entry.status();
-      if (key.key_id() == keyset.primary_key_id()) {
-        auto primary_result = primitives->set_primary(entry.ValueOrDie());
-        if (!primary_result.ok()) return primary_result;
-      }
+      auto primary_result = primitives->set_primary(entry.ValueOrDie());
+      if (!primary_result.ok()) return primary_result;
     }
+    // The wrapper owns the set from now on and only reads from it.
+    primitives->Freeze();
     return transforming_wrapper_.Wrap(std::move(primitives));
   }
 
  private:
-  const std::function<crypto::tink::util::StatusOr<std::unique_ptr<P>>(
+  typedef std::function<crypto::tink::util::StatusOr<std::shared_ptr<P>>(
       const google::crypto::tink::KeyData& key_data)>
-      primitive_getter_;
+      SharedGetter;
+
+  // Distinguishes the constructor for shared primitives, since either kind of
+  // getter converts to the other's std::function type.
+  struct SharedTag {};
+
+  KeysetWrapperImpl(const PrimitiveWrapper<P, Q>* transforming_wrapper,
+                    SharedGetter primitive_getter, SharedTag)
+      : primitive_getter_(std::move(primitive_getter)),
+        transforming_wrapper_(*transforming_wrapper) {}
+
+  static SharedGetter ToSharedGetter(
+      std::function<crypto::tink::util::StatusOr<std::unique_ptr<P>>(
+          const google::crypto::tink::KeyData& key_data)>
+          primitive_getter) {
+    return [primitive_getter](const google::crypto::tink::KeyData& key_data)
+               -> crypto::tink::util::StatusOr<std::shared_ptr<P>> {
+      auto primitive_result = primitive_getter(key_data);
+      if (!primitive_result.ok()) return primitive_result.status();
+      return std::shared_ptr<P>(std::move(primitive_result.ValueOrDie()));
+    };
+  }
+
+  // Creates the primitive for each of 'keys' and stores it at the same index
+  // of 'primitives', using the calling thread and up to num_threads - 1 tasks
+  // on util::Executor::Global(). Keys are claimed in order, and keys claimed
+  // after a failure are skipped, so every key before the first failing one is
+  // processed.
+  crypto::tink::util::Status CreatePrimitives(
+      const std::vector<const google::crypto::tink::Keyset::Key*>& keys,
+      int num_threads, std::vector<std::shared_ptr<P>>* primitives) const {
+    std::vector<crypto::tink::util::Status> statuses(keys.size());
+    std::atomic<bool> failed(false);
+    util::ParallelFor(keys.size(), num_threads, [&](int64_t i) {
+      if (failed.load(std::memory_order_relaxed)) return;
+      auto primitive = primitive_getter_(keys[i]->key_data());
+      if (primitive.ok()) {
+        (*primitives)[i] = std::move(primitive.ValueOrDie());
+      } else {
+        statuses[i] = primitive.status();
+        failed.store(true, std::memory_order_relaxed);
+      }
+    });
+    for (const crypto::tink::util::Status& key_status : statuses) {
+      if (!key_status.ok()) return key_status;
+    }
+    return crypto::tink::util::Status::OK;
+  }
+
+  const SharedGetter primitive_getter_;
   const PrimitiveWrapper<P, Q>& transforming_wrapper_;
 };
 
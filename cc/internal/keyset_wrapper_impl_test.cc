@@ -19,6 +19,7 @@
 #include "gtest/gtest.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
 #include "tink/primitive_wrapper.h"
 #include "tink/util/test_matchers.h"
 #include "tink/util/test_util.h"
@@ -31,10 +32,14 @@ namespace {
 
 using ::crypto::tink::test::AddKeyData;
 using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::testing::Eq;
 using ::testing::HasSubstr;
 using ::testing::Not;
 using ::testing::Pair;
+using ::testing::SizeIs;
 using ::testing::UnorderedElementsAre;
+using ::testing::UnorderedElementsAreArray;
 
 using InputPrimitive = std::string;
 using OutputPrimitive = std::vector<std::pair<int, std::string>>;
@@ -59,6 +64,26 @@ class Wrapper : public PrimitiveWrapper<InputPrimitive, OutputPrimitive> {
   }
 };
 
+// Like Wrapper, but accepts lazily created entries. Each entry is reported
+// as "lazy" or as its primitive, so that tests can see which primitives were
+// created at wrap time.
+class LazyWrapper : public PrimitiveWrapper<InputPrimitive, OutputPrimitive> {
+ public:
+  crypto::tink::util::StatusOr<std::unique_ptr<OutputPrimitive>> Wrap(
+      std::unique_ptr<PrimitiveSet<InputPrimitive>> primitive_set)
+      const override {
+    auto result = absl::make_unique<OutputPrimitive>();
+    for (const auto* entry : primitive_set->get_all()) {
+      result->push_back(std::make_pair(
+          entry->get_key_id(),
+          entry->is_lazy() ? "lazy" : entry->get_primitive()));
+    }
+    return result;
+  }
+
+  bool SupportsLazyPrimitives() const override { return true; }
+};
+
 crypto::tink::util::StatusOr<std::unique_ptr<InputPrimitive>> CreateIn(
     const google::crypto::tink::KeyData& key_data) {
   if (absl::StartsWith(key_data.type_url(), "error:")) {
@@ -156,6 +181,124 @@ TEST(KeysetWrapperImplTest, OnlyEnabled) {
                                    Pair(444, "four")));
 }
 
+
+TEST(KeysetWrapperImplTest, ParallelMatchesSequential) {
+  Wrapper wrapper;
+  auto wrapper_or =
+      absl::make_unique<KeysetWrapperImpl<InputPrimitive, OutputPrimitive>>(
+          &wrapper, &CreateIn);
+  std::vector<std::pair<int, std::string>> keydata;
+  for (int i = 1; i <= 100; ++i) {
+    keydata.push_back({i, absl::StrCat("key ", i)});
+  }
+  google::crypto::tink::Keyset keyset = CreateKeyset(keydata);
+  keyset.set_primary_key_id(42);
+  keyset.mutable_key(10)->set_status(google::crypto::tink::DISABLED);
+
+  util::StatusOr<std::unique_ptr<OutputPrimitive>> sequential =
+      wrapper_or->Wrap(keyset);
+  ASSERT_THAT(sequential.status(), IsOk());
+  ASSERT_THAT(*sequential.ValueOrDie(), SizeIs(99));
+  for (int num_threads : {1, 2, 7, 100, 1000}) {
+    util::StatusOr<std::unique_ptr<OutputPrimitive>> parallel =
+        wrapper_or->Wrap(keyset, num_threads);
+    ASSERT_THAT(parallel.status(), IsOk()) << num_threads;
+    EXPECT_THAT(*parallel.ValueOrDie(),
+                UnorderedElementsAreArray(*sequential.ValueOrDie()))
+        << num_threads;
+  }
+}
+
+TEST(KeysetWrapperImplTest, ParallelReturnsFirstError) {
+  Wrapper wrapper;
+  auto wrapper_or =
+      absl::make_unique<KeysetWrapperImpl<InputPrimitive, OutputPrimitive>>(
+          &wrapper, &CreateIn);
+  std::vector<std::pair<int, std::string>> keydata;
+  for (int i = 1; i <= 50; ++i) {
+    keydata.push_back({i, absl::StrCat(i % 10 == 5 ? "error:" : "ok:", i)});
+  }
+  google::crypto::tink::Keyset keyset = CreateKeyset(keydata);
+  keyset.set_primary_key_id(1);
+
+  for (int num_threads : {1, 4, 50}) {
+    util::StatusOr<std::unique_ptr<OutputPrimitive>> wrapped =
+        wrapper_or->Wrap(keyset, num_threads);
+    ASSERT_THAT(wrapped.status(), Not(IsOk()));
+    EXPECT_THAT(wrapped.status().error_message(), Eq("error:5"))
+        << num_threads;
+  }
+}
+
+TEST(KeysetWrapperImplTest, ParallelRejectsNonPositiveThreadCount) {
+  Wrapper wrapper;
+  auto wrapper_or =
+      absl::make_unique<KeysetWrapperImpl<InputPrimitive, OutputPrimitive>>(
+          &wrapper, &CreateIn);
+  google::crypto::tink::Keyset keyset = CreateKeyset({{1, "one"}});
+  keyset.set_primary_key_id(1);
+
+  EXPECT_THAT(wrapper_or->Wrap(keyset, 0).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(wrapper_or->Wrap(keyset, -1).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(KeysetWrapperImplTest, LazyCreatesOnlyPrimary) {
+  LazyWrapper wrapper;
+  int num_calls = 0;
+  auto wrapper_or =
+      absl::make_unique<KeysetWrapperImpl<InputPrimitive, OutputPrimitive>>(
+          &wrapper, [&num_calls](const google::crypto::tink::KeyData& data) {
+            num_calls++;
+            return CreateIn(data);
+          });
+  google::crypto::tink::Keyset keyset =
+      CreateKeyset({{111, "one"}, {222, "two"}, {333, "error:three"}});
+  keyset.set_primary_key_id(222);
+
+  util::StatusOr<std::unique_ptr<OutputPrimitive>> wrapped =
+      wrapper_or->WrapLazily(keyset);
+
+  ASSERT_THAT(wrapped.status(), IsOk());
+  EXPECT_THAT(*wrapped.ValueOrDie(),
+              UnorderedElementsAre(Pair(111, "lazy"), Pair(222, "two"),
+                                   Pair(333, "lazy")));
+  EXPECT_THAT(num_calls, Eq(1));
+}
+
+TEST(KeysetWrapperImplTest, LazyFailingPrimary) {
+  LazyWrapper wrapper;
+  auto wrapper_or =
+      absl::make_unique<KeysetWrapperImpl<InputPrimitive, OutputPrimitive>>(
+          &wrapper, &CreateIn);
+  google::crypto::tink::Keyset keyset =
+      CreateKeyset({{1, "one"}, {2, "error:two"}});
+  keyset.set_primary_key_id(2);
+
+  util::StatusOr<std::unique_ptr<OutputPrimitive>> wrapped =
+      wrapper_or->WrapLazily(keyset);
+
+  ASSERT_THAT(wrapped.status(), Not(IsOk()));
+  EXPECT_THAT(wrapped.status().error_message(), HasSubstr("error:two"));
+}
+
+TEST(KeysetWrapperImplTest, LazyFallsBackToEagerWrapper) {
+  Wrapper wrapper;
+  auto wrapper_or =
+      absl::make_unique<KeysetWrapperImpl<InputPrimitive, OutputPrimitive>>(
+          &wrapper, &CreateIn);
+  google::crypto::tink::Keyset keyset = CreateKeyset({{1, "one"}, {2, "two"}});
+  keyset.set_primary_key_id(2);
+
+  util::StatusOr<std::unique_ptr<OutputPrimitive>> wrapped =
+      wrapper_or->WrapLazily(keyset);
+
+  ASSERT_THAT(wrapped.status(), IsOk());
+  EXPECT_THAT(*wrapped.ValueOrDie(),
+              UnorderedElementsAre(Pair(1, "one"), Pair(2, "two (primary)")));
+}
+
 }  // namespace
 
 }  // namespace tink
@@ -0,0 +1,57 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/internal/memory_usage.h"
+
+#include <string>
+
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace internal {
+
+namespace {
+
+using ::google::crypto::tink::KeyData;
+using ::google::crypto::tink::Keyset;
+
+// Non-empty string fields of messages are separately allocated strings.
+size_t StringFieldMemoryUsage(const std::string& field) {
+  if (field.empty()) return 0;
+  return sizeof(std::string) + StringMemoryUsage(field);
+}
+
+}  // namespace
+
+size_t KeysetMemoryUsage(const Keyset& keyset) {
+  // The repeated field holds an array of pointers to separately allocated
+  // keys.
+  size_t usage = keyset.key().Capacity() * sizeof(void*);
+  for (const Keyset::Key& key : keyset.key()) {
+    usage += sizeof(Keyset::Key);
+    if (key.has_key_data()) {
+      const KeyData& key_data = key.key_data();
+      usage += sizeof(KeyData) + StringFieldMemoryUsage(key_data.type_url()) +
+               StringFieldMemoryUsage(key_data.value());
+    }
+  }
+  return usage;
+}
+
+}  // namespace internal
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,51 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_INTERNAL_MEMORY_USAGE_H_
+#define TINK_INTERNAL_MEMORY_USAGE_H_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace internal {
+
+// Helpers for the EstimateMemoryUsage() methods of KeysetHandle and
+// PrimitiveSet. Estimates count the bytes requested from the allocator, not
+// the allocator's own per-block overhead.
+
+// Returns the heap bytes held by 's': none if it is stored inline (the small
+// string optimization), otherwise its capacity and terminator.
+inline size_t StringMemoryUsage(const std::string& s) {
+  std::less<const char*> less;
+  const char* data = s.data();
+  const char* object = reinterpret_cast<const char*>(&s);
+  if (!less(data, object) && less(data, object + sizeof(s))) return 0;
+  return s.capacity() + 1;
+}
+
+// Returns the heap bytes held by 'keyset', not counting sizeof(Keyset).
+size_t KeysetMemoryUsage(const google::crypto::tink::Keyset& keyset);
+
+}  // namespace internal
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_INTERNAL_MEMORY_USAGE_H_
@@ -0,0 +1,61 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/internal/memory_usage.h"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace internal {
+namespace {
+
+using ::google::crypto::tink::Keyset;
+using ::testing::Eq;
+using ::testing::Ge;
+
+TEST(MemoryUsageTest, String) {
+  EXPECT_THAT(StringMemoryUsage(std::string()), Eq(0));
+  std::string long_string(1000, 'a');
+  EXPECT_THAT(StringMemoryUsage(long_string),
+              Eq(long_string.capacity() + 1));
+}
+
+TEST(MemoryUsageTest, EmptyKeyset) {
+  EXPECT_THAT(KeysetMemoryUsage(Keyset()), Eq(0));
+}
+
+TEST(MemoryUsageTest, GrowsWithKeys) {
+  Keyset keyset;
+  Keyset::Key* key = keyset.add_key();
+  key->mutable_key_data()->set_type_url(
+      "type.googleapis.com/google.crypto.tink.AesGcmKey");
+  key->mutable_key_data()->set_value(std::string(32, 'k'));
+  size_t one_key = KeysetMemoryUsage(keyset);
+  EXPECT_THAT(one_key, Ge(sizeof(Keyset::Key) + 32));
+
+  keyset.add_key()->mutable_key_data()->set_value(std::string(1000, 'k'));
+  EXPECT_THAT(KeysetMemoryUsage(keyset), Ge(one_key + 1000));
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace tink
+}  // namespace crypto
@@ -15,6 +15,12 @@
 ///////////////////////////////////////////////////////////////////////////////
 #include "tink/internal/registry_impl.h"
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "openssl/sha.h"
 #include "tink/util/errors.h"
 #include "tink/util/statusor.h"
 #include "proto/tink.pb.h"
@@ -29,7 +35,14 @@ namespace internal {
 
 StatusOr<const RegistryImpl::KeyTypeInfo*> RegistryImpl::get_key_type_info(
     absl::string_view type_url) const {
-  absl::MutexLock lock(&maps_mutex_);
+  {
+    absl::MutexLockMaybe lock(maps_read_mutex());
+    auto it = type_url_to_info_.find(type_url);
+    if (it != type_url_to_info_.end()) return &it->second;
+  }
+  util::Status status = RunLazyRegistration(type_url);
+  if (!status.ok()) return status;
+  absl::MutexLockMaybe lock(maps_read_mutex());
   auto it = type_url_to_info_.find(type_url);
   if (it == type_url_to_info_.end()) {
     return ToStatusF(util::error::NOT_FOUND,
@@ -38,18 +51,76 @@ StatusOr<const RegistryImpl::KeyTypeInfo*> RegistryImpl::get_key_type_info(
   return &it->second;
 }
 
-StatusOr<std::unique_ptr<KeyData>> RegistryImpl::NewKeyData(
-    const KeyTemplate& key_template) const {
-  auto key_type_info_or = get_key_type_info(key_template.type_url());
+util::Status RegistryImpl::RegisterLazily(
+    const std::vector<std::string>& type_urls,
+    std::function<util::Status()> registration) {
+  if (!registration) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "Parameter 'registration' must be non-empty.");
+  }
+  auto lazy_registration =
+      std::make_shared<LazyRegistration>(std::move(registration));
+  absl::MutexLock lock(&maps_mutex_);
+  util::Status status = CheckNotFrozen();
+  if (!status.ok()) return status;
+  for (const std::string& type_url : type_urls) {
+    lazy_registrations_.emplace(type_url, lazy_registration);
+  }
+  return util::OkStatus();
+}
+
+util::Status RegistryImpl::LazyRegistration::Run() {
+  absl::MutexLock lock(&mutex);
+  if (!done) {
+    status = registration();
+    done = true;
+  }
+  return status;
+}
+
+util::Status RegistryImpl::RunLazyRegistration(
+    absl::string_view type_url) const {
+  std::shared_ptr<LazyRegistration> lazy_registration;
+  {
+    absl::MutexLockMaybe lock(maps_read_mutex());
+    auto it = lazy_registrations_.find(type_url);
+    if (it == lazy_registrations_.end()) {
+      return ToStatusF(util::error::NOT_FOUND,
+                       "No manager for type '%s' has been registered.",
+                       type_url);
+    }
+    lazy_registration = it->second;
+  }
+  // The registration takes maps_mutex_ itself.
+  return lazy_registration->Run();
+}
+
+StatusOr<const KeyFactory*> RegistryImpl::GetNewKeyFactory(
+    absl::string_view type_url) const {
+  auto key_type_info_or = get_key_type_info(type_url);
   if (!key_type_info_or.ok()) return key_type_info_or.status();
   if (!key_type_info_or.ValueOrDie()->new_key_allowed()) {
     return crypto::tink::util::Status(
         util::error::INVALID_ARGUMENT,
-        absl::StrCat("KeyManager for type ", key_template.type_url(),
+        absl::StrCat("KeyManager for type ", type_url,
                      " does not allow for creation of new keys."));
   }
-  return key_type_info_or.ValueOrDie()->key_factory().NewKeyData(
-      key_template.value());
+  return &key_type_info_or.ValueOrDie()->key_factory();
+}
+
+StatusOr<std::unique_ptr<KeyData>> RegistryImpl::NewKeyData(
+    const KeyTemplate& key_template) const {
+  auto factory_or = GetNewKeyFactory(key_template.type_url());
+  if (!factory_or.ok()) return factory_or.status();
+  if (has_key_pools_.load(std::memory_order_acquire)) {
+    absl::MutexLock lock(&key_pools_mutex_);
+    auto it = key_pools_.find(KeyPoolId(key_template));
+    if (it != key_pools_.end()) {
+      std::unique_ptr<KeyData> key_data = it->second->Take();
+      if (key_data != nullptr) return std::move(key_data);
+    }
+  }
+  return factory_or.ValueOrDie()->NewKeyData(key_template.value());
 }
 
 StatusOr<std::unique_ptr<KeyData>> RegistryImpl::GetPublicKeyData(
@@ -69,6 +140,15 @@ StatusOr<std::unique_ptr<KeyData>> RegistryImpl::GetPublicKeyData(
   return result;
 }
 
+crypto::tink::util::Status RegistryImpl::CheckNotFrozen() const {
+  if (is_frozen()) {
+    return crypto::tink::util::Status(
+        crypto::tink::util::error::FAILED_PRECONDITION,
+        "Cannot modify the registry after it has been frozen.");
+  }
+  return crypto::tink::util::Status::OK;
+}
+
 crypto::tink::util::Status RegistryImpl::CheckInsertable(
     absl::string_view type_url, const std::type_index& key_manager_type_index,
     bool new_key_allowed) const {
@@ -106,11 +186,153 @@ RegistryImpl::DeriveKey(const google::crypto::tink::KeyTemplate& key_template,
                                                       randomness);
 }
 
+namespace {
+
+void HashWithLength(SHA256_CTX* ctx, absl::string_view data) {
+  uint64_t length = data.size();
+  SHA256_Update(ctx, &length, sizeof(length));
+  SHA256_Update(ctx, data.data(), data.size());
+}
+
+}  // namespace
+
+std::string RegistryImpl::InterningId(absl::string_view primitive_type,
+                                      const KeyData& key_data) {
+  SHA256_CTX ctx;
+  SHA256_Init(&ctx);
+  HashWithLength(&ctx, primitive_type);
+  HashWithLength(&ctx, key_data.type_url());
+  HashWithLength(&ctx, key_data.value());
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  SHA256_Final(digest, &ctx);
+  return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+std::shared_ptr<void> RegistryImpl::FindInterned(const std::string& id) const {
+  absl::MutexLock lock(&interning_mutex_);
+  auto it = interned_primitives_.find(id);
+  if (it == interned_primitives_.end()) return nullptr;
+  return it->second.lock();
+}
+
+std::shared_ptr<void> RegistryImpl::Intern(
+    const std::string& id, std::shared_ptr<void> primitive) const {
+  absl::MutexLock lock(&interning_mutex_);
+  std::weak_ptr<void>& interned = interned_primitives_[id];
+  std::shared_ptr<void> existing = interned.lock();
+  if (existing != nullptr) return existing;
+  interned = primitive;
+  if (interned_primitives_.size() > next_interning_sweep_) {
+    for (auto it = interned_primitives_.begin();
+         it != interned_primitives_.end();) {
+      if (it->second.expired()) {
+        interned_primitives_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    next_interning_sweep_ =
+        std::max<size_t>(64, 2 * interned_primitives_.size());
+  }
+  return primitive;
+}
+
+void RegistryImpl::SetPrimitiveInterning(bool enabled) {
+  absl::MutexLock lock(&interning_mutex_);
+  interning_enabled_.store(enabled, std::memory_order_release);
+  if (!enabled) {
+    interned_primitives_.clear();
+    next_interning_sweep_ = 0;
+  }
+}
+
+std::string RegistryImpl::KeyPoolId(const KeyTemplate& key_template) {
+  return absl::StrCat(key_template.type_url(), absl::string_view("\0", 1),
+                      key_template.value());
+}
+
+crypto::tink::util::Status RegistryImpl::SetKeyPool(
+    const KeyTemplate& key_template, int pool_size) {
+  if (pool_size < 0) {
+    return ToStatusF(util::error::INVALID_ARGUMENT,
+                     "Key pool size must be non-negative, got %d.", pool_size);
+  }
+  std::unique_ptr<KeyPool> pool;
+  if (pool_size > 0) {
+    auto factory_or = GetNewKeyFactory(key_template.type_url());
+    if (!factory_or.ok()) return factory_or.status();
+    // The factory is looked up for each key, so that keys are not generated
+    // once the type no longer allows it.
+    pool = absl::make_unique<KeyPool>(
+        [this, key_template]() -> StatusOr<std::unique_ptr<KeyData>> {
+          auto factory_or = GetNewKeyFactory(key_template.type_url());
+          if (!factory_or.ok()) return factory_or.status();
+          return factory_or.ValueOrDie()->NewKeyData(key_template.value());
+        },
+        pool_size);
+  }
+  // The replaced pool is destroyed after releasing the lock, as it may have
+  // to wait for a key generation to finish.
+  std::string id = KeyPoolId(key_template);
+  {
+    absl::MutexLock lock(&key_pools_mutex_);
+    if (pool == nullptr) {
+      auto it = key_pools_.find(id);
+      if (it != key_pools_.end()) {
+        pool = std::move(it->second);
+        key_pools_.erase(it);
+      }
+    } else {
+      std::swap(key_pools_[id], pool);
+    }
+    has_key_pools_.store(!key_pools_.empty(), std::memory_order_release);
+  }
+  return util::OkStatus();
+}
+
+int RegistryImpl::WaitForKeyPool(const KeyTemplate& key_template) {
+  absl::MutexLock lock(&key_pools_mutex_);
+  auto it = key_pools_.find(KeyPoolId(key_template));
+  if (it == key_pools_.end()) return 0;
+  return it->second->WaitUntilFull();
+}
+
+void RegistryImpl::RemoveKeyPools() {
+  absl::flat_hash_map<std::string, std::unique_ptr<KeyPool>> key_pools;
+  {
+    absl::MutexLock lock(&key_pools_mutex_);
+    key_pools.swap(key_pools_);
+    has_key_pools_.store(false, std::memory_order_release);
+  }
+}
+
 void RegistryImpl::Reset() {
+  // Pools generate keys with the key managers removed below.
+  RemoveKeyPools();
   absl::MutexLock lock(&maps_mutex_);
   type_url_to_info_.clear();
   name_to_catalogue_map_.clear();
+  lazy_registrations_.clear();
   primitive_to_wrapper_.clear();
+  frozen_.store(false, std::memory_order_release);
+  // Interned primitives may come from the key managers just removed.
+  SetPrimitiveInterning(false);
+}
+
+void RegistryImpl::Freeze() {
+  // Lazy registrations cannot run on a frozen registry.
+  std::vector<std::shared_ptr<LazyRegistration>> lazy_registrations;
+  {
+    absl::MutexLock lock(&maps_mutex_);
+    for (const auto& entry : lazy_registrations_) {
+      lazy_registrations.push_back(entry.second);
+    }
+  }
+  for (const auto& lazy_registration : lazy_registrations) {
+    lazy_registration->Run().IgnoreError();
+  }
+  absl::MutexLock lock(&maps_mutex_);
+  frozen_.store(true, std::memory_order_release);
 }
 
 }  // namespace internal
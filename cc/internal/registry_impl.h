@@ -17,10 +17,15 @@
 #define TINK_INTERNAL_REGISTRY_IMPL_H_
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
 #include <tuple>
 #include <typeindex>
 #include <typeinfo>
 #include <utility>
+#include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
@@ -36,6 +41,7 @@
 #include "tink/core/key_type_manager.h"
 #include "tink/core/private_key_manager_impl.h"
 #include "tink/core/private_key_type_manager.h"
+#include "tink/internal/key_pool.h"
 #include "tink/internal/keyset_wrapper.h"
 #include "tink/internal/keyset_wrapper_impl.h"
 #include "tink/key_manager.h"
@@ -96,6 +102,15 @@ class RegistryImpl {
           public_key_manager,
       bool new_key_allowed) ABSL_LOCKS_EXCLUDED(maps_mutex_);
 
+  // Makes the first lookup of any of the key types 'type_urls' run
+  // 'registration', which is to register the key managers for these types.
+  // Lookups of the types wait while it runs, and it only runs once, even if
+  // it fails. Types which already have a lazy registration keep it.
+  crypto::tink::util::Status RegisterLazily(
+      const std::vector<std::string>& type_urls,
+      std::function<crypto::tink::util::Status()> registration)
+      ABSL_LOCKS_EXCLUDED(maps_mutex_);
+
   template <class P>
   crypto::tink::util::StatusOr<const KeyManager<P>*> get_key_manager(
       absl::string_view type_url) const ABSL_LOCKS_EXCLUDED(maps_mutex_);
@@ -115,6 +130,14 @@ class RegistryImpl {
       absl::string_view type_url, const portable_proto::MessageLite& key) const
       ABSL_LOCKS_EXCLUDED(maps_mutex_);
 
+  // Same as GetPrimitive(key_data), but the returned primitive may be shared.
+  // While primitive interning is enabled, all callers asking for a P for the
+  // same key get the same primitive as long as any of them still holds it.
+  template <class P>
+  crypto::tink::util::StatusOr<std::shared_ptr<P>> GetSharedPrimitive(
+      const google::crypto::tink::KeyData& key_data) const
+      ABSL_LOCKS_EXCLUDED(maps_mutex_, interning_mutex_);
+
   crypto::tink::util::StatusOr<std::unique_ptr<google::crypto::tink::KeyData>>
   NewKeyData(const google::crypto::tink::KeyTemplate& key_template) const
       ABSL_LOCKS_EXCLUDED(maps_mutex_);
@@ -129,8 +152,17 @@ class RegistryImpl {
       std::unique_ptr<PrimitiveSet<P>> primitive_set) const
       ABSL_LOCKS_EXCLUDED(maps_mutex_);
 
+  // Creates the primitives of the keys in 'keyset' on up to 'num_threads'
+  // threads, and wraps them with the registered wrapper for P.
   template <class P>
   crypto::tink::util::StatusOr<std::unique_ptr<P>> WrapKeyset(
+      const google::crypto::tink::Keyset& keyset, int num_threads = 1) const
+      ABSL_LOCKS_EXCLUDED(maps_mutex_);
+
+  // Same as WrapKeyset(), but creates the primitives of non-primary keys only
+  // when they are first used, if the registered wrapper for P supports it.
+  template <class P>
+  crypto::tink::util::StatusOr<std::unique_ptr<P>> WrapKeysetLazily(
       const google::crypto::tink::Keyset& keyset) const
       ABSL_LOCKS_EXCLUDED(maps_mutex_);
 
@@ -140,6 +172,38 @@ class RegistryImpl {
 
   void Reset() ABSL_LOCKS_EXCLUDED(maps_mutex_);
 
+  // Makes the registry immutable. Afterwards all registrations and
+  // AddCatalogue() fail, and lookups read the maps without taking a lock.
+  // Pending lazy registrations are run first. Freezing an already frozen
+  // registry has no effect. Reset() unfreezes the registry.
+  void Freeze() ABSL_LOCKS_EXCLUDED(maps_mutex_);
+
+  // Returns true if Freeze() has been called since the last Reset().
+  bool is_frozen() const { return frozen_.load(std::memory_order_acquire); }
+
+  // Enables or disables interning of the primitives of keysets, see
+  // GetSharedPrimitive(). Disabling it forgets all interned primitives, but
+  // does not affect primitives already in use. Reset() disables interning.
+  void SetPrimitiveInterning(bool enabled)
+      ABSL_LOCKS_EXCLUDED(interning_mutex_);
+
+  // Returns true if primitive interning is enabled.
+  bool primitive_interning() const {
+    return interning_enabled_.load(std::memory_order_acquire);
+  }
+
+  // Keeps up to 'pool_size' keys for 'key_template' generated ahead of time on
+  // a background thread, which NewKeyData() returns while available. A
+  // 'pool_size' of 0 removes the pool. Reset() removes all pools.
+  crypto::tink::util::Status SetKeyPool(
+      const google::crypto::tink::KeyTemplate& key_template, int pool_size)
+      ABSL_LOCKS_EXCLUDED(maps_mutex_, key_pools_mutex_);
+
+  // Blocks until the pool for 'key_template' is full or its key generation
+  // failed, and returns the number of pooled keys, or 0 if there is no pool.
+  int WaitForKeyPool(const google::crypto::tink::KeyTemplate& key_template)
+      ABSL_LOCKS_EXCLUDED(key_pools_mutex_);
+
  private:
   // All information for a given type url.
   class KeyTypeInfo {
@@ -299,9 +363,10 @@ class RegistryImpl {
           wrapper_type_index_(std::type_index(typeid(*wrapper))),
           q_type_index_(std::type_index(typeid(Q))) {
       auto keyset_wrapper_unique_ptr =
-          absl::make_unique<KeysetWrapperImpl<P, Q>>(
+          KeysetWrapperImpl<P, Q>::NewWithSharedPrimitives(
               wrapper.get(), [](const google::crypto::tink::KeyData& key_data) {
-                return RegistryImpl::GlobalInstance().GetPrimitive<P>(key_data);
+                return RegistryImpl::GlobalInstance().GetSharedPrimitive<P>(
+                    key_data);
               });
       keyset_wrapper_ = std::move(keyset_wrapper_unique_ptr);
       original_wrapper_ = std::move(wrapper);
@@ -385,19 +450,77 @@ class RegistryImpl {
   crypto::tink::util::StatusOr<const KeysetWrapper<P>*> GetKeysetWrapper() const
       ABSL_LOCKS_EXCLUDED(maps_mutex_);
 
+  // A registration passed to RegisterLazily().
+  struct LazyRegistration {
+    explicit LazyRegistration(
+        std::function<crypto::tink::util::Status()> registration)
+        : registration(std::move(registration)) {}
+
+    // Runs the registration unless it has run before, and returns its status.
+    crypto::tink::util::Status Run() ABSL_LOCKS_EXCLUDED(mutex);
+
+    const std::function<crypto::tink::util::Status()> registration;
+    absl::Mutex mutex;
+    bool done ABSL_GUARDED_BY(mutex) = false;
+    crypto::tink::util::Status status ABSL_GUARDED_BY(mutex);
+  };
+
   // Returns the key type info for a given type URL. Since we never replace
   // key type infos, the pointers will stay valid for the lifetime of the
   // binary.
   crypto::tink::util::StatusOr<const KeyTypeInfo*> get_key_type_info(
       absl::string_view type_url) const ABSL_LOCKS_EXCLUDED(maps_mutex_);
 
+  // Runs the lazy registration for 'type_url'. Returns NOT_FOUND if there is
+  // none, and otherwise the status of the registration.
+  crypto::tink::util::Status RunLazyRegistration(
+      absl::string_view type_url) const ABSL_LOCKS_EXCLUDED(maps_mutex_);
+
   // Returns OK if the key manager with the given type index can be inserted
   // for type url type_url and parameter new_key_allowed. Otherwise returns
   // an error to be returned to the user.
+  // Returns an error if the registry is frozen and must not be modified.
+  crypto::tink::util::Status CheckNotFrozen() const
+      ABSL_SHARED_LOCKS_REQUIRED(maps_mutex_);
+
+  // Returns the mutex lookups have to hold while reading the maps, or nullptr
+  // once the registry is frozen, at which point the maps never change again.
+  absl::Mutex* maps_read_mutex() const ABSL_LOCK_RETURNED(maps_mutex_) {
+    return is_frozen() ? nullptr : &maps_mutex_;
+  }
+
   crypto::tink::util::Status CheckInsertable(
       absl::string_view type_url, const std::type_index& key_manager_type_index,
       bool new_key_allowed) const ABSL_SHARED_LOCKS_REQUIRED(maps_mutex_);
 
+  // Returns the key factory for 'type_url', or an error if the type is not
+  // registered or does not allow creating new keys.
+  crypto::tink::util::StatusOr<const KeyFactory*> GetNewKeyFactory(
+      absl::string_view type_url) const ABSL_LOCKS_EXCLUDED(maps_mutex_);
+
+  // Returns the key under which the pool for 'key_template' is stored.
+  static std::string KeyPoolId(
+      const google::crypto::tink::KeyTemplate& key_template);
+
+  // Removes all key pools, waiting for key generations in progress.
+  void RemoveKeyPools() ABSL_LOCKS_EXCLUDED(key_pools_mutex_);
+
+  // Returns the id under which the primitive of type 'primitive_type' for
+  // 'key_data' is interned. This is a SHA-256 digest, so that the interning
+  // map does not keep copies of key material.
+  static std::string InterningId(absl::string_view primitive_type,
+                                 const google::crypto::tink::KeyData& key_data);
+
+  // Returns the live primitive interned as 'id', or nullptr.
+  std::shared_ptr<void> FindInterned(const std::string& id) const
+      ABSL_LOCKS_EXCLUDED(interning_mutex_);
+
+  // Interns 'primitive' as 'id' and returns it, unless another live primitive
+  // has been interned as 'id' meanwhile, which is then returned instead.
+  std::shared_ptr<void> Intern(const std::string& id,
+                               std::shared_ptr<void> primitive) const
+      ABSL_LOCKS_EXCLUDED(interning_mutex_);
+
   mutable absl::Mutex maps_mutex_;
   // A map from the type_url to the given KeyTypeInfo. Once emplaced KeyTypeInfo
   // objects must remain valid throughout the life time of the binary. Hence,
@@ -414,6 +537,31 @@ class RegistryImpl {
 
   absl::flat_hash_map<std::string, LabelInfo> name_to_catalogue_map_
       ABSL_GUARDED_BY(maps_mutex_);
+  // The registrations passed to RegisterLazily(), by type URL. Entries stay
+  // after their registration ran.
+  absl::flat_hash_map<std::string, std::shared_ptr<LazyRegistration>>
+      lazy_registrations_ ABSL_GUARDED_BY(maps_mutex_);
+
+  // Set by Freeze() while holding maps_mutex_, after which the maps above are
+  // read-only until Reset().
+  std::atomic<bool> frozen_{false};
+
+  mutable absl::Mutex interning_mutex_;
+  // Maps InterningId() to the primitive, of the type named in the id. Entries
+  // of destroyed primitives are removed whenever the map has doubled in size.
+  mutable absl::flat_hash_map<std::string, std::weak_ptr<void>>
+      interned_primitives_ ABSL_GUARDED_BY(interning_mutex_);
+  mutable size_t next_interning_sweep_ ABSL_GUARDED_BY(interning_mutex_) = 0;
+  std::atomic<bool> interning_enabled_{false};
+
+  // Declared last, so that the pools stop generating keys before the key
+  // managers they use are destroyed.
+  mutable absl::Mutex key_pools_mutex_;
+  absl::flat_hash_map<std::string, std::unique_ptr<KeyPool>> key_pools_
+      ABSL_GUARDED_BY(key_pools_mutex_);
+  // True while key_pools_ may be non-empty, so that NewKeyData() does not
+  // take key_pools_mutex_ if no pool has been set.
+  std::atomic<bool> has_key_pools_{false};
 };
 
 template <class P>
@@ -426,6 +574,8 @@ crypto::tink::util::Status RegistryImpl::AddCatalogue(
   }
   std::shared_ptr<void> entry(catalogue);
   absl::MutexLock lock(&maps_mutex_);
+  crypto::tink::util::Status frozen_status = CheckNotFrozen();
+  if (!frozen_status.ok()) return frozen_status;
   auto curr_catalogue = name_to_catalogue_map_.find(catalogue_name);
   if (curr_catalogue != name_to_catalogue_map_.end()) {
     auto existing =
@@ -448,7 +598,7 @@ crypto::tink::util::Status RegistryImpl::AddCatalogue(
 template <class P>
 crypto::tink::util::StatusOr<const Catalogue<P>*> RegistryImpl::get_catalogue(
     absl::string_view catalogue_name) const {
-  absl::MutexLock lock(&maps_mutex_);
+  absl::MutexLockMaybe lock(maps_read_mutex());
   auto catalogue_entry = name_to_catalogue_map_.find(catalogue_name);
   if (catalogue_entry == name_to_catalogue_map_.end()) {
     return ToStatusF(crypto::tink::util::error::NOT_FOUND,
@@ -479,7 +629,9 @@ crypto::tink::util::Status RegistryImpl::RegisterKeyManager(
                      "The manager does not support type '%s'.", type_url);
   }
   absl::MutexLock lock(&maps_mutex_);
-  crypto::tink::util::Status status = CheckInsertable(
+  crypto::tink::util::Status status = CheckNotFrozen();
+  if (!status.ok()) return status;
+  status = CheckInsertable(
       type_url, std::type_index(typeid(*owned_manager)), new_key_allowed);
   if (!status.ok()) return status;
 
@@ -506,6 +658,8 @@ crypto::tink::util::Status RegistryImpl::RegisterKeyTypeManager(
   }
   std::string type_url = owned_manager->get_key_type();
   absl::MutexLock lock(&maps_mutex_);
+  crypto::tink::util::Status frozen_status = CheckNotFrozen();
+  if (!frozen_status.ok()) return frozen_status;
 
   // Check FIPS status
   FipsCompatibility fips_compatible = owned_manager->FipsStatus();
@@ -557,6 +711,8 @@ crypto::tink::util::Status RegistryImpl::RegisterAsymmetricKeyManagers(
   std::string public_type_url = public_key_manager->get_key_type();
 
   absl::MutexLock lock(&maps_mutex_);
+  crypto::tink::util::Status frozen_status = CheckNotFrozen();
+  if (!frozen_status.ok()) return frozen_status;
 
   // Check FIPS status
   auto private_fips_status =
@@ -674,6 +830,8 @@ crypto::tink::util::Status RegistryImpl::RegisterPrimitiveWrapper(
   std::unique_ptr<PrimitiveWrapper<P, Q>> entry(wrapper);
 
   absl::MutexLock lock(&maps_mutex_);
+  crypto::tink::util::Status frozen_status = CheckNotFrozen();
+  if (!frozen_status.ok()) return frozen_status;
   auto it = primitive_to_wrapper_.find(std::type_index(typeid(Q)));
   if (it != primitive_to_wrapper_.end()) {
     if (!it->second.HasSameType(*wrapper)) {
@@ -693,7 +851,16 @@ crypto::tink::util::Status RegistryImpl::RegisterPrimitiveWrapper(
 template <class P>
 crypto::tink::util::StatusOr<const KeyManager<P>*>
 RegistryImpl::get_key_manager(absl::string_view type_url) const {
-  absl::MutexLock lock(&maps_mutex_);
+  {
+    absl::MutexLockMaybe lock(maps_read_mutex());
+    auto it = type_url_to_info_.find(type_url);
+    if (it != type_url_to_info_.end()) {
+      return it->second.get_key_manager<P>(type_url);
+    }
+  }
+  crypto::tink::util::Status status = RunLazyRegistration(type_url);
+  if (!status.ok()) return status;
+  absl::MutexLockMaybe lock(maps_read_mutex());
   auto it = type_url_to_info_.find(type_url);
   if (it == type_url_to_info_.end()) {
     return ToStatusF(crypto::tink::util::error::NOT_FOUND,
@@ -722,10 +889,30 @@ crypto::tink::util::StatusOr<std::unique_ptr<P>> RegistryImpl::GetPrimitive(
   return key_manager_result.status();
 }
 
+template <class P>
+crypto::tink::util::StatusOr<std::shared_ptr<P>>
+RegistryImpl::GetSharedPrimitive(
+    const google::crypto::tink::KeyData& key_data) const {
+  if (!primitive_interning()) {
+    auto primitive_result = GetPrimitive<P>(key_data);
+    if (!primitive_result.ok()) return primitive_result.status();
+    return std::shared_ptr<P>(std::move(primitive_result.ValueOrDie()));
+  }
+  std::string id = InterningId(typeid(P).name(), key_data);
+  std::shared_ptr<void> interned = FindInterned(id);
+  if (interned != nullptr) return std::static_pointer_cast<P>(interned);
+  // The primitive is created without holding a lock, so that keysets with
+  // distinct keys do not wait for each other.
+  auto primitive_result = GetPrimitive<P>(key_data);
+  if (!primitive_result.ok()) return primitive_result.status();
+  std::shared_ptr<P> primitive(std::move(primitive_result.ValueOrDie()));
+  return std::static_pointer_cast<P>(Intern(id, std::move(primitive)));
+}
+
 template <class P>
 crypto::tink::util::StatusOr<const PrimitiveWrapper<P, P>*>
 RegistryImpl::GetLegacyWrapper() const {
-  absl::MutexLock lock(&maps_mutex_);
+  absl::MutexLockMaybe lock(maps_read_mutex());
   auto it = primitive_to_wrapper_.find(std::type_index(typeid(P)));
   if (it == primitive_to_wrapper_.end()) {
     return util::Status(
@@ -738,7 +925,7 @@ RegistryImpl::GetLegacyWrapper() const {
 template <class P>
 crypto::tink::util::StatusOr<const KeysetWrapper<P>*>
 RegistryImpl::GetKeysetWrapper() const {
-  absl::MutexLock lock(&maps_mutex_);
+  absl::MutexLockMaybe lock(maps_read_mutex());
   auto it = primitive_to_wrapper_.find(std::type_index(typeid(P)));
   if (it == primitive_to_wrapper_.end()) {
     return util::Status(
@@ -756,6 +943,8 @@ crypto::tink::util::StatusOr<std::unique_ptr<P>> RegistryImpl::Wrap(
         crypto::tink::util::error::INVALID_ARGUMENT,
         "Parameter 'primitive_set' must be non-null.");
   }
+  // The wrapper owns the set from now on and only reads from it.
+  primitive_set->Freeze();
   util::StatusOr<const PrimitiveWrapper<P, P>*> wrapper_result =
       GetLegacyWrapper<P>();
   if (!wrapper_result.ok()) {
@@ -768,17 +957,29 @@ crypto::tink::util::StatusOr<std::unique_ptr<P>> RegistryImpl::Wrap(
 
 template <class P>
 crypto::tink::util::StatusOr<std::unique_ptr<P>> RegistryImpl::WrapKeyset(
-    const google::crypto::tink::Keyset& keyset) const {
+    const google::crypto::tink::Keyset& keyset, int num_threads) const {
   util::StatusOr<const KeysetWrapper<P>*> wrapper_result =
       GetKeysetWrapper<P>();
   if (!wrapper_result.ok()) {
     return wrapper_result.status();
   }
   crypto::tink::util::StatusOr<std::unique_ptr<P>> primitive_result =
-      wrapper_result.ValueOrDie()->Wrap(keyset);
+      wrapper_result.ValueOrDie()->Wrap(keyset, num_threads);
   return std::move(primitive_result);
 }
 
+template <class P>
+crypto::tink::util::StatusOr<std::unique_ptr<P>>
+RegistryImpl::WrapKeysetLazily(
+    const google::crypto::tink::Keyset& keyset) const {
+  util::StatusOr<const KeysetWrapper<P>*> wrapper_result =
+      GetKeysetWrapper<P>();
+  if (!wrapper_result.ok()) {
+    return wrapper_result.status();
+  }
+  return wrapper_result.ValueOrDie()->WrapLazily(keyset);
+}
+
 }  // namespace internal
 }  // namespace tink
 }  // namespace crypto
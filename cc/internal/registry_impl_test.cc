@@ -15,6 +15,8 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include <memory>
+#include <set>
+#include <string>
 #include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
@@ -475,6 +477,314 @@ TEST_F(RegistryTest, GetKeyManagerRemainsValid) {
   EXPECT_THAT(key_manager.ValueOrDie()->get_key_type(), Eq(key_type));
 }
 
+TEST_F(RegistryTest, FreezeRejectsModifications) {
+  std::string key_type = AesGcmKeyManager().get_key_type();
+  ASSERT_THAT(Registry::RegisterKeyManager(
+                  absl::make_unique<TestAeadKeyManager>(key_type), true),
+              IsOk());
+  Registry::Freeze();
+  EXPECT_TRUE(RegistryImpl::GlobalInstance().is_frozen());
+
+  // Lookups still work.
+  auto manager_result = Registry::get_key_manager<Aead>(key_type);
+  ASSERT_THAT(manager_result.status(), IsOk());
+  EXPECT_EQ(manager_result.ValueOrDie()->get_key_type(), key_type);
+  EXPECT_THAT(Registry::get_key_manager<Aead>("some other key type").status(),
+              StatusIs(util::error::NOT_FOUND));
+
+  // Registrations fail, even if they would not change anything.
+  EXPECT_THAT(Registry::RegisterKeyManager(
+                  absl::make_unique<TestAeadKeyManager>(key_type), true),
+              StatusIs(util::error::FAILED_PRECONDITION));
+  EXPECT_THAT(Registry::RegisterKeyManager(
+                  absl::make_unique<TestAeadKeyManager>("some other key type"),
+                  true),
+              StatusIs(util::error::FAILED_PRECONDITION));
+  EXPECT_THAT(Registry::RegisterKeyTypeManager(
+                  absl::make_unique<AesGcmKeyManager>(), true),
+              StatusIs(util::error::FAILED_PRECONDITION));
+  EXPECT_THAT(
+      Registry::RegisterPrimitiveWrapper(absl::make_unique<AeadWrapper>()),
+      StatusIs(util::error::FAILED_PRECONDITION));
+  EXPECT_THAT(Registry::get_key_manager<Aead>("some other key type").status(),
+              StatusIs(util::error::NOT_FOUND));
+
+  // Freezing again has no effect, and Reset() unfreezes the registry.
+  Registry::Freeze();
+  Registry::Reset();
+  EXPECT_FALSE(RegistryImpl::GlobalInstance().is_frozen());
+  EXPECT_THAT(Registry::RegisterKeyManager(
+                  absl::make_unique<TestAeadKeyManager>(key_type), true),
+              IsOk());
+}
+
+TEST_F(RegistryTest, LazyRegistrationRunsOnFirstLookup) {
+  std::string key_type = AesGcmKeyManager().get_key_type();
+  int runs = 0;
+  ASSERT_THAT(RegistryImpl::GlobalInstance().RegisterLazily(
+                  {key_type},
+                  [&runs]() {
+                    ++runs;
+                    return Registry::RegisterKeyTypeManager(
+                        absl::make_unique<AesGcmKeyManager>(), true);
+                  }),
+              IsOk());
+  EXPECT_EQ(runs, 0);
+
+  EXPECT_THAT(Registry::get_key_manager<Aead>(key_type).status(), IsOk());
+  EXPECT_EQ(runs, 1);
+  AesGcmKeyFormat key_format;
+  key_format.set_key_size(16);
+  KeyTemplate key_template;
+  key_template.set_type_url(key_type);
+  key_template.set_value(key_format.SerializeAsString());
+  EXPECT_THAT(Registry::NewKeyData(key_template).status(), IsOk());
+  EXPECT_EQ(runs, 1);
+
+  EXPECT_THAT(Registry::get_key_manager<Aead>("some other key type").status(),
+              StatusIs(util::error::NOT_FOUND));
+}
+
+TEST_F(RegistryTest, LazyRegistrationErrorIsReturnedByLookups) {
+  std::string key_type = AesGcmKeyManager().get_key_type();
+  int runs = 0;
+  ASSERT_THAT(RegistryImpl::GlobalInstance().RegisterLazily(
+                  {key_type},
+                  [&runs]() {
+                    ++runs;
+                    return util::Status(util::error::INTERNAL, "failed");
+                  }),
+              IsOk());
+  EXPECT_THAT(Registry::get_key_manager<Aead>(key_type).status(),
+              StatusIs(util::error::INTERNAL));
+  EXPECT_THAT(Registry::get_key_manager<Aead>(key_type).status(),
+              StatusIs(util::error::INTERNAL));
+  EXPECT_EQ(runs, 1);
+}
+
+TEST_F(RegistryTest, RegisterKeyTypeManagerLazily) {
+  ASSERT_THAT(Registry::RegisterKeyTypeManagerLazily<AesGcmKeyManager>(true),
+              IsOk());
+  std::string key_type = AesGcmKeyManager().get_key_type();
+  auto manager_result = Registry::get_key_manager<Aead>(key_type);
+  ASSERT_THAT(manager_result.status(), IsOk());
+  EXPECT_EQ(manager_result.ValueOrDie()->get_key_type(), key_type);
+  // Eager registrations of the same manager still succeed.
+  EXPECT_THAT(Registry::RegisterKeyTypeManager(
+                  absl::make_unique<AesGcmKeyManager>(), true),
+              IsOk());
+}
+
+TEST_F(RegistryTest, FreezeRunsLazyRegistrations) {
+  std::string key_type = AesGcmKeyManager().get_key_type();
+  int runs = 0;
+  ASSERT_THAT(RegistryImpl::GlobalInstance().RegisterLazily(
+                  {key_type},
+                  [&runs]() {
+                    ++runs;
+                    return Registry::RegisterKeyTypeManager(
+                        absl::make_unique<AesGcmKeyManager>(), true);
+                  }),
+              IsOk());
+  Registry::Freeze();
+  EXPECT_EQ(runs, 1);
+  EXPECT_THAT(Registry::get_key_manager<Aead>(key_type).status(), IsOk());
+  EXPECT_THAT(Registry::RegisterKeyTypeManagerLazily<AesGcmKeyManager>(true),
+              StatusIs(util::error::FAILED_PRECONDITION));
+
+  // Reset() forgets lazy registrations.
+  Registry::Reset();
+  EXPECT_THAT(Registry::get_key_manager<Aead>(key_type).status(),
+              StatusIs(util::error::NOT_FOUND));
+  EXPECT_EQ(runs, 1);
+}
+
+TEST_F(RegistryTest, ConcurrentLookupsWhenFrozen) {
+  std::string key_type_prefix_a = "key_type_a_";
+  std::string key_type_prefix_b = "key_type_b_";
+  int count_a = 42;
+  int count_b = 72;
+  register_test_managers(key_type_prefix_a, count_a);
+  register_test_managers(key_type_prefix_b, count_b);
+  Registry::Freeze();
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back(verify_test_managers, key_type_prefix_a, count_a);
+    threads.emplace_back(verify_test_managers, key_type_prefix_b, count_b);
+  }
+  for (auto& thread : threads) thread.join();
+}
+
+KeyData TestKeyData(const std::string& key_type, const std::string& value) {
+  KeyData key_data;
+  key_data.set_type_url(key_type);
+  key_data.set_value(value);
+  key_data.set_key_material_type(KeyData::SYMMETRIC);
+  return key_data;
+}
+
+TEST_F(RegistryTest, PrimitiveInterningSharesPrimitivesOfSameKey) {
+  std::string key_type = AesGcmKeyManager().get_key_type();
+  ASSERT_THAT(Registry::RegisterKeyManager(
+                  absl::make_unique<TestAeadKeyManager>(key_type), true),
+              IsOk());
+  KeyData key_data = TestKeyData(key_type, "some key");
+  RegistryImpl& registry = RegistryImpl::GlobalInstance();
+
+  // Disabled by default.
+  EXPECT_FALSE(registry.primitive_interning());
+  auto first = registry.GetSharedPrimitive<Aead>(key_data);
+  auto second = registry.GetSharedPrimitive<Aead>(key_data);
+  ASSERT_THAT(first.status(), IsOk());
+  ASSERT_THAT(second.status(), IsOk());
+  EXPECT_NE(first.ValueOrDie(), second.ValueOrDie());
+
+  Registry::SetPrimitiveInterning(true);
+  EXPECT_TRUE(registry.primitive_interning());
+  auto interned = registry.GetSharedPrimitive<Aead>(key_data);
+  auto interned_again = registry.GetSharedPrimitive<Aead>(key_data);
+  auto other_key = registry.GetSharedPrimitive<Aead>(
+      TestKeyData(key_type, "some other key"));
+  ASSERT_THAT(interned.status(), IsOk());
+  ASSERT_THAT(interned_again.status(), IsOk());
+  ASSERT_THAT(other_key.status(), IsOk());
+  EXPECT_EQ(interned.ValueOrDie(), interned_again.ValueOrDie());
+  EXPECT_NE(interned.ValueOrDie(), other_key.ValueOrDie());
+
+  // Disabling interning forgets the interned primitives.
+  Registry::SetPrimitiveInterning(false);
+  auto not_interned = registry.GetSharedPrimitive<Aead>(key_data);
+  ASSERT_THAT(not_interned.status(), IsOk());
+  EXPECT_NE(interned.ValueOrDie(), not_interned.ValueOrDie());
+}
+
+TEST_F(RegistryTest, PrimitiveInterningDoesNotKeepPrimitivesAlive) {
+  std::string key_type = AesGcmKeyManager().get_key_type();
+  ASSERT_THAT(Registry::RegisterKeyManager(
+                  absl::make_unique<TestAeadKeyManager>(key_type), true),
+              IsOk());
+  Registry::SetPrimitiveInterning(true);
+  KeyData key_data = TestKeyData(key_type, "some key");
+  std::weak_ptr<Aead> weak;
+  {
+    auto primitive_result =
+        RegistryImpl::GlobalInstance().GetSharedPrimitive<Aead>(key_data);
+    ASSERT_THAT(primitive_result.status(), IsOk());
+    weak = primitive_result.ValueOrDie();
+  }
+  EXPECT_TRUE(weak.expired());
+
+  // Reset() disables interning.
+  Registry::Reset();
+  EXPECT_FALSE(RegistryImpl::GlobalInstance().primitive_interning());
+}
+
+TEST_F(RegistryTest, PrimitiveInterningSharesAcrossKeysets) {
+  std::string key_type = AesGcmKeyManager().get_key_type();
+  ASSERT_THAT(Registry::RegisterKeyManager(
+                  absl::make_unique<TestAeadKeyManager>(key_type), true),
+              IsOk());
+  ASSERT_THAT(
+      Registry::RegisterPrimitiveWrapper(absl::make_unique<AeadWrapper>()),
+      IsOk());
+  Registry::SetPrimitiveInterning(true);
+  AesGcmKey key;
+  key.set_key_value("0123456789abcdef");
+  Keyset keyset;
+  AddTinkKey(key_type, 42, key, KeyStatusType::ENABLED, KeyData::SYMMETRIC,
+             &keyset);
+  keyset.set_primary_key_id(42);
+
+  auto aead = RegistryImpl::GlobalInstance().WrapKeyset<Aead>(keyset);
+  ASSERT_THAT(aead.status(), IsOk());
+  // The keyset holds the interned primitive, which is therefore reused.
+  auto shared = RegistryImpl::GlobalInstance().GetSharedPrimitive<Aead>(
+      keyset.key(0).key_data());
+  ASSERT_THAT(shared.status(), IsOk());
+  EXPECT_EQ(shared.ValueOrDie().use_count(), 2);
+
+  auto ciphertext = aead.ValueOrDie()->Encrypt("plaintext", "aad");
+  ASSERT_THAT(ciphertext.status(), IsOk());
+  auto plaintext = aead.ValueOrDie()->Decrypt(ciphertext.ValueOrDie(), "aad");
+  ASSERT_THAT(plaintext.status(), IsOk());
+  EXPECT_EQ(plaintext.ValueOrDie(), "plaintext");
+}
+
+KeyTemplate AesGcmTemplate() {
+  AesGcmKeyFormat key_format;
+  key_format.set_key_size(16);
+  KeyTemplate key_template;
+  key_template.set_type_url(AesGcmKeyManager().get_key_type());
+  key_template.set_value(key_format.SerializeAsString());
+  return key_template;
+}
+
+TEST_F(RegistryTest, KeyPoolReturnsPregeneratedKeys) {
+  ASSERT_THAT(Registry::RegisterKeyTypeManager(
+                  absl::make_unique<AesGcmKeyManager>(), true),
+              IsOk());
+  KeyTemplate key_template = AesGcmTemplate();
+  RegistryImpl& registry = RegistryImpl::GlobalInstance();
+  EXPECT_EQ(registry.WaitForKeyPool(key_template), 0);
+
+  ASSERT_THAT(Registry::SetKeyPool(key_template, 3), IsOk());
+  EXPECT_EQ(registry.WaitForKeyPool(key_template), 3);
+  std::set<std::string> keys;
+  for (int i = 0; i < 5; i++) {
+    auto key_data_result = Registry::NewKeyData(key_template);
+    ASSERT_THAT(key_data_result.status(), IsOk());
+    EXPECT_EQ(key_data_result.ValueOrDie()->type_url(),
+              key_template.type_url());
+    keys.insert(key_data_result.ValueOrDie()->value());
+  }
+  EXPECT_THAT(keys, SizeIs(5));
+  // The pool is refilled in the background.
+  EXPECT_EQ(registry.WaitForKeyPool(key_template), 3);
+
+  // Other templates of the same type are not pooled.
+  KeyTemplate other_template = key_template;
+  AesGcmKeyFormat key_format;
+  key_format.set_key_size(32);
+  other_template.set_value(key_format.SerializeAsString());
+  EXPECT_EQ(registry.WaitForKeyPool(other_template), 0);
+
+  ASSERT_THAT(Registry::SetKeyPool(key_template, 0), IsOk());
+  EXPECT_EQ(registry.WaitForKeyPool(key_template), 0);
+  EXPECT_THAT(Registry::NewKeyData(key_template).status(), IsOk());
+
+  ASSERT_THAT(Registry::SetKeyPool(key_template, 2), IsOk());
+  Registry::Reset();
+  EXPECT_EQ(registry.WaitForKeyPool(key_template), 0);
+}
+
+TEST_F(RegistryTest, KeyPoolRequiresNewKeys) {
+  KeyTemplate key_template = AesGcmTemplate();
+  EXPECT_THAT(Registry::SetKeyPool(key_template, 1),
+              StatusIs(util::error::NOT_FOUND));
+  ASSERT_THAT(Registry::RegisterKeyTypeManager(
+                  absl::make_unique<AesGcmKeyManager>(), false),
+              IsOk());
+  EXPECT_THAT(Registry::SetKeyPool(key_template, 1),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(Registry::SetKeyPool(key_template, -1),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(RegistryTest, KeyPoolForInvalidTemplateStaysEmpty) {
+  ASSERT_THAT(Registry::RegisterKeyTypeManager(
+                  absl::make_unique<AesGcmKeyManager>(), true),
+              IsOk());
+  KeyTemplate key_template = AesGcmTemplate();
+  AesGcmKeyFormat key_format;
+  key_format.set_key_size(17);
+  key_template.set_value(key_format.SerializeAsString());
+  ASSERT_THAT(Registry::SetKeyPool(key_template, 2), IsOk());
+  EXPECT_EQ(RegistryImpl::GlobalInstance().WaitForKeyPool(key_template), 0);
+  EXPECT_THAT(Registry::NewKeyData(key_template).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
 class TestAeadCatalogue : public Catalogue<Aead> {
  public:
   TestAeadCatalogue() {}
@@ -30,6 +30,8 @@ namespace tink {
 // A KeysetReader that can read from some source cleartext or
 // encrypted keysets in proto JSON wire format, cf.
 // https://developers.google.com/protocol-buffers/docs/encoding
+// The JSON is parsed in a single pass directly into the keyset proto, and
+// keysets from streams are parsed while they are read.
 class JsonKeysetReader : public KeysetReader {
  public:
   static crypto::tink::util::StatusOr<std::unique_ptr<KeysetReader>> New(
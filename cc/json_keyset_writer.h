@@ -18,8 +18,10 @@
 #define TINK_JSON_KEYSET_WRITER_H_
 
 #include <ostream>
+#include <string>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tink/keyset_writer.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
@@ -31,6 +33,10 @@ namespace tink {
 // A KeysetWriter that can write to some destination cleartext
 // or encrypted keysets in proto JSON wire format, cf.
 // https://developers.google.com/protocol-buffers/docs/encoding
+//
+// The JSON is generated directly, without building a document first, into a
+// buffer that is reused by later writes, and written to the destination with
+// a single write.
 class JsonKeysetWriter : public KeysetWriter {
  public:
   static crypto::tink::util::StatusOr<std::unique_ptr<JsonKeysetWriter>> New(
@@ -42,11 +48,21 @@ class JsonKeysetWriter : public KeysetWriter {
   crypto::tink::util::Status
   Write(const google::crypto::tink::EncryptedKeyset& encrypted_keyset) override;
 
+  // Writes all of 'encrypted_keysets' as a JSON array of encrypted keysets
+  // with a single write, e.g. for backups. The pointers must be non-null.
+  crypto::tink::util::Status WriteBatch(
+      absl::Span<const google::crypto::tink::EncryptedKeyset* const>
+          encrypted_keysets);
+
  private:
   explicit JsonKeysetWriter(std::unique_ptr<std::ostream> destination_stream)
       : destination_stream_(std::move(destination_stream)) {}
 
   std::unique_ptr<std::ostream> destination_stream_;
+  // Hold the JSON and the base64 of the current write. Cleartext keysets are
+  // wiped from them after they have been written.
+  std::string buffer_;
+  std::string scratch_;
 };
 
 }  // namespace tink
@@ -16,9 +16,13 @@
 
 #include "tink/jwt/internal/jwt_format.h"
 
-#include "absl/strings/escaping.h"
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "tink/jwt/internal/json_util.h"
+#include "tink/subtle/subtle_util.h"
 
 namespace crypto {
 namespace tink {
@@ -26,25 +30,131 @@ namespace jwt_internal {
 
 namespace {
 
-bool isValidUrlsafeBase64Char(char c) {
-  return (((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) ||
-          ((c >= '0') && (c <= '9')) || ((c == '-') || (c == '_')));
-}
+constexpr char kBase64UrlAlphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// The value of each base64url character, or kX.
+constexpr uint8_t kX = 0xff;
+constexpr uint8_t kBase64UrlValues[256] = {
+    kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX,
+    kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX,
+    kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, 62, kX, kX,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, kX, kX, kX, kX, kX, kX,
+    kX,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, kX, kX, kX, kX, 63,
+    kX, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, kX, kX, kX, kX, kX,
+    kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX,
+    kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX,
+    kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX,
+    kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX,
+    kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX,
+    kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX,
+    kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX,
+    kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX, kX,
+};
+
+// Algorithms use signatures of up to 512 bytes (RS512 with 4096-bit keys).
+constexpr size_t kMaxSignatureSize = 512;
 
 bool StrictWebSafeBase64Unescape(absl::string_view src, std::string* dest) {
-  for (char c : src) {
-    if (!isValidUrlsafeBase64Char(c)) {
-      return false;
-    }
+  subtle::ResizeStringUninitialized(dest, Base64UrlMaxDecodedSize(src.size()));
+  size_t size;
+  if (!Base64UrlDecode(src, &(*dest)[0], &size)) {
+    dest->clear();
+    return false;
   }
-  return absl::WebSafeBase64Unescape(src, dest);
+  dest->resize(size);
+  return true;
+}
+
+std::string EncodeBase64Url(absl::string_view data) {
+  std::string encoded;
+  subtle::ResizeStringUninitialized(&encoded,
+                                    Base64UrlEncodedSize(data.size()));
+  Base64UrlEncode(data, &encoded[0]);
+  return encoded;
+}
+
+void AppendBase64Url(absl::string_view data, std::string* out) {
+  size_t offset = out->size();
+  subtle::ResizeStringUninitialized(out,
+                                    offset + Base64UrlEncodedSize(data.size()));
+  Base64UrlEncode(data, &(*out)[offset]);
 }
 
 }  // namespace
 
+size_t Base64UrlEncodedSize(size_t size) { return (size * 4 + 2) / 3; }
+
+size_t Base64UrlMaxDecodedSize(size_t encoded_size) {
+  return encoded_size * 3 / 4;
+}
+
+void Base64UrlEncode(absl::string_view data, char* out) {
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(data.data());
+  size_t size = data.size();
+  size_t i = 0;
+  for (; i + 3 <= size; i += 3) {
+    uint32_t block = (in[i] << 16) | (in[i + 1] << 8) | in[i + 2];
+    *out++ = kBase64UrlAlphabet[block >> 18];
+    *out++ = kBase64UrlAlphabet[(block >> 12) & 0x3f];
+    *out++ = kBase64UrlAlphabet[(block >> 6) & 0x3f];
+    *out++ = kBase64UrlAlphabet[block & 0x3f];
+  }
+  if (size - i == 1) {
+    uint32_t block = in[i] << 16;
+    *out++ = kBase64UrlAlphabet[block >> 18];
+    *out++ = kBase64UrlAlphabet[(block >> 12) & 0x3f];
+  } else if (size - i == 2) {
+    uint32_t block = (in[i] << 16) | (in[i + 1] << 8);
+    *out++ = kBase64UrlAlphabet[block >> 18];
+    *out++ = kBase64UrlAlphabet[(block >> 12) & 0x3f];
+    *out++ = kBase64UrlAlphabet[(block >> 6) & 0x3f];
+  }
+}
+
+bool Base64UrlDecode(absl::string_view encoded, char* out, size_t* out_size) {
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(encoded.data());
+  size_t size = encoded.size();
+  if (size % 4 == 1) {
+    return false;
+  }
+  char* start = out;
+  size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    uint32_t a = kBase64UrlValues[in[i]];
+    uint32_t b = kBase64UrlValues[in[i + 1]];
+    uint32_t c = kBase64UrlValues[in[i + 2]];
+    uint32_t d = kBase64UrlValues[in[i + 3]];
+    // Invalid characters are the only values with the high bit set.
+    if ((a | b | c | d) & 0x80) {
+      return false;
+    }
+    uint32_t block = (a << 18) | (b << 12) | (c << 6) | d;
+    *out++ = static_cast<char>(block >> 16);
+    *out++ = static_cast<char>(block >> 8);
+    *out++ = static_cast<char>(block);
+  }
+  if (size - i >= 2) {
+    uint32_t a = kBase64UrlValues[in[i]];
+    uint32_t b = kBase64UrlValues[in[i + 1]];
+    uint32_t c = size - i == 3 ? kBase64UrlValues[in[i + 2]] : 0;
+    if ((a | b | c) & 0x80) {
+      return false;
+    }
+    uint32_t block = (a << 18) | (b << 12) | (c << 6);
+    *out++ = static_cast<char>(block >> 16);
+    if (size - i == 3) {
+      *out++ = static_cast<char>(block >> 8);
+    }
+  }
+  *out_size = out - start;
+  return true;
+}
 
 std::string EncodeHeader(absl::string_view json_header) {
-  return absl::WebSafeBase64Escape(json_header);
+  return EncodeBase64Url(json_header);
 }
 
 bool DecodeHeader(absl::string_view header, std::string* json_header) {
@@ -56,6 +166,28 @@ std::string CreateHeader(absl::string_view algorithm) {
   return EncodeHeader(header);
 }
 
+std::string CreateUnsignedCompact(absl::string_view algorithm,
+                                  absl::string_view json_payload) {
+  return CreateUnsignedCompactWithHeader(CreateHeader(algorithm), json_payload);
+}
+
+std::string CreateUnsignedCompactWithHeader(absl::string_view encoded_header,
+                                            absl::string_view json_payload) {
+  std::string compact;
+  compact.reserve(encoded_header.size() + 1 +
+                  Base64UrlEncodedSize(json_payload.size()) + 1 +
+                  Base64UrlEncodedSize(kMaxSignatureSize));
+  compact.append(encoded_header.data(), encoded_header.size());
+  compact.push_back('.');
+  AppendBase64Url(json_payload, &compact);
+  return compact;
+}
+
+void AppendSignature(absl::string_view signature, std::string* compact) {
+  compact->push_back('.');
+  AppendBase64Url(signature, compact);
+}
+
 util::Status ValidateHeader(absl::string_view encoded_header,
                             absl::string_view algorithm) {
   std::string json_header;
@@ -94,8 +226,39 @@ util::Status ValidateHeader(absl::string_view encoded_header,
   return util::OkStatus();
 }
 
+std::string KeyIdToKid(uint32_t key_id) {
+  char key_id_bytes[4] = {static_cast<char>(key_id >> 24),
+                          static_cast<char>(key_id >> 16),
+                          static_cast<char>(key_id >> 8),
+                          static_cast<char>(key_id)};
+  return EncodeBase64Url(absl::string_view(key_id_bytes, 4));
+}
+
+bool GetKid(absl::string_view compact, std::string* kid) {
+  std::size_t header_end = compact.find('.');
+  if (header_end == absl::string_view::npos) {
+    return false;
+  }
+  std::string json_header;
+  if (!DecodeHeader(compact.substr(0, header_end), &json_header)) {
+    return false;
+  }
+  auto proto_or = JsonStringToProtoStruct(json_header);
+  if (!proto_or.ok()) {
+    return false;
+  }
+  const auto& fields = proto_or.ValueOrDie().fields();
+  auto it = fields.find("kid");
+  if (it == fields.end() ||
+      it->second.kind_case() != google::protobuf::Value::kStringValue) {
+    return false;
+  }
+  *kid = it->second.string_value();
+  return true;
+}
+
 std::string EncodePayload(absl::string_view json_payload) {
-  return absl::WebSafeBase64Escape(json_payload);
+  return EncodeBase64Url(json_payload);
 }
 
 bool DecodePayload(absl::string_view payload, std::string* json_payload) {
@@ -103,7 +266,7 @@ bool DecodePayload(absl::string_view payload, std::string* json_payload) {
 }
 
 std::string EncodeSignature(absl::string_view signature) {
-  return absl::WebSafeBase64Escape(signature);
+  return EncodeBase64Url(signature);
 }
 
 bool DecodeSignature(absl::string_view encoded_signature,
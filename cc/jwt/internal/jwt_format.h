@@ -17,6 +17,10 @@
 #ifndef TINK_JWT_INTERNAL_JWT_FORMAT_H_
 #define TINK_JWT_INTERNAL_JWT_FORMAT_H_
 
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
@@ -24,13 +28,42 @@ namespace crypto {
 namespace tink {
 namespace jwt_internal {
 
+// Base64url encoding without padding (RFC 7515, section 2), into
+// caller-provided buffers. Base64UrlEncode() writes exactly
+// Base64UrlEncodedSize(data.size()) characters to 'out'. Base64UrlDecode()
+// needs room for Base64UrlMaxDecodedSize(encoded.size()) bytes, sets
+// 'out_size' to the number of bytes written, and returns false if 'encoded'
+// contains padding, whitespace or other invalid characters.
+size_t Base64UrlEncodedSize(size_t size);
+size_t Base64UrlMaxDecodedSize(size_t encoded_size);
+void Base64UrlEncode(absl::string_view data, char* out);
+bool Base64UrlDecode(absl::string_view encoded, char* out, size_t* out_size);
+
 std::string EncodeHeader(absl::string_view json_header);
 bool DecodeHeader(absl::string_view header, std::string* json_header);
 
 std::string CreateHeader(absl::string_view algorithm);
+// Returns the encoded header and payload of a token, "<header>.<payload>",
+// with room for appending the signature without another allocation.
+std::string CreateUnsignedCompact(absl::string_view algorithm,
+                                  absl::string_view json_payload);
+// Like CreateUnsignedCompact(), but takes a header already returned by
+// CreateHeader(), so that callers signing many tokens encode it only once.
+std::string CreateUnsignedCompactWithHeader(absl::string_view encoded_header,
+                                            absl::string_view json_payload);
+// Appends "." and the encoded signature to an unsigned compact token.
+void AppendSignature(absl::string_view signature, std::string* compact);
 util::Status ValidateHeader(absl::string_view encoded_header,
                             absl::string_view algorithm);
 
+// Returns the "kid" header parameter identifying the Tink key 'key_id': the
+// key ID in big-endian order, base64url-encoded.
+std::string KeyIdToKid(uint32_t key_id);
+// Sets 'kid' to the "kid" header parameter of the compact token, and returns
+// true if the token has one. Neither the token nor the rest of the header are
+// validated.
+bool GetKid(absl::string_view compact, std::string* kid);
+
 std::string EncodePayload(absl::string_view json_payload);
 bool DecodePayload(absl::string_view payload, std::string* json_payload);
 
@@ -18,6 +18,8 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
 #include "tink/util/test_matchers.h"
 #include "tink/util/test_util.h"
 
@@ -183,6 +185,73 @@ TEST(JwtFormat, DecodeSignatureWithLineFeedFails) {
       DecodePayload("dBjftJeZ4CVP-mB92K2\n7uhbUJU1p1r_wW1gFWFOEjXk", &output));
 }
 
+TEST(JwtFormat, KeyIdToKid) {
+  EXPECT_THAT(KeyIdToKid(0x1ac6a944), Eq("GsapRA"));
+  EXPECT_THAT(KeyIdToKid(0), Eq("AAAAAA"));
+}
+
+TEST(JwtFormat, GetKid) {
+  std::string kid;
+  std::string compact =
+      absl::StrCat(EncodeHeader(R"({"alg":"HS256","kid":"GsapRA"})"), ".",
+                   EncodePayload("{}"), ".sig");
+  ASSERT_TRUE(GetKid(compact, &kid));
+  EXPECT_THAT(kid, Eq("GsapRA"));
+
+  EXPECT_FALSE(GetKid(absl::StrCat(CreateHeader("HS256"), ".e30.sig"), &kid));
+  EXPECT_FALSE(GetKid(
+      absl::StrCat(EncodeHeader(R"({"alg":"HS256","kid":1})"), ".e30.sig"),
+      &kid));
+  EXPECT_FALSE(GetKid(absl::StrCat(EncodeHeader("{"), ".e30.sig"), &kid));
+  EXPECT_FALSE(GetKid("no dots", &kid));
+}
+
+TEST(JwtFormat, Base64UrlMatchesAbsl) {
+  std::string data;
+  for (int i = 0; i < 70; i++) {
+    std::string encoded = EncodeSignature(data);
+    EXPECT_THAT(encoded, Eq(absl::WebSafeBase64Escape(data)));
+    EXPECT_THAT(encoded.size(), Eq(Base64UrlEncodedSize(data.size())));
+    std::string decoded;
+    ASSERT_TRUE(DecodeSignature(encoded, &decoded));
+    EXPECT_THAT(decoded, Eq(data));
+    data.push_back(static_cast<char>(i * 37 + 250));
+  }
+}
+
+TEST(JwtFormat, Base64UrlDecodeIntoBuffer) {
+  char buffer[8];
+  size_t size;
+  ASSERT_TRUE(Base64UrlDecode("AP_-", buffer, &size));
+  EXPECT_THAT(std::string(buffer, size), Eq(std::string("\x00\xff\xfe", 3)));
+  ASSERT_TRUE(Base64UrlDecode("", buffer, &size));
+  EXPECT_THAT(size, Eq(0));
+}
+
+TEST(JwtFormat, Base64UrlDecodeRejectsInvalidInput) {
+  std::string output;
+  for (const char* invalid : {"A", "AAAAA", "AA==", "AA+/", "AA A", "AA\n",
+                              "QUJD=", "\x80" "AAA"}) {
+    EXPECT_FALSE(DecodeSignature(invalid, &output)) << invalid;
+  }
+}
+
+TEST(JwtFormat, CreateUnsignedCompact) {
+  std::string compact = CreateUnsignedCompact("HS256", R"({"iss":"joe"})");
+  EXPECT_THAT(compact, Eq(absl::StrCat(CreateHeader("HS256"), ".",
+                                       EncodePayload(R"({"iss":"joe"})"))));
+  AppendSignature("tag", &compact);
+  EXPECT_THAT(compact, Eq(absl::StrCat(CreateHeader("HS256"), ".",
+                                       EncodePayload(R"({"iss":"joe"})"), ".",
+                                       EncodeSignature("tag"))));
+}
+
+TEST(JwtFormat, CreateUnsignedCompactWithHeader) {
+  std::string header = CreateHeader("ES256");
+  EXPECT_THAT(CreateUnsignedCompactWithHeader(header, R"({"iss":"joe"})"),
+              Eq(CreateUnsignedCompact("ES256", R"({"iss":"joe"})")));
+}
+
 }  // namespace jwt_internal
 }  // namespace tink
 }  // namespace crypto
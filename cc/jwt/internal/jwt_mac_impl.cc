@@ -19,7 +19,6 @@
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_split.h"
 #include "tink/jwt/internal/json_util.h"
-#include "tink/jwt/internal/jwt_format.h"
 
 namespace crypto {
 namespace tink {
@@ -27,20 +26,18 @@ namespace jwt_internal {
 
 util::StatusOr<std::string> JwtMacImpl::ComputeMacAndEncode(
     const RawJwt& token) const {
-  std::string encoded_header = CreateHeader(algorithm_);
   util::StatusOr<std::string> payload_or = token.ToString();
   if (!payload_or.ok()) {
     return payload_or.status();
   }
-  std::string encoded_payload = EncodePayload(payload_or.ValueOrDie());
-  std::string unsigned_token =
-      absl::StrCat(encoded_header, ".", encoded_payload);
-  util::StatusOr<std::string> tag_or = mac_->ComputeMac(unsigned_token);
+  std::string compact =
+      CreateUnsignedCompactWithHeader(encoded_header_, payload_or.ValueOrDie());
+  util::StatusOr<std::string> tag_or = mac_->ComputeMac(compact);
   if (!tag_or.ok()) {
     return tag_or.status();
   }
-  std::string encoded_tag = EncodeSignature(tag_or.ValueOrDie());
-  return absl::StrCat(unsigned_token, ".", encoded_tag);
+  AppendSignature(tag_or.ValueOrDie(), &compact);
+  return compact;
 }
 
 util::StatusOr<VerifiedJwt> JwtMacImpl::VerifyMacAndDecode(
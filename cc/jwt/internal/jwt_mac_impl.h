@@ -18,6 +18,7 @@
 #define TINK_JWT_INTERNAL_JWT_MAC_IMPL_H_
 
 #include "absl/strings/string_view.h"
+#include "tink/jwt/internal/jwt_format.h"
 #include "tink/jwt/jwt_mac.h"
 #include "tink/jwt/jwt_validator.h"
 #include "tink/jwt/raw_jwt.h"
@@ -33,10 +34,10 @@ namespace jwt_internal {
 class JwtMacImpl : public JwtMac {
  public:
   explicit JwtMacImpl(std::unique_ptr<crypto::tink::Mac> mac,
-                      absl::string_view algorithm) {
-    mac_ = std::move(mac);
-    algorithm_ = std::string(algorithm);
-  }
+                      absl::string_view algorithm)
+      : mac_(std::move(mac)),
+        algorithm_(algorithm),
+        encoded_header_(CreateHeader(algorithm)) {}
 
   crypto::tink::util::StatusOr<std::string> ComputeMacAndEncode(
       const crypto::tink::RawJwt& token) const override;
@@ -48,6 +49,8 @@ class JwtMacImpl : public JwtMac {
  private:
   std::unique_ptr<crypto::tink::Mac> mac_;
   std::string algorithm_;
+  // The base64url-encoded header, which is the same for every token.
+  std::string encoded_header_;
 };
 
 }  // namespace jwt_internal
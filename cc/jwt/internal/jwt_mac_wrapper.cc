@@ -16,6 +16,8 @@
 
 #include "tink/jwt/internal/jwt_mac_wrapper.h"
 
+#include "absl/container/flat_hash_map.h"
+#include "tink/jwt/internal/jwt_format.h"
 #include "tink/jwt/jwt_mac.h"
 #include "tink/primitive_set.h"
 #include "tink/util/status.h"
@@ -32,7 +34,11 @@ namespace {
 class JwtMacSetWrapper : public JwtMac {
  public:
   explicit JwtMacSetWrapper(std::unique_ptr<PrimitiveSet<JwtMac>> jwt_mac_set)
-      : jwt_mac_set_(std::move(jwt_mac_set)) {}
+      : jwt_mac_set_(std::move(jwt_mac_set)) {
+    for (const auto* entry : jwt_mac_set_->get_all()) {
+      kid_index_[KeyIdToKid(entry->get_key_id())] = &entry->get_primitive();
+    }
+  }
 
   crypto::tink::util::StatusOr<std::string> ComputeMacAndEncode(
       const crypto::tink::RawJwt& token) const override;
@@ -45,6 +51,8 @@ class JwtMacSetWrapper : public JwtMac {
 
  private:
   std::unique_ptr<PrimitiveSet<JwtMac>> jwt_mac_set_;
+  // The primitives by the "kid" of their key, see KeyIdToKid().
+  absl::flat_hash_map<std::string, JwtMac*> kid_index_;
 };
 
 util::Status Validate(PrimitiveSet<JwtMac>* jwt_mac_set) {
@@ -73,6 +81,21 @@ util::StatusOr<std::string> JwtMacSetWrapper::ComputeMacAndEncode(
 util::StatusOr<crypto::tink::VerifiedJwt> JwtMacSetWrapper::VerifyMacAndDecode(
     absl::string_view compact,
     const crypto::tink::JwtValidator& validator) const {
+  // A token with the kid of one of the keys is only verified with that key.
+  // Tokens without a kid, or with a kid assigned outside Tink, are tried with
+  // all keys.
+  std::string kid;
+  if (GetKid(compact, &kid)) {
+    auto it = kid_index_.find(kid);
+    if (it != kid_index_.end()) {
+      auto verified_jwt_or = it->second->VerifyMacAndDecode(compact, validator);
+      if (verified_jwt_or.ok()) {
+        return verified_jwt_or;
+      }
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "verification failed");
+    }
+  }
   auto raw_primitives_result = jwt_mac_set_->get_raw_primitives();
   if (raw_primitives_result.ok()) {
     for (auto& mac_entry : *(raw_primitives_result.ValueOrDie())) {
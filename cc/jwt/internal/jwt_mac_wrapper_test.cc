@@ -17,6 +17,8 @@
 #include "tink/jwt/internal/jwt_mac_wrapper.h"
 
 #include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "tink/jwt/internal/jwt_format.h"
 #include "tink/jwt/internal/jwt_hmac_key_manager.h"
 #include "tink/keyset_manager.h"
 #include "tink/primitive_set.h"
@@ -37,6 +39,28 @@ namespace jwt_internal {
 namespace {
 
 using ::crypto::tink::test::IsOk;
+using ::google::crypto::tink::KeysetInfo;
+using ::google::crypto::tink::KeyStatusType;
+
+// A JwtMac that rejects all tokens, and counts how often it was asked.
+class CountingJwtMac : public JwtMac {
+ public:
+  explicit CountingJwtMac(int* verify_calls) : verify_calls_(verify_calls) {}
+
+  util::StatusOr<std::string> ComputeMacAndEncode(
+      const RawJwt& token) const override {
+    return util::Status(util::error::UNIMPLEMENTED, "not implemented");
+  }
+
+  util::StatusOr<VerifiedJwt> VerifyMacAndDecode(
+      absl::string_view compact, const JwtValidator& validator) const override {
+    (*verify_calls_)++;
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid MAC");
+  }
+
+ private:
+  int* verify_calls_;
+};
 
 KeyTemplate createTemplate(OutputPrefixType output_prefix) {
   KeyTemplate key_template;
@@ -203,6 +227,88 @@ TEST_F(JwtMacWrapperTest, KeyRotation) {
               IsOk());
 }
 
+TEST_F(JwtMacWrapperTest, VerifyMacAndDecodeBatch) {
+  KeyTemplate key_template = createTemplate(OutputPrefixType::RAW);
+  auto handle_result = KeysetHandle::GenerateNew(key_template);
+  ASSERT_THAT(handle_result.status(), IsOk());
+  auto jwt_mac_or = handle_result.ValueOrDie()->GetPrimitive<JwtMac>();
+  ASSERT_THAT(jwt_mac_or.status(), IsOk());
+  std::unique_ptr<JwtMac> jwt_mac = std::move(jwt_mac_or.ValueOrDie());
+
+  std::vector<std::string> compacts;
+  for (int i = 0; i < 20; i++) {
+    auto raw_jwt_or =
+        RawJwtBuilder().SetIssuer(absl::StrCat("issuer", i)).Build();
+    ASSERT_THAT(raw_jwt_or.status(), IsOk());
+    util::StatusOr<std::string> compact_or =
+        jwt_mac->ComputeMacAndEncode(raw_jwt_or.ValueOrDie());
+    ASSERT_THAT(compact_or.status(), IsOk());
+    // Every third token gets a broken MAC.
+    compacts.push_back(i % 3 == 0 ? absl::StrCat(compact_or.ValueOrDie(), "x")
+                                  : compact_or.ValueOrDie());
+  }
+  std::vector<absl::string_view> compact_views(compacts.begin(),
+                                               compacts.end());
+  JwtValidator validator = JwtValidatorBuilder().Build();
+
+  for (int num_threads : {1, 4, 64}) {
+    std::vector<util::StatusOr<VerifiedJwt>> results =
+        jwt_mac->VerifyMacAndDecodeBatch(compact_views, validator,
+                                         num_threads);
+    ASSERT_EQ(results.size(), compacts.size());
+    for (int i = 0; i < 20; i++) {
+      if (i % 3 == 0) {
+        EXPECT_FALSE(results[i].ok()) << i;
+        continue;
+      }
+      ASSERT_THAT(results[i].status(), IsOk());
+      EXPECT_THAT(results[i].ValueOrDie().GetIssuer(),
+                  test::IsOkAndHolds(absl::StrCat("issuer", i)));
+    }
+  }
+  EXPECT_TRUE(jwt_mac->VerifyMacAndDecodeBatch({}, validator, 4).empty());
+}
+
+TEST_F(JwtMacWrapperTest, OnlyTriesKeyMatchingKid) {
+  std::vector<int> verify_calls(3, 0);
+  auto jwt_mac_set = absl::make_unique<PrimitiveSet<JwtMac>>();
+  PrimitiveSet<JwtMac>::Entry<JwtMac>* entry = nullptr;
+  for (int i = 0; i < 3; i++) {
+    KeysetInfo::KeyInfo key_info;
+    key_info.set_output_prefix_type(OutputPrefixType::RAW);
+    key_info.set_key_id(1000 + i);
+    key_info.set_status(KeyStatusType::ENABLED);
+    auto entry_or = jwt_mac_set->AddPrimitive(
+        absl::make_unique<CountingJwtMac>(&verify_calls[i]), key_info);
+    ASSERT_THAT(entry_or.status(), IsOk());
+    entry = entry_or.ValueOrDie();
+  }
+  ASSERT_THAT(jwt_mac_set->set_primary(entry), IsOk());
+  auto jwt_mac_or = JwtMacWrapper().Wrap(std::move(jwt_mac_set));
+  ASSERT_THAT(jwt_mac_or.status(), IsOk());
+  std::unique_ptr<JwtMac> jwt_mac = std::move(jwt_mac_or.ValueOrDie());
+  JwtValidator validator = JwtValidatorBuilder().Build();
+
+  std::string with_kid = absl::StrCat(
+      EncodeHeader(absl::StrCat(R"({"alg":"HS256","kid":")", KeyIdToKid(1001),
+                                R"("})")),
+      ".", EncodePayload("{}"), ".", EncodeSignature("tag"));
+  EXPECT_FALSE(jwt_mac->VerifyMacAndDecode(with_kid, validator).ok());
+  EXPECT_EQ(verify_calls, std::vector<int>({0, 1, 0}));
+
+  // Without a kid, or with an unknown kid, all keys are tried.
+  std::string without_kid =
+      absl::StrCat(CreateHeader("HS256"), ".", EncodePayload("{}"), ".",
+                   EncodeSignature("tag"));
+  EXPECT_FALSE(jwt_mac->VerifyMacAndDecode(without_kid, validator).ok());
+  EXPECT_EQ(verify_calls, std::vector<int>({1, 2, 1}));
+  std::string unknown_kid = absl::StrCat(
+      EncodeHeader(R"({"alg":"HS256","kid":"some-jwks-key"})"), ".",
+      EncodePayload("{}"), ".", EncodeSignature("tag"));
+  EXPECT_FALSE(jwt_mac->VerifyMacAndDecode(unknown_kid, validator).ok());
+  EXPECT_EQ(verify_calls, std::vector<int>({2, 3, 2}));
+}
+
 }  // namespace
 }  // namespace jwt_internal
 }  // namespace tink
@@ -0,0 +1,571 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/jwt/internal/jwt_payload.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace jwt_internal {
+
+namespace {
+
+// The maximal nesting depth of objects and arrays, as for protobuf's parser.
+constexpr int kMaxDepth = 100;
+
+// Registered claim names, as defined in
+// https://tools.ietf.org/html/rfc7519#section-4.1, in the order of
+// JwtPayload::registered_claims_.
+constexpr absl::string_view kRegisteredClaimNames[] = {
+    "iss", "sub", "aud", "exp", "nbf", "iat", "jti"};
+
+int RegisteredClaimIndex(absl::string_view name) {
+  if (name.size() != 3) return -1;
+  for (int i = 0; i < 7; i++) {
+    if (name == kRegisteredClaimNames[i]) return i;
+  }
+  return -1;
+}
+
+bool IsWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+// Returns the length of the UTF-8 encoded code point at the start of
+// 'text', or 0 if 'text' does not start with valid UTF-8.
+size_t Utf8SequenceLength(absl::string_view text) {
+  uint8_t c = text[0];
+  if (c < 0x80) return 1;
+  size_t length;
+  uint32_t code_point;
+  uint32_t min_code_point;
+  if ((c & 0xE0) == 0xC0) {
+    length = 2;
+    code_point = c & 0x1F;
+    min_code_point = 0x80;
+  } else if ((c & 0xF0) == 0xE0) {
+    length = 3;
+    code_point = c & 0x0F;
+    min_code_point = 0x800;
+  } else if ((c & 0xF8) == 0xF0) {
+    length = 4;
+    code_point = c & 0x07;
+    min_code_point = 0x10000;
+  } else {
+    return 0;
+  }
+  if (text.size() < length) return 0;
+  for (size_t i = 1; i < length; i++) {
+    uint8_t d = text[i];
+    if ((d & 0xC0) != 0x80) return 0;
+    code_point = (code_point << 6) | (d & 0x3F);
+  }
+  if (code_point < min_code_point || code_point > 0x10FFFF ||
+      (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+    return 0;
+  }
+  return length;
+}
+
+// Writes the UTF-8 encoding of 'code_point', of at most 4 bytes, to 'out';
+// returns its length.
+size_t EncodeUtf8(uint32_t code_point, char* out) {
+  if (code_point < 0x80) {
+    out[0] = static_cast<char>(code_point);
+    return 1;
+  }
+  if (code_point < 0x800) {
+    out[0] = static_cast<char>(0xC0 | (code_point >> 6));
+    out[1] = static_cast<char>(0x80 | (code_point & 0x3F));
+    return 2;
+  }
+  if (code_point < 0x10000) {
+    out[0] = static_cast<char>(0xE0 | (code_point >> 12));
+    out[1] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+    out[2] = static_cast<char>(0x80 | (code_point & 0x3F));
+    return 3;
+  }
+  out[0] = static_cast<char>(0xF0 | (code_point >> 18));
+  out[1] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+  out[2] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+  out[3] = static_cast<char>(0x80 | (code_point & 0x3F));
+  return 4;
+}
+
+// Reads the 4 hex digits of a \u escape at the start of 'text'.
+int ReadHex4(absl::string_view text) {
+  if (text.size() < 4) return -1;
+  int value = 0;
+  for (int i = 0; i < 4; i++) {
+    int digit = HexValue(text[i]);
+    if (digit < 0) return -1;
+    value = (value << 4) | digit;
+  }
+  return value;
+}
+
+// Decodes the escape sequence at text[*i], which Parser accepted, into 'out'
+// (at most 4 bytes); advances *i past it and returns the decoded length.
+size_t DecodeEscape(absl::string_view text, size_t* i, char* out) {
+  char c = text[*i + 1];
+  *i += 2;
+  switch (c) {
+    case 'b': *out = '\b'; return 1;
+    case 'f': *out = '\f'; return 1;
+    case 'n': *out = '\n'; return 1;
+    case 'r': *out = '\r'; return 1;
+    case 't': *out = '\t'; return 1;
+    case 'u': {
+      uint32_t code_point = ReadHex4(text.substr(*i));
+      *i += 4;
+      if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+        // The parser checked that the low surrogate follows.
+        uint32_t low = ReadHex4(text.substr(*i + 2));
+        *i += 6;
+        code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+      }
+      return EncodeUtf8(code_point, out);
+    }
+    default:  // '"', '\\' and '/'.
+      *out = c;
+      return 1;
+  }
+}
+
+// Decodes a string literal, including its quotes, that Parser accepted.
+std::string DecodeString(absl::string_view literal) {
+  absl::string_view text = literal.substr(1, literal.size() - 2);
+  std::string result;
+  result.reserve(text.size());
+  size_t i = 0;
+  while (i < text.size()) {
+    size_t escape = text.find('\\', i);
+    if (escape == absl::string_view::npos) escape = text.size();
+    result.append(text.data() + i, escape - i);
+    if (escape == text.size()) break;
+    i = escape;
+    char decoded[4];
+    result.append(decoded, DecodeEscape(text, &i, decoded));
+  }
+  return result;
+}
+
+// Returns whether a string literal that Parser accepted decodes to
+// 'expected', without allocating.
+bool DecodedStringEquals(absl::string_view literal,
+                         absl::string_view expected) {
+  absl::string_view text = literal.substr(1, literal.size() - 2);
+  size_t i = 0;
+  while (i < text.size()) {
+    size_t escape = text.find('\\', i);
+    if (escape == absl::string_view::npos) escape = text.size();
+    size_t run = escape - i;
+    if (expected.substr(0, run) != text.substr(i, run)) return false;
+    expected.remove_prefix(run);
+    if (escape == text.size()) break;
+    i = escape;
+    char decoded[4];
+    size_t size = DecodeEscape(text, &i, decoded);
+    if (expected.substr(0, size) != absl::string_view(decoded, size)) {
+      return false;
+    }
+    expected.remove_prefix(size);
+  }
+  return expected.empty();
+}
+
+util::Status InvalidJson(size_t offset, absl::string_view what) {
+  return util::Status(
+      util::error::INVALID_ARGUMENT,
+      absl::StrCat("invalid JSON payload at offset ", offset, ": ", what));
+}
+
+// A validating JSON parser that only records where values are.
+class Parser {
+ public:
+  explicit Parser(absl::string_view json) : json_(json) {}
+
+  size_t pos() const { return pos_; }
+  bool AtEnd() const { return pos_ == json_.size(); }
+  char Peek() const { return AtEnd() ? '\0' : json_[pos_]; }
+
+  void SkipWhitespace() {
+    while (!AtEnd() && IsWhitespace(json_[pos_])) ++pos_;
+  }
+
+  bool Consume(char c) {
+    if (Peek() != c || AtEnd()) return false;
+    ++pos_;
+    return true;
+  }
+
+  util::Status Expect(char c) {
+    if (Consume(c)) return util::OkStatus();
+    return Error(absl::StrCat("expected '", absl::string_view(&c, 1), "'"));
+  }
+
+  util::Status Error(absl::string_view what) const {
+    return InvalidJson(pos_, what);
+  }
+
+  // Parses any value; sets 'claim->kind', and the values of booleans and
+  // numbers.
+  util::Status ParseValue(int depth, JsonClaim* claim) {
+    switch (Peek()) {
+      case '{':
+        claim->kind = JsonKind::kObject;
+        return ParseObject(depth + 1);
+      case '[':
+        claim->kind = JsonKind::kArray;
+        return ParseArray(depth + 1);
+      case '"':
+        claim->kind = JsonKind::kString;
+        return ParseString();
+      case 't':
+        claim->kind = JsonKind::kBool;
+        claim->bool_value = true;
+        return ParseLiteral("true");
+      case 'f':
+        claim->kind = JsonKind::kBool;
+        claim->bool_value = false;
+        return ParseLiteral("false");
+      case 'n':
+        claim->kind = JsonKind::kNull;
+        return ParseLiteral("null");
+      default:
+        if (Peek() == '-' || IsDigit(Peek())) {
+          claim->kind = JsonKind::kNumber;
+          return ParseNumber(&claim->number_value);
+        }
+        return Error("expected a value");
+    }
+  }
+
+  util::Status ParseString() {
+    if (!Consume('"')) return Error("expected a string");
+    while (true) {
+      if (AtEnd()) return Error("unterminated string");
+      uint8_t c = json_[pos_];
+      if (c == '"') {
+        ++pos_;
+        return util::OkStatus();
+      }
+      if (c == '\\') {
+        auto status = ParseEscape();
+        if (!status.ok()) return status;
+      } else if (c < 0x20) {
+        return Error("control character in string");
+      } else if (c < 0x80) {
+        ++pos_;
+      } else {
+        size_t length = Utf8SequenceLength(json_.substr(pos_));
+        if (length == 0) return Error("invalid UTF-8");
+        pos_ += length;
+      }
+    }
+  }
+
+ private:
+  util::Status ParseEscape() {
+    ++pos_;  // The backslash.
+    switch (Peek()) {
+      case '"':
+      case '\\':
+      case '/':
+      case 'b':
+      case 'f':
+      case 'n':
+      case 'r':
+      case 't':
+        ++pos_;
+        return util::OkStatus();
+      case 'u': {
+        int code_point = ReadHex4(json_.substr(pos_ + 1));
+        if (code_point < 0) return Error("invalid \\u escape");
+        pos_ += 5;
+        if (code_point >= 0xDC00 && code_point <= 0xDFFF) {
+          return Error("unpaired surrogate");
+        }
+        if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+          if (json_.substr(pos_, 2) != "\\u") {
+            return Error("unpaired surrogate");
+          }
+          int low = ReadHex4(json_.substr(pos_ + 2));
+          if (low < 0xDC00 || low > 0xDFFF) {
+            return Error("unpaired surrogate");
+          }
+          pos_ += 6;
+        }
+        return util::OkStatus();
+      }
+      default:
+        return Error("invalid escape");
+    }
+  }
+
+  util::Status ParseNumber(double* value) {
+    size_t start = pos_;
+    Consume('-');
+    if (!Consume('0')) {
+      if (!IsDigit(Peek())) return Error("invalid number");
+      while (IsDigit(Peek())) ++pos_;
+    }
+    if (Consume('.')) {
+      if (!IsDigit(Peek())) return Error("invalid number");
+      while (IsDigit(Peek())) ++pos_;
+    }
+    if (Consume('e') || Consume('E')) {
+      if (!Consume('+')) Consume('-');
+      if (!IsDigit(Peek())) return Error("invalid number");
+      while (IsDigit(Peek())) ++pos_;
+    }
+    if (!absl::SimpleAtod(json_.substr(start, pos_ - start), value) ||
+        !std::isfinite(*value)) {
+      return InvalidJson(start, "number out of range");
+    }
+    return util::OkStatus();
+  }
+
+  util::Status ParseLiteral(absl::string_view literal) {
+    if (json_.substr(pos_, literal.size()) != literal) {
+      return Error("expected a value");
+    }
+    pos_ += literal.size();
+    return util::OkStatus();
+  }
+
+  util::Status ParseObject(int depth) {
+    if (depth > kMaxDepth) return Error("nesting too deep");
+    ++pos_;  // '{'
+    SkipWhitespace();
+    if (Consume('}')) return util::OkStatus();
+    JsonClaim value;
+    while (true) {
+      SkipWhitespace();
+      auto status = ParseString();
+      if (!status.ok()) return status;
+      SkipWhitespace();
+      status = Expect(':');
+      if (!status.ok()) return status;
+      SkipWhitespace();
+      status = ParseValue(depth, &value);
+      if (!status.ok()) return status;
+      SkipWhitespace();
+      if (!Consume(',')) return Expect('}');
+    }
+  }
+
+  util::Status ParseArray(int depth) {
+    if (depth > kMaxDepth) return Error("nesting too deep");
+    ++pos_;  // '['
+    SkipWhitespace();
+    if (Consume(']')) return util::OkStatus();
+    JsonClaim value;
+    while (true) {
+      SkipWhitespace();
+      auto status = ParseValue(depth, &value);
+      if (!status.ok()) return status;
+      SkipWhitespace();
+      if (!Consume(',')) return Expect(']');
+    }
+  }
+
+  absl::string_view json_;
+  size_t pos_ = 0;
+};
+
+}  // namespace
+
+constexpr int JwtPayload::kNumRegisteredClaims;
+
+JwtPayload::JwtPayload() : json_("{}") {
+  std::fill(registered_claims_, registered_claims_ + kNumRegisteredClaims, -1);
+}
+
+// static
+util::StatusOr<JwtPayload> JwtPayload::Parse(std::string json) {
+  JwtPayload payload;
+  payload.json_ = std::move(json);
+  Parser parser(payload.json_);
+  parser.SkipWhitespace();
+  if (parser.Peek() != '{') return parser.Error("expected an object");
+  parser.Consume('{');
+  parser.SkipWhitespace();
+  if (!parser.Consume('}')) {
+    while (true) {
+      JsonClaim claim;
+      parser.SkipWhitespace();
+      size_t name_start = parser.pos();
+      auto status = parser.ParseString();
+      if (!status.ok()) return status;
+      claim.name = DecodeString(absl::string_view(payload.json_).substr(
+          name_start, parser.pos() - name_start));
+      parser.SkipWhitespace();
+      status = parser.Expect(':');
+      if (!status.ok()) return status;
+      parser.SkipWhitespace();
+      claim.value_offset = parser.pos();
+      status = parser.ParseValue(1, &claim);
+      if (!status.ok()) return status;
+      claim.value_size = parser.pos() - claim.value_offset;
+      payload.claims_.push_back(std::move(claim));
+      parser.SkipWhitespace();
+      if (parser.Consume(',')) continue;
+      status = parser.Expect('}');
+      if (!status.ok()) return status;
+      break;
+    }
+  }
+  parser.SkipWhitespace();
+  if (!parser.AtEnd()) return parser.Error("trailing characters");
+
+  const std::vector<JsonClaim>& claims = payload.claims_;
+  payload.sorted_claims_.reserve(claims.size());
+  for (int i = 0; i < claims.size(); i++) {
+    payload.sorted_claims_.push_back(i);
+    int registered = RegisteredClaimIndex(claims[i].name);
+    if (registered >= 0) payload.registered_claims_[registered] = i;
+  }
+  std::sort(payload.sorted_claims_.begin(), payload.sorted_claims_.end(),
+            [&claims](int a, int b) {
+              return claims[a].name < claims[b].name;
+            });
+  for (int i = 1; i < payload.sorted_claims_.size(); i++) {
+    const std::string& name = claims[payload.sorted_claims_[i]].name;
+    if (name == claims[payload.sorted_claims_[i - 1]].name) {
+      return util::Status(
+          util::error::INVALID_ARGUMENT,
+          absl::StrCat("invalid JSON payload: duplicate claim '", name, "'"));
+    }
+  }
+  return std::move(payload);
+}
+
+const JsonClaim* JwtPayload::Find(absl::string_view name) const {
+  int registered = RegisteredClaimIndex(name);
+  if (registered >= 0) {
+    int index = registered_claims_[registered];
+    return index < 0 ? nullptr : &claims_[index];
+  }
+  auto it = std::lower_bound(
+      sorted_claims_.begin(), sorted_claims_.end(), name,
+      [this](int index, absl::string_view name) {
+        return claims_[index].name < name;
+      });
+  if (it == sorted_claims_.end() || claims_[*it].name != name) return nullptr;
+  return &claims_[*it];
+}
+
+util::StatusOr<std::string> JwtPayload::GetString(
+    const JsonClaim& claim) const {
+  if (claim.kind != JsonKind::kString) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        absl::StrCat("claim '", claim.name,
+                                     "' is not a string"));
+  }
+  return DecodeString(Value(claim));
+}
+
+bool JwtPayload::StringEquals(const JsonClaim& claim,
+                              absl::string_view expected) const {
+  return claim.kind == JsonKind::kString &&
+         DecodedStringEquals(Value(claim), expected);
+}
+
+util::StatusOr<std::vector<std::string>> JwtPayload::GetStringArray(
+    const JsonClaim& claim) const {
+  if (claim.kind != JsonKind::kArray) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        absl::StrCat("claim '", claim.name,
+                                     "' is not an array"));
+  }
+  absl::string_view value = Value(claim);
+  Parser parser(value);
+  std::vector<std::string> strings;
+  parser.Consume('[');
+  parser.SkipWhitespace();
+  if (parser.Consume(']')) return strings;
+  while (true) {
+    parser.SkipWhitespace();
+    size_t start = parser.pos();
+    if (parser.Peek() != '"' || !parser.ParseString().ok()) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          absl::StrCat("claim '", claim.name,
+                                       "' is not an array of strings"));
+    }
+    strings.push_back(DecodeString(value.substr(start, parser.pos() - start)));
+    parser.SkipWhitespace();
+    if (!parser.Consume(',')) break;
+  }
+  return strings;
+}
+
+util::StatusOr<bool> JwtPayload::StringArrayContains(
+    const JsonClaim& claim, absl::string_view expected) const {
+  if (claim.kind != JsonKind::kArray) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        absl::StrCat("claim '", claim.name,
+                                     "' is not an array"));
+  }
+  absl::string_view value = Value(claim);
+  Parser parser(value);
+  bool found = false;
+  parser.Consume('[');
+  parser.SkipWhitespace();
+  if (parser.Consume(']')) return found;
+  while (true) {
+    parser.SkipWhitespace();
+    size_t start = parser.pos();
+    if (parser.Peek() != '"' || !parser.ParseString().ok()) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          absl::StrCat("claim '", claim.name,
+                                       "' is not an array of strings"));
+    }
+    // Keep going after a match, so that all elements are checked as in
+    // GetStringArray().
+    found = found || DecodedStringEquals(
+                         value.substr(start, parser.pos() - start), expected);
+    parser.SkipWhitespace();
+    if (!parser.Consume(',')) break;
+  }
+  return found;
+}
+
+}  // namespace jwt_internal
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,110 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_JWT_INTERNAL_JWT_PAYLOAD_H_
+#define TINK_JWT_INTERNAL_JWT_PAYLOAD_H_
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace jwt_internal {
+
+enum class JsonKind { kNull, kBool, kNumber, kString, kObject, kArray };
+
+// A claim of a JWT payload. Booleans and numbers are decoded while parsing;
+// for the other kinds only the position of the JSON value is recorded.
+struct JsonClaim {
+  std::string name;
+  JsonKind kind = JsonKind::kNull;
+  bool bool_value = false;
+  double number_value = 0;
+  size_t value_offset = 0;
+  size_t value_size = 0;
+};
+
+// The claims of a JWT payload, i.e. of a JSON object, parsed and validated
+// in a single pass. Unlike JsonStringToProtoStruct(), the parser does not
+// build a tree of values: strings are only unescaped, and nested objects and
+// arrays only converted, when a claim is requested.
+//
+// The parser follows RFC 8259, and rejects duplicate claim names and numbers
+// that do not fit into a double.
+class JwtPayload {
+ public:
+  // An empty payload, "{}".
+  JwtPayload();
+
+  static util::StatusOr<JwtPayload> Parse(std::string json);
+
+  // The JSON text that was parsed.
+  const std::string& json() const { return json_; }
+  // The claims in the order in which they appear in the payload.
+  const std::vector<JsonClaim>& claims() const { return claims_; }
+
+  // Returns the claim called 'name', or nullptr. Registered claim names
+  // (RFC 7519, section 4.1) are found in constant time.
+  const JsonClaim* Find(absl::string_view name) const;
+
+  // Returns the JSON text of the value of 'claim'.
+  absl::string_view Value(const JsonClaim& claim) const {
+    return absl::string_view(json_).substr(claim.value_offset,
+                                           claim.value_size);
+  }
+
+  // Decodes the value of a kString claim.
+  util::StatusOr<std::string> GetString(const JsonClaim& claim) const;
+  // Decodes the value of a kArray claim whose elements are all strings;
+  // returns an INVALID_ARGUMENT error if any element is not a string.
+  util::StatusOr<std::vector<std::string>> GetStringArray(
+      const JsonClaim& claim) const;
+
+  // Allocation-free counterparts of GetString() and GetStringArray() for
+  // comparing claims with expected values. StringEquals() returns false if
+  // 'claim' is not a kString claim; StringArrayContains() fails like
+  // GetStringArray().
+  bool StringEquals(const JsonClaim& claim, absl::string_view expected) const;
+  util::StatusOr<bool> StringArrayContains(const JsonClaim& claim,
+                                           absl::string_view expected) const;
+
+  // JwtPayload objects are copiable and movable.
+  JwtPayload(const JwtPayload&) = default;
+  JwtPayload& operator=(const JwtPayload&) = default;
+  JwtPayload(JwtPayload&& other) = default;
+  JwtPayload& operator=(JwtPayload&& other) = default;
+
+ private:
+  static constexpr int kNumRegisteredClaims = 7;
+
+  std::string json_;
+  std::vector<JsonClaim> claims_;
+  // Indices into 'claims_', sorted by name.
+  std::vector<int> sorted_claims_;
+  // Indices into 'claims_' of the registered claims, or -1.
+  int registered_claims_[kNumRegisteredClaims];
+};
+
+}  // namespace jwt_internal
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_JWT_INTERNAL_JWT_PAYLOAD_H_
@@ -0,0 +1,190 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/jwt/internal/jwt_payload.h"
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "tink/util/test_matchers.h"
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::IsOkAndHolds;
+using ::crypto::tink::test::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+namespace crypto {
+namespace tink {
+namespace jwt_internal {
+
+TEST(JwtPayload, EmptyPayload) {
+  JwtPayload empty;
+  EXPECT_EQ(empty.json(), "{}");
+  EXPECT_THAT(empty.claims(), IsEmpty());
+  EXPECT_EQ(empty.Find("iss"), nullptr);
+
+  auto payload_or = JwtPayload::Parse(" { } ");
+  ASSERT_THAT(payload_or.status(), IsOk());
+  EXPECT_THAT(payload_or.ValueOrDie().claims(), IsEmpty());
+}
+
+TEST(JwtPayload, ParseAllKinds) {
+  auto payload_or = JwtPayload::Parse(
+      R"({"iss":"issuer", "exp":123.5, "b":true, "n":null,)"
+      R"( "o":{"a":[1,{}]}, "l":["x", "y"], "f":false})");
+  ASSERT_THAT(payload_or.status(), IsOk());
+  const JwtPayload& payload = payload_or.ValueOrDie();
+  ASSERT_EQ(payload.claims().size(), 7);
+
+  const JsonClaim* iss = payload.Find("iss");
+  ASSERT_NE(iss, nullptr);
+  EXPECT_EQ(iss->kind, JsonKind::kString);
+  EXPECT_THAT(payload.GetString(*iss), IsOkAndHolds("issuer"));
+
+  const JsonClaim* exp = payload.Find("exp");
+  ASSERT_NE(exp, nullptr);
+  EXPECT_EQ(exp->kind, JsonKind::kNumber);
+  EXPECT_EQ(exp->number_value, 123.5);
+
+  EXPECT_TRUE(payload.Find("b")->bool_value);
+  EXPECT_FALSE(payload.Find("f")->bool_value);
+  EXPECT_EQ(payload.Find("n")->kind, JsonKind::kNull);
+
+  const JsonClaim* o = payload.Find("o");
+  ASSERT_NE(o, nullptr);
+  EXPECT_EQ(o->kind, JsonKind::kObject);
+  EXPECT_EQ(payload.Value(*o), R"({"a":[1,{}]})");
+
+  const JsonClaim* l = payload.Find("l");
+  ASSERT_NE(l, nullptr);
+  EXPECT_EQ(l->kind, JsonKind::kArray);
+  EXPECT_THAT(payload.GetStringArray(*l),
+              IsOkAndHolds(ElementsAre("x", "y")));
+
+  EXPECT_EQ(payload.Find("sub"), nullptr);
+  EXPECT_EQ(payload.Find("unknown"), nullptr);
+  EXPECT_EQ(payload.claims()[2].name, "b");
+}
+
+TEST(JwtPayload, DecodesEscapes) {
+  auto payload_or = JwtPayload::Parse(
+      R"({"a\u0062":"\"\\\/\b\f\n\r\t\u00e9\u20ac\ud83d\ude00"})");
+  ASSERT_THAT(payload_or.status(), IsOk());
+  const JwtPayload& payload = payload_or.ValueOrDie();
+  const JsonClaim* claim = payload.Find("ab");
+  ASSERT_NE(claim, nullptr);
+  EXPECT_THAT(payload.GetString(*claim),
+              IsOkAndHolds("\"\\/\b\f\n\r\t\xc3\xa9\xe2\x82\xac"
+                           "\xf0\x9f\x98\x80"));
+}
+
+TEST(JwtPayload, AcceptsUtf8) {
+  auto payload_or = JwtPayload::Parse("{\"\xc3\xa9\":\"\xf0\x9f\x98\x80\"}");
+  ASSERT_THAT(payload_or.status(), IsOk());
+  const JwtPayload& payload = payload_or.ValueOrDie();
+  const JsonClaim* claim = payload.Find("\xc3\xa9");
+  ASSERT_NE(claim, nullptr);
+  EXPECT_THAT(payload.GetString(*claim), IsOkAndHolds("\xf0\x9f\x98\x80"));
+}
+
+TEST(JwtPayload, GetStringArrayRejectsOtherElements) {
+  auto payload_or = JwtPayload::Parse(R"({"aud":["a", 1], "e":[]})");
+  ASSERT_THAT(payload_or.status(), IsOk());
+  const JwtPayload& payload = payload_or.ValueOrDie();
+  EXPECT_THAT(payload.GetStringArray(*payload.Find("aud")).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(payload.GetStringArray(*payload.Find("e")),
+              IsOkAndHolds(IsEmpty()));
+  EXPECT_THAT(payload.GetString(*payload.Find("e")).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(JwtPayload, ComparesStringsInPlace) {
+  auto payload_or = JwtPayload::Parse(
+      R"({"iss":"a\u00e9\/b","n":1,"aud":["x", "\u0079"],"bad":["y", 1]})");
+  ASSERT_THAT(payload_or.status(), IsOk());
+  const JwtPayload& payload = payload_or.ValueOrDie();
+  const JsonClaim& iss = *payload.Find("iss");
+  EXPECT_TRUE(payload.StringEquals(iss, "a\xc3\xa9/b"));
+  EXPECT_FALSE(payload.StringEquals(iss, "a\xc3\xa9/"));
+  EXPECT_FALSE(payload.StringEquals(iss, "a\xc3\xa9/bc"));
+  EXPECT_FALSE(payload.StringEquals(iss, "a\\u00e9\\/b"));
+  EXPECT_FALSE(payload.StringEquals(*payload.Find("n"), "1"));
+
+  const JsonClaim& aud = *payload.Find("aud");
+  EXPECT_THAT(payload.StringArrayContains(aud, "y"), IsOkAndHolds(true));
+  EXPECT_THAT(payload.StringArrayContains(aud, "z"), IsOkAndHolds(false));
+  EXPECT_THAT(payload.StringArrayContains(*payload.Find("bad"), "y").status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(payload.StringArrayContains(iss, "x").status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(JwtPayload, RejectsInvalidJson) {
+  std::vector<std::string> invalid = {
+      "",
+      "[]",
+      "\"a\"",
+      "{",
+      "{\"a\"}",
+      "{\"a\":}",
+      "{\"a\":1,}",
+      "{\"a\":1} x",
+      "{a:1}",
+      "{\"a\":01}",
+      "{\"a\":1.}",
+      "{\"a\":.5}",
+      "{\"a\":1e}",
+      "{\"a\":+1}",
+      "{\"a\":1e999}",
+      "{\"a\":tru}",
+      "{\"a\":[1,]}",
+      "{\"a\":{\"b\"}}",
+      "{\"a\":\"\\x\"}",
+      "{\"a\":\"\\u12\"}",
+      "{\"a\":\"\\ud83d\"}",
+      "{\"a\":\"\\ude00\"}",
+      "{\"a\":\"\t\"}",
+      "{\"a\":\"\xc3\"}",
+      "{\"a\":\"\xed\xa0\x80\"}",
+      "{\"a\":\"\xc0\xaf\"}",
+      "{\"a\":1,\"a\":2}",
+      "{\"iss\":\"x\",\"iss\":\"y\"}",
+  };
+  for (const std::string& json : invalid) {
+    EXPECT_THAT(JwtPayload::Parse(json).status(),
+                StatusIs(util::error::INVALID_ARGUMENT))
+        << json;
+  }
+}
+
+TEST(JwtPayload, LimitsNestingDepth) {
+  std::string nested_ok = "{\"a\":" + std::string(99, '[') +
+                          std::string(99, ']') + "}";
+  EXPECT_THAT(JwtPayload::Parse(nested_ok).status(), IsOk());
+  std::string nested_too_deep = "{\"a\":" + std::string(100, '[') +
+                                std::string(100, ']') + "}";
+  EXPECT_THAT(JwtPayload::Parse(nested_too_deep).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+}  // namespace jwt_internal
+}  // namespace tink
+}  // namespace crypto
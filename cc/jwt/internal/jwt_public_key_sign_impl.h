@@ -18,6 +18,7 @@
 #define TINK_JWT_INTERNAL_JWT_PUBLIC_KEY_SIGN_IMPL_H_
 
 #include "absl/strings/string_view.h"
+#include "tink/jwt/internal/jwt_format.h"
 #include "tink/jwt/jwt_public_key_sign.h"
 #include "tink/jwt/raw_jwt.h"
 #include "tink/public_key_sign.h"
@@ -32,10 +33,10 @@ class JwtPublicKeySignImpl : public JwtPublicKeySign {
  public:
   explicit JwtPublicKeySignImpl(
       std::unique_ptr<crypto::tink::PublicKeySign> sign,
-      absl::string_view algorithm) {
-    sign_ = std::move(sign);
-    algorithm_ = std::string(algorithm);
-  }
+      absl::string_view algorithm)
+      : sign_(std::move(sign)),
+        algorithm_(algorithm),
+        encoded_header_(CreateHeader(algorithm)) {}
 
   crypto::tink::util::StatusOr<std::string> SignAndEncode(
       const crypto::tink::RawJwt& token) const override;
@@ -43,6 +44,8 @@ class JwtPublicKeySignImpl : public JwtPublicKeySign {
  private:
   std::unique_ptr<crypto::tink::PublicKeySign> sign_;
   std::string algorithm_;
+  // The base64url-encoded header, which is the same for every token.
+  std::string encoded_header_;
 };
 
 }  // namespace jwt_internal
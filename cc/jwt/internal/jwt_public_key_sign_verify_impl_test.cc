@@ -59,9 +59,28 @@ class JwtSignatureImplTest : public ::testing::Test {
         std::move(sign_result.ValueOrDie()), "ES256");
     jwt_verify_ = absl::make_unique<JwtPublicKeyVerifyImpl>(
         std::move(verify_result.ValueOrDie()), "ES256");
+
+    auto cached_verify_result = subtle::EcdsaVerifyBoringSsl::New(
+        ec_key, subtle::HashType::SHA256,
+        subtle::EcdsaSignatureEncoding::IEEE_P1363);
+    ASSERT_THAT(cached_verify_result.status(), IsOk());
+    JwtPublicKeyVerifyImpl::VerifiedTokenCacheOptions options;
+    options.max_cached_tokens = 1;
+    cached_jwt_verify_ = absl::make_unique<JwtPublicKeyVerifyImpl>(
+        std::move(cached_verify_result.ValueOrDie()), "ES256", options);
   }
+
+  std::string SignToken(RawJwtBuilder builder) {
+    auto raw_jwt_or = builder.Build();
+    EXPECT_THAT(raw_jwt_or.status(), IsOk());
+    auto compact_or = jwt_sign_->SignAndEncode(raw_jwt_or.ValueOrDie());
+    EXPECT_THAT(compact_or.status(), IsOk());
+    return compact_or.ValueOrDie();
+  }
+
   std::unique_ptr<JwtPublicKeySignImpl> jwt_sign_;
   std::unique_ptr<JwtPublicKeyVerifyImpl> jwt_verify_;
+  std::unique_ptr<JwtPublicKeyVerifyImpl> cached_jwt_verify_;
 };
 
 TEST_F(JwtSignatureImplTest, CreateAndValidateToken) {
@@ -143,6 +162,80 @@ TEST_F(JwtSignatureImplTest, FailsWithInvalidTokens) {
   EXPECT_FALSE(jwt_verify_->VerifyAndDecode("..", validator).ok());
 }
 
+TEST_F(JwtSignatureImplTest, CachesVerifiedTokens) {
+  absl::Time now = absl::Now();
+  std::string compact =
+      SignToken(RawJwtBuilder().SetIssuer("issuer").SetExpiration(
+          now + absl::Seconds(300)));
+  JwtValidator validator = JwtValidatorBuilder().Build();
+
+  EXPECT_THAT(
+      cached_jwt_verify_->VerifyAndDecode(compact, validator).status(),
+      IsOk());
+  auto verified_jwt_or =
+      cached_jwt_verify_->VerifyAndDecode(compact, validator);
+  ASSERT_THAT(verified_jwt_or.status(), IsOk());
+  EXPECT_THAT(verified_jwt_or.ValueOrDie().GetIssuer(),
+              test::IsOkAndHolds("issuer"));
+  auto stats = cached_jwt_verify_->GetVerifiedTokenCacheStats();
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+
+  // Cached tokens are still validated.
+  JwtValidator validator2 = JwtValidatorBuilder().SetIssuer("unknown").Build();
+  EXPECT_FALSE(cached_jwt_verify_->VerifyAndDecode(compact, validator2).ok());
+  JwtValidator validator_later =
+      JwtValidatorBuilder().SetFixedNow(now + absl::Seconds(600)).Build();
+  EXPECT_FALSE(
+      cached_jwt_verify_->VerifyAndDecode(compact, validator_later).ok());
+  stats = cached_jwt_verify_->GetVerifiedTokenCacheStats();
+  EXPECT_EQ(stats.hits, 3);
+  EXPECT_EQ(stats.misses, 1);
+
+  // A modified token is not found in the cache, and fails verification.
+  EXPECT_FALSE(
+      cached_jwt_verify_->VerifyAndDecode(absl::StrCat(compact, "x"), validator)
+          .ok());
+  EXPECT_EQ(cached_jwt_verify_->GetVerifiedTokenCacheStats().misses, 2);
+}
+
+TEST_F(JwtSignatureImplTest, DoesNotCacheTokensWithoutExpiration) {
+  std::string compact = SignToken(RawJwtBuilder().SetIssuer("issuer"));
+  JwtValidator validator = JwtValidatorBuilder().Build();
+
+  EXPECT_THAT(
+      cached_jwt_verify_->VerifyAndDecode(compact, validator).status(),
+      IsOk());
+  EXPECT_THAT(
+      cached_jwt_verify_->VerifyAndDecode(compact, validator).status(),
+      IsOk());
+  auto stats = cached_jwt_verify_->GetVerifiedTokenCacheStats();
+  EXPECT_EQ(stats.hits, 0);
+  EXPECT_EQ(stats.misses, 2);
+}
+
+TEST_F(JwtSignatureImplTest, EvictsLeastRecentlyUsedToken) {
+  absl::Time expiration = absl::Now() + absl::Seconds(300);
+  std::string compact1 = SignToken(
+      RawJwtBuilder().SetIssuer("issuer1").SetExpiration(expiration));
+  std::string compact2 = SignToken(
+      RawJwtBuilder().SetIssuer("issuer2").SetExpiration(expiration));
+  JwtValidator validator = JwtValidatorBuilder().Build();
+
+  // The cache holds one token, so alternating tokens always miss.
+  for (int i = 0; i < 2; i++) {
+    EXPECT_THAT(
+        cached_jwt_verify_->VerifyAndDecode(compact1, validator).status(),
+        IsOk());
+    EXPECT_THAT(
+        cached_jwt_verify_->VerifyAndDecode(compact2, validator).status(),
+        IsOk());
+  }
+  auto stats = cached_jwt_verify_->GetVerifiedTokenCacheStats();
+  EXPECT_EQ(stats.hits, 0);
+  EXPECT_EQ(stats.misses, 4);
+}
+
 }  // namespace
 }  // namespace jwt_internal
 }  // namespace tink
@@ -16,8 +16,14 @@
 
 #include "tink/jwt/internal/jwt_public_key_verify_impl.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "absl/strings/escaping.h"
 #include "absl/strings/str_split.h"
+#include "absl/time/clock.h"
+#include "openssl/sha.h"
 #include "tink/jwt/internal/jwt_format.h"
 
 namespace crypto {
@@ -26,6 +32,39 @@ namespace jwt_internal {
 
 util::StatusOr<VerifiedJwt> JwtPublicKeyVerifyImpl::VerifyAndDecode(
     absl::string_view compact, const JwtValidator& validator) const {
+  std::string hash;
+  absl::optional<RawJwt> cached;
+  if (options_.max_cached_tokens > 0) {
+    hash.resize(SHA256_DIGEST_LENGTH);
+    SHA256(reinterpret_cast<const uint8_t*>(compact.data()), compact.size(),
+           reinterpret_cast<uint8_t*>(&hash[0]));
+    cached = GetCachedToken(hash);
+  }
+  bool hit = cached.has_value();
+  if (hit) {
+    hits_++;
+  } else {
+    misses_++;
+    auto raw_jwt_or = VerifyAndParse(compact);
+    if (!raw_jwt_or.ok()) {
+      return raw_jwt_or.status();
+    }
+    cached = raw_jwt_or.ValueOrDie();
+  }
+  // The time claims, and the claims the validator expects, are checked on
+  // every call, also for cached tokens.
+  util::Status validate_result = validator.Validate(*cached);
+  if (!validate_result.ok()) {
+    return validate_result;
+  }
+  if (!hit && options_.max_cached_tokens > 0) {
+    CacheToken(std::move(hash), *cached);
+  }
+  return VerifiedJwt(*cached);
+}
+
+util::StatusOr<RawJwt> JwtPublicKeyVerifyImpl::VerifyAndParse(
+    absl::string_view compact) const {
   // TODO(juerg): Refactor this code into a util function.
   std::size_t signature_pos = compact.find_last_of('.');
   if (signature_pos == absl::string_view::npos) {
@@ -54,16 +93,51 @@ util::StatusOr<VerifiedJwt> JwtPublicKeyVerifyImpl::VerifyAndDecode(
   if (!DecodePayload(parts[1], &json_payload)) {
     return util::Status(util::error::INVALID_ARGUMENT, "invalid JWT payload");
   }
-  auto raw_jwt_or = RawJwt::FromString(json_payload);
-  if (!raw_jwt_or.ok()) {
-    return raw_jwt_or.status();
+  return RawJwt::FromString(json_payload);
+}
+
+absl::optional<RawJwt> JwtPublicKeyVerifyImpl::GetCachedToken(
+    absl::string_view hash) const {
+  absl::MutexLock lock(&mutex_);
+  auto it = cached_token_index_.find(hash);
+  if (it == cached_token_index_.end()) {
+    return absl::nullopt;
+  }
+  auto entry = it->second;
+  if (absl::Now() >= entry->expiration) {
+    cached_token_index_.erase(it);
+    cached_tokens_.erase(entry);
+    return absl::nullopt;
   }
-  RawJwt raw_jwt = raw_jwt_or.ValueOrDie();
-  util::Status validate_result = validator.Validate(raw_jwt);
-  if (!validate_result.ok()) {
-    return validate_result;
+  cached_tokens_.splice(cached_tokens_.begin(), cached_tokens_, entry);
+  return entry->raw_jwt;
+}
+
+void JwtPublicKeyVerifyImpl::CacheToken(std::string hash,
+                                        const RawJwt& raw_jwt) const {
+  auto expiration_or = raw_jwt.GetExpiration();
+  if (!expiration_or.ok() || absl::Now() >= expiration_or.ValueOrDie()) {
+    return;
+  }
+  absl::MutexLock lock(&mutex_);
+  if (cached_token_index_.contains(hash)) {
+    return;
+  }
+  cached_tokens_.push_front(
+      CachedToken{std::move(hash), raw_jwt, expiration_or.ValueOrDie()});
+  cached_token_index_[cached_tokens_.front().hash] = cached_tokens_.begin();
+  if (cached_tokens_.size() > options_.max_cached_tokens) {
+    cached_token_index_.erase(cached_tokens_.back().hash);
+    cached_tokens_.pop_back();
   }
-  return VerifiedJwt(raw_jwt);
+}
+
+JwtPublicKeyVerifyImpl::VerifiedTokenCacheStats
+JwtPublicKeyVerifyImpl::GetVerifiedTokenCacheStats() const {
+  VerifiedTokenCacheStats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  return stats;
 }
 
 }  // namespace jwt_internal
@@ -17,7 +17,18 @@
 #ifndef TINK_JWT_INTERNAL_JWT_PUBLIC_KEY_VERIFY_IMPL_H_
 #define TINK_JWT_INTERNAL_JWT_PUBLIC_KEY_VERIFY_IMPL_H_
 
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/optional.h"
 #include "tink/jwt/jwt_public_key_verify.h"
 #include "tink/jwt/jwt_validator.h"
 #include "tink/jwt/raw_jwt.h"
@@ -32,19 +43,66 @@ namespace jwt_internal {
 
 class JwtPublicKeyVerifyImpl : public JwtPublicKeyVerify {
  public:
+  // Bounds for caching verified tokens, which saves the signature
+  // verification when a token is verified again. Only tokens with an
+  // expiration are cached, and only until they expire; the validator is
+  // applied on every call. With the default values nothing is cached.
+  struct VerifiedTokenCacheOptions {
+    // Keeps up to this many tokens, and evicts the least recently used one
+    // when the cache is full. 0 disables the cache.
+    int max_cached_tokens = 0;
+  };
+
+  // Counts cache lookups; without caching, every call is a miss.
+  struct VerifiedTokenCacheStats {
+    int64_t hits = 0;
+    int64_t misses = 0;
+  };
+
   explicit JwtPublicKeyVerifyImpl(
       std::unique_ptr<crypto::tink::PublicKeyVerify> verify,
-      absl::string_view algorithm) {
-    verify_ = std::move(verify);
-    algorithm_ = std::string(algorithm);
-  }
+      absl::string_view algorithm)
+      : JwtPublicKeyVerifyImpl(std::move(verify), algorithm,
+                               VerifiedTokenCacheOptions()) {}
+
+  JwtPublicKeyVerifyImpl(std::unique_ptr<crypto::tink::PublicKeyVerify> verify,
+                         absl::string_view algorithm,
+                         const VerifiedTokenCacheOptions& options)
+      : verify_(std::move(verify)),
+        algorithm_(std::string(algorithm)),
+        options_(options) {}
 
   crypto::tink::util::StatusOr<VerifiedJwt> VerifyAndDecode(
       absl::string_view compact, const JwtValidator& validator) const override;
 
+  VerifiedTokenCacheStats GetVerifiedTokenCacheStats() const;
+
  private:
+  struct CachedToken {
+    // SHA-256 of the compact token.
+    std::string hash;
+    RawJwt raw_jwt;
+    absl::Time expiration;
+  };
+
+  // Verifies the signature and the header, and parses the payload.
+  crypto::tink::util::StatusOr<RawJwt> VerifyAndParse(
+      absl::string_view compact) const;
+  absl::optional<RawJwt> GetCachedToken(absl::string_view hash) const;
+  void CacheToken(std::string hash, const RawJwt& raw_jwt) const;
+
   std::unique_ptr<crypto::tink::PublicKeyVerify> verify_;
   std::string algorithm_;
+  const VerifiedTokenCacheOptions options_;
+
+  mutable absl::Mutex mutex_;
+  // Most recently used first.
+  mutable std::list<CachedToken> cached_tokens_ ABSL_GUARDED_BY(mutex_);
+  mutable absl::flat_hash_map<absl::string_view,
+                              std::list<CachedToken>::iterator>
+      cached_token_index_ ABSL_GUARDED_BY(mutex_);
+  mutable std::atomic<int64_t> hits_{0};
+  mutable std::atomic<int64_t> misses_{0};
 };
 
 }  // namespace jwt_internal
@@ -16,6 +16,8 @@
 
 #include "tink/jwt/internal/jwt_public_key_verify_wrapper.h"
 
+#include "absl/container/flat_hash_map.h"
+#include "tink/jwt/internal/jwt_format.h"
 #include "tink/jwt/jwt_public_key_verify.h"
 #include "tink/primitive_set.h"
 #include "tink/util/status.h"
@@ -33,7 +35,11 @@ class JwtPublicKeyVerifySetWrapper : public JwtPublicKeyVerify {
  public:
   explicit JwtPublicKeyVerifySetWrapper(
       std::unique_ptr<PrimitiveSet<JwtPublicKeyVerify>> jwt_verify_set)
-      : jwt_verify_set_(std::move(jwt_verify_set)) {}
+      : jwt_verify_set_(std::move(jwt_verify_set)) {
+    for (const auto* entry : jwt_verify_set_->get_all()) {
+      kid_index_[KeyIdToKid(entry->get_key_id())] = &entry->get_primitive();
+    }
+  }
 
   crypto::tink::util::StatusOr<crypto::tink::VerifiedJwt> VerifyAndDecode(
       absl::string_view compact,
@@ -43,6 +49,8 @@ class JwtPublicKeyVerifySetWrapper : public JwtPublicKeyVerify {
 
  private:
   std::unique_ptr<PrimitiveSet<JwtPublicKeyVerify>> jwt_verify_set_;
+  // The primitives by the "kid" of their key, see KeyIdToKid().
+  absl::flat_hash_map<std::string, JwtPublicKeyVerify*> kid_index_;
 };
 
 util::Status Validate(PrimitiveSet<JwtPublicKeyVerify>* jwt_verify_set) {
@@ -67,6 +75,21 @@ util::StatusOr<crypto::tink::VerifiedJwt>
 JwtPublicKeyVerifySetWrapper::VerifyAndDecode(
     absl::string_view compact,
     const crypto::tink::JwtValidator& validator) const {
+  // A token with the kid of one of the keys is only verified with that key.
+  // Tokens without a kid, or with a kid assigned outside Tink, are tried with
+  // all keys.
+  std::string kid;
+  if (GetKid(compact, &kid)) {
+    auto it = kid_index_.find(kid);
+    if (it != kid_index_.end()) {
+      auto verified_jwt_or = it->second->VerifyAndDecode(compact, validator);
+      if (verified_jwt_or.ok()) {
+        return verified_jwt_or;
+      }
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "verification failed");
+    }
+  }
   auto primitives_or = jwt_verify_set_->get_raw_primitives();
   if (primitives_or.ok()) {
     for (auto& entry : *(primitives_or.ValueOrDie())) {
@@ -0,0 +1,380 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/jwt/jwk_set_public_key_verify.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "google/protobuf/struct.pb.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/substitute.h"
+#include "tink/jwt/internal/json_util.h"
+#include "tink/jwt/internal/jwt_ecdsa_verify_key_manager.h"
+#include "tink/jwt/internal/jwt_format.h"
+#include "tink/jwt/internal/jwt_rsa_ssa_pkcs1_verify_key_manager.h"
+#include "tink/jwt/internal/jwt_rsa_ssa_pss_verify_key_manager.h"
+#include "proto/jwt_ecdsa.pb.h"
+#include "proto/jwt_rsa_ssa_pkcs1.pb.h"
+#include "proto/jwt_rsa_ssa_pss.pb.h"
+
+namespace crypto {
+namespace tink {
+
+namespace {
+
+using ::google::crypto::tink::JwtEcdsaAlgorithm;
+using ::google::crypto::tink::JwtEcdsaPublicKey;
+using ::google::crypto::tink::JwtRsaSsaPkcs1Algorithm;
+using ::google::crypto::tink::JwtRsaSsaPkcs1PublicKey;
+using ::google::crypto::tink::JwtRsaSsaPssAlgorithm;
+using ::google::crypto::tink::JwtRsaSsaPssPublicKey;
+
+enum class JwkType { kUnsupported, kEcdsa, kRsaSsaPkcs1, kRsaSsaPss };
+
+// A JWK, converted to the corresponding Tink key.
+struct Jwk {
+  JwkType type = JwkType::kUnsupported;
+  bool has_kid = false;
+  std::string kid;
+  JwtEcdsaPublicKey ecdsa_key;
+  JwtRsaSsaPkcs1PublicKey rsa_ssa_pkcs1_key;
+  JwtRsaSsaPssPublicKey rsa_ssa_pss_key;
+};
+
+// Returns the string member 'name' of 'jwk', or a NOT_FOUND error.
+util::StatusOr<std::string> GetString(const google::protobuf::Struct& jwk,
+                                      absl::string_view name) {
+  auto it = jwk.fields().find(std::string(name));
+  if (it == jwk.fields().end()) {
+    return util::Status(util::error::NOT_FOUND,
+                        absl::Substitute("JWK has no '$0'", name));
+  }
+  if (it->second.kind_case() != google::protobuf::Value::kStringValue) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        absl::Substitute("JWK '$0' is not a string", name));
+  }
+  return it->second.string_value();
+}
+
+util::StatusOr<std::string> GetBase64UrlBytes(
+    const google::protobuf::Struct& jwk, absl::string_view name) {
+  auto value_or = GetString(jwk, name);
+  if (!value_or.ok()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        value_or.status().error_message());
+  }
+  std::string bytes;
+  if (!absl::WebSafeBase64Unescape(value_or.ValueOrDie(), &bytes)) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        absl::Substitute("JWK '$0' is not base64url", name));
+  }
+  return bytes;
+}
+
+util::Status ParseEcdsaJwk(const google::protobuf::Struct& jwk,
+                           absl::string_view alg, Jwk* result) {
+  auto crv_or = GetString(jwk, "crv");
+  if (!crv_or.ok()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        crv_or.status().error_message());
+  }
+  JwtEcdsaAlgorithm algorithm;
+  absl::string_view expected_alg;
+  if (crv_or.ValueOrDie() == "P-256") {
+    algorithm = JwtEcdsaAlgorithm::ES256;
+    expected_alg = "ES256";
+  } else if (crv_or.ValueOrDie() == "P-384") {
+    algorithm = JwtEcdsaAlgorithm::ES384;
+    expected_alg = "ES384";
+  } else if (crv_or.ValueOrDie() == "P-521") {
+    algorithm = JwtEcdsaAlgorithm::ES512;
+    expected_alg = "ES512";
+  } else {
+    return util::OkStatus();  // Unsupported curve.
+  }
+  if (!alg.empty() && alg != expected_alg) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "JWK 'alg' does not match 'crv'");
+  }
+  auto x_or = GetBase64UrlBytes(jwk, "x");
+  if (!x_or.ok()) return x_or.status();
+  auto y_or = GetBase64UrlBytes(jwk, "y");
+  if (!y_or.ok()) return y_or.status();
+  result->type = JwkType::kEcdsa;
+  result->ecdsa_key.set_version(0);
+  result->ecdsa_key.set_algorithm(algorithm);
+  result->ecdsa_key.set_x(x_or.ValueOrDie());
+  result->ecdsa_key.set_y(y_or.ValueOrDie());
+  return util::OkStatus();
+}
+
+util::Status ParseRsaJwk(const google::protobuf::Struct& jwk,
+                         absl::string_view alg, Jwk* result) {
+  // RSA keys can be used with several algorithms, so 'alg' is required.
+  if (alg == "RS256") {
+    result->rsa_ssa_pkcs1_key.set_algorithm(JwtRsaSsaPkcs1Algorithm::RS256);
+  } else if (alg == "RS384") {
+    result->rsa_ssa_pkcs1_key.set_algorithm(JwtRsaSsaPkcs1Algorithm::RS384);
+  } else if (alg == "RS512") {
+    result->rsa_ssa_pkcs1_key.set_algorithm(JwtRsaSsaPkcs1Algorithm::RS512);
+  } else if (alg == "PS256") {
+    result->rsa_ssa_pss_key.set_algorithm(JwtRsaSsaPssAlgorithm::PS256);
+  } else if (alg == "PS384") {
+    result->rsa_ssa_pss_key.set_algorithm(JwtRsaSsaPssAlgorithm::PS384);
+  } else if (alg == "PS512") {
+    result->rsa_ssa_pss_key.set_algorithm(JwtRsaSsaPssAlgorithm::PS512);
+  } else {
+    return util::OkStatus();  // Unsupported algorithm.
+  }
+  auto n_or = GetBase64UrlBytes(jwk, "n");
+  if (!n_or.ok()) return n_or.status();
+  auto e_or = GetBase64UrlBytes(jwk, "e");
+  if (!e_or.ok()) return e_or.status();
+  if (alg[0] == 'R') {
+    result->type = JwkType::kRsaSsaPkcs1;
+    result->rsa_ssa_pkcs1_key.set_version(0);
+    result->rsa_ssa_pkcs1_key.set_n(n_or.ValueOrDie());
+    result->rsa_ssa_pkcs1_key.set_e(e_or.ValueOrDie());
+  } else {
+    result->type = JwkType::kRsaSsaPss;
+    result->rsa_ssa_pss_key.set_version(0);
+    result->rsa_ssa_pss_key.set_n(n_or.ValueOrDie());
+    result->rsa_ssa_pss_key.set_e(e_or.ValueOrDie());
+  }
+  return util::OkStatus();
+}
+
+// Converts 'jwk'. Unsupported keys have type kUnsupported.
+util::StatusOr<Jwk> ParseJwk(const google::protobuf::Value& value) {
+  if (value.kind_case() != google::protobuf::Value::kStructValue) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "JWK is not a JSON object");
+  }
+  const google::protobuf::Struct& jwk = value.struct_value();
+  Jwk result;
+  auto kty_or = GetString(jwk, "kty");
+  if (!kty_or.ok()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        kty_or.status().error_message());
+  }
+  auto use_or = GetString(jwk, "use");
+  if (use_or.ok() && use_or.ValueOrDie() != "sig") {
+    return result;
+  }
+  auto kid_or = GetString(jwk, "kid");
+  if (kid_or.ok()) {
+    result.has_kid = true;
+    result.kid = kid_or.ValueOrDie();
+  }
+  std::string alg;
+  auto alg_or = GetString(jwk, "alg");
+  if (alg_or.ok()) {
+    alg = alg_or.ValueOrDie();
+  }
+  for (const auto& status : {use_or.status(), kid_or.status(),
+                             alg_or.status()}) {
+    if (!status.ok() && status.error_code() != util::error::NOT_FOUND) {
+      return status;
+    }
+  }
+  util::Status status = util::OkStatus();
+  if (kty_or.ValueOrDie() == "EC") {
+    status = ParseEcdsaJwk(jwk, alg, &result);
+  } else if (kty_or.ValueOrDie() == "RSA") {
+    status = ParseRsaJwk(jwk, alg, &result);
+  }
+  if (!status.ok()) {
+    return status;
+  }
+  return result;
+}
+
+// Identifies the key material and algorithm of a supported JWK.
+std::string Fingerprint(const Jwk& jwk) {
+  switch (jwk.type) {
+    case JwkType::kEcdsa:
+      return absl::StrCat("EC:", jwk.ecdsa_key.SerializeAsString());
+    case JwkType::kRsaSsaPkcs1:
+      return absl::StrCat("RS:", jwk.rsa_ssa_pkcs1_key.SerializeAsString());
+    case JwkType::kRsaSsaPss:
+      return absl::StrCat("PS:", jwk.rsa_ssa_pss_key.SerializeAsString());
+    default:
+      return "";
+  }
+}
+
+template <typename KeyManager, typename KeyProto>
+util::StatusOr<std::unique_ptr<JwtPublicKeyVerify>> NewVerify(
+    const KeyProto& key) {
+  KeyManager key_manager;
+  util::Status status = key_manager.ValidateKey(key);
+  if (!status.ok()) {
+    return status;
+  }
+  return key_manager.template GetPrimitive<JwtPublicKeyVerify>(key);
+}
+
+util::StatusOr<std::unique_ptr<JwtPublicKeyVerify>> NewVerify(
+    const Jwk& jwk) {
+  switch (jwk.type) {
+    case JwkType::kEcdsa:
+      return NewVerify<jwt_internal::JwtEcdsaVerifyKeyManager>(jwk.ecdsa_key);
+    case JwkType::kRsaSsaPkcs1:
+      return NewVerify<jwt_internal::JwtRsaSsaPkcs1VerifyKeyManager>(
+          jwk.rsa_ssa_pkcs1_key);
+    case JwkType::kRsaSsaPss:
+      return NewVerify<jwt_internal::JwtRsaSsaPssVerifyKeyManager>(
+          jwk.rsa_ssa_pss_key);
+    default:
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "unsupported JWK");
+  }
+}
+
+}  // namespace
+
+// static
+util::StatusOr<std::unique_ptr<JwkSetPublicKeyVerify>>
+JwkSetPublicKeyVerify::New(absl::string_view jwk_set) {
+  auto verify = absl::WrapUnique(new JwkSetPublicKeyVerify());
+  auto stats_or = verify->Refresh(jwk_set);
+  if (!stats_or.ok()) {
+    return stats_or.status();
+  }
+  return std::move(verify);
+}
+
+util::StatusOr<JwkSetPublicKeyVerify::RefreshStats>
+JwkSetPublicKeyVerify::Refresh(absl::string_view jwk_set) {
+  auto proto_or = jwt_internal::JsonStringToProtoStruct(jwk_set);
+  if (!proto_or.ok()) {
+    return proto_or.status();
+  }
+  const auto& fields = proto_or.ValueOrDie().fields();
+  auto keys_it = fields.find("keys");
+  if (keys_it == fields.end() ||
+      keys_it->second.kind_case() != google::protobuf::Value::kListValue) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "JWK Set has no 'keys' list");
+  }
+
+  absl::MutexLock refresh_lock(&refresh_mutex_);
+  std::shared_ptr<const KeySet> old_key_set = GetKeySet();
+  absl::flat_hash_map<absl::string_view,
+                      std::shared_ptr<const JwtPublicKeyVerify>>
+      old_primitives;
+  for (const Key& key : old_key_set->keys) {
+    old_primitives[key.fingerprint] = key.verify;
+  }
+
+  RefreshStats stats;
+  auto key_set = std::make_shared<KeySet>();
+  absl::flat_hash_set<std::string> fingerprints;
+  for (const auto& value : keys_it->second.list_value().values()) {
+    auto jwk_or = ParseJwk(value);
+    if (!jwk_or.ok()) {
+      return jwk_or.status();
+    }
+    const Jwk& jwk = jwk_or.ValueOrDie();
+    if (jwk.type == JwkType::kUnsupported) {
+      stats.skipped++;
+      continue;
+    }
+    Key key;
+    key.has_kid = jwk.has_kid;
+    key.kid = jwk.kid;
+    key.fingerprint = Fingerprint(jwk);
+    auto it = old_primitives.find(key.fingerprint);
+    if (it != old_primitives.end()) {
+      key.verify = it->second;
+      stats.reused++;
+    } else {
+      auto verify_or = NewVerify(jwk);
+      if (!verify_or.ok()) {
+        return verify_or.status();
+      }
+      key.verify = std::move(verify_or.ValueOrDie());
+      stats.created++;
+    }
+    fingerprints.insert(key.fingerprint);
+    int index = key_set->keys.size();
+    if (key.has_kid) {
+      key_set->keys_by_kid[key.kid].push_back(index);
+    } else {
+      key_set->keys_without_kid.push_back(index);
+    }
+    key_set->keys.push_back(std::move(key));
+  }
+  for (const Key& key : old_key_set->keys) {
+    if (!fingerprints.contains(key.fingerprint)) {
+      stats.removed++;
+    }
+  }
+
+  absl::MutexLock lock(&mutex_);
+  key_set_ = std::move(key_set);
+  return stats;
+}
+
+std::shared_ptr<const JwkSetPublicKeyVerify::KeySet>
+JwkSetPublicKeyVerify::GetKeySet() const {
+  absl::MutexLock lock(&mutex_);
+  return key_set_;
+}
+
+util::StatusOr<VerifiedJwt> JwkSetPublicKeyVerify::VerifyAndDecode(
+    absl::string_view compact, const JwtValidator& validator) const {
+  std::shared_ptr<const KeySet> key_set = GetKeySet();
+  std::string kid;
+  if (!jwt_internal::GetKid(compact, &kid)) {
+    for (const Key& key : key_set->keys) {
+      auto verified_jwt_or = key.verify->VerifyAndDecode(compact, validator);
+      if (verified_jwt_or.ok()) {
+        return verified_jwt_or;
+      }
+    }
+    return util::Status(util::error::INVALID_ARGUMENT, "verification failed");
+  }
+  auto it = key_set->keys_by_kid.find(kid);
+  if (it != key_set->keys_by_kid.end()) {
+    for (int index : it->second) {
+      auto verified_jwt_or =
+          key_set->keys[index].verify->VerifyAndDecode(compact, validator);
+      if (verified_jwt_or.ok()) {
+        return verified_jwt_or;
+      }
+    }
+  }
+  for (int index : key_set->keys_without_kid) {
+    auto verified_jwt_or =
+        key_set->keys[index].verify->VerifyAndDecode(compact, validator);
+    if (verified_jwt_or.ok()) {
+      return verified_jwt_or;
+    }
+  }
+  return util::Status(util::error::INVALID_ARGUMENT, "verification failed");
+}
+
+}  // namespace tink
+}  // namespace crypto
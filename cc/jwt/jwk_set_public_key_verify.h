@@ -0,0 +1,112 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_JWT_JWK_SET_PUBLIC_KEY_VERIFY_H_
+#define TINK_JWT_JWK_SET_PUBLIC_KEY_VERIFY_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "tink/jwt/jwt_public_key_verify.h"
+#include "tink/jwt/jwt_validator.h"
+#include "tink/jwt/verified_jwt.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+///////////////////////////////////////////////////////////////////////////////
+// A JwtPublicKeyVerify for the public keys of a JSON Web Key Set
+// (https://tools.ietf.org/html/rfc7517#section-5), as published by identity
+// providers.
+//
+// Supported are keys with "kty" EC (ES256, ES384 and ES512) and RSA (RS256,
+// RS384, RS512, PS256, PS384 and PS512; RSA keys need an "alg"). Other keys,
+// and keys whose "use" is not "sig", are skipped.
+//
+// Refresh() replaces the keys, e.g. after fetching the JWK Set again. Keys
+// that did not change keep their primitives, so only new keys are parsed and
+// instantiated. Calls to VerifyAndDecode() that run concurrently with a
+// refresh use either the old or the new keys.
+//
+// A token with a "kid" header is only verified with the keys with that kid,
+// and with the keys without a kid; other tokens are tried with all keys.
+class JwkSetPublicKeyVerify : public JwtPublicKeyVerify {
+ public:
+  // What a refresh changed.
+  struct RefreshStats {
+    // Keys that were new or had changed.
+    int created = 0;
+    // Keys that kept their primitive.
+    int reused = 0;
+    // Keys of the previous set that are no longer present.
+    int removed = 0;
+    // Keys that are not supported.
+    int skipped = 0;
+  };
+
+  static crypto::tink::util::StatusOr<std::unique_ptr<JwkSetPublicKeyVerify>>
+  New(absl::string_view jwk_set);
+
+  // Replaces the keys with those of 'jwk_set'. On errors, the current keys
+  // are kept.
+  crypto::tink::util::StatusOr<RefreshStats> Refresh(absl::string_view jwk_set)
+      ABSL_LOCKS_EXCLUDED(refresh_mutex_, mutex_);
+
+  crypto::tink::util::StatusOr<VerifiedJwt> VerifyAndDecode(
+      absl::string_view compact,
+      const JwtValidator& validator) const override;
+
+  ~JwkSetPublicKeyVerify() override {}
+
+ private:
+  struct Key {
+    bool has_kid;
+    std::string kid;
+    // Identifies the key material, including the algorithm.
+    std::string fingerprint;
+    std::shared_ptr<const JwtPublicKeyVerify> verify;
+  };
+
+  struct KeySet {
+    std::vector<Key> keys;
+    // Indices into 'keys' of the keys with a given kid.
+    absl::flat_hash_map<std::string, std::vector<int>> keys_by_kid;
+    // Indices into 'keys' of the keys without a kid.
+    std::vector<int> keys_without_kid;
+  };
+
+  JwkSetPublicKeyVerify() : key_set_(std::make_shared<KeySet>()) {}
+
+  std::shared_ptr<const KeySet> GetKeySet() const ABSL_LOCKS_EXCLUDED(mutex_);
+
+  // Serializes refreshes, so that each one reuses the keys of the last one.
+  absl::Mutex refresh_mutex_;
+  mutable absl::Mutex mutex_;
+  std::shared_ptr<const KeySet> key_set_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_JWT_JWK_SET_PUBLIC_KEY_VERIFY_H_
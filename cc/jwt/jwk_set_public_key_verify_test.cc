@@ -0,0 +1,192 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/jwt/jwk_set_public_key_verify.h"
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/substitute.h"
+#include "tink/jwt/internal/jwt_format.h"
+#include "tink/jwt/jwt_validator.h"
+#include "tink/public_key_sign.h"
+#include "tink/subtle/common_enums.h"
+#include "tink/subtle/ecdsa_sign_boringssl.h"
+#include "tink/subtle/subtle_util_boringssl.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::IsOkAndHolds;
+using ::crypto::tink::test::StatusIs;
+
+// An ES256 key, with a signer for tokens and its JWK.
+class TestKey {
+ public:
+  TestKey() {
+    auto ec_key_or = subtle::SubtleUtilBoringSSL::GetNewEcKey(
+        subtle::EllipticCurveType::NIST_P256);
+    EXPECT_THAT(ec_key_or.status(), IsOk());
+    ec_key_ = ec_key_or.ValueOrDie();
+    auto sign_or = subtle::EcdsaSignBoringSsl::New(
+        ec_key_, subtle::HashType::SHA256,
+        subtle::EcdsaSignatureEncoding::IEEE_P1363);
+    EXPECT_THAT(sign_or.status(), IsOk());
+    sign_ = std::move(sign_or.ValueOrDie());
+  }
+
+  std::string Jwk(absl::string_view kid) const {
+    return absl::Substitute(
+        R"({"kty":"EC","crv":"P-256","use":"sig","kid":"$0",)"
+        R"("x":"$1","y":"$2"})",
+        kid, absl::WebSafeBase64Escape(ec_key_.pub_x),
+        absl::WebSafeBase64Escape(ec_key_.pub_y));
+  }
+
+  // Returns a token with the issuer "issuer", and 'kid' unless it is empty.
+  std::string Sign(absl::string_view kid) const {
+    std::string header =
+        kid.empty() ? R"({"alg":"ES256"})"
+                    : absl::StrCat(R"({"alg":"ES256","kid":")", kid, R"("})");
+    std::string unsigned_token =
+        absl::StrCat(jwt_internal::EncodeHeader(header), ".",
+                     jwt_internal::EncodePayload(R"({"iss":"issuer"})"));
+    auto signature_or = sign_->Sign(unsigned_token);
+    EXPECT_THAT(signature_or.status(), IsOk());
+    return absl::StrCat(
+        unsigned_token, ".",
+        jwt_internal::EncodeSignature(signature_or.ValueOrDie()));
+  }
+
+ private:
+  subtle::SubtleUtilBoringSSL::EcKey ec_key_;
+  std::unique_ptr<PublicKeySign> sign_;
+};
+
+std::string JwkSet(const std::string& jwk1, const std::string& jwk2) {
+  return absl::StrCat(R"({"keys":[)", jwk1, ",", jwk2, "]}");
+}
+
+TEST(JwkSetPublicKeyVerifyTest, VerifiesTokens) {
+  TestKey key1;
+  TestKey key2;
+  auto verify_or =
+      JwkSetPublicKeyVerify::New(JwkSet(key1.Jwk("k1"), key2.Jwk("k2")));
+  ASSERT_THAT(verify_or.status(), IsOk());
+  const JwkSetPublicKeyVerify& verify = *verify_or.ValueOrDie();
+  JwtValidator validator = JwtValidatorBuilder().Build();
+
+  auto verified_jwt_or = verify.VerifyAndDecode(key2.Sign("k2"), validator);
+  ASSERT_THAT(verified_jwt_or.status(), IsOk());
+  EXPECT_THAT(verified_jwt_or.ValueOrDie().GetIssuer(),
+              IsOkAndHolds("issuer"));
+  // Without a kid, all keys are tried.
+  EXPECT_THAT(verify.VerifyAndDecode(key1.Sign(""), validator).status(),
+              IsOk());
+  // With a kid, only the keys with that kid are tried.
+  EXPECT_FALSE(verify.VerifyAndDecode(key1.Sign("k2"), validator).ok());
+  EXPECT_FALSE(verify.VerifyAndDecode(key1.Sign("k3"), validator).ok());
+
+  JwtValidator wrong_issuer = JwtValidatorBuilder().SetIssuer("other").Build();
+  EXPECT_FALSE(verify.VerifyAndDecode(key1.Sign("k1"), wrong_issuer).ok());
+}
+
+TEST(JwkSetPublicKeyVerifyTest, RefreshReusesUnchangedKeys) {
+  TestKey key1;
+  TestKey key2;
+  TestKey key3;
+  auto verify_or =
+      JwkSetPublicKeyVerify::New(JwkSet(key1.Jwk("k1"), key2.Jwk("k2")));
+  ASSERT_THAT(verify_or.status(), IsOk());
+  JwkSetPublicKeyVerify& verify = *verify_or.ValueOrDie();
+  JwtValidator validator = JwtValidatorBuilder().Build();
+
+  auto stats_or = verify.Refresh(JwkSet(key2.Jwk("k2"), key3.Jwk("k3")));
+  ASSERT_THAT(stats_or.status(), IsOk());
+  EXPECT_EQ(stats_or.ValueOrDie().created, 1);
+  EXPECT_EQ(stats_or.ValueOrDie().reused, 1);
+  EXPECT_EQ(stats_or.ValueOrDie().removed, 1);
+  EXPECT_EQ(stats_or.ValueOrDie().skipped, 0);
+
+  EXPECT_FALSE(verify.VerifyAndDecode(key1.Sign("k1"), validator).ok());
+  EXPECT_THAT(verify.VerifyAndDecode(key2.Sign("k2"), validator).status(),
+              IsOk());
+  EXPECT_THAT(verify.VerifyAndDecode(key3.Sign("k3"), validator).status(),
+              IsOk());
+}
+
+TEST(JwkSetPublicKeyVerifyTest, FailedRefreshKeepsKeys) {
+  TestKey key1;
+  TestKey key2;
+  auto verify_or =
+      JwkSetPublicKeyVerify::New(JwkSet(key1.Jwk("k1"), key2.Jwk("k2")));
+  ASSERT_THAT(verify_or.status(), IsOk());
+  JwkSetPublicKeyVerify& verify = *verify_or.ValueOrDie();
+  JwtValidator validator = JwtValidatorBuilder().Build();
+
+  EXPECT_THAT(verify.Refresh(R"({"keys":[{"kty":"EC","crv":"P-256"}]})")
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(verify.Refresh(R"({"no_keys":[]})").status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_FALSE(verify.Refresh("not JSON").ok());
+  EXPECT_THAT(verify.VerifyAndDecode(key1.Sign("k1"), validator).status(),
+              IsOk());
+}
+
+TEST(JwkSetPublicKeyVerifyTest, SkipsUnsupportedKeys) {
+  TestKey key1;
+  std::string jwk_set = absl::StrCat(
+      R"({"keys":[)", key1.Jwk("k1"),
+      R"(,{"kty":"oct","k":"AAAA"})",
+      R"(,{"kty":"RSA","n":"AQAB","e":"AQAB"})",
+      R"(,{"kty":"EC","crv":"P-256","use":"enc","x":"AA","y":"AA"}]})");
+  auto verify_or = JwkSetPublicKeyVerify::New(jwk_set);
+  ASSERT_THAT(verify_or.status(), IsOk());
+  JwkSetPublicKeyVerify& verify = *verify_or.ValueOrDie();
+  auto stats_or = verify.Refresh(jwk_set);
+  ASSERT_THAT(stats_or.status(), IsOk());
+  EXPECT_EQ(stats_or.ValueOrDie().skipped, 3);
+  EXPECT_EQ(stats_or.ValueOrDie().reused, 1);
+}
+
+TEST(JwkSetPublicKeyVerifyTest, RejectsInvalidKeys) {
+  TestKey key1;
+  // 'alg' does not match the curve.
+  EXPECT_THAT(JwkSetPublicKeyVerify::New(
+                  R"({"keys":[{"kty":"EC","crv":"P-256","alg":"ES384",)"
+                  R"("x":"AA","y":"AA"}]})")
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  // Not a point on the curve.
+  EXPECT_FALSE(JwkSetPublicKeyVerify::New(
+                   R"({"keys":[{"kty":"EC","crv":"P-256","x":"AA","y":"AA"}]})")
+                   .ok());
+  EXPECT_THAT(JwkSetPublicKeyVerify::New(R"({"keys":[1]})").status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
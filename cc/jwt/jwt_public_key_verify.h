@@ -17,7 +17,12 @@
 #ifndef TINK_JWT_PUBLIC_KEY_VERIFY_H_
 #define TINK_JWT_PUBLIC_KEY_VERIFY_H_
 
+#include <cstdint>
+#include <vector>
+
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/util/executor.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "tink/jwt/verified_jwt.h"
@@ -48,6 +53,26 @@ class JwtPublicKeyVerify {
   virtual crypto::tink::util::StatusOr<VerifiedJwt> VerifyAndDecode(
       absl::string_view compact, const JwtValidator& validator) const = 0;
 
+  // Verifies and decodes each of 'compacts' with VerifyAndDecode() against
+  // 'validator', on the calling thread and up to num_threads - 1 tasks on
+  // util::Executor::Global() (num_threads values below 1 are treated as 1).
+  // Element i of the result holds the outcome for compacts[i]; a token that
+  // does not verify does not affect the others.
+  //
+  // Implementations should override this method if they can amortize
+  // per-token work over the batch; the default implementation calls
+  // VerifyAndDecode() for each token.
+  virtual std::vector<crypto::tink::util::StatusOr<VerifiedJwt>>
+  VerifyAndDecodeBatch(absl::Span<const absl::string_view> compacts,
+                       const JwtValidator& validator, int num_threads) const {
+    std::vector<crypto::tink::util::StatusOr<VerifiedJwt>> results(
+        compacts.size());
+    util::ParallelFor(compacts.size(), num_threads, [&](int64_t i) {
+      results[i] = VerifyAndDecode(compacts[i], validator);
+    });
+    return results;
+  }
+
   virtual ~JwtPublicKeyVerify() {}
 };
 
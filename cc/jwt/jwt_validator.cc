@@ -16,6 +16,9 @@
 
 #include "tink/jwt/jwt_validator.h"
 
+#include "absl/strings/str_cat.h"
+#include "tink/jwt/internal/jwt_payload.h"
+
 namespace crypto {
 namespace tink {
 
@@ -23,8 +26,30 @@ namespace {
 
 static constexpr absl::Duration kJwtMaxClockSkew = absl::Minutes(10);
 
+// Checks that the string claim 'name' is 'expected', comparing it in place
+// rather than decoding it into a new string. 'label' names the claim in
+// errors.
+util::Status CheckStringClaim(const jwt_internal::JwtPayload& payload,
+                              absl::string_view name, absl::string_view label,
+                              absl::string_view expected) {
+  const jwt_internal::JsonClaim* claim = payload.Find(name);
+  if (claim == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        absl::StrCat("missing expected ", label));
+  }
+  if (claim->kind != jwt_internal::JsonKind::kString) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        absl::StrCat(label, " is not a string"));
+  }
+  if (!payload.StringEquals(*claim, expected)) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        absl::StrCat("wrong ", label));
+  }
+  return util::OkStatus();
 }
 
+}  // namespace
+
 JwtValidator::JwtValidator(absl::optional<absl::string_view> issuer,
                            absl::optional<absl::string_view> subject,
                            absl::optional<absl::string_view> audience,
@@ -69,48 +94,40 @@ util::Status JwtValidator::Validate(RawJwt const& raw_jwt) const {
                         "token cannot yet be used");
     }
   }
-  if (issuer_.has_value()){
-    if (!raw_jwt.HasIssuer()) {
-      return util::Status(util::error::INVALID_ARGUMENT,
-                          "missing expected issuer");
-    }
-    auto issuer_or = raw_jwt.GetIssuer();
-    if (!issuer_or.ok()) {
-      return issuer_or.status();
-    }
-    if (issuer_.value() != issuer_or.ValueOrDie()) {
-      return util::Status(util::error::INVALID_ARGUMENT, "wrong issuer");
+  // Claims are compared in place, so that validating a token which passes
+  // does not allocate.
+  const jwt_internal::JwtPayload& payload = raw_jwt.payload_;
+  if (issuer_.has_value()) {
+    util::Status status =
+        CheckStringClaim(payload, "iss", "issuer", issuer_.value());
+    if (!status.ok()) {
+      return status;
     }
   }
   if (subject_.has_value()) {
-    if (!raw_jwt.HasSubject()) {
-      return util::Status(util::error::INVALID_ARGUMENT,
-                          "missing expected subject");
-    }
-    auto subject_or = raw_jwt.GetSubject();
-    if (!subject_or.ok()) {
-      return subject_or.status();
-    }
-    if (subject_.value() != subject_or.ValueOrDie()) {
-      return util::Status(util::error::INVALID_ARGUMENT, "wrong subject");
+    util::Status status =
+        CheckStringClaim(payload, "sub", "subject", subject_.value());
+    if (!status.ok()) {
+      return status;
     }
   }
+  const jwt_internal::JsonClaim* audiences = payload.Find("aud");
   if (audience_.has_value()) {
-    if (!raw_jwt.HasAudiences()) {
+    if (audiences == nullptr) {
       return util::Status(util::error::INVALID_ARGUMENT,
                           "missing expected audiences");
     }
-    auto audiences_or = raw_jwt.GetAudiences();
-    if (!audiences_or.ok()) {
-      return audiences_or.status();
+    util::StatusOr<bool> found_or =
+        payload.StringArrayContains(*audiences, audience_.value());
+    if (!found_or.ok()) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "Audiences is not a list of strings");
     }
-    std::vector<std::string> audiences = audiences_or.ValueOrDie();
-    auto it = std::find(audiences.begin(), audiences.end(), audience_);
-    if (it == audiences.end()) {
+    if (!found_or.ValueOrDie()) {
       return util::Status(util::error::INVALID_ARGUMENT, "audience not found");
     }
   } else {
-    if (raw_jwt.HasAudiences()) {
+    if (audiences != nullptr) {
       return util::Status(
           util::error::INVALID_ARGUMENT,
           "invalid JWT; token has audience set, but validator not");
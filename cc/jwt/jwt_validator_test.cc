@@ -139,6 +139,28 @@ TEST(JwtValidator, CorrectIssuerOK) {
   EXPECT_THAT(validator.Validate(jwt), IsOk());
 }
 
+TEST(JwtValidator, EscapedIssuerOK) {
+  util::StatusOr<RawJwt> jwt_or =
+      RawJwt::FromString(R"({"iss":"https:\/\/ex\u0061mple.com"})");
+  ASSERT_THAT(jwt_or.status(), IsOk());
+  RawJwt jwt = jwt_or.ValueOrDie();
+
+  JwtValidator validator =
+      JwtValidatorBuilder().SetIssuer("https://example.com").Build();
+
+  EXPECT_THAT(validator.Validate(jwt), IsOk());
+}
+
+TEST(JwtValidator, NonStringIssuerNotOK) {
+  util::StatusOr<RawJwt> jwt_or = RawJwt::FromString(R"({"iss":1})");
+  ASSERT_THAT(jwt_or.status(), IsOk());
+  RawJwt jwt = jwt_or.ValueOrDie();
+
+  JwtValidator validator = JwtValidatorBuilder().SetIssuer("1").Build();
+
+  EXPECT_FALSE(validator.Validate(jwt).ok());
+}
+
 TEST(JwtValidator, DontCheckIssuerOK) {
   util::StatusOr<RawJwt> jwt_or = RawJwtBuilder().SetIssuer("issuer").Build();
   ASSERT_THAT(jwt_or.status(), IsOk());
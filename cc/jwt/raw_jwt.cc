@@ -16,10 +16,16 @@
 
 #include "tink/jwt/raw_jwt.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/substitute.h"
 #include "tink/jwt/internal/json_util.h"
+#include "tink/jwt/internal/jwt_payload.h"
 
 namespace crypto {
 namespace tink {
@@ -53,315 +59,262 @@ util::Status ValidatePayloadName(absl::string_view name) {
   return util::OkStatus();
 }
 
-bool hasClaimOfKind(const google::protobuf::Struct& json_proto,
-                    absl::string_view name,
-                    google::protobuf::Value::KindCase kind) {
+// Returns the custom claim 'name' if it is of the given kind, or nullptr.
+const jwt_internal::JsonClaim* FindClaimOfKind(
+    const jwt_internal::JwtPayload& payload, absl::string_view name,
+    jwt_internal::JsonKind kind) {
   if (IsRegisteredClaimName(name)) {
-    return false;
+    return nullptr;
+  }
+  const jwt_internal::JsonClaim* claim = payload.Find(name);
+  if (claim == nullptr || claim->kind != kind) {
+    return nullptr;
   }
-  auto fields = json_proto.fields();
-  auto it = fields.find(std::string(name));
-  if (it == fields.end()) {
-    return false;
+  return claim;
+}
+
+// Returns the custom claim 'name', which must be of the given kind.
+util::StatusOr<const jwt_internal::JsonClaim*> GetClaimOfKind(
+    const jwt_internal::JwtPayload& payload, absl::string_view name,
+    jwt_internal::JsonKind kind, absl::string_view kind_name) {
+  auto status = ValidatePayloadName(name);
+  if (!status.ok()) {
+    return status;
+  }
+  const jwt_internal::JsonClaim* claim = payload.Find(name);
+  if (claim == nullptr) {
+    return util::Status(util::error::NOT_FOUND,
+                        absl::Substitute("claim '$0' not found", name));
+  }
+  if (claim->kind != kind) {
+    return util::Status(
+        util::error::INVALID_ARGUMENT,
+        absl::Substitute("claim '$0' is not a $1", name, kind_name));
   }
-  const auto& value = it->second;
-  return value.kind_case() == kind;
+  return claim;
+}
+
+// Returns the registered string claim 'name', called 'label' in errors.
+util::StatusOr<std::string> GetRegisteredString(
+    const jwt_internal::JwtPayload& payload, absl::string_view name,
+    absl::string_view label, util::error::Code not_found_code) {
+  const jwt_internal::JsonClaim* claim = payload.Find(name);
+  if (claim == nullptr) {
+    return util::Status(not_found_code, absl::StrCat("No ", label, " found"));
+  }
+  if (claim->kind != jwt_internal::JsonKind::kString) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        absl::StrCat(label, " is not a string"));
+  }
+  return payload.GetString(*claim);
+}
+
+// Returns the registered timestamp claim 'name', called 'label' in errors.
+util::StatusOr<absl::Time> GetRegisteredTime(
+    const jwt_internal::JwtPayload& payload, absl::string_view name,
+    absl::string_view label) {
+  const jwt_internal::JsonClaim* claim = payload.Find(name);
+  if (claim == nullptr) {
+    return util::Status(util::error::NOT_FOUND,
+                        absl::StrCat("No ", label, " found"));
+  }
+  if (claim->kind != jwt_internal::JsonKind::kNumber) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        absl::StrCat(label, " is not a number"));
+  }
+  double sec = claim->number_value;
+  return absl::FromUnixSeconds(sec);
 }
 
 }  // namespace
 
 util::StatusOr<RawJwt> RawJwt::FromString(absl::string_view json_string) {
-  auto proto_or = jwt_internal::JsonStringToProtoStruct(json_string);
-  if (!proto_or.ok()) {
-    return proto_or.status();
+  auto payload_or = jwt_internal::JwtPayload::Parse(std::string(json_string));
+  if (!payload_or.ok()) {
+    return payload_or.status();
   }
-  RawJwt token(proto_or.ValueOrDie());
+  RawJwt token(std::move(payload_or.ValueOrDie()));
   return token;
 }
 
 util::StatusOr<std::string> RawJwt::ToString() const {
-  return jwt_internal::ProtoStructToJsonString(json_proto_);
+  return payload_.json();
 }
 
 RawJwt::RawJwt() {}
 
-RawJwt::RawJwt(google::protobuf::Struct json_proto) {
-  json_proto_ = json_proto;
-}
+RawJwt::RawJwt(jwt_internal::JwtPayload payload)
+    : payload_(std::move(payload)) {}
 
 bool RawJwt::HasIssuer() const {
-  return json_proto_.fields().contains(std::string(kJwtClaimIssuer));
+  return payload_.Find(kJwtClaimIssuer) != nullptr;
 }
 
 util::StatusOr<std::string> RawJwt::GetIssuer() const {
-  auto fields = json_proto_.fields();
-  auto it = fields.find(std::string(kJwtClaimIssuer));
-  if (it == fields.end()) {
-    return util::Status(util::error::INVALID_ARGUMENT, "No Issuer found");
-  }
-  const auto& value = it->second;
-  if (value.kind_case() != google::protobuf::Value::kStringValue) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                        "Issuer is not a string");
-  }
-  return value.string_value();
+  return GetRegisteredString(payload_, kJwtClaimIssuer, "Issuer",
+                             util::error::INVALID_ARGUMENT);
 }
 
 bool RawJwt::HasSubject() const {
-  return json_proto_.fields().contains(std::string(kJwtClaimSubject));
+  return payload_.Find(kJwtClaimSubject) != nullptr;
 }
 
 util::StatusOr<std::string> RawJwt::GetSubject() const {
-  auto fields = json_proto_.fields();
-  auto it = fields.find(std::string(kJwtClaimSubject));
-  if (it == fields.end()) {
-    return util::Status(util::error::INVALID_ARGUMENT, "No Subject found");
-  }
-  const auto& value = it->second;
-  if (value.kind_case() != google::protobuf::Value::kStringValue) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                        "Subject is not a string");
-  }
-  return value.string_value();
+  return GetRegisteredString(payload_, kJwtClaimSubject, "Subject",
+                             util::error::INVALID_ARGUMENT);
 }
 
 bool RawJwt::HasAudiences() const {
-  return json_proto_.fields().contains(std::string(kJwtClaimAudience));
+  return payload_.Find(kJwtClaimAudience) != nullptr;
 }
 
 util::StatusOr<std::vector<std::string>> RawJwt::GetAudiences() const {
-  auto fields = json_proto_.fields();
-  auto it = fields.find(std::string(kJwtClaimAudience));
-  if (it == fields.end()) {
+  const jwt_internal::JsonClaim* claim = payload_.Find(kJwtClaimAudience);
+  if (claim == nullptr) {
     return util::Status(util::error::NOT_FOUND, "No Audiences found");
   }
-  auto list = it->second;
-  if (list.kind_case() != google::protobuf::Value::kListValue) {
+  if (claim->kind != jwt_internal::JsonKind::kArray) {
     return util::Status(util::error::INVALID_ARGUMENT,
                         "Audiences is not a list");
   }
-  std::vector<std::string> audiences;
-  for (const auto& value : list.list_value().values()) {
-    if (value.kind_case() != google::protobuf::Value::kStringValue) {
-      return util::Status(
-          util::error::INVALID_ARGUMENT,
-          "Audiences is not a list of strings");
-    }
-    audiences.push_back(value.string_value());
+  auto audiences_or = payload_.GetStringArray(*claim);
+  if (!audiences_or.ok()) {
+    return util::Status(
+        util::error::INVALID_ARGUMENT,
+        "Audiences is not a list of strings");
   }
-  return audiences;
+  return audiences_or;
 }
 
 
 bool RawJwt::HasJwtId() const {
-  return json_proto_.fields().contains(std::string(kJwtClaimJwtId));
+  return payload_.Find(kJwtClaimJwtId) != nullptr;
 }
 
 util::StatusOr<std::string> RawJwt::GetJwtId() const {
-  auto fields = json_proto_.fields();
-  auto it = fields.find(std::string(kJwtClaimJwtId));
-  if (it == fields.end()) {
-    return util::Status(util::error::NOT_FOUND, "No JwtId found");
-  }
-  const auto& value = it->second;
-  if (value.kind_case() != google::protobuf::Value::kStringValue) {
-    return util::Status(util::error::INVALID_ARGUMENT, "JwtId is not a string");
-  }
-  return value.string_value();
+  return GetRegisteredString(payload_, kJwtClaimJwtId, "JwtId",
+                             util::error::NOT_FOUND);
 }
 
 bool RawJwt::HasExpiration() const {
-  return json_proto_.fields().contains(std::string(kJwtClaimExpiration));
+  return payload_.Find(kJwtClaimExpiration) != nullptr;
 }
 
 util::StatusOr<absl::Time> RawJwt::GetExpiration() const {
-  auto fields = json_proto_.fields();
-  auto it = fields.find(std::string(kJwtClaimExpiration));
-  if (it == fields.end()) {
-    return util::Status(util::error::NOT_FOUND, "No Expiration found");
-  }
-  const auto& value = it->second;
-  if (value.kind_case() != google::protobuf::Value::kNumberValue) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                        "Expiration is not a number");
-  }
-  double sec = value.number_value();
-  return absl::FromUnixSeconds(sec);
+  return GetRegisteredTime(payload_, kJwtClaimExpiration, "Expiration");
 }
 
 bool RawJwt::HasNotBefore() const {
-  return json_proto_.fields().contains(std::string(kJwtClaimNotBefore));
+  return payload_.Find(kJwtClaimNotBefore) != nullptr;
 }
 
 util::StatusOr<absl::Time> RawJwt::GetNotBefore() const {
-  auto fields = json_proto_.fields();
-  auto it = fields.find(std::string(kJwtClaimNotBefore));
-  if (it == fields.end()) {
-    return util::Status(util::error::NOT_FOUND, "No NotBefore found");
-  }
-  const auto& value = it->second;
-  if (value.kind_case() != google::protobuf::Value::kNumberValue) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                        "NotBefore is not a number");
-  }
-  double sec = value.number_value();
-  return absl::FromUnixSeconds(sec);
+  return GetRegisteredTime(payload_, kJwtClaimNotBefore, "NotBefore");
 }
 
 bool RawJwt::HasIssuedAt() const {
-  return json_proto_.fields().contains(std::string(kJwtClaimIssuedAt));
+  return payload_.Find(kJwtClaimIssuedAt) != nullptr;
 }
 
 util::StatusOr<absl::Time> RawJwt::GetIssuedAt() const {
-  auto fields = json_proto_.fields();
-  auto it = fields.find(std::string(kJwtClaimIssuedAt));
-  if (it == fields.end()) {
-    return util::Status(util::error::NOT_FOUND, "No IssuedAt found");
-  }
-  const auto& value = it->second;
-  if (value.kind_case() != google::protobuf::Value::kNumberValue) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                        "IssuedAt is not a number");
-  }
-  double sec = value.number_value();
-  return absl::FromUnixSeconds(sec);
+  return GetRegisteredTime(payload_, kJwtClaimIssuedAt, "IssuedAt");
 }
 
 bool RawJwt::IsNullClaim(absl::string_view name) const {
-  return hasClaimOfKind(json_proto_, name, google::protobuf::Value::kNullValue);
+  return FindClaimOfKind(payload_, name, jwt_internal::JsonKind::kNull) !=
+         nullptr;
 }
 
 bool RawJwt::HasBooleanClaim(absl::string_view name) const {
-  return hasClaimOfKind(json_proto_, name, google::protobuf::Value::kBoolValue);
+  return FindClaimOfKind(payload_, name, jwt_internal::JsonKind::kBool) !=
+         nullptr;
 }
 
 util::StatusOr<bool> RawJwt::GetBooleanClaim(
     absl::string_view name) const {
-  auto status = ValidatePayloadName(name);
-  if (!status.ok()) {
-    return status;
+  auto claim_or =
+      GetClaimOfKind(payload_, name, jwt_internal::JsonKind::kBool, "bool");
+  if (!claim_or.ok()) {
+    return claim_or.status();
   }
-  auto fields = json_proto_.fields();
-  auto it = fields.find(std::string(name));
-  if (it == fields.end()) {
-    return util::Status(util::error::NOT_FOUND,
-                        absl::Substitute("claim '$0' not found", name));
-  }
-  const auto& value = it->second;
-  if (value.kind_case() != google::protobuf::Value::kBoolValue) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                        absl::Substitute("claim '$0' is not a bool", name));
-  }
-  return value.bool_value();
+  return claim_or.ValueOrDie()->bool_value;
 }
 
 bool RawJwt::HasStringClaim(absl::string_view name) const {
-  return hasClaimOfKind(json_proto_, name,
-                        google::protobuf::Value::kStringValue);
+  return FindClaimOfKind(payload_, name, jwt_internal::JsonKind::kString) !=
+         nullptr;
 }
 
 util::StatusOr<std::string> RawJwt::GetStringClaim(
     absl::string_view name) const {
-  auto status = ValidatePayloadName(name);
-  if (!status.ok()) {
-    return status;
+  auto claim_or = GetClaimOfKind(payload_, name,
+                                 jwt_internal::JsonKind::kString, "string");
+  if (!claim_or.ok()) {
+    return claim_or.status();
   }
-  auto fields = json_proto_.fields();
-  auto it = fields.find(std::string(name));
-  if (it == fields.end()) {
-    return util::Status(util::error::NOT_FOUND,
-                        absl::Substitute("claim '$0' not found", name));
-  }
-  const auto& value = it->second;
-  if (value.kind_case() != google::protobuf::Value::kStringValue) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                        absl::Substitute("claim '$0' is not a string", name));
-  }
-  return value.string_value();
+  return payload_.GetString(*claim_or.ValueOrDie());
 }
 
 bool RawJwt::HasNumberClaim(absl::string_view name) const {
-  return hasClaimOfKind(json_proto_, name,
-                        google::protobuf::Value::kNumberValue);
+  return FindClaimOfKind(payload_, name, jwt_internal::JsonKind::kNumber) !=
+         nullptr;
 }
 
 util::StatusOr<double> RawJwt::GetNumberClaim(absl::string_view name) const {
-  auto status = ValidatePayloadName(name);
-  if (!status.ok()) {
-    return status;
-  }
-  auto fields = json_proto_.fields();
-  auto it = fields.find(std::string(name));
-  if (it == fields.end()) {
-    return util::Status(util::error::NOT_FOUND,
-                        absl::Substitute("claim '$0' not found", name));
+  auto claim_or = GetClaimOfKind(payload_, name,
+                                 jwt_internal::JsonKind::kNumber, "number");
+  if (!claim_or.ok()) {
+    return claim_or.status();
   }
-  const auto& value = it->second;
-  if (value.kind_case() != google::protobuf::Value::kNumberValue) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                        absl::Substitute("claim '$0' is not a number", name));
-  }
-  return value.number_value();
+  return claim_or.ValueOrDie()->number_value;
 }
 
 bool RawJwt::HasJsonObjectClaim(absl::string_view name) const {
-  return hasClaimOfKind(json_proto_, name,
-                        google::protobuf::Value::kStructValue);
+  return FindClaimOfKind(payload_, name, jwt_internal::JsonKind::kObject) !=
+         nullptr;
 }
 
 util::StatusOr<std::string> RawJwt::GetJsonObjectClaim(
     absl::string_view name) const {
-  auto status = ValidatePayloadName(name);
-  if (!status.ok()) {
-    return status;
-  }
-  auto fields = json_proto_.fields();
-  auto it = fields.find(std::string(name));
-  if (it == fields.end()) {
-    return util::Status(util::error::NOT_FOUND,
-                        absl::Substitute("claim '$0' not found", name));
-  }
-  const auto& value = it->second;
-  if (value.kind_case() != google::protobuf::Value::kStructValue) {
-    return util::Status(
-        util::error::INVALID_ARGUMENT,
-        absl::Substitute("claim '$0' is not a JSON object", name));
+  auto claim_or = GetClaimOfKind(
+      payload_, name, jwt_internal::JsonKind::kObject, "JSON object");
+  if (!claim_or.ok()) {
+    return claim_or.status();
+  }
+  // Nested objects are only converted when requested.
+  auto proto_or = jwt_internal::JsonStringToProtoStruct(
+      payload_.Value(*claim_or.ValueOrDie()));
+  if (!proto_or.ok()) {
+    return proto_or.status();
   }
-  return jwt_internal::ProtoStructToJsonString(value.struct_value());
+  return jwt_internal::ProtoStructToJsonString(proto_or.ValueOrDie());
 }
 
 bool RawJwt::HasJsonArrayClaim(absl::string_view name) const {
-  return hasClaimOfKind(json_proto_, name,
-                        google::protobuf::Value::kListValue);
+  return FindClaimOfKind(payload_, name, jwt_internal::JsonKind::kArray) !=
+         nullptr;
 }
 
 util::StatusOr<std::string> RawJwt::GetJsonArrayClaim(
     absl::string_view name) const {
-  auto status = ValidatePayloadName(name);
-  if (!status.ok()) {
-    return status;
-  }
-  auto fields = json_proto_.fields();
-  auto it = fields.find(std::string(name));
-  if (it == fields.end()) {
-    return util::Status(util::error::NOT_FOUND,
-                        absl::Substitute("claim '$0' not found", name));
+  auto claim_or = GetClaimOfKind(
+      payload_, name, jwt_internal::JsonKind::kArray, "JSON array");
+  if (!claim_or.ok()) {
+    return claim_or.status();
   }
-  const auto& value = it->second;
-  if (value.kind_case() != google::protobuf::Value::kListValue) {
-    return util::Status(
-        util::error::INVALID_ARGUMENT,
-        absl::Substitute("claim '$0' is not a JSON array", name));
+  auto list_or = jwt_internal::JsonStringToProtoList(
+      payload_.Value(*claim_or.ValueOrDie()));
+  if (!list_or.ok()) {
+    return list_or.status();
   }
-  return jwt_internal::ProtoListToJsonString(value.list_value());
+  return jwt_internal::ProtoListToJsonString(list_or.ValueOrDie());
 }
 
 std::vector<std::string> RawJwt::CustomClaimNames() const {
-  auto fields = json_proto_.fields();
   std::vector<std::string> values;
-  for (auto it = fields.begin(); it != fields.end(); it++) {
-    if (!IsRegisteredClaimName(it->first)) {
-      values.push_back(it->first);
+  for (const jwt_internal::JsonClaim& claim : payload_.claims()) {
+    if (!IsRegisteredClaimName(claim.name)) {
+      values.push_back(claim.name);
     }
   }
   return values;
@@ -512,8 +465,11 @@ util::Status RawJwtBuilder::AddJsonArrayClaim(absl::string_view name,
 }
 
 util::StatusOr<RawJwt> RawJwtBuilder::Build() {
-  RawJwt token(json_proto_);
-  return token;
+  auto json_or = jwt_internal::ProtoStructToJsonString(json_proto_);
+  if (!json_or.ok()) {
+    return json_or.status();
+  }
+  return RawJwt::FromString(json_or.ValueOrDie());
 }
 
 }  // namespace tink
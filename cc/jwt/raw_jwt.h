@@ -21,6 +21,7 @@
 #include "absl/strings/string_view.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
+#include "tink/jwt/internal/jwt_payload.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
@@ -73,9 +74,10 @@ class RawJwt {
   RawJwt& operator=(RawJwt&& other) = default;
 
  private:
-  explicit RawJwt(google::protobuf::Struct json_proto);
-  friend class RawJwtBuilder;
-  google::protobuf::Struct json_proto_;
+  explicit RawJwt(jwt_internal::JwtPayload payload);
+  // JwtValidator compares claims in place, see JwtValidator::Validate().
+  friend class JwtValidator;
+  jwt_internal::JwtPayload payload_;
 };
 
 class RawJwtBuilder {
@@ -0,0 +1,110 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_KEY_USAGE_COUNTER_H_
+#define TINK_KEY_USAGE_COUNTER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/input_stream.h"
+#include "tink/util/status.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+///////////////////////////////////////////////////////////////////////////////
+// Counts ciphertexts, signatures and tags by the key that produced them, as
+// given by their output prefix (see CryptoFormat), without decrypting or
+// verifying them. E.g. counting the ciphertexts of a data set shows whether
+// an old key of a keyset is still needed before disabling it.
+//
+// The prefix of LEGACY and CRUNCHY keys is the same, so both are counted as
+// LEGACY. Outputs that do not start with a TINK or LEGACY prefix, or are
+// shorter than one, are counted as RAW. A RAW output may start with bytes
+// that look like a prefix, so the counts of keysets with RAW keys are only
+// estimates. The ciphertexts of StreamingAead have no output prefix.
+//
+// Not thread-safe; to count in parallel, use a counter per thread and
+// Merge() them.
+class KeyUsageCounter {
+ public:
+  // The number of outputs of a key.
+  struct KeyCount {
+    // TINK, LEGACY or RAW.
+    google::crypto::tink::OutputPrefixType output_prefix_type;
+    // 0 for RAW.
+    uint32_t key_id;
+    int64_t count;
+  };
+
+  KeyUsageCounter() : total_(0) {}
+
+  // Counts 'output'.
+  void Add(absl::string_view output) { AddCount(GetKey(output), 1); }
+
+  // Counts each of 'outputs'.
+  void AddBatch(absl::Span<const absl::string_view> outputs);
+
+  // Counts the outputs stored back to back in 'outputs', where output i
+  // occupies the bytes [offsets[i], offsets[i + 1]), as produced by
+  // Aead::EncryptBatch().
+  void AddBatch(absl::string_view outputs, absl::Span<const int64_t> offsets);
+
+  // Counts the output read from 'input_stream', whose prefix is read from the
+  // current position. Returns an error if the stream fails; a stream that
+  // ends before a whole prefix is counted as RAW.
+  crypto::tink::util::Status AddFromStream(InputStream* input_stream);
+
+  // Adds the counts of 'other'.
+  void Merge(const KeyUsageCounter& other);
+
+  // Returns the number of outputs of the key described by 'key_info'. For
+  // RAW keys, this is the number of all RAW outputs.
+  int64_t GetCount(
+      const google::crypto::tink::KeysetInfo::KeyInfo& key_info) const;
+
+  // Returns the counts of all keys with outputs, sorted by output prefix
+  // type and key id.
+  std::vector<KeyCount> GetCounts() const;
+
+  // Returns the number of outputs counted.
+  int64_t total() const { return total_; }
+
+ private:
+  // The start byte of the prefix in bits 32 to 39 followed by the key id, or
+  // kRawKey.
+  static constexpr uint64_t kRawKey = uint64_t{1} << 40;
+
+  static uint64_t GetKey(absl::string_view output);
+
+  void AddCount(uint64_t key, int64_t count) {
+    counts_[key] += count;
+    total_ += count;
+  }
+
+  absl::flat_hash_map<uint64_t, int64_t> counts_;
+  int64_t total_;
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_KEY_USAGE_COUNTER_H_
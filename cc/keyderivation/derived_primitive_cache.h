@@ -0,0 +1,125 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_KEYDERIVATION_DERIVED_PRIMITIVE_CACHE_H_
+#define TINK_KEYDERIVATION_DERIVED_PRIMITIVE_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "tink/keyderivation/key_deriver.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+// Keeps the primitives derived by a KeyDeriver for the most recently used
+// salts, so that e.g. the primitive of an active tenant is derived only
+// once. When the cache holds 'capacity' primitives, the least recently used
+// one is evicted; callers that still hold it keep it alive.
+//
+// P is the primitive of the derived key template, e.g. Aead.
+// Instances of this class are thread safe.
+template <class P>
+class DerivedPrimitiveCache {
+ public:
+  // 'capacity' must be positive.
+  static crypto::tink::util::StatusOr<std::unique_ptr<DerivedPrimitiveCache>>
+  New(std::unique_ptr<KeyDeriver> deriver, int capacity) {
+    if (deriver == nullptr) {
+      return crypto::tink::util::Status(
+          crypto::tink::util::error::INVALID_ARGUMENT,
+          "deriver must be non-null");
+    }
+    if (capacity <= 0) {
+      return crypto::tink::util::Status(
+          crypto::tink::util::error::INVALID_ARGUMENT,
+          "capacity must be positive");
+    }
+    return {std::unique_ptr<DerivedPrimitiveCache>(
+        new DerivedPrimitiveCache(std::move(deriver), capacity))};
+  }
+
+  // Returns the primitive derived for 'salt', deriving it if it is not
+  // cached.
+  crypto::tink::util::StatusOr<std::shared_ptr<P>> Get(absl::string_view salt)
+      ABSL_LOCKS_EXCLUDED(mu_) {
+    {
+      absl::MutexLock lock(&mu_);
+      auto it = index_.find(salt);
+      if (it != index_.end()) {
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->primitive;
+      }
+    }
+    // Derive without holding the lock, so that primitives of other salts can
+    // be looked up meanwhile. If another thread derives the same primitive
+    // concurrently, the one cached first is kept.
+    auto primitive_result = deriver_->template DerivePrimitive<P>(salt);
+    if (!primitive_result.ok()) return primitive_result.status();
+    std::shared_ptr<P> primitive = std::move(primitive_result.ValueOrDie());
+
+    absl::MutexLock lock(&mu_);
+    auto it = index_.find(salt);
+    if (it != index_.end()) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return it->second->primitive;
+    }
+    lru_.push_front(Entry{std::string(salt), primitive});
+    // The key points into the list node, which does not move.
+    index_.emplace(lru_.front().salt, lru_.begin());
+    if (lru_.size() > static_cast<size_t>(capacity_)) {
+      index_.erase(lru_.back().salt);
+      lru_.pop_back();
+    }
+    return primitive;
+  }
+
+  // Returns the number of cached primitives.
+  int size() const ABSL_LOCKS_EXCLUDED(mu_) {
+    absl::MutexLock lock(&mu_);
+    return lru_.size();
+  }
+
+ private:
+  struct Entry {
+    std::string salt;
+    std::shared_ptr<P> primitive;
+  };
+
+  DerivedPrimitiveCache(std::unique_ptr<KeyDeriver> deriver, int capacity)
+      : deriver_(std::move(deriver)), capacity_(capacity) {}
+
+  const std::unique_ptr<KeyDeriver> deriver_;
+  const int capacity_;
+  mutable absl::Mutex mu_;
+  // The cached primitives, the most recently used first.
+  std::list<Entry> lru_ ABSL_GUARDED_BY(mu_);
+  absl::flat_hash_map<absl::string_view, typename std::list<Entry>::iterator>
+      index_ ABSL_GUARDED_BY(mu_);
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_KEYDERIVATION_DERIVED_PRIMITIVE_CACHE_H_
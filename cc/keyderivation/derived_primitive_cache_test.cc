@@ -0,0 +1,132 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/keyderivation/derived_primitive_cache.h"
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_config.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/keyderivation/key_deriver.h"
+#include "tink/keyset_handle.h"
+#include "tink/prf/prf_config.h"
+#include "tink/prf/prf_key_templates.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+class DerivedPrimitiveCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_THAT(AeadConfig::Register(), IsOk());
+    ASSERT_THAT(PrfConfig::Register(), IsOk());
+    prf_keyset_ =
+        KeysetHandle::GenerateNew(PrfKeyTemplates::HkdfSha256()).ValueOrDie();
+  }
+
+  std::unique_ptr<KeyDeriver> NewDeriver() {
+    return KeyDeriver::New(*prf_keyset_, AeadKeyTemplates::Aes128Gcm())
+        .ValueOrDie();
+  }
+
+  std::unique_ptr<DerivedPrimitiveCache<Aead>> NewCache(int capacity) {
+    return DerivedPrimitiveCache<Aead>::New(NewDeriver(), capacity)
+        .ValueOrDie();
+  }
+
+  std::unique_ptr<KeysetHandle> prf_keyset_;
+};
+
+TEST_F(DerivedPrimitiveCacheTest, InvalidArguments) {
+  EXPECT_THAT(DerivedPrimitiveCache<Aead>::New(nullptr, 10).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(DerivedPrimitiveCache<Aead>::New(NewDeriver(), 0).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(DerivedPrimitiveCacheTest, ReturnsCachedPrimitive) {
+  std::unique_ptr<DerivedPrimitiveCache<Aead>> cache = NewCache(10);
+  std::shared_ptr<Aead> aead = cache->Get("tenant 1").ValueOrDie();
+  EXPECT_EQ(cache->Get("tenant 1").ValueOrDie(), aead);
+  EXPECT_NE(cache->Get("tenant 2").ValueOrDie(), aead);
+  EXPECT_EQ(cache->size(), 2);
+
+  // The cached primitive is the derived one.
+  std::string ciphertext = aead->Encrypt("plaintext", "aad").ValueOrDie();
+  auto decrypt_result = NewDeriver()
+                            ->DerivePrimitive<Aead>("tenant 1")
+                            .ValueOrDie()
+                            ->Decrypt(ciphertext, "aad");
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ(decrypt_result.ValueOrDie(), "plaintext");
+}
+
+TEST_F(DerivedPrimitiveCacheTest, EvictsLeastRecentlyUsed) {
+  std::unique_ptr<DerivedPrimitiveCache<Aead>> cache = NewCache(2);
+  std::shared_ptr<Aead> aead_1 = cache->Get("tenant 1").ValueOrDie();
+  std::shared_ptr<Aead> aead_2 = cache->Get("tenant 2").ValueOrDie();
+  // Makes tenant 2 the least recently used one.
+  EXPECT_EQ(cache->Get("tenant 1").ValueOrDie(), aead_1);
+  std::shared_ptr<Aead> aead_3 = cache->Get("tenant 3").ValueOrDie();
+  EXPECT_EQ(cache->size(), 2);
+
+  EXPECT_EQ(cache->Get("tenant 1").ValueOrDie(), aead_1);
+  EXPECT_EQ(cache->Get("tenant 3").ValueOrDie(), aead_3);
+  // Tenant 2 was evicted, and its primitive is derived again.
+  std::shared_ptr<Aead> new_aead_2 = cache->Get("tenant 2").ValueOrDie();
+  EXPECT_NE(new_aead_2, aead_2);
+  std::string ciphertext = aead_2->Encrypt("plaintext", "aad").ValueOrDie();
+  EXPECT_THAT(new_aead_2->Decrypt(ciphertext, "aad").status(), IsOk());
+  EXPECT_EQ(cache->size(), 2);
+}
+
+TEST_F(DerivedPrimitiveCacheTest, ConcurrentGet) {
+  std::unique_ptr<DerivedPrimitiveCache<Aead>> cache = NewCache(8);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&cache, t]() {
+      for (int i = 0; i < 100; i++) {
+        std::string salt = absl::StrCat("tenant ", (i * 7 + t) % 16);
+        auto aead_result = cache->Get(salt);
+        ASSERT_THAT(aead_result.status(), IsOk());
+        std::string ciphertext =
+            aead_result.ValueOrDie()->Encrypt("plaintext", salt).ValueOrDie();
+        EXPECT_THAT(cache->Get(salt).ValueOrDie()->Decrypt(ciphertext, salt)
+                        .status(),
+                    IsOk());
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_LE(cache->size(), 8);
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
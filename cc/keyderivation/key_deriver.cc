@@ -0,0 +1,68 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/keyderivation/key_deriver.h"
+
+#include <memory>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "tink/input_stream.h"
+#include "tink/internal/registry_impl.h"
+#include "tink/keyset_handle.h"
+#include "tink/subtle/prf/streaming_prf.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+using google::crypto::tink::KeyData;
+using google::crypto::tink::KeyTemplate;
+
+util::StatusOr<std::unique_ptr<KeyDeriver>> KeyDeriver::New(
+    std::unique_ptr<StreamingPrf> prf,
+    const KeyTemplate& derived_key_template) {
+  if (prf == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT, "prf must be non-null");
+  }
+  std::unique_ptr<KeyDeriver> deriver(
+      new KeyDeriver(std::move(prf), derived_key_template));
+  // Derive a key once, so that templates whose key manager is missing or
+  // cannot derive keys are rejected here and not on first use.
+  auto key_data_result = deriver->DeriveKeyData("");
+  if (!key_data_result.ok()) return key_data_result.status();
+  return std::move(deriver);
+}
+
+util::StatusOr<std::unique_ptr<KeyDeriver>> KeyDeriver::New(
+    const KeysetHandle& prf_keyset_handle,
+    const KeyTemplate& derived_key_template) {
+  auto prf_result = prf_keyset_handle.GetPrimitive<StreamingPrf>();
+  if (!prf_result.ok()) return prf_result.status();
+  return New(std::move(prf_result.ValueOrDie()), derived_key_template);
+}
+
+util::StatusOr<KeyData> KeyDeriver::DeriveKeyData(
+    absl::string_view salt) const {
+  std::unique_ptr<InputStream> randomness = prf_->ComputePrf(salt);
+  return internal::RegistryImpl::GlobalInstance().DeriveKey(
+      derived_key_template_, randomness.get());
+}
+
+}  // namespace tink
+}  // namespace crypto
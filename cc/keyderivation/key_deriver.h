@@ -0,0 +1,86 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_KEYDERIVATION_KEY_DERIVER_H_
+#define TINK_KEYDERIVATION_KEY_DERIVER_H_
+
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "tink/keyset_handle.h"
+#include "tink/registry.h"
+#include "tink/subtle/prf/streaming_prf.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+// Derives keys of a fixed key template from a salt, using the pseudorandom
+// bytes a StreamingPrf computes for the salt as the randomness of the key.
+// This way a single PRF key replaces a set of keys that are each identified
+// by a salt, e.g. one key per tenant: the keys are derived on demand and
+// never stored.
+//
+// The same PRF key and salt always give the same key. Different key
+// templates must not be used with the same PRF key, as keys derived for the
+// same salt would share their key material. The output prefix type of the
+// template is ignored; derived primitives, see DerivePrimitive(), are single
+// key primitives without an output prefix.
+//
+// Instances of this class are thread safe.
+class KeyDeriver {
+ public:
+  // Returns a KeyDeriver that derives keys of 'derived_key_template' with
+  // 'prf'. The key manager of the template must be registered and support
+  // key derivation.
+  static crypto::tink::util::StatusOr<std::unique_ptr<KeyDeriver>> New(
+      std::unique_ptr<StreamingPrf> prf,
+      const google::crypto::tink::KeyTemplate& derived_key_template);
+
+  // Same as above, with the PRF of 'prf_keyset_handle', which must contain a
+  // single enabled RAW key of a StreamingPrf key type such as HKDF-PRF, see
+  // PrfKeyTemplates::HkdfSha256(). Requires PrfConfig to be registered.
+  static crypto::tink::util::StatusOr<std::unique_ptr<KeyDeriver>> New(
+      const KeysetHandle& prf_keyset_handle,
+      const google::crypto::tink::KeyTemplate& derived_key_template);
+
+  // Returns the key derived for 'salt'.
+  crypto::tink::util::StatusOr<google::crypto::tink::KeyData> DeriveKeyData(
+      absl::string_view salt) const;
+
+  // Returns the primitive of the key derived for 'salt'.
+  template <class P>
+  crypto::tink::util::StatusOr<std::unique_ptr<P>> DerivePrimitive(
+      absl::string_view salt) const {
+    auto key_data_result = DeriveKeyData(salt);
+    if (!key_data_result.ok()) return key_data_result.status();
+    return Registry::GetPrimitive<P>(key_data_result.ValueOrDie());
+  }
+
+ private:
+  KeyDeriver(std::unique_ptr<StreamingPrf> prf,
+             const google::crypto::tink::KeyTemplate& derived_key_template)
+      : prf_(std::move(prf)), derived_key_template_(derived_key_template) {}
+
+  const std::unique_ptr<StreamingPrf> prf_;
+  const google::crypto::tink::KeyTemplate derived_key_template_;
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_KEYDERIVATION_KEY_DERIVER_H_
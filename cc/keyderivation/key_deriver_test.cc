@@ -0,0 +1,151 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/keyderivation/key_deriver.h"
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "tink/aead.h"
+#include "tink/aead/aead_config.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/keyset_handle.h"
+#include "tink/prf/prf_config.h"
+#include "tink/prf/prf_key_templates.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::google::crypto::tink::KeyData;
+using ::google::crypto::tink::KeyTemplate;
+using ::testing::Not;
+
+class KeyDeriverTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_THAT(AeadConfig::Register(), IsOk());
+    ASSERT_THAT(PrfConfig::Register(), IsOk());
+  }
+
+  std::unique_ptr<KeysetHandle> NewPrfKeyset() {
+    return KeysetHandle::GenerateNew(PrfKeyTemplates::HkdfSha256())
+        .ValueOrDie();
+  }
+};
+
+TEST_F(KeyDeriverTest, SameSaltGivesSameKey) {
+  std::unique_ptr<KeysetHandle> prf_keyset = NewPrfKeyset();
+  auto deriver_result =
+      KeyDeriver::New(*prf_keyset, AeadKeyTemplates::Aes128Gcm());
+  ASSERT_THAT(deriver_result.status(), IsOk());
+  auto other_deriver_result =
+      KeyDeriver::New(*prf_keyset, AeadKeyTemplates::Aes128Gcm());
+  ASSERT_THAT(other_deriver_result.status(), IsOk());
+
+  auto key_data = deriver_result.ValueOrDie()->DeriveKeyData("tenant 1");
+  ASSERT_THAT(key_data.status(), IsOk());
+  auto same_key_data =
+      other_deriver_result.ValueOrDie()->DeriveKeyData("tenant 1");
+  ASSERT_THAT(same_key_data.status(), IsOk());
+  auto other_key_data =
+      deriver_result.ValueOrDie()->DeriveKeyData("tenant 2");
+  ASSERT_THAT(other_key_data.status(), IsOk());
+
+  EXPECT_EQ(key_data.ValueOrDie().type_url(),
+            AeadKeyTemplates::Aes128Gcm().type_url());
+  EXPECT_EQ(key_data.ValueOrDie().value(), same_key_data.ValueOrDie().value());
+  EXPECT_NE(key_data.ValueOrDie().value(),
+            other_key_data.ValueOrDie().value());
+}
+
+TEST_F(KeyDeriverTest, DifferentPrfKeysGiveDifferentKeys) {
+  auto deriver_result =
+      KeyDeriver::New(*NewPrfKeyset(), AeadKeyTemplates::Aes128Gcm());
+  ASSERT_THAT(deriver_result.status(), IsOk());
+  auto other_deriver_result =
+      KeyDeriver::New(*NewPrfKeyset(), AeadKeyTemplates::Aes128Gcm());
+  ASSERT_THAT(other_deriver_result.status(), IsOk());
+
+  EXPECT_NE(
+      deriver_result.ValueOrDie()->DeriveKeyData("tenant").ValueOrDie().value(),
+      other_deriver_result.ValueOrDie()
+          ->DeriveKeyData("tenant")
+          .ValueOrDie()
+          .value());
+}
+
+TEST_F(KeyDeriverTest, DerivePrimitive) {
+  std::unique_ptr<KeysetHandle> prf_keyset = NewPrfKeyset();
+  std::unique_ptr<KeyDeriver> deriver =
+      KeyDeriver::New(*prf_keyset, AeadKeyTemplates::Aes256Gcm())
+          .ValueOrDie();
+  std::unique_ptr<KeyDeriver> other_deriver =
+      KeyDeriver::New(*prf_keyset, AeadKeyTemplates::Aes256Gcm())
+          .ValueOrDie();
+
+  auto aead_result = deriver->DerivePrimitive<Aead>("tenant 1");
+  ASSERT_THAT(aead_result.status(), IsOk());
+  std::string ciphertext =
+      aead_result.ValueOrDie()->Encrypt("plaintext", "aad").ValueOrDie();
+
+  auto same_aead_result = other_deriver->DerivePrimitive<Aead>("tenant 1");
+  ASSERT_THAT(same_aead_result.status(), IsOk());
+  auto decrypt_result =
+      same_aead_result.ValueOrDie()->Decrypt(ciphertext, "aad");
+  ASSERT_THAT(decrypt_result.status(), IsOk());
+  EXPECT_EQ(decrypt_result.ValueOrDie(), "plaintext");
+
+  auto other_aead_result = deriver->DerivePrimitive<Aead>("tenant 2");
+  ASSERT_THAT(other_aead_result.status(), IsOk());
+  EXPECT_THAT(
+      other_aead_result.ValueOrDie()->Decrypt(ciphertext, "aad").status(),
+      Not(IsOk()));
+}
+
+TEST_F(KeyDeriverTest, NullPrf) {
+  EXPECT_THAT(KeyDeriver::New(std::unique_ptr<StreamingPrf>(),
+                              AeadKeyTemplates::Aes128Gcm())
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(KeyDeriverTest, UnknownKeyType) {
+  KeyTemplate key_template;
+  key_template.set_type_url("type.googleapis.com/some.UnknownKey");
+  EXPECT_THAT(KeyDeriver::New(*NewPrfKeyset(), key_template).status(),
+              Not(IsOk()));
+}
+
+TEST_F(KeyDeriverTest, PrfKeysetWithoutStreamingPrf) {
+  std::unique_ptr<KeysetHandle> hmac_prf_keyset =
+      KeysetHandle::GenerateNew(PrfKeyTemplates::HmacSha256()).ValueOrDie();
+  EXPECT_THAT(
+      KeyDeriver::New(*hmac_prf_keyset, AeadKeyTemplates::Aes128Gcm())
+          .status(),
+      Not(IsOk()));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
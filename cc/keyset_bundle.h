@@ -0,0 +1,86 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_KEYSET_BUNDLE_H_
+#define TINK_KEYSET_BUNDLE_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "tink/aead.h"
+#include "tink/keyset_handle.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+// A flat, versioned and checksummed binary format for keysets, meant for
+// services that must create their KeysetHandles quickly at start-up, e.g.
+// on a serverless cold start.
+//
+// A bundle is built ahead of time, e.g. at deployment, from a keyset that
+// Build() validates. Loading it then only checks a fixed-size header and a
+// SHA-256 checksum, optionally decrypts the payload, and parses the keyset;
+// it does not validate the keyset again. The payload starts at an 8-byte
+// aligned offset, so that LoadFile() can map the bundle instead of reading
+// it into a buffer.
+//
+// The layout is, with all integers in big-endian byte order:
+//   magic           8 bytes  "TINKBNDL"
+//   version         1 byte   kVersion
+//   flags           1 byte   bit 0 set if the payload is encrypted
+//   reserved        2 bytes  zero
+//   primary key id  4 bytes
+//   key count       4 bytes
+//   payload size    4 bytes
+//   checksum        32 bytes SHA-256 of all the above and the payload
+//   payload         the serialized Keyset, or its encryption with a key
+//                   encryption key (KEK) under the 24 bytes preceding the
+//                   checksum as associated data.
+//
+// The checksum detects corruption, not tampering: an unencrypted bundle holds
+// a cleartext keyset and must be protected like one, thus the usage of this
+// class without a KEK should be restricted like that of CleartextKeysetHandle.
+class KeysetBundle {
+ public:
+  static constexpr uint8_t kVersion = 1;
+
+  // Validates the keyset of |keyset_handle| and returns it as a bundle. If
+  // |kek| is not null, the keyset is encrypted with it.
+  static crypto::tink::util::StatusOr<std::string> Build(
+      const KeysetHandle& keyset_handle, const Aead* kek = nullptr);
+
+  // Creates a KeysetHandle from |bundle|. |kek| must be given exactly if the
+  // bundle is encrypted; FAILED_PRECONDITION is returned otherwise, so that
+  // an encrypted bundle cannot be replaced by an unencrypted one.
+  static crypto::tink::util::StatusOr<std::unique_ptr<KeysetHandle>> Load(
+      absl::string_view bundle, const Aead* kek = nullptr);
+
+  // Same as Load(), but reads the bundle from the file at |path|, which is
+  // mapped into memory where supported.
+  static crypto::tink::util::StatusOr<std::unique_ptr<KeysetHandle>> LoadFile(
+      const std::string& path, const Aead* kek = nullptr);
+
+ private:
+  KeysetBundle() {}
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_KEYSET_BUNDLE_H_
@@ -17,10 +17,19 @@
 #ifndef TINK_KEYSET_HANDLE_H_
 #define TINK_KEYSET_HANDLE_H_
 
+#include <memory>
+#include <string>
+#include <typeindex>
+#include <vector>
+
 #include "absl/base/attributes.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
 #include "tink/aead.h"
 #include "tink/internal/key_info.h"
 #include "tink/key_manager.h"
+#include "tink/keyset_read_cache.h"
 #include "tink/keyset_reader.h"
 #include "tink/keyset_writer.h"
 #include "tink/primitive_set.h"
@@ -40,6 +49,38 @@ class KeysetHandle {
   static crypto::tink::util::StatusOr<std::unique_ptr<KeysetHandle>> Read(
       std::unique_ptr<KeysetReader> reader, const Aead& master_key_aead);
 
+  // Like Read(), but takes the decrypted keyset from |cache| if the same
+  // encrypted keyset was read with it before and has not expired; only
+  // otherwise it is decrypted with |master_key_aead| and added to |cache|.
+  // |cache| must only be used with this master key, see KeysetReadCache.
+  static crypto::tink::util::StatusOr<std::unique_ptr<KeysetHandle>> Read(
+      std::unique_ptr<KeysetReader> reader, const Aead& master_key_aead,
+      KeysetReadCache* cache);
+
+  // For reloading a keyset that may have changed: reads the encrypted keyset
+  // from |reader| and returns nullptr, without decrypting or parsing it, if
+  // its KeysetReadCache::Digest() equals |*digest|. Otherwise behaves like
+  // Read() above, where |cache| may be null, and on success sets |*digest| to
+  // the digest of the new encrypted keyset. |digest| must be non-null; it is
+  // empty initially.
+  static crypto::tink::util::StatusOr<std::unique_ptr<KeysetHandle>>
+  ReadIfChanged(std::unique_ptr<KeysetReader> reader,
+                const Aead& master_key_aead, KeysetReadCache* cache,
+                std::string* digest);
+
+  // Creates KeysetHandles from the encrypted keysets obtained via |readers|,
+  // in the same order, using |master_key_aead| to decrypt them. This is
+  // cheaper than calling Read() for each keyset: all keysets are decrypted
+  // with a single DecryptBatch() call, and the decrypted keysets are parsed
+  // and validated on the calling thread and up to |num_threads| - 1 tasks on
+  // util::Executor::Global(). Unlike Read(), every keyset is validated, so
+  // that invalid keysets are found while loading them. Fails as a whole if any
+  // keyset cannot be read, decrypted or validated.
+  static crypto::tink::util::StatusOr<
+      std::vector<std::unique_ptr<KeysetHandle>>>
+  ReadMany(std::vector<std::unique_ptr<KeysetReader>> readers,
+           const Aead& master_key_aead, int num_threads = 1);
+
   // Creates a KeysetHandle from a keyset which contains no secret key material.
   // This can be used to load public keysets or envelope encryption keysets.
   static crypto::tink::util::StatusOr<std::unique_ptr<KeysetHandle>>
@@ -60,6 +101,12 @@ class KeysetHandle {
   // key material, thus can be used for logging or monitoring.
   google::crypto::tink::KeysetInfo GetKeysetInfo() const;
 
+  // Returns an estimate of the heap memory, in bytes, held by this handle and
+  // its keyset. Primitives obtained from the handle are not included, except
+  // for the bookkeeping of GetCachedPrimitive(); see also
+  // PrimitiveSet::EstimateMemoryUsage().
+  size_t EstimateMemoryUsage() const;
+
   // Writes the underlying keyset to |writer| only if the keyset does not
   // contain any secret key material.
   // This can be used to persist public keysets or envelope encryption keysets.
@@ -80,6 +127,35 @@ class KeysetHandle {
   template <class P>
   crypto::tink::util::StatusOr<std::unique_ptr<P>> GetPrimitive() const;
 
+  // Same as GetPrimitive(), but creates the primitives of the individual keys
+  // on up to 'num_threads' threads, which shortens the creation for keysets
+  // with many expensive keys (e.g. RSA). The primitives are added to the set
+  // in keyset order, so the primary and the returned error on failure are the
+  // same as for GetPrimitive(). 'num_threads' must be positive.
+  template <class P>
+  crypto::tink::util::StatusOr<std::unique_ptr<P>> GetPrimitiveInParallel(
+      int num_threads) const;
+
+  // Same as GetPrimitive(), but only creates the primitive of the primary key
+  // right away. The primitives of the other enabled keys are created when
+  // they are first needed (e.g. to decrypt a ciphertext of that key), which
+  // saves time and memory for keysets with many rarely used keys. Errors in
+  // non-primary keys are then only reported when those keys are used. Falls
+  // back to GetPrimitive() for primitives whose wrapper does not support
+  // this.
+  template <class P>
+  crypto::tink::util::StatusOr<std::unique_ptr<P>> GetLazyPrimitive() const;
+
+  // Returns a wrapped primitive corresponding to this keyset or fails with
+  // a non-ok status. The primitive is created as in GetPrimitive() on the
+  // first successful call for P; later calls on this handle or its copies
+  // return the same shared primitive without validating the keyset or
+  // constructing the primitives again. Errors are not cached. The cached
+  // primitive reflects the global registry as it was when it was created.
+  // This function is thread-safe.
+  template <class P>
+  crypto::tink::util::StatusOr<std::shared_ptr<P>> GetCachedPrimitive() const;
+
   // Creates a wrapped primitive corresponding to this keyset. Uses the given
   // KeyManager, as well as the KeyManager and PrimitiveWrapper objects in the
   // global registry to create the primitive. The given KeyManager is used for
@@ -94,6 +170,10 @@ class KeysetHandle {
   friend class CleartextKeysetHandle;
   friend class KeysetManager;
   friend class RegistryImpl;
+  template <class P>
+  friend class AtomicPrimitive;
+  template <class... KeyTypeManagers>
+  friend class StaticConfig;
 
   // TestKeysetHandle::GetKeyset() provides access to get_keyset().
   friend class TestKeysetHandle;
@@ -124,7 +204,16 @@ class KeysetHandle {
   crypto::tink::util::StatusOr<std::unique_ptr<PrimitiveSet<P>>> GetPrimitives(
       const KeyManager<P>* custom_manager) const;
 
+  // Primitives created by GetCachedPrimitive(), keyed by primitive type.
+  // Copies of a handle hold the same keyset and thus share the cache.
+  struct PrimitiveCache {
+    absl::Mutex mutex;
+    absl::flat_hash_map<std::type_index, std::shared_ptr<void>> primitives
+        ABSL_GUARDED_BY(mutex);
+  };
+
   google::crypto::tink::Keyset keyset_;
+  std::shared_ptr<PrimitiveCache> primitive_cache_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -168,6 +257,41 @@ crypto::tink::util::StatusOr<std::unique_ptr<P>> KeysetHandle::GetPrimitive()
   return internal::RegistryImpl::GlobalInstance().WrapKeyset<P>(keyset_);
 }
 
+template <class P>
+crypto::tink::util::StatusOr<std::unique_ptr<P>>
+KeysetHandle::GetPrimitiveInParallel(int num_threads) const {
+  return internal::RegistryImpl::GlobalInstance().WrapKeyset<P>(keyset_,
+                                                                num_threads);
+}
+
+template <class P>
+crypto::tink::util::StatusOr<std::unique_ptr<P>>
+KeysetHandle::GetLazyPrimitive() const {
+  return internal::RegistryImpl::GlobalInstance().WrapKeysetLazily<P>(keyset_);
+}
+
+template <class P>
+crypto::tink::util::StatusOr<std::shared_ptr<P>>
+KeysetHandle::GetCachedPrimitive() const {
+  const std::type_index type(typeid(P));
+  {
+    absl::MutexLock lock(&primitive_cache_->mutex);
+    auto it = primitive_cache_->primitives.find(type);
+    if (it != primitive_cache_->primitives.end()) {
+      return std::static_pointer_cast<P>(it->second);
+    }
+  }
+  // The primitive is created without holding the lock, so that a slow
+  // creation does not block other primitive types. If several threads race,
+  // the first primitive inserted is returned to all of them.
+  auto primitive_result = GetPrimitive<P>();
+  if (!primitive_result.ok()) return primitive_result.status();
+  std::shared_ptr<P> primitive = std::move(primitive_result.ValueOrDie());
+  absl::MutexLock lock(&primitive_cache_->mutex);
+  auto inserted = primitive_cache_->primitives.emplace(type, primitive);
+  return std::static_pointer_cast<P>(inserted.first->second);
+}
+
 template <class P>
 crypto::tink::util::StatusOr<std::unique_ptr<P>> KeysetHandle::GetPrimitive(
     const KeyManager<P>* custom_manager) const {
@@ -16,8 +16,15 @@
 #ifndef TINK_KEYSET_MANAGER_H_
 #define TINK_KEYSET_MANAGER_H_
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 #include "absl/base/thread_annotations.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "tink/aead.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "proto/tink.pb.h"
@@ -46,6 +53,45 @@ class KeysetManager {
   static crypto::tink::util::StatusOr<std::unique_ptr<KeysetManager>> New(
       const KeysetHandle& keyset_handle);
 
+  // The outcome of RotateMany(), with one element per keyset in each vector,
+  // in the order of the keysets.
+  struct BulkRotation {
+    // OK, or the reason why the keyset was not rotated.
+    std::vector<crypto::tink::util::Status> statuses;
+    // The rotated keysets, or nullptr for keysets that were not rotated.
+    std::vector<std::unique_ptr<KeysetHandle>> keyset_handles;
+    // The rotated keysets encrypted with the master key, as written by
+    // KeysetHandle::Write(); empty for keysets that were not rotated.
+    std::vector<google::crypto::tink::EncryptedKeyset> encrypted_keysets;
+    // The ids of the new primary keys, or 0 for keysets that were not rotated.
+    std::vector<uint32_t> key_ids;
+    int num_rotated = 0;
+    // The time RotateMany() took.
+    absl::Duration duration;
+
+    double keysets_per_second() const {
+      double seconds = absl::ToDoubleSeconds(duration);
+      return seconds > 0 ? num_rotated / seconds : 0;
+    }
+  };
+
+  // Rotates many keysets at once, as Rotate() does for one: adds a fresh key
+  // generated according to 'key_template' to a copy of each keyset and makes
+  // it the primary. The rotated keysets are then encrypted with
+  // 'master_key_aead', with one EncryptBatch() call per chunk of keysets.
+  // Keys are generated and chunks are encrypted on the calling thread and up
+  // to 'num_threads' - 1 tasks on util::Executor::Global(). Keys are taken
+  // from the key pool of 'key_template' while it has some, see
+  // Registry::SetKeyPool().
+  //
+  // A keyset that cannot be rotated or encrypted does not stop the others;
+  // its error is reported in the result. Fails as a whole only on invalid
+  // arguments.
+  static crypto::tink::util::StatusOr<BulkRotation> RotateMany(
+      absl::Span<const KeysetHandle* const> keyset_handles,
+      const google::crypto::tink::KeyTemplate& key_template,
+      const Aead& master_key_aead, int num_threads = 1);
+
   // Adds to the managed keyset a fresh key generated according to
   // 'keyset_template' and returns the key_id of the added key.
   // The added key has status 'ENABLED'.
@@ -0,0 +1,86 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_KEYSET_READ_CACHE_H_
+#define TINK_KEYSET_READ_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "tink/util/secret_data.h"
+
+namespace crypto {
+namespace tink {
+
+// A cache for the decrypted keysets of KeysetHandle::Read(), so that reading
+// the same encrypted keyset again does not call the master key Aead, which is
+// often a remote KMS.
+//
+// Entries are looked up by a SHA-256 hash of the ciphertext in the
+// EncryptedKeyset,
+// expire 'ttl' after they were added and are evicted in least recently used
+// order once 'capacity' entries are cached. The decrypted keysets are held
+// as util::SecretData and thus wiped when they are evicted. An entry does not
+// record which master key decrypted it, so a cache must only be used with a
+// single master key: reading a cached keyset does not require access to it.
+// This class is thread-safe.
+class KeysetReadCache {
+ public:
+  struct Options {
+    int capacity = 16;
+    absl::Duration ttl = absl::Minutes(10);
+  };
+
+  KeysetReadCache() : KeysetReadCache(Options()) {}
+  explicit KeysetReadCache(const Options& options) : options_(options) {}
+
+  // Returns the SHA-256 hash of 'encrypted_keyset', the ciphertext of an
+  // EncryptedKeyset, which identifies the keyset in this cache and in
+  // KeysetHandle::ReadIfChanged().
+  static std::string Digest(absl::string_view encrypted_keyset);
+
+  // Returns the serialized keyset cached for 'digest', or nullptr if there
+  // is none or it expired.
+  std::shared_ptr<const util::SecretData> Get(absl::string_view digest);
+
+  // Caches 'serialized_keyset' for 'digest'.
+  void Put(absl::string_view digest, util::SecretData serialized_keyset);
+
+ private:
+  struct Entry {
+    std::string digest;
+    absl::Time expiration;
+    std::shared_ptr<const util::SecretData> serialized_keyset;
+  };
+
+  const Options options_;
+  absl::Mutex mutex_;
+  // Most recently used first.
+  std::list<Entry> entries_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_KEYSET_READ_CACHE_H_
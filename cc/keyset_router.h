@@ -0,0 +1,237 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_KEYSET_ROUTER_H_
+#define TINK_KEYSET_ROUTER_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "tink/crypto_format.h"
+#include "tink/internal/key_prefix_index.h"
+#include "tink/keyset_handle.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+///////////////////////////////////////////////////////////////////////////////
+// Routes data produced with many keysets, e.g. the keysets of the tenants of
+// a multi-tenant service, to the primitive of the keyset that produced it,
+// without knowing that keyset in advance.
+//
+// Ciphertexts, signatures and tags of keys with a non-RAW output prefix start
+// with the 5-byte prefix of CryptoFormat, which contains the key id. The
+// router indexes the prefixes of the enabled keys of all its keysets in a
+// single table, so Find() takes constant time regardless of the number of
+// keysets. Keys with the RAW output prefix cannot be routed and are not
+// indexed. Key ids are chosen at random, so keys of different keysets may
+// share a prefix; Find() then returns all of those keysets.
+//
+// Adding and removing keysets is atomic: each change publishes a new
+// immutable table, built without blocking Find(), and each Find() uses either
+// the old or the new table. Find() only takes a shared lock to copy the
+// pointer to the current table. Since each change rebuilds the table, adding
+// N keysets one by one takes O(N^2) time.
+//
+// See AeadRouter and PublicKeyVerifyRouter for routers that decrypt or verify
+// with the keyset found.
+template <class P>
+class KeysetRouter {
+ public:
+  // A keyset added to the router.
+  struct Keyset {
+    std::string name;
+    std::shared_ptr<P> primitive;
+    // The output prefixes of the enabled non-RAW keys of the keyset.
+    std::vector<std::string> key_prefixes;
+  };
+
+ private:
+  struct Table {
+    // In the order they were added.
+    std::vector<std::shared_ptr<const Keyset>> keysets;
+    absl::flat_hash_map<std::string, std::vector<const Keyset*>> by_prefix;
+    internal::KeyPrefixIndex<std::vector<const Keyset*>> index;
+  };
+
+ public:
+  // The keysets found by Find(), in the order they were added. Keeps them
+  // alive even if they are removed from the router meanwhile.
+  class Route {
+   public:
+    using const_iterator = typename std::vector<const Keyset*>::const_iterator;
+
+    bool empty() const { return keysets().empty(); }
+    size_t size() const { return keysets().size(); }
+    const_iterator begin() const { return keysets().begin(); }
+    const_iterator end() const { return keysets().end(); }
+
+   private:
+    friend class KeysetRouter;
+
+    Route(std::shared_ptr<const Table> table,
+          const std::vector<const Keyset*>* keysets)
+        : table_(std::move(table)), keysets_(keysets) {}
+
+    const std::vector<const Keyset*>& keysets() const {
+      static const std::vector<const Keyset*>* const kNoKeysets =
+          new std::vector<const Keyset*>();
+      return keysets_ == nullptr ? *kNoKeysets : *keysets_;
+    }
+
+    std::shared_ptr<const Table> table_;
+    const std::vector<const Keyset*>* keysets_;
+  };
+
+  KeysetRouter() : table_(std::make_shared<Table>()) {}
+
+  KeysetRouter(const KeysetRouter&) = delete;
+  KeysetRouter& operator=(const KeysetRouter&) = delete;
+
+  // Adds the keyset of 'keyset_handle' as 'name', with the primitive
+  // keyset_handle.GetPrimitive<P>() returns. A keyset that was added as
+  // 'name' before is replaced.
+  crypto::tink::util::Status AddKeyset(absl::string_view name,
+                                       const KeysetHandle& keyset_handle) {
+    auto primitive_result = keyset_handle.GetPrimitive<P>();
+    if (!primitive_result.ok()) return primitive_result.status();
+    return AddKeyset(name, keyset_handle.GetKeysetInfo(),
+                     std::shared_ptr<P>(
+                         std::move(primitive_result.ValueOrDie())));
+  }
+
+  // Same as above, for an existing 'primitive' of the keyset described by
+  // 'keyset_info', which must be safe for concurrent use.
+  crypto::tink::util::Status AddKeyset(
+      absl::string_view name,
+      const google::crypto::tink::KeysetInfo& keyset_info,
+      std::shared_ptr<P> primitive) {
+    if (primitive == nullptr) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "primitive must be non-null");
+    }
+    auto keyset = std::make_shared<Keyset>();
+    keyset->name = std::string(name);
+    keyset->primitive = std::move(primitive);
+    for (const auto& key_info : keyset_info.key_info()) {
+      if (key_info.status() != google::crypto::tink::KeyStatusType::ENABLED) {
+        continue;
+      }
+      auto prefix_result = CryptoFormat::GetOutputPrefix(key_info);
+      if (!prefix_result.ok()) return prefix_result.status();
+      if (prefix_result.ValueOrDie().empty()) continue;
+      keyset->key_prefixes.push_back(std::move(prefix_result.ValueOrDie()));
+    }
+
+    absl::MutexLock lock(&update_mutex_);
+    std::vector<std::shared_ptr<const Keyset>> keysets = GetTable()->keysets;
+    bool replaced = false;
+    for (auto& existing : keysets) {
+      if (existing->name == name) {
+        existing = std::move(keyset);
+        replaced = true;
+        break;
+      }
+    }
+    if (!replaced) keysets.push_back(std::move(keyset));
+    Publish(std::move(keysets));
+    return util::OkStatus();
+  }
+
+  // Removes the keyset added as 'name'.
+  crypto::tink::util::Status RemoveKeyset(absl::string_view name) {
+    absl::MutexLock lock(&update_mutex_);
+    std::vector<std::shared_ptr<const Keyset>> keysets = GetTable()->keysets;
+    for (auto it = keysets.begin(); it != keysets.end(); ++it) {
+      if ((*it)->name == name) {
+        keysets.erase(it);
+        Publish(std::move(keysets));
+        return util::OkStatus();
+      }
+    }
+    return util::Status(util::error::NOT_FOUND,
+                        absl::StrCat("no keyset named ", name));
+  }
+
+  // Returns the number of keysets.
+  size_t size() const { return GetTable()->keysets.size(); }
+
+  // Returns the keysets with a key whose output prefix 'data' starts with.
+  Route Find(absl::string_view data) const {
+    std::shared_ptr<const Table> table = GetTable();
+    if (data.size() < CryptoFormat::kNonRawPrefixSize) {
+      return Route(std::move(table), nullptr);
+    }
+    const std::vector<const Keyset*>* keysets =
+        table->index.Find(data.substr(0, CryptoFormat::kNonRawPrefixSize));
+    return Route(std::move(table), keysets);
+  }
+
+ private:
+  std::shared_ptr<const Table> GetTable() const
+      ABSL_LOCKS_EXCLUDED(table_mutex_) {
+    absl::ReaderMutexLock lock(&table_mutex_);
+    return table_;
+  }
+
+  // Builds the table for 'keysets' and makes it the current one.
+  void Publish(std::vector<std::shared_ptr<const Keyset>> keysets)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(update_mutex_) {
+    auto table = std::make_shared<Table>();
+    table->keysets = std::move(keysets);
+    for (const auto& keyset : table->keysets) {
+      for (const std::string& prefix : keyset->key_prefixes) {
+        std::vector<const Keyset*>& routed = table->by_prefix[prefix];
+        // Keys of the same keyset may share a prefix.
+        if (routed.empty() || routed.back() != keyset.get()) {
+          routed.push_back(keyset.get());
+        }
+      }
+    }
+    std::vector<std::pair<absl::string_view, const std::vector<const Keyset*>*>>
+        entries;
+    entries.reserve(table->by_prefix.size());
+    for (const auto& prefix_and_keysets : table->by_prefix) {
+      entries.emplace_back(prefix_and_keysets.first,
+                           &prefix_and_keysets.second);
+    }
+    table->index =
+        internal::KeyPrefixIndex<std::vector<const Keyset*>>(entries);
+    absl::MutexLock lock(&table_mutex_);
+    table_ = std::move(table);
+  }
+
+  // Serializes AddKeyset() and RemoveKeyset(), so that none of them loses
+  // the change of another.
+  absl::Mutex update_mutex_;
+  mutable absl::Mutex table_mutex_;
+  std::shared_ptr<const Table> table_ ABSL_GUARDED_BY(table_mutex_);
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_KEYSET_ROUTER_H_
@@ -0,0 +1,133 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_LATENCY_HISTOGRAM_MONITORING_CLIENT_H_
+#define TINK_LATENCY_HISTOGRAM_MONITORING_CLIENT_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "tink/monitoring_client.h"
+
+namespace crypto {
+namespace tink {
+
+// The latencies of one operation of one primitive with one key, as returned
+// by LatencyHistogramMonitoringClient::Snapshot().
+//
+// Latencies are counted in log-linear buckets, as in HDR histograms: every
+// power of two nanoseconds is split into kSubBuckets equal buckets, so
+// percentiles are accurate to within 1/kSubBuckets of their value.
+struct LatencyHistogram {
+  static constexpr int kSubBucketBits = 3;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  // Latencies of 2^40 ns (about 18 minutes) and more share the last bucket.
+  static constexpr int kMaxExponent = 40;
+  static constexpr int kNumBuckets =
+      (kMaxExponent - kSubBucketBits + 1) * kSubBuckets;
+
+  // Returns the bucket counting 'latency', and the smallest latency counted
+  // by 'bucket'.
+  static int BucketIndex(absl::Duration latency);
+  static absl::Duration BucketLowerBound(int bucket);
+
+  std::string primitive;
+  std::string api_function;
+  // 0 for the operations which failed, see MonitoringEvent.
+  uint32_t key_id = 0;
+  int64_t count = 0;
+  int64_t total_bytes = 0;
+  // 'count' values by bucket; all zero buckets after the last non-zero one
+  // are left out.
+  std::vector<int64_t> buckets;
+
+  // Returns the latency below which the fraction 'quantile' (in [0, 1]) of
+  // the operations lie, i.e. Percentile(0.99) is the p99 latency. Returns
+  // the upper end of the bucket containing it, and zero if 'count' is zero.
+  absl::Duration Percentile(double quantile) const;
+};
+
+// A MonitoringClient which keeps a latency histogram per primitive, API
+// function and key id, e.g. for a metrics agent to scrape p50 and p99
+// latencies of the wrapped primitives:
+//
+//   static auto* histograms = new LatencyHistogramMonitoringClient();
+//   SetMonitoringClient(histograms);
+//   ...
+//   for (const LatencyHistogram& h : histograms->Snapshot()) {
+//     Export(h.primitive, h.api_function, h.key_id, h.Percentile(0.99));
+//   }
+//
+// Recording an operation takes a shared lock to find its histogram, and then
+// increments relaxed atomic counters in one of kNumShards shards, chosen per
+// thread, so that threads rarely write the same cache lines. Snapshot()
+// merges the shards. Histograms are cumulative and never removed.
+class LatencyHistogramMonitoringClient : public MonitoringClient {
+ public:
+  static constexpr int kNumShards = 4;
+
+  LatencyHistogramMonitoringClient() = default;
+
+  bool RecordsLatency() const override { return true; }
+  void Log(const MonitoringEvent& event) override;
+
+  // Returns the histograms of all operations recorded so far, ordered by
+  // primitive, API function and key id. May be called concurrently with
+  // Log(); the counts of operations recorded meanwhile may or may not be
+  // included.
+  std::vector<LatencyHistogram> Snapshot() const;
+
+  LatencyHistogramMonitoringClient(const LatencyHistogramMonitoringClient&) =
+      delete;
+  LatencyHistogramMonitoringClient& operator=(
+      const LatencyHistogramMonitoringClient&) = delete;
+
+ private:
+  struct Shard {
+    std::atomic<int64_t> total_bytes{0};
+    std::atomic<int64_t> buckets[LatencyHistogram::kNumBuckets];
+    Shard();
+  };
+  struct Series {
+    std::string primitive;
+    std::string api_function;
+    uint32_t key_id;
+    Shard shards[kNumShards];
+  };
+  // (primitive, API function, key id). The keys of series_ point into their
+  // Series, so that looking up a series does not allocate.
+  typedef std::tuple<absl::string_view, absl::string_view, uint32_t> SeriesKey;
+
+  Series* GetSeries(const MonitoringEvent& event);
+
+  mutable absl::Mutex mutex_;
+  std::map<SeriesKey, std::unique_ptr<Series>> series_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_LATENCY_HISTOGRAM_MONITORING_CLIENT_H_
@@ -17,7 +17,13 @@
 #ifndef TINK_MAC_H_
 #define TINK_MAC_H_
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/util/output_buffer_factory.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
@@ -40,6 +46,74 @@ class Mac {
       absl::string_view mac_value,
       absl::string_view data) const = 0;
 
+  // Computes the MAC for 'data' like ComputeMac(), but writes it to a buffer
+  // from 'new_buffer' and returns the part of it holding the MAC.
+  //
+  // Implementations which can compute the MAC without a temporary string
+  // should override this method; the default implementation calls
+  // ComputeMac() and copies the result.
+  virtual crypto::tink::util::StatusOr<absl::Span<char>> ComputeMacToBuffer(
+      absl::string_view data,
+      const crypto::tink::util::OutputBufferFactory& new_buffer) const {
+    auto mac_result = ComputeMac(data);
+    if (!mac_result.ok()) return mac_result.status();
+    return crypto::tink::util::internal::CopyToNewBuffer(
+        mac_result.ValueOrDie(), new_buffer);
+  }
+
+  // Computes the MACs of each of 'data'. The MACs are stored back to back in
+  // 'macs', and 'offsets' is set to data.size() + 1 positions such that the
+  // MAC of data[i] occupies the bytes [offsets[i], offsets[i + 1]) of 'macs'.
+  // Each MAC is the same as that of ComputeMac(). Fails as a whole if any of
+  // the MACs cannot be computed.
+  //
+  // Implementations should override this method if they can process several
+  // messages concurrently; the default implementation calls ComputeMac() for
+  // each message.
+  virtual crypto::tink::util::Status ComputeMacBatch(
+      absl::Span<const absl::string_view> data, std::string* macs,
+      std::vector<int64_t>* offsets) const {
+    macs->clear();
+    offsets->assign(1, 0);
+    offsets->reserve(data.size() + 1);
+    for (absl::string_view message : data) {
+      auto mac_result = ComputeMac(message);
+      if (!mac_result.ok()) return mac_result.status();
+      macs->append(mac_result.ValueOrDie());
+      offsets->push_back(macs->size());
+    }
+    return crypto::tink::util::Status::OK;
+  }
+
+  // Verifies each of 'mac_values' against the entry of 'data' at the same
+  // index, and sets 'results' to one status per item, the same as VerifyMac()
+  // returns for it. If 'stop_at_first_failure' is true, the verification may
+  // stop once an item failed; items which were not verified then have status
+  // ABORTED. Returns INVALID_ARGUMENT if 'mac_values' and 'data' differ in
+  // size, and OK otherwise, even if items failed.
+  //
+  // Implementations should override this method if they can verify several
+  // MACs faster than one by one; the default implementation calls VerifyMac()
+  // for each item.
+  virtual crypto::tink::util::Status VerifyMacBatch(
+      absl::Span<const absl::string_view> mac_values,
+      absl::Span<const absl::string_view> data, bool stop_at_first_failure,
+      std::vector<crypto::tink::util::Status>* results) const {
+    if (mac_values.size() != data.size()) {
+      return crypto::tink::util::Status(
+          crypto::tink::util::error::INVALID_ARGUMENT,
+          "mac_values and data must have the same size");
+    }
+    results->assign(data.size(), crypto::tink::util::Status(
+                                     crypto::tink::util::error::ABORTED,
+                                     "not verified"));
+    for (size_t i = 0; i < data.size(); i++) {
+      (*results)[i] = VerifyMac(mac_values[i], data[i]);
+      if (stop_at_first_failure && !(*results)[i].ok()) break;
+    }
+    return crypto::tink::util::Status::OK;
+  }
+
   virtual ~Mac() {}
 };
 
@@ -16,11 +16,23 @@
 
 #include "tink/mac/mac_wrapper.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "tink/crypto_format.h"
 #include "tink/mac.h"
+#include "tink/monitoring_client.h"
 #include "tink/primitive_set.h"
+#include "tink/raw_key_fallback_policy.h"
+#include "tink/subtle/subtle_util.h"
 #include "tink/subtle/subtle_util_boringssl.h"
+#include "tink/util/output_buffer_factory.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "proto/tink.pb.h"
@@ -34,21 +46,98 @@ namespace {
 
 class MacSetWrapper : public Mac {
  public:
-  explicit MacSetWrapper(std::unique_ptr<PrimitiveSet<Mac>> mac_set)
-      : mac_set_(std::move(mac_set)) {}
+  MacSetWrapper(std::unique_ptr<PrimitiveSet<Mac>> mac_set,
+                const RawKeyFallbackPolicy& raw_key_fallback_policy)
+      : mac_set_(std::move(mac_set)),
+        raw_key_fallback_policy_(raw_key_fallback_policy) {}
 
   crypto::tink::util::StatusOr<std::string> ComputeMac(
       absl::string_view data) const override;
 
+  crypto::tink::util::StatusOr<absl::Span<char>> ComputeMacToBuffer(
+      absl::string_view data,
+      const crypto::tink::util::OutputBufferFactory& new_buffer)
+      const override;
+
   crypto::tink::util::Status VerifyMac(absl::string_view mac_value,
                                        absl::string_view data) const override;
 
+  crypto::tink::util::Status ComputeMacBatch(
+      absl::Span<const absl::string_view> data, std::string* macs,
+      std::vector<int64_t>* offsets) const override;
+
+  // Groups the items by key prefix and verifies each group with one
+  // VerifyMacBatch() call per candidate key, so that the keys' primitives can
+  // reuse their keyed state across the items. With 'stop_at_first_failure',
+  // no further groups are verified once an item of a group failed.
+  crypto::tink::util::Status VerifyMacBatch(
+      absl::Span<const absl::string_view> mac_values,
+      absl::Span<const absl::string_view> data, bool stop_at_first_failure,
+      std::vector<crypto::tink::util::Status>* results) const override;
+
   ~MacSetWrapper() override {}
 
  private:
+  // Verifies the items at 'indices', whose MACs carry the key prefix
+  // 'key_id' if it is not null, first with the keys of that prefix and then
+  // with the RAW keys. Returns whether any of the items failed.
+  bool VerifyGroup(const std::string* key_id,
+                   const std::vector<size_t>& indices,
+                   absl::Span<const absl::string_view> mac_values,
+                   absl::Span<const absl::string_view> data,
+                   std::vector<crypto::tink::util::Status>* results) const;
+
   std::unique_ptr<PrimitiveSet<Mac>> mac_set_;
+  const RawKeyFallbackPolicy raw_key_fallback_policy_;
 };
 
+const util::Status& VerificationFailed() {
+  static const util::Status* kVerificationFailed =
+      util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                              "verification failed");
+  return *kVerificationFailed;
+}
+
+// Verifies the items at 'pending' with 'mac' in one VerifyMacBatch() call,
+// after stripping 'prefix_size' bytes from their MACs and, for LEGACY keys,
+// appending the legacy start byte to their data. Sets the results of the
+// items which verified to OK and returns the indices of the others.
+std::vector<size_t> VerifyWithKey(
+    const Mac& mac, bool is_legacy, size_t prefix_size,
+    const std::vector<size_t>& pending,
+    absl::Span<const absl::string_view> mac_values,
+    absl::Span<const absl::string_view> data,
+    std::vector<util::Status>* results) {
+  std::vector<absl::string_view> batch_macs;
+  std::vector<absl::string_view> batch_data;
+  std::vector<std::string> legacy_data;
+  batch_macs.reserve(pending.size());
+  batch_data.reserve(pending.size());
+  // Reserved upfront, as batch_data points into it.
+  if (is_legacy) legacy_data.reserve(pending.size());
+  for (size_t i : pending) {
+    batch_macs.push_back(mac_values[i].substr(prefix_size));
+    if (is_legacy) {
+      legacy_data.push_back(absl::StrCat(data[i], std::string("\x00", 1)));
+      batch_data.push_back(legacy_data.back());
+    } else {
+      batch_data.push_back(data[i]);
+    }
+  }
+  std::vector<util::Status> batch_results;
+  util::Status status = mac.VerifyMacBatch(
+      batch_macs, batch_data, /*stop_at_first_failure=*/false, &batch_results);
+  std::vector<size_t> failed;
+  for (size_t k = 0; k < pending.size(); k++) {
+    if (status.ok() && batch_results[k].ok()) {
+      (*results)[pending[k]] = util::OkStatus();
+    } else {
+      failed.push_back(pending[k]);
+    }
+  }
+  return failed;
+}
+
 util::Status Validate(PrimitiveSet<Mac>* mac_set) {
   if (mac_set == nullptr) {
     return util::Status(util::error::INTERNAL, "mac_set must be non-NULL");
@@ -65,6 +154,7 @@ util::StatusOr<std::string> MacSetWrapper::ComputeMac(
   // BoringSSL expects a non-null pointer for data,
   // regardless of whether the size is 0.
   data = subtle::SubtleUtilBoringSSL::EnsureNonNull(data);
+  internal::MonitoredOperation monitored("mac", "compute", data.size());
 
   auto primary = mac_set_->get_primary();
   std::string local_data;
@@ -76,34 +166,111 @@ util::StatusOr<std::string> MacSetWrapper::ComputeMac(
   }
   auto compute_mac_result = primary->get_primitive().ComputeMac(data);
   if (!compute_mac_result.ok()) return compute_mac_result.status();
+  monitored.Success(primary->get_key_id());
   const std::string& key_id = primary->get_identifier();
   return key_id + compute_mac_result.ValueOrDie();
 }
 
+util::StatusOr<absl::Span<char>> MacSetWrapper::ComputeMacToBuffer(
+    absl::string_view data, const util::OutputBufferFactory& new_buffer) const {
+  data = subtle::SubtleUtilBoringSSL::EnsureNonNull(data);
+  internal::MonitoredOperation monitored("mac", "compute", data.size());
+
+  auto primary = mac_set_->get_primary();
+  std::string local_data;
+  if (primary->get_output_prefix_type() == OutputPrefixType::LEGACY) {
+    local_data = std::string(data);
+    local_data.append(
+        reinterpret_cast<const char*>(&CryptoFormat::kLegacyStartByte), 1);
+    data = local_data;
+  }
+  auto compute_mac_result = util::internal::WriteToBufferWithPrefix(
+      primary->get_identifier(), new_buffer,
+      [&](const util::OutputBufferFactory& new_raw_buffer) {
+        return primary->get_primitive().ComputeMacToBuffer(data,
+                                                           new_raw_buffer);
+      });
+  if (!compute_mac_result.ok()) return compute_mac_result.status();
+  monitored.Success(primary->get_key_id());
+  return compute_mac_result;
+}
+
+util::Status MacSetWrapper::ComputeMacBatch(
+    absl::Span<const absl::string_view> data, std::string* macs,
+    std::vector<int64_t>* offsets) const {
+  auto primary = mac_set_->get_primary();
+  std::vector<std::string> legacy_data;
+  std::vector<absl::string_view> primary_data;
+  primary_data.reserve(data.size());
+  if (primary->get_output_prefix_type() == OutputPrefixType::LEGACY) {
+    legacy_data.reserve(data.size());
+    for (absl::string_view message : data) {
+      legacy_data.push_back(absl::StrCat(
+          message, absl::string_view(reinterpret_cast<const char*>(
+                                         &CryptoFormat::kLegacyStartByte),
+                                     1)));
+      primary_data.push_back(legacy_data.back());
+    }
+  } else {
+    for (absl::string_view message : data) {
+      primary_data.push_back(
+          subtle::SubtleUtilBoringSSL::EnsureNonNull(message));
+    }
+  }
+
+  // Computes all MACs with the primary, then prefixes each with the key id.
+  std::string raw_macs;
+  std::vector<int64_t> raw_offsets;
+  util::Status status = primary->get_primitive().ComputeMacBatch(
+      primary_data, &raw_macs, &raw_offsets);
+  if (!status.ok()) return status;
+  const std::string& key_id = primary->get_identifier();
+  subtle::ResizeStringUninitialized(
+      macs, raw_macs.size() + data.size() * key_id.size());
+  offsets->assign(1, 0);
+  offsets->reserve(data.size() + 1);
+  char* out = &(*macs)[0];
+  int64_t position = 0;
+  for (size_t i = 0; i < data.size(); i++) {
+    std::copy(key_id.begin(), key_id.end(), out + position);
+    position += key_id.size();
+    std::copy(raw_macs.begin() + raw_offsets[i],
+              raw_macs.begin() + raw_offsets[i + 1], out + position);
+    position += raw_offsets[i + 1] - raw_offsets[i];
+    offsets->push_back(position);
+  }
+  return util::Status::OK;
+}
+
 util::Status MacSetWrapper::VerifyMac(
     absl::string_view mac_value,
     absl::string_view data) const {
   data = subtle::SubtleUtilBoringSSL::EnsureNonNull(data);
   mac_value = subtle::SubtleUtilBoringSSL::EnsureNonNull(mac_value);
+  internal::MonitoredOperation monitored("mac", "verify", data.size());
 
+  bool prefix_matched = false;
   if (mac_value.length() > CryptoFormat::kNonRawPrefixSize) {
     absl::string_view key_id =
         mac_value.substr(0, CryptoFormat::kNonRawPrefixSize);
-    auto primitives_result = mac_set_->get_primitives(key_id);
-    if (primitives_result.ok()) {
+    const auto* primitives = mac_set_->find_primitives(key_id);
+    if (primitives != nullptr) {
+      prefix_matched = true;
       absl::string_view raw_mac_value =
           mac_value.substr(CryptoFormat::kNonRawPrefixSize);
-      for (auto& mac_entry : *(primitives_result.ValueOrDie())) {
+      for (auto& mac_entry : *primitives) {
         std::string legacy_data;
         absl::string_view view_on_data_or_legacy_data = data;
         if (mac_entry->get_output_prefix_type() == OutputPrefixType::LEGACY) {
           legacy_data = absl::StrCat(data, std::string("\x00", 1));
           view_on_data_or_legacy_data = legacy_data;
         }
-        Mac& mac = mac_entry->get_primitive();
-        util::Status status =
-            mac.VerifyMac(raw_mac_value, view_on_data_or_legacy_data);
+        auto mac_result = mac_entry->GetOrCreatePrimitive();
+        if (!mac_result.ok()) continue;
+        util::Status status = mac_result.ValueOrDie()->VerifyMac(
+            raw_mac_value, view_on_data_or_legacy_data);
         if (status.ok()) {
+          monitored.Success(mac_entry->get_key_id());
           return status;
         } else {
           // TODO(przydatek): LOG that a matching key didn't verify the MAC.
@@ -112,18 +279,255 @@ util::Status MacSetWrapper::VerifyMac(
     }
   }
 
-  // No matching key succeeded with verification, try all RAW keys.
-  auto raw_primitives_result = mac_set_->get_raw_primitives();
-  if (raw_primitives_result.ok()) {
-    for (auto& mac_entry : *(raw_primitives_result.ValueOrDie())) {
-      Mac& mac = mac_entry->get_primitive();
-      util::Status status = mac.VerifyMac(mac_value, data);
+  // No matching key succeeded with verification, try the RAW keys.
+  const auto* raw_primitives = mac_set_->find_raw_primitives();
+  if (raw_primitives != nullptr) {
+    const PrimitiveSet<Mac>::Primitives& raw = *raw_primitives;
+    size_t max_attempts = internal::RawKeysToTry(raw_key_fallback_policy_,
+                                                 prefix_matched, raw.size());
+    size_t attempts = 0;
+    while (attempts < max_attempts) {
+      const auto& mac_entry = raw[attempts++];
+      auto mac_result = mac_entry->GetOrCreatePrimitive();
+      if (!mac_result.ok()) continue;
+      util::Status status = mac_result.ValueOrDie()->VerifyMac(mac_value, data);
       if (status.ok()) {
+        monitored.Success(mac_entry->get_key_id());
+        internal::RecordRawKeyFallback(raw_key_fallback_policy_, raw.size(),
+                                       attempts, /*success=*/true);
         return status;
       }
     }
+    internal::RecordRawKeyFallback(raw_key_fallback_policy_, raw.size(),
+                                   attempts, /*success=*/false);
   }
-  return util::Status(util::error::INVALID_ARGUMENT, "verification failed");
+  static const util::Status* kVerificationFailed =
+      util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                              "verification failed");
+  return *kVerificationFailed;
+}
+
+util::Status MacSetWrapper::VerifyMacBatch(
+    absl::Span<const absl::string_view> mac_values,
+    absl::Span<const absl::string_view> data, bool stop_at_first_failure,
+    std::vector<util::Status>* results) const {
+  if (mac_values.size() != data.size()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "mac_values and data must have the same size");
+  }
+  results->assign(data.size(),
+                  util::Status(util::error::ABORTED, "not verified"));
+
+  // The groups of items with a known key prefix, in order of first
+  // appearance, followed by the items which can only match RAW keys.
+  std::vector<std::pair<std::string, std::vector<size_t>>> groups;
+  std::map<absl::string_view, size_t> group_of_prefix;
+  std::vector<size_t> unprefixed;
+  const size_t kNoGroup = groups.max_size();
+  for (size_t i = 0; i < data.size(); i++) {
+    if (mac_values[i].size() <= CryptoFormat::kNonRawPrefixSize) {
+      unprefixed.push_back(i);
+      continue;
+    }
+    absl::string_view key_id =
+        mac_values[i].substr(0, CryptoFormat::kNonRawPrefixSize);
+    auto it = group_of_prefix.find(key_id);
+    if (it == group_of_prefix.end()) {
+      size_t group = kNoGroup;
+      if (mac_set_->find_primitives(key_id) != nullptr) {
+        group = groups.size();
+        groups.emplace_back(std::string(key_id), std::vector<size_t>());
+      }
+      it = group_of_prefix.emplace(key_id, group).first;
+    }
+    if (it->second == kNoGroup) {
+      unprefixed.push_back(i);
+    } else {
+      groups[it->second].second.push_back(i);
+    }
+  }
+
+  for (const auto& group : groups) {
+    bool failed = VerifyGroup(&group.first, group.second, mac_values, data,
+                              results);
+    if (failed && stop_at_first_failure) return util::OkStatus();
+  }
+  if (!unprefixed.empty()) {
+    VerifyGroup(nullptr, unprefixed, mac_values, data, results);
+  }
+  return util::OkStatus();
+}
+
+bool MacSetWrapper::VerifyGroup(const std::string* key_id,
+                                const std::vector<size_t>& indices,
+                                absl::Span<const absl::string_view> mac_values,
+                                absl::Span<const absl::string_view> data,
+                                std::vector<util::Status>* results) const {
+  for (size_t i : indices) (*results)[i] = VerificationFailed();
+  std::vector<size_t> pending = indices;
+  if (key_id != nullptr) {
+    const auto* primitives = mac_set_->find_primitives(*key_id);
+    if (primitives != nullptr) {
+      for (auto& mac_entry : *primitives) {
+        if (pending.empty()) return false;
+        auto mac_result = mac_entry->GetOrCreatePrimitive();
+        if (!mac_result.ok()) continue;
+        pending = VerifyWithKey(
+            *mac_result.ValueOrDie(),
+            mac_entry->get_output_prefix_type() == OutputPrefixType::LEGACY,
+            CryptoFormat::kNonRawPrefixSize, pending, mac_values, data,
+            results);
+      }
+    }
+  }
+  if (pending.empty()) return false;
+
+  // No matching key succeeded with verification, try the RAW keys.
+  const auto* raw_primitives = mac_set_->find_raw_primitives();
+  if (raw_primitives != nullptr) {
+    const PrimitiveSet<Mac>::Primitives& raw = *raw_primitives;
+    size_t max_attempts = internal::RawKeysToTry(
+        raw_key_fallback_policy_, /*prefix_matched=*/key_id != nullptr,
+        raw.size());
+    size_t attempts = 0;
+    while (attempts < max_attempts && !pending.empty()) {
+      const auto& mac_entry = raw[attempts++];
+      auto mac_result = mac_entry->GetOrCreatePrimitive();
+      if (!mac_result.ok()) continue;
+      size_t before = pending.size();
+      pending = VerifyWithKey(*mac_result.ValueOrDie(), /*is_legacy=*/false,
+                              /*prefix_size=*/0, pending, mac_values, data,
+                              results);
+      for (size_t k = pending.size(); k < before; k++) {
+        internal::RecordRawKeyFallback(raw_key_fallback_policy_, raw.size(),
+                                       attempts, /*success=*/true);
+      }
+    }
+    for (size_t k = 0; k < pending.size(); k++) {
+      internal::RecordRawKeyFallback(raw_key_fallback_policy_, raw.size(),
+                                     attempts, /*success=*/false);
+    }
+  }
+  return !pending.empty();
+}
+
+// Wraps a set holding a single key with a non-RAW prefix, using the
+// primitive and key prefix directly instead of looking the entries up by
+// prefix.
+class SingleKeyMacWrapper : public MacSetWrapper {
+ public:
+  SingleKeyMacWrapper(std::unique_ptr<PrimitiveSet<Mac>> mac_set,
+                      const RawKeyFallbackPolicy& raw_key_fallback_policy,
+                      const PrimitiveSet<Mac>::Entry<Mac>& entry)
+      : MacSetWrapper(std::move(mac_set), raw_key_fallback_policy),
+        mac_(entry.get_primitive()),
+        prefix_(entry.get_identifier()),
+        key_id_(entry.get_key_id()),
+        is_legacy_(entry.get_output_prefix_type() ==
+                   OutputPrefixType::LEGACY) {}
+
+  crypto::tink::util::StatusOr<std::string> ComputeMac(
+      absl::string_view data) const override;
+
+  crypto::tink::util::StatusOr<absl::Span<char>> ComputeMacToBuffer(
+      absl::string_view data,
+      const crypto::tink::util::OutputBufferFactory& new_buffer)
+      const override;
+
+  crypto::tink::util::Status VerifyMac(absl::string_view mac_value,
+                                       absl::string_view data) const override;
+
+  crypto::tink::util::Status VerifyMacBatch(
+      absl::Span<const absl::string_view> mac_values,
+      absl::Span<const absl::string_view> data, bool stop_at_first_failure,
+      std::vector<crypto::tink::util::Status>* results) const override;
+
+ private:
+  const Mac& mac_;
+  const std::string& prefix_;
+  const uint32_t key_id_;
+  const bool is_legacy_;
+};
+
+util::StatusOr<std::string> SingleKeyMacWrapper::ComputeMac(
+    absl::string_view data) const {
+  data = subtle::SubtleUtilBoringSSL::EnsureNonNull(data);
+  internal::MonitoredOperation monitored("mac", "compute", data.size());
+  std::string legacy_data;
+  if (is_legacy_) {
+    legacy_data = absl::StrCat(data, std::string("\x00", 1));
+    data = legacy_data;
+  }
+  auto compute_mac_result = mac_.ComputeMac(data);
+  if (!compute_mac_result.ok()) return compute_mac_result.status();
+  monitored.Success(key_id_);
+  return prefix_ + compute_mac_result.ValueOrDie();
+}
+
+util::StatusOr<absl::Span<char>> SingleKeyMacWrapper::ComputeMacToBuffer(
+    absl::string_view data, const util::OutputBufferFactory& new_buffer) const {
+  data = subtle::SubtleUtilBoringSSL::EnsureNonNull(data);
+  internal::MonitoredOperation monitored("mac", "compute", data.size());
+  std::string legacy_data;
+  if (is_legacy_) {
+    legacy_data = absl::StrCat(data, std::string("\x00", 1));
+    data = legacy_data;
+  }
+  auto compute_mac_result = util::internal::WriteToBufferWithPrefix(
+      prefix_, new_buffer,
+      [&](const util::OutputBufferFactory& new_raw_buffer) {
+        return mac_.ComputeMacToBuffer(data, new_raw_buffer);
+      });
+  if (!compute_mac_result.ok()) return compute_mac_result.status();
+  monitored.Success(key_id_);
+  return compute_mac_result;
+}
+
+util::Status SingleKeyMacWrapper::VerifyMac(absl::string_view mac_value,
+                                            absl::string_view data) const {
+  data = subtle::SubtleUtilBoringSSL::EnsureNonNull(data);
+  mac_value = subtle::SubtleUtilBoringSSL::EnsureNonNull(mac_value);
+  internal::MonitoredOperation monitored("mac", "verify", data.size());
+  static const util::Status* kVerificationFailed =
+      util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                              "verification failed");
+  if (mac_value.size() <= prefix_.size() ||
+      mac_value.substr(0, prefix_.size()) != prefix_) {
+    return *kVerificationFailed;
+  }
+  std::string legacy_data;
+  if (is_legacy_) {
+    legacy_data = absl::StrCat(data, std::string("\x00", 1));
+    data = legacy_data;
+  }
+  if (!mac_.VerifyMac(mac_value.substr(prefix_.size()), data).ok()) {
+    return *kVerificationFailed;
+  }
+  monitored.Success(key_id_);
+  return util::Status::OK;
+}
+
+util::Status SingleKeyMacWrapper::VerifyMacBatch(
+    absl::Span<const absl::string_view> mac_values,
+    absl::Span<const absl::string_view> data, bool stop_at_first_failure,
+    std::vector<util::Status>* results) const {
+  if (mac_values.size() != data.size()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "mac_values and data must have the same size");
+  }
+  results->assign(data.size(), VerificationFailed());
+  std::vector<size_t> pending;
+  pending.reserve(data.size());
+  for (size_t i = 0; i < data.size(); i++) {
+    if (mac_values[i].size() > prefix_.size() &&
+        mac_values[i].substr(0, prefix_.size()) == prefix_) {
+      pending.push_back(i);
+    }
+  }
+  // All items are verified in a single call, so every item is reported.
+  VerifyWithKey(mac_, is_legacy_, prefix_.size(), pending, mac_values, data,
+                results);
+  return util::OkStatus();
 }
 
 }  // namespace
@@ -132,7 +536,16 @@ util::StatusOr<std::unique_ptr<Mac>> MacWrapper::Wrap(
       std::unique_ptr<PrimitiveSet<Mac>> mac_set) const {
   util::Status status = Validate(mac_set.get());
   if (!status.ok()) return status;
-  std::unique_ptr<Mac> mac(new MacSetWrapper(std::move(mac_set)));
+  const PrimitiveSet<Mac>::Entry<Mac>* single_entry =
+      mac_set->get_single_entry();
+  if (single_entry != nullptr &&
+      single_entry->get_output_prefix_type() != OutputPrefixType::RAW) {
+    std::unique_ptr<Mac> mac(new SingleKeyMacWrapper(
+        std::move(mac_set), raw_key_fallback_policy_, *single_entry));
+    return std::move(mac);
+  }
+  std::unique_ptr<Mac> mac(
+      new MacSetWrapper(std::move(mac_set), raw_key_fallback_policy_));
   return std::move(mac);
 }
 
@@ -21,6 +21,7 @@
 #include "tink/mac.h"
 #include "tink/primitive_set.h"
 #include "tink/primitive_wrapper.h"
+#include "tink/raw_key_fallback_policy.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "proto/tink.pb.h"
@@ -33,10 +34,21 @@ namespace tink {
 // instances, depending on the context:
 //   * Mac::ComputeMac(...) uses the primary instance from the set
 //   * Mac::VerifyMac(...) uses the instance that matches the MAC prefix.
+//     If none of them verifies the MAC, the instances with RAW prefix are
+//     tried, as allowed by the RawKeyFallbackPolicy.
 class MacWrapper : public PrimitiveWrapper<Mac, Mac> {
  public:
+  MacWrapper() = default;
+  explicit MacWrapper(const RawKeyFallbackPolicy& raw_key_fallback_policy)
+      : raw_key_fallback_policy_(raw_key_fallback_policy) {}
+
   util::StatusOr<std::unique_ptr<Mac>> Wrap(
       std::unique_ptr<PrimitiveSet<Mac>> mac_set) const override;
+
+  bool SupportsLazyPrimitives() const override { return true; }
+
+ private:
+  RawKeyFallbackPolicy raw_key_fallback_policy_;
 };
 
 }  // namespace tink
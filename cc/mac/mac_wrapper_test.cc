@@ -16,11 +16,18 @@
 
 #include "tink/mac/mac_wrapper.h"
 
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "tink/crypto_format.h"
 #include "tink/mac.h"
+#include "tink/monitoring_client.h"
 #include "tink/primitive_set.h"
+#include "tink/raw_key_fallback_policy.h"
 #include "tink/util/status.h"
 #include "tink/util/test_matchers.h"
 #include "tink/util/test_util.h"
@@ -28,6 +35,7 @@
 
 using crypto::tink::test::DummyMac;
 using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
 using google::crypto::tink::KeysetInfo;
 using google::crypto::tink::KeyStatusType;
 using google::crypto::tink::OutputPrefixType;
@@ -112,6 +120,39 @@ TEST(MacWrapperTest, Basic) {
                       status.error_message());
 }
 
+TEST(MacWrapperTest, ComputeMacBatch) {
+  for (OutputPrefixType prefix_type :
+       {OutputPrefixType::TINK, OutputPrefixType::LEGACY}) {
+    KeysetInfo keyset_info;
+    KeysetInfo::KeyInfo* key_info = keyset_info.add_key_info();
+    key_info->set_output_prefix_type(prefix_type);
+    key_info->set_key_id(1234543);
+    key_info->set_status(KeyStatusType::ENABLED);
+    std::unique_ptr<PrimitiveSet<Mac>> mac_set(new PrimitiveSet<Mac>());
+    auto entry_result = mac_set->AddPrimitive(
+        absl::make_unique<DummyMac>("mac"), keyset_info.key_info(0));
+    ASSERT_TRUE(entry_result.ok());
+    ASSERT_THAT(mac_set->set_primary(entry_result.ValueOrDie()), IsOk());
+    auto mac_result = MacWrapper().Wrap(std::move(mac_set));
+    ASSERT_TRUE(mac_result.ok()) << mac_result.status();
+    std::unique_ptr<Mac> mac = std::move(mac_result.ValueOrDie());
+
+    std::vector<absl::string_view> data = {"first", "", "third"};
+    std::string macs;
+    std::vector<int64_t> offsets;
+    ASSERT_THAT(mac->ComputeMacBatch(data, &macs, &offsets), IsOk());
+    ASSERT_EQ(offsets.size(), data.size() + 1);
+    for (size_t i = 0; i < data.size(); i++) {
+      std::string mac_value =
+          macs.substr(offsets[i], offsets[i + 1] - offsets[i]);
+      auto compute_mac_result = mac->ComputeMac(data[i]);
+      ASSERT_TRUE(compute_mac_result.ok()) << compute_mac_result.status();
+      EXPECT_EQ(mac_value, compute_mac_result.ValueOrDie());
+      EXPECT_THAT(mac->VerifyMac(mac_value, data[i]), IsOk());
+    }
+  }
+}
+
 TEST(MacWrapperTest, testLegacyAuthentication) {
   // Prepare a set for the wrapper.
   KeysetInfo::KeyInfo key_info;
@@ -206,6 +247,305 @@ TEST(MacWrapperTest, VerifyRawAfterLegacy) {
               IsOk());
 }
 
+TEST(MacWrapperTest, RawKeyFallbackPolicy) {
+  std::string data = "some data";
+  std::string raw2_mac = DummyMac("raw2").ComputeMac(data).ValueOrDie();
+  const char* const kNames[] = {"tink", "raw1", "raw2"};
+  auto new_wrapped_mac =
+      [&kNames](const RawKeyFallbackPolicy& policy) -> std::unique_ptr<Mac> {
+    std::unique_ptr<PrimitiveSet<Mac>> mac_set(new PrimitiveSet<Mac>());
+    for (int i = 0; i < 3; i++) {
+      KeysetInfo::KeyInfo key_info;
+      key_info.set_output_prefix_type(i == 0 ? OutputPrefixType::TINK
+                                             : OutputPrefixType::RAW);
+      key_info.set_key_id(1000 + i);
+      key_info.set_status(KeyStatusType::ENABLED);
+      auto entry = mac_set->AddPrimitive(
+          absl::make_unique<DummyMac>(kNames[i]), key_info);
+      EXPECT_THAT(entry.status(), IsOk());
+      if (i == 0) EXPECT_THAT(mac_set->set_primary(entry.ValueOrDie()), IsOk());
+    }
+    return std::move(
+        MacWrapper(policy).Wrap(std::move(mac_set)).ValueOrDie());
+  };
+
+  RawKeyFallbackCounters counters;
+  RawKeyFallbackPolicy policy;
+  policy.counters = &counters;
+  std::unique_ptr<Mac> mac = new_wrapped_mac(policy);
+  std::string mac_tag = mac->ComputeMac(data).ValueOrDie();
+  EXPECT_THAT(mac->VerifyMac(mac_tag, data), IsOk());
+  EXPECT_THAT(mac->VerifyMac(raw2_mac, data), IsOk());
+  EXPECT_EQ(counters.fallbacks, 1);
+  EXPECT_EQ(counters.raw_attempts, 2);
+  EXPECT_EQ(counters.raw_successes, 1);
+  EXPECT_EQ(counters.skipped, 0);
+
+  RawKeyFallbackCounters limited_counters;
+  policy.max_raw_attempts = 1;
+  policy.counters = &limited_counters;
+  mac = new_wrapped_mac(policy);
+  EXPECT_FALSE(mac->VerifyMac(raw2_mac, data).ok());
+  EXPECT_EQ(limited_counters.raw_attempts, 1);
+  EXPECT_EQ(limited_counters.skipped, 1);
+
+  RawKeyFallbackCounters skip_counters;
+  policy.max_raw_attempts = -1;
+  policy.skip_if_prefix_matched = true;
+  policy.counters = &skip_counters;
+  mac = new_wrapped_mac(policy);
+  EXPECT_FALSE(mac->VerifyMac(mac_tag, "other data").ok());
+  EXPECT_THAT(mac->VerifyMac(raw2_mac, data), IsOk());
+  EXPECT_EQ(skip_counters.fallbacks, 1);
+  EXPECT_EQ(skip_counters.raw_successes, 1);
+  EXPECT_EQ(skip_counters.skipped, 1);
+}
+
+// Stores the events it is passed.
+class RecordingMonitoringClient : public MonitoringClient {
+ public:
+  void Log(const MonitoringEvent& event) override { events.push_back(event); }
+
+  std::vector<MonitoringEvent> events;
+};
+
+TEST(MacWrapperTest, ReportsToMonitoringClient) {
+  std::unique_ptr<PrimitiveSet<Mac>> mac_set(new PrimitiveSet<Mac>());
+  KeysetInfo::KeyInfo key_info;
+  key_info.set_output_prefix_type(OutputPrefixType::TINK);
+  key_info.set_key_id(1234);
+  key_info.set_status(KeyStatusType::ENABLED);
+  auto entry =
+      mac_set->AddPrimitive(absl::make_unique<DummyMac>("mac"), key_info);
+  ASSERT_THAT(entry.status(), IsOk());
+  ASSERT_THAT(mac_set->set_primary(entry.ValueOrDie()), IsOk());
+  auto mac = MacWrapper().Wrap(std::move(mac_set));
+  ASSERT_THAT(mac.status(), IsOk());
+
+  RecordingMonitoringClient client;
+  SetMonitoringClient(&client);
+  std::string data = "some data";
+  std::string mac_tag = mac.ValueOrDie()->ComputeMac(data).ValueOrDie();
+  EXPECT_THAT(mac.ValueOrDie()->VerifyMac(mac_tag, data), IsOk());
+  EXPECT_FALSE(mac.ValueOrDie()->VerifyMac(mac_tag, "other data").ok());
+  SetMonitoringClient(nullptr);
+
+  ASSERT_EQ(client.events.size(), 3);
+  EXPECT_EQ(client.events[0].api_function, "compute");
+  EXPECT_EQ(client.events[0].key_id, 1234);
+  EXPECT_EQ(client.events[0].num_bytes, data.size());
+  EXPECT_TRUE(client.events[0].success);
+  EXPECT_EQ(client.events[1].api_function, "verify");
+  EXPECT_EQ(client.events[1].key_id, 1234);
+  EXPECT_TRUE(client.events[1].success);
+  EXPECT_EQ(client.events[2].api_function, "verify");
+  EXPECT_FALSE(client.events[2].success);
+}
+
+std::unique_ptr<Mac> WrapSingleDummyMac(const KeysetInfo::KeyInfo& key_info,
+                                        bool freeze) {
+  std::unique_ptr<PrimitiveSet<Mac>> mac_set(new PrimitiveSet<Mac>());
+  auto entry_result = mac_set->AddPrimitive(
+      absl::make_unique<DummyMac>("single_mac"), key_info);
+  EXPECT_THAT(entry_result.status(), IsOk());
+  EXPECT_THAT(mac_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  if (freeze) mac_set->Freeze();
+  return std::move(MacWrapper().Wrap(std::move(mac_set)).ValueOrDie());
+}
+
+TEST(MacWrapperTest, SingleKeyMatchesGeneralWrapper) {
+  for (OutputPrefixType prefix_type :
+       {OutputPrefixType::TINK, OutputPrefixType::LEGACY,
+        OutputPrefixType::CRUNCHY, OutputPrefixType::RAW}) {
+    SCOPED_TRACE(prefix_type);
+    KeysetInfo::KeyInfo key_info;
+    key_info.set_output_prefix_type(prefix_type);
+    key_info.set_key_id(1234543);
+    key_info.set_status(KeyStatusType::ENABLED);
+    // Only the frozen set takes the single-key fast path.
+    std::unique_ptr<Mac> single = WrapSingleDummyMac(key_info, true);
+    std::unique_ptr<Mac> general = WrapSingleDummyMac(key_info, false);
+    std::string data = "Some data to authenticate";
+
+    auto mac_value = single->ComputeMac(data);
+    ASSERT_THAT(mac_value.status(), IsOk());
+    EXPECT_EQ(mac_value.ValueOrDie(), general->ComputeMac(data).ValueOrDie());
+    EXPECT_THAT(single->VerifyMac(mac_value.ValueOrDie(), data), IsOk());
+    EXPECT_FALSE(single->VerifyMac(mac_value.ValueOrDie(), "other").ok());
+
+    std::string other_prefix = mac_value.ValueOrDie();
+    other_prefix[1] ^= 1;
+    for (const std::string& bad_mac :
+         {other_prefix, std::string(mac_value.ValueOrDie(), 0, 3)}) {
+      EXPECT_EQ(single->VerifyMac(bad_mac, data).ok(),
+                general->VerifyMac(bad_mac, data).ok());
+    }
+  }
+}
+
+TEST(MacWrapperTest, ComputeMacToBuffer) {
+  for (OutputPrefixType prefix_type :
+       {OutputPrefixType::TINK, OutputPrefixType::LEGACY,
+        OutputPrefixType::RAW}) {
+    for (bool single_key : {true, false}) {
+      SCOPED_TRACE(prefix_type);
+      SCOPED_TRACE(single_key);
+      KeysetInfo::KeyInfo key_info;
+      key_info.set_output_prefix_type(prefix_type);
+      key_info.set_key_id(1234543);
+      key_info.set_status(KeyStatusType::ENABLED);
+      std::unique_ptr<Mac> mac = WrapSingleDummyMac(key_info, single_key);
+      std::string data = "Some data to authenticate";
+
+      std::string arena(256, '\0');
+      int calls = 0;
+      auto mac_result = mac->ComputeMacToBuffer(
+          data, [&arena, &calls](int64_t size) {
+            calls++;
+            return absl::MakeSpan(&arena[0], size);
+          });
+      ASSERT_THAT(mac_result.status(), IsOk());
+      EXPECT_EQ(1, calls);
+      EXPECT_EQ(&arena[0], mac_result.ValueOrDie().data());
+      std::string mac_value(mac_result.ValueOrDie().data(),
+                            mac_result.ValueOrDie().size());
+      EXPECT_EQ(mac->ComputeMac(data).ValueOrDie(), mac_value);
+      EXPECT_THAT(mac->VerifyMac(mac_value, data), IsOk());
+
+      EXPECT_THAT(
+          mac->ComputeMacToBuffer(
+                 data, [](int64_t size) { return absl::Span<char>(); })
+              .status(),
+          StatusIs(util::error::RESOURCE_EXHAUSTED));
+    }
+  }
+}
+
+TEST(MacWrapperTest, VerifyMacBatchMatchesVerifyMac) {
+  const OutputPrefixType kPrefixTypes[] = {
+      OutputPrefixType::TINK, OutputPrefixType::LEGACY, OutputPrefixType::RAW,
+      OutputPrefixType::TINK};
+  std::unique_ptr<PrimitiveSet<Mac>> mac_set(new PrimitiveSet<Mac>());
+  std::vector<std::string> prefixes;
+  for (int i = 0; i < 4; i++) {
+    KeysetInfo::KeyInfo key_info;
+    key_info.set_output_prefix_type(kPrefixTypes[i]);
+    key_info.set_key_id(1000 + i);
+    key_info.set_status(KeyStatusType::ENABLED);
+    auto entry = mac_set->AddPrimitive(
+        absl::make_unique<DummyMac>(absl::StrCat("mac", i)), key_info);
+    ASSERT_THAT(entry.status(), IsOk());
+    if (i == 0) ASSERT_THAT(mac_set->set_primary(entry.ValueOrDie()), IsOk());
+    prefixes.push_back(CryptoFormat::GetOutputPrefix(key_info).ValueOrDie());
+  }
+  auto mac_result = MacWrapper().Wrap(std::move(mac_set));
+  ASSERT_THAT(mac_result.status(), IsOk());
+  std::unique_ptr<Mac> mac = std::move(mac_result.ValueOrDie());
+
+  // The MACs of every key, interleaved, with some broken ones.
+  std::vector<std::string> mac_values;
+  std::vector<std::string> data;
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < 4; i++) {
+      std::string message = absl::StrCat("message ", round, " ", i);
+      std::string mac_data = message;
+      if (kPrefixTypes[i] == OutputPrefixType::LEGACY) {
+        mac_data.push_back('\0');
+      }
+      mac_values.push_back(absl::StrCat(
+          prefixes[i],
+          DummyMac(absl::StrCat("mac", i)).ComputeMac(mac_data).ValueOrDie()));
+      data.push_back(round == 1 ? "other data" : message);
+    }
+  }
+  mac_values.push_back("short");
+  data.push_back("");
+  mac_values.push_back(absl::StrCat(prefixes[0], "bad mac"));
+  data.push_back("message 0 0");
+
+  std::vector<absl::string_view> mac_views(mac_values.begin(),
+                                           mac_values.end());
+  std::vector<absl::string_view> data_views(data.begin(), data.end());
+  std::vector<util::Status> results;
+  ASSERT_THAT(mac->VerifyMacBatch(mac_views, data_views,
+                                  /*stop_at_first_failure=*/false, &results),
+              IsOk());
+  ASSERT_EQ(results.size(), data.size());
+  for (size_t i = 0; i < data.size(); i++) {
+    SCOPED_TRACE(i);
+    util::Status expected = mac->VerifyMac(mac_values[i], data[i]);
+    EXPECT_EQ(results[i].ok(), expected.ok());
+    EXPECT_EQ(results[i].error_code(), expected.error_code());
+    EXPECT_EQ(results[i].ok(), i / 4 != 1 && i < 12);
+  }
+
+  EXPECT_THAT(mac->VerifyMacBatch(mac_views, {}, false, &results),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(MacWrapperTest, VerifyMacBatchStopsAtFirstFailure) {
+  std::unique_ptr<PrimitiveSet<Mac>> mac_set(new PrimitiveSet<Mac>());
+  std::vector<std::string> prefixes;
+  for (int i = 0; i < 2; i++) {
+    KeysetInfo::KeyInfo key_info;
+    key_info.set_output_prefix_type(OutputPrefixType::TINK);
+    key_info.set_key_id(1000 + i);
+    key_info.set_status(KeyStatusType::ENABLED);
+    auto entry = mac_set->AddPrimitive(
+        absl::make_unique<DummyMac>(absl::StrCat("mac", i)), key_info);
+    ASSERT_THAT(entry.status(), IsOk());
+    if (i == 0) ASSERT_THAT(mac_set->set_primary(entry.ValueOrDie()), IsOk());
+    prefixes.push_back(CryptoFormat::GetOutputPrefix(key_info).ValueOrDie());
+  }
+  std::unique_ptr<Mac> mac =
+      std::move(MacWrapper().Wrap(std::move(mac_set)).ValueOrDie());
+
+  std::string good_mac = absl::StrCat(
+      prefixes[1], DummyMac("mac1").ComputeMac("data").ValueOrDie());
+  std::string bad_mac = absl::StrCat(prefixes[0], "bad mac");
+  std::vector<absl::string_view> mac_values = {bad_mac, good_mac, bad_mac};
+  std::vector<absl::string_view> data = {"data", "data", "data"};
+  std::vector<util::Status> results;
+  ASSERT_THAT(mac->VerifyMacBatch(mac_values, data,
+                                  /*stop_at_first_failure=*/true, &results),
+              IsOk());
+  ASSERT_EQ(results.size(), 3);
+  EXPECT_THAT(results[0], StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(results[1], StatusIs(util::error::ABORTED));
+  EXPECT_THAT(results[2], StatusIs(util::error::INVALID_ARGUMENT));
+
+  ASSERT_THAT(mac->VerifyMacBatch(mac_values, data,
+                                  /*stop_at_first_failure=*/false, &results),
+              IsOk());
+  EXPECT_THAT(results[1], IsOk());
+}
+
+TEST(MacWrapperTest, SingleKeyVerifyMacBatch) {
+  for (OutputPrefixType prefix_type :
+       {OutputPrefixType::TINK, OutputPrefixType::LEGACY}) {
+    SCOPED_TRACE(prefix_type);
+    KeysetInfo::KeyInfo key_info;
+    key_info.set_output_prefix_type(prefix_type);
+    key_info.set_key_id(1234543);
+    key_info.set_status(KeyStatusType::ENABLED);
+    std::unique_ptr<Mac> single = WrapSingleDummyMac(key_info, true);
+    std::string mac_value = single->ComputeMac("data").ValueOrDie();
+    std::string other_prefix = mac_value;
+    other_prefix[1] ^= 1;
+    std::vector<absl::string_view> mac_values = {mac_value, other_prefix,
+                                                 mac_value, "x"};
+    std::vector<absl::string_view> data = {"data", "data", "other", "data"};
+    std::vector<util::Status> results;
+    ASSERT_THAT(single->VerifyMacBatch(mac_values, data, false, &results),
+                IsOk());
+    ASSERT_EQ(results.size(), 4);
+    EXPECT_THAT(results[0], IsOk());
+    for (int i = 1; i < 4; i++) {
+      EXPECT_THAT(results[i], StatusIs(util::error::INVALID_ARGUMENT)) << i;
+    }
+  }
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
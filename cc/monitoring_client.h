@@ -0,0 +1,123 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_MONITORING_CLIENT_H_
+#define TINK_MONITORING_CLIENT_H_
+
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace crypto {
+namespace tink {
+
+// Describes one operation of a primitive obtained from a keyset handle.
+struct MonitoringEvent {
+  // Name of the primitive, e.g. "aead" or "mac".
+  absl::string_view primitive;
+  // Name of the function called, e.g. "encrypt" or "verify".
+  absl::string_view api_function;
+  // Id of the key which performed the operation. 0 if the operation failed
+  // without any key succeeding, e.g. for a ciphertext no key decrypts.
+  uint32_t key_id = 0;
+  // Size of the input, i.e. of the plaintext, ciphertext, message or data.
+  int64_t num_bytes = 0;
+  bool success = false;
+  // Duration of the operation if the client records latency, otherwise zero.
+  absl::Duration latency;
+};
+
+// Receives the operations of the primitives returned by the keyset wrappers
+// (AeadWrapper, MacWrapper, PublicKeyVerifyWrapper etc.), e.g. to find out
+// which keys of a keyset are still in use.
+//
+// Log() is called on the thread performing the operation, after it has
+// finished, and may be called concurrently. It should return quickly, e.g.
+// by updating atomic counters.
+class MonitoringClient {
+ public:
+  // Returns whether the events passed to Log() should carry the latency of
+  // the operation, which costs two clock reads per operation. Must always
+  // return the same value.
+  virtual bool RecordsLatency() const { return false; }
+
+  virtual void Log(const MonitoringEvent& event) = 0;
+
+  virtual ~MonitoringClient() {}
+};
+
+// Sets the client which gets the operations of all wrapped primitives, or
+// disables monitoring if 'client' is nullptr, which is the default. The
+// client is not owned, and must stay valid while any wrapped primitive is in
+// use, even after it has been replaced. Without a client, the overhead per
+// operation is a single atomic load.
+void SetMonitoringClient(MonitoringClient* client);
+
+// Returns the client set by SetMonitoringClient(), or nullptr.
+MonitoringClient* GetMonitoringClient();
+
+namespace internal {
+
+// Reports one operation of a wrapped primitive to the monitoring client set
+// at its construction. Unless Success() is called, the operation is reported
+// as failed when the MonitoredOperation goes out of scope.
+class MonitoredOperation {
+ public:
+  MonitoredOperation(absl::string_view primitive,
+                     absl::string_view api_function, int64_t num_bytes)
+      : client_(GetMonitoringClient()) {
+    if (client_ == nullptr) return;
+    event_.primitive = primitive;
+    event_.api_function = api_function;
+    event_.num_bytes = num_bytes;
+    if (client_->RecordsLatency()) start_ = absl::Now();
+  }
+
+  // Reports the operation as performed by the key with id 'key_id'.
+  void Success(uint32_t key_id) {
+    if (client_ == nullptr) return;
+    event_.key_id = key_id;
+    event_.success = true;
+    Report();
+  }
+
+  ~MonitoredOperation() {
+    if (client_ != nullptr) Report();
+  }
+
+  MonitoredOperation(const MonitoredOperation&) = delete;
+  MonitoredOperation& operator=(const MonitoredOperation&) = delete;
+
+ private:
+  void Report() {
+    if (start_ != absl::InfinitePast()) event_.latency = absl::Now() - start_;
+    client_->Log(event_);
+    client_ = nullptr;
+  }
+
+  MonitoringClient* client_;
+  MonitoringEvent event_;
+  absl::Time start_ = absl::InfinitePast();
+};
+
+}  // namespace internal
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_MONITORING_CLIENT_H_
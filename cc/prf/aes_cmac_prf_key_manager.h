@@ -17,12 +17,19 @@
 #define TINK_PRF_AES_CMAC_PRF_KEY_MANAGER_H_
 
 #include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tink/core/key_type_manager.h"
 #include "tink/key_manager.h"
+#include "tink/prf/prf_set.h"
+#include "tink/subtle/aes_cmac_batch.h"
 #include "tink/subtle/prf/prf_set_util.h"
 #include "tink/subtle/random.h"
 #include "tink/subtle/stateful_cmac_boringssl.h"
@@ -39,6 +46,44 @@
 
 namespace crypto {
 namespace tink {
+namespace internal {
+
+// The AES-CMAC PRF. Compute() goes through StatefulCmacBoringSsl, while
+// ComputeBatch() interleaves the inputs with subtle::ComputeAesCmacBatch().
+class AesCmacPrf : public Prf {
+ public:
+  AesCmacPrf(util::SecretData key, std::unique_ptr<Prf> prf,
+             size_t max_output_length)
+      : key_(std::move(key)),
+        prf_(std::move(prf)),
+        max_output_length_(max_output_length) {}
+
+  util::StatusOr<std::string> Compute(absl::string_view input,
+                                      size_t output_length) const override {
+    return prf_->Compute(input, output_length);
+  }
+
+  using Prf::ComputeBatch;
+  util::Status ComputeBatch(absl::Span<const absl::string_view> inputs,
+                            size_t output_length,
+                            absl::Span<uint8_t> out) const override {
+    if (output_length > max_output_length_) {
+      return util::Status(
+          util::error::INVALID_ARGUMENT,
+          absl::StrCat("PRF only supports outputs up to ", max_output_length_,
+                       " bytes, but ", output_length,
+                       " bytes were requested"));
+    }
+    return subtle::ComputeAesCmacBatch(key_, inputs, output_length, out);
+  }
+
+ private:
+  const util::SecretData key_;
+  const std::unique_ptr<Prf> prf_;
+  const size_t max_output_length_;
+};
+
+}  // namespace internal
 
 class AesCmacPrfKeyManager
     : public KeyTypeManager<google::crypto::tink::AesCmacPrfKey,
@@ -48,10 +93,14 @@ class AesCmacPrfKeyManager
   class PrfSetFactory : public PrimitiveFactory<Prf> {
     crypto::tink::util::StatusOr<std::unique_ptr<Prf>> Create(
         const google::crypto::tink::AesCmacPrfKey& key) const override {
-      return subtle::CreatePrfFromStatefulMacFactory(
+      util::SecretData key_value =
+          util::SecretDataFromStringView(key.key_value());
+      std::unique_ptr<Prf> prf = subtle::CreatePrfFromStatefulMacFactory(
           absl::make_unique<subtle::StatefulCmacBoringSslFactory>(
-              AesCmacPrfKeyManager::MaxOutputLength(),
-              util::SecretDataFromStringView(key.key_value())));
+              AesCmacPrfKeyManager::MaxOutputLength(), key_value));
+      return {absl::make_unique<internal::AesCmacPrf>(
+          std::move(key_value), std::move(prf),
+          AesCmacPrfKeyManager::MaxOutputLength())};
     }
   };
 
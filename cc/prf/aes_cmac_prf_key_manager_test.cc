@@ -16,6 +16,8 @@
 #include "tink/prf/aes_cmac_prf_key_manager.h"
 
 #include <sstream>
+#include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -147,6 +149,27 @@ TEST(AesCmacPrfKeyManagerTest, GetPrimitive) {
               StrEq(prf_value_or.ValueOrDie()));
 }
 
+TEST(AesCmacPrfKeyManagerTest, ComputeBatchMatchesCompute) {
+  AesCmacPrfKeyFormat format = ValidKeyFormat();
+  AesCmacPrfKey key = AesCmacPrfKeyManager().CreateKey(format).ValueOrDie();
+  auto prf_or = AesCmacPrfKeyManager().GetPrimitive<Prf>(key);
+  ASSERT_THAT(prf_or.status(), IsOk());
+  std::vector<std::string> inputs;
+  for (int i = 0; i < 20; i++) inputs.push_back(std::string(3 * i, 'a' + i));
+  std::vector<absl::string_view> views(inputs.begin(), inputs.end());
+
+  std::string outputs;
+  ASSERT_THAT(prf_or.ValueOrDie()->ComputeBatch(views, 10, &outputs), IsOk());
+  ASSERT_THAT(outputs, SizeIs(10 * inputs.size()));
+  for (size_t i = 0; i < inputs.size(); i++) {
+    auto output_or = prf_or.ValueOrDie()->Compute(inputs[i], 10);
+    ASSERT_THAT(output_or.status(), IsOk());
+    EXPECT_THAT(outputs.substr(10 * i, 10), StrEq(output_or.ValueOrDie()));
+  }
+  EXPECT_THAT(prf_or.ValueOrDie()->ComputeBatch(views, 17, &outputs),
+              Not(IsOk()));
+}
+
 TEST(AesCmacPrfKeyManagerTest, DeriveKeyValid) {
   std::string bytes = "0123456789abcdef0123456789abcdef";
   auto inputstream = GetInputStreamForString(bytes);
@@ -0,0 +1,192 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/prf/blind_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/prf/prf_set.h"
+#include "tink/subtle/subtle_util.h"
+#include "tink/util/executor.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+constexpr uint64_t BlindIndex::kMaxRows;
+
+namespace {
+
+// Number of values whose tags one task computes and sorts. Large enough for
+// the batch PRF kernels and to amortize scheduling a task.
+constexpr size_t kChunkSize = 4096;
+constexpr size_t kMaxTagSize = 255;
+
+void StoreBigEndian32(uint32_t value, char* out) {
+  out[0] = static_cast<char>(value >> 24);
+  out[1] = static_cast<char>(value >> 16);
+  out[2] = static_cast<char>(value >> 8);
+  out[3] = static_cast<char>(value);
+}
+
+uint32_t LoadBigEndian32(const char* in) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(in);
+  return (static_cast<uint32_t>(bytes[0]) << 24) |
+         (static_cast<uint32_t>(bytes[1]) << 16) |
+         (static_cast<uint32_t>(bytes[2]) << 8) | bytes[3];
+}
+
+}  // namespace
+
+// static
+util::StatusOr<BlindIndex> BlindIndex::Build(
+    const Prf& prf, absl::Span<const absl::string_view> values,
+    size_t tag_size, int num_threads) {
+  if (tag_size == 0 || tag_size > kMaxTagSize) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid tag size");
+  }
+  if (values.size() > kMaxRows) {
+    return util::Status(util::error::INVALID_ARGUMENT, "too many values");
+  }
+  const size_t num_rows = values.size();
+  const size_t num_chunks = (num_rows + kChunkSize - 1) / kChunkSize;
+
+  // The tags of all rows, in order of the rows.
+  std::string tags;
+  subtle::ResizeStringUninitialized(&tags, num_rows * tag_size);
+  auto tag = [&tags, tag_size](uint32_t row) {
+    return &tags[row * tag_size];
+  };
+  auto row_less = [&tag, tag_size](uint32_t row1, uint32_t row2) {
+    int order = std::memcmp(tag(row1), tag(row2), tag_size);
+    return order < 0 || (order == 0 && row1 < row2);
+  };
+
+  // Each chunk of rows is sorted by the task that computes its tags.
+  std::vector<uint32_t> rows(num_rows);
+  std::vector<util::Status> statuses(num_chunks);
+  util::ParallelFor(num_chunks, num_threads, [&](int64_t chunk) {
+    size_t begin = chunk * kChunkSize;
+    size_t end = std::min(num_rows, begin + kChunkSize);
+    statuses[chunk] = prf.ComputeBatch(
+        values.subspan(begin, end - begin), tag_size,
+        absl::MakeSpan(reinterpret_cast<uint8_t*>(tag(begin)),
+                       (end - begin) * tag_size));
+    if (!statuses[chunk].ok()) return;
+    for (size_t row = begin; row < end; row++) rows[row] = row;
+    std::sort(rows.begin() + begin, rows.begin() + end, row_less);
+  });
+  for (const util::Status& status : statuses) {
+    if (!status.ok()) return status;
+  }
+
+  // Merges sorted runs pairwise, doubling their length in each round.
+  for (size_t run_size = kChunkSize; run_size < num_rows; run_size *= 2) {
+    size_t num_merges = (num_rows + 2 * run_size - 1) / (2 * run_size);
+    util::ParallelFor(num_merges, num_threads, [&](int64_t merge) {
+      size_t begin = merge * 2 * run_size;
+      size_t middle = std::min(num_rows, begin + run_size);
+      size_t end = std::min(num_rows, begin + 2 * run_size);
+      std::inplace_merge(rows.begin() + begin, rows.begin() + middle,
+                         rows.begin() + end, row_less);
+    });
+  }
+
+  const size_t record_size = tag_size + sizeof(uint32_t);
+  std::string data;
+  subtle::ResizeStringUninitialized(&data, 1 + num_rows * record_size);
+  data[0] = static_cast<char>(tag_size);
+  util::ParallelFor(num_chunks, num_threads, [&](int64_t chunk) {
+    size_t begin = chunk * kChunkSize;
+    size_t end = std::min(num_rows, begin + kChunkSize);
+    char* record = &data[1 + begin * record_size];
+    for (size_t i = begin; i < end; i++, record += record_size) {
+      std::memcpy(record, tag(rows[i]), tag_size);
+      StoreBigEndian32(rows[i], record + tag_size);
+    }
+  });
+  return BlindIndex(tag_size, std::move(data));
+}
+
+// static
+util::StatusOr<BlindIndex> BlindIndex::FromData(std::string data) {
+  if (data.empty() || data[0] == 0) {
+    return util::Status(util::error::INVALID_ARGUMENT, "not a blind index");
+  }
+  size_t tag_size = static_cast<uint8_t>(data[0]);
+  size_t record_size = tag_size + sizeof(uint32_t);
+  if ((data.size() - 1) % record_size != 0) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "blind index has a partial record");
+  }
+  // Find() relies on the order of the records.
+  for (size_t pos = 1 + record_size; pos < data.size(); pos += record_size) {
+    absl::string_view previous(&data[pos - record_size], tag_size);
+    absl::string_view current(&data[pos], tag_size);
+    int order = previous.compare(current);
+    uint32_t previous_row = LoadBigEndian32(&data[pos - sizeof(uint32_t)]);
+    uint32_t current_row = LoadBigEndian32(&data[pos + tag_size]);
+    if (order > 0 || (order == 0 && previous_row >= current_row)) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "blind index records are not sorted");
+    }
+  }
+  return BlindIndex(tag_size, std::move(data));
+}
+
+util::StatusOr<std::vector<uint32_t>> BlindIndex::Find(
+    const Prf& prf, absl::string_view value) const {
+  auto tag_result = prf.Compute(value, tag_size_);
+  if (!tag_result.ok()) return tag_result.status();
+  const std::string& tag = tag_result.ValueOrDie();
+  if (tag.size() != tag_size_) {
+    return util::Status(util::error::INTERNAL,
+                        "PRF returned an output of unexpected size");
+  }
+  const size_t record_size = RecordSize();
+  auto record_tag = [this, record_size](size_t record) {
+    return absl::string_view(&data_[1 + record * record_size], tag_size_);
+  };
+  // The first record with a tag not less than 'tag'.
+  size_t low = 0;
+  size_t high = size();
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (record_tag(middle) < tag) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  std::vector<uint32_t> rows;
+  for (size_t record = low; record < size() && record_tag(record) == tag;
+       record++) {
+    rows.push_back(
+        LoadBigEndian32(&data_[1 + record * record_size + tag_size_]));
+  }
+  return rows;
+}
+
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,88 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_PRF_BLIND_INDEX_H_
+#define TINK_PRF_BLIND_INDEX_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/prf/prf_set.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+// A blind index of a column of values, e.g. of a column which is stored
+// encrypted: for each row, a tag consisting of the first tag_size() bytes of
+// the PRF of its value, sorted by tag. Rows whose value equals a queried one
+// can then be found without decrypting the column or revealing the values to
+// whoever holds the index.
+//
+// The index is a single string, data(): the tag size as one byte, followed
+// by one record per row, consisting of the tag and the row number as a 4-byte
+// big-endian integer, in ascending order of tag and row number.
+//
+// Shorter tags leak less about which values are equal, but also match more
+// rows of other values; see Prf::Compute() for the choice of the size.
+class BlindIndex {
+ public:
+  // Largest number of rows of an index.
+  static constexpr uint64_t kMaxRows = UINT32_MAX;
+
+  // Builds the index of 'values', where values[i] is the value of row i, with
+  // tags of 'tag_size' bytes. The tags are computed with prf.ComputeBatch() on
+  // chunks of the values, which are then sorted and merged, on the calling
+  // thread and up to num_threads - 1 tasks on util::Executor::Global()
+  // (num_threads values below 1 are treated as 1). 'prf' must be safe for
+  // concurrent use, as the primitives of Tink are.
+  static crypto::tink::util::StatusOr<BlindIndex> Build(
+      const Prf& prf, absl::Span<const absl::string_view> values,
+      size_t tag_size, int num_threads = 1);
+
+  // Returns the index with data() 'data'.
+  static crypto::tink::util::StatusOr<BlindIndex> FromData(std::string data);
+
+  size_t tag_size() const { return tag_size_; }
+  // The number of rows.
+  size_t size() const { return (data_.size() - 1) / RecordSize(); }
+  const std::string& data() const { return data_; }
+
+  // Returns the rows, in ascending order, whose tag equals that of 'value'
+  // under 'prf', which must be the PRF the index was built with. Since tags
+  // are truncated, the values of these rows may still differ from 'value'.
+  crypto::tink::util::StatusOr<std::vector<uint32_t>> Find(
+      const Prf& prf, absl::string_view value) const;
+
+ private:
+  BlindIndex(size_t tag_size, std::string data)
+      : tag_size_(tag_size), data_(std::move(data)) {}
+
+  size_t RecordSize() const { return tag_size_ + sizeof(uint32_t); }
+
+  size_t tag_size_;
+  std::string data_;
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_PRF_BLIND_INDEX_H_
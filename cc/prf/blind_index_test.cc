@@ -0,0 +1,185 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/prf/blind_index.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "openssl/sha.h"
+#include "tink/prf/prf_set.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::testing::Contains;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+// A PRF with unkeyed SHA-256, which is enough to test the index.
+class Sha256Prf : public Prf {
+ public:
+  util::StatusOr<std::string> Compute(absl::string_view input,
+                                      size_t output_length) const override {
+    if (output_length > SHA256_DIGEST_LENGTH) {
+      return util::Status(util::error::INVALID_ARGUMENT, "output too long");
+    }
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const uint8_t*>(input.data()), input.size(),
+           digest);
+    return std::string(reinterpret_cast<const char*>(digest), output_length);
+  }
+};
+
+class FailingPrf : public Prf {
+ public:
+  util::StatusOr<std::string> Compute(absl::string_view input,
+                                      size_t output_length) const override {
+    return util::Status(util::error::INTERNAL, "PRF failed");
+  }
+};
+
+// Values "value 0", ..., "value 999", repeated.
+std::vector<std::string> GetColumn(int num_rows) {
+  std::vector<std::string> column;
+  for (int i = 0; i < num_rows; i++) {
+    column.push_back(absl::StrCat("value ", i % 1000));
+  }
+  return column;
+}
+
+std::vector<absl::string_view> GetViews(
+    const std::vector<std::string>& column) {
+  return std::vector<absl::string_view>(column.begin(), column.end());
+}
+
+TEST(BlindIndexTest, FindsTheRowsOfAValue) {
+  Sha256Prf prf;
+  std::vector<std::string> column = GetColumn(10000);
+  auto index_result = BlindIndex::Build(prf, GetViews(column), 8, 4);
+  ASSERT_THAT(index_result.status(), IsOk());
+  const BlindIndex& index = index_result.ValueOrDie();
+  EXPECT_EQ(8, index.tag_size());
+  EXPECT_EQ(10000, index.size());
+  EXPECT_EQ(1 + 10000 * 12, index.data().size());
+
+  auto rows_result = index.Find(prf, "value 7");
+  ASSERT_THAT(rows_result.status(), IsOk());
+  EXPECT_THAT(rows_result.ValueOrDie(),
+              ElementsAre(7, 1007, 2007, 3007, 4007, 5007, 6007, 7007, 8007,
+                          9007));
+  rows_result = index.Find(prf, "value 1000");
+  ASSERT_THAT(rows_result.status(), IsOk());
+  EXPECT_THAT(rows_result.ValueOrDie(), IsEmpty());
+}
+
+TEST(BlindIndexTest, ShortTagsMatchOtherValues) {
+  Sha256Prf prf;
+  std::vector<std::string> column = GetColumn(1000);
+  auto index_result = BlindIndex::Build(prf, GetViews(column), 1);
+  ASSERT_THAT(index_result.status(), IsOk());
+  auto rows_result = index_result.ValueOrDie().Find(prf, "value 42");
+  ASSERT_THAT(rows_result.status(), IsOk());
+  EXPECT_THAT(rows_result.ValueOrDie(), Contains(42));
+  EXPECT_GT(rows_result.ValueOrDie().size(), 1);
+}
+
+TEST(BlindIndexTest, IndependentOfTheNumberOfThreads) {
+  Sha256Prf prf;
+  std::vector<std::string> column = GetColumn(20000);
+  auto index_result = BlindIndex::Build(prf, GetViews(column), 4, 1);
+  ASSERT_THAT(index_result.status(), IsOk());
+  for (int num_threads : {0, 2, 8}) {
+    auto other_result =
+        BlindIndex::Build(prf, GetViews(column), 4, num_threads);
+    ASSERT_THAT(other_result.status(), IsOk());
+    EXPECT_EQ(index_result.ValueOrDie().data(),
+              other_result.ValueOrDie().data());
+  }
+}
+
+TEST(BlindIndexTest, EmptyColumn) {
+  Sha256Prf prf;
+  auto index_result = BlindIndex::Build(prf, {}, 8);
+  ASSERT_THAT(index_result.status(), IsOk());
+  EXPECT_EQ(0, index_result.ValueOrDie().size());
+  auto rows_result = index_result.ValueOrDie().Find(prf, "value");
+  ASSERT_THAT(rows_result.status(), IsOk());
+  EXPECT_THAT(rows_result.ValueOrDie(), IsEmpty());
+}
+
+TEST(BlindIndexTest, Errors) {
+  Sha256Prf prf;
+  std::vector<std::string> column = GetColumn(10);
+  EXPECT_THAT(BlindIndex::Build(prf, GetViews(column), 0).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(BlindIndex::Build(prf, GetViews(column), 256).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(BlindIndex::Build(prf, GetViews(column), 33).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(BlindIndex::Build(FailingPrf(), GetViews(column), 8).status(),
+              StatusIs(util::error::INTERNAL));
+
+  auto index_result = BlindIndex::Build(prf, GetViews(column), 8);
+  ASSERT_THAT(index_result.status(), IsOk());
+  EXPECT_THAT(
+      index_result.ValueOrDie().Find(FailingPrf(), "value 1").status(),
+      StatusIs(util::error::INTERNAL));
+}
+
+TEST(BlindIndexTest, FromData) {
+  Sha256Prf prf;
+  std::vector<std::string> column = GetColumn(100);
+  auto index_result = BlindIndex::Build(prf, GetViews(column), 8);
+  ASSERT_THAT(index_result.status(), IsOk());
+  const std::string& data = index_result.ValueOrDie().data();
+
+  auto parsed_result = BlindIndex::FromData(data);
+  ASSERT_THAT(parsed_result.status(), IsOk());
+  EXPECT_EQ(100, parsed_result.ValueOrDie().size());
+  auto rows_result = parsed_result.ValueOrDie().Find(prf, "value 3");
+  ASSERT_THAT(rows_result.status(), IsOk());
+  EXPECT_THAT(rows_result.ValueOrDie(), ElementsAre(3));
+
+  EXPECT_THAT(BlindIndex::FromData("").status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(BlindIndex::FromData(std::string(1, '\0')).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(BlindIndex::FromData(data.substr(0, data.size() - 1)).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  // Swaps the first two records.
+  std::string unsorted = data;
+  std::swap_ranges(unsorted.begin() + 1, unsorted.begin() + 13,
+                   unsorted.begin() + 13);
+  EXPECT_THAT(BlindIndex::FromData(unsorted).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -17,13 +17,20 @@
 #ifndef TINK_PRF_HKDF_PRF_KEY_MANAGER_H_
 #define TINK_PRF_HKDF_PRF_KEY_MANAGER_H_
 
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <utility>
 
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tink/core/key_type_manager.h"
 #include "tink/input_stream.h"
 #include "tink/prf/prf_set.h"
+#include "tink/subtle/common_enums.h"
+#include "tink/subtle/hmac_batch.h"
 #include "tink/subtle/prf/hkdf_streaming_prf.h"
 #include "tink/subtle/prf/prf_set_util.h"
 #include "tink/subtle/prf/streaming_prf.h"
@@ -41,6 +48,34 @@
 
 namespace crypto {
 namespace tink {
+namespace internal {
+
+// The HKDF PRF. Compute() goes through HkdfStreamingPrf, while ComputeBatch()
+// runs HKDF-Expand with the keyed HMAC states of a subtle::HmacBatch, so that
+// neither HKDF-Extract nor the HMAC key schedule is repeated per input.
+class HkdfPrf : public Prf {
+ public:
+  HkdfPrf(std::unique_ptr<Prf> prf, std::unique_ptr<subtle::HmacBatch> hkdf)
+      : prf_(std::move(prf)), hkdf_(std::move(hkdf)) {}
+
+  util::StatusOr<std::string> Compute(absl::string_view input,
+                                      size_t output_length) const override {
+    return prf_->Compute(input, output_length);
+  }
+
+  using Prf::ComputeBatch;
+  util::Status ComputeBatch(absl::Span<const absl::string_view> inputs,
+                            size_t output_length,
+                            absl::Span<uint8_t> out) const override {
+    return hkdf_->HkdfExpand(inputs, output_length, out);
+  }
+
+ private:
+  const std::unique_ptr<Prf> prf_;
+  const std::unique_ptr<subtle::HmacBatch> hkdf_;
+};
+
+}  // namespace internal
 
 class HkdfPrfKeyManager
     : public KeyTypeManager<google::crypto::tink::HkdfPrfKey,
@@ -59,14 +94,23 @@ class HkdfPrfKeyManager
   class PrfSetFactory : public PrimitiveFactory<Prf> {
     crypto::tink::util::StatusOr<std::unique_ptr<Prf>> Create(
         const google::crypto::tink::HkdfPrfKey& key) const override {
-      auto hkdf_result = subtle::HkdfStreamingPrf::New(
-          crypto::tink::util::Enums::ProtoToSubtle(key.params().hash()),
-          util::SecretDataFromStringView(key.key_value()), key.params().salt());
+      subtle::HashType hash =
+          crypto::tink::util::Enums::ProtoToSubtle(key.params().hash());
+      util::SecretData secret = util::SecretDataFromStringView(key.key_value());
+      auto hkdf_result =
+          subtle::HkdfStreamingPrf::New(hash, secret, key.params().salt());
       if (!hkdf_result.ok()) {
         return hkdf_result.status();
       }
-      return subtle::CreatePrfFromStreamingPrf(
-          std::move(hkdf_result.ValueOrDie()));
+      auto hkdf_batch_result =
+          subtle::HmacBatch::NewHkdf(hash, secret, key.params().salt());
+      if (!hkdf_batch_result.ok()) {
+        return hkdf_batch_result.status();
+      }
+      return {absl::make_unique<internal::HkdfPrf>(
+          subtle::CreatePrfFromStreamingPrf(
+              std::move(hkdf_result.ValueOrDie())),
+          std::move(hkdf_batch_result.ValueOrDie()))};
     }
   };
 
@@ -17,14 +17,21 @@
 #define TINK_PRF_HMAC_PRF_KEY_MANAGER_H_
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tink/core/key_type_manager.h"
 #include "tink/key_manager.h"
+#include "tink/prf/prf_set.h"
 #include "tink/subtle/common_enums.h"
+#include "tink/subtle/hmac_batch.h"
 #include "tink/subtle/prf/prf_set_util.h"
 #include "tink/subtle/random.h"
 #include "tink/subtle/stateful_hmac_boringssl.h"
@@ -41,6 +48,40 @@
 
 namespace crypto {
 namespace tink {
+namespace internal {
+
+// The HMAC PRF. Compute() goes through StatefulHmacBoringSsl, while
+// ComputeBatch() reuses the keyed HMAC states of a subtle::HmacBatch.
+class HmacPrf : public Prf {
+ public:
+  HmacPrf(std::unique_ptr<Prf> prf, std::unique_ptr<subtle::HmacBatch> hmac)
+      : prf_(std::move(prf)), hmac_(std::move(hmac)) {}
+
+  util::StatusOr<std::string> Compute(absl::string_view input,
+                                      size_t output_length) const override {
+    return prf_->Compute(input, output_length);
+  }
+
+  using Prf::ComputeBatch;
+  util::Status ComputeBatch(absl::Span<const absl::string_view> inputs,
+                            size_t output_length,
+                            absl::Span<uint8_t> out) const override {
+    if (output_length > hmac_->digest_size()) {
+      return util::Status(
+          util::error::INVALID_ARGUMENT,
+          absl::StrCat("PRF only supports outputs up to ",
+                       hmac_->digest_size(), " bytes, but ", output_length,
+                       " bytes were requested"));
+    }
+    return hmac_->Compute(inputs, output_length, out);
+  }
+
+ private:
+  const std::unique_ptr<Prf> prf_;
+  const std::unique_ptr<subtle::HmacBatch> hmac_;
+};
+
+}  // namespace internal
 
 class HmacPrfKeyManager
     : public KeyTypeManager<google::crypto::tink::HmacPrfKey,
@@ -49,11 +90,16 @@ class HmacPrfKeyManager
   class PrfFactory : public PrimitiveFactory<Prf> {
     crypto::tink::util::StatusOr<std::unique_ptr<Prf>> Create(
         const google::crypto::tink::HmacPrfKey& key) const override {
-      return subtle::CreatePrfFromStatefulMacFactory(
-          absl::make_unique<subtle::StatefulHmacBoringSslFactory>(
-              util::Enums::ProtoToSubtle(key.params().hash()),
-              MaxOutputLength(util::Enums::ProtoToSubtle(key.params().hash())),
-              util::SecretDataFromStringView(key.key_value())));
+      subtle::HashType hash = util::Enums::ProtoToSubtle(key.params().hash());
+      util::SecretData key_value =
+          util::SecretDataFromStringView(key.key_value());
+      auto hmac_result = subtle::HmacBatch::New(hash, key_value);
+      if (!hmac_result.ok()) return hmac_result.status();
+      return {absl::make_unique<internal::HmacPrf>(
+          subtle::CreatePrfFromStatefulMacFactory(
+              absl::make_unique<subtle::StatefulHmacBoringSslFactory>(
+                  hash, MaxOutputLength(hash), key_value)),
+          std::move(hmac_result.ValueOrDie()))};
     }
   };
 
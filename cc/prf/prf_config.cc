@@ -21,6 +21,7 @@
 #include "tink/prf/hmac_prf_key_manager.h"
 #include "tink/prf/prf_set_wrapper.h"
 #include "tink/registry.h"
+#include "tink/subtle/prf/streaming_prf_wrapper.h"
 #include "tink/util/status.h"
 
 namespace crypto {
@@ -31,6 +32,9 @@ crypto::tink::util::Status PrfConfig::Register() {
   auto status =
       Registry::RegisterPrimitiveWrapper(absl::make_unique<PrfSetWrapper>());
   if (!status.ok()) return status;
+  status = Registry::RegisterPrimitiveWrapper(
+      absl::make_unique<StreamingPrfWrapper>());
+  if (!status.ok()) return status;
 
   status = Registry::RegisterKeyTypeManager(
       absl::make_unique<HmacPrfKeyManager>(), true);
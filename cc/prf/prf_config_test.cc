@@ -26,6 +26,8 @@
 #include "tink/prf/prf_key_templates.h"
 #include "tink/prf/prf_set.h"
 #include "tink/registry.h"
+#include "tink/subtle/prf/streaming_prf.h"
+#include "tink/util/input_stream_util.h"
 #include "tink/util/status.h"
 #include "tink/util/test_matchers.h"
 #include "tink/util/test_util.h"
@@ -56,6 +58,25 @@ TEST_F(PrfConfigTest, RegisterWorks) {
               IsOk());
 }
 
+TEST_F(PrfConfigTest, StreamingPrfFromHkdfKeyset) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+
+  ASSERT_THAT(PrfConfig::Register(), IsOk());
+  auto keyset_handle_result =
+      KeysetHandle::GenerateNew(PrfKeyTemplates::HkdfSha256());
+  ASSERT_THAT(keyset_handle_result.status(), IsOk());
+  auto streaming_prf_result =
+      keyset_handle_result.ValueOrDie()->GetPrimitive<StreamingPrf>();
+  ASSERT_THAT(streaming_prf_result.status(), IsOk());
+  EXPECT_THAT(ReadBytesFromStream(
+                  32, streaming_prf_result.ValueOrDie()->ComputePrf("input")
+                          .get())
+                  .status(),
+              IsOk());
+}
+
 // FIPS-only mode tests
 TEST_F(PrfConfigTest, RegisterNonFipsTemplates) {
   if (!kUseOnlyFips || !FIPS_mode()) {
@@ -16,18 +16,77 @@
 
 #include "tink/prf/prf_set.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/subtle/subtle_util.h"
+#include "tink/util/status.h"
+
 namespace crypto {
 namespace tink {
 
+util::Status Prf::ComputeBatch(absl::Span<const absl::string_view> inputs,
+                               size_t output_length,
+                               absl::Span<uint8_t> out) const {
+  if (out.size() != inputs.size() * output_length) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "invalid size of the output buffer");
+  }
+  for (size_t i = 0; i < inputs.size(); i++) {
+    auto output_result = Compute(inputs[i], output_length);
+    if (!output_result.ok()) return output_result.status();
+    const std::string& output = output_result.ValueOrDie();
+    if (output.size() != output_length) {
+      return util::Status(util::error::INTERNAL,
+                          "PRF returned an output of unexpected size");
+    }
+    std::copy(output.begin(), output.end(), out.data() + i * output_length);
+  }
+  return util::Status::OK;
+}
+
+util::Status Prf::ComputeBatch(absl::Span<const absl::string_view> inputs,
+                               size_t output_length,
+                               std::string* outputs) const {
+  subtle::ResizeStringUninitialized(outputs, inputs.size() * output_length);
+  util::Status status = ComputeBatch(
+      inputs, output_length,
+      absl::MakeSpan(reinterpret_cast<uint8_t*>(&(*outputs)[0]),
+                     outputs->size()));
+  if (!status.ok()) outputs->clear();
+  return status;
+}
+
+Prf* PrfSet::GetPrf(uint32_t key_id) const {
+  const std::map<uint32_t, Prf*>& prfs = GetPrfs();
+  auto prf_it = prfs.find(key_id);
+  if (prf_it == prfs.end()) return nullptr;
+  return prf_it->second;
+}
+
 util::StatusOr<std::string> PrfSet::ComputePrimary(absl::string_view input,
                                                    size_t output_length) const {
-  auto prfs = GetPrfs();
-  auto prf_it = prfs.find(GetPrimaryId());
-  if (prf_it == prfs.end()) {
+  Prf* prf = GetPrf(GetPrimaryId());
+  if (prf == nullptr) {
+    return util::Status(util::error::INTERNAL,
+                        "PrfSet has no PRF for primary ID.");
+  }
+  return prf->Compute(input, output_length);
+}
+
+util::Status PrfSet::ComputePrimaryBatch(
+    absl::Span<const absl::string_view> inputs, size_t output_length,
+    std::string* outputs) const {
+  Prf* prf = GetPrf(GetPrimaryId());
+  if (prf == nullptr) {
     return util::Status(util::error::INTERNAL,
                         "PrfSet has no PRF for primary ID.");
   }
-  return prf_it->second->Compute(input, output_length);
+  return prf->ComputeBatch(inputs, output_length, outputs);
 }
 
 }  // namespace tink
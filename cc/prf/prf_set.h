@@ -17,9 +17,13 @@
 #ifndef TINK_PRF_PRF_SET_H_
 #define TINK_PRF_PRF_SET_H_
 
+#include <cstdint>
 #include <map>
+#include <string>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
 namespace crypto {
@@ -58,6 +62,21 @@ class Prf {
   // algorithm is less than outputLength.
   virtual util::StatusOr<std::string> Compute(absl::string_view input,
                                               size_t output_length) const = 0;
+  // Computes the PRF on each of 'inputs', and writes the first output_length
+  // bytes of each result back to back into 'out', i.e. the output for
+  // inputs[i] are the bytes [i * output_length, (i + 1) * output_length).
+  // 'out' must hold exactly inputs.size() * output_length bytes.
+  // Fails as a whole if any of the outputs cannot be computed.
+  // Implementations should override this method if they can reuse keyed state
+  // across inputs or process several inputs concurrently; the default
+  // implementation calls Compute() for each input.
+  virtual util::Status ComputeBatch(absl::Span<const absl::string_view> inputs,
+                                    size_t output_length,
+                                    absl::Span<uint8_t> out) const;
+  // As above, but resizes 'outputs' to inputs.size() * output_length bytes
+  // and writes the outputs into it.
+  util::Status ComputeBatch(absl::Span<const absl::string_view> inputs,
+                            size_t output_length, std::string* outputs) const;
 };
 
 // A Tink Keyset can be converted into a set of PRFs using this primitive. Every
@@ -72,10 +91,19 @@ class PrfSet {
   // A map of the PRFs represented by the keys in this keyset.
   // The map is guaranteed to contain getPrimaryId() as a key.
   virtual const std::map<uint32_t, Prf*>& GetPrfs() const = 0;
+  // Returns the PRF with ID 'key_id', or nullptr if there is none.
+  // Implementations should override this method with a lookup cheaper than
+  // the search in GetPrfs() done by the default implementation.
+  virtual Prf* GetPrf(uint32_t key_id) const;
   // Convenience method to compute the primary PRF on a given input.
   // See PRF.compute for details of the parameters.
   util::StatusOr<std::string> ComputePrimary(absl::string_view input,
                                              size_t output_length) const;
+  // Convenience method to compute the primary PRF on a batch of inputs.
+  // See Prf::ComputeBatch for details of the parameters.
+  util::Status ComputePrimaryBatch(absl::Span<const absl::string_view> inputs,
+                                   size_t output_length,
+                                   std::string* outputs) const;
 };
 
 }  // namespace tink
@@ -17,16 +17,20 @@
 #include "tink/prf/prf_set.h"
 
 #include <map>
+#include <string>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tink/keyset_handle.h"
 #include "tink/keyset_manager.h"
 #include "tink/prf/prf_config.h"
 #include "tink/prf/prf_key_templates.h"
+#include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "tink/util/test_matchers.h"
 #include "tink/util/test_util.h"
@@ -83,6 +87,64 @@ TEST(PrfSetTest, ComputePrimary) {
       << "Expected broken PrfSet to not be able to compute the primary PRF";
 }
 
+TEST(PrfSetTest, DefaultGetPrf) {
+  DummyPrfSet prfset;
+  EXPECT_THAT(prfset.GetPrf(1), Eq(prfset.GetPrfs().at(1)));
+  EXPECT_THAT(prfset.GetPrf(2), Eq(nullptr));
+  EXPECT_THAT(BrokenDummyPrfSet().GetPrf(1), Eq(nullptr));
+}
+
+TEST(PrfSetTest, DefaultComputeBatch) {
+  DummyPrf prf;
+  std::vector<absl::string_view> inputs = {"a", "b", "c"};
+  std::vector<uint8_t> out(3 * 8);
+  EXPECT_THAT(prf.ComputeBatch(inputs, 8, absl::MakeSpan(out)), IsOk());
+  EXPECT_THAT(std::string(out.begin(), out.end()),
+              StrEq("DummyPRFDummyPRFDummyPRF"));
+  EXPECT_FALSE(prf.ComputeBatch(inputs, 7, absl::MakeSpan(out)).ok());
+  std::string outputs;
+  EXPECT_THAT(prf.ComputeBatch(inputs, 8, &outputs), IsOk());
+  EXPECT_THAT(outputs, StrEq("DummyPRFDummyPRFDummyPRF"));
+}
+
+TEST(PrfSetTest, ComputeBatchMatchesCompute) {
+  ASSERT_THAT(PrfConfig::Register(), IsOk());
+  auto keyset_manager_result =
+      KeysetManager::New(PrfKeyTemplates::HkdfSha256());
+  ASSERT_THAT(keyset_manager_result.status(), IsOk());
+  auto keyset_manager = std::move(keyset_manager_result.ValueOrDie());
+  ASSERT_THAT(keyset_manager->Add(PrfKeyTemplates::HmacSha256()).status(),
+              IsOk());
+  ASSERT_THAT(keyset_manager->Add(PrfKeyTemplates::HmacSha512()).status(),
+              IsOk());
+  ASSERT_THAT(keyset_manager->Add(PrfKeyTemplates::AesCmac()).status(),
+              IsOk());
+  auto prf_set_result =
+      keyset_manager->GetKeysetHandle()->GetPrimitive<PrfSet>();
+  ASSERT_THAT(prf_set_result.status(), IsOk());
+  std::vector<std::string> inputs;
+  for (int i = 0; i < 20; i++) inputs.push_back(std::string(7 * i, 'x'));
+  std::vector<absl::string_view> views(inputs.begin(), inputs.end());
+  for (auto prf : prf_set_result.ValueOrDie()->GetPrfs()) {
+    for (size_t output_length : {1, 16, 17, 32, 64, 100}) {
+      SCOPED_TRACE(absl::StrCat("Computing prf ", prf.first,
+                                " with output_length ", output_length));
+      std::vector<uint8_t> out(inputs.size() * output_length);
+      util::Status status =
+          prf.second->ComputeBatch(views, output_length, absl::MakeSpan(out));
+      EXPECT_THAT(status.ok(), Eq(prf.second->Compute("", output_length).ok()));
+      if (!status.ok()) continue;
+      for (size_t i = 0; i < inputs.size(); i++) {
+        auto output_result = prf.second->Compute(inputs[i], output_length);
+        ASSERT_THAT(output_result.status(), IsOk());
+        EXPECT_THAT(std::string(out.begin() + i * output_length,
+                                out.begin() + (i + 1) * output_length),
+                    StrEq(output_result.ValueOrDie()));
+      }
+    }
+  }
+}
+
 TEST(PrfSetWrapperTest, TestPrimitivesEndToEnd) {
   auto status = PrfConfig::Register();
   ASSERT_TRUE(status.ok()) << status;
@@ -15,7 +15,15 @@
 ///////////////////////////////////////////////////////////////////////////////
 #include "tink/prf/prf_set_wrapper.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
 #include "absl/memory/memory.h"
+#include "absl/types/span.h"
+#include "tink/monitoring_client.h"
 #include "tink/util/status.h"
 #include "proto/tink.pb.h"
 
@@ -26,25 +34,76 @@ using google::crypto::tink::OutputPrefixType;
 
 namespace {
 
+// Reports the operations of the PRF of one key to the monitoring client.
+class MonitoredPrf : public Prf {
+ public:
+  MonitoredPrf(const Prf* prf, uint32_t key_id) : prf_(prf), key_id_(key_id) {}
+
+  util::StatusOr<std::string> Compute(absl::string_view input,
+                                      size_t output_length) const override {
+    internal::MonitoredOperation monitored("prf", "compute", input.size());
+    auto result = prf_->Compute(input, output_length);
+    if (result.ok()) monitored.Success(key_id_);
+    return result;
+  }
+
+  using Prf::ComputeBatch;
+  util::Status ComputeBatch(absl::Span<const absl::string_view> inputs,
+                            size_t output_length,
+                            absl::Span<uint8_t> out) const override {
+    int64_t num_bytes = 0;
+    for (absl::string_view input : inputs) num_bytes += input.size();
+    internal::MonitoredOperation monitored("prf", "compute_batch", num_bytes);
+    util::Status status = prf_->ComputeBatch(inputs, output_length, out);
+    if (status.ok()) monitored.Success(key_id_);
+    return status;
+  }
+
+ private:
+  const Prf* prf_;
+  const uint32_t key_id_;
+};
+
 class PrfSetPrimitiveWrapper : public PrfSet {
  public:
   explicit PrfSetPrimitiveWrapper(std::unique_ptr<PrimitiveSet<Prf>> prf_set)
-      : prf_set_(std::move(prf_set)) {
+      : prf_set_(std::move(prf_set)),
+        primary_id_(prf_set_->get_primary()->get_key_id()) {
     for (const auto& prf : *prf_set_->get_raw_primitives().ValueOrDie()) {
-      prfs_.insert({prf->get_key_id(), &prf->get_primitive()});
+      monitored_prfs_.push_back(absl::make_unique<MonitoredPrf>(
+          &prf->get_primitive(), prf->get_key_id()));
+      prfs_.insert({prf->get_key_id(), monitored_prfs_.back().get()});
     }
+    // The map has unique keys and is ordered by them, so the vector is sorted
+    // by key ID as well.
+    sorted_prfs_.assign(prfs_.begin(), prfs_.end());
+    primary_prf_ = prfs_.at(primary_id_);
   }
 
-  uint32_t GetPrimaryId() const override {
-    return prf_set_->get_primary()->get_key_id();
-  }
+  uint32_t GetPrimaryId() const override { return primary_id_; }
   const std::map<uint32_t, Prf*>& GetPrfs() const override { return prfs_; }
 
+  Prf* GetPrf(uint32_t key_id) const override {
+    if (key_id == primary_id_) return primary_prf_;
+    auto it = std::lower_bound(
+        sorted_prfs_.begin(), sorted_prfs_.end(), key_id,
+        [](const std::pair<uint32_t, Prf*>& entry, uint32_t id) {
+          return entry.first < id;
+        });
+    if (it == sorted_prfs_.end() || it->first != key_id) return nullptr;
+    return it->second;
+  }
+
   ~PrfSetPrimitiveWrapper() override {}
 
  private:
   std::unique_ptr<PrimitiveSet<Prf>> prf_set_;
+  std::vector<std::unique_ptr<MonitoredPrf>> monitored_prfs_;
+  const uint32_t primary_id_;
   std::map<uint32_t, Prf*> prfs_;
+  // The contents of prfs_ in a contiguous array, for GetPrf().
+  std::vector<std::pair<uint32_t, Prf*>> sorted_prfs_;
+  Prf* primary_prf_;
 };
 
 util::Status Validate(PrimitiveSet<Prf>* prf_set) {
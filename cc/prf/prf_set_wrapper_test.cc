@@ -22,6 +22,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "tink/prf/prf_set.h"
 #include "tink/primitive_set.h"
@@ -38,9 +39,12 @@ using ::crypto::tink::test::IsOkAndHolds;
 using ::google::crypto::tink::Keyset;
 using ::google::crypto::tink::KeysetInfo;
 using ::google::crypto::tink::KeyStatusType;
+using ::testing::Eq;
+using ::testing::IsNull;
 using ::testing::Key;
 using ::testing::NiceMock;
 using ::testing::Not;
+using ::testing::NotNull;
 using ::testing::Return;
 using ::testing::ReturnRef;
 using ::testing::StrEq;
@@ -137,6 +141,34 @@ TEST_F(PrfSetWrapperTest, WrapTwo) {
               IsOkAndHolds(StrEq("different")));
 }
 
+TEST_F(PrfSetWrapperTest, GetPrf) {
+  auto entry = AddPrf("primary", MakeKey(50));
+  ASSERT_THAT(entry.status(), IsOk());
+  ASSERT_THAT(PrfSet()->set_primary(entry.ValueOrDie()), IsOk());
+  for (uint32_t id = 0; id < 100; id += 3) {
+    ASSERT_THAT(AddPrf(absl::StrCat("output", id), MakeKey(id)).status(),
+                IsOk());
+  }
+  PrfSetWrapper wrapper;
+  auto wrapped_or = wrapper.Wrap(std::move(PrfSet()));
+  ASSERT_THAT(wrapped_or.status(), IsOk());
+  auto wrapped = std::move(wrapped_or.ValueOrDie());
+  for (uint32_t id = 0; id < 100; id++) {
+    Prf* prf = wrapped->GetPrf(id);
+    auto prf_it = wrapped->GetPrfs().find(id);
+    if (prf_it == wrapped->GetPrfs().end()) {
+      EXPECT_THAT(prf, IsNull());
+    } else {
+      EXPECT_THAT(prf, Eq(prf_it->second));
+    }
+  }
+  ASSERT_THAT(wrapped->GetPrf(50), NotNull());
+  EXPECT_THAT(wrapped->GetPrf(50)->Compute("input", 7),
+              IsOkAndHolds(StrEq("primary")));
+  EXPECT_THAT(wrapped->GetPrf(51)->Compute("input", 8),
+              IsOkAndHolds(StrEq("output51")));
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
@@ -17,12 +17,21 @@
 #ifndef TINK_PRIMITIVE_SET_H_
 #define TINK_PRIMITIVE_SET_H_
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "absl/base/call_once.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
 #include "absl/synchronization/mutex.h"
 #include "tink/crypto_format.h"
+#include "tink/internal/key_prefix_index.h"
+#include "tink/internal/memory_usage.h"
 #include "tink/util/errors.h"
 #include "tink/util/statusor.h"
 #include "proto/tink.pb.h"
@@ -46,6 +55,18 @@ namespace tink {
 // the set is used, and upon decryption the ciphertext's prefix
 // determines the identifier of the primitive from the set.
 //
+// A PrimitiveSet can be frozen once it is fully populated, which makes it
+// immutable and lets lookups proceed without taking a lock. Sets handed to
+// a PrimitiveWrapper by the Registry are frozen. Reading a frozen set writes
+// no memory shared with other readers: no lock is taken and no reference
+// count is changed. This keeps the pages of sets built before fork() shared
+// between the processes of a prefork server, see warmup.h.
+//
+// Entries can also be lazy: they hold a factory instead of a primitive, and
+// create the primitive the first time it is requested. Only wrappers which
+// return true from PrimitiveWrapper::SupportsLazyPrimitives() receive sets
+// with lazy entries from the Registry, and the primary is never lazy.
+//
 // PrimitiveSet is a public class to allow its use in implementations
 // of custom primitives.
 template <class P>
@@ -55,8 +76,10 @@ class PrimitiveSet {
   template <class P2>
   class Entry {
    public:
+    // 'primitive' may be shared with other entries and sets, e.g. when the
+    // Registry interns primitives; it must then be safe for concurrent use.
     static crypto::tink::util::StatusOr<std::unique_ptr<Entry<P>>> New(
-        std::unique_ptr<P> primitive,
+        std::shared_ptr<P> primitive,
         const google::crypto::tink::KeysetInfo::KeyInfo& key_info) {
       if (key_info.status() != google::crypto::tink::KeyStatusType::ENABLED) {
         return util::Status(crypto::tink::util::error::INVALID_ARGUMENT,
@@ -74,7 +97,83 @@ class PrimitiveSet {
                                         key_info.output_prefix_type()));
     }
 
-    P2& get_primitive() const { return *primitive_; }
+    // Creates a lazy entry, whose primitive is created by 'factory' when it
+    // is first requested. 'factory' is called at most once, possibly
+    // concurrently with other methods of this entry.
+    static crypto::tink::util::StatusOr<std::unique_ptr<Entry<P>>> NewLazy(
+        std::function<crypto::tink::util::StatusOr<std::unique_ptr<P2>>()>
+            factory,
+        const google::crypto::tink::KeysetInfo::KeyInfo& key_info) {
+      if (key_info.status() != google::crypto::tink::KeyStatusType::ENABLED) {
+        return util::Status(crypto::tink::util::error::INVALID_ARGUMENT,
+                            "The key must be ENABLED.");
+      }
+      auto identifier_result = CryptoFormat::GetOutputPrefix(key_info);
+      if (!identifier_result.ok()) return identifier_result.status();
+      if (!factory) {
+        return util::Status(crypto::tink::util::error::INVALID_ARGUMENT,
+                            "The factory must be non-null.");
+      }
+      return NewLazyShared(
+          [factory]() -> crypto::tink::util::StatusOr<std::shared_ptr<P2>> {
+            auto primitive_result = factory();
+            if (!primitive_result.ok()) return primitive_result.status();
+            return std::shared_ptr<P2>(
+                std::move(primitive_result.ValueOrDie()));
+          },
+          key_info);
+    }
+
+    // Same as NewLazy(), but the primitive created by 'factory' may be shared.
+    static crypto::tink::util::StatusOr<std::unique_ptr<Entry<P>>>
+    NewLazyShared(
+        std::function<crypto::tink::util::StatusOr<std::shared_ptr<P2>>()>
+            factory,
+        const google::crypto::tink::KeysetInfo::KeyInfo& key_info) {
+      if (key_info.status() != google::crypto::tink::KeyStatusType::ENABLED) {
+        return util::Status(crypto::tink::util::error::INVALID_ARGUMENT,
+                            "The key must be ENABLED.");
+      }
+      auto identifier_result = CryptoFormat::GetOutputPrefix(key_info);
+      if (!identifier_result.ok()) return identifier_result.status();
+      if (!factory) {
+        return util::Status(crypto::tink::util::error::INVALID_ARGUMENT,
+                            "The factory must be non-null.");
+      }
+      std::unique_ptr<Entry<P>> entry(new Entry(
+          nullptr, identifier_result.ValueOrDie(), key_info.status(),
+          key_info.key_id(), key_info.output_prefix_type()));
+      entry->factory_ = std::move(factory);
+      return std::move(entry);
+    }
+
+    // Returns the primitive of this entry. For a lazy entry the primitive is
+    // created on the first call; wrappers that accept lazy entries must use
+    // GetOrCreatePrimitive() instead, since this aborts if creation fails.
+    P2& get_primitive() const {
+      if (!factory_) return *primitive_;
+      return *GetOrCreatePrimitive().ValueOrDie();
+    }
+
+    // Returns the primitive of this entry, creating it first if the entry is
+    // lazy. If the creation fails, the error is returned by this and all later
+    // calls. Thread-safe.
+    crypto::tink::util::StatusOr<P2*> GetOrCreatePrimitive() const {
+      if (!factory_) return primitive_.get();
+      absl::call_once(create_once_, [this]() {
+        auto primitive_result = factory_();
+        if (primitive_result.ok()) {
+          primitive_ = std::move(primitive_result.ValueOrDie());
+        } else {
+          create_status_ = primitive_result.status();
+        }
+      });
+      if (!create_status_.ok()) return create_status_;
+      return primitive_.get();
+    }
+
+    // Returns true if this entry was created by NewLazy().
+    bool is_lazy() const { return static_cast<bool>(factory_); }
 
     const std::string& get_identifier() const { return identifier_; }
 
@@ -87,7 +186,7 @@ class PrimitiveSet {
     }
 
    private:
-    Entry(std::unique_ptr<P2> primitive, const std::string& identifier,
+    Entry(std::shared_ptr<P2> primitive, const std::string& identifier,
           google::crypto::tink::KeyStatusType status, uint32_t key_id,
           google::crypto::tink::OutputPrefixType output_prefix_type)
         : primitive_(std::move(primitive)),
@@ -96,7 +195,13 @@ class PrimitiveSet {
           key_id_(key_id),
           output_prefix_type_(output_prefix_type) {}
 
-    std::unique_ptr<P> primitive_;
+    // For lazy entries, written once under create_once_.
+    mutable std::shared_ptr<P> primitive_;
+    // Empty unless this entry is lazy.
+    std::function<crypto::tink::util::StatusOr<std::shared_ptr<P2>>()>
+        factory_;
+    mutable absl::once_flag create_once_;
+    mutable crypto::tink::util::Status create_status_;
     std::string identifier_;
     google::crypto::tink::KeyStatusType status_;
     uint32_t key_id_;
@@ -106,32 +211,60 @@ class PrimitiveSet {
   typedef std::vector<std::unique_ptr<Entry<P>>> Primitives;
 
   // Constructs an empty PrimitiveSet.
-  PrimitiveSet<P>() : primary_(nullptr) {}
+  PrimitiveSet<P>() : primary_(nullptr), frozen_(false) {}
 
   // Adds 'primitive' to this set for the specified 'key'.
+  // Fails if the set is frozen.
   crypto::tink::util::StatusOr<Entry<P>*> AddPrimitive(
       std::unique_ptr<P> primitive,
       const google::crypto::tink::KeysetInfo::KeyInfo& key_info) {
     auto entry_or = Entry<P>::New(std::move(primitive), key_info);
     if (!entry_or.ok()) return entry_or.status();
+    return AddEntry(std::move(entry_or.ValueOrDie()));
+  }
 
-    absl::MutexLock lock(&primitives_mutex_);
-    std::string identifier = entry_or.ValueOrDie()->get_identifier();
-    primitives_[identifier].push_back(std::move(entry_or.ValueOrDie()));
-    return primitives_[identifier].back().get();
+  // Same as AddPrimitive(), but 'primitive' may also be used elsewhere, so it
+  // must be safe for concurrent use. Fails if the set is frozen.
+  crypto::tink::util::StatusOr<Entry<P>*> AddSharedPrimitive(
+      std::shared_ptr<P> primitive,
+      const google::crypto::tink::KeysetInfo::KeyInfo& key_info) {
+    auto entry_or = Entry<P>::New(std::move(primitive), key_info);
+    if (!entry_or.ok()) return entry_or.status();
+    return AddEntry(std::move(entry_or.ValueOrDie()));
+  }
+
+  // Adds a lazy entry for the specified 'key' to this set, which calls
+  // 'factory' to create its primitive when it is first requested. Lazy
+  // entries cannot be the primary. Fails if the set is frozen.
+  crypto::tink::util::StatusOr<Entry<P>*> AddLazyPrimitive(
+      std::function<crypto::tink::util::StatusOr<std::unique_ptr<P>>()>
+          factory,
+      const google::crypto::tink::KeysetInfo::KeyInfo& key_info) {
+    auto entry_or = Entry<P>::NewLazy(std::move(factory), key_info);
+    if (!entry_or.ok()) return entry_or.status();
+    return AddEntry(std::move(entry_or.ValueOrDie()));
+  }
+
+  // Same as AddLazyPrimitive(), but the primitive created by 'factory' may be
+  // shared. Fails if the set is frozen.
+  crypto::tink::util::StatusOr<Entry<P>*> AddLazySharedPrimitive(
+      std::function<crypto::tink::util::StatusOr<std::shared_ptr<P>>()>
+          factory,
+      const google::crypto::tink::KeysetInfo::KeyInfo& key_info) {
+    auto entry_or = Entry<P>::NewLazyShared(std::move(factory), key_info);
+    if (!entry_or.ok()) return entry_or.status();
+    return AddEntry(std::move(entry_or.ValueOrDie()));
   }
 
   // Returns the entries with primitives identifed by 'identifier'.
   crypto::tink::util::StatusOr<const Primitives*> get_primitives(
       absl::string_view identifier) {
-    absl::MutexLock lock(&primitives_mutex_);
-    typename CiphertextPrefixToPrimitivesMap::iterator found =
-        primitives_.find(std::string(identifier));
-    if (found == primitives_.end()) {
+    const Primitives* found = find_primitives(identifier);
+    if (found == nullptr) {
       return ToStatusF(crypto::tink::util::error::NOT_FOUND,
                        "No primitives found for identifier '%s'.", identifier);
     }
-    return &(found->second);
+    return found;
   }
 
   // Returns all primitives that use RAW prefix.
@@ -139,8 +272,34 @@ class PrimitiveSet {
     return get_primitives(CryptoFormat::kRawPrefix);
   }
 
+  // Like get_primitives(), but returns nullptr if there are no entries for
+  // 'identifier'. Does not allocate: no error status is built for a miss,
+  // and identifiers of CryptoFormat::kNonRawPrefixSize bytes fit into the
+  // inline buffer of the std::string the lookup needs. Meant for the decrypt
+  // paths of the wrappers, where misses are expected.
+  const Primitives* find_primitives(absl::string_view identifier) {
+    if (frozen_.load(std::memory_order_acquire)) {
+      return frozen_index_.Find(identifier);
+    }
+    absl::MutexLock lock(&primitives_mutex_);
+    typename CiphertextPrefixToPrimitivesMap::iterator found =
+        primitives_.find(std::string(identifier));
+    if (found == primitives_.end()) return nullptr;
+    return &(found->second);
+  }
+
+  // Like get_raw_primitives(), but returns nullptr if there are none.
+  const Primitives* find_raw_primitives() {
+    return find_primitives(CryptoFormat::kRawPrefix);
+  }
+
   // Sets the given 'primary' as the primary primitive of this set.
+  // Fails if the set is frozen.
   crypto::tink::util::Status set_primary(Entry<P>* primary) {
+    if (is_frozen()) {
+      return util::Status(crypto::tink::util::error::FAILED_PRECONDITION,
+                          "Cannot change the primary of a frozen set.");
+    }
     if (!primary) {
       return util::Status(crypto::tink::util::error::INVALID_ARGUMENT,
                           "The primary primitive must be non-null.");
@@ -149,6 +308,10 @@ class PrimitiveSet {
       return util::Status(crypto::tink::util::error::INVALID_ARGUMENT,
                           "Primary has to be enabled.");
     }
+    if (primary->is_lazy()) {
+      return util::Status(crypto::tink::util::error::INVALID_ARGUMENT,
+                          "Primary cannot be a lazy entry.");
+    }
     auto entries_result = get_primitives(primary->get_identifier());
     if (!entries_result.ok()) {
       return util::Status(crypto::tink::util::error::INVALID_ARGUMENT,
@@ -163,8 +326,10 @@ class PrimitiveSet {
   // Returns the entry with the primary primitive.
   const Entry<P>* get_primary() const { return primary_; }
 
-  // Returns all entries currently in this primitive set.
+  // Returns all entries currently in this primitive set. For frozen sets the
+  // entries are copied from a list made by Freeze(), without locking.
   const std::vector<Entry<P>*> get_all() const {
+    if (is_frozen()) return frozen_all_;
     absl::MutexLock lock(&primitives_mutex_);
     std::vector<Entry<P>*> result;
     for (const auto& prefix_and_vector : primitives_) {
@@ -175,13 +340,91 @@ class PrimitiveSet {
     return result;
   }
 
+  // Makes this set immutable. Afterwards AddPrimitive() and set_primary()
+  // fail, and get_primitives() is served from a compact index keyed by the
+  // packed output prefix, without locking, as is get_all(). Freezing an
+  // already frozen set has no effect.
+  void Freeze() {
+    absl::MutexLock lock(&primitives_mutex_);
+    if (frozen_.load(std::memory_order_relaxed)) return;
+    std::vector<std::pair<absl::string_view, const Primitives*>> entries;
+    entries.reserve(primitives_.size());
+    for (const auto& prefix_and_vector : primitives_) {
+      entries.emplace_back(prefix_and_vector.first, &prefix_and_vector.second);
+      for (const auto& entry : prefix_and_vector.second) {
+        frozen_all_.push_back(entry.get());
+      }
+    }
+    frozen_index_ = internal::KeyPrefixIndex<Primitives>(entries);
+    if (primitives_.size() == 1 &&
+        primitives_.begin()->second.size() == 1 &&
+        primitives_.begin()->second.front().get() == primary_) {
+      single_entry_ = primary_;
+    }
+    frozen_.store(true, std::memory_order_release);
+  }
+
+  // Returns true if Freeze() has been called on this set.
+  bool is_frozen() const { return frozen_.load(std::memory_order_acquire); }
+
+  // Returns the entry of a frozen set that holds exactly one primitive, which
+  // then is the primary, or nullptr otherwise. Lets wrappers skip the lookups
+  // by key prefix for single-key keysets.
+  const Entry<P>* get_single_entry() const {
+    return is_frozen() ? single_entry_ : nullptr;
+  }
+
+  // Returns an estimate of the heap memory, in bytes, held by this set: the
+  // set itself, its entries and its indices. The primitives are not
+  // included, as their size is not known here and they may be shared; the
+  // memory benchmark in benchmarks/ measures them per key type.
+  size_t EstimateMemoryUsage() const {
+    absl::MutexLock lock(&primitives_mutex_);
+    size_t usage = sizeof(*this) + frozen_index_.EstimateMemoryUsage() +
+                   frozen_all_.capacity() * sizeof(Entry<P>*) +
+                   primitives_.bucket_count() * sizeof(void*);
+    for (const auto& prefix_and_vector : primitives_) {
+      // A node of the map holds a next pointer and the cached hash.
+      usage += sizeof(prefix_and_vector) + 2 * sizeof(void*) +
+               internal::StringMemoryUsage(prefix_and_vector.first) +
+               prefix_and_vector.second.capacity() *
+                   sizeof(std::unique_ptr<Entry<P>>);
+      for (const auto& entry : prefix_and_vector.second) {
+        usage += sizeof(Entry<P>) +
+                 internal::StringMemoryUsage(entry->get_identifier());
+      }
+    }
+    return usage;
+  }
+
  private:
   typedef std::unordered_map<std::string, Primitives>
       CiphertextPrefixToPrimitivesMap;
+
+  crypto::tink::util::StatusOr<Entry<P>*> AddEntry(
+      std::unique_ptr<Entry<P>> entry) {
+    absl::MutexLock lock(&primitives_mutex_);
+    if (frozen_.load(std::memory_order_relaxed)) {
+      return util::Status(crypto::tink::util::error::FAILED_PRECONDITION,
+                          "Cannot add primitives to a frozen set.");
+    }
+    std::string identifier = entry->get_identifier();
+    primitives_[identifier].push_back(std::move(entry));
+    return primitives_[identifier].back().get();
+  }
+
   Entry<P>* primary_;  // the Entry<P> object is owned by primitives_
   mutable absl::Mutex primitives_mutex_;
   CiphertextPrefixToPrimitivesMap primitives_
       ABSL_GUARDED_BY(primitives_mutex_);
+  // Set once by Freeze(); written before frozen_ is published and read-only
+  // afterwards.
+  internal::KeyPrefixIndex<Primitives> frozen_index_;
+  // All entries, in the order of primitives_, for get_all() on frozen sets.
+  std::vector<Entry<P>*> frozen_all_;
+  // Set by Freeze() if the set holds only the primary, see get_single_entry().
+  const Entry<P>* single_entry_ = nullptr;
+  std::atomic<bool> frozen_;
 };
 
 }  // namespace tink
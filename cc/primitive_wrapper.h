@@ -37,6 +37,11 @@ class PrimitiveWrapper {
   virtual ~PrimitiveWrapper() {}
   virtual crypto::tink::util::StatusOr<std::unique_ptr<Primitive>> Wrap(
       std::unique_ptr<PrimitiveSet<InputPrimitive>> primitive_set) const = 0;
+
+  // Returns true if Wrap() accepts sets with lazy entries, i.e. if the
+  // wrapped primitive accesses the primitives of non-primary entries only via
+  // Entry::GetOrCreatePrimitive() and handles its errors.
+  virtual bool SupportsLazyPrimitives() const { return false; }
 };
 
 }  // namespace tink
@@ -17,7 +17,13 @@
 #ifndef TINK_PUBLIC_KEY_SIGN_H_
 #define TINK_PUBLIC_KEY_SIGN_H_
 
+#include <cstdint>
+#include <string>
+#include <vector>
+
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/util/executor.h"
 #include "tink/util/statusor.h"
 
 namespace crypto {
@@ -37,6 +43,24 @@ class PublicKeySign {
   virtual crypto::tink::util::StatusOr<std::string> Sign(
       absl::string_view data) const = 0;
 
+  // Signs each of 'data' like Sign(), on the calling thread and up to
+  // num_threads - 1 tasks on util::Executor::Global() (num_threads values
+  // below 1 are treated as 1). Element i of the result holds the signature
+  // for data[i], or the error signing it.
+  //
+  // Implementations should override this method if they can amortize
+  // per-signature work over the batch; the default implementation calls
+  // Sign() for each element.
+  virtual std::vector<crypto::tink::util::StatusOr<std::string>> SignBatch(
+      absl::Span<const absl::string_view> data, int num_threads) const {
+    std::vector<crypto::tink::util::StatusOr<std::string>> signatures(
+        data.size());
+    util::ParallelFor(data.size(), num_threads, [&](int64_t i) {
+      signatures[i] = Sign(data[i]);
+    });
+    return signatures;
+  }
+
   virtual ~PublicKeySign() {}
 };
 
@@ -17,6 +17,11 @@
 #ifndef TINK_RANDOM_ACCESS_STREAM_H_
 #define TINK_RANDOM_ACCESS_STREAM_H_
 
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "absl/strings/cord.h"
 #include "tink/util/buffer.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
@@ -53,6 +58,32 @@ class RandomAccessStream {
       int count,
       crypto::tink::util::Buffer* dest_buffer) = 0;
 
+  // Reads like PRead(), but appends the bytes read to 'dest' and returns
+  // the status PRead() would have returned. Implementations that read into
+  // memory of their own can hand it over to the Cord instead of copying it;
+  // the default implementation reads into a Buffer and copies the bytes.
+  virtual crypto::tink::util::Status PReadCord(int64_t position, int count,
+                                               absl::Cord* dest) {
+    if (dest == nullptr) {
+      return crypto::tink::util::Status(
+          crypto::tink::util::error::INVALID_ARGUMENT,
+          "dest must be non-null");
+    }
+    if (count < 0) {
+      return crypto::tink::util::Status(
+          crypto::tink::util::error::INVALID_ARGUMENT,
+          "count cannot be negative");
+    }
+    // A Buffer cannot be empty.
+    auto buffer_result = crypto::tink::util::Buffer::New(std::max(count, 1));
+    if (!buffer_result.ok()) return buffer_result.status();
+    std::unique_ptr<crypto::tink::util::Buffer> buffer =
+        std::move(buffer_result.ValueOrDie());
+    auto status = PRead(position, count, buffer.get());
+    dest->Append(absl::string_view(buffer->get_mem_block(), buffer->size()));
+    return status;
+  }
+
   // Returns the size of this stream in bytes, if available.
   // If the size is not available, returns a non-Ok status.
   // The returned value is the "logical" size of a stream, i.e. of
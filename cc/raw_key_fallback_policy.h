@@ -0,0 +1,102 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_RAW_KEY_FALLBACK_POLICY_H_
+#define TINK_RAW_KEY_FALLBACK_POLICY_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace crypto {
+namespace tink {
+
+// Counts how often the primitives of keyset wrappers fell back to trying the
+// keys with OutputPrefixType::RAW. Thread-safe, and may be shared by several
+// wrappers.
+struct RawKeyFallbackCounters {
+  // Number of ciphertexts (or MACs) for which at least one RAW key was tried.
+  std::atomic<int64_t> fallbacks{0};
+  // Number of RAW keys tried.
+  std::atomic<int64_t> raw_attempts{0};
+  // Number of ciphertexts (or MACs) accepted by a RAW key.
+  std::atomic<int64_t> raw_successes{0};
+  // Number of ciphertexts (or MACs) rejected without trying all RAW keys,
+  // due to the policy.
+  std::atomic<int64_t> skipped{0};
+};
+
+// Controls when the primitives of the AEAD, deterministic AEAD and MAC
+// keyset wrappers try the RAW keys of a keyset. By default, they try all RAW
+// keys for every ciphertext which no key with a matching prefix decrypts,
+// so a foreign or corrupted ciphertext costs one decryption per RAW key.
+//
+// To apply a policy, register a wrapper constructed with it before the
+// configuration of the primitive, e.g.
+//
+//   Registry::RegisterPrimitiveWrapper(
+//       absl::make_unique<AeadWrapper>(policy));
+//   AeadConfig::Register();
+struct RawKeyFallbackPolicy {
+  // If true, the RAW keys are not tried for ciphertexts whose prefix matches
+  // a key of the keyset, even if none of the matching keys decrypts them.
+  // RAW ciphertexts which start with a matching prefix by chance are then
+  // rejected; with 5-byte prefixes this has a probability of about 2^-32
+  // per key with a prefix.
+  bool skip_if_prefix_matched = false;
+  // Maximum number of RAW keys tried per ciphertext, in keyset order, or -1
+  // to try all of them.
+  int max_raw_attempts = -1;
+  // If not null, counts the fallbacks. Must outlive the wrapped primitives.
+  RawKeyFallbackCounters* counters = nullptr;
+};
+
+namespace internal {
+
+// Returns how many of the 'num_raw_keys' RAW keys 'policy' allows to try for
+// a ciphertext, where 'prefix_matched' tells whether keys with a matching
+// prefix were found (and failed).
+inline size_t RawKeysToTry(const RawKeyFallbackPolicy& policy,
+                           bool prefix_matched, size_t num_raw_keys) {
+  if (prefix_matched && policy.skip_if_prefix_matched) return 0;
+  if (policy.max_raw_attempts < 0) return num_raw_keys;
+  return std::min(num_raw_keys, static_cast<size_t>(policy.max_raw_attempts));
+}
+
+// Records in the counters of 'policy' that 'attempts' of 'num_raw_keys' RAW
+// keys were tried for a ciphertext, and whether one of them succeeded.
+inline void RecordRawKeyFallback(const RawKeyFallbackPolicy& policy,
+                                 size_t num_raw_keys, size_t attempts,
+                                 bool success) {
+  RawKeyFallbackCounters* counters = policy.counters;
+  if (counters == nullptr || num_raw_keys == 0) return;
+  if (attempts > 0) {
+    counters->fallbacks.fetch_add(1, std::memory_order_relaxed);
+    counters->raw_attempts.fetch_add(attempts, std::memory_order_relaxed);
+  }
+  if (success) {
+    counters->raw_successes.fetch_add(1, std::memory_order_relaxed);
+  } else if (attempts < num_raw_keys) {
+    counters->skipped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace internal
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_RAW_KEY_FALLBACK_POLICY_H_
@@ -20,8 +20,11 @@
 #include <memory>
 #include <string>
 
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "tink/internal/registry_impl.h"
+#include "tink/util/constants.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
@@ -133,6 +136,38 @@ class Registry {
                                        new_key_allowed);
   }
 
+  // Same as RegisterKeyTypeManager(), but the KTManager is only created, with
+  // its default constructor, and registered when its key type is first looked
+  // up, e.g. by GetPrimitive() or NewKeyData(). This saves the startup time
+  // and memory of key managers an application never uses. Errors, such as a
+  // conflicting key manager, are only returned by that lookup. As for all of
+  // Tink's key managers, the key type must be derived from KTManager::KeyProto.
+  template <class KTManager>
+  static crypto::tink::util::Status RegisterKeyTypeManagerLazily(
+      bool new_key_allowed) {
+    return internal::RegistryImpl::GlobalInstance().RegisterLazily(
+        {KeyTypeUrl<typename KTManager::KeyProto>()}, [new_key_allowed]() {
+          return RegisterKeyTypeManager(absl::make_unique<KTManager>(),
+                                        new_key_allowed);
+        });
+  }
+
+  // Same as RegisterAsymmetricKeyManagers(), but lazily, like
+  // RegisterKeyTypeManagerLazily(). Both key managers are registered when
+  // either key type is first looked up.
+  template <class PrivateKeyTypeManager, class KeyTypeManager>
+  static crypto::tink::util::Status RegisterAsymmetricKeyManagersLazily(
+      bool new_key_allowed) {
+    return internal::RegistryImpl::GlobalInstance().RegisterLazily(
+        {KeyTypeUrl<typename PrivateKeyTypeManager::KeyProto>(),
+         KeyTypeUrl<typename KeyTypeManager::KeyProto>()},
+        [new_key_allowed]() {
+          return RegisterAsymmetricKeyManagers(
+              absl::make_unique<PrivateKeyTypeManager>(),
+              absl::make_unique<KeyTypeManager>(), new_key_allowed);
+        });
+  }
+
   template <class ConcretePrimitiveWrapper>
   static crypto::tink::util::Status RegisterPrimitiveWrapper(
       std::unique_ptr<ConcretePrimitiveWrapper> wrapper) {
@@ -202,12 +237,45 @@ class Registry {
         std::move(primitive_set));
   }
 
+  // Makes the registry immutable. Intended to be called once at startup,
+  // after all catalogues, key managers and wrappers have been registered.
+  // Afterwards further registrations fail, while lookups no longer need to
+  // take a lock.
+  static void Freeze() { internal::RegistryImpl::GlobalInstance().Freeze(); }
+
+  // Enables or disables interning of the primitives created for keysets.
+  // While enabled, keysets sharing a key also share the primitive of that
+  // key, e.g. its AES key schedule, as long as any of them is alive. Since
+  // Tink primitives are immutable and thread-safe, this only saves memory and
+  // key setup; custom key managers must return primitives with these
+  // properties as well. Disabled by default and by Reset().
+  static void SetPrimitiveInterning(bool enabled) {
+    internal::RegistryImpl::GlobalInstance().SetPrimitiveInterning(enabled);
+  }
+
+  // Keeps up to 'pool_size' keys for 'key_template' generated ahead of time
+  // on a background thread, so that NewKeyData() returns immediately while a
+  // pooled key is available. This is meant for templates with slow key
+  // generation, such as RSA. A 'pool_size' of 0 removes the pool, and
+  // Reset() removes all pools.
+  static crypto::tink::util::Status SetKeyPool(
+      const google::crypto::tink::KeyTemplate& key_template, int pool_size) {
+    return internal::RegistryImpl::GlobalInstance().SetKeyPool(key_template,
+                                                               pool_size);
+  }
+
   // Resets the registry.
   // After reset the registry is empty, i.e. it contains neither catalogues
   // nor key managers. This method is intended for testing only.
   static void Reset() {
     return internal::RegistryImpl::GlobalInstance().Reset();
   }
+
+ private:
+  template <class KeyProto>
+  static std::string KeyTypeUrl() {
+    return absl::StrCat(kTypeGoogleapisCom, KeyProto().GetTypeName());
+  }
 };
 
 }  // namespace tink
@@ -0,0 +1,132 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_REPLICATED_PRIMITIVE_H_
+#define TINK_REPLICATED_PRIMITIVE_H_
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tink/internal/cpu_topology.h"
+#include "tink/keyset_handle.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+///////////////////////////////////////////////////////////////////////////////
+// Replicas of a wrapped primitive, one per group of CPUs, by default one per
+// NUMA node.
+//
+// A single primitive shared by all threads keeps its key schedules and
+// BoringSSL contexts in the memory of one NUMA node, which the CPUs of the
+// other nodes read over the interconnect. ReplicatedPrimitive creates each
+// replica on a thread pinned to the CPUs of its group, so that with the
+// usual first-touch policy its memory is allocated on their node, and Get()
+// returns the replica of the CPU the calling thread runs on.
+//
+// This costs the memory and the creation time of num_replicas() primitives;
+// see PrimitiveSet::EstimateMemoryUsage() for the size of one. On machines
+// with a single node, or where the CPU or the topology cannot be determined
+// (i.e. outside Linux), there is a single replica and Get() returns it.
+// The replicas must not be modified after creation, and threads may migrate
+// between CPUs, so Get() is only a locality hint: any replica works on any
+// CPU.
+template <class P>
+class ReplicatedPrimitive {
+ public:
+  // Creates one primitive with 'factory' for each group of 'cpu_groups', on
+  // a thread pinned to the CPUs of the group. CPUs in none of the groups use
+  // the first replica.
+  static crypto::tink::util::StatusOr<std::unique_ptr<ReplicatedPrimitive<P>>>
+  New(const std::function<
+          crypto::tink::util::StatusOr<std::unique_ptr<P>>()>& factory,
+      const std::vector<std::vector<int>>& cpu_groups =
+          internal::NumaNodeCpus()) {
+    if (cpu_groups.empty()) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "cpu_groups must not be empty");
+    }
+    std::unique_ptr<ReplicatedPrimitive<P>> replicated(
+        new ReplicatedPrimitive<P>());
+    for (int group = 0; group < cpu_groups.size(); group++) {
+      crypto::tink::util::Status status;
+      std::unique_ptr<P> replica;
+      internal::RunOnCpus(cpu_groups[group], [&factory, &status, &replica]() {
+        auto replica_result = factory();
+        if (!replica_result.ok()) {
+          status = replica_result.status();
+          return;
+        }
+        replica = std::move(replica_result.ValueOrDie());
+      });
+      if (!status.ok()) return status;
+      if (replica == nullptr) {
+        return util::Status(util::error::INTERNAL, "factory returned null");
+      }
+      replicated->replicas_.push_back(std::move(replica));
+      for (int cpu : cpu_groups[group]) {
+        if (cpu < 0) continue;
+        if (cpu >= replicated->replica_of_cpu_.size()) {
+          replicated->replica_of_cpu_.resize(cpu + 1, 0);
+        }
+        replicated->replica_of_cpu_[cpu] = group;
+      }
+    }
+    return std::move(replicated);
+  }
+
+  // Same as above, with the primitives keyset_handle.GetPrimitive<P>()
+  // returns.
+  static crypto::tink::util::StatusOr<std::unique_ptr<ReplicatedPrimitive<P>>>
+  New(const KeysetHandle& keyset_handle,
+      const std::vector<std::vector<int>>& cpu_groups =
+          internal::NumaNodeCpus()) {
+    return New([&keyset_handle]() { return keyset_handle.GetPrimitive<P>(); },
+               cpu_groups);
+  }
+
+  ReplicatedPrimitive(const ReplicatedPrimitive&) = delete;
+  ReplicatedPrimitive& operator=(const ReplicatedPrimitive&) = delete;
+
+  // Returns the replica of the CPU the calling thread runs on.
+  const P& Get() const {
+    int cpu = internal::CurrentCpu();
+    if (cpu < 0 || cpu >= replica_of_cpu_.size()) return *replicas_[0];
+    return *replicas_[replica_of_cpu_[cpu]];
+  }
+
+  // Returns the replica of the 'index'-th CPU group.
+  const P& replica(int index) const { return *replicas_[index]; }
+
+  int num_replicas() const { return replicas_.size(); }
+
+ private:
+  ReplicatedPrimitive() {}
+
+  std::vector<std::unique_ptr<P>> replicas_;
+  // Indices into 'replicas_'.
+  std::vector<int> replica_of_cpu_;
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_REPLICATED_PRIMITIVE_H_
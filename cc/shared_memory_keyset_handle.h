@@ -0,0 +1,83 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SHARED_MEMORY_KEYSET_HANDLE_H_
+#define TINK_SHARED_MEMORY_KEYSET_HANDLE_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "tink/keyset_handle.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+// Shares cleartext keysets between the processes of a host through sealed
+// shared memory, so that e.g. the workers of a server can create
+// KeysetHandles for a keyset that one process has read and decrypted,
+// without calling the master key (often a remote KMS) themselves.
+//
+// Export() writes the keyset to an anonymous memory file (memfd) that is
+// sealed against any further modification, and locks it into memory. The
+// file descriptor is passed to the other processes by inheriting it across
+// fork() or by sending it over a Unix domain socket (SCM_RIGHTS); Import()
+// then creates a KeysetHandle from it. Like CleartextKeysetHandle, this
+// exposes the key material to every process that obtains the descriptor,
+// thus its usage should be restricted.
+//
+// Only supported on Linux; elsewhere both functions return UNIMPLEMENTED.
+class SharedMemoryKeysetHandle {
+ public:
+  // Sealed shared memory holding a keyset. The memory stays locked and the
+  // descriptor stays open as long as this object exists; the memory is freed
+  // once this object and all other descriptors and mappings of it are gone.
+  class Segment {
+   public:
+    ~Segment();
+
+    // The descriptor of the memory file. It is close-on-exec.
+    int fd() const { return fd_; }
+
+   private:
+    friend class SharedMemoryKeysetHandle;
+
+    Segment(int fd, void* mapping, std::size_t size)
+        : fd_(fd), mapping_(mapping), size_(size) {}
+
+    const int fd_;
+    void* const mapping_;
+    const std::size_t size_;
+  };
+
+  // Writes the keyset of |keyset_handle| to a new sealed memory file.
+  static crypto::tink::util::StatusOr<std::unique_ptr<Segment>> Export(
+      const KeysetHandle& keyset_handle);
+
+  // Creates a KeysetHandle from the memory file |fd| written by Export().
+  // Fails with FAILED_PRECONDITION if the file is not sealed against writes,
+  // shrinking and growing. Does not take ownership of |fd|.
+  static crypto::tink::util::StatusOr<std::unique_ptr<KeysetHandle>> Import(
+      int fd);
+
+ private:
+  SharedMemoryKeysetHandle() {}
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SHARED_MEMORY_KEYSET_HANDLE_H_
@@ -16,7 +16,12 @@
 
 #include "tink/signature/public_key_sign_wrapper.h"
 
+#include <string>
+#include <vector>
+
+#include "absl/types/span.h"
 #include "tink/crypto_format.h"
+#include "tink/monitoring_client.h"
 #include "tink/primitive_set.h"
 #include "tink/public_key_sign.h"
 #include "tink/subtle/subtle_util_boringssl.h"
@@ -51,6 +56,10 @@ class PublicKeySignSetWrapper : public PublicKeySign {
   crypto::tink::util::StatusOr<std::string> Sign(
       absl::string_view data) const override;
 
+  std::vector<crypto::tink::util::StatusOr<std::string>> SignBatch(
+      absl::Span<const absl::string_view> data,
+      int num_threads) const override;
+
   ~PublicKeySignSetWrapper() override {}
 
  private:
@@ -62,6 +71,8 @@ util::StatusOr<std::string> PublicKeySignSetWrapper::Sign(
   // BoringSSL expects a non-null pointer for data,
   // regardless of whether the size is 0.
   data = subtle::SubtleUtilBoringSSL::EnsureNonNull(data);
+  internal::MonitoredOperation monitored("public_key_sign", "sign",
+                                         data.size());
 
   auto primary = public_key_sign_set_->get_primary();
   std::string local_data;
@@ -72,10 +83,53 @@ util::StatusOr<std::string> PublicKeySignSetWrapper::Sign(
   }
   auto sign_result = primary->get_primitive().Sign(data);
   if (!sign_result.ok()) return sign_result.status();
+  monitored.Success(primary->get_key_id());
   const std::string& key_id = primary->get_identifier();
   return key_id + sign_result.ValueOrDie();
 }
 
+std::vector<util::StatusOr<std::string>> PublicKeySignSetWrapper::SignBatch(
+    absl::Span<const absl::string_view> data, int num_threads) const {
+  int64_t num_bytes = 0;
+  for (absl::string_view element : data) num_bytes += element.size();
+  internal::MonitoredOperation monitored("public_key_sign", "sign_batch",
+                                         num_bytes);
+
+  // The primary and its output prefix type are looked up once, and the
+  // primary signs the whole batch.
+  auto primary = public_key_sign_set_->get_primary();
+  std::vector<absl::string_view> primary_data;
+  primary_data.reserve(data.size());
+  std::vector<std::string> legacy_data;
+  if (primary->get_output_prefix_type() == OutputPrefixType::LEGACY) {
+    legacy_data.reserve(data.size());
+    for (absl::string_view element : data) {
+      legacy_data.emplace_back(element);
+      legacy_data.back().append(1, CryptoFormat::kLegacyStartByte);
+      primary_data.push_back(legacy_data.back());
+    }
+  } else {
+    for (absl::string_view element : data) {
+      primary_data.push_back(
+          subtle::SubtleUtilBoringSSL::EnsureNonNull(element));
+    }
+  }
+  std::vector<util::StatusOr<std::string>> signatures =
+      primary->get_primitive().SignBatch(primary_data, num_threads);
+
+  const std::string& key_id = primary->get_identifier();
+  bool all_ok = true;
+  for (util::StatusOr<std::string>& signature : signatures) {
+    if (!signature.ok()) {
+      all_ok = false;
+      continue;
+    }
+    if (!key_id.empty()) signature.ValueOrDie().insert(0, key_id);
+  }
+  if (all_ok) monitored.Success(primary->get_key_id());
+  return signatures;
+}
+
 }  // anonymous namespace
 
 util::StatusOr<std::unique_ptr<PublicKeySign>> PublicKeySignWrapper::Wrap(
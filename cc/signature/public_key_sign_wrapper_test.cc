@@ -15,8 +15,13 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 #include "tink/signature/public_key_sign_wrapper.h"
+
+#include <string>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "tink/crypto_format.h"
 #include "tink/primitive_set.h"
 #include "tink/public_key_sign.h"
@@ -170,6 +175,52 @@ TEST_F(PublicKeySignSetWrapperTest, testLegacySignatures) {
     EXPECT_TRUE(status.ok()) << status;
 }
 
+// Returns a PublicKeySign wrapping a DummyPublicKeySign named
+// 'signature_name' with a key of type 'output_prefix_type' as primary.
+std::unique_ptr<PublicKeySign> NewWrappedSign(
+    const std::string& signature_name, OutputPrefixType output_prefix_type) {
+  KeysetInfo::KeyInfo key;
+  key.set_output_prefix_type(output_prefix_type);
+  key.set_key_id(1234543);
+  key.set_status(KeyStatusType::ENABLED);
+  auto pk_sign_set = absl::make_unique<PrimitiveSet<PublicKeySign>>();
+  auto entry_result = pk_sign_set->AddPrimitive(
+      absl::make_unique<DummyPublicKeySign>(signature_name), key);
+  EXPECT_TRUE(entry_result.ok());
+  EXPECT_THAT(pk_sign_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  auto pk_sign_result = PublicKeySignWrapper().Wrap(std::move(pk_sign_set));
+  EXPECT_TRUE(pk_sign_result.ok()) << pk_sign_result.status();
+  return std::move(pk_sign_result.ValueOrDie());
+}
+
+TEST_F(PublicKeySignSetWrapperTest, SignBatchMatchesSign) {
+  for (OutputPrefixType output_prefix_type :
+       {OutputPrefixType::TINK, OutputPrefixType::LEGACY,
+        OutputPrefixType::RAW}) {
+    std::unique_ptr<PublicKeySign> pk_sign =
+        NewWrappedSign("some signatures", output_prefix_type);
+    std::vector<std::string> data;
+    for (int i = 0; i < 100; i++) data.push_back(absl::StrCat("data ", i));
+    std::vector<absl::string_view> data_views(data.begin(), data.end());
+
+    std::vector<util::StatusOr<std::string>> signatures =
+        pk_sign->SignBatch(data_views, /*num_threads=*/4);
+    ASSERT_EQ(signatures.size(), data.size());
+    for (size_t i = 0; i < data.size(); i++) {
+      ASSERT_TRUE(signatures[i].ok()) << signatures[i].status();
+      auto sign_result = pk_sign->Sign(data[i]);
+      ASSERT_TRUE(sign_result.ok()) << sign_result.status();
+      EXPECT_EQ(signatures[i].ValueOrDie(), sign_result.ValueOrDie());
+    }
+  }
+}
+
+TEST_F(PublicKeySignSetWrapperTest, SignBatchEmpty) {
+  std::unique_ptr<PublicKeySign> pk_sign =
+      NewWrappedSign("some signatures", OutputPrefixType::TINK);
+  EXPECT_TRUE(pk_sign->SignBatch({}, /*num_threads=*/4).empty());
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
@@ -0,0 +1,45 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/signature/public_key_verify_router.h"
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "tink/util/status.h"
+
+namespace crypto {
+namespace tink {
+
+util::Status PublicKeyVerifyRouter::Verify(absl::string_view signature,
+                                           absl::string_view data,
+                                           std::string* keyset_name) const {
+  Route route = Find(signature);
+  if (route.empty()) {
+    return util::Status(util::error::NOT_FOUND,
+                        "no keyset has a key for the signature");
+  }
+  for (const Keyset* keyset : route) {
+    if (keyset->primitive->Verify(signature, data).ok()) {
+      if (keyset_name != nullptr) *keyset_name = keyset->name;
+      return util::OkStatus();
+    }
+  }
+  return util::Status(util::error::INVALID_ARGUMENT, "verification failed");
+}
+
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,50 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SIGNATURE_PUBLIC_KEY_VERIFY_ROUTER_H_
+#define TINK_SIGNATURE_PUBLIC_KEY_VERIFY_ROUTER_H_
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "tink/keyset_router.h"
+#include "tink/public_key_verify.h"
+#include "tink/util/status.h"
+
+namespace crypto {
+namespace tink {
+
+// Verifies signatures of many public keysets, e.g. those of the tenants of a
+// service, without knowing in advance which keyset a signature belongs to.
+// The keyset is found by the output prefix of the signature, see
+// KeysetRouter; signatures of RAW keys cannot be verified.
+class PublicKeyVerifyRouter : public KeysetRouter<PublicKeyVerify> {
+ public:
+  PublicKeyVerifyRouter() {}
+
+  // Verifies that 'signature' is a signature for 'data' by a key of one of
+  // the keysets. If 'keyset_name' is non-null, it is set to the name of
+  // that keyset. Fails with NOT_FOUND if no keyset has a key with the output
+  // prefix of 'signature'.
+  crypto::tink::util::Status Verify(absl::string_view signature,
+                                    absl::string_view data,
+                                    std::string* keyset_name = nullptr) const;
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SIGNATURE_PUBLIC_KEY_VERIFY_ROUTER_H_
@@ -0,0 +1,127 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/signature/public_key_verify_router.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tink/crypto_format.h"
+#include "tink/primitive_set.h"
+#include "tink/public_key_verify.h"
+#include "tink/signature/public_key_verify_wrapper.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+#include "proto/tink.pb.h"
+
+using ::crypto::tink::test::DummyPublicKeySign;
+using ::crypto::tink::test::DummyPublicKeyVerify;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::google::crypto::tink::KeysetInfo;
+using ::google::crypto::tink::KeyStatusType;
+using ::google::crypto::tink::OutputPrefixType;
+
+namespace crypto {
+namespace tink {
+namespace {
+
+// A public keyset with a single key, its wrapped PublicKeyVerify, and a
+// signature of "data" by its key.
+struct TestKeyset {
+  KeysetInfo keyset_info;
+  std::shared_ptr<PublicKeyVerify> verify;
+  std::string signature;
+};
+
+TestKeyset GetTestKeyset(uint32_t key_id, absl::string_view signature_name) {
+  TestKeyset keyset;
+  KeysetInfo::KeyInfo* key_info = keyset.keyset_info.add_key_info();
+  key_info->set_key_id(key_id);
+  key_info->set_output_prefix_type(OutputPrefixType::TINK);
+  key_info->set_status(KeyStatusType::ENABLED);
+  auto verify_set = absl::make_unique<PrimitiveSet<PublicKeyVerify>>();
+  auto entry_result = verify_set->AddPrimitive(
+      absl::make_unique<DummyPublicKeyVerify>(signature_name), *key_info);
+  EXPECT_THAT(entry_result.status(), IsOk());
+  EXPECT_THAT(verify_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  auto verify_result = PublicKeyVerifyWrapper().Wrap(std::move(verify_set));
+  EXPECT_THAT(verify_result.status(), IsOk());
+  keyset.verify = std::move(verify_result.ValueOrDie());
+  keyset.signature = absl::StrCat(
+      CryptoFormat::GetOutputPrefix(*key_info).ValueOrDie(),
+      DummyPublicKeySign(signature_name).Sign("data").ValueOrDie());
+  return keyset;
+}
+
+TEST(PublicKeyVerifyRouterTest, VerifiesWithTheKeysetOfTheSignature) {
+  PublicKeyVerifyRouter router;
+  TestKeyset keyset1 = GetTestKeyset(1111, "signature1");
+  TestKeyset keyset2 = GetTestKeyset(2222, "signature2");
+  ASSERT_THAT(
+      router.AddKeyset("tenant1", keyset1.keyset_info, keyset1.verify),
+      IsOk());
+  ASSERT_THAT(
+      router.AddKeyset("tenant2", keyset2.keyset_info, keyset2.verify),
+      IsOk());
+
+  std::string keyset_name;
+  EXPECT_THAT(router.Verify(keyset2.signature, "data", &keyset_name), IsOk());
+  EXPECT_EQ("tenant2", keyset_name);
+  EXPECT_THAT(router.Verify(keyset1.signature, "data", &keyset_name), IsOk());
+  EXPECT_EQ("tenant1", keyset_name);
+
+  EXPECT_THAT(router.Verify(keyset2.signature, "other data"),
+              StatusIs(util::error::INVALID_ARGUMENT));
+
+  ASSERT_THAT(router.RemoveKeyset("tenant2"), IsOk());
+  EXPECT_THAT(router.Verify(keyset2.signature, "data"),
+              StatusIs(util::error::NOT_FOUND));
+}
+
+TEST(PublicKeyVerifyRouterTest, TriesAllKeysetsWithTheKeyId) {
+  PublicKeyVerifyRouter router;
+  TestKeyset keyset1 = GetTestKeyset(1234, "signature1");
+  TestKeyset keyset2 = GetTestKeyset(1234, "signature2");
+  ASSERT_THAT(
+      router.AddKeyset("tenant1", keyset1.keyset_info, keyset1.verify),
+      IsOk());
+  ASSERT_THAT(
+      router.AddKeyset("tenant2", keyset2.keyset_info, keyset2.verify),
+      IsOk());
+
+  std::string keyset_name;
+  EXPECT_THAT(router.Verify(keyset2.signature, "data", &keyset_name), IsOk());
+  EXPECT_EQ("tenant2", keyset_name);
+}
+
+TEST(PublicKeyVerifyRouterTest, UnknownSignature) {
+  PublicKeyVerifyRouter router;
+  TestKeyset keyset = GetTestKeyset(1111, "signature");
+  ASSERT_THAT(router.AddKeyset("tenant", keyset.keyset_info, keyset.verify),
+              IsOk());
+  EXPECT_THAT(router.Verify("", "data"), StatusIs(util::error::NOT_FOUND));
+  EXPECT_THAT(router.Verify("some unprefixed signature", "data"),
+              StatusIs(util::error::NOT_FOUND));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
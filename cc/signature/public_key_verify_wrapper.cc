@@ -16,8 +16,15 @@
 
 #include "tink/signature/public_key_verify_wrapper.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "tink/crypto_format.h"
+#include "tink/monitoring_client.h"
 #include "tink/primitive_set.h"
 #include "tink/public_key_verify.h"
 #include "tink/subtle/subtle_util_boringssl.h"
@@ -53,6 +60,11 @@ class PublicKeyVerifySetWrapper : public PublicKeyVerify {
   crypto::tink::util::Status Verify(absl::string_view signature,
                                     absl::string_view data) const override;
 
+  crypto::tink::util::Status VerifyBatch(
+      absl::Span<const absl::string_view> signatures,
+      absl::Span<const absl::string_view> data,
+      std::vector<bool>* valid) const override;
+
   ~PublicKeyVerifySetWrapper() override {}
 
  private:
@@ -66,6 +78,8 @@ util::Status PublicKeyVerifySetWrapper::Verify(
   // regardless of whether the size is 0.
   data = subtle::SubtleUtilBoringSSL::EnsureNonNull(data);
   signature = subtle::SubtleUtilBoringSSL::EnsureNonNull(signature);
+  internal::MonitoredOperation monitored("public_key_verify", "verify",
+                                         data.size());
 
   if (signature.length() <= CryptoFormat::kNonRawPrefixSize) {
     // This also rejects raw signatures with size of 4 bytes or fewer.
@@ -85,10 +99,12 @@ util::Status PublicKeyVerifySetWrapper::Verify(
         legacy_data = absl::StrCat(data, std::string("\x00", 1));
         view_on_data_or_legacy_data = legacy_data;
       }
-      auto& public_key_verify = entry->get_primitive();
-      auto verify_result =
-          public_key_verify.Verify(raw_signature, view_on_data_or_legacy_data);
+      auto public_key_verify_result = entry->GetOrCreatePrimitive();
+      if (!public_key_verify_result.ok()) continue;
+      auto verify_result = public_key_verify_result.ValueOrDie()->Verify(
+          raw_signature, view_on_data_or_legacy_data);
       if (verify_result.ok()) {
+        monitored.Success(entry->get_key_id());
         return util::Status::OK;
       } else {
         // LOG that a matching key didn't verify the signature.
@@ -101,9 +117,13 @@ util::Status PublicKeyVerifySetWrapper::Verify(
   if (raw_primitives_result.ok()) {
     for (auto& public_key_verify_entry :
              *(raw_primitives_result.ValueOrDie())) {
-      auto& public_key_verify = public_key_verify_entry->get_primitive();
-      auto verify_result = public_key_verify.Verify(signature, data);
+      auto public_key_verify_result =
+          public_key_verify_entry->GetOrCreatePrimitive();
+      if (!public_key_verify_result.ok()) continue;
+      auto verify_result =
+          public_key_verify_result.ValueOrDie()->Verify(signature, data);
       if (verify_result.ok()) {
+        monitored.Success(public_key_verify_entry->get_key_id());
         return util::Status::OK;
       }
     }
@@ -111,6 +131,114 @@ util::Status PublicKeyVerifySetWrapper::Verify(
   return util::Status(util::error::INVALID_ARGUMENT, "Invalid signature.");
 }
 
+// Verifies the signatures at 'indices' with the primitives of 'entries',
+// passing each primitive all signatures not verified by an earlier one with
+// a single VerifyBatch() call. Sets the verified elements of 'valid' to true,
+// and returns the indices which none of the primitives verified.
+std::vector<size_t> VerifyBatchWithEntries(
+    const PrimitiveSet<PublicKeyVerify>::Primitives& entries,
+    absl::Span<const absl::string_view> signatures,
+    absl::Span<const absl::string_view> data, size_t prefix_size,
+    std::vector<size_t> indices, std::vector<bool>* valid) {
+  for (auto& entry : entries) {
+    if (indices.empty()) break;
+    auto public_key_verify_result = entry->GetOrCreatePrimitive();
+    if (!public_key_verify_result.ok()) continue;
+    bool is_legacy =
+        entry->get_output_prefix_type() == OutputPrefixType::LEGACY;
+    std::vector<std::string> legacy_data;
+    if (is_legacy) legacy_data.reserve(indices.size());
+    std::vector<absl::string_view> entry_signatures;
+    std::vector<absl::string_view> entry_data;
+    entry_signatures.reserve(indices.size());
+    entry_data.reserve(indices.size());
+    for (size_t i : indices) {
+      entry_signatures.push_back(signatures[i].substr(prefix_size));
+      if (is_legacy) {
+        legacy_data.push_back(absl::StrCat(data[i], std::string("\x00", 1)));
+        entry_data.push_back(legacy_data.back());
+      } else {
+        entry_data.push_back(data[i]);
+      }
+    }
+    std::vector<bool> entry_valid;
+    // The status only summarizes entry_valid, which is inspected below.
+    public_key_verify_result.ValueOrDie()
+        ->VerifyBatch(entry_signatures, entry_data, &entry_valid)
+        .IgnoreError();
+    if (entry_valid.size() != indices.size()) continue;
+    std::vector<size_t> remaining;
+    for (size_t j = 0; j < indices.size(); j++) {
+      if (entry_valid[j]) {
+        (*valid)[indices[j]] = true;
+      } else {
+        remaining.push_back(indices[j]);
+      }
+    }
+    indices = std::move(remaining);
+  }
+  return indices;
+}
+
+util::Status PublicKeyVerifySetWrapper::VerifyBatch(
+    absl::Span<const absl::string_view> signatures,
+    absl::Span<const absl::string_view> data, std::vector<bool>* valid) const {
+  if (signatures.size() != data.size()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "signatures and data must have the same size");
+  }
+  valid->assign(signatures.size(), false);
+  std::vector<absl::string_view> non_null_signatures;
+  std::vector<absl::string_view> non_null_data;
+  non_null_signatures.reserve(signatures.size());
+  non_null_data.reserve(data.size());
+  for (size_t i = 0; i < signatures.size(); i++) {
+    non_null_signatures.push_back(
+        subtle::SubtleUtilBoringSSL::EnsureNonNull(signatures[i]));
+    non_null_data.push_back(
+        subtle::SubtleUtilBoringSSL::EnsureNonNull(data[i]));
+  }
+
+  // Group the signatures by their key id, so that each key is asked to
+  // verify all of its signatures at once. As in Verify(), signatures which no
+  // key with a matching id verifies are tried with the RAW keys.
+  absl::flat_hash_map<absl::string_view, std::vector<size_t>> by_key_id;
+  for (size_t i = 0; i < non_null_signatures.size(); i++) {
+    // Signatures this short are rejected by Verify() as well.
+    if (non_null_signatures[i].length() <= CryptoFormat::kNonRawPrefixSize) {
+      continue;
+    }
+    absl::string_view key_id =
+        non_null_signatures[i].substr(0, CryptoFormat::kNonRawPrefixSize);
+    by_key_id[key_id].push_back(i);
+  }
+  std::vector<size_t> unverified;
+  for (auto& key_id_and_indices : by_key_id) {
+    std::vector<size_t> indices = std::move(key_id_and_indices.second);
+    auto primitives_result =
+        public_key_verify_set_->get_primitives(key_id_and_indices.first);
+    if (primitives_result.ok()) {
+      indices = VerifyBatchWithEntries(
+          *primitives_result.ValueOrDie(), non_null_signatures, non_null_data,
+          CryptoFormat::kNonRawPrefixSize, std::move(indices), valid);
+    }
+    unverified.insert(unverified.end(), indices.begin(), indices.end());
+  }
+  auto raw_primitives_result = public_key_verify_set_->get_raw_primitives();
+  if (raw_primitives_result.ok()) {
+    unverified = VerifyBatchWithEntries(
+        *raw_primitives_result.ValueOrDie(), non_null_signatures,
+        non_null_data, /*prefix_size=*/0, std::move(unverified), valid);
+  }
+
+  for (bool signature_valid : *valid) {
+    if (!signature_valid) {
+      return util::Status(util::error::INVALID_ARGUMENT, "Invalid signature.");
+    }
+  }
+  return util::Status::OK;
+}
+
 }  // anonymous namespace
 
 util::StatusOr<std::unique_ptr<PublicKeyVerify>> PublicKeyVerifyWrapper::Wrap(
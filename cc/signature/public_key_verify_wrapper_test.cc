@@ -16,7 +16,14 @@
 
 #include "tink/signature/public_key_verify_wrapper.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tink/crypto_format.h"
 #include "tink/primitive_set.h"
 #include "tink/public_key_verify.h"
 #include "tink/util/status.h"
@@ -26,6 +33,7 @@
 using ::crypto::tink::test::DummyPublicKeySign;
 using ::crypto::tink::test::DummyPublicKeyVerify;
 using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
 using ::google::crypto::tink::KeysetInfo;
 using ::google::crypto::tink::KeyStatusType;
 using ::google::crypto::tink::OutputPrefixType;
@@ -124,6 +132,72 @@ TEST_F(PublicKeyVerifySetWrapperTest, testBasic) {
   }
 }
 
+TEST_F(PublicKeyVerifySetWrapperTest, VerifyBatch) {
+  KeysetInfo keyset_info;
+  std::vector<OutputPrefixType> prefix_types = {
+      OutputPrefixType::RAW, OutputPrefixType::LEGACY, OutputPrefixType::TINK};
+  std::unique_ptr<PrimitiveSet<PublicKeyVerify>> pk_verify_set(
+      new PrimitiveSet<PublicKeyVerify>());
+  for (int i = 0; i < prefix_types.size(); i++) {
+    KeysetInfo::KeyInfo* key_info = keyset_info.add_key_info();
+    key_info->set_output_prefix_type(prefix_types[i]);
+    key_info->set_key_id(1000 + i);
+    key_info->set_status(KeyStatusType::ENABLED);
+    auto entry_result = pk_verify_set->AddPrimitive(
+        absl::make_unique<DummyPublicKeyVerify>(absl::StrCat("signature_", i)),
+        *key_info);
+    ASSERT_THAT(entry_result.status(), IsOk());
+    ASSERT_THAT(pk_verify_set->set_primary(entry_result.ValueOrDie()), IsOk());
+  }
+  auto pk_verify_result =
+      PublicKeyVerifyWrapper().Wrap(std::move(pk_verify_set));
+  ASSERT_THAT(pk_verify_result.status(), IsOk());
+  std::unique_ptr<PublicKeyVerify> pk_verify =
+      std::move(pk_verify_result.ValueOrDie());
+
+  std::vector<std::string> data;
+  std::vector<std::string> signatures;
+  for (int i = 0; i < 12; i++) {
+    int key = i % prefix_types.size();
+    data.push_back(absl::StrCat("data_", i));
+    std::string signed_data = data.back();
+    if (prefix_types[key] == OutputPrefixType::LEGACY) {
+      signed_data.push_back('\0');
+    }
+    std::string prefix =
+        CryptoFormat::GetOutputPrefix(keyset_info.key_info(key)).ValueOrDie();
+    signatures.push_back(absl::StrCat(
+        prefix, DummyPublicKeySign(absl::StrCat("signature_", key))
+                    .Sign(signed_data)
+                    .ValueOrDie()));
+  }
+  std::vector<absl::string_view> data_views(data.begin(), data.end());
+  std::vector<absl::string_view> signature_views(signatures.begin(),
+                                                 signatures.end());
+  std::vector<bool> valid;
+  EXPECT_THAT(pk_verify->VerifyBatch(signature_views, data_views, &valid),
+              IsOk());
+  EXPECT_EQ(valid, std::vector<bool>(12, true));
+
+  // Swapped data, a truncated signature and an unknown key id.
+  std::swap(data_views[3], data_views[4]);
+  signature_views[7] = "abc";
+  signatures[8][1] ^= 1;
+  signature_views[8] = signatures[8];
+  EXPECT_THAT(pk_verify->VerifyBatch(signature_views, data_views, &valid),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  for (int i = 0; i < 12; i++) {
+    EXPECT_EQ(valid[i],
+              pk_verify->Verify(signature_views[i], data_views[i]).ok())
+        << i;
+    EXPECT_EQ(valid[i], i != 3 && i != 4 && i != 7 && i != 8) << i;
+  }
+
+  data_views.pop_back();
+  EXPECT_THAT(pk_verify->VerifyBatch(signature_views, data_views, &valid),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
@@ -109,12 +109,12 @@ RsaSsaPssSignKeyManager::PublicKeySignFactory::Create(
   auto signer = subtle::RsaSsaPssSignBoringSsl::New(key, params);
   if (!signer.ok()) return signer.status();
   // To check that the key is correct, we sign a test message with private key
-  // and verify with public key.
+  // and verify with public key, once per key and process.
   auto verifier = RsaSsaPssVerifyKeyManager().GetPrimitive<PublicKeyVerify>(
       private_key.public_key());
   if (!verifier.ok()) return verifier.status();
-  auto sign_verify_result =
-      SignAndVerify(signer.ValueOrDie().get(), verifier.ValueOrDie().get());
+  auto sign_verify_result = SignAndVerifyOnce(
+      signer.ValueOrDie().get(), verifier.ValueOrDie().get(), private_key);
   if (!sign_verify_result.ok()) {
     return util::Status(util::error::INTERNAL,
                         "security bug: signing with private key followed by "
@@ -16,9 +16,71 @@
 
 #include "tink/signature/sig_util.h"
 
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "openssl/sha.h"
+#include "tink/aead.h"
+#include "tink/util/errors.h"
+#include "tink/util/secret_data.h"
+
 namespace crypto {
 namespace tink {
 
+namespace {
+
+// The SHA-256 digests of the serialized private keys which passed
+// SignAndVerify() in this process. Once the set is full it is cleared, so
+// that it does not grow without bound if keys are rotated often.
+class CheckedKeys {
+ public:
+  static CheckedKeys& GlobalInstance() {
+    static CheckedKeys* instance = new CheckedKeys();
+    return *instance;
+  }
+
+  bool Contains(const std::string& digest) ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    return digests_.contains(digest);
+  }
+
+  void Insert(const std::string& digest) ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    if (digests_.size() >= kMaxSize) digests_.clear();
+    digests_.insert(digest);
+  }
+
+  std::vector<std::string> GetAll() ABSL_LOCKS_EXCLUDED(mutex_) {
+    absl::MutexLock lock(&mutex_);
+    return std::vector<std::string>(digests_.begin(), digests_.end());
+  }
+
+ private:
+  static constexpr size_t kMaxSize = 4096;
+
+  absl::Mutex mutex_;
+  absl::flat_hash_set<std::string> digests_ ABSL_GUARDED_BY(mutex_);
+};
+
+std::string KeyDigest(const portable_proto::MessageLite& private_key) {
+  util::SecretData serialized(private_key.ByteSizeLong());
+  private_key.SerializeToArray(serialized.data(), serialized.size());
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  SHA256(serialized.data(), serialized.size(), digest);
+  return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+constexpr char kCheckedKeysAssociatedData[] = "tink checked keys";
+
+}  // namespace
+
 crypto::tink::util::Status SignAndVerify(const PublicKeySign* signer,
                                          const PublicKeyVerify* verifier) {
   static constexpr char kTestMessage[] = "Wycheproof and Tink.";
@@ -27,5 +89,75 @@ crypto::tink::util::Status SignAndVerify(const PublicKeySign* signer,
   return verifier->Verify(sign_result.ValueOrDie(), kTestMessage);
 }
 
+crypto::tink::util::Status SignAndVerifyOnce(
+    const PublicKeySign* signer, const PublicKeyVerify* verifier,
+    const portable_proto::MessageLite& private_key) {
+  std::string digest = KeyDigest(private_key);
+  if (CheckedKeys::GlobalInstance().Contains(digest)) {
+    return crypto::tink::util::OkStatus();
+  }
+  crypto::tink::util::Status status = SignAndVerify(signer, verifier);
+  if (status.ok()) CheckedKeys::GlobalInstance().Insert(digest);
+  return status;
+}
+
+crypto::tink::util::Status SaveCheckedKeys(const std::string& path,
+                                           const Aead& kek) {
+  std::string plaintext(1, static_cast<char>(kCheckedKeysVersion));
+  for (const std::string& digest : CheckedKeys::GlobalInstance().GetAll()) {
+    plaintext.append(digest);
+  }
+  auto encrypt_result = kek.Encrypt(plaintext, kCheckedKeysAssociatedData);
+  if (!encrypt_result.ok()) return encrypt_result.status();
+  // Written next to 'path' and renamed, so that readers never see a partial
+  // file.
+  std::string tmp_path = absl::StrCat(path, ".tmp");
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    file << encrypt_result.ValueOrDie();
+    file.close();
+    if (!file) {
+      std::remove(tmp_path.c_str());
+      return ToStatusF(util::error::INTERNAL, "Could not write '%s'.",
+                       tmp_path.c_str());
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return ToStatusF(util::error::INTERNAL, "Could not rename '%s' to '%s'.",
+                     tmp_path.c_str(), path.c_str());
+  }
+  return util::OkStatus();
+}
+
+crypto::tink::util::Status LoadCheckedKeys(const std::string& path,
+                                           const Aead& kek) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return ToStatusF(util::error::NOT_FOUND, "Could not open '%s'.",
+                     path.c_str());
+  }
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  if (file.bad()) {
+    return ToStatusF(util::error::INTERNAL, "Could not read '%s'.",
+                     path.c_str());
+  }
+  auto decrypt_result = kek.Decrypt(buffer.str(), kCheckedKeysAssociatedData);
+  if (!decrypt_result.ok()) return decrypt_result.status();
+  const std::string& plaintext = decrypt_result.ValueOrDie();
+  if (plaintext.empty() ||
+      static_cast<uint8_t>(plaintext[0]) != kCheckedKeysVersion ||
+      (plaintext.size() - 1) % SHA256_DIGEST_LENGTH != 0) {
+    return ToStatusF(util::error::INVALID_ARGUMENT,
+                     "'%s' is not a checked keys file.", path.c_str());
+  }
+  for (size_t pos = 1; pos < plaintext.size(); pos += SHA256_DIGEST_LENGTH) {
+    CheckedKeys::GlobalInstance().Insert(
+        plaintext.substr(pos, SHA256_DIGEST_LENGTH));
+  }
+  return util::OkStatus();
+}
+
 }  // namespace tink
 }  // namespace crypto
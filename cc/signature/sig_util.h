@@ -16,8 +16,13 @@
 #ifndef TINK_SIGNATURE_SIG_UTIL_H_
 #define TINK_SIGNATURE_SIG_UTIL_H_
 
+#include <cstdint>
+#include <string>
+
+#include "tink/aead.h"
 #include "tink/public_key_sign.h"
 #include "tink/public_key_verify.h"
+#include "tink/util/protobuf_helper.h"
 #include "tink/util/status.h"
 
 namespace crypto {
@@ -26,6 +31,38 @@ namespace tink {
 crypto::tink::util::Status SignAndVerify(const PublicKeySign* signer,
                                          const PublicKeyVerify* verifier);
 
+// Same as SignAndVerify(), but skips the check if it already succeeded in
+// this process for a key with the same serialization as 'private_key'. Key
+// managers use this so that creating many primitives for the same keys, e.g.
+// on every keyset load, does not repeat the private key operation.
+crypto::tink::util::Status SignAndVerifyOnce(
+    const PublicKeySign* signer, const PublicKeyVerify* verifier,
+    const portable_proto::MessageLite& private_key);
+
+// Writes the keys whose check SignAndVerifyOnce() skips in this process to
+// the file at 'path', encrypted with 'kek', so that processes which later
+// LoadCheckedKeys() skip the check for them too. This saves the private key
+// operation per key on each start of short-lived processes which load the
+// same keysets, e.g. command line tools and batch jobs.
+//
+// Only SHA-256 digests of the serialized keys are written, not the keys. The
+// file is authenticated by 'kek', which should be bound to the host, e.g. a
+// key only readable by the service account of the processes: whoever can
+// encrypt with it can make those processes skip the check for any key. The
+// file is replaced atomically, so concurrent readers see an old or a new
+// version. Its plaintext is a version byte, kCheckedKeysVersion, followed by
+// the 32-byte digests; the associated data is "tink checked keys".
+crypto::tink::util::Status SaveCheckedKeys(const std::string& path,
+                                           const Aead& kek);
+
+// Reads a file written by SaveCheckedKeys() with 'kek', and skips the checks
+// of SignAndVerifyOnce() for the keys in it. Returns NOT_FOUND if there is no
+// file at 'path'.
+crypto::tink::util::Status LoadCheckedKeys(const std::string& path,
+                                           const Aead& kek);
+
+constexpr uint8_t kCheckedKeysVersion = 1;
+
 }  // namespace tink
 }  // namespace crypto
 
@@ -0,0 +1,132 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "tink/signature/sig_util.h"
+
+#include <fstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "openssl/sha.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::test::DummyAead;
+using ::crypto::tink::test::DummyPublicKeySign;
+using ::crypto::tink::test::DummyPublicKeyVerify;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::google::crypto::tink::KeyData;
+
+KeyData TestKey(absl::string_view value) {
+  KeyData key;
+  key.set_type_url("some key type");
+  key.set_value(std::string(value));
+  return key;
+}
+
+std::string TestFilePath(absl::string_view name) {
+  return absl::StrCat(crypto::tink::test::TmpDir(), "/", name);
+}
+
+TEST(SigUtilTest, SignAndVerify) {
+  DummyPublicKeySign signer("key");
+  DummyPublicKeyVerify verifier("key");
+  DummyPublicKeyVerify wrong_verifier("other");
+  EXPECT_THAT(SignAndVerify(&signer, &verifier), IsOk());
+  EXPECT_FALSE(SignAndVerify(&signer, &wrong_verifier).ok());
+}
+
+TEST(SigUtilTest, SignAndVerifyOnceRemembersSuccessfulChecks) {
+  DummyPublicKeySign signer("key");
+  DummyPublicKeyVerify verifier("key");
+  DummyPublicKeyVerify wrong_verifier("other");
+  KeyData key = TestKey("SignAndVerifyOnce key");
+
+  // Failed checks are not remembered.
+  EXPECT_FALSE(SignAndVerifyOnce(&signer, &wrong_verifier, key).ok());
+  EXPECT_FALSE(SignAndVerifyOnce(&signer, &wrong_verifier, key).ok());
+
+  EXPECT_THAT(SignAndVerifyOnce(&signer, &verifier, key), IsOk());
+  // The check is skipped for the same key ...
+  EXPECT_THAT(SignAndVerifyOnce(&signer, &wrong_verifier, key), IsOk());
+  // ... but not for any other key.
+  EXPECT_FALSE(SignAndVerifyOnce(&signer, &wrong_verifier,
+                                 TestKey("SignAndVerifyOnce other key"))
+                   .ok());
+}
+
+TEST(SigUtilTest, SaveAndLoadCheckedKeys) {
+  DummyPublicKeySign signer("key");
+  DummyPublicKeyVerify verifier("key");
+  DummyPublicKeyVerify wrong_verifier("other");
+  DummyAead kek("kek");
+  std::string path = TestFilePath("sig_util_test_checked_keys");
+  ASSERT_THAT(SignAndVerifyOnce(&signer, &verifier,
+                                TestKey("SaveAndLoadCheckedKeys key")),
+              IsOk());
+  ASSERT_THAT(SaveCheckedKeys(path, kek), IsOk());
+
+  // Loads the digest of a key which was not checked in this process, as if
+  // another process had saved it.
+  KeyData key = TestKey("SaveAndLoadCheckedKeys other process key");
+  EXPECT_FALSE(SignAndVerifyOnce(&signer, &wrong_verifier, key).ok());
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  std::string serialized = key.SerializeAsString();
+  SHA256(reinterpret_cast<const uint8_t*>(serialized.data()),
+         serialized.size(), digest);
+  std::string plaintext = absl::StrCat(
+      std::string(1, static_cast<char>(kCheckedKeysVersion)),
+      std::string(reinterpret_cast<const char*>(digest), sizeof(digest)));
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << kek.Encrypt(plaintext, "tink checked keys").ValueOrDie();
+  }
+  DummyAead other_kek("other kek");
+  EXPECT_FALSE(LoadCheckedKeys(path, other_kek).ok());
+  EXPECT_FALSE(SignAndVerifyOnce(&signer, &wrong_verifier, key).ok());
+  ASSERT_THAT(LoadCheckedKeys(path, kek), IsOk());
+  EXPECT_THAT(SignAndVerifyOnce(&signer, &wrong_verifier, key), IsOk());
+}
+
+TEST(SigUtilTest, LoadCheckedKeysErrors) {
+  DummyAead kek("kek");
+  EXPECT_THAT(LoadCheckedKeys(TestFilePath("sig_util_test_missing"), kek),
+              StatusIs(util::error::NOT_FOUND));
+
+  std::string path = TestFilePath("sig_util_test_bad_checked_keys");
+  for (const std::string& plaintext :
+       {std::string(""), std::string(1 + SHA256_DIGEST_LENGTH, '\x02'),
+        std::string(SHA256_DIGEST_LENGTH, '\x01')}) {
+    {
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      file << kek.Encrypt(plaintext, "tink checked keys").ValueOrDie();
+    }
+    EXPECT_THAT(LoadCheckedKeys(path, kek),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
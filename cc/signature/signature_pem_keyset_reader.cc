@@ -19,10 +19,15 @@
 #include <cstddef>
 #include <memory>
 #include <random>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "tink/input_stream.h"
 #include "tink/keyset_reader.h"
 #include "tink/signature/rsa_ssa_pkcs1_sign_key_manager.h"
 #include "tink/signature/rsa_ssa_pkcs1_verify_key_manager.h"
@@ -31,6 +36,7 @@
 #include "tink/subtle/pem_parser_boringssl.h"
 #include "tink/subtle/subtle_util_boringssl.h"
 #include "tink/util/enums.h"
+#include "tink/util/executor.h"
 #include "tink/util/keyset_util.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/status.h"
@@ -73,23 +79,16 @@ util::Status SetRsaSsaPssParameters(const PemKeyParams& pem_parameters,
   return util::OkStatus();
 }
 
-// Creates a new Keyset::Key with ID `key_id`. The key has key data
-// `key_data`, key type `key_type`, and key material type
-// `key_material_type`.
-Keyset::Key NewKeysetKey(uint32_t key_id, absl::string_view key_type,
-                         const KeyData::KeyMaterialType& key_material_type,
-                         const std::string& key_data) {
-  Keyset::Key key;
-  // Populate KeyData for the new key.
-  key.set_key_id(key_id);
-  key.set_status(KeyStatusType::ENABLED);
-  // PEM keys don't add any prefix to signatures
-  key.set_output_prefix_type(OutputPrefixType::RAW);
-  KeyData* key_data_proto = key.mutable_key_data();
-  key_data_proto->set_type_url(key_type.data(), key_type.size());
-  key_data_proto->set_value(key_data);
-  key_data_proto->set_key_material_type(key_material_type);
-  return key;
+// Creates the data of a new key with key type `key_type`, key material type
+// `key_material_type`, and serialized key `key_data`.
+KeyData NewKeyData(absl::string_view key_type,
+                   const KeyData::KeyMaterialType& key_material_type,
+                   const std::string& key_data) {
+  KeyData key_data_proto;
+  key_data_proto.set_type_url(key_type.data(), key_type.size());
+  key_data_proto.set_value(key_data);
+  key_data_proto.set_key_material_type(key_material_type);
+  return key_data_proto;
 }
 
 // Construct a new RSASSA-PSS key proto from a subtle RSA private key
@@ -167,8 +166,8 @@ RsaSsaPkcs1PrivateKey NewRsaSsaPkcs1PrivateKey(
   return private_key_proto;
 }
 
-// Adds the PEM-encoded private key `pem_key` to `keyset`.
-util::Status AddRsaSsaPrivateKey(const PemKey& pem_key, Keyset* keyset) {
+// Parses the PEM-encoded private key `pem_key`.
+util::StatusOr<KeyData> ParseRsaSsaPrivateKey(const PemKey& pem_key) {
   // Try to parse the PEM RSA private key.
   auto private_key_subtle_or =
       subtle::PemParser::ParseRsaPrivateKey(pem_key.serialized_key);
@@ -197,11 +196,9 @@ util::Status AddRsaSsaPrivateKey(const PemKey& pem_key, Keyset* keyset) {
       auto key_validation_status = key_manager.ValidateKey(private_key_proto);
       if (!key_validation_status.ok()) return key_validation_status;
 
-      *keyset->add_key() =
-          NewKeysetKey(GenerateUnusedKeyId(*keyset), key_manager.get_key_type(),
-                       key_manager.key_material_type(),
-                       private_key_proto.SerializeAsString());
-      break;
+      return NewKeyData(key_manager.get_key_type(),
+                        key_manager.key_material_type(),
+                        private_key_proto.SerializeAsString());
     }
     case PemAlgorithm::RSASSA_PKCS1: {
       RsaSsaPkcs1SignKeyManager key_manager;
@@ -212,25 +209,19 @@ util::Status AddRsaSsaPrivateKey(const PemKey& pem_key, Keyset* keyset) {
       auto key_validation_status = key_manager.ValidateKey(private_key_proto);
       if (!key_validation_status.ok()) return key_validation_status;
 
-      *keyset->add_key() =
-          NewKeysetKey(GenerateUnusedKeyId(*keyset), key_manager.get_key_type(),
-                       key_manager.key_material_type(),
-                       private_key_proto.SerializeAsString());
-
-      break;
+      return NewKeyData(key_manager.get_key_type(),
+                        key_manager.key_material_type(),
+                        private_key_proto.SerializeAsString());
     }
     default:
       return util::Status(
           util::error::INVALID_ARGUMENT,
           absl::StrCat("Invalid RSA algorithm ", pem_key.parameters.algorithm));
   }
-
-  return util::OkStatus();
 }
 
-// Parses a given PEM-encoded RSA public key `pem_key`, and adds it to the
-// keyset `keyset`.
-util::Status AddRsaSsaPublicKey(const PemKey& pem_key, Keyset* keyset) {
+// Parses a given PEM-encoded RSA public key `pem_key`.
+util::StatusOr<KeyData> ParseRsaSsaPublicKey(const PemKey& pem_key) {
   // Parse the PEM string into a RSA public key.
   auto public_key_subtle_or =
       subtle::PemParser::ParseRsaPublicKey(pem_key.serialized_key);
@@ -267,12 +258,9 @@ util::Status AddRsaSsaPublicKey(const PemKey& pem_key, Keyset* keyset) {
       auto key_validation_status = key_manager.ValidateKey(public_key_proto);
       if (!key_validation_status.ok()) return key_validation_status;
 
-      *keyset->add_key() =
-          NewKeysetKey(GenerateUnusedKeyId(*keyset), key_manager.get_key_type(),
-                       key_manager.key_material_type(),
-                       public_key_proto.SerializeAsString());
-
-      break;
+      return NewKeyData(key_manager.get_key_type(),
+                        key_manager.key_material_type(),
+                        public_key_proto.SerializeAsString());
     }
     case PemAlgorithm::RSASSA_PKCS1: {
       RsaSsaPkcs1PublicKey public_key_proto;
@@ -291,99 +279,232 @@ util::Status AddRsaSsaPublicKey(const PemKey& pem_key, Keyset* keyset) {
       auto key_validation_status = key_manager.ValidateKey(public_key_proto);
       if (!key_validation_status.ok()) return key_validation_status;
 
-      *keyset->add_key() =
-          NewKeysetKey(GenerateUnusedKeyId(*keyset), key_manager.get_key_type(),
-                       key_manager.key_material_type(),
-                       public_key_proto.SerializeAsString());
-      break;
+      return NewKeyData(key_manager.get_key_type(),
+                        key_manager.key_material_type(),
+                        public_key_proto.SerializeAsString());
     }
     default:
       return util::Status(
           util::error::INVALID_ARGUMENT,
           absl::StrCat("Invalid RSA algorithm ", pem_key.parameters.algorithm));
   }
-  return util::OkStatus();
 }
 
+// Parses the PEM-encoded private key `pem_key` of any supported key type.
+util::StatusOr<KeyData> ParsePrivateKey(const PemKey& pem_key) {
+  switch (pem_key.parameters.key_type) {
+    case PemKeyType::PEM_RSA:
+      return ParseRsaSsaPrivateKey(pem_key);
+    default:
+      return util::Status(util::error::UNIMPLEMENTED,
+                          "EC Keys Parsing unimplemented");
+  }
+}
+
+// Parses the PEM-encoded public key `pem_key` of any supported key type.
+util::StatusOr<KeyData> ParsePublicKey(const PemKey& pem_key) {
+  switch (pem_key.parameters.key_type) {
+    case PemKeyType::PEM_RSA:
+      return ParseRsaSsaPublicKey(pem_key);
+    default:
+      return util::Status(util::error::UNIMPLEMENTED,
+                          "EC Keys Parsing unimplemented");
+  }
+}
+
+// Reads the PEM blocks of a stream one at a time.
+class PemBlockReader {
+ public:
+  explicit PemBlockReader(InputStream* stream) : stream_(stream) {}
+
+  // Returns the next PEM block, including its BEGIN and END lines, or an
+  // OUT_OF_RANGE error at the end of the stream.
+  util::StatusOr<std::string> Next() {
+    std::string line;
+    util::Status status;
+    while ((status = ReadLine(&line)).ok() &&
+           !absl::StartsWith(line, "-----BEGIN ")) {
+    }
+    if (!status.ok()) return status;
+    std::string block;
+    while (true) {
+      absl::StrAppend(&block, line, "\n");
+      if (absl::StartsWith(line, "-----END ")) return block;
+      status = ReadLine(&line);
+      if (status.error_code() == util::error::OUT_OF_RANGE) {
+        return util::Status(util::error::INVALID_ARGUMENT,
+                            "Truncated PEM block");
+      }
+      if (!status.ok()) return status;
+    }
+  }
+
+ private:
+  // Reads the next line into `line`, without its line break. Returns an
+  // OUT_OF_RANGE error at the end of the stream.
+  util::Status ReadLine(std::string* line) {
+    line->clear();
+    bool read_any = false;
+    while (true) {
+      const void* buffer;
+      auto next_result = stream_->Next(&buffer);
+      if (!next_result.ok()) {
+        if (next_result.status().error_code() == util::error::OUT_OF_RANGE &&
+            read_any) {
+          break;
+        }
+        return next_result.status();
+      }
+      absl::string_view chunk(static_cast<const char*>(buffer),
+                              next_result.ValueOrDie());
+      if (!chunk.empty()) read_any = true;
+      size_t end = chunk.find('\n');
+      if (end != absl::string_view::npos) {
+        line->append(chunk.data(), end);
+        stream_->BackUp(chunk.size() - end - 1);
+        break;
+      }
+      line->append(chunk.data(), chunk.size());
+    }
+    if (!line->empty() && line->back() == '\r') line->pop_back();
+    return util::OkStatus();
+  }
+
+  InputStream* stream_;
+};
+
+// The number of keys parsed per batch and thread. Larger batches keep the
+// threads busier, at the cost of holding more keys of bundles in memory.
+constexpr int kKeysPerThreadAndBatch = 16;
+
 }  // namespace
 
 void SignaturePemKeysetReaderBuilder::Add(const PemKey& pem_serialized_key) {
   pem_serialized_keys_.push_back(pem_serialized_key);
 }
 
+void SignaturePemKeysetReaderBuilder::AddBundle(PemBundle pem_bundle) {
+  pem_bundles_.push_back(std::move(pem_bundle));
+}
+
 util::StatusOr<std::unique_ptr<KeysetReader>>
 SignaturePemKeysetReaderBuilder::Build() {
-  if (pem_serialized_keys_.empty()) {
+  if (pem_serialized_keys_.empty() && pem_bundles_.empty()) {
     return util::Status(util::error::INVALID_ARGUMENT,
                         "Empty array of PEM-encoded keys");
   }
+  if (num_threads_ < 1) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "num_threads must be positive");
+  }
+  for (const PemBundle& pem_bundle : pem_bundles_) {
+    if (pem_bundle.stream == nullptr) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "PEM bundle has a null stream");
+    }
+  }
 
   switch (pem_reader_type_) {
     case PUBLIC_KEY_SIGN: {
-      return absl::WrapUnique<KeysetReader>(
-          new PublicKeySignPemKeysetReader(pem_serialized_keys_));
+      return absl::WrapUnique<KeysetReader>(new PublicKeySignPemKeysetReader(
+          pem_serialized_keys_, std::move(pem_bundles_), num_threads_));
     }
     case PUBLIC_KEY_VERIFY: {
-      return absl::WrapUnique<KeysetReader>(
-          new PublicKeyVerifyPemKeysetReader(pem_serialized_keys_));
+      return absl::WrapUnique<KeysetReader>(new PublicKeyVerifyPemKeysetReader(
+          pem_serialized_keys_, std::move(pem_bundles_), num_threads_));
     }
   }
   return util::Status(util::error::INVALID_ARGUMENT,
                       "Unknown pem_reader_type_");
 }
 
-util::StatusOr<std::unique_ptr<Keyset>> PublicKeySignPemKeysetReader::Read() {
-  if (pem_serialized_keys_.empty()) {
-    return util::Status(util::error::INVALID_ARGUMENT,
-                        "Empty array of PEM-encoded keys");
+util::Status SignaturePemKeysetReader::AddKeys(
+    const std::vector<const PemKey*>& pem_keys, KeyParser parse_key,
+    Keyset* keyset) {
+  std::vector<util::StatusOr<KeyData>> key_data(pem_keys.size());
+  util::ParallelFor(pem_keys.size(), num_threads_, [&](int64_t i) {
+    key_data[i] = parse_key(*pem_keys[i]);
+  });
+  for (auto& key_data_result : key_data) {
+    if (!key_data_result.ok()) return key_data_result.status();
+    uint32_t key_id = GenerateUnusedKeyId(*keyset);
+    Keyset::Key* key = keyset->add_key();
+    key->set_key_id(key_id);
+    key->set_status(KeyStatusType::ENABLED);
+    // PEM keys don't add any prefix to signatures
+    key->set_output_prefix_type(OutputPrefixType::RAW);
+    *key->mutable_key_data() = std::move(key_data_result.ValueOrDie());
   }
-
-  auto keyset = absl::make_unique<Keyset>();
-  for (const PemKey& pem_key : pem_serialized_keys_) {
-    // Parse and add the new key to the keyset.
-    switch (pem_key.parameters.key_type) {
-      case PemKeyType::PEM_RSA: {
-        auto add_rsassa_pss_status = AddRsaSsaPrivateKey(pem_key, keyset.get());
-        if (!add_rsassa_pss_status.ok()) return add_rsassa_pss_status;
-        break;
-      }
-      default:
-        return util::Status(util::error::UNIMPLEMENTED,
-                            "EC Keys Parsing unimplemented");
-    }
-  }
-
-  // Set the 1st key as primary.
-  keyset->set_primary_key_id(keyset->key(0).key_id());
-
-  return keyset;
+  return util::OkStatus();
 }
 
-util::StatusOr<std::unique_ptr<Keyset>> PublicKeyVerifyPemKeysetReader::Read() {
-  if (pem_serialized_keys_.empty()) {
+util::StatusOr<std::unique_ptr<Keyset>> SignaturePemKeysetReader::ReadKeyset(
+    KeyParser parse_key) {
+  if (bundles_read_) {
+    return util::Status(util::error::FAILED_PRECONDITION,
+                        "The PEM bundles have already been read");
+  }
+  if (pem_serialized_keys_.empty() && pem_bundles_.empty()) {
     return util::Status(util::error::INVALID_ARGUMENT,
                         "Empty array of PEM-encoded keys");
   }
 
+  const size_t batch_size = kKeysPerThreadAndBatch * num_threads_;
   auto keyset = absl::make_unique<Keyset>();
+  std::vector<const PemKey*> batch;
+  batch.reserve(batch_size);
   for (const PemKey& pem_key : pem_serialized_keys_) {
-    // Parse and add the new key to the keyset.
-    switch (pem_key.parameters.key_type) {
-      case PemKeyType::PEM_RSA: {
-        auto add_rsassa_pss_status = AddRsaSsaPublicKey(pem_key, keyset.get());
-        if (!add_rsassa_pss_status.ok()) return add_rsassa_pss_status;
-        break;
+    batch.push_back(&pem_key);
+    if (batch.size() == batch_size) {
+      auto status = AddKeys(batch, parse_key, keyset.get());
+      if (!status.ok()) return status;
+      batch.clear();
+    }
+  }
+  auto status = AddKeys(batch, parse_key, keyset.get());
+  if (!status.ok()) return status;
+
+  if (!pem_bundles_.empty()) bundles_read_ = true;
+  std::vector<PemKey> bundle_keys;
+  bundle_keys.reserve(batch_size);
+  for (const PemBundle& pem_bundle : pem_bundles_) {
+    PemBlockReader block_reader(pem_bundle.stream.get());
+    bool end_of_bundle = false;
+    while (!end_of_bundle) {
+      bundle_keys.clear();
+      while (bundle_keys.size() < batch_size) {
+        auto block_result = block_reader.Next();
+        if (block_result.status().error_code() == util::error::OUT_OF_RANGE) {
+          end_of_bundle = true;
+          break;
+        }
+        if (!block_result.ok()) return block_result.status();
+        bundle_keys.push_back(
+            {std::move(block_result.ValueOrDie()), pem_bundle.parameters});
       }
-      default:
-        return util::Status(util::error::UNIMPLEMENTED,
-                            "EC Keys Parsing unimplemented");
+      batch.clear();
+      for (const PemKey& pem_key : bundle_keys) batch.push_back(&pem_key);
+      status = AddKeys(batch, parse_key, keyset.get());
+      if (!status.ok()) return status;
     }
   }
+  if (keyset->key_size() == 0) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "Empty array of PEM-encoded keys");
+  }
 
   // Set the 1st key as primary.
   keyset->set_primary_key_id(keyset->key(0).key_id());
 
-  return keyset;
+  return std::move(keyset);
+}
+
+util::StatusOr<std::unique_ptr<Keyset>> PublicKeySignPemKeysetReader::Read() {
+  return ReadKeyset(&ParsePrivateKey);
+}
+
+util::StatusOr<std::unique_ptr<Keyset>> PublicKeyVerifyPemKeysetReader::Read() {
+  return ReadKeyset(&ParsePublicKey);
 }
 
 util::StatusOr<std::unique_ptr<EncryptedKeyset>>
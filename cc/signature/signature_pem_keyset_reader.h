@@ -17,10 +17,14 @@
 #ifndef TINK_SIGNATURE_SIGNATURE_PEM_KEYSET_READER_H_
 #define TINK_SIGNATURE_SIGNATURE_PEM_KEYSET_READER_H_
 
+#include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
+#include "tink/input_stream.h"
 #include "tink/keyset_reader.h"
+#include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "proto/common.pb.h"
 #include "proto/tink.pb.h"
@@ -50,6 +54,13 @@ struct PemKey {
   PemKeyParams parameters;
 };
 
+// PEM-encoded keys read from `stream`, back to back, which all have the
+// parameters `parameters`. Text outside of the PEM blocks is ignored.
+struct PemBundle {
+  std::unique_ptr<InputStream> stream;
+  PemKeyParams parameters;
+};
+
 // Base class for parsing PEM-encoded keys (RFC 7468) into a keyset.
 class SignaturePemKeysetReader : public KeysetReader {
  public:
@@ -57,12 +68,36 @@ class SignaturePemKeysetReader : public KeysetReader {
   ReadEncrypted() override;
 
  protected:
-  explicit SignaturePemKeysetReader(
-      const std::vector<PemKey>& pem_serialized_keys)
-      : pem_serialized_keys_(pem_serialized_keys) {}
+  SignaturePemKeysetReader(std::vector<PemKey> pem_serialized_keys,
+                           std::vector<PemBundle> pem_bundles, int num_threads)
+      : pem_serialized_keys_(std::move(pem_serialized_keys)),
+        pem_bundles_(std::move(pem_bundles)),
+        num_threads_(num_threads),
+        bundles_read_(false) {}
+
+  // Parses a PEM-encoded key into the key data of a keyset key.
+  using KeyParser = util::StatusOr<::google::crypto::tink::KeyData> (*)(
+      const PemKey& pem_key);
+
+  // Parses the keys of `pem_serialized_keys_`, then those of `pem_bundles_`,
+  // with `parse_key`, and returns a keyset of them with the first key as
+  // primary. The keys are parsed in batches, each on up to `num_threads_`
+  // threads, and only one batch of the bundles is held in memory at a time.
+  util::StatusOr<std::unique_ptr<::google::crypto::tink::Keyset>> ReadKeyset(
+      KeyParser parse_key);
 
   // PEM-serialized keys to parse.
   std::vector<PemKey> pem_serialized_keys_;
+  // Bundles of PEM-serialized keys to parse, which can only be read once.
+  std::vector<PemBundle> pem_bundles_;
+  int num_threads_;
+  bool bundles_read_;
+
+ private:
+  // Parses `pem_keys` and adds them to `keyset`, in order.
+  util::Status AddKeys(const std::vector<const PemKey*>& pem_keys,
+                       KeyParser parse_key,
+                       ::google::crypto::tink::Keyset* keyset);
 };
 
 // Builder class for creating a PEM reader. Example usage:
@@ -95,20 +130,38 @@ class SignaturePemKeysetReaderBuilder {
   enum PemReaderType { PUBLIC_KEY_SIGN, PUBLIC_KEY_VERIFY };
 
   explicit SignaturePemKeysetReaderBuilder(PemReaderType pem_reader_type)
-      : pem_reader_type_(pem_reader_type) {}
+      : pem_reader_type_(pem_reader_type), num_threads_(1) {}
 
   // Adds a PEM serialized key `pem_serialized_key` to the builder.
   void Add(const PemKey& pem_serialized_key);
 
+  // Adds the PEM serialized keys of `pem_bundle`, e.g. a file with the keys of
+  // many partners, to the builder. The bundle is read by the reader, a batch
+  // of keys at a time, so neither the whole bundle nor all of its parsed keys
+  // are held in memory at once. Its keys follow those added with Add(), in
+  // the order the bundles were added. Build() hands the bundles to the reader
+  // it creates, which can then only be read once.
+  void AddBundle(PemBundle pem_bundle);
+
+  // Makes the reader parse the keys on the calling thread and up to
+  // `num_threads` - 1 tasks on util::Executor::Global(), which shortens
+  // imports of many keys. The keys keep their order, and errors are reported
+  // for the first failing key as with a single thread. `num_threads` must be
+  // positive.
+  void set_num_threads(int num_threads) { num_threads_ = num_threads; }
+
   // Creates an instance of keyset reader based on `pem_reader_type_`, to parse
-  // the PEM-encoded keys in `pem_serialized_keys_`.
+  // the PEM-encoded keys in `pem_serialized_keys_` and `pem_bundles_`.
   util::StatusOr<std::unique_ptr<KeysetReader>> Build();
 
  private:
   // List of keys as PEM serialized items.
   std::vector<PemKey> pem_serialized_keys_;
+  // Bundles of keys, handed to the next reader built.
+  std::vector<PemBundle> pem_bundles_;
   // Reader type that this reader must support.
   PemReaderType pem_reader_type_;
+  int num_threads_;
 };
 
 // Keyset reader for PEM keys that support the PublicKeySign principal.
@@ -121,9 +174,11 @@ class PublicKeySignPemKeysetReader : public SignaturePemKeysetReader {
   // Friend builder class.
   friend class SignaturePemKeysetReaderBuilder;
 
-  explicit PublicKeySignPemKeysetReader(
-      const std::vector<PemKey> pem_serialized_keys)
-      : SignaturePemKeysetReader(pem_serialized_keys) {}
+  PublicKeySignPemKeysetReader(std::vector<PemKey> pem_serialized_keys,
+                               std::vector<PemBundle> pem_bundles,
+                               int num_threads)
+      : SignaturePemKeysetReader(std::move(pem_serialized_keys),
+                                 std::move(pem_bundles), num_threads) {}
 };
 
 // Keyset reader for PEM keys that support the PublicKeyVerify principal.
@@ -136,9 +191,11 @@ class PublicKeyVerifyPemKeysetReader : public SignaturePemKeysetReader {
   // Friend builder class.
   friend class SignaturePemKeysetReaderBuilder;
 
-  explicit PublicKeyVerifyPemKeysetReader(
-      const std::vector<PemKey> pem_serialized_keys)
-      : SignaturePemKeysetReader(pem_serialized_keys) {}
+  PublicKeyVerifyPemKeysetReader(std::vector<PemKey> pem_serialized_keys,
+                                 std::vector<PemBundle> pem_bundles,
+                                 int num_threads)
+      : SignaturePemKeysetReader(std::move(pem_serialized_keys),
+                                 std::move(pem_bundles), num_threads) {}
 };
 
 }  // namespace tink
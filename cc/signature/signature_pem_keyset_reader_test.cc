@@ -16,9 +16,12 @@
 #include "tink/signature/signature_pem_keyset_reader.h"
 
 #include <memory>
+#include <sstream>
+#include <string>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "tink/keyset_handle.h"
@@ -31,6 +34,7 @@
 #include "tink/subtle/pem_parser_boringssl.h"
 #include "tink/subtle/subtle_util_boringssl.h"
 #include "tink/util/enums.h"
+#include "tink/util/istream_input_stream.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/status.h"
 #include "tink/util/test_matchers.h"
@@ -425,6 +429,99 @@ TEST(SignaturePemKeysetTeaderTest, ReadRsaPublicKeyInvalidHashType) {
   EXPECT_THAT(keyset_reader->Read().status(), StatusIs(Code::INVALID_ARGUMENT));
 }
 
+// Verify keys added one by one and in bundles are parsed in order, also on
+// several threads.
+TEST(SignaturePemKeysetReaderTest, ReadBundlesInParallel) {
+  const PemKeyParams params_sha256 = {.key_type = PemKeyType::PEM_RSA,
+                                      .algorithm = PemAlgorithm::RSASSA_PSS,
+                                      .key_size_in_bits = 2048,
+                                      .hash_type = HashType::SHA256};
+  const PemKeyParams params_sha384 = {.key_type = PemKeyType::PEM_RSA,
+                                      .algorithm = PemAlgorithm::RSASSA_PSS,
+                                      .key_size_in_bits = 2048,
+                                      .hash_type = HashType::SHA384};
+  // More keys than a batch on 2 threads, with text between the blocks.
+  const int kBundleKeys = 50;
+  std::string bundle = "Keys of our partners\r\n";
+  for (int i = 0; i < kBundleKeys; i++) {
+    absl::StrAppend(&bundle, "partner ", i, "\n", kRsaPublicKey2048);
+  }
+
+  for (int num_threads : {1, 2}) {
+    SCOPED_TRACE(absl::StrCat("num_threads: ", num_threads));
+    auto builder = SignaturePemKeysetReaderBuilder(
+        SignaturePemKeysetReaderBuilder::PemReaderType::PUBLIC_KEY_VERIFY);
+    builder.set_num_threads(num_threads);
+    builder.Add({.serialized_key = std::string(kRsaPublicKey2048),
+                 .parameters = params_sha384});
+    builder.AddBundle({absl::make_unique<util::IstreamInputStream>(
+                           absl::make_unique<std::stringstream>(bundle), 64),
+                       params_sha256});
+    builder.AddBundle({absl::make_unique<util::IstreamInputStream>(
+                           absl::make_unique<std::stringstream>(
+                               std::string(kRsaPublicKey2048))),
+                       params_sha384});
+    auto keyset_reader_or = builder.Build();
+    ASSERT_THAT(keyset_reader_or.status(), IsOk());
+    std::unique_ptr<KeysetReader> keyset_reader =
+        std::move(keyset_reader_or).ValueOrDie();
+
+    auto keyset_or = keyset_reader->Read();
+    ASSERT_THAT(keyset_or.status(), IsOk());
+    std::unique_ptr<Keyset> keyset = std::move(keyset_or).ValueOrDie();
+    RsaSsaPssVerifyKeyManager verify_key_manager;
+    ASSERT_THAT(keyset->key(), SizeIs(kBundleKeys + 2));
+    EXPECT_EQ(keyset->primary_key_id(), keyset->key(0).key_id());
+    std::string key_sha256 =
+        GetRsaSsaPssPublicKeyProto(kRsaPublicKey2048, HashType::SHA256,
+                                   verify_key_manager.get_version())
+            .SerializeAsString();
+    std::string key_sha384 =
+        GetRsaSsaPssPublicKeyProto(kRsaPublicKey2048, HashType::SHA384,
+                                   verify_key_manager.get_version())
+            .SerializeAsString();
+    EXPECT_EQ(key_sha384, keyset->key(0).key_data().value());
+    for (int i = 1; i <= kBundleKeys; i++) {
+      EXPECT_EQ(key_sha256, keyset->key(i).key_data().value());
+    }
+    EXPECT_EQ(key_sha384, keyset->key(kBundleKeys + 1).key_data().value());
+
+    // The bundles have been consumed.
+    EXPECT_THAT(keyset_reader->Read().status(),
+                StatusIs(Code::FAILED_PRECONDITION));
+  }
+}
+
+// Verify the first failing key of a bundle is reported.
+TEST(SignaturePemKeysetReaderTest, ReadInvalidBundles) {
+  const PemKeyParams params = {.key_type = PemKeyType::PEM_RSA,
+                               .algorithm = PemAlgorithm::RSASSA_PSS,
+                               .key_size_in_bits = 2048,
+                               .hash_type = HashType::SHA256};
+  const std::string truncated = absl::StrCat(
+      kRsaPublicKey2048,
+      kRsaPublicKey2048.substr(0, kRsaPublicKey2048.size() / 2));
+  const std::string wrong_size =
+      absl::StrCat(kRsaPublicKey2048, kRsaPublicKey1024);
+  for (const std::string& bundle : {truncated, wrong_size, std::string()}) {
+    auto builder = SignaturePemKeysetReaderBuilder(
+        SignaturePemKeysetReaderBuilder::PemReaderType::PUBLIC_KEY_VERIFY);
+    builder.set_num_threads(2);
+    builder.AddBundle({absl::make_unique<util::IstreamInputStream>(
+                           absl::make_unique<std::stringstream>(bundle)),
+                       params});
+    auto keyset_reader_or = builder.Build();
+    ASSERT_THAT(keyset_reader_or.status(), IsOk());
+    EXPECT_THAT(keyset_reader_or.ValueOrDie()->Read().status(),
+                StatusIs(Code::INVALID_ARGUMENT));
+  }
+
+  auto builder = SignaturePemKeysetReaderBuilder(
+      SignaturePemKeysetReaderBuilder::PemReaderType::PUBLIC_KEY_VERIFY);
+  builder.AddBundle({nullptr, params});
+  EXPECT_THAT(builder.Build().status(), StatusIs(Code::INVALID_ARGUMENT));
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
@@ -0,0 +1,249 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_STATIC_CONFIG_H_
+#define TINK_STATIC_CONFIG_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/utility/utility.h"
+#include "tink/config/tink_fips.h"
+#include "tink/core/template_util.h"
+#include "tink/internal/key_info.h"
+#include "tink/keyset_handle.h"
+#include "tink/primitive_set.h"
+#include "tink/primitive_wrapper.h"
+#include "tink/util/secret_proto.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "tink/util/validation.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+///////////////////////////////////////////////////////////////////////////////
+// A fixed set of key types, given as KeyTypeManager classes, for binaries
+// that know at compile time which key types they use, e.g.
+//
+//   using MyConfig = StaticConfig<AesGcmKeyManager, HmacKeyManager>;
+//   auto config = MyConfig::New().ValueOrDie();
+//   auto aead = config->GetPrimitive<Aead>(keyset_handle, AeadWrapper());
+//
+// The config owns its key managers and does not use the registry: nothing is
+// registered, and primitives are created without the registry's locks, its
+// type_index checks and its dynamic_casts. The type URL of a key is mapped to
+// its manager with a perfect hash over the type URLs of the managers, which
+// New() computes once, and the manager is then called through a table of
+// functions generated for each primitive and manager, which parse the key
+// into the KeyProto of the manager directly.
+//
+// Type URLs are only known once the managers exist, so the hash is computed
+// at runtime. Like a registered manager, a manager that is not FIPS
+// compatible fails in FIPS-only mode.
+template <class... KeyTypeManagers>
+class StaticConfig {
+ public:
+  static_assert(sizeof...(KeyTypeManagers) > 0,
+                "StaticConfig needs at least one key type manager.");
+  static_assert(!internal::HasDuplicates<KeyTypeManagers...>::value,
+                "StaticConfig lists a key type manager twice.");
+
+  // Returns a config holding default-constructed key managers. Fails if two
+  // of them manage the same key type.
+  static crypto::tink::util::StatusOr<std::unique_ptr<StaticConfig>> New() {
+    std::unique_ptr<StaticConfig> config(new StaticConfig());
+    crypto::tink::util::Status status = config->BuildIndex();
+    if (!status.ok()) return status;
+    return std::move(config);
+  }
+
+  StaticConfig(const StaticConfig&) = delete;
+  StaticConfig& operator=(const StaticConfig&) = delete;
+
+  // Returns the manager of type KeyTypeManager of the config.
+  template <class KeyTypeManager>
+  const KeyTypeManager& get_key_type_manager() const {
+    return std::get<internal::IndexOf<KeyTypeManager,
+                                      List<KeyTypeManagers...>>::value>(
+        managers_);
+  }
+
+  // Returns true if the config has a manager for 'type_url'.
+  bool DoesSupport(absl::string_view type_url) const {
+    return Find(type_url) >= 0;
+  }
+
+  // Creates the primitive P for 'key_data' with the manager of its type.
+  template <class P>
+  crypto::tink::util::StatusOr<std::unique_ptr<P>> GetPrimitive(
+      const google::crypto::tink::KeyData& key_data) const {
+    int index = Find(key_data.type_url());
+    if (index < 0) {
+      return crypto::tink::util::Status(
+          crypto::tink::util::error::NOT_FOUND,
+          absl::StrCat("No manager for type '", key_data.type_url(),
+                       "' in this config."));
+    }
+    return GetPrimitiveFunctions<P>(
+        absl::index_sequence_for<KeyTypeManagers...>())[index](managers_,
+                                                               key_data);
+  }
+
+  // Creates the primitives P of the enabled keys of 'keyset_handle' with the
+  // managers of the config, and wraps them with 'wrapper'.
+  template <class P>
+  crypto::tink::util::StatusOr<std::unique_ptr<P>> GetPrimitive(
+      const KeysetHandle& keyset_handle,
+      const PrimitiveWrapper<P, P>& wrapper) const {
+    const google::crypto::tink::Keyset& keyset = keyset_handle.get_keyset();
+    crypto::tink::util::Status status = ValidateKeyset(keyset);
+    if (!status.ok()) return status;
+    auto primitives = absl::make_unique<PrimitiveSet<P>>();
+    for (const google::crypto::tink::Keyset::Key& key : keyset.key()) {
+      if (key.status() != google::crypto::tink::KeyStatusType::ENABLED) {
+        continue;
+      }
+      auto primitive_result = GetPrimitive<P>(key.key_data());
+      if (!primitive_result.ok()) return primitive_result.status();
+      auto entry_result = primitives->AddPrimitive(
+          std::move(primitive_result.ValueOrDie()), KeyInfoFromKey(key));
+      if (!entry_result.ok()) return entry_result.status();
+      if (key.key_id() == keyset.primary_key_id()) {
+        auto primary_result =
+            primitives->set_primary(entry_result.ValueOrDie());
+        if (!primary_result.ok()) return primary_result;
+      }
+    }
+    return wrapper.Wrap(std::move(primitives));
+  }
+
+ private:
+  using Managers = std::tuple<KeyTypeManagers...>;
+  static constexpr size_t kNumManagers = sizeof...(KeyTypeManagers);
+
+  // The hash table has a power of two of slots, at least four per manager,
+  // so that a seed without collisions is found after a few attempts.
+  static constexpr size_t NumSlots(size_t slots) {
+    return slots >= 4 * kNumManagers ? slots : NumSlots(2 * slots);
+  }
+  static constexpr size_t kNumSlots = NumSlots(1);
+
+  template <class P>
+  using GetPrimitiveFunction =
+      crypto::tink::util::StatusOr<std::unique_ptr<P>> (*)(
+          const Managers&, const google::crypto::tink::KeyData&);
+
+  StaticConfig() {}
+
+  // FNV-1a, starting from a state derived from 'seed'.
+  static uint32_t Hash(absl::string_view type_url, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ (seed * 0x9e3779b9u);
+    for (char c : type_url) {
+      hash ^= static_cast<uint8_t>(c);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  // Returns the index of the manager for 'type_url', or -1.
+  int Find(absl::string_view type_url) const {
+    int index = slots_[Hash(type_url, seed_) & (kNumSlots - 1)];
+    if (index < 0 || type_urls_[index] != type_url) return -1;
+    return index;
+  }
+
+  // Fills type_urls_ and finds a seed for which their hashes do not collide.
+  crypto::tink::util::Status BuildIndex() {
+    CollectTypeUrls(absl::index_sequence_for<KeyTypeManagers...>());
+    for (size_t i = 0; i < kNumManagers; i++) {
+      for (size_t j = 0; j < i; j++) {
+        if (type_urls_[i] == type_urls_[j]) {
+          return crypto::tink::util::Status(
+              crypto::tink::util::error::ALREADY_EXISTS,
+              absl::StrCat("Two managers in this config manage type '",
+                           type_urls_[i], "'."));
+        }
+      }
+    }
+    for (seed_ = 0;; seed_++) {
+      slots_.fill(-1);
+      bool collision = false;
+      for (size_t i = 0; i < kNumManagers && !collision; i++) {
+        int& slot = slots_[Hash(type_urls_[i], seed_) & (kNumSlots - 1)];
+        collision = slot >= 0;
+        slot = i;
+      }
+      if (!collision) return crypto::tink::util::OkStatus();
+    }
+  }
+
+  template <size_t... I>
+  void CollectTypeUrls(absl::index_sequence<I...>) {
+    type_urls_ = {{std::get<I>(managers_).get_key_type()...}};
+  }
+
+  // Returns the functions creating a P with each of the managers.
+  template <class P, size_t... I>
+  static const GetPrimitiveFunction<P>* GetPrimitiveFunctions(
+      absl::index_sequence<I...>) {
+    static const GetPrimitiveFunction<P> kFunctions[] = {
+        &GetPrimitiveWithManager<P, I>...};
+    return kFunctions;
+  }
+
+  // Same as KeyManagerImpl::GetPrimitive() for the I-th manager.
+  template <class P, size_t I>
+  static crypto::tink::util::StatusOr<std::unique_ptr<P>>
+  GetPrimitiveWithManager(const Managers& managers,
+                          const google::crypto::tink::KeyData& key_data) {
+    using Manager = typename std::tuple_element<I, Managers>::type;
+    const Manager& manager = std::get<I>(managers);
+    crypto::tink::util::Status fips_status =
+        ChecksFipsCompatibility(manager.FipsStatus());
+    if (!fips_status.ok()) return fips_status;
+    util::SecretProto<typename Manager::KeyProto> key_proto;
+    if (!key_proto->ParseFromString(key_data.value())) {
+      return crypto::tink::util::Status(
+          crypto::tink::util::error::INVALID_ARGUMENT,
+          absl::StrCat("Could not parse key_data.value as key type '",
+                       key_data.type_url(), "'."));
+    }
+    crypto::tink::util::Status validation = manager.ValidateKey(*key_proto);
+    if (!validation.ok()) return validation;
+    return manager.template GetPrimitive<P>(*key_proto);
+  }
+
+  Managers managers_;
+  std::array<std::string, kNumManagers> type_urls_;
+  std::array<int, kNumSlots> slots_;
+  uint32_t seed_ = 0;
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_STATIC_CONFIG_H_
@@ -0,0 +1,59 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_STREAMING_HYBRID_ENCRYPT_H_
+#define TINK_STREAMING_HYBRID_ENCRYPT_H_
+
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "tink/output_stream.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+///////////////////////////////////////////////////////////////////////////////
+// The interface for streaming hybrid encryption.
+//
+// This is the streaming counterpart of HybridEncrypt, for plaintexts that are
+// too large to be held in memory, such as files encrypted to the public key
+// of a recipient. It provides the same guarantees as HybridEncrypt: the
+// ciphertext is private and bound to 'context_info', but the recipient does
+// not learn who the sender is (cf. the warning in hybrid_encrypt.h).
+// The resulting ciphertext stream can be decrypted with the corresponding
+// StreamingHybridDecrypt-primitive.
+class StreamingHybridEncrypt {
+ public:
+  // Returns a wrapper around 'ciphertext_destination', such that any bytes
+  // written via the wrapper are encrypted binding 'context_info' to the
+  // resulting ciphertext. The same 'context_info' has to be passed in for
+  // decryption. Position() of the wrapper returns the number of written
+  // plaintext bytes. Closing the wrapper results in closing of the wrapped
+  // stream.
+  virtual crypto::tink::util::StatusOr<
+      std::unique_ptr<crypto::tink::OutputStream>>
+  NewEncryptingStream(
+      std::unique_ptr<crypto::tink::OutputStream> ciphertext_destination,
+      absl::string_view context_info) const = 0;
+
+  virtual ~StreamingHybridEncrypt() {}
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_STREAMING_HYBRID_ENCRYPT_H_
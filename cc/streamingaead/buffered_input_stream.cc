@@ -39,8 +39,9 @@ BufferedInputStream::BufferedInputStream(
   count_in_buffer_ = 0;
   count_backedup_ = 0;
   position_ = 0;
-  buffer_.resize(4 * 1024);  // 4 KB
   buffer_offset_ = 0;
+  data_ = nullptr;
+  borrowed_ = false;
   after_rewind_ = false;
   rewinding_enabled_ = true;
   direct_access_ = false;
@@ -51,16 +52,27 @@ crypto::tink::util::StatusOr<int> BufferedInputStream::Next(const void** data) {
   if (direct_access_) return input_stream_->Next(data);
   if (!status_.ok()) return status_;
 
+  // If we don't allow rewind any more and all the buffered bytes come from
+  // the last input_stream_->Next(), the bytes not returned yet can be
+  // backed up in input_stream_, and from now on we go directly to it.
+  if (!rewinding_enabled_ && borrowed_) {
+    input_stream_->BackUp(after_rewind_ ? count_in_buffer_ : count_backedup_);
+    direct_access_ = true;
+    data_ = nullptr;
+    borrowed_ = false;
+    return input_stream_->Next(data);
+  }
+
   // We're just after rewind, so return all the data in the buffer, if any.
   if (after_rewind_ && count_in_buffer_ > 0) {
     after_rewind_ = false;
-    *data = buffer_.data();
+    *data = data_;
     position_ = count_in_buffer_;
     return count_in_buffer_;
   }
   if (count_backedup_ > 0) {  // Return the backed-up bytes.
     buffer_offset_ = count_in_buffer_ - count_backedup_;
-    *data = buffer_.data() + buffer_offset_;
+    *data = data_ + buffer_offset_;
     int backedup = count_backedup_;
     count_backedup_ = 0;
     position_ = count_in_buffer_;
@@ -78,8 +90,16 @@ crypto::tink::util::StatusOr<int> BufferedInputStream::Next(const void** data) {
   }
 
   // Otherwise, we read from input_stream_ the next chunk of data,
-  // and append it to buffer_.
+  // and append it to the buffered bytes.
   after_rewind_ = false;
+  if (borrowed_) {
+    // The bytes returned by input_stream_->Next() are valid only until
+    // the next call, so they have to be copied now.
+    buffer_.resize(count_in_buffer_);
+    memcpy(buffer_.data(), data_, count_in_buffer_);
+    data_ = buffer_.data();
+    borrowed_ = false;
+  }
   const void* buf;
   auto next_result = input_stream_->Next(&buf);
   if (!next_result.ok()) {
@@ -87,15 +107,23 @@ crypto::tink::util::StatusOr<int> BufferedInputStream::Next(const void** data) {
     return status_;
   }
   size_t count_read = next_result.ValueOrDie();
-  if (buffer_.size() < count_in_buffer_ + count_read) {
-    buffer_.resize(buffer_.size() + std::max(buffer_.size(), count_read));
-  }
-  memcpy(buffer_.data() + count_in_buffer_, buf, count_read);
   buffer_offset_ = count_in_buffer_;
   count_backedup_ = 0;
-  count_in_buffer_ += count_read;
   position_ = position_ + count_read;
-  *data = buffer_.data() + buffer_offset_;
+  if (count_in_buffer_ == 0) {
+    // Nothing is buffered yet, so the bytes are not copied, until
+    // it is needed.
+    data_ = static_cast<const uint8_t*>(buf);
+    borrowed_ = true;
+  } else {
+    if (buffer_.size() < count_in_buffer_ + count_read) {
+      buffer_.resize(buffer_.size() + std::max(buffer_.size(), count_read));
+    }
+    memcpy(buffer_.data() + count_in_buffer_, buf, count_read);
+    data_ = buffer_.data();
+  }
+  count_in_buffer_ += count_read;
+  *data = data_ + buffer_offset_;
   return count_read;
 }
 
@@ -31,6 +31,10 @@ namespace streamingaead {
 // An InputStream that initially buffers all the read bytes, and offers
 // rewind-functionality, until explicitly instructed to disable
 // rewinding (and stop buffering).
+// As long as all the bytes read so far come from a single Next()-call
+// of the underlying stream, they are not copied: rewinding returns them
+// directly from that stream's buffer, and once rewinding is disabled
+// the unread bytes are backed up to the underlying stream.
 class BufferedInputStream : public crypto::tink::InputStream {
  public:
   // Constructs an InputStream that will read from 'input_stream',
@@ -62,6 +66,10 @@ class BufferedInputStream : public crypto::tink::InputStream {
   // are directly relayed to methods of input_stream_.
   crypto::tink::util::Status status_;
   std::vector<uint8_t> buffer_;
+  // The buffered bytes: either in buffer_, or, if borrowed_ is true,
+  // the bytes returned by the last input_stream_->Next()-call.
+  const uint8_t* data_;
+  bool borrowed_;
   bool after_rewind_;       // true iff no Next has been called after rewind
   bool rewinding_enabled_;  // true iff this stream can be rewound
   int64_t position_;     // current position in the stream (from the beginning)
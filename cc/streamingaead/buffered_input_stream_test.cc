@@ -83,6 +83,28 @@ util::Status ReadFromStream(InputStream* input_stream, int count,
   return util::Status::OK;
 }
 
+// An InputStream that relays to another one, and remembers the bytes
+// returned by the last Next()-call.
+class RecordingInputStream : public InputStream {
+ public:
+  explicit RecordingInputStream(std::unique_ptr<InputStream> input_stream)
+      : input_stream_(std::move(input_stream)), last_data_(nullptr) {}
+
+  util::StatusOr<int> Next(const void** data) override {
+    auto next_result = input_stream_->Next(data);
+    last_data_ = next_result.ok() ? *data : nullptr;
+    return next_result;
+  }
+  void BackUp(int count) override { input_stream_->BackUp(count); }
+  int64_t Position() const override { return input_stream_->Position(); }
+
+  const void* last_data() const { return last_data_; }
+
+ private:
+  std::unique_ptr<InputStream> input_stream_;
+  const void* last_data_;
+};
+
 TEST(BufferedInputStreamTest, ReadingAndRewinding) {
   for (auto input_size : {0, 1, 10, 100, 1000, 10000, 100000}) {
     std::string contents = subtle::Random::GetRandomBytes(input_size);
@@ -320,6 +342,48 @@ TEST(BufferedInputStreamTest, DisableRewindingAfterRewind) {
   }
 }
 
+TEST(BufferedInputStreamTest, FirstChunkIsNotCopied) {
+  int input_size = 10000;
+  std::string contents = subtle::Random::GetRandomBytes(input_size);
+  auto recording_stream =
+      absl::make_unique<RecordingInputStream>(GetInputStream(contents));
+  RecordingInputStream* recording_stream_ref = recording_stream.get();
+  auto buf_stream = absl::make_unique<BufferedInputStream>(
+      std::move(recording_stream));
+  const void* buffer;
+
+  // Bytes from the first chunk are returned from the underlying stream's
+  // buffer, also after rewinding.
+  auto next_result = buf_stream->Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  int next_size = next_result.ValueOrDie();
+  EXPECT_EQ(recording_stream_ref->last_data(), buffer);
+  buf_stream->BackUp(next_size - 100);
+  ASSERT_THAT(buf_stream->Rewind(), IsOk());
+  next_result = buf_stream->Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  EXPECT_EQ(next_size, next_result.ValueOrDie());
+  EXPECT_EQ(recording_stream_ref->last_data(), buffer);
+  EXPECT_EQ(contents.substr(0, next_size),
+            std::string(static_cast<const char*>(buffer), next_size));
+
+  // Once rewinding is disabled, the unread bytes come directly from the
+  // underlying stream.
+  buf_stream->BackUp(next_size - 10);
+  EXPECT_EQ(10, buf_stream->Position());
+  buf_stream->DisableRewinding();
+  next_result = buf_stream->Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  EXPECT_EQ(recording_stream_ref->last_data(), buffer);
+  EXPECT_EQ(
+      contents.substr(10, next_result.ValueOrDie()),
+      std::string(static_cast<const char*>(buffer), next_result.ValueOrDie()));
+  std::string rest;
+  ASSERT_THAT(ReadFromStream(buf_stream.get(), &rest), IsOk());
+  EXPECT_EQ(input_size, buf_stream->Position());
+  EXPECT_EQ(contents.substr(10 + next_result.ValueOrDie()), rest);
+}
+
 }  // namespace
 }  // namespace streamingaead
 }  // namespace tink
@@ -29,6 +29,7 @@
 #include "tink/util/errors.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
 
 namespace crypto {
 namespace tink {
@@ -39,6 +40,32 @@ using crypto::tink::StreamingAead;
 using util::Status;
 using util::StatusOr;
 
+namespace {
+
+// Returns the RAW primitives in the order in which they are tried:
+// the primary first, as new ciphertexts are encrypted with it, so that
+// decrypting them tries a single primitive, and then all the others.
+std::vector<StreamingAead*> GetCandidates(
+    const PrimitiveSet<StreamingAead>& primitives,
+    const PrimitiveSet<StreamingAead>::Primitives& raw_primitives) {
+  std::vector<StreamingAead*> candidates;
+  candidates.reserve(raw_primitives.size());
+  const auto* primary = primitives.get_primary();
+  if (primary != nullptr &&
+      primary->get_output_prefix_type() ==
+          google::crypto::tink::OutputPrefixType::RAW) {
+    candidates.push_back(&primary->get_primitive());
+  }
+  for (const auto& primitive : raw_primitives) {
+    if (primitive.get() != primary) {
+      candidates.push_back(&primitive->get_primitive());
+    }
+  }
+  return candidates;
+}
+
+}  // namespace
+
 // static
 StatusOr<std::unique_ptr<InputStream>> DecryptingInputStream::New(
     std::shared_ptr<PrimitiveSet<StreamingAead>> primitives,
@@ -69,11 +96,11 @@ util::StatusOr<int> DecryptingInputStream::Next(const void** data) {
   if (!raw_primitives_result.ok()) {
     return Status(util::error::INTERNAL, "No RAW primitives found");
   }
-  for (auto& primitive : *(raw_primitives_result.ValueOrDie())) {
-    StreamingAead& streaming_aead = primitive->get_primitive();
+  for (StreamingAead* streaming_aead :
+       GetCandidates(*primitives_, *raw_primitives_result.ValueOrDie())) {
     auto shared_ct = absl::make_unique<SharedInputStream>(
         buffered_ct_source_.get());
-    auto decrypting_stream_result = streaming_aead.NewDecryptingStream(
+    auto decrypting_stream_result = streaming_aead->NewDecryptingStream(
         std::move(shared_ct), associated_data_);
     if (decrypting_stream_result.ok()) {
       auto next_result = decrypting_stream_result.ValueOrDie()->Next(data);
@@ -124,6 +124,99 @@ std::shared_ptr<PrimitiveSet<StreamingAead>> GetTestStreamingAeadSet(
   return saead_set;
 }
 
+// A DummyStreamingAead that counts the decrypting streams it creates.
+class CountingStreamingAead : public StreamingAead {
+ public:
+  CountingStreamingAead(absl::string_view saead_name, int* decryption_count)
+      : saead_(saead_name), decryption_count_(decryption_count) {}
+
+  util::StatusOr<std::unique_ptr<OutputStream>> NewEncryptingStream(
+      std::unique_ptr<OutputStream> ciphertext_destination,
+      absl::string_view associated_data) override {
+    return saead_.NewEncryptingStream(std::move(ciphertext_destination),
+                                      associated_data);
+  }
+
+  util::StatusOr<std::unique_ptr<InputStream>> NewDecryptingStream(
+      std::unique_ptr<InputStream> ciphertext_source,
+      absl::string_view associated_data) override {
+    (*decryption_count_)++;
+    return saead_.NewDecryptingStream(std::move(ciphertext_source),
+                                      associated_data);
+  }
+
+  util::StatusOr<std::unique_ptr<RandomAccessStream>>
+  NewDecryptingRandomAccessStream(
+      std::unique_ptr<RandomAccessStream> ciphertext_source,
+      absl::string_view associated_data) override {
+    (*decryption_count_)++;
+    return saead_.NewDecryptingRandomAccessStream(std::move(ciphertext_source),
+                                                  associated_data);
+  }
+
+ private:
+  DummyStreamingAead saead_;
+  int* decryption_count_;
+};
+
+// Returns a PrimitiveSet with 'count' CountingStreamingAead instances,
+// of which the one in the middle is the primary. The number of decrypting
+// streams created by the i-th instance is counted in 'decryption_counts[i]'.
+std::shared_ptr<PrimitiveSet<StreamingAead>> GetCountingStreamingAeadSet(
+    int count, std::vector<int>* decryption_counts) {
+  auto saead_set = std::make_shared<PrimitiveSet<StreamingAead>>();
+  decryption_counts->assign(count, 0);
+  for (int i = 0; i < count; i++) {
+    KeysetInfo::KeyInfo key_info;
+    key_info.set_output_prefix_type(OutputPrefixType::RAW);
+    key_info.set_key_id(1000 + i);
+    key_info.set_status(KeyStatusType::ENABLED);
+    auto entry_result = saead_set->AddPrimitive(
+        absl::make_unique<CountingStreamingAead>(
+            absl::StrCat("streaming_aead", i), &(*decryption_counts)[i]),
+        key_info);
+    EXPECT_THAT(entry_result.status(), IsOk());
+    if (i == count / 2) {
+      EXPECT_THAT(saead_set->set_primary(entry_result.ValueOrDie()), IsOk());
+    }
+  }
+  return saead_set;
+}
+
+TEST(DecryptingInputStreamTest, PrimaryIsTriedFirst) {
+  std::vector<int> decryption_counts;
+  auto saead_set = GetCountingStreamingAeadSet(5, &decryption_counts);
+  std::string plaintext = subtle::Random::GetRandomBytes(1000);
+  std::string aad = "some aad";
+
+  // A ciphertext of the primary is decrypted without trying the others.
+  auto dec_stream_result = DecryptingInputStream::New(
+      saead_set,
+      GetCiphertextSource(&(saead_set->get_primary()->get_primitive()),
+                          plaintext, aad),
+      aad);
+  ASSERT_THAT(dec_stream_result.status(), IsOk());
+  std::string decrypted;
+  EXPECT_THAT(ReadFromStream(dec_stream_result.ValueOrDie().get(), &decrypted),
+              IsOk());
+  EXPECT_EQ(plaintext, decrypted);
+  EXPECT_EQ((std::vector<int>{0, 0, 1, 0, 0}), decryption_counts);
+
+  // A ciphertext of another primitive is still decrypted.
+  const auto& raw_primitives = *(saead_set->get_raw_primitives().ValueOrDie());
+  auto other_dec_stream_result = DecryptingInputStream::New(
+      saead_set,
+      GetCiphertextSource(&(raw_primitives[4]->get_primitive()), plaintext,
+                          aad),
+      aad);
+  ASSERT_THAT(other_dec_stream_result.status(), IsOk());
+  EXPECT_THAT(
+      ReadFromStream(other_dec_stream_result.ValueOrDie().get(), &decrypted),
+      IsOk());
+  EXPECT_EQ(plaintext, decrypted);
+  EXPECT_EQ((std::vector<int>{1, 1, 2, 1, 1}), decryption_counts);
+}
+
 TEST(DecryptingInputStreamTest, BasicDecryption) {
   uint32_t key_id_0 = 1234543;
   uint32_t key_id_1 = 726329;
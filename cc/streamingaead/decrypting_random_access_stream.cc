@@ -16,7 +16,11 @@
 
 #include "tink/streamingaead/decrypting_random_access_stream.h"
 
+#include <atomic>
+#include <vector>
+
 #include "absl/memory/memory.h"
+#include "absl/strings/cord.h"
 #include "absl/synchronization/mutex.h"
 #include "tink/random_access_stream.h"
 #include "tink/primitive_set.h"
@@ -26,6 +30,7 @@
 #include "tink/util/errors.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
 
 namespace crypto {
 namespace tink {
@@ -36,6 +41,32 @@ using crypto::tink::StreamingAead;
 using util::Status;
 using util::StatusOr;
 
+namespace {
+
+// Returns the RAW primitives in the order in which they are tried:
+// the primary first, as new ciphertexts are encrypted with it, so that
+// decrypting them tries a single primitive, and then all the others.
+std::vector<StreamingAead*> GetCandidates(
+    const PrimitiveSet<StreamingAead>& primitives,
+    const PrimitiveSet<StreamingAead>::Primitives& raw_primitives) {
+  std::vector<StreamingAead*> candidates;
+  candidates.reserve(raw_primitives.size());
+  const auto* primary = primitives.get_primary();
+  if (primary != nullptr &&
+      primary->get_output_prefix_type() ==
+          google::crypto::tink::OutputPrefixType::RAW) {
+    candidates.push_back(&primary->get_primitive());
+  }
+  for (const auto& primitive : raw_primitives) {
+    if (primitive.get() != primary) {
+      candidates.push_back(&primitive->get_primitive());
+    }
+  }
+  return candidates;
+}
+
+}  // namespace
+
 // static
 StatusOr<std::unique_ptr<RandomAccessStream>> DecryptingRandomAccessStream::New(
     std::shared_ptr<PrimitiveSet<StreamingAead>> primitives,
@@ -72,10 +103,12 @@ util::Status DecryptingRandomAccessStream::PRead(
       return util::Status(util::error::INVALID_ARGUMENT,
                           "position cannot be negative");
     }
-    absl::ReaderMutexLock lock(&matching_mutex_);
-    if (matching_stream_ != nullptr) {
-      return matching_stream_->PRead(position, count, dest_buffer);
+    RandomAccessStream* matched_stream =
+        matched_stream_.load(std::memory_order_acquire);
+    if (matched_stream != nullptr) {
+      return matched_stream->PRead(position, count, dest_buffer);
     }
+    absl::ReaderMutexLock lock(&matching_mutex_);
     if (attempted_matching_) {
       return Status(util::error::INVALID_ARGUMENT,
                     "Did not find a decrypter matching the ciphertext stream.");
@@ -97,12 +130,12 @@ util::Status DecryptingRandomAccessStream::PRead(
   if (!raw_primitives_result.ok()) {
     return Status(util::error::INTERNAL, "No RAW primitives found");
   }
-  for (auto& primitive : *(raw_primitives_result.ValueOrDie())) {
-    StreamingAead& streaming_aead = primitive->get_primitive();
+  for (StreamingAead* streaming_aead :
+       GetCandidates(*primitives_, *raw_primitives_result.ValueOrDie())) {
     auto shared_ct = absl::make_unique<SharedRandomAccessStream>(
         ciphertext_source_.get());
     auto decrypting_stream_result =
-        streaming_aead.NewDecryptingRandomAccessStream(
+        streaming_aead->NewDecryptingRandomAccessStream(
             std::move(shared_ct), associated_data_);
     if (decrypting_stream_result.ok()) {
       auto status = decrypting_stream_result.ValueOrDie()->PRead(
@@ -110,6 +143,8 @@ util::Status DecryptingRandomAccessStream::PRead(
       if (status.ok() || status.error_code() == util::error::OUT_OF_RANGE) {
         // Found a match.
         matching_stream_ = std::move(decrypting_stream_result.ValueOrDie());
+        matched_stream_.store(matching_stream_.get(),
+                              std::memory_order_release);
         return status;
       }
     }
@@ -119,10 +154,22 @@ util::Status DecryptingRandomAccessStream::PRead(
                 "Could not find a decrypter matching the ciphertext stream.");
 }
 
+util::Status DecryptingRandomAccessStream::PReadCord(int64_t position,
+                                                     int count,
+                                                     absl::Cord* dest) {
+  RandomAccessStream* matched_stream =
+      matched_stream_.load(std::memory_order_acquire);
+  if (matched_stream != nullptr) {
+    return matched_stream->PReadCord(position, count, dest);
+  }
+  return RandomAccessStream::PReadCord(position, count, dest);
+}
+
 StatusOr<int64_t> DecryptingRandomAccessStream::size() {
-  absl::ReaderMutexLock lock(&matching_mutex_);
-  if (matching_stream_ != nullptr) {
-    return matching_stream_->size();
+  RandomAccessStream* matched_stream =
+      matched_stream_.load(std::memory_order_acquire);
+  if (matched_stream != nullptr) {
+    return matched_stream->size();
   }
   // TODO(b/139722894): attempt matching here?
   return Status(util::error::UNAVAILABLE, "no matching found yet");
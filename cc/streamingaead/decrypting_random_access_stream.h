@@ -17,9 +17,11 @@
 #ifndef TINK_STREAMINGAEAD_DECRYPTING_RANDOM_ACCESS_STREAM_H_
 #define TINK_STREAMINGAEAD_DECRYPTING_RANDOM_ACCESS_STREAM_H_
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
+#include "absl/strings/cord.h"
 #include "absl/synchronization/mutex.h"
 #include "tink/random_access_stream.h"
 #include "tink/primitive_set.h"
@@ -51,6 +53,10 @@ class DecryptingRandomAccessStream : public crypto::tink::RandomAccessStream {
   ~DecryptingRandomAccessStream() override {}
   crypto::tink::util::Status PRead(int64_t position, int count,
       crypto::tink::util::Buffer* dest_buffer) override;
+  // Forwarded to the matching stream once it has been found; until then,
+  // reads with PRead(), which finds it.
+  crypto::tink::util::Status PReadCord(int64_t position, int count,
+                                       absl::Cord* dest) override;
   crypto::tink::util::StatusOr<int64_t> size() override;
 
  private:
@@ -72,6 +78,9 @@ class DecryptingRandomAccessStream : public crypto::tink::RandomAccessStream {
   bool attempted_matching_ ABSL_GUARDED_BY(matching_mutex_);
   std::unique_ptr<crypto::tink::RandomAccessStream> matching_stream_
       ABSL_GUARDED_BY(matching_mutex_);
+  // matching_stream_.get() once a match is found. matching_stream_ is not
+  // changed afterwards, so reads use it without locking matching_mutex_.
+  std::atomic<crypto::tink::RandomAccessStream*> matched_stream_{nullptr};
 };
 
 }  // namespace streamingaead
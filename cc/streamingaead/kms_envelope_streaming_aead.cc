@@ -0,0 +1,271 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/streamingaead/kms_envelope_streaming_aead.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/internal/endian.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tink/aead.h"
+#include "tink/input_stream.h"
+#include "tink/output_stream.h"
+#include "tink/random_access_stream.h"
+#include "tink/registry.h"
+#include "tink/streaming_aead.h"
+#include "tink/tracing.h"
+#include "tink/util/buffer.h"
+#include "tink/util/input_stream_util.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+namespace {
+
+const int kEncryptedDekPrefixSize = 4;
+const char* kEmptyAssociatedData = "";
+
+// Writes 'contents' to 'output_stream'.
+util::Status WriteToStream(absl::string_view contents,
+                           OutputStream* output_stream) {
+  while (!contents.empty()) {
+    void* buffer;
+    auto next_result = output_stream->Next(&buffer);
+    if (!next_result.ok()) return next_result.status();
+    int count = std::min<int>(next_result.ValueOrDie(), contents.size());
+    std::memcpy(buffer, contents.data(), count);
+    output_stream->BackUp(next_result.ValueOrDie() - count);
+    contents.remove_prefix(count);
+  }
+  return util::Status::OK;
+}
+
+// Reads 'count' bytes at 'position' of 'stream'.
+util::StatusOr<std::string> ReadAt(RandomAccessStream* stream,
+                                   int64_t position, int count) {
+  if (count == 0) return std::string();
+  auto buffer_result = util::Buffer::New(count);
+  if (!buffer_result.ok()) return buffer_result.status();
+  auto buffer = std::move(buffer_result.ValueOrDie());
+  std::string result;
+  while (result.size() < count) {
+    auto status = stream->PRead(position + result.size(),
+                                count - result.size(), buffer.get());
+    if (!status.ok() && status.error_code() != util::error::OUT_OF_RANGE) {
+      return status;
+    }
+    result.append(buffer->get_mem_block(), buffer->size());
+    if (!status.ok() && result.size() < count) return status;
+  }
+  return result;
+}
+
+// Returns the size of the encrypted DEK given its 'prefix'.
+util::StatusOr<int> GetEncryptedDekSize(absl::string_view prefix) {
+  uint32_t size =
+      absl::big_endian::Load32(reinterpret_cast<const uint8_t*>(prefix.data()));
+  if (size > KmsEnvelopeStreamingAead::kMaxEncryptedDekSize) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid ciphertext");
+  }
+  return static_cast<int>(size);
+}
+
+// Converts the error of reading the header of a ciphertext stream.
+util::Status HeaderReadError(const util::Status& status) {
+  if (status.error_code() == util::error::OUT_OF_RANGE) {
+    return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too short");
+  }
+  return status;
+}
+
+// A RandomAccessStream of the part of another stream after 'offset' bytes,
+// i.e. of the ciphertext stream of the DEK.
+class OffsetRandomAccessStream : public RandomAccessStream {
+ public:
+  OffsetRandomAccessStream(std::unique_ptr<RandomAccessStream> stream,
+                           int64_t offset)
+      : stream_(std::move(stream)), offset_(offset) {}
+
+  util::Status PRead(int64_t position, int count,
+                     util::Buffer* dest_buffer) override {
+    if (position < 0) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "position cannot be negative");
+    }
+    return stream_->PRead(position + offset_, count, dest_buffer);
+  }
+
+  util::StatusOr<int64_t> size() override {
+    auto size_result = stream_->size();
+    if (!size_result.ok()) return size_result.status();
+    return std::max<int64_t>(size_result.ValueOrDie() - offset_, 0);
+  }
+
+ private:
+  std::unique_ptr<RandomAccessStream> stream_;
+  const int64_t offset_;
+};
+
+}  // namespace
+
+// static
+util::StatusOr<std::unique_ptr<StreamingAead>> KmsEnvelopeStreamingAead::New(
+    const google::crypto::tink::KeyTemplate& dek_template,
+    std::unique_ptr<Aead> remote_aead) {
+  if (remote_aead == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "remote_aead must be non-null");
+  }
+  auto km_result =
+      Registry::get_key_manager<StreamingAead>(dek_template.type_url());
+  if (!km_result.ok()) return km_result.status();
+  std::unique_ptr<StreamingAead> streaming_aead(
+      new KmsEnvelopeStreamingAead(dek_template, std::move(remote_aead)));
+  return std::move(streaming_aead);
+}
+
+// The streams of the DEK do not refer to its StreamingAead, which is
+// therefore not kept beyond the creation of the stream.
+util::StatusOr<std::unique_ptr<OutputStream>>
+KmsEnvelopeStreamingAead::NewEncryptingStream(
+    std::unique_ptr<OutputStream> ciphertext_destination,
+    absl::string_view associated_data) {
+  if (ciphertext_destination == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_destination must be non-null");
+  }
+  // Generate DEK.
+  auto dek_result = Registry::NewKeyData(dek_template_);
+  if (!dek_result.ok()) return dek_result.status();
+  auto dek = std::move(dek_result.ValueOrDie());
+
+  // Wrap DEK key values with remote.
+  std::unique_ptr<TraceSpan> span =
+      internal::StartSpan("tink.kms_envelope_streaming_aead.encrypt_dek");
+  auto dek_encrypt_result =
+      remote_aead_->Encrypt(dek->value(), kEmptyAssociatedData);
+  internal::EndSpan(span.get(), dek_encrypt_result.status());
+  if (!dek_encrypt_result.ok()) {
+    util::SafeZeroString(dek->mutable_value());
+    return dek_encrypt_result.status();
+  }
+
+  // Create StreamingAead from DEK.
+  auto streaming_aead_result = Registry::GetPrimitive<StreamingAead>(*dek);
+  util::SafeZeroString(dek->mutable_value());
+  if (!streaming_aead_result.ok()) return streaming_aead_result.status();
+
+  // Write the encrypted DEK, followed by the stream encrypted with the DEK.
+  const std::string& encrypted_dek = dek_encrypt_result.ValueOrDie();
+  uint8_t enc_dek_size[kEncryptedDekPrefixSize];
+  absl::big_endian::Store32(enc_dek_size, encrypted_dek.size());
+  auto status = WriteToStream(
+      absl::StrCat(
+          absl::string_view(reinterpret_cast<const char*>(enc_dek_size),
+                            kEncryptedDekPrefixSize),
+          encrypted_dek),
+      ciphertext_destination.get());
+  if (!status.ok()) return status;
+  return streaming_aead_result.ValueOrDie()->NewEncryptingStream(
+      std::move(ciphertext_destination), associated_data);
+}
+
+util::StatusOr<std::unique_ptr<StreamingAead>>
+KmsEnvelopeStreamingAead::DecryptDek(absl::string_view encrypted_dek) const {
+  auto dek_decrypt_result =
+      remote_aead_->Decrypt(encrypted_dek, kEmptyAssociatedData);
+  if (!dek_decrypt_result.ok()) {
+    return util::Status(
+        util::error::INVALID_ARGUMENT,
+        absl::StrCat("invalid ciphertext: ",
+                     dek_decrypt_result.status().error_message()));
+  }
+
+  // Create StreamingAead from DEK.
+  google::crypto::tink::KeyData dek;
+  dek.set_type_url(dek_template_.type_url());
+  dek.set_value(std::move(dek_decrypt_result.ValueOrDie()));
+  dek.set_key_material_type(google::crypto::tink::KeyData::SYMMETRIC);
+  auto streaming_aead_result = Registry::GetPrimitive<StreamingAead>(dek);
+  util::SafeZeroString(dek.mutable_value());
+  return streaming_aead_result;
+}
+
+util::StatusOr<std::unique_ptr<InputStream>>
+KmsEnvelopeStreamingAead::NewDecryptingStream(
+    std::unique_ptr<InputStream> ciphertext_source,
+    absl::string_view associated_data) {
+  if (ciphertext_source == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_source must be non-null");
+  }
+  auto prefix_result =
+      ReadBytesFromStream(kEncryptedDekPrefixSize, ciphertext_source.get());
+  if (!prefix_result.ok()) return HeaderReadError(prefix_result.status());
+  auto size_result = GetEncryptedDekSize(prefix_result.ValueOrDie());
+  if (!size_result.ok()) return size_result.status();
+  auto encrypted_dek_result =
+      ReadBytesFromStream(size_result.ValueOrDie(), ciphertext_source.get());
+  if (!encrypted_dek_result.ok()) {
+    return HeaderReadError(encrypted_dek_result.status());
+  }
+  auto streaming_aead_result = DecryptDek(encrypted_dek_result.ValueOrDie());
+  if (!streaming_aead_result.ok()) return streaming_aead_result.status();
+  return streaming_aead_result.ValueOrDie()->NewDecryptingStream(
+      std::move(ciphertext_source), associated_data);
+}
+
+util::StatusOr<std::unique_ptr<RandomAccessStream>>
+KmsEnvelopeStreamingAead::NewDecryptingRandomAccessStream(
+    std::unique_ptr<RandomAccessStream> ciphertext_source,
+    absl::string_view associated_data) {
+  if (ciphertext_source == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_source must be non-null");
+  }
+  auto prefix_result =
+      ReadAt(ciphertext_source.get(), 0, kEncryptedDekPrefixSize);
+  if (!prefix_result.ok()) return HeaderReadError(prefix_result.status());
+  auto size_result = GetEncryptedDekSize(prefix_result.ValueOrDie());
+  if (!size_result.ok()) return size_result.status();
+  int encrypted_dek_size = size_result.ValueOrDie();
+  auto encrypted_dek_result = ReadAt(
+      ciphertext_source.get(), kEncryptedDekPrefixSize, encrypted_dek_size);
+  if (!encrypted_dek_result.ok()) {
+    return HeaderReadError(encrypted_dek_result.status());
+  }
+  auto streaming_aead_result = DecryptDek(encrypted_dek_result.ValueOrDie());
+  if (!streaming_aead_result.ok()) return streaming_aead_result.status();
+  return streaming_aead_result.ValueOrDie()->NewDecryptingRandomAccessStream(
+      absl::make_unique<OffsetRandomAccessStream>(
+          std::move(ciphertext_source),
+          kEncryptedDekPrefixSize + encrypted_dek_size),
+      associated_data);
+}
+
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,91 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_STREAMINGAEAD_KMS_ENVELOPE_STREAMING_AEAD_H_
+#define TINK_STREAMINGAEAD_KMS_ENVELOPE_STREAMING_AEAD_H_
+
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "tink/aead.h"
+#include "tink/input_stream.h"
+#include "tink/output_stream.h"
+#include "tink/random_access_stream.h"
+#include "tink/streaming_aead.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+// The streaming counterpart of KmsEnvelopeAead: each ciphertext stream is
+// encrypted with a freshly generated streaming data encryption key (DEK),
+// e.g. an AES-GCM-HKDF key, which is encrypted by a remote AEAD backed by a
+// KMS. Encrypting or decrypting a stream of any size thus takes one remote
+// call.
+//
+// The ciphertext structure is as follows:
+//  - Length of encrypted DEK: 4 bytes (big endian)
+//  - Encrypted DEK: variable length that is equal to the value
+//    specified in the last 4 bytes.
+//  - Ciphertext stream of the DEK: variable length.
+class KmsEnvelopeStreamingAead : public StreamingAead {
+ public:
+  // The maximal size of an encrypted DEK accepted for decryption.
+  static constexpr int kMaxEncryptedDekSize = 16 * 1024;
+
+  // 'dek_template' must be a template of a StreamingAead key type that is
+  // registered, e.g. StreamingAeadKeyTemplates::Aes256GcmHkdf1MB().
+  static crypto::tink::util::StatusOr<std::unique_ptr<StreamingAead>> New(
+      const google::crypto::tink::KeyTemplate& dek_template,
+      std::unique_ptr<Aead> remote_aead);
+
+  crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::OutputStream>>
+  NewEncryptingStream(
+      std::unique_ptr<crypto::tink::OutputStream> ciphertext_destination,
+      absl::string_view associated_data) override;
+
+  crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::InputStream>>
+  NewDecryptingStream(
+      std::unique_ptr<crypto::tink::InputStream> ciphertext_source,
+      absl::string_view associated_data) override;
+
+  crypto::tink::util::StatusOr<
+      std::unique_ptr<crypto::tink::RandomAccessStream>>
+  NewDecryptingRandomAccessStream(
+      std::unique_ptr<crypto::tink::RandomAccessStream> ciphertext_source,
+      absl::string_view associated_data) override;
+
+  ~KmsEnvelopeStreamingAead() override {}
+
+ private:
+  KmsEnvelopeStreamingAead(
+      const google::crypto::tink::KeyTemplate& dek_template,
+      std::unique_ptr<Aead> remote_aead)
+      : dek_template_(dek_template), remote_aead_(std::move(remote_aead)) {}
+
+  // Returns the StreamingAead of the DEK encrypted as 'encrypted_dek'.
+  crypto::tink::util::StatusOr<std::unique_ptr<StreamingAead>> DecryptDek(
+      absl::string_view encrypted_dek) const;
+
+  google::crypto::tink::KeyTemplate dek_template_;
+  std::unique_ptr<Aead> remote_aead_;
+};
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_STREAMINGAEAD_KMS_ENVELOPE_STREAMING_AEAD_H_
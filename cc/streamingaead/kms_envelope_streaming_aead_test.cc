@@ -0,0 +1,227 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/streamingaead/kms_envelope_streaming_aead.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/base/internal/endian.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/input_stream.h"
+#include "tink/output_stream.h"
+#include "tink/streaming_aead.h"
+#include "tink/streamingaead/streaming_aead_config.h"
+#include "tink/streamingaead/streaming_aead_key_templates.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/buffer.h"
+#include "tink/util/file_random_access_stream.h"
+#include "tink/util/istream_input_stream.h"
+#include "tink/util/ostream_output_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using crypto::tink::subtle::test::ReadFromStream;
+using crypto::tink::subtle::test::WriteToStream;
+using crypto::tink::test::DummyAead;
+using crypto::tink::test::IsOk;
+using crypto::tink::test::StatusIs;
+
+// A remote AEAD that counts the calls made to it.
+class CountingAead : public Aead {
+ public:
+  CountingAead(absl::string_view name, int* encryptions, int* decryptions)
+      : aead_(name), encryptions_(encryptions), decryptions_(decryptions) {}
+
+  util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view associated_data) const override {
+    ++*encryptions_;
+    return aead_.Encrypt(plaintext, associated_data);
+  }
+
+  util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view associated_data) const override {
+    ++*decryptions_;
+    return aead_.Decrypt(ciphertext, associated_data);
+  }
+
+ private:
+  DummyAead aead_;
+  int* encryptions_;
+  int* decryptions_;
+};
+
+class KmsEnvelopeStreamingAeadTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_THAT(StreamingAeadConfig::Register(), IsOk());
+  }
+
+  std::unique_ptr<StreamingAead> NewEnvelopeStreamingAead(
+      absl::string_view kms_key_name) {
+    auto result = KmsEnvelopeStreamingAead::New(
+        StreamingAeadKeyTemplates::Aes128GcmHkdf4KB(),
+        absl::make_unique<CountingAead>(kms_key_name, &encryptions_,
+                                        &decryptions_));
+    EXPECT_THAT(result.status(), IsOk());
+    return std::move(result.ValueOrDie());
+  }
+
+  int encryptions_ = 0;
+  int decryptions_ = 0;
+};
+
+std::string Encrypt(StreamingAead* streaming_aead, absl::string_view plaintext,
+                    absl::string_view associated_data) {
+  auto ct_stream = absl::make_unique<std::stringstream>();
+  auto ct_buf = ct_stream->rdbuf();
+  auto enc_stream_result = streaming_aead->NewEncryptingStream(
+      absl::make_unique<util::OstreamOutputStream>(std::move(ct_stream)),
+      associated_data);
+  EXPECT_THAT(enc_stream_result.status(), IsOk());
+  EXPECT_THAT(WriteToStream(enc_stream_result.ValueOrDie().get(), plaintext),
+              IsOk());
+  return ct_buf->str();
+}
+
+util::StatusOr<std::string> Decrypt(StreamingAead* streaming_aead,
+                                    absl::string_view ciphertext,
+                                    absl::string_view associated_data) {
+  auto dec_stream_result = streaming_aead->NewDecryptingStream(
+      absl::make_unique<util::IstreamInputStream>(
+          absl::make_unique<std::stringstream>(std::string(ciphertext))),
+      associated_data);
+  if (!dec_stream_result.ok()) return dec_stream_result.status();
+  std::string plaintext;
+  auto status =
+      ReadFromStream(dec_stream_result.ValueOrDie().get(), &plaintext);
+  if (!status.ok()) return status;
+  return plaintext;
+}
+
+TEST_F(KmsEnvelopeStreamingAeadTest, EncryptDecrypt) {
+  auto streaming_aead = NewEnvelopeStreamingAead("kms-key");
+  std::string associated_data = "some associated data";
+  for (int pt_size : {0, 1, 100, 10000, 100000}) {
+    SCOPED_TRACE(absl::StrCat("pt_size = ", pt_size));
+    encryptions_ = 0;
+    decryptions_ = 0;
+    std::string pt = subtle::Random::GetRandomBytes(pt_size);
+    std::string ct = Encrypt(streaming_aead.get(), pt, associated_data);
+    auto dec_result = Decrypt(streaming_aead.get(), ct, associated_data);
+    ASSERT_THAT(dec_result.status(), IsOk());
+    EXPECT_EQ(dec_result.ValueOrDie(), pt);
+    // A single remote call per stream.
+    EXPECT_EQ(encryptions_, 1);
+    EXPECT_EQ(decryptions_, 1);
+  }
+}
+
+TEST_F(KmsEnvelopeStreamingAeadTest, CiphertextStructure) {
+  auto streaming_aead = NewEnvelopeStreamingAead("kms-key");
+  std::string ct = Encrypt(streaming_aead.get(), "some plaintext", "");
+  ASSERT_GE(ct.size(), 4);
+  uint32_t enc_dek_size =
+      absl::big_endian::Load32(reinterpret_cast<const uint8_t*>(ct.data()));
+  ASSERT_LE(enc_dek_size, ct.size() - 4);
+  // The encrypted DEK is the ciphertext of DummyAead.
+  EXPECT_EQ(ct.substr(4, enc_dek_size).find("kms-key"), 0);
+}
+
+TEST_F(KmsEnvelopeStreamingAeadTest, RandomAccessDecryption) {
+  auto streaming_aead = NewEnvelopeStreamingAead("kms-key");
+  std::string associated_data = "some associated data";
+  std::string pt = subtle::Random::GetRandomBytes(20000);
+  std::string ct = Encrypt(streaming_aead.get(), pt, associated_data);
+  auto dec_stream_result = streaming_aead->NewDecryptingRandomAccessStream(
+      absl::make_unique<util::FileRandomAccessStream>(
+          test::GetTestFileDescriptor("kms_envelope_streaming_aead_ct", ct)),
+      associated_data);
+  ASSERT_THAT(dec_stream_result.status(), IsOk());
+  auto dec_stream = std::move(dec_stream_result.ValueOrDie());
+  auto size_result = dec_stream->size();
+  ASSERT_THAT(size_result.status(), IsOk());
+  EXPECT_EQ(size_result.ValueOrDie(), pt.size());
+  for (int position : {0, 1, 4095, 4096, 12345}) {
+    SCOPED_TRACE(absl::StrCat("position = ", position));
+    auto buffer = std::move(util::Buffer::New(1000).ValueOrDie());
+    auto status = dec_stream->PRead(position, 1000, buffer.get());
+    ASSERT_THAT(status, IsOk());
+    EXPECT_EQ(std::string(buffer->get_mem_block(), buffer->size()),
+              pt.substr(position, 1000));
+  }
+}
+
+TEST_F(KmsEnvelopeStreamingAeadTest, WrongAssociatedDataOrKmsKey) {
+  auto streaming_aead = NewEnvelopeStreamingAead("kms-key");
+  std::string ct =
+      Encrypt(streaming_aead.get(), "some plaintext", "associated data");
+  EXPECT_FALSE(
+      Decrypt(streaming_aead.get(), ct, "wrong associated data").ok());
+  auto other_streaming_aead = NewEnvelopeStreamingAead("other-kms-key");
+  EXPECT_THAT(
+      Decrypt(other_streaming_aead.get(), ct, "associated data").status(),
+      StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(KmsEnvelopeStreamingAeadTest, InvalidHeader) {
+  auto streaming_aead = NewEnvelopeStreamingAead("kms-key");
+  std::string large_size(4, '\0');
+  absl::big_endian::Store32(
+      &large_size[0], KmsEnvelopeStreamingAead::kMaxEncryptedDekSize + 1);
+  for (const std::string& ct :
+       {std::string(""), std::string("\0\0", 2),
+        std::string("\0\0\0\x10" "abc", 7), large_size}) {
+    SCOPED_TRACE(absl::StrCat("ct = ", absl::CEscape(ct)));
+    EXPECT_THAT(Decrypt(streaming_aead.get(), ct, "").status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+}
+
+TEST_F(KmsEnvelopeStreamingAeadTest, InvalidParameters) {
+  int encryptions = 0;
+  int decryptions = 0;
+  EXPECT_THAT(KmsEnvelopeStreamingAead::New(
+                  StreamingAeadKeyTemplates::Aes128GcmHkdf4KB(), nullptr)
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  // The DEK must be a streaming AEAD key.
+  EXPECT_FALSE(KmsEnvelopeStreamingAead::New(
+                   AeadKeyTemplates::Aes128Gcm(),
+                   absl::make_unique<CountingAead>("kms-key", &encryptions,
+                                                   &decryptions))
+                   .ok());
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
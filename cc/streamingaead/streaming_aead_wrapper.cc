@@ -16,14 +16,21 @@
 
 #include "tink/streamingaead/streaming_aead_wrapper.h"
 
+#include <memory>
+#include <utility>
+
+#include "absl/memory/memory.h"
 #include "tink/streaming_aead.h"
 #include "tink/crypto_format.h"
 #include "tink/input_stream.h"
+#include "tink/monitoring_client.h"
 #include "tink/output_stream.h"
 #include "tink/primitive_set.h"
 #include "tink/random_access_stream.h"
 #include "tink/streamingaead/decrypting_input_stream.h"
 #include "tink/streamingaead/decrypting_random_access_stream.h"
+#include "tink/tracing.h"
+#include "tink/util/buffer.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
@@ -52,6 +59,125 @@ Status Validate(PrimitiveSet<StreamingAead>* primitives) {
   return Status::OK;
 }
 
+// The attribute of stream spans holding the number of plaintext bytes.
+constexpr char kBytesAttribute[] = "bytes";
+
+// Forwards to an encrypting stream, and ends 'span' when it is closed or
+// destroyed.
+class TracedOutputStream : public OutputStream {
+ public:
+  TracedOutputStream(std::unique_ptr<OutputStream> stream,
+                     std::unique_ptr<TraceSpan> span)
+      : stream_(std::move(stream)), span_(std::move(span)) {}
+
+  StatusOr<int> Next(void** data) override {
+    auto result = stream_->Next(data);
+    if (!result.ok()) End(result.status());
+    return result;
+  }
+
+  void BackUp(int count) override { stream_->BackUp(count); }
+
+  Status Close() override {
+    Status status = stream_->Close();
+    End(status);
+    return status;
+  }
+
+  int64_t Position() const override { return stream_->Position(); }
+
+  ~TracedOutputStream() override {
+    End(Status(util::error::CANCELLED, "stream destroyed before Close()"));
+  }
+
+ private:
+  void End(const Status& status) {
+    if (span_ == nullptr) return;
+    span_->SetAttribute(kBytesAttribute, stream_->Position());
+    span_->End(status);
+    span_ = nullptr;
+  }
+
+  std::unique_ptr<OutputStream> stream_;
+  std::unique_ptr<TraceSpan> span_;
+};
+
+// Forwards to a decrypting stream, and ends 'span' once the end of the
+// stream or an error is reached, or when it is destroyed.
+class TracedInputStream : public InputStream {
+ public:
+  TracedInputStream(std::unique_ptr<InputStream> stream,
+                    std::unique_ptr<TraceSpan> span)
+      : stream_(std::move(stream)), span_(std::move(span)) {}
+
+  StatusOr<int> Next(const void** data) override {
+    auto result = stream_->Next(data);
+    if (!result.ok()) {
+      End(result.status().error_code() == util::error::OUT_OF_RANGE
+              ? Status::OK
+              : result.status());
+    }
+    return result;
+  }
+
+  void BackUp(int count) override { stream_->BackUp(count); }
+
+  int64_t Position() const override { return stream_->Position(); }
+
+  ~TracedInputStream() override {
+    End(Status(util::error::CANCELLED,
+               "stream destroyed before reaching its end"));
+  }
+
+ private:
+  void End(const Status& status) {
+    if (span_ == nullptr) return;
+    span_->SetAttribute(kBytesAttribute, stream_->Position());
+    span_->End(status);
+    span_ = nullptr;
+  }
+
+  std::unique_ptr<InputStream> stream_;
+  std::unique_ptr<TraceSpan> span_;
+};
+
+// Forwards to a decrypting random access stream, and ends 'span' with the
+// first error other than reaching the end of the stream, or with OK when it
+// is destroyed.
+class TracedRandomAccessStream : public RandomAccessStream {
+ public:
+  TracedRandomAccessStream(std::unique_ptr<RandomAccessStream> stream,
+                           std::unique_ptr<TraceSpan> span)
+      : stream_(std::move(stream)), span_(std::move(span)) {}
+
+  Status PRead(int64_t position, int count,
+               util::Buffer* dest_buffer) override {
+    Status status = stream_->PRead(position, count, dest_buffer);
+    if (status.ok() || status.error_code() == util::error::OUT_OF_RANGE) {
+      bytes_read_ += dest_buffer->size();
+    } else {
+      End(status);
+    }
+    return status;
+  }
+
+  StatusOr<int64_t> size() override { return stream_->size(); }
+
+  ~TracedRandomAccessStream() override { End(Status::OK); }
+
+ private:
+  void End(const Status& status) {
+    if (span_ == nullptr) return;
+    span_->SetAttribute(kBytesAttribute, bytes_read_);
+    span_->End(status);
+    span_ = nullptr;
+  }
+
+  std::unique_ptr<RandomAccessStream> stream_;
+  std::unique_ptr<TraceSpan> span_;
+  int64_t bytes_read_ = 0;
+};
+
 class StreamingAeadSetWrapper: public StreamingAead {
  public:
   explicit StreamingAeadSetWrapper(
@@ -89,24 +215,53 @@ StatusOr<std::unique_ptr<OutputStream>>
 StreamingAeadSetWrapper::NewEncryptingStream(
     std::unique_ptr<OutputStream> ciphertext_destination,
     absl::string_view associated_data) {
-  return primitives_->get_primary()->get_primitive().NewEncryptingStream(
-          std::move(ciphertext_destination), associated_data);
+  std::unique_ptr<TraceSpan> span =
+      internal::StartSpan("tink.streaming_aead.encrypting_stream");
+  // Only creating the stream is monitored, which writes the header and
+  // derives the keys; decrypting streams find their key while being read.
+  internal::MonitoredOperation monitored("streaming_aead",
+                                         "new_encrypting_stream", 0);
+  const auto* primary = primitives_->get_primary();
+  auto stream_result = primary->get_primitive().NewEncryptingStream(
+      std::move(ciphertext_destination), associated_data);
+  if (stream_result.ok()) monitored.Success(primary->get_key_id());
+  if (span == nullptr || !stream_result.ok()) {
+    internal::EndSpan(span.get(), stream_result.status());
+    return stream_result;
+  }
+  return {absl::make_unique<TracedOutputStream>(
+      std::move(stream_result.ValueOrDie()), std::move(span))};
 }
 
 StatusOr<std::unique_ptr<InputStream>>
 StreamingAeadSetWrapper::NewDecryptingStream(
     std::unique_ptr<InputStream> ciphertext_source,
     absl::string_view associated_data) {
-  return {streamingaead::DecryptingInputStream::New(
-      primitives_, std::move(ciphertext_source), associated_data)};
+  auto stream_result = streamingaead::DecryptingInputStream::New(
+      primitives_, std::move(ciphertext_source), associated_data);
+  if (!stream_result.ok()) return stream_result.status();
+  std::unique_ptr<InputStream> stream = std::move(stream_result.ValueOrDie());
+  std::unique_ptr<TraceSpan> span =
+      internal::StartSpan("tink.streaming_aead.decrypting_stream");
+  if (span == nullptr) return std::move(stream);
+  return {absl::make_unique<TracedInputStream>(std::move(stream),
+                                               std::move(span))};
 }
 
 StatusOr<std::unique_ptr<RandomAccessStream>>
 StreamingAeadSetWrapper::NewDecryptingRandomAccessStream(
     std::unique_ptr<RandomAccessStream> ciphertext_source,
     absl::string_view associated_data) {
-  return {streamingaead::DecryptingRandomAccessStream::New(
-      primitives_, std::move(ciphertext_source), associated_data)};
+  auto stream_result = streamingaead::DecryptingRandomAccessStream::New(
+      primitives_, std::move(ciphertext_source), associated_data);
+  if (!stream_result.ok()) return stream_result.status();
+  std::unique_ptr<RandomAccessStream> stream =
+      std::move(stream_result.ValueOrDie());
+  std::unique_ptr<TraceSpan> span = internal::StartSpan(
+      "tink.streaming_aead.decrypting_random_access_stream");
+  if (span == nullptr) return std::move(stream);
+  return {absl::make_unique<TracedRandomAccessStream>(std::move(stream),
+                                                      std::move(span))};
 }
 
 }  // anonymous namespace
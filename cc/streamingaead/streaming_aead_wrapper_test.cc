@@ -23,12 +23,15 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "tink/input_stream.h"
+#include "tink/latency_histogram_monitoring_client.h"
+#include "tink/monitoring_client.h"
 #include "tink/output_stream.h"
 #include "tink/primitive_set.h"
 #include "tink/random_access_stream.h"
 #include "tink/streaming_aead.h"
 #include "tink/subtle/random.h"
 #include "tink/subtle/test_util.h"
+#include "tink/tracing.h"
 #include "tink/util/buffer.h"
 #include "tink/util/file_random_access_stream.h"
 #include "tink/util/istream_input_stream.h"
@@ -320,6 +323,121 @@ TEST(StreamingAeadSetWrapperTest, MissingRawPrimitives) {
                                              HasSubstr("no raw primitives")));
 }
 
+// Records the names of the spans it creates, and the status and "bytes"
+// attribute they end with.
+class RecordingTracer : public Tracer {
+ public:
+  struct Record {
+    std::string name;
+    int64_t bytes = -1;
+    bool ended = false;
+    util::Status status;
+  };
+
+  std::unique_ptr<TraceSpan> StartSpan(absl::string_view name) override {
+    records.push_back(absl::make_unique<Record>());
+    records.back()->name = std::string(name);
+    return absl::make_unique<Span>(records.back().get());
+  }
+
+  std::vector<std::unique_ptr<Record>> records;
+
+ private:
+  class Span : public TraceSpan {
+   public:
+    explicit Span(Record* record) : record_(record) {}
+    void SetAttribute(absl::string_view key, int64_t value) override {
+      if (key == "bytes") record_->bytes = value;
+    }
+    void End(const util::Status& status) override {
+      record_->ended = true;
+      record_->status = status;
+    }
+
+   private:
+    Record* record_;
+  };
+};
+
+TEST(StreamingAeadSetWrapperTest, TracesStreams) {
+  auto saead_set = GetTestStreamingAeadSet(
+      {{1234543, "streaming_aead0", OutputPrefixType::RAW}});
+  auto wrap_result = StreamingAeadWrapper().Wrap(std::move(saead_set));
+  ASSERT_THAT(wrap_result.status(), IsOk());
+  auto saead = std::move(wrap_result.ValueOrDie());
+  RecordingTracer tracer;
+  SetTracer(&tracer);
+  std::string plaintext = subtle::Random::GetRandomBytes(100);
+  std::string aad = "some_aad";
+
+  auto ct_stream = absl::make_unique<std::stringstream>();
+  auto ct_buf = ct_stream->rdbuf();
+  auto enc_stream_result = saead->NewEncryptingStream(
+      absl::make_unique<util::OstreamOutputStream>(std::move(ct_stream)),
+      aad);
+  ASSERT_THAT(enc_stream_result.status(), IsOk());
+  ASSERT_EQ(tracer.records.size(), 1);
+  EXPECT_FALSE(tracer.records[0]->ended);
+  EXPECT_THAT(WriteToStream(enc_stream_result.ValueOrDie().get(), plaintext),
+              IsOk());
+  EXPECT_EQ(tracer.records[0]->name, "tink.streaming_aead.encrypting_stream");
+  EXPECT_TRUE(tracer.records[0]->ended);
+  EXPECT_THAT(tracer.records[0]->status, IsOk());
+  EXPECT_EQ(tracer.records[0]->bytes, plaintext.size());
+
+  auto dec_stream_result = saead->NewDecryptingStream(
+      absl::make_unique<util::IstreamInputStream>(
+          absl::make_unique<std::stringstream>(ct_buf->str())),
+      aad);
+  ASSERT_THAT(dec_stream_result.status(), IsOk());
+  std::string decrypted;
+  EXPECT_THAT(ReadFromStream(dec_stream_result.ValueOrDie().get(), &decrypted),
+              IsOk());
+  EXPECT_EQ(decrypted, plaintext);
+  ASSERT_EQ(tracer.records.size(), 2);
+  EXPECT_EQ(tracer.records[1]->name, "tink.streaming_aead.decrypting_stream");
+  EXPECT_TRUE(tracer.records[1]->ended);
+  EXPECT_THAT(tracer.records[1]->status, IsOk());
+  EXPECT_EQ(tracer.records[1]->bytes, plaintext.size());
+
+  auto ra_stream_result = saead->NewDecryptingRandomAccessStream(
+      GetRandomAccessStream(ct_buf->str()), aad);
+  ASSERT_THAT(ra_stream_result.status(), IsOk());
+  EXPECT_THAT(ReadAll(ra_stream_result.ValueOrDie().get(), &decrypted),
+              StatusIs(util::error::OUT_OF_RANGE));
+  ASSERT_EQ(tracer.records.size(), 3);
+  EXPECT_FALSE(tracer.records[2]->ended);
+  ra_stream_result.ValueOrDie().reset();
+  EXPECT_EQ(tracer.records[2]->name,
+            "tink.streaming_aead.decrypting_random_access_stream");
+  EXPECT_TRUE(tracer.records[2]->ended);
+  EXPECT_THAT(tracer.records[2]->status, IsOk());
+  EXPECT_EQ(tracer.records[2]->bytes, plaintext.size());
+  SetTracer(nullptr);
+}
+
+TEST(StreamingAeadSetWrapperTest, MonitorsEncryptingStreams) {
+  auto saead_set = GetTestStreamingAeadSet(
+      {{1234543, "streaming_aead0", OutputPrefixType::RAW}});
+  auto wrap_result = StreamingAeadWrapper().Wrap(std::move(saead_set));
+  ASSERT_THAT(wrap_result.status(), IsOk());
+  LatencyHistogramMonitoringClient client;
+  SetMonitoringClient(&client);
+  auto enc_stream_result = wrap_result.ValueOrDie()->NewEncryptingStream(
+      absl::make_unique<util::OstreamOutputStream>(
+          absl::make_unique<std::stringstream>()),
+      "some_aad");
+  SetMonitoringClient(nullptr);
+  ASSERT_THAT(enc_stream_result.status(), IsOk());
+
+  std::vector<LatencyHistogram> histograms = client.Snapshot();
+  ASSERT_EQ(histograms.size(), 1);
+  EXPECT_EQ(histograms[0].primitive, "streaming_aead");
+  EXPECT_EQ(histograms[0].api_function, "new_encrypting_stream");
+  EXPECT_EQ(histograms[0].key_id, 1234543);
+  EXPECT_EQ(histograms[0].count, 1);
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
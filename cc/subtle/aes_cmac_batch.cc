@@ -0,0 +1,172 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/aes_cmac_batch.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "openssl/evp.h"
+#include "tink/subtle/subtle_util.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+namespace {
+
+constexpr size_t kBlockSize = 16;
+
+const EVP_CIPHER* GetAesEcbCipherForKeySize(size_t size_in_bytes) {
+  switch (size_in_bytes) {
+    case 16:
+      return EVP_aes_128_ecb();
+    case 32:
+      return EVP_aes_256_ecb();
+    default:
+      return nullptr;
+  }
+}
+
+// Multiplies 'block' by x in GF(2^128), as in the subkey generation of
+// RFC 4493.
+void MultiplyByX(uint8_t block[kBlockSize]) {
+  uint8_t carry = 0x87 & -(block[0] >> 7);
+  for (size_t i = 0; i < kBlockSize - 1; ++i) {
+    block[i] = (block[i] << 1) | (block[i + 1] >> 7);
+  }
+  block[kBlockSize - 1] = (block[kBlockSize - 1] << 1) ^ carry;
+}
+
+// The number of blocks CMAC processes for a message of 'size' bytes.
+size_t NumBlocks(size_t size) {
+  return std::max<size_t>(1, (size + kBlockSize - 1) / kBlockSize);
+}
+
+}  // namespace
+
+util::Status ComputeAesCmacBatch(const util::SecretData& key,
+                                 absl::Span<const absl::string_view> data,
+                                 size_t tag_size, std::string* tags) {
+  ResizeStringUninitialized(tags, data.size() * tag_size);
+  return ComputeAesCmacBatch(
+      key, data, tag_size,
+      absl::MakeSpan(reinterpret_cast<uint8_t*>(&(*tags)[0]), tags->size()));
+}
+
+util::Status ComputeAesCmacBatch(const util::SecretData& key,
+                                 absl::Span<const absl::string_view> data,
+                                 size_t tag_size, absl::Span<uint8_t> tags) {
+  const EVP_CIPHER* cipher = GetAesEcbCipherForKeySize(key.size());
+  if (cipher == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid key size");
+  }
+  if (tag_size > kBlockSize) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid tag size");
+  }
+  if (tags.size() != data.size() * tag_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "invalid size of the output buffer");
+  }
+  bssl::UniquePtr<EVP_CIPHER_CTX> ctx(EVP_CIPHER_CTX_new());
+  if (ctx.get() == nullptr ||
+      EVP_EncryptInit_ex(ctx.get(), cipher, nullptr /* engine */, key.data(),
+                         nullptr /* iv */) != 1 ||
+      EVP_CIPHER_CTX_set_padding(ctx.get(), 0) != 1) {
+    return util::Status(util::error::INTERNAL,
+                        "could not initialize EVP_CIPHER_CTX");
+  }
+
+  // States of the lanes, the blocks encrypted in the current step, and the
+  // lane each of these blocks belongs to. The CMAC subkeys k1 and k2 are
+  // derived from the encryption of the zero block.
+  util::SecretData states(kAesCmacBatchLanes * kBlockSize);
+  util::SecretData blocks(kAesCmacBatchLanes * kBlockSize, 0);
+  util::SecretData k1(kBlockSize, 0);
+  std::array<size_t, kAesCmacBatchLanes> lanes;
+  int len;
+  if (EVP_EncryptUpdate(ctx.get(), k1.data(), &len, k1.data(), kBlockSize) !=
+      1) {
+    return util::Status(util::error::INTERNAL, "encryption failed");
+  }
+  MultiplyByX(k1.data());
+  util::SecretData k2(k1);
+  MultiplyByX(k2.data());
+
+  for (size_t first = 0; first < data.size(); first += kAesCmacBatchLanes) {
+    const size_t num_lanes =
+        std::min(kAesCmacBatchLanes, data.size() - first);
+    std::fill(states.begin(), states.end(), 0);
+    size_t steps = 0;
+    for (size_t lane = 0; lane < num_lanes; lane++) {
+      steps = std::max(steps, NumBlocks(data[first + lane].size()));
+    }
+    for (size_t step = 0; step < steps; step++) {
+      size_t num_blocks = 0;
+      for (size_t lane = 0; lane < num_lanes; lane++) {
+        absl::string_view message = data[first + lane];
+        const size_t message_blocks = NumBlocks(message.size());
+        if (step >= message_blocks) continue;
+        const uint8_t* state = &states[lane * kBlockSize];
+        uint8_t* block = &blocks[num_blocks * kBlockSize];
+        const uint8_t* in =
+            reinterpret_cast<const uint8_t*>(message.data()) +
+            step * kBlockSize;
+        if (step + 1 < message_blocks) {
+          for (size_t i = 0; i < kBlockSize; i++) {
+            block[i] = state[i] ^ in[i];
+          }
+        } else {
+          // The last block is xored with k1 if it is complete, and padded
+          // and xored with k2 otherwise.
+          const size_t last_size = message.size() - step * kBlockSize;
+          const uint8_t* subkey = last_size == kBlockSize ? k1.data()
+                                                          : k2.data();
+          for (size_t i = 0; i < kBlockSize; i++) {
+            uint8_t padded =
+                i < last_size ? in[i] : (i == last_size ? 0x80 : 0x00);
+            block[i] = state[i] ^ padded ^ subkey[i];
+          }
+        }
+        lanes[num_blocks++] = lane;
+      }
+      if (EVP_EncryptUpdate(ctx.get(), blocks.data(), &len, blocks.data(),
+                            num_blocks * kBlockSize) != 1) {
+        return util::Status(util::error::INTERNAL, "encryption failed");
+      }
+      for (size_t i = 0; i < num_blocks; i++) {
+        std::copy_n(&blocks[i * kBlockSize], kBlockSize,
+                    &states[lanes[i] * kBlockSize]);
+      }
+    }
+    for (size_t lane = 0; lane < num_lanes; lane++) {
+      std::copy_n(&states[lane * kBlockSize], tag_size,
+                  tags.data() + (first + lane) * tag_size);
+    }
+  }
+  return util::Status::OK;
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
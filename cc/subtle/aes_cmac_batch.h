@@ -0,0 +1,58 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_SUBTLE_AES_CMAC_BATCH_H_
+#define TINK_SUBTLE_AES_CMAC_BATCH_H_
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// The number of messages processed concurrently by ComputeAesCmacBatch().
+constexpr size_t kAesCmacBatchLanes = 8;
+
+// Computes the AES-CMAC (RFC 4493) of each of 'data' under 'key', which must
+// be 16 or 32 bytes long, and stores the first 'tag_size' (at most 16) bytes
+// of each of them back to back in 'tags'.
+//
+// CMAC is sequential within a message, but independent across messages.
+// Hence the messages are processed in groups of kAesCmacBatchLanes: in each
+// step the next block of every message of the group is encrypted with a
+// single ECB call, which BoringSSL pipelines through the AES hardware.
+crypto::tink::util::Status ComputeAesCmacBatch(
+    const util::SecretData& key, absl::Span<const absl::string_view> data,
+    size_t tag_size, std::string* tags);
+
+// As above, but writes the tags into 'tags', which must hold exactly
+// data.size() * tag_size bytes.
+crypto::tink::util::Status ComputeAesCmacBatch(
+    const util::SecretData& key, absl::Span<const absl::string_view> data,
+    size_t tag_size, absl::Span<uint8_t> tags);
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_AES_CMAC_BATCH_H_
@@ -0,0 +1,144 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/aes_cmac_batch.h"
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "openssl/cmac.h"
+#include "tink/subtle/random.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+std::string AesCmac(const util::SecretData& key, absl::string_view data) {
+  uint8_t tag[16];
+  EXPECT_EQ(AES_CMAC(tag, key.data(), key.size(),
+                     reinterpret_cast<const uint8_t*>(data.data()),
+                     data.size()),
+            1);
+  return std::string(reinterpret_cast<const char*>(tag), sizeof(tag));
+}
+
+// Test vectors from RFC 4493, Section 4.
+TEST(AesCmacBatchTest, Rfc4493TestVectors) {
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("2b7e151628aed2a6abf7158809cf4f3c"));
+  std::string message = test::HexDecodeOrDie(
+      "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+      "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+  std::vector<absl::string_view> data = {
+      absl::string_view(message).substr(0, 0),
+      absl::string_view(message).substr(0, 16),
+      absl::string_view(message).substr(0, 40),
+      absl::string_view(message).substr(0, 64)};
+  std::string tags;
+  ASSERT_THAT(ComputeAesCmacBatch(key, data, 16, &tags), IsOk());
+  EXPECT_EQ(test::HexEncode(tags),
+            "bb1d6929e95937287fa37d129b756746"
+            "070a16b46b4d4144f79bdd9dd04a287c"
+            "dfa66747de9ae63030ca32611497c827"
+            "51f0bebf7e3b9d92fc49741779363cfe");
+}
+
+TEST(AesCmacBatchTest, MatchesSingleMessageCmac) {
+  for (size_t key_size : {16, 32}) {
+    util::SecretData key =
+        util::SecretDataFromStringView(Random::GetRandomBytes(key_size));
+    // Messages of all sizes up to a few blocks, so that the lanes of a group
+    // finish at different steps and groups are partially filled.
+    std::vector<std::string> messages;
+    for (size_t size = 0; size < 70; size++) {
+      messages.push_back(Random::GetRandomBytes(size));
+    }
+    messages.push_back(Random::GetRandomBytes(1000));
+    std::vector<absl::string_view> data(messages.begin(), messages.end());
+    for (size_t tag_size : {16, 10}) {
+      std::string tags;
+      ASSERT_THAT(ComputeAesCmacBatch(key, data, tag_size, &tags), IsOk());
+      ASSERT_EQ(tags.size(), messages.size() * tag_size);
+      for (size_t i = 0; i < messages.size(); i++) {
+        EXPECT_EQ(tags.substr(i * tag_size, tag_size),
+                  AesCmac(key, messages[i]).substr(0, tag_size))
+            << "message size: " << messages[i].size();
+      }
+    }
+  }
+}
+
+TEST(AesCmacBatchTest, EmptyBatch) {
+  util::SecretData key =
+      util::SecretDataFromStringView(Random::GetRandomBytes(32));
+  std::string tags = "not empty";
+  EXPECT_THAT(ComputeAesCmacBatch(key, {}, 16, &tags), IsOk());
+  EXPECT_TRUE(tags.empty());
+}
+
+TEST(AesCmacBatchTest, InvalidParameters) {
+  std::vector<absl::string_view> data = {"data"};
+  std::string tags;
+  EXPECT_THAT(
+      ComputeAesCmacBatch(
+          util::SecretDataFromStringView(Random::GetRandomBytes(24)), data,
+          16, &tags),
+      StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(
+      ComputeAesCmacBatch(
+          util::SecretDataFromStringView(Random::GetRandomBytes(32)), data,
+          17, &tags),
+      StatusIs(util::error::INVALID_ARGUMENT));
+  std::vector<uint8_t> buffer(15);
+  EXPECT_THAT(
+      ComputeAesCmacBatch(
+          util::SecretDataFromStringView(Random::GetRandomBytes(32)), data,
+          16, absl::MakeSpan(buffer)),
+      StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(AesCmacBatchTest, WritesIntoBuffer) {
+  util::SecretData key =
+      util::SecretDataFromStringView(Random::GetRandomBytes(32));
+  std::vector<std::string> messages = {"", "a", std::string(100, 'b')};
+  std::vector<absl::string_view> data(messages.begin(), messages.end());
+  std::vector<uint8_t> buffer(3 * 10);
+  ASSERT_THAT(ComputeAesCmacBatch(key, data, 10, absl::MakeSpan(buffer)),
+              IsOk());
+  for (size_t i = 0; i < messages.size(); i++) {
+    EXPECT_EQ(std::string(buffer.begin() + 10 * i,
+                          buffer.begin() + 10 * (i + 1)),
+              AesCmac(key, messages[i]).substr(0, 10));
+  }
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -16,11 +16,14 @@
 
 #include "tink/subtle/aes_cmac_boringssl.h"
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "openssl/cmac.h"
 #include "openssl/mem.h"
+#include "tink/subtle/aes_cmac_batch.h"
 #include "tink/subtle/subtle_util.h"
 #include "tink/subtle/subtle_util_boringssl.h"
 #include "tink/util/status.h"
@@ -81,7 +84,53 @@ util::Status AesCmacBoringSsl::VerifyMac(absl::string_view mac,
                         "BoringSSL failed to compute CMAC");
   }
   if (CRYPTO_memcmp(buf, mac.data(), tag_size_) != 0) {
-    return util::Status(util::error::INVALID_ARGUMENT, "verification failed");
+    static const util::Status* kVerificationFailed =
+        util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                                "verification failed");
+    return *kVerificationFailed;
+  }
+  return util::OkStatus();
+}
+
+util::Status AesCmacBoringSsl::ComputeMacBatch(
+    absl::Span<const absl::string_view> data, std::string* macs,
+    std::vector<int64_t>* offsets) const {
+  util::Status status = ComputeAesCmacBatch(key_, data, tag_size_, macs);
+  if (!status.ok()) return status;
+  offsets->resize(data.size() + 1);
+  for (size_t i = 0; i <= data.size(); i++) {
+    (*offsets)[i] = i * tag_size_;
+  }
+  return util::OkStatus();
+}
+
+util::Status AesCmacBoringSsl::VerifyMacBatch(
+    absl::Span<const absl::string_view> mac_values,
+    absl::Span<const absl::string_view> data, bool stop_at_first_failure,
+    std::vector<util::Status>* results) const {
+  if (mac_values.size() != data.size()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "mac_values and data must have the same size");
+  }
+  std::string tags;
+  util::Status status = ComputeAesCmacBatch(key_, data, tag_size_, &tags);
+  if (!status.ok()) return status;
+  static const util::Status* kVerificationFailed =
+      util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                              "verification failed");
+  // All tags are computed anyway, so every item is reported.
+  results->clear();
+  results->reserve(data.size());
+  for (size_t i = 0; i < data.size(); i++) {
+    if (mac_values[i].size() != tag_size_) {
+      results->push_back(
+          util::Status(util::error::INVALID_ARGUMENT, "incorrect tag size"));
+    } else if (CRYPTO_memcmp(&tags[i * tag_size_], mac_values[i].data(),
+                             tag_size_) != 0) {
+      results->push_back(*kVerificationFailed);
+    } else {
+      results->push_back(util::OkStatus());
+    }
   }
   return util::OkStatus();
 }
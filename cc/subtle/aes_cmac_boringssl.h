@@ -17,8 +17,14 @@
 #ifndef TINK_SUBTLE_AES_CMAC_BORINGSSL_H_
 #define TINK_SUBTLE_AES_CMAC_BORINGSSL_H_
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 
 #include "tink/mac.h"
 #include "tink/config/tink_fips.h"
@@ -43,6 +49,19 @@ class AesCmacBoringSsl : public Mac {
   crypto::tink::util::Status VerifyMac(absl::string_view mac,
                                        absl::string_view data) const override;
 
+  // Interleaves the CMAC computations of several messages, see
+  // ComputeAesCmacBatch().
+  crypto::tink::util::Status ComputeMacBatch(
+      absl::Span<const absl::string_view> data, std::string* macs,
+      std::vector<int64_t>* offsets) const override;
+
+  // Computes the CMACs of all items with ComputeAesCmacBatch(), so the key
+  // is expanded only once, and compares them afterwards.
+  crypto::tink::util::Status VerifyMacBatch(
+      absl::Span<const absl::string_view> mac_values,
+      absl::Span<const absl::string_view> data, bool stop_at_first_failure,
+      std::vector<crypto::tink::util::Status>* results) const override;
+
   static constexpr crypto::tink::FipsCompatibility kFipsStatus =
       crypto::tink::FipsCompatibility::kNotFips;
 
@@ -17,6 +17,7 @@
 #include "tink/subtle/aes_cmac_boringssl.h"
 
 #include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "tink/config/tink_fips.h"
@@ -200,6 +201,38 @@ TEST(AesCmacBoringSslTest, TruncationOrAdditionSmallTag) {
   }
 }
 
+TEST(AesCmacBoringSslTest, VerifyMacBatch) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  util::SecretData key = util::SecretDataFromStringView(test::HexDecodeOrDie(
+      "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"));
+  auto mac_result = AesCmacBoringSsl::New(key, kTagSize);
+  ASSERT_TRUE(mac_result.ok()) << mac_result.status();
+  auto mac = std::move(mac_result.ValueOrDie());
+  std::vector<std::string> data = {"first", "", "third", "fourth"};
+  std::vector<std::string> tags;
+  for (const std::string& message : data) {
+    tags.push_back(mac->ComputeMac(message).ValueOrDie());
+  }
+  tags[2][0] ^= 1;
+  tags[3].pop_back();
+  std::vector<absl::string_view> tag_views(tags.begin(), tags.end());
+  std::vector<absl::string_view> data_views(data.begin(), data.end());
+  std::vector<util::Status> results;
+  ASSERT_TRUE(mac->VerifyMacBatch(tag_views, data_views,
+                                  /*stop_at_first_failure=*/false, &results)
+                  .ok());
+  ASSERT_EQ(results.size(), data.size());
+  EXPECT_TRUE(results[0].ok()) << results[0];
+  EXPECT_TRUE(results[1].ok()) << results[1];
+  EXPECT_THAT(results[2], StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(results[3], StatusIs(util::error::INVALID_ARGUMENT));
+
+  EXPECT_THAT(mac->VerifyMacBatch(tag_views, {}, false, &results),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
 TEST(AesCmacBoringSslTest, InvalidKeySizes) {
   if (kUseOnlyFips) {
     GTEST_SKIP() << "Not supported in FIPS-only mode";
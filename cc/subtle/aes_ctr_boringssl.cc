@@ -19,17 +19,34 @@
 #include <string>
 
 #include "absl/memory/memory.h"
+#include "absl/types/span.h"
 #include "openssl/evp.h"
 #include "tink/config/tink_fips.h"
 #include "tink/subtle/random.h"
 #include "tink/subtle/subtle_util.h"
 #include "tink/subtle/subtle_util_boringssl.h"
+#include "tink/subtle/thread_local_context.h"
 #include "tink/util/status.h"
 
 namespace crypto {
 namespace tink {
 namespace subtle {
 
+AesCtrBoringSsl::AesCtrBoringSsl(bssl::UniquePtr<EVP_CIPHER_CTX> keyed_ctx,
+                                 int iv_size)
+    : keyed_ctx_(std::move(keyed_ctx)),
+      // Copying the keyed context keeps its key schedule.
+      ctx_([this]()
+               -> util::StatusOr<std::unique_ptr<bssl::ScopedEVP_CIPHER_CTX>> {
+        auto ctx = absl::make_unique<bssl::ScopedEVP_CIPHER_CTX>();
+        if (EVP_CIPHER_CTX_copy(ctx->get(), keyed_ctx_.get()) != 1) {
+          return util::Status(util::error::INTERNAL,
+                              "could not copy EVP_CIPHER_CTX");
+        }
+        return std::move(ctx);
+      }),
+      iv_size_(iv_size) {}
+
 util::StatusOr<std::unique_ptr<IndCpaCipher>> AesCtrBoringSsl::New(
     util::SecretData key, int iv_size) {
   auto status = CheckFipsCompatibility<AesCtrBoringSsl>();
@@ -43,8 +60,17 @@ util::StatusOr<std::unique_ptr<IndCpaCipher>> AesCtrBoringSsl::New(
   if (iv_size < kMinIvSizeInBytes || iv_size > kBlockSize) {
     return util::Status(util::error::INVALID_ARGUMENT, "invalid iv size");
   }
-  return {
-      absl::WrapUnique(new AesCtrBoringSsl(std::move(key), iv_size, cipher))};
+  bssl::UniquePtr<EVP_CIPHER_CTX> keyed_ctx(EVP_CIPHER_CTX_new());
+  if (keyed_ctx.get() == nullptr) {
+    return util::Status(util::error::INTERNAL,
+                        "could not initialize EVP_CIPHER_CTX");
+  }
+  if (EVP_EncryptInit_ex(keyed_ctx.get(), cipher, nullptr /* engine */,
+                         reinterpret_cast<const uint8_t*>(key.data()),
+                         nullptr /* iv */) != 1) {
+    return util::Status(util::error::INTERNAL, "could not initialize ctx");
+  }
+  return {absl::WrapUnique(new AesCtrBoringSsl(std::move(keyed_ctx), iv_size))};
 }
 
 util::StatusOr<std::string> AesCtrBoringSsl::Encrypt(
@@ -53,12 +79,11 @@ util::StatusOr<std::string> AesCtrBoringSsl::Encrypt(
   // the size is 0.
   plaintext = SubtleUtilBoringSSL::EnsureNonNull(plaintext);
 
-  bssl::UniquePtr<EVP_CIPHER_CTX> ctx(EVP_CIPHER_CTX_new());
-  if (ctx.get() == nullptr) {
-    return util::Status(util::error::INTERNAL,
-                        "could not initialize EVP_CIPHER_CTX");
-  }
-  std::string ciphertext = Random::GetRandomBytes(iv_size_);
+  auto ctx_result = ctx_.Get();
+  if (!ctx_result.ok()) return ctx_result.status();
+  EVP_CIPHER_CTX* ctx = ctx_result.ValueOrDie()->get();
+  std::string ciphertext(iv_size_, '\0');
+  Random::GetRandomNonceBytes(absl::MakeSpan(&ciphertext[0], iv_size_));
   // OpenSSL expects that the IV must be a full block. We pad with zeros.
   std::string iv_block = ciphertext;
   // Note that kBlockSize >= iv_size_ is checked in the factory method.
@@ -66,16 +91,16 @@ util::StatusOr<std::string> AesCtrBoringSsl::Encrypt(
   // the new memory.
   iv_block.resize(kBlockSize, '\0');
 
-  int ret =
-      EVP_EncryptInit_ex(ctx.get(), cipher_, nullptr /* engine */, key_.data(),
-                         reinterpret_cast<const uint8_t*>(&iv_block[0]));
+  int ret = EVP_EncryptInit_ex(ctx, nullptr /* cipher */,
+                               nullptr /* engine */, nullptr /* key */,
+                               reinterpret_cast<const uint8_t*>(&iv_block[0]));
   if (ret != 1) {
     return util::Status(util::error::INTERNAL, "could not initialize ctx");
   }
   ResizeStringUninitialized(&ciphertext, iv_size_ + plaintext.size());
   int len;
   ret = EVP_EncryptUpdate(
-      ctx.get(), reinterpret_cast<uint8_t*>(&ciphertext[iv_size_]), &len,
+      ctx, reinterpret_cast<uint8_t*>(&ciphertext[iv_size_]), &len,
       reinterpret_cast<const uint8_t*>(plaintext.data()), plaintext.size());
   if (ret != 1) {
     return util::Status(util::error::INTERNAL, "encryption failed");
@@ -92,21 +117,18 @@ util::StatusOr<std::string> AesCtrBoringSsl::Decrypt(
     return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too short");
   }
 
-  bssl::UniquePtr<EVP_CIPHER_CTX> ctx(EVP_CIPHER_CTX_new());
-  if (ctx.get() == nullptr) {
-    return util::Status(util::error::INTERNAL,
-                        "could not initialize EVP_CIPHER_CTX");
-  }
+  auto ctx_result = ctx_.Get();
+  if (!ctx_result.ok()) return ctx_result.status();
+  EVP_CIPHER_CTX* ctx = ctx_result.ValueOrDie()->get();
 
-  // Initialise key and IV
+  // Initialise the IV
   std::string iv_block = std::string(ciphertext.substr(0, iv_size_));
   iv_block.resize(kBlockSize, '\0');
-  int ret = EVP_DecryptInit_ex(ctx.get(), cipher_, nullptr /* engine */,
-                               reinterpret_cast<const uint8_t*>(key_.data()),
+  int ret = EVP_DecryptInit_ex(ctx, nullptr /* cipher */,
+                               nullptr /* engine */, nullptr /* key */,
                                reinterpret_cast<const uint8_t*>(&iv_block[0]));
   if (ret != 1) {
-    return util::Status(util::error::INTERNAL,
-                        "could not initialize key or iv");
+    return util::Status(util::error::INTERNAL, "could not initialize iv");
   }
 
   size_t plaintext_size = ciphertext.size() - iv_size_;
@@ -115,7 +137,7 @@ util::StatusOr<std::string> AesCtrBoringSsl::Decrypt(
   size_t read = iv_size_;
   int len;
   ret = EVP_DecryptUpdate(
-      ctx.get(), reinterpret_cast<uint8_t*>(&plaintext[0]), &len,
+      ctx, reinterpret_cast<uint8_t*>(&plaintext[0]), &len,
       reinterpret_cast<const uint8_t*>(&ciphertext.data()[read]),
       plaintext_size);
   if (ret != 1) {
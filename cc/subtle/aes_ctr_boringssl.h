@@ -23,6 +23,7 @@
 #include "openssl/evp.h"
 #include "tink/config/tink_fips.h"
 #include "tink/subtle/ind_cpa_cipher.h"
+#include "tink/subtle/thread_local_context.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/statusor.h"
 
@@ -48,13 +49,13 @@ class AesCtrBoringSsl : public IndCpaCipher {
   static constexpr int kMinIvSizeInBytes = 12;
   static constexpr int kBlockSize = 16;
 
-  AesCtrBoringSsl(util::SecretData key, int iv_size, const EVP_CIPHER* cipher)
-      : key_(std::move(key)), iv_size_(iv_size), cipher_(cipher) {}
+  AesCtrBoringSsl(bssl::UniquePtr<EVP_CIPHER_CTX> keyed_ctx, int iv_size);
 
-  const util::SecretData key_;
+  // Holds the key schedule, computed once in New(). Encrypt() and Decrypt()
+  // work on a per-thread copy of it, which only needs the IV to be set.
+  const bssl::UniquePtr<EVP_CIPHER_CTX> keyed_ctx_;
+  const ThreadLocalContext<bssl::ScopedEVP_CIPHER_CTX> ctx_;
   const int iv_size_;
-  // cipher_ is a singleton owned by BoringSsl.
-  const EVP_CIPHER *cipher_;
 };
 
 }  // namespace subtle
@@ -17,6 +17,7 @@
 #include "tink/subtle/aes_ctr_boringssl.h"
 
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -156,6 +157,40 @@ TEST(AesCtrBoringSslTest, TestMultipleEncrypt) {
   EXPECT_NE(ct1.ValueOrDie(), ct2.ValueOrDie());
 }
 
+TEST(AesCtrBoringSslTest, TestConcurrentUse) {
+  if (kUseOnlyFips && !FIPS_mode()) {
+    GTEST_SKIP()
+        << "Test should not run in FIPS mode when BoringCrypto is unavailable.";
+  }
+
+  // NIST SP 800-38A pp 55, as in TestNistTestVector.
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("2b7e151628aed2a6abf7158809cf4f3c"));
+  std::string ciphertext(test::HexDecodeOrDie(
+      "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff874d6191b620e3261bef6864990db6ce"));
+  std::string message(test::HexDecodeOrDie("6bc1bee22e409f96e93d7e117393172a"));
+  auto res = AesCtrBoringSsl::New(key, 16);
+  ASSERT_THAT(res.status(), IsOk());
+  const IndCpaCipher& cipher = *res.ValueOrDie();
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j < 1000; j++) {
+        auto pt = cipher.Decrypt(ciphertext);
+        ASSERT_THAT(pt.status(), IsOk());
+        EXPECT_EQ(pt.ValueOrDie(), message);
+        auto ct = cipher.Encrypt(message);
+        ASSERT_THAT(ct.status(), IsOk());
+        pt = cipher.Decrypt(ct.ValueOrDie());
+        ASSERT_THAT(pt.status(), IsOk());
+        EXPECT_EQ(pt.ValueOrDie(), message);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+}
+
 TEST(AesCtrBoringSslTest, TestFipsOnly) {
   if (kUseOnlyFips && !FIPS_mode()) {
     GTEST_SKIP()
@@ -0,0 +1,307 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/aes_ctr_hmac_boringssl.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/types/span.h"
+#include "openssl/crypto.h"
+#include "openssl/evp.h"
+#include "openssl/hmac.h"
+#include "tink/config/tink_fips.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/subtle_util.h"
+#include "tink/subtle/subtle_util_boringssl.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+namespace {
+
+// Encrypts 'size' bytes of 'in' into 'out' with 'cipher_ctx', and feeds the
+// output (if 'mac_output') or else the input to 'hmac_ctx'. Works in chunks
+// of 'chunk_size' bytes, so that the data is fed to HMAC while it is still in
+// cache. In CTR mode decryption is the same operation, so this also decrypts.
+util::Status CtrHmacUpdate(EVP_CIPHER_CTX* cipher_ctx, HMAC_CTX* hmac_ctx,
+                           const uint8_t* in, uint8_t* out, size_t size,
+                           bool mac_output, size_t chunk_size) {
+  for (size_t offset = 0; offset < size; offset += chunk_size) {
+    size_t n = std::min(chunk_size, size - offset);
+    if (!mac_output && !HMAC_Update(hmac_ctx, in + offset, n)) {
+      return util::Status(util::error::INTERNAL, "HMAC update failed");
+    }
+    int len;
+    if (EVP_EncryptUpdate(cipher_ctx, out + offset, &len, in + offset, n) !=
+            1 ||
+        len != n) {
+      return util::Status(util::error::INTERNAL, "AES-CTR update failed");
+    }
+    if (mac_output && !HMAC_Update(hmac_ctx, out + offset, n)) {
+      return util::Status(util::error::INTERNAL, "HMAC update failed");
+    }
+  }
+  return util::OkStatus();
+}
+
+}  // namespace
+
+util::StatusOr<std::unique_ptr<Aead>> AesCtrHmacBoringSsl::New(
+    const util::SecretData& aes_key, int iv_size, HashType hmac_hash,
+    const util::SecretData& hmac_key, int tag_size) {
+  auto status = CheckFipsCompatibility<AesCtrHmacBoringSsl>();
+  if (!status.ok()) return status;
+
+  const EVP_CIPHER* cipher =
+      SubtleUtilBoringSSL::GetAesCtrCipherForKeySize(aes_key.size());
+  if (cipher == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid key size");
+  }
+  if (iv_size < kMinIvSizeInBytes || iv_size > kBlockSize) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid iv size");
+  }
+  auto md_result = SubtleUtilBoringSSL::EvpHash(hmac_hash);
+  if (!md_result.ok()) return md_result.status();
+  const EVP_MD* md = md_result.ValueOrDie();
+  if (tag_size < kMinTagSizeInBytes || tag_size > EVP_MD_size(md)) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid tag size");
+  }
+  if (hmac_key.size() < kMinHmacKeySizeInBytes) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "invalid HMAC key size");
+  }
+
+  bssl::UniquePtr<EVP_CIPHER_CTX> keyed_cipher_ctx(EVP_CIPHER_CTX_new());
+  if (keyed_cipher_ctx.get() == nullptr ||
+      EVP_EncryptInit_ex(keyed_cipher_ctx.get(), cipher, nullptr /* engine */,
+                         reinterpret_cast<const uint8_t*>(aes_key.data()),
+                         nullptr /* iv */) != 1) {
+    return util::Status(util::error::INTERNAL,
+                        "could not initialize EVP_CIPHER_CTX");
+  }
+  bssl::UniquePtr<HMAC_CTX> keyed_hmac_ctx(HMAC_CTX_new());
+  if (keyed_hmac_ctx.get() == nullptr ||
+      !HMAC_Init_ex(keyed_hmac_ctx.get(), hmac_key.data(), hmac_key.size(), md,
+                    nullptr /* engine */)) {
+    return util::Status(util::error::INTERNAL, "HMAC initialization failed");
+  }
+  return {absl::WrapUnique(new AesCtrHmacBoringSsl(
+      std::move(keyed_cipher_ctx), std::move(keyed_hmac_ctx), iv_size,
+      tag_size))};
+}
+
+// A PreparedAead holding the HMAC state after the associated data.
+class AesCtrHmacBoringSsl::PreparedAesCtrHmac : public PreparedAead {
+ public:
+  PreparedAesCtrHmac(const AesCtrHmacBoringSsl* aead,
+                     absl::string_view additional_data,
+                     bssl::UniquePtr<HMAC_CTX> aad_hmac_ctx)
+      : aead_(aead),
+        additional_data_(additional_data),
+        aad_hmac_ctx_(std::move(aad_hmac_ctx)) {}
+
+  util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext) const override {
+    return aead_->EncryptWithAadState(plaintext, additional_data_,
+                                      aad_hmac_ctx_.get());
+  }
+
+  util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext) const override {
+    return aead_->DecryptWithAadState(ciphertext, additional_data_,
+                                      aad_hmac_ctx_.get());
+  }
+
+ private:
+  const AesCtrHmacBoringSsl* aead_;
+  // Only its size is used, for the final block of the tag input.
+  const std::string additional_data_;
+  const bssl::UniquePtr<HMAC_CTX> aad_hmac_ctx_;
+};
+
+util::StatusOr<std::unique_ptr<PreparedAead>>
+AesCtrHmacBoringSsl::PrepareAssociatedData(
+    absl::string_view additional_data) const {
+  if (additional_data.size() > UINT64_MAX / 8) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "additional data too long");
+  }
+  additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
+  bssl::UniquePtr<HMAC_CTX> aad_hmac_ctx(HMAC_CTX_new());
+  if (aad_hmac_ctx.get() == nullptr ||
+      !HMAC_CTX_copy_ex(aad_hmac_ctx.get(), keyed_hmac_ctx_.get()) ||
+      !HMAC_Update(aad_hmac_ctx.get(),
+                   reinterpret_cast<const uint8_t*>(additional_data.data()),
+                   additional_data.size())) {
+    return util::Status(util::error::INTERNAL, "HMAC update failed");
+  }
+  return {absl::make_unique<PreparedAesCtrHmac>(this, additional_data,
+                                                std::move(aad_hmac_ctx))};
+}
+
+util::Status AesCtrHmacBoringSsl::InitContexts(
+    absl::string_view iv, absl::string_view additional_data,
+    const HMAC_CTX* aad_hmac_ctx, EVP_CIPHER_CTX* cipher_ctx,
+    HMAC_CTX* hmac_ctx) const {
+  if (EVP_CIPHER_CTX_copy(cipher_ctx, keyed_cipher_ctx_.get()) != 1 ||
+      !HMAC_CTX_copy_ex(hmac_ctx, aad_hmac_ctx != nullptr
+                                      ? aad_hmac_ctx
+                                      : keyed_hmac_ctx_.get())) {
+    return util::Status(util::error::INTERNAL, "could not copy contexts");
+  }
+  // The IV is padded with zeros to a full block. Only the IV is set, the
+  // context keeps its key schedule.
+  uint8_t iv_block[kBlockSize] = {0};
+  std::memcpy(iv_block, iv.data(), iv.size());
+  if (EVP_EncryptInit_ex(cipher_ctx, nullptr /* cipher */, nullptr /* engine */,
+                         nullptr /* key */, iv_block) != 1) {
+    return util::Status(util::error::INTERNAL, "could not initialize iv");
+  }
+  if ((aad_hmac_ctx == nullptr &&
+       !HMAC_Update(hmac_ctx,
+                    reinterpret_cast<const uint8_t*>(additional_data.data()),
+                    additional_data.size())) ||
+      !HMAC_Update(hmac_ctx, reinterpret_cast<const uint8_t*>(iv.data()),
+                   iv.size())) {
+    return util::Status(util::error::INTERNAL, "HMAC update failed");
+  }
+  return util::OkStatus();
+}
+
+util::Status AesCtrHmacBoringSsl::FinalizeTag(absl::string_view additional_data,
+                                              HMAC_CTX* hmac_ctx,
+                                              uint8_t* tag) const {
+  uint64_t aad_size_in_bits = static_cast<uint64_t>(additional_data.size()) * 8;
+  uint8_t aad_size_bytes[8];
+  for (int i = sizeof(aad_size_bytes) - 1; i >= 0; i--) {
+    aad_size_bytes[i] = aad_size_in_bits & 0xff;
+    aad_size_in_bits >>= 8;
+  }
+  uint8_t buf[EVP_MAX_MD_SIZE];
+  unsigned int buf_len;
+  if (!HMAC_Update(hmac_ctx, aad_size_bytes, sizeof(aad_size_bytes)) ||
+      !HMAC_Final(hmac_ctx, buf, &buf_len)) {
+    return util::Status(util::error::INTERNAL, "HMAC finalization failed");
+  }
+  std::memcpy(tag, buf, tag_size_);
+  return util::OkStatus();
+}
+
+util::StatusOr<std::string> AesCtrHmacBoringSsl::Encrypt(
+    absl::string_view plaintext, absl::string_view additional_data) const {
+  return EncryptWithAadState(plaintext, additional_data, nullptr);
+}
+
+util::StatusOr<std::string> AesCtrHmacBoringSsl::Decrypt(
+    absl::string_view ciphertext, absl::string_view additional_data) const {
+  return DecryptWithAadState(ciphertext, additional_data, nullptr);
+}
+
+util::StatusOr<std::string> AesCtrHmacBoringSsl::EncryptWithAadState(
+    absl::string_view plaintext, absl::string_view additional_data,
+    const HMAC_CTX* aad_hmac_ctx) const {
+  // BoringSSL expects a non-null pointer for plaintext and additional_data,
+  // regardless of whether the size is 0.
+  plaintext = SubtleUtilBoringSSL::EnsureNonNull(plaintext);
+  additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
+  if (additional_data.size() > UINT64_MAX / 8) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "additional data too long");
+  }
+
+  std::string ciphertext;
+  ResizeStringUninitialized(&ciphertext,
+                            iv_size_ + plaintext.size() + tag_size_);
+  Random::GetRandomNonceBytes(absl::MakeSpan(&ciphertext[0], iv_size_));
+  uint8_t* out = reinterpret_cast<uint8_t*>(&ciphertext[0]);
+
+  bssl::ScopedEVP_CIPHER_CTX cipher_ctx;
+  bssl::ScopedHMAC_CTX hmac_ctx;
+  auto status =
+      InitContexts(absl::string_view(ciphertext.data(), iv_size_),
+                   additional_data, aad_hmac_ctx, cipher_ctx.get(),
+                   hmac_ctx.get());
+  if (!status.ok()) return status;
+  status = CtrHmacUpdate(
+      cipher_ctx.get(), hmac_ctx.get(),
+      reinterpret_cast<const uint8_t*>(plaintext.data()), out + iv_size_,
+      plaintext.size(), /*mac_output=*/true, kChunkSize);
+  if (!status.ok()) return status;
+  status = FinalizeTag(additional_data, hmac_ctx.get(),
+                       out + iv_size_ + plaintext.size());
+  if (!status.ok()) return status;
+  return ciphertext;
+}
+
+util::StatusOr<std::string> AesCtrHmacBoringSsl::DecryptWithAadState(
+    absl::string_view ciphertext, absl::string_view additional_data,
+    const HMAC_CTX* aad_hmac_ctx) const {
+  // BoringSSL expects a non-null pointer for additional_data,
+  // regardless of whether the size is 0.
+  additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
+  if (ciphertext.size() < iv_size_ + tag_size_) {
+    return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too short");
+  }
+  if (additional_data.size() > UINT64_MAX / 8) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "additional data too long");
+  }
+
+  size_t plaintext_size = ciphertext.size() - iv_size_ - tag_size_;
+  bssl::ScopedEVP_CIPHER_CTX cipher_ctx;
+  bssl::ScopedHMAC_CTX hmac_ctx;
+  auto status =
+      InitContexts(ciphertext.substr(0, iv_size_), additional_data,
+                   aad_hmac_ctx, cipher_ctx.get(), hmac_ctx.get());
+  if (!status.ok()) return status;
+
+  std::string plaintext;
+  ResizeStringUninitialized(&plaintext, plaintext_size);
+  // BoringSSL expects a non-null pointer for the output.
+  uint8_t empty_buffer;
+  uint8_t* out = plaintext.empty()
+                     ? &empty_buffer
+                     : reinterpret_cast<uint8_t*>(&plaintext[0]);
+  status = CtrHmacUpdate(
+      cipher_ctx.get(), hmac_ctx.get(),
+      reinterpret_cast<const uint8_t*>(ciphertext.data()) + iv_size_, out,
+      plaintext_size, /*mac_output=*/false, kChunkSize);
+  if (!status.ok()) return status;
+
+  uint8_t tag[EVP_MAX_MD_SIZE];
+  status = FinalizeTag(additional_data, hmac_ctx.get(), tag);
+  if (!status.ok()) return status;
+  if (CRYPTO_memcmp(tag, ciphertext.data() + iv_size_ + plaintext_size,
+                    tag_size_) != 0) {
+    static const util::Status* kVerificationFailed =
+        util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                                "verification failed");
+    return *kVerificationFailed;
+  }
+  return plaintext;
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,127 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_SUBTLE_AES_CTR_HMAC_BORINGSSL_H_
+#define TINK_SUBTLE_AES_CTR_HMAC_BORINGSSL_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "openssl/base.h"
+#include "openssl/evp.h"
+#include "openssl/hmac.h"
+#include "tink/aead.h"
+#include "tink/config/tink_fips.h"
+#include "tink/subtle/common_enums.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// AES-CTR-HMAC AEAD, producing the same ciphertexts as EncryptThenAuthenticate
+// with AesCtrBoringSsl and HmacBoringSsl, i.e. (iv || ciphertext || tag) with
+// the tag computed over (additional_data || iv || ciphertext || t), where t is
+// the length of additional_data in bits as 64-bit big endian integer.
+//
+// Unlike EncryptThenAuthenticate, it makes a single pass over the data: each
+// chunk of ciphertext is fed to HMAC right after it is encrypted (or before it
+// is decrypted), while it is still in cache, and the tag input is never
+// concatenated into a separate string.
+class AesCtrHmacBoringSsl : public Aead {
+ public:
+  static crypto::tink::util::StatusOr<std::unique_ptr<Aead>> New(
+      const util::SecretData& aes_key, int iv_size, HashType hmac_hash,
+      const util::SecretData& hmac_key, int tag_size);
+
+  crypto::tink::util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view additional_data) const override;
+
+  // The plaintext is decrypted while the tag is computed, but only returned
+  // once the tag has been verified.
+  crypto::tink::util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view additional_data) const override;
+
+  // Feeds 'additional_data' to HMAC once, so that the returned object starts
+  // each tag computation from that state.
+  crypto::tink::util::StatusOr<std::unique_ptr<PreparedAead>>
+  PrepareAssociatedData(absl::string_view additional_data) const override;
+
+  static constexpr crypto::tink::FipsCompatibility kFipsStatus =
+      crypto::tink::FipsCompatibility::kRequiresBoringCrypto;
+
+ private:
+  class PreparedAesCtrHmac;
+
+  static constexpr int kMinIvSizeInBytes = 12;
+  static constexpr int kBlockSize = 16;
+  static constexpr int kMinHmacKeySizeInBytes = 16;
+  static constexpr int kMinTagSizeInBytes = 10;
+  // Number of bytes encrypted (or decrypted) before they are fed to HMAC.
+  static constexpr size_t kChunkSize = 8192;
+
+  AesCtrHmacBoringSsl(bssl::UniquePtr<EVP_CIPHER_CTX> keyed_cipher_ctx,
+                      bssl::UniquePtr<HMAC_CTX> keyed_hmac_ctx, int iv_size,
+                      int tag_size)
+      : keyed_cipher_ctx_(std::move(keyed_cipher_ctx)),
+        keyed_hmac_ctx_(std::move(keyed_hmac_ctx)),
+        iv_size_(iv_size),
+        tag_size_(tag_size) {}
+
+  // Copies the keyed contexts into 'cipher_ctx' and 'hmac_ctx', sets the IV
+  // of 'cipher_ctx' and feeds 'additional_data' and 'iv' to 'hmac_ctx'. If
+  // 'aad_hmac_ctx' is not null, it holds the HMAC state after
+  // 'additional_data' and is copied instead of feeding 'additional_data'.
+  util::Status InitContexts(absl::string_view iv,
+                            absl::string_view additional_data,
+                            const HMAC_CTX* aad_hmac_ctx,
+                            EVP_CIPHER_CTX* cipher_ctx,
+                            HMAC_CTX* hmac_ctx) const;
+
+  // Feeds the length of 'additional_data' to 'hmac_ctx' and writes the
+  // truncated tag to 'tag'.
+  util::Status FinalizeTag(absl::string_view additional_data,
+                           HMAC_CTX* hmac_ctx, uint8_t* tag) const;
+
+  // Encrypt() and Decrypt(), with the optional 'aad_hmac_ctx' of
+  // InitContexts().
+  crypto::tink::util::StatusOr<std::string> EncryptWithAadState(
+      absl::string_view plaintext, absl::string_view additional_data,
+      const HMAC_CTX* aad_hmac_ctx) const;
+  crypto::tink::util::StatusOr<std::string> DecryptWithAadState(
+      absl::string_view ciphertext, absl::string_view additional_data,
+      const HMAC_CTX* aad_hmac_ctx) const;
+
+  // Both contexts are keyed once in New() and only ever copied afterwards.
+  const bssl::UniquePtr<EVP_CIPHER_CTX> keyed_cipher_ctx_;
+  const bssl::UniquePtr<HMAC_CTX> keyed_hmac_ctx_;
+  const int iv_size_;
+  const int tag_size_;
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_AES_CTR_HMAC_BORINGSSL_H_
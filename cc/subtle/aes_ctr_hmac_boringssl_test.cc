@@ -0,0 +1,211 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/aes_ctr_hmac_boringssl.h"
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "openssl/crypto.h"
+#include "tink/aead.h"
+#include "tink/config/tink_fips.h"
+#include "tink/subtle/aes_ctr_boringssl.h"
+#include "tink/subtle/common_enums.h"
+#include "tink/subtle/encrypt_then_authenticate.h"
+#include "tink/subtle/hmac_boringssl.h"
+#include "tink/subtle/random.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+constexpr int kIvSize = 12;
+constexpr int kTagSize = 16;
+
+// Returns the AES-CTR-HMAC AEAD built from the separate primitives, which
+// AesCtrHmacBoringSsl must be compatible with.
+util::StatusOr<std::unique_ptr<Aead>> NewEncryptThenAuthenticate(
+    const util::SecretData& aes_key, const util::SecretData& hmac_key) {
+  auto ind_cpa_cipher = AesCtrBoringSsl::New(aes_key, kIvSize);
+  if (!ind_cpa_cipher.ok()) return ind_cpa_cipher.status();
+  auto mac = HmacBoringSsl::New(HashType::SHA256, kTagSize, hmac_key);
+  if (!mac.ok()) return mac.status();
+  return EncryptThenAuthenticate::New(std::move(ind_cpa_cipher.ValueOrDie()),
+                                      std::move(mac.ValueOrDie()), kTagSize);
+}
+
+class AesCtrHmacBoringSslTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (kUseOnlyFips && !FIPS_mode()) {
+      GTEST_SKIP() << "Test should not run in FIPS mode when BoringCrypto is "
+                      "unavailable.";
+    }
+    aes_key_ = Random::GetRandomKeyBytes(16);
+    hmac_key_ = Random::GetRandomKeyBytes(32);
+    auto fused = AesCtrHmacBoringSsl::New(aes_key_, kIvSize, HashType::SHA256,
+                                          hmac_key_, kTagSize);
+    ASSERT_THAT(fused.status(), IsOk());
+    fused_ = std::move(fused.ValueOrDie());
+    auto separate = NewEncryptThenAuthenticate(aes_key_, hmac_key_);
+    ASSERT_THAT(separate.status(), IsOk());
+    separate_ = std::move(separate.ValueOrDie());
+  }
+
+  util::SecretData aes_key_;
+  util::SecretData hmac_key_;
+  std::unique_ptr<Aead> fused_;
+  std::unique_ptr<Aead> separate_;
+};
+
+TEST_F(AesCtrHmacBoringSslTest, CompatibleWithEncryptThenAuthenticate) {
+  // Sizes around the chunk size of 8192 bytes.
+  for (int size : {0, 1, 16, 8191, 8192, 8193, 3 * 8192 + 5}) {
+    for (absl::string_view aad : {"", "some associated data"}) {
+      SCOPED_TRACE(size);
+      std::string plaintext = Random::GetRandomBytes(size);
+
+      auto ciphertext = fused_->Encrypt(plaintext, aad);
+      ASSERT_THAT(ciphertext.status(), IsOk());
+      EXPECT_EQ(ciphertext.ValueOrDie().size(), kIvSize + size + kTagSize);
+      auto decrypted = separate_->Decrypt(ciphertext.ValueOrDie(), aad);
+      ASSERT_THAT(decrypted.status(), IsOk());
+      EXPECT_EQ(decrypted.ValueOrDie(), plaintext);
+
+      ciphertext = separate_->Encrypt(plaintext, aad);
+      ASSERT_THAT(ciphertext.status(), IsOk());
+      decrypted = fused_->Decrypt(ciphertext.ValueOrDie(), aad);
+      ASSERT_THAT(decrypted.status(), IsOk());
+      EXPECT_EQ(decrypted.ValueOrDie(), plaintext);
+    }
+  }
+}
+
+TEST_F(AesCtrHmacBoringSslTest, NullStringViews) {
+  auto ciphertext = fused_->Encrypt(absl::string_view(), absl::string_view());
+  ASSERT_THAT(ciphertext.status(), IsOk());
+  auto decrypted = fused_->Decrypt(ciphertext.ValueOrDie(), "");
+  ASSERT_THAT(decrypted.status(), IsOk());
+  EXPECT_EQ(decrypted.ValueOrDie(), "");
+}
+
+TEST_F(AesCtrHmacBoringSslTest, ModifiedCiphertext) {
+  std::string aad = "some associated data";
+  auto ciphertext_result = fused_->Encrypt("Some data to encrypt.", aad);
+  ASSERT_THAT(ciphertext_result.status(), IsOk());
+  const std::string& ciphertext = ciphertext_result.ValueOrDie();
+
+  for (size_t i = 0; i < ciphertext.size() * 8; i++) {
+    std::string modified = ciphertext;
+    modified[i / 8] ^= 1 << (i % 8);
+    EXPECT_THAT(fused_->Decrypt(modified, aad).status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+  for (size_t size = 0; size < ciphertext.size(); size++) {
+    EXPECT_THAT(fused_->Decrypt(ciphertext.substr(0, size), aad).status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+  EXPECT_THAT(fused_->Decrypt(ciphertext, "other associated data").status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(AesCtrHmacBoringSslTest, PrepareAssociatedData) {
+  std::string aad = "some associated data";
+  auto prepared_result = fused_->PrepareAssociatedData(aad);
+  ASSERT_THAT(prepared_result.status(), IsOk());
+  std::unique_ptr<PreparedAead> prepared =
+      std::move(prepared_result.ValueOrDie());
+  for (int size : {0, 1, 16, 8193}) {
+    SCOPED_TRACE(size);
+    std::string plaintext = Random::GetRandomBytes(size);
+    auto ciphertext = prepared->Encrypt(plaintext);
+    ASSERT_THAT(ciphertext.status(), IsOk());
+    auto decrypted = separate_->Decrypt(ciphertext.ValueOrDie(), aad);
+    ASSERT_THAT(decrypted.status(), IsOk());
+    EXPECT_EQ(decrypted.ValueOrDie(), plaintext);
+
+    ciphertext = separate_->Encrypt(plaintext, aad);
+    ASSERT_THAT(ciphertext.status(), IsOk());
+    decrypted = prepared->Decrypt(ciphertext.ValueOrDie());
+    ASSERT_THAT(decrypted.status(), IsOk());
+    EXPECT_EQ(decrypted.ValueOrDie(), plaintext);
+  }
+
+  // A ciphertext for other associated data does not decrypt.
+  auto other_ciphertext = fused_->Encrypt("plaintext", "other");
+  ASSERT_THAT(other_ciphertext.status(), IsOk());
+  EXPECT_THAT(prepared->Decrypt(other_ciphertext.ValueOrDie()).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST_F(AesCtrHmacBoringSslTest, ConcurrentUse) {
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([this]() {
+      for (int j = 0; j < 200; j++) {
+        std::string plaintext = Random::GetRandomBytes(j * 100);
+        auto ciphertext = fused_->Encrypt(plaintext, "aad");
+        ASSERT_THAT(ciphertext.status(), IsOk());
+        auto decrypted = fused_->Decrypt(ciphertext.ValueOrDie(), "aad");
+        ASSERT_THAT(decrypted.status(), IsOk());
+        EXPECT_EQ(decrypted.ValueOrDie(), plaintext);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+}
+
+TEST_F(AesCtrHmacBoringSslTest, InvalidParameters) {
+  util::SecretData short_key = Random::GetRandomKeyBytes(15);
+  EXPECT_FALSE(AesCtrHmacBoringSsl::New(short_key, kIvSize, HashType::SHA256,
+                                        hmac_key_, kTagSize)
+                   .ok());
+  EXPECT_FALSE(AesCtrHmacBoringSsl::New(aes_key_, kIvSize, HashType::SHA256,
+                                        short_key, kTagSize)
+                   .ok());
+  EXPECT_FALSE(AesCtrHmacBoringSsl::New(aes_key_, 11, HashType::SHA256,
+                                        hmac_key_, kTagSize)
+                   .ok());
+  EXPECT_FALSE(AesCtrHmacBoringSsl::New(aes_key_, 17, HashType::SHA256,
+                                        hmac_key_, kTagSize)
+                   .ok());
+  EXPECT_FALSE(AesCtrHmacBoringSsl::New(aes_key_, kIvSize, HashType::SHA256,
+                                        hmac_key_, 9)
+                   .ok());
+  EXPECT_FALSE(AesCtrHmacBoringSsl::New(aes_key_, kIvSize, HashType::SHA256,
+                                        hmac_key_, 33)
+                   .ok());
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
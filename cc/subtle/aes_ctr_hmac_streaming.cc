@@ -16,24 +16,27 @@
 
 #include "tink/subtle/aes_ctr_hmac_streaming.h"
 
+#include <algorithm>
 #include <limits>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "openssl/base.h"
 #include "openssl/cipher.h"
 #include "openssl/err.h"
 #include "openssl/evp.h"
+#include "openssl/hmac.h"
+#include "openssl/mem.h"
 #include "tink/subtle/common_enums.h"
 #include "tink/subtle/hkdf.h"
-#include "tink/subtle/hmac_boringssl.h"
 #include "tink/subtle/random.h"
 #include "tink/subtle/stream_segment_decrypter.h"
 #include "tink/subtle/stream_segment_encrypter.h"
-#include "tink/subtle/subtle_util.h"
 #include "tink/subtle/subtle_util_boringssl.h"
 #include "tink/util/errors.h"
 #include "tink/util/secret_data.h"
@@ -44,13 +47,71 @@ namespace crypto {
 namespace tink {
 namespace subtle {
 
-static std::string NonceForSegment(absl::string_view nonce_prefix,
-                                   int64_t segment_number,
-                                   bool is_last_segment) {
-  return absl::StrCat(
-      nonce_prefix, BigEndian32(segment_number),
-      is_last_segment ? std::string(1, '\x01') : std::string(1, '\x00'),
-      std::string(4, '\x00'));
+// Writes the AES-CTR nonce of a segment to 'nonce', which must have room for
+// AesCtrHmacStreaming::kNonceSizeInBytes bytes.
+static void NonceForSegment(absl::string_view nonce_prefix,
+                            int64_t segment_number, bool is_last_segment,
+                            uint8_t* nonce) {
+  uint8_t* pos = std::copy(nonce_prefix.begin(), nonce_prefix.end(), nonce);
+  *pos++ = static_cast<uint8_t>(segment_number >> 24);
+  *pos++ = static_cast<uint8_t>(segment_number >> 16);
+  *pos++ = static_cast<uint8_t>(segment_number >> 8);
+  *pos++ = static_cast<uint8_t>(segment_number);
+  *pos++ = is_last_segment ? 1 : 0;
+  std::fill(pos, nonce + AesCtrHmacStreaming::kNonceSizeInBytes, 0);
+}
+
+// Returns an AES-CTR context keyed with 'key_value'. The IV is set per
+// segment, which leaves the key schedule untouched.
+static util::StatusOr<bssl::UniquePtr<EVP_CIPHER_CTX>> NewKeyedCipherCtx(
+    const util::SecretData& key_value) {
+  const EVP_CIPHER* cipher =
+      SubtleUtilBoringSSL::GetAesCtrCipherForKeySize(key_value.size());
+  if (cipher == nullptr) {
+    return util::Status(util::error::INTERNAL, "invalid key size");
+  }
+  bssl::UniquePtr<EVP_CIPHER_CTX> ctx(EVP_CIPHER_CTX_new());
+  if (ctx.get() == nullptr) {
+    return util::Status(util::error::INTERNAL,
+                        "could not initialize EVP_CIPHER_CTX");
+  }
+  if (EVP_EncryptInit_ex(ctx.get(), cipher, nullptr /* engine */,
+                         reinterpret_cast<const uint8_t*>(key_value.data()),
+                         nullptr /* iv */) != 1) {
+    return util::Status(util::error::INTERNAL, "could not initialize ctx");
+  }
+  return std::move(ctx);
+}
+
+// Returns an HMAC context keyed with 'hmac_key_value', see ComputeTag().
+static util::StatusOr<bssl::UniquePtr<HMAC_CTX>> NewKeyedHmacCtx(
+    HashType tag_algo, const util::SecretData& hmac_key_value) {
+  auto md_result = SubtleUtilBoringSSL::EvpHash(tag_algo);
+  if (!md_result.ok()) return md_result.status();
+  bssl::UniquePtr<HMAC_CTX> ctx(HMAC_CTX_new());
+  if (ctx.get() == nullptr ||
+      !HMAC_Init_ex(ctx.get(), hmac_key_value.data(), hmac_key_value.size(),
+                    md_result.ValueOrDie(), nullptr /* engine */)) {
+    return util::Status(util::error::INTERNAL, "HMAC initialization failed");
+  }
+  return std::move(ctx);
+}
+
+// Computes HMAC(nonce || ciphertext) with the keyed 'hmac_ctx' and writes
+// the untruncated result to 'tag', which must hold EVP_MAX_MD_SIZE bytes.
+static util::Status ComputeTag(HMAC_CTX* hmac_ctx, const uint8_t* nonce,
+                               const uint8_t* ciphertext,
+                               size_t ciphertext_size, uint8_t* tag) {
+  unsigned int tag_len;
+  // Initializing with neither key nor digest restores the keyed inner and
+  // outer hash states, so the key schedule is not redone for every segment.
+  if (!HMAC_Init_ex(hmac_ctx, nullptr, 0, nullptr, nullptr) ||
+      !HMAC_Update(hmac_ctx, nonce, AesCtrHmacStreaming::kNonceSizeInBytes) ||
+      !HMAC_Update(hmac_ctx, ciphertext, ciphertext_size) ||
+      !HMAC_Final(hmac_ctx, tag, &tag_len)) {
+    return util::Status(util::error::INTERNAL, "HMAC computation failed");
+  }
+  return util::OkStatus();
 }
 
 static util::Status DeriveKeys(const util::SecretData& ikm, HashType hkdf_algo,
@@ -134,7 +195,8 @@ AesCtrHmacStreaming::NewSegmentEncrypter(
 util::StatusOr<std::unique_ptr<StreamSegmentDecrypter>>
 AesCtrHmacStreaming::NewSegmentDecrypter(
     absl::string_view associated_data) const {
-  return AesCtrHmacStreamSegmentDecrypter::New(params_, associated_data);
+  return AesCtrHmacStreamSegmentDecrypter::New(params_, associated_data,
+                                               key_cache_);
 }
 
 // AesCtrHmacStreamSegmentEncrypter
@@ -152,9 +214,10 @@ AesCtrHmacStreamSegmentEncrypter::New(const AesCtrHmacStreaming::Params& params,
   auto status = Validate(params);
   if (!status.ok()) return status;
 
-  std::string salt = Random::GetRandomBytes(params.key_size);
-  std::string nonce_prefix =
-      Random::GetRandomBytes(AesCtrHmacStreaming::kNoncePrefixSizeInBytes);
+  std::string salt = Random::GetRandomNonceBytes(params.key_size);
+  std::string nonce_prefix(AesCtrHmacStreaming::kNoncePrefixSizeInBytes, '\0');
+  Random::GetRandomNonceBytes(
+      absl::MakeSpan(&nonce_prefix[0], nonce_prefix.size()));
   std::string header = MakeHeader(salt, nonce_prefix);
 
   util::SecretData key_value;
@@ -163,58 +226,92 @@ AesCtrHmacStreamSegmentEncrypter::New(const AesCtrHmacStreaming::Params& params,
                       params.key_size, &key_value, &hmac_key_value);
   if (!status.ok()) return status;
 
-  auto cipher = SubtleUtilBoringSSL::GetAesCtrCipherForKeySize(params.key_size);
-  if (cipher == nullptr) {
-    return util::Status(util::error::INTERNAL, "invalid key size");
-  }
-
-  auto hmac_result = HmacBoringSsl::New(params.tag_algo, params.tag_size,
-                                        std::move(hmac_key_value));
-  if (!hmac_result.ok()) return hmac_result.status();
-  auto mac = std::move(hmac_result.ValueOrDie());
+  auto cipher_ctx_result = NewKeyedCipherCtx(key_value);
+  if (!cipher_ctx_result.ok()) return cipher_ctx_result.status();
+  auto hmac_ctx_result = NewKeyedHmacCtx(params.tag_algo, hmac_key_value);
+  if (!hmac_ctx_result.ok()) return hmac_ctx_result.status();
 
   return {absl::WrapUnique(new AesCtrHmacStreamSegmentEncrypter(
-      std::move(key_value), header, nonce_prefix,
-      params.ciphertext_segment_size, params.ciphertext_offset, params.tag_size,
-      cipher, std::move(mac)))};
+      header, nonce_prefix, params.ciphertext_segment_size,
+      params.ciphertext_offset, params.tag_size,
+      std::move(cipher_ctx_result.ValueOrDie()),
+      std::move(hmac_ctx_result.ValueOrDie())))};
 }
 
 util::Status AesCtrHmacStreamSegmentEncrypter::EncryptSegment(
     const std::vector<uint8_t>& plaintext, bool is_last_segment,
     std::vector<uint8_t>* ciphertext_buffer) {
-  if (plaintext.size() > get_plaintext_segment_size()) {
-    return util::Status(util::error::INVALID_ARGUMENT, "plaintext too long");
+  if (ciphertext_buffer == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_buffer must be non-null");
   }
+  ciphertext_buffer->resize(plaintext.size() + tag_size_);
+  return EncryptSegmentInto(plaintext, is_last_segment,
+                            absl::MakeSpan(*ciphertext_buffer))
+      .status();
+}
+
+util::StatusOr<int> AesCtrHmacStreamSegmentEncrypter::EncryptSegmentInto(
+    absl::Span<const uint8_t> plaintext, bool is_last_segment,
+    absl::Span<uint8_t> ciphertext_buffer) {
+  auto status =
+      EncryptSegmentWith(cipher_ctx_.get(), hmac_ctx_.get(), plaintext,
+                         segment_number_, is_last_segment, ciphertext_buffer);
+  if (!status.ok()) return status;
+  IncSegmentNumber();
+  return static_cast<int>(plaintext.size()) + tag_size_;
+}
+
+util::Status AesCtrHmacStreamSegmentEncrypter::EncryptSegmentAt(
+    const std::vector<uint8_t>& plaintext, int64_t segment_number,
+    bool is_last_segment, std::vector<uint8_t>* ciphertext_buffer) const {
   if (ciphertext_buffer == nullptr) {
     return util::Status(util::error::INVALID_ARGUMENT,
                         "ciphertext_buffer must be non-null");
   }
-  if (get_segment_number() > std::numeric_limits<uint32_t>::max() ||
-      (get_segment_number() == std::numeric_limits<uint32_t>::max() &&
+  ciphertext_buffer->resize(plaintext.size() + tag_size_);
+  // The shared contexts are modified by every segment, so concurrent callers
+  // work on private copies. Copying keeps the key schedules.
+  bssl::ScopedEVP_CIPHER_CTX cipher_ctx;
+  bssl::ScopedHMAC_CTX hmac_ctx;
+  if (EVP_CIPHER_CTX_copy(cipher_ctx.get(), cipher_ctx_.get()) != 1 ||
+      !HMAC_CTX_copy_ex(hmac_ctx.get(), hmac_ctx_.get())) {
+    return util::Status(util::error::INTERNAL, "could not copy contexts");
+  }
+  return EncryptSegmentWith(cipher_ctx.get(), hmac_ctx.get(), plaintext,
+                            segment_number, is_last_segment,
+                            absl::MakeSpan(*ciphertext_buffer));
+}
+
+util::Status AesCtrHmacStreamSegmentEncrypter::EncryptSegmentWith(
+    EVP_CIPHER_CTX* cipher_ctx, HMAC_CTX* hmac_ctx,
+    absl::Span<const uint8_t> plaintext, int64_t segment_number,
+    bool is_last_segment, absl::Span<uint8_t> ciphertext_buffer) const {
+  if (plaintext.size() > get_plaintext_segment_size()) {
+    return util::Status(util::error::INVALID_ARGUMENT, "plaintext too long");
+  }
+  if (ciphertext_buffer.size() < plaintext.size() + tag_size_) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_buffer too small");
+  }
+  if (segment_number < 0 ||
+      segment_number > std::numeric_limits<uint32_t>::max() ||
+      (segment_number == std::numeric_limits<uint32_t>::max() &&
        !is_last_segment)) {
     return util::Status(util::error::INVALID_ARGUMENT, "too many segments");
   }
 
-  int ct_size = plaintext.size() + tag_size_;
-  ciphertext_buffer->resize(ct_size);
-
-  std::string nonce =
-      NonceForSegment(nonce_prefix_, segment_number_, is_last_segment);
+  uint8_t nonce[AesCtrHmacStreaming::kNonceSizeInBytes];
+  NonceForSegment(nonce_prefix_, segment_number, is_last_segment, nonce);
 
-  // Encrypt.
-  bssl::UniquePtr<EVP_CIPHER_CTX> ctx(EVP_CIPHER_CTX_new());
-  if (ctx.get() == nullptr) {
-    return util::Status(util::error::INTERNAL,
-                        "could not initialize EVP_CIPHER_CTX");
-  }
-  if (EVP_EncryptInit_ex(ctx.get(), cipher_, nullptr /* engine */,
-                         reinterpret_cast<const uint8_t*>(key_value_.data()),
-                         reinterpret_cast<const uint8_t*>(nonce.data())) != 1) {
+  // Encrypt. Only the IV is set, the context keeps its key schedule.
+  if (EVP_EncryptInit_ex(cipher_ctx, nullptr /* cipher */, nullptr /* engine */,
+                         nullptr /* key */, nonce) != 1) {
     return util::Status(util::error::INTERNAL, "could not initialize ctx");
   }
 
   int out_len;
-  if (EVP_EncryptUpdate(ctx.get(), ciphertext_buffer->data(), &out_len,
+  if (EVP_EncryptUpdate(cipher_ctx, ciphertext_buffer.data(), &out_len,
                         plaintext.data(), plaintext.size()) != 1) {
     return util::Status(util::error::INTERNAL, "encryption failed");
   }
@@ -223,31 +320,28 @@ util::Status AesCtrHmacStreamSegmentEncrypter::EncryptSegment(
   }
 
   // Add MAC tag.
-  absl::string_view ciphertext_string(
-      reinterpret_cast<const char*>(ciphertext_buffer->data()),
-      plaintext.size());
-  auto tag_result = mac_->ComputeMac(absl::StrCat(nonce, ciphertext_string));
-  if (!tag_result.ok()) return tag_result.status();
-  std::string tag = tag_result.ValueOrDie();
-  memcpy(ciphertext_buffer->data() + plaintext.size(),
-         reinterpret_cast<const uint8_t*>(tag.data()), tag_size_);
-
-  IncSegmentNumber();
+  uint8_t tag[EVP_MAX_MD_SIZE];
+  auto status = ComputeTag(hmac_ctx, nonce, ciphertext_buffer.data(),
+                           plaintext.size(), tag);
+  if (!status.ok()) return status;
+  std::copy(tag, tag + tag_size_, ciphertext_buffer.data() + plaintext.size());
   return util::OkStatus();
 }
 
 // AesCtrHmacStreamSegmentDecrypter
 // static
 util::StatusOr<std::unique_ptr<StreamSegmentDecrypter>>
-AesCtrHmacStreamSegmentDecrypter::New(const AesCtrHmacStreaming::Params& params,
-                                      absl::string_view associated_data) {
+AesCtrHmacStreamSegmentDecrypter::New(
+    const AesCtrHmacStreaming::Params& params,
+    absl::string_view associated_data,
+    std::shared_ptr<DerivedKeyCache<AesCtrHmacKeyedContexts>> key_cache) {
   auto status = Validate(params);
   if (!status.ok()) return status;
 
   return {absl::WrapUnique(new AesCtrHmacStreamSegmentDecrypter(
       params.ikm, params.hkdf_algo, params.key_size, associated_data,
       params.ciphertext_segment_size, params.ciphertext_offset, params.tag_algo,
-      params.tag_size))};
+      params.tag_size, std::move(key_cache)))};
 }
 
 util::Status AesCtrHmacStreamSegmentDecrypter::Init(
@@ -271,21 +365,32 @@ util::Status AesCtrHmacStreamSegmentDecrypter::Init(
       std::string(reinterpret_cast<const char*>(header.data() + 1 + key_size_),
                   AesCtrHmacStreaming::kNoncePrefixSizeInBytes);
 
+  if (key_cache_ != nullptr) {
+    contexts_ = key_cache_->Get(salt, associated_data_);
+    if (contexts_ != nullptr) {
+      is_initialized_ = true;
+      return util::OkStatus();
+    }
+  }
+
+  util::SecretData key_value;
   util::SecretData hmac_key_value;
   auto status = DeriveKeys(ikm_, hkdf_algo_, salt, associated_data_, key_size_,
-                           &key_value_, &hmac_key_value);
+                           &key_value, &hmac_key_value);
   if (!status.ok()) return status;
 
-  cipher_ = SubtleUtilBoringSSL::GetAesCtrCipherForKeySize(key_size_);
-  if (cipher_ == nullptr) {
-    return util::Status(util::error::INTERNAL, "invalid key size");
+  auto contexts = std::make_shared<AesCtrHmacKeyedContexts>();
+  auto cipher_ctx_result = NewKeyedCipherCtx(key_value);
+  if (!cipher_ctx_result.ok()) return cipher_ctx_result.status();
+  contexts->cipher_ctx = std::move(cipher_ctx_result.ValueOrDie());
+  auto hmac_ctx_result = NewKeyedHmacCtx(tag_algo_, hmac_key_value);
+  if (!hmac_ctx_result.ok()) return hmac_ctx_result.status();
+  contexts->hmac_ctx = std::move(hmac_ctx_result.ValueOrDie());
+  contexts_ = std::move(contexts);
+  if (key_cache_ != nullptr) {
+    key_cache_->Put(salt, associated_data_, contexts_);
   }
 
-  auto hmac_result =
-      HmacBoringSsl::New(tag_algo_, tag_size_, std::move(hmac_key_value));
-  if (!hmac_result.ok()) return hmac_result.status();
-  mac_ = std::move(hmac_result.ValueOrDie());
-
   is_initialized_ = true;
   return util::OkStatus();
 }
@@ -307,40 +412,68 @@ util::Status AesCtrHmacStreamSegmentDecrypter::DecryptSegment(
     return util::Status(util::error::INVALID_ARGUMENT,
                         "plaintext_buffer must be non-null");
   }
+  plaintext_buffer->resize(ciphertext.size() - tag_size_);
+  return DecryptSegmentInto(ciphertext, segment_number, is_last_segment,
+                            absl::MakeSpan(*plaintext_buffer))
+      .status();
+}
+
+util::StatusOr<int> AesCtrHmacStreamSegmentDecrypter::DecryptSegmentInto(
+    absl::Span<const uint8_t> ciphertext, int64_t segment_number,
+    bool is_last_segment, absl::Span<uint8_t> plaintext_buffer) {
+  if (!is_initialized_) {
+    return util::Status(util::error::FAILED_PRECONDITION,
+                        "decrypter not initialized");
+  }
+  if (ciphertext.size() > get_ciphertext_segment_size()) {
+    return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too long");
+  }
+  if (ciphertext.size() < tag_size_) {
+    return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too short");
+  }
+  int pt_size = ciphertext.size() - tag_size_;
+  if (plaintext_buffer.size() < pt_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "plaintext_buffer too small");
+  }
   if (segment_number > std::numeric_limits<uint32_t>::max() ||
       (segment_number == std::numeric_limits<uint32_t>::max() &&
        !is_last_segment)) {
     return util::Status(util::error::INVALID_ARGUMENT, "too many segments");
   }
 
-  int pt_size = ciphertext.size() - tag_size_;
-  plaintext_buffer->resize(pt_size);
-
-  std::string nonce =
-      NonceForSegment(nonce_prefix_, segment_number, is_last_segment);
+  uint8_t nonce[AesCtrHmacStreaming::kNonceSizeInBytes];
+  NonceForSegment(nonce_prefix_, segment_number, is_last_segment, nonce);
+
+  // Segments of one stream may be decrypted concurrently (e.g. by a
+  // DecryptingRandomAccessStream), so each call works on copies of the keyed
+  // contexts. Copying keeps the key schedules.
+  bssl::ScopedEVP_CIPHER_CTX cipher_ctx;
+  bssl::ScopedHMAC_CTX hmac_ctx;
+  if (EVP_CIPHER_CTX_copy(cipher_ctx.get(), contexts_->cipher_ctx.get()) !=
+          1 ||
+      !HMAC_CTX_copy_ex(hmac_ctx.get(), contexts_->hmac_ctx.get())) {
+    return util::Status(util::error::INTERNAL, "could not copy contexts");
+  }
 
   // Verify MAC tag.
-  absl::string_view tag(
-      reinterpret_cast<const char*>(ciphertext.data() + pt_size), tag_size_);
-  absl::string_view ciphertext_string(
-      reinterpret_cast<const char*>(ciphertext.data()), pt_size);
-  auto status = mac_->VerifyMac(tag, absl::StrCat(nonce, ciphertext_string));
+  uint8_t tag[EVP_MAX_MD_SIZE];
+  auto status =
+      ComputeTag(hmac_ctx.get(), nonce, ciphertext.data(), pt_size, tag);
   if (!status.ok()) return status;
-
-  // Decrypt.
-  bssl::UniquePtr<EVP_CIPHER_CTX> ctx(EVP_CIPHER_CTX_new());
-  if (ctx.get() == nullptr) {
-    return util::Status(util::error::INTERNAL,
-                        "could not initialize EVP_CIPHER_CTX");
+  if (CRYPTO_memcmp(tag, ciphertext.data() + pt_size, tag_size_) != 0) {
+    return util::Status(util::error::INVALID_ARGUMENT, "verification failed");
   }
-  if (EVP_DecryptInit_ex(ctx.get(), cipher_, nullptr /* engine */,
-                         reinterpret_cast<const uint8_t*>(key_value_.data()),
-                         reinterpret_cast<const uint8_t*>(nonce.data())) != 1) {
+
+  // Decrypt. Only the IV is set, the context keeps its key schedule.
+  if (EVP_DecryptInit_ex(cipher_ctx.get(), nullptr /* cipher */,
+                         nullptr /* engine */, nullptr /* key */,
+                         nonce) != 1) {
     return util::Status(util::error::INTERNAL, "could not initialize ctx");
   }
 
   int out_len;
-  if (EVP_DecryptUpdate(ctx.get(), plaintext_buffer->data(), &out_len,
+  if (EVP_DecryptUpdate(cipher_ctx.get(), plaintext_buffer.data(), &out_len,
                         ciphertext.data(), pt_size) != 1) {
     return util::Status(util::error::INTERNAL, "decryption failed");
   }
@@ -348,7 +481,7 @@ util::Status AesCtrHmacStreamSegmentDecrypter::DecryptSegment(
     return util::Status(util::error::INTERNAL, "incorrect plaintext size");
   }
 
-  return util::OkStatus();
+  return pt_size;
 }
 
 }  // namespace subtle
@@ -17,14 +17,18 @@
 #ifndef TINK_SUBTLE_AES_CTR_HMAC_STREAMING_H_
 #define TINK_SUBTLE_AES_CTR_HMAC_STREAMING_H_
 
+#include <memory>
 #include <utility>
 #include <vector>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "openssl/base.h"
 #include "openssl/evp.h"
-#include "tink/mac.h"
+#include "openssl/hmac.h"
 #include "tink/config/tink_fips.h"
 #include "tink/subtle/common_enums.h"
+#include "tink/subtle/derived_key_cache.h"
 #include "tink/subtle/nonce_based_streaming_aead.h"
 #include "tink/subtle/stream_segment_decrypter.h"
 #include "tink/subtle/stream_segment_encrypter.h"
@@ -36,6 +40,13 @@ namespace crypto {
 namespace tink {
 namespace subtle {
 
+// The contexts that AesCtrHmacStreamSegmentDecrypter keys with the keys
+// derived from the header of a ciphertext stream.
+struct AesCtrHmacKeyedContexts {
+  bssl::UniquePtr<EVP_CIPHER_CTX> cipher_ctx;
+  bssl::UniquePtr<HMAC_CTX> hmac_ctx;
+};
+
 // Streaming encryption using AES-CTR and HMAC.
 //
 // Each ciphertext uses a new AES-CTR key and HMAC key that are derived from the
@@ -69,6 +80,10 @@ class AesCtrHmacStreaming : public NonceBasedStreamingAead {
     int ciphertext_offset;
     HashType tag_algo;
     int tag_size;
+    // If positive, the keyed contexts of up to this many recently opened
+    // ciphertext streams are kept, so that opening one of them again for
+    // decryption skips the key derivation.
+    int derived_key_cache_size = 0;
   };
 
   // The size of the nonce for AES-CTR.
@@ -99,8 +114,15 @@ class AesCtrHmacStreaming : public NonceBasedStreamingAead {
       absl::string_view associated_data) const override;
 
  private:
-  explicit AesCtrHmacStreaming(Params params) : params_(std::move(params)) {}
+  explicit AesCtrHmacStreaming(Params params)
+      : params_(std::move(params)),
+        key_cache_(params_.derived_key_cache_size > 0
+                       ? std::make_shared<
+                             DerivedKeyCache<AesCtrHmacKeyedContexts>>(
+                             params_.derived_key_cache_size)
+                       : nullptr) {}
   const Params params_;
+  const std::shared_ptr<DerivedKeyCache<AesCtrHmacKeyedContexts>> key_cache_;
 };
 
 class AesCtrHmacStreamSegmentEncrypter : public StreamSegmentEncrypter {
@@ -114,6 +136,13 @@ class AesCtrHmacStreamSegmentEncrypter : public StreamSegmentEncrypter {
   util::Status EncryptSegment(const std::vector<uint8_t>& plaintext,
                               bool is_last_segment,
                               std::vector<uint8_t>* ciphertext_buffer) override;
+  util::Status EncryptSegmentAt(
+      const std::vector<uint8_t>& plaintext, int64_t segment_number,
+      bool is_last_segment,
+      std::vector<uint8_t>* ciphertext_buffer) const override;
+  util::StatusOr<int> EncryptSegmentInto(
+      absl::Span<const uint8_t> plaintext, bool is_last_segment,
+      absl::Span<uint8_t> ciphertext_buffer) override;
 
   const std::vector<uint8_t>& get_header() const override { return header_; }
   int64_t get_segment_number() const override { return segment_number_; }
@@ -129,40 +158,53 @@ class AesCtrHmacStreamSegmentEncrypter : public StreamSegmentEncrypter {
   void IncSegmentNumber() override { segment_number_++; }
 
  private:
-  AesCtrHmacStreamSegmentEncrypter(util::SecretData key_value,
-                                   absl::string_view header,
+  AesCtrHmacStreamSegmentEncrypter(absl::string_view header,
                                    absl::string_view nonce_prefix,
                                    int ciphertext_segment_size,
                                    int ciphertext_offset, int tag_size,
-                                   const EVP_CIPHER* cipher,
-                                   std::unique_ptr<Mac> mac)
-      : key_value_(std::move(key_value)),
-        header_(header.begin(), header.end()),
+                                   bssl::UniquePtr<EVP_CIPHER_CTX> cipher_ctx,
+                                   bssl::UniquePtr<HMAC_CTX> hmac_ctx)
+      : header_(header.begin(), header.end()),
         nonce_prefix_(nonce_prefix),
         ciphertext_segment_size_(ciphertext_segment_size),
         ciphertext_offset_(ciphertext_offset),
         tag_size_(tag_size),
-        cipher_(cipher),
-        mac_(std::move(mac)),
+        cipher_ctx_(std::move(cipher_ctx)),
+        hmac_ctx_(std::move(hmac_ctx)),
         segment_number_(0) {}
 
-  const util::SecretData key_value_;
+  // Encrypts a segment into the beginning of 'ciphertext_buffer' using the
+  // given keyed contexts, which must not be used concurrently by other
+  // callers.
+  util::Status EncryptSegmentWith(EVP_CIPHER_CTX* cipher_ctx,
+                                  HMAC_CTX* hmac_ctx,
+                                  absl::Span<const uint8_t> plaintext,
+                                  int64_t segment_number, bool is_last_segment,
+                                  absl::Span<uint8_t> ciphertext_buffer) const;
+
   const std::vector<uint8_t> header_;
   const std::string nonce_prefix_;
   const int ciphertext_segment_size_;
   const int ciphertext_offset_;
   const int tag_size_;
-  const EVP_CIPHER* cipher_;
-  const std::unique_ptr<Mac> mac_;
+  // Contexts keyed once upon creation, and reused for every segment: only
+  // the IV of the cipher context changes, and the HMAC context is reset to
+  // its keyed state.
+  const bssl::UniquePtr<EVP_CIPHER_CTX> cipher_ctx_;
+  const bssl::UniquePtr<HMAC_CTX> hmac_ctx_;
   int64_t segment_number_;
 };
 
 class AesCtrHmacStreamSegmentDecrypter : public StreamSegmentDecrypter {
  public:
-  // A factory.
+  // A factory. If 'key_cache' is not null, Init() looks up the keyed
+  // contexts for the header in it before deriving them, and adds newly
+  // derived ones.
   static util::StatusOr<std::unique_ptr<StreamSegmentDecrypter>> New(
       const AesCtrHmacStreaming::Params& params,
-      absl::string_view associated_data);
+      absl::string_view associated_data,
+      std::shared_ptr<DerivedKeyCache<AesCtrHmacKeyedContexts>> key_cache =
+          nullptr);
 
   // Overridden methods of StreamSegmentDecrypter.
   util::Status Init(const std::vector<uint8_t>& header) override;
@@ -170,6 +212,9 @@ class AesCtrHmacStreamSegmentDecrypter : public StreamSegmentDecrypter {
   util::Status DecryptSegment(const std::vector<uint8_t>& ciphertext,
                               int64_t segment_number, bool is_last_segment,
                               std::vector<uint8_t>* plaintext_buffer) override;
+  util::StatusOr<int> DecryptSegmentInto(
+      absl::Span<const uint8_t> ciphertext, int64_t segment_number,
+      bool is_last_segment, absl::Span<uint8_t> plaintext_buffer) override;
 
   int get_header_size() const override {
     return 1 + key_size_ + AesCtrHmacStreaming::kNoncePrefixSizeInBytes;
@@ -189,7 +234,9 @@ class AesCtrHmacStreamSegmentDecrypter : public StreamSegmentDecrypter {
                                    absl::string_view associated_data,
                                    int ciphertext_segment_size,
                                    int ciphertext_offset, HashType tag_algo,
-                                   int tag_size)
+                                   int tag_size,
+                                   std::shared_ptr<DerivedKeyCache<
+                                       AesCtrHmacKeyedContexts>> key_cache)
       : ikm_(std::move(ikm)),
         hkdf_algo_(hkdf_algo),
         key_size_(key_size),
@@ -197,7 +244,8 @@ class AesCtrHmacStreamSegmentDecrypter : public StreamSegmentDecrypter {
         ciphertext_segment_size_(ciphertext_segment_size),
         ciphertext_offset_(ciphertext_offset),
         tag_algo_(tag_algo),
-        tag_size_(tag_size) {}
+        tag_size_(tag_size),
+        key_cache_(std::move(key_cache)) {}
 
   // Parameters set upon decrypter creation.
   const util::SecretData ikm_;
@@ -208,13 +256,15 @@ class AesCtrHmacStreamSegmentDecrypter : public StreamSegmentDecrypter {
   const int ciphertext_offset_;
   const HashType tag_algo_;
   const int tag_size_;
+  const std::shared_ptr<DerivedKeyCache<AesCtrHmacKeyedContexts>> key_cache_;
 
   // Parameters set when initializing with data from stream header.
   bool is_initialized_ = false;
-  util::SecretData key_value_;
   std::string nonce_prefix_;
-  const EVP_CIPHER* cipher_;
-  std::unique_ptr<Mac> mac_;
+  // Keyed in Init(); DecryptSegment() works on copies of these, so that the
+  // key schedules are computed once per stream. Possibly shared with other
+  // decrypters through key_cache_.
+  std::shared_ptr<const AesCtrHmacKeyedContexts> contexts_;
 };
 
 }  // namespace subtle
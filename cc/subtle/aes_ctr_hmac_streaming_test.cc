@@ -23,7 +23,9 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "tink/subtle/common_enums.h"
+#include "tink/subtle/derived_key_cache.h"
 #include "tink/subtle/random.h"
 #include "tink/subtle/stream_segment_decrypter.h"
 #include "tink/subtle/stream_segment_encrypter.h"
@@ -162,6 +164,41 @@ TEST(AesCtrHmacStreamSegmentEncrypterTest, EncryptNullCtBuffer) {
       StatusIs(util::error::INVALID_ARGUMENT, HasSubstr("must be non-null")));
 }
 
+TEST(AesCtrHmacStreamSegmentEncrypterTest, EncryptSegmentInto) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  AesCtrHmacStreaming::Params params = ValidParams();
+  std::string associated_data = "associated data";
+
+  auto enc_result =
+      AesCtrHmacStreamSegmentEncrypter::New(params, associated_data);
+  ASSERT_THAT(enc_result.status(), IsOk());
+  auto enc = std::move(enc_result.ValueOrDie());
+
+  std::vector<uint8_t> pt(enc->get_plaintext_segment_size(), 'p');
+  std::vector<uint8_t> expected_ct;
+  ASSERT_THAT(enc->EncryptSegmentAt(pt, /*segment_number=*/0,
+                                    /*is_last_segment=*/false, &expected_ct),
+              IsOk());
+
+  // The buffer may be larger than the ciphertext segment.
+  std::vector<uint8_t> buffer(expected_ct.size() + 10, 'x');
+  auto into_result = enc->EncryptSegmentInto(pt, false, absl::MakeSpan(buffer));
+  ASSERT_THAT(into_result.status(), IsOk());
+  EXPECT_EQ(into_result.ValueOrDie(), expected_ct.size());
+  EXPECT_EQ(std::vector<uint8_t>(buffer.begin(),
+                                 buffer.begin() + expected_ct.size()),
+            expected_ct);
+  EXPECT_EQ(enc->get_segment_number(), 1);
+
+  buffer.resize(expected_ct.size() - 1);
+  EXPECT_THAT(
+      enc->EncryptSegmentInto(pt, true, absl::MakeSpan(buffer)).status(),
+      StatusIs(util::error::INVALID_ARGUMENT, HasSubstr("too small")));
+  EXPECT_EQ(enc->get_segment_number(), 1);
+}
+
 TEST(AesCtrHmacStreamSegmentDecrypterTest, Basic) {
   if (kUseOnlyFips) {
     GTEST_SKIP() << "Not supported in FIPS-only mode";
@@ -378,6 +415,129 @@ TEST(AesCtrHmacStreamSegmentDecrypterTest, DecryptNullPtBuffer) {
       StatusIs(util::error::INVALID_ARGUMENT, HasSubstr("must be non-null")));
 }
 
+TEST(AesCtrHmacStreamSegmentDecrypterTest, DecryptSegmentInto) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  AesCtrHmacStreaming::Params params = ValidParams();
+  std::string associated_data = "associated data";
+
+  auto enc_result =
+      AesCtrHmacStreamSegmentEncrypter::New(params, associated_data);
+  ASSERT_THAT(enc_result.status(), IsOk());
+  auto enc = std::move(enc_result.ValueOrDie());
+  auto dec_result =
+      AesCtrHmacStreamSegmentDecrypter::New(params, associated_data);
+  ASSERT_THAT(dec_result.status(), IsOk());
+  auto dec = std::move(dec_result.ValueOrDie());
+  ASSERT_THAT(dec->Init(enc->get_header()), IsOk());
+
+  // Encrypt and decrypt a segment within larger buffers, without vectors
+  // of the exact segment sizes.
+  std::vector<uint8_t> pt(dec->get_plaintext_segment_size(), 'p');
+  std::vector<uint8_t> ct_buffer(dec->get_ciphertext_segment_size() + 10);
+  auto ct_size = enc->EncryptSegmentInto(absl::MakeConstSpan(pt).subspan(5),
+                                         false, absl::MakeSpan(ct_buffer));
+  ASSERT_THAT(ct_size.status(), IsOk());
+  std::vector<uint8_t> pt_buffer(dec->get_plaintext_segment_size());
+  auto pt_size = dec->DecryptSegmentInto(
+      absl::MakeConstSpan(ct_buffer.data(), ct_size.ValueOrDie()), 0, false,
+      absl::MakeSpan(pt_buffer));
+  ASSERT_THAT(pt_size.status(), IsOk());
+  EXPECT_EQ(pt_size.ValueOrDie(), pt.size() - 5);
+  EXPECT_EQ(std::vector<uint8_t>(pt_buffer.begin(),
+                                 pt_buffer.begin() + pt.size() - 5),
+            std::vector<uint8_t>(pt.begin() + 5, pt.end()));
+
+  EXPECT_THAT(
+      dec->DecryptSegmentInto(
+             absl::MakeConstSpan(ct_buffer.data(), ct_size.ValueOrDie()), 0,
+             false, absl::MakeSpan(pt_buffer.data(), pt.size() - 6))
+          .status(),
+      StatusIs(util::error::INVALID_ARGUMENT, HasSubstr("too small")));
+}
+
+TEST(AesCtrHmacStreamSegmentDecrypterTest, ReusesContextsAcrossSegments) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  AesCtrHmacStreaming::Params params = ValidParams();
+  std::string associated_data = "associated data";
+  auto enc_result =
+      AesCtrHmacStreamSegmentEncrypter::New(params, associated_data);
+  ASSERT_THAT(enc_result.status(), IsOk());
+  auto enc = std::move(enc_result.ValueOrDie());
+  auto dec_result =
+      AesCtrHmacStreamSegmentDecrypter::New(params, associated_data);
+  ASSERT_THAT(dec_result.status(), IsOk());
+  auto dec = std::move(dec_result.ValueOrDie());
+  ASSERT_THAT(dec->Init(enc->get_header()), IsOk());
+
+  // Identical plaintexts give different ciphertexts, since each segment
+  // gets its own IV even though the cipher context is reused.
+  std::vector<uint8_t> pt(enc->get_plaintext_segment_size(), 'p');
+  std::vector<std::vector<uint8_t>> cts(4);
+  for (int i = 0; i < cts.size(); i++) {
+    ASSERT_THAT(enc->EncryptSegment(pt, i == cts.size() - 1, &cts[i]), IsOk());
+  }
+  EXPECT_NE(cts[0], cts[1]);
+
+  // Decrypt out of order, with a failing segment in between.
+  std::vector<uint8_t> decrypted;
+  for (int i : {2, 0, 3, 1}) {
+    SCOPED_TRACE(absl::StrCat("segment_number = ", i));
+    EXPECT_THAT(dec->DecryptSegment(cts[i], i, i == cts.size() - 1,
+                                    &decrypted),
+                IsOk());
+    EXPECT_EQ(pt, decrypted);
+    EXPECT_THAT(dec->DecryptSegment(cts[i], i + 1, false, &decrypted),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+}
+
+TEST(AesCtrHmacStreamSegmentDecrypterTest, SharesContextsThroughKeyCache) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  AesCtrHmacStreaming::Params params = ValidParams();
+  std::string associated_data = "associated data";
+  auto key_cache =
+      std::make_shared<DerivedKeyCache<AesCtrHmacKeyedContexts>>(2);
+  auto enc_result =
+      AesCtrHmacStreamSegmentEncrypter::New(params, associated_data);
+  ASSERT_THAT(enc_result.status(), IsOk());
+  auto enc = std::move(enc_result.ValueOrDie());
+  std::vector<uint8_t> pt(enc->get_plaintext_segment_size(), 'p');
+  std::vector<uint8_t> ct;
+  ASSERT_THAT(enc->EncryptSegment(pt, true, &ct), IsOk());
+
+  std::string salt(reinterpret_cast<const char*>(enc->get_header().data()) + 1,
+                   params.key_size);
+  EXPECT_EQ(key_cache->Get(salt, associated_data), nullptr);
+  for (int i = 0; i < 2; i++) {
+    SCOPED_TRACE(absl::StrCat("decrypter = ", i));
+    auto dec_result = AesCtrHmacStreamSegmentDecrypter::New(
+        params, associated_data, key_cache);
+    ASSERT_THAT(dec_result.status(), IsOk());
+    auto dec = std::move(dec_result.ValueOrDie());
+    ASSERT_THAT(dec->Init(enc->get_header()), IsOk());
+    EXPECT_NE(key_cache->Get(salt, associated_data), nullptr);
+    std::vector<uint8_t> decrypted;
+    EXPECT_THAT(dec->DecryptSegment(ct, 0, true, &decrypted), IsOk());
+    EXPECT_EQ(pt, decrypted);
+  }
+
+  // Other associated data neither hits the cache nor decrypts.
+  auto dec_result = AesCtrHmacStreamSegmentDecrypter::New(
+      params, "other associated data", key_cache);
+  ASSERT_THAT(dec_result.status(), IsOk());
+  auto dec = std::move(dec_result.ValueOrDie());
+  ASSERT_THAT(dec->Init(enc->get_header()), IsOk());
+  std::vector<uint8_t> decrypted;
+  EXPECT_THAT(dec->DecryptSegment(ct, 0, true, &decrypted),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
 TEST(AesCtrHmacStreamingTest, Basic) {
   if (kUseOnlyFips) {
     GTEST_SKIP() << "Not supported in FIPS-only mode";
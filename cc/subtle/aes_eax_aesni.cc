@@ -31,6 +31,7 @@
 #include <string>
 
 #include "absl/algorithm/container.h"
+#include "absl/memory/memory.h"
 #include "tink/subtle/random.h"
 #include "tink/subtle/subtle_util.h"
 #include "tink/subtle/subtle_util_boringssl.h"
@@ -81,9 +82,9 @@ inline __m128i Increment(__m128i x) {
 // So far I've not found a simple way to compute and add the carry using
 // xmm instructions. However, optimizing this function is not important,
 // since it is used just once during decryption.
-inline __m128i Add(__m128i x, uint64 y) {
-  // Convert to a vector of two uint64.
-  uint64 vec[2];
+inline __m128i Add(__m128i x, uint64_t y) {
+  // Convert to a vector of two uint64_t.
+  uint64_t vec[2];
   _mm_storeu_si128(reinterpret_cast<__m128i*>(vec), x);
   // Perform the addition on the vector.
   vec[0] += y;
@@ -163,7 +164,7 @@ uint8_t Rcon(int round) {
 // This performs a rotation and a substitution with an S-box.
 // This implementation uses AESKEYGENASSIST to compute the result twice
 // and checks that the two results match.
-inline uint32 SubRot(uint32 tmp) {
+inline uint32_t SubRot(uint32_t tmp) {
   __m128i inp = _mm_set_epi32(0, 0, tmp, 0);
   __m128i out = _mm_aeskeygenassist_si128(inp, 0x00);
   return _mm_extract_epi32(out, 1);
@@ -172,7 +173,7 @@ inline uint32 SubRot(uint32 tmp) {
 // Apply the S-box to the 4 bytes in a word.
 // This operation is used in the key expansion of 256-bit keys.
 // This implementation computes the result twice and checks equality.
-inline uint32 SubWord(uint32 tmp) {
+inline uint32_t SubWord(uint32_t tmp) {
   __m128i inp = _mm_set_epi32(0, 0, tmp, 0);
   __m128i out = _mm_aeskeygenassist_si128(inp, 0x00);
   return _mm_extract_epi32(out, 0);
@@ -184,12 +185,12 @@ void Aes128KeyExpansion(const uint8_t* key, __m128i *round_key) {
   const int Nk = 4;  // Number of words in the key
   const int Nb = 4;  // Number of words per round key
   const int Nr = 10;  // Number or rounds
-  uint32 *w = reinterpret_cast<uint32*>(round_key);
-  const uint32 *keywords = reinterpret_cast<const uint32*>(key);
+  uint32_t *w = reinterpret_cast<uint32_t*>(round_key);
+  const uint32_t *keywords = reinterpret_cast<const uint32_t*>(key);
   for (int i = 0; i < Nk; i++) {
     w[i] = keywords[i];
   }
-  uint32 tmp = w[Nk - 1];
+  uint32_t tmp = w[Nk - 1];
   for (int i = Nk; i < Nb * (Nr + 1); i++) {
     if (i % Nk == 0) {
       tmp = SubRot(tmp) ^ Rcon(i / Nk);
@@ -203,12 +204,12 @@ void Aes256KeyExpansion(const uint8_t* key, __m128i *round_key) {
   const int Nk = 8;  // Number of words in the key
   const int Nb = 4;  // Number of words per round key
   const int Nr = 14;  // Number or rounds
-  uint32 *w = reinterpret_cast<uint32*>(round_key);
-  const uint32 *keywords = reinterpret_cast<const uint32*>(key);
+  uint32_t *w = reinterpret_cast<uint32_t*>(round_key);
+  const uint32_t *keywords = reinterpret_cast<const uint32_t*>(key);
   for (int i = 0; i < Nk; i++) {
     w[i] = keywords[i];
   }
-  uint32 tmp = w[Nk - 1];
+  uint32_t tmp = w[Nk - 1];
   for (int i = Nk; i < Nb * (Nr + 1); i++) {
     if (i % Nk == 0) {
       tmp = SubRot(tmp) ^ Rcon(i / Nk);
@@ -268,6 +269,9 @@ bool AesEaxAesni::SetKey(const util::SecretData& key) {
   __m128i zero_encrypted = EncryptBlock(zero);
   *B_ = MultiplyByX(zero_encrypted);
   *P_ = MultiplyByX(*B_);
+  for (int tag = 0; tag < 3; tag++) {
+    (*encrypted_tags_)[tag] = EncryptBlock(_mm_set_epi32(tag << 24, 0, 0, 0));
+  }
   return true;
 }
 
@@ -337,24 +341,51 @@ __m128i AesEaxAesni::Pad(const uint8_t* data, int len) const {
   }
 }
 
-__m128i AesEaxAesni::OMAC(absl::string_view blob, int tag) const {
-  const uint8_t* data = reinterpret_cast<const uint8_t*>(blob.data());
-  size_t len = blob.size();
-  __m128i state = _mm_set_epi32(tag << 24, 0, 0, 0);
+__m128i AesEaxAesni::OMACInitialState(size_t len, int tag) const {
   if (len == 0) {
-    state = _mm_xor_si128(state, *B_);
-  } else {
-    state = EncryptBlock(state);
-    size_t idx = 0;
-    while (len - idx > kBlockSize) {
-      __m128i in = _mm_loadu_si128((__m128i*) (data + idx));
-      state = _mm_xor_si128(in, state);
-      state = EncryptBlock(state);
-      idx += kBlockSize;
-    }
-    state = _mm_xor_si128(state, Pad(data + idx, len - idx));
+    return _mm_setzero_si128();
+  }
+  return (*encrypted_tags_)[tag];
+}
+
+__m128i AesEaxAesni::OMACStepInput(const uint8_t* data, size_t len, int tag,
+                                   size_t step, __m128i state) const {
+  if (len == 0) {
+    return _mm_xor_si128(_mm_set_epi32(tag << 24, 0, 0, 0), *B_);
+  }
+  size_t idx = step * kBlockSize;
+  if (len - idx > kBlockSize) {
+    __m128i in = _mm_loadu_si128((__m128i*) (data + idx));
+    return _mm_xor_si128(in, state);
+  }
+  return _mm_xor_si128(state, Pad(data + idx, len - idx));
+}
+
+void AesEaxAesni::OMAC2(absl::string_view blob0, int tag0,
+                        absl::string_view blob1, int tag1, __m128i* mac0,
+                        __m128i* mac1) const {
+  const uint8_t* data0 = reinterpret_cast<const uint8_t*>(blob0.data());
+  const uint8_t* data1 = reinterpret_cast<const uint8_t*>(blob1.data());
+  size_t len0 = blob0.size();
+  size_t len1 = blob1.size();
+  const size_t steps0 = OMACSteps(len0);
+  const size_t steps1 = OMACSteps(len1);
+  __m128i state0 = OMACInitialState(len0, tag0);
+  __m128i state1 = OMACInitialState(len1, tag1);
+  size_t step = 0;
+  for (; step < steps0 && step < steps1; step++) {
+    Encrypt2Blocks(OMACStepInput(data0, len0, tag0, step, state0),
+                   OMACStepInput(data1, len1, tag1, step, state1), &state0,
+                   &state1);
+  }
+  for (size_t i = step; i < steps0; i++) {
+    state0 = EncryptBlock(OMACStepInput(data0, len0, tag0, i, state0));
+  }
+  for (size_t i = step; i < steps1; i++) {
+    state1 = EncryptBlock(OMACStepInput(data1, len1, tag1, i, state1));
   }
-  return EncryptBlock(state);
+  *mac0 = state0;
+  *mac1 = state1;
 }
 
 bool AesEaxAesni::RawEncrypt(absl::string_view nonce, absl::string_view in,
@@ -368,9 +399,11 @@ bool AesEaxAesni::RawEncrypt(absl::string_view nonce, absl::string_view in,
 
   // NOTE(bleichen): The author of EAX designed this mode, so that
   //   it would be possible to compute N and H independently of the encryption.
-  //   So far this possiblity is not used in this implementation.
-  const __m128i N = OMAC(nonce, 0);
-  const __m128i H = OMAC(additional_data, 1);
+  //   N and H are computed concurrently; the OMAC of the ciphertext is a
+  //   chain of dependent block encryptions and bounds the throughput.
+  __m128i N;
+  __m128i H;
+  OMAC2(nonce, 0, additional_data, 1, &N, &H);
 
   // Compute the initial counter in little endian order.
   // EAX uses big endian order, but it is easier to increment
@@ -423,8 +456,9 @@ bool AesEaxAesni::RawEncrypt(absl::string_view nonce, absl::string_view in,
 bool AesEaxAesni::RawDecrypt(absl::string_view nonce, absl::string_view in,
                              absl::string_view additional_data,
                              absl::Span<uint8_t> plaintext) const {
-  __m128i N = OMAC(nonce, 0);
-  __m128i H = OMAC(additional_data, 1);
+  __m128i N;
+  __m128i H;
+  OMAC2(nonce, 0, additional_data, 1, &N, &H);
 
   const uint8_t* ciphertext = reinterpret_cast<const uint8_t*>(in.data());
   const size_t ciphertext_size = in.size();
@@ -530,10 +564,10 @@ crypto::tink::util::StatusOr<std::string> AesEaxAesni::Encrypt(
   size_t ciphertext_size = plaintext.size() + nonce_size_ + kTagSize;
   std::string ciphertext;
   ResizeStringUninitialized(&ciphertext, ciphertext_size);
-  const std::string nonce = Random::GetRandomBytes(nonce_size_);
-  absl::c_copy(nonce, ciphertext.begin());
+  Random::GetRandomNonceBytes(absl::MakeSpan(&ciphertext[0], nonce_size_));
   bool result = RawEncrypt(
-      nonce, plaintext, additional_data,
+      absl::string_view(ciphertext).substr(0, nonce_size_), plaintext,
+      additional_data,
       absl::MakeSpan(reinterpret_cast<uint8_t*>(&ciphertext[nonce_size_]),
                      ciphertext_size - nonce_size_));
   if (!result) {
@@ -562,7 +596,9 @@ crypto::tink::util::StatusOr<std::string> AesEaxAesni::Decrypt(
       nonce, encrypted, additional_data,
       absl::MakeSpan(reinterpret_cast<uint8_t*>(&res[0]), res.size()));
   if (!result) {
-    return util::Status(util::error::INTERNAL, "Decryption failed");
+    static const util::Status* kDecryptionFailed =
+        util::Status::NewStatic(util::error::INTERNAL, "Decryption failed");
+    return *kDecryptionFailed;
   }
   return res;
 }
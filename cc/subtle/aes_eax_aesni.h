@@ -102,21 +102,45 @@ class AesEaxAesni : public Aead {
   // Pads a partial block of size 1 .. 16.
   __m128i Pad(const uint8_t* data, int len) const;
 
-  // Computes an OMAC.
-  __m128i OMAC(absl::string_view blob, int tag) const;
+  // Returns the number of block encryptions of the OMAC of a blob of size
+  // len.
+  static size_t OMACSteps(size_t len) {
+    return len == 0 ? 1 : (len + kBlockSize - 1) / kBlockSize;
+  }
+
+  // Returns the initial state of the OMAC of a blob of size len.
+  __m128i OMACInitialState(size_t len, int tag) const;
+
+  // Returns the input of the block encryption in step 'step' of the OMAC
+  // of data[0] .. data[len - 1], given the state after the previous step.
+  __m128i OMACStepInput(const uint8_t* data, size_t len, int tag, size_t step,
+                        __m128i state) const;
+
+  // Computes the OMACs of two blobs concurrently. The block encryptions of
+  // the two OMACs are independent, so that computing them together takes
+  // about as long as computing the longer one.
+  void OMAC2(absl::string_view blob0, int tag0, absl::string_view blob1,
+             int tag1, __m128i* mac0, __m128i* mac1) const;
 
   static constexpr int kMaxRounds = 14;  // maximal number of rounds
   static constexpr int kMaxRoundKeys =
       kMaxRounds + 1;  // max number of round keys
   using RoundKeys = std::array<__m128i, kMaxRoundKeys>;
   util::SecretUniquePtr<RoundKeys> round_key_ =
-      util::MakeSecretUniquePtr<RoundKeys>();
+      util::MakeKeyStateUniquePtr<RoundKeys>();
   util::SecretUniquePtr<RoundKeys> round_dec_key_ =
-      util::MakeSecretUniquePtr<RoundKeys>();
+      util::MakeKeyStateUniquePtr<RoundKeys>();
   util::SecretUniquePtr<__m128i> B_ =
-      util::MakeSecretUniquePtr<__m128i>();  // Used for padding
+      util::MakeKeyStateUniquePtr<__m128i>();  // Used for padding
   util::SecretUniquePtr<__m128i> P_ =
-      util::MakeSecretUniquePtr<__m128i>();  // Used for padding
+      util::MakeKeyStateUniquePtr<__m128i>();  // Used for padding
+  // The encryptions of the blocks [0], [1] and [2] that start the OMACs of
+  // the nonce, the additional data and the ciphertext. They only depend on
+  // the key, and saving them shortens the chain of dependent block
+  // encryptions of each OMAC by one.
+  using EncryptedTags = std::array<__m128i, 3>;
+  util::SecretUniquePtr<EncryptedTags> encrypted_tags_ =
+      util::MakeKeyStateUniquePtr<EncryptedTags>();
   int rounds_;
   const size_t nonce_size_;
 };
@@ -0,0 +1,386 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(__aarch64__) && \
+    (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+
+#include "tink/subtle/aes_eax_armce.h"
+
+#include <arm_neon.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "absl/algorithm/container.h"
+#include "absl/memory/memory.h"
+#include "openssl/mem.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/subtle_util.h"
+#include "tink/subtle/subtle_util_boringssl.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+namespace {
+
+// Loads block[0] .. block[block_size - 1] and sets the remaining bytes to 0.
+uint8x16_t LoadPartialBlock(const uint8_t* block, size_t block_size) {
+  std::array<uint8_t, 16> tmp;
+  tmp.fill(0);
+  std::copy_n(block, block_size, tmp.begin());
+  return vld1q_u8(tmp.data());
+}
+
+// Stores the first block_size bytes of value in block[0] .. block[block_size
+// - 1].
+void StorePartialBlock(uint8_t* block, size_t block_size, uint8x16_t value) {
+  std::array<uint8_t, 16> tmp;
+  vst1q_u8(tmp.data(), value);
+  std::copy_n(tmp.begin(), block_size, block);
+}
+
+bool EqualBlocks(uint8x16_t x, uint8x16_t y) {
+  std::array<uint8_t, 16> x_bytes;
+  std::array<uint8_t, 16> y_bytes;
+  vst1q_u8(x_bytes.data(), x);
+  vst1q_u8(y_bytes.data(), y);
+  return CRYPTO_memcmp(x_bytes.data(), y_bytes.data(), 16) == 0;
+}
+
+// Returns the block [tag] that starts the OMAC with the given tag.
+uint8x16_t TagBlock(int tag) {
+  std::array<uint8_t, 16> tmp;
+  tmp.fill(0);
+  tmp[15] = tag;
+  return vld1q_u8(tmp.data());
+}
+
+// Multiplies a binary polynomial given in big endian order by x and reduces
+// it modulo x^128 + x^7 + x^2 + x + 1. Only used when setting the key.
+uint8x16_t MultiplyByX(uint8x16_t value) {
+  std::array<uint8_t, 16> block;
+  vst1q_u8(block.data(), value);
+  uint8_t carry = 0x87 & -(block[0] >> 7);
+  for (size_t i = 0; i < 15; ++i) {
+    block[i] = (block[i] << 1) | (block[i + 1] >> 7);
+  }
+  block[15] = (block[15] << 1) ^ carry;
+  return vld1q_u8(block.data());
+}
+
+// The 128-bit big endian counter of the CTR mode.
+class Counter {
+ public:
+  explicit Counter(uint8x16_t block) {
+    std::array<uint8_t, 16> bytes;
+    vst1q_u8(bytes.data(), block);
+    for (int i = 0; i < 8; i++) {
+      hi_ = (hi_ << 8) | bytes[i];
+      lo_ = (lo_ << 8) | bytes[i + 8];
+    }
+  }
+
+  uint8x16_t Block() const {
+    std::array<uint8_t, 16> bytes;
+    for (int i = 0; i < 8; i++) {
+      bytes[i] = hi_ >> (56 - 8 * i);
+      bytes[i + 8] = lo_ >> (56 - 8 * i);
+    }
+    return vld1q_u8(bytes.data());
+  }
+
+  void Increment() {
+    if (++lo_ == 0) hi_++;
+  }
+
+ private:
+  uint64_t hi_ = 0;
+  uint64_t lo_ = 0;
+};
+
+static const uint8_t kRoundConstant[11] =
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36};
+
+// Applies the S-box to the 4 bytes of a word. AESE with a zero round key
+// applies SubBytes and ShiftRows, and ShiftRows has no effect if all columns
+// of the state are equal.
+inline uint32_t SubWord(uint32_t word) {
+  uint8x16_t state = vreinterpretq_u8_u32(vdupq_n_u32(word));
+  state = vaeseq_u8(state, vdupq_n_u8(0));
+  return vgetq_lane_u32(vreinterpretq_u32_u8(state), 0);
+}
+
+// Rotates the bytes of a word, with the words in little endian order.
+inline uint32_t RotWord(uint32_t word) { return (word >> 8) | (word << 24); }
+
+// The key expansion of FIPS 197, for keys of 'nk' words.
+void KeyExpansion(const uint8_t* key, int nk, int rounds,
+                  uint8x16_t* round_key) {
+  uint32_t w[4 * 15];
+  std::memcpy(w, key, 4 * nk);
+  for (int i = nk; i < 4 * (rounds + 1); i++) {
+    uint32_t tmp = w[i - 1];
+    if (i % nk == 0) {
+      tmp = SubWord(RotWord(tmp)) ^ kRoundConstant[i / nk];
+    } else if (nk > 6 && i % nk == 4) {
+      tmp = SubWord(tmp);
+    }
+    w[i] = w[i - nk] ^ tmp;
+  }
+  for (int i = 0; i <= rounds; i++) {
+    round_key[i] = vld1q_u8(reinterpret_cast<const uint8_t*>(&w[4 * i]));
+  }
+  OPENSSL_cleanse(w, sizeof(w));
+}
+
+bool IsValidNonceSize(size_t nonce_size) {
+  return nonce_size == 12 || nonce_size == 16;
+}
+
+bool IsValidKeySize(size_t key_size) {
+  return key_size == 16 || key_size == 32;
+}
+
+// Returns the number of block encryptions of the OMAC of a blob of size len.
+size_t OMACSteps(size_t len) { return len == 0 ? 1 : (len + 15) / 16; }
+
+}  // namespace
+
+crypto::tink::util::StatusOr<std::unique_ptr<Aead>> AesEaxArmCe::New(
+    const util::SecretData& key, size_t nonce_size_in_bytes) {
+  if (!IsValidKeySize(key.size())) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Invalid key size");
+  }
+  if (!IsValidNonceSize(nonce_size_in_bytes)) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Invalid nonce size");
+  }
+  auto eax = absl::WrapUnique(new AesEaxArmCe(nonce_size_in_bytes));
+  if (!eax->SetKey(key)) {
+    return util::Status(util::error::INTERNAL, "Setting AES key failed");
+  }
+  return {std::move(eax)};
+}
+
+bool AesEaxArmCe::SetKey(const util::SecretData& key) {
+  if (key.size() == 16) {
+    rounds_ = 10;
+  } else if (key.size() == 32) {
+    rounds_ = 14;
+  } else {
+    return false;
+  }
+  KeyExpansion(key.data(), key.size() / 4, rounds_, round_key_->data());
+  // Derive the paddings from the key.
+  *B_ = MultiplyByX(EncryptBlock(vdupq_n_u8(0)));
+  *P_ = MultiplyByX(*B_);
+  for (int tag = 0; tag < 3; tag++) {
+    (*encrypted_tags_)[tag] = EncryptBlock(TagBlock(tag));
+  }
+  return true;
+}
+
+inline uint8x16_t AesEaxArmCe::EncryptBlock(uint8x16_t block) const {
+  for (int i = 0; i < rounds_ - 1; i++) {
+    block = vaesmcq_u8(vaeseq_u8(block, (*round_key_)[i]));
+  }
+  block = vaeseq_u8(block, (*round_key_)[rounds_ - 1]);
+  return veorq_u8(block, (*round_key_)[rounds_]);
+}
+
+inline void AesEaxArmCe::Encrypt2Blocks(uint8x16_t in0, uint8x16_t in1,
+                                        uint8x16_t* out0,
+                                        uint8x16_t* out1) const {
+  for (int i = 0; i < rounds_ - 1; i++) {
+    uint8x16_t round_key = (*round_key_)[i];
+    in0 = vaesmcq_u8(vaeseq_u8(in0, round_key));
+    in1 = vaesmcq_u8(vaeseq_u8(in1, round_key));
+  }
+  uint8x16_t round_key = (*round_key_)[rounds_ - 1];
+  uint8x16_t last_round = (*round_key_)[rounds_];
+  *out0 = veorq_u8(vaeseq_u8(in0, round_key), last_round);
+  *out1 = veorq_u8(vaeseq_u8(in1, round_key), last_round);
+}
+
+uint8x16_t AesEaxArmCe::Pad(const uint8_t* data, size_t len) const {
+  std::array<uint8_t, kBlockSize> tmp;
+  tmp.fill(0);
+  std::copy_n(data, len, tmp.begin());
+  if (len == kBlockSize) {
+    return veorq_u8(vld1q_u8(tmp.data()), *B_);
+  }
+  tmp[len] = 0x80;
+  return veorq_u8(vld1q_u8(tmp.data()), *P_);
+}
+
+void AesEaxArmCe::OMAC2(absl::string_view blob0, int tag0,
+                        absl::string_view blob1, int tag1, uint8x16_t* mac0,
+                        uint8x16_t* mac1) const {
+  auto initial_state = [this](size_t len, int tag) {
+    return len == 0 ? vdupq_n_u8(0) : (*encrypted_tags_)[tag];
+  };
+  auto step_input = [this](const uint8_t* data, size_t len, int tag,
+                           size_t step, uint8x16_t state) {
+    if (len == 0) return veorq_u8(TagBlock(tag), *B_);
+    size_t idx = step * kBlockSize;
+    if (len - idx > kBlockSize) return veorq_u8(vld1q_u8(data + idx), state);
+    return veorq_u8(state, Pad(data + idx, len - idx));
+  };
+  const uint8_t* data0 = reinterpret_cast<const uint8_t*>(blob0.data());
+  const uint8_t* data1 = reinterpret_cast<const uint8_t*>(blob1.data());
+  size_t len0 = blob0.size();
+  size_t len1 = blob1.size();
+  const size_t steps0 = OMACSteps(len0);
+  const size_t steps1 = OMACSteps(len1);
+  uint8x16_t state0 = initial_state(len0, tag0);
+  uint8x16_t state1 = initial_state(len1, tag1);
+  size_t step = 0;
+  for (; step < steps0 && step < steps1; step++) {
+    Encrypt2Blocks(step_input(data0, len0, tag0, step, state0),
+                   step_input(data1, len1, tag1, step, state1), &state0,
+                   &state1);
+  }
+  for (size_t i = step; i < steps0; i++) {
+    state0 = EncryptBlock(step_input(data0, len0, tag0, i, state0));
+  }
+  for (size_t i = step; i < steps1; i++) {
+    state1 = EncryptBlock(step_input(data1, len1, tag1, i, state1));
+  }
+  *mac0 = state0;
+  *mac1 = state1;
+}
+
+uint8x16_t AesEaxArmCe::CtrAndOMAC(uint8x16_t n, absl::Span<const uint8_t> in,
+                                   uint8_t* out, bool encrypt) const {
+  uint8x16_t mac = TagBlock(2);
+  if (in.empty()) return EncryptBlock(veorq_u8(mac, *B_));
+  Counter ctr(n);
+  uint8x16_t key_stream;
+  size_t idx = 0;
+  while (idx + kBlockSize < in.size()) {
+    // Gets the key stream for one block and computes the MAC of the previous
+    // ciphertext block or header.
+    uint8x16_t block = vld1q_u8(&in[idx]);
+    Encrypt2Blocks(mac, ctr.Block(), &mac, &key_stream);
+    uint8x16_t result = veorq_u8(block, key_stream);
+    vst1q_u8(out + idx, result);
+    mac = veorq_u8(mac, encrypt ? result : block);
+    ctr.Increment();
+    idx += kBlockSize;
+  }
+  size_t last_block_size = in.size() - idx;
+  Encrypt2Blocks(mac, ctr.Block(), &mac, &key_stream);
+  uint8x16_t block = LoadPartialBlock(&in[idx], last_block_size);
+  StorePartialBlock(out + idx, last_block_size, veorq_u8(block, key_stream));
+  mac = veorq_u8(mac, Pad(encrypt ? out + idx : &in[idx], last_block_size));
+  return EncryptBlock(mac);
+}
+
+bool AesEaxArmCe::RawEncrypt(absl::string_view nonce, absl::string_view in,
+                             absl::string_view additional_data,
+                             absl::Span<uint8_t> ciphertext) const {
+  if (in.size() + kTagSize != ciphertext.size()) {
+    return false;
+  }
+  uint8x16_t N;
+  uint8x16_t H;
+  OMAC2(nonce, 0, additional_data, 1, &N, &H);
+  uint8x16_t mac = CtrAndOMAC(
+      N,
+      absl::MakeSpan(reinterpret_cast<const uint8_t*>(in.data()), in.size()),
+      ciphertext.data(), /*encrypt=*/true);
+  uint8x16_t tag = veorq_u8(veorq_u8(mac, N), H);
+  vst1q_u8(&ciphertext[in.size()], tag);
+  return true;
+}
+
+bool AesEaxArmCe::RawDecrypt(absl::string_view nonce, absl::string_view in,
+                             absl::string_view additional_data,
+                             absl::Span<uint8_t> plaintext) const {
+  if (in.size() < kTagSize || in.size() - kTagSize != plaintext.size()) {
+    return false;
+  }
+  uint8x16_t N;
+  uint8x16_t H;
+  OMAC2(nonce, 0, additional_data, 1, &N, &H);
+  const uint8_t* ciphertext = reinterpret_cast<const uint8_t*>(in.data());
+  uint8x16_t mac =
+      CtrAndOMAC(N, absl::MakeSpan(ciphertext, plaintext.size()),
+                 plaintext.data(), /*encrypt=*/false);
+  uint8x16_t tag = veorq_u8(veorq_u8(mac, N), H);
+  if (!EqualBlocks(tag, vld1q_u8(&ciphertext[plaintext.size()]))) {
+    absl::c_fill(plaintext, 0);
+    return false;
+  }
+  return true;
+}
+
+crypto::tink::util::StatusOr<std::string> AesEaxArmCe::Encrypt(
+    absl::string_view plaintext, absl::string_view additional_data) const {
+  plaintext = SubtleUtilBoringSSL::EnsureNonNull(plaintext);
+  additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
+
+  if (SIZE_MAX - nonce_size_ - kTagSize <= plaintext.size()) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Plaintext too long");
+  }
+  size_t ciphertext_size = plaintext.size() + nonce_size_ + kTagSize;
+  std::string ciphertext;
+  ResizeStringUninitialized(&ciphertext, ciphertext_size);
+  Random::GetRandomNonceBytes(absl::MakeSpan(&ciphertext[0], nonce_size_));
+  bool result = RawEncrypt(
+      absl::string_view(ciphertext).substr(0, nonce_size_), plaintext,
+      additional_data,
+      absl::MakeSpan(reinterpret_cast<uint8_t*>(&ciphertext[nonce_size_]),
+                     ciphertext_size - nonce_size_));
+  if (!result) {
+    return util::Status(util::error::INTERNAL, "Encryption failed");
+  }
+  return ciphertext;
+}
+
+crypto::tink::util::StatusOr<std::string> AesEaxArmCe::Decrypt(
+    absl::string_view ciphertext, absl::string_view additional_data) const {
+  additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
+
+  size_t ct_size = ciphertext.size();
+  if (ct_size < nonce_size_ + kTagSize) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Ciphertext too short");
+  }
+  size_t out_size = ct_size - kTagSize - nonce_size_;
+  absl::string_view nonce = ciphertext.substr(0, nonce_size_);
+  absl::string_view encrypted =
+      ciphertext.substr(nonce_size_, ct_size - nonce_size_);
+  std::string res;
+  ResizeStringUninitialized(&res, out_size);
+  bool result = RawDecrypt(
+      nonce, encrypted, additional_data,
+      absl::MakeSpan(reinterpret_cast<uint8_t*>(&res[0]), res.size()));
+  if (!result) {
+    static const util::Status* kDecryptionFailed =
+        util::Status::NewStatic(util::error::INTERNAL, "Decryption failed");
+    return *kDecryptionFailed;
+  }
+  return res;
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // __aarch64__ && (__ARM_FEATURE_AES || __ARM_FEATURE_CRYPTO)
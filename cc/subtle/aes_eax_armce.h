@@ -0,0 +1,115 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SUBTLE_AES_EAX_ARMCE_H_
+#define TINK_SUBTLE_AES_EAX_ARMCE_H_
+
+#if defined(__aarch64__) && \
+    (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+
+#include <arm_neon.h>
+
+#include <array>
+#include <memory>
+#include <string>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/aead.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// This class implements AES-EAX on aarch64 CPUs with the ARMv8 cryptography
+// extension, like AesEaxAesni does on x86. It supports the same key and
+// nonce sizes and produces the same ciphertexts as AesEaxBoringSsl.
+class AesEaxArmCe : public Aead {
+ public:
+  static crypto::tink::util::StatusOr<std::unique_ptr<Aead>> New(
+      const util::SecretData& key, size_t nonce_size_in_bytes);
+
+  crypto::tink::util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view additional_data) const override;
+
+  crypto::tink::util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view additional_data) const override;
+
+ private:
+  static constexpr size_t kTagSize = 16;
+  static constexpr size_t kBlockSize = 16;
+
+  explicit AesEaxArmCe(size_t nonce_size) : nonce_size_(nonce_size) {}
+
+  // Only called by New(), since instances are immutable.
+  bool SetKey(const util::SecretData& key);
+
+  // Encrypts a single block.
+  uint8x16_t EncryptBlock(uint8x16_t block) const;
+
+  // Encrypts 2 independent blocks, interleaving their rounds.
+  void Encrypt2Blocks(uint8x16_t in0, uint8x16_t in1, uint8x16_t* out0,
+                      uint8x16_t* out1) const;
+
+  // Pads a partial block of size 1 .. 16.
+  uint8x16_t Pad(const uint8_t* data, size_t len) const;
+
+  // Computes the OMACs of two blobs concurrently, see AesEaxAesni::OMAC2().
+  void OMAC2(absl::string_view blob0, int tag0, absl::string_view blob1,
+             int tag1, uint8x16_t* mac0, uint8x16_t* mac1) const;
+
+  // Encrypts or decrypts 'in' in CTR mode starting with the counter 'n',
+  // writing the result to 'out', and returns the OMAC of the ciphertext.
+  // The OMAC of each ciphertext block is computed together with the key
+  // stream of a block.
+  uint8x16_t CtrAndOMAC(uint8x16_t n, absl::Span<const uint8_t> in,
+                        uint8_t* out, bool encrypt) const;
+
+  bool RawEncrypt(absl::string_view nonce, absl::string_view in,
+                  absl::string_view additional_data,
+                  absl::Span<uint8_t> ciphertext) const;
+
+  bool RawDecrypt(absl::string_view nonce, absl::string_view in,
+                  absl::string_view additional_data,
+                  absl::Span<uint8_t> plaintext) const;
+
+  static constexpr int kMaxRounds = 14;
+  using RoundKeys = std::array<uint8x16_t, kMaxRounds + 1>;
+  util::SecretUniquePtr<RoundKeys> round_key_ =
+      util::MakeSecretUniquePtr<RoundKeys>();
+  util::SecretUniquePtr<uint8x16_t> B_ =
+      util::MakeSecretUniquePtr<uint8x16_t>();  // Used for padding
+  util::SecretUniquePtr<uint8x16_t> P_ =
+      util::MakeSecretUniquePtr<uint8x16_t>();  // Used for padding
+  // The encryptions of the blocks [0], [1] and [2], see AesEaxAesni.
+  using EncryptedTags = std::array<uint8x16_t, 3>;
+  util::SecretUniquePtr<EncryptedTags> encrypted_tags_ =
+      util::MakeSecretUniquePtr<EncryptedTags>();
+  int rounds_;
+  const size_t nonce_size_;
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // __aarch64__ && (__ARM_FEATURE_AES || __ARM_FEATURE_CRYPTO)
+#endif  // TINK_SUBTLE_AES_EAX_ARMCE_H_
@@ -0,0 +1,112 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(__aarch64__) && \
+    (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+
+#include "tink/subtle/aes_eax_armce.h"
+
+#include <string>
+
+#include "gtest/gtest.h"
+#include "tink/subtle/aes_eax_boringssl.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+using ::crypto::tink::test::HexDecodeOrDie;
+using ::crypto::tink::test::IsOk;
+
+struct TestVector {
+  std::string key;
+  std::string nonce;
+  std::string header;
+  std::string message;
+  std::string ciphertext;
+};
+
+// Test vectors from the EAX paper.
+TEST(AesEaxArmCeTest, TestVectors) {
+  const TestVector kTestVectors[] = {
+      {"233952DEE4D5ED5F9B9C6D6FF80FF478", "62EC67F9C3A4A407FCB2A8C49031A8B3",
+       "6BFB914FD07EAE6B", "", "E037830E8389F27B025A2D6527E79D01"},
+      {"91945D3F4DCBEE0BF45EF52255F095A4", "BECAF043B0A23D843194BA972C66DEBD",
+       "FA3BFD4806EB53FA", "F7FB", "19DD5C4C9331049D0BDAB0277408F67967E5"},
+      {"8395FCF1E95BEBD697BD010BC766AAC3", "22E7ADD93CFC6393C57EC0B3C17D6B44",
+       "126735FCC320D25A", "CA40D7446E545FFAED3BD12A740A659FFBBB3CEAB7",
+       "CB8920F87A6C75CFF39627B56E3ED197C552D295A7CFC46AFC253B4652B1AF3795B124"
+       "AB6E"},
+  };
+  for (const TestVector& v : kTestVectors) {
+    auto cipher = AesEaxArmCe::New(
+        util::SecretDataFromStringView(HexDecodeOrDie(v.key)), 16);
+    ASSERT_THAT(cipher.status(), IsOk());
+    std::string ciphertext =
+        HexDecodeOrDie(v.nonce) + HexDecodeOrDie(v.ciphertext);
+    auto plaintext =
+        cipher.ValueOrDie()->Decrypt(ciphertext, HexDecodeOrDie(v.header));
+    ASSERT_THAT(plaintext.status(), IsOk());
+    EXPECT_EQ(plaintext.ValueOrDie(), HexDecodeOrDie(v.message));
+    ciphertext.back() ^= 1;
+    plaintext =
+        cipher.ValueOrDie()->Decrypt(ciphertext, HexDecodeOrDie(v.header));
+    EXPECT_FALSE(plaintext.ok());
+  }
+}
+
+TEST(AesEaxArmCeTest, CompatibleWithBoringSsl) {
+  for (int key_size : {16, 32}) {
+    for (int nonce_size : {12, 16}) {
+      util::SecretData key(key_size, 0x42);
+      auto armce = AesEaxArmCe::New(key, nonce_size);
+      auto boringssl = AesEaxBoringSsl::New(key, nonce_size);
+      ASSERT_THAT(armce.status(), IsOk());
+      ASSERT_THAT(boringssl.status(), IsOk());
+      for (size_t size = 0; size < 100; size++) {
+        std::string message(size, 'x');
+        auto ciphertext = boringssl.ValueOrDie()->Encrypt(message, "aad");
+        ASSERT_THAT(ciphertext.status(), IsOk());
+        auto plaintext =
+            armce.ValueOrDie()->Decrypt(ciphertext.ValueOrDie(), "aad");
+        ASSERT_THAT(plaintext.status(), IsOk());
+        EXPECT_EQ(plaintext.ValueOrDie(), message);
+        ciphertext = armce.ValueOrDie()->Encrypt(message, "aad");
+        ASSERT_THAT(ciphertext.status(), IsOk());
+        plaintext =
+            boringssl.ValueOrDie()->Decrypt(ciphertext.ValueOrDie(), "aad");
+        ASSERT_THAT(plaintext.status(), IsOk());
+        EXPECT_EQ(plaintext.ValueOrDie(), message);
+      }
+    }
+  }
+}
+
+TEST(AesEaxArmCeTest, InvalidParameters) {
+  EXPECT_FALSE(AesEaxArmCe::New(util::SecretData(24, 0), 12).ok());
+  EXPECT_FALSE(AesEaxArmCe::New(util::SecretData(16, 0), 8).ok());
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // __aarch64__ && (__ARM_FEATURE_AES || __ARM_FEATURE_CRYPTO)
@@ -229,20 +229,41 @@ void AesEaxBoringSsl::CtrCrypt(const Block& N, absl::Span<const uint8_t> in,
                      ecount_buf.data(), &num);
 }
 
+crypto::tink::util::StatusOr<int64_t> AesEaxBoringSsl::CiphertextSize(
+    int64_t plaintext_size) const {
+  return plaintext_size + nonce_size_ + kTagSize;
+}
+
 crypto::tink::util::StatusOr<std::string> AesEaxBoringSsl::Encrypt(
     absl::string_view plaintext, absl::string_view additional_data) const {
+  std::string ciphertext;
+  ResizeStringUninitialized(&ciphertext,
+                            plaintext.size() + nonce_size_ + kTagSize);
+  auto written = EncryptInto(plaintext, additional_data,
+                             absl::MakeSpan(&ciphertext[0], ciphertext.size()));
+  if (!written.ok()) return written.status();
+  return ciphertext;
+}
+
+crypto::tink::util::StatusOr<int64_t> AesEaxBoringSsl::EncryptInto(
+    absl::string_view plaintext, absl::string_view additional_data,
+    absl::Span<char> ciphertext_buffer) const {
   // BoringSSL expects a non-null pointer for plaintext and additional_data,
   // regardless of whether the size is 0.
   plaintext = SubtleUtilBoringSSL::EnsureNonNull(plaintext);
   additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
 
   size_t ciphertext_size = plaintext.size() + nonce_size_ + kTagSize;
-  std::string ciphertext;
-  ResizeStringUninitialized(&ciphertext, ciphertext_size);
-  const std::string nonce = Random::GetRandomBytes(nonce_size_);
+  if (ciphertext_buffer.size() < ciphertext_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_buffer is too small");
+  }
+  Random::GetRandomNonceBytes(ciphertext_buffer.subspan(0, nonce_size_));
+  absl::string_view nonce(ciphertext_buffer.data(), nonce_size_);
   const Block N = Omac(nonce, 0);
   const Block H = Omac(additional_data, 1);
-  uint8_t* ct_start = reinterpret_cast<uint8_t*>(&ciphertext[nonce_size_]);
+  uint8_t* ct_start =
+      reinterpret_cast<uint8_t*>(ciphertext_buffer.data() + nonce_size_);
   CtrCrypt(N,
            absl::MakeSpan(reinterpret_cast<const uint8_t*>(plaintext.data()),
                           plaintext.size()),
@@ -250,13 +271,28 @@ crypto::tink::util::StatusOr<std::string> AesEaxBoringSsl::Encrypt(
   Block mac = Omac(absl::MakeSpan(ct_start, plaintext.size()), 2);
   XorBlock(N.data(), &mac);
   XorBlock(H.data(), &mac);
-  absl::c_copy(nonce, ciphertext.begin());
-  std::copy_n(mac.begin(), kTagSize, &ciphertext[ciphertext_size - kTagSize]);
-  return ciphertext;
+  std::copy_n(mac.begin(), kTagSize,
+              ciphertext_buffer.data() + ciphertext_size - kTagSize);
+  return ciphertext_size;
 }
 
 crypto::tink::util::StatusOr<std::string> AesEaxBoringSsl::Decrypt(
     absl::string_view ciphertext, absl::string_view additional_data) const {
+  size_t ct_size = ciphertext.size();
+  if (ct_size < nonce_size_ + kTagSize) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Ciphertext too short");
+  }
+  std::string res;
+  ResizeStringUninitialized(&res, ct_size - kTagSize - nonce_size_);
+  auto written = DecryptInto(ciphertext, additional_data,
+                             absl::MakeSpan(&res[0], res.size()));
+  if (!written.ok()) return written.status();
+  return res;
+}
+
+crypto::tink::util::StatusOr<int64_t> AesEaxBoringSsl::DecryptInto(
+    absl::string_view ciphertext, absl::string_view additional_data,
+    absl::Span<char> plaintext_buffer) const {
   // BoringSSL expects a non-null pointer for additional_data,
   // regardless of whether the size is 0.
   additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
@@ -266,6 +302,10 @@ crypto::tink::util::StatusOr<std::string> AesEaxBoringSsl::Decrypt(
     return util::Status(util::error::INVALID_ARGUMENT, "Ciphertext too short");
   }
   size_t out_size = ct_size - kTagSize - nonce_size_;
+  if (plaintext_buffer.size() < out_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "plaintext_buffer is too small");
+  }
   absl::string_view nonce = ciphertext.substr(0, nonce_size_);
   absl::string_view encrypted = ciphertext.substr(nonce_size_, out_size);
   absl::string_view tag = ciphertext.substr(ct_size - kTagSize, kTagSize);
@@ -276,15 +316,15 @@ crypto::tink::util::StatusOr<std::string> AesEaxBoringSsl::Decrypt(
   XorBlock(H.data(), &mac);
   const uint8_t *sig = reinterpret_cast<const uint8_t*>(tag.data());
   if (!EqualBlocks(mac.data(), sig)) {
-    return util::Status(util::error::INVALID_ARGUMENT, "Tag mismatch");
+    static const util::Status* kTagMismatch =
+        util::Status::NewStatic(util::error::INVALID_ARGUMENT, "Tag mismatch");
+    return *kTagMismatch;
   }
-  std::string res;
-  ResizeStringUninitialized(&res, out_size);
   CtrCrypt(N,
            absl::MakeSpan(reinterpret_cast<const uint8_t*>(encrypted.data()),
                           encrypted.size()),
-           reinterpret_cast<uint8_t*>(&res[0]));
-  return res;
+           reinterpret_cast<uint8_t*>(plaintext_buffer.data()));
+  return out_size;
 }
 
 }  // namespace subtle
@@ -21,6 +21,7 @@
 
 #include "gtest/gtest.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "openssl/err.h"
 #include "tink/subtle/wycheproof_util.h"
 #include "tink/util/secret_data.h"
@@ -34,6 +35,7 @@ namespace tink {
 namespace subtle {
 namespace {
 
+using ::crypto::tink::test::IsOk;
 using ::crypto::tink::test::StatusIs;
 
 TEST(AesEaxBoringSslTest, TestBasic) {
@@ -57,6 +59,76 @@ TEST(AesEaxBoringSslTest, TestBasic) {
   EXPECT_EQ(pt.ValueOrDie(), message);
 }
 
+TEST(AesEaxBoringSslTest, EncryptIntoDecryptInto) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  auto cipher_result = AesEaxBoringSsl::New(key, 12);
+  ASSERT_THAT(cipher_result.status(), IsOk());
+  auto cipher = std::move(cipher_result.ValueOrDie());
+  std::string message = "Some data to encrypt.";
+  std::string aad = "Some data to authenticate.";
+
+  auto ciphertext_size = cipher->CiphertextSize(message.size());
+  ASSERT_THAT(ciphertext_size.status(), IsOk());
+  EXPECT_EQ(ciphertext_size.ValueOrDie(), message.size() + 28);
+
+  std::vector<char> ciphertext(ciphertext_size.ValueOrDie());
+  auto written =
+      cipher->EncryptInto(message, aad, absl::MakeSpan(ciphertext));
+  ASSERT_THAT(written.status(), IsOk());
+  EXPECT_EQ(written.ValueOrDie(), ciphertext.size());
+  absl::string_view ciphertext_view(ciphertext.data(), ciphertext.size());
+
+  // The output of EncryptInto() can be decrypted by Decrypt() ...
+  auto decrypted = cipher->Decrypt(ciphertext_view, aad);
+  ASSERT_THAT(decrypted.status(), IsOk());
+  EXPECT_EQ(decrypted.ValueOrDie(), message);
+
+  // ... and by DecryptInto(), also into a buffer larger than needed.
+  std::vector<char> plaintext(ciphertext.size());
+  written = cipher->DecryptInto(ciphertext_view, aad, absl::MakeSpan(plaintext));
+  ASSERT_THAT(written.status(), IsOk());
+  EXPECT_EQ(std::string(plaintext.data(), written.ValueOrDie()), message);
+
+  // The output of Encrypt() can be decrypted by DecryptInto().
+  auto encrypted = cipher->Encrypt(message, aad);
+  ASSERT_THAT(encrypted.status(), IsOk());
+  written = cipher->DecryptInto(encrypted.ValueOrDie(), aad,
+                                absl::MakeSpan(plaintext));
+  ASSERT_THAT(written.status(), IsOk());
+  EXPECT_EQ(std::string(plaintext.data(), written.ValueOrDie()), message);
+}
+
+TEST(AesEaxBoringSslTest, EncryptIntoDecryptIntoBufferTooSmall) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  auto cipher_result = AesEaxBoringSsl::New(key, 12);
+  ASSERT_THAT(cipher_result.status(), IsOk());
+  auto cipher = std::move(cipher_result.ValueOrDie());
+  std::string message = "Some data to encrypt.";
+  std::string aad = "Some data to authenticate.";
+
+  std::vector<char> ciphertext(message.size() + 28 - 1);
+  EXPECT_THAT(
+      cipher->EncryptInto(message, aad, absl::MakeSpan(ciphertext)).status(),
+      StatusIs(util::error::INVALID_ARGUMENT));
+
+  auto encrypted = cipher->Encrypt(message, aad);
+  ASSERT_THAT(encrypted.status(), IsOk());
+  std::vector<char> plaintext(message.size() - 1);
+  EXPECT_THAT(cipher
+                  ->DecryptInto(encrypted.ValueOrDie(), aad,
+                                absl::MakeSpan(plaintext))
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
 TEST(AesEaxBoringSslTest, TestMessageSize) {
   if (kUseOnlyFips) {
     GTEST_SKIP() << "Not supported in FIPS-only mode";
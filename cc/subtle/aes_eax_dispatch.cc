@@ -0,0 +1,80 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/aes_eax_dispatch.h"
+
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "tink/aead.h"
+#include "tink/subtle/aes_eax_aesni.h"
+#include "tink/subtle/aes_eax_armce.h"
+#include "tink/subtle/aes_eax_boringssl.h"
+#include "tink/subtle/cpu_features.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+AesEaxImplementation GetAesEaxImplementation() {
+#if defined(__SSE4_1__) && defined(__AES__)
+  if (HasCpuFeature(CpuFeature::kSse41) && HasCpuFeature(CpuFeature::kAesNi)) {
+    return AesEaxImplementation::kAesNi;
+  }
+#endif
+#if defined(__aarch64__) && \
+    (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+  if (HasCpuFeature(CpuFeature::kArmAes)) {
+    return AesEaxImplementation::kArmCe;
+  }
+#endif
+  return AesEaxImplementation::kBoringSsl;
+}
+
+absl::string_view AesEaxImplementationName(
+    AesEaxImplementation implementation) {
+  switch (implementation) {
+    case AesEaxImplementation::kBoringSsl:
+      return "BoringSSL";
+    case AesEaxImplementation::kAesNi:
+      return "AES-NI";
+    case AesEaxImplementation::kArmCe:
+      return "ARMv8 CE";
+  }
+  return "unknown";
+}
+
+crypto::tink::util::StatusOr<std::unique_ptr<Aead>> NewAesEax(
+    const util::SecretData& key, size_t nonce_size_in_bytes) {
+#if defined(__SSE4_1__) && defined(__AES__)
+  if (GetAesEaxImplementation() == AesEaxImplementation::kAesNi) {
+    return AesEaxAesni::New(key, nonce_size_in_bytes);
+  }
+#endif
+#if defined(__aarch64__) && \
+    (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+  if (GetAesEaxImplementation() == AesEaxImplementation::kArmCe) {
+    return AesEaxArmCe::New(key, nonce_size_in_bytes);
+  }
+#endif
+  return AesEaxBoringSsl::New(key, nonce_size_in_bytes);
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
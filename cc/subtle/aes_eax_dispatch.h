@@ -0,0 +1,56 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SUBTLE_AES_EAX_DISPATCH_H_
+#define TINK_SUBTLE_AES_EAX_DISPATCH_H_
+
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "tink/aead.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+enum class AesEaxImplementation {
+  kBoringSsl,  // AesEaxBoringSsl.
+  kAesNi,      // AesEaxAesni.
+  kArmCe,      // AesEaxArmCe.
+};
+
+// Returns the AES-EAX implementation NewAesEax() currently uses: AesEaxAesni
+// or AesEaxArmCe if it has been compiled in (with SSE4.1 and AES-NI, or the
+// ARMv8 crypto extension enabled) and the CPU supports the features it needs,
+// see HasCpuFeature(), and AesEaxBoringSsl otherwise.
+AesEaxImplementation GetAesEaxImplementation();
+
+// Returns a short name for 'implementation', e.g. "AES-NI".
+absl::string_view AesEaxImplementationName(
+    AesEaxImplementation implementation);
+
+// Returns an AES-EAX Aead using GetAesEaxImplementation(). All
+// implementations produce the same ciphertexts.
+crypto::tink::util::StatusOr<std::unique_ptr<Aead>> NewAesEax(
+    const util::SecretData& key, size_t nonce_size_in_bytes);
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_AES_EAX_DISPATCH_H_
@@ -0,0 +1,74 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/aes_eax_dispatch.h"
+
+#include <memory>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "tink/subtle/cpu_features.h"
+#include "tink/subtle/random.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+
+TEST(AesEaxDispatchTest, DisablingAesFeaturesSelectsBoringSsl) {
+  SetCpuFeatureDisabled(CpuFeature::kAesNi, true);
+  SetCpuFeatureDisabled(CpuFeature::kArmAes, true);
+  EXPECT_EQ(GetAesEaxImplementation(), AesEaxImplementation::kBoringSsl);
+  SetCpuFeatureDisabled(CpuFeature::kAesNi, false);
+  SetCpuFeatureDisabled(CpuFeature::kArmAes, false);
+#if defined(__SSE4_1__) && defined(__AES__)
+  EXPECT_EQ(GetAesEaxImplementation(), AesEaxImplementation::kAesNi);
+#elif defined(__aarch64__) && \
+    (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+  EXPECT_EQ(GetAesEaxImplementation(), AesEaxImplementation::kArmCe);
+#else
+  EXPECT_EQ(GetAesEaxImplementation(), AesEaxImplementation::kBoringSsl);
+#endif
+  EXPECT_EQ(AesEaxImplementationName(AesEaxImplementation::kAesNi), "AES-NI");
+}
+
+TEST(AesEaxDispatchTest, ImplementationsAreCompatible) {
+  util::SecretData key = Random::GetRandomKeyBytes(16);
+  auto active = NewAesEax(key, 12);
+  ASSERT_THAT(active.status(), IsOk());
+  SetCpuFeatureDisabled(CpuFeature::kAesNi, true);
+  SetCpuFeatureDisabled(CpuFeature::kArmAes, true);
+  auto fallback = NewAesEax(key, 12);
+  SetCpuFeatureDisabled(CpuFeature::kAesNi, false);
+  SetCpuFeatureDisabled(CpuFeature::kArmAes, false);
+  ASSERT_THAT(fallback.status(), IsOk());
+
+  auto ciphertext = active.ValueOrDie()->Encrypt("plaintext", "aad");
+  ASSERT_THAT(ciphertext.status(), IsOk());
+  auto plaintext =
+      fallback.ValueOrDie()->Decrypt(ciphertext.ValueOrDie(), "aad");
+  ASSERT_THAT(plaintext.status(), IsOk());
+  EXPECT_EQ(plaintext.ValueOrDie(), "plaintext");
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
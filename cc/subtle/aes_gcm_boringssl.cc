@@ -16,11 +16,21 @@
 
 #include "tink/subtle/aes_gcm_boringssl.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "openssl/aead.h"
+#include "openssl/cipher.h"
+#include "openssl/mem.h"
 #include "tink/config/tink_fips.h"
+#include "tink/subtle/aes_gcm_multi_buffer.h"
 #include "tink/subtle/random.h"
 #include "tink/subtle/subtle_util.h"
 #include "tink/subtle/subtle_util_boringssl.h"
@@ -32,6 +42,17 @@ namespace subtle {
 
 util::StatusOr<std::unique_ptr<Aead>> AesGcmBoringSsl::New(
     const util::SecretData& key) {
+  return Create(key, nullptr);
+}
+
+util::StatusOr<std::unique_ptr<Aead>> AesGcmBoringSsl::NewWithCounterNonces(
+    const util::SecretData& key) {
+  return Create(key, absl::make_unique<CounterNonceGenerator>());
+}
+
+util::StatusOr<std::unique_ptr<Aead>> AesGcmBoringSsl::Create(
+    const util::SecretData& key,
+    std::unique_ptr<CounterNonceGenerator> counter_nonces) {
   auto status = CheckFipsCompatibility<AesGcmBoringSsl>();
   if (!status.ok()) return status;
 
@@ -40,31 +61,78 @@ util::StatusOr<std::unique_ptr<Aead>> AesGcmBoringSsl::New(
   if (aead == nullptr) {
     return util::Status(util::error::INVALID_ARGUMENT, "invalid key size");
   }
-  bssl::UniquePtr<EVP_AEAD_CTX> ctx(EVP_AEAD_CTX_new(
-      aead, key.data(), key.size(), EVP_AEAD_DEFAULT_TAG_LENGTH));
-  if (!ctx) {
+  const EVP_CIPHER* cipher =
+      SubtleUtilBoringSSL::GetAesGcmCipherForKeySize(key.size());
+  if (cipher == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid key size");
+  }
+  // The context holds the key schedule, so it is placed with other key state.
+  util::SecretUniquePtr<EVP_AEAD_CTX> ctx =
+      util::MakeKeyStateUniquePtr<EVP_AEAD_CTX>();
+  EVP_AEAD_CTX_zero(ctx.get());
+  if (!EVP_AEAD_CTX_init(ctx.get(), aead, key.data(), key.size(),
+                         EVP_AEAD_DEFAULT_TAG_LENGTH, nullptr /* engine */)) {
     return util::Status(util::error::INTERNAL,
                         "could not initialize EVP_AEAD_CTX");
   }
-  return {absl::WrapUnique(new AesGcmBoringSsl(std::move(ctx)))};
+  std::unique_ptr<AesGcmMultiBuffer> multi_buffer;
+  if (!kUseOnlyFips) multi_buffer = AesGcmMultiBuffer::New(key);
+  return {absl::WrapUnique(new AesGcmBoringSsl(std::move(ctx), cipher, key,
+                                               std::move(counter_nonces),
+                                               std::move(multi_buffer)))};
+}
+
+AesGcmBoringSsl::~AesGcmBoringSsl() { EVP_AEAD_CTX_cleanup(ctx_.get()); }
+
+util::Status AesGcmBoringSsl::NewIv(absl::Span<char> iv) const {
+  if (counter_nonces_ != nullptr) return counter_nonces_->Next(iv);
+  Random::GetRandomNonceBytes(iv);
+  return util::OkStatus();
+}
+
+util::StatusOr<int64_t> AesGcmBoringSsl::CiphertextSize(
+    int64_t plaintext_size) const {
+  return kIvSizeInBytes + plaintext_size + kTagSizeInBytes;
 }
 
 util::StatusOr<std::string> AesGcmBoringSsl::Encrypt(
     absl::string_view plaintext, absl::string_view additional_data) const {
-  std::string result = Random::GetRandomBytes(kIvSizeInBytes);
+  std::string result;
   ResizeStringUninitialized(
       &result, kIvSizeInBytes + plaintext.size() + kTagSizeInBytes);
+  auto written = EncryptInto(plaintext, additional_data,
+                             absl::MakeSpan(&result[0], result.size()));
+  if (!written.ok()) return written.status();
+  return result;
+}
+
+util::StatusOr<int64_t> AesGcmBoringSsl::EncryptInto(
+    absl::string_view plaintext, absl::string_view additional_data,
+    absl::Span<char> ciphertext_buffer) const {
+  const size_t ciphertext_size =
+      kIvSizeInBytes + plaintext.size() + kTagSizeInBytes;
+  if (ciphertext_buffer.size() < ciphertext_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_buffer is too small");
+  }
+  // BoringSSL expects a non-null pointer for plaintext and additional_data,
+  // regardless of whether the size is 0.
+  plaintext = SubtleUtilBoringSSL::EnsureNonNull(plaintext);
+  additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
+
+  auto iv_status = NewIv(ciphertext_buffer.subspan(0, kIvSizeInBytes));
+  if (!iv_status.ok()) return iv_status;
+  uint8_t* out = reinterpret_cast<uint8_t*>(ciphertext_buffer.data());
   size_t len;
   if (EVP_AEAD_CTX_seal(
-          ctx_.get(), reinterpret_cast<uint8_t*>(&result[kIvSizeInBytes]), &len,
-          plaintext.size() + kTagSizeInBytes,
-          reinterpret_cast<const uint8_t*>(&result[0]), kIvSizeInBytes,
+          ctx_.get(), out + kIvSizeInBytes, &len,
+          plaintext.size() + kTagSizeInBytes, out, kIvSizeInBytes,
           reinterpret_cast<const uint8_t*>(plaintext.data()), plaintext.size(),
           reinterpret_cast<const uint8_t*>(additional_data.data()),
           additional_data.size()) != 1) {
     return util::Status(util::error::INTERNAL, "Encryption failed");
   }
-  return result;
+  return kIvSizeInBytes + len;
 }
 
 util::StatusOr<std::string> AesGcmBoringSsl::Decrypt(
@@ -76,10 +144,36 @@ util::StatusOr<std::string> AesGcmBoringSsl::Decrypt(
   std::string result;
   ResizeStringUninitialized(
       &result, ciphertext.size() - kIvSizeInBytes - kTagSizeInBytes);
+  auto written = DecryptInto(ciphertext, additional_data,
+                             absl::MakeSpan(&result[0], result.size()));
+  if (!written.ok()) return written.status();
+  return result;
+}
+
+util::StatusOr<int64_t> AesGcmBoringSsl::DecryptInto(
+    absl::string_view ciphertext, absl::string_view additional_data,
+    absl::Span<char> plaintext_buffer) const {
+  if (ciphertext.size() < kIvSizeInBytes + kTagSizeInBytes) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Ciphertext too short");
+  }
+  const size_t plaintext_size =
+      ciphertext.size() - kIvSizeInBytes - kTagSizeInBytes;
+  if (plaintext_buffer.size() < plaintext_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "plaintext_buffer is too small");
+  }
+  // BoringSSL expects a non-null pointer for additional_data,
+  // regardless of whether the size is 0.
+  additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
+
+  // The plaintext may be empty, in which case the buffer may be empty as well.
+  uint8_t empty_buffer;
+  uint8_t* out = plaintext_buffer.empty()
+                     ? &empty_buffer
+                     : reinterpret_cast<uint8_t*>(plaintext_buffer.data());
   size_t len;
   if (EVP_AEAD_CTX_open(
-          ctx_.get(), reinterpret_cast<uint8_t*>(&result[0]), &len,
-          result.size(),
+          ctx_.get(), out, &len, plaintext_size,
           // The nonce is the first |kIvSizeInBytes| bytes of |ciphertext|.
           reinterpret_cast<const uint8_t*>(ciphertext.data()), kIvSizeInBytes,
           // The input is the remainder.
@@ -87,9 +181,246 @@ util::StatusOr<std::string> AesGcmBoringSsl::Decrypt(
           ciphertext.size() - kIvSizeInBytes,
           reinterpret_cast<const uint8_t*>(additional_data.data()),
           additional_data.size()) != 1) {
-    return util::Status(util::error::INTERNAL, "Authentication failed");
+    static const util::Status* kAuthenticationFailed =
+        util::Status::NewStatic(util::error::INTERNAL, "Authentication failed");
+    return *kAuthenticationFailed;
   }
-  return result;
+  return len;
+}
+
+util::StatusOr<int64_t> AesGcmBoringSsl::EncryptGatherInto(
+    absl::Span<const absl::string_view> plaintext_parts,
+    absl::string_view additional_data,
+    absl::Span<char> ciphertext_buffer) const {
+  if (plaintext_parts.size() == 1) {
+    return EncryptInto(plaintext_parts[0], additional_data, ciphertext_buffer);
+  }
+  size_t plaintext_size = 0;
+  for (absl::string_view part : plaintext_parts) {
+    plaintext_size += part.size();
+  }
+  const size_t ciphertext_size =
+      kIvSizeInBytes + plaintext_size + kTagSizeInBytes;
+  if (ciphertext_buffer.size() < ciphertext_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_buffer is too small");
+  }
+
+  auto iv_status = NewIv(ciphertext_buffer.subspan(0, kIvSizeInBytes));
+  if (!iv_status.ok()) return iv_status;
+  uint8_t* out = reinterpret_cast<uint8_t*>(ciphertext_buffer.data());
+  bssl::UniquePtr<EVP_CIPHER_CTX> ctx(EVP_CIPHER_CTX_new());
+  if (!EVP_EncryptInit_ex(ctx.get(), cipher_, nullptr,
+                          reinterpret_cast<const uint8_t*>(key_.data()),
+                          out)) {
+    return util::Status(util::error::INTERNAL, "Encryption init failed");
+  }
+  int len = 0;
+  if (!additional_data.empty() &&
+      !EVP_EncryptUpdate(
+          ctx.get(), nullptr, &len,
+          reinterpret_cast<const uint8_t*>(additional_data.data()),
+          additional_data.size())) {
+    return util::Status(util::error::INTERNAL, "Encryption failed");
+  }
+  size_t written = kIvSizeInBytes;
+  for (absl::string_view part : plaintext_parts) {
+    if (part.empty()) continue;
+    if (!EVP_EncryptUpdate(ctx.get(), out + written, &len,
+                           reinterpret_cast<const uint8_t*>(part.data()),
+                           part.size())) {
+      return util::Status(util::error::INTERNAL, "Encryption failed");
+    }
+    written += len;
+  }
+  if (!EVP_EncryptFinal_ex(ctx.get(), out + written, &len)) {
+    return util::Status(util::error::INTERNAL, "Encryption failed");
+  }
+  written += len;
+  if (written != kIvSizeInBytes + plaintext_size ||
+      !EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_GET_TAG, kTagSizeInBytes,
+                           out + written)) {
+    return util::Status(util::error::INTERNAL, "Encryption failed");
+  }
+  return ciphertext_size;
+}
+
+util::StatusOr<int64_t> AesGcmBoringSsl::DecryptScatterInto(
+    absl::string_view ciphertext, absl::string_view additional_data,
+    absl::Span<const absl::Span<char>> plaintext_buffers) const {
+  if (plaintext_buffers.size() == 1) {
+    return DecryptInto(ciphertext, additional_data, plaintext_buffers[0]);
+  }
+  if (ciphertext.size() < kIvSizeInBytes + kTagSizeInBytes) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Ciphertext too short");
+  }
+  const size_t plaintext_size =
+      ciphertext.size() - kIvSizeInBytes - kTagSizeInBytes;
+  size_t capacity = 0;
+  for (absl::Span<char> buffer : plaintext_buffers) {
+    capacity += buffer.size();
+  }
+  if (capacity < plaintext_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "plaintext_buffers are too small");
+  }
+
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(ciphertext.data());
+  bssl::UniquePtr<EVP_CIPHER_CTX> ctx(EVP_CIPHER_CTX_new());
+  if (!EVP_DecryptInit_ex(ctx.get(), cipher_, nullptr,
+                          reinterpret_cast<const uint8_t*>(key_.data()), in)) {
+    return util::Status(util::error::INTERNAL, "Decryption init failed");
+  }
+  int len = 0;
+  if (!additional_data.empty() &&
+      !EVP_DecryptUpdate(
+          ctx.get(), nullptr, &len,
+          reinterpret_cast<const uint8_t*>(additional_data.data()),
+          additional_data.size())) {
+    return util::Status(util::error::INTERNAL, "Decryption failed");
+  }
+
+  // Decrypts the ciphertext into the buffers, remembering how far they have
+  // been filled so that they can be cleared if the authentication fails.
+  size_t read = kIvSizeInBytes;
+  size_t buffers_used = 0;
+  bool ok = true;
+  for (; ok && read < kIvSizeInBytes + plaintext_size; buffers_used++) {
+    absl::Span<char> buffer = plaintext_buffers[buffers_used];
+    size_t count =
+        std::min(buffer.size(), kIvSizeInBytes + plaintext_size - read);
+    if (count == 0) continue;
+    ok = EVP_DecryptUpdate(ctx.get(), reinterpret_cast<uint8_t*>(buffer.data()),
+                           &len, in + read, count) &&
+         len == static_cast<int>(count);
+    read += count;
+  }
+  uint8_t tag[kTagSizeInBytes];
+  std::memcpy(tag, in + ciphertext.size() - kTagSizeInBytes, kTagSizeInBytes);
+  if (ok && EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_TAG,
+                                kTagSizeInBytes, tag) &&
+      EVP_DecryptFinal_ex(ctx.get(), nullptr, &len)) {
+    return plaintext_size;
+  }
+  // Do not release unauthenticated plaintext.
+  for (size_t i = 0; i < buffers_used; i++) {
+    if (!plaintext_buffers[i].empty()) {
+      std::memset(plaintext_buffers[i].data(), 0, plaintext_buffers[i].size());
+    }
+  }
+  static const util::Status* kAuthenticationFailed =
+      util::Status::NewStatic(util::error::INTERNAL, "Authentication failed");
+  return *kAuthenticationFailed;
+}
+
+util::StatusOr<absl::Span<char>> AesGcmBoringSsl::DecryptInPlace(
+    absl::Span<char> ciphertext, absl::string_view additional_data) const {
+  if (ciphertext.size() < kIvSizeInBytes + kTagSizeInBytes) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Ciphertext too short");
+  }
+  // BoringSSL expects a non-null pointer for additional_data,
+  // regardless of whether the size is 0.
+  additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
+
+  // EVP_AEAD_CTX_open() allows the output to alias the input exactly, so the
+  // plaintext is written over the encrypted part of the ciphertext.
+  uint8_t* in = reinterpret_cast<uint8_t*>(ciphertext.data());
+  size_t len;
+  if (EVP_AEAD_CTX_open(
+          ctx_.get(), in + kIvSizeInBytes, &len,
+          ciphertext.size() - kIvSizeInBytes - kTagSizeInBytes, in,
+          kIvSizeInBytes, in + kIvSizeInBytes,
+          ciphertext.size() - kIvSizeInBytes,
+          reinterpret_cast<const uint8_t*>(additional_data.data()),
+          additional_data.size()) != 1) {
+    static const util::Status* kAuthenticationFailed =
+        util::Status::NewStatic(util::error::INTERNAL, "Authentication failed");
+    return *kAuthenticationFailed;
+  }
+  return ciphertext.subspan(kIvSizeInBytes, len);
+}
+
+bool AesGcmBoringSsl::UseMultiBuffer(
+    absl::Span<const absl::string_view> records) const {
+  if (multi_buffer_ == nullptr || records.size() < 2) return false;
+  for (absl::string_view record : records) {
+    if (record.size() > kMaxMultiBufferRecordSize) return false;
+  }
+  return true;
+}
+
+util::Status AesGcmBoringSsl::EncryptBatch(
+    absl::Span<const absl::string_view> plaintexts,
+    absl::Span<const absl::string_view> associated_data,
+    std::string* ciphertexts, std::vector<int64_t>* offsets) const {
+  if (plaintexts.size() != associated_data.size() ||
+      !UseMultiBuffer(plaintexts)) {
+    return Aead::EncryptBatch(plaintexts, associated_data, ciphertexts,
+                              offsets);
+  }
+  offsets->assign(1, 0);
+  offsets->reserve(plaintexts.size() + 1);
+  for (absl::string_view plaintext : plaintexts) {
+    offsets->push_back(offsets->back() + kIvSizeInBytes + plaintext.size() +
+                       kTagSizeInBytes);
+  }
+  ciphertexts->clear();
+  ResizeStringUninitialized(ciphertexts, offsets->back());
+  std::vector<uint8_t*> outs(plaintexts.size());
+  for (size_t i = 0; i < plaintexts.size(); i++) {
+    char* out = &(*ciphertexts)[(*offsets)[i]];
+    auto iv_status = NewIv(absl::MakeSpan(out, kIvSizeInBytes));
+    if (!iv_status.ok()) {
+      ciphertexts->clear();
+      offsets->assign(1, 0);
+      return iv_status;
+    }
+    outs[i] = reinterpret_cast<uint8_t*>(out);
+  }
+  multi_buffer_->Seal(plaintexts, associated_data, outs);
+  return util::OkStatus();
+}
+
+util::Status AesGcmBoringSsl::DecryptBatch(
+    absl::Span<const absl::string_view> ciphertexts,
+    absl::Span<const absl::string_view> associated_data,
+    std::string* plaintexts, std::vector<int64_t>* offsets) const {
+  if (ciphertexts.size() != associated_data.size() ||
+      !UseMultiBuffer(ciphertexts)) {
+    return Aead::DecryptBatch(ciphertexts, associated_data, plaintexts,
+                              offsets);
+  }
+  plaintexts->clear();
+  offsets->assign(1, 0);
+  for (absl::string_view ciphertext : ciphertexts) {
+    if (ciphertext.size() < kIvSizeInBytes + kTagSizeInBytes) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "Ciphertext too short");
+    }
+  }
+  offsets->reserve(ciphertexts.size() + 1);
+  for (absl::string_view ciphertext : ciphertexts) {
+    offsets->push_back(offsets->back() + ciphertext.size() - kIvSizeInBytes -
+                       kTagSizeInBytes);
+  }
+  // Keeps a valid pointer for empty plaintexts.
+  ResizeStringUninitialized(plaintexts, offsets->back() + 1);
+  std::vector<uint8_t*> outs(ciphertexts.size());
+  for (size_t i = 0; i < ciphertexts.size(); i++) {
+    outs[i] = reinterpret_cast<uint8_t*>(&(*plaintexts)[(*offsets)[i]]);
+  }
+  bool authentic = multi_buffer_->Open(ciphertexts, associated_data, outs);
+  plaintexts->resize(offsets->back());
+  if (!authentic) {
+    // Do not release unauthenticated plaintext.
+    OPENSSL_cleanse(&(*plaintexts)[0], plaintexts->size());
+    plaintexts->clear();
+    offsets->assign(1, 0);
+    static const util::Status* kAuthenticationFailed =
+        util::Status::NewStatic(util::error::INTERNAL, "Authentication failed");
+    return *kAuthenticationFailed;
+  }
+  return util::OkStatus();
 }
 
 }  // namespace subtle
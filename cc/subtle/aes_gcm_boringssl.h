@@ -17,21 +17,31 @@
 #ifndef TINK_SUBTLE_AES_GCM_BORINGSSL_H_
 #define TINK_SUBTLE_AES_GCM_BORINGSSL_H_
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/base/macros.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "openssl/aead.h"
+#include "openssl/cipher.h"
 #include "tink/aead.h"
 #include "tink/config/tink_fips.h"
+#include "tink/subtle/aes_gcm_multi_buffer.h"
+#include "tink/subtle/counter_nonce_generator.h"
 #include "tink/util/secret_data.h"
+#include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
 namespace crypto {
 namespace tink {
 namespace subtle {
 
-class AesGcmBoringSsl : public Aead {
+// Final, so that calls through an AesGcmBoringSsl pointer are not virtual.
+class AesGcmBoringSsl final : public Aead {
  public:
   ABSL_DEPRECATED("Use AesGcmBoringSsl::New(const util::SecretData&) instead.")
   static crypto::tink::util::StatusOr<std::unique_ptr<Aead>> New(
@@ -41,6 +51,16 @@ class AesGcmBoringSsl : public Aead {
   static crypto::tink::util::StatusOr<std::unique_ptr<Aead>> New(
       const util::SecretData& key);
 
+  // Returns an AES-GCM primitive which derives the nonces from a counter
+  // instead of the random number generator (see CounterNonceGenerator).
+  // The ciphertexts have the same format as those of New(). Encryption fails
+  // with RESOURCE_EXHAUSTED once the nonces of the primitive are used up,
+  // which is after 2^48 encryptions at the earliest.
+  static crypto::tink::util::StatusOr<std::unique_ptr<Aead>>
+  NewWithCounterNonces(const util::SecretData& key);
+
+  ~AesGcmBoringSsl() override;
+
   crypto::tink::util::StatusOr<std::string> Encrypt(
       absl::string_view plaintext,
       absl::string_view additional_data) const override;
@@ -49,17 +69,88 @@ class AesGcmBoringSsl : public Aead {
       absl::string_view ciphertext,
       absl::string_view additional_data) const override;
 
+  crypto::tink::util::StatusOr<int64_t> CiphertextSize(
+      int64_t plaintext_size) const override;
+
+  crypto::tink::util::StatusOr<int64_t> EncryptInto(
+      absl::string_view plaintext, absl::string_view additional_data,
+      absl::Span<char> ciphertext_buffer) const override;
+
+  crypto::tink::util::StatusOr<int64_t> DecryptInto(
+      absl::string_view ciphertext, absl::string_view additional_data,
+      absl::Span<char> plaintext_buffer) const override;
+
+  // Encrypts the parts one by one, without concatenating them.
+  crypto::tink::util::StatusOr<int64_t> EncryptGatherInto(
+      absl::Span<const absl::string_view> plaintext_parts,
+      absl::string_view additional_data,
+      absl::Span<char> ciphertext_buffer) const override;
+
+  // Decrypts directly into the buffers. If the authentication fails, the
+  // buffers are zeroed.
+  crypto::tink::util::StatusOr<int64_t> DecryptScatterInto(
+      absl::string_view ciphertext, absl::string_view additional_data,
+      absl::Span<const absl::Span<char>> plaintext_buffers) const override;
+
+  // The returned plaintext starts right after the IV in 'ciphertext'.
+  crypto::tink::util::StatusOr<absl::Span<char>> DecryptInPlace(
+      absl::Span<char> ciphertext,
+      absl::string_view additional_data) const override;
+
+  // Batches of small records are encrypted and decrypted together with
+  // AesGcmMultiBuffer, if it is available and Tink is not restricted to
+  // FIPS-validated implementations.
+  crypto::tink::util::Status EncryptBatch(
+      absl::Span<const absl::string_view> plaintexts,
+      absl::Span<const absl::string_view> associated_data,
+      std::string* ciphertexts, std::vector<int64_t>* offsets) const override;
+
+  crypto::tink::util::Status DecryptBatch(
+      absl::Span<const absl::string_view> ciphertexts,
+      absl::Span<const absl::string_view> associated_data,
+      std::string* plaintexts, std::vector<int64_t>* offsets) const override;
+
   static constexpr crypto::tink::FipsCompatibility kFipsStatus =
       crypto::tink::FipsCompatibility::kRequiresBoringCrypto;
 
  private:
   static constexpr int kIvSizeInBytes = 12;
   static constexpr int kTagSizeInBytes = 16;
+  // Larger records fill the pipeline of BoringSSL's stitched AES-GCM on
+  // their own, so batches with larger records are processed one record at a
+  // time.
+  static constexpr size_t kMaxMultiBufferRecordSize = 256;
+
+  AesGcmBoringSsl(util::SecretUniquePtr<EVP_AEAD_CTX> ctx,
+                  const EVP_CIPHER* cipher, const util::SecretData& key,
+                  std::unique_ptr<CounterNonceGenerator> counter_nonces,
+                  std::unique_ptr<AesGcmMultiBuffer> multi_buffer)
+      : ctx_(std::move(ctx)),
+        cipher_(cipher),
+        key_(key),
+        counter_nonces_(std::move(counter_nonces)),
+        multi_buffer_(std::move(multi_buffer)) {}
+
+  static crypto::tink::util::StatusOr<std::unique_ptr<Aead>> Create(
+      const util::SecretData& key,
+      std::unique_ptr<CounterNonceGenerator> counter_nonces);
+
+  // Writes a fresh nonce to 'iv'.
+  crypto::tink::util::Status NewIv(absl::Span<char> iv) const;
 
-  explicit AesGcmBoringSsl(bssl::UniquePtr<EVP_AEAD_CTX> ctx)
-      : ctx_(std::move(ctx)) {}
+  // Returns true if the batch of 'records' should be processed with
+  // multi_buffer_.
+  bool UseMultiBuffer(absl::Span<const absl::string_view> records) const;
 
-  bssl::UniquePtr<EVP_AEAD_CTX> ctx_;
+  const util::SecretUniquePtr<EVP_AEAD_CTX> ctx_;
+  // EVP_AEAD has no incremental interface, so EncryptGatherInto() and
+  // DecryptScatterInto() use the EVP_CIPHER interface with these instead.
+  const EVP_CIPHER* cipher_;
+  const util::SecretData key_;
+  // If null, the nonces are random.
+  const std::unique_ptr<CounterNonceGenerator> counter_nonces_;
+  // Null if not available.
+  const std::unique_ptr<AesGcmMultiBuffer> multi_buffer_;
 };
 
 }  // namespace subtle
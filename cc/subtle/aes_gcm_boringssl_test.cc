@@ -22,6 +22,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "openssl/err.h"
 #include "include/rapidjson/document.h"
 #include "tink/config/tink_fips.h"
@@ -62,6 +63,314 @@ TEST(AesGcmBoringSslTest, testBasic) {
   EXPECT_EQ(pt.ValueOrDie(), message);
 }
 
+TEST(AesGcmBoringSslTest, EncryptIntoDecryptInto) {
+  if (kUseOnlyFips && !FIPS_mode()) {
+    GTEST_SKIP()
+        << "Test should not run in FIPS mode when BoringCrypto is unavailable.";
+  }
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  auto cipher_result = AesGcmBoringSsl::New(key);
+  ASSERT_THAT(cipher_result.status(), IsOk());
+  auto cipher = std::move(cipher_result.ValueOrDie());
+  std::string message = "Some data to encrypt.";
+  std::string aad = "Some data to authenticate.";
+
+  auto ciphertext_size = cipher->CiphertextSize(message.size());
+  ASSERT_THAT(ciphertext_size.status(), IsOk());
+  EXPECT_EQ(ciphertext_size.ValueOrDie(), message.size() + 28);
+
+  std::vector<char> ciphertext(ciphertext_size.ValueOrDie());
+  auto written =
+      cipher->EncryptInto(message, aad, absl::MakeSpan(ciphertext));
+  ASSERT_THAT(written.status(), IsOk());
+  EXPECT_EQ(written.ValueOrDie(), ciphertext.size());
+  absl::string_view ciphertext_view(ciphertext.data(), ciphertext.size());
+
+  // The output of EncryptInto() can be decrypted by Decrypt() ...
+  auto decrypted = cipher->Decrypt(ciphertext_view, aad);
+  ASSERT_THAT(decrypted.status(), IsOk());
+  EXPECT_EQ(decrypted.ValueOrDie(), message);
+
+  // ... and by DecryptInto(), also into a buffer larger than needed.
+  std::vector<char> plaintext(ciphertext.size());
+  written = cipher->DecryptInto(ciphertext_view, aad, absl::MakeSpan(plaintext));
+  ASSERT_THAT(written.status(), IsOk());
+  EXPECT_EQ(std::string(plaintext.data(), written.ValueOrDie()), message);
+
+  // The output of Encrypt() can be decrypted by DecryptInto().
+  auto encrypted = cipher->Encrypt(message, aad);
+  ASSERT_THAT(encrypted.status(), IsOk());
+  written = cipher->DecryptInto(encrypted.ValueOrDie(), aad,
+                                absl::MakeSpan(plaintext));
+  ASSERT_THAT(written.status(), IsOk());
+  EXPECT_EQ(std::string(plaintext.data(), written.ValueOrDie()), message);
+}
+
+TEST(AesGcmBoringSslTest, EncryptIntoDecryptIntoBufferTooSmall) {
+  if (kUseOnlyFips && !FIPS_mode()) {
+    GTEST_SKIP()
+        << "Test should not run in FIPS mode when BoringCrypto is unavailable.";
+  }
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  auto cipher_result = AesGcmBoringSsl::New(key);
+  ASSERT_THAT(cipher_result.status(), IsOk());
+  auto cipher = std::move(cipher_result.ValueOrDie());
+  std::string message = "Some data to encrypt.";
+  std::string aad = "Some data to authenticate.";
+
+  std::vector<char> ciphertext(message.size() + 28 - 1);
+  EXPECT_THAT(
+      cipher->EncryptInto(message, aad, absl::MakeSpan(ciphertext)).status(),
+      StatusIs(util::error::INVALID_ARGUMENT));
+
+  auto encrypted = cipher->Encrypt(message, aad);
+  ASSERT_THAT(encrypted.status(), IsOk());
+  std::vector<char> plaintext(message.size() - 1);
+  EXPECT_THAT(cipher
+                  ->DecryptInto(encrypted.ValueOrDie(), aad,
+                                absl::MakeSpan(plaintext))
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(AesGcmBoringSslTest, EncryptGatherIntoDecryptScatterInto) {
+  if (kUseOnlyFips && !FIPS_mode()) {
+    GTEST_SKIP()
+        << "Test should not run in FIPS mode when BoringCrypto is unavailable.";
+  }
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  auto cipher_result = AesGcmBoringSsl::New(key);
+  ASSERT_THAT(cipher_result.status(), IsOk());
+  auto cipher = std::move(cipher_result.ValueOrDie());
+  std::string aad = "Some data to authenticate.";
+  std::string message = "A header, followed by a body in several fragments.";
+  std::vector<absl::string_view> parts = {
+      absl::string_view(message).substr(0, 9), absl::string_view(),
+      absl::string_view(message).substr(9, 20),
+      absl::string_view(message).substr(29)};
+
+  std::vector<char> ciphertext(message.size() + 28);
+  auto written =
+      cipher->EncryptGatherInto(parts, aad, absl::MakeSpan(ciphertext));
+  ASSERT_THAT(written.status(), IsOk());
+  EXPECT_EQ(written.ValueOrDie(), ciphertext.size());
+  absl::string_view ciphertext_view(ciphertext.data(), ciphertext.size());
+
+  // The ciphertext is an ordinary ciphertext of the concatenated parts.
+  auto decrypted = cipher->Decrypt(ciphertext_view, aad);
+  ASSERT_THAT(decrypted.status(), IsOk());
+  EXPECT_EQ(decrypted.ValueOrDie(), message);
+
+  // Ordinary ciphertexts can be decrypted into several buffers, which need
+  // not have the same boundaries as the parts used for encryption.
+  auto encrypted = cipher->Encrypt(message, aad);
+  ASSERT_THAT(encrypted.status(), IsOk());
+  std::vector<char> plaintext(message.size() + 10);
+  std::vector<absl::Span<char>> buffers = {
+      absl::MakeSpan(plaintext).subspan(0, 5),
+      absl::MakeSpan(plaintext).subspan(5, 0),
+      absl::MakeSpan(plaintext).subspan(5, 30),
+      absl::MakeSpan(plaintext).subspan(35)};
+  written = cipher->DecryptScatterInto(encrypted.ValueOrDie(), aad, buffers);
+  ASSERT_THAT(written.status(), IsOk());
+  EXPECT_EQ(std::string(plaintext.data(), written.ValueOrDie()), message);
+
+  // Buffers which are too small are rejected.
+  buffers.pop_back();
+  EXPECT_THAT(
+      cipher->DecryptScatterInto(encrypted.ValueOrDie(), aad, buffers)
+          .status(),
+      StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(cipher
+                  ->EncryptGatherInto(parts, aad,
+                                      absl::MakeSpan(ciphertext).subspan(1))
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(AesGcmBoringSslTest, DecryptScatterIntoModified) {
+  if (kUseOnlyFips && !FIPS_mode()) {
+    GTEST_SKIP()
+        << "Test should not run in FIPS mode when BoringCrypto is unavailable.";
+  }
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  auto cipher_result = AesGcmBoringSsl::New(key);
+  ASSERT_THAT(cipher_result.status(), IsOk());
+  auto cipher = std::move(cipher_result.ValueOrDie());
+  std::string message = "Some data to encrypt.";
+  std::string aad = "Some data to authenticate.";
+  auto encrypted = cipher->Encrypt(message, aad);
+  ASSERT_THAT(encrypted.status(), IsOk());
+
+  std::string modified = encrypted.ValueOrDie();
+  modified[15] ^= 1;
+  std::vector<char> plaintext(message.size(), 'x');
+  std::vector<absl::Span<char>> buffers = {
+      absl::MakeSpan(plaintext).subspan(0, 10),
+      absl::MakeSpan(plaintext).subspan(10)};
+  EXPECT_THAT(cipher->DecryptScatterInto(modified, aad, buffers).status(),
+              StatusIs(util::error::INTERNAL));
+  // No unauthenticated plaintext is left in the buffers.
+  EXPECT_EQ(std::string(plaintext.data(), plaintext.size()),
+            std::string(message.size(), '\0'));
+  EXPECT_THAT(
+      cipher->DecryptScatterInto(encrypted.ValueOrDie(), "other aad", buffers)
+          .status(),
+      StatusIs(util::error::INTERNAL));
+}
+
+TEST(AesGcmBoringSslTest, DecryptInPlace) {
+  if (kUseOnlyFips && !FIPS_mode()) {
+    GTEST_SKIP()
+        << "Test should not run in FIPS mode when BoringCrypto is unavailable.";
+  }
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  auto cipher_result = AesGcmBoringSsl::New(key);
+  ASSERT_THAT(cipher_result.status(), IsOk());
+  auto cipher = std::move(cipher_result.ValueOrDie());
+  std::string message = "Some data to encrypt.";
+  std::string aad = "Some data to authenticate.";
+  auto encrypted = cipher->Encrypt(message, aad);
+  ASSERT_THAT(encrypted.status(), IsOk());
+
+  std::string buffer = encrypted.ValueOrDie();
+  auto decrypted =
+      cipher->DecryptInPlace(absl::MakeSpan(&buffer[0], buffer.size()), aad);
+  ASSERT_THAT(decrypted.status(), IsOk());
+  // The plaintext is in the ciphertext buffer, right after the nonce.
+  EXPECT_EQ(decrypted.ValueOrDie().data(), &buffer[12]);
+  EXPECT_EQ(std::string(decrypted.ValueOrDie().data(),
+                        decrypted.ValueOrDie().size()),
+            message);
+
+  buffer = encrypted.ValueOrDie();
+  EXPECT_THAT(cipher
+                  ->DecryptInPlace(absl::MakeSpan(&buffer[0], buffer.size()),
+                                   "other aad")
+                  .status(),
+              StatusIs(util::error::INTERNAL));
+  buffer = encrypted.ValueOrDie().substr(0, 12 + 15);
+  EXPECT_THAT(cipher
+                  ->DecryptInPlace(absl::MakeSpan(&buffer[0], buffer.size()),
+                                   aad)
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(AesGcmBoringSslTest, CounterNonces) {
+  if (kUseOnlyFips && !FIPS_mode()) {
+    GTEST_SKIP()
+        << "Test should not run in FIPS mode when BoringCrypto is unavailable.";
+  }
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  auto cipher_result = AesGcmBoringSsl::NewWithCounterNonces(key);
+  ASSERT_THAT(cipher_result.status(), IsOk());
+  auto cipher = std::move(cipher_result.ValueOrDie());
+  auto random_cipher_result = AesGcmBoringSsl::New(key);
+  ASSERT_THAT(random_cipher_result.status(), IsOk());
+  auto random_cipher = std::move(random_cipher_result.ValueOrDie());
+  std::string message = "Some data to encrypt.";
+  std::string aad = "Some data to authenticate.";
+
+  auto encrypted1 = cipher->Encrypt(message, aad);
+  ASSERT_THAT(encrypted1.status(), IsOk());
+  std::vector<char> buffer(message.size() + 28);
+  auto written = cipher->EncryptGatherInto({"Some data ", "to encrypt."}, aad,
+                                           absl::MakeSpan(buffer));
+  ASSERT_THAT(written.status(), IsOk());
+  std::string encrypted2(buffer.data(), written.ValueOrDie());
+
+  // The nonces share the fixed field, and the counter goes up.
+  EXPECT_EQ(encrypted1.ValueOrDie().substr(0, 8), encrypted2.substr(0, 8));
+  EXPECT_EQ(encrypted1.ValueOrDie().substr(8, 4), std::string(4, '\0'));
+  EXPECT_EQ(encrypted2.substr(8, 4), std::string("\0\0\0\1", 4));
+
+  // The ciphertexts have the usual format.
+  for (const std::string& encrypted : {encrypted1.ValueOrDie(), encrypted2}) {
+    auto decrypted = random_cipher->Decrypt(encrypted, aad);
+    ASSERT_THAT(decrypted.status(), IsOk());
+    EXPECT_EQ(decrypted.ValueOrDie(), message);
+  }
+}
+
+TEST(AesGcmBoringSslTest, EncryptBatchDecryptBatch) {
+  if (kUseOnlyFips && !FIPS_mode()) {
+    GTEST_SKIP()
+        << "Test should not run in FIPS mode when BoringCrypto is unavailable.";
+  }
+  for (const std::string& hex_key :
+       {std::string("000102030405060708090a0b0c0d0e0f"),
+        std::string("000102030405060708090a0b0c0d0e0f"
+                    "101112131415161718191a1b1c1d1e1f")}) {
+    util::SecretData key =
+        util::SecretDataFromStringView(test::HexDecodeOrDie(hex_key));
+    auto cipher_result = AesGcmBoringSsl::New(key);
+    ASSERT_THAT(cipher_result.status(), IsOk());
+    auto cipher = std::move(cipher_result.ValueOrDie());
+
+    // Small records, and a batch with a record too large for the
+    // multi-buffer implementation.
+    std::vector<std::string> messages;
+    std::vector<std::string> aads;
+    for (int i = 0; i < 40; i++) {
+      messages.push_back(std::string(i, 'a' + i % 26));
+      aads.push_back(absl::StrCat("aad ", i));
+    }
+    std::vector<std::vector<std::string>> batches = {
+        messages, {"small", std::string(10000, 'x')}};
+    for (const std::vector<std::string>& batch : batches) {
+      std::vector<absl::string_view> plaintexts(batch.begin(), batch.end());
+      std::vector<absl::string_view> associated_data(
+          aads.begin(), aads.begin() + batch.size());
+      std::string ciphertexts;
+      std::vector<int64_t> offsets;
+      ASSERT_THAT(cipher->EncryptBatch(plaintexts, associated_data,
+                                       &ciphertexts, &offsets),
+                  IsOk());
+      ASSERT_EQ(offsets.size(), batch.size() + 1);
+      std::vector<absl::string_view> ciphertext_views;
+      for (size_t i = 0; i < batch.size(); i++) {
+        ciphertext_views.push_back(absl::string_view(ciphertexts).substr(
+            offsets[i], offsets[i + 1] - offsets[i]));
+        auto decrypted =
+            cipher->Decrypt(ciphertext_views[i], associated_data[i]);
+        ASSERT_THAT(decrypted.status(), IsOk());
+        EXPECT_EQ(decrypted.ValueOrDie(), batch[i]);
+      }
+
+      std::string decrypted;
+      std::vector<int64_t> decrypted_offsets;
+      ASSERT_THAT(cipher->DecryptBatch(ciphertext_views, associated_data,
+                                       &decrypted, &decrypted_offsets),
+                  IsOk());
+      ASSERT_EQ(decrypted_offsets.size(), batch.size() + 1);
+      for (size_t i = 0; i < batch.size(); i++) {
+        EXPECT_EQ(decrypted.substr(decrypted_offsets[i],
+                                   decrypted_offsets[i + 1] -
+                                       decrypted_offsets[i]),
+                  batch[i]);
+      }
+
+      std::string modified(ciphertext_views[1]);
+      modified.back() ^= 1;
+      ciphertext_views[1] = modified;
+      EXPECT_THAT(cipher->DecryptBatch(ciphertext_views, associated_data,
+                                       &decrypted, &decrypted_offsets),
+                  StatusIs(util::error::INTERNAL));
+      ciphertext_views[1] = "too short";
+      EXPECT_THAT(cipher->DecryptBatch(ciphertext_views, associated_data,
+                                       &decrypted, &decrypted_offsets),
+                  StatusIs(util::error::INVALID_ARGUMENT));
+    }
+  }
+}
+
 TEST(AesGcmBoringSslTest, testModification) {
   if (kUseOnlyFips && !FIPS_mode()) {
     GTEST_SKIP()
@@ -93,7 +93,8 @@ AesGcmHkdfStreamSegmentDecrypter::AesGcmHkdfStreamSegmentDecrypter(
       ciphertext_segment_size_(params.ciphertext_segment_size),
       associated_data_(std::move(params.associated_data)),
       header_size_(1 + derived_key_size_ +
-                   AesGcmHkdfStreamSegmentEncrypter::kNoncePrefixSizeInBytes) {}
+                   AesGcmHkdfStreamSegmentEncrypter::kNoncePrefixSizeInBytes),
+      key_cache_(std::move(params.key_cache)) {}
 
 // static
 util::StatusOr<std::unique_ptr<StreamSegmentDecrypter>>
@@ -129,12 +130,19 @@ util::Status AesGcmHkdfStreamSegmentDecrypter::Init(
                    AesGcmHkdfStreamSegmentEncrypter::kNoncePrefixSizeInBytes),
                nonce_prefix_.begin());
 
+  absl::string_view salt(reinterpret_cast<const char*>(salt_.data()),
+                         derived_key_size_);
+  if (key_cache_ != nullptr) {
+    ctx_ = key_cache_->Get(salt, associated_data_);
+    if (ctx_ != nullptr) {
+      is_initialized_ = true;
+      return util::OkStatus();
+    }
+  }
+
   // Derive symmetric key.
-  auto hkdf_result = Hkdf::ComputeHkdf(
-      hkdf_hash_, ikm_,
-      absl::string_view(reinterpret_cast<const char*>(salt_.data()),
-                        derived_key_size_),
-      associated_data_, derived_key_size_);
+  auto hkdf_result = Hkdf::ComputeHkdf(hkdf_hash_, ikm_, salt,
+                                       associated_data_, derived_key_size_);
   if (!hkdf_result.ok()) return hkdf_result.status();
   util::SecretData key = std::move(hkdf_result).ValueOrDie();
 
@@ -144,13 +152,15 @@ util::Status AesGcmHkdfStreamSegmentDecrypter::Init(
   if (aead == nullptr) {
     return util::Status(util::error::INTERNAL, "invalid key size");
   }
-  ctx_.reset(
+  bssl::UniquePtr<EVP_AEAD_CTX> ctx(
       EVP_AEAD_CTX_new(aead, key.data(), key.size(),
                        AesGcmHkdfStreamSegmentEncrypter::kTagSizeInBytes));
-  if (!ctx_) {
+  if (!ctx) {
     return util::Status(util::error::INTERNAL,
                         "could not initialize EVP_AEAD_CTX");
   }
+  ctx_ = std::move(ctx);
+  if (key_cache_ != nullptr) key_cache_->Put(salt, associated_data_, ctx_);
   is_initialized_ = true;
   return util::OkStatus();
 }
@@ -179,16 +189,40 @@ util::Status AesGcmHkdfStreamSegmentDecrypter::DecryptSegment(
     return util::Status(util::error::INVALID_ARGUMENT,
                         "plaintext_buffer must be non-null");
   }
+  plaintext_buffer->resize(ciphertext.size() -
+                           AesGcmHkdfStreamSegmentEncrypter::kTagSizeInBytes);
+  return DecryptSegmentInto(ciphertext, segment_number, is_last_segment,
+                            absl::MakeSpan(*plaintext_buffer))
+      .status();
+}
+
+util::StatusOr<int> AesGcmHkdfStreamSegmentDecrypter::DecryptSegmentInto(
+    absl::Span<const uint8_t> ciphertext,
+    int64_t segment_number,
+    bool is_last_segment,
+    absl::Span<uint8_t> plaintext_buffer) {
+  if (!is_initialized_) {
+    return util::Status(util::error::FAILED_PRECONDITION,
+                        "decrypter not initialized");
+  }
+  if (ciphertext.size() > get_ciphertext_segment_size()) {
+    return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too long");
+  }
+  if (ciphertext.size() < AesGcmHkdfStreamSegmentEncrypter::kTagSizeInBytes) {
+    return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too short");
+  }
+  int pt_size =
+      ciphertext.size() - AesGcmHkdfStreamSegmentEncrypter::kTagSizeInBytes;
+  if (plaintext_buffer.size() < pt_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "plaintext_buffer too small");
+  }
   if (segment_number > std::numeric_limits<uint32_t>::max() ||
       (segment_number == std::numeric_limits<uint32_t>::max() &&
        !is_last_segment)) {
     return util::Status(util::error::INVALID_ARGUMENT, "too many segments");
   }
 
-  int pt_size =
-      ciphertext.size() - AesGcmHkdfStreamSegmentEncrypter::kTagSizeInBytes;
-  plaintext_buffer->resize(pt_size);
-
   // Construct IV.
   std::vector<uint8_t> iv(AesGcmHkdfStreamSegmentEncrypter::kNonceSizeInBytes);
   absl::c_copy(nonce_prefix_, iv.begin());
@@ -200,8 +234,7 @@ util::Status AesGcmHkdfStreamSegmentDecrypter::DecryptSegment(
   // Decrypt.
   size_t out_len;
   if (!EVP_AEAD_CTX_open(
-          ctx_.get(), plaintext_buffer->data(), &out_len,
-          plaintext_buffer->size(),
+          ctx_.get(), plaintext_buffer.data(), &out_len, pt_size,
           iv.data(), iv.size(),
           ciphertext.data(), ciphertext.size(),
           /* ad = */ nullptr, /* ad.length() = */ 0)) {
@@ -209,10 +242,10 @@ util::Status AesGcmHkdfStreamSegmentDecrypter::DecryptSegment(
                         absl::StrCat("Decryption failed: ",
                                      SubtleUtilBoringSSL::GetErrors()));
   }
-  if (out_len != plaintext_buffer->size()) {
+  if (out_len != pt_size) {
     return util::Status(util::error::INTERNAL, "incorrect plaintext size");
   }
-  return util::OkStatus();
+  return pt_size;
 }
 
 
@@ -22,8 +22,10 @@
 #include <string>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "openssl/aead.h"
 #include "tink/subtle/common_enums.h"
+#include "tink/subtle/derived_key_cache.h"
 #include "tink/subtle/stream_segment_decrypter.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/statusor.h"
@@ -67,6 +69,9 @@ class AesGcmHkdfStreamSegmentDecrypter : public StreamSegmentDecrypter {
     int ciphertext_offset;
     int ciphertext_segment_size;
     std::string associated_data;
+    // Optional cache of the keyed AES-GCM contexts, shared by the decrypters
+    // of one key.
+    std::shared_ptr<DerivedKeyCache<EVP_AEAD_CTX>> key_cache;
   };
 
   // A factory.
@@ -82,6 +87,12 @@ class AesGcmHkdfStreamSegmentDecrypter : public StreamSegmentDecrypter {
       bool is_last_segment,
       std::vector<uint8_t>* plaintext_buffer) override;
 
+  util::StatusOr<int> DecryptSegmentInto(
+      absl::Span<const uint8_t> ciphertext,
+      int64_t segment_number,
+      bool is_last_segment,
+      absl::Span<uint8_t> plaintext_buffer) override;
+
   int get_header_size() const override {
     return header_size_;
   }
@@ -107,12 +118,14 @@ class AesGcmHkdfStreamSegmentDecrypter : public StreamSegmentDecrypter {
   const int ciphertext_segment_size_;
   const std::string associated_data_;
   const int header_size_;
+  const std::shared_ptr<DerivedKeyCache<EVP_AEAD_CTX>> key_cache_;
 
   // Parameters set when initializing with data from stream header.
   bool is_initialized_ = false;
   std::vector<uint8_t> salt_;
   std::vector<uint8_t> nonce_prefix_;
-  bssl::UniquePtr<EVP_AEAD_CTX> ctx_;
+  // Possibly shared with other decrypters through key_cache_.
+  std::shared_ptr<const EVP_AEAD_CTX> ctx_;
 };
 
 }  // namespace subtle
@@ -16,12 +16,15 @@
 
 #include "tink/subtle/aes_gcm_hkdf_stream_segment_decrypter.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "tink/subtle/aes_gcm_hkdf_stream_segment_encrypter.h"
 #include "tink/subtle/common_enums.h"
+#include "tink/subtle/derived_key_cache.h"
 #include "tink/subtle/hkdf.h"
 #include "tink/subtle/random.h"
 #include "tink/subtle/stream_segment_encrypter.h"
@@ -146,6 +149,93 @@ TEST(AesGcmHkdfStreamSegmentDecrypterTest, testBasic) {
 }
 
 
+TEST(AesGcmHkdfStreamSegmentDecrypterTest, testDecryptSegmentInto) {
+  AesGcmHkdfStreamSegmentDecrypter::Params params;
+  params.ikm = Random::GetRandomKeyBytes(16);
+  params.hkdf_hash = SHA256;
+  params.derived_key_size = 16;
+  params.ciphertext_offset = 0;
+  params.ciphertext_segment_size = 128;
+  params.associated_data = "associated data";
+  auto result = AesGcmHkdfStreamSegmentDecrypter::New(params);
+  ASSERT_TRUE(result.ok()) << result.status();
+  auto dec = std::move(result.ValueOrDie());
+  auto enc = std::move(
+      GetEncrypter(params.ikm, params.hkdf_hash, params.derived_key_size,
+                   params.ciphertext_offset, params.ciphertext_segment_size,
+                   params.associated_data).ValueOrDie());
+  auto status = dec->Init(enc->get_header());
+  ASSERT_TRUE(status.ok()) << status;
+
+  // Encrypt and decrypt a segment within larger buffers, without vectors
+  // of the exact segment sizes.
+  std::vector<uint8_t> pt(dec->get_plaintext_segment_size(), 'p');
+  std::vector<uint8_t> ct_buffer(dec->get_ciphertext_segment_size() + 10);
+  auto enc_result = enc->EncryptSegmentInto(
+      absl::MakeConstSpan(pt).subspan(5), false, absl::MakeSpan(ct_buffer));
+  ASSERT_TRUE(enc_result.ok()) << enc_result.status();
+  std::vector<uint8_t> pt_buffer(dec->get_plaintext_segment_size());
+  auto dec_result = dec->DecryptSegmentInto(
+      absl::MakeConstSpan(ct_buffer.data(), enc_result.ValueOrDie()), 0,
+      false, absl::MakeSpan(pt_buffer));
+  ASSERT_TRUE(dec_result.ok()) << dec_result.status();
+  EXPECT_EQ(pt.size() - 5, dec_result.ValueOrDie());
+  EXPECT_EQ(std::vector<uint8_t>(pt.begin() + 5, pt.end()),
+            std::vector<uint8_t>(pt_buffer.begin(),
+                                 pt_buffer.begin() + pt.size() - 5));
+
+  // A plaintext buffer that is too small is rejected.
+  dec_result = dec->DecryptSegmentInto(
+      absl::MakeConstSpan(ct_buffer.data(), enc_result.ValueOrDie()), 0,
+      false, absl::MakeSpan(pt_buffer.data(), pt.size() - 6));
+  EXPECT_FALSE(dec_result.ok());
+  EXPECT_PRED_FORMAT2(testing::IsSubstring, "too small",
+                      dec_result.status().error_message());
+}
+
+TEST(AesGcmHkdfStreamSegmentDecrypterTest, testKeyCache) {
+  AesGcmHkdfStreamSegmentDecrypter::Params params;
+  params.ikm = Random::GetRandomKeyBytes(16);
+  params.hkdf_hash = SHA256;
+  params.derived_key_size = 16;
+  params.ciphertext_offset = 0;
+  params.ciphertext_segment_size = 128;
+  params.associated_data = "associated data";
+  params.key_cache = std::make_shared<DerivedKeyCache<EVP_AEAD_CTX>>(2);
+  auto enc = std::move(
+      GetEncrypter(params.ikm, params.hkdf_hash, params.derived_key_size,
+                   params.ciphertext_offset, params.ciphertext_segment_size,
+                   params.associated_data).ValueOrDie());
+  std::vector<uint8_t> pt(10, 'p');
+  std::vector<uint8_t> ct;
+  auto status = enc->EncryptSegment(pt, true, &ct);
+  ASSERT_TRUE(status.ok()) << status;
+
+  // The first decrypter derives the key and caches it, the second one gets
+  // the same keyed context from the cache.
+  std::string salt(
+      reinterpret_cast<const char*>(enc->get_header().data()) + 1,
+      params.derived_key_size);
+  EXPECT_EQ(nullptr, params.key_cache->Get(salt, params.associated_data));
+  std::shared_ptr<const EVP_AEAD_CTX> cached;
+  for (int i = 0; i < 2; i++) {
+    SCOPED_TRACE(absl::StrCat("decrypter = ", i));
+    auto result = AesGcmHkdfStreamSegmentDecrypter::New(params);
+    ASSERT_TRUE(result.ok()) << result.status();
+    auto dec = std::move(result.ValueOrDie());
+    status = dec->Init(enc->get_header());
+    ASSERT_TRUE(status.ok()) << status;
+    auto ctx = params.key_cache->Get(salt, params.associated_data);
+    ASSERT_NE(nullptr, ctx);
+    if (i == 0) cached = ctx;
+    EXPECT_EQ(cached, ctx);
+    std::vector<uint8_t> decrypted;
+    status = dec->DecryptSegment(ct, 0, true, &decrypted);
+    EXPECT_TRUE(status.ok()) << status;
+    EXPECT_EQ(pt, decrypted);
+  }
+}
+
 TEST(AesGcmHkdfStreamSegmentDecrypterTest, testWrongDerivedKeySize) {
   for (int derived_key_size : {12, 24, 64}) {
     for (HashType hkdf_hash : {SHA1, SHA256, SHA512}) {
@@ -25,6 +25,7 @@
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "openssl/aead.h"
 #include "tink/subtle/random.h"
 #include "tink/subtle/subtle_util_boringssl.h"
@@ -72,6 +73,21 @@ util::Status Validate(const AesGcmHkdfStreamSegmentEncrypter::Params& params) {
     return util::Status(util::error::INVALID_ARGUMENT,
                         "ciphertext_segment_size too small");
   }
+  if (!params.nonce_prefix.empty() &&
+      params.nonce_prefix.size() !=
+          AesGcmHkdfStreamSegmentEncrypter::kNoncePrefixSizeInBytes) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "nonce_prefix has wrong size");
+  }
+  if (params.segment_number < 0 ||
+      params.segment_number > std::numeric_limits<uint32_t>::max()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "segment_number out of range");
+  }
+  if (params.nonce_prefix.empty() && params.segment_number != 0) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "segment_number requires a nonce_prefix");
+  }
   return util::OkStatus();
 }
 
@@ -92,6 +108,14 @@ util::StatusOr<bssl::UniquePtr<EVP_AEAD_CTX>> CreateAeadCtx(
   return ctx;
 }
 
+std::string CreateNoncePrefix() {
+  std::string nonce_prefix(
+      AesGcmHkdfStreamSegmentEncrypter::kNoncePrefixSizeInBytes, '\0');
+  Random::GetRandomNonceBytes(
+      absl::MakeSpan(&nonce_prefix[0], nonce_prefix.size()));
+  return nonce_prefix;
+}
+
 std::vector<uint8_t> CreateHeader(absl::string_view salt,
                                   absl::string_view nonce_prefix) {
   uint8_t header_size = static_cast<uint8_t>(
@@ -113,10 +137,12 @@ int AesGcmHkdfStreamSegmentEncrypter::get_plaintext_segment_size() const {
 AesGcmHkdfStreamSegmentEncrypter::AesGcmHkdfStreamSegmentEncrypter(
     bssl::UniquePtr<EVP_AEAD_CTX> ctx, const Params& params)
     : ctx_(std::move(ctx)),
-      nonce_prefix_(Random::GetRandomBytes(kNoncePrefixSizeInBytes)),
+      nonce_prefix_(params.nonce_prefix.empty() ? CreateNoncePrefix()
+                                                 : params.nonce_prefix),
       header_(CreateHeader(params.salt, nonce_prefix_)),
       ciphertext_segment_size_(params.ciphertext_segment_size),
-      ciphertext_offset_(params.ciphertext_offset) {}
+      ciphertext_offset_(params.ciphertext_offset),
+      segment_number_(params.segment_number) {}
 
 // static
 util::StatusOr<std::unique_ptr<StreamSegmentEncrypter>>
@@ -134,6 +160,31 @@ util::Status AesGcmHkdfStreamSegmentEncrypter::EncryptSegment(
     const std::vector<uint8_t>& plaintext,
     bool is_last_segment,
     std::vector<uint8_t>* ciphertext_buffer) {
+  auto status = EncryptSegmentAt(plaintext, get_segment_number(),
+                                 is_last_segment, ciphertext_buffer);
+  if (!status.ok()) return status;
+  IncSegmentNumber();
+  return util::OkStatus();
+}
+
+util::StatusOr<int> AesGcmHkdfStreamSegmentEncrypter::EncryptSegmentInto(
+    absl::Span<const uint8_t> plaintext,
+    bool is_last_segment,
+    absl::Span<uint8_t> ciphertext_buffer) {
+  auto status = SealSegment(plaintext, get_segment_number(), is_last_segment,
+                            ciphertext_buffer);
+  if (!status.ok()) return status;
+  IncSegmentNumber();
+  return static_cast<int>(plaintext.size()) + kTagSizeInBytes;
+}
+
+// EVP_AEAD_CTX_seal() does not modify the context, so concurrent calls are
+// safe.
+util::Status AesGcmHkdfStreamSegmentEncrypter::EncryptSegmentAt(
+    const std::vector<uint8_t>& plaintext,
+    int64_t segment_number,
+    bool is_last_segment,
+    std::vector<uint8_t>* ciphertext_buffer) const {
   if (plaintext.size() > get_plaintext_segment_size()) {
     return util::Status(util::error::INVALID_ARGUMENT, "plaintext too long");
   }
@@ -141,25 +192,38 @@ util::Status AesGcmHkdfStreamSegmentEncrypter::EncryptSegment(
     return util::Status(util::error::INVALID_ARGUMENT,
                         "ciphertext_buffer must be non-null");
   }
-  if (get_segment_number() > std::numeric_limits<uint32_t>::max() ||
-      (get_segment_number() == std::numeric_limits<uint32_t>::max() &&
+  ciphertext_buffer->resize(plaintext.size() + kTagSizeInBytes);
+  return SealSegment(plaintext, segment_number, is_last_segment,
+                     absl::MakeSpan(*ciphertext_buffer));
+}
+
+util::Status AesGcmHkdfStreamSegmentEncrypter::SealSegment(
+    absl::Span<const uint8_t> plaintext, int64_t segment_number,
+    bool is_last_segment, absl::Span<uint8_t> ciphertext_buffer) const {
+  if (plaintext.size() > get_plaintext_segment_size()) {
+    return util::Status(util::error::INVALID_ARGUMENT, "plaintext too long");
+  }
+  int ct_size = plaintext.size() + kTagSizeInBytes;
+  if (ciphertext_buffer.size() < ct_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_buffer too small");
+  }
+  if (segment_number < 0 ||
+      segment_number > std::numeric_limits<uint32_t>::max() ||
+      (segment_number == std::numeric_limits<uint32_t>::max() &&
        !is_last_segment)) {
     return util::Status(util::error::INVALID_ARGUMENT, "too many segments");
   }
 
-  int ct_size = plaintext.size() + kTagSizeInBytes;
-  ciphertext_buffer->resize(ct_size);
-
   // Construct IV.
   std::vector<uint8_t> iv(kNonceSizeInBytes);
   memcpy(iv.data(), nonce_prefix_.data(), kNoncePrefixSizeInBytes);
   BigEndianStore32(iv.data() + kNoncePrefixSizeInBytes,
-                   static_cast<uint32_t>(get_segment_number()));
+                   static_cast<uint32_t>(segment_number));
   iv.back() = is_last_segment ? 1 : 0;
   size_t out_len;
   if (!EVP_AEAD_CTX_seal(
-          ctx_.get(), ciphertext_buffer->data(), &out_len,
-          ciphertext_buffer->size(),
+          ctx_.get(), ciphertext_buffer.data(), &out_len, ct_size,
           iv.data(), iv.size(),
           plaintext.data(), plaintext.size(),
           /* ad = */ nullptr, /* ad.length() = */ 0)) {
@@ -167,7 +231,6 @@ util::Status AesGcmHkdfStreamSegmentEncrypter::EncryptSegment(
                         absl::StrCat("Encryption failed: ",
                                      SubtleUtilBoringSSL::GetErrors()));
   }
-  IncSegmentNumber();
   return util::OkStatus();
 }
 
@@ -17,10 +17,12 @@
 #ifndef TINK_SUBTLE_AES_GCM_HKDF_STREAM_SEGMENT_ENCRYPTER_H_
 #define TINK_SUBTLE_AES_GCM_HKDF_STREAM_SEGMENT_ENCRYPTER_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "openssl/aead.h"
 #include "tink/subtle/stream_segment_encrypter.h"
 #include "tink/util/secret_data.h"
@@ -76,6 +78,13 @@ class AesGcmHkdfStreamSegmentEncrypter : public StreamSegmentEncrypter {
     std::string salt;
     int ciphertext_offset;
     int ciphertext_segment_size;
+    // If non-empty, the nonce prefix to use instead of a random one, and
+    // 'segment_number' is the number of the first segment to encrypt. This
+    // allows continuing an existing ciphertext stream with the given salt and
+    // nonce prefix; such an encrypter must never seal a segment number that
+    // was sealed before with different plaintext.
+    std::string nonce_prefix;
+    int64_t segment_number = 0;
   };
 
   // A factory.
@@ -87,6 +96,15 @@ class AesGcmHkdfStreamSegmentEncrypter : public StreamSegmentEncrypter {
       const std::vector<uint8_t>& plaintext,
       bool is_last_segment,
       std::vector<uint8_t>* ciphertext_buffer) override;
+  util::Status EncryptSegmentAt(
+      const std::vector<uint8_t>& plaintext,
+      int64_t segment_number,
+      bool is_last_segment,
+      std::vector<uint8_t>* ciphertext_buffer) const override;
+  util::StatusOr<int> EncryptSegmentInto(
+      absl::Span<const uint8_t> plaintext,
+      bool is_last_segment,
+      absl::Span<uint8_t> ciphertext_buffer) override;
 
   const std::vector<uint8_t>& get_header() const override {
     return header_;
@@ -111,13 +129,19 @@ class AesGcmHkdfStreamSegmentEncrypter : public StreamSegmentEncrypter {
   AesGcmHkdfStreamSegmentEncrypter(bssl::UniquePtr<EVP_AEAD_CTX> ctx,
                                    const Params& params);
 
+  // Encrypts 'plaintext' as the segment with number 'segment_number' into
+  // the beginning of 'ciphertext_buffer'.
+  util::Status SealSegment(absl::Span<const uint8_t> plaintext,
+                           int64_t segment_number, bool is_last_segment,
+                           absl::Span<uint8_t> ciphertext_buffer) const;
+
   bssl::UniquePtr<EVP_AEAD_CTX> ctx_;
   const std::string nonce_prefix_;
   const std::vector<uint8_t> header_;
   const int ciphertext_segment_size_;
   const int ciphertext_offset_;
 
-  int64_t segment_number_ = 0;
+  int64_t segment_number_;
 };
 
 }  // namespace subtle
@@ -22,6 +22,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "tink/subtle/random.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
@@ -96,6 +97,41 @@ TEST(AesGcmHkdfStreamSegmentEncrypterTest, testBasic) {
   }
 }
 
+TEST(AesGcmHkdfStreamSegmentEncrypterTest, testEncryptSegmentInto) {
+  AesGcmHkdfStreamSegmentEncrypter::Params params;
+  params.key = Random::GetRandomKeyBytes(16);
+  params.salt = Random::GetRandomBytes(16);
+  params.ciphertext_offset = 0;
+  params.ciphertext_segment_size = 128;
+  auto result = AesGcmHkdfStreamSegmentEncrypter::New(params);
+  ASSERT_TRUE(result.ok()) << result.status();
+  auto enc = std::move(result.ValueOrDie());
+
+  std::vector<uint8_t> pt(enc->get_plaintext_segment_size(), 'p');
+  std::vector<uint8_t> expected_ct;
+  auto status = enc->EncryptSegmentAt(pt, /* segment_number = */ 0,
+                                      /* is_last_segment = */ false,
+                                      &expected_ct);
+  EXPECT_TRUE(status.ok()) << status;
+
+  // The buffer may be larger than the ciphertext segment.
+  std::vector<uint8_t> buffer(expected_ct.size() + 10, 'x');
+  auto into_result = enc->EncryptSegmentInto(pt, false, absl::MakeSpan(buffer));
+  EXPECT_TRUE(into_result.ok()) << into_result.status();
+  EXPECT_EQ(expected_ct.size(), into_result.ValueOrDie());
+  EXPECT_EQ(expected_ct,
+            std::vector<uint8_t>(buffer.begin(),
+                                 buffer.begin() + expected_ct.size()));
+  EXPECT_EQ(1, enc->get_segment_number());
+
+  // A buffer that is too small is rejected.
+  buffer.resize(expected_ct.size() - 1);
+  into_result = enc->EncryptSegmentInto(pt, true, absl::MakeSpan(buffer));
+  EXPECT_FALSE(into_result.ok());
+  EXPECT_THAT(into_result.status().error_message(), HasSubstr("too small"));
+  EXPECT_EQ(1, enc->get_segment_number());
+}
+
 TEST(AesGcmHkdfStreamSegmentEncrypterTest, testWrongKeySize) {
   for (int key_size : {12, 24, 64}) {
     for (int ciphertext_offset : {0, 5, 10}) {
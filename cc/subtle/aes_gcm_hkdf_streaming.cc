@@ -72,7 +72,34 @@ util::StatusOr<std::unique_ptr<StreamSegmentEncrypter>>
 AesGcmHkdfStreaming::NewSegmentEncrypter(
     absl::string_view associated_data) const {
   AesGcmHkdfStreamSegmentEncrypter::Params params;
-  params.salt = Random::GetRandomBytes(derived_key_size_);
+  params.salt = Random::GetRandomNonceBytes(derived_key_size_);
+  auto hkdf_result = Hkdf::ComputeHkdf(hkdf_hash_, ikm_, params.salt,
+                                       associated_data, derived_key_size_);
+  if (!hkdf_result.ok()) return hkdf_result.status();
+  params.key = std::move(hkdf_result).ValueOrDie();
+  params.ciphertext_offset = ciphertext_offset_;
+  params.ciphertext_segment_size = ciphertext_segment_size_;
+  return AesGcmHkdfStreamSegmentEncrypter::New(std::move(params));
+}
+
+util::StatusOr<std::unique_ptr<StreamSegmentEncrypter>>
+AesGcmHkdfStreaming::NewSegmentEncrypterForAppend(
+    absl::string_view associated_data, const std::vector<uint8_t>& header,
+    int64_t segment_number) const {
+  // The header is header_size || salt || nonce_prefix, see
+  // AesGcmHkdfStreamSegmentEncrypter.
+  const int header_size =
+      1 + derived_key_size_ +
+      AesGcmHkdfStreamSegmentEncrypter::kNoncePrefixSizeInBytes;
+  if (header.size() != header_size || header[0] != header_size) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid header");
+  }
+  AesGcmHkdfStreamSegmentEncrypter::Params params;
+  params.salt = std::string(header.begin() + 1,
+                            header.begin() + 1 + derived_key_size_);
+  params.nonce_prefix =
+      std::string(header.begin() + 1 + derived_key_size_, header.end());
+  params.segment_number = segment_number;
   auto hkdf_result = Hkdf::ComputeHkdf(hkdf_hash_, ikm_, params.salt,
                                        associated_data, derived_key_size_);
   if (!hkdf_result.ok()) return hkdf_result.status();
@@ -92,6 +119,7 @@ AesGcmHkdfStreaming::NewSegmentDecrypter(
   params.ciphertext_offset = ciphertext_offset_;
   params.ciphertext_segment_size = ciphertext_segment_size_;
   params.associated_data = std::string(associated_data);
+  params.key_cache = key_cache_;
   return AesGcmHkdfStreamSegmentDecrypter::New(std::move(params));
 }
 
@@ -17,11 +17,15 @@
 #ifndef TINK_SUBTLE_AES_GCM_HKDF_STREAMING_H_
 #define TINK_SUBTLE_AES_GCM_HKDF_STREAMING_H_
 
+#include <cstdint>
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include "openssl/aead.h"
 #include "tink/config/tink_fips.h"
 #include "tink/subtle/common_enums.h"
+#include "tink/subtle/derived_key_cache.h"
 #include "tink/subtle/nonce_based_streaming_aead.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/statusor.h"
@@ -38,6 +42,10 @@ class AesGcmHkdfStreaming : public NonceBasedStreamingAead {
     int derived_key_size;
     int ciphertext_segment_size;
     int ciphertext_offset;
+    // If positive, the keyed contexts of up to this many recently opened
+    // ciphertext streams are kept, so that opening one of them again for
+    // decryption skips the key derivation.
+    int derived_key_cache_size = 0;
   };
 
   static util::StatusOr<std::unique_ptr<AesGcmHkdfStreaming>> New(
@@ -53,19 +61,29 @@ class AesGcmHkdfStreaming : public NonceBasedStreamingAead {
   util::StatusOr<std::unique_ptr<StreamSegmentDecrypter>> NewSegmentDecrypter(
       absl::string_view associated_data) const override;
 
+  util::StatusOr<std::unique_ptr<StreamSegmentEncrypter>>
+  NewSegmentEncrypterForAppend(absl::string_view associated_data,
+                               const std::vector<uint8_t>& header,
+                               int64_t segment_number) const override;
+
  private:
   explicit AesGcmHkdfStreaming(Params params)
       : ikm_(std::move(params.ikm)),
         hkdf_hash_(params.hkdf_hash),
         derived_key_size_(params.derived_key_size),
         ciphertext_segment_size_(params.ciphertext_segment_size),
-        ciphertext_offset_(params.ciphertext_offset) {}
+        ciphertext_offset_(params.ciphertext_offset),
+        key_cache_(params.derived_key_cache_size > 0
+                       ? std::make_shared<DerivedKeyCache<EVP_AEAD_CTX>>(
+                             params.derived_key_cache_size)
+                       : nullptr) {}
 
   const util::SecretData ikm_;
   const HashType hkdf_hash_;
   const int derived_key_size_;
   const int ciphertext_segment_size_;
   const int ciphertext_offset_;
+  const std::shared_ptr<DerivedKeyCache<EVP_AEAD_CTX>> key_cache_;
 };
 
 }  // namespace subtle
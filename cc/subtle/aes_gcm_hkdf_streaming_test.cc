@@ -18,20 +18,25 @@
 
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "tink/output_stream.h"
+#include "tink/subtle/aes_gcm_hkdf_stream_segment_encrypter.h"
 #include "tink/subtle/common_enums.h"
 #include "tink/subtle/random.h"
+#include "tink/subtle/streaming_aead_record_encrypter.h"
 #include "tink/subtle/streaming_aead_test_util.h"
 #include "tink/subtle/test_util.h"
+#include "tink/util/file_random_access_stream.h"
 #include "tink/util/istream_input_stream.h"
 #include "tink/util/ostream_output_stream.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
 
 namespace crypto {
 namespace tink {
@@ -94,6 +99,306 @@ TEST(AesGcmHkdfStreamingTest, testBasic) {
   }
 }
 
+TEST(AesGcmHkdfStreamingTest, testDecryptRange) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  for (int ciphertext_offset : {0, 10}) {
+    SCOPED_TRACE(absl::StrCat("ciphertext_offset = ", ciphertext_offset));
+    AesGcmHkdfStreaming::Params params;
+    params.ikm = Random::GetRandomKeyBytes(16);
+    params.hkdf_hash = SHA256;
+    params.derived_key_size = 16;
+    params.ciphertext_segment_size = 128;
+    params.ciphertext_offset = ciphertext_offset;
+    auto result = AesGcmHkdfStreaming::New(std::move(params));
+    ASSERT_THAT(result.status(), IsOk());
+    auto streaming_aead = std::move(result.ValueOrDie());
+
+    // Encrypt a plaintext of a few segments, preceded by ciphertext_offset
+    // bytes.
+    std::string associated_data = "some associated data";
+    std::string pt = Random::GetRandomBytes(1000);
+    auto ct_stream = absl::make_unique<std::stringstream>();
+    auto ct_buf = ct_stream->rdbuf();
+    auto ct_destination =
+        absl::make_unique<util::OstreamOutputStream>(std::move(ct_stream));
+    ASSERT_THAT(test::WriteToStream(ct_destination.get(),
+                                    std::string(ciphertext_offset, 'o'),
+                                    false),
+                IsOk());
+    auto enc_stream_result = streaming_aead->NewEncryptingStream(
+        std::move(ct_destination), associated_data);
+    ASSERT_THAT(enc_stream_result.status(), IsOk());
+    ASSERT_THAT(test::WriteToStream(enc_stream_result.ValueOrDie().get(), pt),
+                IsOk());
+    util::FileRandomAccessStream ct_source(
+        crypto::tink::test::GetTestFileDescriptor(
+            absl::StrCat("decrypt_range_", ciphertext_offset, ".txt"),
+            ct_buf->str()));
+
+    for (int num_threads : {1, 3}) {
+      for (int offset : {0, 1, 50, 100, 111, 112, 500, 999}) {
+        for (int length : {1, 16, 112, 400, 2000}) {
+          SCOPED_TRACE(absl::StrCat("num_threads = ", num_threads,
+                                    ", offset = ", offset,
+                                    ", length = ", length));
+          auto range_result = streaming_aead->DecryptRange(
+              &ct_source, associated_data, offset, length, num_threads);
+          ASSERT_THAT(range_result.status(), IsOk());
+          EXPECT_EQ(pt.substr(offset, length), range_result.ValueOrDie());
+        }
+      }
+    }
+    auto empty_result = streaming_aead->DecryptRange(
+        &ct_source, associated_data, 0, 0);
+    ASSERT_THAT(empty_result.status(), IsOk());
+    EXPECT_EQ("", empty_result.ValueOrDie());
+    EXPECT_THAT(streaming_aead->DecryptRange(&ct_source, associated_data,
+                                             pt.size(), 1).status(),
+                StatusIs(util::error::OUT_OF_RANGE));
+    EXPECT_THAT(streaming_aead->DecryptRange(&ct_source, associated_data,
+                                             -1, 1).status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+    EXPECT_THAT(streaming_aead->DecryptRange(&ct_source, "wrong aad",
+                                             500, 100, 3).status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+}
+
+// Returns the ciphertext of 'pt', preceded by 'ciphertext_offset' bytes.
+std::string EncryptToString(NonceBasedStreamingAead* streaming_aead,
+                            absl::string_view pt,
+                            absl::string_view associated_data,
+                            int ciphertext_offset) {
+  auto ct_stream = absl::make_unique<std::stringstream>();
+  auto ct_buf = ct_stream->rdbuf();
+  auto ct_destination =
+      absl::make_unique<util::OstreamOutputStream>(std::move(ct_stream));
+  EXPECT_THAT(test::WriteToStream(ct_destination.get(),
+                                  std::string(ciphertext_offset, 'o'), false),
+              IsOk());
+  auto enc_stream_result = streaming_aead->NewEncryptingStream(
+      std::move(ct_destination), associated_data);
+  EXPECT_THAT(enc_stream_result.status(), IsOk());
+  EXPECT_THAT(test::WriteToStream(enc_stream_result.ValueOrDie().get(), pt),
+              IsOk());
+  return ct_buf->str();
+}
+
+TEST(AesGcmHkdfStreamingTest, testAppend) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  for (int ciphertext_offset : {0, 10}) {
+    AesGcmHkdfStreaming::Params params;
+    params.ikm = Random::GetRandomKeyBytes(16);
+    params.hkdf_hash = SHA256;
+    params.derived_key_size = 16;
+    params.ciphertext_segment_size = 128;
+    params.ciphertext_offset = ciphertext_offset;
+    auto result = AesGcmHkdfStreaming::New(std::move(params));
+    ASSERT_THAT(result.status(), IsOk());
+    auto streaming_aead = std::move(result.ValueOrDie());
+    std::string associated_data = "some associated data";
+
+    for (int pt_size : {0, 20, 78, 500, 1000}) {
+      for (int append_size : {0, 1, 200, 1000}) {
+        SCOPED_TRACE(absl::StrCat("ciphertext_offset = ", ciphertext_offset,
+                                  ", pt_size = ", pt_size,
+                                  ", append_size = ", append_size));
+        std::string pt = Random::GetRandomBytes(pt_size);
+        std::string ct = EncryptToString(streaming_aead.get(), pt,
+                                         associated_data, ciphertext_offset);
+        util::FileRandomAccessStream ct_source(
+            crypto::tink::test::GetTestFileDescriptor(
+                absl::StrCat("append_", ciphertext_offset, ".txt"), ct));
+        auto position_result = streaming_aead->GetAppendPosition(&ct_source);
+        ASSERT_THAT(position_result.status(), IsOk());
+        int64_t position = position_result.ValueOrDie();
+
+        auto out_stream = absl::make_unique<std::stringstream>();
+        auto out_buf = out_stream->rdbuf();
+        auto append_stream_result = streaming_aead->NewAppendingStream(
+            &ct_source,
+            absl::make_unique<util::OstreamOutputStream>(
+                std::move(out_stream)),
+            associated_data);
+        ASSERT_THAT(append_stream_result.status(), IsOk());
+        auto append_stream = std::move(append_stream_result.ValueOrDie());
+        EXPECT_EQ(pt_size, append_stream->Position());
+        std::string appended = Random::GetRandomBytes(append_size);
+        auto status = test::WriteToStream(append_stream.get(), appended);
+        if (append_size == 1) {
+          // A single byte fits into the existing last segment.
+          EXPECT_THAT(status, StatusIs(util::error::FAILED_PRECONDITION));
+          EXPECT_EQ("", out_buf->str());
+          continue;
+        }
+        ASSERT_THAT(status, IsOk());
+        if (append_size == 0) {
+          EXPECT_EQ("", out_buf->str());
+          continue;
+        }
+
+        // The output replaces the ciphertext from the append position on.
+        std::string new_ct = ct.substr(0, position) + out_buf->str();
+        util::FileRandomAccessStream new_ct_source(
+            crypto::tink::test::GetTestFileDescriptor(
+                absl::StrCat("appended_", ciphertext_offset, ".txt"), new_ct));
+        auto dec_result = streaming_aead->DecryptRange(
+            &new_ct_source, associated_data, 0, pt_size + append_size);
+        ASSERT_THAT(dec_result.status(), IsOk());
+        EXPECT_EQ(pt + appended, dec_result.ValueOrDie());
+      }
+    }
+
+    // The existing ciphertext is authenticated.
+    std::string ct = EncryptToString(streaming_aead.get(), "some plaintext",
+                                     associated_data, ciphertext_offset);
+    util::FileRandomAccessStream ct_source(
+        crypto::tink::test::GetTestFileDescriptor(
+            absl::StrCat("append_", ciphertext_offset, ".txt"), ct));
+    EXPECT_THAT(streaming_aead
+                    ->NewAppendingStream(
+                        &ct_source,
+                        absl::make_unique<util::OstreamOutputStream>(
+                            absl::make_unique<std::stringstream>()),
+                        "wrong associated data")
+                    .status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+}
+
+TEST(AesGcmHkdfStreamingTest, testRecords) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  AesGcmHkdfStreaming::Params params;
+  params.ikm = Random::GetRandomKeyBytes(16);
+  params.hkdf_hash = SHA256;
+  params.derived_key_size = 16;
+  params.ciphertext_segment_size = 128;
+  params.ciphertext_offset = 0;
+  auto result = AesGcmHkdfStreaming::New(std::move(params));
+  ASSERT_THAT(result.status(), IsOk());
+  auto streaming_aead = std::move(result.ValueOrDie());
+  std::string associated_data = "some associated data";
+
+  auto enc_result = streaming_aead->NewRecordEncrypter(associated_data);
+  ASSERT_THAT(enc_result.status(), IsOk());
+  auto encrypter = std::move(enc_result.ValueOrDie());
+  EXPECT_EQ(encrypter->get_max_message_size(), 112);
+  std::vector<std::string> messages;
+  for (int size : {0, 1, 20, 112, 0, 50}) {
+    messages.push_back(Random::GetRandomBytes(size));
+  }
+  // Records can be encrypted in any order, as in a pipeline, and are sent
+  // in the order of their numbers.
+  std::vector<std::string> records(messages.size() + 1);
+  for (int i = messages.size(); i >= 0; i--) {
+    bool is_last = i == messages.size();
+    ASSERT_THAT(encrypter->EncryptRecordAt(is_last ? "" : messages[i], i,
+                                           is_last, &records[i]),
+                IsOk());
+    EXPECT_EQ(records[i].size(),
+              StreamingAeadRecordEncrypter::kLengthSizeInBytes +
+                  (is_last ? 0 : messages[i].size()) +
+                  AesGcmHkdfStreamSegmentEncrypter::kTagSizeInBytes);
+  }
+  std::string data(encrypter->get_header().begin(),
+                   encrypter->get_header().end());
+  for (const std::string& record : records) data += record;
+
+  auto dec_result = streaming_aead->NewRecordDecrypter(associated_data);
+  ASSERT_THAT(dec_result.status(), IsOk());
+  auto decrypter = std::move(dec_result.ValueOrDie());
+  std::vector<std::string> decrypted;
+  EXPECT_THAT(decrypter->Update(data, &decrypted), IsOk());
+  EXPECT_THAT(decrypter->Finalize(), IsOk());
+  EXPECT_EQ(decrypted, messages);
+
+  // The records are authenticated with the associated data.
+  auto wrong_dec_result =
+      streaming_aead->NewRecordDecrypter("wrong associated data");
+  ASSERT_THAT(wrong_dec_result.status(), IsOk());
+  decrypted.clear();
+  EXPECT_FALSE(wrong_dec_result.ValueOrDie()->Update(data, &decrypted).ok());
+  EXPECT_TRUE(decrypted.empty());
+}
+
+TEST(AesGcmHkdfStreamingTest, testRandomAccessEncrypter) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  for (int ciphertext_offset : {0, 10}) {
+    AesGcmHkdfStreaming::Params params;
+    params.ikm = Random::GetRandomKeyBytes(16);
+    params.hkdf_hash = SHA256;
+    params.derived_key_size = 16;
+    params.ciphertext_segment_size = 128;
+    params.ciphertext_offset = ciphertext_offset;
+    auto result = AesGcmHkdfStreaming::New(std::move(params));
+    ASSERT_THAT(result.status(), IsOk());
+    auto streaming_aead = std::move(result.ValueOrDie());
+    std::string associated_data = "some associated data";
+
+    for (int pt_size : {0, 20, 500, 1000}) {
+      SCOPED_TRACE(absl::StrCat("ciphertext_offset = ", ciphertext_offset,
+                                ", pt_size = ", pt_size));
+      // One writer creates the stream, another one encrypts the odd
+      // segments using the shared header.
+      auto enc_result =
+          streaming_aead->NewRandomAccessEncrypter(associated_data);
+      ASSERT_THAT(enc_result.status(), IsOk());
+      auto encrypter = std::move(enc_result.ValueOrDie());
+      std::string header(encrypter->get_header().begin(),
+                         encrypter->get_header().end());
+      auto other_enc_result =
+          streaming_aead->NewRandomAccessEncrypter(associated_data, header);
+      ASSERT_THAT(other_enc_result.status(), IsOk());
+      auto other_encrypter = std::move(other_enc_result.ValueOrDie());
+
+      std::string pt = Random::GetRandomBytes(pt_size);
+      int64_t num_segments = encrypter->GetNumberOfSegments(pt_size);
+      std::string ct(encrypter->GetCiphertextPosition(num_segments - 1), 'x');
+      ct.replace(encrypter->get_header_position(), header.size(), header);
+      for (int64_t i = num_segments - 1; i >= 0; i--) {
+        std::string segment_ct;
+        ASSERT_THAT(
+            (i % 2 == 0 ? encrypter : other_encrypter)
+                ->EncryptSegment(
+                    i,
+                    absl::string_view(pt).substr(
+                        encrypter->GetPlaintextPosition(i),
+                        encrypter->GetPlaintextSegmentSize(i)),
+                    i == num_segments - 1, &segment_ct),
+            IsOk());
+        ct.replace(encrypter->GetCiphertextPosition(i), segment_ct.size(),
+                   segment_ct);
+      }
+
+      auto dec_stream_result = streaming_aead->NewDecryptingStream(
+          absl::make_unique<util::IstreamInputStream>(
+              absl::make_unique<std::stringstream>(
+                  ct.substr(ciphertext_offset))),
+          associated_data);
+      ASSERT_THAT(dec_stream_result.status(), IsOk());
+      std::string decrypted;
+      EXPECT_THAT(test::ReadFromStream(dec_stream_result.ValueOrDie().get(),
+                                       &decrypted),
+                  IsOk());
+      EXPECT_EQ(pt, decrypted);
+    }
+
+    // The header must be that of the streaming AEAD.
+    EXPECT_THAT(streaming_aead
+                    ->NewRandomAccessEncrypter(associated_data, "header")
+                    .status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+}
+
 TEST(AesGcmHkdfStreamingTest, testIkmSmallerThanDerivedKey) {
   if (kUseOnlyFips) {
     GTEST_SKIP() << "Not supported in FIPS-only mode";
@@ -0,0 +1,578 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/aes_gcm_multi_buffer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#if defined(__AES__) && defined(__AVX2__) && defined(__VAES__) && \
+    defined(__VPCLMULQDQ__)
+#define TINK_AES_GCM_MULTI_BUFFER_VAES 1
+#include <immintrin.h>
+#endif
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "openssl/mem.h"
+#include "tink/subtle/cpu_features.h"
+#include "tink/util/secret_data.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+namespace {
+
+constexpr size_t kBlockSize = 16;
+
+bool IsAvailable() {
+#if defined(TINK_AES_GCM_MULTI_BUFFER_VAES)
+  return HasCpuFeature(CpuFeature::kAesNi) &&
+         HasCpuFeature(CpuFeature::kAvx2) && HasCpuFeature(CpuFeature::kVaes) &&
+         HasCpuFeature(CpuFeature::kVpclmulqdq);
+#else
+  return false;
+#endif
+}
+
+// A message of a batch.
+struct Message {
+  const uint8_t* iv;
+  const uint8_t* associated_data;
+  size_t associated_data_size;
+  // The CTR input and output, of 'size' bytes.
+  const uint8_t* in;
+  uint8_t* out;
+  size_t size;
+  // The ciphertext, which is 'out' when sealing and 'in' when opening.
+  const uint8_t* ciphertext;
+};
+
+#if defined(TINK_AES_GCM_MULTI_BUFFER_VAES)
+
+size_t Blocks(size_t size) { return (size + kBlockSize - 1) / kBlockSize; }
+
+// The number of counter blocks encrypted at once, in 4 registers.
+constexpr int kAesBlocks = 8;
+// The number of messages whose GHASH is computed at once, in 4 registers.
+constexpr int kGhashLanes = 8;
+// The number of blocks of a message hashed per reduction.
+constexpr int kGhashStride = 4;
+
+// Returns the next round key of the AES key schedule from 'previous', the
+// round key Nk words earlier, and the output of AESKEYGENASSIST, whose
+// relevant word is selected by 'kShuffle'.
+template <int kShuffle>
+__m128i NextRoundKey(__m128i previous, __m128i assist) {
+  assist = _mm_shuffle_epi32(assist, kShuffle);
+  __m128i shifted = _mm_slli_si128(previous, 4);
+  previous = _mm_xor_si128(previous, shifted);
+  shifted = _mm_slli_si128(shifted, 4);
+  previous = _mm_xor_si128(previous, shifted);
+  shifted = _mm_slli_si128(shifted, 4);
+  previous = _mm_xor_si128(previous, shifted);
+  return _mm_xor_si128(previous, assist);
+}
+
+void ExpandAes128Key(const uint8_t* key, __m128i* round_keys) {
+  round_keys[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+#define TINK_AES128_ROUND(i, rcon)                        \
+  round_keys[i] = NextRoundKey<0xff>(                     \
+      round_keys[i - 1],                                  \
+      _mm_aeskeygenassist_si128(round_keys[i - 1], rcon))
+  TINK_AES128_ROUND(1, 0x01);
+  TINK_AES128_ROUND(2, 0x02);
+  TINK_AES128_ROUND(3, 0x04);
+  TINK_AES128_ROUND(4, 0x08);
+  TINK_AES128_ROUND(5, 0x10);
+  TINK_AES128_ROUND(6, 0x20);
+  TINK_AES128_ROUND(7, 0x40);
+  TINK_AES128_ROUND(8, 0x80);
+  TINK_AES128_ROUND(9, 0x1b);
+  TINK_AES128_ROUND(10, 0x36);
+#undef TINK_AES128_ROUND
+}
+
+void ExpandAes256Key(const uint8_t* key, __m128i* round_keys) {
+  round_keys[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key));
+  round_keys[1] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(key + 16));
+  // Even round keys use RotWord, SubWord and the round constant; odd ones
+  // only SubWord.
+#define TINK_AES256_ROUNDS(i, rcon)                                        \
+  round_keys[i] = NextRoundKey<0xff>(                                      \
+      round_keys[i - 2], _mm_aeskeygenassist_si128(round_keys[i - 1], rcon)); \
+  if (i + 1 < 15) {                                                        \
+    round_keys[i + 1] = NextRoundKey<0xaa>(                                \
+        round_keys[i - 1], _mm_aeskeygenassist_si128(round_keys[i], 0x00)); \
+  }
+  TINK_AES256_ROUNDS(2, 0x01);
+  TINK_AES256_ROUNDS(4, 0x02);
+  TINK_AES256_ROUNDS(6, 0x04);
+  TINK_AES256_ROUNDS(8, 0x08);
+  TINK_AES256_ROUNDS(10, 0x10);
+  TINK_AES256_ROUNDS(12, 0x20);
+  TINK_AES256_ROUNDS(14, 0x40);
+#undef TINK_AES256_ROUNDS
+}
+
+// Reverses the bytes of each 128-bit lane.
+const __m128i kReverseBytes =
+    _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+// The key in the form used by the kernels.
+struct Key {
+  int rounds;
+  // Each round key in both lanes.
+  __m256i round_keys[15];
+  // The powers H^(kGhashStride - i) of the GHASH key H in both lanes.
+  __m256i hash_key_powers[kGhashStride];
+};
+
+// Encrypts the kAesBlocks blocks in 'blocks' in place. The registers are
+// spelled out, so that they are kept in registers between the rounds.
+inline void EncryptBlocks(const Key& key, __m256i* blocks) {
+  __m256i round_key = key.round_keys[0];
+  __m256i b0 = _mm256_xor_si256(blocks[0], round_key);
+  __m256i b1 = _mm256_xor_si256(blocks[1], round_key);
+  __m256i b2 = _mm256_xor_si256(blocks[2], round_key);
+  __m256i b3 = _mm256_xor_si256(blocks[3], round_key);
+  for (int i = 1; i < key.rounds; i++) {
+    round_key = key.round_keys[i];
+    b0 = _mm256_aesenc_epi128(b0, round_key);
+    b1 = _mm256_aesenc_epi128(b1, round_key);
+    b2 = _mm256_aesenc_epi128(b2, round_key);
+    b3 = _mm256_aesenc_epi128(b3, round_key);
+  }
+  round_key = key.round_keys[key.rounds];
+  blocks[0] = _mm256_aesenclast_epi128(b0, round_key);
+  blocks[1] = _mm256_aesenclast_epi128(b1, round_key);
+  blocks[2] = _mm256_aesenclast_epi128(b2, round_key);
+  blocks[3] = _mm256_aesenclast_epi128(b3, round_key);
+}
+
+// Carry-less multiplication and reduction of the GHASH field elements in
+// each 128-bit lane, whose bytes are reversed, following Algorithm 5 of Gueron
+// and Kounavis, "Intel Carry-Less Multiplication Instruction and its Usage for
+// Computing the GCM Mode". The products of several multiplications are added
+// before they are reduced.
+struct Product {
+  __m256i lo = _mm256_setzero_si256();
+  __m256i mid = _mm256_setzero_si256();
+  __m256i hi = _mm256_setzero_si256();
+};
+
+// Adds the unreduced product of 'a' and 'b' to 'product'.
+inline void MultiplyAdd(__m256i a, __m256i b, Product* product) {
+  product->lo =
+      _mm256_xor_si256(product->lo, _mm256_clmulepi64_epi128(a, b, 0x00));
+  product->mid = _mm256_xor_si256(
+      product->mid, _mm256_xor_si256(_mm256_clmulepi64_epi128(a, b, 0x10),
+                                     _mm256_clmulepi64_epi128(a, b, 0x01)));
+  product->hi =
+      _mm256_xor_si256(product->hi, _mm256_clmulepi64_epi128(a, b, 0x11));
+}
+
+inline __m256i Reduce(const Product& product) {
+  __m256i lo = _mm256_xor_si256(product.lo, _mm256_bslli_epi128(product.mid, 8));
+  __m256i hi = _mm256_xor_si256(product.hi, _mm256_bsrli_epi128(product.mid, 8));
+
+  // Shifts the 256-bit product hi:lo left by one bit, since the bits of the
+  // field elements are reflected.
+  __m256i lo_carry = _mm256_srli_epi32(lo, 31);
+  __m256i hi_carry = _mm256_srli_epi32(hi, 31);
+  lo = _mm256_slli_epi32(lo, 1);
+  hi = _mm256_slli_epi32(hi, 1);
+  __m256i cross_carry = _mm256_bsrli_epi128(lo_carry, 12);
+  lo = _mm256_or_si256(lo, _mm256_bslli_epi128(lo_carry, 4));
+  hi = _mm256_or_si256(hi, _mm256_bslli_epi128(hi_carry, 4));
+  hi = _mm256_or_si256(hi, cross_carry);
+
+  // Reduces modulo x^128 + x^7 + x^2 + x + 1.
+  __m256i t = _mm256_xor_si256(
+      _mm256_xor_si256(_mm256_slli_epi32(lo, 31), _mm256_slli_epi32(lo, 30)),
+      _mm256_slli_epi32(lo, 25));
+  lo = _mm256_xor_si256(lo, _mm256_bslli_epi128(t, 12));
+  __m256i u = _mm256_xor_si256(
+      _mm256_xor_si256(_mm256_srli_epi32(lo, 1), _mm256_srli_epi32(lo, 2)),
+      _mm256_xor_si256(_mm256_srli_epi32(lo, 7), _mm256_bsrli_epi128(t, 4)));
+  return _mm256_xor_si256(hi, _mm256_xor_si256(lo, u));
+}
+
+inline __m256i GfMul(__m256i a, __m256i b) {
+  Product product;
+  MultiplyAdd(a, b, &product);
+  return Reduce(product);
+}
+
+inline __m256i Combine(__m128i lo, __m128i hi) {
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+// Returns the counter block 'counter' for 'iv'.
+inline __m128i CounterBlock(__m128i iv_block, uint32_t counter) {
+  return _mm_insert_epi32(iv_block, __builtin_bswap32(counter), 3);
+}
+
+// Blocks waiting to be encrypted by CtrEncrypt().
+class PendingBlocks {
+ public:
+  explicit PendingBlocks(const Key& key) : key_(key), count_(0) {}
+
+  // Adds a counter block whose encryption is XORed with the 'size' bytes at
+  // 'in' into 'out', or copied to 'out' if 'in' is null.
+  void Add(__m128i counter_block, const uint8_t* in, uint8_t* out,
+           size_t size) {
+    counter_blocks_[count_] = counter_block;
+    blocks_[count_] = {in, out, size};
+    if (++count_ == kAesBlocks) Flush();
+  }
+
+  void Flush() {
+    if (count_ == 0) return;
+    __m256i data[kAesBlocks / 2];
+    for (int j = 0; j < kAesBlocks / 2; j++) {
+      data[j] = Combine(counter_blocks_[2 * j], counter_blocks_[2 * j + 1]);
+    }
+    EncryptBlocks(key_, data);
+    uint8_t key_stream[kAesBlocks][kBlockSize];
+    for (int j = 0; j < kAesBlocks / 2; j++) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(key_stream[2 * j]),
+                          data[j]);
+    }
+    for (int j = 0; j < count_; j++) {
+      const Block& block = blocks_[j];
+      if (block.in == nullptr) {
+        std::memcpy(block.out, key_stream[j], block.size);
+      } else if (block.size == kBlockSize) {
+        __m128i in =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.in));
+        __m128i stream =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(key_stream[j]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(block.out),
+                         _mm_xor_si128(in, stream));
+      } else {
+        for (size_t k = 0; k < block.size; k++) {
+          block.out[k] = block.in[k] ^ key_stream[j][k];
+        }
+      }
+    }
+    count_ = 0;
+  }
+
+ private:
+  struct Block {
+    const uint8_t* in;
+    uint8_t* out;
+    size_t size;
+  };
+
+  const Key& key_;
+  int count_;
+  __m128i counter_blocks_[kAesBlocks];
+  Block blocks_[kAesBlocks];
+};
+
+// Encrypts or decrypts the messages in CTR mode, and stores the encryption
+// of the first counter block of message i, which masks its tag, at
+// tag_masks + 16 * i.
+void CtrEncrypt(const Key& key, const std::vector<Message>& messages,
+                uint8_t* tag_masks) {
+  PendingBlocks pending(key);
+  for (size_t i = 0; i < messages.size(); i++) {
+    const Message& message = messages[i];
+    uint8_t iv[kBlockSize] = {0};
+    std::memcpy(iv, message.iv, AesGcmMultiBuffer::kIvSize);
+    __m128i iv_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iv));
+    pending.Add(CounterBlock(iv_block, 1), nullptr,
+                tag_masks + kBlockSize * i, kBlockSize);
+    uint32_t counter = 2;
+    size_t offset = 0;
+    // Runs of kAesBlocks full blocks are encrypted right away.
+    for (; message.size - offset >= kAesBlocks * kBlockSize;
+         offset += kAesBlocks * kBlockSize, counter += kAesBlocks) {
+      __m256i blocks[kAesBlocks / 2];
+      for (int j = 0; j < kAesBlocks / 2; j++) {
+        blocks[j] = Combine(CounterBlock(iv_block, counter + 2 * j),
+                            CounterBlock(iv_block, counter + 2 * j + 1));
+      }
+      EncryptBlocks(key, blocks);
+      for (int j = 0; j < kAesBlocks / 2; j++) {
+        size_t block_offset = offset + 2 * j * kBlockSize;
+        __m256i in = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(message.in + block_offset));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(message.out + block_offset),
+            _mm256_xor_si256(in, blocks[j]));
+      }
+    }
+    for (; offset < message.size; offset += kBlockSize, counter++) {
+      pending.Add(CounterBlock(iv_block, counter), message.in + offset,
+                  message.out + offset,
+                  std::min(kBlockSize, message.size - offset));
+    }
+  }
+  pending.Flush();
+}
+
+// The number of GHASH input blocks of 'message': the padded associated
+// data, the padded ciphertext and the lengths.
+size_t GhashBlocks(const Message& message) {
+  return Blocks(message.associated_data_size) + Blocks(message.size) + 1;
+}
+
+void StoreBigEndian64(uint64_t value, uint8_t* out) {
+  for (int i = 7; i >= 0; i--) {
+    out[i] = value & 0xff;
+    value >>= 8;
+  }
+}
+
+// Writes the GHASH input blocks of 'message' to out, out + stride, etc.
+void WriteGhashInput(const Message& message, uint8_t* out, size_t stride) {
+  const uint8_t* parts[2] = {message.associated_data, message.ciphertext};
+  const size_t part_sizes[2] = {message.associated_data_size, message.size};
+  for (int part = 0; part < 2; part++) {
+    for (size_t offset = 0; offset < part_sizes[part]; offset += kBlockSize) {
+      size_t size = std::min(kBlockSize, part_sizes[part] - offset);
+      std::memcpy(out, parts[part] + offset, size);
+      std::memset(out + size, 0, kBlockSize - size);
+      out += stride;
+    }
+  }
+  StoreBigEndian64(message.associated_data_size * 8, out);
+  StoreBigEndian64(message.size * 8, out + 8);
+}
+
+// Returns the hash of two lanes after the kGhashStride rows of input blocks
+// at 'rows', from their hash 'hash' before them, as
+// (hash + X_1) * H^4 + X_2 * H^3 + X_3 * H^2 + X_4 * H.
+inline __m256i HashBlocks(const Key& key, __m256i hash, const uint8_t* rows) {
+  const __m256i reverse_bytes = _mm256_broadcastsi128_si256(kReverseBytes);
+  Product product;
+  for (int i = 0; i < kGhashStride; i++) {
+    __m256i input = _mm256_shuffle_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+            rows + i * kGhashLanes * kBlockSize)),
+        reverse_bytes);
+    if (i == 0) input = _mm256_xor_si256(input, hash);
+    MultiplyAdd(input, key.hash_key_powers[i], &product);
+  }
+  return Reduce(product);
+}
+
+// Computes the GHASH of the messages and stores the one of message i at
+// hashes + 16 * i.
+//
+// The messages are sorted by length and hashed in groups of kGhashLanes, one
+// message per lane. GHASH(X) = GHASH(0 || X), so shorter messages of a group
+// are padded with zero blocks at the front and all lanes finish together. The
+// padded inputs of a group are copied into rows of one block per lane first,
+// so that the loop over the blocks only loads and multiplies.
+void Ghash(const Key& key, const std::vector<Message>& messages,
+           uint8_t* hashes) {
+  std::vector<size_t> blocks(messages.size());
+  std::vector<size_t> order(messages.size());
+  for (size_t i = 0; i < messages.size(); i++) {
+    blocks[i] = GhashBlocks(messages[i]);
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&blocks](size_t a, size_t b) {
+    return blocks[a] < blocks[b];
+  });
+
+  // The input blocks of a group, one row of kGhashLanes blocks per step.
+  const size_t row_size = kGhashLanes * kBlockSize;
+  std::vector<uint8_t> input;
+  for (size_t first = 0; first < order.size(); first += kGhashLanes) {
+    const size_t lanes = std::min<size_t>(kGhashLanes, order.size() - first);
+    const size_t* group = &order[first];
+    // A multiple of kGhashStride.
+    const size_t group_blocks =
+        (blocks[group[lanes - 1]] + kGhashStride - 1) / kGhashStride *
+        kGhashStride;
+    input.assign(group_blocks * row_size, 0);
+    for (size_t lane = 0; lane < lanes; lane++) {
+      WriteGhashInput(
+          messages[group[lane]],
+          &input[(group_blocks - blocks[group[lane]]) * row_size +
+                 lane * kBlockSize],
+          row_size);
+    }
+
+    // The hashes of lanes 2j and 2j + 1 are in hash_j.
+    __m256i hash0 = _mm256_setzero_si256();
+    __m256i hash1 = _mm256_setzero_si256();
+    __m256i hash2 = _mm256_setzero_si256();
+    __m256i hash3 = _mm256_setzero_si256();
+    for (size_t step = 0; step < group_blocks; step += kGhashStride) {
+      const uint8_t* rows = &input[step * row_size];
+      hash0 = HashBlocks(key, hash0, rows);
+      hash1 = HashBlocks(key, hash1, rows + 2 * kBlockSize);
+      hash2 = HashBlocks(key, hash2, rows + 4 * kBlockSize);
+      hash3 = HashBlocks(key, hash3, rows + 6 * kBlockSize);
+    }
+    const __m256i hash[kGhashLanes / 2] = {hash0, hash1, hash2, hash3};
+    for (size_t lane = 0; lane < lanes; lane++) {
+      __m256i pair = hash[lane / 2];
+      __m128i value = lane % 2 == 0 ? _mm256_castsi256_si128(pair)
+                                    : _mm256_extracti128_si256(pair, 1);
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(hashes + kBlockSize * group[lane]),
+          _mm_shuffle_epi8(value, kReverseBytes));
+    }
+  }
+}
+
+Key LoadKey(int rounds, const uint8_t (*round_keys)[16],
+            const uint8_t* hash_key) {
+  Key key;
+  key.rounds = rounds;
+  for (int i = 0; i <= rounds; i++) {
+    key.round_keys[i] = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(round_keys[i])));
+  }
+  __m256i power = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(hash_key)));
+  key.hash_key_powers[kGhashStride - 1] = power;
+  for (int i = kGhashStride - 2; i >= 0; i--) {
+    power = GfMul(power, key.hash_key_powers[kGhashStride - 1]);
+    key.hash_key_powers[i] = power;
+  }
+  return key;
+}
+
+#endif  // TINK_AES_GCM_MULTI_BUFFER_VAES
+
+// Computes the tags of 'messages' into 'tags', 16 bytes each, and encrypts
+// or decrypts them.
+void Process(int rounds, const uint8_t (*round_keys)[16],
+             const uint8_t* hash_key, const std::vector<Message>& messages,
+             uint8_t* tags) {
+#if defined(TINK_AES_GCM_MULTI_BUFFER_VAES)
+  Key key = LoadKey(rounds, round_keys, hash_key);
+  std::vector<uint8_t> tag_masks(kBlockSize * messages.size());
+  CtrEncrypt(key, messages, tag_masks.data());
+  Ghash(key, messages, tags);
+  for (size_t i = 0; i < tag_masks.size(); i++) tags[i] ^= tag_masks[i];
+  OPENSSL_cleanse(&key, sizeof(key));
+#endif
+}
+
+}  // namespace
+
+std::unique_ptr<AesGcmMultiBuffer> AesGcmMultiBuffer::New(
+    const util::SecretData& key) {
+  if (!IsAvailable() || (key.size() != 16 && key.size() != 32)) {
+    return nullptr;
+  }
+  auto aes_gcm = absl::WrapUnique(new AesGcmMultiBuffer());
+#if defined(TINK_AES_GCM_MULTI_BUFFER_VAES)
+  __m128i round_keys[15];
+  if (key.size() == 16) {
+    aes_gcm->rounds_ = 10;
+    ExpandAes128Key(key.data(), round_keys);
+  } else {
+    aes_gcm->rounds_ = 14;
+    ExpandAes256Key(key.data(), round_keys);
+  }
+  for (int i = 0; i <= aes_gcm->rounds_; i++) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(aes_gcm->round_keys_[i]),
+                     round_keys[i]);
+  }
+  __m128i hash_key = _mm_xor_si128(_mm_setzero_si128(), round_keys[0]);
+  for (int i = 1; i < aes_gcm->rounds_; i++) {
+    hash_key = _mm_aesenc_si128(hash_key, round_keys[i]);
+  }
+  hash_key = _mm_aesenclast_si128(hash_key, round_keys[aes_gcm->rounds_]);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(aes_gcm->hash_key_),
+                   _mm_shuffle_epi8(hash_key, kReverseBytes));
+  OPENSSL_cleanse(round_keys, sizeof(round_keys));
+#endif
+  return aes_gcm;
+}
+
+absl::string_view AesGcmMultiBuffer::Implementation() {
+  return IsAvailable() ? "VAES" : "";
+}
+
+AesGcmMultiBuffer::~AesGcmMultiBuffer() {
+  OPENSSL_cleanse(round_keys_, sizeof(round_keys_));
+  OPENSSL_cleanse(hash_key_, sizeof(hash_key_));
+}
+
+void AesGcmMultiBuffer::Seal(
+    absl::Span<const absl::string_view> plaintexts,
+    absl::Span<const absl::string_view> associated_data,
+    absl::Span<uint8_t* const> ciphertexts) const {
+  std::vector<Message> messages(plaintexts.size());
+  for (size_t i = 0; i < plaintexts.size(); i++) {
+    Message& message = messages[i];
+    message.iv = ciphertexts[i];
+    message.associated_data =
+        reinterpret_cast<const uint8_t*>(associated_data[i].data());
+    message.associated_data_size = associated_data[i].size();
+    message.in = reinterpret_cast<const uint8_t*>(plaintexts[i].data());
+    message.out = ciphertexts[i] + kIvSize;
+    message.size = plaintexts[i].size();
+    message.ciphertext = message.out;
+  }
+  std::vector<uint8_t> tags(kTagSize * messages.size());
+  Process(rounds_, round_keys_, hash_key_, messages, tags.data());
+  for (size_t i = 0; i < messages.size(); i++) {
+    std::memcpy(messages[i].out + messages[i].size, &tags[kTagSize * i],
+                kTagSize);
+  }
+}
+
+bool AesGcmMultiBuffer::Open(
+    absl::Span<const absl::string_view> ciphertexts,
+    absl::Span<const absl::string_view> associated_data,
+    absl::Span<uint8_t* const> plaintexts) const {
+  std::vector<Message> messages(ciphertexts.size());
+  for (size_t i = 0; i < ciphertexts.size(); i++) {
+    Message& message = messages[i];
+    const uint8_t* ciphertext =
+        reinterpret_cast<const uint8_t*>(ciphertexts[i].data());
+    message.iv = ciphertext;
+    message.associated_data =
+        reinterpret_cast<const uint8_t*>(associated_data[i].data());
+    message.associated_data_size = associated_data[i].size();
+    message.in = ciphertext + kIvSize;
+    message.out = plaintexts[i];
+    message.size = ciphertexts[i].size() - kIvSize - kTagSize;
+    message.ciphertext = message.in;
+  }
+  std::vector<uint8_t> tags(kTagSize * messages.size());
+  Process(rounds_, round_keys_, hash_key_, messages, tags.data());
+  bool ok = true;
+  for (size_t i = 0; i < messages.size(); i++) {
+    ok &= CRYPTO_memcmp(&tags[kTagSize * i],
+                        messages[i].in + messages[i].size, kTagSize) == 0;
+  }
+  return ok;
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
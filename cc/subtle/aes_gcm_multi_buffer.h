@@ -0,0 +1,97 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_SUBTLE_AES_GCM_MULTI_BUFFER_H_
+#define TINK_SUBTLE_AES_GCM_MULTI_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/util/secret_data.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// AES-GCM for batches of small messages under one key, producing the same
+// ciphertexts as AesGcmBoringSsl, i.e. (iv || ciphertext || tag) with a
+// 12-byte IV and a 16-byte tag.
+//
+// A small message is only a few AES blocks, too few to fill the AES pipeline,
+// and its GHASH is a chain of dependent multiplications. Hence the counter
+// blocks of all messages are encrypted together, 8 at a time with the vector
+// AES instructions (VAES), and the GHASH of 8 messages is computed at once in
+// the 128-bit lanes of vector registers (VPCLMULQDQ).
+//
+// The implementation is only compiled in when the target supports these
+// instructions, e.g. with --copt=-maes --copt=-mavx2 --copt=-mvaes
+// --copt=-mvpclmulqdq, and used when the CPU supports them at run time (see
+// cpu_features.h).
+//
+// This class is thread-safe.
+class AesGcmMultiBuffer {
+ public:
+  static constexpr size_t kIvSize = 12;
+  static constexpr size_t kTagSize = 16;
+
+  // Returns an instance keyed with 'key', which must be 16 or 32 bytes long,
+  // or nullptr if no implementation is available or the key size is invalid.
+  static std::unique_ptr<AesGcmMultiBuffer> New(const util::SecretData& key);
+
+  // Returns the name of the implementation New() uses, e.g. "VAES", or an
+  // empty string if there is none.
+  static absl::string_view Implementation();
+
+  AesGcmMultiBuffer(const AesGcmMultiBuffer&) = delete;
+  AesGcmMultiBuffer& operator=(const AesGcmMultiBuffer&) = delete;
+  ~AesGcmMultiBuffer();
+
+  // Encrypts each of 'plaintexts' with the corresponding entry of
+  // 'associated_data'. ciphertexts[i] must point to kIvSize +
+  // plaintexts[i].size() + kTagSize bytes which start with the IV to use; the
+  // rest is overwritten with the ciphertext and the tag.
+  void Seal(absl::Span<const absl::string_view> plaintexts,
+            absl::Span<const absl::string_view> associated_data,
+            absl::Span<uint8_t* const> ciphertexts) const;
+
+  // Decrypts each of 'ciphertexts', which must be at least kIvSize + kTagSize
+  // bytes long, with the corresponding entry of 'associated_data' into
+  // plaintexts[i], which must hold ciphertexts[i].size() - kIvSize - kTagSize
+  // bytes. Returns false if any of the tags does not match, in which case the
+  // plaintexts must not be used.
+  bool Open(absl::Span<const absl::string_view> ciphertexts,
+            absl::Span<const absl::string_view> associated_data,
+            absl::Span<uint8_t* const> plaintexts) const;
+
+ private:
+  AesGcmMultiBuffer() {}
+
+  int rounds_;
+  // The AES round keys, rounds_ + 1 of them.
+  uint8_t round_keys_[15][16];
+  // The GHASH key E(0), with its bytes reversed.
+  uint8_t hash_key_[16];
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_AES_GCM_MULTI_BUFFER_H_
@@ -0,0 +1,177 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/aes_gcm_multi_buffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "openssl/aead.h"
+#include "tink/subtle/cpu_features.h"
+#include "tink/subtle/random.h"
+#include "tink/util/secret_data.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+constexpr size_t kIvSize = AesGcmMultiBuffer::kIvSize;
+constexpr size_t kTagSize = AesGcmMultiBuffer::kTagSize;
+
+// Returns (iv || ciphertext || tag) as computed by BoringSSL.
+std::string ReferenceSeal(const util::SecretData& key, absl::string_view iv,
+                          absl::string_view plaintext,
+                          absl::string_view associated_data) {
+  const EVP_AEAD* aead =
+      key.size() == 16 ? EVP_aead_aes_128_gcm() : EVP_aead_aes_256_gcm();
+  bssl::UniquePtr<EVP_AEAD_CTX> ctx(EVP_AEAD_CTX_new(
+      aead, key.data(), key.size(), EVP_AEAD_DEFAULT_TAG_LENGTH));
+  std::vector<uint8_t> out(plaintext.size() + kTagSize);
+  size_t out_size;
+  uint8_t empty = 0;
+  EXPECT_EQ(1, EVP_AEAD_CTX_seal(
+                   ctx.get(), out.data(), &out_size, out.size(),
+                   reinterpret_cast<const uint8_t*>(iv.data()), iv.size(),
+                   plaintext.empty()
+                       ? &empty
+                       : reinterpret_cast<const uint8_t*>(plaintext.data()),
+                   plaintext.size(),
+                   associated_data.empty()
+                       ? &empty
+                       : reinterpret_cast<const uint8_t*>(
+                             associated_data.data()),
+                   associated_data.size()));
+  return std::string(iv) +
+         std::string(reinterpret_cast<const char*>(out.data()), out_size);
+}
+
+class AesGcmMultiBufferTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (AesGcmMultiBuffer::Implementation().empty()) {
+      GTEST_SKIP() << "No multi-buffer implementation available";
+    }
+  }
+};
+
+// Checks messages of all lengths up to a few blocks, with associated data of
+// several lengths, in batches of several sizes against BoringSSL.
+TEST_F(AesGcmMultiBufferTest, MatchesReference) {
+  for (size_t key_size : {16, 32}) {
+    util::SecretData key = Random::GetRandomKeyBytes(key_size);
+    auto aes_gcm = AesGcmMultiBuffer::New(key);
+    ASSERT_NE(aes_gcm, nullptr);
+
+    std::vector<std::string> plaintexts;
+    std::vector<std::string> associated_data;
+    for (int size = 0; size <= 150; size++) {
+      plaintexts.push_back(Random::GetRandomBytes(size));
+      associated_data.push_back(Random::GetRandomBytes((size * 7) % 41));
+    }
+    plaintexts.push_back(Random::GetRandomBytes(5000));
+    associated_data.push_back("");
+    for (size_t batch_size : {size_t{1}, size_t{5}, plaintexts.size()}) {
+      std::vector<absl::string_view> batch(plaintexts.begin(),
+                                           plaintexts.begin() + batch_size);
+      std::vector<absl::string_view> batch_associated_data(
+          associated_data.begin(), associated_data.begin() + batch_size);
+      std::vector<std::string> ciphertexts(batch_size);
+      std::vector<uint8_t*> outs(batch_size);
+      for (size_t i = 0; i < batch_size; i++) {
+        ciphertexts[i] = Random::GetRandomBytes(kIvSize);
+        ciphertexts[i].resize(kIvSize + batch[i].size() + kTagSize);
+        outs[i] = reinterpret_cast<uint8_t*>(&ciphertexts[i][0]);
+      }
+      aes_gcm->Seal(batch, batch_associated_data, outs);
+
+      std::vector<std::string> decrypted(batch_size);
+      std::vector<uint8_t*> plaintext_outs(batch_size);
+      for (size_t i = 0; i < batch_size; i++) {
+        EXPECT_EQ(ReferenceSeal(key, ciphertexts[i].substr(0, kIvSize),
+                                batch[i], batch_associated_data[i]),
+                  ciphertexts[i])
+            << "message size " << batch[i].size();
+        decrypted[i].resize(batch[i].size());
+        plaintext_outs[i] = reinterpret_cast<uint8_t*>(&decrypted[i][0]);
+      }
+      std::vector<absl::string_view> ciphertext_views(ciphertexts.begin(),
+                                                      ciphertexts.end());
+      EXPECT_TRUE(aes_gcm->Open(ciphertext_views, batch_associated_data,
+                                plaintext_outs));
+      for (size_t i = 0; i < batch_size; i++) {
+        EXPECT_EQ(batch[i], decrypted[i]);
+      }
+    }
+  }
+}
+
+TEST_F(AesGcmMultiBufferTest, OpenFailsIfAnyTagIsWrong) {
+  util::SecretData key = Random::GetRandomKeyBytes(16);
+  auto aes_gcm = AesGcmMultiBuffer::New(key);
+  ASSERT_NE(aes_gcm, nullptr);
+  std::vector<std::string> ciphertexts;
+  for (int i = 0; i < 10; i++) {
+    ciphertexts.push_back(ReferenceSeal(key, Random::GetRandomBytes(kIvSize),
+                                        "plaintext", "associated data"));
+  }
+  std::vector<absl::string_view> associated_data(10, "associated data");
+  std::string plaintexts(10 * 9, '\0');
+  std::vector<uint8_t*> outs;
+  for (int i = 0; i < 10; i++) {
+    outs.push_back(reinterpret_cast<uint8_t*>(&plaintexts[9 * i]));
+  }
+  std::vector<absl::string_view> views(ciphertexts.begin(), ciphertexts.end());
+  ASSERT_TRUE(aes_gcm->Open(views, associated_data, outs));
+
+  for (size_t position : {size_t{0}, kIvSize, ciphertexts[7].size() - 1}) {
+    std::string modified = ciphertexts[7];
+    modified[position] ^= 1;
+    views[7] = modified;
+    EXPECT_FALSE(aes_gcm->Open(views, associated_data, outs));
+  }
+  views[7] = ciphertexts[7];
+  associated_data[3] = "other associated data";
+  EXPECT_FALSE(aes_gcm->Open(views, associated_data, outs));
+}
+
+TEST_F(AesGcmMultiBufferTest, EmptyBatch) {
+  auto aes_gcm = AesGcmMultiBuffer::New(Random::GetRandomKeyBytes(32));
+  ASSERT_NE(aes_gcm, nullptr);
+  aes_gcm->Seal({}, {}, {});
+  EXPECT_TRUE(aes_gcm->Open({}, {}, {}));
+}
+
+TEST_F(AesGcmMultiBufferTest, InvalidKeySize) {
+  EXPECT_EQ(AesGcmMultiBuffer::New(Random::GetRandomKeyBytes(24)), nullptr);
+}
+
+TEST(AesGcmMultiBufferWithoutCpuFeaturesTest, NotAvailable) {
+  SetCpuFeatureDisabled(CpuFeature::kVaes, true);
+  EXPECT_EQ(AesGcmMultiBuffer::Implementation(), "");
+  EXPECT_EQ(AesGcmMultiBuffer::New(Random::GetRandomKeyBytes(16)), nullptr);
+  SetCpuFeatureDisabled(CpuFeature::kVaes, false);
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,363 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/aes_gcm_parallel_boringssl.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "openssl/aead.h"
+#include "openssl/cipher.h"
+#include "openssl/crypto.h"
+#include "tink/config/tink_fips.h"
+#include "tink/subtle/aes_gcm_boringssl.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/subtle_util.h"
+#include "tink/subtle/subtle_util_boringssl.h"
+#include "tink/util/executor.h"
+#include "tink/util/status.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+namespace {
+
+// GCM allows at most 2^32 - 2 blocks of plaintext.
+constexpr uint64_t kMaxPlaintextSize = (uint64_t{1} << 36) - 32;
+
+// The nonce used with the GHASH context.
+constexpr uint8_t kZeroNonce[12] = {0};
+
+uint64_t LoadBigEndian64(const uint8_t* in) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; i++) value = (value << 8) | in[i];
+  return value;
+}
+
+void StoreBigEndian64(uint64_t value, uint8_t* out) {
+  for (int i = 7; i >= 0; i--) {
+    out[i] = value & 0xff;
+    value >>= 8;
+  }
+}
+
+}  // namespace
+
+// static
+util::StatusOr<std::unique_ptr<Aead>> AesGcmParallelBoringSsl::New(
+    const util::SecretData& key, int num_threads, int64_t min_parallel_size,
+    util::Executor* executor) {
+  auto status = CheckFipsCompatibility<AesGcmParallelBoringSsl>();
+  if (!status.ok()) return status;
+  if (num_threads < 1) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "num_threads must be positive");
+  }
+
+  const EVP_AEAD* aead =
+      SubtleUtilBoringSSL::GetAesGcmAeadForKeySize(key.size());
+  const EVP_CIPHER* ctr_cipher =
+      SubtleUtilBoringSSL::GetAesCtrCipherForKeySize(key.size());
+  if (aead == nullptr || ctr_cipher == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid key size");
+  }
+  auto aes_gcm_result = AesGcmBoringSsl::New(key);
+  if (!aes_gcm_result.ok()) return aes_gcm_result.status();
+  bssl::UniquePtr<EVP_AEAD_CTX> ghash_ctx(EVP_AEAD_CTX_new(
+      aead, key.data(), key.size(), EVP_AEAD_DEFAULT_TAG_LENGTH));
+  if (!ghash_ctx) {
+    return util::Status(util::error::INTERNAL,
+                        "could not initialize EVP_AEAD_CTX");
+  }
+  bssl::UniquePtr<EVP_CIPHER_CTX> keyed_ctr_ctx(EVP_CIPHER_CTX_new());
+  if (keyed_ctr_ctx.get() == nullptr ||
+      EVP_EncryptInit_ex(keyed_ctr_ctx.get(), ctr_cipher, nullptr /* engine */,
+                         key.data(), nullptr /* iv */) != 1) {
+    return util::Status(util::error::INTERNAL,
+                        "could not initialize EVP_CIPHER_CTX");
+  }
+  auto result = absl::WrapUnique(new AesGcmParallelBoringSsl(
+      std::move(aes_gcm_result.ValueOrDie()), std::move(ghash_ctx),
+      std::move(keyed_ctr_ctx), num_threads, min_parallel_size,
+      executor));
+
+  // H is the encryption of the zero block, and the mask of the GHASH
+  // context that of the counter block 0^96 || 1.
+  const uint8_t zeros[kBlockSize] = {0};
+  uint8_t block[kBlockSize];
+  absl::string_view zero_nonce(reinterpret_cast<const char*>(kZeroNonce),
+                               sizeof(kZeroNonce));
+  status = result->Ctr(zero_nonce, 0, zeros, block, kBlockSize);
+  if (!status.ok()) return status;
+  result->h_ = {LoadBigEndian64(block), LoadBigEndian64(block + 8)};
+  status = result->Ctr(zero_nonce, 1, zeros, block, kBlockSize);
+  if (!status.ok()) return status;
+  result->ghash_mask_ = {LoadBigEndian64(block), LoadBigEndian64(block + 8)};
+  OPENSSL_cleanse(block, sizeof(block));
+  result->h_chunk_ = result->PowerOfH(kChunkSize / kBlockSize);
+  result->chunk_length_h_ =
+      Multiply({uint64_t{8} * kChunkSize, 0}, result->h_);
+  return {std::move(result)};
+}
+
+// Multiplication in GF(2^128) with the bit order of GCM, see NIST SP 800-38D,
+// section 6.3. Runs in constant time.
+// static
+AesGcmParallelBoringSsl::FieldElement AesGcmParallelBoringSsl::Multiply(
+    FieldElement x, FieldElement y) {
+  FieldElement z = {0, 0};
+  FieldElement v = y;
+  for (int i = 0; i < 128; i++) {
+    uint64_t bit = (i < 64 ? x.hi >> (63 - i) : x.lo >> (127 - i)) & 1;
+    uint64_t mask = 0 - bit;
+    z.hi ^= v.hi & mask;
+    z.lo ^= v.lo & mask;
+    uint64_t carry = 0 - (v.lo & 1);
+    v.lo = (v.lo >> 1) | (v.hi << 63);
+    v.hi = (v.hi >> 1) ^ (carry & 0xe100000000000000);
+  }
+  return z;
+}
+
+AesGcmParallelBoringSsl::FieldElement AesGcmParallelBoringSsl::PowerOfH(
+    int64_t exponent) const {
+  FieldElement result = {uint64_t{1} << 63, 0};
+  FieldElement power = h_;
+  for (; exponent > 0; exponent >>= 1) {
+    if (exponent & 1) result = Multiply(result, power);
+    power = Multiply(power, power);
+  }
+  return result;
+}
+
+util::Status AesGcmParallelBoringSsl::Ctr(absl::string_view iv,
+                                          uint32_t counter, const uint8_t* in,
+                                          uint8_t* out, size_t size) const {
+  uint8_t counter_block[kBlockSize];
+  std::memcpy(counter_block, iv.data(), kIvSizeInBytes);
+  for (int i = kBlockSize - 1; i >= kIvSizeInBytes; i--) {
+    counter_block[i] = counter & 0xff;
+    counter >>= 8;
+  }
+  bssl::ScopedEVP_CIPHER_CTX ctx;
+  int len;
+  if (EVP_CIPHER_CTX_copy(ctx.get(), keyed_ctr_ctx_.get()) != 1 ||
+      EVP_EncryptInit_ex(ctx.get(), nullptr /* cipher */, nullptr /* engine */,
+                         nullptr /* key */, counter_block) != 1 ||
+      EVP_EncryptUpdate(ctx.get(), out, &len, in, size) != 1 ||
+      len != size) {
+    return util::Status(util::error::INTERNAL, "AES-CTR failed");
+  }
+  return util::OkStatus();
+}
+
+util::StatusOr<AesGcmParallelBoringSsl::FieldElement>
+AesGcmParallelBoringSsl::GhashTimesH(const uint8_t* data, size_t size) const {
+  // The tag for an empty message is ((GHASH(data) ^ L) * H) ^ ghash_mask_,
+  // where L is the length block of 'data'.
+  uint8_t tag[kTagSizeInBytes];
+  uint8_t empty;
+  size_t len;
+  if (EVP_AEAD_CTX_seal(ghash_ctx_.get(), tag, &len, sizeof(tag), kZeroNonce,
+                        sizeof(kZeroNonce), &empty, 0,
+                        size == 0 ? &empty : data, size) != 1) {
+    return util::Status(util::error::INTERNAL, "GHASH failed");
+  }
+  FieldElement length_h = size == kChunkSize
+                              ? chunk_length_h_
+                              : Multiply({uint64_t{8} * size, 0}, h_);
+  return FieldElement{
+      LoadBigEndian64(tag) ^ ghash_mask_.hi ^ length_h.hi,
+      LoadBigEndian64(tag + 8) ^ ghash_mask_.lo ^ length_h.lo};
+}
+
+util::StatusOr<AesGcmParallelBoringSsl::FieldElement>
+AesGcmParallelBoringSsl::CryptAndTag(absl::string_view iv,
+                                     absl::string_view additional_data,
+                                     const uint8_t* in, uint8_t* out,
+                                     size_t size, bool encrypt) const {
+  const int64_t num_chunks = (size + kChunkSize - 1) / kChunkSize;
+  std::vector<FieldElement> chunk_hashes(num_chunks);
+  std::atomic<bool> failed(false);
+  auto process_chunk = [&](int64_t i) {
+    const size_t offset = i * kChunkSize;
+    const size_t chunk_size = std::min<size_t>(kChunkSize, size - offset);
+    // The first counter block is used for the tag.
+    const uint32_t counter = 2 + offset / kBlockSize;
+    util::Status status;
+    if (encrypt) {
+      status = Ctr(iv, counter, in + offset, out + offset, chunk_size);
+    }
+    auto hash_result =
+        GhashTimesH(encrypt ? out + offset : in + offset, chunk_size);
+    if (!encrypt && status.ok()) {
+      status = Ctr(iv, counter, in + offset, out + offset, chunk_size);
+    }
+    if (!status.ok() || !hash_result.ok()) {
+      failed.store(true, std::memory_order_relaxed);
+      return;
+    }
+    chunk_hashes[i] = hash_result.ValueOrDie();
+  };
+  util::ParallelFor(num_chunks, num_threads_, process_chunk, executor_);
+  if (failed.load()) {
+    return util::Status(util::error::INTERNAL, "AES-GCM failed");
+  }
+
+  // GHASH(A || C) * H is the sum of GHASH(X_i) * H * H^(number of blocks
+  // following X_i) over the associated data and the chunks, which Horner's
+  // rule computes with one multiplication per chunk.
+  auto hash_result = GhashTimesH(
+      reinterpret_cast<const uint8_t*>(additional_data.data()),
+      additional_data.size());
+  if (!hash_result.ok()) return hash_result.status();
+  FieldElement hash = hash_result.ValueOrDie();
+  for (int64_t i = 0; i < num_chunks; i++) {
+    const size_t chunk_size =
+        std::min<size_t>(kChunkSize, size - i * kChunkSize);
+    hash = Multiply(hash, chunk_size == kChunkSize
+                              ? h_chunk_
+                              : PowerOfH((chunk_size + kBlockSize - 1) /
+                                         kBlockSize));
+    hash.hi ^= chunk_hashes[i].hi;
+    hash.lo ^= chunk_hashes[i].lo;
+  }
+  FieldElement length_h = Multiply(
+      {uint64_t{8} * additional_data.size(), uint64_t{8} * size}, h_);
+  hash.hi ^= length_h.hi;
+  hash.lo ^= length_h.lo;
+
+  // The tag is the hash masked with the encryption of the counter block 1.
+  const uint8_t zeros[kBlockSize] = {0};
+  uint8_t mask[kBlockSize];
+  auto status = Ctr(iv, 1, zeros, mask, kBlockSize);
+  if (!status.ok()) return status;
+  hash.hi ^= LoadBigEndian64(mask);
+  hash.lo ^= LoadBigEndian64(mask + 8);
+  return hash;
+}
+
+util::StatusOr<int64_t> AesGcmParallelBoringSsl::CiphertextSize(
+    int64_t plaintext_size) const {
+  return kIvSizeInBytes + plaintext_size + kTagSizeInBytes;
+}
+
+util::StatusOr<std::string> AesGcmParallelBoringSsl::Encrypt(
+    absl::string_view plaintext, absl::string_view additional_data) const {
+  std::string result;
+  ResizeStringUninitialized(
+      &result, kIvSizeInBytes + plaintext.size() + kTagSizeInBytes);
+  auto written = EncryptInto(plaintext, additional_data,
+                             absl::MakeSpan(&result[0], result.size()));
+  if (!written.ok()) return written.status();
+  return result;
+}
+
+util::StatusOr<int64_t> AesGcmParallelBoringSsl::EncryptInto(
+    absl::string_view plaintext, absl::string_view additional_data,
+    absl::Span<char> ciphertext_buffer) const {
+  if (plaintext.size() < min_parallel_size_) {
+    return aead_->EncryptInto(plaintext, additional_data, ciphertext_buffer);
+  }
+  const size_t ciphertext_size =
+      kIvSizeInBytes + plaintext.size() + kTagSizeInBytes;
+  if (ciphertext_buffer.size() < ciphertext_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_buffer is too small");
+  }
+  if (plaintext.size() > kMaxPlaintextSize) {
+    return util::Status(util::error::INVALID_ARGUMENT, "plaintext too long");
+  }
+  additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
+
+  Random::GetRandomNonceBytes(ciphertext_buffer.subspan(0, kIvSizeInBytes));
+  uint8_t* out = reinterpret_cast<uint8_t*>(ciphertext_buffer.data());
+  auto tag_result = CryptAndTag(
+      absl::string_view(ciphertext_buffer.data(), kIvSizeInBytes),
+      additional_data, reinterpret_cast<const uint8_t*>(plaintext.data()),
+      out + kIvSizeInBytes, plaintext.size(), /*encrypt=*/true);
+  if (!tag_result.ok()) return tag_result.status();
+  uint8_t* tag = out + kIvSizeInBytes + plaintext.size();
+  StoreBigEndian64(tag_result.ValueOrDie().hi, tag);
+  StoreBigEndian64(tag_result.ValueOrDie().lo, tag + 8);
+  return ciphertext_size;
+}
+
+util::StatusOr<std::string> AesGcmParallelBoringSsl::Decrypt(
+    absl::string_view ciphertext, absl::string_view additional_data) const {
+  if (ciphertext.size() < kIvSizeInBytes + kTagSizeInBytes) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Ciphertext too short");
+  }
+
+  std::string result;
+  ResizeStringUninitialized(
+      &result, ciphertext.size() - kIvSizeInBytes - kTagSizeInBytes);
+  auto written = DecryptInto(ciphertext, additional_data,
+                             absl::MakeSpan(&result[0], result.size()));
+  if (!written.ok()) return written.status();
+  return result;
+}
+
+util::StatusOr<int64_t> AesGcmParallelBoringSsl::DecryptInto(
+    absl::string_view ciphertext, absl::string_view additional_data,
+    absl::Span<char> plaintext_buffer) const {
+  if (ciphertext.size() < kIvSizeInBytes + kTagSizeInBytes) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Ciphertext too short");
+  }
+  const size_t plaintext_size =
+      ciphertext.size() - kIvSizeInBytes - kTagSizeInBytes;
+  if (plaintext_size < min_parallel_size_) {
+    return aead_->DecryptInto(ciphertext, additional_data, plaintext_buffer);
+  }
+  if (plaintext_buffer.size() < plaintext_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "plaintext_buffer is too small");
+  }
+  if (plaintext_size > kMaxPlaintextSize) {
+    return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too long");
+  }
+  additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
+
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(ciphertext.data());
+  uint8_t* out = reinterpret_cast<uint8_t*>(plaintext_buffer.data());
+  auto tag_result =
+      CryptAndTag(ciphertext.substr(0, kIvSizeInBytes), additional_data,
+                  in + kIvSizeInBytes, out, plaintext_size, /*encrypt=*/false);
+  if (!tag_result.ok()) return tag_result.status();
+  uint8_t tag[kTagSizeInBytes];
+  StoreBigEndian64(tag_result.ValueOrDie().hi, tag);
+  StoreBigEndian64(tag_result.ValueOrDie().lo, tag + 8);
+  if (CRYPTO_memcmp(tag, in + kIvSizeInBytes + plaintext_size,
+                    kTagSizeInBytes) != 0) {
+    std::memset(out, 0, plaintext_size);
+    static const util::Status* kAuthenticationFailed =
+        util::Status::NewStatic(util::error::INTERNAL, "Authentication failed");
+    return *kAuthenticationFailed;
+  }
+  return plaintext_size;
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,151 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SUBTLE_AES_GCM_PARALLEL_BORINGSSL_H_
+#define TINK_SUBTLE_AES_GCM_PARALLEL_BORINGSSL_H_
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "openssl/aead.h"
+#include "openssl/cipher.h"
+#include "tink/aead.h"
+#include "tink/config/tink_fips.h"
+#include "tink/util/executor.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// AES-GCM for very large messages, producing the same ciphertexts as
+// AesGcmBoringSsl, i.e. (iv || ciphertext || tag).
+//
+// Messages of at least 'min_parallel_size' bytes are split into chunks of
+// kChunkSize bytes. The CTR encryption and the GHASH of the chunks run in
+// parallel, and the GHASH values of the chunks are combined into the
+// tag on the calling thread. The GHASH of a chunk is taken from BoringSSL's
+// AES-GCM, as the tag for an empty message with the chunk as associated data,
+// so that it uses the same carry-less multiplication instructions. Smaller
+// messages are passed to AesGcmBoringSsl.
+//
+// Decryption computes the tag while it decrypts, and zeroes the plaintext if
+// the tag does not match.
+class AesGcmParallelBoringSsl final : public Aead {
+ public:
+  static constexpr int kChunkSize = 256 * 1024;
+  static constexpr int64_t kDefaultMinParallelSize = 4 * 1024 * 1024;
+
+  // Large messages are processed on the calling thread and up to
+  // num_threads - 1 tasks on 'executor', or on util::Executor::Global() if
+  // 'executor' is null. 'executor' must outlive the primitive.
+  static crypto::tink::util::StatusOr<std::unique_ptr<Aead>> New(
+      const util::SecretData& key, int num_threads,
+      int64_t min_parallel_size = kDefaultMinParallelSize,
+      util::Executor* executor = nullptr);
+
+  crypto::tink::util::StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view additional_data) const override;
+
+  crypto::tink::util::StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view additional_data) const override;
+
+  crypto::tink::util::StatusOr<int64_t> CiphertextSize(
+      int64_t plaintext_size) const override;
+
+  crypto::tink::util::StatusOr<int64_t> EncryptInto(
+      absl::string_view plaintext, absl::string_view additional_data,
+      absl::Span<char> ciphertext_buffer) const override;
+
+  crypto::tink::util::StatusOr<int64_t> DecryptInto(
+      absl::string_view ciphertext, absl::string_view additional_data,
+      absl::Span<char> plaintext_buffer) const override;
+
+  static constexpr crypto::tink::FipsCompatibility kFipsStatus =
+      crypto::tink::FipsCompatibility::kNotFips;
+
+ private:
+  static constexpr int kIvSizeInBytes = 12;
+  static constexpr int kTagSizeInBytes = 16;
+  static constexpr int kBlockSize = 16;
+
+  // An element of GF(2^128), as the two big endian halves of a block.
+  struct FieldElement {
+    uint64_t hi;
+    uint64_t lo;
+  };
+
+  AesGcmParallelBoringSsl(std::unique_ptr<Aead> aead,
+                          bssl::UniquePtr<EVP_AEAD_CTX> ghash_ctx,
+                          bssl::UniquePtr<EVP_CIPHER_CTX> keyed_ctr_ctx,
+                          int num_threads, int64_t min_parallel_size,
+                          util::Executor* executor)
+      : aead_(std::move(aead)),
+        ghash_ctx_(std::move(ghash_ctx)),
+        keyed_ctr_ctx_(std::move(keyed_ctr_ctx)),
+        num_threads_(num_threads),
+        min_parallel_size_(min_parallel_size),
+        executor_(executor) {}
+
+  static FieldElement Multiply(FieldElement x, FieldElement y);
+  FieldElement PowerOfH(int64_t exponent) const;
+
+  // Encrypts 'size' bytes of 'in' to 'out' in CTR mode, starting with the
+  // counter block 'iv' || 'counter'.
+  crypto::tink::util::Status Ctr(absl::string_view iv, uint32_t counter,
+                                 const uint8_t* in, uint8_t* out,
+                                 size_t size) const;
+
+  // Returns the GHASH of 'data' padded to full blocks, multiplied by H, i.e.
+  // the contribution of 'data' to the GHASH of a message times H.
+  crypto::tink::util::StatusOr<FieldElement> GhashTimesH(
+      const uint8_t* data, size_t size) const;
+
+  // Encrypts (if 'encrypt') or decrypts 'size' bytes of 'in' to 'out' with
+  // 'iv', and returns the tag over 'additional_data' and the ciphertext.
+  crypto::tink::util::StatusOr<FieldElement> CryptAndTag(
+      absl::string_view iv, absl::string_view additional_data,
+      const uint8_t* in, uint8_t* out, size_t size, bool encrypt) const;
+
+  // Used for messages smaller than min_parallel_size_.
+  const std::unique_ptr<Aead> aead_;
+  // AES-GCM with the same key, used to compute the GHASH of chunks.
+  const bssl::UniquePtr<EVP_AEAD_CTX> ghash_ctx_;
+  // Keyed once in New() and only ever copied afterwards.
+  const bssl::UniquePtr<EVP_CIPHER_CTX> keyed_ctr_ctx_;
+  const int num_threads_;
+  const int64_t min_parallel_size_;
+  util::Executor* const executor_;
+  // Set in New(): the hash key H, H to the number of blocks of a chunk, the
+  // length block of a chunk times H, and the AES encryption of the counter
+  // block 0^96 || 1 for the zero nonce used with ghash_ctx_.
+  FieldElement h_;
+  FieldElement h_chunk_;
+  FieldElement chunk_length_h_;
+  FieldElement ghash_mask_;
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_AES_GCM_PARALLEL_BORINGSSL_H_
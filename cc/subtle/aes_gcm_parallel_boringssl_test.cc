@@ -0,0 +1,174 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/aes_gcm_parallel_boringssl.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "tink/aead.h"
+#include "tink/config/tink_fips.h"
+#include "tink/subtle/aes_gcm_boringssl.h"
+#include "tink/subtle/random.h"
+#include "tink/util/executor.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+constexpr int kChunkSize = AesGcmParallelBoringSsl::kChunkSize;
+
+class AesGcmParallelBoringSslKeySizeTest
+    : public ::testing::TestWithParam<int> {
+ protected:
+  void SetUp() override {
+    if (kUseOnlyFips) {
+      GTEST_SKIP() << "Not supported in FIPS-only mode";
+    }
+  }
+};
+
+TEST_P(AesGcmParallelBoringSslKeySizeTest, CompatibleWithAesGcmBoringSsl) {
+  util::SecretData key = Random::GetRandomKeyBytes(GetParam());
+  auto aes_gcm = AesGcmBoringSsl::New(key);
+  ASSERT_THAT(aes_gcm.status(), IsOk());
+  for (int num_threads : {1, 3}) {
+    // A 'min_parallel_size' of 0 processes all messages in parallel.
+    auto parallel = AesGcmParallelBoringSsl::New(key, num_threads, 0);
+    ASSERT_THAT(parallel.status(), IsOk());
+    for (int size : {0, 1, 16, 17, kChunkSize - 1, kChunkSize, kChunkSize + 1,
+                     3 * kChunkSize + 100}) {
+      for (absl::string_view aad : {"", "some associated data"}) {
+        SCOPED_TRACE(size);
+        std::string plaintext = Random::GetRandomBytes(size);
+
+        auto ciphertext = parallel.ValueOrDie()->Encrypt(plaintext, aad);
+        ASSERT_THAT(ciphertext.status(), IsOk());
+        EXPECT_EQ(ciphertext.ValueOrDie().size(), 12 + size + 16);
+        auto decrypted =
+            aes_gcm.ValueOrDie()->Decrypt(ciphertext.ValueOrDie(), aad);
+        ASSERT_THAT(decrypted.status(), IsOk());
+        EXPECT_EQ(decrypted.ValueOrDie(), plaintext);
+
+        ciphertext = aes_gcm.ValueOrDie()->Encrypt(plaintext, aad);
+        ASSERT_THAT(ciphertext.status(), IsOk());
+        decrypted =
+            parallel.ValueOrDie()->Decrypt(ciphertext.ValueOrDie(), aad);
+        ASSERT_THAT(decrypted.status(), IsOk());
+        EXPECT_EQ(decrypted.ValueOrDie(), plaintext);
+      }
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(AesGcmParallelBoringSslTests,
+                         AesGcmParallelBoringSslKeySizeTest,
+                         ::testing::Values(16, 32));
+
+TEST(AesGcmParallelBoringSslTest, ModifiedCiphertext) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  auto parallel =
+      AesGcmParallelBoringSsl::New(Random::GetRandomKeyBytes(16), 2, 0);
+  ASSERT_THAT(parallel.status(), IsOk());
+  std::string aad = "some associated data";
+  auto ciphertext_result =
+      parallel.ValueOrDie()->Encrypt(std::string(2 * kChunkSize, 'a'), aad);
+  ASSERT_THAT(ciphertext_result.status(), IsOk());
+  const std::string& ciphertext = ciphertext_result.ValueOrDie();
+
+  for (size_t position : {size_t{0}, size_t{12}, size_t{kChunkSize + 12},
+                          ciphertext.size() - 1}) {
+    SCOPED_TRACE(position);
+    std::string modified = ciphertext;
+    modified[position] ^= 1;
+    std::string plaintext(2 * kChunkSize, 'x');
+    EXPECT_THAT(parallel.ValueOrDie()
+                    ->DecryptInto(modified, aad,
+                                  absl::MakeSpan(&plaintext[0],
+                                                 plaintext.size()))
+                    .status(),
+                StatusIs(util::error::INTERNAL));
+    // No unauthenticated plaintext is left in the buffer.
+    EXPECT_EQ(plaintext, std::string(2 * kChunkSize, '\0'));
+  }
+  EXPECT_THAT(
+      parallel.ValueOrDie()->Decrypt(ciphertext, "other associated data")
+          .status(),
+      StatusIs(util::error::INTERNAL));
+  EXPECT_THAT(parallel.ValueOrDie()->Decrypt("too short", aad).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(AesGcmParallelBoringSslTest, Executor) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  std::atomic<int> scheduled(0);
+  util::FunctionExecutor executor([&scheduled](std::function<void()> task) {
+    scheduled++;
+    task();
+  });
+  auto parallel = AesGcmParallelBoringSsl::New(
+      Random::GetRandomKeyBytes(16), 4, 2 * kChunkSize, &executor);
+  ASSERT_THAT(parallel.status(), IsOk());
+
+  // Messages below the threshold do not use it.
+  std::string small(kChunkSize, 'a');
+  auto ciphertext = parallel.ValueOrDie()->Encrypt(small, "");
+  ASSERT_THAT(ciphertext.status(), IsOk());
+  EXPECT_EQ(scheduled, 0);
+
+  std::string large(4 * kChunkSize, 'b');
+  ciphertext = parallel.ValueOrDie()->Encrypt(large, "");
+  ASSERT_THAT(ciphertext.status(), IsOk());
+  EXPECT_EQ(scheduled, 3);
+  auto decrypted = parallel.ValueOrDie()->Decrypt(ciphertext.ValueOrDie(), "");
+  ASSERT_THAT(decrypted.status(), IsOk());
+  EXPECT_EQ(decrypted.ValueOrDie(), large);
+  EXPECT_EQ(scheduled, 6);
+}
+
+TEST(AesGcmParallelBoringSslTest, InvalidParameters) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  EXPECT_THAT(
+      AesGcmParallelBoringSsl::New(Random::GetRandomKeyBytes(15), 2).status(),
+      StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(
+      AesGcmParallelBoringSsl::New(Random::GetRandomKeyBytes(16), 0).status(),
+      StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -20,10 +20,15 @@
 #include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "openssl/aead.h"
+#include "openssl/mem.h"
 #include "tink/config/tink_fips.h"
+#include "tink/subtle/aes_gcm_siv_multi_buffer.h"
 #include "tink/subtle/random.h"
 #include "tink/subtle/subtle_util.h"
+#include "tink/subtle/subtle_util_boringssl.h"
 #include "tink/util/status.h"
 
 namespace crypto {
@@ -45,6 +50,17 @@ const EVP_AEAD* GetCipherForKeySize(int size_in_bytes) {
 
 util::StatusOr<std::unique_ptr<Aead>> AesGcmSivBoringSsl::New(
     const util::SecretData& key) {
+  return Create(key, nullptr);
+}
+
+util::StatusOr<std::unique_ptr<Aead>> AesGcmSivBoringSsl::NewWithCounterNonces(
+    const util::SecretData& key) {
+  return Create(key, absl::make_unique<CounterNonceGenerator>());
+}
+
+util::StatusOr<std::unique_ptr<Aead>> AesGcmSivBoringSsl::Create(
+    const util::SecretData& key,
+    std::unique_ptr<CounterNonceGenerator> counter_nonces) {
   auto status = CheckFipsCompatibility<AesGcmSivBoringSsl>();
   if (!status.ok()) return status;
 
@@ -58,28 +74,63 @@ util::StatusOr<std::unique_ptr<Aead>> AesGcmSivBoringSsl::New(
     return util::Status(util::error::INTERNAL,
                         "could not initialize EVP_AEAD_CTX");
   }
-  return {absl::WrapUnique(new AesGcmSivBoringSsl(std::move(ctx)))};
+  return {absl::WrapUnique(new AesGcmSivBoringSsl(
+      std::move(ctx), std::move(counter_nonces),
+      AesGcmSivMultiBuffer::New(key)))};
+}
+
+util::Status AesGcmSivBoringSsl::NewNonce(absl::Span<char> nonce) const {
+  if (counter_nonces_ != nullptr) return counter_nonces_->Next(nonce);
+  Random::GetRandomNonceBytes(nonce);
+  return util::OkStatus();
+}
+
+util::StatusOr<int64_t> AesGcmSivBoringSsl::CiphertextSize(
+    int64_t plaintext_size) const {
+  return kIvSizeInBytes + plaintext_size + kTagSizeInBytes;
 }
 
 util::StatusOr<std::string> AesGcmSivBoringSsl::Encrypt(
     absl::string_view plaintext, absl::string_view additional_data) const {
-  std::string ciphertext = Random::GetRandomBytes(kIvSizeInBytes);
+  std::string ciphertext;
   ResizeStringUninitialized(
       &ciphertext, kIvSizeInBytes + plaintext.size() + kTagSizeInBytes);
+  auto written = EncryptInto(plaintext, additional_data,
+                             absl::MakeSpan(&ciphertext[0], ciphertext.size()));
+  if (!written.ok()) return written.status();
+  return ciphertext;
+}
+
+util::StatusOr<int64_t> AesGcmSivBoringSsl::EncryptInto(
+    absl::string_view plaintext, absl::string_view additional_data,
+    absl::Span<char> ciphertext_buffer) const {
+  const size_t ciphertext_size =
+      kIvSizeInBytes + plaintext.size() + kTagSizeInBytes;
+  if (ciphertext_buffer.size() < ciphertext_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_buffer is too small");
+  }
+  // BoringSSL expects a non-null pointer for plaintext and additional_data,
+  // regardless of whether the size is 0.
+  plaintext = SubtleUtilBoringSSL::EnsureNonNull(plaintext);
+  additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
+
+  auto nonce_status = NewNonce(ciphertext_buffer.subspan(0, kIvSizeInBytes));
+  if (!nonce_status.ok()) return nonce_status;
+  uint8_t* out = reinterpret_cast<uint8_t*>(ciphertext_buffer.data());
   size_t len;
   if (EVP_AEAD_CTX_seal(
-          ctx_.get(), reinterpret_cast<uint8_t*>(&ciphertext[kIvSizeInBytes]),
-          &len, ciphertext.size() - kIvSizeInBytes,
-          reinterpret_cast<const uint8_t*>(&ciphertext[0]), kIvSizeInBytes,
+          ctx_.get(), out + kIvSizeInBytes, &len,
+          ciphertext_size - kIvSizeInBytes, out, kIvSizeInBytes,
           reinterpret_cast<const uint8_t*>(plaintext.data()), plaintext.size(),
           reinterpret_cast<const uint8_t*>(additional_data.data()),
           additional_data.size()) != 1) {
     return util::Status(util::error::INTERNAL, "Encryption failed");
   }
-  if (len != ciphertext.size() - kIvSizeInBytes) {
+  if (len != ciphertext_size - kIvSizeInBytes) {
     return util::Status(util::error::INTERNAL, "incorrect ciphertext size");
   }
-  return ciphertext;
+  return ciphertext_size;
 }
 
 util::StatusOr<std::string> AesGcmSivBoringSsl::Decrypt(
@@ -91,10 +142,36 @@ util::StatusOr<std::string> AesGcmSivBoringSsl::Decrypt(
   std::string plaintext;
   ResizeStringUninitialized(
       &plaintext, ciphertext.size() - kIvSizeInBytes - kTagSizeInBytes);
+  auto written = DecryptInto(ciphertext, additional_data,
+                             absl::MakeSpan(&plaintext[0], plaintext.size()));
+  if (!written.ok()) return written.status();
+  return plaintext;
+}
+
+util::StatusOr<int64_t> AesGcmSivBoringSsl::DecryptInto(
+    absl::string_view ciphertext, absl::string_view additional_data,
+    absl::Span<char> plaintext_buffer) const {
+  if (ciphertext.size() < kIvSizeInBytes + kTagSizeInBytes) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Ciphertext too short");
+  }
+  const size_t plaintext_size =
+      ciphertext.size() - kIvSizeInBytes - kTagSizeInBytes;
+  if (plaintext_buffer.size() < plaintext_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "plaintext_buffer is too small");
+  }
+  // BoringSSL expects a non-null pointer for additional_data,
+  // regardless of whether the size is 0.
+  additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
+
+  // The plaintext may be empty, in which case the buffer may be empty as well.
+  uint8_t empty_buffer;
+  uint8_t* out = plaintext_buffer.empty()
+                     ? &empty_buffer
+                     : reinterpret_cast<uint8_t*>(plaintext_buffer.data());
   size_t len;
   if (EVP_AEAD_CTX_open(
-          ctx_.get(), reinterpret_cast<uint8_t*>(&plaintext[0]), &len,
-          plaintext.size(),
+          ctx_.get(), out, &len, plaintext_size,
           // The nonce is the first |kIvSizeInBytes| bytes of |ciphertext|.
           reinterpret_cast<const uint8_t*>(ciphertext.data()), kIvSizeInBytes,
           // The input is the remainder.
@@ -102,12 +179,97 @@ util::StatusOr<std::string> AesGcmSivBoringSsl::Decrypt(
           ciphertext.size() - kIvSizeInBytes,
           reinterpret_cast<const uint8_t*>(additional_data.data()),
           additional_data.size()) != 1) {
-    return util::Status(util::error::INTERNAL, "Authentication failed");
+    static const util::Status* kAuthenticationFailed =
+        util::Status::NewStatic(util::error::INTERNAL, "Authentication failed");
+    return *kAuthenticationFailed;
   }
-  if (len != plaintext.size()) {
+  if (len != plaintext_size) {
     return util::Status(util::error::INTERNAL, "incorrect ciphertext size");
   }
-  return plaintext;
+  return len;
+}
+
+bool AesGcmSivBoringSsl::UseMultiBuffer(
+    absl::Span<const absl::string_view> records) const {
+  if (multi_buffer_ == nullptr || records.size() < 2) return false;
+  for (absl::string_view record : records) {
+    if (record.size() > kMaxMultiBufferRecordSize) return false;
+  }
+  return true;
+}
+
+util::Status AesGcmSivBoringSsl::EncryptBatch(
+    absl::Span<const absl::string_view> plaintexts,
+    absl::Span<const absl::string_view> associated_data,
+    std::string* ciphertexts, std::vector<int64_t>* offsets) const {
+  if (plaintexts.size() != associated_data.size() ||
+      !UseMultiBuffer(plaintexts)) {
+    return Aead::EncryptBatch(plaintexts, associated_data, ciphertexts,
+                              offsets);
+  }
+  offsets->assign(1, 0);
+  offsets->reserve(plaintexts.size() + 1);
+  for (absl::string_view plaintext : plaintexts) {
+    offsets->push_back(offsets->back() + kIvSizeInBytes + plaintext.size() +
+                       kTagSizeInBytes);
+  }
+  ciphertexts->clear();
+  ResizeStringUninitialized(ciphertexts, offsets->back());
+  std::vector<uint8_t*> outs(plaintexts.size());
+  for (size_t i = 0; i < plaintexts.size(); i++) {
+    char* out = &(*ciphertexts)[(*offsets)[i]];
+    auto nonce_status = NewNonce(absl::MakeSpan(out, kIvSizeInBytes));
+    if (!nonce_status.ok()) {
+      ciphertexts->clear();
+      offsets->assign(1, 0);
+      return nonce_status;
+    }
+    outs[i] = reinterpret_cast<uint8_t*>(out);
+  }
+  multi_buffer_->Seal(plaintexts, associated_data, outs);
+  return util::OkStatus();
+}
+
+util::Status AesGcmSivBoringSsl::DecryptBatch(
+    absl::Span<const absl::string_view> ciphertexts,
+    absl::Span<const absl::string_view> associated_data,
+    std::string* plaintexts, std::vector<int64_t>* offsets) const {
+  if (ciphertexts.size() != associated_data.size() ||
+      !UseMultiBuffer(ciphertexts)) {
+    return Aead::DecryptBatch(ciphertexts, associated_data, plaintexts,
+                              offsets);
+  }
+  plaintexts->clear();
+  offsets->assign(1, 0);
+  for (absl::string_view ciphertext : ciphertexts) {
+    if (ciphertext.size() < kIvSizeInBytes + kTagSizeInBytes) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "Ciphertext too short");
+    }
+  }
+  offsets->reserve(ciphertexts.size() + 1);
+  for (absl::string_view ciphertext : ciphertexts) {
+    offsets->push_back(offsets->back() + ciphertext.size() - kIvSizeInBytes -
+                       kTagSizeInBytes);
+  }
+  // Keeps a valid pointer for empty plaintexts.
+  ResizeStringUninitialized(plaintexts, offsets->back() + 1);
+  std::vector<uint8_t*> outs(ciphertexts.size());
+  for (size_t i = 0; i < ciphertexts.size(); i++) {
+    outs[i] = reinterpret_cast<uint8_t*>(&(*plaintexts)[(*offsets)[i]]);
+  }
+  bool authentic = multi_buffer_->Open(ciphertexts, associated_data, outs);
+  plaintexts->resize(offsets->back());
+  if (!authentic) {
+    // Do not release unauthenticated plaintext.
+    OPENSSL_cleanse(&(*plaintexts)[0], plaintexts->size());
+    plaintexts->clear();
+    offsets->assign(1, 0);
+    static const util::Status* kAuthenticationFailed =
+        util::Status::NewStatic(util::error::INTERNAL, "Authentication failed");
+    return *kAuthenticationFailed;
+  }
+  return util::OkStatus();
 }
 
 }  // namespace subtle
@@ -18,12 +18,17 @@
 #define TINK_SUBTLE_AES_GCM_SIV_BORINGSSL_H_
 
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "openssl/aead.h"
 #include "tink/aead.h"
 #include "tink/config/tink_fips.h"
+#include "tink/subtle/aes_gcm_siv_multi_buffer.h"
+#include "tink/subtle/counter_nonce_generator.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/statusor.h"
 
@@ -53,6 +58,13 @@ class AesGcmSivBoringSsl : public Aead {
   static crypto::tink::util::StatusOr<std::unique_ptr<Aead>> New(
       const util::SecretData& key);
 
+  // Returns an AES-GCM-SIV primitive which derives the nonces from a counter
+  // instead of the random number generator (see CounterNonceGenerator).
+  // The ciphertexts have the same format as those of New(). Encryption fails
+  // with RESOURCE_EXHAUSTED once the nonces of the primitive are used up.
+  static crypto::tink::util::StatusOr<std::unique_ptr<Aead>>
+  NewWithCounterNonces(const util::SecretData& key);
+
   crypto::tink::util::StatusOr<std::string> Encrypt(
       absl::string_view plaintext,
       absl::string_view additional_data) const override;
@@ -61,17 +73,65 @@ class AesGcmSivBoringSsl : public Aead {
       absl::string_view ciphertext,
       absl::string_view additional_data) const override;
 
+  crypto::tink::util::StatusOr<int64_t> CiphertextSize(
+      int64_t plaintext_size) const override;
+
+  crypto::tink::util::StatusOr<int64_t> EncryptInto(
+      absl::string_view plaintext, absl::string_view additional_data,
+      absl::Span<char> ciphertext_buffer) const override;
+
+  crypto::tink::util::StatusOr<int64_t> DecryptInto(
+      absl::string_view ciphertext, absl::string_view additional_data,
+      absl::Span<char> plaintext_buffer) const override;
+
+  // Batches of small records are encrypted and decrypted together with
+  // AesGcmSivMultiBuffer, if it is available, which derives the per-nonce
+  // keys of the records together and processes several records in parallel
+  // lanes.
+  crypto::tink::util::Status EncryptBatch(
+      absl::Span<const absl::string_view> plaintexts,
+      absl::Span<const absl::string_view> associated_data,
+      std::string* ciphertexts, std::vector<int64_t>* offsets) const override;
+
+  crypto::tink::util::Status DecryptBatch(
+      absl::Span<const absl::string_view> ciphertexts,
+      absl::Span<const absl::string_view> associated_data,
+      std::string* plaintexts, std::vector<int64_t>* offsets) const override;
+
   static constexpr crypto::tink::FipsCompatibility kFipsStatus =
       crypto::tink::FipsCompatibility::kNotFips;
 
  private:
   static constexpr int kIvSizeInBytes = 12;
   static constexpr int kTagSizeInBytes = 16;
+  // The per-nonce key derivation dominates the cost of small records only;
+  // batches with larger records are processed one record at a time by
+  // BoringSSL.
+  static constexpr size_t kMaxMultiBufferRecordSize = 256;
+
+  AesGcmSivBoringSsl(bssl::UniquePtr<EVP_AEAD_CTX> ctx,
+                     std::unique_ptr<CounterNonceGenerator> counter_nonces,
+                     std::unique_ptr<AesGcmSivMultiBuffer> multi_buffer)
+      : ctx_(std::move(ctx)),
+        counter_nonces_(std::move(counter_nonces)),
+        multi_buffer_(std::move(multi_buffer)) {}
+
+  static crypto::tink::util::StatusOr<std::unique_ptr<Aead>> Create(
+      const util::SecretData& key,
+      std::unique_ptr<CounterNonceGenerator> counter_nonces);
+
+  // Writes a fresh nonce to 'nonce'.
+  crypto::tink::util::Status NewNonce(absl::Span<char> nonce) const;
 
-  explicit AesGcmSivBoringSsl(bssl::UniquePtr<EVP_AEAD_CTX> ctx)
-      : ctx_(std::move(ctx)) {}
+  // Returns true if the batch of 'records' should be processed with
+  // multi_buffer_.
+  bool UseMultiBuffer(absl::Span<const absl::string_view> records) const;
 
   bssl::UniquePtr<EVP_AEAD_CTX> ctx_;
+  // If null, the nonces are random.
+  const std::unique_ptr<CounterNonceGenerator> counter_nonces_;
+  // Null if not available.
+  const std::unique_ptr<AesGcmSivMultiBuffer> multi_buffer_;
 };
 
 }  // namespace subtle
@@ -0,0 +1,536 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/aes_gcm_siv_multi_buffer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#if defined(__AES__) && defined(__PCLMUL__) && defined(__SSE4_1__)
+#define TINK_AES_GCM_SIV_MULTI_BUFFER_AESNI 1
+#include <immintrin.h>
+#endif
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "openssl/mem.h"
+#include "tink/subtle/cpu_features.h"
+#include "tink/util/secret_data.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+namespace {
+
+constexpr size_t kBlockSize = 16;
+
+bool IsAvailable() {
+#if defined(TINK_AES_GCM_SIV_MULTI_BUFFER_AESNI)
+  return HasCpuFeature(CpuFeature::kAesNi) &&
+         HasCpuFeature(CpuFeature::kPclmul) &&
+         HasCpuFeature(CpuFeature::kSse41);
+#else
+  return false;
+#endif
+}
+
+// A message of a batch.
+struct Message {
+  const uint8_t* nonce;
+  const uint8_t* associated_data;
+  size_t associated_data_size;
+  // The CTR input and output, of 'size' bytes.
+  const uint8_t* in;
+  uint8_t* out;
+  size_t size;
+  // The plaintext, which is 'in' when sealing and 'out' when opening.
+  const uint8_t* plaintext;
+};
+
+#if defined(TINK_AES_GCM_SIV_MULTI_BUFFER_AESNI)
+
+size_t Blocks(size_t size) { return (size + kBlockSize - 1) / kBlockSize; }
+
+// The number of blocks encrypted at once.
+constexpr int kAesBlocks = 8;
+// The number of messages processed at once, one per lane.
+constexpr int kLanes = 4;
+
+// The keys of a message, derived from the key-generating key and its nonce.
+struct MessageKeys {
+  // The message authentication key, i.e. the POLYVAL key.
+  __m128i hash_key;
+  // The round keys of the message encryption key.
+  __m128i round_keys[15];
+};
+
+// Returns the next round key of the AES key schedule from 'previous', the
+// round key Nk words earlier, and the output of AESKEYGENASSIST, whose
+// relevant word is selected by 'kShuffle'.
+template <int kShuffle>
+__m128i NextRoundKey(__m128i previous, __m128i assist) {
+  assist = _mm_shuffle_epi32(assist, kShuffle);
+  __m128i shifted = _mm_slli_si128(previous, 4);
+  previous = _mm_xor_si128(previous, shifted);
+  shifted = _mm_slli_si128(shifted, 4);
+  previous = _mm_xor_si128(previous, shifted);
+  shifted = _mm_slli_si128(shifted, 4);
+  previous = _mm_xor_si128(previous, shifted);
+  return _mm_xor_si128(previous, assist);
+}
+
+// Expands the AES-128 keys in keys[i].round_keys[0] for i < kCount. The key
+// schedules are interleaved, since each of them is a chain of dependent
+// steps.
+template <int kCount>
+void ExpandAes128Keys(MessageKeys* keys) {
+#define TINK_AES128_ROUND(i, rcon)                                    \
+  for (int lane = 0; lane < kCount; lane++) {                         \
+    keys[lane].round_keys[i] = NextRoundKey<0xff>(                    \
+        keys[lane].round_keys[i - 1],                                 \
+        _mm_aeskeygenassist_si128(keys[lane].round_keys[i - 1], rcon)); \
+  }
+  TINK_AES128_ROUND(1, 0x01);
+  TINK_AES128_ROUND(2, 0x02);
+  TINK_AES128_ROUND(3, 0x04);
+  TINK_AES128_ROUND(4, 0x08);
+  TINK_AES128_ROUND(5, 0x10);
+  TINK_AES128_ROUND(6, 0x20);
+  TINK_AES128_ROUND(7, 0x40);
+  TINK_AES128_ROUND(8, 0x80);
+  TINK_AES128_ROUND(9, 0x1b);
+  TINK_AES128_ROUND(10, 0x36);
+#undef TINK_AES128_ROUND
+}
+
+// Same as above for the AES-256 keys in keys[i].round_keys[0] and
+// keys[i].round_keys[1].
+template <int kCount>
+void ExpandAes256Keys(MessageKeys* keys) {
+  // Even round keys use RotWord, SubWord and the round constant; odd ones
+  // only SubWord.
+#define TINK_AES256_ROUNDS(i, rcon)                                         \
+  for (int lane = 0; lane < kCount; lane++) {                               \
+    __m128i* round_keys = keys[lane].round_keys;                            \
+    round_keys[i] = NextRoundKey<0xff>(                                     \
+        round_keys[i - 2],                                                  \
+        _mm_aeskeygenassist_si128(round_keys[i - 1], rcon));                \
+    if (i + 1 < 15) {                                                       \
+      round_keys[i + 1] = NextRoundKey<0xaa>(                               \
+          round_keys[i - 1], _mm_aeskeygenassist_si128(round_keys[i], 0x00)); \
+    }                                                                       \
+  }
+  TINK_AES256_ROUNDS(2, 0x01);
+  TINK_AES256_ROUNDS(4, 0x02);
+  TINK_AES256_ROUNDS(6, 0x04);
+  TINK_AES256_ROUNDS(8, 0x08);
+  TINK_AES256_ROUNDS(10, 0x10);
+  TINK_AES256_ROUNDS(12, 0x20);
+  TINK_AES256_ROUNDS(14, 0x40);
+#undef TINK_AES256_ROUNDS
+}
+
+template <int kCount>
+void ExpandKeys(int rounds, MessageKeys* keys) {
+  if (rounds == 10) {
+    ExpandAes128Keys<kCount>(keys);
+  } else {
+    ExpandAes256Keys<kCount>(keys);
+  }
+}
+
+// Encrypts the kAesBlocks blocks in 'blocks' in place, block i with the
+// round keys at round_keys[i], which blocks may share.
+inline void EncryptBlocks(int rounds, const __m128i* const* round_keys,
+                          __m128i* blocks) {
+  __m128i b[kAesBlocks];
+  for (int i = 0; i < kAesBlocks; i++) {
+    b[i] = _mm_xor_si128(blocks[i], round_keys[i][0]);
+  }
+  for (int round = 1; round < rounds; round++) {
+    for (int i = 0; i < kAesBlocks; i++) {
+      b[i] = _mm_aesenc_si128(b[i], round_keys[i][round]);
+    }
+  }
+  for (int i = 0; i < kAesBlocks; i++) {
+    blocks[i] = _mm_aesenclast_si128(b[i], round_keys[i][rounds]);
+  }
+}
+
+// Returns the product a * b * x^-128 of POLYVAL field elements, i.e.
+// dot(a, b) of RFC 8452, reduced modulo x^128 + x^127 + x^126 + x^121 + 1
+// by folding the low half of the product into the high half twice.
+inline __m128i Dot(__m128i a, __m128i b) {
+  const __m128i poly = _mm_set_epi32(static_cast<int>(0xc2000000), 0, 0, 1);
+  __m128i lo = _mm_clmulepi64_si128(a, b, 0x00);
+  __m128i hi = _mm_clmulepi64_si128(a, b, 0x11);
+  __m128i mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x01),
+                              _mm_clmulepi64_si128(a, b, 0x10));
+  lo = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+  hi = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+  __m128i fold = _mm_clmulepi64_si128(lo, poly, 0x10);
+  lo = _mm_xor_si128(_mm_shuffle_epi32(lo, 0x4e), fold);
+  fold = _mm_clmulepi64_si128(lo, poly, 0x10);
+  lo = _mm_xor_si128(_mm_shuffle_epi32(lo, 0x4e), fold);
+  return _mm_xor_si128(hi, lo);
+}
+
+// Returns a block holding the nonce at 'offset' and zeros elsewhere.
+inline __m128i NonceBlock(const uint8_t* nonce, size_t offset) {
+  uint8_t block[kBlockSize] = {0};
+  std::memcpy(block + offset, nonce, AesGcmSivMultiBuffer::kNonceSize);
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+}
+
+// Derives the keys of the messages of the lanes as in RFC 8452, section 4,
+// encrypting the derivation blocks of all lanes together.
+void DeriveKeys(int rounds, const __m128i* key_generating_key,
+                const Message* const* lane_messages, MessageKeys* keys) {
+  // Two blocks per 128-bit key.
+  const int blocks_per_message = rounds == 10 ? 4 : 6;
+  const int total = kLanes * blocks_per_message;
+  __m128i derived[kLanes * 6];
+  const __m128i* round_keys[kAesBlocks];
+  std::fill(round_keys, round_keys + kAesBlocks, key_generating_key);
+  for (int first = 0; first < total; first += kAesBlocks) {
+    for (int i = 0; i < kAesBlocks; i++) {
+      int block = first + i;
+      derived[block] = _mm_insert_epi32(
+          NonceBlock(lane_messages[block / blocks_per_message]->nonce, 4),
+          block % blocks_per_message, 0);
+    }
+    EncryptBlocks(rounds, round_keys, &derived[first]);
+  }
+  for (int lane = 0; lane < kLanes; lane++) {
+    // Only the first 8 bytes of each block are used.
+    const __m128i* blocks = &derived[lane * blocks_per_message];
+    keys[lane].hash_key = _mm_unpacklo_epi64(blocks[0], blocks[1]);
+    keys[lane].round_keys[0] = _mm_unpacklo_epi64(blocks[2], blocks[3]);
+    if (blocks_per_message == 6) {
+      keys[lane].round_keys[1] = _mm_unpacklo_epi64(blocks[4], blocks[5]);
+    }
+  }
+  OPENSSL_cleanse(derived, sizeof(derived));
+}
+
+// The number of POLYVAL input blocks of 'message': the padded associated
+// data, the padded plaintext and the lengths.
+size_t PolyvalBlocks(const Message& message) {
+  return Blocks(message.associated_data_size) + Blocks(message.size) + 1;
+}
+
+void StoreLittleEndian64(uint64_t value, uint8_t* out) {
+  for (int i = 0; i < 8; i++) {
+    out[i] = value & 0xff;
+    value >>= 8;
+  }
+}
+
+// Writes the POLYVAL input blocks of 'message' to out, out + stride, etc.
+void WritePolyvalInput(const Message& message, uint8_t* out, size_t stride) {
+  const uint8_t* parts[2] = {message.associated_data, message.plaintext};
+  const size_t part_sizes[2] = {message.associated_data_size, message.size};
+  for (int part = 0; part < 2; part++) {
+    for (size_t offset = 0; offset < part_sizes[part]; offset += kBlockSize) {
+      size_t size = std::min(kBlockSize, part_sizes[part] - offset);
+      std::memcpy(out, parts[part] + offset, size);
+      std::memset(out + size, 0, kBlockSize - size);
+      out += stride;
+    }
+  }
+  StoreLittleEndian64(message.associated_data_size * 8, out);
+  StoreLittleEndian64(message.size * 8, out + 8);
+}
+
+// Computes the POLYVAL hashes of the messages of the lanes into 'hashes'.
+//
+// POLYVAL(H, X) = POLYVAL(H, 0 || X), so shorter messages are padded with
+// zero blocks at the front and all lanes finish together. The padded inputs
+// are copied into rows of one block per lane in 'input' first, so that the
+// loop over the blocks only loads and multiplies.
+void Polyval(const MessageKeys* keys, const Message* const* lane_messages,
+             std::vector<uint8_t>* input, __m128i* hashes) {
+  size_t blocks[kLanes];
+  size_t rows = 0;
+  for (int lane = 0; lane < kLanes; lane++) {
+    blocks[lane] = PolyvalBlocks(*lane_messages[lane]);
+    rows = std::max(rows, blocks[lane]);
+  }
+  const size_t row_size = kLanes * kBlockSize;
+  input->assign(rows * row_size, 0);
+  for (int lane = 0; lane < kLanes; lane++) {
+    WritePolyvalInput(
+        *lane_messages[lane],
+        &(*input)[(rows - blocks[lane]) * row_size + lane * kBlockSize],
+        row_size);
+  }
+  __m128i hash[kLanes];
+  for (int lane = 0; lane < kLanes; lane++) hash[lane] = _mm_setzero_si128();
+  for (size_t row = 0; row < rows; row++) {
+    const uint8_t* in = &(*input)[row * row_size];
+    for (int lane = 0; lane < kLanes; lane++) {
+      __m128i block = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(in + lane * kBlockSize));
+      hash[lane] = Dot(_mm_xor_si128(hash[lane], block), keys[lane].hash_key);
+    }
+  }
+  for (int lane = 0; lane < kLanes; lane++) hashes[lane] = hash[lane];
+}
+
+// Computes the tags of the messages of the lanes from their POLYVAL hashes.
+void ComputeTags(int rounds, const MessageKeys* keys,
+                 const Message* const* lane_messages, const __m128i* hashes,
+                 __m128i* tags) {
+  const __m128i clear_top_bit = _mm_set_epi32(0x7fffffff, -1, -1, -1);
+  __m128i blocks[kAesBlocks];
+  const __m128i* round_keys[kAesBlocks];
+  for (int i = 0; i < kAesBlocks; i++) {
+    // The blocks after kLanes repeat the last lane.
+    int lane = std::min(i, kLanes - 1);
+    blocks[i] = _mm_and_si128(
+        _mm_xor_si128(hashes[lane], NonceBlock(lane_messages[lane]->nonce, 0)),
+        clear_top_bit);
+    round_keys[i] = keys[lane].round_keys;
+  }
+  EncryptBlocks(rounds, round_keys, blocks);
+  for (int lane = 0; lane < kLanes; lane++) tags[lane] = blocks[lane];
+}
+
+// Encrypts or decrypts the first 'lanes' messages of the lanes in CTR mode,
+// with counter blocks derived from 'tags'. Each step encrypts the next
+// kAesBlocks / kLanes counter blocks of each lane.
+void CtrEncrypt(int rounds, const MessageKeys* keys,
+                const Message* const* lane_messages, int lanes,
+                const __m128i* tags) {
+  constexpr int kBlocksPerLane = kAesBlocks / kLanes;
+  const __m128i top_bit = _mm_set_epi32(static_cast<int>(0x80000000), 0, 0, 0);
+  __m128i counters[kLanes];
+  size_t max_size = 0;
+  for (int lane = 0; lane < kLanes; lane++) {
+    counters[lane] = _mm_or_si128(tags[lane], top_bit);
+    max_size = std::max(max_size, lane_messages[lane]->size);
+  }
+  const __m128i* round_keys[kAesBlocks];
+  for (int i = 0; i < kAesBlocks; i++) {
+    round_keys[i] = keys[i / kBlocksPerLane].round_keys;
+  }
+  for (size_t offset = 0; offset < max_size;
+       offset += kBlocksPerLane * kBlockSize) {
+    // The counter is the first 32 bits, little-endian, and wraps around.
+    const uint32_t counter = static_cast<uint32_t>(offset / kBlockSize);
+    __m128i blocks[kAesBlocks];
+    for (int i = 0; i < kAesBlocks; i++) {
+      blocks[i] = _mm_add_epi32(
+          counters[i / kBlocksPerLane],
+          _mm_cvtsi32_si128(static_cast<int>(counter + i % kBlocksPerLane)));
+    }
+    EncryptBlocks(rounds, round_keys, blocks);
+    for (int i = 0; i < lanes * kBlocksPerLane; i++) {
+      const Message& message = *lane_messages[i / kBlocksPerLane];
+      size_t block_offset = offset + (i % kBlocksPerLane) * kBlockSize;
+      if (block_offset >= message.size) continue;
+      size_t size = std::min(kBlockSize, message.size - block_offset);
+      if (size == kBlockSize) {
+        __m128i in = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(message.in + block_offset));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(message.out + block_offset),
+            _mm_xor_si128(in, blocks[i]));
+      } else {
+        uint8_t key_stream[kBlockSize];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(key_stream), blocks[i]);
+        for (size_t j = 0; j < size; j++) {
+          message.out[block_offset + j] =
+              message.in[block_offset + j] ^ key_stream[j];
+        }
+      }
+    }
+  }
+}
+
+// Computes the tags of the messages at 'group', of which there are 'lanes',
+// at most kLanes, into tags + 16 * group[i], and encrypts them, or decrypts
+// them with the received tags if 'opening' is true.
+void ProcessGroup(int rounds, const __m128i* key_generating_key,
+                  const std::vector<Message>& messages, const size_t* group,
+                  int lanes, bool opening, std::vector<uint8_t>* input,
+                  uint8_t* tags) {
+  // If there are fewer than kLanes messages, the last one is repeated, and
+  // its results are only stored once.
+  const Message* lane_messages[kLanes];
+  for (int lane = 0; lane < kLanes; lane++) {
+    lane_messages[lane] = &messages[group[std::min(lane, lanes - 1)]];
+  }
+  MessageKeys keys[kLanes];
+  DeriveKeys(rounds, key_generating_key, lane_messages, keys);
+  ExpandKeys<kLanes>(rounds, keys);
+  if (opening) {
+    __m128i received_tags[kLanes];
+    for (int lane = 0; lane < kLanes; lane++) {
+      const Message& message = *lane_messages[lane];
+      received_tags[lane] = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(message.in + message.size));
+    }
+    CtrEncrypt(rounds, keys, lane_messages, lanes, received_tags);
+  }
+  __m128i hashes[kLanes];
+  Polyval(keys, lane_messages, input, hashes);
+  __m128i computed_tags[kLanes];
+  ComputeTags(rounds, keys, lane_messages, hashes, computed_tags);
+  if (!opening) CtrEncrypt(rounds, keys, lane_messages, lanes, computed_tags);
+  for (int lane = 0; lane < lanes; lane++) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(tags + kBlockSize * group[lane]),
+                     computed_tags[lane]);
+  }
+  OPENSSL_cleanse(keys, sizeof(keys));
+}
+
+#endif  // TINK_AES_GCM_SIV_MULTI_BUFFER_AESNI
+
+// Computes the tags of 'messages' into 'tags', 16 bytes each, and encrypts
+// them, or decrypts them if 'opening' is true.
+//
+// The messages are sorted by length and processed in groups of kLanes, so
+// that the lanes of a group need about the same number of steps.
+void Process(int rounds, const uint8_t (*round_keys)[16],
+             const std::vector<Message>& messages, bool opening,
+             uint8_t* tags) {
+#if defined(TINK_AES_GCM_SIV_MULTI_BUFFER_AESNI)
+  if (messages.empty()) return;
+  __m128i key_generating_key[15];
+  for (int i = 0; i <= rounds; i++) {
+    key_generating_key[i] =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(round_keys[i]));
+  }
+  std::vector<size_t> blocks(messages.size());
+  std::vector<size_t> order(messages.size());
+  for (size_t i = 0; i < messages.size(); i++) {
+    blocks[i] = PolyvalBlocks(messages[i]);
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&blocks](size_t a, size_t b) {
+    return blocks[a] < blocks[b];
+  });
+  // Holds the plaintexts while they are hashed.
+  std::vector<uint8_t> input;
+  for (size_t first = 0; first < order.size(); first += kLanes) {
+    ProcessGroup(rounds, key_generating_key, messages, &order[first],
+                 std::min<size_t>(kLanes, order.size() - first), opening,
+                 &input, tags);
+  }
+  if (!input.empty()) OPENSSL_cleanse(input.data(), input.size());
+  OPENSSL_cleanse(key_generating_key, sizeof(key_generating_key));
+#endif
+}
+
+}  // namespace
+
+std::unique_ptr<AesGcmSivMultiBuffer> AesGcmSivMultiBuffer::New(
+    const util::SecretData& key) {
+  if (!IsAvailable() || (key.size() != 16 && key.size() != 32)) {
+    return nullptr;
+  }
+  auto aes_gcm_siv = absl::WrapUnique(new AesGcmSivMultiBuffer());
+#if defined(TINK_AES_GCM_SIV_MULTI_BUFFER_AESNI)
+  MessageKeys expanded;
+  expanded.round_keys[0] =
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(key.data()));
+  if (key.size() == 16) {
+    aes_gcm_siv->rounds_ = 10;
+  } else {
+    aes_gcm_siv->rounds_ = 14;
+    expanded.round_keys[1] =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(key.data() + 16));
+  }
+  ExpandKeys<1>(aes_gcm_siv->rounds_, &expanded);
+  for (int i = 0; i <= aes_gcm_siv->rounds_; i++) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(aes_gcm_siv->round_keys_[i]),
+                     expanded.round_keys[i]);
+  }
+  OPENSSL_cleanse(&expanded, sizeof(expanded));
+#endif
+  return aes_gcm_siv;
+}
+
+absl::string_view AesGcmSivMultiBuffer::Implementation() {
+  return IsAvailable() ? "AES-NI" : "";
+}
+
+AesGcmSivMultiBuffer::~AesGcmSivMultiBuffer() {
+  OPENSSL_cleanse(round_keys_, sizeof(round_keys_));
+}
+
+void AesGcmSivMultiBuffer::Seal(
+    absl::Span<const absl::string_view> plaintexts,
+    absl::Span<const absl::string_view> associated_data,
+    absl::Span<uint8_t* const> ciphertexts) const {
+  std::vector<Message> messages(plaintexts.size());
+  for (size_t i = 0; i < plaintexts.size(); i++) {
+    Message& message = messages[i];
+    message.nonce = ciphertexts[i];
+    message.associated_data =
+        reinterpret_cast<const uint8_t*>(associated_data[i].data());
+    message.associated_data_size = associated_data[i].size();
+    message.in = reinterpret_cast<const uint8_t*>(plaintexts[i].data());
+    message.out = ciphertexts[i] + kNonceSize;
+    message.size = plaintexts[i].size();
+    message.plaintext = message.in;
+  }
+  std::vector<uint8_t> tags(kTagSize * messages.size());
+  Process(rounds_, round_keys_, messages, /*opening=*/false, tags.data());
+  for (size_t i = 0; i < messages.size(); i++) {
+    std::memcpy(messages[i].out + messages[i].size, &tags[kTagSize * i],
+                kTagSize);
+  }
+}
+
+bool AesGcmSivMultiBuffer::Open(
+    absl::Span<const absl::string_view> ciphertexts,
+    absl::Span<const absl::string_view> associated_data,
+    absl::Span<uint8_t* const> plaintexts) const {
+  std::vector<Message> messages(ciphertexts.size());
+  for (size_t i = 0; i < ciphertexts.size(); i++) {
+    Message& message = messages[i];
+    const uint8_t* ciphertext =
+        reinterpret_cast<const uint8_t*>(ciphertexts[i].data());
+    message.nonce = ciphertext;
+    message.associated_data =
+        reinterpret_cast<const uint8_t*>(associated_data[i].data());
+    message.associated_data_size = associated_data[i].size();
+    message.in = ciphertext + kNonceSize;
+    message.out = plaintexts[i];
+    message.size = ciphertexts[i].size() - kNonceSize - kTagSize;
+    message.plaintext = message.out;
+  }
+  std::vector<uint8_t> tags(kTagSize * messages.size());
+  Process(rounds_, round_keys_, messages, /*opening=*/true, tags.data());
+  bool ok = true;
+  for (size_t i = 0; i < messages.size(); i++) {
+    ok &= CRYPTO_memcmp(&tags[kTagSize * i],
+                        messages[i].in + messages[i].size, kTagSize) == 0;
+  }
+  return ok;
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
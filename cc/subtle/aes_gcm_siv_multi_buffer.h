@@ -0,0 +1,96 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SUBTLE_AES_GCM_SIV_MULTI_BUFFER_H_
+#define TINK_SUBTLE_AES_GCM_SIV_MULTI_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/util/secret_data.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// AES-GCM-SIV (RFC 8452) for batches of small messages under one key,
+// producing the same ciphertexts as AesGcmSivBoringSsl, i.e.
+// (nonce || ciphertext || tag) with a 12-byte nonce and a 16-byte tag.
+//
+// Each message is encrypted and authenticated with keys derived from the key
+// and its nonce, which takes 4 or 6 AES blocks and a key schedule; for a small
+// message this costs as much as the encryption itself, and each step depends
+// on the previous one. Hence the key derivation blocks of all messages are
+// encrypted together, 8 at a time, and the key schedules, POLYVAL, tags and
+// CTR encryption of 4 messages are computed in parallel lanes, so that their
+// independent AES-NI and PCLMULQDQ instructions fill the pipelines.
+//
+// The implementation is only compiled in when the target supports these
+// instructions, e.g. with --copt=-maes --copt=-mpclmul --copt=-msse4.1, and
+// used when the CPU supports them at run time (see cpu_features.h).
+//
+// This class is thread-safe.
+class AesGcmSivMultiBuffer {
+ public:
+  static constexpr size_t kNonceSize = 12;
+  static constexpr size_t kTagSize = 16;
+
+  // Returns an instance keyed with 'key', which must be 16 or 32 bytes long,
+  // or nullptr if no implementation is available or the key size is invalid.
+  static std::unique_ptr<AesGcmSivMultiBuffer> New(
+      const util::SecretData& key);
+
+  // Returns the name of the implementation New() uses, e.g. "AES-NI", or an
+  // empty string if there is none.
+  static absl::string_view Implementation();
+
+  AesGcmSivMultiBuffer(const AesGcmSivMultiBuffer&) = delete;
+  AesGcmSivMultiBuffer& operator=(const AesGcmSivMultiBuffer&) = delete;
+  ~AesGcmSivMultiBuffer();
+
+  // Encrypts each of 'plaintexts' with the corresponding entry of
+  // 'associated_data'. ciphertexts[i] must point to kNonceSize +
+  // plaintexts[i].size() + kTagSize bytes which start with the nonce to use;
+  // the rest is overwritten with the ciphertext and the tag.
+  void Seal(absl::Span<const absl::string_view> plaintexts,
+            absl::Span<const absl::string_view> associated_data,
+            absl::Span<uint8_t* const> ciphertexts) const;
+
+  // Decrypts each of 'ciphertexts', which must be at least kNonceSize +
+  // kTagSize bytes long, with the corresponding entry of 'associated_data'
+  // into plaintexts[i], which must hold ciphertexts[i].size() - kNonceSize -
+  // kTagSize bytes. Returns false if any of the tags does not match, in which
+  // case the plaintexts must not be used.
+  bool Open(absl::Span<const absl::string_view> ciphertexts,
+            absl::Span<const absl::string_view> associated_data,
+            absl::Span<uint8_t* const> plaintexts) const;
+
+ private:
+  AesGcmSivMultiBuffer() {}
+
+  int rounds_;
+  // The round keys of the key-generating key, rounds_ + 1 of them.
+  uint8_t round_keys_[15][16];
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_AES_GCM_SIV_MULTI_BUFFER_H_
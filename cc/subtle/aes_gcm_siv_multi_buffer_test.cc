@@ -0,0 +1,220 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/aes_gcm_siv_multi_buffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "openssl/aead.h"
+#include "tink/subtle/cpu_features.h"
+#include "tink/subtle/random.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/test_util.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+constexpr size_t kNonceSize = AesGcmSivMultiBuffer::kNonceSize;
+constexpr size_t kTagSize = AesGcmSivMultiBuffer::kTagSize;
+
+// Returns (nonce || ciphertext || tag) as computed by BoringSSL.
+std::string ReferenceSeal(const util::SecretData& key, absl::string_view nonce,
+                          absl::string_view plaintext,
+                          absl::string_view associated_data) {
+  const EVP_AEAD* aead = key.size() == 16 ? EVP_aead_aes_128_gcm_siv()
+                                          : EVP_aead_aes_256_gcm_siv();
+  bssl::UniquePtr<EVP_AEAD_CTX> ctx(EVP_AEAD_CTX_new(
+      aead, key.data(), key.size(), EVP_AEAD_DEFAULT_TAG_LENGTH));
+  std::vector<uint8_t> out(plaintext.size() + kTagSize);
+  size_t out_size;
+  uint8_t empty = 0;
+  EXPECT_EQ(1, EVP_AEAD_CTX_seal(
+                   ctx.get(), out.data(), &out_size, out.size(),
+                   reinterpret_cast<const uint8_t*>(nonce.data()),
+                   nonce.size(),
+                   plaintext.empty()
+                       ? &empty
+                       : reinterpret_cast<const uint8_t*>(plaintext.data()),
+                   plaintext.size(),
+                   associated_data.empty()
+                       ? &empty
+                       : reinterpret_cast<const uint8_t*>(
+                             associated_data.data()),
+                   associated_data.size()));
+  return std::string(nonce) +
+         std::string(reinterpret_cast<const char*>(out.data()), out_size);
+}
+
+class AesGcmSivMultiBufferTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (AesGcmSivMultiBuffer::Implementation().empty()) {
+      GTEST_SKIP() << "No multi-buffer implementation available";
+    }
+  }
+};
+
+// Test vectors from RFC 8452, appendix C.
+TEST_F(AesGcmSivMultiBufferTest, Rfc8452TestVectors) {
+  struct TestVector {
+    std::string key;
+    std::string nonce;
+    std::string plaintext;
+    std::string associated_data;
+    std::string ciphertext_and_tag;
+  };
+  std::vector<TestVector> test_vectors = {
+      {"01000000000000000000000000000000", "030000000000000000000000", "",
+       "", "dc20e2d83f25705bb49e439eca56de25"},
+      {"01000000000000000000000000000000", "030000000000000000000000",
+       "0100000000000000", "",
+       "b5d839330ac7b786578782fff6013b815b287c22493a364c"},
+  };
+  for (const TestVector& test_vector : test_vectors) {
+    auto aes_gcm_siv = AesGcmSivMultiBuffer::New(
+        util::SecretDataFromStringView(test::HexDecodeOrDie(test_vector.key)));
+    ASSERT_NE(aes_gcm_siv, nullptr);
+    std::string plaintext = test::HexDecodeOrDie(test_vector.plaintext);
+    std::string associated_data =
+        test::HexDecodeOrDie(test_vector.associated_data);
+    std::string ciphertext = test::HexDecodeOrDie(test_vector.nonce);
+    ciphertext.resize(kNonceSize + plaintext.size() + kTagSize);
+    std::vector<absl::string_view> plaintexts = {plaintext, plaintext};
+    std::vector<absl::string_view> associated_data_views = {associated_data,
+                                                            associated_data};
+    std::string other_ciphertext = ciphertext;
+    std::vector<uint8_t*> outs = {
+        reinterpret_cast<uint8_t*>(&ciphertext[0]),
+        reinterpret_cast<uint8_t*>(&other_ciphertext[0])};
+    aes_gcm_siv->Seal(plaintexts, associated_data_views, outs);
+    EXPECT_EQ(test::HexEncode(ciphertext.substr(kNonceSize)),
+              test_vector.ciphertext_and_tag);
+    EXPECT_EQ(ciphertext, other_ciphertext);
+  }
+}
+
+// Checks messages of all lengths up to a few blocks, with associated data of
+// several lengths, in batches of several sizes against BoringSSL.
+TEST_F(AesGcmSivMultiBufferTest, MatchesReference) {
+  for (size_t key_size : {16, 32}) {
+    util::SecretData key = Random::GetRandomKeyBytes(key_size);
+    auto aes_gcm_siv = AesGcmSivMultiBuffer::New(key);
+    ASSERT_NE(aes_gcm_siv, nullptr);
+
+    std::vector<std::string> plaintexts;
+    std::vector<std::string> associated_data;
+    for (int size = 0; size <= 150; size++) {
+      plaintexts.push_back(Random::GetRandomBytes(size));
+      associated_data.push_back(Random::GetRandomBytes((size * 7) % 41));
+    }
+    plaintexts.push_back(Random::GetRandomBytes(5000));
+    associated_data.push_back("");
+    for (size_t batch_size :
+         {size_t{1}, size_t{3}, size_t{5}, plaintexts.size()}) {
+      std::vector<absl::string_view> batch(plaintexts.begin(),
+                                           plaintexts.begin() + batch_size);
+      std::vector<absl::string_view> batch_associated_data(
+          associated_data.begin(), associated_data.begin() + batch_size);
+      std::vector<std::string> ciphertexts(batch_size);
+      std::vector<uint8_t*> outs(batch_size);
+      for (size_t i = 0; i < batch_size; i++) {
+        ciphertexts[i] = Random::GetRandomBytes(kNonceSize);
+        ciphertexts[i].resize(kNonceSize + batch[i].size() + kTagSize);
+        outs[i] = reinterpret_cast<uint8_t*>(&ciphertexts[i][0]);
+      }
+      aes_gcm_siv->Seal(batch, batch_associated_data, outs);
+
+      std::vector<std::string> decrypted(batch_size);
+      std::vector<uint8_t*> plaintext_outs(batch_size);
+      for (size_t i = 0; i < batch_size; i++) {
+        EXPECT_EQ(ReferenceSeal(key, ciphertexts[i].substr(0, kNonceSize),
+                                batch[i], batch_associated_data[i]),
+                  ciphertexts[i])
+            << "message size " << batch[i].size();
+        decrypted[i].resize(batch[i].size());
+        plaintext_outs[i] = reinterpret_cast<uint8_t*>(&decrypted[i][0]);
+      }
+      std::vector<absl::string_view> ciphertext_views(ciphertexts.begin(),
+                                                      ciphertexts.end());
+      EXPECT_TRUE(aes_gcm_siv->Open(ciphertext_views, batch_associated_data,
+                                    plaintext_outs));
+      for (size_t i = 0; i < batch_size; i++) {
+        EXPECT_EQ(batch[i], decrypted[i]);
+      }
+    }
+  }
+}
+
+TEST_F(AesGcmSivMultiBufferTest, OpenFailsIfAnyTagIsWrong) {
+  util::SecretData key = Random::GetRandomKeyBytes(16);
+  auto aes_gcm_siv = AesGcmSivMultiBuffer::New(key);
+  ASSERT_NE(aes_gcm_siv, nullptr);
+  std::vector<std::string> ciphertexts;
+  for (int i = 0; i < 10; i++) {
+    ciphertexts.push_back(ReferenceSeal(key,
+                                        Random::GetRandomBytes(kNonceSize),
+                                        "plaintext", "associated data"));
+  }
+  std::vector<absl::string_view> associated_data(10, "associated data");
+  std::string plaintexts(10 * 9, '\0');
+  std::vector<uint8_t*> outs;
+  for (int i = 0; i < 10; i++) {
+    outs.push_back(reinterpret_cast<uint8_t*>(&plaintexts[9 * i]));
+  }
+  std::vector<absl::string_view> views(ciphertexts.begin(), ciphertexts.end());
+  ASSERT_TRUE(aes_gcm_siv->Open(views, associated_data, outs));
+
+  for (size_t position :
+       {size_t{0}, kNonceSize, ciphertexts[7].size() - 1}) {
+    std::string modified = ciphertexts[7];
+    modified[position] ^= 1;
+    views[7] = modified;
+    EXPECT_FALSE(aes_gcm_siv->Open(views, associated_data, outs));
+  }
+  views[7] = ciphertexts[7];
+  associated_data[3] = "other associated data";
+  EXPECT_FALSE(aes_gcm_siv->Open(views, associated_data, outs));
+}
+
+TEST_F(AesGcmSivMultiBufferTest, EmptyBatch) {
+  auto aes_gcm_siv = AesGcmSivMultiBuffer::New(Random::GetRandomKeyBytes(32));
+  ASSERT_NE(aes_gcm_siv, nullptr);
+  aes_gcm_siv->Seal({}, {}, {});
+  EXPECT_TRUE(aes_gcm_siv->Open({}, {}, {}));
+}
+
+TEST_F(AesGcmSivMultiBufferTest, InvalidKeySize) {
+  EXPECT_EQ(AesGcmSivMultiBuffer::New(Random::GetRandomKeyBytes(24)), nullptr);
+}
+
+TEST(AesGcmSivMultiBufferWithoutCpuFeaturesTest, NotAvailable) {
+  SetCpuFeatureDisabled(CpuFeature::kAesNi, true);
+  EXPECT_EQ(AesGcmSivMultiBuffer::Implementation(), "");
+  EXPECT_EQ(AesGcmSivMultiBuffer::New(Random::GetRandomKeyBytes(16)), nullptr);
+  SetCpuFeatureDisabled(CpuFeature::kAesNi, false);
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
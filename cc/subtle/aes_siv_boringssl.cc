@@ -18,11 +18,15 @@
 
 #include <algorithm>
 #include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
 
 #include "absl/memory/memory.h"
 #include "openssl/aes.h"
 #include "openssl/mem.h"
 #include "tink/deterministic_aead.h"
+#include "tink/subtle/subtle_util.h"
 #include "tink/util/errors.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
@@ -34,7 +38,8 @@ namespace {
 
 crypto::tink::util::StatusOr<util::SecretUniquePtr<AES_KEY>> InitializeAesKey(
     absl::Span<const uint8_t> key) {
-  util::SecretUniquePtr<AES_KEY> aes_key = util::MakeSecretUniquePtr<AES_KEY>();
+  util::SecretUniquePtr<AES_KEY> aes_key =
+      util::MakeKeyStateUniquePtr<AES_KEY>();
   if (AES_set_encrypt_key(reinterpret_cast<const uint8_t*>(key.data()),
                           8 * key.size(), aes_key.get()) != 0) {
     return util::Status(util::error::INTERNAL, "could not initialize aes key");
@@ -79,6 +84,13 @@ util::SecretData AesSivBoringSsl::ComputeCmacK2() const {
   return cmac_k2;
 }
 
+util::SecretData AesSivBoringSsl::ComputeS2vInitialBlock() const {
+  util::SecretData block(kBlockSize, 0);
+  Cmac(block, block.data());
+  MultiplyByX(block.data());
+  return block;
+}
+
 void AesSivBoringSsl::CtrCrypt(const uint8_t siv[kBlockSize],
                                absl::Span<const uint8_t> in,
                                uint8_t* out) const {
@@ -172,19 +184,18 @@ void AesSivBoringSsl::CmacLong(absl::Span<const uint8_t> data,
   EncryptBlock(block, mac);
 }
 
-void AesSivBoringSsl::S2v(absl::Span<const uint8_t> aad,
-                          absl::Span<const uint8_t> msg,
-                          uint8_t siv[kBlockSize]) const {
-  // This stuff could be precomputed.
-  uint8_t block[kBlockSize];
-  std::fill(std::begin(block), std::end(block), 0);
-  Cmac(block, block);
-  MultiplyByX(block);
-
+void AesSivBoringSsl::S2vProcessAad(absl::Span<const uint8_t> aad,
+                                    uint8_t aad_state[kBlockSize]) const {
   uint8_t aad_mac[kBlockSize];
   Cmac(aad, aad_mac);
-  XorBlock(block, aad_mac, block);
+  XorBlock(s2v_initial_block_.data(), aad_mac, aad_state);
+}
 
+void AesSivBoringSsl::S2vFinish(const uint8_t aad_state[kBlockSize],
+                                absl::Span<const uint8_t> msg,
+                                uint8_t siv[kBlockSize]) const {
+  uint8_t block[kBlockSize];
+  std::copy_n(aad_state, kBlockSize, block);
   if (msg.size() >= kBlockSize) {
     CmacLong(msg, block, siv);
   } else {
@@ -199,42 +210,178 @@ void AesSivBoringSsl::S2v(absl::Span<const uint8_t> aad,
 
 util::StatusOr<std::string> AesSivBoringSsl::EncryptDeterministically(
     absl::string_view plaintext, absl::string_view additional_data) const {
-  uint8_t siv[kBlockSize];
-  S2v(absl::MakeSpan(reinterpret_cast<const uint8_t*>(additional_data.data()),
+  uint8_t aad_state[kBlockSize];
+  S2vProcessAad(
+      absl::MakeSpan(reinterpret_cast<const uint8_t*>(additional_data.data()),
                      additional_data.size()),
-      absl::MakeSpan(reinterpret_cast<const uint8_t*>(plaintext.data()),
-                     plaintext.size()),
-      siv);
-  size_t ciphertext_size = plaintext.size() + kBlockSize;
-  std::vector<uint8_t> ct(ciphertext_size);
-  std::copy(std::begin(siv), std::end(siv), ct.begin());
+      aad_state);
+  return EncryptWithAadState(aad_state, plaintext);
+}
+
+util::StatusOr<std::string> AesSivBoringSsl::DecryptDeterministically(
+    absl::string_view ciphertext, absl::string_view additional_data) const {
+  uint8_t aad_state[kBlockSize];
+  S2vProcessAad(
+      absl::MakeSpan(reinterpret_cast<const uint8_t*>(additional_data.data()),
+                     additional_data.size()),
+      aad_state);
+  return DecryptWithAadState(aad_state, ciphertext);
+}
+
+util::StatusOr<std::string> AesSivBoringSsl::EncryptWithAadState(
+    const uint8_t aad_state[kBlockSize], absl::string_view plaintext) const {
+  uint8_t siv[kBlockSize];
+  S2vFinish(aad_state,
+            absl::MakeSpan(reinterpret_cast<const uint8_t*>(plaintext.data()),
+                           plaintext.size()),
+            siv);
+  // Encrypts directly into the result, instead of into a buffer that is
+  // copied afterwards.
+  std::string ciphertext;
+  ResizeStringUninitialized(&ciphertext, plaintext.size() + kBlockSize);
+  uint8_t* ct = reinterpret_cast<uint8_t*>(&ciphertext[0]);
+  std::copy(std::begin(siv), std::end(siv), ct);
   CtrCrypt(siv,
            absl::MakeSpan(reinterpret_cast<const uint8_t*>(plaintext.data()),
                           plaintext.size()),
-           ct.data() + kBlockSize);
-  return std::string(reinterpret_cast<const char*>(ct.data()), ciphertext_size);
+           ct + kBlockSize);
+  return ciphertext;
 }
 
-util::StatusOr<std::string> AesSivBoringSsl::DecryptDeterministically(
-    absl::string_view ciphertext, absl::string_view additional_data) const {
+util::StatusOr<std::string> AesSivBoringSsl::DecryptWithAadState(
+    const uint8_t aad_state[kBlockSize], absl::string_view ciphertext) const {
   if (ciphertext.size() < kBlockSize) {
     return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too short");
   }
   size_t plaintext_size = ciphertext.size() - kBlockSize;
-  std::vector<uint8_t> pt(plaintext_size);
+  std::string plaintext;
+  ResizeStringUninitialized(&plaintext, plaintext_size);
+  uint8_t* pt = reinterpret_cast<uint8_t*>(&plaintext[0]);
   const uint8_t *siv = reinterpret_cast<const uint8_t*>(&ciphertext[0]);
   const uint8_t* ct =
       reinterpret_cast<const uint8_t*>(&ciphertext[0]) + kBlockSize;
-  CtrCrypt(siv, absl::MakeSpan(ct, plaintext_size), pt.data());
+  CtrCrypt(siv, absl::MakeSpan(ct, plaintext_size), pt);
 
   uint8_t s2v[kBlockSize];
-  S2v(absl::MakeSpan(reinterpret_cast<const uint8_t*>(additional_data.data()),
-                     additional_data.size()),
-      absl::MakeSpan(pt), s2v);
+  S2vFinish(aad_state, absl::MakeSpan(pt, plaintext_size), s2v);
   if (CRYPTO_memcmp(siv, s2v, kBlockSize) != 0) {
-    return util::Status(util::error::INVALID_ARGUMENT, "invalid ciphertext");
+    // Do not leave the unauthenticated plaintext in freed memory.
+    OPENSSL_cleanse(pt, plaintext_size);
+    static const util::Status* kInvalidCiphertext =
+        util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                                "invalid ciphertext");
+    return *kInvalidCiphertext;
+  }
+  return plaintext;
+}
+
+util::Status AesSivBoringSsl::EncryptDeterministicallyBatch(
+    absl::Span<const absl::string_view> plaintexts,
+    absl::string_view additional_data, std::string* ciphertexts,
+    std::vector<int64_t>* offsets) const {
+  uint8_t aad_state[kBlockSize];
+  S2vProcessAad(
+      absl::MakeSpan(reinterpret_cast<const uint8_t*>(additional_data.data()),
+                     additional_data.size()),
+      aad_state);
+
+  int64_t total_size = 0;
+  for (absl::string_view plaintext : plaintexts) {
+    total_size += plaintext.size() + kBlockSize;
   }
-  return std::string(reinterpret_cast<const char*>(pt.data()), plaintext_size);
+  ResizeStringUninitialized(ciphertexts, total_size);
+  uint8_t* out = reinterpret_cast<uint8_t*>(&(*ciphertexts)[0]);
+  offsets->assign(1, 0);
+  offsets->reserve(plaintexts.size() + 1);
+  int64_t position = 0;
+  for (absl::string_view plaintext : plaintexts) {
+    absl::Span<const uint8_t> pt = absl::MakeSpan(
+        reinterpret_cast<const uint8_t*>(plaintext.data()), plaintext.size());
+    uint8_t* siv = out + position;
+    S2vFinish(aad_state, pt, siv);
+    CtrCrypt(siv, pt, siv + kBlockSize);
+    position += kBlockSize + plaintext.size();
+    offsets->push_back(position);
+  }
+  return util::Status::OK;
+}
+
+util::Status AesSivBoringSsl::DecryptDeterministicallyBatch(
+    absl::Span<const absl::string_view> ciphertexts,
+    absl::string_view additional_data, std::string* plaintexts,
+    std::vector<int64_t>* offsets) const {
+  int64_t total_size = 0;
+  for (absl::string_view ciphertext : ciphertexts) {
+    if (ciphertext.size() < kBlockSize) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "ciphertext too short");
+    }
+    total_size += ciphertext.size() - kBlockSize;
+  }
+  uint8_t aad_state[kBlockSize];
+  S2vProcessAad(
+      absl::MakeSpan(reinterpret_cast<const uint8_t*>(additional_data.data()),
+                     additional_data.size()),
+      aad_state);
+
+  ResizeStringUninitialized(plaintexts, total_size);
+  uint8_t* out = reinterpret_cast<uint8_t*>(&(*plaintexts)[0]);
+  offsets->assign(1, 0);
+  offsets->reserve(ciphertexts.size() + 1);
+  int64_t position = 0;
+  for (absl::string_view ciphertext : ciphertexts) {
+    const uint8_t* siv = reinterpret_cast<const uint8_t*>(ciphertext.data());
+    size_t plaintext_size = ciphertext.size() - kBlockSize;
+    uint8_t* pt = out + position;
+    CtrCrypt(siv, absl::MakeSpan(siv + kBlockSize, plaintext_size), pt);
+    uint8_t s2v[kBlockSize];
+    S2vFinish(aad_state, absl::MakeSpan(pt, plaintext_size), s2v);
+    if (CRYPTO_memcmp(siv, s2v, kBlockSize) != 0) {
+      // Do not leave the plaintexts of the batch in freed memory.
+      OPENSSL_cleanse(out, position + plaintext_size);
+      plaintexts->clear();
+      offsets->clear();
+      static const util::Status* kInvalidCiphertext =
+          util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                                  "invalid ciphertext");
+      return *kInvalidCiphertext;
+    }
+    position += plaintext_size;
+    offsets->push_back(position);
+  }
+  return util::Status::OK;
+}
+
+// Holds the S2V state for one additional data.
+class AesSivBoringSsl::PreparedAesSiv : public PreparedDeterministicAead {
+ public:
+  PreparedAesSiv(const AesSivBoringSsl* aes_siv, util::SecretData aad_state)
+      : aes_siv_(aes_siv), aad_state_(std::move(aad_state)) {}
+
+  util::StatusOr<std::string> EncryptDeterministically(
+      absl::string_view plaintext) const override {
+    return aes_siv_->EncryptWithAadState(aad_state_.data(), plaintext);
+  }
+
+  util::StatusOr<std::string> DecryptDeterministically(
+      absl::string_view ciphertext) const override {
+    return aes_siv_->DecryptWithAadState(aad_state_.data(), ciphertext);
+  }
+
+ private:
+  const AesSivBoringSsl* aes_siv_;
+  const util::SecretData aad_state_;
+};
+
+util::StatusOr<std::unique_ptr<PreparedDeterministicAead>>
+AesSivBoringSsl::PrepareAssociatedData(
+    absl::string_view additional_data) const {
+  util::SecretData aad_state(kBlockSize);
+  S2vProcessAad(
+      absl::MakeSpan(reinterpret_cast<const uint8_t*>(additional_data.data()),
+                     additional_data.size()),
+      aad_state.data());
+  return {absl::make_unique<PreparedAesSiv>(this, std::move(aad_state))};
 }
 
 }  // namespace subtle
@@ -17,7 +17,10 @@
 #ifndef TINK_SUBTLE_AES_SIV_BORINGSSL_H_
 #define TINK_SUBTLE_AES_SIV_BORINGSSL_H_
 
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
@@ -67,6 +70,23 @@ class AesSivBoringSsl : public DeterministicAead {
       absl::string_view ciphertext,
       absl::string_view additional_data) const override;
 
+  // Computes the part of S2V that depends on 'additional_data' only once for
+  // the whole batch.
+  crypto::tink::util::Status EncryptDeterministicallyBatch(
+      absl::Span<const absl::string_view> plaintexts,
+      absl::string_view additional_data, std::string* ciphertexts,
+      std::vector<int64_t>* offsets) const override;
+
+  crypto::tink::util::Status DecryptDeterministicallyBatch(
+      absl::Span<const absl::string_view> ciphertexts,
+      absl::string_view additional_data, std::string* plaintexts,
+      std::vector<int64_t>* offsets) const override;
+
+  // Computes the part of S2V that depends on 'additional_data' once, so that
+  // the returned object only processes the messages.
+  crypto::tink::util::StatusOr<std::unique_ptr<PreparedDeterministicAead>>
+  PrepareAssociatedData(absl::string_view additional_data) const override;
+
   static bool IsValidKeySizeInBytes(size_t size) {
     return size == 64;
   }
@@ -75,6 +95,8 @@ class AesSivBoringSsl : public DeterministicAead {
       crypto::tink::FipsCompatibility::kNotFips;
 
  private:
+  class PreparedAesSiv;
+
   static constexpr size_t kBlockSize = 16;
 
   AesSivBoringSsl(util::SecretUniquePtr<AES_KEY> k1,
@@ -82,12 +104,16 @@ class AesSivBoringSsl : public DeterministicAead {
       : k1_(std::move(k1)),
         k2_(std::move(k2)),
         cmac_k1_(ComputeCmacK1()),
-        cmac_k2_(ComputeCmacK2()) {}
+        cmac_k2_(ComputeCmacK2()),
+        s2v_initial_block_(ComputeS2vInitialBlock()) {}
 
   // Precomputes cmac_k1
   util::SecretData ComputeCmacK1() const;
   // Precomputes cmac_k2
   util::SecretData ComputeCmacK2() const;
+  // Precomputes s2v_initial_block, the doubled CMAC of the zero block that
+  // S2V starts with. It only depends on the key.
+  util::SecretData ComputeS2vInitialBlock() const;
 
   // Encrypts (or decrypts) the bytes in in using an SIV and
   // writes the result to out.
@@ -117,13 +143,28 @@ class AesSivBoringSsl : public DeterministicAead {
   static void XorBlock(const uint8_t x[kBlockSize], const uint8_t y[kBlockSize],
                        uint8_t res[kBlockSize]);
 
-  void S2v(absl::Span<const uint8_t> aad, absl::Span<const uint8_t> msg,
-           uint8_t siv[kBlockSize]) const;
+  // Computes the state of S2V after processing 'aad', which only depends on
+  // the key and 'aad'.
+  void S2vProcessAad(absl::Span<const uint8_t> aad,
+                     uint8_t aad_state[kBlockSize]) const;
+
+  // Completes S2V for 'msg', starting from the state computed by
+  // S2vProcessAad().
+  void S2vFinish(const uint8_t aad_state[kBlockSize],
+                 absl::Span<const uint8_t> msg, uint8_t siv[kBlockSize]) const;
+
+  // Encrypts and decrypts a single message, given the state computed by
+  // S2vProcessAad() for the additional data.
+  crypto::tink::util::StatusOr<std::string> EncryptWithAadState(
+      const uint8_t aad_state[kBlockSize], absl::string_view plaintext) const;
+  crypto::tink::util::StatusOr<std::string> DecryptWithAadState(
+      const uint8_t aad_state[kBlockSize], absl::string_view ciphertext) const;
 
   const util::SecretUniquePtr<AES_KEY> k1_;
   const util::SecretUniquePtr<AES_KEY> k2_;
   const util::SecretData cmac_k1_;
   const util::SecretData cmac_k2_;
+  const util::SecretData s2v_initial_block_;
 };
 
 }  // namespace subtle
@@ -32,6 +32,7 @@ namespace tink {
 namespace subtle {
 namespace {
 
+using ::crypto::tink::test::IsOk;
 using ::crypto::tink::test::StatusIs;
 
 TEST(AesSivBoringSslTest, testCarryComputation) {
@@ -69,6 +70,94 @@ TEST(AesSivBoringSslTest, testEncryptDecrypt) {
   EXPECT_EQ(pt.ValueOrDie(), message);
 }
 
+TEST(AesSivBoringSslTest, testBatchMatchesSingleRecord) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  util::SecretData key = util::SecretDataFromStringView(test::HexDecodeOrDie(
+      "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+      "00112233445566778899aabbccddeefff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff"));
+  auto res = AesSivBoringSsl::New(key);
+  EXPECT_TRUE(res.ok()) << res.status();
+  auto cipher = std::move(res.ValueOrDie());
+  std::string aad = "Additional data";
+  std::vector<std::string> messages = {"", "a", std::string(16, 'b'),
+                                       std::string(17, 'c'),
+                                       std::string(1000, 'd')};
+  std::vector<absl::string_view> message_views(messages.begin(),
+                                               messages.end());
+  std::string cts;
+  std::vector<int64_t> ct_offsets;
+  ASSERT_THAT(cipher->EncryptDeterministicallyBatch(message_views, aad, &cts,
+                                                    &ct_offsets),
+              IsOk());
+  ASSERT_EQ(ct_offsets.size(), messages.size() + 1);
+  std::vector<absl::string_view> ct_views;
+  for (size_t i = 0; i < messages.size(); i++) {
+    ct_views.push_back(absl::string_view(cts).substr(
+        ct_offsets[i], ct_offsets[i + 1] - ct_offsets[i]));
+    auto ct = cipher->EncryptDeterministically(messages[i], aad);
+    ASSERT_TRUE(ct.ok()) << ct.status();
+    EXPECT_EQ(ct_views[i], ct.ValueOrDie());
+  }
+
+  std::string pts;
+  std::vector<int64_t> pt_offsets;
+  ASSERT_THAT(cipher->DecryptDeterministicallyBatch(ct_views, aad, &pts,
+                                                    &pt_offsets),
+              IsOk());
+  ASSERT_EQ(pt_offsets.size(), messages.size() + 1);
+  for (size_t i = 0; i < messages.size(); i++) {
+    EXPECT_EQ(absl::string_view(pts).substr(pt_offsets[i],
+                                            pt_offsets[i + 1] - pt_offsets[i]),
+              messages[i]);
+  }
+
+  // Modifying one ciphertext makes the whole batch fail.
+  std::string modified(ct_views[3]);
+  modified[0] ^= 1;
+  ct_views[3] = modified;
+  EXPECT_THAT(cipher->DecryptDeterministicallyBatch(ct_views, aad, &pts,
+                                                    &pt_offsets),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_TRUE(pts.empty());
+  EXPECT_TRUE(pt_offsets.empty());
+}
+
+TEST(AesSivBoringSslTest, testPrepareAssociatedData) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  util::SecretData key = util::SecretDataFromStringView(test::HexDecodeOrDie(
+      "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"
+      "00112233445566778899aabbccddeefff0f1f2f3f4f5f6f7f8f9fafbfcfdfeff"));
+  auto res = AesSivBoringSsl::New(key);
+  EXPECT_TRUE(res.ok()) << res.status();
+  auto cipher = std::move(res.ValueOrDie());
+  std::string aad = "Additional data";
+  auto prepared_result = cipher->PrepareAssociatedData(aad);
+  ASSERT_TRUE(prepared_result.ok()) << prepared_result.status();
+  auto prepared = std::move(prepared_result.ValueOrDie());
+  for (int i = 0; i < 40; i++) {
+    std::string message(i, 'x');
+    auto ct = prepared->EncryptDeterministically(message);
+    ASSERT_TRUE(ct.ok()) << ct.status();
+    auto expected_ct = cipher->EncryptDeterministically(message, aad);
+    ASSERT_TRUE(expected_ct.ok()) << expected_ct.status();
+    EXPECT_EQ(ct.ValueOrDie(), expected_ct.ValueOrDie());
+    auto pt = prepared->DecryptDeterministically(ct.ValueOrDie());
+    ASSERT_TRUE(pt.ok()) << pt.status();
+    EXPECT_EQ(pt.ValueOrDie(), message);
+  }
+
+  // A ciphertext for other associated data does not decrypt.
+  auto other_ct = cipher->EncryptDeterministically("message", "other");
+  ASSERT_TRUE(other_ct.ok()) << other_ct.status();
+  EXPECT_THAT(
+      prepared->DecryptDeterministically(other_ct.ValueOrDie()).status(),
+      StatusIs(util::error::INVALID_ARGUMENT));
+}
+
 TEST(AesSivBoringSslTest, testNullPtrStringView) {
   if (kUseOnlyFips) {
     GTEST_SKIP() << "Not supported in FIPS-only mode";
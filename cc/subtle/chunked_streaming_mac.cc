@@ -0,0 +1,341 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/chunked_streaming_mac.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "openssl/mem.h"
+#include "tink/output_stream_with_result.h"
+#include "tink/subtle/mac/stateful_mac.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+namespace {
+
+constexpr char kChunkPrefix = 0x00;
+constexpr char kTagPrefix = 0x01;
+
+std::string BigEndian64(uint64_t value) {
+  std::string result(8, 0);
+  for (int i = 7; i >= 0; i--) {
+    result[i] = static_cast<char>(value & 0xff);
+    value >>= 8;
+  }
+  return result;
+}
+
+// Returns t_i = M(0x00 || BigEndian64(i) || c_i).
+util::StatusOr<std::string> ComputeChunkTag(
+    const StatefulMacFactory& mac_factory, uint64_t index,
+    const std::vector<uint8_t>& chunk) {
+  auto mac_result = mac_factory.Create();
+  if (!mac_result.ok()) return mac_result.status();
+  StatefulMac* mac = mac_result.ValueOrDie().get();
+  util::Status status =
+      mac->Update(std::string(1, kChunkPrefix) + BigEndian64(index));
+  if (!status.ok()) return status;
+  status = mac->Update(absl::string_view(
+      reinterpret_cast<const char*>(chunk.data()), chunk.size()));
+  if (!status.ok()) return status;
+  return mac->Finalize();
+}
+
+// Computes the tag of the data written to it, see ChunkedStreamingMac.
+// Full chunks are handed to the workers right away; at most
+// 2 * num_threads chunks are buffered at any time.
+class ChunkedComputeMacOutputStream
+    : public OutputStreamWithResult<std::string> {
+ public:
+  ChunkedComputeMacOutputStream(
+      std::shared_ptr<const StatefulMacFactory> mac_factory,
+      std::unique_ptr<StatefulMac> tag_mac, int chunk_size, int num_threads);
+  ~ChunkedComputeMacOutputStream() override;
+
+  util::StatusOr<int> NextBuffer(void** buffer) override;
+  util::StatusOr<std::string> CloseStreamAndComputeResult() override;
+  void BackUp(int count) override;
+  int64_t Position() const override { return position_; }
+
+ private:
+  // A chunk handed to the workers.
+  struct Job {
+    uint64_t index;
+    std::vector<uint8_t> chunk;
+    util::StatusOr<std::string> chunk_tag;
+    bool done = false;
+  };
+
+  // Queues chunk_ for the workers, and leaves an empty chunk_ behind.
+  void Submit();
+
+  // Adds the tags of the chunks that are done, in order, to tag_mac_,
+  // blocking until at most 'max_pending' chunks are still in flight.
+  util::Status AddCompleted(int max_pending);
+
+  void WorkerLoop();
+  bool HasQueuedJobOrShutdown() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  bool IsFrontDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const std::shared_ptr<const StatefulMacFactory> mac_factory_;
+  const std::unique_ptr<StatefulMac> tag_mac_;
+  const int chunk_size_;
+  const int max_in_flight_;
+  util::Status status_;
+  int64_t position_;
+  uint64_t num_chunks_;
+  // The current chunk, of which the first 'chunk_position_' bytes are data,
+  // and the size of the buffer returned by the last NextBuffer().
+  std::vector<uint8_t> chunk_;
+  int chunk_position_;
+  int last_buffer_size_;
+  std::vector<std::vector<uint8_t>> free_chunks_;
+
+  absl::Mutex mu_;
+  // Chunks that were submitted but whose tags are not yet added, in order.
+  std::deque<std::unique_ptr<Job>> in_flight_ ABSL_GUARDED_BY(mu_);
+  // Chunks of in_flight_ that no worker has picked up yet.
+  std::deque<Job*> queued_ ABSL_GUARDED_BY(mu_);
+  bool shutdown_ ABSL_GUARDED_BY(mu_) = false;
+  std::vector<std::thread> workers_;
+};
+
+ChunkedComputeMacOutputStream::ChunkedComputeMacOutputStream(
+    std::shared_ptr<const StatefulMacFactory> mac_factory,
+    std::unique_ptr<StatefulMac> tag_mac, int chunk_size, int num_threads)
+    : mac_factory_(std::move(mac_factory)),
+      tag_mac_(std::move(tag_mac)),
+      chunk_size_(chunk_size),
+      max_in_flight_(2 * num_threads),
+      status_(util::OkStatus()),
+      position_(0),
+      num_chunks_(0),
+      chunk_(chunk_size),
+      chunk_position_(0),
+      last_buffer_size_(0) {
+  status_ = tag_mac_->Update(absl::string_view(&kTagPrefix, 1));
+  workers_.reserve(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    workers_.emplace_back([this]() { WorkerLoop(); });
+  }
+}
+
+ChunkedComputeMacOutputStream::~ChunkedComputeMacOutputStream() {
+  {
+    absl::MutexLock lock(&mu_);
+    shutdown_ = true;
+  }
+  for (auto& worker : workers_) worker.join();
+}
+
+bool ChunkedComputeMacOutputStream::HasQueuedJobOrShutdown() const {
+  return shutdown_ || !queued_.empty();
+}
+
+bool ChunkedComputeMacOutputStream::IsFrontDone() const {
+  return in_flight_.front()->done;
+}
+
+void ChunkedComputeMacOutputStream::WorkerLoop() {
+  while (true) {
+    Job* job;
+    {
+      absl::MutexLock lock(&mu_);
+      mu_.Await(absl::Condition(
+          this, &ChunkedComputeMacOutputStream::HasQueuedJobOrShutdown));
+      if (shutdown_) return;
+      job = queued_.front();
+      queued_.pop_front();
+    }
+    // The job is owned by in_flight_, which does not release it before it is
+    // marked as done, so it can be accessed without holding the lock.
+    util::StatusOr<std::string> chunk_tag =
+        ComputeChunkTag(*mac_factory_, job->index, job->chunk);
+    absl::MutexLock lock(&mu_);
+    job->chunk_tag = std::move(chunk_tag);
+    job->done = true;
+  }
+}
+
+void ChunkedComputeMacOutputStream::Submit() {
+  auto job = absl::make_unique<Job>();
+  job->index = num_chunks_++;
+  chunk_.resize(chunk_position_);
+  job->chunk.swap(chunk_);
+  if (!free_chunks_.empty()) {
+    chunk_.swap(free_chunks_.back());
+    free_chunks_.pop_back();
+  }
+  chunk_.resize(chunk_size_);
+  chunk_position_ = 0;
+  last_buffer_size_ = 0;
+  absl::MutexLock lock(&mu_);
+  queued_.push_back(job.get());
+  in_flight_.push_back(std::move(job));
+}
+
+util::Status ChunkedComputeMacOutputStream::AddCompleted(int max_pending) {
+  while (true) {
+    std::unique_ptr<Job> job;
+    {
+      absl::MutexLock lock(&mu_);
+      if (in_flight_.empty()) return util::OkStatus();
+      if (!in_flight_.front()->done) {
+        if (in_flight_.size() <= max_pending) return util::OkStatus();
+        mu_.Await(absl::Condition(
+            this, &ChunkedComputeMacOutputStream::IsFrontDone));
+      }
+      job = std::move(in_flight_.front());
+      in_flight_.pop_front();
+    }
+    if (!job->chunk_tag.ok()) return job->chunk_tag.status();
+    util::Status status = tag_mac_->Update(job->chunk_tag.ValueOrDie());
+    if (!status.ok()) return status;
+    // Clear the chunk, so that the data cannot be accessed later.
+    OPENSSL_cleanse(job->chunk.data(), job->chunk.size());
+    free_chunks_.push_back(std::move(job->chunk));
+  }
+}
+
+util::StatusOr<int> ChunkedComputeMacOutputStream::NextBuffer(void** buffer) {
+  if (!status_.ok()) return status_;
+  if (chunk_position_ == chunk_size_) {
+    Submit();
+    status_ = AddCompleted(max_in_flight_);
+    if (!status_.ok()) return status_;
+  }
+  *buffer = chunk_.data() + chunk_position_;
+  last_buffer_size_ = chunk_size_ - chunk_position_;
+  chunk_position_ = chunk_size_;
+  position_ += last_buffer_size_;
+  return last_buffer_size_;
+}
+
+void ChunkedComputeMacOutputStream::BackUp(int count) {
+  if (!status_.ok() || count < 1) return;
+  count = std::min(count, last_buffer_size_);
+  last_buffer_size_ -= count;
+  chunk_position_ -= count;
+  position_ -= count;
+}
+
+util::StatusOr<std::string>
+ChunkedComputeMacOutputStream::CloseStreamAndComputeResult() {
+  if (!status_.ok()) return status_;
+  // The last chunk is empty only if all of the data is.
+  if (chunk_position_ > 0 || num_chunks_ == 0) Submit();
+  status_ = AddCompleted(/* max_pending = */ 0);
+  if (!status_.ok()) return status_;
+  status_ = util::Status(util::error::FAILED_PRECONDITION, "Stream Closed");
+  util::Status status = tag_mac_->Update(BigEndian64(num_chunks_));
+  if (!status.ok()) return status;
+  return tag_mac_->Finalize();
+}
+
+// Computes the tag of the data written to it with a
+// ChunkedComputeMacOutputStream, and compares it with the expected one.
+class ChunkedVerifyMacOutputStream
+    : public OutputStreamWithResult<util::Status> {
+ public:
+  ChunkedVerifyMacOutputStream(
+      const std::string& expected,
+      std::unique_ptr<OutputStreamWithResult<std::string>> compute_stream)
+      : expected_(expected), compute_stream_(std::move(compute_stream)) {}
+
+  util::StatusOr<int> NextBuffer(void** buffer) override {
+    return compute_stream_->Next(buffer);
+  }
+
+  util::Status CloseStreamAndComputeResult() override {
+    util::StatusOr<std::string> mac = compute_stream_->CloseAndGetResult();
+    if (!mac.ok()) return mac.status();
+    if (mac.ValueOrDie().size() == expected_.size() &&
+        CRYPTO_memcmp(mac.ValueOrDie().data(), expected_.data(),
+                      expected_.size()) == 0) {
+      return util::OkStatus();
+    }
+    return util::Status(util::error::INVALID_ARGUMENT, "Incorrect MAC");
+  }
+
+  void BackUp(int count) override { compute_stream_->BackUp(count); }
+  int64_t Position() const override { return compute_stream_->Position(); }
+
+ private:
+  const std::string expected_;
+  const std::unique_ptr<OutputStreamWithResult<std::string>> compute_stream_;
+};
+
+}  // namespace
+
+util::StatusOr<std::unique_ptr<StreamingMac>> ChunkedStreamingMac::New(
+    std::unique_ptr<StatefulMacFactory> mac_factory, int chunk_size,
+    int num_threads) {
+  if (mac_factory == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "mac_factory must be non-null");
+  }
+  if (chunk_size <= 0) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "chunk_size must be positive");
+  }
+  if (num_threads <= 0) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "num_threads must be positive");
+  }
+  return {absl::WrapUnique(new ChunkedStreamingMac(
+      std::shared_ptr<const StatefulMacFactory>(std::move(mac_factory)),
+      chunk_size, num_threads))};
+}
+
+util::StatusOr<std::unique_ptr<OutputStreamWithResult<std::string>>>
+ChunkedStreamingMac::NewComputeMacOutputStream() const {
+  auto tag_mac_result = mac_factory_->Create();
+  if (!tag_mac_result.ok()) return tag_mac_result.status();
+  return std::unique_ptr<OutputStreamWithResult<std::string>>(
+      absl::make_unique<ChunkedComputeMacOutputStream>(
+          mac_factory_, std::move(tag_mac_result.ValueOrDie()), chunk_size_,
+          num_threads_));
+}
+
+util::StatusOr<std::unique_ptr<OutputStreamWithResult<util::Status>>>
+ChunkedStreamingMac::NewVerifyMacOutputStream(
+    const std::string& mac_value) const {
+  auto compute_stream_result = NewComputeMacOutputStream();
+  if (!compute_stream_result.ok()) return compute_stream_result.status();
+  return std::unique_ptr<OutputStreamWithResult<util::Status>>(
+      absl::make_unique<ChunkedVerifyMacOutputStream>(
+          mac_value, std::move(compute_stream_result.ValueOrDie())));
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
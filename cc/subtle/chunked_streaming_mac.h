@@ -0,0 +1,80 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_SUBTLE_CHUNKED_STREAMING_MAC_H_
+#define TINK_SUBTLE_CHUNKED_STREAMING_MAC_H_
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "tink/output_stream_with_result.h"
+#include "tink/streaming_mac.h"
+#include "tink/subtle/mac/stateful_mac.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// A StreamingMac which splits the data into chunks of 'chunk_size' bytes,
+// and computes the MACs of the chunks on a pool of worker threads, so that
+// MACing large inputs is not bound to a single core.
+//
+// The data is split into chunks c_0, ..., c_{n-1}, all of which are
+// 'chunk_size' bytes long except for the last one, which is non-empty unless
+// the data is empty (n = 1 then). With the MAC M created by 'mac_factory',
+// which must be a PRF (as HMAC and AES-CMAC are), the tag is
+//   t_i = M(0x00 || BigEndian64(i) || c_i)
+//   tag = M(0x01 || t_0 || ... || t_{n-1} || BigEndian64(n)).
+// The chunk index binds each chunk to its position, and the number of chunks
+// prevents truncating or extending the data by whole chunks.
+//
+// The tags differ from those of StreamingMacImpl with the same MAC.
+class ChunkedStreamingMac : public StreamingMac {
+ public:
+  // Returns a ChunkedStreamingMac whose streams use 'num_threads' worker
+  // threads each. 'chunk_size' and 'num_threads' must be positive.
+  static util::StatusOr<std::unique_ptr<StreamingMac>> New(
+      std::unique_ptr<StatefulMacFactory> mac_factory, int chunk_size,
+      int num_threads);
+
+  util::StatusOr<std::unique_ptr<OutputStreamWithResult<std::string>>>
+  NewComputeMacOutputStream() const override;
+
+  util::StatusOr<std::unique_ptr<OutputStreamWithResult<util::Status>>>
+  NewVerifyMacOutputStream(const std::string& mac_value) const override;
+
+ private:
+  ChunkedStreamingMac(std::shared_ptr<const StatefulMacFactory> mac_factory,
+                      int chunk_size, int num_threads)
+      : mac_factory_(std::move(mac_factory)),
+        chunk_size_(chunk_size),
+        num_threads_(num_threads) {}
+
+  // Shared with the streams, which may outlive this object.
+  const std::shared_ptr<const StatefulMacFactory> mac_factory_;
+  const int chunk_size_;
+  const int num_threads_;
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_CHUNKED_STREAMING_MAC_H_
@@ -0,0 +1,192 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/chunked_streaming_mac.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "tink/subtle/common_enums.h"
+#include "tink/subtle/mac/stateful_mac.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/stateful_hmac_boringssl.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+std::unique_ptr<StatefulMacFactory> HmacFactory(const util::SecretData& key) {
+  return absl::make_unique<StatefulHmacBoringSslFactory>(SHA256, 32, key);
+}
+
+std::string Mac(const util::SecretData& key, const std::string& data) {
+  auto mac = std::move(HmacFactory(key)->Create().ValueOrDie());
+  EXPECT_THAT(mac->Update(data), IsOk());
+  return mac->Finalize().ValueOrDie();
+}
+
+std::string BigEndian64(uint64_t value) {
+  std::string result;
+  for (int shift = 56; shift >= 0; shift -= 8) {
+    result.push_back(static_cast<char>(value >> shift));
+  }
+  return result;
+}
+
+// Computes the tag as specified in chunked_streaming_mac.h.
+std::string ExpectedTag(const util::SecretData& key, const std::string& data,
+                        int chunk_size) {
+  std::string tag_input(1, '\x01');
+  uint64_t num_chunks = 0;
+  size_t position = 0;
+  do {
+    std::string chunk = data.substr(position, chunk_size);
+    tag_input += Mac(key, absl::StrCat(std::string(1, '\x00'),
+                                       BigEndian64(num_chunks), chunk));
+    num_chunks++;
+    position += chunk_size;
+  } while (position < data.size());
+  return Mac(key, tag_input + BigEndian64(num_chunks));
+}
+
+TEST(ChunkedStreamingMacTest, MatchesSpecification) {
+  util::SecretData key =
+      util::SecretDataFromStringView(Random::GetRandomBytes(32));
+  const int chunk_size = 100;
+  for (int num_threads : {1, 4}) {
+    auto streaming_mac_result =
+        ChunkedStreamingMac::New(HmacFactory(key), chunk_size, num_threads);
+    ASSERT_THAT(streaming_mac_result.status(), IsOk());
+    for (int size : {0, 1, 99, 100, 101, 200, 1234, 100000}) {
+      SCOPED_TRACE(absl::StrCat("size ", size, ", threads ", num_threads));
+      std::string data = Random::GetRandomBytes(size);
+      auto stream_result =
+          streaming_mac_result.ValueOrDie()->NewComputeMacOutputStream();
+      ASSERT_THAT(stream_result.status(), IsOk());
+      auto stream = std::move(stream_result.ValueOrDie());
+      ASSERT_THAT(test::WriteToStream(stream.get(), data, false), IsOk());
+      EXPECT_EQ(stream->Position(), size);
+      auto tag_result = stream->CloseAndGetResult();
+      ASSERT_THAT(tag_result.status(), IsOk());
+      EXPECT_EQ(tag_result.ValueOrDie(), ExpectedTag(key, data, chunk_size));
+    }
+  }
+}
+
+TEST(ChunkedStreamingMacTest, SmallWritesWithBackUp) {
+  util::SecretData key =
+      util::SecretDataFromStringView(Random::GetRandomBytes(32));
+  auto streaming_mac_result = ChunkedStreamingMac::New(HmacFactory(key), 64, 3);
+  ASSERT_THAT(streaming_mac_result.status(), IsOk());
+  std::string data = Random::GetRandomBytes(1000);
+  auto stream = std::move(
+      streaming_mac_result.ValueOrDie()->NewComputeMacOutputStream()
+          .ValueOrDie());
+  // Writes 7 bytes per Next() call, backing up the rest of each buffer.
+  size_t position = 0;
+  while (position < data.size()) {
+    void* buffer;
+    auto next_result = stream->Next(&buffer);
+    ASSERT_THAT(next_result.status(), IsOk());
+    int size = std::min<size_t>(data.size() - position, 7);
+    size = std::min(size, next_result.ValueOrDie());
+    memcpy(buffer, data.data() + position, size);
+    stream->BackUp(next_result.ValueOrDie() - size);
+    position += size;
+  }
+  EXPECT_EQ(stream->Position(), data.size());
+  auto tag_result = stream->CloseAndGetResult();
+  ASSERT_THAT(tag_result.status(), IsOk());
+  EXPECT_EQ(tag_result.ValueOrDie(), ExpectedTag(key, data, 64));
+}
+
+TEST(ChunkedStreamingMacTest, Verify) {
+  util::SecretData key =
+      util::SecretDataFromStringView(Random::GetRandomBytes(32));
+  auto streaming_mac_result =
+      ChunkedStreamingMac::New(HmacFactory(key), 1000, 2);
+  ASSERT_THAT(streaming_mac_result.status(), IsOk());
+  const StreamingMac& streaming_mac = *streaming_mac_result.ValueOrDie();
+  std::string data = Random::GetRandomBytes(12345);
+  std::string tag = ExpectedTag(key, data, 1000);
+
+  auto stream =
+      std::move(streaming_mac.NewVerifyMacOutputStream(tag).ValueOrDie());
+  ASSERT_THAT(test::WriteToStream(stream.get(), data, false), IsOk());
+  EXPECT_THAT(stream->CloseAndGetResult(), IsOk());
+
+  std::string modified_tag = tag;
+  modified_tag[0] ^= 1;
+  stream = std::move(
+      streaming_mac.NewVerifyMacOutputStream(modified_tag).ValueOrDie());
+  ASSERT_THAT(test::WriteToStream(stream.get(), data, false), IsOk());
+  EXPECT_THAT(stream->CloseAndGetResult(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+
+  // Dropping the last full chunk changes the tag.
+  stream = std::move(streaming_mac.NewVerifyMacOutputStream(tag).ValueOrDie());
+  ASSERT_THAT(test::WriteToStream(stream.get(), data.substr(0, 12000), false),
+              IsOk());
+  EXPECT_THAT(stream->CloseAndGetResult(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(ChunkedStreamingMacTest, InvalidParameters) {
+  util::SecretData key =
+      util::SecretDataFromStringView(Random::GetRandomBytes(32));
+  EXPECT_THAT(ChunkedStreamingMac::New(nullptr, 100, 1).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(ChunkedStreamingMac::New(HmacFactory(key), 0, 1).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(ChunkedStreamingMac::New(HmacFactory(key), 100, 0).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(ChunkedStreamingMacTest, DestroyUnclosedStream) {
+  util::SecretData key =
+      util::SecretDataFromStringView(Random::GetRandomBytes(32));
+  auto streaming_mac_result = ChunkedStreamingMac::New(HmacFactory(key), 10, 4);
+  ASSERT_THAT(streaming_mac_result.status(), IsOk());
+  auto stream = std::move(
+      streaming_mac_result.ValueOrDie()->NewComputeMacOutputStream()
+          .ValueOrDie());
+  EXPECT_THAT(test::WriteToStream(stream.get(), std::string(1000, 'a'), false),
+              IsOk());
+  // The destructor stops the workers while chunks are still queued.
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,81 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/counter_nonce_generator.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "tink/subtle/random.h"
+#include "tink/util/status.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+CounterNonceGenerator::CounterNonceGenerator(int64_t max_fixed_fields,
+                                             int64_t nonces_per_fixed_field)
+    : max_fixed_fields_(max_fixed_fields),
+      nonces_per_fixed_field_(nonces_per_fixed_field),
+      current_(nullptr) {}
+
+util::Status CounterNonceGenerator::Next(absl::Span<char> nonce) {
+  if (nonce.size() != kNonceSizeInBytes) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid nonce size");
+  }
+  while (true) {
+    FixedField* field = current_.load(std::memory_order_acquire);
+    if (field != nullptr &&
+        field->fork_generation == Random::GetForkGeneration()) {
+      uint64_t counter = field->counter.fetch_add(1, std::memory_order_relaxed);
+      if (counter < static_cast<uint64_t>(nonces_per_fixed_field_)) {
+        memcpy(nonce.data(), field->value, sizeof(field->value));
+        for (int i = 0; i < 4; i++) {
+          nonce[8 + i] = static_cast<char>(counter >> (24 - 8 * i));
+        }
+        return util::OkStatus();
+      }
+    }
+    util::Status status = Renew(field);
+    if (!status.ok()) return status;
+  }
+}
+
+util::Status CounterNonceGenerator::Renew(const FixedField* used_up) {
+  absl::MutexLock lock(&mutex_);
+  if (current_.load(std::memory_order_relaxed) != used_up) {
+    return util::OkStatus();
+  }
+  if (fixed_fields_.size() >= static_cast<size_t>(max_fixed_fields_)) {
+    return util::Status(util::error::RESOURCE_EXHAUSTED,
+                        "all nonces for this key are used up");
+  }
+  auto field = absl::make_unique<FixedField>();
+  Random::GetRandomBytes(absl::MakeSpan(field->value));
+  field->fork_generation = Random::GetForkGeneration();
+  current_.store(field.get(), std::memory_order_release);
+  fixed_fields_.push_back(std::move(field));
+  return util::OkStatus();
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,88 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SUBTLE_COUNTER_NONCE_GENERATOR_H_
+#define TINK_SUBTLE_COUNTER_NONCE_GENERATOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "tink/util/status.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// Generates 12-byte nonces with the deterministic construction of
+// NIST SP 800-38D, section 8.2.1: an 8-byte random fixed field followed by a
+// 4-byte big-endian counter. Generating a nonce takes one atomic increment
+// instead of a call to the random number generator.
+//
+// A new fixed field is drawn once its 2^32 counter values are used up, and in
+// the child process after fork(), which would otherwise repeat the nonces of
+// the parent. Since 64-bit fixed fields may collide, at most
+// 'max_fixed_fields' are drawn; the default keeps the probability of a
+// collision below 2^-32. Afterwards Next() fails, and the key must be rotated.
+//
+// The class is thread-safe.
+class CounterNonceGenerator {
+ public:
+  static constexpr int kNonceSizeInBytes = 12;
+  static constexpr int64_t kMaxFixedFields = int64_t{1} << 16;
+  static constexpr int64_t kNoncesPerFixedField = int64_t{1} << 32;
+
+  // Smaller limits than the defaults are only useful for testing.
+  explicit CounterNonceGenerator(
+      int64_t max_fixed_fields = kMaxFixedFields,
+      int64_t nonces_per_fixed_field = kNoncesPerFixedField);
+
+  CounterNonceGenerator(const CounterNonceGenerator&) = delete;
+  CounterNonceGenerator& operator=(const CounterNonceGenerator&) = delete;
+
+  // Writes the next nonce to 'nonce', which must have kNonceSizeInBytes
+  // bytes. Fails with RESOURCE_EXHAUSTED once all nonces are used up.
+  util::Status Next(absl::Span<char> nonce);
+
+ private:
+  struct FixedField {
+    uint8_t value[8];
+    uint64_t fork_generation;
+    std::atomic<uint64_t> counter{0};
+  };
+
+  // Replaces 'used_up' by a new fixed field, unless another thread did so.
+  util::Status Renew(const FixedField* used_up);
+
+  const int64_t max_fixed_fields_;
+  const int64_t nonces_per_fixed_field_;
+  std::atomic<FixedField*> current_;
+  absl::Mutex mutex_;
+  // Fixed fields are kept until destruction, since other threads may still
+  // read a replaced one.
+  std::vector<std::unique_ptr<FixedField>> fixed_fields_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_COUNTER_NONCE_GENERATOR_H_
@@ -0,0 +1,144 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/counter_nonce_generator.h"
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/types/span.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::testing::SizeIs;
+
+std::string NextNonce(CounterNonceGenerator& generator) {
+  std::string nonce(CounterNonceGenerator::kNonceSizeInBytes, '\0');
+  EXPECT_THAT(generator.Next(absl::MakeSpan(&nonce[0], nonce.size())), IsOk());
+  return nonce;
+}
+
+TEST(CounterNonceGeneratorTest, CountsUpAfterFixedField) {
+  CounterNonceGenerator generator;
+  std::string first = NextNonce(generator);
+  for (int i = 1; i < 300; i++) {
+    std::string nonce = NextNonce(generator);
+    EXPECT_EQ(nonce.substr(0, 8), first.substr(0, 8));
+    EXPECT_EQ(nonce.substr(8),
+              std::string({0, 0, static_cast<char>(i >> 8),
+                           static_cast<char>(i & 0xff)}));
+  }
+}
+
+TEST(CounterNonceGeneratorTest, GeneratorsHaveDifferentFixedFields) {
+  CounterNonceGenerator generator1;
+  CounterNonceGenerator generator2;
+  EXPECT_NE(NextNonce(generator1), NextNonce(generator2));
+}
+
+TEST(CounterNonceGeneratorTest, InvalidNonceSize) {
+  CounterNonceGenerator generator;
+  char nonce[16];
+  EXPECT_THAT(generator.Next(absl::MakeSpan(nonce)),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(CounterNonceGeneratorTest, RenewsFixedFieldAndFailsWhenExhausted) {
+  CounterNonceGenerator generator(/*max_fixed_fields=*/3,
+                                  /*nonces_per_fixed_field=*/4);
+  absl::flat_hash_set<std::string> nonces;
+  absl::flat_hash_set<std::string> fixed_fields;
+  for (int i = 0; i < 12; i++) {
+    std::string nonce = NextNonce(generator);
+    nonces.insert(nonce);
+    fixed_fields.insert(nonce.substr(0, 8));
+  }
+  EXPECT_THAT(nonces, SizeIs(12));
+  EXPECT_THAT(fixed_fields, SizeIs(3));
+  char nonce[CounterNonceGenerator::kNonceSizeInBytes];
+  EXPECT_THAT(generator.Next(absl::MakeSpan(nonce)),
+              StatusIs(util::error::RESOURCE_EXHAUSTED));
+}
+
+TEST(CounterNonceGeneratorTest, ConcurrentNoncesAreUnique) {
+  CounterNonceGenerator generator(/*max_fixed_fields=*/1000,
+                                  /*nonces_per_fixed_field=*/100);
+  constexpr int kThreads = 8;
+  constexpr int kNoncesPerThread = 1000;
+  std::vector<std::vector<std::string>> results(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&generator, &results, t] {
+      for (int i = 0; i < kNoncesPerThread; i++) {
+        results[t].push_back(NextNonce(generator));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  absl::flat_hash_set<std::string> nonces;
+  for (const auto& result : results) {
+    nonces.insert(result.begin(), result.end());
+  }
+  EXPECT_THAT(nonces, SizeIs(kThreads * kNoncesPerThread));
+}
+
+#ifndef _WIN32
+TEST(CounterNonceGeneratorTest, NoncesDifferAfterForkTest) {
+  CounterNonceGenerator generator;
+  NextNonce(generator);
+
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    std::string nonce = NextNonce(generator);
+    ssize_t written = write(fds[1], nonce.data(), nonce.size());
+    _exit(written == static_cast<ssize_t>(nonce.size()) ? 0 : 1);
+  }
+  close(fds[1]);
+  std::string parent_nonce = NextNonce(generator);
+  char child_nonce[CounterNonceGenerator::kNonceSizeInBytes];
+  ASSERT_EQ(read(fds[0], child_nonce, sizeof(child_nonce)),
+            sizeof(child_nonce));
+  close(fds[0]);
+  int status;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  EXPECT_NE(parent_nonce.substr(0, 8), std::string(child_nonce, 8));
+}
+#endif
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
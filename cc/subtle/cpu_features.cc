@@ -0,0 +1,133 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/cpu_features.h"
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/strings/string_view.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#elif defined(__aarch64__) && defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+namespace {
+
+uint32_t Bit(CpuFeature feature) {
+  return uint32_t{1} << static_cast<int>(feature);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Returns the extended control register XCR0, which says which register
+// states the OS saves on context switches.
+uint64_t ReadXcr0() {
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+}
+#endif
+
+uint32_t DetectCpuFeatures() {
+  uint32_t features = 0;
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned int eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return features;
+  if (ecx & (1u << 19)) features |= Bit(CpuFeature::kSse41);
+  if (ecx & (1u << 25)) features |= Bit(CpuFeature::kAesNi);
+  if (ecx & (1u << 1)) features |= Bit(CpuFeature::kPclmul);
+  // AVX state must be enabled by the OS (OSXSAVE, then XCR0), in addition to
+  // being supported by the CPU.
+  uint64_t xcr0 = (ecx & (1u << 27)) ? ReadXcr0() : 0;
+  bool has_ymm = (xcr0 & 0x06) == 0x06;
+  bool has_zmm = (xcr0 & 0xe6) == 0xe6;
+  if (__get_cpuid_max(0, nullptr) < 7) return features;
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  if (has_ymm && (ebx & (1u << 5))) features |= Bit(CpuFeature::kAvx2);
+  if (has_ymm && (ecx & (1u << 9))) features |= Bit(CpuFeature::kVaes);
+  if (has_ymm && (ecx & (1u << 10))) features |= Bit(CpuFeature::kVpclmulqdq);
+  if (has_zmm && (ebx & (1u << 16))) features |= Bit(CpuFeature::kAvx512F);
+  if (ebx & (1u << 29)) features |= Bit(CpuFeature::kShaNi);
+#elif defined(__aarch64__) && defined(__linux__)
+  unsigned long hwcap = getauxval(AT_HWCAP);  // NOLINT(runtime/int)
+  if (hwcap & HWCAP_AES) features |= Bit(CpuFeature::kArmAes);
+  if (hwcap & HWCAP_PMULL) features |= Bit(CpuFeature::kArmPmull);
+  if (hwcap & HWCAP_SHA2) features |= Bit(CpuFeature::kArmSha2);
+#endif
+  return features;
+}
+
+uint32_t DetectedCpuFeatures() {
+  static const uint32_t features = DetectCpuFeatures();
+  return features;
+}
+
+std::atomic<uint32_t> disabled_cpu_features{0};
+
+}  // namespace
+
+bool HasCpuFeature(CpuFeature feature) {
+  uint32_t features = DetectedCpuFeatures() &
+                      ~disabled_cpu_features.load(std::memory_order_relaxed);
+  return (features & Bit(feature)) != 0;
+}
+
+void SetCpuFeatureDisabled(CpuFeature feature, bool disabled) {
+  if (disabled) {
+    disabled_cpu_features.fetch_or(Bit(feature), std::memory_order_relaxed);
+  } else {
+    disabled_cpu_features.fetch_and(~Bit(feature), std::memory_order_relaxed);
+  }
+}
+
+absl::string_view CpuFeatureName(CpuFeature feature) {
+  switch (feature) {
+    case CpuFeature::kSse41:
+      return "SSE4.1";
+    case CpuFeature::kAesNi:
+      return "AES-NI";
+    case CpuFeature::kPclmul:
+      return "PCLMULQDQ";
+    case CpuFeature::kAvx2:
+      return "AVX2";
+    case CpuFeature::kVaes:
+      return "VAES";
+    case CpuFeature::kVpclmulqdq:
+      return "VPCLMULQDQ";
+    case CpuFeature::kAvx512F:
+      return "AVX-512F";
+    case CpuFeature::kShaNi:
+      return "SHA-NI";
+    case CpuFeature::kArmAes:
+      return "ARMv8 AES";
+    case CpuFeature::kArmPmull:
+      return "ARMv8 PMULL";
+    case CpuFeature::kArmSha2:
+      return "ARMv8 SHA2";
+  }
+  return "unknown";
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,60 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SUBTLE_CPU_FEATURES_H_
+#define TINK_SUBTLE_CPU_FEATURES_H_
+
+#include "absl/strings/string_view.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// CPU features which Tink uses to choose between implementations of a
+// primitive. Most primitives are implemented by BoringSSL, which does its
+// own dispatch; these are for the implementations in Tink itself.
+enum class CpuFeature {
+  kSse41,       // x86 SSE4.1.
+  kAesNi,       // x86 AES-NI.
+  kPclmul,      // x86 carry-less multiplication.
+  kAvx2,        // x86 AVX2, with OS support for the YMM registers.
+  kVaes,        // x86 vector AES (VAES), with OS support for the YMM registers.
+  kVpclmulqdq,  // x86 vector carry-less multiplication (VPCLMULQDQ), with OS
+                // support for the YMM registers.
+  kAvx512F,     // x86 AVX-512 foundation, with OS support for ZMM registers.
+  kShaNi,       // x86 SHA extensions.
+  kArmAes,      // ARMv8 AES instructions.
+  kArmPmull,    // ARMv8 polynomial multiplication.
+  kArmSha2,     // ARMv8 SHA-256 instructions.
+};
+
+// Returns true if the CPU this process runs on supports 'feature', and the
+// feature has not been disabled with SetCpuFeatureDisabled().
+bool HasCpuFeature(CpuFeature feature);
+
+// Makes HasCpuFeature() return false for 'feature' if 'disabled' is true, or
+// restores the detected value otherwise. This lets benchmarks and tests
+// compare implementations; it only affects primitives created afterwards.
+void SetCpuFeatureDisabled(CpuFeature feature, bool disabled);
+
+// Returns a short name for 'feature', e.g. "AES-NI".
+absl::string_view CpuFeatureName(CpuFeature feature);
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_CPU_FEATURES_H_
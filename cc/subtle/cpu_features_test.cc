@@ -0,0 +1,49 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/cpu_features.h"
+
+#include "gtest/gtest.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+TEST(CpuFeaturesTest, DisableAndRestore) {
+  bool detected = HasCpuFeature(CpuFeature::kAesNi);
+  SetCpuFeatureDisabled(CpuFeature::kAesNi, true);
+  EXPECT_FALSE(HasCpuFeature(CpuFeature::kAesNi));
+  SetCpuFeatureDisabled(CpuFeature::kAesNi, false);
+  EXPECT_EQ(HasCpuFeature(CpuFeature::kAesNi), detected);
+}
+
+TEST(CpuFeaturesTest, DisablingOneFeatureKeepsOthers) {
+  bool detected = HasCpuFeature(CpuFeature::kPclmul);
+  SetCpuFeatureDisabled(CpuFeature::kAesNi, true);
+  EXPECT_EQ(HasCpuFeature(CpuFeature::kPclmul), detected);
+  SetCpuFeatureDisabled(CpuFeature::kAesNi, false);
+}
+
+TEST(CpuFeaturesTest, Names) {
+  EXPECT_EQ(CpuFeatureName(CpuFeature::kAesNi), "AES-NI");
+  EXPECT_EQ(CpuFeatureName(CpuFeature::kArmPmull), "ARMv8 PMULL");
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -18,16 +18,23 @@
 
 #include <algorithm>
 #include <cstring>
+#include <functional>
+#include <limits>
+#include <utility>
 #include <vector>
 
 #include "absl/base/thread_annotations.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/str_cat.h"
 #include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "tink/random_access_stream.h"
 #include "tink/subtle/stream_segment_decrypter.h"
 #include "tink/util/buffer.h"
 #include "tink/util/errors.h"
+#include "tink/util/executor.h"
+#include "tink/util/secret_data.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
@@ -41,10 +48,97 @@ using crypto::tink::util::Buffer;
 using crypto::tink::util::Status;
 using crypto::tink::util::StatusOr;
 
+namespace {
+
+// Decrypts 'ct_segment' into 'pt_segment'. The ciphertext is only copied
+// into a vector if 'segment_decrypter' does not implement
+// DecryptSegmentInto().
+Status DecryptSegmentFromSpan(StreamSegmentDecrypter* segment_decrypter,
+                              absl::Span<const uint8_t> ct_segment,
+                              int64_t segment_nr, bool is_last_segment,
+                              std::vector<uint8_t>* pt_segment) {
+  pt_segment->resize(segment_decrypter->get_plaintext_segment_size());
+  auto dec_result = segment_decrypter->DecryptSegmentInto(
+      ct_segment, segment_nr, is_last_segment, absl::MakeSpan(*pt_segment));
+  if (dec_result.ok()) {
+    pt_segment->resize(dec_result.ValueOrDie());
+    return Status::OK;
+  }
+  if (dec_result.status().error_code() != util::error::UNIMPLEMENTED) {
+    return dec_result.status();
+  }
+  return segment_decrypter->DecryptSegment(
+      std::vector<uint8_t>(ct_segment.begin(), ct_segment.end()), segment_nr,
+      is_last_segment, pt_segment);
+}
+
+// A segment needed by PReadv().
+struct VectoredSegment {
+  int64_t segment_nr;
+  Status status;
+  absl::Span<const uint8_t> ciphertext;
+  std::vector<uint8_t> plaintext;
+};
+
+// Adjacent segments of PReadv() that are read with a single PRead().
+struct SegmentRun {
+  size_t first_segment;  // index in the vector of VectoredSegment
+  size_t end_segment;
+  int64_t ct_position;
+  std::vector<uint8_t> ciphertext;
+};
+
+// Reads exactly 'count' bytes starting at 'position' of 'source' to 'dest'.
+Status ReadFully(RandomAccessStream* source, int64_t position, int count,
+                 uint8_t* dest) {
+  int read_count = 0;
+  while (read_count < count) {
+    auto buffer_result = Buffer::NewNonOwning(
+        reinterpret_cast<char*>(dest) + read_count, count - read_count);
+    if (!buffer_result.ok()) return buffer_result.status();
+    auto buffer = std::move(buffer_result.ValueOrDie());
+    auto status = source->PRead(position + read_count, count - read_count,
+                                buffer.get());
+    read_count += buffer->size();
+    if (status.error_code() == util::error::OUT_OF_RANGE) {
+      if (read_count < count) {
+        return Status(util::error::INVALID_ARGUMENT,
+                      "ciphertext stream is too short");
+      }
+    } else if (!status.ok()) {
+      return status;
+    }
+  }
+  return Status::OK;
+}
+
+}  // namespace
+
 // static
 StatusOr<std::unique_ptr<RandomAccessStream>> DecryptingRandomAccessStream::New(
     std::unique_ptr<StreamSegmentDecrypter> segment_decrypter,
     std::unique_ptr<RandomAccessStream> ciphertext_source) {
+  return New(std::move(segment_decrypter), std::move(ciphertext_source),
+             Options());
+}
+
+// static
+StatusOr<std::unique_ptr<RandomAccessStream>> DecryptingRandomAccessStream::New(
+    std::unique_ptr<StreamSegmentDecrypter> segment_decrypter,
+    std::unique_ptr<RandomAccessStream> ciphertext_source,
+    const Options& options) {
+  if (options.num_threads < 0 || options.read_ahead_segments < 0) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "options must be non-negative");
+  }
+  if (options.cache_size_in_bytes < 0) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "options must be non-negative");
+  }
+  if (options.read_ahead_segments > 0 && options.num_threads == 0) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "reading ahead requires worker threads");
+  }
   if (segment_decrypter == nullptr) {
     return Status(util::error::INVALID_ARGUMENT,
                   "segment_decrypter must be non-null");
@@ -73,37 +167,237 @@ StatusOr<std::unique_ptr<RandomAccessStream>> DecryptingRandomAccessStream::New(
   }
   dec_stream->status_ =
       Status(util::error::UNAVAILABLE, "The header hasn't been read yet.");
+  dec_stream->options_ = options;
+  DecryptingRandomAccessStream* stream = dec_stream.get();
+  for (int i = 0; i < options.num_threads; i++) {
+    dec_stream->workers_.emplace_back([stream]() { stream->WorkerLoop(); });
+  }
   return {std::move(dec_stream)};
 }
 
+DecryptingRandomAccessStream::~DecryptingRandomAccessStream() {
+  {
+    absl::MutexLock lock(&segments_mutex_);
+    shutdown_ = true;
+  }
+  for (auto& worker : workers_) worker.join();
+  for (auto& waiting : async_reads_) {
+    for (auto& read : waiting.second) {
+      read->done(Status(util::error::CANCELLED, "stream destroyed"));
+    }
+  }
+}
+
 util::Status DecryptingRandomAccessStream::PRead(int64_t position, int count,
                                                  Buffer* dest_buffer) {
+  auto status = PrepareRead(position, count, dest_buffer);
+  if (!status.ok()) return status;
+  return PReadAndDecrypt(position, count, dest_buffer);
+}
+
+void DecryptingRandomAccessStream::PReadAsync(
+    int64_t position, int count, Buffer* dest_buffer,
+    std::function<void(Status)> done) {
+  if (options_.num_threads == 0) {
+    done(Status(util::error::FAILED_PRECONDITION,
+                "PReadAsync requires worker threads"));
+    return;
+  }
+  auto status = PrepareRead(position, count, dest_buffer);
+  if (!status.ok()) {
+    done(status);
+    return;
+  }
+  if (count == 0) {
+    done(Status::OK);
+    return;
+  }
+  if (position == pt_size_) {
+    done(Status(util::error::OUT_OF_RANGE, "EOF"));
+    return;
+  }
+  int64_t last_position = std::min(position + count, pt_size_) - 1;
+  ScheduleSegments(GetSegmentNr(position), GetSegmentNr(last_position));
+  auto read = absl::make_unique<AsyncRead>();
+  read->position = position;
+  read->count = count;
+  read->dest_buffer = dest_buffer;
+  read->done = std::move(done);
+  bool completed;
+  {
+    absl::MutexLock lock(&segments_mutex_);
+    completed = TryCompleteAsyncReadLocked(&read, &status);
+  }
+  if (completed) read->done(status);
+}
+
+std::vector<Status> DecryptingRandomAccessStream::PReadv(
+    const std::vector<ReadRange>& ranges, int num_threads) {
+  std::vector<Status> statuses(ranges.size());
+  std::vector<int64_t> segment_nrs;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    const ReadRange& range = ranges[i];
+    statuses[i] = PrepareRead(range.position, range.count, range.dest_buffer);
+    if (!statuses[i].ok() || range.count == 0) continue;
+    if (range.position == pt_size_) {
+      statuses[i] = Status(util::error::OUT_OF_RANGE, "EOF");
+      continue;
+    }
+    int64_t last_position =
+        std::min(range.position + range.count, pt_size_) - 1;
+    for (int64_t nr = GetSegmentNr(range.position);
+         nr <= GetSegmentNr(last_position); nr++) {
+      segment_nrs.push_back(nr);
+    }
+  }
+  std::sort(segment_nrs.begin(), segment_nrs.end());
+  segment_nrs.erase(std::unique(segment_nrs.begin(), segment_nrs.end()),
+                    segment_nrs.end());
+
+  // Takes the cached segments, and groups the others into runs.
+  std::vector<VectoredSegment> segments(segment_nrs.size());
+  std::vector<SegmentRun> runs;
+  // A single PRead() reads at most std::numeric_limits<int>::max() bytes.
+  const size_t max_run_length =
+      std::max(1, std::numeric_limits<int>::max() / ct_segment_size_);
+  for (size_t i = 0; i < segments.size(); i++) {
+    VectoredSegment& segment = segments[i];
+    segment.segment_nr = segment_nrs[i];
+    if (options_.cache_size_in_bytes > 0 &&
+        GetCachedSegment(segment.segment_nr, &segment.plaintext)) {
+      continue;
+    }
+    if (!runs.empty() && runs.back().end_segment == i &&
+        segments[i - 1].segment_nr + 1 == segment.segment_nr &&
+        i - runs.back().first_segment < max_run_length) {
+      runs.back().end_segment++;
+      continue;
+    }
+    SegmentRun run;
+    run.first_segment = i;
+    run.end_segment = i + 1;
+    run.ct_position = segment.segment_nr == 0
+                          ? ct_offset_ + header_size_
+                          : segment.segment_nr * ct_segment_size_;
+    runs.push_back(std::move(run));
+  }
+
+  // Reads the runs, and then decrypts their segments.
+  const int64_t ct_size = pt_size_ + ct_segment_overhead_ * segment_count_ +
+                          ct_offset_ + header_size_;
+  util::ParallelFor(runs.size(), num_threads, [&](int64_t r) {
+    SegmentRun& run = runs[r];
+    int64_t end_segment_nr = segments[run.end_segment - 1].segment_nr + 1;
+    int64_t ct_end = std::min(end_segment_nr * ct_segment_size_, ct_size);
+    run.ciphertext.resize(ct_end - run.ct_position);
+    Status status = ReadFully(ct_source_.get(), run.ct_position,
+                              run.ciphertext.size(), run.ciphertext.data());
+    int64_t offset = 0;
+    for (size_t i = run.first_segment; i < run.end_segment; i++) {
+      VectoredSegment& segment = segments[i];
+      if (!status.ok()) {
+        segment.status = status;
+        continue;
+      }
+      int64_t ct_segment_end = std::min(
+          (segment.segment_nr + 1) * ct_segment_size_ - run.ct_position,
+          static_cast<int64_t>(run.ciphertext.size()));
+      segment.ciphertext = absl::MakeConstSpan(
+          run.ciphertext.data() + offset, ct_segment_end - offset);
+      offset = ct_segment_end;
+    }
+  });
+  util::ParallelFor(segments.size(), num_threads, [&](int64_t i) {
+    VectoredSegment& segment = segments[i];
+    // Cached segments have no ciphertext.
+    if (!segment.status.ok() || segment.ciphertext.empty()) return;
+    segment.status = DecryptSegmentFromSpan(
+        segment_decrypter_.get(), segment.ciphertext, segment.segment_nr,
+        segment.segment_nr == segment_count_ - 1, &segment.plaintext);
+    if (segment.status.ok() && options_.cache_size_in_bytes > 0) {
+      CacheSegment(segment.segment_nr, segment.plaintext);
+    }
+  });
+
+  // Copies the plaintext of the segments to the ranges.
+  for (size_t i = 0; i < ranges.size(); i++) {
+    const ReadRange& range = ranges[i];
+    if (!statuses[i].ok() || range.count == 0) continue;
+    int64_t end_position = std::min(range.position + range.count, pt_size_);
+    int64_t first_segment_nr = GetSegmentNr(range.position);
+    int64_t last_segment_nr = GetSegmentNr(end_position - 1);
+    auto segment = std::lower_bound(
+        segments.begin(), segments.end(), first_segment_nr,
+        [](const VectoredSegment& s, int64_t nr) { return s.segment_nr < nr; });
+    int64_t read_count = 0;
+    int64_t expected_count = end_position - range.position;
+    int pt_offset = GetPlaintextOffset(range.position);
+    for (int64_t nr = first_segment_nr; nr <= last_segment_nr;
+         nr++, segment++) {
+      if (!segment->status.ok()) {
+        statuses[i] = segment->status;
+        break;
+      }
+      int64_t pt_count =
+          static_cast<int64_t>(segment->plaintext.size()) - pt_offset;
+      int64_t to_copy_count = std::min(pt_count, expected_count - read_count);
+      if (to_copy_count <= 0) {
+        statuses[i] = Status(util::error::INTERNAL, "segment too short");
+        break;
+      }
+      statuses[i] = range.dest_buffer->set_size(read_count + to_copy_count);
+      if (!statuses[i].ok()) break;
+      std::memcpy(range.dest_buffer->get_mem_block() + read_count,
+                  segment->plaintext.data() + pt_offset, to_copy_count);
+      read_count += to_copy_count;
+      pt_offset = 0;
+    }
+    if (statuses[i].ok() && end_position == pt_size_) {
+      statuses[i] = Status(util::error::OUT_OF_RANGE, "EOF");
+    }
+  }
+  return statuses;
+}
+
+util::Status DecryptingRandomAccessStream::PrepareRead(int64_t position,
+                                                       int count,
+                                                       Buffer* dest_buffer) {
   if (dest_buffer == nullptr) {
     return Status(util::error::INVALID_ARGUMENT,
                   "dest_buffer must be non-null");
   }
   auto status = dest_buffer->set_size(0);
   if (!status.ok()) return status;
-  if (count < 0) {
-    return Status(util::error::INVALID_ARGUMENT, "count cannot be negative");
-  }
   if (count > dest_buffer->allocated_size()) {
     return Status(util::error::INVALID_ARGUMENT, "buffer too small");
   }
+  return PrepareReadRange(position, count);
+}
+
+util::Status DecryptingRandomAccessStream::PrepareReadRange(int64_t position,
+                                                            int count) {
+  if (count < 0) {
+    return Status(util::error::INVALID_ARGUMENT, "count cannot be negative");
+  }
   if (position < 0) {
     return Status(util::error::INVALID_ARGUMENT, "position cannot be negative");
   }
 
-  {  // Initialize, if not initialized yet.
-    absl::MutexLock lock(&status_mutex_);
-    InitializeIfNeeded();
-    if (!status_.ok()) return status_;
-  }
+  auto status = Initialize();
+  if (!status.ok()) return status;
 
   if (position > pt_size_) {
     return Status(util::error::INVALID_ARGUMENT, "position too large");
   }
-  return PReadAndDecrypt(position, count, dest_buffer);
+  return Status::OK;
+}
+
+Status DecryptingRandomAccessStream::Initialize() {
+  if (initialized_.load(std::memory_order_acquire)) return Status::OK;
+  absl::MutexLock lock(&status_mutex_);
+  InitializeIfNeeded();
+  if (status_.ok()) initialized_.store(true, std::memory_order_release);
+  return status_;
 }
 
 // NOTE: As the initialization below requires availability of size() of the
@@ -219,11 +513,16 @@ util::Status DecryptingRandomAccessStream::ReadAndDecryptSegment(
       (is_last_segment && ct_buffer->size() > 0 &&
        pread_status.error_code() == util::error::OUT_OF_RANGE)) {
     // some bytes were read
-    auto dec_status = segment_decrypter_->DecryptSegment(
-        std::vector<uint8_t>(ct_buffer->get_mem_block(),
-                             ct_buffer->get_mem_block() + ct_buffer->size()),
+    auto dec_status = DecryptSegmentFromSpan(
+        segment_decrypter_.get(),
+        absl::MakeConstSpan(
+            reinterpret_cast<const uint8_t*>(ct_buffer->get_mem_block()),
+            ct_buffer->size()),
         segment_nr, is_last_segment, pt_segment);
     if (dec_status.ok()) {
+      if (options_.cache_size_in_bytes > 0) {
+        CacheSegment(segment_nr, *pt_segment);
+      }
       return is_last_segment ?
           Status(util::error::OUT_OF_RANGE, "EOF") : Status::OK;
     }
@@ -232,6 +531,227 @@ util::Status DecryptingRandomAccessStream::ReadAndDecryptSegment(
   return pread_status;
 }
 
+util::Status DecryptingRandomAccessStream::GetSegment(
+    int64_t segment_nr, Buffer* ct_buffer, std::vector<uint8_t>* pt_segment) {
+  if (options_.cache_size_in_bytes > 0 &&
+      GetCachedSegment(segment_nr, pt_segment)) {
+    // Only segments that were decrypted successfully are cached, so this
+    // is the same status ReadAndDecryptSegment() returned for them.
+    return segment_nr == segment_count_ - 1
+               ? Status(util::error::OUT_OF_RANGE, "EOF")
+               : Status::OK;
+  }
+  if (options_.num_threads == 0) {
+    return ReadAndDecryptSegment(segment_nr, ct_buffer, pt_segment);
+  }
+  std::unique_ptr<Segment> segment;
+  {
+    absl::MutexLock lock(&segments_mutex_);
+    while (true) {
+      auto it = segments_.find(segment_nr);
+      if (it == segments_.end()) {
+        // Not scheduled yet, or taken by a concurrent PRead().
+        ScheduleSegmentLocked(segment_nr);
+        continue;
+      }
+      if (it->second->done) {
+        segment = std::move(it->second);
+        segments_.erase(it);
+        break;
+      }
+      segment_done_.Wait(&segments_mutex_);
+    }
+  }
+  pt_segment->swap(segment->plaintext);
+  return segment->status;
+}
+
+void DecryptingRandomAccessStream::ScheduleSegments(int64_t first_segment_nr,
+                                                    int64_t last_segment_nr) {
+  int64_t end_segment_nr =
+      std::min(last_segment_nr + options_.read_ahead_segments,
+               segment_count_ - 1);
+  absl::MutexLock lock(&segments_mutex_);
+  // Segments being worked on cannot be dropped, but they are dropped by a
+  // later call once they are done, so that memory use stays bounded.
+  for (auto it = segments_.begin(); it != segments_.end();) {
+    auto current = it++;
+    if (current->second->done && (current->first < first_segment_nr ||
+                                  current->first > end_segment_nr)) {
+      segments_.erase(current);
+    }
+  }
+  for (int64_t nr = first_segment_nr; nr <= end_segment_nr; nr++) {
+    if (!segments_.contains(nr) && !IsCached(nr)) ScheduleSegmentLocked(nr);
+  }
+}
+
+bool DecryptingRandomAccessStream::GetCachedSegment(
+    int64_t segment_nr, std::vector<uint8_t>* pt_segment) {
+  absl::MutexLock lock(&cache_mutex_);
+  auto it = cache_.find(segment_nr);
+  if (it == cache_.end()) return false;
+  cache_lru_.splice(cache_lru_.begin(), cache_lru_, it->second.lru_position);
+  pt_segment->assign(it->second.plaintext.begin(),
+                     it->second.plaintext.end());
+  return true;
+}
+
+bool DecryptingRandomAccessStream::IsCached(int64_t segment_nr) {
+  if (options_.cache_size_in_bytes == 0) return false;
+  absl::MutexLock lock(&cache_mutex_);
+  return cache_.contains(segment_nr);
+}
+
+void DecryptingRandomAccessStream::CacheSegment(
+    int64_t segment_nr, const std::vector<uint8_t>& pt_segment) {
+  if (pt_segment.size() > options_.cache_size_in_bytes) return;
+  absl::MutexLock lock(&cache_mutex_);
+  if (cache_.contains(segment_nr)) return;  // Decrypted concurrently.
+  // SecretData wipes the plaintext of evicted segments.
+  while (cache_size_ + pt_segment.size() > options_.cache_size_in_bytes) {
+    auto evicted = cache_.find(cache_lru_.back());
+    cache_size_ -= evicted->second.plaintext.size();
+    cache_.erase(evicted);
+    cache_lru_.pop_back();
+  }
+  cache_lru_.push_front(segment_nr);
+  CachedSegment& cached = cache_[segment_nr];
+  cached.plaintext.assign(pt_segment.begin(), pt_segment.end());
+  cached.lru_position = cache_lru_.begin();
+  cache_size_ += pt_segment.size();
+}
+
+void DecryptingRandomAccessStream::ScheduleSegmentLocked(int64_t segment_nr) {
+  segments_[segment_nr] = absl::make_unique<Segment>();
+  queued_.push_back(segment_nr);
+}
+
+bool DecryptingRandomAccessStream::TryCompleteAsyncReadLocked(
+    std::unique_ptr<AsyncRead>* read, Status* status) {
+  int64_t position = (*read)->position;
+  int64_t end_position = std::min(position + (*read)->count, pt_size_);
+  int64_t first_segment_nr = GetSegmentNr(position);
+  int64_t last_segment_nr = GetSegmentNr(end_position - 1);
+  for (int64_t nr = first_segment_nr; nr <= last_segment_nr; nr++) {
+    auto it = segments_.find(nr);
+    if (it == segments_.end()) {
+      auto segment = absl::make_unique<Segment>();
+      if (options_.cache_size_in_bytes > 0 &&
+          GetCachedSegment(nr, &segment->plaintext)) {
+        segment->done = true;
+        segment->status = nr == segment_count_ - 1
+                              ? Status(util::error::OUT_OF_RANGE, "EOF")
+                              : Status::OK;
+        segments_[nr] = std::move(segment);
+        continue;
+      }
+      // Taken by a concurrent PRead(), or dropped by ScheduleSegments().
+      ScheduleSegmentLocked(nr);
+      async_reads_[nr].push_back(std::move(*read));
+      return false;
+    }
+    if (!it->second->done) {
+      async_reads_[nr].push_back(std::move(*read));
+      return false;
+    }
+  }
+
+  Buffer* dest_buffer = (*read)->dest_buffer;
+  *status = Status::OK;
+  int64_t read_count = 0;
+  int64_t expected_count = end_position - position;
+  int pt_offset = GetPlaintextOffset(position);
+  for (int64_t nr = first_segment_nr; nr <= last_segment_nr; nr++) {
+    const Segment& segment = *segments_[nr];
+    if (!segment.status.ok() &&
+        segment.status.error_code() != util::error::OUT_OF_RANGE) {
+      *status = segment.status;
+      break;
+    }
+    int64_t pt_count =
+        static_cast<int64_t>(segment.plaintext.size()) - pt_offset;
+    int64_t to_copy_count = std::min(pt_count, expected_count - read_count);
+    if (to_copy_count <= 0) {
+      *status = segment.status.ok()
+                    ? Status(util::error::INTERNAL, "segment too short")
+                    : segment.status;
+      break;
+    }
+    *status = dest_buffer->set_size(read_count + to_copy_count);
+    if (!status->ok()) break;
+    std::memcpy(dest_buffer->get_mem_block() + read_count,
+                segment.plaintext.data() + pt_offset, to_copy_count);
+    read_count += to_copy_count;
+    pt_offset = 0;
+  }
+  for (int64_t nr = first_segment_nr; nr <= last_segment_nr; nr++) {
+    segments_.erase(nr);
+  }
+  if (status->ok() && end_position == pt_size_) {
+    *status = Status(util::error::OUT_OF_RANGE, "EOF");
+  }
+  return true;
+}
+
+bool DecryptingRandomAccessStream::HasQueuedSegmentOrShutdown() const {
+  return shutdown_ || !queued_.empty();
+}
+
+void DecryptingRandomAccessStream::WorkerLoop() {
+  std::unique_ptr<Buffer> ct_buffer;
+  while (true) {
+    int64_t segment_nr;
+    Segment* segment;
+    {
+      absl::MutexLock lock(&segments_mutex_);
+      segments_mutex_.Await(absl::Condition(
+          this, &DecryptingRandomAccessStream::HasQueuedSegmentOrShutdown));
+      if (shutdown_) return;
+      segment_nr = queued_.front();
+      queued_.pop_front();
+      // Segments are dropped from segments_ only when done, so the pointer
+      // stays valid until this worker marks the segment as done.
+      segment = segments_[segment_nr].get();
+    }
+    // Segments are scheduled only once the stream is initialized, so
+    // ct_segment_size_ is known here.
+    Status status;
+    if (ct_buffer == nullptr) {
+      auto ct_buffer_result = Buffer::New(ct_segment_size_);
+      if (ct_buffer_result.ok()) {
+        ct_buffer = std::move(ct_buffer_result.ValueOrDie());
+      } else {
+        status = ct_buffer_result.status();
+      }
+    }
+    if (ct_buffer != nullptr) {
+      status = ReadAndDecryptSegment(segment_nr, ct_buffer.get(),
+                                     &segment->plaintext);
+    }
+    std::vector<std::pair<std::unique_ptr<AsyncRead>, Status>> completed;
+    {
+      absl::MutexLock lock(&segments_mutex_);
+      segment->status = std::move(status);
+      segment->done = true;
+      segment_done_.SignalAll();
+      auto it = async_reads_.find(segment_nr);
+      if (it != async_reads_.end()) {
+        std::vector<std::unique_ptr<AsyncRead>> waiting =
+            std::move(it->second);
+        async_reads_.erase(it);
+        for (auto& read : waiting) {
+          Status read_status;
+          if (TryCompleteAsyncReadLocked(&read, &read_status)) {
+            completed.emplace_back(std::move(read), std::move(read_status));
+          }
+        }
+      }
+    }
+    for (auto& read : completed) read.first->done(read.second);
+  }
+}
+
 util::Status DecryptingRandomAccessStream::PReadAndDecrypt(
     int64_t position, int count, Buffer* dest_buffer) {
   if (position < 0 || count < 0 || dest_buffer == nullptr
@@ -256,6 +776,53 @@ util::Status DecryptingRandomAccessStream::PReadAndDecrypt(
                     "position is larger than stream size");
     }
   }
+  return DecryptRange(
+      position, count,
+      [dest_buffer](std::vector<uint8_t>* pt_segment, int pt_offset,
+                    int pt_count) {
+        int read_count = dest_buffer->size();
+        auto status = dest_buffer->set_size(read_count + pt_count);
+        if (!status.ok()) return status;
+        std::memcpy(dest_buffer->get_mem_block() + read_count,
+                    pt_segment->data() + pt_offset, pt_count);
+        return Status::OK;
+      });
+}
+
+util::Status DecryptingRandomAccessStream::PReadCord(int64_t position,
+                                                     int count,
+                                                     absl::Cord* dest) {
+  if (dest == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT, "dest must be non-null");
+  }
+  auto status = PrepareReadRange(position, count);
+  if (!status.ok()) return status;
+  if (position > std::numeric_limits<int64_t>::max() - count) {
+    return Status(util::error::OUT_OF_RANGE, "position too large");
+  }
+  return DecryptRange(
+      position, count,
+      [dest](std::vector<uint8_t>* pt_segment, int pt_offset, int pt_count) {
+        // Moving the vector keeps its data where it is.
+        auto* plaintext = new std::vector<uint8_t>(std::move(*pt_segment));
+        pt_segment->clear();
+        dest->Append(absl::MakeCordFromExternal(
+            absl::string_view(
+                reinterpret_cast<const char*>(plaintext->data()) + pt_offset,
+                pt_count),
+            [plaintext]() {
+              util::SafeZeroMemory(reinterpret_cast<char*>(plaintext->data()),
+                                   plaintext->size());
+              delete plaintext;
+            }));
+        return Status::OK;
+      });
+}
+
+util::Status DecryptingRandomAccessStream::DecryptRange(
+    int64_t position, int count,
+    const std::function<Status(std::vector<uint8_t>* pt_segment,
+                               int pt_offset, int pt_count)>& consume) {
   auto ct_buffer_result = Buffer::New(ct_segment_size_);
   if (!ct_buffer_result.ok()) {
     return ToStatusF(util::error::INVALID_ARGUMENT,
@@ -263,27 +830,30 @@ util::Status DecryptingRandomAccessStream::PReadAndDecrypt(
                      ct_segment_size_);
   }
   auto ct_buffer = std::move(ct_buffer_result.ValueOrDie());
+  if (options_.num_threads > 0 && count > 0 && position < pt_size_) {
+    int64_t last_position = std::min(position + count, pt_size_) - 1;
+    ScheduleSegments(GetSegmentNr(position), GetSegmentNr(last_position));
+  }
   std::vector<uint8_t> pt_segment;
   int remaining = count;
   int read_count = 0;
   int pt_offset = GetPlaintextOffset(position);
   while (remaining > 0) {
     auto segment_nr = GetSegmentNr(position + read_count);
-    auto status =
-        ReadAndDecryptSegment(segment_nr, ct_buffer.get(), &pt_segment);
+    auto status = GetSegment(segment_nr, ct_buffer.get(), &pt_segment);
     if (status.ok() || status.error_code() == util::error::OUT_OF_RANGE) {
       int pt_count = pt_segment.size() - pt_offset;
       int to_copy_count = std::min(pt_count, remaining);
-      auto s = dest_buffer->set_size(read_count + to_copy_count);
-      if (!s.ok()) return s;
-      std::memcpy(dest_buffer->get_mem_block() + read_count,
-                  pt_segment.data() + pt_offset, to_copy_count);
+      if (to_copy_count > 0) {
+        auto s = consume(&pt_segment, pt_offset, to_copy_count);
+        if (!s.ok()) return s;
+      }
       pt_offset = 0;
       if (status.error_code() == util::error::OUT_OF_RANGE &&
           to_copy_count == pt_count)
         return status;
       read_count += to_copy_count;
-      remaining = count - dest_buffer->size();
+      remaining = count - read_count;
     } else {  // some other error happened
       return status;
     }
@@ -292,11 +862,8 @@ util::Status DecryptingRandomAccessStream::PReadAndDecrypt(
 }
 
 StatusOr<int64_t> DecryptingRandomAccessStream::size() {
-  {  // Initialize, if not initialized yet.
-    absl::MutexLock lock(&status_mutex_);
-    InitializeIfNeeded();
-    if (!status_.ok()) return status_;
-  }
+  auto status = Initialize();
+  if (!status.ok()) return status;
   return pt_size_;
 }
 
@@ -17,12 +17,24 @@
 #ifndef TINK_SUBTLE_DECRYPTING_RANDOM_ACCESS_STREAM_H_
 #define TINK_SUBTLE_DECRYPTING_RANDOM_ACCESS_STREAM_H_
 
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
 #include <memory>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/cord.h"
 #include "absl/synchronization/mutex.h"
 #include "tink/random_access_stream.h"
 #include "tink/subtle/stream_segment_decrypter.h"
+#include "tink/util/buffer.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
 namespace crypto {
@@ -38,9 +50,37 @@ namespace subtle {
 //    refer to the plaintext bytes.
 //  - size()-call returns the size of the entire plaintext
 //    if it were to be decrypted.
+//  - PReadAsync()-calls, available with worker threads, work like
+//    PRead()-calls, but return immediately and report the result
+//    via a callback once the workers have decrypted the segments.
 // Instances of this class are thread safe.
 class DecryptingRandomAccessStream : public crypto::tink::RandomAccessStream {
  public:
+  // A range of the plaintext to be read by PReadv().
+  struct ReadRange {
+    int64_t position;
+    int count;
+    crypto::tink::util::Buffer* dest_buffer;
+  };
+
+  // Optional settings of a decrypting random access stream.
+  struct Options {
+    // Number of worker threads that read and decrypt segments. With 0
+    // workers, PRead() reads and decrypts the segments itself, one at a time.
+    // With workers, the segments needed by a PRead() are read from the
+    // ciphertext source concurrently.
+    int num_threads = 0;
+    // Number of segments following the ones needed by a PRead() that are
+    // read and decrypted ahead, in anticipation of sequential reads.
+    // Requires num_threads > 0.
+    int read_ahead_segments = 0;
+    // Maximal total size of the decrypted segments kept in a cache, so that
+    // repeated reads into the same segments decrypt them only once. When the
+    // cache is full, the least recently used segments are evicted and their
+    // plaintext is wiped. If 0, no segments are cached.
+    int64_t cache_size_in_bytes = 0;
+  };
+
   // A factory that produces decrypting random access streams.
   // The returned stream is a wrapper around 'ciphertext_source',
   // such that any bytes written via the wrapper are AEAD-decrypted
@@ -51,23 +91,126 @@ class DecryptingRandomAccessStream : public crypto::tink::RandomAccessStream {
   New(std::unique_ptr<StreamSegmentDecrypter> segment_decrypter,
       std::unique_ptr<crypto::tink::RandomAccessStream> ciphertext_source);
 
+  // Same as above, with the specified 'options'.
+  static crypto::tink::util::StatusOr<
+      std::unique_ptr<crypto::tink::RandomAccessStream>>
+  New(std::unique_ptr<StreamSegmentDecrypter> segment_decrypter,
+      std::unique_ptr<crypto::tink::RandomAccessStream> ciphertext_source,
+      const Options& options);
+
+  ~DecryptingRandomAccessStream() override;
+
   // -----------------------
   // Methods of RandomAccessStream-interface implemented by this class.
   crypto::tink::util::Status PRead(
       int64_t position, int count,
       crypto::tink::util::Buffer* dest_buffer) override;
   crypto::tink::util::StatusOr<int64_t> size() override;
+  // Appends the plaintext to 'dest' without copying it: the chunks of the
+  // Cord are the buffers the segments were decrypted into, which are wiped
+  // once the Cord releases them. Segments taken from the cache are copied
+  // once, from the cache.
+  crypto::tink::util::Status PReadCord(int64_t position, int count,
+                                       absl::Cord* dest) override;
+
+  // Reads like PRead(), but without waiting for the segments to be read
+  // and decrypted: 'done' is called with the status PRead() would have
+  // returned once 'dest_buffer' holds the plaintext. 'done' is called
+  // by a worker thread, or by the calling thread if the read completes
+  // or fails right away; it must not destroy this stream. 'dest_buffer'
+  // must remain valid until 'done' is called. If the stream is destroyed
+  // before a read completes, 'done' is called with CANCELLED.
+  // Requires options.num_threads > 0. The first call may block while the
+  // stream header is read, if no other call has read it yet.
+  void PReadAsync(int64_t position, int count,
+                  crypto::tink::util::Buffer* dest_buffer,
+                  std::function<void(crypto::tink::util::Status)> done);
+
+  // Reads several ranges at once, e.g. the column chunks needed from a
+  // columnar file, and returns for each range the status PRead() would have
+  // returned for it. The segments needed by any of the ranges are decrypted
+  // exactly once, even if ranges overlap or share a segment, and each run of
+  // adjacent segments that are not cached is read from the ciphertext source
+  // with a single PRead(). The reads, and then the decryption of the
+  // segments, are spread over up to 'num_threads' threads with
+  // util::ParallelFor(). This does not use the workers of the stream.
+  std::vector<crypto::tink::util::Status> PReadv(
+      const std::vector<ReadRange>& ranges, int num_threads = 1);
 
  private:
+  // A segment that is read and decrypted by a worker.
+  struct Segment {
+    bool done = false;
+    crypto::tink::util::Status status;
+    std::vector<uint8_t> plaintext;
+  };
+
+  // A decrypted segment in the cache.
+  struct CachedSegment {
+    util::SecretData plaintext;
+    std::list<int64_t>::iterator lru_position;
+  };
+
+  // A PReadAsync() that is waiting for its segments.
+  struct AsyncRead {
+    int64_t position;
+    int count;
+    crypto::tink::util::Buffer* dest_buffer;
+    std::function<void(crypto::tink::util::Status)> done;
+  };
+
   DecryptingRandomAccessStream() {}
+  // Validates the arguments of a PRead() and initializes this stream
+  // if needed. Clears 'dest_buffer'.
+  crypto::tink::util::Status PrepareRead(
+      int64_t position, int count, crypto::tink::util::Buffer* dest_buffer);
+  // Validates the range of a PRead() and initializes this stream if needed.
+  crypto::tink::util::Status PrepareReadRange(int64_t position, int count);
   crypto::tink::util::Status PReadAndDecrypt(
       int64_t position, int count, crypto::tink::util::Buffer* dest_buffer);
+  // Decrypts the segments of the plaintext range starting at 'position',
+  // and passes each segment's plaintext, the offset of the range in it and
+  // the number of bytes of the range in it to 'consume'.
+  crypto::tink::util::Status DecryptRange(
+      int64_t position, int count,
+      const std::function<crypto::tink::util::Status(
+          std::vector<uint8_t>* pt_segment, int pt_offset, int pt_count)>&
+          consume);
   // Reads the specified ciphertext segment from ct_source_, decrypts it,
   // and writes the resulting plaintext bytes to pt_segment.
   // Uses the provided ct_buffer as a buffer for the ciphertext segment.
   crypto::tink::util::Status ReadAndDecryptSegment(
       int64_t segment_nr, crypto::tink::util::Buffer* ct_buffer,
       std::vector<uint8_t>* pt_segment);
+  // Like ReadAndDecryptSegment(), but with workers the segment is taken from
+  // the segments read ahead, or handed to the workers if it is not there.
+  crypto::tink::util::Status GetSegment(
+      int64_t segment_nr, crypto::tink::util::Buffer* ct_buffer,
+      std::vector<uint8_t>* pt_segment);
+  // Hands the segments from 'first_segment_nr' to 'last_segment_nr'
+  // and the read_ahead_segments following ones to the workers, unless they
+  // are already there, and drops finished segments outside of this range.
+  void ScheduleSegments(int64_t first_segment_nr, int64_t last_segment_nr);
+  void ScheduleSegmentLocked(int64_t segment_nr)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(segments_mutex_);
+  void WorkerLoop();
+  // If the specified segment is cached, copies its plaintext to 'pt_segment'
+  // and returns true.
+  bool GetCachedSegment(int64_t segment_nr, std::vector<uint8_t>* pt_segment);
+  bool IsCached(int64_t segment_nr);
+  // Adds a copy of 'pt_segment' to the cache, evicting the least recently
+  // used segments as needed.
+  void CacheSegment(int64_t segment_nr, const std::vector<uint8_t>& pt_segment);
+  // If all segments of '*read' are done, copies their plaintext to its
+  // destination, drops them from segments_, sets '*status' to the result
+  // of the read and returns true. Otherwise hands '*read' over to
+  // async_reads_, to be retried once the first missing segment is done,
+  // and returns false.
+  bool TryCompleteAsyncReadLocked(std::unique_ptr<AsyncRead>* read,
+                                  crypto::tink::util::Status* status)
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(segments_mutex_);
+  bool HasQueuedSegmentOrShutdown() const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(segments_mutex_);
   // Returns the segment number that contains the specified 'pt_position'.
   int64_t GetSegmentNr(int64_t pt_position);
   // Returns the offset within a segment for the specified 'pt_position'.
@@ -76,11 +219,18 @@ class DecryptingRandomAccessStream : public crypto::tink::RandomAccessStream {
   // by reading the stream header from ct_source_ and using it initialize
   // segment_decrypter_.
   void InitializeIfNeeded();
+  // Like InitializeIfNeeded(), and returns status_. Once the stream is
+  // initialized, this returns without taking status_mutex_.
+  crypto::tink::util::Status Initialize();
   std::unique_ptr<StreamSegmentDecrypter> segment_decrypter_;
   std::unique_ptr<crypto::tink::RandomAccessStream> ct_source_;
 
   mutable absl::Mutex status_mutex_;
   crypto::tink::util::Status status_ ABSL_GUARDED_BY(status_mutex_);
+  // Set once status_ is OK. The fields below are written before that, and
+  // are not changed afterwards, so readers that see it set may use them
+  // without locking.
+  std::atomic<bool> initialized_{false};
   int header_size_;
   int ct_offset_;
   int ct_segment_size_;
@@ -88,6 +238,29 @@ class DecryptingRandomAccessStream : public crypto::tink::RandomAccessStream {
   int ct_segment_overhead_;
   int64_t segment_count_;
   int64_t pt_size_;
+
+  Options options_;
+  absl::Mutex segments_mutex_;
+  // Signalled whenever a worker finishes a segment.
+  absl::CondVar segment_done_;
+  // Segments handed to the workers, and not yet taken by a PRead().
+  absl::flat_hash_map<int64_t, std::unique_ptr<Segment>> segments_
+      ABSL_GUARDED_BY(segments_mutex_);
+  // Numbers of the segments in segments_ that no worker has picked up yet.
+  std::deque<int64_t> queued_ ABSL_GUARDED_BY(segments_mutex_);
+  // Pending PReadAsync() calls, by the segment they are waiting for.
+  absl::flat_hash_map<int64_t, std::vector<std::unique_ptr<AsyncRead>>>
+      async_reads_ ABSL_GUARDED_BY(segments_mutex_);
+  bool shutdown_ ABSL_GUARDED_BY(segments_mutex_) = false;
+  std::vector<std::thread> workers_;
+
+  // Must not be locked before segments_mutex_.
+  absl::Mutex cache_mutex_;
+  absl::flat_hash_map<int64_t, CachedSegment> cache_
+      ABSL_GUARDED_BY(cache_mutex_);
+  // Numbers of the cached segments, most recently used first.
+  std::list<int64_t> cache_lru_ ABSL_GUARDED_BY(cache_mutex_);
+  int64_t cache_size_ ABSL_GUARDED_BY(cache_mutex_) = 0;
 };
 
 }  // namespace subtle
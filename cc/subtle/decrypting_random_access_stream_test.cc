@@ -16,13 +16,18 @@
 
 #include "tink/subtle/decrypting_random_access_stream.h"
 
+#include <atomic>
 #include <sstream>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
 #include <vector>
 
 #include "gtest/gtest.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/blocking_counter.h"
 #include "tink/output_stream.h"
 #include "tink/random_access_stream.h"
 #include "tink/streaming_aead.h"
@@ -73,6 +78,29 @@ class DummyRandomAccessStream : public RandomAccessStream {
   int ct_offset_;
 };
 
+// A RandomAccessStream that counts the PRead()-calls to another stream.
+class CountingRandomAccessStream : public RandomAccessStream {
+ public:
+  CountingRandomAccessStream(std::unique_ptr<RandomAccessStream> stream,
+                             std::atomic<int>* pread_count)
+      : stream_(std::move(stream)), pread_count_(pread_count) {}
+
+  crypto::tink::util::Status PRead(
+      int64_t position, int count,
+      crypto::tink::util::Buffer* dest_buffer) override {
+    (*pread_count_)++;
+    return stream_->PRead(position, count, dest_buffer);
+  }
+
+  crypto::tink::util::StatusOr<int64_t> size() override {
+    return stream_->size();
+  }
+
+ private:
+  std::unique_ptr<RandomAccessStream> stream_;
+  std::atomic<int>* pread_count_;
+};
+
 // Creates a RandomAccessStream with the specified contents.
 std::unique_ptr<RandomAccessStream> GetRandomAccessStream(
     absl::string_view contents) {
@@ -409,6 +437,472 @@ TEST(DecryptingRandomAccessStreamTest, NullCiphertextSource) {
                        HasSubstr("cipertext_source must be non-null")));
 }
 
+TEST(DecryptingRandomAccessStreamTest, ReadAheadDecryption) {
+  int pt_segment_size = 50;
+  int header_size = 10;
+  int ct_offset = 5;
+  for (int pt_size : {0, 1, 42, 100, 1000, 10000}) {
+    std::string plaintext = subtle::Random::GetRandomBytes(pt_size);
+    DummyStreamingAead saead(pt_segment_size, header_size, ct_offset);
+    std::string ciphertext =
+        GetCiphertext(&saead, plaintext, "some aad", ct_offset);
+    for (int num_threads : {1, 4}) {
+      for (int read_ahead_segments : {0, 1, 8}) {
+        SCOPED_TRACE(absl::StrCat("pt_size = ", pt_size,
+                                  ", num_threads = ", num_threads,
+                                  ", read_ahead_segments = ",
+                                  read_ahead_segments));
+        DecryptingRandomAccessStream::Options options;
+        options.num_threads = num_threads;
+        options.read_ahead_segments = read_ahead_segments;
+        auto seg_decrypter = absl::make_unique<DummyStreamSegmentDecrypter>(
+            pt_segment_size, header_size, ct_offset);
+        auto dec_stream_result = DecryptingRandomAccessStream::New(
+            std::move(seg_decrypter), GetRandomAccessStream(ciphertext),
+            options);
+        ASSERT_THAT(dec_stream_result.status(), IsOk());
+        auto dec_stream = std::move(dec_stream_result.ValueOrDie());
+        std::string decrypted;
+        auto status = ReadAll(dec_stream.get(), &decrypted);
+        EXPECT_THAT(status,
+                    StatusIs(util::error::OUT_OF_RANGE, HasSubstr("EOF")));
+        EXPECT_EQ(plaintext, decrypted);
+
+        // Jumping around discards segments read ahead, but still gives the
+        // right plaintext.
+        auto buffer = std::move(util::Buffer::New(100).ValueOrDie());
+        for (int position : {pt_size / 2, 0, pt_size - 1, pt_size / 3}) {
+          if (position < 0) continue;
+          status = dec_stream->PRead(position, 100, buffer.get());
+          EXPECT_TRUE(status.ok() ||
+                      status.error_code() == util::error::OUT_OF_RANGE);
+          EXPECT_EQ(plaintext.substr(position, 100),
+                    std::string(buffer->get_mem_block(), buffer->size()));
+        }
+      }
+    }
+  }
+}
+
+TEST(DecryptingRandomAccessStreamTest, ConcurrentReadAheadDecryption) {
+  int pt_segment_size = 64;
+  int header_size = 10;
+  int ct_offset = 0;
+  int pt_size = 20000;
+  std::string plaintext = subtle::Random::GetRandomBytes(pt_size);
+  DummyStreamingAead saead(pt_segment_size, header_size, ct_offset);
+  DecryptingRandomAccessStream::Options options;
+  options.num_threads = 3;
+  options.read_ahead_segments = 4;
+  auto dec_stream_result = DecryptingRandomAccessStream::New(
+      absl::make_unique<DummyStreamSegmentDecrypter>(pt_segment_size,
+                                                     header_size, ct_offset),
+      GetCiphertextSource(&saead, plaintext, "some aad", ct_offset), options);
+  ASSERT_THAT(dec_stream_result.status(), IsOk());
+  RandomAccessStream* dec_stream = dec_stream_result.ValueOrDie().get();
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&, i]() {
+      auto buffer = std::move(util::Buffer::New(150).ValueOrDie());
+      for (int position = i * 7; position < pt_size; position += 150) {
+        auto status = dec_stream->PRead(position, 150, buffer.get());
+        EXPECT_TRUE(status.ok() ||
+                    status.error_code() == util::error::OUT_OF_RANGE);
+        EXPECT_EQ(plaintext.substr(position, 150),
+                  std::string(buffer->get_mem_block(), buffer->size()));
+      }
+    });
+  }
+  for (auto& reader : readers) reader.join();
+}
+
+TEST(DecryptingRandomAccessStreamTest, CachedDecryption) {
+  int pt_segment_size = 100;
+  int header_size = 10;
+  int ct_offset = 0;
+  int pt_size = 1000;
+  std::string plaintext = subtle::Random::GetRandomBytes(pt_size);
+  DummyStreamingAead saead(pt_segment_size, header_size, ct_offset);
+  std::string ciphertext =
+      GetCiphertext(&saead, plaintext, "some aad", ct_offset);
+  for (int num_threads : {0, 2}) {
+    SCOPED_TRACE(absl::StrCat("num_threads = ", num_threads));
+    DecryptingRandomAccessStream::Options options;
+    options.num_threads = num_threads;
+    // Room for two full segments.
+    options.cache_size_in_bytes = 2 * pt_segment_size;
+    auto seg_decrypter = absl::make_unique<DummyStreamSegmentDecrypter>(
+        pt_segment_size, header_size, ct_offset);
+    DummyStreamSegmentDecrypter* seg_decrypter_ref = seg_decrypter.get();
+    auto dec_stream_result = DecryptingRandomAccessStream::New(
+        std::move(seg_decrypter), GetRandomAccessStream(ciphertext), options);
+    ASSERT_THAT(dec_stream_result.status(), IsOk());
+    auto dec_stream = std::move(dec_stream_result.ValueOrDie());
+    auto buffer = std::move(util::Buffer::New(10).ValueOrDie());
+
+    // Repeated reads within segments 1 and 2 decrypt each of them once.
+    for (int i = 0; i < 3; i++) {
+      for (int position : {150, 170, 250, 280}) {
+        ASSERT_THAT(dec_stream->PRead(position, 10, buffer.get()), IsOk());
+        EXPECT_EQ(plaintext.substr(position, 10),
+                  std::string(buffer->get_mem_block(), buffer->size()));
+      }
+    }
+    EXPECT_EQ(2 * pt_segment_size,
+              seg_decrypter_ref->get_generated_output_size());
+
+    // Reading segment 3 evicts segment 1, which is decrypted again.
+    ASSERT_THAT(dec_stream->PRead(350, 10, buffer.get()), IsOk());
+    ASSERT_THAT(dec_stream->PRead(250, 10, buffer.get()), IsOk());
+    EXPECT_EQ(3 * pt_segment_size,
+              seg_decrypter_ref->get_generated_output_size());
+    ASSERT_THAT(dec_stream->PRead(150, 10, buffer.get()), IsOk());
+    EXPECT_EQ(plaintext.substr(150, 10),
+              std::string(buffer->get_mem_block(), buffer->size()));
+    EXPECT_EQ(4 * pt_segment_size,
+              seg_decrypter_ref->get_generated_output_size());
+
+    // The last segment is cached as well, and still reports EOF.
+    for (int i = 0; i < 2; i++) {
+      EXPECT_THAT(dec_stream->PRead(pt_size - 5, 10, buffer.get()),
+                  StatusIs(util::error::OUT_OF_RANGE, HasSubstr("EOF")));
+      EXPECT_EQ(plaintext.substr(pt_size - 5),
+                std::string(buffer->get_mem_block(), buffer->size()));
+    }
+  }
+}
+
+TEST(DecryptingRandomAccessStreamTest, CordDecryption) {
+  int pt_segment_size = 100;
+  int header_size = 10;
+  int ct_offset = 5;
+  int pt_size = 1000;
+  std::string plaintext = subtle::Random::GetRandomBytes(pt_size);
+  DummyStreamingAead saead(pt_segment_size, header_size, ct_offset);
+  std::string ciphertext =
+      GetCiphertext(&saead, plaintext, "some aad", ct_offset);
+  for (int num_threads : {0, 2}) {
+    for (int64_t cache_size : {0, 200}) {
+      SCOPED_TRACE(absl::StrCat("num_threads = ", num_threads,
+                                ", cache_size = ", cache_size));
+      DecryptingRandomAccessStream::Options options;
+      options.num_threads = num_threads;
+      options.cache_size_in_bytes = cache_size;
+      auto dec_stream_result = DecryptingRandomAccessStream::New(
+          absl::make_unique<DummyStreamSegmentDecrypter>(
+              pt_segment_size, header_size, ct_offset),
+          GetRandomAccessStream(ciphertext), options);
+      ASSERT_THAT(dec_stream_result.status(), IsOk());
+      auto dec_stream = std::move(dec_stream_result.ValueOrDie());
+
+      for (int position : {0, 1, 84, 85, 150, 999}) {
+        for (int count : {0, 1, 15, 100, 350}) {
+          SCOPED_TRACE(absl::StrCat("position = ", position,
+                                    ", count = ", count));
+          absl::Cord cord("prefix");
+          auto status = dec_stream->PReadCord(position, count, &cord);
+          std::string expected = plaintext.substr(position, count);
+          if (count > 0 && position + count >= pt_size) {
+            EXPECT_THAT(status, StatusIs(util::error::OUT_OF_RANGE));
+          } else {
+            EXPECT_THAT(status, IsOk());
+          }
+          EXPECT_EQ(absl::StrCat("prefix", expected), std::string(cord));
+        }
+      }
+
+      // A Cord read of several segments consists of a chunk per segment
+      // (plus the prefix).
+      absl::Cord cord("prefix");
+      ASSERT_THAT(dec_stream->PReadCord(150, 200, &cord), IsOk());
+      EXPECT_EQ(absl::StrCat("prefix", plaintext.substr(150, 200)),
+                std::string(cord));
+      int chunks = 0;
+      for (absl::string_view chunk : cord.Chunks()) {
+        if (!chunk.empty()) chunks++;
+      }
+      EXPECT_GE(chunks, 3);
+
+      absl::Cord unused;
+      EXPECT_THAT(dec_stream->PReadCord(-1, 10, &unused),
+                  StatusIs(util::error::INVALID_ARGUMENT));
+      EXPECT_THAT(dec_stream->PReadCord(0, -1, &unused),
+                  StatusIs(util::error::INVALID_ARGUMENT));
+      EXPECT_THAT(dec_stream->PReadCord(pt_size + 1, 10, &unused),
+                  StatusIs(util::error::INVALID_ARGUMENT));
+      EXPECT_THAT(dec_stream->PReadCord(0, 10, nullptr),
+                  StatusIs(util::error::INVALID_ARGUMENT));
+    }
+  }
+}
+
+TEST(DecryptingRandomAccessStreamTest, AsyncDecryption) {
+  int pt_segment_size = 50;
+  int header_size = 10;
+  int ct_offset = 5;
+  for (int pt_size : {0, 1, 42, 100, 1000}) {
+    std::string plaintext = subtle::Random::GetRandomBytes(pt_size);
+    DummyStreamingAead saead(pt_segment_size, header_size, ct_offset);
+    std::string ciphertext =
+        GetCiphertext(&saead, plaintext, "some aad", ct_offset);
+    for (int cache_size_in_bytes : {0, 1000}) {
+      SCOPED_TRACE(absl::StrCat("pt_size = ", pt_size,
+                                ", cache_size_in_bytes = ",
+                                cache_size_in_bytes));
+      DecryptingRandomAccessStream::Options options;
+      options.num_threads = 2;
+      options.read_ahead_segments = 1;
+      options.cache_size_in_bytes = cache_size_in_bytes;
+      auto dec_stream_result = DecryptingRandomAccessStream::New(
+          absl::make_unique<DummyStreamSegmentDecrypter>(
+              pt_segment_size, header_size, ct_offset),
+          GetRandomAccessStream(ciphertext), options);
+      ASSERT_THAT(dec_stream_result.status(), IsOk());
+      auto* dec_stream = static_cast<DecryptingRandomAccessStream*>(
+          dec_stream_result.ValueOrDie().get());
+
+      // Each read gives the same result as the corresponding PRead().
+      auto buffer = std::move(util::Buffer::New(120).ValueOrDie());
+      auto async_buffer = std::move(util::Buffer::New(120).ValueOrDie());
+      for (int position : {0, 1, 37, pt_size / 2, pt_size - 1, pt_size}) {
+        for (int count : {0, 1, 50, 120}) {
+          if (position < 0) continue;
+          SCOPED_TRACE(absl::StrCat("position = ", position,
+                                    ", count = ", count));
+          util::Status status =
+              dec_stream->PRead(position, count, buffer.get());
+          util::Status async_status;
+          absl::BlockingCounter done(1);
+          dec_stream->PReadAsync(position, count, async_buffer.get(),
+                                 [&](util::Status s) {
+                                   async_status = s;
+                                   done.DecrementCount();
+                                 });
+          done.Wait();
+          EXPECT_EQ(status, async_status);
+          EXPECT_EQ(std::string(buffer->get_mem_block(), buffer->size()),
+                    std::string(async_buffer->get_mem_block(),
+                                async_buffer->size()));
+        }
+      }
+    }
+  }
+}
+
+TEST(DecryptingRandomAccessStreamTest, ManyConcurrentAsyncReads) {
+  int pt_segment_size = 64;
+  int header_size = 10;
+  int ct_offset = 0;
+  int pt_size = 20000;
+  int read_size = 150;
+  std::string plaintext = subtle::Random::GetRandomBytes(pt_size);
+  DummyStreamingAead saead(pt_segment_size, header_size, ct_offset);
+  DecryptingRandomAccessStream::Options options;
+  options.num_threads = 3;
+  auto dec_stream_result = DecryptingRandomAccessStream::New(
+      absl::make_unique<DummyStreamSegmentDecrypter>(pt_segment_size,
+                                                     header_size, ct_offset),
+      GetCiphertextSource(&saead, plaintext, "some aad", ct_offset), options);
+  ASSERT_THAT(dec_stream_result.status(), IsOk());
+  auto* dec_stream = static_cast<DecryptingRandomAccessStream*>(
+      dec_stream_result.ValueOrDie().get());
+
+  // All reads are issued before any of them is waited for.
+  std::vector<int> positions;
+  for (int position = 0; position < pt_size; position += 97) {
+    positions.push_back(position);
+  }
+  std::vector<std::unique_ptr<util::Buffer>> buffers;
+  std::vector<util::Status> statuses(positions.size());
+  absl::BlockingCounter done(positions.size());
+  for (int i = 0; i < positions.size(); i++) {
+    buffers.push_back(std::move(util::Buffer::New(read_size).ValueOrDie()));
+    dec_stream->PReadAsync(positions[i], read_size, buffers[i].get(),
+                           [&statuses, &done, i](util::Status status) {
+                             statuses[i] = status;
+                             done.DecrementCount();
+                           });
+  }
+  done.Wait();
+  for (int i = 0; i < positions.size(); i++) {
+    EXPECT_TRUE(statuses[i].ok() ||
+                statuses[i].error_code() == util::error::OUT_OF_RANGE)
+        << statuses[i];
+    EXPECT_EQ(plaintext.substr(positions[i], read_size),
+              std::string(buffers[i]->get_mem_block(), buffers[i]->size()));
+  }
+}
+
+TEST(DecryptingRandomAccessStreamTest, AsyncReadRequiresWorkers) {
+  auto dec_stream_result = DecryptingRandomAccessStream::New(
+      absl::make_unique<DummyStreamSegmentDecrypter>(42, 10, 0),
+      GetRandomAccessStream("some ciphertext contents"));
+  ASSERT_THAT(dec_stream_result.status(), IsOk());
+  auto* dec_stream = static_cast<DecryptingRandomAccessStream*>(
+      dec_stream_result.ValueOrDie().get());
+  auto buffer = std::move(util::Buffer::New(10).ValueOrDie());
+  util::Status status;
+  dec_stream->PReadAsync(0, 10, buffer.get(),
+                         [&status](util::Status s) { status = s; });
+  EXPECT_THAT(status, StatusIs(util::error::FAILED_PRECONDITION));
+}
+
+TEST(DecryptingRandomAccessStreamTest, VectoredRead) {
+  int pt_segment_size = 64;
+  int header_size = 10;
+  int pt_size = 1000;
+  for (int ct_offset : {0, 5}) {
+    for (int num_threads : {1, 4}) {
+      SCOPED_TRACE(absl::StrCat("ct_offset = ", ct_offset,
+                                ", num_threads = ", num_threads));
+      std::string plaintext = subtle::Random::GetRandomBytes(pt_size);
+      DummyStreamingAead saead(pt_segment_size, header_size, ct_offset);
+      auto dec_stream_result = DecryptingRandomAccessStream::New(
+          absl::make_unique<DummyStreamSegmentDecrypter>(
+              pt_segment_size, header_size, ct_offset),
+          GetCiphertextSource(&saead, plaintext, "some aad", ct_offset));
+      ASSERT_THAT(dec_stream_result.status(), IsOk());
+      auto* dec_stream = static_cast<DecryptingRandomAccessStream*>(
+          dec_stream_result.ValueOrDie().get());
+
+      // Overlapping ranges, ranges sharing a segment, ranges reaching or
+      // starting at the end, an empty range and an invalid one.
+      std::vector<std::pair<int64_t, int>> positions_and_counts = {
+          {0, 10},   {5, 100},  {300, 50}, {320, 5},  {100, 500},
+          {990, 20}, {1000, 1}, {700, 0},  {1001, 1}, {500, 500}};
+      std::vector<std::unique_ptr<util::Buffer>> buffers;
+      std::vector<DecryptingRandomAccessStream::ReadRange> ranges;
+      for (const auto& position_and_count : positions_and_counts) {
+        buffers.push_back(std::move(
+            util::Buffer::New(std::max(position_and_count.second, 1))
+                .ValueOrDie()));
+        ranges.push_back({position_and_count.first, position_and_count.second,
+                          buffers.back().get()});
+      }
+      std::vector<util::Status> statuses =
+          dec_stream->PReadv(ranges, num_threads);
+      ASSERT_EQ(ranges.size(), statuses.size());
+      for (int i = 0; i < ranges.size(); i++) {
+        auto buffer = std::move(util::Buffer::New(
+            buffers[i]->allocated_size()).ValueOrDie());
+        auto status = dec_stream->PRead(ranges[i].position, ranges[i].count,
+                                        buffer.get());
+        EXPECT_EQ(status.error_code(), statuses[i].error_code())
+            << "range " << i << ": " << statuses[i];
+        EXPECT_EQ(std::string(buffer->get_mem_block(), buffer->size()),
+                  std::string(buffers[i]->get_mem_block(),
+                              buffers[i]->size()))
+            << "range " << i;
+      }
+      EXPECT_EQ(plaintext.substr(100, 500),
+                std::string(buffers[4]->get_mem_block(), buffers[4]->size()));
+      EXPECT_THAT(statuses[5], StatusIs(util::error::OUT_OF_RANGE));
+      EXPECT_THAT(statuses[8], StatusIs(util::error::INVALID_ARGUMENT));
+    }
+  }
+}
+
+TEST(DecryptingRandomAccessStreamTest, VectoredReadCoalescesSegments) {
+  int pt_segment_size = 64;
+  int header_size = 10;
+  int ct_offset = 0;
+  int pt_size = 1000;
+  std::string plaintext = subtle::Random::GetRandomBytes(pt_size);
+  DummyStreamingAead saead(pt_segment_size, header_size, ct_offset);
+  std::atomic<int> pread_count(0);
+  DecryptingRandomAccessStream::Options options;
+  options.cache_size_in_bytes = 10 * pt_segment_size;
+  auto dec_stream_result = DecryptingRandomAccessStream::New(
+      absl::make_unique<DummyStreamSegmentDecrypter>(pt_segment_size,
+                                                     header_size, ct_offset),
+      absl::make_unique<CountingRandomAccessStream>(
+          GetCiphertextSource(&saead, plaintext, "some aad", ct_offset),
+          &pread_count),
+      options);
+  ASSERT_THAT(dec_stream_result.status(), IsOk());
+  auto* dec_stream = static_cast<DecryptingRandomAccessStream*>(
+      dec_stream_result.ValueOrDie().get());
+  ASSERT_THAT(dec_stream->size().status(), IsOk());
+  pread_count = 0;
+
+  // Segments 1 to 4 and 8 to 9 are needed, so two reads suffice.
+  std::vector<std::unique_ptr<util::Buffer>> buffers;
+  std::vector<DecryptingRandomAccessStream::ReadRange> ranges;
+  std::vector<std::pair<int64_t, int>> positions_and_counts = {
+      {60, 70}, {200, 40}, {140, 40}, {520, 100}, {530, 10}};
+  for (const auto& position_and_count : positions_and_counts) {
+    buffers.push_back(
+        std::move(util::Buffer::New(position_and_count.second).ValueOrDie()));
+    ranges.push_back({position_and_count.first, position_and_count.second,
+                      buffers.back().get()});
+  }
+  std::vector<util::Status> statuses = dec_stream->PReadv(ranges);
+  EXPECT_EQ(2, pread_count);
+  for (int i = 0; i < ranges.size(); i++) {
+    EXPECT_THAT(statuses[i], IsOk());
+    EXPECT_EQ(plaintext.substr(ranges[i].position, ranges[i].count),
+              std::string(buffers[i]->get_mem_block(), buffers[i]->size()));
+  }
+
+  // The segments are cached now.
+  pread_count = 0;
+  statuses = dec_stream->PReadv(ranges);
+  EXPECT_EQ(0, pread_count);
+  for (int i = 0; i < ranges.size(); i++) {
+    EXPECT_THAT(statuses[i], IsOk());
+    EXPECT_EQ(plaintext.substr(ranges[i].position, ranges[i].count),
+              std::string(buffers[i]->get_mem_block(), buffers[i]->size()));
+  }
+}
+
+TEST(DecryptingRandomAccessStreamTest, VectoredReadTruncatedCiphertext) {
+  int pt_segment_size = 64;
+  int header_size = 10;
+  int ct_offset = 0;
+  std::string plaintext = subtle::Random::GetRandomBytes(500);
+  DummyStreamingAead saead(pt_segment_size, header_size, ct_offset);
+  std::string ciphertext =
+      GetCiphertext(&saead, plaintext, "some aad", ct_offset);
+  auto dec_stream_result = DecryptingRandomAccessStream::New(
+      absl::make_unique<DummyStreamSegmentDecrypter>(pt_segment_size,
+                                                     header_size, ct_offset),
+      GetRandomAccessStream(ciphertext.substr(0, ciphertext.size() - 5)));
+  ASSERT_THAT(dec_stream_result.status(), IsOk());
+  auto* dec_stream = static_cast<DecryptingRandomAccessStream*>(
+      dec_stream_result.ValueOrDie().get());
+  auto first_buffer = std::move(util::Buffer::New(20).ValueOrDie());
+  auto last_buffer = std::move(util::Buffer::New(20).ValueOrDie());
+  std::vector<util::Status> statuses = dec_stream->PReadv(
+      {{0, 20, first_buffer.get()}, {470, 20, last_buffer.get()}});
+  EXPECT_THAT(statuses[0], IsOk());
+  EXPECT_EQ(plaintext.substr(0, 20),
+            std::string(first_buffer->get_mem_block(), first_buffer->size()));
+  EXPECT_FALSE(statuses[1].ok());
+  EXPECT_NE(util::error::OUT_OF_RANGE, statuses[1].error_code());
+}
+
+TEST(DecryptingRandomAccessStreamTest, InvalidOptions) {
+  for (auto num_threads_and_read_ahead :
+       std::vector<std::pair<int, int>>{{-1, 0}, {1, -1}, {0, 2}}) {
+    DecryptingRandomAccessStream::Options options;
+    options.num_threads = num_threads_and_read_ahead.first;
+    options.read_ahead_segments = num_threads_and_read_ahead.second;
+    auto dec_stream_result = DecryptingRandomAccessStream::New(
+        absl::make_unique<DummyStreamSegmentDecrypter>(42, 10, 0),
+        GetRandomAccessStream("some ciphertext contents"), options);
+    EXPECT_THAT(dec_stream_result.status(),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+  DecryptingRandomAccessStream::Options options;
+  options.cache_size_in_bytes = -1;
+  EXPECT_THAT(DecryptingRandomAccessStream::New(
+                  absl::make_unique<DummyStreamSegmentDecrypter>(42, 10, 0),
+                  GetRandomAccessStream("some ciphertext contents"), options)
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
 }  // namespace
 }  // namespace subtle
 }  // namespace tink
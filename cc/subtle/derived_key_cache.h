@@ -0,0 +1,103 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SUBTLE_DERIVED_KEY_CACHE_H_
+#define TINK_SUBTLE_DERIVED_KEY_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "openssl/sha.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// A small cache for the keyed state that streaming AEAD segment decrypters
+// derive from the salt in a ciphertext header and the associated data.
+// One cache belongs to one StreamingAead primitive, i.e. to one key, so that
+// reopening a ciphertext stream with it skips key derivation and key setup.
+//
+// Entries are looked up by the salt and a SHA-256 hash of the associated
+// data, and evicted in least recently used order once 'capacity' entries are
+// cached. The cached values are shared by all decrypters using them, so they
+// must be safe for concurrent use and are only accessed as const; their
+// destructors are responsible for wiping key material.
+template <typename V>
+class DerivedKeyCache {
+ public:
+  explicit DerivedKeyCache(int capacity) : capacity_(capacity) {}
+
+  // Returns the value cached for 'salt' and 'associated_data', or nullptr.
+  std::shared_ptr<const V> Get(absl::string_view salt,
+                               absl::string_view associated_data) {
+    std::string key = CacheKey(salt, associated_data);
+    absl::MutexLock lock(&mutex_);
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->first == key) {
+        entries_.splice(entries_.begin(), entries_, it);
+        return entries_.front().second;
+      }
+    }
+    return nullptr;
+  }
+
+  // Caches 'value' for 'salt' and 'associated_data'.
+  void Put(absl::string_view salt, absl::string_view associated_data,
+           std::shared_ptr<const V> value) {
+    if (capacity_ <= 0) return;
+    std::string key = CacheKey(salt, associated_data);
+    absl::MutexLock lock(&mutex_);
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+      if (it->first == key) {
+        entries_.erase(it);
+        break;
+      }
+    }
+    entries_.emplace_front(std::move(key), std::move(value));
+    if (entries_.size() > static_cast<size_t>(capacity_)) entries_.pop_back();
+  }
+
+ private:
+  static std::string CacheKey(absl::string_view salt,
+                              absl::string_view associated_data) {
+    uint8_t digest[SHA256_DIGEST_LENGTH];
+    ::SHA256(reinterpret_cast<const uint8_t*>(associated_data.data()),
+           associated_data.size(), digest);
+    return absl::StrCat(
+        salt, absl::string_view(reinterpret_cast<const char*>(digest),
+                                sizeof(digest)));
+  }
+
+  const int capacity_;
+  absl::Mutex mutex_;
+  // Most recently used first.
+  std::list<std::pair<std::string, std::shared_ptr<const V>>> entries_
+      ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_DERIVED_KEY_CACHE_H_
@@ -0,0 +1,101 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/derived_key_cache.h"
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+TEST(DerivedKeyCacheTest, GetPut) {
+  DerivedKeyCache<std::string> cache(2);
+  EXPECT_EQ(cache.Get("salt", "aad"), nullptr);
+  auto value = std::make_shared<const std::string>("value");
+  cache.Put("salt", "aad", value);
+  EXPECT_EQ(cache.Get("salt", "aad"), value);
+  EXPECT_EQ(cache.Get("salt", "other aad"), nullptr);
+  EXPECT_EQ(cache.Get("other salt", "aad"), nullptr);
+}
+
+TEST(DerivedKeyCacheTest, PutReplaces) {
+  DerivedKeyCache<std::string> cache(2);
+  cache.Put("salt", "aad", std::make_shared<const std::string>("old"));
+  auto value = std::make_shared<const std::string>("new");
+  cache.Put("salt", "aad", value);
+  EXPECT_EQ(cache.Get("salt", "aad"), value);
+}
+
+TEST(DerivedKeyCacheTest, EvictsLeastRecentlyUsed) {
+  DerivedKeyCache<std::string> cache(2);
+  cache.Put("salt0", "aad", std::make_shared<const std::string>("0"));
+  cache.Put("salt1", "aad", std::make_shared<const std::string>("1"));
+  // Makes "salt1" the least recently used entry.
+  EXPECT_NE(cache.Get("salt0", "aad"), nullptr);
+  cache.Put("salt2", "aad", std::make_shared<const std::string>("2"));
+  EXPECT_NE(cache.Get("salt0", "aad"), nullptr);
+  EXPECT_EQ(cache.Get("salt1", "aad"), nullptr);
+  EXPECT_NE(cache.Get("salt2", "aad"), nullptr);
+}
+
+TEST(DerivedKeyCacheTest, EvictedValuesStayValid) {
+  DerivedKeyCache<std::string> cache(1);
+  cache.Put("salt0", "aad", std::make_shared<const std::string>("0"));
+  std::shared_ptr<const std::string> value = cache.Get("salt0", "aad");
+  cache.Put("salt1", "aad", std::make_shared<const std::string>("1"));
+  EXPECT_EQ(cache.Get("salt0", "aad"), nullptr);
+  ASSERT_NE(value, nullptr);
+  EXPECT_EQ(*value, "0");
+}
+
+TEST(DerivedKeyCacheTest, ZeroCapacity) {
+  DerivedKeyCache<std::string> cache(0);
+  cache.Put("salt", "aad", std::make_shared<const std::string>("value"));
+  EXPECT_EQ(cache.Get("salt", "aad"), nullptr);
+}
+
+TEST(DerivedKeyCacheTest, ConcurrentUse) {
+  DerivedKeyCache<std::string> cache(4);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&cache, t] {
+      for (int i = 0; i < 100; i++) {
+        std::string salt = absl::StrCat("salt", (t + i) % 8);
+        auto value = cache.Get(salt, "aad");
+        if (value == nullptr) {
+          cache.Put(salt, "aad", std::make_shared<const std::string>(salt));
+        } else {
+          EXPECT_EQ(*value, salt);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
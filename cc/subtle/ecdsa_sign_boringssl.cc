@@ -16,7 +16,7 @@
 
 #include "tink/subtle/ecdsa_sign_boringssl.h"
 
-#include <vector>
+#include <string>
 
 #include "absl/strings/str_cat.h"
 #include "tink/subtle/common_enums.h"
@@ -31,41 +31,6 @@ namespace crypto {
 namespace tink {
 namespace subtle {
 
-namespace {
-
-// Transforms ECDSA DER signature encoding to IEEE_P1363 encoding.
-//
-// The IEEE_P1363 signature's format is r || s, where r and s are zero-padded
-// and have the same size in bytes as the order of the curve. For example, for
-// NIST P-256 curve, r and s are zero-padded to 32 bytes.
-//
-// The DER signature is encoded using ASN.1
-// (https://tools.ietf.org/html/rfc5480#appendix-A): ECDSA-Sig-Value :: =
-// SEQUENCE { r INTEGER, s INTEGER }. In particular, the encoding is: 0x30 ||
-// totalLength || 0x02 || r's length || r || 0x02 || s's length || s.
-crypto::tink::util::StatusOr<std::string> DerToIeee(absl::string_view der,
-                                                    const EC_KEY* key) {
-  size_t field_size_in_bytes =
-      (EC_GROUP_get_degree(EC_KEY_get0_group(key)) + 7) / 8;
-  bssl::UniquePtr<ECDSA_SIG> ecdsa(ECDSA_SIG_from_bytes(
-      reinterpret_cast<const uint8_t*>(der.data()), der.size()));
-  if (ecdsa.get() == nullptr) {
-    return util::Status(util::error::INTERNAL,
-                        "Internal BoringSSL ECDSA_SIG_from_bytes's error");
-  }
-  auto status_or_r = SubtleUtilBoringSSL::bn2str(ecdsa->r, field_size_in_bytes);
-  if (!status_or_r.ok()) {
-    return status_or_r.status();
-  }
-  auto status_or_s = SubtleUtilBoringSSL::bn2str(ecdsa->s, field_size_in_bytes);
-  if (!status_or_s.ok()) {
-    return status_or_s.status();
-  }
-  return status_or_r.ValueOrDie() + status_or_s.ValueOrDie();
-}
-
-}  // namespace
-
 // static
 util::StatusOr<std::unique_ptr<EcdsaSignBoringSsl>> EcdsaSignBoringSsl::New(
     const SubtleUtilBoringSSL::EcKey& ec_key, HashType hash_type,
@@ -118,7 +83,11 @@ util::StatusOr<std::unique_ptr<EcdsaSignBoringSsl>> EcdsaSignBoringSsl::New(
 EcdsaSignBoringSsl::EcdsaSignBoringSsl(bssl::UniquePtr<EC_KEY> key,
                                        const EVP_MD* hash,
                                        EcdsaSignatureEncoding encoding)
-    : key_(std::move(key)), hash_(hash), encoding_(encoding) {}
+    : key_(std::move(key)),
+      hash_(hash),
+      encoding_(encoding),
+      field_size_in_bytes_(
+          (EC_GROUP_get_degree(EC_KEY_get0_group(key_.get())) + 7) / 8) {}
 
 util::StatusOr<std::string> EcdsaSignBoringSsl::Sign(
     absl::string_view data) const {
@@ -135,24 +104,35 @@ util::StatusOr<std::string> EcdsaSignBoringSsl::Sign(
   }
 
   // Compute the signature.
-  std::vector<uint8_t> buffer(ECDSA_size(key_.get()));
-  unsigned int sig_length;
-  if (1 != ECDSA_sign(0 /* unused */, digest, digest_size, buffer.data(),
-                  &sig_length, key_.get())) {
-    return util::Status(util::error::INTERNAL, "Signing failed.");
-  }
-
   if (encoding_ == subtle::EcdsaSignatureEncoding::IEEE_P1363) {
-    auto status_or_sig = DerToIeee(
-        std::string(reinterpret_cast<char*>(buffer.data()), sig_length),
-        key_.get());
-    if (!status_or_sig.ok()) {
-      return status_or_sig.status();
+    // The IEEE_P1363 signature's format is r || s, where r and s are
+    // zero-padded and have the same size in bytes as the order of the curve.
+    // r and s are written directly, without a DER encoding in between.
+    bssl::UniquePtr<ECDSA_SIG> ecdsa(
+        ECDSA_do_sign(digest, digest_size, key_.get()));
+    if (ecdsa == nullptr) {
+      return util::Status(util::error::INTERNAL, "Signing failed.");
     }
-    return status_or_sig.ValueOrDie();
+    std::string signature(2 * field_size_in_bytes_, '\0');
+    uint8_t* signature_bytes = reinterpret_cast<uint8_t*>(&signature[0]);
+    if (1 != BN_bn2bin_padded(signature_bytes, field_size_in_bytes_,
+                              ecdsa->r) ||
+        1 != BN_bn2bin_padded(signature_bytes + field_size_in_bytes_,
+                              field_size_in_bytes_, ecdsa->s)) {
+      return util::Status(util::error::INTERNAL, "Signing failed.");
+    }
+    return signature;
   }
 
-  return std::string(reinterpret_cast<char*>(buffer.data()), sig_length);
+  std::string signature(ECDSA_size(key_.get()), '\0');
+  unsigned int sig_length;
+  if (1 != ECDSA_sign(0 /* unused */, digest, digest_size,
+                      reinterpret_cast<uint8_t*>(&signature[0]), &sig_length,
+                      key_.get())) {
+    return util::Status(util::error::INTERNAL, "Signing failed.");
+  }
+  signature.resize(sig_length);
+  return signature;
 }
 
 }  // namespace subtle
@@ -53,6 +53,8 @@ class EcdsaSignBoringSsl : public PublicKeySign {
   bssl::UniquePtr<EC_KEY> key_;
   const EVP_MD* hash_;  // Owned by BoringSSL.
   EcdsaSignatureEncoding encoding_;
+  // Size of r and s in IEEE_P1363 signatures.
+  size_t field_size_in_bytes_;
 };
 
 }  // namespace subtle
@@ -88,22 +88,40 @@ util::Status EcdsaVerifyBoringSsl::Verify(absl::string_view signature,
     return util::Status(util::error::INTERNAL, "Could not compute digest.");
   }
 
-  std::string derSig(signature);
+  int verified;
   if (encoding_ == subtle::EcdsaSignatureEncoding::IEEE_P1363) {
-    const EC_GROUP* group = EC_KEY_get0_group(key_.get());
-    auto status_or_der =
-        SubtleUtilBoringSSL::EcSignatureIeeeToDer(group, signature);
-
-    if (!status_or_der.ok()) {
-      return status_or_der.status();
+    // Verify r and s directly instead of encoding them to DER first, only to
+    // have ECDSA_verify() parse them again. r, s and the ECDSA_SIG live on
+    // the stack, so only the digits of r and s are allocated.
+    if (signature.size() != 2 * field_size_in_bytes_) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "Signature is not valid.");
+    }
+    const uint8_t* sig_bytes =
+        reinterpret_cast<const uint8_t*>(signature.data());
+    BIGNUM r;
+    BIGNUM s;
+    BN_init(&r);
+    BN_init(&s);
+    ECDSA_SIG ecdsa_sig;
+    ecdsa_sig.r = &r;
+    ecdsa_sig.s = &s;
+    if (BN_bin2bn(sig_bytes, field_size_in_bytes_, &r) == nullptr ||
+        BN_bin2bn(sig_bytes + field_size_in_bytes_, field_size_in_bytes_,
+                  &s) == nullptr) {
+      BN_free(&r);
+      BN_free(&s);
+      return util::Status(util::error::INTERNAL, "BN_bin2bn error.");
     }
-    derSig = status_or_der.ValueOrDie();
+    verified = ECDSA_do_verify(digest, digest_size, &ecdsa_sig, key_.get());
+    BN_free(&r);
+    BN_free(&s);
+  } else {
+    verified = ECDSA_verify(0 /* unused */, digest, digest_size,
+                            reinterpret_cast<const uint8_t*>(signature.data()),
+                            signature.size(), key_.get());
   }
-
-  // Verify the signature.
-  if (1 != ECDSA_verify(0 /* unused */, digest, digest_size,
-                        reinterpret_cast<const uint8_t*>(derSig.data()),
-                        derSig.size(), key_.get())) {
+  if (1 != verified) {
     // signature is invalid
     return util::Status(util::error::INVALID_ARGUMENT,
                         "Signature is not valid.");
@@ -54,11 +54,17 @@ class EcdsaVerifyBoringSsl : public PublicKeyVerify {
  private:
   EcdsaVerifyBoringSsl(bssl::UniquePtr<EC_KEY> key, const EVP_MD* hash,
                        EcdsaSignatureEncoding encoding)
-      : key_(std::move(key)), hash_(hash), encoding_(encoding) {}
+      : key_(std::move(key)),
+        hash_(hash),
+        encoding_(encoding),
+        field_size_in_bytes_(
+            (EC_GROUP_get_degree(EC_KEY_get0_group(key_.get())) + 7) / 8) {}
 
   bssl::UniquePtr<EC_KEY> key_;
   const EVP_MD* hash_;  // Owned by BoringSSL.
   EcdsaSignatureEncoding encoding_;
+  // Size of r and s in IEEE_P1363 signatures.
+  size_t field_size_in_bytes_;
 };
 
 }  // namespace subtle
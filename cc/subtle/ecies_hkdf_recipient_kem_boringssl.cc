@@ -61,37 +61,44 @@ EciesHkdfNistPCurveRecipientKemBoringSsl::New(EllipticCurveType curve,
   }
   auto status_or_ec_group = SubtleUtilBoringSSL::GetEcGroup(curve);
   if (!status_or_ec_group.ok()) return status_or_ec_group.status();
-  // TODO(przydatek): consider refactoring SubtleUtilBoringSSL,
-  //     so that the saved group can be used for KEM operations.
+  bssl::UniquePtr<EC_GROUP> ec_group(status_or_ec_group.ValueOrDie());
+  bssl::UniquePtr<BIGNUM> priv_key_bn(
+      BN_bin2bn(priv_key.data(), priv_key.size(), nullptr));
+  if (priv_key_bn == nullptr) {
+    return util::Status(util::error::INTERNAL, "BN_bin2bn failed");
+  }
   return {absl::WrapUnique(new EciesHkdfNistPCurveRecipientKemBoringSsl(
-      curve, std::move(priv_key), status_or_ec_group.ValueOrDie()))};
+      std::move(ec_group), std::move(priv_key_bn)))};
 }
 
 EciesHkdfNistPCurveRecipientKemBoringSsl::
-    EciesHkdfNistPCurveRecipientKemBoringSsl(EllipticCurveType curve,
-                                             util::SecretData priv_key_value,
-                                             EC_GROUP* ec_group)
-    : curve_(curve),
-      priv_key_value_(std::move(priv_key_value)),
-      ec_group_(ec_group) {}
+    EciesHkdfNistPCurveRecipientKemBoringSsl(
+        bssl::UniquePtr<EC_GROUP> ec_group, bssl::UniquePtr<BIGNUM> priv_key)
+    : ec_group_(std::move(ec_group)), priv_key_(std::move(priv_key)) {}
+
+EciesHkdfNistPCurveRecipientKemBoringSsl::
+    ~EciesHkdfNistPCurveRecipientKemBoringSsl() {
+  // BN_free() does not clear the value.
+  BN_clear(priv_key_.get());
+}
 
 util::StatusOr<util::SecretData>
 EciesHkdfNistPCurveRecipientKemBoringSsl::GenerateKey(
     absl::string_view kem_bytes, HashType hash, absl::string_view hkdf_salt,
     absl::string_view hkdf_info, uint32_t key_size_in_bytes,
     EcPointFormat point_format) const {
-  auto status_or_ec_point =
-      SubtleUtilBoringSSL::EcPointDecode(curve_, point_format, kem_bytes);
+  // The group and the private key are only read here, so concurrent calls
+  // can share them.
+  auto status_or_ec_point = SubtleUtilBoringSSL::EcPointDecode(
+      ec_group_.get(), point_format, kem_bytes);
   if (!status_or_ec_point.ok()) {
     return ToStatusF(util::error::INVALID_ARGUMENT, "Invalid KEM bytes: %s",
                      status_or_ec_point.status().error_message());
   }
   bssl::UniquePtr<EC_POINT> pub_key =
       std::move(status_or_ec_point.ValueOrDie());
-  bssl::UniquePtr<BIGNUM> priv_key(
-      BN_bin2bn(priv_key_value_.data(), priv_key_value_.size(), nullptr));
   auto shared_secret_or = SubtleUtilBoringSSL::ComputeEcdhSharedSecret(
-      curve_, priv_key.get(), pub_key.get());
+      ec_group_.get(), priv_key_.get(), pub_key.get());
   if (!shared_secret_or.ok()) {
     return shared_secret_or.status();
   }
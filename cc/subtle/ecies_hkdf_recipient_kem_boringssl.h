@@ -18,6 +18,7 @@
 #define TINK_SUBTLE_ECIES_HKDF_RECIPIENT_KEM_BORINGSSL_H_
 
 #include "absl/strings/string_view.h"
+#include "openssl/bn.h"
 #include "openssl/curve25519.h"
 #include "openssl/ec.h"
 #include "tink/config/tink_fips.h"
@@ -68,17 +69,17 @@ class EciesHkdfNistPCurveRecipientKemBoringSsl
       absl::string_view hkdf_info, uint32_t key_size_in_bytes,
       EcPointFormat point_format) const override;
 
+  ~EciesHkdfNistPCurveRecipientKemBoringSsl() override;
+
   static constexpr crypto::tink::FipsCompatibility kFipsStatus =
       crypto::tink::FipsCompatibility::kNotFips;
 
  private:
-  EciesHkdfNistPCurveRecipientKemBoringSsl(EllipticCurveType curve,
-                                           util::SecretData priv_key_value,
-                                           EC_GROUP* ec_group);
+  EciesHkdfNistPCurveRecipientKemBoringSsl(bssl::UniquePtr<EC_GROUP> ec_group,
+                                           bssl::UniquePtr<BIGNUM> priv_key);
 
-  EllipticCurveType curve_;
-  util::SecretData priv_key_value_;
-  bssl::UniquePtr<EC_GROUP> ec_group_;
+  const bssl::UniquePtr<EC_GROUP> ec_group_;
+  const bssl::UniquePtr<BIGNUM> priv_key_;
 };
 
 // Implementation of EciesHkdfRecipientKemBoringSsl for curve25519.
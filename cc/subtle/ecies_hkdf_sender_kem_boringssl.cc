@@ -16,6 +16,8 @@
 
 #include "tink/subtle/ecies_hkdf_sender_kem_boringssl.h"
 
+#include <utility>
+
 #include "absl/memory/memory.h"
 #include "openssl/bn.h"
 #include "openssl/curve25519.h"
@@ -47,26 +49,92 @@ EciesHkdfSenderKemBoringSsl::New(subtle::EllipticCurveType curve,
 
 EciesHkdfNistPCurveSendKemBoringSsl::EciesHkdfNistPCurveSendKemBoringSsl(
     subtle::EllipticCurveType curve, const std::string& pubx,
-    const std::string& puby, EC_POINT* peer_pub_key)
-    : curve_(curve), pubx_(pubx), puby_(puby), peer_pub_key_(peer_pub_key) {}
+    const std::string& puby, EC_GROUP* group, EC_POINT* peer_pub_key,
+    size_t ephemeral_key_pool_size)
+    : curve_(curve),
+      pubx_(pubx),
+      puby_(puby),
+      group_(group),
+      peer_pub_key_(peer_pub_key),
+      ephemeral_key_pool_size_(ephemeral_key_pool_size) {}
 
 // static
 util::StatusOr<std::unique_ptr<const EciesHkdfSenderKemBoringSsl>>
 EciesHkdfNistPCurveSendKemBoringSsl::New(subtle::EllipticCurveType curve,
                                          const std::string& pubx,
                                          const std::string& puby) {
+  auto status_or_sender_kem = NewWithEphemeralKeyPool(
+      curve, pubx, puby, /*ephemeral_key_pool_size=*/0);
+  if (!status_or_sender_kem.ok()) return status_or_sender_kem.status();
+  std::unique_ptr<const EciesHkdfSenderKemBoringSsl> sender_kem(
+      std::move(status_or_sender_kem.ValueOrDie()));
+  return std::move(sender_kem);
+}
+
+// static
+util::StatusOr<std::unique_ptr<const EciesHkdfNistPCurveSendKemBoringSsl>>
+EciesHkdfNistPCurveSendKemBoringSsl::NewWithEphemeralKeyPool(
+    subtle::EllipticCurveType curve, const std::string& pubx,
+    const std::string& puby, size_t ephemeral_key_pool_size) {
   auto status = CheckFipsCompatibility<EciesHkdfNistPCurveSendKemBoringSsl>();
   if (!status.ok()) return status;
 
+  auto status_or_ec_group = SubtleUtilBoringSSL::GetEcGroup(curve);
+  if (!status_or_ec_group.ok()) return status_or_ec_group.status();
+  bssl::UniquePtr<EC_GROUP> group(status_or_ec_group.ValueOrDie());
   auto status_or_ec_point =
       SubtleUtilBoringSSL::GetEcPoint(curve, pubx, puby);
   if (!status_or_ec_point.ok()) return status_or_ec_point.status();
-  std::unique_ptr<const EciesHkdfSenderKemBoringSsl> sender_kem(
-      new EciesHkdfNistPCurveSendKemBoringSsl(curve, pubx, puby,
-                                              status_or_ec_point.ValueOrDie()));
+  std::unique_ptr<const EciesHkdfNistPCurveSendKemBoringSsl> sender_kem(
+      new EciesHkdfNistPCurveSendKemBoringSsl(
+          curve, pubx, puby, group.release(), status_or_ec_point.ValueOrDie(),
+          ephemeral_key_pool_size));
   return std::move(sender_kem);
 }
 
+util::StatusOr<bssl::UniquePtr<EC_KEY>>
+EciesHkdfNistPCurveSendKemBoringSsl::NewEphemeralKey() const {
+  bssl::UniquePtr<EC_KEY> ephemeral_key(EC_KEY_new());
+  if (1 != EC_KEY_set_group(ephemeral_key.get(), group_.get())) {
+    return util::Status(util::error::INTERNAL, "EC_KEY_set_group failed");
+  }
+  if (1 != EC_KEY_generate_key(ephemeral_key.get())) {
+    return util::Status(util::error::INTERNAL, "EC_KEY_generate_key failed");
+  }
+  return std::move(ephemeral_key);
+}
+
+bssl::UniquePtr<EC_KEY>
+EciesHkdfNistPCurveSendKemBoringSsl::TakeEphemeralKeyFromPool() const {
+  absl::MutexLock lock(&ephemeral_key_pool_mutex_);
+  if (ephemeral_key_pool_.empty()) return nullptr;
+  bssl::UniquePtr<EC_KEY> ephemeral_key =
+      std::move(ephemeral_key_pool_.back());
+  ephemeral_key_pool_.pop_back();
+  return ephemeral_key;
+}
+
+util::Status EciesHkdfNistPCurveSendKemBoringSsl::RefillEphemeralKeyPool()
+    const {
+  while (EphemeralKeyPoolSize() < ephemeral_key_pool_size_) {
+    auto status_or_ephemeral_key = NewEphemeralKey();
+    if (!status_or_ephemeral_key.ok()) return status_or_ephemeral_key.status();
+    absl::MutexLock lock(&ephemeral_key_pool_mutex_);
+    // GenerateKey() may have emptied the pool or another refill may have
+    // filled it meanwhile; a surplus key pair is just freed.
+    if (ephemeral_key_pool_.size() < ephemeral_key_pool_size_) {
+      ephemeral_key_pool_.push_back(
+          std::move(status_or_ephemeral_key.ValueOrDie()));
+    }
+  }
+  return util::Status::OK;
+}
+
+size_t EciesHkdfNistPCurveSendKemBoringSsl::EphemeralKeyPoolSize() const {
+  absl::MutexLock lock(&ephemeral_key_pool_mutex_);
+  return ephemeral_key_pool_.size();
+}
+
 util::StatusOr<std::unique_ptr<const EciesHkdfSenderKemBoringSsl::KemKey>>
 EciesHkdfNistPCurveSendKemBoringSsl::GenerateKey(
     subtle::HashType hash, absl::string_view hkdf_salt,
@@ -77,17 +145,13 @@ EciesHkdfNistPCurveSendKemBoringSsl::GenerateKey(
                         "peer_pub_key_ wasn't initialized");
   }
 
-  auto status_or_ec_group = SubtleUtilBoringSSL::GetEcGroup(curve_);
-  if (!status_or_ec_group.ok()) {
-    return status_or_ec_group.status();
-  }
-  bssl::UniquePtr<EC_GROUP> group(status_or_ec_group.ValueOrDie());
-  bssl::UniquePtr<EC_KEY> ephemeral_key(EC_KEY_new());
-  if (1 != EC_KEY_set_group(ephemeral_key.get(), group.get())) {
-    return util::Status(util::error::INTERNAL, "EC_KEY_set_group failed");
-  }
-  if (1 != EC_KEY_generate_key(ephemeral_key.get())) {
-    return util::Status(util::error::INTERNAL, "EC_KEY_generate_key failed");
+  // EC_KEY_free wipes the private key, so a pooled key pair is destroyed
+  // together with 'ephemeral_key' once it has been used here.
+  bssl::UniquePtr<EC_KEY> ephemeral_key = TakeEphemeralKeyFromPool();
+  if (ephemeral_key == nullptr) {
+    auto status_or_ephemeral_key = NewEphemeralKey();
+    if (!status_or_ephemeral_key.ok()) return status_or_ephemeral_key.status();
+    ephemeral_key = std::move(status_or_ephemeral_key.ValueOrDie());
   }
   const BIGNUM* ephemeral_priv = EC_KEY_get0_private_key(ephemeral_key.get());
   const EC_POINT* ephemeral_pub = EC_KEY_get0_public_key(ephemeral_key.get());
@@ -98,7 +162,7 @@ EciesHkdfNistPCurveSendKemBoringSsl::GenerateKey(
   }
   std::string kem_bytes = status_or_string_kem.ValueOrDie();
   auto status_or_string_shared_secret =
-      SubtleUtilBoringSSL::ComputeEcdhSharedSecret(curve_, ephemeral_priv,
+      SubtleUtilBoringSSL::ComputeEcdhSharedSecret(group_.get(), ephemeral_priv,
                                                    peer_pub_key_.get());
   if (!status_or_string_shared_secret.ok()) {
     return status_or_string_shared_secret.status();
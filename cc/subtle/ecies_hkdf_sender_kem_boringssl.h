@@ -17,12 +17,19 @@
 #ifndef TINK_SUBTLE_ECIES_HKDF_SENDER_KEM_BORINGSSL_H_
 #define TINK_SUBTLE_ECIES_HKDF_SENDER_KEM_BORINGSSL_H_
 
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "openssl/curve25519.h"
 #include "openssl/ec.h"
 #include "tink/config/tink_fips.h"
 #include "tink/subtle/common_enums.h"
 #include "tink/util/secret_data.h"
+#include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
 namespace crypto {
@@ -70,6 +77,14 @@ class EciesHkdfSenderKemBoringSsl {
 };
 
 // Implementation of EciesHkdfSenderKemBoringSsl for the NIST P-curves.
+//
+// Generating the ephemeral key pair is the most expensive part of
+// GenerateKey(). A KEM created with NewWithEphemeralKeyPool() can generate
+// ephemeral key pairs ahead of time, in RefillEphemeralKeyPool(); GenerateKey()
+// then takes a key pair from the pool and only computes the ECDH shared
+// secret and the HKDF. Each pooled key pair is used exactly once and is wiped
+// when it is freed after use. If the pool is empty, GenerateKey() generates
+// a key pair itself, as a KEM without pool does.
 class EciesHkdfNistPCurveSendKemBoringSsl : public EciesHkdfSenderKemBoringSsl {
  public:
   // Constructs a sender KEM for the specified curve and recipient's
@@ -79,6 +94,14 @@ class EciesHkdfNistPCurveSendKemBoringSsl : public EciesHkdfSenderKemBoringSsl {
   New(EllipticCurveType curve, const std::string& pubx,
       const std::string& puby);
 
+  // Like New(), but the KEM holds up to 'ephemeral_key_pool_size' ephemeral
+  // key pairs generated by RefillEphemeralKeyPool(). The pool starts empty.
+  static crypto::tink::util::StatusOr<
+      std::unique_ptr<const EciesHkdfNistPCurveSendKemBoringSsl>>
+  NewWithEphemeralKeyPool(EllipticCurveType curve, const std::string& pubx,
+                          const std::string& puby,
+                          size_t ephemeral_key_pool_size);
+
   // Generates ephemeral key pairs, computes ECDH's shared secret based on
   // generated ephemeral key and recipient's public key, then uses HKDF
   // to derive the symmetric key from the shared secret, 'hkdf_info' and
@@ -87,6 +110,15 @@ class EciesHkdfNistPCurveSendKemBoringSsl : public EciesHkdfSenderKemBoringSsl {
       HashType hash, absl::string_view hkdf_salt, absl::string_view hkdf_info,
       uint32_t key_size_in_bytes, EcPointFormat point_format) const override;
 
+  // Generates ephemeral key pairs until the pool is full. The key pairs are
+  // generated without holding the pool's lock, so this can run on a
+  // background thread concurrently with GenerateKey(). Does nothing for a
+  // KEM created with New().
+  crypto::tink::util::Status RefillEphemeralKeyPool() const;
+
+  // Returns the number of ephemeral key pairs currently in the pool.
+  size_t EphemeralKeyPoolSize() const;
+
   static constexpr crypto::tink::FipsCompatibility kFipsStatus =
       crypto::tink::FipsCompatibility::kNotFips;
 
@@ -94,12 +126,26 @@ class EciesHkdfNistPCurveSendKemBoringSsl : public EciesHkdfSenderKemBoringSsl {
   EciesHkdfNistPCurveSendKemBoringSsl(EllipticCurveType curve,
                                       const std::string& pubx,
                                       const std::string& puby,
-                                      EC_POINT* peer_pub_key);
+                                      EC_GROUP* group, EC_POINT* peer_pub_key,
+                                      size_t ephemeral_key_pool_size);
+
+  // Generates a fresh ephemeral key pair on 'group_'.
+  crypto::tink::util::StatusOr<bssl::UniquePtr<EC_KEY>> NewEphemeralKey()
+      const;
+
+  // Removes and returns an ephemeral key pair from the pool, or nullptr if
+  // the pool is empty.
+  bssl::UniquePtr<EC_KEY> TakeEphemeralKeyFromPool() const;
 
   EllipticCurveType curve_;
   std::string pubx_;
   std::string puby_;
+  bssl::UniquePtr<EC_GROUP> group_;
   bssl::UniquePtr<EC_POINT> peer_pub_key_;
+  const size_t ephemeral_key_pool_size_;
+  mutable absl::Mutex ephemeral_key_pool_mutex_;
+  mutable std::vector<bssl::UniquePtr<EC_KEY>> ephemeral_key_pool_
+      ABSL_GUARDED_BY(ephemeral_key_pool_mutex_);
 };
 
 // Implementation of EciesHkdfSenderKemBoringSsl for curve25519.
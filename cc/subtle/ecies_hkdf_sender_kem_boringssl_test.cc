@@ -17,6 +17,8 @@
 #include "tink/subtle/ecies_hkdf_sender_kem_boringssl.h"
 
 #include <iostream>
+#include <set>
+#include <string>
 
 #include "gtest/gtest.h"
 #include "tink/subtle/common_enums.h"
@@ -169,6 +171,63 @@ TEST_F(EciesHkdfNistPCurveSendKemBoringSslTest, TestGenerateKey) {
   EXPECT_EQ(kem_key->get_symmetric_key().size(), key_size_in_bytes);
 }
 
+TEST_F(EciesHkdfNistPCurveSendKemBoringSslTest, TestEphemeralKeyPool) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  EllipticCurveType curve = EllipticCurveType::NIST_P256;
+  auto status_or_test_key = SubtleUtilBoringSSL::GetNewEcKey(curve);
+  ASSERT_TRUE(status_or_test_key.ok());
+  auto test_key = status_or_test_key.ValueOrDie();
+  auto status_or_sender_kem =
+      EciesHkdfNistPCurveSendKemBoringSsl::NewWithEphemeralKeyPool(
+          curve, test_key.pub_x, test_key.pub_y, 3);
+  ASSERT_TRUE(status_or_sender_kem.ok());
+  auto sender_kem = std::move(status_or_sender_kem.ValueOrDie());
+  auto recipient_kem =
+      std::move(EciesHkdfRecipientKemBoringSsl::New(curve, test_key.priv)
+                    .ValueOrDie());
+  EXPECT_EQ(sender_kem->EphemeralKeyPoolSize(), 0);
+  ASSERT_TRUE(sender_kem->RefillEphemeralKeyPool().ok());
+  EXPECT_EQ(sender_kem->EphemeralKeyPoolSize(), 3);
+
+  // Each key pair is used once; once the pool is empty, GenerateKey keeps
+  // working with fresh key pairs.
+  std::set<std::string> kem_bytes;
+  for (int i = 0; i < 5; i++) {
+    auto status_or_kem_key =
+        sender_kem->GenerateKey(HashType::SHA256, "hkdf_salt", "hkdf_info",
+                                32, EcPointFormat::UNCOMPRESSED);
+    ASSERT_TRUE(status_or_kem_key.ok());
+    auto kem_key = std::move(status_or_kem_key.ValueOrDie());
+    EXPECT_TRUE(kem_bytes.insert(kem_key->get_kem_bytes()).second);
+    auto status_or_symmetric_key = recipient_kem->GenerateKey(
+        kem_key->get_kem_bytes(), HashType::SHA256, "hkdf_salt", "hkdf_info",
+        32, EcPointFormat::UNCOMPRESSED);
+    ASSERT_TRUE(status_or_symmetric_key.ok());
+    EXPECT_EQ(status_or_symmetric_key.ValueOrDie(),
+              kem_key->get_symmetric_key());
+    EXPECT_EQ(sender_kem->EphemeralKeyPoolSize(), i < 3 ? 2 - i : 0);
+  }
+}
+
+TEST_F(EciesHkdfNistPCurveSendKemBoringSslTest, TestRefillWithoutPool) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  EllipticCurveType curve = EllipticCurveType::NIST_P256;
+  auto status_or_test_key = SubtleUtilBoringSSL::GetNewEcKey(curve);
+  ASSERT_TRUE(status_or_test_key.ok());
+  auto test_key = status_or_test_key.ValueOrDie();
+  auto status_or_sender_kem =
+      EciesHkdfNistPCurveSendKemBoringSsl::NewWithEphemeralKeyPool(
+          curve, test_key.pub_x, test_key.pub_y, 0);
+  ASSERT_TRUE(status_or_sender_kem.ok());
+  auto sender_kem = std::move(status_or_sender_kem.ValueOrDie());
+  ASSERT_TRUE(sender_kem->RefillEphemeralKeyPool().ok());
+  EXPECT_EQ(sender_kem->EphemeralKeyPoolSize(), 0);
+}
+
 class EciesHkdfX25519SendKemBoringSslTest : public ::testing::Test {};
 
 TEST_F(EciesHkdfX25519SendKemBoringSslTest, TestNew) {
@@ -18,6 +18,7 @@
 
 #include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "absl/strings/string_view.h"
@@ -73,7 +74,7 @@ util::StatusOr<std::string> EncryptThenAuthenticate::Encrypt(
   if (!ct.ok()) {
     return ct.status();
   }
-  std::string ciphertext(ct.ValueOrDie());
+  std::string ciphertext = std::move(ct.ValueOrDie());
   std::string toAuthData = absl::StrCat(additional_data, ciphertext,
                                         longToBigEndianStr(aad_size_in_bits));
 
@@ -0,0 +1,173 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/hmac_batch.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "openssl/base.h"
+#include "openssl/digest.h"
+#include "openssl/hkdf.h"
+#include "openssl/hmac.h"
+#include "tink/subtle/common_enums.h"
+#include "tink/subtle/hmac_sha256_multi_buffer.h"
+#include "tink/subtle/subtle_util_boringssl.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+namespace {
+
+// HKDF-Expand computes at most 255 blocks, RFC 5869, Section 2.3.
+constexpr size_t kMaxHkdfBlocks = 255;
+
+}  // namespace
+
+util::StatusOr<std::unique_ptr<HmacBatch>> HmacBatch::NewWithMd(
+    const EVP_MD* md, const uint8_t* key, size_t key_size) {
+  bssl::UniquePtr<HMAC_CTX> ctx(HMAC_CTX_new());
+  if (ctx == nullptr ||
+      !HMAC_Init_ex(ctx.get(), key, key_size, md, nullptr /* engine */)) {
+    return util::Status(util::error::INTERNAL, "HMAC initialization failed");
+  }
+  std::unique_ptr<HmacSha256MultiBuffer> multi_buffer;
+  if (md == EVP_sha256()) {
+    multi_buffer = HmacSha256MultiBuffer::New(key, key_size);
+  }
+  return {absl::WrapUnique(new HmacBatch(EVP_MD_size(md), std::move(ctx),
+                                         std::move(multi_buffer)))};
+}
+
+util::StatusOr<std::unique_ptr<HmacBatch>> HmacBatch::New(
+    HashType hash_type, const util::SecretData& key) {
+  util::StatusOr<const EVP_MD*> md = SubtleUtilBoringSSL::EvpHash(hash_type);
+  if (!md.ok()) return md.status();
+  return NewWithMd(md.ValueOrDie(), key.data(), key.size());
+}
+
+util::StatusOr<std::unique_ptr<HmacBatch>> HmacBatch::NewHkdf(
+    HashType hash_type, const util::SecretData& secret,
+    absl::string_view salt) {
+  util::StatusOr<const EVP_MD*> md = SubtleUtilBoringSSL::EvpHash(hash_type);
+  if (!md.ok()) return md.status();
+  util::SecretData prk(EVP_MAX_MD_SIZE);
+  size_t prk_len;
+  if (HKDF_extract(prk.data(), &prk_len, md.ValueOrDie(), secret.data(),
+                   secret.size(), reinterpret_cast<const uint8_t*>(salt.data()),
+                   salt.size()) != 1) {
+    return util::Status(util::error::INTERNAL, "BoringSSL's HKDF failed");
+  }
+  return NewWithMd(md.ValueOrDie(), prk.data(), prk_len);
+}
+
+util::StatusOr<bssl::UniquePtr<HMAC_CTX>> HmacBatch::CopyKeyedContext()
+    const {
+  bssl::UniquePtr<HMAC_CTX> ctx(HMAC_CTX_new());
+  if (ctx == nullptr || !HMAC_CTX_copy_ex(ctx.get(), keyed_ctx_.get())) {
+    return util::Status(util::error::INTERNAL, "HMAC initialization failed");
+  }
+  return std::move(ctx);
+}
+
+util::Status HmacBatch::Compute(absl::Span<const absl::string_view> data,
+                                size_t tag_size,
+                                absl::Span<uint8_t> out) const {
+  if (tag_size > digest_size_) {
+    return util::Status(util::error::INVALID_ARGUMENT, "invalid tag size");
+  }
+  if (out.size() != data.size() * tag_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "invalid size of the output buffer");
+  }
+  if (multi_buffer_ != nullptr && 2 * data.size() >= multi_buffer_->lanes()) {
+    multi_buffer_->Compute(data, tag_size, out.data());
+    return util::OkStatus();
+  }
+  auto ctx_result = CopyKeyedContext();
+  if (!ctx_result.ok()) return ctx_result.status();
+  HMAC_CTX* ctx = ctx_result.ValueOrDie().get();
+  uint8_t buf[EVP_MAX_MD_SIZE];
+  for (size_t i = 0; i < data.size(); i++) {
+    // BoringSSL expects a non-null pointer for data,
+    // regardless of whether the size is 0.
+    absl::string_view message = SubtleUtilBoringSSL::EnsureNonNull(data[i]);
+    // Passing no key and no digest restores the keyed state.
+    if (!HMAC_Init_ex(ctx, nullptr, 0, nullptr, nullptr) ||
+        !HMAC_Update(ctx, reinterpret_cast<const uint8_t*>(message.data()),
+                     message.size()) ||
+        !HMAC_Final(ctx, buf, nullptr)) {
+      OPENSSL_cleanse(buf, sizeof(buf));
+      return util::Status(util::error::INTERNAL, "HMAC computation failed");
+    }
+    std::copy_n(buf, tag_size, out.data() + i * tag_size);
+  }
+  OPENSSL_cleanse(buf, sizeof(buf));
+  return util::OkStatus();
+}
+
+util::Status HmacBatch::HkdfExpand(absl::Span<const absl::string_view> infos,
+                                   size_t output_length,
+                                   absl::Span<uint8_t> out) const {
+  if (output_length > kMaxHkdfBlocks * digest_size_) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "invalid output length");
+  }
+  if (out.size() != infos.size() * output_length) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "invalid size of the output buffer");
+  }
+  auto ctx_result = CopyKeyedContext();
+  if (!ctx_result.ok()) return ctx_result.status();
+  HMAC_CTX* ctx = ctx_result.ValueOrDie().get();
+  // T(i) = HMAC-Hash(PRK, T(i - 1) | info | i), with T(0) empty.
+  uint8_t t[EVP_MAX_MD_SIZE];
+  for (size_t i = 0; i < infos.size(); i++) {
+    absl::string_view info = SubtleUtilBoringSSL::EnsureNonNull(infos[i]);
+    uint8_t* output = out.data() + i * output_length;
+    size_t remaining = output_length;
+    for (uint8_t block = 1; remaining > 0; block++) {
+      const size_t previous_size = block == 1 ? 0 : digest_size_;
+      if (!HMAC_Init_ex(ctx, nullptr, 0, nullptr, nullptr) ||
+          !HMAC_Update(ctx, t, previous_size) ||
+          !HMAC_Update(ctx, reinterpret_cast<const uint8_t*>(info.data()),
+                       info.size()) ||
+          !HMAC_Update(ctx, &block, 1) || !HMAC_Final(ctx, t, nullptr)) {
+        OPENSSL_cleanse(t, sizeof(t));
+        return util::Status(util::error::INTERNAL, "BoringSSL's HKDF failed");
+      }
+      const size_t size = std::min(remaining, digest_size_);
+      output = std::copy_n(t, size, output);
+      remaining -= size;
+    }
+  }
+  OPENSSL_cleanse(t, sizeof(t));
+  return util::OkStatus();
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,100 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_SUBTLE_HMAC_BATCH_H_
+#define TINK_SUBTLE_HMAC_BATCH_H_
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "openssl/base.h"
+#include "openssl/hmac.h"
+#include "tink/subtle/common_enums.h"
+#include "tink/subtle/hmac_sha256_multi_buffer.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// An HMAC key, hashed into the inner and outer HMAC states once upon
+// creation. Each message of a batch then starts from a copy of these states,
+// so neither the key schedule nor any per-message allocation is repeated.
+// The output is written into caller-provided buffers. For SHA-256, larger
+// batches are computed with HmacSha256MultiBuffer where it is available.
+//
+// This class is thread-safe.
+class HmacBatch {
+ public:
+  // Returns an HmacBatch keyed with 'key'.
+  static util::StatusOr<std::unique_ptr<HmacBatch>> New(
+      HashType hash_type, const util::SecretData& key);
+
+  // Returns an HmacBatch keyed with the pseudorandom key computed by
+  // HKDF-Extract(salt, secret) of RFC 5869, Section 2.2, for use with
+  // HkdfExpand().
+  static util::StatusOr<std::unique_ptr<HmacBatch>> NewHkdf(
+      HashType hash_type, const util::SecretData& secret,
+      absl::string_view salt);
+
+  // The size of the HMAC output in bytes.
+  size_t digest_size() const { return digest_size_; }
+
+  // Computes the HMAC of each of 'data', and writes their first 'tag_size'
+  // bytes back to back into 'out', which must hold exactly
+  // data.size() * tag_size bytes.
+  util::Status Compute(absl::Span<const absl::string_view> data,
+                       size_t tag_size, absl::Span<uint8_t> out) const;
+
+  // Computes HKDF-Expand(PRK, info, output_length) of RFC 5869, Section 2.3,
+  // with this key as PRK, for each of 'infos', and writes the results back to
+  // back into 'out', which must hold exactly infos.size() * output_length
+  // bytes.
+  util::Status HkdfExpand(absl::Span<const absl::string_view> infos,
+                          size_t output_length,
+                          absl::Span<uint8_t> out) const;
+
+ private:
+  HmacBatch(size_t digest_size, bssl::UniquePtr<HMAC_CTX> keyed_ctx,
+            std::unique_ptr<HmacSha256MultiBuffer> multi_buffer)
+      : digest_size_(digest_size),
+        keyed_ctx_(std::move(keyed_ctx)),
+        multi_buffer_(std::move(multi_buffer)) {}
+
+  static util::StatusOr<std::unique_ptr<HmacBatch>> NewWithMd(
+      const EVP_MD* md, const uint8_t* key, size_t key_size);
+
+  // Returns a copy of keyed_ctx_, to be reset for every message.
+  util::StatusOr<bssl::UniquePtr<HMAC_CTX>> CopyKeyedContext() const;
+
+  const size_t digest_size_;
+  const bssl::UniquePtr<HMAC_CTX> keyed_ctx_;
+  // Null unless the hash is SHA-256 and a multi-buffer implementation is
+  // available.
+  const std::unique_ptr<HmacSha256MultiBuffer> multi_buffer_;
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_HMAC_BATCH_H_
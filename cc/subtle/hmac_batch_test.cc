@@ -0,0 +1,165 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/hmac_batch.h"
+
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "openssl/hkdf.h"
+#include "openssl/hmac.h"
+#include "tink/subtle/common_enums.h"
+#include "tink/subtle/random.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+std::string ToString(const std::vector<uint8_t>& buffer, size_t begin,
+                     size_t size) {
+  return std::string(buffer.begin() + begin, buffer.begin() + begin + size);
+}
+
+// Test case 2 of RFC 4231.
+TEST(HmacBatchTest, Rfc4231TestVector) {
+  auto hmac_result =
+      HmacBatch::New(SHA256, util::SecretDataFromStringView("Jefe"));
+  ASSERT_THAT(hmac_result.status(), IsOk());
+  std::vector<absl::string_view> data = {"what do ya want for nothing?"};
+  std::vector<uint8_t> tag(32);
+  ASSERT_THAT(hmac_result.ValueOrDie()->Compute(data, 32, absl::MakeSpan(tag)),
+              IsOk());
+  EXPECT_EQ(test::HexEncode(ToString(tag, 0, 32)),
+            "5bdcc146bf60754e6a042426089575c7"
+            "5a003f089d2739839dec58b964ec3843");
+}
+
+TEST(HmacBatchTest, MatchesSingleMessageHmac) {
+  util::SecretData key =
+      util::SecretDataFromStringView(Random::GetRandomBytes(32));
+  for (HashType hash : {SHA1, SHA256, SHA512}) {
+    auto hmac_result = HmacBatch::New(hash, key);
+    ASSERT_THAT(hmac_result.status(), IsOk());
+    const EVP_MD* md = hash == SHA1     ? EVP_sha1()
+                       : hash == SHA256 ? EVP_sha256()
+                                        : EVP_sha512();
+    std::vector<std::string> messages;
+    for (size_t size = 0; size < 300; size += 7) {
+      messages.push_back(Random::GetRandomBytes(size));
+    }
+    std::vector<absl::string_view> data(messages.begin(), messages.end());
+    const size_t tag_size = hmac_result.ValueOrDie()->digest_size() - 3;
+    std::vector<uint8_t> tags(messages.size() * tag_size);
+    ASSERT_THAT(
+        hmac_result.ValueOrDie()->Compute(data, tag_size, absl::MakeSpan(tags)),
+        IsOk());
+    for (size_t i = 0; i < messages.size(); i++) {
+      uint8_t expected[EVP_MAX_MD_SIZE];
+      unsigned int expected_size;
+      ASSERT_NE(HMAC(md, key.data(), key.size(),
+                     reinterpret_cast<const uint8_t*>(messages[i].data()),
+                     messages[i].size(), expected, &expected_size),
+                nullptr);
+      EXPECT_EQ(ToString(tags, i * tag_size, tag_size),
+                std::string(reinterpret_cast<char*>(expected), tag_size));
+    }
+  }
+}
+
+// Test case 1 of RFC 5869.
+TEST(HmacBatchTest, Rfc5869TestVector) {
+  auto hkdf_result = HmacBatch::NewHkdf(
+      SHA256,
+      util::SecretDataFromStringView(
+          test::HexDecodeOrDie("0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b")),
+      test::HexDecodeOrDie("000102030405060708090a0b0c"));
+  ASSERT_THAT(hkdf_result.status(), IsOk());
+  std::string info = test::HexDecodeOrDie("f0f1f2f3f4f5f6f7f8f9");
+  std::vector<absl::string_view> infos = {info};
+  std::vector<uint8_t> okm(42);
+  ASSERT_THAT(
+      hkdf_result.ValueOrDie()->HkdfExpand(infos, 42, absl::MakeSpan(okm)),
+      IsOk());
+  EXPECT_EQ(test::HexEncode(ToString(okm, 0, 42)),
+            "3cb25f25faacd57a90434f64d0362f2a2d2d0a90cf1a5a4c5db02d56ecc4c5bf"
+            "34007208d5b887185865");
+}
+
+TEST(HmacBatchTest, MatchesSingleMessageHkdf) {
+  util::SecretData secret =
+      util::SecretDataFromStringView(Random::GetRandomBytes(32));
+  std::string salt = Random::GetRandomBytes(16);
+  auto hkdf_result = HmacBatch::NewHkdf(SHA512, secret, salt);
+  ASSERT_THAT(hkdf_result.status(), IsOk());
+  std::vector<std::string> inputs;
+  for (size_t size = 0; size < 100; size += 9) {
+    inputs.push_back(Random::GetRandomBytes(size));
+  }
+  std::vector<absl::string_view> infos(inputs.begin(), inputs.end());
+  // More than two blocks, the last of which is partial.
+  const size_t output_length = 150;
+  std::vector<uint8_t> out(inputs.size() * output_length);
+  ASSERT_THAT(hkdf_result.ValueOrDie()->HkdfExpand(infos, output_length,
+                                                   absl::MakeSpan(out)),
+              IsOk());
+  for (size_t i = 0; i < inputs.size(); i++) {
+    uint8_t expected[output_length];
+    ASSERT_EQ(HKDF(expected, output_length, EVP_sha512(), secret.data(),
+                   secret.size(), reinterpret_cast<const uint8_t*>(salt.data()),
+                   salt.size(),
+                   reinterpret_cast<const uint8_t*>(inputs[i].data()),
+                   inputs[i].size()),
+              1);
+    EXPECT_EQ(ToString(out, i * output_length, output_length),
+              std::string(reinterpret_cast<char*>(expected), output_length));
+  }
+}
+
+TEST(HmacBatchTest, InvalidParameters) {
+  auto hmac_result = HmacBatch::New(
+      SHA256, util::SecretDataFromStringView(Random::GetRandomBytes(32)));
+  ASSERT_THAT(hmac_result.status(), IsOk());
+  std::vector<absl::string_view> data = {"data", "more data"};
+  std::vector<uint8_t> out(2 * 33);
+  EXPECT_THAT(
+      hmac_result.ValueOrDie()->Compute(data, 33, absl::MakeSpan(out)),
+      StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(
+      hmac_result.ValueOrDie()->Compute(data, 16, absl::MakeSpan(out)),
+      StatusIs(util::error::INVALID_ARGUMENT));
+  std::vector<uint8_t> long_out(2 * (255 * 32 + 1));
+  EXPECT_THAT(hmac_result.ValueOrDie()->HkdfExpand(data, 255 * 32 + 1,
+                                                   absl::MakeSpan(long_out)),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
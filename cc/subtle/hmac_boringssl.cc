@@ -16,13 +16,20 @@
 
 #include "tink/subtle/hmac_boringssl.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include "absl/memory/memory.h"
+#include "absl/types/span.h"
 #include "tink/mac.h"
 #include "tink/subtle/common_enums.h"
+#include "tink/subtle/hmac_sha256_multi_buffer.h"
+#include "tink/subtle/subtle_util.h"
 #include "tink/subtle/subtle_util_boringssl.h"
 #include "tink/util/errors.h"
+#include "tink/util/output_buffer_factory.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "openssl/digest.h"
@@ -57,51 +64,145 @@ util::StatusOr<std::unique_ptr<Mac>> HmacBoringSsl::New(HashType hash_type,
   if (key.size() < kMinKeySize) {
     return util::Status(util::error::INVALID_ARGUMENT, "invalid key size");
   }
-  return {absl::WrapUnique(new HmacBoringSsl(md, tag_size, std::move(key)))};
+  util::SecretUniquePtr<HMAC_CTX> keyed_ctx =
+      util::MakeKeyStateUniquePtr<HMAC_CTX>();
+  HMAC_CTX_init(keyed_ctx.get());
+  if (!HMAC_Init_ex(keyed_ctx.get(), key.data(), key.size(), md,
+                    nullptr /* engine */)) {
+    HMAC_CTX_cleanup(keyed_ctx.get());
+    return util::Status(util::error::INTERNAL, "HMAC initialization failed");
+  }
+  std::unique_ptr<HmacSha256MultiBuffer> multi_buffer;
+  if (hash_type == HashType::SHA256) {
+    multi_buffer = HmacSha256MultiBuffer::New(key.data(), key.size());
+  }
+  return {absl::WrapUnique(new HmacBoringSsl(tag_size, std::move(keyed_ctx),
+                                             std::move(multi_buffer)))};
 }
 
-util::StatusOr<std::string> HmacBoringSsl::ComputeMac(
-    absl::string_view data) const {
+HmacBoringSsl::~HmacBoringSsl() { HMAC_CTX_cleanup(keyed_ctx_.get()); }
+
+util::Status HmacBoringSsl::ComputeHmac(HMAC_CTX* ctx, absl::string_view data,
+                                        uint8_t* buf) const {
   // BoringSSL expects a non-null pointer for data,
   // regardless of whether the size is 0.
   data = SubtleUtilBoringSSL::EnsureNonNull(data);
 
-  uint8_t buf[EVP_MAX_MD_SIZE];
   unsigned int out_len;
-  const uint8_t* res = HMAC(md_, key_.data(), key_.size(),
-                            reinterpret_cast<const uint8_t*>(data.data()),
-                            data.size(), buf, &out_len);
-  if (res == nullptr) {
+  if (!HMAC_CTX_copy_ex(ctx, keyed_ctx_.get()) ||
+      !HMAC_Update(ctx, reinterpret_cast<const uint8_t*>(data.data()),
+                   data.size()) ||
+      !HMAC_Final(ctx, buf, &out_len)) {
     // TODO(bleichen): We expect that BoringSSL supports the
     //   hashes that we use. Maybe we should have a status that indicates
     //   such mismatches between expected and actual behaviour.
     return util::Status(util::error::INTERNAL,
                         "BoringSSL failed to compute HMAC");
   }
+  return util::Status::OK;
+}
+
+util::StatusOr<std::string> HmacBoringSsl::ComputeMac(
+    absl::string_view data) const {
+  uint8_t buf[EVP_MAX_MD_SIZE];
+  bssl::ScopedHMAC_CTX ctx;
+  auto status = ComputeHmac(ctx.get(), data, buf);
+  if (!status.ok()) return status;
   return std::string(reinterpret_cast<char*>(buf), tag_size_);
 }
 
+util::StatusOr<absl::Span<char>> HmacBoringSsl::ComputeMacToBuffer(
+    absl::string_view data, const util::OutputBufferFactory& new_buffer) const {
+  uint8_t buf[EVP_MAX_MD_SIZE];
+  bssl::ScopedHMAC_CTX ctx;
+  auto status = ComputeHmac(ctx.get(), data, buf);
+  if (!status.ok()) return status;
+  return util::internal::CopyToNewBuffer(
+      absl::string_view(reinterpret_cast<char*>(buf), tag_size_), new_buffer);
+}
+
+util::Status HmacBoringSsl::VerifyHmac(HMAC_CTX* ctx, absl::string_view mac,
+                                       absl::string_view data) const {
+  if (mac.size() != tag_size_) {
+    return util::Status(util::error::INVALID_ARGUMENT, "incorrect tag size");
+  }
+  uint8_t buf[EVP_MAX_MD_SIZE];
+  auto status = ComputeHmac(ctx, data, buf);
+  if (!status.ok()) return status;
+  return CompareTag(buf, mac);
+}
+
+util::Status HmacBoringSsl::CompareTag(const uint8_t* hmac,
+                                       absl::string_view mac) const {
+  if (CRYPTO_memcmp(hmac, mac.data(), tag_size_) != 0) {
+    static const util::Status* kVerificationFailed =
+        util::Status::NewStatic(util::error::INVALID_ARGUMENT,
+                                "verification failed");
+    return *kVerificationFailed;
+  }
+  return util::Status::OK;
+}
+
 util::Status HmacBoringSsl::VerifyMac(
     absl::string_view mac,
     absl::string_view data) const {
-  // BoringSSL expects a non-null pointer for data,
-  // regardless of whether the size is 0.
-  data = SubtleUtilBoringSSL::EnsureNonNull(data);
+  bssl::ScopedHMAC_CTX ctx;
+  return VerifyHmac(ctx.get(), mac, data);
+}
 
-  if (mac.size() != tag_size_) {
-    return util::Status(util::error::INVALID_ARGUMENT, "incorrect tag size");
+util::Status HmacBoringSsl::ComputeMacBatch(
+    absl::Span<const absl::string_view> data, std::string* macs,
+    std::vector<int64_t>* offsets) const {
+  offsets->resize(data.size() + 1);
+  for (size_t i = 0; i <= data.size(); i++) (*offsets)[i] = i * tag_size_;
+  ResizeStringUninitialized(macs, data.size() * tag_size_);
+  uint8_t* out = reinterpret_cast<uint8_t*>(&(*macs)[0]);
+  if (UseMultiBuffer(data.size())) {
+    multi_buffer_->Compute(data, tag_size_, out);
+    return util::Status::OK;
   }
   uint8_t buf[EVP_MAX_MD_SIZE];
-  unsigned int out_len;
-  const uint8_t* res = HMAC(md_, key_.data(), key_.size(),
-                            reinterpret_cast<const uint8_t*>(data.data()),
-                            data.size(), buf, &out_len);
-  if (res == nullptr) {
-    return util::Status(util::error::INTERNAL,
-                        "BoringSSL failed to compute HMAC");
+  bssl::ScopedHMAC_CTX ctx;
+  for (size_t i = 0; i < data.size(); i++) {
+    auto status = ComputeHmac(ctx.get(), data[i], buf);
+    if (!status.ok()) {
+      macs->clear();
+      offsets->assign(1, 0);
+      return status;
+    }
+    std::copy_n(buf, tag_size_, out + i * tag_size_);
+  }
+  return util::Status::OK;
+}
+
+util::Status HmacBoringSsl::VerifyMacBatch(
+    absl::Span<const absl::string_view> mac_values,
+    absl::Span<const absl::string_view> data, bool stop_at_first_failure,
+    std::vector<util::Status>* results) const {
+  if (mac_values.size() != data.size()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "mac_values and data must have the same size");
+  }
+  results->assign(data.size(),
+                  util::Status(util::error::ABORTED, "not verified"));
+  if (UseMultiBuffer(data.size())) {
+    // All items are verified, which stop_at_first_failure allows.
+    std::vector<uint8_t> hmacs(data.size() * tag_size_);
+    multi_buffer_->Compute(data, tag_size_, hmacs.data());
+    for (size_t i = 0; i < data.size(); i++) {
+      if (mac_values[i].size() != tag_size_) {
+        (*results)[i] =
+            util::Status(util::error::INVALID_ARGUMENT, "incorrect tag size");
+      } else {
+        (*results)[i] = CompareTag(&hmacs[i * tag_size_], mac_values[i]);
+      }
+    }
+    return util::Status::OK;
   }
-  if (CRYPTO_memcmp(buf, mac.data(), tag_size_) != 0) {
-    return util::Status(util::error::INVALID_ARGUMENT, "verification failed");
+  bssl::ScopedHMAC_CTX ctx;
+  for (size_t i = 0; i < data.size(); i++) {
+    (*results)[i] = VerifyHmac(ctx.get(), mac_values[i], data[i]);
+    if (stop_at_first_failure && !(*results)[i].ok()) break;
   }
   return util::Status::OK;
 }
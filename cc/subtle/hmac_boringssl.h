@@ -17,14 +17,22 @@
 #ifndef TINK_SUBTLE_HMAC_BORINGSSL_H_
 #define TINK_SUBTLE_HMAC_BORINGSSL_H_
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "openssl/base.h"
 #include "openssl/evp.h"
+#include "openssl/hmac.h"
 #include "tink/mac.h"
 #include "tink/config/tink_fips.h"
 #include "tink/subtle/common_enums.h"
+#include "tink/subtle/hmac_sha256_multi_buffer.h"
+#include "tink/util/output_buffer_factory.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
@@ -38,16 +46,37 @@ class HmacBoringSsl : public Mac {
   static crypto::tink::util::StatusOr<std::unique_ptr<Mac>> New(
       HashType hash_type, uint32_t tag_size, util::SecretData key);
 
+  ~HmacBoringSsl() override;
+
   // Computes and returns the HMAC for 'data'.
   crypto::tink::util::StatusOr<std::string> ComputeMac(
       absl::string_view data) const override;
 
+  // Computes the HMAC for 'data' on the stack and copies it to the buffer.
+  crypto::tink::util::StatusOr<absl::Span<char>> ComputeMacToBuffer(
+      absl::string_view data,
+      const crypto::tink::util::OutputBufferFactory& new_buffer)
+      const override;
+
   // Verifies if 'mac' is a correct HMAC for 'data'.
   // Returns Status::OK if 'mac' is correct, and a non-OK-Status otherwise.
   crypto::tink::util::Status VerifyMac(
       absl::string_view mac,
       absl::string_view data) const override;
 
+  // Computes all MACs with a single context, into which the keyed state is
+  // copied for each item, or with HmacSha256MultiBuffer for larger batches
+  // where it is available.
+  crypto::tink::util::Status ComputeMacBatch(
+      absl::Span<const absl::string_view> data, std::string* macs,
+      std::vector<int64_t>* offsets) const override;
+
+  // Verifies all items like ComputeMacBatch() computes them.
+  crypto::tink::util::Status VerifyMacBatch(
+      absl::Span<const absl::string_view> mac_values,
+      absl::Span<const absl::string_view> data, bool stop_at_first_failure,
+      std::vector<crypto::tink::util::Status>* results) const override;
+
   static constexpr crypto::tink::FipsCompatibility kFipsStatus =
       crypto::tink::FipsCompatibility::kRequiresBoringCrypto;
 
@@ -55,13 +84,39 @@ class HmacBoringSsl : public Mac {
   // Minimum HMAC key size in bytes.
   static constexpr size_t kMinKeySize = 16;
 
-  HmacBoringSsl(const EVP_MD* md, uint32_t tag_size, util::SecretData key)
-      : md_(md), tag_size_(tag_size), key_(std::move(key)) {}
+  HmacBoringSsl(uint32_t tag_size, util::SecretUniquePtr<HMAC_CTX> keyed_ctx,
+                std::unique_ptr<HmacSha256MultiBuffer> multi_buffer)
+      : tag_size_(tag_size),
+        keyed_ctx_(std::move(keyed_ctx)),
+        multi_buffer_(std::move(multi_buffer)) {}
+
+  // Returns true if a batch of 'size' messages is computed with
+  // multi_buffer_.
+  bool UseMultiBuffer(size_t size) const {
+    return multi_buffer_ != nullptr && 2 * size >= multi_buffer_->lanes();
+  }
+
+  // Computes the untruncated HMAC of 'data' into 'buf', which must hold
+  // EVP_MAX_MD_SIZE bytes, using 'ctx' as scratch space.
+  crypto::tink::util::Status ComputeHmac(HMAC_CTX* ctx, absl::string_view data,
+                                         uint8_t* buf) const;
+
+  // Checks 'mac' against the HMAC of 'data', using 'ctx' as scratch space.
+  crypto::tink::util::Status VerifyHmac(HMAC_CTX* ctx, absl::string_view mac,
+                                        absl::string_view data) const;
+
+  // Checks 'mac' against the first tag_size_ bytes of 'hmac'.
+  crypto::tink::util::Status CompareTag(const uint8_t* hmac,
+                                        absl::string_view mac) const;
 
-  // HmacBoringSsl is not owner of md (it is owned by BoringSSL).
-  const EVP_MD* const md_;
   const uint32_t tag_size_;
-  const util::SecretData key_;
+  // Holds the inner and outer hash states after absorbing the padded key.
+  // Never updated after construction; every call works on a copy, so the
+  // key schedule is computed only once. Placed with other key state.
+  const util::SecretUniquePtr<HMAC_CTX> keyed_ctx_;
+  // Null unless the hash is SHA-256 and a multi-buffer implementation is
+  // available.
+  const std::unique_ptr<HmacSha256MultiBuffer> multi_buffer_;
 };
 
 }  // namespace subtle
@@ -17,6 +17,8 @@
 #include "tink/subtle/hmac_boringssl.h"
 
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "tink/mac.h"
@@ -138,6 +140,115 @@ TEST_F(HmacBoringSslTest, testTruncation) {
   }
 }
 
+TEST_F(HmacBoringSslTest, testConcurrentCalls) {
+  if (kUseOnlyFips && !FIPS_mode()) {
+    GTEST_SKIP()
+        << "Test should not run in FIPS mode when BoringCrypto is unavailable.";
+  }
+  // All calls share the keyed HMAC state computed in New(), so interleaved
+  // calls from several threads must not affect each other.
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  auto hmac_result = HmacBoringSsl::New(HashType::SHA1, 16, key);
+  ASSERT_TRUE(hmac_result.ok()) << hmac_result.status();
+  const Mac& hmac = *hmac_result.ValueOrDie();
+  std::string expected_tag =
+      test::HexDecodeOrDie("9ccdca5b7fffb690df396e4ac49b9cd4");
+  std::string expected_empty_tag =
+      test::HexDecodeOrDie("5433122f77bcf8a4d9b874b4149823ef");
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&]() {
+      for (int j = 0; j < 1000; j++) {
+        auto res = hmac.ComputeMac(j % 2 ? "Some data to test." : "");
+        ASSERT_TRUE(res.ok()) << res.status();
+        EXPECT_EQ(res.ValueOrDie(), j % 2 ? expected_tag : expected_empty_tag);
+        EXPECT_TRUE(hmac.VerifyMac(expected_tag, "Some data to test.").ok());
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+}
+
+TEST_F(HmacBoringSslTest, testVerifyMacBatch) {
+  if (kUseOnlyFips && !FIPS_mode()) {
+    GTEST_SKIP()
+        << "Test should not run in FIPS mode when BoringCrypto is unavailable.";
+  }
+  util::SecretData key = util::SecretDataFromStringView(test::HexDecodeOrDie(
+      "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"));
+  auto mac_result = HmacBoringSsl::New(HashType::SHA256, 16, key);
+  ASSERT_TRUE(mac_result.ok()) << mac_result.status();
+  auto mac = std::move(mac_result.ValueOrDie());
+  std::vector<std::string> data = {"first", "", "third", "fourth"};
+  std::vector<std::string> tags;
+  for (const std::string& message : data) {
+    tags.push_back(mac->ComputeMac(message).ValueOrDie());
+  }
+  tags[2][0] ^= 1;
+  tags[3].pop_back();
+  std::vector<absl::string_view> tag_views(tags.begin(), tags.end());
+  std::vector<absl::string_view> data_views(data.begin(), data.end());
+  std::vector<util::Status> results;
+  ASSERT_TRUE(mac->VerifyMacBatch(tag_views, data_views,
+                                  /*stop_at_first_failure=*/false, &results)
+                  .ok());
+  ASSERT_EQ(results.size(), data.size());
+  EXPECT_TRUE(results[0].ok()) << results[0];
+  EXPECT_TRUE(results[1].ok()) << results[1];
+  EXPECT_THAT(results[2], StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(results[3], StatusIs(util::error::INVALID_ARGUMENT));
+
+  EXPECT_THAT(mac->VerifyMacBatch(tag_views, {}, false, &results),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+// Batches of several sizes, so that both the one-by-one and the multi-buffer
+// computation are covered where the latter is available.
+TEST_F(HmacBoringSslTest, testComputeAndVerifyMacBatch) {
+  if (kUseOnlyFips && !FIPS_mode()) {
+    GTEST_SKIP()
+        << "Test should not run in FIPS mode when BoringCrypto is unavailable.";
+  }
+  util::SecretData key = util::SecretDataFromStringView(test::HexDecodeOrDie(
+      "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"));
+  for (HashType hash : {HashType::SHA256, HashType::SHA512}) {
+    auto mac_result = HmacBoringSsl::New(hash, 16, key);
+    ASSERT_TRUE(mac_result.ok()) << mac_result.status();
+    auto mac = std::move(mac_result.ValueOrDie());
+    for (size_t batch_size : {0, 1, 3, 40}) {
+      std::vector<std::string> data;
+      for (size_t i = 0; i < batch_size; i++) {
+        data.push_back(std::string(i * 13, 'a' + i % 26));
+      }
+      std::vector<absl::string_view> data_views(data.begin(), data.end());
+      std::string macs;
+      std::vector<int64_t> offsets;
+      ASSERT_TRUE(mac->ComputeMacBatch(data_views, &macs, &offsets).ok());
+      ASSERT_EQ(offsets.size(), batch_size + 1);
+      std::vector<absl::string_view> tag_views;
+      for (size_t i = 0; i < batch_size; i++) {
+        tag_views.push_back(absl::string_view(macs).substr(
+            offsets[i], offsets[i + 1] - offsets[i]));
+        EXPECT_EQ(tag_views[i], mac->ComputeMac(data[i]).ValueOrDie());
+      }
+
+      std::vector<std::string> tags(tag_views.begin(), tag_views.end());
+      if (batch_size > 1) tags[1][0] ^= 1;
+      tag_views.assign(tags.begin(), tags.end());
+      std::vector<util::Status> results;
+      ASSERT_TRUE(mac->VerifyMacBatch(tag_views, data_views,
+                                      /*stop_at_first_failure=*/false,
+                                      &results)
+                      .ok());
+      for (size_t i = 0; i < batch_size; i++) {
+        EXPECT_EQ(results[i].ok(), i != 1) << results[i];
+      }
+    }
+  }
+}
+
 TEST_F(HmacBoringSslTest, testInvalidKeySizes) {
   if (kUseOnlyFips && !FIPS_mode()) {
     GTEST_SKIP()
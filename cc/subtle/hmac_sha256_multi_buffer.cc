@@ -0,0 +1,373 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/hmac_sha256_multi_buffer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "openssl/mem.h"
+#include "openssl/sha.h"
+#include "tink/subtle/cpu_features.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+namespace {
+
+constexpr size_t kBlockSize = SHA256_CBLOCK;
+constexpr size_t kDigestSize = SHA256_DIGEST_LENGTH;
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+
+constexpr uint32_t kRoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+uint32_t LoadBigEndian32(const uint8_t* in) {
+  return (uint32_t{in[0]} << 24) | (uint32_t{in[1]} << 16) |
+         (uint32_t{in[2]} << 8) | uint32_t{in[3]};
+}
+
+void StoreBigEndian32(uint32_t value, uint8_t* out) {
+  out[0] = value >> 24;
+  out[1] = value >> 16;
+  out[2] = value >> 8;
+  out[3] = value;
+}
+
+// The vector operations of the SHA-256 rounds, for the lanes of one register
+// type. Lane j of word i of 'L' lanes is at index i * L + j of the arrays.
+#if defined(__AVX2__)
+struct Avx2Ops {
+  using V = __m256i;
+  static constexpr int kLanes = 8;
+
+  static V Load(const uint32_t* in) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+  }
+  static void Store(V v, uint32_t* out) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), v);
+  }
+  static V Set1(uint32_t x) { return _mm256_set1_epi32(x); }
+  static V Add(V a, V b) { return _mm256_add_epi32(a, b); }
+  static V And(V a, V b) { return _mm256_and_si256(a, b); }
+  // ~a & b.
+  static V AndNot(V a, V b) { return _mm256_andnot_si256(a, b); }
+  static V Or(V a, V b) { return _mm256_or_si256(a, b); }
+  static V Xor(V a, V b) { return _mm256_xor_si256(a, b); }
+  template <int n>
+  static V Shr(V a) {
+    return _mm256_srli_epi32(a, n);
+  }
+  template <int n>
+  static V Rotr(V a) {
+    return Or(_mm256_srli_epi32(a, n), _mm256_slli_epi32(a, 32 - n));
+  }
+};
+#endif  // __AVX2__
+
+#if defined(__AVX512F__)
+struct Avx512Ops {
+  using V = __m512i;
+  static constexpr int kLanes = 16;
+
+  static V Load(const uint32_t* in) { return _mm512_loadu_si512(in); }
+  static void Store(V v, uint32_t* out) { _mm512_storeu_si512(out, v); }
+  static V Set1(uint32_t x) { return _mm512_set1_epi32(x); }
+  static V Add(V a, V b) { return _mm512_add_epi32(a, b); }
+  static V And(V a, V b) { return _mm512_and_si512(a, b); }
+  // ~a & b.
+  static V AndNot(V a, V b) { return _mm512_andnot_si512(a, b); }
+  static V Or(V a, V b) { return _mm512_or_si512(a, b); }
+  static V Xor(V a, V b) { return _mm512_xor_si512(a, b); }
+  template <int n>
+  static V Shr(V a) {
+    return _mm512_srli_epi32(a, n);
+  }
+  template <int n>
+  static V Rotr(V a) {
+    return _mm512_ror_epi32(a, n);
+  }
+};
+#endif  // __AVX512F__
+
+// Runs the SHA-256 compression function of FIPS 180-4, Section 6.2.2, on the
+// 8 state words in 'state' with the 16 message words in 'words', in all
+// lanes.
+template <class Ops>
+void Compress(uint32_t* state, const uint32_t* words) {
+  using V = typename Ops::V;
+  constexpr int L = Ops::kLanes;
+  V a = Ops::Load(state), b = Ops::Load(state + L),
+    c = Ops::Load(state + 2 * L), d = Ops::Load(state + 3 * L),
+    e = Ops::Load(state + 4 * L), f = Ops::Load(state + 5 * L),
+    g = Ops::Load(state + 6 * L), h = Ops::Load(state + 7 * L);
+  // The last 16 words of the message schedule.
+  V w[16];
+  for (int t = 0; t < 16; t++) w[t] = Ops::Load(words + t * L);
+  for (int t = 0; t < 64; t++) {
+    if (t >= 16) {
+      const V w15 = w[(t - 15) & 15];
+      const V w2 = w[(t - 2) & 15];
+      const V s0 = Ops::Xor(Ops::Xor(Ops::template Rotr<7>(w15),
+                                     Ops::template Rotr<18>(w15)),
+                            Ops::template Shr<3>(w15));
+      const V s1 = Ops::Xor(Ops::Xor(Ops::template Rotr<17>(w2),
+                                     Ops::template Rotr<19>(w2)),
+                            Ops::template Shr<10>(w2));
+      w[t & 15] =
+          Ops::Add(Ops::Add(w[t & 15], s0), Ops::Add(w[(t - 7) & 15], s1));
+    }
+    const V sigma1 = Ops::Xor(
+        Ops::Xor(Ops::template Rotr<6>(e), Ops::template Rotr<11>(e)),
+        Ops::template Rotr<25>(e));
+    const V ch = Ops::Xor(Ops::And(e, f), Ops::AndNot(e, g));
+    const V t1 =
+        Ops::Add(Ops::Add(h, sigma1),
+                 Ops::Add(Ops::Add(ch, Ops::Set1(kRoundConstants[t])),
+                          w[t & 15]));
+    const V sigma0 = Ops::Xor(
+        Ops::Xor(Ops::template Rotr<2>(a), Ops::template Rotr<13>(a)),
+        Ops::template Rotr<22>(a));
+    const V maj = Ops::Or(Ops::And(a, b), Ops::And(c, Ops::Or(a, b)));
+    h = g;
+    g = f;
+    f = e;
+    e = Ops::Add(d, t1);
+    d = c;
+    c = b;
+    b = a;
+    a = Ops::Add(t1, Ops::Add(sigma0, maj));
+  }
+  Ops::Store(Ops::Add(a, Ops::Load(state)), state);
+  Ops::Store(Ops::Add(b, Ops::Load(state + L)), state + L);
+  Ops::Store(Ops::Add(c, Ops::Load(state + 2 * L)), state + 2 * L);
+  Ops::Store(Ops::Add(d, Ops::Load(state + 3 * L)), state + 3 * L);
+  Ops::Store(Ops::Add(e, Ops::Load(state + 4 * L)), state + 4 * L);
+  Ops::Store(Ops::Add(f, Ops::Load(state + 5 * L)), state + 5 * L);
+  Ops::Store(Ops::Add(g, Ops::Load(state + 6 * L)), state + 6 * L);
+  Ops::Store(Ops::Add(h, Ops::Load(state + 7 * L)), state + 7 * L);
+}
+
+// The message a lane is working on.
+struct Lane {
+  // Index into the batch, or -1 if the lane is idle.
+  int64_t message;
+  // The blocks of the message that need no padding.
+  const uint8_t* full_blocks;
+  size_t num_full_blocks;
+  // The padded end of the inner message, or the padded inner digest for the
+  // outer hash.
+  uint8_t tail[2 * kBlockSize];
+  size_t num_blocks;
+  // The block to compress next.
+  size_t block;
+  bool outer;
+};
+
+// Writes the SHA-256 padding of a message of 'total_size' bytes, whose last
+// 'size' bytes are at the start of 'tail', and returns the number of padded
+// blocks in 'tail'.
+size_t PadTail(size_t size, uint64_t total_size, uint8_t* tail) {
+  const size_t padded_size = size + 9 <= kBlockSize ? kBlockSize
+                                                    : 2 * kBlockSize;
+  tail[size] = 0x80;
+  std::fill(tail + size + 1, tail + padded_size - 8, 0);
+  const uint64_t bits = total_size * 8;
+  StoreBigEndian32(bits >> 32, tail + padded_size - 8);
+  StoreBigEndian32(bits, tail + padded_size - 4);
+  return padded_size / kBlockSize;
+}
+
+template <class Ops>
+void ComputeHmacs(const uint32_t* inner_state, const uint32_t* outer_state,
+                  absl::Span<const absl::string_view> data, size_t tag_size,
+                  uint8_t* out) {
+  constexpr int L = Ops::kLanes;
+  uint32_t state[8 * L];
+  uint32_t words[16 * L];
+  Lane lanes[L];
+  static const uint8_t kIdleBlock[kBlockSize] = {0};
+  size_t next_message = 0;
+  int active_lanes = 0;
+
+  // Starts the inner hash of the next message in lane 'j', if any.
+  auto start_message = [&](int j) {
+    Lane& lane = lanes[j];
+    if (next_message == data.size()) {
+      lane.message = -1;
+      return;
+    }
+    lane.message = next_message++;
+    absl::string_view message = data[lane.message];
+    const size_t tail_size = message.size() % kBlockSize;
+    lane.full_blocks = reinterpret_cast<const uint8_t*>(message.data());
+    lane.num_full_blocks = message.size() / kBlockSize;
+    if (tail_size > 0) {
+      std::memcpy(lane.tail,
+                  message.data() + lane.num_full_blocks * kBlockSize,
+                  tail_size);
+    }
+    lane.num_blocks = lane.num_full_blocks +
+                      PadTail(tail_size, kBlockSize + message.size(),
+                              lane.tail);
+    lane.block = 0;
+    lane.outer = false;
+    for (int i = 0; i < 8; i++) state[i * L + j] = inner_state[i];
+    active_lanes++;
+  };
+
+  for (int j = 0; j < L; j++) start_message(j);
+  while (active_lanes > 0) {
+    for (int j = 0; j < L; j++) {
+      const Lane& lane = lanes[j];
+      const uint8_t* block = kIdleBlock;
+      if (lane.message >= 0) {
+        block = lane.block < lane.num_full_blocks
+                    ? lane.full_blocks + lane.block * kBlockSize
+                    : lane.tail +
+                          (lane.block - lane.num_full_blocks) * kBlockSize;
+      }
+      for (int t = 0; t < 16; t++) {
+        words[t * L + j] = LoadBigEndian32(block + 4 * t);
+      }
+    }
+    Compress<Ops>(state, words);
+    for (int j = 0; j < L; j++) {
+      Lane& lane = lanes[j];
+      if (lane.message < 0 || ++lane.block < lane.num_blocks) continue;
+      if (!lane.outer) {
+        // The outer hash is over the inner digest.
+        for (int i = 0; i < 8; i++) {
+          StoreBigEndian32(state[i * L + j], lane.tail + 4 * i);
+          state[i * L + j] = outer_state[i];
+        }
+        lane.full_blocks = nullptr;
+        lane.num_full_blocks = 0;
+        lane.num_blocks =
+            PadTail(kDigestSize, kBlockSize + kDigestSize, lane.tail);
+        lane.block = 0;
+        lane.outer = true;
+        continue;
+      }
+      uint8_t digest[kDigestSize];
+      for (int i = 0; i < 8; i++) {
+        StoreBigEndian32(state[i * L + j], digest + 4 * i);
+      }
+      std::copy_n(digest, tag_size, out + lane.message * tag_size);
+      active_lanes--;
+      start_message(j);
+    }
+  }
+  OPENSSL_cleanse(state, sizeof(state));
+  OPENSSL_cleanse(words, sizeof(words));
+  OPENSSL_cleanse(lanes, sizeof(lanes));
+}
+
+#endif  // defined(__AVX2__) || defined(__AVX512F__)
+
+}  // namespace
+
+std::unique_ptr<HmacSha256MultiBuffer> HmacSha256MultiBuffer::New(
+    const uint8_t* key, size_t key_size) {
+  std::unique_ptr<HmacSha256MultiBuffer> hmac;
+#if defined(__AVX512F__)
+  if (hmac == nullptr && HasCpuFeature(CpuFeature::kAvx512F)) {
+    hmac = absl::WrapUnique(new HmacSha256MultiBuffer(
+        &ComputeHmacs<Avx512Ops>, Avx512Ops::kLanes));
+  }
+#endif
+#if defined(__AVX2__)
+  if (hmac == nullptr && HasCpuFeature(CpuFeature::kAvx2) &&
+      !HasCpuFeature(CpuFeature::kShaNi)) {
+    hmac = absl::WrapUnique(
+        new HmacSha256MultiBuffer(&ComputeHmacs<Avx2Ops>, Avx2Ops::kLanes));
+  }
+#endif
+  if (hmac == nullptr) return nullptr;
+
+  // RFC 2104: keys longer than a block are hashed first, and shorter ones
+  // are padded with zeros.
+  uint8_t block_key[kBlockSize] = {0};
+  if (key_size > kBlockSize) {
+    SHA256(key, key_size, block_key);
+  } else if (key_size > 0) {
+    std::memcpy(block_key, key, key_size);
+  }
+  uint8_t pad[kBlockSize];
+  SHA256_CTX ctx;
+  for (uint8_t i = 0; i < kBlockSize; i++) pad[i] = block_key[i] ^ 0x36;
+  SHA256_Init(&ctx);
+  SHA256_Update(&ctx, pad, kBlockSize);
+  std::copy_n(ctx.h, 8, hmac->inner_state_);
+  for (uint8_t i = 0; i < kBlockSize; i++) pad[i] = block_key[i] ^ 0x5c;
+  SHA256_Init(&ctx);
+  SHA256_Update(&ctx, pad, kBlockSize);
+  std::copy_n(ctx.h, 8, hmac->outer_state_);
+  OPENSSL_cleanse(block_key, sizeof(block_key));
+  OPENSSL_cleanse(pad, sizeof(pad));
+  OPENSSL_cleanse(&ctx, sizeof(ctx));
+  return hmac;
+}
+
+absl::string_view HmacSha256MultiBuffer::Implementation() {
+#if defined(__AVX512F__)
+  if (HasCpuFeature(CpuFeature::kAvx512F)) return "AVX-512F";
+#endif
+#if defined(__AVX2__)
+  if (HasCpuFeature(CpuFeature::kAvx2) && !HasCpuFeature(CpuFeature::kShaNi)) {
+    return "AVX2";
+  }
+#endif
+  return "";
+}
+
+HmacSha256MultiBuffer::~HmacSha256MultiBuffer() {
+  OPENSSL_cleanse(inner_state_, sizeof(inner_state_));
+  OPENSSL_cleanse(outer_state_, sizeof(outer_state_));
+}
+
+void HmacSha256MultiBuffer::Compute(absl::Span<const absl::string_view> data,
+                                    size_t tag_size, uint8_t* out) const {
+  kernel_(inner_state_, outer_state_, data, std::min(tag_size, kDigestSize),
+          out);
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,88 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_SUBTLE_HMAC_SHA256_MULTI_BUFFER_H_
+#define TINK_SUBTLE_HMAC_SHA256_MULTI_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// HMAC-SHA256 of many messages at once, which computes the SHA-256 blocks of
+// 8 (AVX2) or 16 (AVX-512F) messages in the lanes of vector registers. Each
+// lane moves on to the next message as soon as its message is done, so
+// messages of different lengths keep all lanes busy.
+//
+// The implementations are only compiled in when the target supports their
+// instructions, e.g. with --copt=-mavx2 or --copt=-mavx512f, and used when
+// the CPU supports them at run time (see cpu_features.h). The AVX2 version
+// is not used on CPUs with the SHA extensions, whose single-message SHA-256
+// in BoringSSL is faster.
+//
+// This class is thread-safe.
+class HmacSha256MultiBuffer {
+ public:
+  // Returns an instance keyed with 'key', or nullptr if no implementation is
+  // available; callers then compute the HMACs one by one.
+  static std::unique_ptr<HmacSha256MultiBuffer> New(const uint8_t* key,
+                                                    size_t key_size);
+
+  // Returns the name of the implementation New() uses, e.g. "AVX2", or an
+  // empty string if there is none.
+  static absl::string_view Implementation();
+
+  HmacSha256MultiBuffer(const HmacSha256MultiBuffer&) = delete;
+  HmacSha256MultiBuffer& operator=(const HmacSha256MultiBuffer&) = delete;
+  ~HmacSha256MultiBuffer();
+
+  // The number of messages computed at once. Batches of fewer than
+  // lanes() / 2 messages are usually faster one by one.
+  int lanes() const { return lanes_; }
+
+  // Computes the HMAC of each of 'data', and writes their first 'tag_size'
+  // bytes, which must be at most 32, back to back into 'out'.
+  void Compute(absl::Span<const absl::string_view> data, size_t tag_size,
+               uint8_t* out) const;
+
+ private:
+  using Kernel = void (*)(const uint32_t* inner_state,
+                          const uint32_t* outer_state,
+                          absl::Span<const absl::string_view> data,
+                          size_t tag_size, uint8_t* out);
+
+  HmacSha256MultiBuffer(Kernel kernel, int lanes)
+      : kernel_(kernel), lanes_(lanes) {}
+
+  const Kernel kernel_;
+  const int lanes_;
+  // The SHA-256 states after absorbing the key XORed with ipad and opad.
+  uint32_t inner_state_[8];
+  uint32_t outer_state_[8];
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_HMAC_SHA256_MULTI_BUFFER_H_
@@ -0,0 +1,131 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/hmac_sha256_multi_buffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/strings/string_view.h"
+#include "openssl/digest.h"
+#include "openssl/hmac.h"
+#include "tink/subtle/cpu_features.h"
+#include "tink/subtle/random.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+std::string ReferenceHmac(absl::string_view key, absl::string_view data) {
+  uint8_t mac[EVP_MAX_MD_SIZE];
+  unsigned int mac_size;
+  HMAC(EVP_sha256(), key.data(), key.size(),
+       reinterpret_cast<const uint8_t*>(data.data()), data.size(), mac,
+       &mac_size);
+  return std::string(reinterpret_cast<const char*>(mac), mac_size);
+}
+
+// Checks the HMACs of messages of all lengths up to a few blocks, in
+// batches of several sizes, against BoringSSL.
+void CheckAgainstReference(const HmacSha256MultiBuffer& hmac,
+                           absl::string_view key, size_t tag_size) {
+  std::vector<std::string> messages;
+  for (int size = 0; size <= 300; size++) {
+    messages.push_back(Random::GetRandomBytes(size));
+  }
+  messages.push_back(Random::GetRandomBytes(5000));
+  for (size_t batch_size : {size_t{1}, size_t{7}, messages.size()}) {
+    std::vector<absl::string_view> batch(messages.begin(),
+                                         messages.begin() + batch_size);
+    std::vector<uint8_t> out(batch_size * tag_size);
+    hmac.Compute(batch, tag_size, out.data());
+    for (size_t i = 0; i < batch_size; i++) {
+      EXPECT_EQ(ReferenceHmac(key, batch[i]).substr(0, tag_size),
+                std::string(out.begin() + i * tag_size,
+                            out.begin() + (i + 1) * tag_size))
+          << "message size " << batch[i].size();
+    }
+  }
+}
+
+class HmacSha256MultiBufferTest : public ::testing::Test {
+ protected:
+  // The AVX2 implementation is not used on CPUs with SHA extensions unless
+  // they are disabled.
+  void SetUp() override {
+    SetCpuFeatureDisabled(CpuFeature::kShaNi, true);
+    if (HmacSha256MultiBuffer::Implementation().empty()) {
+      GTEST_SKIP() << "No multi-buffer implementation available";
+    }
+  }
+
+  void TearDown() override {
+    SetCpuFeatureDisabled(CpuFeature::kShaNi, false);
+  }
+};
+
+TEST_F(HmacSha256MultiBufferTest, MatchesReference) {
+  for (size_t key_size : {0, 16, 32, 64, 65, 200}) {
+    std::string key = Random::GetRandomBytes(key_size);
+    auto hmac = HmacSha256MultiBuffer::New(
+        reinterpret_cast<const uint8_t*>(key.data()), key.size());
+    ASSERT_NE(hmac, nullptr);
+    CheckAgainstReference(*hmac, key, 32);
+    CheckAgainstReference(*hmac, key, 16);
+  }
+}
+
+TEST_F(HmacSha256MultiBufferTest, EmptyBatch) {
+  std::string key = Random::GetRandomBytes(32);
+  auto hmac = HmacSha256MultiBuffer::New(
+      reinterpret_cast<const uint8_t*>(key.data()), key.size());
+  ASSERT_NE(hmac, nullptr);
+  hmac->Compute({}, 32, nullptr);
+}
+
+TEST_F(HmacSha256MultiBufferTest, EachImplementation) {
+  std::string key = Random::GetRandomBytes(32);
+  for (bool avx512 : {true, false}) {
+    SetCpuFeatureDisabled(CpuFeature::kAvx512F, !avx512);
+    auto hmac = HmacSha256MultiBuffer::New(
+        reinterpret_cast<const uint8_t*>(key.data()), key.size());
+    if (hmac != nullptr) {
+      EXPECT_EQ(HmacSha256MultiBuffer::Implementation(),
+                hmac->lanes() == 16 ? "AVX-512F" : "AVX2");
+      CheckAgainstReference(*hmac, key, 32);
+    }
+  }
+  SetCpuFeatureDisabled(CpuFeature::kAvx512F, false);
+}
+
+TEST(HmacSha256MultiBufferWithoutCpuFeaturesTest, NotAvailable) {
+  SetCpuFeatureDisabled(CpuFeature::kAvx512F, true);
+  SetCpuFeatureDisabled(CpuFeature::kAvx2, true);
+  EXPECT_EQ(HmacSha256MultiBuffer::Implementation(), "");
+  EXPECT_EQ(HmacSha256MultiBuffer::New(nullptr, 0), nullptr);
+  SetCpuFeatureDisabled(CpuFeature::kAvx512F, false);
+  SetCpuFeatureDisabled(CpuFeature::kAvx2, false);
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -42,6 +42,15 @@ class StatefulMac {
 
   virtual util::Status Update(absl::string_view data) = 0;
   virtual util::StatusOr<std::string> Finalize() = 0;
+
+  // Discards all data passed to Update() and returns this MAC to the state it
+  // was in after creation, so that it can compute another MAC with the same
+  // key without being keyed again. Also valid after Finalize(). Returns
+  // UNIMPLEMENTED if the implementation cannot be reused.
+  virtual util::Status Reset() {
+    return util::Status(util::error::UNIMPLEMENTED,
+                        "This StatefulMac cannot be reset.");
+  }
 };
 
 class StatefulMacFactory {
@@ -16,22 +16,149 @@
 
 #include "tink/subtle/nonce_based_streaming_aead.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "tink/input_stream.h"
 #include "tink/output_stream.h"
 #include "tink/random_access_stream.h"
 #include "tink/streaming_aead.h"
 #include "tink/subtle/decrypting_random_access_stream.h"
+#include "tink/subtle/parallel_streaming_aead_encrypting_stream.h"
 #include "tink/subtle/stream_segment_decrypter.h"
 #include "tink/subtle/stream_segment_encrypter.h"
 #include "tink/subtle/streaming_aead_decrypting_stream.h"
 #include "tink/subtle/streaming_aead_encrypting_stream.h"
+#include "tink/util/buffer.h"
+#include "tink/util/executor.h"
+#include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
 namespace crypto {
 namespace tink {
 namespace subtle {
 
+namespace {
+
+// A ciphertext segment within the range read by DecryptRange(), and the
+// space for its plaintext in the result.
+struct RangeSegment {
+  int64_t segment_nr;
+  absl::Span<const uint8_t> ciphertext;
+  absl::Span<uint8_t> plaintext;
+};
+
+// Reads exactly 'count' bytes starting at 'position' of 'source' to 'dest'.
+util::Status ReadFully(RandomAccessStream* source, int64_t position,
+                       int count, uint8_t* dest) {
+  int read_count = 0;
+  while (read_count < count) {
+    auto buffer_result = util::Buffer::NewNonOwning(
+        reinterpret_cast<char*>(dest) + read_count, count - read_count);
+    if (!buffer_result.ok()) return buffer_result.status();
+    auto buffer = std::move(buffer_result.ValueOrDie());
+    auto status = source->PRead(position + read_count, count - read_count,
+                                buffer.get());
+    read_count += buffer->size();
+    if (status.error_code() == util::error::OUT_OF_RANGE) {
+      if (read_count < count) {
+        return util::Status(util::error::INVALID_ARGUMENT,
+                            "ciphertext stream is too short");
+      }
+    } else if (!status.ok()) {
+      return status;
+    }
+  }
+  return util::OkStatus();
+}
+
+util::Status DecryptRangeSegment(StreamSegmentDecrypter* segment_decrypter,
+                                 const RangeSegment& segment,
+                                 bool is_last_segment) {
+  auto dec_result = segment_decrypter->DecryptSegmentInto(
+      segment.ciphertext, segment.segment_nr, is_last_segment,
+      segment.plaintext);
+  if (dec_result.ok()) {
+    if (dec_result.ValueOrDie() != segment.plaintext.size()) {
+      return util::Status(util::error::INTERNAL,
+                          "unexpected size of decrypted segment");
+    }
+    return util::OkStatus();
+  }
+  if (dec_result.status().error_code() != util::error::UNIMPLEMENTED) {
+    return dec_result.status();
+  }
+  std::vector<uint8_t> pt_segment;
+  auto status = segment_decrypter->DecryptSegment(
+      std::vector<uint8_t>(segment.ciphertext.begin(),
+                           segment.ciphertext.end()),
+      segment.segment_nr, is_last_segment, &pt_segment);
+  if (!status.ok()) return status;
+  if (pt_segment.size() != segment.plaintext.size()) {
+    return util::Status(util::error::INTERNAL,
+                        "unexpected size of decrypted segment");
+  }
+  std::copy(pt_segment.begin(), pt_segment.end(), segment.plaintext.begin());
+  return util::OkStatus();
+}
+
+// The position and size of the last segment of a ciphertext stream.
+struct LastSegment {
+  int64_t segment_nr;
+  int64_t ct_position;
+  int ct_size;
+  int64_t pt_position;
+};
+
+// Computes the last segment of a ciphertext stream of 'ct_size' bytes, as
+// DecryptingRandomAccessStream does.
+util::StatusOr<LastSegment> GetLastSegment(
+    const StreamSegmentDecrypter& segment_decrypter, int64_t ct_size) {
+  const int header_size = segment_decrypter.get_header_size();
+  const int ct_offset = segment_decrypter.get_ciphertext_offset();
+  const int ct_segment_size = segment_decrypter.get_ciphertext_segment_size();
+  const int ct_segment_overhead =
+      ct_segment_size - segment_decrypter.get_plaintext_segment_size();
+  int64_t segment_count = ct_size / ct_segment_size;
+  if (ct_size % ct_segment_size > 0) segment_count++;
+  // Tink supports up to 2^32 segments.
+  if (segment_count - 1 > std::numeric_limits<uint32_t>::max()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        absl::StrCat("too many segments: ", segment_count));
+  }
+  const int64_t overhead =
+      ct_segment_overhead * segment_count + ct_offset + header_size;
+  if (overhead > ct_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext stream is too short");
+  }
+  LastSegment last_segment;
+  last_segment.segment_nr = segment_count - 1;
+  last_segment.ct_position = last_segment.segment_nr == 0
+                                 ? ct_offset + header_size
+                                 : last_segment.segment_nr * ct_segment_size;
+  last_segment.ct_size = ct_size - last_segment.ct_position;
+  if (last_segment.ct_size < ct_segment_overhead) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "last segment is too short");
+  }
+  last_segment.pt_position = last_segment.ct_position - ct_offset -
+                             header_size -
+                             last_segment.segment_nr * ct_segment_overhead;
+  return last_segment;
+}
+
+}  // namespace
+
 crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::OutputStream>>
     NonceBasedStreamingAead::NewEncryptingStream(
         std::unique_ptr<crypto::tink::OutputStream> ciphertext_destination,
@@ -43,6 +170,98 @@ crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::OutputStream>>
       std::move(ciphertext_destination));
 }
 
+crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::OutputStream>>
+    NonceBasedStreamingAead::NewParallelEncryptingStream(
+        std::unique_ptr<crypto::tink::OutputStream> ciphertext_destination,
+        absl::string_view associated_data, int num_threads) {
+  auto segment_encrypter_result = NewSegmentEncrypter(associated_data);
+  if (!segment_encrypter_result.ok()) return segment_encrypter_result.status();
+  return ParallelStreamingAeadEncryptingStream::New(
+      std::move(segment_encrypter_result.ValueOrDie()),
+      std::move(ciphertext_destination), num_threads);
+}
+
+crypto::tink::util::StatusOr<int64_t>
+    NonceBasedStreamingAead::GetAppendPosition(
+        crypto::tink::RandomAccessStream* ciphertext_source) {
+  if (ciphertext_source == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_source must be non-null");
+  }
+  // The layout of the stream does not depend on the associated data.
+  auto segment_decrypter_result = NewSegmentDecrypter("");
+  if (!segment_decrypter_result.ok()) return segment_decrypter_result.status();
+  auto ct_size_result = ciphertext_source->size();
+  if (!ct_size_result.ok()) return ct_size_result.status();
+  auto last_segment_result = GetLastSegment(
+      *segment_decrypter_result.ValueOrDie(), ct_size_result.ValueOrDie());
+  if (!last_segment_result.ok()) return last_segment_result.status();
+  return last_segment_result.ValueOrDie().ct_position;
+}
+
+crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::OutputStream>>
+    NonceBasedStreamingAead::NewAppendingStream(
+        crypto::tink::RandomAccessStream* ciphertext_source,
+        std::unique_ptr<crypto::tink::OutputStream> ciphertext_destination,
+        absl::string_view associated_data) {
+  if (ciphertext_source == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_source must be non-null");
+  }
+  if (ciphertext_destination == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_destination must be non-null");
+  }
+  auto segment_decrypter_result = NewSegmentDecrypter(associated_data);
+  if (!segment_decrypter_result.ok()) return segment_decrypter_result.status();
+  auto segment_decrypter = std::move(segment_decrypter_result.ValueOrDie());
+  auto ct_size_result = ciphertext_source->size();
+  if (!ct_size_result.ok()) return ct_size_result.status();
+  auto last_segment_result =
+      GetLastSegment(*segment_decrypter, ct_size_result.ValueOrDie());
+  if (!last_segment_result.ok()) return last_segment_result.status();
+  const LastSegment& last_segment = last_segment_result.ValueOrDie();
+
+  // Verify the header and the last segment, which must be sealed as such.
+  std::vector<uint8_t> header(segment_decrypter->get_header_size());
+  auto status = ReadFully(ciphertext_source,
+                          segment_decrypter->get_ciphertext_offset(),
+                          header.size(), header.data());
+  if (!status.ok()) return status;
+  status = segment_decrypter->Init(header);
+  if (!status.ok()) return status;
+  std::vector<uint8_t> ct_segment(last_segment.ct_size);
+  status = ReadFully(ciphertext_source, last_segment.ct_position,
+                     ct_segment.size(), ct_segment.data());
+  if (!status.ok()) return status;
+  std::vector<uint8_t> pt_segment(
+      last_segment.ct_size - (segment_decrypter->get_ciphertext_segment_size() -
+                              segment_decrypter->get_plaintext_segment_size()));
+  RangeSegment segment;
+  segment.segment_nr = last_segment.segment_nr;
+  segment.ciphertext = absl::MakeConstSpan(ct_segment);
+  segment.plaintext = absl::MakeSpan(pt_segment);
+  status = DecryptRangeSegment(segment_decrypter.get(), segment,
+                               /* is_last_segment = */ true);
+  if (!status.ok()) return status;
+
+  auto segment_encrypter_result = NewSegmentEncrypterForAppend(
+      associated_data, header, last_segment.segment_nr);
+  if (!segment_encrypter_result.ok()) return segment_encrypter_result.status();
+  return StreamingAeadEncryptingStream::NewForAppend(
+      std::move(segment_encrypter_result.ValueOrDie()),
+      std::move(ciphertext_destination), pt_segment,
+      last_segment.pt_position + pt_segment.size());
+}
+
+crypto::tink::util::StatusOr<std::unique_ptr<StreamSegmentEncrypter>>
+    NonceBasedStreamingAead::NewSegmentEncrypterForAppend(
+        absl::string_view associated_data, const std::vector<uint8_t>& header,
+        int64_t segment_number) const {
+  return util::Status(util::error::UNIMPLEMENTED,
+                      "appending to ciphertext streams is not supported");
+}
+
 crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::InputStream>>
     NonceBasedStreamingAead::NewDecryptingStream(
         std::unique_ptr<crypto::tink::InputStream> ciphertext_source,
@@ -54,6 +273,62 @@ crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::InputStream>>
       std::move(ciphertext_source));
 }
 
+crypto::tink::util::StatusOr<std::unique_ptr<StreamingAeadEncrypter>>
+NonceBasedStreamingAead::NewEncrypter(absl::string_view associated_data) {
+  auto segment_encrypter_result = NewSegmentEncrypter(associated_data);
+  if (!segment_encrypter_result.ok()) return segment_encrypter_result.status();
+  return StreamingAeadEncrypter::New(
+      std::move(segment_encrypter_result.ValueOrDie()));
+}
+
+crypto::tink::util::StatusOr<std::unique_ptr<StreamingAeadDecrypter>>
+NonceBasedStreamingAead::NewDecrypter(absl::string_view associated_data) {
+  auto segment_decrypter_result = NewSegmentDecrypter(associated_data);
+  if (!segment_decrypter_result.ok()) return segment_decrypter_result.status();
+  return StreamingAeadDecrypter::New(
+      std::move(segment_decrypter_result.ValueOrDie()));
+}
+
+crypto::tink::util::StatusOr<
+    std::unique_ptr<StreamingAeadRandomAccessEncrypter>>
+NonceBasedStreamingAead::NewRandomAccessEncrypter(
+    absl::string_view associated_data) {
+  auto segment_encrypter_result = NewSegmentEncrypter(associated_data);
+  if (!segment_encrypter_result.ok()) return segment_encrypter_result.status();
+  return StreamingAeadRandomAccessEncrypter::New(
+      std::move(segment_encrypter_result.ValueOrDie()));
+}
+
+crypto::tink::util::StatusOr<
+    std::unique_ptr<StreamingAeadRandomAccessEncrypter>>
+NonceBasedStreamingAead::NewRandomAccessEncrypter(
+    absl::string_view associated_data, absl::string_view header) {
+  auto segment_encrypter_result = NewSegmentEncrypterForAppend(
+      associated_data, std::vector<uint8_t>(header.begin(), header.end()),
+      /* segment_number = */ 0);
+  if (!segment_encrypter_result.ok()) return segment_encrypter_result.status();
+  return StreamingAeadRandomAccessEncrypter::New(
+      std::move(segment_encrypter_result.ValueOrDie()));
+}
+
+crypto::tink::util::StatusOr<std::unique_ptr<StreamingAeadRecordEncrypter>>
+NonceBasedStreamingAead::NewRecordEncrypter(
+    absl::string_view associated_data) {
+  auto segment_encrypter_result = NewSegmentEncrypter(associated_data);
+  if (!segment_encrypter_result.ok()) return segment_encrypter_result.status();
+  return StreamingAeadRecordEncrypter::New(
+      std::move(segment_encrypter_result.ValueOrDie()));
+}
+
+crypto::tink::util::StatusOr<std::unique_ptr<StreamingAeadRecordDecrypter>>
+NonceBasedStreamingAead::NewRecordDecrypter(
+    absl::string_view associated_data) {
+  auto segment_decrypter_result = NewSegmentDecrypter(associated_data);
+  if (!segment_decrypter_result.ok()) return segment_decrypter_result.status();
+  return StreamingAeadRecordDecrypter::New(
+      std::move(segment_decrypter_result.ValueOrDie()));
+}
+
 crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::RandomAccessStream>>
     NonceBasedStreamingAead::NewDecryptingRandomAccessStream(
         std::unique_ptr<crypto::tink::RandomAccessStream> ciphertext_source,
@@ -65,6 +340,156 @@ crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::RandomAccessStream>>
       std::move(ciphertext_source));
 }
 
+crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::RandomAccessStream>>
+    NonceBasedStreamingAead::NewDecryptingRandomAccessStream(
+        std::unique_ptr<crypto::tink::RandomAccessStream> ciphertext_source,
+        absl::string_view associated_data,
+        const DecryptingRandomAccessStream::Options& options) {
+  auto segment_decrypter_result = NewSegmentDecrypter(associated_data);
+  if (!segment_decrypter_result.ok()) return segment_decrypter_result.status();
+  return DecryptingRandomAccessStream::New(
+      std::move(segment_decrypter_result.ValueOrDie()),
+      std::move(ciphertext_source), options);
+}
+
+crypto::tink::util::StatusOr<std::string> NonceBasedStreamingAead::DecryptRange(
+    crypto::tink::RandomAccessStream* ciphertext_source,
+    absl::string_view associated_data, int64_t offset, int length,
+    int num_threads) {
+  if (ciphertext_source == nullptr) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_source must be non-null");
+  }
+  if (offset < 0 || length < 0) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "offset and length must be non-negative");
+  }
+  if (num_threads < 1) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "num_threads must be positive");
+  }
+  if (length == 0) return std::string();
+  auto segment_decrypter_result = NewSegmentDecrypter(associated_data);
+  if (!segment_decrypter_result.ok()) return segment_decrypter_result.status();
+  auto segment_decrypter = std::move(segment_decrypter_result.ValueOrDie());
+  const int header_size = segment_decrypter->get_header_size();
+  const int ct_offset = segment_decrypter->get_ciphertext_offset();
+  const int ct_segment_size = segment_decrypter->get_ciphertext_segment_size();
+  const int pt_segment_size = segment_decrypter->get_plaintext_segment_size();
+  const int ct_segment_overhead = ct_segment_size - pt_segment_size;
+
+  // Compute the plaintext size as DecryptingRandomAccessStream does.
+  auto ct_size_result = ciphertext_source->size();
+  if (!ct_size_result.ok()) return ct_size_result.status();
+  const int64_t ct_size = ct_size_result.ValueOrDie();
+  int64_t segment_count = ct_size / ct_segment_size;
+  if (ct_size % ct_segment_size > 0) segment_count++;
+  // Tink supports up to 2^32 segments.
+  if (segment_count - 1 > std::numeric_limits<uint32_t>::max()) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        absl::StrCat("too many segments: ", segment_count));
+  }
+  const int64_t overhead =
+      ct_segment_overhead * segment_count + ct_offset + header_size;
+  if (overhead > ct_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext stream is too short");
+  }
+  const int64_t pt_size = ct_size - overhead;
+  if (offset >= pt_size) {
+    return util::Status(util::error::OUT_OF_RANGE,
+                        "offset is not smaller than the plaintext size");
+  }
+  const int64_t pt_end = offset + std::min<int64_t>(length, pt_size - offset);
+
+  // The first segment holds header_size + ct_offset fewer plaintext bytes
+  // than the others, the last one may be shorter than the others.
+  const int first_segment_shift = ct_offset + header_size;
+  const int64_t first_segment_nr =
+      (offset + first_segment_shift) / pt_segment_size;
+  const int64_t last_segment_nr =
+      (pt_end - 1 + first_segment_shift) / pt_segment_size;
+  auto segment_ct_start = [&](int64_t segment_nr) -> int64_t {
+    if (segment_nr == 0) return first_segment_shift;
+    return segment_nr * ct_segment_size;
+  };
+  auto segment_pt_start = [&](int64_t segment_nr) -> int64_t {
+    if (segment_nr == 0) return 0;
+    return segment_nr * pt_segment_size - first_segment_shift;
+  };
+  // Read the header together with the segments if it directly precedes
+  // them, i.e. if the range starts in the first segment.
+  const int64_t ct_start =
+      first_segment_nr == 0 ? ct_offset : segment_ct_start(first_segment_nr);
+  const int64_t ct_end =
+      std::min<int64_t>((last_segment_nr + 1) * ct_segment_size, ct_size);
+  if (ct_end - ct_start > std::numeric_limits<int>::max()) {
+    return util::Status(util::error::INVALID_ARGUMENT, "range too large");
+  }
+  std::vector<uint8_t> ct(ct_end - ct_start);
+  std::vector<uint8_t> header(header_size);
+  util::Status status;
+  if (first_segment_nr == 0) {
+    status = ReadFully(ciphertext_source, ct_start, ct.size(), ct.data());
+    if (!status.ok()) return status;
+    std::copy(ct.begin(), ct.begin() + header_size, header.begin());
+  } else {
+    status = ReadFully(ciphertext_source, ct_offset, header_size,
+                       header.data());
+    if (!status.ok()) return status;
+    status = ReadFully(ciphertext_source, ct_start, ct.size(), ct.data());
+    if (!status.ok()) return status;
+  }
+  status = segment_decrypter->Init(header);
+  if (!status.ok()) return status;
+
+  // Decrypt all segments into their place in 'pt', then drop the plaintext
+  // outside of the range.
+  auto segment_ct_size = [&](int64_t segment_nr) -> int64_t {
+    return std::min<int64_t>((segment_nr + 1) * ct_segment_size, ct_size) -
+           segment_ct_start(segment_nr);
+  };
+  auto segment_pt_size = [&](int64_t segment_nr) -> int64_t {
+    return std::max<int64_t>(
+        segment_ct_size(segment_nr) - ct_segment_overhead, 0);
+  };
+  const int64_t pt_start = segment_pt_start(first_segment_nr);
+  std::string pt(segment_pt_start(last_segment_nr) - pt_start +
+                     segment_pt_size(last_segment_nr),
+                 '\0');
+  std::vector<RangeSegment> segments;
+  for (int64_t segment_nr = first_segment_nr; segment_nr <= last_segment_nr;
+       segment_nr++) {
+    RangeSegment segment;
+    segment.segment_nr = segment_nr;
+    segment.ciphertext = absl::MakeConstSpan(
+        ct.data() + (segment_ct_start(segment_nr) - ct_start),
+        segment_ct_size(segment_nr));
+    segment.plaintext = absl::MakeSpan(
+        reinterpret_cast<uint8_t*>(&pt[0]) +
+            (segment_pt_start(segment_nr) - pt_start),
+        segment_pt_size(segment_nr));
+    segments.push_back(segment);
+  }
+  StreamSegmentDecrypter* decrypter = segment_decrypter.get();
+  const int64_t last_stream_segment_nr = segment_count - 1;
+  std::vector<util::Status> statuses(segments.size());
+  std::atomic<bool> failed(false);
+  util::ParallelFor(segments.size(), num_threads, [&](int64_t i) {
+    if (failed.load(std::memory_order_relaxed)) return;
+    statuses[i] = DecryptRangeSegment(
+        decrypter, segments[i],
+        segments[i].segment_nr == last_stream_segment_nr);
+    if (!statuses[i].ok()) failed.store(true, std::memory_order_relaxed);
+  });
+  for (const auto& segment_status : statuses) {
+    if (!segment_status.ok()) return segment_status;
+  }
+  pt.erase(0, offset - pt_start);
+  pt.resize(pt_end - offset);
+  return std::move(pt);
+}
+
 }  // namespace subtle
 }  // namespace tink
 }  // namespace crypto
@@ -17,13 +17,24 @@
 #ifndef TINK_SUBTLE_NONCE_BASED_STREAMING_AEAD_H_
 #define TINK_SUBTLE_NONCE_BASED_STREAMING_AEAD_H_
 
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "absl/strings/string_view.h"
 #include "tink/input_stream.h"
 #include "tink/output_stream.h"
 #include "tink/random_access_stream.h"
 #include "tink/streaming_aead.h"
+#include "tink/subtle/decrypting_random_access_stream.h"
 #include "tink/subtle/stream_segment_decrypter.h"
 #include "tink/subtle/stream_segment_encrypter.h"
+#include "tink/subtle/streaming_aead_decrypter.h"
+#include "tink/subtle/streaming_aead_encrypter.h"
+#include "tink/subtle/streaming_aead_random_access_encrypter.h"
+#include "tink/subtle/streaming_aead_record_decrypter.h"
+#include "tink/subtle/streaming_aead_record_encrypter.h"
 #include "tink/util/statusor.h"
 
 namespace crypto {
@@ -53,6 +64,106 @@ class NonceBasedStreamingAead : public StreamingAead {
       std::unique_ptr<crypto::tink::RandomAccessStream> ciphertext_source,
       absl::string_view associated_data) override;
 
+  // Like NewDecryptingRandomAccessStream() above, with the given 'options',
+  // e.g. for reading segments ahead on worker threads.
+  crypto::tink::util::StatusOr<
+      std::unique_ptr<crypto::tink::RandomAccessStream>>
+  NewDecryptingRandomAccessStream(
+      std::unique_ptr<crypto::tink::RandomAccessStream> ciphertext_source,
+      absl::string_view associated_data,
+      const DecryptingRandomAccessStream::Options& options);
+
+  // Like NewEncryptingStream(), but encrypts the segments on 'num_threads'
+  // worker threads, see ParallelStreamingAeadEncryptingStream. The resulting
+  // ciphertext can be decrypted by any of the decrypting streams above.
+  crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::OutputStream>>
+  NewParallelEncryptingStream(
+      std::unique_ptr<crypto::tink::OutputStream> ciphertext_destination,
+      absl::string_view associated_data, int num_threads);
+
+  // Returns an encrypter to which the plaintext is passed in memory, and
+  // which returns the ciphertext instead of writing it to a stream, for use
+  // with non-blocking I/O; see StreamingAeadEncrypter. The ciphertext is the
+  // same as that of NewEncryptingStream().
+  crypto::tink::util::StatusOr<std::unique_ptr<StreamingAeadEncrypter>>
+  NewEncrypter(absl::string_view associated_data);
+
+  // Returns the counterpart of NewEncrypter() for decryption, see
+  // StreamingAeadDecrypter. It decrypts the ciphertexts of all encrypting
+  // streams above.
+  crypto::tink::util::StatusOr<std::unique_ptr<StreamingAeadDecrypter>>
+  NewDecrypter(absl::string_view associated_data);
+
+  // Returns an encrypter of the segments of a new ciphertext stream in any
+  // order and from any thread, see StreamingAeadRandomAccessEncrypter.
+  crypto::tink::util::StatusOr<
+      std::unique_ptr<StreamingAeadRandomAccessEncrypter>>
+  NewRandomAccessEncrypter(absl::string_view associated_data);
+
+  // Like NewRandomAccessEncrypter() above, but for the existing ciphertext
+  // stream with the given 'header', so that several writers can encrypt the
+  // parts of one stream: one writer creates the stream and passes its
+  // get_header() to the others. Requires a subclass that implements
+  // NewSegmentEncrypterForAppend(), such as AES-GCM-HKDF.
+  crypto::tink::util::StatusOr<
+      std::unique_ptr<StreamingAeadRandomAccessEncrypter>>
+  NewRandomAccessEncrypter(absl::string_view associated_data,
+                           absl::string_view header);
+
+  // Returns an encrypter of discrete messages as records of a single
+  // ciphertext stream, for message-oriented transports; see
+  // StreamingAeadRecordEncrypter.
+  crypto::tink::util::StatusOr<std::unique_ptr<StreamingAeadRecordEncrypter>>
+  NewRecordEncrypter(absl::string_view associated_data);
+
+  // Returns the counterpart of NewRecordEncrypter() for decryption, see
+  // StreamingAeadRecordDecrypter.
+  crypto::tink::util::StatusOr<std::unique_ptr<StreamingAeadRecordDecrypter>>
+  NewRecordDecrypter(absl::string_view associated_data);
+
+  // Decrypts up to 'length' bytes of the plaintext starting at plaintext
+  // position 'offset' from the ciphertext in 'ciphertext_source', e.g. to
+  // serve a byte range of an encrypted object. Unlike repeated PRead()-calls
+  // on a decrypting random access stream, this reads the stream header and
+  // the ciphertext of all segments overlapping the range with at most two
+  // PRead()-calls on 'ciphertext_source' (a single one if the range starts in
+  // the first segment), and decrypts the segments on up to 'num_threads'
+  // threads. Fewer than 'length' bytes are returned only if the plaintext
+  // ends before offset + length; an 'offset' at or past the end of the
+  // plaintext gives OUT_OF_RANGE. As with decrypting random access streams,
+  // truncation of the ciphertext is only detected if the range includes the
+  // last segment.
+  crypto::tink::util::StatusOr<std::string> DecryptRange(
+      crypto::tink::RandomAccessStream* ciphertext_source,
+      absl::string_view associated_data, int64_t offset, int length,
+      int num_threads = 1);
+
+  // Returns the position in 'ciphertext_source' from which the output of
+  // NewAppendingStream() replaces the existing ciphertext, i.e. the position
+  // of the last segment.
+  crypto::tink::util::StatusOr<int64_t> GetAppendPosition(
+      crypto::tink::RandomAccessStream* ciphertext_source);
+
+  // Returns an encrypting stream that appends to the complete ciphertext
+  // stream in 'ciphertext_source', so that appending costs one segment
+  // rather than re-encrypting the whole stream. The header and the last
+  // segment of the existing ciphertext are verified using 'associated_data'.
+  // The stream re-encrypts the last segment together with the appended
+  // plaintext, and 'ciphertext_destination' must write its output over the
+  // existing ciphertext starting at GetAppendPosition(), e.g. by opening the
+  // file for writing without truncating it and seeking to that position.
+  //
+  // Sealing the existing last segment again as the last segment would reuse
+  // its nonce with a different plaintext, so each append must start a new
+  // segment: Close() fails with FAILED_PRECONDITION and writes nothing if
+  // the appended plaintext fits into the existing last segment. Appending
+  // nothing leaves the existing ciphertext unchanged.
+  crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::OutputStream>>
+  NewAppendingStream(
+      crypto::tink::RandomAccessStream* ciphertext_source,
+      std::unique_ptr<crypto::tink::OutputStream> ciphertext_destination,
+      absl::string_view associated_data);
+
  protected:
   // Methods to be implemented by a subclass of this class.
 
@@ -63,6 +174,14 @@ class NonceBasedStreamingAead : public StreamingAead {
   // Returns a new StreamSegmentDecrypter that uses `associated_data` for AEAD.
   virtual crypto::tink::util::StatusOr<std::unique_ptr<StreamSegmentDecrypter>>
   NewSegmentDecrypter(absl::string_view associated_data) const = 0;
+
+  // Returns a new StreamSegmentEncrypter that continues the ciphertext
+  // stream with the given `header` at segment `segment_number`. The default
+  // implementation returns UNIMPLEMENTED.
+  virtual crypto::tink::util::StatusOr<std::unique_ptr<StreamSegmentEncrypter>>
+  NewSegmentEncrypterForAppend(absl::string_view associated_data,
+                               const std::vector<uint8_t>& header,
+                               int64_t segment_number) const;
 };
 
 }  // namespace subtle
@@ -0,0 +1,281 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/parallel_streaming_aead_encrypting_stream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "tink/output_stream.h"
+#include "tink/subtle/stream_segment_encrypter.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+using crypto::tink::OutputStream;
+using crypto::tink::util::Status;
+using crypto::tink::util::StatusOr;
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+namespace {
+
+// Writes 'contents' to the specified 'output_stream', which must be non-null.
+// In case of errors returns the first non-OK status of
+// output_stream->Next()-operation.
+util::Status WriteToStream(const std::vector<uint8_t>& contents,
+                           OutputStream* output_stream) {
+  void* buffer;
+  int pos = 0;
+  int remaining = contents.size();
+  int available_space = 0;
+  int available_bytes = 0;
+  while (remaining > 0) {
+    auto next_result = output_stream->Next(&buffer);
+    if (!next_result.ok()) return next_result.status();
+    available_space = next_result.ValueOrDie();
+    available_bytes = std::min(available_space, remaining);
+    memcpy(buffer, contents.data() + pos, available_bytes);
+    remaining -= available_bytes;
+    pos += available_bytes;
+  }
+  if (available_space > available_bytes) {
+    output_stream->BackUp(available_space - available_bytes);
+  }
+  return Status::OK;
+}
+
+}  // anonymous namespace
+
+// static
+StatusOr<std::unique_ptr<OutputStream>>
+ParallelStreamingAeadEncryptingStream::New(
+    std::unique_ptr<StreamSegmentEncrypter> segment_encrypter,
+    std::unique_ptr<OutputStream> ciphertext_destination, int num_threads) {
+  if (segment_encrypter == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "segment_encrypter must be non-null");
+  }
+  if (ciphertext_destination == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "cipertext_destination must be non-null");
+  }
+  if (num_threads <= 0) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "num_threads must be positive");
+  }
+  int first_segment_size = segment_encrypter->get_plaintext_segment_size() -
+                           segment_encrypter->get_ciphertext_offset() -
+                           segment_encrypter->get_header().size();
+  if (first_segment_size <= 0) {
+    return Status(util::error::INTERNAL,
+                  "Size of the first segment must be greater than 0.");
+  }
+  auto enc_stream = absl::WrapUnique(new ParallelStreamingAeadEncryptingStream(
+      std::move(segment_encrypter), std::move(ciphertext_destination),
+      num_threads));
+  enc_stream->pt_buffer_.resize(first_segment_size);
+  enc_stream->count_backedup_ = first_segment_size;
+  return {std::move(enc_stream)};
+}
+
+ParallelStreamingAeadEncryptingStream::ParallelStreamingAeadEncryptingStream(
+    std::unique_ptr<StreamSegmentEncrypter> segment_encrypter,
+    std::unique_ptr<OutputStream> ciphertext_destination, int num_threads)
+    : segment_encrypter_(std::move(segment_encrypter)),
+      ct_destination_(std::move(ciphertext_destination)),
+      max_in_flight_(2 * num_threads),
+      next_segment_number_(segment_encrypter_->get_segment_number()),
+      position_(0),
+      status_(Status::OK),
+      count_backedup_(0),
+      pt_buffer_offset_(0),
+      is_first_segment_(true) {
+  workers_.reserve(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    workers_.emplace_back([this]() { WorkerLoop(); });
+  }
+}
+
+ParallelStreamingAeadEncryptingStream::
+    ~ParallelStreamingAeadEncryptingStream() {
+  {
+    absl::MutexLock lock(&mu_);
+    shutdown_ = true;
+  }
+  for (auto& worker : workers_) worker.join();
+}
+
+bool ParallelStreamingAeadEncryptingStream::HasQueuedJobOrShutdown() const {
+  return shutdown_ || !queued_.empty();
+}
+
+bool ParallelStreamingAeadEncryptingStream::IsFrontDone() const {
+  return in_flight_.front()->done;
+}
+
+void ParallelStreamingAeadEncryptingStream::WorkerLoop() {
+  while (true) {
+    Job* job;
+    {
+      absl::MutexLock lock(&mu_);
+      mu_.Await(absl::Condition(this, &ParallelStreamingAeadEncryptingStream::
+                                          HasQueuedJobOrShutdown));
+      if (shutdown_) return;
+      job = queued_.front();
+      queued_.pop_front();
+    }
+    // The job is owned by in_flight_, which does not release it before it is
+    // marked as done, so it can be accessed without holding the lock.
+    Status status = segment_encrypter_->EncryptSegmentAt(
+        job->plaintext, job->segment_number, job->is_last_segment,
+        &job->ciphertext);
+    absl::MutexLock lock(&mu_);
+    job->status = std::move(status);
+    job->done = true;
+  }
+}
+
+void ParallelStreamingAeadEncryptingStream::Submit(
+    std::vector<uint8_t>* plaintext, bool is_last_segment) {
+  auto job = absl::make_unique<Job>();
+  job->segment_number = next_segment_number_++;
+  job->is_last_segment = is_last_segment;
+  job->plaintext.swap(*plaintext);
+  if (!free_buffers_.empty()) {
+    plaintext->swap(free_buffers_.back());
+    free_buffers_.pop_back();
+  }
+  plaintext->clear();
+  absl::MutexLock lock(&mu_);
+  queued_.push_back(job.get());
+  in_flight_.push_back(std::move(job));
+}
+
+Status ParallelStreamingAeadEncryptingStream::WriteCompleted(int max_pending) {
+  while (true) {
+    std::unique_ptr<Job> job;
+    {
+      absl::MutexLock lock(&mu_);
+      if (in_flight_.empty()) return Status::OK;
+      if (!in_flight_.front()->done) {
+        if (in_flight_.size() <= max_pending) return Status::OK;
+        mu_.Await(absl::Condition(
+            this, &ParallelStreamingAeadEncryptingStream::IsFrontDone));
+      }
+      job = std::move(in_flight_.front());
+      in_flight_.pop_front();
+    }
+    if (!job->status.ok()) return job->status;
+    auto status = WriteToStream(job->ciphertext, ct_destination_.get());
+    if (!status.ok()) return status;
+    free_buffers_.push_back(std::move(job->plaintext));
+  }
+}
+
+Status ParallelStreamingAeadEncryptingStream::Fail(Status status) {
+  ct_destination_->Close().IgnoreError();
+  return status;
+}
+
+StatusOr<int> ParallelStreamingAeadEncryptingStream::Next(void** data) {
+  if (!status_.ok()) return status_;
+
+  // The first call to Next().
+  if (is_first_segment_) {
+    is_first_segment_ = false;
+    count_backedup_ = 0;
+    status_ =
+        WriteToStream(segment_encrypter_->get_header(), ct_destination_.get());
+    if (!status_.ok()) return status_;
+    *data = pt_buffer_.data();
+    position_ = pt_buffer_.size();
+    return pt_buffer_.size();
+  }
+
+  // If some space was backed up, return it first.
+  if (count_backedup_ > 0) {
+    position_ += count_backedup_;
+    pt_buffer_offset_ = pt_buffer_.size() - count_backedup_;
+    int backedup = count_backedup_;
+    count_backedup_ = 0;
+    *data = pt_buffer_.data() + pt_buffer_offset_;
+    return backedup;
+  }
+
+  // As in StreamingAeadEncryptingStream, pt_to_encrypt_ is known not to be
+  // the last segment by now. It is handed to the workers instead of being
+  // encrypted in place, and finished segments are written out, blocking
+  // only when too many segments are in flight.
+  if (!pt_to_encrypt_.empty()) {
+    Submit(&pt_to_encrypt_, /* is_last_segment = */ false);
+    status_ = WriteCompleted(max_in_flight_);
+    if (!status_.ok()) return status_;
+  }
+  pt_buffer_.swap(pt_to_encrypt_);
+  pt_buffer_.resize(segment_encrypter_->get_plaintext_segment_size());
+  *data = pt_buffer_.data();
+  pt_buffer_offset_ = 0;
+  position_ += pt_buffer_.size();
+  return pt_buffer_.size();
+}
+
+void ParallelStreamingAeadEncryptingStream::BackUp(int count) {
+  if (is_first_segment_ || !status_.ok() || count < 1) return;
+  int curr_buffer_size = pt_buffer_.size() - pt_buffer_offset_;
+  int actual_count = std::min(count, curr_buffer_size - count_backedup_);
+  count_backedup_ += actual_count;
+  position_ -= actual_count;
+}
+
+Status ParallelStreamingAeadEncryptingStream::Close() {
+  if (!status_.ok()) return status_;
+  if (is_first_segment_) {  // Next() was never called.
+    is_first_segment_ = false;
+    status_ =
+        WriteToStream(segment_encrypter_->get_header(), ct_destination_.get());
+    if (!status_.ok()) return status_;
+  }
+
+  // The last segment encrypts plaintext from pt_to_encrypt_,
+  // unless the current pt_buffer_ has some plaintext bytes.
+  std::vector<uint8_t>* pt_last_segment = &pt_to_encrypt_;
+  if ((!pt_buffer_.empty()) && count_backedup_ < pt_buffer_.size()) {
+    pt_buffer_.resize(pt_buffer_.size() - count_backedup_);
+    pt_last_segment = &pt_buffer_;
+  }
+  if (pt_last_segment != &pt_to_encrypt_ && (!pt_to_encrypt_.empty())) {
+    Submit(&pt_to_encrypt_, /* is_last_segment = */ false);
+  }
+  Submit(pt_last_segment, /* is_last_segment = */ true);
+  status_ = WriteCompleted(/* max_pending = */ 0);
+  if (!status_.ok()) return Fail(status_);
+  status_ = Status(util::error::FAILED_PRECONDITION, "Stream closed");
+  return ct_destination_->Close();
+}
+
+int64_t ParallelStreamingAeadEncryptingStream::Position() const {
+  return position_;
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,125 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_SUBTLE_PARALLEL_STREAMING_AEAD_ENCRYPTING_STREAM_H_
+#define TINK_SUBTLE_PARALLEL_STREAMING_AEAD_ENCRYPTING_STREAM_H_
+
+#include <deque>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "tink/output_stream.h"
+#include "tink/subtle/stream_segment_encrypter.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// An encrypting stream that produces the same ciphertext format as
+// StreamingAeadEncryptingStream, but encrypts the segments on a pool of
+// worker threads. Segments are written to the ciphertext destination in
+// order, and at most 2 * num_threads segments are buffered at any time.
+//
+// 'segment_encrypter' must implement EncryptSegmentAt(); otherwise the
+// first write of a segment fails with UNIMPLEMENTED.
+class ParallelStreamingAeadEncryptingStream : public OutputStream {
+ public:
+  // A factory that produces encrypting streams, see
+  // StreamingAeadEncryptingStream::New(). 'num_threads' must be positive.
+  static
+  crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::OutputStream>>
+      New(std::unique_ptr<StreamSegmentEncrypter> segment_encrypter,
+          std::unique_ptr<crypto::tink::OutputStream> ciphertext_destination,
+          int num_threads);
+
+  ~ParallelStreamingAeadEncryptingStream() override;
+
+  // -----------------------
+  // Methods of OutputStream-interface implemented by this class.
+  crypto::tink::util::StatusOr<int> Next(void** data) override;
+  void BackUp(int count) override;
+  crypto::tink::util::Status Close() override;
+  int64_t Position() const override;
+
+ private:
+  // A segment handed to the workers.
+  struct Job {
+    int64_t segment_number;
+    bool is_last_segment;
+    std::vector<uint8_t> plaintext;
+    std::vector<uint8_t> ciphertext;
+    crypto::tink::util::Status status;
+    bool done = false;
+  };
+
+  ParallelStreamingAeadEncryptingStream(
+      std::unique_ptr<StreamSegmentEncrypter> segment_encrypter,
+      std::unique_ptr<crypto::tink::OutputStream> ciphertext_destination,
+      int num_threads);
+
+  // Queues the contents of 'plaintext' for encryption as the next segment,
+  // and leaves an empty (possibly recycled) buffer in 'plaintext'.
+  void Submit(std::vector<uint8_t>* plaintext, bool is_last_segment);
+
+  // Writes the encrypted segments that are done, in order, blocking until at
+  // most 'max_pending' segments are still in flight.
+  crypto::tink::util::Status WriteCompleted(int max_pending);
+
+  // Closes ct_destination_ after a failure, and returns 'status'.
+  crypto::tink::util::Status Fail(crypto::tink::util::Status status);
+
+  void WorkerLoop();
+  bool HasQueuedJobOrShutdown() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  bool IsFrontDone() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+
+  const std::unique_ptr<StreamSegmentEncrypter> segment_encrypter_;
+  const std::unique_ptr<crypto::tink::OutputStream> ct_destination_;
+  const int max_in_flight_;
+  std::vector<uint8_t> pt_buffer_;  // plaintext buffer
+  std::vector<uint8_t> pt_to_encrypt_;  // plaintext to be encrypted
+  std::vector<std::vector<uint8_t>> free_buffers_;  // recycled plaintexts
+  int64_t next_segment_number_;
+  int64_t position_;  // number of plaintext bytes written to this stream
+  crypto::tink::util::Status status_;  // status of the stream
+
+  // Counters that describe the state of the data in pt_buffer_.
+  int count_backedup_;    // # bytes in pt_buffer_ that were backed up
+  int pt_buffer_offset_;  // offset at which *data starts in pt_buffer_
+
+  // True until Next() or Close() is called for the first time, i.e. as long
+  // as the header has not been written to ct_destination_.
+  bool is_first_segment_;
+
+  absl::Mutex mu_;
+  // Segments that were submitted but not yet written, in segment order.
+  std::deque<std::unique_ptr<Job>> in_flight_ ABSL_GUARDED_BY(mu_);
+  // Segments of in_flight_ that no worker has picked up yet.
+  std::deque<Job*> queued_ ABSL_GUARDED_BY(mu_);
+  bool shutdown_ ABSL_GUARDED_BY(mu_) = false;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_PARALLEL_STREAMING_AEAD_ENCRYPTING_STREAM_H_
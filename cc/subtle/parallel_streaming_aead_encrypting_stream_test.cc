@@ -0,0 +1,181 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/subtle/parallel_streaming_aead_encrypting_stream.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tink/input_stream.h"
+#include "tink/output_stream.h"
+#include "tink/random_access_stream.h"
+#include "tink/streaming_aead.h"
+#include "tink/subtle/aes_ctr_hmac_streaming.h"
+#include "tink/subtle/aes_gcm_hkdf_streaming.h"
+#include "tink/subtle/common_enums.h"
+#include "tink/subtle/nonce_based_streaming_aead.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/streaming_aead_test_util.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/ostream_output_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+using ::crypto::tink::subtle::test::DummyStreamSegmentEncrypter;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using ::crypto::tink::util::OstreamOutputStream;
+
+// A StreamingAead whose encrypting streams are parallel streams of the
+// wrapped NonceBasedStreamingAead, so that EncryptThenDecrypt() can check
+// them against the regular decrypting streams.
+class ParallelEncryptingStreamingAead : public StreamingAead {
+ public:
+  ParallelEncryptingStreamingAead(NonceBasedStreamingAead* streaming_aead,
+                                  int num_threads)
+      : streaming_aead_(streaming_aead), num_threads_(num_threads) {}
+
+  util::StatusOr<std::unique_ptr<OutputStream>> NewEncryptingStream(
+      std::unique_ptr<OutputStream> ciphertext_destination,
+      absl::string_view associated_data) override {
+    return streaming_aead_->NewParallelEncryptingStream(
+        std::move(ciphertext_destination), associated_data, num_threads_);
+  }
+
+  util::StatusOr<std::unique_ptr<InputStream>> NewDecryptingStream(
+      std::unique_ptr<InputStream> ciphertext_source,
+      absl::string_view associated_data) override {
+    return streaming_aead_->NewDecryptingStream(std::move(ciphertext_source),
+                                                associated_data);
+  }
+
+  util::StatusOr<std::unique_ptr<RandomAccessStream>>
+  NewDecryptingRandomAccessStream(
+      std::unique_ptr<RandomAccessStream> ciphertext_source,
+      absl::string_view associated_data) override {
+    return streaming_aead_->NewDecryptingRandomAccessStream(
+        std::move(ciphertext_source), associated_data);
+  }
+
+ private:
+  NonceBasedStreamingAead* streaming_aead_;
+  int num_threads_;
+};
+
+std::unique_ptr<OutputStream> GetCiphertextDestination() {
+  return absl::make_unique<OstreamOutputStream>(
+      absl::make_unique<std::stringstream>());
+}
+
+TEST(ParallelStreamingAeadEncryptingStreamTest, AesGcmHkdf) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  for (int ciphertext_offset : {0, 10}) {
+    AesGcmHkdfStreaming::Params params;
+    params.ikm = Random::GetRandomKeyBytes(32);
+    params.hkdf_hash = SHA256;
+    params.derived_key_size = 16;
+    params.ciphertext_segment_size = 128;
+    params.ciphertext_offset = ciphertext_offset;
+    auto result = AesGcmHkdfStreaming::New(std::move(params));
+    ASSERT_THAT(result.status(), IsOk());
+    auto streaming_aead = std::move(result.ValueOrDie());
+    for (int num_threads : {1, 2, 4}) {
+      ParallelEncryptingStreamingAead parallel(streaming_aead.get(),
+                                               num_threads);
+      for (int pt_size : {0, 16, 100, 1000, 10000}) {
+        SCOPED_TRACE(absl::StrCat("ciphertext_offset = ", ciphertext_offset,
+                                  ", num_threads = ", num_threads,
+                                  ", pt_size = ", pt_size));
+        std::string pt = Random::GetRandomBytes(pt_size);
+        EXPECT_THAT(EncryptThenDecrypt(&parallel, streaming_aead.get(), pt,
+                                       "some associated data",
+                                       ciphertext_offset),
+                    IsOk());
+      }
+    }
+  }
+}
+
+TEST(ParallelStreamingAeadEncryptingStreamTest, AesCtrHmac) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  AesCtrHmacStreaming::Params params;
+  params.ikm = Random::GetRandomKeyBytes(32);
+  params.hkdf_algo = SHA256;
+  params.key_size = 16;
+  params.ciphertext_segment_size = 256;
+  params.ciphertext_offset = 8;
+  params.tag_algo = SHA256;
+  params.tag_size = 16;
+  auto result = AesCtrHmacStreaming::New(std::move(params));
+  ASSERT_THAT(result.status(), IsOk());
+  auto streaming_aead = std::move(result.ValueOrDie());
+  for (int num_threads : {1, 3}) {
+    ParallelEncryptingStreamingAead parallel(streaming_aead.get(),
+                                             num_threads);
+    for (int pt_size : {0, 16, 1000, 20000}) {
+      SCOPED_TRACE(absl::StrCat("num_threads = ", num_threads,
+                                ", pt_size = ", pt_size));
+      std::string pt = Random::GetRandomBytes(pt_size);
+      EXPECT_THAT(EncryptThenDecrypt(&parallel, streaming_aead.get(), pt,
+                                     "some associated data",
+                                     /* ciphertext_offset = */ 8),
+                  IsOk());
+    }
+  }
+}
+
+TEST(ParallelStreamingAeadEncryptingStreamTest, InvalidNumThreads) {
+  auto seg_enc = absl::make_unique<DummyStreamSegmentEncrypter>(100, 10, 0);
+  EXPECT_THAT(ParallelStreamingAeadEncryptingStream::New(
+                  std::move(seg_enc), GetCiphertextDestination(), 0)
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(ParallelStreamingAeadEncryptingStreamTest, UnsupportedSegmentEncrypter) {
+  // DummyStreamSegmentEncrypter does not implement EncryptSegmentAt().
+  auto seg_enc = absl::make_unique<DummyStreamSegmentEncrypter>(100, 10, 0);
+  auto result = ParallelStreamingAeadEncryptingStream::New(
+      std::move(seg_enc), GetCiphertextDestination(), 2);
+  ASSERT_THAT(result.status(), IsOk());
+  auto enc_stream = std::move(result.ValueOrDie());
+  void* buffer;
+  auto next_result = enc_stream->Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  EXPECT_THAT(enc_stream->Close(), StatusIs(util::error::UNIMPLEMENTED));
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
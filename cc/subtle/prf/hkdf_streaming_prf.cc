@@ -24,8 +24,10 @@
 #include "openssl/base.h"
 #include "openssl/hkdf.h"
 #include "openssl/hmac.h"
+#include "tink/random_access_stream.h"
 #include "tink/subtle/subtle_util.h"
 #include "tink/subtle/subtle_util_boringssl.h"
+#include "tink/util/buffer.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
@@ -164,6 +166,73 @@ class HkdfInputStream : public InputStream {
   int position_in_ti_ = 0;
 };
 
+// Reads the output of an HkdfInputStream on demand, and keeps it to answer
+// reads at arbitrary positions.
+class HkdfRandomAccessStream : public RandomAccessStream {
+ public:
+  HkdfRandomAccessStream(const EVP_MD *digest, const util::SecretData &secret,
+                         absl::string_view salt, absl::string_view input)
+      : stream_(digest, secret, salt, input),
+        size_(digest == nullptr ? 0 : kMaxBlocks * EVP_MD_size(digest)) {
+    output_.reserve(size_);
+  }
+
+  util::Status PRead(int64_t position, int count,
+                     util::Buffer *dest_buffer) override {
+    if (dest_buffer == nullptr) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "dest_buffer must be non-null");
+    }
+    if (count <= 0) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "count must be positive");
+    }
+    if (count > dest_buffer->allocated_size()) {
+      return util::Status(util::error::INVALID_ARGUMENT, "buffer too small");
+    }
+    if (position < 0) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "position cannot be negative");
+    }
+    const int64_t end = std::min(position + count, size_);
+    while (static_cast<int64_t>(output_.size()) < end) {
+      const void *data;
+      auto next_result = stream_.Next(&data);
+      if (!next_result.ok()) {
+        dest_buffer->set_size(0).IgnoreError();
+        return next_result.status();
+      }
+      const uint8_t *bytes = static_cast<const uint8_t *>(data);
+      output_.insert(output_.end(), bytes, bytes + next_result.ValueOrDie());
+    }
+    if (position >= end) {
+      dest_buffer->set_size(0).IgnoreError();
+      return util::Status(util::error::OUT_OF_RANGE, "EOF");
+    }
+    std::copy(output_.begin() + position, output_.begin() + end,
+              dest_buffer->get_mem_block());
+    util::Status status = dest_buffer->set_size(end - position);
+    if (!status.ok()) return status;
+    if (end - position < count) {
+      return util::Status(util::error::OUT_OF_RANGE, "EOF");
+    }
+    return util::OkStatus();
+  }
+
+  util::StatusOr<int64_t> size() override { return size_; }
+
+ private:
+  // HKDF-Expand computes at most 255 blocks, RFC 5869, Section 2.3.
+  static constexpr int64_t kMaxBlocks = 255;
+
+  HkdfInputStream stream_;
+  const int64_t size_;
+  // The output read from stream_ so far.
+  util::SecretData output_;
+};
+
+constexpr int64_t HkdfRandomAccessStream::kMaxBlocks;
+
 }  // namespace
 
 std::unique_ptr<InputStream> HkdfStreamingPrf::ComputePrf(
@@ -171,6 +240,12 @@ std::unique_ptr<InputStream> HkdfStreamingPrf::ComputePrf(
   return absl::make_unique<HkdfInputStream>(hash_, secret_, salt_, input);
 }
 
+std::unique_ptr<RandomAccessStream> HkdfStreamingPrf::ComputePrfRandomAccess(
+    absl::string_view input) const {
+  return absl::make_unique<HkdfRandomAccessStream>(hash_, secret_, salt_,
+                                                   input);
+}
+
 // static
 crypto::tink::util::StatusOr<std::unique_ptr<StreamingPrf>>
 HkdfStreamingPrf::New(HashType hash, util::SecretData secret,
@@ -23,6 +23,7 @@
 
 #include "absl/strings/string_view.h"
 #include "openssl/base.h"
+#include "tink/random_access_stream.h"
 #include "tink/subtle/common_enums.h"
 #include "tink/subtle/prf/streaming_prf.h"
 #include "tink/config/tink_fips.h"
@@ -41,6 +42,15 @@ class HkdfStreamingPrf : public StreamingPrf {
   std::unique_ptr<InputStream> ComputePrf(
       absl::string_view input) const override;
 
+  // Returns the same bytes as ComputePrf(input), i.e. the whole output of
+  // HKDF-Expand, which is 255 times the hash size long, as a stream which
+  // can be read at any position.
+  // The blocks of HKDF-Expand are chained, so reading at some position
+  // computes all blocks up to it; the blocks are kept, so that each of them
+  // is computed at most once. The returned stream is not thread-safe.
+  std::unique_ptr<RandomAccessStream> ComputePrfRandomAccess(
+      absl::string_view input) const;
+
   static constexpr crypto::tink::FipsCompatibility kFipsStatus =
       crypto::tink::FipsCompatibility::kNotFips;
 
@@ -20,6 +20,7 @@
 #include "gtest/gtest.h"
 #include "tink/subtle/hkdf.h"
 #include "tink/subtle/random.h"
+#include "tink/util/buffer.h"
 #include "tink/util/input_stream_util.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/test_matchers.h"
@@ -33,6 +34,7 @@ namespace {
 
 using ::crypto::tink::test::HexDecodeOrDie;
 using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::IsOkAndHolds;
 using ::crypto::tink::test::StatusIs;
 using ::testing::Eq;
 using ::testing::Ge;
@@ -538,6 +540,55 @@ TEST(HkdfStreamingPrf, TestAgainstHkdfUtil) {
               Eq(util::SecretDataAsStringView(compute_hkdf_result)));
 }
 
+TEST(HkdfStreamingPrf, RandomAccessMatchesStream) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  auto streaming_prf_or = HkdfStreamingPrf::New(
+      SHA256, util::SecretDataFromStringView("key0123456"), "salt");
+  ASSERT_THAT(streaming_prf_or.status(), IsOk());
+  const HkdfStreamingPrf& prf =
+      static_cast<const HkdfStreamingPrf&>(*streaming_prf_or.ValueOrDie());
+  std::unique_ptr<InputStream> stream = prf.ComputePrf("input");
+  auto expected_or = ReadBytesFromStream(255 * 32, stream.get());
+  ASSERT_THAT(expected_or.status(), IsOk());
+  const std::string& expected = expected_or.ValueOrDie();
+
+  std::unique_ptr<RandomAccessStream> random_access =
+      prf.ComputePrfRandomAccess("input");
+  EXPECT_THAT(random_access->size(), IsOkAndHolds(255 * 32));
+  auto buffer = std::move(util::Buffer::New(100).ValueOrDie());
+  // Read backwards, so that the first read computes all blocks.
+  for (int64_t position = 255 * 32 - 100; position >= 0; position -= 77) {
+    ASSERT_THAT(random_access->PRead(position, 100, buffer.get()), IsOk());
+    EXPECT_THAT(std::string(buffer->get_mem_block(), buffer->size()),
+                Eq(expected.substr(position, 100)));
+  }
+}
+
+TEST(HkdfStreamingPrf, RandomAccessEndOfStream) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  auto streaming_prf_or = HkdfStreamingPrf::New(
+      SHA1, util::SecretDataFromStringView("key0123456"), "salt");
+  ASSERT_THAT(streaming_prf_or.status(), IsOk());
+  std::unique_ptr<RandomAccessStream> random_access =
+      static_cast<const HkdfStreamingPrf&>(*streaming_prf_or.ValueOrDie())
+          .ComputePrfRandomAccess("input");
+  auto buffer = std::move(util::Buffer::New(10).ValueOrDie());
+  EXPECT_THAT(random_access->PRead(255 * 20 - 4, 10, buffer.get()),
+              StatusIs(util::error::OUT_OF_RANGE));
+  EXPECT_THAT(buffer->size(), Eq(4));
+  EXPECT_THAT(random_access->PRead(255 * 20, 10, buffer.get()),
+              StatusIs(util::error::OUT_OF_RANGE));
+  EXPECT_THAT(buffer->size(), Eq(0));
+  EXPECT_THAT(random_access->PRead(-1, 10, buffer.get()),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(random_access->PRead(0, 11, buffer.get()),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
 TEST(HkdfStreamingPrf, TestFipsOnly) {
   if (!kUseOnlyFips) {
     GTEST_SKIP() << "Only supported in FIPS-only mode";
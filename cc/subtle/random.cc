@@ -16,18 +16,64 @@
 
 #include "tink/subtle/random.h"
 
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#include <atomic>
 #include <cstring>
 #include <string>
 
+#include "absl/types/span.h"
 #include "openssl/rand.h"
+#include "tink/subtle/subtle_util.h"
 
 namespace crypto {
 namespace tink {
 namespace subtle {
 
+namespace {
+
+// Requests larger than this bypass the nonce pool.
+constexpr size_t kMaxPooledRequestSize = 32;
+constexpr size_t kNoncePoolSize = 512;
+
+// Incremented in the child process after fork(). A thread-local nonce pool
+// records the generation it was filled in, and is discarded once the
+// generation changes, so that parent and child never use the same nonces.
+std::atomic<uint64_t> fork_generation{0};
+
+void RegisterForkHandler() {
+#ifndef _WIN32
+  static const int registered = pthread_atfork(
+      /*prepare=*/nullptr, /*parent=*/nullptr, /*child=*/[] {
+        fork_generation.fetch_add(1, std::memory_order_relaxed);
+      });
+  (void)registered;
+#endif
+}
+
+struct NoncePool {
+  uint8_t bytes[kNoncePoolSize];
+  // The unused bytes are the last 'available' bytes of 'bytes'.
+  size_t available = 0;
+  uint64_t generation = 0;
+};
+
+thread_local NoncePool nonce_pool;
+
+}  // namespace
+
 // static
 std::string Random::GetRandomBytes(size_t length) {
-  std::unique_ptr<uint8_t[]> buf(new uint8_t[length]);
+  std::string result;
+  ResizeStringUninitialized(&result, length);
+  GetRandomBytes(absl::MakeSpan(&result[0], length));
+  return result;
+}
+
+// static
+void Random::GetRandomBytes(absl::Span<char> buffer) {
   // BoringSSL documentation says that it always returns 1; while
   // OpenSSL documentation says that it returns 1 on success, 0 otherwise. We
   // use BoringSSL, so we don't check the return value.
@@ -38,30 +84,69 @@ std::string Random::GetRandomBytes(size_t length) {
   // until the system has collected at least 128 bits since boot. For old
   // kernels without getrandom support (and not in FIPS mode), it will resort to
   // /dev/urandom.
-  RAND_bytes(buf.get(), length);
-  return std::string(reinterpret_cast<const char *>(buf.get()), length);
+  RAND_bytes(reinterpret_cast<uint8_t*>(buffer.data()), buffer.size());
+}
+
+// static
+void Random::GetRandomBytes(absl::Span<uint8_t> buffer) {
+  RAND_bytes(buffer.data(), buffer.size());
+}
+
+// static
+void Random::GetRandomNonceBytes(absl::Span<char> buffer) {
+  if (buffer.size() > kMaxPooledRequestSize) {
+    GetRandomBytes(buffer);
+    return;
+  }
+  NoncePool& pool = nonce_pool;
+  uint64_t generation = fork_generation.load(std::memory_order_relaxed);
+  if (pool.generation != generation || pool.available < buffer.size()) {
+    // The fork handler must be in place before the pool holds any bytes.
+    RegisterForkHandler();
+    RAND_bytes(pool.bytes, kNoncePoolSize);
+    pool.available = kNoncePoolSize;
+    pool.generation = generation;
+  }
+  uint8_t* bytes = pool.bytes + (kNoncePoolSize - pool.available);
+  std::memcpy(buffer.data(), bytes, buffer.size());
+  std::memset(bytes, 0, buffer.size());
+  pool.available -= buffer.size();
+}
+
+// static
+std::string Random::GetRandomNonceBytes(size_t length) {
+  std::string result;
+  ResizeStringUninitialized(&result, length);
+  GetRandomNonceBytes(absl::MakeSpan(&result[0], length));
+  return result;
+}
+
+// static
+uint64_t Random::GetForkGeneration() {
+  RegisterForkHandler();
+  return fork_generation.load(std::memory_order_relaxed);
 }
 
 uint32_t Random::GetRandomUInt32() {
-  uint8_t buf[sizeof(uint32_t)];
-  RAND_bytes(buf, sizeof(uint32_t));
+  char buf[sizeof(uint32_t)];
+  GetRandomNonceBytes(absl::MakeSpan(buf));
   uint32_t result;
   std::memcpy(&result, buf, sizeof(uint32_t));
   return result;
 }
 
 uint16_t Random::GetRandomUInt16() {
-  uint8_t buf[sizeof(uint16_t)];
-  RAND_bytes(buf, sizeof(uint16_t));
+  char buf[sizeof(uint16_t)];
+  GetRandomNonceBytes(absl::MakeSpan(buf));
   uint16_t result;
   std::memcpy(&result, buf, sizeof(uint16_t));
   return result;
 }
 
 uint8_t Random::GetRandomUInt8() {
-  uint8_t result;
-  RAND_bytes(&result, 1);
-  return result;
+  char result;
+  GetRandomNonceBytes(absl::MakeSpan(&result, 1));
+  return static_cast<uint8_t>(result);
 }
 
 util::SecretData Random::GetRandomKeyBytes(size_t length) {
@@ -17,9 +17,11 @@
 #ifndef TINK_SUBTLE_RANDOM_H_
 #define TINK_SUBTLE_RANDOM_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
+#include "absl/types/span.h"
 #include "tink/util/secret_data.h"
 
 namespace crypto {
@@ -28,8 +30,27 @@ namespace subtle {
 
 class Random {
  public:
-  // Returns a random string of desired length.
+  // Returns a random string of desired length. The bytes come directly from
+  // RAND_bytes, so they may be used as key material.
   static std::string GetRandomBytes(size_t length);
+  // Fills 'buffer' with random bytes.
+  static void GetRandomBytes(absl::Span<char> buffer);
+  static void GetRandomBytes(absl::Span<uint8_t> buffer);
+  // Fills 'buffer' with random bytes for public values such as nonces, IVs
+  // and salts. Short requests are served from a per-thread pool that is
+  // refilled with a single call to RAND_bytes, so that encrypting many small
+  // messages does not pay for one RAND_bytes call per nonce. Pooled bytes are
+  // never returned twice, and a pool inherited across fork() is discarded in
+  // the child. Must not be used for key material; use GetRandomKeyBytes
+  // instead.
+  static void GetRandomNonceBytes(absl::Span<char> buffer);
+  // Returns a random string of desired length, see GetRandomNonceBytes above.
+  static std::string GetRandomNonceBytes(size_t length);
+  // Returns a value which changes in the child process after fork(), so that
+  // state derived from random values can be renewed in the child.
+  static uint64_t GetForkGeneration();
+  // The following are served from the same per-thread pool as
+  // GetRandomNonceBytes.
   static uint32_t GetRandomUInt32();
   static uint16_t GetRandomUInt16();
   static uint8_t GetRandomUInt8();
@@ -16,13 +16,20 @@
 
 #include "tink/subtle/random.h"
 
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include <set>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/types/span.h"
 #include "tink/util/secret_data.h"
 
 namespace crypto {
@@ -131,6 +138,124 @@ TEST(RandomTest, UInt32Test) {
   }
 }
 
+
+TEST(RandomTest, UInt8SpanTest) {
+  std::vector<uint8_t> first(16);
+  std::vector<uint8_t> second(16);
+  Random::GetRandomBytes(absl::MakeSpan(first));
+  Random::GetRandomBytes(absl::MakeSpan(second));
+  EXPECT_NE(first, second);
+}
+
+TEST(RandomTest, NonceBytesUniqueTest) {
+  // Enough nonces to refill the per-thread pool many times, with sizes that
+  // do not divide the pool size.
+  const int kTests = 10000;
+  absl::flat_hash_set<std::string> nonces;
+  for (int i = 0; i < kTests; ++i) {
+    std::string nonce(12 + i % 13, '\0');
+    Random::GetRandomNonceBytes(absl::MakeSpan(&nonce[0], nonce.size()));
+    nonces.insert(nonce);
+  }
+  EXPECT_THAT(nonces, SizeIs(kTests));
+}
+
+TEST(RandomTest, NonceBytesLargeRequestTest) {
+  std::string first(4096, '\0');
+  std::string second(4096, '\0');
+  Random::GetRandomNonceBytes(absl::MakeSpan(&first[0], first.size()));
+  Random::GetRandomNonceBytes(absl::MakeSpan(&second[0], second.size()));
+  EXPECT_NE(first, std::string(4096, '\0'));
+  EXPECT_NE(first, second);
+}
+
+TEST(RandomTest, NonceBytesEmptyRequestTest) {
+  Random::GetRandomNonceBytes(absl::Span<char>());
+}
+
+TEST(RandomTest, NonceBytesStringTest) {
+  absl::flat_hash_set<std::string> salts;
+  for (int i = 0; i < 100; i++) {
+    std::string salt = Random::GetRandomNonceBytes(32);
+    EXPECT_THAT(salt, SizeIs(32));
+    salts.insert(salt);
+  }
+  EXPECT_THAT(salts, SizeIs(100));
+  EXPECT_THAT(Random::GetRandomNonceBytes(100), SizeIs(100));
+}
+
+TEST(RandomTest, NonceBytesStatisticsTest) {
+  constexpr int kByteLength = 12;
+  std::vector<int> bit_counts(8 * kByteLength);
+  const int kTests = 10000;
+  for (int i = 0; i < kTests; ++i) {
+    char random[kByteLength];
+    Random::GetRandomNonceBytes(absl::MakeSpan(random));
+    for (int bit = 0; bit < 8 * kByteLength; ++bit) {
+      if (random[bit / 8] & (1 << (bit % 8))) {
+        ++bit_counts[bit];
+      }
+    }
+  }
+  for (int i = 0; i < 8 * kByteLength; ++i) {
+    EXPECT_THAT(bit_counts[i], Gt(kTests * 0.4)) << i;
+    EXPECT_THAT(bit_counts[i], Lt(kTests * 0.6)) << i;
+  }
+}
+
+TEST(RandomTest, NonceBytesConcurrentTest) {
+  const int kThreads = 4;
+  const int kNoncesPerThread = 1000;
+  std::vector<std::vector<std::string>> results(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&results, t]() {
+      for (int i = 0; i < kNoncesPerThread; ++i) {
+        std::string nonce(12, '\0');
+        Random::GetRandomNonceBytes(absl::MakeSpan(&nonce[0], nonce.size()));
+        results[t].push_back(nonce);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  absl::flat_hash_set<std::string> nonces;
+  for (const auto& result : results) {
+    nonces.insert(result.begin(), result.end());
+  }
+  EXPECT_THAT(nonces, SizeIs(kThreads * kNoncesPerThread));
+}
+
+#ifndef _WIN32
+TEST(RandomTest, NonceBytesDifferAfterForkTest) {
+  // Fill the pool of this thread before forking.
+  char warmup[12];
+  Random::GetRandomNonceBytes(absl::MakeSpan(warmup));
+
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    char nonce[12];
+    Random::GetRandomNonceBytes(absl::MakeSpan(nonce));
+    ssize_t written = write(fds[1], nonce, sizeof(nonce));
+    _exit(written == sizeof(nonce) ? 0 : 1);
+  }
+  close(fds[1]);
+  char parent_nonce[12];
+  Random::GetRandomNonceBytes(absl::MakeSpan(parent_nonce));
+  char child_nonce[12];
+  ASSERT_EQ(read(fds[0], child_nonce, sizeof(child_nonce)),
+            sizeof(child_nonce));
+  close(fds[0]);
+  int status;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  EXPECT_NE(std::string(parent_nonce, sizeof(parent_nonce)),
+            std::string(child_nonce, sizeof(child_nonce)));
+}
+#endif
+
 }  // namespace
 }  // namespace subtle
 }  // namespace tink
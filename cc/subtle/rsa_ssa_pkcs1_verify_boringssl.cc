@@ -51,6 +51,9 @@ RsaSsaPkcs1VerifyBoringSsl::New(
   if (!rsa.ok()) {
     return rsa.status();
   }
+  auto precompute_status =
+      SubtleUtilBoringSSL::PrecomputeRsaPublicKey(rsa.ValueOrDie().get());
+  if (!precompute_status.ok()) return precompute_status;
 
   std::unique_ptr<RsaSsaPkcs1VerifyBoringSsl> verify(
       new RsaSsaPkcs1VerifyBoringSsl(std::move(rsa).ValueOrDie(),
@@ -37,6 +37,10 @@ namespace subtle {
 // Cryptography Standards) encoding is defined at
 // https://tools.ietf.org/html/rfc8017#section-8.2). This implemention uses
 // BoringSSL for the underlying cryptographic operations.
+//
+// Verify() may be called concurrently from several threads. The Montgomery
+// context of the modulus is created in New(), so concurrent calls share it
+// without having to set it up first.
 class RsaSsaPkcs1VerifyBoringSsl : public PublicKeyVerify {
  public:
   static crypto::tink::util::StatusOr<
@@ -54,6 +54,9 @@ RsaSsaPssVerifyBoringSsl::New(
   if (!rsa.ok()) {
     return rsa.status();
   }
+  auto precompute_status =
+      SubtleUtilBoringSSL::PrecomputeRsaPublicKey(rsa.ValueOrDie().get());
+  if (!precompute_status.ok()) return precompute_status;
 
   std::unique_ptr<RsaSsaPssVerifyBoringSsl> verify(new RsaSsaPssVerifyBoringSsl(
       std::move(rsa).ValueOrDie(), sig_hash_result.ValueOrDie(),
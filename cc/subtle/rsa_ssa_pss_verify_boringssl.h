@@ -37,6 +37,10 @@ namespace subtle {
 // Signature Scheme) encoding is defined at
 // https://tools.ietf.org/html/rfc8017#section-8.1). This implemention uses
 // Boring SSL for the underlying cryptographic operations.
+//
+// Verify() may be called concurrently from several threads. The Montgomery
+// context of the modulus is created in New(), so concurrent calls share it
+// without having to set it up first.
 class RsaSsaPssVerifyBoringSsl : public PublicKeyVerify {
  public:
   static crypto::tink::util::StatusOr<std::unique_ptr<RsaSsaPssVerifyBoringSsl>>
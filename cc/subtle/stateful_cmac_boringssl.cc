@@ -25,8 +25,9 @@ namespace crypto {
 namespace tink {
 namespace subtle {
 
-util::StatusOr<std::unique_ptr<StatefulMac>> StatefulCmacBoringSsl::New(
-    uint32_t tag_size, const util::SecretData& key_value) {
+util::StatusOr<bssl::UniquePtr<CMAC_CTX>>
+StatefulCmacBoringSsl::NewKeyedContext(uint32_t tag_size,
+                                       const util::SecretData& key_value) {
   const EVP_CIPHER* cipher;
   switch (key_value.size()) {
     case 16:
@@ -51,11 +52,29 @@ util::StatusOr<std::unique_ptr<StatefulMac>> StatefulCmacBoringSsl::New(
     return util::Status(util::error::FAILED_PRECONDITION,
                         "CMAC initialization failed");
   }
+  return std::move(ctx);
+}
 
+util::StatusOr<std::unique_ptr<StatefulMac>>
+StatefulCmacBoringSsl::NewFromKeyedContext(uint32_t tag_size,
+                                           const CMAC_CTX* keyed_ctx) {
+  bssl::UniquePtr<CMAC_CTX> ctx(CMAC_CTX_new());
+  if (!CMAC_CTX_copy(ctx.get(), keyed_ctx)) {
+    return util::Status(util::error::FAILED_PRECONDITION,
+                        "CMAC initialization failed");
+  }
   return {
       absl::WrapUnique(new StatefulCmacBoringSsl(tag_size, std::move(ctx)))};
 }
 
+util::StatusOr<std::unique_ptr<StatefulMac>> StatefulCmacBoringSsl::New(
+    uint32_t tag_size, const util::SecretData& key_value) {
+  auto ctx_result = NewKeyedContext(tag_size, key_value);
+  if (!ctx_result.ok()) return ctx_result.status();
+  return {absl::WrapUnique(new StatefulCmacBoringSsl(
+      tag_size, std::move(ctx_result.ValueOrDie())))};
+}
+
 util::Status StatefulCmacBoringSsl::Update(absl::string_view data) {
   // BoringSSL expects a non-null pointer for data,
   // regardless of whether the size is 0.
@@ -79,13 +98,23 @@ util::StatusOr<std::string> StatefulCmacBoringSsl::Finalize() {
   return std::string(reinterpret_cast<char*>(buf), tag_size_);
 }
 
+util::Status StatefulCmacBoringSsl::Reset() {
+  if (!CMAC_Reset(cmac_context_.get())) {
+    return util::Status(util::error::INTERNAL, "CMAC reset failed");
+  }
+  return util::OkStatus();
+}
+
 StatefulCmacBoringSslFactory::StatefulCmacBoringSslFactory(
     uint32_t tag_size, const util::SecretData& key_value)
-    : tag_size_(tag_size), key_value_(key_value) {}
+    : tag_size_(tag_size),
+      keyed_ctx_(StatefulCmacBoringSsl::NewKeyedContext(tag_size, key_value)) {}
 
 util::StatusOr<std::unique_ptr<StatefulMac>>
 StatefulCmacBoringSslFactory::Create() const {
-  return StatefulCmacBoringSsl::New(tag_size_, key_value_);
+  if (!keyed_ctx_.ok()) return keyed_ctx_.status();
+  return StatefulCmacBoringSsl::NewFromKeyedContext(
+      tag_size_, keyed_ctx_.ValueOrDie().get());
 }
 
 }  // namespace subtle
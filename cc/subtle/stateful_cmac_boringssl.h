@@ -41,19 +41,34 @@ class StatefulCmacBoringSsl : public subtle::StatefulMac {
       uint32_t tag_size, const util::SecretData& key_value);
   util::Status Update(absl::string_view data) override;
   util::StatusOr<std::string> Finalize() override;
+  util::Status Reset() override;
 
  private:
   static constexpr size_t kSmallKeySize = 16;
   static constexpr size_t kBigKeySize = 32;
   static constexpr size_t kMaxTagSize = 16;
 
+  friend class StatefulCmacBoringSslFactory;
+
   StatefulCmacBoringSsl(uint32_t tag_size, bssl::UniquePtr<CMAC_CTX> ctx)
       : cmac_context_(std::move(ctx)), tag_size_(tag_size) {}
 
+  // Checks the parameters and returns a CMAC context keyed with 'key_value'.
+  static util::StatusOr<bssl::UniquePtr<CMAC_CTX>> NewKeyedContext(
+      uint32_t tag_size, const util::SecretData& key_value);
+
+  // Returns a StatefulCmacBoringSsl which starts from a copy of 'keyed_ctx',
+  // skipping the key schedule.
+  static util::StatusOr<std::unique_ptr<StatefulMac>> NewFromKeyedContext(
+      uint32_t tag_size, const CMAC_CTX* keyed_ctx);
+
   const bssl::UniquePtr<CMAC_CTX> cmac_context_;
   const uint32_t tag_size_;
 };
 
+// Keys a CMAC context once upon construction; Create() hands out copies of
+// it, so the AES key schedule and subkeys are not recomputed for every
+// StatefulMac.
 class StatefulCmacBoringSslFactory : public subtle::StatefulMacFactory {
  public:
   StatefulCmacBoringSslFactory(uint32_t tag_size,
@@ -62,7 +77,8 @@ class StatefulCmacBoringSslFactory : public subtle::StatefulMacFactory {
 
  private:
   const uint32_t tag_size_;
-  const util::SecretData key_value_;
+  // The keyed context, or the error which prevented creating it.
+  const util::StatusOr<bssl::UniquePtr<CMAC_CTX>> keyed_ctx_;
 };
 
 }  // namespace subtle
@@ -173,6 +173,55 @@ TEST(StatefulCmacFactoryTest, createsObjects) {
   EXPECT_THAT(output, StrEq(expected));
 }
 
+TEST(StatefulCmacBoringSslFactoryTest, createsIndependentObjects) {
+  std::string key(test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  std::string data = "Some data to test.";
+  std::string expected(
+      test::HexDecodeOrDie("c856e183e8dee9bb99402d54c34f3222"));
+  StatefulCmacBoringSslFactory factory(kTagSize,
+                                       util::SecretDataFromStringView(key));
+
+  // Objects created from the same keyed state do not share their state.
+  auto first_or = factory.Create();
+  ASSERT_THAT(first_or.status(), IsOk());
+  auto second_or = factory.Create();
+  ASSERT_THAT(second_or.status(), IsOk());
+  EXPECT_THAT(first_or.ValueOrDie()->Update("garbage"), IsOk());
+  EXPECT_THAT(second_or.ValueOrDie()->Update(data), IsOk());
+  auto output_or = second_or.ValueOrDie()->Finalize();
+  ASSERT_THAT(output_or.status(), IsOk());
+  EXPECT_THAT(output_or.ValueOrDie(), StrEq(expected));
+}
+
+TEST(StatefulCmacBoringSslTest, resetDiscardsData) {
+  std::string key(test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  std::string data = "Some data to test.";
+  std::string expected(
+      test::HexDecodeOrDie("c856e183e8dee9bb99402d54c34f3222"));
+  auto cmac_or =
+      StatefulCmacBoringSsl::New(kTagSize, util::SecretDataFromStringView(key));
+  ASSERT_THAT(cmac_or.status(), IsOk());
+  auto cmac = std::move(cmac_or.ValueOrDie());
+
+  // Reset both before and after Finalize().
+  EXPECT_THAT(cmac->Update("garbage"), IsOk());
+  EXPECT_THAT(cmac->Reset(), IsOk());
+  for (int i = 0; i < 2; i++) {
+    EXPECT_THAT(cmac->Update(data), IsOk());
+    auto output_or = cmac->Finalize();
+    ASSERT_THAT(output_or.status(), IsOk());
+    EXPECT_THAT(output_or.ValueOrDie(), StrEq(expected));
+    EXPECT_THAT(cmac->Reset(), IsOk());
+  }
+}
+
+TEST(StatefulCmacBoringSslFactoryTest, invalidKeySize) {
+  StatefulCmacBoringSslFactory factory(kTagSize, util::SecretData(15, 'x'));
+  EXPECT_THAT(factory.Create().status(),
+              StatusIs(util::error::INVALID_ARGUMENT,
+                       HasSubstr("invalid key size")));
+}
+
 // Test with test vectors from Wycheproof project.
 bool WycheproofTest(const rapidjson::Document &root) {
   int errors = 0;
@@ -25,8 +25,9 @@ namespace crypto {
 namespace tink {
 namespace subtle {
 
-util::StatusOr<std::unique_ptr<StatefulMac>> StatefulHmacBoringSsl::New(
-    HashType hash_type, uint32_t tag_size, const util::SecretData& key_value) {
+util::StatusOr<bssl::UniquePtr<HMAC_CTX>>
+StatefulHmacBoringSsl::NewKeyedContext(HashType hash_type, uint32_t tag_size,
+                                       const util::SecretData& key_value) {
   util::StatusOr<const EVP_MD*> res = SubtleUtilBoringSSL::EvpHash(hash_type);
   if (!res.ok()) {
     return res.status();
@@ -49,11 +50,29 @@ util::StatusOr<std::unique_ptr<StatefulMac>> StatefulHmacBoringSsl::New(
     return util::Status(util::error::FAILED_PRECONDITION,
                         "HMAC initialization failed");
   }
+  return std::move(ctx);
+}
 
+util::StatusOr<std::unique_ptr<StatefulMac>>
+StatefulHmacBoringSsl::NewFromKeyedContext(uint32_t tag_size,
+                                           const HMAC_CTX* keyed_ctx) {
+  bssl::UniquePtr<HMAC_CTX> ctx(HMAC_CTX_new());
+  if (!HMAC_CTX_copy_ex(ctx.get(), keyed_ctx)) {
+    return util::Status(util::error::FAILED_PRECONDITION,
+                        "HMAC initialization failed");
+  }
   return std::unique_ptr<StatefulMac>(
       new StatefulHmacBoringSsl(tag_size, std::move(ctx)));
 }
 
+util::StatusOr<std::unique_ptr<StatefulMac>> StatefulHmacBoringSsl::New(
+    HashType hash_type, uint32_t tag_size, const util::SecretData& key_value) {
+  auto ctx_result = NewKeyedContext(hash_type, tag_size, key_value);
+  if (!ctx_result.ok()) return ctx_result.status();
+  return std::unique_ptr<StatefulMac>(new StatefulHmacBoringSsl(
+      tag_size, std::move(ctx_result.ValueOrDie())));
+}
+
 util::Status StatefulHmacBoringSsl::Update(absl::string_view data) {
   // BoringSSL expects a non-null pointer for data,
   // regardless of whether the size is 0.
@@ -78,13 +97,25 @@ util::StatusOr<std::string> StatefulHmacBoringSsl::Finalize() {
   return std::string(reinterpret_cast<char*>(buf), tag_size_);
 }
 
+util::Status StatefulHmacBoringSsl::Reset() {
+  // Without a key and digest, HMAC_Init_ex() restarts with the current key.
+  if (!HMAC_Init_ex(hmac_context_.get(), nullptr, 0, nullptr, nullptr)) {
+    return util::Status(util::error::INTERNAL, "HMAC reset failed");
+  }
+  return util::OkStatus();
+}
+
 StatefulHmacBoringSslFactory::StatefulHmacBoringSslFactory(
     HashType hash_type, uint32_t tag_size, const util::SecretData& key_value)
-    : hash_type_(hash_type), tag_size_(tag_size), key_value_(key_value) {}
+    : tag_size_(tag_size),
+      keyed_ctx_(StatefulHmacBoringSsl::NewKeyedContext(hash_type, tag_size,
+                                                        key_value)) {}
 
 util::StatusOr<std::unique_ptr<StatefulMac>>
 StatefulHmacBoringSslFactory::Create() const {
-  return StatefulHmacBoringSsl::New(hash_type_, tag_size_, key_value_);
+  if (!keyed_ctx_.ok()) return keyed_ctx_.status();
+  return StatefulHmacBoringSsl::NewFromKeyedContext(
+      tag_size_, keyed_ctx_.ValueOrDie().get());
 }
 
 }  // namespace subtle
@@ -37,18 +37,32 @@ class StatefulHmacBoringSsl : public subtle::StatefulMac {
       HashType hash_type, uint32_t tag_size, const util::SecretData& key_value);
   util::Status Update(absl::string_view data) override;
   util::StatusOr<std::string> Finalize() override;
+  util::Status Reset() override;
 
  private:
   // Minimum HMAC key size in bytes.
   static constexpr size_t kMinKeySize = 16;
 
+  friend class StatefulHmacBoringSslFactory;
+
   StatefulHmacBoringSsl(uint32_t tag_size, bssl::UniquePtr<HMAC_CTX> ctx)
       : hmac_context_(std::move(ctx)), tag_size_(tag_size) {}
 
+  // Checks the parameters and returns an HMAC context keyed with 'key_value'.
+  static util::StatusOr<bssl::UniquePtr<HMAC_CTX>> NewKeyedContext(
+      HashType hash_type, uint32_t tag_size, const util::SecretData& key_value);
+
+  // Returns a StatefulHmacBoringSsl which starts from a copy of 'keyed_ctx',
+  // skipping the key schedule.
+  static util::StatusOr<std::unique_ptr<StatefulMac>> NewFromKeyedContext(
+      uint32_t tag_size, const HMAC_CTX* keyed_ctx);
+
   const bssl::UniquePtr<HMAC_CTX> hmac_context_;
   const uint32_t tag_size_;
 };
 
+// Keys an HMAC context once upon construction; Create() hands out copies of
+// it, so the key schedule is not recomputed for every StatefulMac.
 class StatefulHmacBoringSslFactory : public subtle::StatefulMacFactory {
  public:
   StatefulHmacBoringSslFactory(HashType hash_type, uint32_t tag_size,
@@ -56,9 +70,9 @@ class StatefulHmacBoringSslFactory : public subtle::StatefulMacFactory {
   util::StatusOr<std::unique_ptr<StatefulMac>> Create() const override;
 
  private:
-  const HashType hash_type_;
   const uint32_t tag_size_;
-  const util::SecretData key_value_;
+  // The keyed context, or the error which prevented creating it.
+  const util::StatusOr<bssl::UniquePtr<HMAC_CTX>> keyed_ctx_;
 };
 
 }  // namespace subtle
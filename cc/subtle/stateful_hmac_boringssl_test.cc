@@ -198,6 +198,64 @@ TEST(StatefulCmacFactoryTest, createsObjects) {
   EXPECT_THAT(output, StrEq(expected));
 }
 
+TEST(StatefulHmacBoringSslFactoryTest, createsIndependentObjects) {
+  std::string key(test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  std::string data = "Some data to test.";
+  std::string expected(
+      test::HexDecodeOrDie("1d6eb74bc283f7947e92c72bd985ce6e"));
+  StatefulHmacBoringSslFactory factory(HashType::SHA256, kTagSize,
+                                       util::SecretDataFromStringView(key));
+
+  // Objects created from the same keyed state do not share their state.
+  auto first_or = factory.Create();
+  ASSERT_THAT(first_or.status(), IsOk());
+  auto second_or = factory.Create();
+  ASSERT_THAT(second_or.status(), IsOk());
+  EXPECT_THAT(first_or.ValueOrDie()->Update("garbage"), IsOk());
+  EXPECT_THAT(second_or.ValueOrDie()->Update(data), IsOk());
+  auto output_or = second_or.ValueOrDie()->Finalize();
+  ASSERT_THAT(output_or.status(), IsOk());
+  EXPECT_THAT(output_or.ValueOrDie(), StrEq(expected));
+
+  auto third_or = factory.Create();
+  ASSERT_THAT(third_or.status(), IsOk());
+  EXPECT_THAT(third_or.ValueOrDie()->Update(data), IsOk());
+  output_or = third_or.ValueOrDie()->Finalize();
+  ASSERT_THAT(output_or.status(), IsOk());
+  EXPECT_THAT(output_or.ValueOrDie(), StrEq(expected));
+}
+
+TEST(StatefulHmacBoringSslTest, resetDiscardsData) {
+  std::string key(test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f"));
+  std::string data = "Some data to test.";
+  std::string expected(
+      test::HexDecodeOrDie("1d6eb74bc283f7947e92c72bd985ce6e"));
+  StatefulHmacBoringSslFactory factory(HashType::SHA256, kTagSize,
+                                       util::SecretDataFromStringView(key));
+  auto hmac_or = factory.Create();
+  ASSERT_THAT(hmac_or.status(), IsOk());
+  auto hmac = std::move(hmac_or.ValueOrDie());
+
+  // Reset both before and after Finalize().
+  EXPECT_THAT(hmac->Update("garbage"), IsOk());
+  EXPECT_THAT(hmac->Reset(), IsOk());
+  for (int i = 0; i < 2; i++) {
+    EXPECT_THAT(hmac->Update(data), IsOk());
+    auto output_or = hmac->Finalize();
+    ASSERT_THAT(output_or.status(), IsOk());
+    EXPECT_THAT(output_or.ValueOrDie(), StrEq(expected));
+    EXPECT_THAT(hmac->Reset(), IsOk());
+  }
+}
+
+TEST(StatefulHmacBoringSslFactoryTest, invalidKeySize) {
+  StatefulHmacBoringSslFactory factory(HashType::SHA256, kTagSize,
+                                       util::SecretData(15, 'x'));
+  EXPECT_THAT(factory.Create().status(),
+              StatusIs(util::error::INVALID_ARGUMENT,
+                       HasSubstr("invalid key size")));
+}
+
 class StatefulHmacBoringSslTestVectorTest
     : public ::testing::TestWithParam<std::pair<int, std::string>> {
  public:
@@ -20,7 +20,9 @@
 #include <cstdint>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "tink/util/status.h"
+#include "tink/util/statusor.h"
 
 namespace crypto {
 namespace tink {
@@ -44,12 +46,29 @@ class StreamSegmentDecrypter {
   // Decryption uses the current value returned by get_segment_number()
   // as the segment number, and subsequently increments the current
   // segment number.
+  // Once Init() succeeded, this may be called concurrently for different
+  // segments (e.g. by DecryptingRandomAccessStream).
   virtual util::Status DecryptSegment(
       const std::vector<uint8_t>& ciphertext,
       int64_t segment_number,
       bool is_last_segment,
       std::vector<uint8_t>* plaintext_buffer) = 0;
 
+  // Like DecryptSegment(), but writes the plaintext to the beginning of
+  // 'plaintext_buffer' and returns its size, so that callers can decrypt
+  // from and to memory they do not hold in vectors. 'plaintext_buffer' must
+  // have room for ciphertext.size() minus the segment overhead, i.e.
+  // get_ciphertext_segment_size() - get_plaintext_segment_size() bytes.
+  // The default implementation returns UNIMPLEMENTED.
+  virtual util::StatusOr<int> DecryptSegmentInto(
+      absl::Span<const uint8_t> ciphertext,
+      int64_t segment_number,
+      bool is_last_segment,
+      absl::Span<uint8_t> plaintext_buffer) {
+    return util::Status(util::error::UNIMPLEMENTED,
+                        "DecryptSegmentInto is not supported.");
+  }
+
   // Initializes this decrypter, using the information from 'header',
   // which must be of size exactly get_header_size().
   virtual util::Status Init(const std::vector<uint8_t>& header) = 0;
@@ -20,7 +20,9 @@
 #include <cstdint>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "tink/util/status.h"
+#include "tink/util/statusor.h"
 
 namespace crypto {
 namespace tink {
@@ -76,6 +78,37 @@ class StreamSegmentEncrypter {
       bool is_last_segment,
       std::vector<uint8_t>* ciphertext_buffer) = 0;
 
+  // Encrypts 'plaintext' as the segment with number 'segment_number',
+  // like EncryptSegment(), but without using or changing the current
+  // segment number. Implementations that override this method must allow
+  // concurrent calls, so that several segments of one stream can be
+  // encrypted in parallel; callers are responsible for never using the same
+  // segment number twice. The default implementation returns UNIMPLEMENTED.
+  virtual util::Status EncryptSegmentAt(
+      const std::vector<uint8_t>& plaintext,
+      int64_t segment_number,
+      bool is_last_segment,
+      std::vector<uint8_t>* ciphertext_buffer) const {
+    return util::Status(util::error::UNIMPLEMENTED,
+                        "EncryptSegmentAt is not supported.");
+  }
+
+  // Like EncryptSegment(), but writes the ciphertext to the beginning of
+  // 'ciphertext_buffer' and returns its size, so that callers can encrypt
+  // from and to memory they do not hold in vectors, e.g. directly into the
+  // buffer of an output stream. 'ciphertext_buffer' must have room for
+  // plaintext.size() plus the segment overhead, i.e.
+  // get_ciphertext_segment_size() - get_plaintext_segment_size() bytes.
+  // The default implementation returns UNIMPLEMENTED and does not change
+  // the segment number.
+  virtual util::StatusOr<int> EncryptSegmentInto(
+      absl::Span<const uint8_t> plaintext,
+      bool is_last_segment,
+      absl::Span<uint8_t> ciphertext_buffer) {
+    return util::Status(util::error::UNIMPLEMENTED,
+                        "EncryptSegmentInto is not supported.");
+  }
+
   // Returns the header of the ciphertext stream.
   virtual const std::vector<uint8_t>& get_header() const = 0;
 
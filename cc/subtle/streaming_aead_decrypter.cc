@@ -0,0 +1,132 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/streaming_aead_decrypter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "tink/subtle/stream_segment_decrypter.h"
+#include "tink/util/buffer_pool.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+using crypto::tink::util::Status;
+using crypto::tink::util::StatusOr;
+
+// static
+StatusOr<std::unique_ptr<StreamingAeadDecrypter>> StreamingAeadDecrypter::New(
+    std::unique_ptr<StreamSegmentDecrypter> segment_decrypter) {
+  if (segment_decrypter == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "segment_decrypter must be non-null");
+  }
+  int first_segment_size = segment_decrypter->get_ciphertext_segment_size() -
+                           segment_decrypter->get_ciphertext_offset() -
+                           segment_decrypter->get_header_size();
+  if (first_segment_size <= 0) {
+    return Status(util::error::INTERNAL,
+                  "Size of the first segment must be greater than 0.");
+  }
+  return {absl::WrapUnique(
+      new StreamingAeadDecrypter(std::move(segment_decrypter)))};
+}
+
+StreamingAeadDecrypter::StreamingAeadDecrypter(
+    std::unique_ptr<StreamSegmentDecrypter> segment_decrypter)
+    : segment_decrypter_(std::move(segment_decrypter)),
+      buffer_pool_(util::BufferPool::Global()),
+      segment_size_(segment_decrypter_->get_header_size()),
+      segment_number_(0),
+      is_initialized_(false) {
+  ct_buffer_ = buffer_pool_->Acquire(
+      segment_decrypter_->get_ciphertext_segment_size());
+  ct_buffer_.resize(0);
+  pt_buffer_ = buffer_pool_->Acquire(
+      segment_decrypter_->get_plaintext_segment_size());
+}
+
+StreamingAeadDecrypter::~StreamingAeadDecrypter() {
+  buffer_pool_->Release(std::move(ct_buffer_));
+  buffer_pool_->Release(std::move(pt_buffer_));
+}
+
+Status StreamingAeadDecrypter::DecryptSegment(bool is_last_segment,
+                                              std::string* plaintext) {
+  Status status = segment_decrypter_->DecryptSegment(
+      ct_buffer_, segment_number_, is_last_segment, &pt_buffer_);
+  if (!status.ok()) return status;
+  plaintext->append(reinterpret_cast<const char*>(pt_buffer_.data()),
+                    pt_buffer_.size());
+  ct_buffer_.resize(0);
+  segment_number_++;
+  segment_size_ = segment_decrypter_->get_ciphertext_segment_size();
+  return Status::OK;
+}
+
+Status StreamingAeadDecrypter::Update(absl::string_view ciphertext,
+                                      std::string* plaintext) {
+  if (!status_.ok()) return status_;
+  while (!ciphertext.empty()) {
+    size_t count =
+        std::min(segment_size_ - ct_buffer_.size(), ciphertext.size());
+    ct_buffer_.insert(ct_buffer_.end(), ciphertext.begin(),
+                      ciphertext.begin() + count);
+    ciphertext.remove_prefix(count);
+    if (ct_buffer_.size() < segment_size_) break;
+    if (!is_initialized_) {
+      status_ = segment_decrypter_->Init(ct_buffer_);
+      if (!status_.ok()) return status_;
+      is_initialized_ = true;
+      ct_buffer_.resize(0);
+      segment_size_ = segment_decrypter_->get_ciphertext_segment_size() -
+                      segment_decrypter_->get_ciphertext_offset() -
+                      segment_decrypter_->get_header_size();
+    } else if (!ciphertext.empty()) {
+      // A full segment is not the last one if more ciphertext follows.
+      status_ = DecryptSegment(/* is_last_segment = */ false, plaintext);
+      if (!status_.ok()) return status_;
+    }
+  }
+  return Status::OK;
+}
+
+Status StreamingAeadDecrypter::Finalize(std::string* plaintext) {
+  if (!status_.ok()) return status_;
+  if (!is_initialized_) {
+    status_ = Status(util::error::INVALID_ARGUMENT,
+                     "Could not read stream header.");
+    return status_;
+  }
+  status_ = DecryptSegment(/* is_last_segment = */ true, plaintext);
+  if (!status_.ok()) return status_;
+  status_ = Status(util::error::FAILED_PRECONDITION, "Decrypter finalized");
+  return Status::OK;
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
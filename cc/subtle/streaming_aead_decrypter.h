@@ -0,0 +1,90 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SUBTLE_STREAMING_AEAD_DECRYPTER_H_
+#define TINK_SUBTLE_STREAMING_AEAD_DECRYPTER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tink/subtle/stream_segment_decrypter.h"
+#include "tink/util/buffer_pool.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// Decrypts a ciphertext stream without doing any I/O: the ciphertext is
+// passed in with Update() in pieces of any size, e.g. as it arrives from a
+// non-blocking socket, and the plaintext of every segment that has been
+// authenticated is handed back to the caller. This is the counterpart of
+// StreamingAeadEncrypter, and decrypts the same ciphertexts as
+// StreamingAeadDecryptingStream with the same segment decrypter.
+//
+// A segment is decrypted once it is complete and more ciphertext follows,
+// and the last segment is decrypted by Finalize(). As with the decrypting
+// streams, plaintext is released segment by segment, and a truncated
+// ciphertext is only detected by Finalize().
+class StreamingAeadDecrypter {
+ public:
+  // The segment buffers are taken from util::BufferPool::Global().
+  static crypto::tink::util::StatusOr<std::unique_ptr<StreamingAeadDecrypter>>
+  New(std::unique_ptr<StreamSegmentDecrypter> segment_decrypter);
+
+  StreamingAeadDecrypter(const StreamingAeadDecrypter&) = delete;
+  StreamingAeadDecrypter& operator=(const StreamingAeadDecrypter&) = delete;
+
+  ~StreamingAeadDecrypter();
+
+  // Takes 'ciphertext' as the continuation of the stream, and appends the
+  // plaintext of the segments it completes to 'plaintext'. After a failure,
+  // the decrypter cannot be used anymore.
+  crypto::tink::util::Status Update(absl::string_view ciphertext,
+                                    std::string* plaintext);
+
+  // Decrypts the last segment and appends its plaintext to 'plaintext'.
+  // Fails if the ciphertext passed to Update() is not a complete ciphertext
+  // stream. Afterwards the decrypter cannot be used anymore.
+  crypto::tink::util::Status Finalize(std::string* plaintext);
+
+ private:
+  explicit StreamingAeadDecrypter(
+      std::unique_ptr<StreamSegmentDecrypter> segment_decrypter);
+
+  // Decrypts ct_buffer_ as the next segment and appends it to 'plaintext'.
+  crypto::tink::util::Status DecryptSegment(bool is_last_segment,
+                                            std::string* plaintext);
+
+  std::unique_ptr<StreamSegmentDecrypter> segment_decrypter_;
+  util::BufferPool* buffer_pool_;  // source of the buffers below
+  std::vector<uint8_t> ct_buffer_;  // header or ciphertext of a segment
+  std::vector<uint8_t> pt_buffer_;  // plaintext of the current segment
+  size_t segment_size_;  // expected size of the data in ct_buffer_
+  int64_t segment_number_;
+  bool is_initialized_;  // whether the header was read
+  crypto::tink::util::Status status_;  // status of the decrypter
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_STREAMING_AEAD_DECRYPTER_H_
@@ -0,0 +1,146 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/streaming_aead_decrypter.h"
+
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+using crypto::tink::subtle::test::DummyStreamSegmentDecrypter;
+using crypto::tink::subtle::test::DummyStreamSegmentEncrypter;
+using crypto::tink::test::IsOk;
+using crypto::tink::test::StatusIs;
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+std::unique_ptr<StreamingAeadDecrypter> GetDecrypter(int pt_segment_size,
+                                                     int header_size,
+                                                     int ct_offset) {
+  auto decrypter_result = StreamingAeadDecrypter::New(
+      absl::make_unique<DummyStreamSegmentDecrypter>(pt_segment_size,
+                                                     header_size, ct_offset));
+  EXPECT_THAT(decrypter_result.status(), IsOk());
+  return std::move(decrypter_result.ValueOrDie());
+}
+
+// Passes 'ciphertext' to Update() in pieces of 'chunk_size', and returns
+// the status of Finalize().
+util::Status Decrypt(StreamingAeadDecrypter* decrypter,
+                     absl::string_view ciphertext, int chunk_size,
+                     std::string* plaintext) {
+  for (size_t pos = 0; pos < ciphertext.size(); pos += chunk_size) {
+    auto status = decrypter->Update(ciphertext.substr(pos, chunk_size),
+                                    plaintext);
+    if (!status.ok()) return status;
+  }
+  return decrypter->Finalize(plaintext);
+}
+
+TEST(StreamingAeadDecrypterTest, DecryptsSegmentEncrypterOutput) {
+  for (int pt_size : {0, 1, 10, 100, 1000, 10000}) {
+    for (int pt_segment_size : {64, 100, 128, 1000, 1024}) {
+      for (int header_size : {5, 10, 32}) {
+        for (int ct_offset : {0, 1, 5, 15}) {
+          for (int chunk_size : {1, 7, 64, 1000, 100000}) {
+            SCOPED_TRACE(absl::StrCat(
+                "pt_size = ", pt_size, ", pt_segment_size = ", pt_segment_size,
+                ", header_size = ", header_size, ", ct_offset = ", ct_offset,
+                ", chunk_size = ", chunk_size));
+            DummyStreamSegmentEncrypter seg_enc(pt_segment_size, header_size,
+                                                ct_offset);
+            std::string pt = Random::GetRandomBytes(pt_size);
+            std::string ct = seg_enc.GenerateCiphertext(pt);
+            auto decrypter = GetDecrypter(pt_segment_size, header_size,
+                                          ct_offset);
+            std::string decrypted;
+            EXPECT_THAT(Decrypt(decrypter.get(), ct, chunk_size, &decrypted),
+                        IsOk());
+            EXPECT_EQ(pt, decrypted);
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(StreamingAeadDecrypterTest, TruncatedCiphertext) {
+  int pt_segment_size = 100;
+  int header_size = 10;
+  int ct_offset = 5;
+  DummyStreamSegmentEncrypter seg_enc(pt_segment_size, header_size,
+                                      ct_offset);
+  std::string ct = seg_enc.GenerateCiphertext(Random::GetRandomBytes(1000));
+  int ct_segment_size = seg_enc.get_ciphertext_segment_size();
+  int first_segment_size = ct_segment_size - ct_offset;
+  // Cut within a segment, and exactly at the end of the first and second
+  // segment: the last segment marker is missing in all cases.
+  for (int size : {first_segment_size + 17, first_segment_size,
+                   first_segment_size + ct_segment_size,
+                   static_cast<int>(ct.size()) - 1}) {
+    SCOPED_TRACE(absl::StrCat("size = ", size));
+    auto decrypter = GetDecrypter(pt_segment_size, header_size, ct_offset);
+    std::string decrypted;
+    EXPECT_THAT(Decrypt(decrypter.get(), ct.substr(0, size), 64, &decrypted),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+}
+
+TEST(StreamingAeadDecrypterTest, MissingHeader) {
+  int header_size = 10;
+  for (int size : {0, 1, header_size - 1}) {
+    SCOPED_TRACE(absl::StrCat("size = ", size));
+    auto decrypter = GetDecrypter(100, header_size, 0);
+    std::string decrypted;
+    EXPECT_THAT(decrypter->Update(std::string(size, 'h'), &decrypted),
+                IsOk());
+    EXPECT_THAT(decrypter->Finalize(&decrypted),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+}
+
+TEST(StreamingAeadDecrypterTest, UseAfterFinalize) {
+  DummyStreamSegmentEncrypter seg_enc(100, 10, 0);
+  std::string ct = seg_enc.GenerateCiphertext("some plaintext");
+  auto decrypter = GetDecrypter(100, 10, 0);
+  std::string decrypted;
+  EXPECT_THAT(Decrypt(decrypter.get(), ct, 1000, &decrypted), IsOk());
+  EXPECT_THAT(decrypter->Update(ct, &decrypted),
+              StatusIs(util::error::FAILED_PRECONDITION));
+  EXPECT_THAT(decrypter->Finalize(&decrypted),
+              StatusIs(util::error::FAILED_PRECONDITION));
+}
+
+TEST(StreamingAeadDecrypterTest, NullSegmentDecrypter) {
+  EXPECT_THAT(StreamingAeadDecrypter::New(nullptr).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
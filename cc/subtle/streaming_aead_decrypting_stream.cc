@@ -18,10 +18,17 @@
 
 #include <algorithm>
 #include <cstring>
+#include <deque>
+#include <memory>
+#include <utility>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
 #include "tink/input_stream.h"
 #include "tink/subtle/stream_segment_decrypter.h"
+#include "tink/util/buffer_pool.h"
+#include "tink/util/executor.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 
@@ -75,10 +82,237 @@ util::Status ReadFromStream(InputStream* input_stream, int count,
 
 }  // anonymous namespace
 
+// Reads the ciphertext stream and decrypts it segment by segment.
+// Not thread-safe.
+class StreamingAeadDecryptingStream::SegmentReader {
+ public:
+  SegmentReader(std::unique_ptr<StreamSegmentDecrypter> segment_decrypter,
+                std::unique_ptr<InputStream> ct_source,
+                util::BufferPool* buffer_pool)
+      : segment_decrypter_(std::move(segment_decrypter)),
+        ct_source_(std::move(ct_source)),
+        buffer_pool_(buffer_pool),
+        ct_buffer_(buffer_pool_->Acquire(
+            segment_decrypter_->get_ciphertext_segment_size())),
+        segment_number_(0),
+        is_initialized_(false),
+        read_last_segment_(false) {}
+
+  ~SegmentReader() { buffer_pool_->Release(std::move(ct_buffer_)); }
+
+  int plaintext_segment_size() const {
+    return segment_decrypter_->get_plaintext_segment_size();
+  }
+
+  // Decrypts the next segment into 'pt_buffer', reading and processing the
+  // header of the ciphertext stream first if this is the first segment.
+  // Returns OUT_OF_RANGE once the last segment has been read.
+  Status ReadSegment(std::vector<uint8_t>* pt_buffer);
+
+ private:
+  std::unique_ptr<StreamSegmentDecrypter> segment_decrypter_;
+  std::unique_ptr<InputStream> ct_source_;
+  util::BufferPool* buffer_pool_;  // source of ct_buffer_
+  std::vector<uint8_t> ct_buffer_;  // ciphertext buffer
+  int64_t segment_number_;  // number of the next segment
+  // If true, the header of the ciphertext stream has been already read
+  // and processed.
+  bool is_initialized_;
+  bool read_last_segment_;
+};
+
+Status StreamingAeadDecryptingStream::SegmentReader::ReadSegment(
+    std::vector<uint8_t>* pt_buffer) {
+  if (read_last_segment_) {
+    return Status(util::error::OUT_OF_RANGE, "Reached end of stream.");
+  }
+  int ct_segment_size = segment_decrypter_->get_ciphertext_segment_size();
+  if (!is_initialized_) {
+    std::vector<uint8_t> header;
+    Status status = ReadFromStream(
+        ct_source_.get(), segment_decrypter_->get_header_size(), &header);
+    if (status.error_code() == util::error::OUT_OF_RANGE) {
+      return Status(util::error::INVALID_ARGUMENT,
+                    "Could not read stream header.");
+    }
+    if (!status.ok()) return status;
+    status = segment_decrypter_->Init(header);
+    if (!status.ok()) return status;
+    is_initialized_ = true;
+    // The first segment is shorter by the header and the ciphertext offset.
+    ct_segment_size -= segment_decrypter_->get_ciphertext_offset() +
+                       segment_decrypter_->get_header_size();
+  }
+  Status status = ReadFromStream(ct_source_.get(), ct_segment_size,
+                                 &ct_buffer_);
+  if (!status.ok() && (status.error_code() != util::error::OUT_OF_RANGE)) {
+    return status;
+  }
+  read_last_segment_ = (status.error_code() == util::error::OUT_OF_RANGE);
+  status = segment_decrypter_->DecryptSegment(
+      ct_buffer_,
+      /* segment_number = */ segment_number_,
+      /* is_last_segment = */ read_last_segment_,
+      pt_buffer);
+  if (!status.ok() && !read_last_segment_) {
+    // Try decrypting as the last segment, if haven't tried yet.
+    read_last_segment_ = true;
+    status = segment_decrypter_->DecryptSegment(
+        ct_buffer_,
+        /* segment_number = */ segment_number_,
+        /* is_last_segment = */ read_last_segment_,
+        pt_buffer);
+  }
+  if (!status.ok()) return status;
+  segment_number_++;
+  return Status::OK;
+}
+
+// Keeps up to 'max_segments' decrypted segments ahead of the consumer,
+// filled by a task scheduled on an executor. At most one thread uses the
+// SegmentReader at a time. The consumer waits only for a read that has
+// already started, never for a task that has merely been scheduled.
+class StreamingAeadDecryptingStream::ReadAhead
+    : public std::enable_shared_from_this<ReadAhead> {
+ public:
+  ReadAhead(std::unique_ptr<SegmentReader> segment_reader, int max_segments,
+            util::Executor* executor, util::BufferPool* buffer_pool)
+      : segment_reader_(std::move(segment_reader)),
+        max_segments_(max_segments),
+        executor_(executor),
+        buffer_pool_(buffer_pool) {}
+
+  // Moves the next segment into 'pt_buffer', reading it on the calling
+  // thread if no task is reading it already. Returns the status of the
+  // SegmentReader once all segments read ahead have been consumed.
+  Status ReadSegment(std::vector<uint8_t>* pt_buffer);
+
+  // Waits for a running read to finish, then makes all tasks return without
+  // reading and releases the buffers and the SegmentReader.
+  void Close();
+
+ private:
+  // Reads segments until max_segments_ are ready. Runs as a task.
+  void Fill();
+
+  // Returns true if a task that fills up the segments should be scheduled,
+  // and marks it scheduled.
+  bool ShouldScheduleFill() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  void ScheduleFill();
+
+  std::unique_ptr<SegmentReader> segment_reader_;
+  const int max_segments_;
+  util::Executor* const executor_;
+  util::BufferPool* const buffer_pool_;
+
+  absl::Mutex mutex_;
+  std::deque<std::vector<uint8_t>> ready_segments_ ABSL_GUARDED_BY(mutex_);
+  // The status of the SegmentReader after the segments in ready_segments_.
+  Status status_ ABSL_GUARDED_BY(mutex_);
+  // True while a thread reads from segment_reader_.
+  bool reading_ ABSL_GUARDED_BY(mutex_) = false;
+  bool fill_scheduled_ ABSL_GUARDED_BY(mutex_) = false;
+  bool closed_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+Status StreamingAeadDecryptingStream::ReadAhead::ReadSegment(
+    std::vector<uint8_t>* pt_buffer) {
+  mutex_.Lock();
+  mutex_.Await(absl::Condition(
+      +[](ReadAhead* read_ahead) ABSL_EXCLUSIVE_LOCKS_REQUIRED(
+           read_ahead->mutex_) {
+        return !read_ahead->reading_ || !read_ahead->ready_segments_.empty();
+      },
+      this));
+  Status status = status_;
+  if (!ready_segments_.empty()) {
+    std::swap(*pt_buffer, ready_segments_.front());
+    buffer_pool_->Release(std::move(ready_segments_.front()));
+    ready_segments_.pop_front();
+    status = Status::OK;
+  } else if (status_.ok()) {
+    // No task is reading, so read the segment on this thread.
+    reading_ = true;
+    mutex_.Unlock();
+    status = segment_reader_->ReadSegment(pt_buffer);
+    mutex_.Lock();
+    reading_ = false;
+    status_ = status;
+  }
+  bool schedule_fill = ShouldScheduleFill();
+  mutex_.Unlock();
+  if (schedule_fill) ScheduleFill();
+  return status;
+}
+
+void StreamingAeadDecryptingStream::ReadAhead::Close() {
+  absl::MutexLock lock(&mutex_);
+  closed_ = true;
+  mutex_.Await(absl::Condition(
+      +[](ReadAhead* read_ahead) ABSL_EXCLUSIVE_LOCKS_REQUIRED(
+           read_ahead->mutex_) { return !read_ahead->reading_; },
+      this));
+  for (auto& segment : ready_segments_) {
+    buffer_pool_->Release(std::move(segment));
+  }
+  ready_segments_.clear();
+  segment_reader_.reset();
+}
+
+void StreamingAeadDecryptingStream::ReadAhead::Fill() {
+  mutex_.Lock();
+  while (!closed_ && !reading_ && status_.ok() &&
+         ready_segments_.size() < static_cast<size_t>(max_segments_)) {
+    reading_ = true;
+    std::vector<uint8_t> segment =
+        buffer_pool_->Acquire(segment_reader_->plaintext_segment_size());
+    mutex_.Unlock();
+    Status status = segment_reader_->ReadSegment(&segment);
+    mutex_.Lock();
+    reading_ = false;
+    status_ = status;
+    if (status.ok()) {
+      ready_segments_.push_back(std::move(segment));
+    } else {
+      buffer_pool_->Release(std::move(segment));
+    }
+  }
+  fill_scheduled_ = false;
+  mutex_.Unlock();
+}
+
+bool StreamingAeadDecryptingStream::ReadAhead::ShouldScheduleFill() {
+  if (fill_scheduled_ || closed_ || reading_ || !status_.ok() ||
+      ready_segments_.size() >= static_cast<size_t>(max_segments_)) {
+    return false;
+  }
+  fill_scheduled_ = true;
+  return true;
+}
+
+void StreamingAeadDecryptingStream::ReadAhead::ScheduleFill() {
+  // The task keeps this object alive, as it may run after the stream is gone.
+  std::shared_ptr<ReadAhead> self = shared_from_this();
+  executor_->Schedule([self] { self->Fill(); });
+}
+
+StreamingAeadDecryptingStream::StreamingAeadDecryptingStream()
+    : buffer_pool_(util::BufferPool::Global()) {}
+
 // static
 StatusOr<std::unique_ptr<InputStream>> StreamingAeadDecryptingStream::New(
     std::unique_ptr<StreamSegmentDecrypter> segment_decrypter,
     std::unique_ptr<InputStream> ciphertext_source) {
+  return New(std::move(segment_decrypter), std::move(ciphertext_source),
+             /* read_ahead_segments = */ 0);
+}
+
+// static
+StatusOr<std::unique_ptr<InputStream>> StreamingAeadDecryptingStream::New(
+    std::unique_ptr<StreamSegmentDecrypter> segment_decrypter,
+    std::unique_ptr<InputStream> ciphertext_source, int read_ahead_segments,
+    util::Executor* executor) {
   if (segment_decrypter == nullptr) {
     return Status(util::error::INVALID_ARGUMENT,
                   "segment_decrypter must be non-null");
@@ -87,71 +321,50 @@ StatusOr<std::unique_ptr<InputStream>> StreamingAeadDecryptingStream::New(
     return Status(util::error::INVALID_ARGUMENT,
                   "cipertext_source must be non-null");
   }
-  std::unique_ptr<StreamingAeadDecryptingStream> dec_stream(
-      new StreamingAeadDecryptingStream());
-  dec_stream->segment_decrypter_ = std::move(segment_decrypter);
-  dec_stream->ct_source_ = std::move(ciphertext_source);
+  if (read_ahead_segments < 0) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "read_ahead_segments must be non-negative");
+  }
   int first_segment_size =
-      dec_stream->segment_decrypter_->get_ciphertext_segment_size() -
-      dec_stream->segment_decrypter_->get_ciphertext_offset() -
-      dec_stream->segment_decrypter_->get_header_size();
+      segment_decrypter->get_ciphertext_segment_size() -
+      segment_decrypter->get_ciphertext_offset() -
+      segment_decrypter->get_header_size();
   if (first_segment_size <= 0) {
     return Status(util::error::INTERNAL,
                   "Size of the first segment must be greater than 0.");
   }
-  dec_stream->ct_buffer_.resize(first_segment_size);
+  std::unique_ptr<StreamingAeadDecryptingStream> dec_stream(
+      new StreamingAeadDecryptingStream());
+  auto segment_reader = absl::make_unique<SegmentReader>(
+      std::move(segment_decrypter), std::move(ciphertext_source),
+      dec_stream->buffer_pool_);
+  dec_stream->pt_buffer_ = dec_stream->buffer_pool_->Acquire(
+      segment_reader->plaintext_segment_size());
+  dec_stream->pt_buffer_.resize(0);
+  if (read_ahead_segments == 0) {
+    dec_stream->segment_reader_ = std::move(segment_reader);
+  } else {
+    if (executor == nullptr) executor = util::Executor::Global();
+    dec_stream->read_ahead_ = std::make_shared<ReadAhead>(
+        std::move(segment_reader), read_ahead_segments, executor,
+        dec_stream->buffer_pool_);
+  }
   dec_stream->position_ = 0;
-  dec_stream->segment_number_ = 0;
   dec_stream->is_initialized_ = false;
-  dec_stream->read_last_segment_ = false;
-  dec_stream->count_backedup_ = first_segment_size;
+  dec_stream->count_backedup_ = 0;
   dec_stream->pt_buffer_offset_ = 0;
   dec_stream->status_ = Status::OK;
   return {std::move(dec_stream)};
 }
 
+StreamingAeadDecryptingStream::~StreamingAeadDecryptingStream() {
+  if (read_ahead_ != nullptr) read_ahead_->Close();
+  buffer_pool_->Release(std::move(pt_buffer_));
+}
+
 StatusOr<int> StreamingAeadDecryptingStream::Next(const void** data) {
   if (!status_.ok()) return status_;
 
-  // The first call to Next().
-  if (!is_initialized_) {
-    std::vector<uint8_t> header;
-    status_ = ReadFromStream(ct_source_.get(),
-                             segment_decrypter_->get_header_size(), &header);
-    if (status_.error_code() == util::error::OUT_OF_RANGE) {
-      status_ = Status(util::error::INVALID_ARGUMENT,
-                       "Could not read stream header.");
-    }
-    if (!status_.ok()) return status_;
-    status_ = segment_decrypter_->Init(header);
-    if (!status_.ok()) return status_;
-    is_initialized_ = true;
-    count_backedup_ = 0;
-    status_ = ReadFromStream(ct_source_.get(), ct_buffer_.size(), &ct_buffer_);
-    if (!status_.ok() && (status_.error_code() != util::error::OUT_OF_RANGE)) {
-      return status_;
-    }
-    read_last_segment_ = (status_.error_code() == util::error::OUT_OF_RANGE);
-    status_ = segment_decrypter_->DecryptSegment(
-        ct_buffer_,
-        /* segment_number = */ segment_number_,
-        /* is_last_segment = */ read_last_segment_,
-        &pt_buffer_);
-    if (!status_.ok() && !read_last_segment_) {
-      // Try decrypting as the last segment, if haven't tried yet.
-      read_last_segment_ = true;
-      status_ = segment_decrypter_->DecryptSegment(
-          ct_buffer_,
-          /* segment_number = */ segment_number_,
-          /* is_last_segment = */ read_last_segment_,
-          &pt_buffer_);
-    }
-    if (!status_.ok()) return status_;
-    *data = pt_buffer_.data();
-    position_ = pt_buffer_.size();
-    return pt_buffer_.size();
-  }
-
   // If some bytes were backed up, return them first.
   if (count_backedup_ > 0) {
     position_ += count_backedup_;
@@ -162,34 +375,15 @@ StatusOr<int> StreamingAeadDecryptingStream::Next(const void** data) {
     return backedup;
   }
 
-  // We're past the first segment, and no space was backed up, so we
-  // try to get and decrypt the next ciphertext segment, if any.
-  if (read_last_segment_) {
-    status_ = Status(util::error::OUT_OF_RANGE, "Reached end of stream.");
-    return status_;
-  }
-  segment_number_++;
-  ct_buffer_.resize(segment_decrypter_->get_ciphertext_segment_size());
-  status_ = ReadFromStream(ct_source_.get(), ct_buffer_.size(), &ct_buffer_);
-  if (!status_.ok() && (status_.error_code() != util::error::OUT_OF_RANGE)) {
-    return status_;
-  }
-  read_last_segment_ = (status_.error_code() == util::error::OUT_OF_RANGE);
-  status_ = segment_decrypter_->DecryptSegment(
-      ct_buffer_,
-      /* segment_number = */ segment_number_,
-      /* is_last_segment = */ read_last_segment_,
-      &pt_buffer_);
-  if (!status_.ok() && !read_last_segment_) {
-    // Try decrypting as the last segment, if haven't tried yet.
-    read_last_segment_ = true;
-    status_ = segment_decrypter_->DecryptSegment(
-        ct_buffer_,
-        /* segment_number = */ segment_number_,
-        /* is_last_segment = */ read_last_segment_,
-        &pt_buffer_);
+  // No space was backed up, so we get and decrypt the next ciphertext
+  // segment, if any.
+  if (read_ahead_ == nullptr) {
+    status_ = segment_reader_->ReadSegment(&pt_buffer_);
+  } else {
+    status_ = read_ahead_->ReadSegment(&pt_buffer_);
   }
   if (!status_.ok()) return status_;
+  is_initialized_ = true;
   *data = pt_buffer_.data();
   pt_buffer_offset_ = 0;
   position_ += pt_buffer_.size();
@@ -22,6 +22,8 @@
 
 #include "tink/input_stream.h"
 #include "tink/subtle/stream_segment_decrypter.h"
+#include "tink/util/buffer_pool.h"
+#include "tink/util/executor.h"
 #include "tink/util/statusor.h"
 
 namespace crypto {
@@ -36,36 +38,54 @@ class StreamingAeadDecryptingStream : public InputStream {
   // underlying ciphertext by 'segment_decrypter', using 'associated_data' as
   // associated authenticated data, and the read bytes are bytes of the
   // resulting plaintext.
+  // The segment buffers are taken from util::BufferPool::Global().
   static
   crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::InputStream>>
       New(std::unique_ptr<StreamSegmentDecrypter> segment_decrypter,
           std::unique_ptr<crypto::tink::InputStream> ciphertext_source);
 
+  // Like New() above, but while the caller consumes a segment, up to
+  // 'read_ahead_segments' following segments are read from
+  // 'ciphertext_source' and decrypted in a task scheduled on 'executor',
+  // or on util::Executor::Global() if 'executor' is null. At most
+  // read_ahead_segments + 1 plaintext segments are buffered at any time.
+  // If no task has started reading ahead when the caller needs the next
+  // segment, the caller reads it itself, so the stream makes progress even
+  // if the executor is busy. 'ciphertext_source' is then read from the
+  // executor's threads, and is destroyed with the returned stream.
+  static
+  crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::InputStream>>
+      New(std::unique_ptr<StreamSegmentDecrypter> segment_decrypter,
+          std::unique_ptr<crypto::tink::InputStream> ciphertext_source,
+          int read_ahead_segments, util::Executor* executor = nullptr);
+
   // -----------------------
   // Methods of InputStream-interface implemented by this class.
   crypto::tink::util::StatusOr<int> Next(const void** data) override;
   void BackUp(int count) override;
   int64_t Position() const override;
 
+  ~StreamingAeadDecryptingStream() override;
+
  private:
-  StreamingAeadDecryptingStream() {}
-  std::unique_ptr<StreamSegmentDecrypter> segment_decrypter_;
-  std::unique_ptr<crypto::tink::InputStream> ct_source_;
-  std::vector<uint8_t> ct_buffer_;  // ciphertext buffer
+  class SegmentReader;
+  class ReadAhead;
+
+  StreamingAeadDecryptingStream();
+  // Reads and decrypts the segments; null if 'read_ahead_' is used instead.
+  std::unique_ptr<SegmentReader> segment_reader_;
+  std::shared_ptr<ReadAhead> read_ahead_;
+  util::BufferPool* buffer_pool_;  // source of the buffer below
   std::vector<uint8_t> pt_buffer_;  // plaintext buffer
   int64_t position_;  // number of plaintext bytes read from this stream
-  int64_t segment_number_;  // current segment number
   crypto::tink::util::Status status_;  // status of the stream
 
   // Counters that describe the state of the data in pt_buffer_.
   int count_backedup_;    // # bytes in pt_buffer_ that were backed up
   int pt_buffer_offset_;  // offset at which *data starts in pt_buffer_
 
-  // Flag that indicates whether the decrypting stream has been initialized.
-  // If true, the header of the ciphertext stream has been already read
-  // and processed.
+  // Flag that indicates whether the first segment has been returned.
   bool is_initialized_;
-  bool read_last_segment_;
 };
 
 }  // namespace subtle
@@ -27,6 +27,7 @@
 #include "tink/subtle/stream_segment_decrypter.h"
 #include "tink/subtle/random.h"
 #include "tink/subtle/test_util.h"
+#include "tink/util/executor.h"
 #include "tink/util/istream_input_stream.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
@@ -67,6 +68,25 @@ std::unique_ptr<InputStream> GetDecryptingStream(
   return dec_stream;
 }
 
+// Like GetDecryptingStream(), but reading up to 'read_ahead_segments'
+// segments ahead on 'executor'.
+std::unique_ptr<InputStream> GetReadAheadDecryptingStream(
+    int pt_segment_size, int header_size, int ct_offset,
+    absl::string_view ciphertext, int read_ahead_segments,
+    util::Executor* executor) {
+  auto ct_stream =
+      absl::make_unique<std::stringstream>(std::string(ciphertext));
+  std::unique_ptr<InputStream> ct_source(
+      absl::make_unique<IstreamInputStream>(std::move(ct_stream)));
+  auto seg_dec = absl::make_unique<DummyStreamSegmentDecrypter>(
+          pt_segment_size, header_size, ct_offset);
+  auto dec_stream = std::move(StreamingAeadDecryptingStream::New(
+      std::move(seg_dec), std::move(ct_source), read_ahead_segments,
+      executor).ValueOrDie());
+  EXPECT_EQ(0, dec_stream->Position());
+  return dec_stream;
+}
+
 
 class StreamingAeadDecryptingStreamTest : public ::testing::Test {
 };
@@ -406,6 +426,106 @@ TEST_F(StreamingAeadDecryptingStreamTest, BackupAndPosition) {
   EXPECT_EQ(pt, decrypted_first_segment + decrypted_rest);
 }
 
+TEST_F(StreamingAeadDecryptingStreamTest, ReadAhead) {
+  util::ThreadPool pool(2);
+  std::vector<int> pt_sizes = {0, 10, 1000, 100000};
+  std::vector<int> read_ahead_segments = {1, 2, 8};
+  int pt_segment_size = 128;
+  int header_size = 10;
+  int ct_offset = 5;
+  for (auto pt_size : pt_sizes) {
+    for (auto read_ahead : read_ahead_segments) {
+      SCOPED_TRACE(absl::StrCat("pt_size = ", pt_size,
+                                ", read_ahead_segments = ", read_ahead));
+      std::string pt = Random::GetRandomBytes(pt_size);
+      DummyStreamSegmentEncrypter seg_enc(pt_segment_size, header_size,
+                                          ct_offset);
+      std::string ct = seg_enc.GenerateCiphertext(pt);
+      auto dec_stream = GetReadAheadDecryptingStream(
+          pt_segment_size, header_size, ct_offset, ct, read_ahead, &pool);
+
+      // Back up part of the first buffer, then read the rest of the stream.
+      const void* buffer;
+      auto next_result = dec_stream->Next(&buffer);
+      ASSERT_TRUE(next_result.ok()) << next_result.status();
+      int buffer_size = next_result.ValueOrDie();
+      dec_stream->BackUp(buffer_size / 2);
+      std::string decrypted(static_cast<const char*>(buffer),
+                            buffer_size - buffer_size / 2);
+      std::string decrypted_rest;
+      auto status = test::ReadFromStream(dec_stream.get(), &decrypted_rest);
+      EXPECT_TRUE(status.ok()) << status;
+      EXPECT_EQ(pt.size(), dec_stream->Position());
+      EXPECT_EQ(pt, decrypted + decrypted_rest);
+    }
+  }
+}
+
+TEST_F(StreamingAeadDecryptingStreamTest, ReadAheadWithoutRunningTasks) {
+  // The stream does not wait for tasks that never run.
+  util::FunctionExecutor executor([](std::function<void()> task) {});
+  int pt_segment_size = 100;
+  int header_size = 10;
+  std::string pt = Random::GetRandomBytes(1000);
+  DummyStreamSegmentEncrypter seg_enc(pt_segment_size, header_size,
+                                      /* ct_offset = */ 0);
+  std::string ct = seg_enc.GenerateCiphertext(pt);
+  auto dec_stream = GetReadAheadDecryptingStream(
+      pt_segment_size, header_size, /* ct_offset = */ 0, ct,
+      /* read_ahead_segments = */ 4, &executor);
+  std::string decrypted;
+  auto status = test::ReadFromStream(dec_stream.get(), &decrypted);
+  EXPECT_TRUE(status.ok()) << status;
+  EXPECT_EQ(pt, decrypted);
+}
+
+TEST_F(StreamingAeadDecryptingStreamTest, ReadAheadTruncatedLastSegment) {
+  util::ThreadPool pool(1);
+  int pt_segment_size = 120;
+  int header_size = 64;
+  std::string pt = Random::GetRandomBytes(5000);
+  DummyStreamSegmentEncrypter seg_enc(pt_segment_size, header_size,
+      /* ct_offset = */ 0);
+  std::string ct = seg_enc.GenerateCiphertext(pt);
+  auto dec_stream = GetReadAheadDecryptingStream(
+      pt_segment_size, header_size, /* ct_offset = */ 0,
+      ct.substr(0, ct.size() - 2), /* read_ahead_segments = */ 3, &pool);
+  std::string decrypted;
+  auto status = test::ReadFromStream(dec_stream.get(), &decrypted);
+  EXPECT_FALSE(status.ok());
+  EXPECT_EQ(status.error_code(), util::error::INVALID_ARGUMENT);
+  EXPECT_PRED_FORMAT2(testing::IsSubstring, "unexpected last-segment marker",
+                      status.error_message());
+}
+
+TEST_F(StreamingAeadDecryptingStreamTest, ReadAheadDestroyedWhileReading) {
+  util::ThreadPool pool(1);
+  int pt_segment_size = 64;
+  int header_size = 8;
+  std::string pt = Random::GetRandomBytes(100000);
+  DummyStreamSegmentEncrypter seg_enc(pt_segment_size, header_size,
+                                      /* ct_offset = */ 0);
+  std::string ct = seg_enc.GenerateCiphertext(pt);
+  for (int i = 0; i < 10; i++) {
+    auto dec_stream = GetReadAheadDecryptingStream(
+        pt_segment_size, header_size, /* ct_offset = */ 0, ct,
+        /* read_ahead_segments = */ 16, &pool);
+    const void* buffer;
+    EXPECT_TRUE(dec_stream->Next(&buffer).ok());
+  }
+}
+
+TEST_F(StreamingAeadDecryptingStreamTest, NegativeReadAhead) {
+  auto ct_source = absl::make_unique<IstreamInputStream>(
+      absl::make_unique<std::stringstream>(std::string("ciphertext")));
+  auto result = StreamingAeadDecryptingStream::New(
+      absl::make_unique<DummyStreamSegmentDecrypter>(
+          /* pt_segment_size = */ 100, /* header_size = */ 10,
+          /* ct_offset = */ 0),
+      std::move(ct_source), /* read_ahead_segments = */ -1);
+  EXPECT_EQ(util::error::INVALID_ARGUMENT, result.status().error_code());
+}
+
 }  // namespace
 }  // namespace subtle
 }  // namespace tink
@@ -0,0 +1,127 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/streaming_aead_encrypter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tink/subtle/stream_segment_encrypter.h"
+#include "tink/util/buffer_pool.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+using crypto::tink::util::Status;
+using crypto::tink::util::StatusOr;
+
+// static
+StatusOr<std::unique_ptr<StreamingAeadEncrypter>> StreamingAeadEncrypter::New(
+    std::unique_ptr<StreamSegmentEncrypter> segment_encrypter) {
+  if (segment_encrypter == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "segment_encrypter must be non-null");
+  }
+  int first_segment_size = segment_encrypter->get_plaintext_segment_size() -
+                           segment_encrypter->get_ciphertext_offset() -
+                           segment_encrypter->get_header().size();
+  if (first_segment_size <= 0) {
+    return Status(util::error::INTERNAL,
+                  "Size of the first segment must be greater than 0.");
+  }
+  std::unique_ptr<StreamingAeadEncrypter> encrypter(
+      new StreamingAeadEncrypter(std::move(segment_encrypter)));
+  encrypter->segment_size_ = first_segment_size;
+  return {std::move(encrypter)};
+}
+
+StreamingAeadEncrypter::StreamingAeadEncrypter(
+    std::unique_ptr<StreamSegmentEncrypter> segment_encrypter)
+    : segment_encrypter_(std::move(segment_encrypter)),
+      buffer_pool_(util::BufferPool::Global()),
+      segment_size_(0),
+      header_appended_(false) {
+  pt_buffer_ = buffer_pool_->Acquire(
+      segment_encrypter_->get_plaintext_segment_size());
+  pt_buffer_.resize(0);
+  ct_buffer_ = buffer_pool_->Acquire(
+      segment_encrypter_->get_ciphertext_segment_size());
+}
+
+StreamingAeadEncrypter::~StreamingAeadEncrypter() {
+  buffer_pool_->Release(std::move(pt_buffer_));
+  buffer_pool_->Release(std::move(ct_buffer_));
+}
+
+void StreamingAeadEncrypter::AppendHeader(std::string* ciphertext) {
+  if (header_appended_) return;
+  const std::vector<uint8_t>& header = segment_encrypter_->get_header();
+  ciphertext->append(reinterpret_cast<const char*>(header.data()),
+                     header.size());
+  header_appended_ = true;
+}
+
+Status StreamingAeadEncrypter::EncryptSegment(bool is_last_segment,
+                                              std::string* ciphertext) {
+  Status status = segment_encrypter_->EncryptSegment(
+      pt_buffer_, is_last_segment, &ct_buffer_);
+  if (!status.ok()) return status;
+  ciphertext->append(reinterpret_cast<const char*>(ct_buffer_.data()),
+                     ct_buffer_.size());
+  pt_buffer_.resize(0);
+  segment_size_ = segment_encrypter_->get_plaintext_segment_size();
+  return Status::OK;
+}
+
+Status StreamingAeadEncrypter::Update(absl::string_view plaintext,
+                                      std::string* ciphertext) {
+  if (!status_.ok()) return status_;
+  AppendHeader(ciphertext);
+  while (!plaintext.empty()) {
+    // A full segment is encrypted only now that more plaintext follows.
+    if (pt_buffer_.size() == segment_size_) {
+      status_ = EncryptSegment(/* is_last_segment = */ false, ciphertext);
+      if (!status_.ok()) return status_;
+    }
+    size_t count =
+        std::min(segment_size_ - pt_buffer_.size(), plaintext.size());
+    pt_buffer_.insert(pt_buffer_.end(), plaintext.begin(),
+                      plaintext.begin() + count);
+    plaintext.remove_prefix(count);
+  }
+  return Status::OK;
+}
+
+Status StreamingAeadEncrypter::Finalize(std::string* ciphertext) {
+  if (!status_.ok()) return status_;
+  AppendHeader(ciphertext);
+  status_ = EncryptSegment(/* is_last_segment = */ true, ciphertext);
+  if (!status_.ok()) return status_;
+  status_ = Status(util::error::FAILED_PRECONDITION, "Encrypter finalized");
+  return Status::OK;
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
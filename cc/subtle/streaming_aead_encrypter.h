@@ -0,0 +1,91 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SUBTLE_STREAMING_AEAD_ENCRYPTER_H_
+#define TINK_SUBTLE_STREAMING_AEAD_ENCRYPTER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tink/subtle/stream_segment_encrypter.h"
+#include "tink/util/buffer_pool.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// Encrypts a ciphertext stream without doing any I/O: the plaintext is passed
+// in with Update() in pieces of any size, and the ciphertext produced so far
+// is handed back to the caller, who writes it out. This lets applications
+// with non-blocking I/O, e.g. on an event loop or in coroutines, encrypt a
+// stream without dedicating a thread to a blocking OutputStream. The
+// ciphertext is the same as that of StreamingAeadEncryptingStream with the
+// same segment encrypter.
+//
+// A segment is encrypted once it is full and more plaintext follows, so
+// Update() returns ciphertext in whole segments, and Finalize() returns the
+// last segment.
+class StreamingAeadEncrypter {
+ public:
+  // The segment buffers are taken from util::BufferPool::Global().
+  static crypto::tink::util::StatusOr<std::unique_ptr<StreamingAeadEncrypter>>
+  New(std::unique_ptr<StreamSegmentEncrypter> segment_encrypter);
+
+  StreamingAeadEncrypter(const StreamingAeadEncrypter&) = delete;
+  StreamingAeadEncrypter& operator=(const StreamingAeadEncrypter&) = delete;
+
+  ~StreamingAeadEncrypter();
+
+  // Encrypts 'plaintext' as the continuation of the stream, and appends the
+  // ciphertext that is complete to 'ciphertext'. The first call appends the
+  // stream header. After a failure, the encrypter cannot be used anymore.
+  crypto::tink::util::Status Update(absl::string_view plaintext,
+                                    std::string* ciphertext);
+
+  // Encrypts the last segment and appends the remaining ciphertext to
+  // 'ciphertext'. Afterwards the encrypter cannot be used anymore.
+  crypto::tink::util::Status Finalize(std::string* ciphertext);
+
+ private:
+  explicit StreamingAeadEncrypter(
+      std::unique_ptr<StreamSegmentEncrypter> segment_encrypter);
+
+  // Appends the header to 'ciphertext', unless it was appended before.
+  void AppendHeader(std::string* ciphertext);
+
+  // Encrypts pt_buffer_ as the next segment and appends it to 'ciphertext'.
+  crypto::tink::util::Status EncryptSegment(bool is_last_segment,
+                                            std::string* ciphertext);
+
+  std::unique_ptr<StreamSegmentEncrypter> segment_encrypter_;
+  util::BufferPool* buffer_pool_;  // source of the buffers below
+  std::vector<uint8_t> pt_buffer_;  // plaintext of the current segment
+  std::vector<uint8_t> ct_buffer_;  // ciphertext of the current segment
+  size_t segment_size_;  // plaintext size of the current segment
+  bool header_appended_;
+  crypto::tink::util::Status status_;  // status of the encrypter
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_STREAMING_AEAD_ENCRYPTER_H_
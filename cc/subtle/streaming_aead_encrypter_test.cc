@@ -0,0 +1,112 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/streaming_aead_encrypter.h"
+
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+using crypto::tink::subtle::test::DummyStreamSegmentEncrypter;
+using crypto::tink::test::IsOk;
+using crypto::tink::test::StatusIs;
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+// Encrypts 'plaintext' passing it to Update() in pieces of 'chunk_size'.
+std::string Encrypt(StreamingAeadEncrypter* encrypter,
+                    absl::string_view plaintext, int chunk_size) {
+  std::string ciphertext;
+  for (size_t pos = 0; pos < plaintext.size(); pos += chunk_size) {
+    EXPECT_THAT(
+        encrypter->Update(plaintext.substr(pos, chunk_size), &ciphertext),
+        IsOk());
+  }
+  EXPECT_THAT(encrypter->Finalize(&ciphertext), IsOk());
+  return ciphertext;
+}
+
+TEST(StreamingAeadEncrypterTest, MatchesSegmentEncrypter) {
+  for (int pt_size : {0, 1, 10, 100, 1000, 10000}) {
+    for (int pt_segment_size : {64, 100, 128, 1000, 1024}) {
+      for (int header_size : {5, 10, 32}) {
+        for (int ct_offset : {0, 1, 5, 15}) {
+          for (int chunk_size : {1, 7, 64, 1000, 100000}) {
+            SCOPED_TRACE(absl::StrCat(
+                "pt_size = ", pt_size, ", pt_segment_size = ", pt_segment_size,
+                ", header_size = ", header_size, ", ct_offset = ", ct_offset,
+                ", chunk_size = ", chunk_size));
+            DummyStreamSegmentEncrypter expected_enc(pt_segment_size,
+                                                     header_size, ct_offset);
+            auto encrypter_result = StreamingAeadEncrypter::New(
+                absl::make_unique<DummyStreamSegmentEncrypter>(
+                    pt_segment_size, header_size, ct_offset));
+            ASSERT_THAT(encrypter_result.status(), IsOk());
+            std::string pt = Random::GetRandomBytes(pt_size);
+            EXPECT_EQ(expected_enc.GenerateCiphertext(pt),
+                      Encrypt(encrypter_result.ValueOrDie().get(), pt,
+                              chunk_size));
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(StreamingAeadEncrypterTest, HeaderIsReturnedByFirstUpdate) {
+  int header_size = 10;
+  auto encrypter_result = StreamingAeadEncrypter::New(
+      absl::make_unique<DummyStreamSegmentEncrypter>(100, header_size, 0));
+  ASSERT_THAT(encrypter_result.status(), IsOk());
+  auto encrypter = std::move(encrypter_result.ValueOrDie());
+  std::string ciphertext;
+  EXPECT_THAT(encrypter->Update("", &ciphertext), IsOk());
+  EXPECT_EQ(ciphertext, std::string(header_size, 'h'));
+}
+
+TEST(StreamingAeadEncrypterTest, UseAfterFinalize) {
+  auto encrypter_result = StreamingAeadEncrypter::New(
+      absl::make_unique<DummyStreamSegmentEncrypter>(100, 10, 0));
+  ASSERT_THAT(encrypter_result.status(), IsOk());
+  auto encrypter = std::move(encrypter_result.ValueOrDie());
+  std::string ciphertext;
+  EXPECT_THAT(encrypter->Finalize(&ciphertext), IsOk());
+  EXPECT_THAT(encrypter->Update("some plaintext", &ciphertext),
+              StatusIs(util::error::FAILED_PRECONDITION));
+  EXPECT_THAT(encrypter->Finalize(&ciphertext),
+              StatusIs(util::error::FAILED_PRECONDITION));
+}
+
+TEST(StreamingAeadEncrypterTest, NullSegmentEncrypter) {
+  EXPECT_THAT(StreamingAeadEncrypter::New(nullptr).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -18,10 +18,18 @@
 
 #include <algorithm>
 #include <cstring>
+#include <deque>
+#include <memory>
+#include <utility>
 
+#include "absl/base/thread_annotations.h"
 #include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "tink/output_stream.h"
 #include "tink/subtle/stream_segment_encrypter.h"
+#include "tink/util/buffer_pool.h"
+#include "tink/util/executor.h"
 #include "tink/util/statusor.h"
 
 using crypto::tink::OutputStream;
@@ -62,10 +70,146 @@ util::Status WriteToStream(const std::vector<uint8_t>& contents,
 
 }  // anonymous namespace
 
+// Writes ciphertext segments to the destination in a task scheduled on an
+// executor, keeping up to 'max_segments' segments queued. At most one
+// thread writes to the destination at a time. The stream waits only for a
+// write that has already started, never for a task that has merely been
+// scheduled; instead it writes queued segments itself.
+class StreamingAeadEncryptingStream::WriteBehind
+    : public std::enable_shared_from_this<WriteBehind> {
+ public:
+  WriteBehind(OutputStream* ct_destination, int max_segments,
+              util::Executor* executor, util::BufferPool* buffer_pool)
+      : ct_destination_(ct_destination),
+        max_segments_(max_segments),
+        executor_(executor),
+        buffer_pool_(buffer_pool) {}
+
+  // Queues 'segment' for writing; its buffer is released to the buffer
+  // pool once written. Returns the first error of the destination, if any.
+  Status Write(std::vector<uint8_t> segment);
+
+  // Returns once all queued segments were written, or the first error of
+  // the destination.
+  Status Flush();
+
+  // Waits for a running write to finish, then makes all tasks return
+  // without writing and releases the queued segments.
+  void Close();
+
+ private:
+  // Writes queued segments until none are left. Runs as a task.
+  void Drain();
+
+  // Writes the first queued segment, unlocking mutex_ while writing.
+  void WriteNextSegment() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Waits for a running write to finish.
+  void AwaitNotWriting() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  OutputStream* const ct_destination_;
+  const int max_segments_;
+  util::Executor* const executor_;
+  util::BufferPool* const buffer_pool_;
+
+  absl::Mutex mutex_;
+  std::deque<std::vector<uint8_t>> queued_segments_ ABSL_GUARDED_BY(mutex_);
+  // The first error of the destination.
+  Status status_ ABSL_GUARDED_BY(mutex_);
+  // True while a thread writes to ct_destination_.
+  bool writing_ ABSL_GUARDED_BY(mutex_) = false;
+  bool drain_scheduled_ ABSL_GUARDED_BY(mutex_) = false;
+  bool closed_ ABSL_GUARDED_BY(mutex_) = false;
+};
+
+Status StreamingAeadEncryptingStream::WriteBehind::Write(
+    std::vector<uint8_t> segment) {
+  mutex_.Lock();
+  queued_segments_.push_back(std::move(segment));
+  while (status_.ok() &&
+         queued_segments_.size() > static_cast<size_t>(max_segments_)) {
+    if (writing_) {
+      AwaitNotWriting();
+    } else {
+      WriteNextSegment();
+    }
+  }
+  Status status = status_;
+  bool schedule_drain = status_.ok() && !drain_scheduled_ && !writing_ &&
+                        !queued_segments_.empty();
+  if (schedule_drain) drain_scheduled_ = true;
+  mutex_.Unlock();
+  if (schedule_drain) {
+    // The task keeps this object alive, as it may run after the stream is
+    // gone; it does not write then, as Close() was called.
+    std::shared_ptr<WriteBehind> self = shared_from_this();
+    executor_->Schedule([self] { self->Drain(); });
+  }
+  return status;
+}
+
+Status StreamingAeadEncryptingStream::WriteBehind::Flush() {
+  absl::MutexLock lock(&mutex_);
+  while (status_.ok() && (writing_ || !queued_segments_.empty())) {
+    if (writing_) {
+      AwaitNotWriting();
+    } else {
+      WriteNextSegment();
+    }
+  }
+  return status_;
+}
+
+void StreamingAeadEncryptingStream::WriteBehind::Close() {
+  absl::MutexLock lock(&mutex_);
+  closed_ = true;
+  AwaitNotWriting();
+  for (auto& segment : queued_segments_) {
+    buffer_pool_->Release(std::move(segment));
+  }
+  queued_segments_.clear();
+}
+
+void StreamingAeadEncryptingStream::WriteBehind::Drain() {
+  absl::MutexLock lock(&mutex_);
+  while (!closed_ && !writing_ && status_.ok() && !queued_segments_.empty()) {
+    WriteNextSegment();
+  }
+  drain_scheduled_ = false;
+}
+
+void StreamingAeadEncryptingStream::WriteBehind::WriteNextSegment() {
+  writing_ = true;
+  std::vector<uint8_t> segment = std::move(queued_segments_.front());
+  queued_segments_.pop_front();
+  mutex_.Unlock();
+  Status status = WriteToStream(segment, ct_destination_);
+  mutex_.Lock();
+  writing_ = false;
+  buffer_pool_->Release(std::move(segment));
+  if (status_.ok()) status_ = status;
+}
+
+void StreamingAeadEncryptingStream::WriteBehind::AwaitNotWriting() {
+  mutex_.Await(absl::Condition(
+      +[](WriteBehind* write_behind) ABSL_EXCLUSIVE_LOCKS_REQUIRED(
+           write_behind->mutex_) { return !write_behind->writing_; },
+      this));
+}
+
 // static
 StatusOr<std::unique_ptr<OutputStream>> StreamingAeadEncryptingStream::New(
     std::unique_ptr<StreamSegmentEncrypter> segment_encrypter,
     std::unique_ptr<OutputStream> ciphertext_destination) {
+  return New(std::move(segment_encrypter), std::move(ciphertext_destination),
+             /* write_behind_segments = */ 0);
+}
+
+// static
+StatusOr<std::unique_ptr<OutputStream>> StreamingAeadEncryptingStream::New(
+    std::unique_ptr<StreamSegmentEncrypter> segment_encrypter,
+    std::unique_ptr<OutputStream> ciphertext_destination,
+    int write_behind_segments, util::Executor* executor) {
   if (segment_encrypter == nullptr) {
     return Status(util::error::INVALID_ARGUMENT,
                   "segment_encrypter must be non-null");
@@ -74,6 +218,10 @@ StatusOr<std::unique_ptr<OutputStream>> StreamingAeadEncryptingStream::New(
     return Status(util::error::INVALID_ARGUMENT,
                   "cipertext_destination must be non-null");
   }
+  if (write_behind_segments < 0) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "write_behind_segments must be non-negative");
+  }
   std::unique_ptr<StreamingAeadEncryptingStream> enc_stream(
       new StreamingAeadEncryptingStream());
   enc_stream->segment_encrypter_ = std::move(segment_encrypter);
@@ -87,16 +235,140 @@ StatusOr<std::unique_ptr<OutputStream>> StreamingAeadEncryptingStream::New(
     return Status(util::error::INTERNAL,
                   "Size of the first segment must be greater than 0.");
   }
+  // Both plaintext buffers hold full segments later on.
+  int pt_segment_size =
+      enc_stream->segment_encrypter_->get_plaintext_segment_size();
+  enc_stream->pt_buffer_ = enc_stream->buffer_pool_->Acquire(pt_segment_size);
   enc_stream->pt_buffer_.resize(first_segment_size);
+  enc_stream->pt_to_encrypt_ =
+      enc_stream->buffer_pool_->Acquire(pt_segment_size);
   enc_stream->pt_to_encrypt_.resize(0);
   enc_stream->position_ = 0;
   enc_stream->is_first_segment_ = true;
+  enc_stream->encrypt_into_supported_ = true;
   enc_stream->count_backedup_ = first_segment_size;
   enc_stream->pt_buffer_offset_ = 0;
   enc_stream->status_ = Status::OK;
+  enc_stream->append_segment_number_ = -1;
+  enc_stream->append_position_ = -1;
+  if (write_behind_segments > 0) {
+    if (executor == nullptr) executor = util::Executor::Global();
+    enc_stream->write_behind_ = std::make_shared<WriteBehind>(
+        enc_stream->ct_destination_.get(), write_behind_segments, executor,
+        enc_stream->buffer_pool_);
+  }
   return {std::move(enc_stream)};
 }
 
+// static
+StatusOr<std::unique_ptr<OutputStream>>
+StreamingAeadEncryptingStream::NewForAppend(
+    std::unique_ptr<StreamSegmentEncrypter> segment_encrypter,
+    std::unique_ptr<OutputStream> ciphertext_destination,
+    const std::vector<uint8_t>& last_segment_plaintext,
+    int64_t plaintext_size) {
+  if (segment_encrypter == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "segment_encrypter must be non-null");
+  }
+  if (ciphertext_destination == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "cipertext_destination must be non-null");
+  }
+  int64_t segment_number = segment_encrypter->get_segment_number();
+  int pt_segment_size = segment_encrypter->get_plaintext_segment_size();
+  // The existing last segment is filled up before a new one is started.
+  int last_segment_size =
+      segment_number == 0
+          ? pt_segment_size - segment_encrypter->get_ciphertext_offset() -
+                segment_encrypter->get_header().size()
+          : pt_segment_size;
+  if (last_segment_size <= 0) {
+    return Status(util::error::INTERNAL,
+                  "Size of the first segment must be greater than 0.");
+  }
+  if (last_segment_plaintext.size() > last_segment_size ||
+      plaintext_size < last_segment_plaintext.size()) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "last_segment_plaintext does not fit the stream");
+  }
+  std::unique_ptr<StreamingAeadEncryptingStream> enc_stream(
+      new StreamingAeadEncryptingStream());
+  enc_stream->segment_encrypter_ = std::move(segment_encrypter);
+  enc_stream->ct_destination_ = std::move(ciphertext_destination);
+  enc_stream->pt_buffer_ = enc_stream->buffer_pool_->Acquire(pt_segment_size);
+  enc_stream->pt_buffer_.assign(last_segment_plaintext.begin(),
+                                last_segment_plaintext.end());
+  enc_stream->pt_buffer_.resize(last_segment_size);
+  enc_stream->pt_to_encrypt_ =
+      enc_stream->buffer_pool_->Acquire(pt_segment_size);
+  enc_stream->pt_to_encrypt_.resize(0);
+  // The stream behaves as if the existing plaintext had been written and
+  // the rest of pt_buffer_ had been backed up.
+  enc_stream->position_ = plaintext_size;
+  enc_stream->is_first_segment_ = false;
+  enc_stream->encrypt_into_supported_ = true;
+  enc_stream->count_backedup_ =
+      last_segment_size - last_segment_plaintext.size();
+  enc_stream->pt_buffer_offset_ = 0;
+  enc_stream->status_ = Status::OK;
+  enc_stream->append_segment_number_ = segment_number;
+  enc_stream->append_position_ = plaintext_size;
+  return {std::move(enc_stream)};
+}
+
+StreamingAeadEncryptingStream::~StreamingAeadEncryptingStream() {
+  if (write_behind_ != nullptr) write_behind_->Close();
+  buffer_pool_->Release(std::move(pt_buffer_));
+  buffer_pool_->Release(std::move(pt_to_encrypt_));
+  buffer_pool_->Release(std::move(ct_buffer_));
+}
+
+Status StreamingAeadEncryptingStream::EncryptAndWriteSegment(
+    const std::vector<uint8_t>& plaintext, bool is_last_segment) {
+  if (write_behind_ != nullptr) {
+    std::vector<uint8_t> ciphertext = buffer_pool_->Acquire(
+        segment_encrypter_->get_ciphertext_segment_size());
+    auto status = segment_encrypter_->EncryptSegment(
+        plaintext, is_last_segment, &ciphertext);
+    if (!status.ok()) {
+      buffer_pool_->Release(std::move(ciphertext));
+      return status;
+    }
+    return write_behind_->Write(std::move(ciphertext));
+  }
+  if (encrypt_into_supported_) {
+    int ct_size = plaintext.size() +
+                  segment_encrypter_->get_ciphertext_segment_size() -
+                  segment_encrypter_->get_plaintext_segment_size();
+    void* buffer;
+    auto next_result = ct_destination_->Next(&buffer);
+    if (!next_result.ok()) return next_result.status();
+    int available_space = next_result.ValueOrDie();
+    if (available_space >= ct_size) {
+      auto encrypt_result = segment_encrypter_->EncryptSegmentInto(
+          plaintext, is_last_segment,
+          absl::MakeSpan(static_cast<uint8_t*>(buffer), ct_size));
+      if (encrypt_result.ok()) {
+        ct_destination_->BackUp(available_space -
+                                encrypt_result.ValueOrDie());
+        return Status::OK;
+      }
+      if (encrypt_result.status().error_code() !=
+          util::error::UNIMPLEMENTED) {
+        return encrypt_result.status();
+      }
+      encrypt_into_supported_ = false;
+    }
+    // The buffer is returned unused, WriteToStream() below obtains it again.
+    ct_destination_->BackUp(available_space);
+  }
+  auto status = segment_encrypter_->EncryptSegment(plaintext, is_last_segment,
+                                                   &ct_buffer_);
+  if (!status.ok()) return status;
+  return WriteToStream(ct_buffer_, ct_destination_.get());
+}
+
 StatusOr<int> StreamingAeadEncryptingStream::Next(void** data) {
   if (!status_.ok()) return status_;
 
@@ -131,10 +403,8 @@ StatusOr<int> StreamingAeadEncryptingStream::Next(void** data) {
   //
   // Step 1.
   if (!pt_to_encrypt_.empty()) {
-    status_ = segment_encrypter_->EncryptSegment(
-        pt_to_encrypt_, /* is_last_segment = */ false, &ct_buffer_);
-    if (!status_.ok()) return status_;
-    status_ = WriteToStream(ct_buffer_, ct_destination_.get());
+    status_ = EncryptAndWriteSegment(pt_to_encrypt_,
+                                     /* is_last_segment = */ false);
     if (!status_.ok()) return status_;
   }
   // Step 2.
@@ -171,34 +441,49 @@ Status StreamingAeadEncryptingStream::Close() {
     pt_buffer_.resize(pt_buffer_.size() - count_backedup_);
     pt_last_segment = &pt_buffer_;
   }
-  if (pt_last_segment != &pt_to_encrypt_ && (!pt_to_encrypt_.empty())) {
-    // Before writing the last segment we must encrypt pt_to_encrypt_.
-    status_ = segment_encrypter_->EncryptSegment(
-        pt_to_encrypt_, /* is_last_segment = */ false, &ct_buffer_);
-    if (!status_.ok()) {
-      ct_destination_->Close().IgnoreError();
+  if (append_segment_number_ >= 0) {
+    int64_t last_segment_number =
+        segment_encrypter_->get_segment_number() +
+        (pt_last_segment == &pt_buffer_ && !pt_to_encrypt_.empty() ? 1 : 0);
+    if (last_segment_number == append_segment_number_) {
+      if (position_ == append_position_) {
+        // Nothing was appended, the existing ciphertext is left as is.
+        status_ = Status(util::error::FAILED_PRECONDITION, "Stream closed");
+        return CloseDestination();
+      }
+      status_ = Status(util::error::FAILED_PRECONDITION,
+                       "Appended data must extend the stream past its "
+                       "existing last segment");
+      CloseDestination().IgnoreError();
       return status_;
     }
-    status_ = WriteToStream(ct_buffer_, ct_destination_.get());
+  }
+  if (pt_last_segment != &pt_to_encrypt_ && (!pt_to_encrypt_.empty())) {
+    // Before writing the last segment we must encrypt pt_to_encrypt_.
+    status_ = EncryptAndWriteSegment(pt_to_encrypt_,
+                                     /* is_last_segment = */ false);
     if (!status_.ok()) {
-      ct_destination_->Close().IgnoreError();
+      CloseDestination().IgnoreError();
       return status_;
     }
   }
 
   // Encrypt pt_last_segment, write the ciphertext, and close the stream.
-  status_ = segment_encrypter_->EncryptSegment(
-      *pt_last_segment, /* is_last_segment = */ true, &ct_buffer_);
-  if (!status_.ok()) {
-    ct_destination_->Close().IgnoreError();
-    return status_;
+  status_ = EncryptAndWriteSegment(*pt_last_segment,
+                                   /* is_last_segment = */ true);
+  if (status_.ok() && write_behind_ != nullptr) {
+    status_ = write_behind_->Flush();
   }
-  status_ = WriteToStream(ct_buffer_, ct_destination_.get());
   if (!status_.ok()) {
-    ct_destination_->Close().IgnoreError();
+    CloseDestination().IgnoreError();
     return status_;
   }
   status_ = Status(util::error::FAILED_PRECONDITION, "Stream closed");
+  return CloseDestination();
+}
+
+Status StreamingAeadEncryptingStream::CloseDestination() {
+  if (write_behind_ != nullptr) write_behind_->Close();
   return ct_destination_->Close();
 }
 
@@ -17,11 +17,14 @@
 #ifndef TINK_SUBTLE_STREAMING_AEAD_ENCRYPTING_STREAM_H_
 #define TINK_SUBTLE_STREAMING_AEAD_ENCRYPTING_STREAM_H_
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
 #include "tink/output_stream.h"
 #include "tink/subtle/stream_segment_encrypter.h"
+#include "tink/util/buffer_pool.h"
+#include "tink/util/executor.h"
 #include "tink/util/statusor.h"
 
 namespace crypto {
@@ -35,11 +38,50 @@ class StreamingAeadEncryptingStream : public OutputStream {
   // such that any bytes written via the wrapper are AEAD-encrypted
   // by 'segment_encrypter' using 'associated_data' as associated
   // authenticated data.
+  // The segment buffers are taken from util::BufferPool::Global().
   static
   crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::OutputStream>>
       New(std::unique_ptr<StreamSegmentEncrypter> segment_encrypter,
           std::unique_ptr<crypto::tink::OutputStream> ciphertext_destination);
 
+  // Like New() above, but the ciphertext segments are written to
+  // 'ciphertext_destination' by a task scheduled on 'executor', or on
+  // util::Executor::Global() if 'executor' is null, so that the caller can
+  // fill and encrypt the next segments while earlier ones are written.
+  // Up to 'write_behind_segments' encrypted segments wait to be written;
+  // when that many are waiting, the caller writes segments itself unless
+  // a task is writing already. Errors of the destination are returned by
+  // the next call to Next() or Close(), and Close() returns only after all
+  // segments were written. 'ciphertext_destination' is then written from
+  // the executor's threads, but never from two threads at once.
+  static
+  crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::OutputStream>>
+      New(std::unique_ptr<StreamSegmentEncrypter> segment_encrypter,
+          std::unique_ptr<crypto::tink::OutputStream> ciphertext_destination,
+          int write_behind_segments, util::Executor* executor = nullptr);
+
+  // Like New(), but the returned stream continues an existing ciphertext
+  // stream whose last segment encrypts 'last_segment_plaintext' and which
+  // encrypts 'plaintext_size' bytes in total. 'segment_encrypter' must use
+  // the header of the existing stream, and its segment number must be the
+  // number of the existing last segment. The stream writes neither the
+  // header nor the ciphertext offset; its output replaces the existing last
+  // segment, i.e. it must be written starting at the position of that
+  // segment in the existing ciphertext.
+  //
+  // Sealing the last segment again as the last segment with more plaintext
+  // would reuse its nonce, so Close() fails with FAILED_PRECONDITION and
+  // writes nothing if some, but too few bytes were written to the stream to
+  // start a new segment. If no bytes were written, Close() writes nothing
+  // and the existing ciphertext stays valid.
+  static
+  crypto::tink::util::StatusOr<std::unique_ptr<crypto::tink::OutputStream>>
+      NewForAppend(
+          std::unique_ptr<StreamSegmentEncrypter> segment_encrypter,
+          std::unique_ptr<crypto::tink::OutputStream> ciphertext_destination,
+          const std::vector<uint8_t>& last_segment_plaintext,
+          int64_t plaintext_size);
+
   // -----------------------
   // Methods of OutputStream-interface implemented by this class.
   crypto::tink::util::StatusOr<int> Next(void** data) override;
@@ -47,10 +89,30 @@ class StreamingAeadEncryptingStream : public OutputStream {
   crypto::tink::util::Status Close() override;
   int64_t Position() const override;
 
+  ~StreamingAeadEncryptingStream() override;
+
  private:
-  StreamingAeadEncryptingStream() {}
+  StreamingAeadEncryptingStream()
+      : buffer_pool_(util::BufferPool::Global()) {}
+
+  class WriteBehind;
+
+  // Encrypts 'plaintext' as the next segment and writes the ciphertext
+  // to ct_destination_, or passes it to write_behind_ if set. If the buffer
+  // returned by ct_destination_->Next() can hold the entire ciphertext
+  // segment, the segment is encrypted directly into it, otherwise it goes
+  // through ct_buffer_.
+  crypto::tink::util::Status EncryptAndWriteSegment(
+      const std::vector<uint8_t>& plaintext, bool is_last_segment);
+
+  // Stops write_behind_, if set, and closes ct_destination_.
+  crypto::tink::util::Status CloseDestination();
+
   std::unique_ptr<StreamSegmentEncrypter> segment_encrypter_;
   std::unique_ptr<crypto::tink::OutputStream> ct_destination_;
+  // Writes the segments to ct_destination_ in the background, if not null.
+  std::shared_ptr<WriteBehind> write_behind_;
+  util::BufferPool* buffer_pool_;  // source of the buffers below
   std::vector<uint8_t> pt_buffer_;  // plaintext buffer
   std::vector<uint8_t> ct_buffer_;  // ciphertext buffer
   std::vector<uint8_t> pt_to_encrypt_;  // plaintext to be encrypted
@@ -67,6 +129,16 @@ class StreamingAeadEncryptingStream : public OutputStream {
   // header has been written to ct_destination_, nor the user had
   // a chance to write any data to this stream.
   bool is_first_segment_;
+
+  // False once segment_encrypter_ reported that it does not implement
+  // EncryptSegmentInto().
+  bool encrypt_into_supported_;
+
+  // For streams created by NewForAppend(): the number of the last segment
+  // of the existing ciphertext stream, and the plaintext size at which
+  // the stream was created. -1 for streams created by New().
+  int64_t append_segment_number_;
+  int64_t append_position_;
 };
 
 }  // namespace subtle
@@ -27,6 +27,7 @@
 #include "tink/subtle/stream_segment_encrypter.h"
 #include "tink/subtle/random.h"
 #include "tink/subtle/test_util.h"
+#include "tink/util/executor.h"
 #include "tink/util/ostream_output_stream.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
@@ -68,6 +69,49 @@ std::unique_ptr<OutputStream> GetEncryptingStream(
   return enc_stream;
 }
 
+// Like GetEncryptingStream(), but with up to 'write_behind_segments'
+// segments written to the destination on 'executor'.
+std::unique_ptr<OutputStream> GetWriteBehindEncryptingStream(
+    int pt_segment_size, int header_size, int ct_offset,
+    int write_behind_segments, util::Executor* executor,
+    ValidationRefs* refs) {
+  auto ct_stream = absl::make_unique<std::stringstream>();
+  refs->ct_buf = ct_stream->rdbuf();
+  std::unique_ptr<OutputStream> ct_destination(
+      absl::make_unique<OstreamOutputStream>(std::move(ct_stream)));
+  auto seg_enc = absl::make_unique<DummyStreamSegmentEncrypter>(
+          pt_segment_size, header_size, ct_offset);
+  refs->seg_enc = seg_enc.get();
+  auto enc_stream = std::move(StreamingAeadEncryptingStream::New(
+      std::move(seg_enc), std::move(ct_destination), write_behind_segments,
+      executor).ValueOrDie());
+  EXPECT_EQ(0, enc_stream->Position());
+  return enc_stream;
+}
+
+// An OutputStream whose Next() fails after 'ok_calls' calls.
+class FailingOutputStream : public OutputStream {
+ public:
+  explicit FailingOutputStream(int ok_calls)
+      : ok_calls_(ok_calls), buffer_(1000) {}
+
+  util::StatusOr<int> Next(void** data) override {
+    if (ok_calls_ == 0) {
+      return util::Status(util::error::UNAVAILABLE, "destination failed");
+    }
+    ok_calls_--;
+    *data = buffer_.data();
+    return buffer_.size();
+  }
+  void BackUp(int count) override {}
+  util::Status Close() override { return util::Status::OK; }
+  int64_t Position() const override { return 0; }
+
+ private:
+  int ok_calls_;
+  std::vector<uint8_t> buffer_;
+};
+
 
 class StreamingAeadEncryptingStreamTest : public ::testing::Test {
 };
@@ -562,6 +606,86 @@ TEST_F(StreamingAeadEncryptingStreamTest, BackupAndPosition) {
   EXPECT_EQ(util::error::FAILED_PRECONDITION, close_status.error_code());
 }
 
+TEST_F(StreamingAeadEncryptingStreamTest, WriteBehind) {
+  util::ThreadPool pool(2);
+  std::vector<int> pt_sizes = {0, 10, 1000, 100000};
+  std::vector<int> write_behind_segments = {1, 2, 8};
+  int pt_segment_size = 128;
+  int header_size = 10;
+  int ct_offset = 5;
+  for (auto pt_size : pt_sizes) {
+    for (auto write_behind : write_behind_segments) {
+      SCOPED_TRACE(absl::StrCat("pt_size = ", pt_size,
+                                ", write_behind_segments = ", write_behind));
+      ValidationRefs refs;
+      auto enc_stream = GetWriteBehindEncryptingStream(
+          pt_segment_size, header_size, ct_offset, write_behind, &pool,
+          &refs);
+      std::string pt = Random::GetRandomBytes(pt_size);
+      auto status = test::WriteToStream(enc_stream.get(), pt);
+      EXPECT_TRUE(status.ok()) << status;
+      EXPECT_EQ(pt.size(), enc_stream->Position());
+      DummyStreamSegmentEncrypter seg_enc(pt_segment_size, header_size,
+                                          ct_offset);
+      EXPECT_EQ(seg_enc.GenerateCiphertext(pt), refs.ct_buf->str());
+    }
+  }
+}
+
+TEST_F(StreamingAeadEncryptingStreamTest, WriteBehindWithoutRunningTasks) {
+  // The stream does not wait for tasks that never run.
+  util::FunctionExecutor executor([](std::function<void()> task) {});
+  int pt_segment_size = 100;
+  int header_size = 10;
+  ValidationRefs refs;
+  auto enc_stream = GetWriteBehindEncryptingStream(
+      pt_segment_size, header_size, /* ct_offset = */ 0,
+      /* write_behind_segments = */ 4, &executor, &refs);
+  std::string pt = Random::GetRandomBytes(10000);
+  auto status = test::WriteToStream(enc_stream.get(), pt);
+  EXPECT_TRUE(status.ok()) << status;
+  DummyStreamSegmentEncrypter seg_enc(pt_segment_size, header_size,
+                                      /* ct_offset = */ 0);
+  EXPECT_EQ(seg_enc.GenerateCiphertext(pt), refs.ct_buf->str());
+}
+
+TEST_F(StreamingAeadEncryptingStreamTest, WriteBehindDestinationError) {
+  util::ThreadPool pool(1);
+  auto seg_enc = absl::make_unique<DummyStreamSegmentEncrypter>(
+      /* pt_segment_size = */ 100, /* header_size = */ 10,
+      /* ct_offset = */ 0);
+  auto enc_stream = std::move(StreamingAeadEncryptingStream::New(
+      std::move(seg_enc), absl::make_unique<FailingOutputStream>(10),
+      /* write_behind_segments = */ 2, &pool).ValueOrDie());
+  std::string pt = Random::GetRandomBytes(100000);
+  auto status = test::WriteToStream(enc_stream.get(), pt);
+  EXPECT_EQ(util::error::UNAVAILABLE, status.error_code()) << status;
+}
+
+TEST_F(StreamingAeadEncryptingStreamTest, WriteBehindDestroyedWhileWriting) {
+  util::ThreadPool pool(1);
+  for (int i = 0; i < 10; i++) {
+    ValidationRefs refs;
+    auto enc_stream = GetWriteBehindEncryptingStream(
+        /* pt_segment_size = */ 64, /* header_size = */ 8,
+        /* ct_offset = */ 0, /* write_behind_segments = */ 16, &pool, &refs);
+    void* buffer;
+    for (int j = 0; j < 20; j++) {
+      EXPECT_TRUE(enc_stream->Next(&buffer).ok());
+    }
+  }
+}
+
+TEST_F(StreamingAeadEncryptingStreamTest, NegativeWriteBehind) {
+  auto result = StreamingAeadEncryptingStream::New(
+      absl::make_unique<DummyStreamSegmentEncrypter>(
+          /* pt_segment_size = */ 100, /* header_size = */ 10,
+          /* ct_offset = */ 0),
+      absl::make_unique<FailingOutputStream>(0),
+      /* write_behind_segments = */ -1);
+  EXPECT_EQ(util::error::INVALID_ARGUMENT, result.status().error_code());
+}
+
 }  // namespace
 }  // namespace subtle
 }  // namespace tink
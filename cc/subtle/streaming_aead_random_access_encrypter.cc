@@ -0,0 +1,132 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/streaming_aead_random_access_encrypter.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "tink/subtle/stream_segment_encrypter.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+using crypto::tink::util::Status;
+using crypto::tink::util::StatusOr;
+
+// static
+StatusOr<std::unique_ptr<StreamingAeadRandomAccessEncrypter>>
+StreamingAeadRandomAccessEncrypter::New(
+    std::unique_ptr<StreamSegmentEncrypter> segment_encrypter) {
+  if (segment_encrypter == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "segment_encrypter must be non-null");
+  }
+  if (segment_encrypter->get_plaintext_segment_size() -
+          segment_encrypter->get_ciphertext_offset() -
+          static_cast<int>(segment_encrypter->get_header().size()) <=
+      0) {
+    return Status(util::error::INTERNAL,
+                  "Size of the first segment must be greater than 0.");
+  }
+  return {absl::WrapUnique(
+      new StreamingAeadRandomAccessEncrypter(std::move(segment_encrypter)))};
+}
+
+StreamingAeadRandomAccessEncrypter::StreamingAeadRandomAccessEncrypter(
+    std::unique_ptr<StreamSegmentEncrypter> segment_encrypter)
+    : segment_encrypter_(std::move(segment_encrypter)),
+      first_segment_size_(segment_encrypter_->get_plaintext_segment_size() -
+                          segment_encrypter_->get_ciphertext_offset() -
+                          segment_encrypter_->get_header().size()) {}
+
+int StreamingAeadRandomAccessEncrypter::GetPlaintextSegmentSize(
+    int64_t segment_number) const {
+  return segment_number == 0
+             ? first_segment_size_
+             : segment_encrypter_->get_plaintext_segment_size();
+}
+
+int64_t StreamingAeadRandomAccessEncrypter::GetPlaintextPosition(
+    int64_t segment_number) const {
+  if (segment_number == 0) return 0;
+  return first_segment_size_ +
+         (segment_number - 1) *
+             segment_encrypter_->get_plaintext_segment_size();
+}
+
+int64_t StreamingAeadRandomAccessEncrypter::GetCiphertextPosition(
+    int64_t segment_number) const {
+  if (segment_number == 0) {
+    return get_header_position() + get_header().size();
+  }
+  return segment_number * segment_encrypter_->get_ciphertext_segment_size();
+}
+
+int64_t StreamingAeadRandomAccessEncrypter::GetNumberOfSegments(
+    int64_t plaintext_size) const {
+  if (plaintext_size <= first_segment_size_) return 1;
+  int pt_segment_size = segment_encrypter_->get_plaintext_segment_size();
+  return 1 + (plaintext_size - first_segment_size_ + pt_segment_size - 1) /
+                 pt_segment_size;
+}
+
+Status StreamingAeadRandomAccessEncrypter::EncryptSegment(
+    int64_t segment_number, absl::string_view plaintext,
+    bool is_last_segment, std::string* ciphertext) const {
+  if (ciphertext == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "ciphertext must be non-null");
+  }
+  if (segment_number < 0) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "segment_number must be non-negative");
+  }
+  int segment_size = GetPlaintextSegmentSize(segment_number);
+  if (plaintext.size() > segment_size) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "plaintext does not fit into the segment");
+  }
+  if (!is_last_segment && plaintext.size() != segment_size) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "only the last segment may be shorter than a full segment");
+  }
+  if (is_last_segment && segment_number > 0 && plaintext.empty()) {
+    // A stream with plaintext ends with a segment that is not empty.
+    return Status(util::error::INVALID_ARGUMENT,
+                  "the last segment must not be empty");
+  }
+  std::vector<uint8_t> ct_buffer;
+  Status status = segment_encrypter_->EncryptSegmentAt(
+      std::vector<uint8_t>(plaintext.begin(), plaintext.end()),
+      segment_number, is_last_segment, &ct_buffer);
+  if (!status.ok()) return status;
+  ciphertext->append(reinterpret_cast<const char*>(ct_buffer.data()),
+                     ct_buffer.size());
+  return Status::OK;
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,111 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SUBTLE_STREAMING_AEAD_RANDOM_ACCESS_ENCRYPTER_H_
+#define TINK_SUBTLE_STREAMING_AEAD_RANDOM_ACCESS_ENCRYPTER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tink/subtle/stream_segment_encrypter.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// Encrypts the segments of a ciphertext stream independently of each other,
+// in any order and from any thread, for writers that produce the parts of
+// one large object separately, e.g. with positional writes or as the parts
+// of a multipart upload. Each segment is encrypted with its number, so the
+// ciphertext is the same as that of StreamingAeadEncryptingStream with the
+// same segment encrypter, once all segments and the header are written at
+// their positions.
+//
+// Positions are those in the ciphertext stream including the ciphertext
+// offset, i.e. the header starts at get_ciphertext_offset() of the segment
+// encrypter and the segments other than the first one are aligned to the
+// ciphertext segment size. The bytes before the header are not written by
+// the encrypter.
+//
+// All segments except the last one must be full, i.e. encrypt exactly
+// GetPlaintextSegmentSize() bytes, and exactly one segment, the one with the
+// highest number, must be encrypted as the last one. The caller is
+// responsible for never encrypting a segment number twice with different
+// plaintexts, since that reuses the nonce of the segment.
+class StreamingAeadRandomAccessEncrypter {
+ public:
+  // 'segment_encrypter' must implement EncryptSegmentAt(), such as the one
+  // of AES-GCM-HKDF; otherwise EncryptSegment() fails with UNIMPLEMENTED.
+  // Its current segment number is ignored.
+  static crypto::tink::util::StatusOr<
+      std::unique_ptr<StreamingAeadRandomAccessEncrypter>>
+  New(std::unique_ptr<StreamSegmentEncrypter> segment_encrypter);
+
+  StreamingAeadRandomAccessEncrypter(
+      const StreamingAeadRandomAccessEncrypter&) = delete;
+  StreamingAeadRandomAccessEncrypter& operator=(
+      const StreamingAeadRandomAccessEncrypter&) = delete;
+
+  // Returns the header, which must be written at get_header_position(), and
+  // which other writers of the same stream use to create their encrypters.
+  const std::vector<uint8_t>& get_header() const {
+    return segment_encrypter_->get_header();
+  }
+
+  int64_t get_header_position() const {
+    return segment_encrypter_->get_ciphertext_offset();
+  }
+
+  // Returns the number of plaintext bytes of segment 'segment_number' if it
+  // is not the last one; the first segment is shorter than the others.
+  int GetPlaintextSegmentSize(int64_t segment_number) const;
+
+  // Returns the position of the first plaintext byte of 'segment_number'.
+  int64_t GetPlaintextPosition(int64_t segment_number) const;
+
+  // Returns the position at which the ciphertext of 'segment_number' must
+  // be written.
+  int64_t GetCiphertextPosition(int64_t segment_number) const;
+
+  // Returns the number of segments of a stream with 'plaintext_size' bytes
+  // of plaintext; the last segment has number GetNumberOfSegments() - 1.
+  int64_t GetNumberOfSegments(int64_t plaintext_size) const;
+
+  // Encrypts 'plaintext' as the segment with number 'segment_number' and
+  // appends the ciphertext to 'ciphertext'. Thread-safe.
+  crypto::tink::util::Status EncryptSegment(int64_t segment_number,
+                                            absl::string_view plaintext,
+                                            bool is_last_segment,
+                                            std::string* ciphertext) const;
+
+ private:
+  explicit StreamingAeadRandomAccessEncrypter(
+      std::unique_ptr<StreamSegmentEncrypter> segment_encrypter);
+
+  const std::unique_ptr<StreamSegmentEncrypter> segment_encrypter_;
+  const int first_segment_size_;  // plaintext size of the first segment
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_STREAMING_AEAD_RANDOM_ACCESS_ENCRYPTER_H_
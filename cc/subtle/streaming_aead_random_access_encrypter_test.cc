@@ -0,0 +1,168 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/streaming_aead_random_access_encrypter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/executor.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+using crypto::tink::subtle::test::DummyStreamSegmentEncrypter;
+using crypto::tink::test::IsOk;
+using crypto::tink::test::StatusIs;
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+// A DummyStreamSegmentEncrypter that encrypts segments in any order.
+class DummyRandomAccessSegmentEncrypter : public DummyStreamSegmentEncrypter {
+ public:
+  using DummyStreamSegmentEncrypter::DummyStreamSegmentEncrypter;
+
+  util::Status EncryptSegmentAt(
+      const std::vector<uint8_t>& plaintext, int64_t segment_number,
+      bool is_last_segment,
+      std::vector<uint8_t>* ciphertext_buffer) const override {
+    ciphertext_buffer->resize(plaintext.size() + kSegmentTagSize);
+    memcpy(ciphertext_buffer->data(), plaintext.data(), plaintext.size());
+    memcpy(ciphertext_buffer->data() + plaintext.size(), &segment_number,
+           sizeof(segment_number));
+    ciphertext_buffer->back() =
+        is_last_segment ? kLastSegment : kNotLastSegment;
+    return util::Status::OK;
+  }
+};
+
+TEST(StreamingAeadRandomAccessEncrypterTest, OutOfOrderParallelWrites) {
+  int pt_segment_size = 100;
+  int header_size = 10;
+  for (int ct_offset : {0, 7}) {
+    for (int pt_size : {0, 1, 83, 90, 1000, 10000}) {
+      SCOPED_TRACE(absl::StrCat("ct_offset = ", ct_offset,
+                                ", pt_size = ", pt_size));
+      auto result = StreamingAeadRandomAccessEncrypter::New(
+          absl::make_unique<DummyRandomAccessSegmentEncrypter>(
+              pt_segment_size, header_size, ct_offset));
+      ASSERT_THAT(result.status(), IsOk());
+      auto encrypter = std::move(result.ValueOrDie());
+      std::string pt = Random::GetRandomBytes(pt_size);
+      DummyStreamSegmentEncrypter seg_enc(pt_segment_size, header_size,
+                                          ct_offset);
+      std::string expected_ct =
+          std::string(ct_offset, 'o') + seg_enc.GenerateCiphertext(pt);
+
+      // Each segment is encrypted by a separate task and written at its
+      // position, as with positional writes.
+      std::string ct(ct_offset, 'o');
+      ct.resize(expected_ct.size());
+      const std::vector<uint8_t>& header = encrypter->get_header();
+      std::copy(header.begin(), header.end(),
+                ct.begin() + encrypter->get_header_position());
+      int64_t num_segments = encrypter->GetNumberOfSegments(pt_size);
+      std::vector<util::Status> statuses(num_segments);
+      util::ParallelFor(num_segments, 4, [&](int64_t i) {
+        // Encrypt in reverse order.
+        int64_t segment_number = num_segments - 1 - i;
+        int64_t pt_position = encrypter->GetPlaintextPosition(segment_number);
+        absl::string_view segment_pt = absl::string_view(pt).substr(
+            pt_position, encrypter->GetPlaintextSegmentSize(segment_number));
+        std::string segment_ct;
+        statuses[segment_number] = encrypter->EncryptSegment(
+            segment_number, segment_pt, segment_number == num_segments - 1,
+            &segment_ct);
+        std::copy(segment_ct.begin(), segment_ct.end(),
+                  ct.begin() + encrypter->GetCiphertextPosition(
+                                   segment_number));
+      });
+      for (const auto& status : statuses) EXPECT_THAT(status, IsOk());
+      EXPECT_EQ(expected_ct, ct);
+    }
+  }
+}
+
+TEST(StreamingAeadRandomAccessEncrypterTest, Layout) {
+  auto encrypter = std::move(StreamingAeadRandomAccessEncrypter::New(
+      absl::make_unique<DummyRandomAccessSegmentEncrypter>(
+          /* pt_segment_size = */ 100, /* header_size = */ 10,
+          /* ct_offset = */ 5)).ValueOrDie());
+  int ct_segment_size = 100 + DummyStreamSegmentEncrypter::kSegmentTagSize;
+  EXPECT_EQ(5, encrypter->get_header_position());
+  EXPECT_EQ(85, encrypter->GetPlaintextSegmentSize(0));
+  EXPECT_EQ(100, encrypter->GetPlaintextSegmentSize(1));
+  EXPECT_EQ(0, encrypter->GetPlaintextPosition(0));
+  EXPECT_EQ(85, encrypter->GetPlaintextPosition(1));
+  EXPECT_EQ(285, encrypter->GetPlaintextPosition(3));
+  EXPECT_EQ(15, encrypter->GetCiphertextPosition(0));
+  EXPECT_EQ(ct_segment_size, encrypter->GetCiphertextPosition(1));
+  EXPECT_EQ(3 * ct_segment_size, encrypter->GetCiphertextPosition(3));
+  EXPECT_EQ(1, encrypter->GetNumberOfSegments(0));
+  EXPECT_EQ(1, encrypter->GetNumberOfSegments(85));
+  EXPECT_EQ(2, encrypter->GetNumberOfSegments(86));
+  EXPECT_EQ(2, encrypter->GetNumberOfSegments(185));
+  EXPECT_EQ(3, encrypter->GetNumberOfSegments(186));
+}
+
+TEST(StreamingAeadRandomAccessEncrypterTest, InvalidSegments) {
+  auto encrypter = std::move(StreamingAeadRandomAccessEncrypter::New(
+      absl::make_unique<DummyRandomAccessSegmentEncrypter>(
+          /* pt_segment_size = */ 100, /* header_size = */ 10,
+          /* ct_offset = */ 0)).ValueOrDie());
+  std::string ct;
+  // Only the last segment may be shorter than a full segment.
+  EXPECT_THAT(encrypter->EncryptSegment(1, std::string(99, 'a'), false, &ct),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(encrypter->EncryptSegment(1, std::string(99, 'a'), true, &ct),
+              IsOk());
+  EXPECT_THAT(encrypter->EncryptSegment(0, std::string(90, 'a'), false, &ct),
+              IsOk());
+  EXPECT_THAT(encrypter->EncryptSegment(0, std::string(91, 'a'), true, &ct),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  // Only a stream without plaintext ends with an empty segment.
+  EXPECT_THAT(encrypter->EncryptSegment(0, "", true, &ct), IsOk());
+  EXPECT_THAT(encrypter->EncryptSegment(2, "", true, &ct),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(encrypter->EncryptSegment(-1, "", true, &ct),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(StreamingAeadRandomAccessEncrypterTest, UnsupportedSegmentEncrypter) {
+  // DummyStreamSegmentEncrypter does not implement EncryptSegmentAt().
+  auto encrypter = std::move(StreamingAeadRandomAccessEncrypter::New(
+      absl::make_unique<DummyStreamSegmentEncrypter>(100, 10, 0))
+                                 .ValueOrDie());
+  std::string ct;
+  EXPECT_THAT(encrypter->EncryptSegment(0, "plaintext", true, &ct),
+              StatusIs(util::error::UNIMPLEMENTED));
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,149 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/streaming_aead_record_decrypter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "tink/subtle/stream_segment_decrypter.h"
+#include "tink/subtle/streaming_aead_record_encrypter.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+using crypto::tink::util::Status;
+using crypto::tink::util::StatusOr;
+
+// static
+StatusOr<std::unique_ptr<StreamingAeadRecordDecrypter>>
+StreamingAeadRecordDecrypter::New(
+    std::unique_ptr<StreamSegmentDecrypter> segment_decrypter) {
+  if (segment_decrypter == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "segment_decrypter must be non-null");
+  }
+  return {absl::WrapUnique(
+      new StreamingAeadRecordDecrypter(std::move(segment_decrypter)))};
+}
+
+StreamingAeadRecordDecrypter::StreamingAeadRecordDecrypter(
+    std::unique_ptr<StreamSegmentDecrypter> segment_decrypter)
+    : segment_decrypter_(std::move(segment_decrypter)),
+      overhead_(segment_decrypter_->get_ciphertext_segment_size() -
+                segment_decrypter_->get_plaintext_segment_size()),
+      state_(State::kHeader),
+      expected_size_(segment_decrypter_->get_header_size()),
+      record_number_(0),
+      is_closed_(false) {}
+
+Status StreamingAeadRecordDecrypter::DecryptRecord(
+    std::vector<std::string>* messages) {
+  Status status = segment_decrypter_->DecryptSegment(
+      buffer_, record_number_, /* is_last_segment = */ false, &pt_buffer_);
+  if (!status.ok() && buffer_.size() == overhead_) {
+    // Only an empty record can be the last one.
+    Status last_status = segment_decrypter_->DecryptSegment(
+        buffer_, record_number_, /* is_last_segment = */ true, &pt_buffer_);
+    if (!last_status.ok()) return status;
+    is_closed_ = true;
+    return Status::OK;
+  }
+  if (!status.ok()) return status;
+  messages->emplace_back(reinterpret_cast<const char*>(pt_buffer_.data()),
+                         pt_buffer_.size());
+  record_number_++;
+  return Status::OK;
+}
+
+Status StreamingAeadRecordDecrypter::ProcessBuffer(
+    std::vector<std::string>* messages) {
+  switch (state_) {
+    case State::kHeader: {
+      Status status = segment_decrypter_->Init(buffer_);
+      if (!status.ok()) return status;
+      break;
+    }
+    case State::kLength: {
+      uint32_t length = (static_cast<uint32_t>(buffer_[0]) << 24) |
+                        (static_cast<uint32_t>(buffer_[1]) << 16) |
+                        (static_cast<uint32_t>(buffer_[2]) << 8) |
+                        static_cast<uint32_t>(buffer_[3]);
+      if (length < overhead_ ||
+          length > segment_decrypter_->get_ciphertext_segment_size()) {
+        return Status(util::error::INVALID_ARGUMENT,
+                      "Invalid record length.");
+      }
+      buffer_.clear();
+      state_ = State::kRecord;
+      expected_size_ = length;
+      return Status::OK;
+    }
+    case State::kRecord: {
+      Status status = DecryptRecord(messages);
+      if (!status.ok()) return status;
+      break;
+    }
+  }
+  buffer_.clear();
+  state_ = State::kLength;
+  expected_size_ = StreamingAeadRecordEncrypter::kLengthSizeInBytes;
+  return Status::OK;
+}
+
+Status StreamingAeadRecordDecrypter::Update(
+    absl::string_view data, std::vector<std::string>* messages) {
+  if (!status_.ok()) return status_;
+  if (messages == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT, "messages must be non-null");
+  }
+  while (!data.empty()) {
+    if (is_closed_) {
+      status_ = Status(util::error::INVALID_ARGUMENT,
+                       "Data after the last record.");
+      return status_;
+    }
+    size_t count = std::min(expected_size_ - buffer_.size(), data.size());
+    buffer_.insert(buffer_.end(), data.begin(), data.begin() + count);
+    data.remove_prefix(count);
+    if (buffer_.size() < expected_size_) break;
+    status_ = ProcessBuffer(messages);
+    if (!status_.ok()) return status_;
+  }
+  return Status::OK;
+}
+
+Status StreamingAeadRecordDecrypter::Finalize() const {
+  if (!status_.ok()) return status_;
+  if (!is_closed_) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "Record stream ended before the last record.");
+  }
+  return Status::OK;
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
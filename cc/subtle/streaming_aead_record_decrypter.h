@@ -0,0 +1,91 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SUBTLE_STREAMING_AEAD_RECORD_DECRYPTER_H_
+#define TINK_SUBTLE_STREAMING_AEAD_RECORD_DECRYPTER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tink/subtle/stream_segment_decrypter.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// Decrypts a record stream produced by StreamingAeadRecordEncrypter. The
+// data received from the transport is passed to Update() in pieces of any
+// size, and the messages of the records it completes are returned in order.
+// A record that fails to decrypt, e.g. because records were reordered,
+// dropped or modified, makes the decrypter unusable.
+class StreamingAeadRecordDecrypter {
+ public:
+  static crypto::tink::util::StatusOr<
+      std::unique_ptr<StreamingAeadRecordDecrypter>>
+  New(std::unique_ptr<StreamSegmentDecrypter> segment_decrypter);
+
+  StreamingAeadRecordDecrypter(const StreamingAeadRecordDecrypter&) = delete;
+  StreamingAeadRecordDecrypter& operator=(
+      const StreamingAeadRecordDecrypter&) = delete;
+
+  // Takes 'data' as the continuation of the record stream, and appends the
+  // messages of the records it completes to 'messages'. Data following the
+  // last record is an error.
+  crypto::tink::util::Status Update(absl::string_view data,
+                                    std::vector<std::string>* messages);
+
+  // Returns true once the last record, i.e. the one appended by
+  // StreamingAeadRecordEncrypter::Close(), was received.
+  bool is_closed() const { return is_closed_; }
+
+  // Returns OK if the record stream ended with the last record, and an
+  // error if it was truncated. Receivers that need to know that they got all
+  // messages call this once the transport is closed.
+  crypto::tink::util::Status Finalize() const;
+
+ private:
+  explicit StreamingAeadRecordDecrypter(
+      std::unique_ptr<StreamSegmentDecrypter> segment_decrypter);
+
+  // Handles buffer_, which holds the data expected next.
+  crypto::tink::util::Status ProcessBuffer(std::vector<std::string>* messages);
+
+  // Decrypts buffer_ as the next record and appends its message.
+  crypto::tink::util::Status DecryptRecord(std::vector<std::string>* messages);
+
+  enum class State { kHeader, kLength, kRecord };
+
+  std::unique_ptr<StreamSegmentDecrypter> segment_decrypter_;
+  const int overhead_;  // ciphertext size minus plaintext size of a record
+  State state_;  // what buffer_ is being filled with
+  std::vector<uint8_t> buffer_;  // header, length field or record
+  size_t expected_size_;  // size of the data expected in buffer_
+  std::vector<uint8_t> pt_buffer_;  // plaintext of the current record
+  int64_t record_number_;
+  bool is_closed_;
+  crypto::tink::util::Status status_;  // status of the decrypter
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_STREAMING_AEAD_RECORD_DECRYPTER_H_
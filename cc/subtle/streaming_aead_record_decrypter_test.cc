@@ -0,0 +1,198 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/streaming_aead_record_decrypter.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/streaming_aead_record_encrypter.h"
+#include "tink/subtle/subtle_util.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+using crypto::tink::subtle::test::DummyStreamSegmentDecrypter;
+using crypto::tink::subtle::test::DummyStreamSegmentEncrypter;
+using crypto::tink::test::IsOk;
+using crypto::tink::test::StatusIs;
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+constexpr int kSegmentSize = 100;
+constexpr int kHeaderSize = 10;
+
+std::unique_ptr<StreamingAeadRecordDecrypter> GetDecrypter() {
+  auto decrypter_result = StreamingAeadRecordDecrypter::New(
+      absl::make_unique<DummyStreamSegmentDecrypter>(
+          kSegmentSize, kHeaderSize, /* ct_offset = */ 0));
+  EXPECT_THAT(decrypter_result.status(), IsOk());
+  return std::move(decrypter_result.ValueOrDie());
+}
+
+// Returns the header and the records of 'messages', separately so that
+// tests can modify them.
+std::vector<std::string> GetRecords(const std::vector<std::string>& messages,
+                                    bool close) {
+  auto encrypter = std::move(
+      StreamingAeadRecordEncrypter::New(
+          absl::make_unique<DummyStreamSegmentEncrypter>(
+              kSegmentSize, kHeaderSize, /* ct_offset = */ 0))
+          .ValueOrDie());
+  std::vector<std::string> records;
+  records.emplace_back(encrypter->get_header().begin(),
+                       encrypter->get_header().end());
+  for (const std::string& message : messages) {
+    records.emplace_back();
+    EXPECT_THAT(encrypter->EncryptRecord(message, &records.back()), IsOk());
+  }
+  if (close) {
+    records.emplace_back();
+    EXPECT_THAT(encrypter->Close(&records.back()), IsOk());
+  }
+  return records;
+}
+
+// Passes the concatenation of 'records' to Update() in pieces of
+// 'chunk_size', and returns the first error, or the status of Finalize().
+util::Status Decrypt(StreamingAeadRecordDecrypter* decrypter,
+                     const std::vector<std::string>& records, int chunk_size,
+                     std::vector<std::string>* messages) {
+  std::string data = absl::StrJoin(records, "");
+  for (size_t pos = 0; pos < data.size(); pos += chunk_size) {
+    auto status = decrypter->Update(
+        absl::string_view(data).substr(pos, chunk_size), messages);
+    if (!status.ok()) return status;
+  }
+  return decrypter->Finalize();
+}
+
+TEST(StreamingAeadRecordDecrypterTest, RoundTrip) {
+  std::vector<std::string> messages;
+  for (int size : {0, 1, 10, 0, 99, 100, 50, 0}) {
+    messages.push_back(Random::GetRandomBytes(size));
+  }
+  auto records = GetRecords(messages, /* close = */ true);
+  for (int chunk_size : {1, 3, 4, 17, 100, 10000}) {
+    SCOPED_TRACE(absl::StrCat("chunk_size = ", chunk_size));
+    auto decrypter = GetDecrypter();
+    std::vector<std::string> decrypted;
+    EXPECT_THAT(Decrypt(decrypter.get(), records, chunk_size, &decrypted),
+                IsOk());
+    EXPECT_TRUE(decrypter->is_closed());
+    EXPECT_EQ(decrypted, messages);
+  }
+}
+
+TEST(StreamingAeadRecordDecrypterTest, MessagesAreReturnedPerRecord) {
+  auto records = GetRecords({"first", "second"}, /* close = */ true);
+  auto decrypter = GetDecrypter();
+  std::vector<std::string> decrypted;
+  EXPECT_THAT(decrypter->Update(records[0] + records[1], &decrypted), IsOk());
+  EXPECT_EQ(decrypted, std::vector<std::string>({"first"}));
+  EXPECT_THAT(decrypter->Update(records[2], &decrypted), IsOk());
+  EXPECT_EQ(decrypted, std::vector<std::string>({"first", "second"}));
+  EXPECT_FALSE(decrypter->is_closed());
+  EXPECT_THAT(decrypter->Update(records[3], &decrypted), IsOk());
+  EXPECT_TRUE(decrypter->is_closed());
+}
+
+TEST(StreamingAeadRecordDecrypterTest, TruncatedStream) {
+  std::vector<std::string> decrypted;
+  // Without the last record.
+  auto decrypter = GetDecrypter();
+  EXPECT_THAT(Decrypt(decrypter.get(),
+                      GetRecords({"first", "second"}, /* close = */ false),
+                      1000, &decrypted),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  // Within a record.
+  auto records = GetRecords({"first", "second"}, /* close = */ true);
+  records[2].resize(records[2].size() - 1);
+  records.pop_back();
+  decrypter = GetDecrypter();
+  EXPECT_THAT(Decrypt(decrypter.get(), records, 1000, &decrypted),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(StreamingAeadRecordDecrypterTest, ReorderedOrDroppedRecords) {
+  auto records = GetRecords({"first", "second", "third"}, /* close = */ true);
+  std::vector<std::string> decrypted;
+  auto reordered = records;
+  std::swap(reordered[1], reordered[2]);
+  auto decrypter = GetDecrypter();
+  EXPECT_THAT(Decrypt(decrypter.get(), reordered, 1000, &decrypted),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  auto dropped = records;
+  dropped.erase(dropped.begin() + 2);
+  decrypter = GetDecrypter();
+  EXPECT_THAT(Decrypt(decrypter.get(), dropped, 1000, &decrypted),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  // The decrypter cannot be used after an error.
+  EXPECT_THAT(decrypter->Update(records[3], &decrypted),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(StreamingAeadRecordDecrypterTest, DataAfterLastRecord) {
+  auto records = GetRecords({"first"}, /* close = */ true);
+  records.push_back("x");
+  auto decrypter = GetDecrypter();
+  std::vector<std::string> decrypted;
+  EXPECT_THAT(Decrypt(decrypter.get(), records, 1000, &decrypted),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(StreamingAeadRecordDecrypterTest, InvalidRecordLength) {
+  auto records = GetRecords({"first"}, /* close = */ true);
+  std::vector<std::string> decrypted;
+  for (uint32_t length : {0, 8, 1000}) {
+    SCOPED_TRACE(absl::StrCat("length = ", length));
+    auto modified = records;
+    modified[1].replace(0, StreamingAeadRecordEncrypter::kLengthSizeInBytes,
+                        BigEndian32(length));
+    auto decrypter = GetDecrypter();
+    EXPECT_THAT(Decrypt(decrypter.get(), modified, 1000, &decrypted),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+}
+
+TEST(StreamingAeadRecordDecrypterTest, WrongHeader) {
+  auto records = GetRecords({"first"}, /* close = */ true);
+  records[0][0] ^= 1;
+  auto decrypter = GetDecrypter();
+  std::vector<std::string> decrypted;
+  EXPECT_THAT(Decrypt(decrypter.get(), records, 1000, &decrypted),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(StreamingAeadRecordDecrypterTest, NullSegmentDecrypter) {
+  EXPECT_THAT(StreamingAeadRecordDecrypter::New(nullptr).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
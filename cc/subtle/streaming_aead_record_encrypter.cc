@@ -0,0 +1,135 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/streaming_aead_record_encrypter.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/subtle/stream_segment_encrypter.h"
+#include "tink/subtle/subtle_util.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+using crypto::tink::util::Status;
+using crypto::tink::util::StatusOr;
+
+// static
+StatusOr<std::unique_ptr<StreamingAeadRecordEncrypter>>
+StreamingAeadRecordEncrypter::New(
+    std::unique_ptr<StreamSegmentEncrypter> segment_encrypter) {
+  if (segment_encrypter == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "segment_encrypter must be non-null");
+  }
+  return {absl::WrapUnique(
+      new StreamingAeadRecordEncrypter(std::move(segment_encrypter)))};
+}
+
+StreamingAeadRecordEncrypter::StreamingAeadRecordEncrypter(
+    std::unique_ptr<StreamSegmentEncrypter> segment_encrypter)
+    : segment_encrypter_(std::move(segment_encrypter)),
+      overhead_(segment_encrypter_->get_ciphertext_segment_size() -
+                segment_encrypter_->get_plaintext_segment_size()),
+      encrypt_into_supported_(true) {}
+
+Status StreamingAeadRecordEncrypter::AppendRecord(absl::string_view message,
+                                                  bool is_last_record,
+                                                  std::string* records) {
+  if (message.size() > get_max_message_size()) {
+    return Status(util::error::INVALID_ARGUMENT, "message too long");
+  }
+  if (records == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT, "records must be non-null");
+  }
+  int ct_size = message.size() + overhead_;
+  size_t length_pos = records->size();
+  records->append(BigEndian32(ct_size));
+  if (encrypt_into_supported_) {
+    // Encrypts directly into 'records', saving the copies below.
+    size_t ct_pos = records->size();
+    ResizeStringUninitialized(records, ct_pos + ct_size);
+    auto encrypt_result = segment_encrypter_->EncryptSegmentInto(
+        absl::MakeConstSpan(reinterpret_cast<const uint8_t*>(message.data()),
+                            message.size()),
+        is_last_record,
+        absl::MakeSpan(reinterpret_cast<uint8_t*>(&(*records)[ct_pos]),
+                       ct_size));
+    if (encrypt_result.ok()) return Status::OK;
+    records->resize(ct_pos);
+    if (encrypt_result.status().error_code() != util::error::UNIMPLEMENTED) {
+      records->resize(length_pos);
+      return encrypt_result.status();
+    }
+    encrypt_into_supported_ = false;
+  }
+  pt_buffer_.assign(message.begin(), message.end());
+  Status status =
+      segment_encrypter_->EncryptSegment(pt_buffer_, is_last_record,
+                                         &ct_buffer_);
+  if (!status.ok()) {
+    records->resize(length_pos);
+    return status;
+  }
+  records->append(reinterpret_cast<const char*>(ct_buffer_.data()),
+                  ct_buffer_.size());
+  return Status::OK;
+}
+
+Status StreamingAeadRecordEncrypter::EncryptRecord(absl::string_view message,
+                                                   std::string* records) {
+  if (!status_.ok()) return status_;
+  return AppendRecord(message, /* is_last_record = */ false, records);
+}
+
+Status StreamingAeadRecordEncrypter::EncryptRecordAt(
+    absl::string_view message, int64_t record_number, bool is_last_record,
+    std::string* record) const {
+  if (record == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT, "record must be non-null");
+  }
+  std::vector<uint8_t> ct_buffer;
+  Status status = segment_encrypter_->EncryptSegmentAt(
+      std::vector<uint8_t>(message.begin(), message.end()), record_number,
+      is_last_record, &ct_buffer);
+  if (!status.ok()) return status;
+  record->append(BigEndian32(ct_buffer.size()));
+  record->append(reinterpret_cast<const char*>(ct_buffer.data()),
+                 ct_buffer.size());
+  return Status::OK;
+}
+
+Status StreamingAeadRecordEncrypter::Close(std::string* records) {
+  if (!status_.ok()) return status_;
+  status_ = AppendRecord("", /* is_last_record = */ true, records);
+  if (!status_.ok()) return status_;
+  status_ = Status(util::error::FAILED_PRECONDITION, "Encrypter closed");
+  return Status::OK;
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
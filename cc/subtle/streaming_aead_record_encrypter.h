@@ -0,0 +1,120 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SUBTLE_STREAMING_AEAD_RECORD_ENCRYPTER_H_
+#define TINK_SUBTLE_STREAMING_AEAD_RECORD_ENCRYPTER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "tink/subtle/stream_segment_encrypter.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+// Encrypts discrete messages, e.g. of a network protocol, as records of a
+// single ciphertext stream. Unlike encrypting each message with an Aead,
+// all records share the key derived for the stream, and each record costs
+// only a length field and the segment overhead (e.g. the 16-byte tag for
+// AES-GCM-HKDF). The record stream has the layout
+//
+//   | header | length | 1st record | length | 2nd record | ... |
+//
+// where 'header' is get_header() of the segment encrypter, each record is
+// the encryption of one message as a segment of variable size, and each
+// 'length' is the size of the following record as 4-byte big endian
+// integer. The record number is the segment number, so records cannot be
+// reordered, dropped or replayed without detection. Close() appends an
+// empty record marked as the last one, which lets the receiver detect a
+// truncated stream. The ciphertext offset of the segment encrypter is not
+// used.
+class StreamingAeadRecordEncrypter {
+ public:
+  // The size of the length field preceding each record.
+  static constexpr int kLengthSizeInBytes = 4;
+
+  static crypto::tink::util::StatusOr<
+      std::unique_ptr<StreamingAeadRecordEncrypter>>
+  New(std::unique_ptr<StreamSegmentEncrypter> segment_encrypter);
+
+  StreamingAeadRecordEncrypter(const StreamingAeadRecordEncrypter&) = delete;
+  StreamingAeadRecordEncrypter& operator=(
+      const StreamingAeadRecordEncrypter&) = delete;
+
+  // Returns the header, which must be sent before the first record.
+  const std::vector<uint8_t>& get_header() const {
+    return segment_encrypter_->get_header();
+  }
+
+  // Returns the maximal size of a message, i.e. the plaintext segment size.
+  int get_max_message_size() const {
+    return segment_encrypter_->get_plaintext_segment_size();
+  }
+
+  // Returns the number of the record that EncryptRecord() encrypts next.
+  int64_t get_record_number() const {
+    return segment_encrypter_->get_segment_number();
+  }
+
+  // Encrypts 'message' as the next record, and appends it together with
+  // its length field to 'records'.
+  crypto::tink::util::Status EncryptRecord(absl::string_view message,
+                                           std::string* records);
+
+  // Encrypts 'message' as the record with number 'record_number', like
+  // EncryptRecord() but without using or changing the current record
+  // number. This may be called concurrently, so that records can be
+  // encrypted in a pipeline and sent in the order of their numbers; the
+  // caller must never use a record number twice, and must not mix this with
+  // EncryptRecord() or Close(). Requires a segment encrypter that supports
+  // EncryptSegmentAt(), such as the one of AES-GCM-HKDF.
+  crypto::tink::util::Status EncryptRecordAt(absl::string_view message,
+                                             int64_t record_number,
+                                             bool is_last_record,
+                                             std::string* record) const;
+
+  // Appends the last record, which is empty, to 'records'. Afterwards the
+  // encrypter cannot be used anymore.
+  crypto::tink::util::Status Close(std::string* records);
+
+ private:
+  explicit StreamingAeadRecordEncrypter(
+      std::unique_ptr<StreamSegmentEncrypter> segment_encrypter);
+
+  // Encrypts 'message' as the next segment and appends it to 'records'.
+  crypto::tink::util::Status AppendRecord(absl::string_view message,
+                                          bool is_last_record,
+                                          std::string* records);
+
+  std::unique_ptr<StreamSegmentEncrypter> segment_encrypter_;
+  const int overhead_;  // ciphertext size minus plaintext size of a record
+  bool encrypt_into_supported_;
+  std::vector<uint8_t> pt_buffer_;  // used if EncryptSegmentInto() is not
+  std::vector<uint8_t> ct_buffer_;  // supported by segment_encrypter_
+  crypto::tink::util::Status status_;  // status of the encrypter
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_STREAMING_AEAD_RECORD_ENCRYPTER_H_
@@ -0,0 +1,107 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/streaming_aead_record_encrypter.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "tink/subtle/subtle_util.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+using crypto::tink::subtle::test::DummyStreamSegmentEncrypter;
+using crypto::tink::test::IsOk;
+using crypto::tink::test::StatusIs;
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+std::unique_ptr<StreamingAeadRecordEncrypter> GetEncrypter(
+    int pt_segment_size) {
+  auto encrypter_result = StreamingAeadRecordEncrypter::New(
+      absl::make_unique<DummyStreamSegmentEncrypter>(pt_segment_size,
+                                                     /* header_size = */ 10,
+                                                     /* ct_offset = */ 0));
+  EXPECT_THAT(encrypter_result.status(), IsOk());
+  return std::move(encrypter_result.ValueOrDie());
+}
+
+// Returns the record that DummyStreamSegmentEncrypter produces for
+// 'message', preceded by its length field.
+std::string ExpectedRecord(absl::string_view message, int64_t record_number,
+                           bool is_last_record) {
+  std::string record(message);
+  record.append(reinterpret_cast<const char*>(&record_number),
+                sizeof(record_number));
+  record.append(1, is_last_record ? DummyStreamSegmentEncrypter::kLastSegment
+                                  : DummyStreamSegmentEncrypter::kNotLastSegment);
+  return BigEndian32(record.size()) + record;
+}
+
+TEST(StreamingAeadRecordEncrypterTest, RecordLayout) {
+  auto encrypter = GetEncrypter(100);
+  EXPECT_EQ(encrypter->get_header(), std::vector<uint8_t>(10, 'h'));
+  EXPECT_EQ(encrypter->get_max_message_size(), 100);
+  std::string records;
+  std::string expected;
+  std::vector<std::string> messages = {"first", "", std::string(100, 'x')};
+  for (int i = 0; i < messages.size(); i++) {
+    EXPECT_EQ(encrypter->get_record_number(), i);
+    EXPECT_THAT(encrypter->EncryptRecord(messages[i], &records), IsOk());
+    expected += ExpectedRecord(messages[i], i, false);
+  }
+  EXPECT_THAT(encrypter->Close(&records), IsOk());
+  expected += ExpectedRecord("", messages.size(), true);
+  EXPECT_EQ(records, expected);
+}
+
+TEST(StreamingAeadRecordEncrypterTest, MessageTooLong) {
+  auto encrypter = GetEncrypter(100);
+  std::string records;
+  EXPECT_THAT(encrypter->EncryptRecord(std::string(101, 'x'), &records),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_EQ(records, "");
+  // The encrypter remains usable.
+  EXPECT_THAT(encrypter->EncryptRecord("message", &records), IsOk());
+  EXPECT_EQ(records, ExpectedRecord("message", 0, false));
+}
+
+TEST(StreamingAeadRecordEncrypterTest, UseAfterClose) {
+  auto encrypter = GetEncrypter(100);
+  std::string records;
+  EXPECT_THAT(encrypter->Close(&records), IsOk());
+  EXPECT_THAT(encrypter->EncryptRecord("message", &records),
+              StatusIs(util::error::FAILED_PRECONDITION));
+  EXPECT_THAT(encrypter->Close(&records),
+              StatusIs(util::error::FAILED_PRECONDITION));
+}
+
+TEST(StreamingAeadRecordEncrypterTest, NullSegmentEncrypter) {
+  EXPECT_THAT(StreamingAeadRecordEncrypter::New(nullptr).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
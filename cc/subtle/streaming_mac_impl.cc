@@ -16,7 +16,13 @@
 
 #include "tink/subtle/streaming_mac_impl.h"
 
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
 #include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
 #include "tink/util/status.h"
 
 namespace crypto {
@@ -27,17 +33,62 @@ namespace {
 constexpr size_t kBufferSize = 4096;
 }
 
+constexpr int StreamingMacImpl::kMaxPooledMacs;
+
+class StatefulMacPool {
+ public:
+  explicit StatefulMacPool(std::unique_ptr<StatefulMacFactory> mac_factory)
+      : mac_factory_(std::move(mac_factory)) {}
+
+  // Returns an idle StatefulMac, or a new one if there is none.
+  util::StatusOr<std::unique_ptr<StatefulMac>> Take() {
+    {
+      absl::MutexLock lock(&mutex_);
+      if (!idle_macs_.empty()) {
+        std::unique_ptr<StatefulMac> mac = std::move(idle_macs_.back());
+        idle_macs_.pop_back();
+        return std::move(mac);
+      }
+    }
+    return mac_factory_->Create();
+  }
+
+  // Resets 'mac' and keeps it for Take(), unless it cannot be reset or the
+  // pool is full.
+  void Return(std::unique_ptr<StatefulMac> mac) {
+    if (mac == nullptr || !mac->Reset().ok()) return;
+    absl::MutexLock lock(&mutex_);
+    if (idle_macs_.size() <
+        static_cast<size_t>(StreamingMacImpl::kMaxPooledMacs)) {
+      idle_macs_.push_back(std::move(mac));
+    }
+  }
+
+ private:
+  const std::unique_ptr<StatefulMacFactory> mac_factory_;
+  absl::Mutex mutex_;
+  std::vector<std::unique_ptr<StatefulMac>> idle_macs_ ABSL_GUARDED_BY(mutex_);
+};
+
+StreamingMacImpl::StreamingMacImpl(
+    std::unique_ptr<StatefulMacFactory> mac_factory)
+    : mac_pool_(std::make_shared<StatefulMacPool>(std::move(mac_factory))) {}
+
 class ComputeMacOutputStream : public OutputStreamWithResult<std::string> {
  public:
-  explicit ComputeMacOutputStream(std::unique_ptr<StatefulMac> mac)
+  ComputeMacOutputStream(std::unique_ptr<StatefulMac> mac,
+                         std::shared_ptr<StatefulMacPool> mac_pool)
       : status_(util::OkStatus()),
         mac_(std::move(mac)),
+        mac_pool_(std::move(mac_pool)),
         position_(0),
         buffer_position_(0),
         buffer_("") {
     buffer_.resize(kBufferSize);
   }
 
+  ~ComputeMacOutputStream() override { mac_pool_->Return(std::move(mac_)); }
+
   util::StatusOr<int> NextBuffer(void** buffer) override;
   util::StatusOr<std::string> CloseStreamAndComputeResult() override;
   void BackUp(int count) override;
@@ -47,7 +98,8 @@ class ComputeMacOutputStream : public OutputStreamWithResult<std::string> {
   void WriteIntoMac();
 
   util::Status status_;
-  const std::unique_ptr<StatefulMac> mac_;
+  std::unique_ptr<StatefulMac> mac_;
+  const std::shared_ptr<StatefulMacPool> mac_pool_;
   int64_t position_;
   int buffer_position_;
   std::string buffer_;
@@ -55,8 +107,7 @@ class ComputeMacOutputStream : public OutputStreamWithResult<std::string> {
 
 util::StatusOr<std::unique_ptr<OutputStreamWithResult<std::string>>>
 StreamingMacImpl::NewComputeMacOutputStream() const {
-  util::StatusOr<std::unique_ptr<StatefulMac>> mac_status =
-      mac_factory_->Create();
+  util::StatusOr<std::unique_ptr<StatefulMac>> mac_status = mac_pool_->Take();
 
   if (!mac_status.ok()) {
     return mac_status.status();
@@ -64,7 +115,7 @@ StreamingMacImpl::NewComputeMacOutputStream() const {
 
   std::unique_ptr<OutputStreamWithResult<std::string>> string_to_return =
       absl::make_unique<ComputeMacOutputStream>(
-          std::move(mac_status.ValueOrDie()));
+          std::move(mac_status.ValueOrDie()), mac_pool_);
   return string_to_return;
 }
 
@@ -109,9 +160,11 @@ void ComputeMacOutputStream::WriteIntoMac() {
 class VerifyMacOutputStream : public OutputStreamWithResult<util::Status> {
  public:
   VerifyMacOutputStream(const std::string& expected,
-                        std::unique_ptr<StatefulMac> mac)
+                        std::unique_ptr<StatefulMac> mac,
+                        std::shared_ptr<StatefulMacPool> mac_pool)
       : status_(util::OkStatus()),
         mac_(std::move(mac)),
+        mac_pool_(std::move(mac_pool)),
         position_(0),
         buffer_position_(0),
         buffer_(""),
@@ -119,6 +172,8 @@ class VerifyMacOutputStream : public OutputStreamWithResult<util::Status> {
     buffer_.resize(kBufferSize);
   }
 
+  ~VerifyMacOutputStream() override { mac_pool_->Return(std::move(mac_)); }
+
   util::StatusOr<int> NextBuffer(void** buffer) override;
 
   util::Status CloseStreamAndComputeResult() override;
@@ -133,6 +188,7 @@ class VerifyMacOutputStream : public OutputStreamWithResult<util::Status> {
   // changed to ERROR:FAILED_PRECONDITION when the stream is closed.
   util::Status status_;
   std::unique_ptr<StatefulMac> mac_;
+  const std::shared_ptr<StatefulMacPool> mac_pool_;
   int64_t position_;
   int buffer_position_;
   std::string buffer_;
@@ -185,14 +241,13 @@ void VerifyMacOutputStream::WriteIntoMac() {
 
 util::StatusOr<std::unique_ptr<OutputStreamWithResult<util::Status>>>
 StreamingMacImpl::NewVerifyMacOutputStream(const std::string& mac_value) const {
-  util::StatusOr<std::unique_ptr<StatefulMac>> mac_status =
-      mac_factory_->Create();
+  util::StatusOr<std::unique_ptr<StatefulMac>> mac_status = mac_pool_->Take();
   if (!mac_status.ok()) {
     return mac_status.status();
   }
   return std::unique_ptr<OutputStreamWithResult<util::Status>>(
       absl::make_unique<VerifyMacOutputStream>(
-          mac_value, std::move(mac_status.ValueOrDie())));
+          mac_value, std::move(mac_status.ValueOrDie()), mac_pool_));
 }
 }  // namespace subtle
 }  // namespace tink
@@ -27,11 +27,18 @@ namespace crypto {
 namespace tink {
 namespace subtle {
 
+class StatefulMacPool;
+
+// Streams take their StatefulMac from a pool: once a stream is destroyed, its
+// StatefulMac is Reset() and kept for the next stream, so that computing
+// many small MACs does not create and key a new StatefulMac for each.
 class StreamingMacImpl : public StreamingMac {
  public:
+  // The maximum number of idle StatefulMacs kept for reuse.
+  static constexpr int kMaxPooledMacs = 16;
+
   // Constructor
-  explicit StreamingMacImpl(std::unique_ptr<StatefulMacFactory> mac_factory)
-      : mac_factory_(std::move(mac_factory)) {}
+  explicit StreamingMacImpl(std::unique_ptr<StatefulMacFactory> mac_factory);
 
   // Implement streaming mac class functions
   // Returns an ComputeMacOutputStream, which when closed will return the
@@ -45,7 +52,8 @@ class StreamingMacImpl : public StreamingMac {
   NewVerifyMacOutputStream(const std::string& mac_value) const override;
 
  private:
-  std::unique_ptr<StatefulMacFactory> mac_factory_;
+  // Shared with the streams, which may outlive this object.
+  const std::shared_ptr<StatefulMacPool> mac_pool_;
 };
 
 }  // namespace subtle
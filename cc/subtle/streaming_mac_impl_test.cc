@@ -16,6 +16,11 @@
 
 #include "tink/subtle/streaming_mac_impl.h"
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "tink/subtle/random.h"
 #include "tink/subtle/test_util.h"
@@ -252,6 +257,104 @@ TEST(StreamingMacImplTest, VerifyCloseTwiceError) {
   EXPECT_EQ(util::error::FAILED_PRECONDITION, reclose_status.error_code());
 }
 
+// Counts the StatefulMacs it creates, which can optionally not be reset.
+class CountingStatefulMacFactory : public StatefulMacFactory {
+ public:
+  explicit CountingStatefulMacFactory(bool resettable, int* created)
+      : resettable_(resettable), created_(created) {}
+
+  util::StatusOr<std::unique_ptr<StatefulMac>> Create() const override {
+    ++*created_;
+    if (resettable_) {
+      return std::unique_ptr<StatefulMac>(
+          absl::make_unique<DummyStatefulMac>("streaming mac:"));
+    }
+    return std::unique_ptr<StatefulMac>(
+        absl::make_unique<UnresettableStatefulMac>());
+  }
+
+ private:
+  class UnresettableStatefulMac : public StatefulMac {
+   public:
+    util::Status Update(absl::string_view data) override {
+      return mac_.Update(data);
+    }
+    util::StatusOr<std::string> Finalize() override { return mac_.Finalize(); }
+
+   private:
+    DummyStatefulMac mac_{"streaming mac:"};
+  };
+
+  const bool resettable_;
+  int* const created_;
+};
+
+TEST(StreamingMacImplTest, ReusesStatefulMacs) {
+  int created = 0;
+  StreamingMacImpl streaming_mac(
+      absl::make_unique<CountingStatefulMacFactory>(true, &created));
+  for (int i = 0; i < 3; i++) {
+    auto compute_stream = streaming_mac.NewComputeMacOutputStream();
+    ASSERT_THAT(compute_stream.status(), IsOk());
+    EXPECT_THAT(test::WriteToStream(compute_stream.ValueOrDie().get(),
+                                    "message", false),
+                IsOk());
+    auto mac = compute_stream.ValueOrDie()->CloseAndGetResult();
+    ASSERT_THAT(mac.status(), IsOk());
+    EXPECT_EQ(mac.ValueOrDie(), "23:7:DummyMac:streaming mac:message");
+    compute_stream.ValueOrDie().reset();
+
+    // A stream which is not closed also returns its StatefulMac, without
+    // leaking its data into the next stream.
+    auto verify_stream =
+        streaming_mac.NewVerifyMacOutputStream(mac.ValueOrDie());
+    ASSERT_THAT(verify_stream.status(), IsOk());
+    EXPECT_THAT(test::WriteToStream(verify_stream.ValueOrDie().get(),
+                                    "garbage", false),
+                IsOk());
+  }
+  EXPECT_EQ(created, 1);
+}
+
+TEST(StreamingMacImplTest, ConcurrentStreamsUseDistinctStatefulMacs) {
+  int created = 0;
+  StreamingMacImpl streaming_mac(
+      absl::make_unique<CountingStatefulMacFactory>(true, &created));
+  std::vector<std::unique_ptr<OutputStreamWithResult<std::string>>> streams;
+  for (int i = 0; i < StreamingMacImpl::kMaxPooledMacs + 2; i++) {
+    auto stream = streaming_mac.NewComputeMacOutputStream();
+    ASSERT_THAT(stream.status(), IsOk());
+    streams.push_back(std::move(stream.ValueOrDie()));
+  }
+  EXPECT_EQ(created, StreamingMacImpl::kMaxPooledMacs + 2);
+  streams.clear();
+
+  // Only kMaxPooledMacs were kept.
+  for (int i = 0; i < StreamingMacImpl::kMaxPooledMacs + 2; i++) {
+    auto stream = streaming_mac.NewComputeMacOutputStream();
+    ASSERT_THAT(stream.status(), IsOk());
+    streams.push_back(std::move(stream.ValueOrDie()));
+  }
+  EXPECT_EQ(created, StreamingMacImpl::kMaxPooledMacs + 4);
+}
+
+TEST(StreamingMacImplTest, DoesNotReuseUnresettableStatefulMacs) {
+  int created = 0;
+  StreamingMacImpl streaming_mac(
+      absl::make_unique<CountingStatefulMacFactory>(false, &created));
+  for (int i = 0; i < 2; i++) {
+    auto stream = streaming_mac.NewComputeMacOutputStream();
+    ASSERT_THAT(stream.status(), IsOk());
+    EXPECT_THAT(
+        test::WriteToStream(stream.ValueOrDie().get(), "message", false),
+        IsOk());
+    auto mac = stream.ValueOrDie()->CloseAndGetResult();
+    ASSERT_THAT(mac.status(), IsOk());
+    EXPECT_EQ(mac.ValueOrDie(), "23:7:DummyMac:streaming mac:message");
+  }
+  EXPECT_EQ(created, 2);
+}
+
 }  // namespace
 }  // namespace subtle
 }  // namespace tink
@@ -282,33 +282,39 @@ util::StatusOr<util::SecretData> SubtleUtilBoringSSL::ComputeEcdhSharedSecret(
     return status_or_ec_group.status();
   }
   bssl::UniquePtr<EC_GROUP> priv_group(status_or_ec_group.ValueOrDie());
-  bssl::UniquePtr<EC_POINT> shared_point(EC_POINT_new(priv_group.get()));
+  return ComputeEcdhSharedSecret(priv_group.get(), priv_key, pub_key);
+}
+
+// static
+util::StatusOr<util::SecretData> SubtleUtilBoringSSL::ComputeEcdhSharedSecret(
+    const EC_GROUP *priv_group, const BIGNUM *priv_key,
+    const EC_POINT *pub_key) {
+  bssl::UniquePtr<EC_POINT> shared_point(EC_POINT_new(priv_group));
   // BoringSSL's EC_POINT_set_affine_coordinates_GFp documentation says that
   // "unlike with OpenSSL, it's considered an error if the point is not on the
   // curve". To be sure, we double check here.
-  if (1 != EC_POINT_is_on_curve(priv_group.get(), pub_key, nullptr)) {
+  if (1 != EC_POINT_is_on_curve(priv_group, pub_key, nullptr)) {
     return util::Status(util::error::INTERNAL, "Point is not on curve");
   }
   // Compute the shared point.
-  if (1 != EC_POINT_mul(priv_group.get(), shared_point.get(), nullptr, pub_key,
+  if (1 != EC_POINT_mul(priv_group, shared_point.get(), nullptr, pub_key,
                         priv_key, nullptr)) {
     return util::Status(util::error::INTERNAL, "Point multiplication failed");
   }
   // Check for buggy computation.
-  if (1 !=
-      EC_POINT_is_on_curve(priv_group.get(), shared_point.get(), nullptr)) {
+  if (1 != EC_POINT_is_on_curve(priv_group, shared_point.get(), nullptr)) {
     return util::Status(util::error::INTERNAL, "Shared point is not on curve");
   }
   // Get shared point's x coordinate.
   bssl::UniquePtr<BIGNUM> shared_x(BN_new());
-  if (1 !=
-      EC_POINT_get_affine_coordinates_GFp(priv_group.get(), shared_point.get(),
-                                          shared_x.get(), nullptr, nullptr)) {
+  if (1 != EC_POINT_get_affine_coordinates_GFp(priv_group, shared_point.get(),
+                                               shared_x.get(), nullptr,
+                                               nullptr)) {
     return util::Status(util::error::INTERNAL,
                         "EC_POINT_get_affine_coordinates_GFp failed");
   }
   return BignumToSecretData(shared_x.get(),
-                            FieldElementSizeInBytes(priv_group.get()));
+                            FieldElementSizeInBytes(priv_group));
 }
 
 // static
@@ -319,8 +325,14 @@ util::StatusOr<bssl::UniquePtr<EC_POINT>> SubtleUtilBoringSSL::EcPointDecode(
     return status_or_ec_group.status();
   }
   bssl::UniquePtr<EC_GROUP> group(status_or_ec_group.ValueOrDie());
-  bssl::UniquePtr<EC_POINT> point(EC_POINT_new(group.get()));
-  unsigned curve_size_in_bytes = (EC_GROUP_get_degree(group.get()) + 7) / 8;
+  return EcPointDecode(group.get(), format, encoded);
+}
+
+// static
+util::StatusOr<bssl::UniquePtr<EC_POINT>> SubtleUtilBoringSSL::EcPointDecode(
+    const EC_GROUP *group, EcPointFormat format, absl::string_view encoded) {
+  bssl::UniquePtr<EC_POINT> point(EC_POINT_new(group));
+  unsigned curve_size_in_bytes = (EC_GROUP_get_degree(group) + 7) / 8;
   switch (format) {
     case EcPointFormat::UNCOMPRESSED: {
       if (static_cast<int>(encoded[0]) != 0x04) {
@@ -335,7 +347,7 @@ util::StatusOr<bssl::UniquePtr<EC_POINT>> SubtleUtilBoringSSL::EcPointDecode(
                              encoded.size(), 1 + 2 * curve_size_in_bytes));
       }
       if (1 !=
-          EC_POINT_oct2point(group.get(), point.get(),
+          EC_POINT_oct2point(group, point.get(),
                              reinterpret_cast<const uint8_t *>(encoded.data()),
                              encoded.size(), nullptr)) {
         return util::Status(util::error::INTERNAL, "EC_POINT_toc2point failed");
@@ -368,7 +380,7 @@ util::StatusOr<bssl::UniquePtr<EC_POINT>> SubtleUtilBoringSSL::EcPointDecode(
         return util::Status(util::error::INTERNAL,
                             "Openssl internal error extracting y coordinate");
       }
-      if (1 != EC_POINT_set_affine_coordinates_GFp(group.get(), point.get(),
+      if (1 != EC_POINT_set_affine_coordinates_GFp(group, point.get(),
                                                    x.get(), y.get(), nullptr)) {
         return util::Status(util::error::INTERNAL,
                             "Openssl internal error setting coordinates");
@@ -383,7 +395,7 @@ util::StatusOr<bssl::UniquePtr<EC_POINT>> SubtleUtilBoringSSL::EcPointDecode(
                             "0x03, but input doesn't");
       }
       if (1 !=
-          EC_POINT_oct2point(group.get(), point.get(),
+          EC_POINT_oct2point(group, point.get(),
                              reinterpret_cast<const uint8_t *>(encoded.data()),
                              encoded.size(), nullptr)) {
         return util::Status(util::error::INTERNAL, "EC_POINT_oct2point failed");
@@ -393,7 +405,7 @@ util::StatusOr<bssl::UniquePtr<EC_POINT>> SubtleUtilBoringSSL::EcPointDecode(
     default:
       return util::Status(util::error::INTERNAL, "Unsupported format");
   }
-  if (1 != EC_POINT_is_on_curve(group.get(), point.get(), nullptr)) {
+  if (1 != EC_POINT_is_on_curve(group, point.get(), nullptr)) {
     return util::Status(util::error::INTERNAL, "Point is not on curve");
   }
   return {std::move(point)};
@@ -796,6 +808,22 @@ SubtleUtilBoringSSL::BoringSslRsaFromRsaPublicKey(
   return rsa;
 }
 
+// static
+util::Status SubtleUtilBoringSSL::PrecomputeRsaPublicKey(RSA *rsa) {
+  // 1^e mod n is a valid input for any modulus, and cheap to compute.
+  std::vector<uint8_t> input(RSA_size(rsa), 0);
+  input.back() = 1;
+  std::vector<uint8_t> output(input.size());
+  size_t output_length;
+  if (1 != RSA_verify_raw(rsa, &output_length, output.data(), output.size(),
+                          input.data(), input.size(), RSA_NO_PADDING)) {
+    return util::Status(
+        util::error::INTERNAL,
+        absl::StrCat("RSA precomputation failed: ", GetErrors()));
+  }
+  return util::Status::OK;
+}
+
 // static
 const EVP_CIPHER *SubtleUtilBoringSSL::GetAesCtrCipherForKeySize(
     uint32_t size_in_bytes) {
@@ -166,6 +166,11 @@ class SubtleUtilBoringSSL {
   static util::StatusOr<bssl::UniquePtr<EC_POINT>> EcPointDecode(
       EllipticCurveType curve, EcPointFormat format, absl::string_view encoded);
 
+  // Same as above, but uses the existing 'group' instead of creating the group
+  // of the curve.
+  static util::StatusOr<bssl::UniquePtr<EC_POINT>> EcPointDecode(
+      const EC_GROUP *group, EcPointFormat format, absl::string_view encoded);
+
   // Returns the encoded public key based on curve type, point format and
   // BoringSSL's EC_POINT public key point. The uncompressed point is encoded as
   // 0x04 || x || y where x, y are curve_size_in_bytes big-endian byte array.
@@ -180,6 +185,11 @@ class SubtleUtilBoringSSL {
   static crypto::tink::util::StatusOr<util::SecretData> ComputeEcdhSharedSecret(
       EllipticCurveType curve, const BIGNUM *priv_key, const EC_POINT *pub_key);
 
+  // Same as above, but uses the existing 'group' instead of creating the group
+  // of the curve.
+  static crypto::tink::util::StatusOr<util::SecretData> ComputeEcdhSharedSecret(
+      const EC_GROUP *group, const BIGNUM *priv_key, const EC_POINT *pub_key);
+
   // Transforms ECDSA IEEE_P1363 signature encoding to DER encoding.
   //
   // The IEEE_P1363 signature's format is r || s, where r and s are zero-padded
@@ -245,6 +255,12 @@ class SubtleUtilBoringSSL {
   static util::StatusOr<bssl::UniquePtr<RSA>> BoringSslRsaFromRsaPublicKey(
       const RsaPublicKey &key);
 
+  // Runs one public key operation with 'rsa'. BoringSSL creates the
+  // Montgomery context for the modulus on the first such operation, under a
+  // write lock on the key; doing it here keeps that cost and the lock
+  // contention out of the first concurrent verifications.
+  static util::Status PrecomputeRsaPublicKey(RSA *rsa);
+
   // Returns BoringSSL's AES CTR EVP_CIPHER for the key size.
   static const EVP_CIPHER *GetAesCtrCipherForKeySize(uint32_t size_in_bytes);
 
@@ -17,6 +17,7 @@
 #ifndef TINK_SUBTLE_TEST_UTIL_H_
 #define TINK_SUBTLE_TEST_UTIL_H_
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -235,7 +236,8 @@ class DummyStreamSegmentDecrypter : public StreamSegmentDecrypter {
   std::vector<uint8_t> header_;
   int pt_segment_size_;
   int ct_offset_;
-  int64_t generated_output_size_;
+  // Atomic, as segments may be decrypted concurrently.
+  std::atomic<int64_t> generated_output_size_;
 };   // class DummyStreamSegmentDecrypter
 
 class DummyStreamingAead : public NonceBasedStreamingAead {
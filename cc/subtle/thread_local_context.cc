@@ -0,0 +1,117 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/thread_local_context.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+namespace {
+
+// Guards the lists of caches of all contexts, and is held whenever states are
+// added or removed. Taken before the mutex of a cache.
+absl::Mutex* RegistryMutex() {
+  // Never destroyed: caches may be destroyed during static destruction.
+  static absl::Mutex* mutex = new absl::Mutex();
+  return mutex;
+}
+
+}  // namespace
+
+namespace internal {
+
+// The states of one thread, by context.
+struct ThreadContextCache {
+  struct Slot {
+    void* state;
+    ThreadLocalContextBase::Deleter deleter;
+  };
+
+  ~ThreadContextCache();
+
+  // Only contended when a context is destroyed while this thread holds a
+  // state of it.
+  absl::Mutex mutex;
+  absl::flat_hash_map<const ThreadLocalContextBase*, Slot> slots
+      ABSL_GUARDED_BY(mutex);
+};
+
+}  // namespace internal
+
+namespace {
+
+// Set once the cache of the thread is destroyed; states created after that,
+// e.g. by destructors of other thread-local objects, are not cached.
+thread_local bool thread_cache_destroyed = false;
+thread_local internal::ThreadContextCache thread_cache;
+
+}  // namespace
+
+namespace internal {
+
+ThreadContextCache::~ThreadContextCache() {
+  thread_cache_destroyed = true;
+  absl::MutexLock registry_lock(RegistryMutex());
+  absl::MutexLock lock(&mutex);
+  for (const auto& entry : slots) {
+    std::vector<ThreadContextCache*>& caches = entry.first->caches_;
+    caches.erase(std::find(caches.begin(), caches.end(), this));
+    entry.second.deleter(entry.second.state);
+  }
+  slots.clear();
+}
+
+}  // namespace internal
+
+ThreadLocalContextBase::~ThreadLocalContextBase() {
+  absl::MutexLock registry_lock(RegistryMutex());
+  for (internal::ThreadContextCache* cache : caches_) {
+    absl::MutexLock lock(&cache->mutex);
+    auto it = cache->slots.find(this);
+    it->second.deleter(it->second.state);
+    cache->slots.erase(it);
+  }
+}
+
+void* ThreadLocalContextBase::Find() const {
+  if (thread_cache_destroyed) return nullptr;
+  internal::ThreadContextCache& cache = thread_cache;
+  absl::MutexLock lock(&cache.mutex);
+  auto it = cache.slots.find(this);
+  return it == cache.slots.end() ? nullptr : it->second.state;
+}
+
+bool ThreadLocalContextBase::Store(void* state, Deleter deleter) const {
+  if (thread_cache_destroyed) return false;
+  internal::ThreadContextCache& cache = thread_cache;
+  absl::MutexLock registry_lock(RegistryMutex());
+  absl::MutexLock lock(&cache.mutex);
+  cache.slots[this] = {state, deleter};
+  caches_.push_back(&cache);
+  return true;
+}
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
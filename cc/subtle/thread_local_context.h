@@ -0,0 +1,128 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_SUBTLE_THREAD_LOCAL_CONTEXT_H_
+#define TINK_SUBTLE_THREAD_LOCAL_CONTEXT_H_
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+
+namespace internal {
+struct ThreadContextCache;
+}  // namespace internal
+
+// The part of ThreadLocalContext<T> which does not depend on T.
+class ThreadLocalContextBase {
+ public:
+  ThreadLocalContextBase(const ThreadLocalContextBase&) = delete;
+  ThreadLocalContextBase& operator=(const ThreadLocalContextBase&) = delete;
+
+ protected:
+  using Deleter = void (*)(void*);
+
+  ThreadLocalContextBase() {}
+  // Deletes the states of all threads.
+  ~ThreadLocalContextBase();
+
+  // Returns the state of the calling thread, or nullptr if it has none.
+  void* Find() const;
+  // Makes 'state' the state of the calling thread, deleted with 'deleter'
+  // when either the thread exits or this is destroyed. Returns false, and does
+  // not take ownership, if the thread is exiting.
+  bool Store(void* state, Deleter deleter) const;
+
+ private:
+  friend struct internal::ThreadContextCache;
+
+  // The caches of the threads with a state of this context. Guarded by the
+  // mutex of all caches, see thread_local_context.cc.
+  mutable std::vector<internal::ThreadContextCache*> caches_;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Per-thread mutable state of a primitive, such as a keyed EVP_CIPHER_CTX
+// which each operation re-initializes with its IV. Since primitives are
+// shared by threads, such state otherwise has to be allocated and set up in
+// every call.
+//
+// Each thread gets its own state from 'factory' the first time it calls
+// Get(), and reuses it afterwards. The states are deleted when their thread
+// exits or when the context is destroyed, whichever comes first, so T's
+// destructor must wipe any key material it holds (BoringSSL's cipher contexts
+// do). The state must be left reusable by every operation, and a thread must
+// not hold two Refs of the same context at once.
+template <typename T>
+class ThreadLocalContext : public ThreadLocalContextBase {
+ public:
+  using Factory = std::function<util::StatusOr<std::unique_ptr<T>>()>;
+
+  // The state of the calling thread, for the duration of one operation.
+  class Ref {
+   public:
+    Ref(Ref&& other) = default;
+    Ref& operator=(Ref&& other) = default;
+
+    T* get() const { return state_; }
+    T* operator->() const { return state_; }
+    T& operator*() const { return *state_; }
+
+   private:
+    friend class ThreadLocalContext;
+
+    Ref(T* state, std::unique_ptr<T> owned)
+        : state_(state), owned_(std::move(owned)) {}
+
+    T* state_;
+    // Only set if the state could not be cached, e.g. on an exiting thread.
+    std::unique_ptr<T> owned_;
+  };
+
+  explicit ThreadLocalContext(Factory factory) : factory_(std::move(factory)) {}
+
+  // Returns the state of the calling thread, creating it on first use.
+  crypto::tink::util::StatusOr<Ref> Get() const {
+    void* state = Find();
+    if (state != nullptr) return Ref(static_cast<T*>(state), nullptr);
+    auto state_result = factory_();
+    if (!state_result.ok()) return state_result.status();
+    std::unique_ptr<T> new_state = std::move(state_result.ValueOrDie());
+    if (Store(new_state.get(), &Delete)) {
+      return Ref(new_state.release(), nullptr);
+    }
+    T* uncached = new_state.get();
+    return Ref(uncached, std::move(new_state));
+  }
+
+ private:
+  static void Delete(void* state) { delete static_cast<T*>(state); }
+
+  const Factory factory_;
+};
+
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_SUBTLE_THREAD_LOCAL_CONTEXT_H_
@@ -0,0 +1,152 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/subtle/thread_local_context.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace subtle {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+// Counts the states which were created and are still alive.
+struct Counters {
+  std::atomic<int> created{0};
+  std::atomic<int> alive{0};
+};
+
+class State {
+ public:
+  explicit State(Counters* counters) : counters_(counters) {
+    counters_->alive++;
+  }
+  ~State() { counters_->alive--; }
+
+  int uses = 0;
+
+ private:
+  Counters* counters_;
+};
+
+ThreadLocalContext<State>::Factory CountingFactory(Counters* counters) {
+  return [counters]() -> util::StatusOr<std::unique_ptr<State>> {
+    counters->created++;
+    return absl::make_unique<State>(counters);
+  };
+}
+
+TEST(ThreadLocalContextTest, ReusesTheStateOfTheThread) {
+  Counters counters;
+  ThreadLocalContext<State> context(CountingFactory(&counters));
+  for (int i = 0; i < 3; i++) {
+    auto ref_result = context.Get();
+    ASSERT_THAT(ref_result.status(), IsOk());
+    EXPECT_EQ(i, ref_result.ValueOrDie()->uses++);
+  }
+  EXPECT_EQ(1, counters.created);
+  EXPECT_EQ(1, counters.alive);
+}
+
+TEST(ThreadLocalContextTest, ContextsHaveSeparateStates) {
+  Counters counters;
+  ThreadLocalContext<State> context1(CountingFactory(&counters));
+  ThreadLocalContext<State> context2(CountingFactory(&counters));
+  auto ref1 = context1.Get();
+  auto ref2 = context2.Get();
+  ASSERT_THAT(ref1.status(), IsOk());
+  ASSERT_THAT(ref2.status(), IsOk());
+  EXPECT_NE(ref1.ValueOrDie().get(), ref2.ValueOrDie().get());
+  EXPECT_EQ(2, counters.alive);
+}
+
+TEST(ThreadLocalContextTest, DeletesStatesWhenThreadsExit) {
+  Counters counters;
+  ThreadLocalContext<State> context(CountingFactory(&counters));
+  auto ref_result = context.Get();
+  ASSERT_THAT(ref_result.status(), IsOk());
+  State* main_state = ref_result.ValueOrDie().get();
+
+  State* thread_state = nullptr;
+  std::thread thread([&context, &thread_state]() {
+    thread_state = context.Get().ValueOrDie().get();
+    EXPECT_EQ(thread_state, context.Get().ValueOrDie().get());
+  });
+  thread.join();
+  EXPECT_NE(main_state, thread_state);
+  EXPECT_EQ(2, counters.created);
+  EXPECT_EQ(1, counters.alive);
+  EXPECT_EQ(main_state, context.Get().ValueOrDie().get());
+}
+
+TEST(ThreadLocalContextTest, DeletesStatesOfAllThreadsWhenDestroyed) {
+  Counters counters;
+  auto context =
+      absl::make_unique<ThreadLocalContext<State>>(CountingFactory(&counters));
+  ASSERT_THAT(context->Get().status(), IsOk());
+
+  bool got_state = false;
+  bool destroyed = false;
+  absl::Mutex mutex;
+  std::thread thread([&]() {
+    bool ok = context->Get().ok();
+    absl::MutexLock lock(&mutex);
+    got_state = ok;
+    mutex.Await(absl::Condition(&destroyed));
+  });
+  {
+    absl::MutexLock lock(&mutex);
+    mutex.Await(absl::Condition(&got_state));
+  }
+  EXPECT_EQ(2, counters.alive);
+  context.reset();
+  EXPECT_EQ(0, counters.alive);
+  {
+    absl::MutexLock lock(&mutex);
+    destroyed = true;
+  }
+  thread.join();
+  EXPECT_EQ(0, counters.alive);
+}
+
+TEST(ThreadLocalContextTest, FactoryErrors) {
+  int calls = 0;
+  ThreadLocalContext<State> context(
+      [&calls]() -> util::StatusOr<std::unique_ptr<State>> {
+        calls++;
+        return util::Status(util::error::INTERNAL, "no state");
+      });
+  EXPECT_THAT(context.Get().status(), StatusIs(util::error::INTERNAL));
+  EXPECT_THAT(context.Get().status(), StatusIs(util::error::INTERNAL));
+  EXPECT_EQ(2, calls);
+}
+
+}  // namespace
+}  // namespace subtle
+}  // namespace tink
+}  // namespace crypto
@@ -20,6 +20,8 @@
 #include <string>
 #include <vector>
 
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "openssl/err.h"
 #include "openssl/evp.h"
 #include "tink/aead.h"
@@ -54,44 +56,55 @@ util::StatusOr<std::unique_ptr<Aead>> XChacha20Poly1305BoringSsl::New(
   if (cipher == nullptr) {
     return util::Status(util::error::INTERNAL, "Failed to get EVP_AEAD");
   }
-  return std::unique_ptr<Aead>(
-      new XChacha20Poly1305BoringSsl(std::move(key), cipher));
-}
-
-util::StatusOr<std::string> XChacha20Poly1305BoringSsl::Encrypt(
-    absl::string_view plaintext, absl::string_view additional_data) const {
   bssl::UniquePtr<EVP_AEAD_CTX> ctx(
-      EVP_AEAD_CTX_new(aead_, reinterpret_cast<const uint8_t*>(key_.data()),
-                       key_.size(), kTagSize));
+      EVP_AEAD_CTX_new(cipher, reinterpret_cast<const uint8_t*>(key.data()),
+                       key.size(), kTagSize));
   if (ctx.get() == nullptr) {
     return util::Status(util::error::INTERNAL,
                         "could not initialize EVP_AEAD_CTX");
   }
+  return std::unique_ptr<Aead>(new XChacha20Poly1305BoringSsl(std::move(ctx)));
+}
+
+util::StatusOr<int64_t> XChacha20Poly1305BoringSsl::CiphertextSize(
+    int64_t plaintext_size) const {
+  return kNonceSize + plaintext_size + kTagSize;
+}
+
+util::StatusOr<std::string> XChacha20Poly1305BoringSsl::Encrypt(
+    absl::string_view plaintext, absl::string_view additional_data) const {
+  std::string ct;
+  ResizeStringUninitialized(&ct, kNonceSize + plaintext.size() + kTagSize);
+  auto written = EncryptInto(plaintext, additional_data,
+                             absl::MakeSpan(&ct[0], ct.size()));
+  if (!written.ok()) return written.status();
+  return ct;
+}
+
+util::StatusOr<int64_t> XChacha20Poly1305BoringSsl::EncryptInto(
+    absl::string_view plaintext, absl::string_view additional_data,
+    absl::Span<char> ciphertext_buffer) const {
+  size_t ciphertext_size = kNonceSize + plaintext.size() + kTagSize;
+  if (ciphertext_buffer.size() < ciphertext_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "ciphertext_buffer is too small");
+  }
 
   // BoringSSL expects a non-null pointer for plaintext and additional_data,
   // regardless of whether the size is 0.
   plaintext = SubtleUtilBoringSSL::EnsureNonNull(plaintext);
   additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
 
-  const std::string nonce = Random::GetRandomBytes(kNonceSize);
-  if (nonce.size() != kNonceSize) {
-    return util::Status(util::error::INTERNAL,
-                        "Failed to get enough random bytes for nonce");
-  }
-
-  size_t ciphertext_size = nonce.size() + plaintext.size() + kTagSize;
-
   // Write the nonce in the output buffer.
-  std::string ct = nonce;
-  ResizeStringUninitialized(&ct, ciphertext_size);
-  size_t written = nonce.size();
+  Random::GetRandomNonceBytes(ciphertext_buffer.subspan(0, kNonceSize));
+  uint8_t* out = reinterpret_cast<uint8_t*>(ciphertext_buffer.data());
+  size_t written = kNonceSize;
 
   // Encrypt the plaintext and store it after the nonce.
   size_t out_len = 0;
   int ret = EVP_AEAD_CTX_seal(
-      ctx.get(), reinterpret_cast<uint8_t*>(&ct[written]), &out_len,
-      ciphertext_size - written, reinterpret_cast<const uint8_t*>(nonce.data()),
-      nonce.size(), reinterpret_cast<const uint8_t*>(plaintext.data()),
+      ctx_.get(), out + written, &out_len, ciphertext_size - written, out,
+      kNonceSize, reinterpret_cast<const uint8_t*>(plaintext.data()),
       plaintext.size(),
       reinterpret_cast<const uint8_t*>(additional_data.data()),
       additional_data.size());
@@ -104,11 +117,26 @@ util::StatusOr<std::string> XChacha20Poly1305BoringSsl::Encrypt(
   if (written != ciphertext_size) {
     return util::Status(util::error::INTERNAL, "Incorrect ciphertext size");
   }
-  return ct;
+  return written;
 }
 
 util::StatusOr<std::string> XChacha20Poly1305BoringSsl::Decrypt(
     absl::string_view ciphertext, absl::string_view additional_data) const {
+  if (ciphertext.size() < kNonceSize + kTagSize) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Ciphertext too short");
+  }
+
+  std::string out;
+  ResizeStringUninitialized(&out, ciphertext.size() - kNonceSize - kTagSize);
+  auto written = DecryptInto(ciphertext, additional_data,
+                             absl::MakeSpan(&out[0], out.size()));
+  if (!written.ok()) return written.status();
+  return out;
+}
+
+util::StatusOr<int64_t> XChacha20Poly1305BoringSsl::DecryptInto(
+    absl::string_view ciphertext, absl::string_view additional_data,
+    absl::Span<char> plaintext_buffer) const {
   // BoringSSL expects a non-null pointer for additional_data,
   // regardless of whether the size is 0.
   additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
@@ -116,39 +144,69 @@ util::StatusOr<std::string> XChacha20Poly1305BoringSsl::Decrypt(
   if (ciphertext.size() < kNonceSize + kTagSize) {
     return util::Status(util::error::INVALID_ARGUMENT, "Ciphertext too short");
   }
-
-  bssl::UniquePtr<EVP_AEAD_CTX> ctx(
-      EVP_AEAD_CTX_new(aead_, reinterpret_cast<const uint8_t*>(key_.data()),
-                       key_.size(), kTagSize));
-  if (ctx.get() == nullptr) {
-    return util::Status(util::error::INTERNAL,
-                        "could not initialize EVP_AEAD_CTX");
-  }
-
-  std::string out;
   size_t out_size = ciphertext.size() - kNonceSize - kTagSize;
-  ResizeStringUninitialized(&out, out_size);
+  if (plaintext_buffer.size() < out_size) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "plaintext_buffer is too small");
+  }
 
   absl::string_view nonce = ciphertext.substr(0, kNonceSize);
   absl::string_view encrypted =
       ciphertext.substr(kNonceSize, out_size + kTagSize);
 
+  // The plaintext may be empty, in which case the buffer may be empty as well.
+  uint8_t empty_buffer;
+  uint8_t* out = plaintext_buffer.empty()
+                     ? &empty_buffer
+                     : reinterpret_cast<uint8_t*>(plaintext_buffer.data());
   size_t len = 0;
   int ret = EVP_AEAD_CTX_open(
-      ctx.get(), reinterpret_cast<uint8_t*>(&out[0]), &len, out_size,
+      ctx_.get(), out, &len, out_size,
       reinterpret_cast<const uint8_t*>(nonce.data()), nonce.size(),
       reinterpret_cast<const uint8_t*>(encrypted.data()), encrypted.size(),
       reinterpret_cast<const uint8_t*>(additional_data.data()),
       additional_data.size());
   if (ret != 1) {
-    return util::Status(util::error::INTERNAL, "EVP_AEAD_CTX_open failed");
+    static const util::Status* kOpenFailed =
+        util::Status::NewStatic(util::error::INTERNAL,
+                                "EVP_AEAD_CTX_open failed");
+    return *kOpenFailed;
   }
 
   if (len != out_size) {
     return util::Status(util::error::INTERNAL, "Incorrect output size");
   }
 
-  return out;
+  return len;
+}
+
+util::StatusOr<absl::Span<char>> XChacha20Poly1305BoringSsl::DecryptInPlace(
+    absl::Span<char> ciphertext, absl::string_view additional_data) const {
+  // BoringSSL expects a non-null pointer for additional_data,
+  // regardless of whether the size is 0.
+  additional_data = SubtleUtilBoringSSL::EnsureNonNull(additional_data);
+
+  if (ciphertext.size() < kNonceSize + kTagSize) {
+    return util::Status(util::error::INVALID_ARGUMENT, "Ciphertext too short");
+  }
+
+  // EVP_AEAD_CTX_open() allows the output to alias the input exactly, so the
+  // plaintext is written over the encrypted part of the ciphertext.
+  uint8_t* in = reinterpret_cast<uint8_t*>(ciphertext.data());
+  size_t len = 0;
+  int ret = EVP_AEAD_CTX_open(
+      ctx_.get(), in + kNonceSize, &len,
+      ciphertext.size() - kNonceSize - kTagSize, in, kNonceSize,
+      in + kNonceSize, ciphertext.size() - kNonceSize,
+      reinterpret_cast<const uint8_t*>(additional_data.data()),
+      additional_data.size());
+  if (ret != 1) {
+    static const util::Status* kOpenFailed =
+        util::Status::NewStatic(util::error::INTERNAL,
+                                "EVP_AEAD_CTX_open failed");
+    return *kOpenFailed;
+  }
+  return ciphertext.subspan(kNonceSize, len);
 }
 
 }  // namespace subtle
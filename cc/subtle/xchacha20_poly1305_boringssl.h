@@ -21,6 +21,8 @@
 #include <utility>
 
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "openssl/aead.h"
 #include "openssl/base.h"
 #include "tink/aead.h"
 #include "tink/config/tink_fips.h"
@@ -49,6 +51,22 @@ class XChacha20Poly1305BoringSsl : public Aead {
       absl::string_view ciphertext,
       absl::string_view additional_data) const override;
 
+  crypto::tink::util::StatusOr<int64_t> CiphertextSize(
+      int64_t plaintext_size) const override;
+
+  crypto::tink::util::StatusOr<int64_t> EncryptInto(
+      absl::string_view plaintext, absl::string_view additional_data,
+      absl::Span<char> ciphertext_buffer) const override;
+
+  crypto::tink::util::StatusOr<int64_t> DecryptInto(
+      absl::string_view ciphertext, absl::string_view additional_data,
+      absl::Span<char> plaintext_buffer) const override;
+
+  // The returned plaintext starts right after the nonce in 'ciphertext'.
+  crypto::tink::util::StatusOr<absl::Span<char>> DecryptInPlace(
+      absl::Span<char> ciphertext,
+      absl::string_view additional_data) const override;
+
   static constexpr crypto::tink::FipsCompatibility kFipsStatus =
       crypto::tink::FipsCompatibility::kNotFips;
 
@@ -57,11 +75,12 @@ class XChacha20Poly1305BoringSsl : public Aead {
   static constexpr int kNonceSize = 24;
   static constexpr int kTagSize = 16;
 
-  XChacha20Poly1305BoringSsl(util::SecretData key, const EVP_AEAD* aead)
-      : key_(std::move(key)), aead_(aead) {}
+  explicit XChacha20Poly1305BoringSsl(bssl::UniquePtr<EVP_AEAD_CTX> ctx)
+      : ctx_(std::move(ctx)) {}
 
-  const util::SecretData key_;
-  const EVP_AEAD* const aead_;
+  // Created once in New(). Sealing and opening only read the context, so it
+  // is safe to use from several threads at once.
+  const bssl::UniquePtr<EVP_AEAD_CTX> ctx_;
 };
 
 }  // namespace subtle
@@ -17,10 +17,12 @@
 #include "tink/subtle/xchacha20_poly1305_boringssl.h"
 
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "gtest/gtest.h"
 #include "absl/strings/str_cat.h"
+#include "absl/types/span.h"
 #include "openssl/err.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
@@ -32,6 +34,7 @@ namespace tink {
 namespace subtle {
 namespace {
 
+using ::crypto::tink::test::IsOk;
 using ::crypto::tink::test::StatusIs;
 
 TEST(XChacha20Poly1305BoringSslTest, TestBasic) {
@@ -55,6 +58,142 @@ TEST(XChacha20Poly1305BoringSslTest, TestBasic) {
   EXPECT_EQ(pt.ValueOrDie(), message);
 }
 
+TEST(XChacha20Poly1305BoringSslTest, ConcurrentUse) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+
+  util::SecretData key = util::SecretDataFromStringView(test::HexDecodeOrDie(
+      "000102030405060708090a0b0c0d0e0f000102030405060708090a0b0c0d0e0f"));
+  auto res = XChacha20Poly1305BoringSsl::New(key);
+  ASSERT_THAT(res.status(), IsOk());
+  const Aead& cipher = *res.ValueOrDie();
+  std::string aad = "Some data to authenticate.";
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&cipher, &aad, i]() {
+      for (int j = 0; j < 1000; j++) {
+        std::string message = absl::StrCat("Message ", i, " ", j);
+        auto ct = cipher.Encrypt(message, aad);
+        ASSERT_THAT(ct.status(), IsOk());
+        auto pt = cipher.Decrypt(ct.ValueOrDie(), aad);
+        ASSERT_THAT(pt.status(), IsOk());
+        EXPECT_EQ(pt.ValueOrDie(), message);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+}
+
+TEST(XChacha20Poly1305BoringSslTest, EncryptIntoDecryptInto) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f000102030405060708090a0b0c0d0e0f"));
+  auto cipher_result = XChacha20Poly1305BoringSsl::New(key);
+  ASSERT_THAT(cipher_result.status(), IsOk());
+  auto cipher = std::move(cipher_result.ValueOrDie());
+  std::string message = "Some data to encrypt.";
+  std::string aad = "Some data to authenticate.";
+
+  auto ciphertext_size = cipher->CiphertextSize(message.size());
+  ASSERT_THAT(ciphertext_size.status(), IsOk());
+  EXPECT_EQ(ciphertext_size.ValueOrDie(), message.size() + 40);
+
+  std::vector<char> ciphertext(ciphertext_size.ValueOrDie());
+  auto written =
+      cipher->EncryptInto(message, aad, absl::MakeSpan(ciphertext));
+  ASSERT_THAT(written.status(), IsOk());
+  EXPECT_EQ(written.ValueOrDie(), ciphertext.size());
+  absl::string_view ciphertext_view(ciphertext.data(), ciphertext.size());
+
+  // The output of EncryptInto() can be decrypted by Decrypt() ...
+  auto decrypted = cipher->Decrypt(ciphertext_view, aad);
+  ASSERT_THAT(decrypted.status(), IsOk());
+  EXPECT_EQ(decrypted.ValueOrDie(), message);
+
+  // ... and by DecryptInto(), also into a buffer larger than needed.
+  std::vector<char> plaintext(ciphertext.size());
+  written = cipher->DecryptInto(ciphertext_view, aad, absl::MakeSpan(plaintext));
+  ASSERT_THAT(written.status(), IsOk());
+  EXPECT_EQ(std::string(plaintext.data(), written.ValueOrDie()), message);
+
+  // The output of Encrypt() can be decrypted by DecryptInto().
+  auto encrypted = cipher->Encrypt(message, aad);
+  ASSERT_THAT(encrypted.status(), IsOk());
+  written = cipher->DecryptInto(encrypted.ValueOrDie(), aad,
+                                absl::MakeSpan(plaintext));
+  ASSERT_THAT(written.status(), IsOk());
+  EXPECT_EQ(std::string(plaintext.data(), written.ValueOrDie()), message);
+}
+
+TEST(XChacha20Poly1305BoringSslTest, EncryptIntoDecryptIntoBufferTooSmall) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  util::SecretData key = util::SecretDataFromStringView(
+      test::HexDecodeOrDie("000102030405060708090a0b0c0d0e0f000102030405060708090a0b0c0d0e0f"));
+  auto cipher_result = XChacha20Poly1305BoringSsl::New(key);
+  ASSERT_THAT(cipher_result.status(), IsOk());
+  auto cipher = std::move(cipher_result.ValueOrDie());
+  std::string message = "Some data to encrypt.";
+  std::string aad = "Some data to authenticate.";
+
+  std::vector<char> ciphertext(message.size() + 40 - 1);
+  EXPECT_THAT(
+      cipher->EncryptInto(message, aad, absl::MakeSpan(ciphertext)).status(),
+      StatusIs(util::error::INVALID_ARGUMENT));
+
+  auto encrypted = cipher->Encrypt(message, aad);
+  ASSERT_THAT(encrypted.status(), IsOk());
+  std::vector<char> plaintext(message.size() - 1);
+  EXPECT_THAT(cipher
+                  ->DecryptInto(encrypted.ValueOrDie(), aad,
+                                absl::MakeSpan(plaintext))
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(XChacha20Poly1305BoringSslTest, DecryptInPlace) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  util::SecretData key = util::SecretDataFromStringView(test::HexDecodeOrDie(
+      "000102030405060708090a0b0c0d0e0f000102030405060708090a0b0c0d0e0f"));
+  auto cipher_result = XChacha20Poly1305BoringSsl::New(key);
+  ASSERT_THAT(cipher_result.status(), IsOk());
+  auto cipher = std::move(cipher_result.ValueOrDie());
+  std::string message = "Some data to encrypt.";
+  std::string aad = "Some data to authenticate.";
+  auto encrypted = cipher->Encrypt(message, aad);
+  ASSERT_THAT(encrypted.status(), IsOk());
+
+  std::string buffer = encrypted.ValueOrDie();
+  auto decrypted =
+      cipher->DecryptInPlace(absl::MakeSpan(&buffer[0], buffer.size()), aad);
+  ASSERT_THAT(decrypted.status(), IsOk());
+  // The plaintext is in the ciphertext buffer, right after the nonce.
+  EXPECT_EQ(decrypted.ValueOrDie().data(), &buffer[24]);
+  EXPECT_EQ(std::string(decrypted.ValueOrDie().data(),
+                        decrypted.ValueOrDie().size()),
+            message);
+
+  buffer = encrypted.ValueOrDie();
+  EXPECT_THAT(cipher
+                  ->DecryptInPlace(absl::MakeSpan(&buffer[0], buffer.size()),
+                                   "other aad")
+                  .status(),
+              StatusIs(util::error::INTERNAL));
+  buffer = encrypted.ValueOrDie().substr(0, 24 + 15);
+  EXPECT_THAT(cipher
+                  ->DecryptInPlace(absl::MakeSpan(&buffer[0], buffer.size()),
+                                   aad)
+                  .status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
 TEST(XChacha20Poly1305BoringSslTest, TestModification) {
   if (kUseOnlyFips) {
     GTEST_SKIP() << "Not supported in FIPS-only mode";
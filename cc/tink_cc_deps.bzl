@@ -37,6 +37,15 @@ def tink_cc_deps():
             sha256 = "54a139559cc46a68cf79e55d5c22dc9d48e647a66827342520ce0441402430fe",
         )
 
+    # Google Benchmark. Used by the benchmarks in //benchmarks.
+    if not native.existing_rule("com_github_google_benchmark"):
+        http_archive(
+            name = "com_github_google_benchmark",
+            strip_prefix = "benchmark-0baacde3618ca617da95375e0af13ce1baadea47",
+            url = "https://github.com/google/benchmark/archive/0baacde3618ca617da95375e0af13ce1baadea47.zip",
+            sha256 = "62e2f2e6d8a744d67e4bbc212fcfd06647080de4253c97ad5c6749e09faf2cb0",
+        )
+
     if not native.existing_rule("rapidjson"):
         # Release from 2016-08-25; still the latest release on 2019-10-18
         http_archive(
@@ -0,0 +1,110 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_TRACING_H_
+#define TINK_TRACING_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "tink/util/status.h"
+
+namespace crypto {
+namespace tink {
+
+// A span of a trace, covering one operation which may take long, such as a
+// call to a remote KMS or the lifetime of a stream.
+class TraceSpan {
+ public:
+  // Attaches a numeric attribute, e.g. the number of bytes processed.
+  virtual void SetAttribute(absl::string_view key, int64_t value) {}
+
+  // Ends the span with the result of the operation. Called at most once, and
+  // not called for operations which never finish, such as asynchronous calls
+  // whose callback is dropped.
+  virtual void End(const util::Status& status) = 0;
+
+  virtual ~TraceSpan() {}
+};
+
+// Creates the spans of Tink's long-running operations. Span names start with
+// "tink.", e.g. "tink.kms_envelope_aead.decrypt_dek".
+//
+// StartSpan() is called on the thread starting the operation and may be
+// called concurrently; the current span of that thread, if any, is the
+// natural parent of the new one.
+class Tracer {
+ public:
+  virtual std::unique_ptr<TraceSpan> StartSpan(absl::string_view name) = 0;
+
+  virtual ~Tracer() {}
+};
+
+// Sets the tracer used for all spans started afterwards, or disables tracing
+// if 'tracer' is nullptr, which is the default. The tracer is not owned, and
+// must stay valid while any Tink primitive is in use, even after it has been
+// replaced. Without a tracer, the overhead per operation is a single atomic
+// load.
+void SetTracer(Tracer* tracer);
+
+// Returns the tracer set by SetTracer(), or nullptr.
+Tracer* GetTracer();
+
+namespace internal {
+
+// Returns a new span named 'name' if a tracer is set, and nullptr otherwise.
+inline std::unique_ptr<TraceSpan> StartSpan(absl::string_view name) {
+  Tracer* tracer = GetTracer();
+  if (tracer == nullptr) return nullptr;
+  return tracer->StartSpan(name);
+}
+
+// Ends 'span' with 'status' unless it is nullptr.
+inline void EndSpan(TraceSpan* span, const util::Status& status) {
+  if (span != nullptr) span->End(status);
+}
+
+// A span which ends when it goes out of scope, with the status last passed
+// to set_status(), OK by default.
+class ScopedSpan {
+ public:
+  explicit ScopedSpan(absl::string_view name) : span_(StartSpan(name)) {}
+
+  void SetAttribute(absl::string_view key, int64_t value) {
+    if (span_ != nullptr) span_->SetAttribute(key, value);
+  }
+
+  void set_status(const util::Status& status) {
+    if (span_ != nullptr) status_ = status;
+  }
+
+  ~ScopedSpan() { EndSpan(span_.get(), status_); }
+
+  ScopedSpan(const ScopedSpan&) = delete;
+  ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+ private:
+  std::unique_ptr<TraceSpan> span_;
+  util::Status status_;
+};
+
+}  // namespace internal
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_TRACING_H_
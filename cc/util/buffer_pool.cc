@@ -0,0 +1,124 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/util/buffer_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "openssl/mem.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+namespace {
+
+std::atomic<BufferPool*>& GlobalPool() {
+  static std::atomic<BufferPool*>* pool =
+      new std::atomic<BufferPool*>(new SizeClassBufferPool());
+  return *pool;
+}
+
+}  // namespace
+
+// static
+BufferPool* BufferPool::Global() {
+  return GlobalPool().load(std::memory_order_acquire);
+}
+
+// static
+void BufferPool::SetGlobal(BufferPool* pool) {
+  GlobalPool().store(pool, std::memory_order_release);
+}
+
+SizeClassBufferPool::SizeClassBufferPool(const Options& options)
+    : options_(options) {
+  int num_classes = 0;
+  for (std::size_t size = options_.min_buffer_size;
+       size > 0 && size <= options_.max_buffer_size; size <<= 1) {
+    num_classes++;
+  }
+  free_buffers_.resize(num_classes);
+}
+
+int SizeClassBufferPool::SizeClassFor(std::size_t size) const {
+  std::size_t class_size = options_.min_buffer_size;
+  for (int i = 0; i < free_buffers_.size(); i++) {
+    if (size <= class_size) return i;
+    class_size <<= 1;
+  }
+  return -1;
+}
+
+std::vector<uint8_t> SizeClassBufferPool::Acquire(std::size_t size) {
+  std::vector<uint8_t> buffer;
+  int size_class = SizeClassFor(size);
+  if (size_class < 0) {
+    buffer.resize(size);
+    return buffer;
+  }
+  {
+    absl::MutexLock lock(&mutex_);
+    std::vector<std::vector<uint8_t>>& free_buffers =
+        free_buffers_[size_class];
+    if (!free_buffers.empty()) {
+      buffer = std::move(free_buffers.back());
+      free_buffers.pop_back();
+      retained_bytes_ -= buffer.capacity();
+    }
+  }
+  if (buffer.capacity() == 0) {
+    buffer.reserve(options_.min_buffer_size << size_class);
+  }
+  // Released buffers are wiped, so this only clears memory of new ones.
+  buffer.resize(size);
+  return buffer;
+}
+
+void SizeClassBufferPool::Release(std::vector<uint8_t> buffer) {
+  // Shrinking a vector keeps the old contents beyond its size, so the whole
+  // capacity is wiped.
+  buffer.resize(buffer.capacity());
+  OPENSSL_cleanse(buffer.data(), buffer.size());
+  buffer.clear();
+
+  // Buffers go to the largest size class they can serve.
+  std::size_t capacity = buffer.capacity();
+  if (capacity < options_.min_buffer_size) return;
+  int size_class = SizeClassFor(capacity);
+  if (size_class < 0) return;
+  if ((options_.min_buffer_size << size_class) > capacity) size_class--;
+
+  absl::MutexLock lock(&mutex_);
+  if (retained_bytes_ + capacity > options_.max_retained_bytes) return;
+  retained_bytes_ += capacity;
+  free_buffers_[size_class].push_back(std::move(buffer));
+}
+
+std::size_t SizeClassBufferPool::retained_bytes() const {
+  absl::MutexLock lock(&mutex_);
+  return retained_bytes_;
+}
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,103 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_UTIL_BUFFER_POOL_H_
+#define TINK_UTIL_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+// A source of the byte vectors that streaming AEAD streams use as segment
+// buffers. Streams acquire their buffers when created and release them when
+// destroyed, so that applications opening many short-lived streams can
+// reuse buffer memory instead of allocating it for every stream.
+//
+// Segment buffers hold plaintext, therefore implementations must wipe every
+// released buffer before reusing or freeing it. Implementations must be
+// thread-safe.
+class BufferPool {
+ public:
+  // Returns a vector of 'size' zero bytes.
+  virtual std::vector<uint8_t> Acquire(std::size_t size) = 0;
+
+  // Wipes 'buffer' and takes it back. 'buffer' need not have been returned
+  // by Acquire(), and may have been resized since.
+  virtual void Release(std::vector<uint8_t> buffer) = 0;
+
+  virtual ~BufferPool() {}
+
+  // Returns the pool used by the streams, a SizeClassBufferPool with
+  // default options unless replaced with SetGlobal().
+  static BufferPool* Global();
+
+  // Makes the streams created from now on use 'pool', which must not be
+  // null. Streams return their buffers to the pool they acquired them from,
+  // so a replaced pool must outlive all streams created while it was used.
+  static void SetGlobal(BufferPool* pool);
+};
+
+// A BufferPool that keeps released buffers in power-of-two size classes.
+// Buffers larger than Options::max_buffer_size are not pooled, and once the
+// pool retains Options::max_retained_bytes further released buffers are
+// freed.
+class SizeClassBufferPool : public BufferPool {
+ public:
+  struct Options {
+    // The smallest size class; smaller requests get buffers of this size.
+    std::size_t min_buffer_size = 4096;
+    // The largest size class.
+    std::size_t max_buffer_size = 4 * 1024 * 1024;
+    // The total capacity of the buffers the pool keeps for reuse.
+    std::size_t max_retained_bytes = 16 * 1024 * 1024;
+  };
+
+  SizeClassBufferPool() : SizeClassBufferPool(Options()) {}
+  explicit SizeClassBufferPool(const Options& options);
+
+  std::vector<uint8_t> Acquire(std::size_t size) override;
+  void Release(std::vector<uint8_t> buffer) override;
+
+  // Returns the total capacity of the buffers currently kept for reuse.
+  std::size_t retained_bytes() const;
+
+ private:
+  // Returns the index of the smallest size class holding 'size' bytes, or
+  // -1 if 'size' is larger than max_buffer_size.
+  int SizeClassFor(std::size_t size) const;
+
+  const Options options_;
+  mutable absl::Mutex mutex_;
+  // free_buffers_[i] holds empty vectors with a capacity of at least
+  // min_buffer_size << i bytes.
+  std::vector<std::vector<std::vector<uint8_t>>> free_buffers_
+      ABSL_GUARDED_BY(mutex_);
+  std::size_t retained_bytes_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_UTIL_BUFFER_POOL_H_
@@ -0,0 +1,139 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/util/buffer_pool.h"
+
+#include <cstdint>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+namespace {
+
+using ::testing::Each;
+using ::testing::Eq;
+
+SizeClassBufferPool::Options SmallOptions() {
+  SizeClassBufferPool::Options options;
+  options.min_buffer_size = 16;
+  options.max_buffer_size = 1024;
+  options.max_retained_bytes = 4096;
+  return options;
+}
+
+TEST(SizeClassBufferPoolTest, AcquireReturnsZeroedBuffers) {
+  SizeClassBufferPool pool(SmallOptions());
+  for (std::size_t size : {0, 1, 16, 17, 1000, 1024, 5000}) {
+    SCOPED_TRACE(size);
+    std::vector<uint8_t> buffer = pool.Acquire(size);
+    EXPECT_EQ(buffer.size(), size);
+    EXPECT_THAT(buffer, Each(Eq(0)));
+    buffer.assign(size, 0xab);
+    pool.Release(std::move(buffer));
+  }
+}
+
+TEST(SizeClassBufferPoolTest, ReusesReleasedBuffers) {
+  SizeClassBufferPool pool(SmallOptions());
+  std::vector<uint8_t> buffer = pool.Acquire(100);
+  EXPECT_GE(buffer.capacity(), 128);
+  const uint8_t* data = buffer.data();
+  buffer.assign(buffer.size(), 0xab);
+  pool.Release(std::move(buffer));
+  EXPECT_EQ(pool.retained_bytes(), 128);
+
+  // Any size of the same size class gets the released buffer, wiped.
+  std::vector<uint8_t> reused = pool.Acquire(120);
+  EXPECT_EQ(reused.data(), data);
+  EXPECT_EQ(reused.size(), 120);
+  EXPECT_THAT(reused, Each(Eq(0)));
+  EXPECT_EQ(pool.retained_bytes(), 0);
+}
+
+TEST(SizeClassBufferPoolTest, WipesWholeCapacity) {
+  SizeClassBufferPool pool(SmallOptions());
+  std::vector<uint8_t> buffer = pool.Acquire(128);
+  buffer.assign(buffer.size(), 0xab);
+  // Shrinking leaves the old contents in the capacity of the buffer.
+  buffer.resize(10);
+  pool.Release(std::move(buffer));
+  std::vector<uint8_t> reused = pool.Acquire(128);
+  EXPECT_THAT(reused, Each(Eq(0)));
+}
+
+TEST(SizeClassBufferPoolTest, DoesNotPoolLargeBuffers) {
+  SizeClassBufferPool pool(SmallOptions());
+  pool.Release(pool.Acquire(2048));
+  EXPECT_EQ(pool.retained_bytes(), 0);
+}
+
+TEST(SizeClassBufferPoolTest, LimitsRetainedBytes) {
+  SizeClassBufferPool pool(SmallOptions());
+  std::vector<std::vector<uint8_t>> buffers;
+  for (int i = 0; i < 8; i++) buffers.push_back(pool.Acquire(1024));
+  for (auto& buffer : buffers) pool.Release(std::move(buffer));
+  EXPECT_EQ(pool.retained_bytes(), 4096);
+}
+
+TEST(SizeClassBufferPoolTest, AcceptsForeignBuffers) {
+  SizeClassBufferPool pool(SmallOptions());
+  std::vector<uint8_t> buffer(200, 0xab);
+  buffer.shrink_to_fit();
+  pool.Release(std::move(buffer));
+  // A capacity of 200 bytes serves the 128 byte size class.
+  EXPECT_EQ(pool.retained_bytes(), 200);
+  std::vector<uint8_t> reused = pool.Acquire(128);
+  EXPECT_GE(reused.capacity(), 200);
+  EXPECT_THAT(reused, Each(Eq(0)));
+}
+
+TEST(SizeClassBufferPoolTest, ConcurrentUse) {
+  SizeClassBufferPool pool(SmallOptions());
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&pool]() {
+      for (int i = 0; i < 1000; i++) {
+        std::vector<uint8_t> buffer = pool.Acquire(16 + i % 1000);
+        ASSERT_THAT(buffer, Each(Eq(0)));
+        buffer.assign(buffer.size(), 0xab);
+        pool.Release(std::move(buffer));
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_LE(pool.retained_bytes(), 4096);
+}
+
+TEST(BufferPoolTest, SetGlobal) {
+  BufferPool* default_pool = BufferPool::Global();
+  ASSERT_NE(default_pool, nullptr);
+  SizeClassBufferPool pool(SmallOptions());
+  BufferPool::SetGlobal(&pool);
+  EXPECT_EQ(BufferPool::Global(), &pool);
+  BufferPool::SetGlobal(default_pool);
+  EXPECT_EQ(BufferPool::Global(), default_pool);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,84 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/util/cord_input_stream.h"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+#include "tink/input_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+CordInputStream::CordInputStream(absl::Cord input)
+    : input_(std::move(input)), next_chunk_(input_.chunk_begin()) {
+  position_ = 0;
+  count_backedup_ = 0;
+  status_ = Status::OK;
+}
+
+crypto::tink::util::StatusOr<int> CordInputStream::Next(const void** data) {
+  if (!status_.ok()) return status_;
+  if (count_backedup_ > 0) {  // Return the backed-up bytes.
+    int backedup = count_backedup_;
+    count_backedup_ = 0;
+    returned_.remove_prefix(returned_.size() - backedup);
+    *data = returned_.data();
+    position_ = position_ + backedup;
+    return backedup;
+  }
+  if (remaining_.empty()) {
+    if (next_chunk_ == input_.chunk_end()) {
+      status_ = Status(util::error::OUT_OF_RANGE, "EOF");
+      return status_;
+    }
+    remaining_ = *next_chunk_;
+    ++next_chunk_;
+  }
+  // Chunks are returned whole, unless they are too large for an int.
+  size_t count = std::min<size_t>(remaining_.size(),
+                                  std::numeric_limits<int>::max());
+  returned_ = remaining_.substr(0, count);
+  remaining_.remove_prefix(count);
+  position_ = position_ + count;
+  *data = returned_.data();
+  return count;
+}
+
+void CordInputStream::BackUp(int count) {
+  if (!status_.ok() || count < 1) return;
+  int actual_count =
+      std::min<int64_t>(count, returned_.size() - count_backedup_);
+  count_backedup_ = count_backedup_ + actual_count;
+  position_ = position_ - actual_count;
+}
+
+CordInputStream::~CordInputStream() {}
+
+int64_t CordInputStream::Position() const {
+  return position_;
+}
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
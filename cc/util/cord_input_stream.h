@@ -0,0 +1,71 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_UTIL_CORD_INPUT_STREAM_H_
+#define TINK_UTIL_CORD_INPUT_STREAM_H_
+
+#include <cstdint>
+
+#include "absl/strings/cord.h"
+#include "absl/strings/string_view.h"
+#include "tink/input_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+// An InputStream that reads from an absl::Cord. Next() returns the chunks
+// of the Cord directly, so the Cord is neither flattened nor copied.
+// With it a StreamingAead can decrypt a Cord payload without first
+// converting it to a string.
+class CordInputStream : public crypto::tink::InputStream {
+ public:
+  // Constructs an InputStream that will read the contents of 'input'.
+  explicit CordInputStream(absl::Cord input);
+
+  // Not copyable, as the stream iterates over its own copy of the Cord.
+  CordInputStream(const CordInputStream&) = delete;
+  CordInputStream& operator=(const CordInputStream&) = delete;
+
+  ~CordInputStream() override;
+
+  crypto::tink::util::StatusOr<int> Next(const void** data) override;
+
+  void BackUp(int count) override;
+
+  int64_t Position() const override;
+
+ private:
+  util::Status status_;
+  absl::Cord input_;
+  absl::Cord::ChunkIterator next_chunk_;
+  int64_t position_;  // current position in the Cord (from the beginning)
+
+  // The bytes returned by the last Next(), the bytes of the current chunk
+  // that follow them, and the # of bytes at the end of returned_ that were
+  // backed up.
+  absl::string_view returned_;
+  absl::string_view remaining_;
+  int count_backedup_;
+};
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_UTIL_CORD_INPUT_STREAM_H_
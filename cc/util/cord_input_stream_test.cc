@@ -0,0 +1,176 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/util/cord_input_stream.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/cord_output_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+// Returns a Cord whose chunks are the given 'fragments', which must outlive
+// the Cord.
+absl::Cord MakeFragmentedCord(const std::vector<std::string>& fragments) {
+  absl::Cord cord;
+  for (const std::string& fragment : fragments) {
+    cord.Append(absl::MakeCordFromExternal(fragment, [](absl::string_view) {}));
+  }
+  return cord;
+}
+
+// Reads the specified 'input_stream' until no more bytes can be read,
+// and puts the read bytes into 'contents'.
+// Returns the status of the last input_stream->Next()-operation.
+Status ReadTillEnd(CordInputStream* input_stream, std::string* contents) {
+  contents->clear();
+  const void* buffer;
+  auto next_result = input_stream->Next(&buffer);
+  while (next_result.ok()) {
+    contents->append(static_cast<const char*>(buffer),
+                     next_result.ValueOrDie());
+    next_result = input_stream->Next(&buffer);
+  }
+  return next_result.status();
+}
+
+TEST(CordInputStreamTest, ReadingCords) {
+  for (int fragment_count : {0, 1, 5, 100}) {
+    for (int fragment_size : {1, 10, 1000, 100000}) {
+      SCOPED_TRACE(absl::StrCat("fragment_count = ", fragment_count,
+                                ", fragment_size = ", fragment_size));
+      std::vector<std::string> fragments;
+      for (int i = 0; i < fragment_count; i++) {
+        fragments.push_back(subtle::Random::GetRandomBytes(fragment_size));
+      }
+      absl::Cord cord = MakeFragmentedCord(fragments);
+      CordInputStream input_stream(cord);
+      std::string contents;
+      EXPECT_THAT(ReadTillEnd(&input_stream, &contents),
+                  StatusIs(error::OUT_OF_RANGE));
+      EXPECT_EQ(std::string(cord), contents);
+      EXPECT_EQ(cord.size(), input_stream.Position());
+    }
+  }
+}
+
+TEST(CordInputStreamTest, ChunksAreNotCopied) {
+  std::vector<std::string> fragments = {subtle::Random::GetRandomBytes(1000),
+                                        subtle::Random::GetRandomBytes(2000)};
+  CordInputStream input_stream(MakeFragmentedCord(fragments));
+  for (const std::string& fragment : fragments) {
+    const void* buffer;
+    auto next_result = input_stream.Next(&buffer);
+    ASSERT_THAT(next_result.status(), IsOk());
+    EXPECT_EQ(fragment.size(), next_result.ValueOrDie());
+    EXPECT_EQ(fragment.data(), buffer);
+  }
+}
+
+TEST(CordInputStreamTest, BackupAndPosition) {
+  std::vector<std::string> fragments = {subtle::Random::GetRandomBytes(1000),
+                                        subtle::Random::GetRandomBytes(2000)};
+  CordInputStream input_stream(MakeFragmentedCord(fragments));
+  const void* buffer;
+  EXPECT_EQ(0, input_stream.Position());
+  auto next_result = input_stream.Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  EXPECT_EQ(1000, input_stream.Position());
+
+  // BackUp several times, but in total fewer bytes than returned by Next().
+  int total_backup_size = 0;
+  for (int backup_size : {0, 1, 5, 0, 10, 100, -42, 400, 20, -100}) {
+    SCOPED_TRACE(absl::StrCat("backup_size = ", backup_size));
+    input_stream.BackUp(backup_size);
+    total_backup_size += std::max(0, backup_size);
+    EXPECT_EQ(1000 - total_backup_size, input_stream.Position());
+  }
+
+  // Call Next(), it should return exactly the backed up bytes.
+  next_result = input_stream.Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  EXPECT_EQ(total_backup_size, next_result.ValueOrDie());
+  EXPECT_EQ(fragments[0].substr(1000 - total_backup_size),
+            std::string(static_cast<const char*>(buffer), total_backup_size));
+  EXPECT_EQ(1000, input_stream.Position());
+
+  // Backing up more than returned by the last Next() backs up only that.
+  input_stream.BackUp(5000);
+  EXPECT_EQ(1000 - total_backup_size, input_stream.Position());
+
+  std::string rest;
+  EXPECT_THAT(ReadTillEnd(&input_stream, &rest),
+              StatusIs(error::OUT_OF_RANGE));
+  EXPECT_EQ(fragments[0].substr(1000 - total_backup_size) + fragments[1],
+            rest);
+  EXPECT_EQ(3000, input_stream.Position());
+}
+
+TEST(CordInputStreamTest, StreamingAeadWithCords) {
+  subtle::test::DummyStreamingAead saead(/*pt_segment_size=*/100,
+                                         /*header_size=*/10,
+                                         /*ct_offset=*/0);
+  std::vector<std::string> fragments;
+  for (int i = 0; i < 10; i++) {
+    fragments.push_back(subtle::Random::GetRandomBytes(777));
+  }
+  absl::Cord plaintext = MakeFragmentedCord(fragments);
+
+  // Encrypt the Cord into a Cord.
+  absl::Cord ciphertext;
+  auto enc_stream_result = saead.NewEncryptingStream(
+      absl::make_unique<CordOutputStream>(&ciphertext), "some aad");
+  ASSERT_THAT(enc_stream_result.status(), IsOk());
+  auto enc_stream = std::move(enc_stream_result.ValueOrDie());
+  for (absl::string_view chunk : plaintext.Chunks()) {
+    ASSERT_THAT(subtle::test::WriteToStream(enc_stream.get(), chunk,
+                                            /*close_stream=*/false),
+                IsOk());
+  }
+  ASSERT_THAT(enc_stream->Close(), IsOk());
+
+  // Decrypt it back.
+  auto dec_stream_result = saead.NewDecryptingStream(
+      absl::make_unique<CordInputStream>(ciphertext), "some aad");
+  ASSERT_THAT(dec_stream_result.status(), IsOk());
+  std::string decrypted;
+  EXPECT_THAT(subtle::test::ReadFromStream(
+                  dec_stream_result.ValueOrDie().get(), &decrypted),
+              IsOk());
+  EXPECT_EQ(std::string(plaintext), decrypted);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,100 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/util/cord_output_stream.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "absl/strings/cord.h"
+#include "tink/output_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+CordOutputStream::CordOutputStream(absl::Cord* destination, int buffer_size)
+    : buffer_size_(buffer_size > 0 ? buffer_size : 128 * 1024) {  // 128 KB
+  destination_ = destination;
+  count_in_buffer_ = 0;
+  count_backedup_ = 0;
+  position_ = 0;
+  buffer_offset_ = 0;
+  status_ = destination_ == nullptr
+                ? Status(util::error::INVALID_ARGUMENT,
+                         "destination must be non-null")
+                : Status::OK;
+}
+
+crypto::tink::util::StatusOr<int> CordOutputStream::Next(void** data) {
+  if (!status_.ok()) return status_;
+
+  // If some space was backed up, return it first.
+  if (count_backedup_ > 0) {
+    position_ = position_ + count_backedup_;
+    buffer_offset_ = count_in_buffer_;
+    count_in_buffer_ = count_in_buffer_ + count_backedup_;
+    int backedup = count_backedup_;
+    count_backedup_ = 0;
+    *data = &buffer_[buffer_offset_];
+    return backedup;
+  }
+
+  // No space was backed up, so buffer_ is full (or this is the first call
+  // to Next()). Hand buffer_ over to the Cord and start a new one.
+  if (count_in_buffer_ > 0) destination_->Append(std::move(buffer_));
+  buffer_ = std::string(buffer_size_, '\0');
+  count_in_buffer_ = buffer_size_;
+  buffer_offset_ = 0;
+  position_ = position_ + buffer_size_;
+  *data = &buffer_[0];
+  return buffer_size_;
+}
+
+void CordOutputStream::BackUp(int count) {
+  if (!status_.ok() || count < 1 || count_in_buffer_ == 0) return;
+  int curr_buffer_size = buffer_size_ - buffer_offset_;
+  int actual_count = std::min(count, curr_buffer_size - count_backedup_);
+  count_backedup_ += actual_count;
+  count_in_buffer_ -= actual_count;
+  position_ -= actual_count;
+}
+
+CordOutputStream::~CordOutputStream() {
+  Close().IgnoreError();
+}
+
+Status CordOutputStream::Close() {
+  if (!status_.ok()) return status_;
+  if (count_in_buffer_ > 0) {
+    buffer_.resize(count_in_buffer_);
+    destination_->Append(std::move(buffer_));
+    count_in_buffer_ = 0;
+  }
+  status_ = Status(util::error::FAILED_PRECONDITION, "Stream closed");
+  return Status::OK;
+}
+
+int64_t CordOutputStream::Position() const {
+  return position_;
+}
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,73 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_UTIL_CORD_OUTPUT_STREAM_H_
+#define TINK_UTIL_CORD_OUTPUT_STREAM_H_
+
+#include <cstdint>
+#include <string>
+
+#include "absl/strings/cord.h"
+#include "tink/output_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+// An OutputStream that appends to an absl::Cord. The bytes are written
+// to buffers that are handed over to the Cord as whole chunks, so they
+// are not copied again. With it a StreamingAead can produce its output
+// as a Cord, without going through a string.
+class CordOutputStream : public crypto::tink::OutputStream {
+ public:
+  // Constructs an OutputStream that will append to 'destination', which
+  // must outlive the stream, using buffers of the specified size, if any
+  // (if no legal 'buffer_size' is given, a reasonable default will be used).
+  // 'destination' is complete once Close() has been called.
+  explicit CordOutputStream(absl::Cord* destination, int buffer_size = -1);
+
+  ~CordOutputStream() override;
+
+  crypto::tink::util::StatusOr<int> Next(void** data) override;
+
+  void BackUp(int count) override;
+
+  crypto::tink::util::Status Close() override;
+
+  int64_t Position() const override;
+
+ private:
+  util::Status status_;
+  absl::Cord* destination_;
+  std::string buffer_;
+  const int buffer_size_;
+  int64_t position_;     // current position in the Cord (from the beginning)
+
+  // Counters that describe the state of the data in buffer_.
+  // After the first call to Next() there is an invariant:
+  // count_in_buffer_ == buffer_size_ - count_backedup_
+  int count_in_buffer_;  // # bytes in buffer_ that will be appended
+  int count_backedup_;   // # bytes in buffer_ that were backed up
+  int buffer_offset_;    // offset where the returned *data starts in buffer_
+};
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_UTIL_CORD_OUTPUT_STREAM_H_
@@ -0,0 +1,120 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/util/cord_output_stream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "absl/strings/cord.h"
+#include "absl/strings/str_cat.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+namespace {
+
+using ::crypto::tink::subtle::test::WriteToStream;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+TEST(CordOutputStreamTest, WritingCords) {
+  for (int stream_size : {0, 10, 100, 1000, 10000, 100000, 1000000}) {
+    for (int buffer_size : {-1, 1, 100, 4096}) {
+      SCOPED_TRACE(absl::StrCat("stream_size = ", stream_size,
+                                ", buffer_size = ", buffer_size));
+      std::string contents = subtle::Random::GetRandomBytes(stream_size);
+      absl::Cord cord("some prefix");
+      CordOutputStream output_stream(&cord, buffer_size);
+      EXPECT_THAT(WriteToStream(&output_stream, contents), IsOk());
+      EXPECT_EQ(stream_size, output_stream.Position());
+      EXPECT_EQ(absl::StrCat("some prefix", contents), std::string(cord));
+    }
+  }
+}
+
+TEST(CordOutputStreamTest, BackupAndPosition) {
+  int buffer_size = 1234;
+  std::string contents = subtle::Random::GetRandomBytes(3 * buffer_size);
+  absl::Cord cord;
+  CordOutputStream output_stream(&cord, buffer_size);
+  void* buffer;
+
+  EXPECT_EQ(0, output_stream.Position());
+  auto next_result = output_stream.Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  EXPECT_EQ(buffer_size, next_result.ValueOrDie());
+  EXPECT_EQ(buffer_size, output_stream.Position());
+  std::memcpy(buffer, contents.data(), buffer_size);
+
+  // BackUp several times, but in total fewer bytes than returned by Next().
+  int total_backup_size = 0;
+  for (int backup_size : {0, 1, 5, 0, 10, 100, -42, 400, 20, -100}) {
+    SCOPED_TRACE(absl::StrCat("backup_size = ", backup_size));
+    output_stream.BackUp(backup_size);
+    total_backup_size += std::max(0, backup_size);
+    EXPECT_EQ(buffer_size - total_backup_size, output_stream.Position());
+  }
+
+  // Call Next(), it should return exactly the backed up space.
+  next_result = output_stream.Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  EXPECT_EQ(total_backup_size, next_result.ValueOrDie());
+  EXPECT_EQ(buffer_size, output_stream.Position());
+  std::memcpy(buffer, contents.data() + buffer_size - total_backup_size,
+              total_backup_size);
+
+  // Backing up more than returned by the last Next() backs up only that.
+  output_stream.BackUp(buffer_size);
+  EXPECT_EQ(buffer_size - total_backup_size, output_stream.Position());
+
+  // Write the rest of the contents.
+  EXPECT_THAT(
+      WriteToStream(&output_stream,
+                    contents.substr(buffer_size - total_backup_size)),
+      IsOk());
+  EXPECT_EQ(contents, std::string(cord));
+}
+
+TEST(CordOutputStreamTest, Close) {
+  absl::Cord cord;
+  CordOutputStream output_stream(&cord);
+  EXPECT_THAT(WriteToStream(&output_stream, "some contents"), IsOk());
+  EXPECT_EQ("some contents", std::string(cord));
+  void* buffer;
+  EXPECT_THAT(output_stream.Next(&buffer).status(),
+              StatusIs(error::FAILED_PRECONDITION));
+  EXPECT_THAT(output_stream.Close(), StatusIs(error::FAILED_PRECONDITION));
+  EXPECT_EQ("some contents", std::string(cord));
+}
+
+TEST(CordOutputStreamTest, NullDestination) {
+  CordOutputStream output_stream(nullptr);
+  void* buffer;
+  EXPECT_THAT(output_stream.Next(&buffer).status(),
+              StatusIs(error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,139 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/util/deflate_output_stream.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "zlib.h"
+#include "tink/output_stream.h"
+#include "tink/util/buffer_pool.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+namespace {
+
+// The minimal size of the buffers returned by Next().
+constexpr int kMinBufferSize = 4 * 1024;
+
+}  // namespace
+
+DeflateOutputStream::DeflateOutputStream(
+    std::unique_ptr<crypto::tink::OutputStream> destination,
+    int compression_level)
+    : destination_(std::move(destination)),
+      stream_(absl::make_unique<z_stream_s>()),
+      buffer_pool_(BufferPool::Global()),
+      count_in_buffer_(0),
+      position_(0) {
+  if (deflateInit(stream_.get(), compression_level) != Z_OK) {
+    status_ = Status(util::error::INVALID_ARGUMENT,
+                     "Invalid compression level.");
+  }
+}
+
+DeflateOutputStream::~DeflateOutputStream() {
+  Close().IgnoreError();
+  deflateEnd(stream_.get());
+  buffer_pool_->Release(std::move(in_buffer_));
+}
+
+Status DeflateOutputStream::Deflate(bool finish) {
+  stream_->next_in = in_buffer_.data();
+  stream_->avail_in = count_in_buffer_;
+  count_in_buffer_ = 0;
+  while (true) {
+    if (stream_->avail_out == 0) {
+      // Compresses directly into the next buffer of the destination.
+      void* buffer;
+      auto next_result = destination_->Next(&buffer);
+      if (!next_result.ok()) return next_result.status();
+      stream_->next_out = static_cast<Bytef*>(buffer);
+      stream_->avail_out = next_result.ValueOrDie();
+      continue;
+    }
+    int ret = deflate(stream_.get(), finish ? Z_FINISH : Z_NO_FLUSH);
+    if (ret == Z_STREAM_END) return Status::OK;
+    if (ret != Z_OK && ret != Z_BUF_ERROR) {
+      return Status(util::error::INTERNAL, "Compression failed.");
+    }
+    if (!finish && stream_->avail_in == 0 && stream_->avail_out > 0) {
+      return Status::OK;
+    }
+  }
+}
+
+StatusOr<int> DeflateOutputStream::Next(void** data) {
+  if (!status_.ok()) return status_;
+  if (in_buffer_.empty()) {  // possible only at the first call to Next()
+    // The buffers have the size of the destination's buffers, e.g. of the
+    // plaintext segments of an encrypting stream.
+    void* buffer;
+    auto next_result = destination_->Next(&buffer);
+    if (!next_result.ok()) {
+      status_ = next_result.status();
+      return status_;
+    }
+    stream_->next_out = static_cast<Bytef*>(buffer);
+    stream_->avail_out = next_result.ValueOrDie();
+    in_buffer_ = buffer_pool_->Acquire(
+        std::max(next_result.ValueOrDie(), kMinBufferSize));
+  } else {
+    status_ = Deflate(/* finish = */ false);
+    if (!status_.ok()) return status_;
+  }
+  *data = in_buffer_.data();
+  count_in_buffer_ = in_buffer_.size();
+  position_ += in_buffer_.size();
+  return count_in_buffer_;
+}
+
+void DeflateOutputStream::BackUp(int count) {
+  if (!status_.ok() || count < 1) return;
+  int actual_count = std::min(count, count_in_buffer_);
+  count_in_buffer_ -= actual_count;
+  position_ -= actual_count;
+}
+
+Status DeflateOutputStream::Close() {
+  if (!status_.ok()) return status_;
+  status_ = Deflate(/* finish = */ true);
+  if (!status_.ok()) {
+    destination_->Close().IgnoreError();
+    return status_;
+  }
+  destination_->BackUp(stream_->avail_out);
+  status_ = destination_->Close();
+  if (!status_.ok()) return status_;
+  status_ = Status(util::error::FAILED_PRECONDITION, "Stream closed");
+  return Status::OK;
+}
+
+int64_t DeflateOutputStream::Position() const {
+  return position_;
+}
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
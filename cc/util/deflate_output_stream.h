@@ -0,0 +1,90 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_UTIL_DEFLATE_OUTPUT_STREAM_H_
+#define TINK_UTIL_DEFLATE_OUTPUT_STREAM_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tink/output_stream.h"
+#include "tink/util/buffer_pool.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+struct z_stream_s;
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+// An OutputStream that compresses the data written to it with zlib's
+// deflate, and writes the compressed data to another OutputStream,
+// typically an encrypting stream of a StreamingAead:
+//
+//   auto ct_stream = streaming_aead->NewEncryptingStream(...).ValueOrDie();
+//   DeflateOutputStream pt_stream(std::move(ct_stream));
+//
+// The compressed data is written directly into the buffers returned by
+// the destination's Next(), e.g. the plaintext segment of the encrypting
+// stream, so no copy is made between compression and encryption. The
+// buffers returned by Next() have the size of the first buffer of the
+// destination, i.e. of a segment, and are taken from BufferPool::Global().
+class DeflateOutputStream : public crypto::tink::OutputStream {
+ public:
+  // The zlib compression levels, from 1 (fastest) to 9 (best compression).
+  static constexpr int kDefaultCompressionLevel = -1;
+  static constexpr int kBestSpeed = 1;
+  static constexpr int kBestCompression = 9;
+
+  // Constructs an OutputStream that compresses into 'destination' with the
+  // given compression level. The data is in the zlib format (RFC 1950).
+  explicit DeflateOutputStream(
+      std::unique_ptr<crypto::tink::OutputStream> destination,
+      int compression_level = kDefaultCompressionLevel);
+
+  ~DeflateOutputStream() override;
+
+  crypto::tink::util::StatusOr<int> Next(void** data) override;
+
+  void BackUp(int count) override;
+
+  // Compresses the remaining data, and closes the destination.
+  crypto::tink::util::Status Close() override;
+
+  // Returns the number of uncompressed bytes written so far.
+  int64_t Position() const override;
+
+ private:
+  // Compresses the data in in_buffer_ into the destination, finishing the
+  // compressed stream if 'finish' is true.
+  crypto::tink::util::Status Deflate(bool finish);
+
+  util::Status status_;
+  std::unique_ptr<crypto::tink::OutputStream> destination_;
+  std::unique_ptr<z_stream_s> stream_;
+  util::BufferPool* buffer_pool_;  // source of in_buffer_
+  std::vector<uint8_t> in_buffer_;  // uncompressed data
+  int count_in_buffer_;  // # bytes in in_buffer_ written by the caller
+  int64_t position_;
+};
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_UTIL_DEFLATE_OUTPUT_STREAM_H_
@@ -0,0 +1,187 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/util/deflate_output_stream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "zlib.h"
+#include "tink/output_stream.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/streaming_aead_encrypting_stream.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/ostream_output_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+namespace {
+
+using ::crypto::tink::subtle::test::DummyStreamSegmentEncrypter;
+using ::crypto::tink::subtle::test::WriteToStream;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+// Decompresses 'compressed' with zlib's uncompress(), expecting 'size' bytes.
+std::string Uncompress(const std::string& compressed, int size) {
+  std::string uncompressed(size, '\0');
+  uLongf uncompressed_size = size;
+  EXPECT_EQ(uncompress(reinterpret_cast<Bytef*>(&uncompressed[0]),
+                       &uncompressed_size,
+                       reinterpret_cast<const Bytef*>(compressed.data()),
+                       compressed.size()),
+            Z_OK);
+  uncompressed.resize(uncompressed_size);
+  return uncompressed;
+}
+
+// A compressible string of 'size' bytes.
+std::string GetData(int size) {
+  std::string data;
+  while (data.size() < size) {
+    data += absl::StrCat("line ", data.size() % 1000, ": ",
+                         subtle::Random::GetRandomBytes(4), "\n");
+  }
+  data.resize(size);
+  return data;
+}
+
+TEST(DeflateOutputStreamTest, Compress) {
+  for (int size : {0, 1, 10, 100, 1000, 10000, 100000, 1000000}) {
+    for (int buffer_size : {1, 10, 1000, 100000}) {
+      SCOPED_TRACE(absl::StrCat("size = ", size,
+                                ", buffer_size = ", buffer_size));
+      std::string data = GetData(size);
+      auto ct_stream = absl::make_unique<std::stringstream>();
+      auto ct_buf = ct_stream->rdbuf();
+      DeflateOutputStream output_stream(
+          absl::make_unique<OstreamOutputStream>(std::move(ct_stream),
+                                                 buffer_size));
+      EXPECT_THAT(WriteToStream(&output_stream, data), IsOk());
+      EXPECT_EQ(output_stream.Position(), size);
+      std::string compressed = ct_buf->str();
+      if (size >= 1000) {
+        EXPECT_LT(compressed.size(), size);
+      }
+      EXPECT_EQ(Uncompress(compressed, size), data);
+    }
+  }
+}
+
+TEST(DeflateOutputStreamTest, CompressionLevels) {
+  std::string data = GetData(100000);
+  for (int level : {DeflateOutputStream::kBestSpeed,
+                    DeflateOutputStream::kBestCompression}) {
+    SCOPED_TRACE(absl::StrCat("level = ", level));
+    auto ct_stream = absl::make_unique<std::stringstream>();
+    auto ct_buf = ct_stream->rdbuf();
+    DeflateOutputStream output_stream(
+        absl::make_unique<OstreamOutputStream>(std::move(ct_stream)), level);
+    EXPECT_THAT(WriteToStream(&output_stream, data), IsOk());
+    EXPECT_EQ(Uncompress(ct_buf->str(), data.size()), data);
+  }
+
+  DeflateOutputStream output_stream(
+      absl::make_unique<OstreamOutputStream>(
+          absl::make_unique<std::stringstream>()),
+      /* compression_level = */ 10);
+  void* buffer;
+  EXPECT_THAT(output_stream.Next(&buffer).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(output_stream.Close(), StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(DeflateOutputStreamTest, BackUpAndPosition) {
+  auto ct_stream = absl::make_unique<std::stringstream>();
+  auto ct_buf = ct_stream->rdbuf();
+  DeflateOutputStream output_stream(
+      absl::make_unique<OstreamOutputStream>(std::move(ct_stream)));
+  void* buffer;
+  auto next_result = output_stream.Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  int buffer_size = next_result.ValueOrDie();
+  EXPECT_EQ(output_stream.Position(), buffer_size);
+  std::memset(buffer, 'a', 10);
+  output_stream.BackUp(buffer_size - 10);
+  EXPECT_EQ(output_stream.Position(), 10);
+  output_stream.BackUp(buffer_size);  // cannot back up beyond the buffer
+  EXPECT_EQ(output_stream.Position(), 0);
+
+  next_result = output_stream.Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  std::memset(buffer, 'b', 5);
+  output_stream.BackUp(next_result.ValueOrDie() - 5);
+  EXPECT_EQ(output_stream.Position(), 5);
+  EXPECT_THAT(output_stream.Close(), IsOk());
+  EXPECT_EQ(Uncompress(ct_buf->str(), 5), "bbbbb");
+
+  // The stream cannot be used after Close().
+  EXPECT_THAT(output_stream.Next(&buffer).status(),
+              StatusIs(util::error::FAILED_PRECONDITION));
+  EXPECT_THAT(output_stream.Close(),
+              StatusIs(util::error::FAILED_PRECONDITION));
+}
+
+TEST(DeflateOutputStreamTest, CompressIntoEncryptingStream) {
+  int pt_segment_size = 64 * 1024;
+  int header_size = 32;
+  auto ct_stream = absl::make_unique<std::stringstream>();
+  auto ct_buf = ct_stream->rdbuf();
+  auto enc_stream_result = subtle::StreamingAeadEncryptingStream::New(
+      absl::make_unique<DummyStreamSegmentEncrypter>(
+          pt_segment_size, header_size, /* ct_offset = */ 0),
+      absl::make_unique<OstreamOutputStream>(std::move(ct_stream)));
+  ASSERT_THAT(enc_stream_result.status(), IsOk());
+  DeflateOutputStream output_stream(std::move(enc_stream_result.ValueOrDie()));
+
+  // The buffers have the size of the first plaintext segment.
+  void* buffer;
+  auto next_result = output_stream.Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  EXPECT_EQ(next_result.ValueOrDie(), pt_segment_size - header_size);
+  output_stream.BackUp(next_result.ValueOrDie());
+
+  std::string data = GetData(1000000);
+  EXPECT_THAT(WriteToStream(&output_stream, data), IsOk());
+  std::string compressed_plaintext;
+  std::string ct = ct_buf->str();
+  // Strips the header and the segment tags of the dummy encryption.
+  const int tag_size = DummyStreamSegmentEncrypter::kSegmentTagSize;
+  int pos = header_size;
+  int segment_size = pt_segment_size - header_size;
+  while (pos < ct.size()) {
+    int size = std::min<int>(segment_size, ct.size() - pos - tag_size);
+    compressed_plaintext += ct.substr(pos, size);
+    pos += size + tag_size;
+    segment_size = pt_segment_size;
+  }
+  EXPECT_EQ(Uncompress(compressed_plaintext, data.size()), data);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
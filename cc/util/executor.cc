@@ -0,0 +1,149 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/util/executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+namespace {
+
+std::atomic<Executor*>& GlobalExecutor() {
+  static std::atomic<Executor*>* executor = new std::atomic<Executor*>(
+      new ThreadPool(std::max<int>(1, std::thread::hardware_concurrency())));
+  return *executor;
+}
+
+// Shared by the calling thread and the helpers of one ParallelFor() call.
+// Helpers may start after the call has returned, so they only touch 'task'
+// after registering as active while 'done' is false.
+struct ParallelForState {
+  ParallelForState(int64_t num_tasks,
+                   const std::function<void(int64_t)>* task)
+      : num_tasks(num_tasks), task(task) {}
+
+  void RunTasks() {
+    for (int64_t i = next_task.fetch_add(1, std::memory_order_relaxed);
+         i < num_tasks; i = next_task.fetch_add(1, std::memory_order_relaxed)) {
+      (*task)(i);
+    }
+  }
+
+  const int64_t num_tasks;
+  const std::function<void(int64_t)>* const task;
+  std::atomic<int64_t> next_task{0};
+  absl::Mutex mutex;
+  int active_helpers ABSL_GUARDED_BY(mutex) = 0;
+  bool done ABSL_GUARDED_BY(mutex) = false;
+};
+
+}  // namespace
+
+// static
+Executor* Executor::Global() {
+  return GlobalExecutor().load(std::memory_order_acquire);
+}
+
+// static
+void Executor::SetGlobal(Executor* executor) {
+  GlobalExecutor().store(executor, std::memory_order_release);
+}
+
+ThreadPool::ThreadPool(int num_threads) {
+  threads_.reserve(num_threads);
+  for (int i = 0; i < num_threads; i++) {
+    threads_.emplace_back(&ThreadPool::Run, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopping_ = true;
+  }
+  for (std::thread& thread : threads_) thread.join();
+}
+
+void ThreadPool::Schedule(std::function<void()> task) {
+  absl::MutexLock lock(&mutex_);
+  tasks_.push_back(std::move(task));
+}
+
+void ThreadPool::Run() {
+  while (true) {
+    std::function<void()> task;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(
+          +[](ThreadPool* pool) ABSL_EXCLUSIVE_LOCKS_REQUIRED(pool->mutex_) {
+            return pool->stopping_ || !pool->tasks_.empty();
+          },
+          this));
+      if (tasks_.empty()) return;
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+void ParallelFor(int64_t num_tasks, int max_parallelism,
+                 const std::function<void(int64_t task)>& task,
+                 Executor* executor) {
+  if (num_tasks <= 0) return;
+  int64_t num_helpers =
+      std::min<int64_t>(std::max(max_parallelism, 1), num_tasks) - 1;
+  if (num_helpers == 0) {
+    for (int64_t i = 0; i < num_tasks; i++) task(i);
+    return;
+  }
+  if (executor == nullptr) executor = Executor::Global();
+  auto state = std::make_shared<ParallelForState>(num_tasks, &task);
+  for (int64_t i = 0; i < num_helpers; i++) {
+    executor->Schedule([state] {
+      {
+        absl::MutexLock lock(&state->mutex);
+        if (state->done) return;
+        state->active_helpers++;
+      }
+      state->RunTasks();
+      absl::MutexLock lock(&state->mutex);
+      state->active_helpers--;
+    });
+  }
+  state->RunTasks();
+  absl::MutexLock lock(&state->mutex);
+  state->mutex.Await(absl::Condition(
+      +[](ParallelForState* state) ABSL_EXCLUSIVE_LOCKS_REQUIRED(
+           state->mutex) { return state->active_helpers == 0; },
+      state.get()));
+  state->done = true;
+}
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
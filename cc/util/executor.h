@@ -0,0 +1,115 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_UTIL_EXECUTOR_H_
+#define TINK_UTIL_EXECUTOR_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+// Runs the tasks of Tink's parallel operations, such as batch verification,
+// parallel keyset parsing and multi-threaded encryption of large messages.
+// Applications with their own scheduler implement this interface, or wrap
+// their scheduler in a FunctionExecutor, and install it with SetGlobal() so
+// that Tink does not start threads of its own.
+//
+// Tink never waits for a scheduled task to start: the thread starting a
+// parallel operation works on it as well, and the scheduled tasks only help
+// (see ParallelFor below). Therefore executors may run tasks late, queue
+// them behind long-running work, or run them on fibers, and Tink operations
+// may be started from within scheduled tasks. Tasks may block briefly on
+// mutexes, but never on other tasks. Implementations must be thread-safe.
+class Executor {
+ public:
+  // Runs 'task' at some point, on any thread.
+  virtual void Schedule(std::function<void()> task) = 0;
+
+  virtual ~Executor() {}
+
+  // Returns the executor used by Tink's parallel operations: a ThreadPool
+  // with one thread per hardware thread, created on first use, unless
+  // replaced with SetGlobal().
+  static Executor* Global();
+
+  // Makes the parallel operations started from now on use 'executor', which
+  // must not be null and must outlive all tasks scheduled on it.
+  static void SetGlobal(Executor* executor);
+};
+
+// An Executor with a fixed number of threads and a queue of pending tasks.
+class ThreadPool : public Executor {
+ public:
+  explicit ThreadPool(int num_threads);
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Runs the pending tasks, then joins the threads.
+  ~ThreadPool() override;
+
+  void Schedule(std::function<void()> task) override;
+
+ private:
+  void Run();
+
+  absl::Mutex mutex_;
+  std::deque<std::function<void()>> tasks_ ABSL_GUARDED_BY(mutex_);
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<std::thread> threads_;
+};
+
+// Adapts a scheduling function, e.g. of an application's own scheduler, to
+// the Executor interface.
+class FunctionExecutor : public Executor {
+ public:
+  explicit FunctionExecutor(
+      std::function<void(std::function<void()>)> schedule)
+      : schedule_(std::move(schedule)) {}
+
+  void Schedule(std::function<void()> task) override {
+    schedule_(std::move(task));
+  }
+
+ private:
+  const std::function<void(std::function<void()>)> schedule_;
+};
+
+// Runs task(0), ..., task(num_tasks - 1) and returns once all of them have
+// finished. The tasks are claimed in order by the calling thread and by up to
+// max_parallelism - 1 helpers scheduled on 'executor', or on
+// Executor::Global() if 'executor' is null. Since the calling thread keeps
+// claiming tasks until none are left, the call completes even if no helper
+// ever runs.
+void ParallelFor(int64_t num_tasks, int max_parallelism,
+                 const std::function<void(int64_t task)>& task,
+                 Executor* executor = nullptr);
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_UTIL_EXECUTOR_H_
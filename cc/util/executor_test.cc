@@ -0,0 +1,132 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/util/executor.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/synchronization/blocking_counter.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+namespace {
+
+using ::testing::Each;
+using ::testing::Eq;
+
+TEST(ThreadPoolTest, RunsScheduledTasks) {
+  std::atomic<int> runs(0);
+  {
+    ThreadPool pool(4);
+    absl::BlockingCounter done(100);
+    for (int i = 0; i < 100; i++) {
+      pool.Schedule([&runs, &done] {
+        runs++;
+        done.DecrementCount();
+      });
+    }
+    done.Wait();
+  }
+  EXPECT_EQ(runs, 100);
+}
+
+TEST(ThreadPoolTest, DestructorRunsPendingTasks) {
+  std::atomic<int> runs(0);
+  {
+    ThreadPool pool(1);
+    for (int i = 0; i < 100; i++) {
+      pool.Schedule([&runs] { runs++; });
+    }
+  }
+  EXPECT_EQ(runs, 100);
+}
+
+TEST(FunctionExecutorTest, ForwardsTasks) {
+  std::vector<std::function<void()>> scheduled;
+  FunctionExecutor executor(
+      [&scheduled](std::function<void()> task) { scheduled.push_back(task); });
+  int runs = 0;
+  executor.Schedule([&runs] { runs++; });
+  ASSERT_EQ(scheduled.size(), 1);
+  scheduled[0]();
+  EXPECT_EQ(runs, 1);
+}
+
+TEST(ParallelForTest, RunsEveryTaskOnce) {
+  ThreadPool pool(4);
+  for (int max_parallelism : {0, 1, 2, 4, 16}) {
+    for (int64_t num_tasks : {0, 1, 3, 1000}) {
+      std::vector<std::atomic<int>> runs(num_tasks);
+      ParallelFor(
+          num_tasks, max_parallelism, [&runs](int64_t i) { runs[i]++; },
+          &pool);
+      for (const auto& count : runs) EXPECT_EQ(count, 1);
+    }
+  }
+}
+
+TEST(ParallelForTest, CompletesWhenHelpersNeverRun) {
+  std::vector<std::function<void()>> scheduled;
+  FunctionExecutor executor(
+      [&scheduled](std::function<void()> task) { scheduled.push_back(task); });
+  std::vector<int> runs(100);
+  ParallelFor(
+      runs.size(), 8, [&runs](int64_t i) { runs[i]++; }, &executor);
+  EXPECT_THAT(runs, Each(Eq(1)));
+  EXPECT_EQ(scheduled.size(), 7);
+  // Helpers starting after the call has returned do nothing.
+  for (auto& task : scheduled) task();
+  EXPECT_THAT(runs, Each(Eq(1)));
+}
+
+TEST(ParallelForTest, NestedOnSingleThread) {
+  ThreadPool pool(1);
+  std::atomic<int> runs(0);
+  ParallelFor(
+      4, 4,
+      [&runs, &pool](int64_t) {
+        ParallelFor(
+            4, 4, [&runs](int64_t) { runs++; }, &pool);
+      },
+      &pool);
+  EXPECT_EQ(runs, 16);
+}
+
+TEST(ParallelForTest, UsesGlobalExecutor) {
+  std::atomic<int> scheduled(0);
+  FunctionExecutor executor([&scheduled](std::function<void()> task) {
+    scheduled++;
+    task();
+  });
+  Executor* previous = Executor::Global();
+  Executor::SetGlobal(&executor);
+  std::atomic<int> runs(0);
+  ParallelFor(10, 3, [&runs](int64_t) { runs++; });
+  Executor::SetGlobal(previous);
+  EXPECT_EQ(scheduled, 2);
+  EXPECT_EQ(runs, 10);
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
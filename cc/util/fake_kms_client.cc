@@ -17,19 +17,28 @@
 
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <sstream>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/escaping.h"
 #include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "tink/aead/aead_key_templates.h"
+#include "tink/async_aead.h"
 #include "tink/binary_keyset_reader.h"
 #include "tink/binary_keyset_writer.h"
 #include "tink/cleartext_keyset_handle.h"
 #include "tink/kms_client.h"
+#include "tink/subtle/random.h"
 #include "tink/util/errors.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
@@ -54,6 +63,80 @@ std::string GetEncodedKeyset(absl::string_view key_uri) {
   return std::string(key_uri.substr(std::string(kKeyUriPrefix).length()));
 }
 
+// Returns a pseudorandom number in [0, 1).
+double RandomFraction() {
+  return subtle::Random::GetRandomUInt32() / 4294967296.0;
+}
+
+// Waits for the simulated latency of one remote call, and returns the
+// simulated error of the call, if any.
+Status SimulateRemoteCall(const FakeKmsClient::Conditions& conditions) {
+  absl::SleepFor(conditions.latency + conditions.jitter * RandomFraction());
+  if (RandomFraction() < conditions.error_rate) {
+    return Status(util::error::UNAVAILABLE, "Simulated KMS error");
+  }
+  return util::OkStatus();
+}
+
+// Wraps the Aead of a fake KMS key, simulating the conditions of the remote
+// calls. Asynchronous calls run on a detached thread each, which owns what
+// it uses, so that the SimulatedRemoteAead may be deleted before they
+// complete.
+class SimulatedRemoteAead : public Aead, public AsyncAead {
+ public:
+  SimulatedRemoteAead(std::unique_ptr<Aead> aead,
+                      const FakeKmsClient::Conditions& conditions)
+      : aead_(std::move(aead)), conditions_(conditions) {}
+
+  StatusOr<std::string> Encrypt(
+      absl::string_view plaintext,
+      absl::string_view associated_data) const override {
+    Status status = SimulateRemoteCall(conditions_);
+    if (!status.ok()) return status;
+    return aead_->Encrypt(plaintext, associated_data);
+  }
+
+  StatusOr<std::string> Decrypt(
+      absl::string_view ciphertext,
+      absl::string_view associated_data) const override {
+    Status status = SimulateRemoteCall(conditions_);
+    if (!status.ok()) return status;
+    return aead_->Decrypt(ciphertext, associated_data);
+  }
+
+  void EncryptAsync(absl::string_view plaintext,
+                    absl::string_view associated_data,
+                    Callback done) const override {
+    std::shared_ptr<const Aead> aead = aead_;
+    FakeKmsClient::Conditions conditions = conditions_;
+    std::string input(plaintext);
+    std::string ad(associated_data);
+    std::thread([aead, conditions, input, ad, done]() {
+      Status status = SimulateRemoteCall(conditions);
+      if (!status.ok()) return done(status);
+      done(aead->Encrypt(input, ad));
+    }).detach();
+  }
+
+  void DecryptAsync(absl::string_view ciphertext,
+                    absl::string_view associated_data,
+                    Callback done) const override {
+    std::shared_ptr<const Aead> aead = aead_;
+    FakeKmsClient::Conditions conditions = conditions_;
+    std::string input(ciphertext);
+    std::string ad(associated_data);
+    std::thread([aead, conditions, input, ad, done]() {
+      Status status = SimulateRemoteCall(conditions);
+      if (!status.ok()) return done(status);
+      done(aead->Decrypt(input, ad));
+    }).detach();
+  }
+
+ private:
+  std::shared_ptr<const Aead> aead_;
+  FakeKmsClient::Conditions conditions_;
+};
+
 }  // namespace
 
 
@@ -72,6 +155,16 @@ StatusOr<std::unique_ptr<FakeKmsClient>> FakeKmsClient::New(
   return std::move(client);
 }
 
+// static
+StatusOr<std::unique_ptr<FakeKmsClient>> FakeKmsClient::NewWithConditions(
+    absl::string_view key_uri, absl::string_view credentials_path,
+    const Conditions& conditions) {
+  auto client_result = New(key_uri, credentials_path);
+  if (!client_result.ok()) return client_result.status();
+  client_result.ValueOrDie()->conditions_ = conditions;
+  return std::move(client_result.ValueOrDie());
+}
+
 bool FakeKmsClient::DoesSupport(absl::string_view key_uri) const {
   if (!encoded_keyset_.empty()) {
     return encoded_keyset_ == GetEncodedKeyset(key_uri);
@@ -105,7 +198,16 @@ StatusOr<std::unique_ptr<Aead>> FakeKmsClient::GetAead(
   if (!handle_result.ok()) {
     return handle_result.status();
   }
-  return handle_result.ValueOrDie()->GetPrimitive<crypto::tink::Aead>();
+  auto aead_result =
+      handle_result.ValueOrDie()->GetPrimitive<crypto::tink::Aead>();
+  if (!aead_result.ok()) return aead_result.status();
+  if (conditions_.latency == absl::ZeroDuration() &&
+      conditions_.jitter == absl::ZeroDuration() &&
+      conditions_.error_rate <= 0) {
+    return aead_result;
+  }
+  return {absl::make_unique<SimulatedRemoteAead>(
+      std::move(aead_result.ValueOrDie()), conditions_)};
 }
 
 Status FakeKmsClient::RegisterNewClient(absl::string_view key_uri,
@@ -20,6 +20,7 @@
 #include <memory>
 
 #include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "tink/aead.h"
 #include "tink/keyset_handle.h"
 #include "tink/kms_client.h"
@@ -40,8 +41,22 @@ namespace test {
 // by encoding the key in the 'key_uri'. So the client simply needs to decode
 // the key and generate an AEAD out of it. This is of course insecure and should
 // only be used in testing.
+//
+// To evaluate code depending on a KMS without a real one, the client can
+// also simulate the latency and failures of the remote calls.
 class FakeKmsClient : public crypto::tink::KmsClient {
  public:
+  // Simulated conditions of the remote calls made by the Aead primitives
+  // of a client. The defaults add neither latency nor errors.
+  struct Conditions {
+    // Each call takes 'latency' plus a uniformly distributed extra delay of
+    // up to 'jitter'.
+    absl::Duration latency = absl::ZeroDuration();
+    absl::Duration jitter = absl::ZeroDuration();
+    // The fraction of calls, from 0 to 1, that fail with UNAVAILABLE.
+    double error_rate = 0;
+  };
+
   // Creates a new FakeKmsClient that is bound to the key specified in
   // 'key_uri'.
   //
@@ -51,6 +66,14 @@ class FakeKmsClient : public crypto::tink::KmsClient {
   static crypto::tink::util::StatusOr<std::unique_ptr<FakeKmsClient>> New(
       absl::string_view key_uri, absl::string_view credentials_path);
 
+  // Same as New(), but the Aead primitives returned by GetAead() simulate
+  // 'conditions'. They also implement AsyncAead, whose operations complete
+  // on a new thread after the simulated latency.
+  static crypto::tink::util::StatusOr<std::unique_ptr<FakeKmsClient>>
+  NewWithConditions(absl::string_view key_uri,
+                    absl::string_view credentials_path,
+                    const Conditions& conditions);
+
   // Creates a new client and registers it in KMSClients.
   static crypto::tink::util::Status RegisterNewClient(
       absl::string_view key_uri, absl::string_view credentials_path);
@@ -69,6 +92,7 @@ class FakeKmsClient : public crypto::tink::KmsClient {
  private:
   FakeKmsClient() {}
   std::string encoded_keyset_;
+  Conditions conditions_;
 };
 
 }  // namespace test
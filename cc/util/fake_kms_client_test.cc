@@ -21,8 +21,12 @@
 #include <vector>
 
 #include "gtest/gtest.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "tink/aead/aead_config.h"
 #include "tink/aead/aead_key_templates.h"
+#include "tink/async_aead.h"
 #include "tink/util/status.h"
 #include "tink/util/statusor.h"
 #include "tink/util/test_matchers.h"
@@ -189,6 +193,74 @@ TEST_F(FakeKmsClientTest, RegisterAndEncryptDecryptWithKmsEnvelopeAead) {
   EXPECT_EQ(plaintext, decrypt_result.ValueOrDie());
 }
 
+TEST_F(FakeKmsClientTest, SimulatesLatency) {
+  auto uri_result = FakeKmsClient::CreateFakeKeyUri();
+  ASSERT_TRUE(uri_result.ok()) << uri_result.status();
+  std::string key_uri = uri_result.ValueOrDie();
+  FakeKmsClient::Conditions conditions;
+  conditions.latency = absl::Milliseconds(20);
+  auto client_result =
+      FakeKmsClient::NewWithConditions(key_uri, "", conditions);
+  ASSERT_TRUE(client_result.ok()) << client_result.status();
+  auto aead_result = client_result.ValueOrDie()->GetAead(key_uri);
+  ASSERT_TRUE(aead_result.ok()) << aead_result.status();
+  auto aead = std::move(aead_result.ValueOrDie());
+
+  absl::Time start = absl::Now();
+  auto encrypt_result = aead->Encrypt("some_plaintext", "some_aad");
+  EXPECT_GE(absl::Now() - start, conditions.latency);
+  ASSERT_TRUE(encrypt_result.ok()) << encrypt_result.status();
+  auto decrypt_result = aead->Decrypt(encrypt_result.ValueOrDie(), "some_aad");
+  ASSERT_TRUE(decrypt_result.ok()) << decrypt_result.status();
+  EXPECT_EQ("some_plaintext", decrypt_result.ValueOrDie());
+}
+
+TEST_F(FakeKmsClientTest, SimulatesErrors) {
+  auto uri_result = FakeKmsClient::CreateFakeKeyUri();
+  ASSERT_TRUE(uri_result.ok()) << uri_result.status();
+  std::string key_uri = uri_result.ValueOrDie();
+  FakeKmsClient::Conditions conditions;
+  conditions.error_rate = 1;
+  auto client_result =
+      FakeKmsClient::NewWithConditions(key_uri, "", conditions);
+  ASSERT_TRUE(client_result.ok()) << client_result.status();
+  auto aead_result = client_result.ValueOrDie()->GetAead(key_uri);
+  ASSERT_TRUE(aead_result.ok()) << aead_result.status();
+
+  auto encrypt_result =
+      aead_result.ValueOrDie()->Encrypt("some_plaintext", "some_aad");
+  EXPECT_EQ(util::error::UNAVAILABLE, encrypt_result.status().error_code());
+}
+
+TEST_F(FakeKmsClientTest, SimulatedAeadIsAsync) {
+  auto uri_result = FakeKmsClient::CreateFakeKeyUri();
+  ASSERT_TRUE(uri_result.ok()) << uri_result.status();
+  std::string key_uri = uri_result.ValueOrDie();
+  FakeKmsClient::Conditions conditions;
+  conditions.latency = absl::Milliseconds(1);
+  auto client_result =
+      FakeKmsClient::NewWithConditions(key_uri, "", conditions);
+  ASSERT_TRUE(client_result.ok()) << client_result.status();
+  auto aead_result = client_result.ValueOrDie()->GetAead(key_uri);
+  ASSERT_TRUE(aead_result.ok()) << aead_result.status();
+  auto aead = std::move(aead_result.ValueOrDie());
+  auto* async_aead = dynamic_cast<const AsyncAead*>(aead.get());
+  ASSERT_NE(async_aead, nullptr);
+
+  absl::Notification done;
+  util::StatusOr<std::string> encrypt_result;
+  async_aead->EncryptAsync("some_plaintext", "some_aad",
+                           [&](util::StatusOr<std::string> result) {
+                             encrypt_result = std::move(result);
+                             done.Notify();
+                           });
+  done.WaitForNotification();
+  ASSERT_TRUE(encrypt_result.ok()) << encrypt_result.status();
+  auto decrypt_result = aead->Decrypt(encrypt_result.ValueOrDie(), "some_aad");
+  ASSERT_TRUE(decrypt_result.ok()) << decrypt_result.status();
+  EXPECT_EQ("some_plaintext", decrypt_result.ValueOrDie());
+}
+
 // TODO(b/174740983): Add test where an unbounded KeyClient is registered.
 // This is not yet implemented as it would break the isolation of the tests:
 // Once a unbounded client is registered, it can't currently be unregistered.
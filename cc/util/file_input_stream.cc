@@ -16,8 +16,12 @@
 
 #include "tink/util/file_input_stream.h"
 
+#include <fcntl.h>
 #include <unistd.h>
+
 #include <algorithm>
+#include <cerrno>
+#include <cstdint>
 
 #include "absl/memory/memory.h"
 #include "tink/input_stream.h"
@@ -52,31 +56,85 @@ int read_ignoring_eintr(int fd, void *buf, size_t count) {
   return result;
 }
 
+// Alignment of the buffer, the read sizes and the file offsets required by
+// direct I/O on common file systems.
+constexpr int kDirectIoAlignment = 4096;
+
+// Sets or clears O_DIRECT for 'fd', and returns true on success.
+bool set_direct_io(int fd, bool enabled) {
+#ifdef O_DIRECT
+  int flags = fcntl(fd, F_GETFL);
+  if (flags < 0) return false;
+  flags = enabled ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+  return fcntl(fd, F_SETFL, flags) == 0;
+#else
+  return !enabled;
+#endif
+}
+
+int get_buffer_size(int buffer_size, bool direct_io) {
+  if (buffer_size <= 0) return 128 * 1024;  // 128 KB
+  if (!direct_io) return buffer_size;
+  int64_t aligned_size =
+      (static_cast<int64_t>(buffer_size) + kDirectIoAlignment - 1) /
+      kDirectIoAlignment * kDirectIoAlignment;
+  return std::min<int64_t>(aligned_size, INT32_MAX / kDirectIoAlignment *
+                                             kDirectIoAlignment);
+}
+
 }  // anonymous namespace
 
-FileInputStream::FileInputStream(int file_descriptor, int buffer_size) :
-    buffer_size_(buffer_size > 0 ? buffer_size : 128 * 1024) {  // 128 KB
+FileInputStream::FileInputStream(int file_descriptor, int buffer_size)
+    : FileInputStream(file_descriptor, buffer_size, /*direct_io=*/false) {}
+
+FileInputStream::FileInputStream(int file_descriptor, int buffer_size,
+                                 bool direct_io)
+    : buffer_size_(get_buffer_size(buffer_size, direct_io)) {
   fd_ = file_descriptor;
+  direct_io_ = direct_io;
   count_in_buffer_ = 0;
   count_backedup_ = 0;
   position_ = 0;
-  buffer_ = absl::make_unique<uint8_t[]>(buffer_size_);
+  int alignment = direct_io_ ? kDirectIoAlignment : 1;
+  buffer_storage_ = absl::make_unique<uint8_t[]>(buffer_size_ + alignment - 1);
+  auto address = reinterpret_cast<uintptr_t>(buffer_storage_.get());
+  buffer_ = buffer_storage_.get() +
+            (alignment - address % alignment) % alignment;
   buffer_offset_ = 0;
   status_ = Status::OK;
 }
 
+// static
+StatusOr<std::unique_ptr<FileInputStream>> FileInputStream::NewWithDirectIo(
+    int file_descriptor, int buffer_size) {
+  if (!set_direct_io(file_descriptor, true)) {
+    return ToStatusF(util::error::UNIMPLEMENTED,
+                     "Direct I/O is not supported: %d", errno);
+  }
+  return {absl::WrapUnique(
+      new FileInputStream(file_descriptor, buffer_size, /*direct_io=*/true))};
+}
+
 crypto::tink::util::StatusOr<int> FileInputStream::Next(const void** data) {
   if (!status_.ok()) return status_;
   if (count_backedup_ > 0) {  // Return the backed-up bytes.
     buffer_offset_ = buffer_offset_ + (count_in_buffer_ - count_backedup_);
     count_in_buffer_ = count_backedup_;
     count_backedup_ = 0;
-    *data = buffer_.get() + buffer_offset_;
+    *data = buffer_ + buffer_offset_;
     position_ = position_ + count_in_buffer_;
     return count_in_buffer_;
   }
   // Read new bytes to buffer_.
-  int read_result = read_ignoring_eintr(fd_, buffer_.get(), buffer_size_);
+  int read_result = read_ignoring_eintr(fd_, buffer_, buffer_size_);
+  if (read_result < 0 && errno == EINVAL && direct_io_) {
+    // The file offset is not aligned for direct I/O (e.g. after a short
+    // read), so continue without it.
+    direct_io_ = false;
+    if (set_direct_io(fd_, false)) {
+      read_result = read_ignoring_eintr(fd_, buffer_, buffer_size_);
+    }
+  }
   if (read_result <= 0) {  // EOF or an I/O error.
     if (read_result == 0) {
       status_ = Status(util::error::OUT_OF_RANGE, "EOF");
@@ -90,7 +148,7 @@ crypto::tink::util::StatusOr<int> FileInputStream::Next(const void** data) {
   count_backedup_ = 0;
   count_in_buffer_ = read_result;
   position_ = position_ + count_in_buffer_;
-  *data = buffer_.get();
+  *data = buffer_;
   return count_in_buffer_;
 }
 
@@ -34,8 +34,20 @@ class FileInputStream : public crypto::tink::InputStream {
   // via 'file_descriptor', using a buffer of the specified size, if any
   // (if no legal 'buffer_size' is given, a reasonable default will be used).
   // Takes the ownership of the file, and will close it upon destruction.
+  // When this stream feeds a streaming decryption, a 'buffer_size' equal to
+  // the ciphertext segment size lets each segment be read with one syscall.
   explicit FileInputStream(int file_descriptor, int buffer_size = -1);
 
+  // Like the constructor above, but reads the file with direct I/O
+  // (O_DIRECT), bypassing the page cache, which avoids a copy of the data
+  // for large files that are read only once. 'buffer_size' is rounded up
+  // to a multiple of the I/O alignment. If a read cannot be done with
+  // direct I/O (e.g. at an unaligned file offset), the stream continues
+  // without it. Returns an error, without taking the ownership of the file,
+  // if direct I/O is not supported for the file.
+  static crypto::tink::util::StatusOr<std::unique_ptr<FileInputStream>>
+  NewWithDirectIo(int file_descriptor, int buffer_size = -1);
+
   ~FileInputStream() override;
 
   crypto::tink::util::StatusOr<int> Next(const void** data) override;
@@ -45,10 +57,15 @@ class FileInputStream : public crypto::tink::InputStream {
   int64_t Position() const override;
 
  private:
+  FileInputStream(int file_descriptor, int buffer_size, bool direct_io);
+
   util::Status status_;
   int fd_;
-  std::unique_ptr<uint8_t[]> buffer_;
+  bool direct_io_;
   const int buffer_size_;
+  // buffer_ points into buffer_storage_, aligned as needed for direct I/O.
+  std::unique_ptr<uint8_t[]> buffer_storage_;
+  uint8_t* buffer_;
   int64_t position_;     // current position in the file (from the beginning)
 
   // Counters that describe the state of the data in buffer_.
@@ -16,6 +16,8 @@
 
 #include "tink/util/file_input_stream.h"
 
+#include <unistd.h>
+
 #include "gtest/gtest.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
@@ -82,6 +84,36 @@ TEST_F(FileInputStreamTest, testCustomBufferSizes) {
   }
 }
 
+TEST_F(FileInputStreamTest, testDirectIo) {
+  int stream_size = 100000;
+  for (auto buffer_size : {1, 4096, 10000}) {
+    for (auto start_offset : {0, 1}) {
+      SCOPED_TRACE(absl::StrCat("buffer_size = ", buffer_size,
+                                ", start_offset = ", start_offset));
+      std::string file_contents;
+      std::string filename = absl::StrCat(buffer_size, "_", start_offset,
+                                          "_direct_io_test.bin");
+      int input_fd =
+          test::GetTestFileDescriptor(filename, stream_size, &file_contents);
+      // Starting at an unaligned offset makes the stream fall back to
+      // regular reads.
+      ASSERT_EQ(start_offset, lseek(input_fd, start_offset, SEEK_SET));
+      auto input_stream_result =
+          util::FileInputStream::NewWithDirectIo(input_fd, buffer_size);
+      if (!input_stream_result.ok()) {
+        close(input_fd);
+        GTEST_SKIP() << "Direct I/O not supported: "
+                     << input_stream_result.status();
+      }
+      auto input_stream = std::move(input_stream_result.ValueOrDie());
+      std::string stream_contents;
+      auto status = ReadTillEnd(input_stream.get(), &stream_contents);
+      EXPECT_EQ(util::error::OUT_OF_RANGE, status.error_code());
+      EXPECT_EQ(file_contents.substr(start_offset), stream_contents);
+    }
+  }
+}
+
 TEST_F(FileInputStreamTest, testBackupAndPosition) {
   int stream_size = 100000;
   int buffer_size = 1234;
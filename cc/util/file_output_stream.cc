@@ -16,9 +16,13 @@
 
 #include "tink/util/file_output_stream.h"
 
+#include <fcntl.h>
 #include <unistd.h>
-#include <cstring>
+
 #include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
 
 #include "absl/memory/memory.h"
 #include "tink/output_stream.h"
@@ -53,12 +57,43 @@ int write_ignoring_eintr(int fd, const void *buf, size_t count) {
   return result;
 }
 
+// Alignment of the buffer, the write sizes and the file offsets required by
+// direct I/O on common file systems.
+constexpr int kDirectIoAlignment = 4096;
+
+// Sets or clears O_DIRECT for 'fd', and returns true on success.
+bool set_direct_io(int fd, bool enabled) {
+#ifdef O_DIRECT
+  int flags = fcntl(fd, F_GETFL);
+  if (flags < 0) return false;
+  flags = enabled ? (flags | O_DIRECT) : (flags & ~O_DIRECT);
+  return fcntl(fd, F_SETFL, flags) == 0;
+#else
+  return !enabled;
+#endif
+}
+
+int get_buffer_size(int buffer_size, bool direct_io) {
+  if (buffer_size <= 0) return 128 * 1024;  // 128 KB
+  if (!direct_io) return buffer_size;
+  int64_t aligned_size =
+      (static_cast<int64_t>(buffer_size) + kDirectIoAlignment - 1) /
+      kDirectIoAlignment * kDirectIoAlignment;
+  return std::min<int64_t>(aligned_size, INT32_MAX / kDirectIoAlignment *
+                                             kDirectIoAlignment);
+}
+
 }  // anonymous namespace
 
 
-FileOutputStream::FileOutputStream(int file_descriptor, int buffer_size) :
-    buffer_size_(buffer_size > 0 ? buffer_size : 128 * 1024) {  // 128 KB
+FileOutputStream::FileOutputStream(int file_descriptor, int buffer_size)
+    : FileOutputStream(file_descriptor, buffer_size, /*direct_io=*/false) {}
+
+FileOutputStream::FileOutputStream(int file_descriptor, int buffer_size,
+                                   bool direct_io)
+    : buffer_size_(get_buffer_size(buffer_size, direct_io)) {
   fd_ = file_descriptor;
+  direct_io_ = direct_io;
   count_in_buffer_ = 0;
   count_backedup_ = 0;
   buffer_ = nullptr;
@@ -67,12 +102,41 @@ FileOutputStream::FileOutputStream(int file_descriptor, int buffer_size) :
   status_ = Status::OK;
 }
 
+// static
+StatusOr<std::unique_ptr<FileOutputStream>> FileOutputStream::NewWithDirectIo(
+    int file_descriptor, int buffer_size) {
+  if (!set_direct_io(file_descriptor, true)) {
+    return ToStatusF(util::error::UNIMPLEMENTED,
+                     "Direct I/O is not supported: %d", errno);
+  }
+  return {absl::WrapUnique(
+      new FileOutputStream(file_descriptor, buffer_size, /*direct_io=*/true))};
+}
+
+int FileOutputStream::Write(const uint8_t* buf, int count) {
+  int write_result = write_ignoring_eintr(fd_, buf, count);
+  if (write_result < 0 && errno == EINVAL && direct_io_) {
+    // The data or the file offset is not aligned for direct I/O (e.g. at
+    // the end of the file), so continue without it.
+    direct_io_ = false;
+    if (set_direct_io(fd_, false)) {
+      write_result = write_ignoring_eintr(fd_, buf, count);
+    }
+  }
+  return write_result;
+}
+
 crypto::tink::util::StatusOr<int> FileOutputStream::Next(void** data) {
   if (!status_.ok()) return status_;
 
   if (buffer_ == nullptr) {  // possible only at the first call to Next()
-    buffer_ = absl::make_unique<uint8_t[]>(buffer_size_);
-    *data = buffer_.get();
+    int alignment = direct_io_ ? kDirectIoAlignment : 1;
+    buffer_storage_ =
+        absl::make_unique<uint8_t[]>(buffer_size_ + alignment - 1);
+    auto address = reinterpret_cast<uintptr_t>(buffer_storage_.get());
+    buffer_ = buffer_storage_.get() +
+              (alignment - address % alignment) % alignment;
+    *data = buffer_;
     count_in_buffer_ = buffer_size_;
     position_ = buffer_size_;
     return buffer_size_;
@@ -85,7 +149,7 @@ crypto::tink::util::StatusOr<int> FileOutputStream::Next(void** data) {
     count_in_buffer_ = count_in_buffer_ + count_backedup_;
     int backedup = count_backedup_;
     count_backedup_ = 0;
-    *data = buffer_.get() + buffer_offset_;
+    *data = buffer_ + buffer_offset_;
     return backedup;
   }
 
@@ -94,7 +158,7 @@ crypto::tink::util::StatusOr<int> FileOutputStream::Next(void** data) {
   // The available space might not span the entire buffer_, as writing
   // may succeed only for a prefix of buffer_ -- in this case the data still
   // to be written is shifted in buffer_ and the remaining space is returned.
-  int write_result = write_ignoring_eintr(fd_, buffer_.get(), buffer_size_);
+  int write_result = Write(buffer_, buffer_size_);
   if (write_result <= 0) {  // No data written or an I/O error occurred.
     if (write_result == 0) {
       return 0;
@@ -108,11 +172,11 @@ crypto::tink::util::StatusOr<int> FileOutputStream::Next(void** data) {
   count_in_buffer_ = buffer_size_;
   count_backedup_ = 0;
   buffer_offset_ = buffer_size_ - write_result;
-  *data = buffer_.get() + buffer_offset_;
+  *data = buffer_ + buffer_offset_;
   if (write_result < buffer_size_) {
     // Only part of the data was written, shift the remaining data in buffer_.
     // Using memmove, as source and destination may overlap.
-    std::memmove(buffer_.get(), buffer_.get() + write_result, buffer_offset_);
+    std::memmove(buffer_, buffer_ + write_result, buffer_offset_);
   }
   return write_result;
 }
@@ -136,8 +200,8 @@ Status FileOutputStream::Close() {
     // Try to write the remaining bytes.
     int total_written = 0;
     while (total_written < count_in_buffer_) {
-      int write_result = write_ignoring_eintr(
-          fd_, buffer_.get() + total_written, count_in_buffer_ - total_written);
+      int write_result = Write(buffer_ + total_written,
+                               count_in_buffer_ - total_written);
       if (write_result < 0) {  // An I/O error occurred.
         status_ = ToStatusF(
             util::error::INTERNAL, "I/O error upon write: %d", errno);
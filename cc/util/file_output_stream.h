@@ -34,8 +34,20 @@ class FileOutputStream : public crypto::tink::OutputStream {
   // via 'file_descriptor', using a buffer of the specified size, if any
   // (if no legal 'buffer_size' is given, a reasonable default will be used).
   // Takes the ownership of the file, and will close it upon destruction.
+  // When this stream receives a streaming encryption, a 'buffer_size' equal
+  // to the ciphertext segment size lets each segment be written with one
+  // syscall.
   explicit FileOutputStream(int file_descriptor, int buffer_size = -1);
 
+  // Like the constructor above, but writes the file with direct I/O
+  // (O_DIRECT), bypassing the page cache. 'buffer_size' is rounded up
+  // to a multiple of the I/O alignment. Writes that cannot be done with
+  // direct I/O (e.g. the final, partially filled buffer) are done without
+  // it. Returns an error, without taking the ownership of the file,
+  // if direct I/O is not supported for the file.
+  static crypto::tink::util::StatusOr<std::unique_ptr<FileOutputStream>>
+  NewWithDirectIo(int file_descriptor, int buffer_size = -1);
+
   ~FileOutputStream() override;
 
   crypto::tink::util::StatusOr<int> Next(void** data) override;
@@ -47,10 +59,18 @@ class FileOutputStream : public crypto::tink::OutputStream {
   int64_t Position() const override;
 
  private:
+  FileOutputStream(int file_descriptor, int buffer_size, bool direct_io);
+
+  // Writes up to 'count' bytes from 'buf' to fd_, like write(2).
+  int Write(const uint8_t* buf, int count);
+
   util::Status status_;
   int fd_;
-  std::unique_ptr<uint8_t[]> buffer_;
+  bool direct_io_;
   const int buffer_size_;
+  // buffer_ points into buffer_storage_, aligned as needed for direct I/O.
+  std::unique_ptr<uint8_t[]> buffer_storage_;
+  uint8_t* buffer_;
   int64_t position_;     // current position in the file (from the beginning)
 
   // Counters that describe the state of the data in buffer_.
@@ -16,6 +16,8 @@
 
 #include "tink/util/file_output_stream.h"
 
+#include <unistd.h>
+
 #include "gtest/gtest.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
@@ -93,6 +95,32 @@ TEST_F(FileOutputStreamTest, CustomBufferSizes) {
 }
 
 
+TEST_F(FileOutputStreamTest, DirectIo) {
+  for (auto stream_size : {0, 10, 4096, 100000}) {
+    for (auto buffer_size : {1, 4096, 10000}) {
+      SCOPED_TRACE(absl::StrCat("stream_size = ", stream_size,
+                                ", buffer_size = ", buffer_size));
+      std::string stream_contents =
+          subtle::Random::GetRandomBytes(stream_size);
+      std::string filename = absl::StrCat(stream_size, "_", buffer_size,
+                                          "_direct_io_test.bin");
+      int output_fd = test::GetTestFileDescriptor(filename);
+      auto output_stream_result =
+          util::FileOutputStream::NewWithDirectIo(output_fd, buffer_size);
+      if (!output_stream_result.ok()) {
+        close(output_fd);
+        GTEST_SKIP() << "Direct I/O not supported: "
+                     << output_stream_result.status();
+      }
+      auto output_stream = std::move(output_stream_result.ValueOrDie());
+      auto status = WriteToStream(output_stream.get(), stream_contents);
+      EXPECT_TRUE(status.ok()) << status;
+      std::string file_contents = test::ReadTestFile(filename);
+      EXPECT_EQ(stream_contents, file_contents);
+    }
+  }
+}
+
 TEST_F(FileOutputStreamTest, BackupAndPosition) {
   int stream_size = 1024 * 1024;
   int buffer_size = 1234;
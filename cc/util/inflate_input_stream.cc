@@ -0,0 +1,148 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/util/inflate_input_stream.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "zlib.h"
+#include "tink/input_stream.h"
+#include "tink/util/buffer_pool.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+namespace {
+
+// The minimal size of the buffers returned by Next().
+constexpr int kMinBufferSize = 4 * 1024;
+
+}  // namespace
+
+InflateInputStream::InflateInputStream(
+    std::unique_ptr<crypto::tink::InputStream> source)
+    : source_(std::move(source)),
+      stream_(absl::make_unique<z_stream_s>()),
+      stream_end_(false),
+      buffer_pool_(BufferPool::Global()),
+      count_in_buffer_(0),
+      count_returned_(0),
+      count_backedup_(0),
+      position_(0) {
+  if (inflateInit(stream_.get()) != Z_OK) {
+    status_ = Status(util::error::INTERNAL,
+                     "Initialization of decompression failed.");
+  }
+}
+
+InflateInputStream::~InflateInputStream() {
+  inflateEnd(stream_.get());
+  buffer_pool_->Release(std::move(out_buffer_));
+}
+
+StatusOr<int> InflateInputStream::Inflate() {
+  if (stream_end_) return Status(util::error::OUT_OF_RANGE, "EOF");
+  while (true) {
+    if (stream_->avail_in == 0) {
+      // Decompresses directly from the next buffer of the source.
+      const void* buffer;
+      auto next_result = source_->Next(&buffer);
+      if (!next_result.ok()) {
+        if (next_result.status().error_code() == util::error::OUT_OF_RANGE) {
+          return Status(util::error::INVALID_ARGUMENT,
+                        "Compressed data is truncated.");
+        }
+        return next_result.status();
+      }
+      if (out_buffer_.empty()) {
+        out_buffer_ = buffer_pool_->Acquire(
+            std::max(next_result.ValueOrDie(), kMinBufferSize));
+      }
+      stream_->next_in =
+          static_cast<Bytef*>(const_cast<void*>(buffer));
+      stream_->avail_in = next_result.ValueOrDie();
+      continue;
+    }
+    stream_->next_out = out_buffer_.data();
+    stream_->avail_out = out_buffer_.size();
+    int ret = inflate(stream_.get(), Z_NO_FLUSH);
+    int count = out_buffer_.size() - stream_->avail_out;
+    if (ret == Z_STREAM_END) {
+      // Leaves the data following the compressed data in the source.
+      source_->BackUp(stream_->avail_in);
+      stream_->avail_in = 0;
+      stream_end_ = true;
+      if (count == 0) return Status(util::error::OUT_OF_RANGE, "EOF");
+      return count;
+    }
+    if (ret == Z_DATA_ERROR || ret == Z_NEED_DICT) {
+      return Status(util::error::INVALID_ARGUMENT,
+                    "Invalid compressed data.");
+    }
+    if (ret != Z_OK && ret != Z_BUF_ERROR) {
+      return Status(util::error::INTERNAL, "Decompression failed.");
+    }
+    if (count > 0) return count;
+  }
+}
+
+StatusOr<int> InflateInputStream::Next(const void** data) {
+  if (!status_.ok()) return status_;
+
+  // If some bytes were backed up, return them first.
+  if (count_backedup_ > 0) {
+    *data = out_buffer_.data() + count_in_buffer_ - count_backedup_;
+    count_returned_ = count_backedup_;
+    count_backedup_ = 0;
+    position_ += count_returned_;
+    return count_returned_;
+  }
+
+  auto inflate_result = Inflate();
+  if (!inflate_result.ok()) {
+    status_ = inflate_result.status();
+    count_in_buffer_ = 0;
+    count_returned_ = 0;
+    return status_;
+  }
+  *data = out_buffer_.data();
+  count_in_buffer_ = inflate_result.ValueOrDie();
+  count_returned_ = count_in_buffer_;
+  position_ += count_returned_;
+  return count_returned_;
+}
+
+void InflateInputStream::BackUp(int count) {
+  if (!status_.ok() || count < 1) return;
+  int actual_count = std::min(count, count_returned_ - count_backedup_);
+  count_backedup_ += actual_count;
+  position_ -= actual_count;
+}
+
+int64_t InflateInputStream::Position() const {
+  return position_;
+}
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
@@ -0,0 +1,80 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_UTIL_INFLATE_INPUT_STREAM_H_
+#define TINK_UTIL_INFLATE_INPUT_STREAM_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tink/input_stream.h"
+#include "tink/util/buffer_pool.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+struct z_stream_s;
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+// An InputStream that decompresses the data written by DeflateOutputStream,
+// which it reads from another InputStream, typically a decrypting stream of
+// a StreamingAead. The data is decompressed directly from the buffers
+// returned by the source's Next(), e.g. the plaintext segment of the
+// decrypting stream, so no copy is made between decryption and
+// decompression. The buffers returned by Next() have the size of the first
+// buffer of the source, and are taken from BufferPool::Global().
+//
+// Truncated or corrupted compressed data results in an INVALID_ARGUMENT
+// error. Data following the end of the compressed data is left in the
+// source.
+class InflateInputStream : public crypto::tink::InputStream {
+ public:
+  explicit InflateInputStream(
+      std::unique_ptr<crypto::tink::InputStream> source);
+
+  ~InflateInputStream() override;
+
+  crypto::tink::util::StatusOr<int> Next(const void** data) override;
+
+  void BackUp(int count) override;
+
+  // Returns the number of uncompressed bytes read so far.
+  int64_t Position() const override;
+
+ private:
+  // Decompresses the next data into out_buffer_, and returns its size.
+  crypto::tink::util::StatusOr<int> Inflate();
+
+  util::Status status_;
+  std::unique_ptr<crypto::tink::InputStream> source_;
+  std::unique_ptr<z_stream_s> stream_;
+  bool stream_end_;  // whether the end of the compressed data was reached
+  util::BufferPool* buffer_pool_;  // source of out_buffer_
+  std::vector<uint8_t> out_buffer_;  // uncompressed data
+  int count_in_buffer_;  // # bytes of data in out_buffer_
+  int count_returned_;  // # bytes returned by the last call to Next()
+  int count_backedup_;  // # bytes of those that were backed up
+  int64_t position_;
+};
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_UTIL_INFLATE_INPUT_STREAM_H_
@@ -0,0 +1,169 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/util/inflate_input_stream.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "zlib.h"
+#include "tink/input_stream.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/deflate_output_stream.h"
+#include "tink/util/istream_input_stream.h"
+#include "tink/util/ostream_output_stream.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+namespace {
+
+using ::crypto::tink::subtle::test::ReadFromStream;
+using ::crypto::tink::subtle::test::WriteToStream;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+// Compresses 'data' with zlib's compress().
+std::string Compress(const std::string& data) {
+  std::string compressed(compressBound(data.size()), '\0');
+  uLongf compressed_size = compressed.size();
+  EXPECT_EQ(compress(reinterpret_cast<Bytef*>(&compressed[0]),
+                     &compressed_size,
+                     reinterpret_cast<const Bytef*>(data.data()),
+                     data.size()),
+            Z_OK);
+  compressed.resize(compressed_size);
+  return compressed;
+}
+
+// A compressible string of 'size' bytes.
+std::string GetData(int size) {
+  std::string data;
+  while (data.size() < size) {
+    data += absl::StrCat("line ", data.size() % 1000, ": ",
+                         subtle::Random::GetRandomBytes(4), "\n");
+  }
+  data.resize(size);
+  return data;
+}
+
+std::unique_ptr<InflateInputStream> GetInflateStream(
+    const std::string& compressed, int buffer_size) {
+  return absl::make_unique<InflateInputStream>(
+      absl::make_unique<IstreamInputStream>(
+          absl::make_unique<std::stringstream>(compressed), buffer_size));
+}
+
+TEST(InflateInputStreamTest, Decompress) {
+  for (int size : {0, 1, 10, 100, 1000, 10000, 100000, 1000000}) {
+    for (int buffer_size : {1, 10, 1000, 100000}) {
+      SCOPED_TRACE(absl::StrCat("size = ", size,
+                                ", buffer_size = ", buffer_size));
+      std::string data = GetData(size);
+      auto input_stream = GetInflateStream(Compress(data), buffer_size);
+      std::string decompressed;
+      EXPECT_THAT(ReadFromStream(input_stream.get(), &decompressed), IsOk());
+      EXPECT_EQ(decompressed, data);
+      EXPECT_EQ(input_stream->Position(), size);
+    }
+  }
+}
+
+TEST(InflateInputStreamTest, RoundTripWithDeflateOutputStream) {
+  std::string data = GetData(300000);
+  auto ct_stream = absl::make_unique<std::stringstream>();
+  auto ct_buf = ct_stream->rdbuf();
+  DeflateOutputStream output_stream(
+      absl::make_unique<OstreamOutputStream>(std::move(ct_stream)));
+  EXPECT_THAT(WriteToStream(&output_stream, data), IsOk());
+  auto input_stream = GetInflateStream(ct_buf->str(), -1);
+  std::string decompressed;
+  EXPECT_THAT(ReadFromStream(input_stream.get(), &decompressed), IsOk());
+  EXPECT_EQ(decompressed, data);
+}
+
+TEST(InflateInputStreamTest, BackUpAndPosition) {
+  std::string data = GetData(100000);
+  auto input_stream = GetInflateStream(Compress(data), -1);
+  const void* buffer;
+  auto next_result = input_stream->Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  int size = next_result.ValueOrDie();
+  ASSERT_GT(size, 10);
+  EXPECT_EQ(input_stream->Position(), size);
+  input_stream->BackUp(size - 10);
+  EXPECT_EQ(input_stream->Position(), 10);
+
+  next_result = input_stream->Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  EXPECT_EQ(next_result.ValueOrDie(), size - 10);
+  EXPECT_EQ(std::string(static_cast<const char*>(buffer), size - 10),
+            data.substr(10, size - 10));
+  input_stream->BackUp(2 * size);  // cannot back up beyond the buffer
+  EXPECT_EQ(input_stream->Position(), 10);
+
+  std::string decompressed;
+  EXPECT_THAT(ReadFromStream(input_stream.get(), &decompressed), IsOk());
+  EXPECT_EQ(decompressed, data.substr(10));
+  EXPECT_EQ(input_stream->Position(), data.size());
+}
+
+TEST(InflateInputStreamTest, TruncatedData) {
+  std::string compressed = Compress(GetData(10000));
+  for (int size : {0, 1, 10, static_cast<int>(compressed.size()) - 1}) {
+    SCOPED_TRACE(absl::StrCat("size = ", size));
+    auto input_stream = GetInflateStream(compressed.substr(0, size), -1);
+    std::string decompressed;
+    EXPECT_THAT(ReadFromStream(input_stream.get(), &decompressed),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+}
+
+TEST(InflateInputStreamTest, CorruptedData) {
+  std::string compressed = Compress(GetData(10000));
+  compressed[compressed.size() / 2] ^= 1;
+  auto input_stream = GetInflateStream(compressed, -1);
+  std::string decompressed;
+  EXPECT_THAT(ReadFromStream(input_stream.get(), &decompressed),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(InflateInputStreamTest, TrailingDataIsLeftInSource) {
+  std::string data = GetData(10000);
+  auto source = absl::make_unique<IstreamInputStream>(
+      absl::make_unique<std::stringstream>(Compress(data) + "trailer"));
+  IstreamInputStream* source_ptr = source.get();
+  InflateInputStream input_stream(std::move(source));
+  std::string decompressed;
+  EXPECT_THAT(ReadFromStream(&input_stream, &decompressed), IsOk());
+  EXPECT_EQ(decompressed, data);
+  std::string trailer;
+  EXPECT_THAT(ReadFromStream(source_ptr, &trailer), IsOk());
+  EXPECT_EQ(trailer, "trailer");
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
@@ -17,9 +17,12 @@
 #include "tink/util/input_stream_util.h"
 
 #include <algorithm>
+#include <string>
+#include <utility>
 
 #include "absl/algorithm/container.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "tink/input_stream.h"
 #include "tink/util/statusor.h"
@@ -60,6 +63,25 @@ util::StatusOr<std::string> ReadBytesFromStream(int num_bytes,
   return ReadBytesFromStreamImpl<std::string>(num_bytes, input_stream);
 }
 
+util::StatusOr<absl::string_view> ReadBytesFromStreamView(
+    int num_bytes, InputStream* input_stream, std::string* storage) {
+  if (num_bytes <= 0) return absl::string_view();
+  const void* buffer;
+  auto next_result = input_stream->Next(&buffer);
+  if (!next_result.ok()) return next_result.status();
+  int num_bytes_in_chunk = next_result.ValueOrDie();
+  if (num_bytes_in_chunk >= num_bytes) {
+    input_stream->BackUp(num_bytes_in_chunk - num_bytes);
+    return absl::string_view(static_cast<const char*>(buffer), num_bytes);
+  }
+  input_stream->BackUp(num_bytes_in_chunk);
+  auto bytes_result =
+      ReadBytesFromStreamImpl<std::string>(num_bytes, input_stream);
+  if (!bytes_result.ok()) return bytes_result.status();
+  *storage = std::move(bytes_result.ValueOrDie());
+  return absl::string_view(*storage);
+}
+
 util::StatusOr<util::SecretData> ReadSecretBytesFromStream(
     int num_bytes, InputStream* input_stream) {
   return ReadBytesFromStreamImpl<util::SecretData>(num_bytes, input_stream);
@@ -19,6 +19,7 @@
 
 #include <string>
 
+#include "absl/strings/string_view.h"
 #include "tink/input_stream.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/statusor.h"
@@ -31,6 +32,16 @@ namespace tink {
 // propagated. This can loop indefinitely (in case Next() repeatedly returns 0).
 util::StatusOr<std::string> ReadBytesFromStream(int num_bytes,
                                                 InputStream* input_stream);
+
+// Like ReadBytesFromStream(), but does not copy the bytes if they are
+// contiguous in the next buffer of 'input_stream': returns a view of them in
+// that buffer, which is valid until the next call of Next() on the stream.
+// The rest of the buffer is backed up, so the stream must keep its buffer
+// valid across BackUp(), as the InputStreams of Tink do. Otherwise, the bytes
+// are copied to '*storage' and the returned view refers to it.
+util::StatusOr<absl::string_view> ReadBytesFromStreamView(
+    int num_bytes, InputStream* input_stream, std::string* storage);
+
 // A SecretData variant of ReadBytesFromStream
 util::StatusOr<util::SecretData> ReadSecretBytesFromStream(
     int num_bytes, InputStream* input_stream);
@@ -119,6 +119,41 @@ TEST(ReadBytesTest, EmptyInput) {
   EXPECT_THAT(text_or.status(), StatusIs(util::error::OUT_OF_RANGE));
 }
 
+TEST(ReadBytesViewTest, ReadFromBuffer) {
+  const std::string content = "0123456789abcdefghijklmnop";
+  IstreamInputStream input_stream{absl::make_unique<std::stringstream>(content)};
+  std::string storage;
+  auto view_or = ReadBytesFromStreamView(7, &input_stream, &storage);
+  ASSERT_THAT(view_or.status(), IsOk());
+  EXPECT_THAT(view_or.ValueOrDie(), Eq("0123456"));
+  EXPECT_THAT(storage, Eq(""));  // not copied
+
+  view_or = ReadBytesFromStreamView(5, &input_stream, &storage);
+  ASSERT_THAT(view_or.status(), IsOk());
+  EXPECT_THAT(view_or.ValueOrDie(), Eq("789ab"));
+  EXPECT_THAT(storage, Eq(""));
+  EXPECT_EQ(input_stream.Position(), 12);
+}
+
+TEST(ReadBytesViewTest, ReadAcrossBuffers) {
+  IstreamInputStream input_stream{
+      absl::make_unique<std::stringstream>("0123456789abcdefghijklmnop"), 4};
+  std::string storage;
+  auto view_or = ReadBytesFromStreamView(11, &input_stream, &storage);
+  ASSERT_THAT(view_or.status(), IsOk());
+  EXPECT_THAT(view_or.ValueOrDie(), Eq("0123456789a"));
+  EXPECT_THAT(storage, Eq("0123456789a"));
+
+  view_or = ReadBytesFromStreamView(1, &input_stream, &storage);
+  ASSERT_THAT(view_or.status(), IsOk());
+  EXPECT_THAT(view_or.ValueOrDie(), Eq("b"));
+  view_or = ReadBytesFromStreamView(0, &input_stream, &storage);
+  ASSERT_THAT(view_or.status(), IsOk());
+  EXPECT_THAT(view_or.ValueOrDie(), Eq(""));
+  view_or = ReadBytesFromStreamView(100, &input_stream, &storage);
+  EXPECT_THAT(view_or.status(), StatusIs(util::error::OUT_OF_RANGE));
+}
+
 TEST(ReadSecretBytesTest, ReadExact) {
   const std::string content = "Some content";
   IstreamInputStream input_stream{
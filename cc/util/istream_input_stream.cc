@@ -19,7 +19,9 @@
 #include <unistd.h>
 #include <algorithm>
 #include <cstring>
+#include <ios>
 #include <istream>
+#include <streambuf>
 
 #include "absl/memory/memory.h"
 #include "tink/input_stream.h"
@@ -31,9 +33,11 @@ namespace crypto {
 namespace tink {
 namespace util {
 
+constexpr int IstreamInputStream::kDefaultBufferSize;
+
 IstreamInputStream::IstreamInputStream(std::unique_ptr<std::istream> input,
                                        int buffer_size) :
-    buffer_size_(buffer_size > 0 ? buffer_size : 128 * 1024) {  // 128 KB
+    buffer_size_(buffer_size > 0 ? buffer_size : kDefaultBufferSize) {
   input_ = std::move(input);
   count_in_buffer_ = 0;
   count_backedup_ = 0;
@@ -53,18 +57,19 @@ crypto::tink::util::StatusOr<int> IstreamInputStream::Next(const void** data) {
     position_ = position_ + count_in_buffer_;
     return count_in_buffer_;
   }
-  // Read new bytes to buffer_.
-  input_->read(reinterpret_cast<char*>(buffer_.get()), buffer_size_);
-  int count_read = input_->gcount();
-  if (count_read == 0) {  // Could not read bytes, EOF or an I/O error.
-    if (input_->good()) return count_read;  // No bytes could be read.
-    // If !good(), distinguish EOF from other failures.
-    if (input_->eof()) {
-      status_ = Status(util::error::OUT_OF_RANGE, "EOF");
-    } else {
-      status_ =
-          ToStatusF(util::error::INTERNAL, "I/O error: %s", strerror(errno));
-    }
+  // Read new bytes to buffer_. Reading from the streambuf directly skips the
+  // sentry that std::istream::read() constructs on every call.
+  std::streambuf* input_buffer = input_->rdbuf();
+  if (input_buffer == nullptr || (input_->fail() && !input_->eof())) {
+    status_ =
+        ToStatusF(util::error::INTERNAL, "I/O error: %s", strerror(errno));
+    return status_;
+  }
+  int count_read =
+      input_buffer->sgetn(reinterpret_cast<char*>(buffer_.get()), buffer_size_);
+  if (count_read <= 0) {  // Could not read bytes, EOF or an I/O error.
+    input_->setstate(std::ios_base::eofbit);
+    status_ = Status(util::error::OUT_OF_RANGE, "EOF");
     return status_;
   }
   buffer_offset_ = 0;
@@ -28,12 +28,17 @@ namespace crypto {
 namespace tink {
 namespace util {
 
-// An InputStream that reads from a std::istream.
+// An InputStream that reads from a std::istream. It reads from the
+// istream's streambuf directly, in chunks of the size of its buffer; larger
+// buffers mean fewer calls to the streambuf.
 class IstreamInputStream : public crypto::tink::InputStream {
  public:
+  // The size of the buffer if none is given to the constructor.
+  static constexpr int kDefaultBufferSize = 128 * 1024;  // 128 KB
+
   // Constructs an InputStream that will read from the 'input' istream,
   // using a buffer of the specified size, if any (if no legal 'buffer_size'
-  // is given, a reasonable default will be used).
+  // is given, kDefaultBufferSize is used).
   explicit IstreamInputStream(std::unique_ptr<std::istream> input,
                               int buffer_size = -1);
 
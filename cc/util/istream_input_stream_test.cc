@@ -186,6 +186,16 @@ TEST_F(IstreamInputStreamTest, testBackupAndPosition) {
             std::string(static_cast<const char*>(buffer), buffer_size));
 }
 
+TEST_F(IstreamInputStreamTest, testUnopenedFile) {
+  auto input = absl::make_unique<std::ifstream>(
+      absl::StrCat(crypto::tink::test::TmpDir(), "/no_such_dir/file.bin"),
+      std::ofstream::binary);
+  util::IstreamInputStream input_stream(std::move(input));
+  const void* buffer;
+  auto next_result = input_stream.Next(&buffer);
+  EXPECT_EQ(util::error::INTERNAL, next_result.status().error_code());
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
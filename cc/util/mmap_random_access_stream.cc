@@ -0,0 +1,142 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/util/mmap_random_access_stream.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "tink/random_access_stream.h"
+#include "tink/util/buffer.h"
+#include "tink/util/errors.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+using crypto::tink::util::Status;
+using crypto::tink::util::StatusOr;
+
+namespace {
+
+// Attempts to close file descriptor fd, while ignoring EINTR.
+// (code borrowed from ZeroCopy-streams)
+int close_ignoring_eintr(int fd) {
+  int result;
+  do {
+    result = close(fd);
+  } while (result < 0 && errno == EINTR);
+  return result;
+}
+
+int ToMadvise(MmapRandomAccessStream::AccessPattern access_pattern) {
+  switch (access_pattern) {
+    case MmapRandomAccessStream::AccessPattern::kSequential:
+      return MADV_SEQUENTIAL;
+    case MmapRandomAccessStream::AccessPattern::kRandom:
+      return MADV_RANDOM;
+    default:
+      return MADV_NORMAL;
+  }
+}
+
+}  // anonymous namespace
+
+// static
+StatusOr<std::unique_ptr<MmapRandomAccessStream>> MmapRandomAccessStream::New(
+    int file_descriptor, AccessPattern access_pattern) {
+  struct stat s;
+  if (fstat(file_descriptor, &s) == -1) {
+    int error = errno;
+    close_ignoring_eintr(file_descriptor);
+    return ToStatusF(util::error::UNAVAILABLE, "fstat failed: %d", error);
+  }
+  if (s.st_size == 0) {
+    close_ignoring_eintr(file_descriptor);
+    return {absl::WrapUnique(new MmapRandomAccessStream(nullptr, 0))};
+  }
+  void* data = mmap(nullptr, s.st_size, PROT_READ, MAP_SHARED,
+                    file_descriptor, 0);
+  int error = errno;
+  // The mapping stays valid after the file is closed.
+  close_ignoring_eintr(file_descriptor);
+  if (data == MAP_FAILED) {
+    return ToStatusF(util::error::UNKNOWN, "mmap failed: %d", error);
+  }
+  // madvise() is only a hint, so failures are ignored.
+  madvise(data, s.st_size, ToMadvise(access_pattern));
+  return {absl::WrapUnique(
+      new MmapRandomAccessStream(static_cast<const char*>(data), s.st_size))};
+}
+
+MmapRandomAccessStream::~MmapRandomAccessStream() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+StatusOr<absl::string_view> MmapRandomAccessStream::View(int64_t position,
+                                                         int count) const {
+  if (count <= 0) {
+    return Status(util::error::INVALID_ARGUMENT, "count must be positive");
+  }
+  if (position < 0) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "position cannot be negative");
+  }
+  if (position >= size_) {
+    return Status(util::error::OUT_OF_RANGE, "EOF");
+  }
+  return absl::string_view(data_ + position,
+                           std::min<int64_t>(count, size_ - position));
+}
+
+Status MmapRandomAccessStream::PRead(int64_t position, int count,
+                                     Buffer* dest_buffer) {
+  if (dest_buffer == nullptr) {
+    return Status(util::error::INVALID_ARGUMENT,
+                  "dest_buffer must be non-null");
+  }
+  if (count > dest_buffer->allocated_size()) {
+    return Status(util::error::INVALID_ARGUMENT, "buffer too small");
+  }
+  auto view_result = View(position, count);
+  if (!view_result.ok()) {
+    dest_buffer->set_size(0).IgnoreError();
+    return view_result.status();
+  }
+  absl::string_view view = view_result.ValueOrDie();
+  auto status = dest_buffer->set_size(view.size());
+  if (!status.ok()) return status;
+  std::memcpy(dest_buffer->get_mem_block(), view.data(), view.size());
+  return Status::OK;
+}
+
+StatusOr<int64_t> MmapRandomAccessStream::size() { return size_; }
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
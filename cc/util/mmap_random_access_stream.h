@@ -0,0 +1,82 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_UTIL_MMAP_RANDOM_ACCESS_STREAM_H_
+#define TINK_UTIL_MMAP_RANDOM_ACCESS_STREAM_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "absl/strings/string_view.h"
+#include "tink/random_access_stream.h"
+#include "tink/util/buffer.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+// A RandomAccessStream that reads from a memory-mapped file. PRead() copies
+// from the mapping without a system call, and View() gives callers that can
+// work on the mapped bytes directly access without any copy.
+//
+// The size of the stream is fixed when it is created, so the file must not
+// be truncated or extended while the stream exists.
+// Instances of this class are thread safe.
+class MmapRandomAccessStream : public crypto::tink::RandomAccessStream {
+ public:
+  // Hints about the expected access pattern, passed to madvise().
+  enum class AccessPattern {
+    kNormal,
+    kSequential,
+    kRandom,
+  };
+
+  // Maps the file specified via 'file_descriptor' into memory.
+  // Takes the ownership of the file, which is closed once it is mapped.
+  static crypto::tink::util::StatusOr<std::unique_ptr<MmapRandomAccessStream>>
+  New(int file_descriptor, AccessPattern access_pattern);
+
+  ~MmapRandomAccessStream() override;
+
+  crypto::tink::util::Status PRead(int64_t position,
+                                   int count,
+                                   Buffer* dest_buffer) override;
+
+  crypto::tink::util::StatusOr<int64_t> size() override;
+
+  // Returns a view of the up to 'count' bytes starting at 'position'. The
+  // view is shorter than 'count' if the stream ends before, and stays valid
+  // until this stream is destroyed. Returns OUT_OF_RANGE if 'position' is
+  // not smaller than size().
+  crypto::tink::util::StatusOr<absl::string_view> View(int64_t position,
+                                                       int count) const;
+
+ private:
+  MmapRandomAccessStream(const char* data, int64_t size)
+      : data_(data), size_(size) {}
+
+  const char* const data_;  // nullptr for empty files, which cannot be mapped
+  const int64_t size_;
+};
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_UTIL_MMAP_RANDOM_ACCESS_STREAM_H_
@@ -0,0 +1,159 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/util/mmap_random_access_stream.h"
+
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tink/util/buffer.h"
+#include "tink/util/test_matchers.h"
+#include "tink/util/test_util.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+using AccessPattern = MmapRandomAccessStream::AccessPattern;
+
+std::unique_ptr<MmapRandomAccessStream> GetMmapStream(
+    int stream_size, std::string* file_contents,
+    AccessPattern access_pattern = AccessPattern::kNormal) {
+  std::string filename = absl::StrCat(stream_size, "_mmap_reading_test.bin");
+  int input_fd =
+      test::GetTestFileDescriptor(filename, stream_size, file_contents);
+  auto result = MmapRandomAccessStream::New(input_fd, access_pattern);
+  EXPECT_THAT(result.status(), IsOk());
+  return std::move(result.ValueOrDie());
+}
+
+TEST(MmapRandomAccessStreamTest, ReadingStreams) {
+  for (auto access_pattern : {AccessPattern::kNormal,
+                              AccessPattern::kSequential,
+                              AccessPattern::kRandom}) {
+    for (auto stream_size : {1, 10, 100, 1000, 10000, 1000000}) {
+      SCOPED_TRACE(absl::StrCat("stream_size = ", stream_size));
+      std::string file_contents;
+      auto ra_stream = GetMmapStream(stream_size, &file_contents,
+                                     access_pattern);
+      EXPECT_EQ(stream_size, ra_stream->size().ValueOrDie());
+      int chunk_size = 1 + (stream_size / 10);
+      auto buffer = std::move(Buffer::New(chunk_size).ValueOrDie());
+      std::string stream_contents;
+      auto status = ra_stream->PRead(0, chunk_size, buffer.get());
+      while (status.ok()) {
+        stream_contents.append(buffer->get_mem_block(), buffer->size());
+        status = ra_stream->PRead(stream_contents.size(), chunk_size,
+                                  buffer.get());
+      }
+      EXPECT_THAT(status, StatusIs(util::error::OUT_OF_RANGE));
+      EXPECT_EQ(0, buffer->size());
+      EXPECT_EQ(file_contents, stream_contents);
+    }
+  }
+}
+
+TEST(MmapRandomAccessStreamTest, View) {
+  int stream_size = 1000;
+  std::string file_contents;
+  auto ra_stream = GetMmapStream(stream_size, &file_contents);
+  for (int position : {0, 1, 500, 999}) {
+    for (int count : {1, 10, 1000}) {
+      SCOPED_TRACE(absl::StrCat("position = ", position, ", count = ", count));
+      auto view_result = ra_stream->View(position, count);
+      ASSERT_THAT(view_result.status(), IsOk());
+      EXPECT_EQ(absl::string_view(file_contents).substr(position, count),
+                view_result.ValueOrDie());
+    }
+  }
+  // Views into the mapping stay valid, and are not copies.
+  EXPECT_EQ(ra_stream->View(10, 20).ValueOrDie().data(),
+            ra_stream->View(0, 30).ValueOrDie().data() + 10);
+  EXPECT_THAT(ra_stream->View(stream_size, 1).status(),
+              StatusIs(util::error::OUT_OF_RANGE));
+  EXPECT_THAT(ra_stream->View(-1, 1).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+  EXPECT_THAT(ra_stream->View(0, 0).status(),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(MmapRandomAccessStreamTest, EmptyFile) {
+  std::string file_contents;
+  auto ra_stream = GetMmapStream(0, &file_contents);
+  EXPECT_EQ(0, ra_stream->size().ValueOrDie());
+  auto buffer = std::move(Buffer::New(42).ValueOrDie());
+  EXPECT_THAT(ra_stream->PRead(0, 42, buffer.get()),
+              StatusIs(util::error::OUT_OF_RANGE));
+  EXPECT_EQ(0, buffer->size());
+}
+
+TEST(MmapRandomAccessStreamTest, ConcurrentReads) {
+  int stream_size = 100000;
+  std::string file_contents;
+  auto ra_stream = GetMmapStream(stream_size, &file_contents);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) {
+    readers.emplace_back([&, i]() {
+      int64_t position = i * stream_size / 4;
+      int count = stream_size / 2;
+      auto buffer = std::move(Buffer::New(count).ValueOrDie());
+      EXPECT_THAT(ra_stream->PRead(position, count, buffer.get()), IsOk());
+      EXPECT_EQ(file_contents.substr(position, count),
+                std::string(buffer->get_mem_block(), buffer->size()));
+    });
+  }
+  for (auto& reader : readers) reader.join();
+}
+
+TEST(MmapRandomAccessStreamTest, InvalidReads) {
+  std::string file_contents;
+  auto ra_stream = GetMmapStream(100, &file_contents);
+  auto buffer = std::move(Buffer::New(42).ValueOrDie());
+  for (auto position : {-100, -1}) {
+    EXPECT_THAT(ra_stream->PRead(position, 42, buffer.get()),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+  for (auto count : {-1, 0, 43}) {
+    EXPECT_THAT(ra_stream->PRead(0, count, buffer.get()),
+                StatusIs(util::error::INVALID_ARGUMENT));
+  }
+  for (auto position : {101, 110}) {
+    EXPECT_THAT(ra_stream->PRead(position, 42, buffer.get()),
+                StatusIs(util::error::OUT_OF_RANGE));
+    EXPECT_EQ(0, buffer->size());
+  }
+  EXPECT_THAT(ra_stream->PRead(0, 42, nullptr),
+              StatusIs(util::error::INVALID_ARGUMENT));
+}
+
+TEST(MmapRandomAccessStreamTest, InvalidFileDescriptor) {
+  EXPECT_THAT(MmapRandomAccessStream::New(-1, AccessPattern::kNormal).status(),
+              StatusIs(util::error::UNAVAILABLE));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
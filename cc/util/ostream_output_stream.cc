@@ -19,6 +19,7 @@
 #include <algorithm>
 #include <cerrno>
 #include <cstring>
+#include <ios>
 #include <memory>
 #include <ostream>
 
@@ -32,9 +33,11 @@ namespace crypto {
 namespace tink {
 namespace util {
 
+constexpr int OstreamOutputStream::kDefaultBufferSize;
+
 OstreamOutputStream::OstreamOutputStream(std::unique_ptr<std::ostream> output,
                                          int buffer_size) :
-    buffer_size_(buffer_size > 0 ? buffer_size : 128 * 1024) {  // 128 KB
+    buffer_size_(buffer_size > 0 ? buffer_size : kDefaultBufferSize) {
   output_ = std::move(output);
   count_in_buffer_ = 0;
   count_backedup_ = 0;
@@ -110,8 +113,10 @@ Status OstreamOutputStream::Close() {
   if (!status_.ok()) return status_;
   if (count_in_buffer_ > 0) {
     // Try to write the remaining bytes.
-    output_->write(reinterpret_cast<char*>(buffer_.get()), count_in_buffer_);
-    if (!output_->good()) {  // An I/O error occurred.
+    int write_result = output_->rdbuf()->sputn(
+        reinterpret_cast<char*>(buffer_.get()), count_in_buffer_);
+    if (write_result != count_in_buffer_) {  // An I/O error occurred.
+      output_->setstate(std::ios_base::badbit);
       status_ = ToStatusF(
           util::error::INTERNAL, "I/O error upon write: %d", errno);
       return status_;
@@ -28,12 +28,17 @@ namespace crypto {
 namespace tink {
 namespace util {
 
-// An OutputStream that writes to an ostream.
+// An OutputStream that writes to an ostream. It writes to the ostream's
+// streambuf directly, in chunks of the size of its buffer; larger buffers
+// mean fewer calls to the streambuf.
 class OstreamOutputStream : public crypto::tink::OutputStream {
  public:
+  // The size of the buffer if none is given to the constructor.
+  static constexpr int kDefaultBufferSize = 128 * 1024;  // 128 KB
+
   // Constructs an OutputStream that will write to the ostream specified
   // via 'output', using a buffer of the specified size, if any
-  // (if no legal 'buffer_size' is given, a reasonable default will be used).
+  // (if no legal 'buffer_size' is given, kDefaultBufferSize is used).
   explicit OstreamOutputStream(std::unique_ptr<std::ostream> output,
                                int buffer_size = -1);
 
@@ -0,0 +1,97 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_UTIL_OUTPUT_BUFFER_FACTORY_H_
+#define TINK_UTIL_OUTPUT_BUFFER_FACTORY_H_
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+// Allocates the buffers the ...ToBuffer() methods of the primitives write
+// their results to, so that callers decide where the results live, e.g. in
+// an arena that is freed at the end of a request. Called with the number of
+// bytes needed, and returns a buffer of at least that size which stays valid
+// for as long as the caller uses the result, or a smaller buffer (such as an
+// empty one) if it cannot allocate. A primitive may ask for more bytes than
+// its result takes, but calls the factory at most once per result, and writes
+// the result to the start of the buffer.
+using OutputBufferFactory = std::function<absl::Span<char>(int64_t size)>;
+
+namespace internal {
+
+// Returns a buffer of 'size' bytes from 'new_buffer', or RESOURCE_EXHAUSTED
+// if it returned a smaller one.
+inline StatusOr<absl::Span<char>> NewOutputBuffer(
+    const OutputBufferFactory& new_buffer, int64_t size) {
+  absl::Span<char> buffer = new_buffer(size);
+  if (static_cast<int64_t>(buffer.size()) < size) {
+    return Status(error::RESOURCE_EXHAUSTED,
+                  "could not allocate the output buffer");
+  }
+  return buffer.subspan(0, size);
+}
+
+// Returns a copy of 'data' in a buffer from 'new_buffer'. Used by the
+// default implementations of the ...ToBuffer() methods.
+inline StatusOr<absl::Span<char>> CopyToNewBuffer(
+    absl::string_view data, const OutputBufferFactory& new_buffer) {
+  auto buffer_result = NewOutputBuffer(new_buffer, data.size());
+  if (!buffer_result.ok()) return buffer_result.status();
+  absl::Span<char> buffer = buffer_result.ValueOrDie();
+  if (!data.empty()) std::memcpy(buffer.data(), data.data(), data.size());
+  return buffer;
+}
+
+// Calls 'write' with a factory whose buffers are taken from 'new_buffer'
+// with 'prefix' written in front of them, and returns the prefixed result.
+// Used by the wrappers to place the output prefix of a key in front of the
+// result of its primitive without copying that result.
+template <typename Write>
+StatusOr<absl::Span<char>> WriteToBufferWithPrefix(
+    absl::string_view prefix, const OutputBufferFactory& new_buffer,
+    Write write) {
+  absl::Span<char> buffer;
+  OutputBufferFactory new_prefixed_buffer =
+      [prefix, &new_buffer, &buffer](int64_t size) -> absl::Span<char> {
+        buffer = new_buffer(size + prefix.size());
+        if (buffer.size() < prefix.size()) return absl::Span<char>();
+        if (!prefix.empty()) {
+          std::memcpy(buffer.data(), prefix.data(), prefix.size());
+        }
+        return buffer.subspan(prefix.size());
+      };
+  StatusOr<absl::Span<char>> result = write(new_prefixed_buffer);
+  if (!result.ok()) return result.status();
+  return buffer.subspan(0, prefix.size() + result.ValueOrDie().size());
+}
+
+}  // namespace internal
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_UTIL_OUTPUT_BUFFER_FACTORY_H_
@@ -0,0 +1,121 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "tink/util/output_buffer_factory.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "absl/types/span.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+namespace {
+
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+// Hands out buffers from a fixed region, like an arena of a request.
+class FakeArena {
+ public:
+  explicit FakeArena(int64_t capacity) : memory_(capacity, 'x') {}
+
+  OutputBufferFactory factory() {
+    return [this](int64_t size) -> absl::Span<char> {
+      requested_.push_back(size);
+      if (used_ + size > static_cast<int64_t>(memory_.size())) {
+        return absl::Span<char>();
+      }
+      absl::Span<char> buffer(&memory_[used_], size);
+      used_ += size;
+      return buffer;
+    };
+  }
+
+  const std::vector<int64_t>& requested() const { return requested_; }
+  const char* data() const { return memory_.data(); }
+
+ private:
+  std::string memory_;
+  int64_t used_ = 0;
+  std::vector<int64_t> requested_;
+};
+
+std::string ToString(absl::Span<const char> span) {
+  return std::string(span.data(), span.size());
+}
+
+TEST(OutputBufferFactoryTest, CopyToNewBuffer) {
+  FakeArena arena(16);
+  auto result = internal::CopyToNewBuffer("some data", arena.factory());
+  ASSERT_THAT(result.status(), IsOk());
+  EXPECT_EQ("some data", ToString(result.ValueOrDie()));
+  EXPECT_EQ(arena.data(), result.ValueOrDie().data());
+
+  auto empty_result = internal::CopyToNewBuffer("", arena.factory());
+  ASSERT_THAT(empty_result.status(), IsOk());
+  EXPECT_TRUE(empty_result.ValueOrDie().empty());
+
+  EXPECT_THAT(internal::CopyToNewBuffer("more than the rest", arena.factory())
+                  .status(),
+              StatusIs(error::RESOURCE_EXHAUSTED));
+}
+
+TEST(OutputBufferFactoryTest, WriteToBufferWithPrefix) {
+  FakeArena arena(32);
+  auto result = internal::WriteToBufferWithPrefix(
+      "prefix", arena.factory(), [](const OutputBufferFactory& new_buffer) {
+        // Asks for more than it writes, like a decryption.
+        auto buffer_result = internal::NewOutputBuffer(new_buffer, 10);
+        if (!buffer_result.ok()) return buffer_result;
+        std::memcpy(buffer_result.ValueOrDie().data(), "data", 4);
+        return StatusOr<absl::Span<char>>(
+            buffer_result.ValueOrDie().subspan(0, 4));
+      });
+  ASSERT_THAT(result.status(), IsOk());
+  EXPECT_EQ("prefixdata", ToString(result.ValueOrDie()));
+  EXPECT_EQ(arena.data(), result.ValueOrDie().data());
+  EXPECT_EQ(std::vector<int64_t>({16}), arena.requested());
+}
+
+TEST(OutputBufferFactoryTest, WriteToBufferWithPrefixFails) {
+  FakeArena arena(8);
+  auto write = [](const OutputBufferFactory& new_buffer) {
+    return internal::CopyToNewBuffer("data", new_buffer);
+  };
+  EXPECT_THAT(
+      internal::WriteToBufferWithPrefix("prefix", arena.factory(), write)
+          .status(),
+      StatusIs(error::RESOURCE_EXHAUSTED));
+  EXPECT_THAT(internal::WriteToBufferWithPrefix(
+                  "prefix", arena.factory(),
+                  [](const OutputBufferFactory& new_buffer) {
+                    return StatusOr<absl::Span<char>>(
+                        Status(error::INVALID_ARGUMENT, "failed"));
+                  })
+                  .status(),
+              StatusIs(error::INVALID_ARGUMENT));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
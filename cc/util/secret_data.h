@@ -88,6 +88,8 @@ class SecretUniquePtr {
  private:
   template <typename S, typename... Args>
   friend SecretUniquePtr<S> MakeSecretUniquePtr(Args&&... args);
+  template <typename S, typename... Args>
+  friend SecretUniquePtr<S> MakeKeyStateUniquePtr(Args&&... args);
   explicit SecretUniquePtr(Value&& value) : value_(std::move(value)) {}
   Value value_;
 };
@@ -100,6 +102,22 @@ SecretUniquePtr<T> MakeSecretUniquePtr(Args&&... args) {
   return SecretUniquePtr<T>({ptr, internal::SanitizingDeleter<T>()});
 }
 
+// Same as MakeSecretUniquePtr(), for key state: state which is computed once
+// when a key is set up and then only read, such as an AES key schedule. It is
+// placed in cache-line aligned blocks of the SecureArena which hold nothing
+// else (see SecureArena::AllocateKeyState()).
+template <typename T, typename... Args>
+SecretUniquePtr<T> MakeKeyStateUniquePtr(Args&&... args) {
+  T* ptr = nullptr;
+  if (alignof(T) <= internal::SecureArena::kCacheLineSize) {
+    ptr = static_cast<T*>(internal::SecureArena::AllocateKeyState(sizeof(T)));
+  }
+  if (ptr == nullptr) ptr = internal::SanitizingAllocator<T>().allocate(1);
+  new (ptr)
+      T(std::forward<Args>(args)...);  // Invoke constructor "placement new"
+  return SecretUniquePtr<T>({ptr, internal::SanitizingDeleter<T>()});
+}
+
 // Convenience conversion functions
 inline absl::string_view SecretDataAsStringView(const SecretData& secret) {
   return {reinterpret_cast<const char*>(secret.data()), secret.size()};
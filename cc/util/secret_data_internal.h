@@ -21,6 +21,7 @@
 #include <memory>
 
 #include "absl/base/attributes.h"
+#include "tink/util/secure_arena.h"
 
 namespace crypto {
 namespace tink {
@@ -35,6 +36,8 @@ inline void SafeZeroMemory(char* ptr, std::size_t size) {
   }
 }
 
+// Small allocations are served by the SecureArena, which keeps them out of
+// swap and away from the general heap; larger ones use std::allocator.
 template <typename T>
 struct SanitizingAllocator {
   typedef T value_type;
@@ -45,11 +48,20 @@ struct SanitizingAllocator {
       const SanitizingAllocator<U>&) noexcept {}
 
   ABSL_MUST_USE_RESULT T* allocate(std::size_t n) {
+    if (alignof(T) <= SecureArena::kMinAlignment &&
+        n <= SecureArena::kMaxBlockSize / sizeof(T)) {
+      void* ptr = SecureArena::Allocate(n * sizeof(T));
+      if (ptr != nullptr) return static_cast<T*>(ptr);
+    }
     return std::allocator<T>().allocate(n);
   }
 
   void deallocate(T* ptr, std::size_t n) noexcept {
     SafeZeroMemory(reinterpret_cast<char*>(ptr), n * sizeof(T));
+    if (SecureArena::Contains(ptr)) {
+      SecureArena::Deallocate(ptr, n * sizeof(T));
+      return;
+    }
     std::allocator<T>().deallocate(ptr, n);
   }
 
@@ -68,10 +80,18 @@ struct SanitizingAllocator<void> {
   explicit constexpr SanitizingAllocator(
       const SanitizingAllocator<U>&) noexcept {}
 
-  ABSL_MUST_USE_RESULT void* allocate(std::size_t n) { return std::malloc(n); }
+  ABSL_MUST_USE_RESULT void* allocate(std::size_t n) {
+    void* ptr = SecureArena::Allocate(n);
+    if (ptr != nullptr) return ptr;
+    return std::malloc(n);
+  }
 
   void deallocate(void* ptr, std::size_t n) noexcept {
     SafeZeroMemory(reinterpret_cast<char*>(ptr), n);
+    if (SecureArena::Contains(ptr)) {
+      SecureArena::Deallocate(ptr, n);
+      return;
+    }
     std::free(ptr);
   }
 
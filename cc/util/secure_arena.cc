@@ -0,0 +1,391 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/util/secure_arena.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+namespace internal {
+
+constexpr std::size_t SecureArena::kMaxBlockSize;
+constexpr std::size_t SecureArena::kMinAlignment;
+constexpr std::size_t SecureArena::kCacheLineSize;
+
+namespace {
+
+constexpr std::size_t kMinBlockSize = SecureArena::kMinAlignment;
+constexpr int kNumSizeClasses = 8;  // 16, 32, ..., 2048 bytes.
+constexpr std::size_t kSlabSize = 64 * 1024;
+// Address space reserved for the arena. Only the slabs in use are backed by
+// memory.
+constexpr std::size_t kReservedSize = 64 * 1024 * 1024;
+// A thread returns half of its cached blocks of a size class to the arena
+// once it caches this many.
+constexpr int kMaxThreadCacheBlocks = 64;
+// Number of blocks a thread takes from the arena at once.
+constexpr int kThreadCacheRefill = 16;
+
+static_assert((kMinBlockSize << (kNumSizeClasses - 1)) ==
+                  SecureArena::kMaxBlockSize,
+              "size classes must end at kMaxBlockSize");
+
+constexpr int kNumKeyStateSizeClasses = 6;  // 64, 128, ..., 2048 bytes.
+constexpr std::size_t kKeyStateSlabSize = 64 * 1024;
+constexpr std::size_t kHugePageSize = 2 * 1024 * 1024;
+constexpr std::size_t kKeyStateReservedSize = 256 * 1024 * 1024;
+
+static_assert((SecureArena::kCacheLineSize << (kNumKeyStateSizeClasses - 1)) ==
+                  SecureArena::kMaxBlockSize,
+              "key state size classes must end at kMaxBlockSize");
+
+std::atomic<bool> key_state_huge_pages(false);
+static_assert(kMinBlockSize >= alignof(std::max_align_t),
+              "blocks must be suitably aligned for any type");
+
+// A block on a free list.
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+int SizeClass(std::size_t size) {
+  int size_class = 0;
+  for (std::size_t block_size = kMinBlockSize; block_size < size;
+       block_size <<= 1) {
+    size_class++;
+  }
+  return size_class;
+}
+
+int KeyStateSizeClass(std::size_t size) {
+  int size_class = 0;
+  for (std::size_t block_size = SecureArena::kCacheLineSize; block_size < size;
+       block_size <<= 1) {
+    size_class++;
+  }
+  return size_class;
+}
+
+class Arena {
+ public:
+  static Arena* Get() {
+    // Never destroyed: blocks may be released during static destruction.
+    static Arena* arena = new Arena();
+    return arena;
+  }
+
+  bool Contains(const void* ptr) const {
+    auto address = reinterpret_cast<std::uintptr_t>(ptr);
+    return address >= begin_ && address < end_;
+  }
+
+  bool available() const { return begin_ != end_; }
+
+  // Moves up to 'max_blocks' blocks of 'size_class' to the front of '*list'
+  // and returns their number, which is 0 once the arena is exhausted.
+  int Take(int size_class, int max_blocks, FreeBlock** list) {
+    absl::MutexLock lock(&mutex_);
+    int taken = 0;
+    while (taken < max_blocks) {
+      if (free_lists_[size_class] == nullptr && !AddSlab(size_class)) break;
+      FreeBlock* block = free_lists_[size_class];
+      free_lists_[size_class] = block->next;
+      block->next = *list;
+      *list = block;
+      taken++;
+    }
+    return taken;
+  }
+
+  // Returns the list of blocks from 'head' to 'tail' to the arena.
+  void Give(int size_class, FreeBlock* head, FreeBlock* tail) {
+    absl::MutexLock lock(&mutex_);
+    tail->next = free_lists_[size_class];
+    free_lists_[size_class] = head;
+  }
+
+ private:
+  Arena() {
+#ifndef _WIN32
+    page_size_ = sysconf(_SC_PAGESIZE);
+    void* reserved = mmap(nullptr, kReservedSize, PROT_NONE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (reserved == MAP_FAILED) return;
+    begin_ = reinterpret_cast<std::uintptr_t>(reserved);
+    end_ = begin_ + kReservedSize;
+    // The first page stays inaccessible as guard page of the first slab.
+    next_slab_ = begin_ + page_size_;
+#endif
+  }
+
+  // Makes the next slab accessible and puts its blocks on the free list of
+  // 'size_class'. Returns false if the arena is exhausted.
+  bool AddSlab(int size_class) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+#ifdef _WIN32
+    return false;
+#else
+    // Leave a guard page after every slab.
+    if (end_ - next_slab_ < kSlabSize + page_size_) return false;
+    void* slab = reinterpret_cast<void*>(next_slab_);
+    if (mprotect(slab, kSlabSize, PROT_READ | PROT_WRITE) != 0) return false;
+    // Fails once RLIMIT_MEMLOCK is reached; the slab is still usable then.
+    mlock(slab, kSlabSize);
+#ifdef MADV_DONTDUMP
+    madvise(slab, kSlabSize, MADV_DONTDUMP);
+#endif
+    next_slab_ += kSlabSize + page_size_;
+    std::size_t block_size = kMinBlockSize << size_class;
+    char* bytes = static_cast<char*>(slab);
+    for (std::size_t offset = 0; offset < kSlabSize; offset += block_size) {
+      FreeBlock* block = reinterpret_cast<FreeBlock*>(bytes + offset);
+      block->next = free_lists_[size_class];
+      free_lists_[size_class] = block;
+    }
+    return true;
+#endif
+  }
+
+  std::uintptr_t begin_ = 0;
+  std::uintptr_t end_ = 0;
+  std::uintptr_t page_size_ = 0;
+  absl::Mutex mutex_;
+  std::uintptr_t next_slab_ ABSL_GUARDED_BY(mutex_) = 0;
+  FreeBlock* free_lists_[kNumSizeClasses] ABSL_GUARDED_BY(mutex_) = {};
+};
+
+// Serves the blocks of key state. Allocations are rare, as they happen when
+// keys are set up, so there are no per-thread free lists. Blocks are carved
+// from the current slab for all size classes, so that the key state of a
+// key stays close together.
+class KeyStateArena {
+ public:
+  static KeyStateArena* Get() {
+    // Never destroyed: blocks may be released during static destruction.
+    static KeyStateArena* arena = new KeyStateArena();
+    return arena;
+  }
+
+  bool Contains(const void* ptr) const {
+    auto address = reinterpret_cast<std::uintptr_t>(ptr);
+    return address >= begin_ && address < end_;
+  }
+
+  // Returns a block of 'size_class', or nullptr once the arena is exhausted.
+  void* Take(int size_class) {
+    absl::MutexLock lock(&mutex_);
+    FreeBlock* block = free_lists_[size_class];
+    if (block != nullptr) {
+      free_lists_[size_class] = block->next;
+      // The rest of the block was zeroed before it was deallocated.
+      std::memset(block, 0, sizeof(FreeBlock));
+      return block;
+    }
+    std::size_t block_size = SecureArena::kCacheLineSize << size_class;
+    if (slab_end_ - next_block_ < block_size && !AddSlab()) return nullptr;
+    void* fresh = reinterpret_cast<void*>(next_block_);
+    next_block_ += block_size;
+    return fresh;
+  }
+
+  void Give(int size_class, void* ptr) {
+    FreeBlock* block = static_cast<FreeBlock*>(ptr);
+    absl::MutexLock lock(&mutex_);
+    block->next = free_lists_[size_class];
+    free_lists_[size_class] = block;
+  }
+
+ private:
+  KeyStateArena() {
+#ifndef _WIN32
+    page_size_ = sysconf(_SC_PAGESIZE);
+    // Reserves room to align the range to a huge page.
+    void* reserved =
+        mmap(nullptr, kKeyStateReservedSize + kHugePageSize, PROT_NONE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (reserved == MAP_FAILED) return;
+    begin_ = AlignUp(reinterpret_cast<std::uintptr_t>(reserved), kHugePageSize);
+    end_ = begin_ + kKeyStateReservedSize;
+    absl::MutexLock lock(&mutex_);
+    // The first page stays inaccessible as guard page of the first slab.
+    next_slab_ = begin_ + page_size_;
+    next_block_ = next_slab_;
+    slab_end_ = next_slab_;
+#endif
+  }
+
+  static std::uintptr_t AlignUp(std::uintptr_t address, std::size_t alignment) {
+    return (address + alignment - 1) & ~(alignment - 1);
+  }
+
+  // Makes the next slab accessible and the one blocks are carved from. The
+  // rest of the previous slab is left unused. Returns false if the arena is
+  // exhausted.
+  bool AddSlab() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+#ifdef _WIN32
+    return false;
+#else
+    bool huge_pages = key_state_huge_pages.load(std::memory_order_relaxed);
+    std::size_t slab_size = huge_pages ? kHugePageSize : kKeyStateSlabSize;
+    std::uintptr_t slab_begin =
+        huge_pages ? AlignUp(next_slab_, kHugePageSize) : next_slab_;
+    // Leave a guard page after every slab.
+    if (slab_begin > end_ || end_ - slab_begin < slab_size + page_size_) {
+      return false;
+    }
+    void* slab = reinterpret_cast<void*>(slab_begin);
+    if (mprotect(slab, slab_size, PROT_READ | PROT_WRITE) != 0) return false;
+#ifdef MADV_HUGEPAGE
+    if (huge_pages) madvise(slab, slab_size, MADV_HUGEPAGE);
+#endif
+    // Fails once RLIMIT_MEMLOCK is reached; the slab is still usable then.
+    mlock(slab, slab_size);
+#ifdef MADV_DONTDUMP
+    madvise(slab, slab_size, MADV_DONTDUMP);
+#endif
+    next_slab_ = slab_begin + slab_size + page_size_;
+    next_block_ = slab_begin;
+    slab_end_ = slab_begin + slab_size;
+    return true;
+#endif
+  }
+
+  std::uintptr_t begin_ = 0;
+  std::uintptr_t end_ = 0;
+  std::uintptr_t page_size_ = 0;
+  absl::Mutex mutex_;
+  std::uintptr_t next_slab_ ABSL_GUARDED_BY(mutex_) = 0;
+  // The unused part of the current slab.
+  std::uintptr_t next_block_ ABSL_GUARDED_BY(mutex_) = 0;
+  std::uintptr_t slab_end_ ABSL_GUARDED_BY(mutex_) = 0;
+  FreeBlock* free_lists_[kNumKeyStateSizeClasses] ABSL_GUARDED_BY(mutex_) =
+      {};
+};
+
+struct ThreadCache {
+  ~ThreadCache();
+
+  FreeBlock* free_lists[kNumSizeClasses] = {};
+  int sizes[kNumSizeClasses] = {};
+};
+
+// Set once the cache of the thread is destroyed; blocks freed after that,
+// e.g. by destructors of other thread-local objects, go to the arena.
+thread_local bool thread_cache_destroyed = false;
+thread_local ThreadCache thread_cache;
+
+ThreadCache::~ThreadCache() {
+  thread_cache_destroyed = true;
+  for (int size_class = 0; size_class < kNumSizeClasses; size_class++) {
+    FreeBlock* head = free_lists[size_class];
+    if (head == nullptr) continue;
+    FreeBlock* tail = head;
+    while (tail->next != nullptr) tail = tail->next;
+    Arena::Get()->Give(size_class, head, tail);
+  }
+}
+
+}  // namespace
+
+// static
+void* SecureArena::Allocate(std::size_t size) {
+  if (size > kMaxBlockSize) return nullptr;
+  Arena* arena = Arena::Get();
+  if (!arena->available()) return nullptr;
+  int size_class = SizeClass(size);
+  FreeBlock* block = nullptr;
+  if (thread_cache_destroyed) {
+    if (arena->Take(size_class, 1, &block) == 0) return nullptr;
+  } else {
+    ThreadCache& cache = thread_cache;
+    if (cache.free_lists[size_class] == nullptr) {
+      cache.sizes[size_class] += arena->Take(
+          size_class, kThreadCacheRefill, &cache.free_lists[size_class]);
+      if (cache.free_lists[size_class] == nullptr) return nullptr;
+    }
+    block = cache.free_lists[size_class];
+    cache.free_lists[size_class] = block->next;
+    cache.sizes[size_class]--;
+  }
+  // The rest of the block was zeroed before it was deallocated.
+  std::memset(block, 0, sizeof(FreeBlock));
+  return block;
+}
+
+// static
+void* SecureArena::AllocateKeyState(std::size_t size) {
+  if (size > kMaxBlockSize) return nullptr;
+  return KeyStateArena::Get()->Take(KeyStateSizeClass(size));
+}
+
+// static
+void SecureArena::Deallocate(void* ptr, std::size_t size) {
+  KeyStateArena* key_state_arena = KeyStateArena::Get();
+  if (key_state_arena->Contains(ptr)) {
+    key_state_arena->Give(KeyStateSizeClass(size), ptr);
+    return;
+  }
+  int size_class = SizeClass(size);
+  FreeBlock* block = static_cast<FreeBlock*>(ptr);
+  if (thread_cache_destroyed) {
+    block->next = nullptr;
+    Arena::Get()->Give(size_class, block, block);
+    return;
+  }
+  ThreadCache& cache = thread_cache;
+  block->next = cache.free_lists[size_class];
+  cache.free_lists[size_class] = block;
+  if (++cache.sizes[size_class] < kMaxThreadCacheBlocks) return;
+  // Keep the most recently freed half, and give the rest to the arena, so
+  // that blocks freed on one thread can be reused by others.
+  FreeBlock* last_kept = block;
+  for (int i = 1; i < kMaxThreadCacheBlocks / 2; i++) {
+    last_kept = last_kept->next;
+  }
+  FreeBlock* head = last_kept->next;
+  FreeBlock* tail = head;
+  while (tail->next != nullptr) tail = tail->next;
+  last_kept->next = nullptr;
+  cache.sizes[size_class] = kMaxThreadCacheBlocks / 2;
+  Arena::Get()->Give(size_class, head, tail);
+}
+
+// static
+bool SecureArena::Contains(const void* ptr) {
+  return Arena::Get()->Contains(ptr) || KeyStateArena::Get()->Contains(ptr);
+}
+
+// static
+void SecureArena::EnableKeyStateHugePages() {
+  key_state_huge_pages.store(true, std::memory_order_relaxed);
+}
+
+}  // namespace internal
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
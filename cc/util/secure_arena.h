@@ -0,0 +1,84 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_UTIL_SECURE_ARENA_H_
+#define TINK_UTIL_SECURE_ARENA_H_
+
+#include <cstddef>
+
+namespace crypto {
+namespace tink {
+namespace util {
+namespace internal {
+
+// Allocator for small blocks of secret data, used by SanitizingAllocator.
+//
+// The arena reserves a single range of address space when first used, and
+// serves blocks from 64 KiB slabs inside it. Each slab is locked into memory
+// with mlock() (best effort, subject to RLIMIT_MEMLOCK), excluded from core
+// dumps where supported, and followed by an inaccessible guard page, so that
+// overruns fault instead of reaching other data. Blocks are grouped in
+// power-of-two size classes from 16 to kMaxBlockSize bytes, and freed blocks
+// are kept on per-thread free lists, so most allocations take no lock.
+//
+// Key state, i.e. state which is computed once when a key is set up and then
+// only read, such as AES round keys, is served separately by
+// AllocateKeyState(): from slabs in another range of address space, in
+// blocks of whole cache lines. Key schedules of many keys are thus packed
+// densely, and never share a cache line with data that is written while they
+// are in use, which would otherwise be invalidated on the other cores.
+//
+// Memory of the arena is never returned to the operating system. Callers are
+// responsible for zeroing blocks before deallocating them.
+class SecureArena {
+ public:
+  // Largest block served by the arena.
+  static constexpr std::size_t kMaxBlockSize = 2048;
+  // Every block is aligned to at least this many bytes.
+  static constexpr std::size_t kMinAlignment = 16;
+  // Blocks of key state are aligned to and a multiple of this many bytes.
+  static constexpr std::size_t kCacheLineSize = 64;
+
+  // Returns a block of at least 'size' bytes, or nullptr if 'size' is larger
+  // than kMaxBlockSize or the arena is exhausted or unavailable on this
+  // platform. Callers then fall back to the general heap.
+  static void* Allocate(std::size_t size);
+
+  // Same as Allocate(), for a block of key state.
+  static void* AllocateKeyState(std::size_t size);
+
+  // Returns the block at 'ptr' to the arena. 'ptr' must have been returned
+  // by Allocate(size) or AllocateKeyState(size), possibly on a different
+  // thread.
+  static void Deallocate(void* ptr, std::size_t size);
+
+  // Makes the slabs for key state which are added from now on 2 MiB large
+  // and aligned, and asks for transparent huge pages for them where
+  // supported, so that the key state of thousands of keys is covered by a
+  // few TLB entries. Meant to be called at start-up by processes which hold
+  // many keys; each slab then takes 2 MiB of memory.
+  static void EnableKeyStateHugePages();
+
+  // Returns true if 'ptr' points into memory of the arena.
+  static bool Contains(const void* ptr);
+};
+
+}  // namespace internal
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_UTIL_SECURE_ARENA_H_
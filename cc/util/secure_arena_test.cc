@@ -0,0 +1,188 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/util/secure_arena.h"
+
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "tink/util/secret_data.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+namespace internal {
+namespace {
+
+TEST(SecureArenaTest, AllocatesSmallBlocks) {
+  for (std::size_t size = 1; size <= SecureArena::kMaxBlockSize; size *= 3) {
+    SCOPED_TRACE(size);
+    void* ptr = SecureArena::Allocate(size);
+    ASSERT_NE(ptr, nullptr);
+    EXPECT_TRUE(SecureArena::Contains(ptr));
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr) %
+                  SecureArena::kMinAlignment,
+              0);
+    std::memset(ptr, 0xab, size);
+    std::memset(ptr, 0, size);
+    SecureArena::Deallocate(ptr, size);
+  }
+}
+
+TEST(SecureArenaTest, RejectsLargeBlocks) {
+  EXPECT_EQ(SecureArena::Allocate(SecureArena::kMaxBlockSize + 1), nullptr);
+}
+
+TEST(SecureArenaTest, DoesNotContainHeapMemory) {
+  std::vector<uint8_t> heap(16);
+  EXPECT_FALSE(SecureArena::Contains(heap.data()));
+  EXPECT_FALSE(SecureArena::Contains(nullptr));
+}
+
+TEST(SecureArenaTest, ReusesFreedBlocks) {
+  void* ptr = SecureArena::Allocate(64);
+  ASSERT_NE(ptr, nullptr);
+  SecureArena::Deallocate(ptr, 64);
+  EXPECT_EQ(SecureArena::Allocate(64), ptr);
+  SecureArena::Deallocate(ptr, 64);
+}
+
+TEST(SecureArenaTest, BlocksDoNotOverlap) {
+  constexpr int kNumBlocks = 1000;
+  for (std::size_t size : {16, 100, 2048}) {
+    SCOPED_TRACE(size);
+    std::vector<uint8_t*> blocks;
+    for (int i = 0; i < kNumBlocks; i++) {
+      auto block = static_cast<uint8_t*>(SecureArena::Allocate(size));
+      ASSERT_NE(block, nullptr);
+      std::memset(block, i & 0xff, size);
+      blocks.push_back(block);
+    }
+    for (int i = 0; i < kNumBlocks; i++) {
+      EXPECT_EQ(blocks[i][0], i & 0xff);
+      EXPECT_EQ(blocks[i][size - 1], i & 0xff);
+      std::memset(blocks[i], 0, size);
+      SecureArena::Deallocate(blocks[i], size);
+    }
+  }
+}
+
+TEST(SecureArenaTest, DeallocateOnOtherThread) {
+  constexpr int kNumBlocks = 200;
+  std::vector<void*> blocks;
+  std::thread allocating_thread([&blocks] {
+    for (int i = 0; i < kNumBlocks; i++) {
+      blocks.push_back(SecureArena::Allocate(32));
+    }
+  });
+  allocating_thread.join();
+  std::set<void*> distinct(blocks.begin(), blocks.end());
+  EXPECT_EQ(distinct.size(), kNumBlocks);
+  for (void* block : blocks) {
+    ASSERT_NE(block, nullptr);
+    SecureArena::Deallocate(block, 32);
+  }
+}
+
+TEST(SecureArenaTest, UsedForSecretData) {
+  SecretData small(32, 0x01);
+  EXPECT_TRUE(SecureArena::Contains(small.data()));
+  SecretData large(SecureArena::kMaxBlockSize + 1, 0x01);
+  EXPECT_FALSE(SecureArena::Contains(large.data()));
+  SecretUniquePtr<int> value = MakeSecretUniquePtr<int>(42);
+  EXPECT_TRUE(SecureArena::Contains(value.get()));
+  EXPECT_EQ(*value, 42);
+}
+
+TEST(SecureArenaTest, KeyStateBlocksOccupyWholeCacheLines) {
+  constexpr int kNumBlocks = 100;
+  std::vector<uint8_t*> blocks;
+  std::set<std::uintptr_t> cache_lines;
+  for (int i = 0; i < kNumBlocks; i++) {
+    auto block = static_cast<uint8_t*>(SecureArena::AllocateKeyState(16));
+    ASSERT_NE(block, nullptr);
+    EXPECT_TRUE(SecureArena::Contains(block));
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(block) %
+                  SecureArena::kCacheLineSize,
+              0);
+    std::memset(block, 0xab, 16);
+    blocks.push_back(block);
+    cache_lines.insert(reinterpret_cast<std::uintptr_t>(block) /
+                       SecureArena::kCacheLineSize);
+  }
+  EXPECT_EQ(cache_lines.size(), kNumBlocks);
+  // Other blocks never share a cache line with key state.
+  void* other = SecureArena::Allocate(16);
+  ASSERT_NE(other, nullptr);
+  EXPECT_EQ(cache_lines.count(reinterpret_cast<std::uintptr_t>(other) /
+                              SecureArena::kCacheLineSize),
+            0);
+  SecureArena::Deallocate(other, 16);
+  for (uint8_t* block : blocks) {
+    std::memset(block, 0, 16);
+    SecureArena::Deallocate(block, 16);
+  }
+  EXPECT_EQ(SecureArena::AllocateKeyState(SecureArena::kMaxBlockSize + 1),
+            nullptr);
+}
+
+TEST(SecureArenaTest, ReusesFreedKeyStateBlocks) {
+  void* ptr = SecureArena::AllocateKeyState(200);
+  ASSERT_NE(ptr, nullptr);
+  SecureArena::Deallocate(ptr, 200);
+  EXPECT_EQ(SecureArena::AllocateKeyState(256), ptr);
+  SecureArena::Deallocate(ptr, 256);
+}
+
+TEST(SecureArenaTest, KeyStateWithHugePages) {
+  SecureArena::EnableKeyStateHugePages();
+  // Enough blocks to fill more than a slab of either size.
+  constexpr int kNumBlocks = 1100;
+  std::vector<uint8_t*> blocks;
+  for (int i = 0; i < kNumBlocks; i++) {
+    auto block = static_cast<uint8_t*>(
+        SecureArena::AllocateKeyState(SecureArena::kMaxBlockSize));
+    ASSERT_NE(block, nullptr);
+    std::memset(block, i & 0xff, SecureArena::kMaxBlockSize);
+    blocks.push_back(block);
+  }
+  for (int i = 0; i < kNumBlocks; i++) {
+    EXPECT_EQ(blocks[i][0], i & 0xff);
+    EXPECT_EQ(blocks[i][SecureArena::kMaxBlockSize - 1], i & 0xff);
+    std::memset(blocks[i], 0, SecureArena::kMaxBlockSize);
+    SecureArena::Deallocate(blocks[i], SecureArena::kMaxBlockSize);
+  }
+}
+
+TEST(SecureArenaTest, UsedForKeyState) {
+  SecretUniquePtr<int> value = MakeKeyStateUniquePtr<int>(42);
+  EXPECT_TRUE(SecureArena::Contains(value.get()));
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(value.get()) %
+                SecureArena::kCacheLineSize,
+            0);
+  EXPECT_EQ(*value, 42);
+}
+
+}  // namespace
+}  // namespace internal
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
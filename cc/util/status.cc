@@ -15,6 +15,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <sstream>
+#include <utility>
 
 #include "tink/util/status.h"
 
@@ -58,15 +59,12 @@ Status::Status(const ::absl::Status& status)
 
 Status::operator ::absl::Status() const {
   if (ok()) return ::absl::OkStatus();
-  return ::absl::Status(static_cast<absl::StatusCode>(code_), message_);
-}
-
-Status::Status() : code_(::crypto::tink::util::error::OK), message_("") {
+  return ::absl::Status(static_cast<absl::StatusCode>(code_), error_message());
 }
 
 Status::Status(::crypto::tink::util::error::Code error,
-               const std::string& error_message)
-    : code_(error), message_(error_message) {
+               std::string error_message)
+    : code_(error), message_(std::move(error_message)) {
   if (code_ == ::crypto::tink::util::error::OK) {
     message_.clear();
   }
@@ -75,9 +73,20 @@ Status::Status(::crypto::tink::util::error::Code error,
 Status& Status::operator=(const Status& other) {
   code_ = other.code_;
   message_ = other.message_;
+  static_message_ = other.static_message_;
   return *this;
 }
 
+// static
+const Status* Status::NewStatic(::crypto::tink::util::error::Code error,
+                                const std::string& error_message) {
+  Status* status = new Status(error, "");
+  if (error != ::crypto::tink::util::error::OK) {
+    status->static_message_ = new std::string(error_message);
+  }
+  return status;
+}
+
 const Status& Status::CANCELLED = GetCancelled();
 const Status& Status::UNKNOWN = GetUnknown();
 const Status& Status::OK = GetOk();
@@ -88,7 +97,7 @@ std::string Status::ToString() const {
   }
 
   std::ostringstream oss;
-  oss << code_ << ": " << message_;
+  oss << code_ << ": " << error_message();
   return oss.str();
 }
 
@@ -139,13 +139,29 @@ class ABSL_MUST_USE_RESULT Status;
 class Status {
  public:
   // Creates an OK status
-  Status();
+  Status() : code_(::crypto::tink::util::error::OK) {}
 
   // Make a Status from the specified error and message.
-  Status(::crypto::tink::util::error::Code error,
-         const std::string& error_message);
+  Status(::crypto::tink::util::error::Code error, std::string error_message);
 
+  Status(const Status& other) = default;
+  Status(Status&& other) = default;
   Status& operator=(const Status& other);
+  Status& operator=(Status&& other) = default;
+
+  // Returns a new Status whose copies refer to its message instead of copying
+  // it, so that copying it never allocates. Meant for errors on hot paths
+  // which callers usually expect and discard, e.g. failed authentication
+  // during trial decryption. The returned Status is never deleted, since it
+  // must outlive all of its copies; keep it in a function-local static:
+  //
+  //   static const util::Status* kAuthenticationFailed =
+  //       util::Status::NewStatic(util::error::INTERNAL,
+  //                               "Authentication failed");
+  //   ...
+  //   return *kAuthenticationFailed;
+  static const Status* NewStatic(::crypto::tink::util::error::Code error,
+                                 const std::string& error_message);
 
   // Some pre-defined Status objects
   static const Status& OK;  // Identical to 0-arg constructor
@@ -162,7 +178,9 @@ class Status {
   ::crypto::tink::util::error::Code CanonicalCode() const {
     return code_;
   }
-  const std::string& error_message() const { return message_; }
+  const std::string& error_message() const {
+    return static_message_ != nullptr ? *static_message_ : message_;
+  }
 
   bool operator==(const Status& x) const;
   bool operator!=(const Status& x) const;
@@ -179,10 +197,14 @@ class Status {
  private:
   ::crypto::tink::util::error::Code code_;
   std::string message_;
+  // Message shared by all copies of a Status made by NewStatic(); message_ is
+  // empty then.
+  const std::string* static_message_ = nullptr;
 };
 
 inline bool Status::operator==(const Status& other) const {
-  return (this->code_ == other.code_) && (this->message_ == other.message_);
+  return (this->code_ == other.code_) &&
+         (this->error_message() == other.error_message());
 }
 
 inline bool Status::operator!=(const Status& other) const {
@@ -116,6 +116,30 @@ TEST(StatusOrTest, MoveOutMoveOnly) {
   ASSERT_THAT(*ten, Eq(10));
 }
 
+TEST(StatusOrTest, MoveFromStatus) {
+  Status status(error::Code::INVALID_ARGUMENT, "A message on the heap");
+  StatusOr<int> error = std::move(status);
+  EXPECT_EQ(error.status().CanonicalCode(), error::Code::INVALID_ARGUMENT);
+  EXPECT_EQ(error.status().error_message(), "A message on the heap");
+}
+
+TEST(StatusOrTest, StaticStatusSharesMessage) {
+  static const Status* kStatus =
+      Status::NewStatic(error::Code::INTERNAL, "Authentication failed");
+  StatusOr<int> error = *kStatus;
+  EXPECT_EQ(error.status().error_message().data(),
+            kStatus->error_message().data());
+  StatusOr<int> moved = std::move(error);
+  EXPECT_EQ(moved.status().error_message().data(),
+            kStatus->error_message().data());
+
+  EXPECT_EQ(moved.status(),
+            Status(error::Code::INTERNAL, "Authentication failed"));
+  EXPECT_EQ(moved.status().ToString(), "INTERNAL: Authentication failed");
+  absl::Status converted = moved.status();
+  EXPECT_EQ(converted.message(), "Authentication failed");
+}
+
 }  // namespace
 
 }  // namespace util
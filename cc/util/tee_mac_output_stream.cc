@@ -0,0 +1,139 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/util/tee_mac_output_stream.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "openssl/digest.h"
+#include "tink/output_stream.h"
+#include "tink/subtle/common_enums.h"
+#include "tink/subtle/mac/stateful_mac.h"
+#include "tink/subtle/subtle_util_boringssl.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+namespace {
+
+// A StatefulMac that computes an unkeyed hash.
+class StatefulHash : public subtle::StatefulMac {
+ public:
+  explicit StatefulHash(bssl::UniquePtr<EVP_MD_CTX> ctx)
+      : ctx_(std::move(ctx)) {}
+
+  Status Update(absl::string_view data) override {
+    if (EVP_DigestUpdate(ctx_.get(), data.data(), data.size()) != 1) {
+      return Status(util::error::INTERNAL, "Hash update failed.");
+    }
+    return Status::OK;
+  }
+
+  StatusOr<std::string> Finalize() override {
+    uint8_t digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_size;
+    if (EVP_DigestFinal_ex(ctx_.get(), digest, &digest_size) != 1) {
+      return Status(util::error::INTERNAL, "Hash finalization failed.");
+    }
+    return std::string(reinterpret_cast<char*>(digest), digest_size);
+  }
+
+ private:
+  const bssl::UniquePtr<EVP_MD_CTX> ctx_;
+};
+
+}  // namespace
+
+TeeMacOutputStream::TeeMacOutputStream(
+    std::unique_ptr<crypto::tink::OutputStream> destination,
+    std::unique_ptr<subtle::StatefulMac> mac)
+    : destination_(std::move(destination)),
+      mac_(std::move(mac)),
+      buffer_(nullptr),
+      count_in_buffer_(0) {}
+
+StatusOr<std::unique_ptr<TeeMacOutputStream>> TeeMacOutputStream::NewWithHash(
+    std::unique_ptr<crypto::tink::OutputStream> destination,
+    subtle::HashType hash_type) {
+  auto md_result = subtle::SubtleUtilBoringSSL::EvpHash(hash_type);
+  if (!md_result.ok()) return md_result.status();
+  bssl::UniquePtr<EVP_MD_CTX> ctx(EVP_MD_CTX_new());
+  if (ctx == nullptr ||
+      EVP_DigestInit_ex(ctx.get(), md_result.ValueOrDie(), nullptr) != 1) {
+    return Status(util::error::INTERNAL, "Hash initialization failed.");
+  }
+  return absl::make_unique<TeeMacOutputStream>(
+      std::move(destination), absl::make_unique<StatefulHash>(std::move(ctx)));
+}
+
+void TeeMacOutputStream::UpdateMac() {
+  if (count_in_buffer_ == 0) return;
+  status_ = mac_->Update(absl::string_view(buffer_, count_in_buffer_));
+  count_in_buffer_ = 0;
+}
+
+StatusOr<int> TeeMacOutputStream::NextBuffer(void** data) {
+  if (!status_.ok()) return status_;
+  // The destination may process the data of the current buffer in Next(),
+  // e.g. encrypt it in place, so it must be passed to the MAC first.
+  UpdateMac();
+  if (!status_.ok()) return status_;
+  auto next_result = destination_->Next(data);
+  if (!next_result.ok()) {
+    status_ = next_result.status();
+    return status_;
+  }
+  buffer_ = static_cast<const char*>(*data);
+  count_in_buffer_ = next_result.ValueOrDie();
+  return count_in_buffer_;
+}
+
+void TeeMacOutputStream::BackUp(int count) {
+  if (!status_.ok() || count < 1) return;
+  int actual_count = std::min(count, count_in_buffer_);
+  count_in_buffer_ -= actual_count;
+  destination_->BackUp(actual_count);
+}
+
+StatusOr<std::string> TeeMacOutputStream::CloseStreamAndComputeResult() {
+  if (!status_.ok()) return status_;
+  UpdateMac();
+  if (!status_.ok()) {
+    destination_->Close().IgnoreError();
+    return status_;
+  }
+  status_ = destination_->Close();
+  if (!status_.ok()) return status_;
+  status_ = Status(util::error::FAILED_PRECONDITION, "Stream closed");
+  return mac_->Finalize();
+}
+
+int64_t TeeMacOutputStream::Position() const {
+  return destination_->Position();
+}
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
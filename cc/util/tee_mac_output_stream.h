@@ -0,0 +1,91 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_UTIL_TEE_MAC_OUTPUT_STREAM_H_
+#define TINK_UTIL_TEE_MAC_OUTPUT_STREAM_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "tink/output_stream.h"
+#include "tink/output_stream_with_result.h"
+#include "tink/subtle/common_enums.h"
+#include "tink/subtle/mac/stateful_mac.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+
+// An OutputStream that writes the data written to it to another
+// OutputStream, typically an encrypting stream of a StreamingAead, and
+// computes a MAC or a hash of the same data, e.g. a content hash of the
+// plaintext for deduplication, in the same pass:
+//
+//   auto ct_stream = streaming_aead->NewEncryptingStream(...).ValueOrDie();
+//   auto pt_stream = TeeMacOutputStream::NewWithHash(
+//       std::move(ct_stream), subtle::HashType::SHA256).ValueOrDie();
+//   ... write the plaintext to pt_stream ...
+//   std::string digest = pt_stream->CloseAndGetResult().ValueOrDie();
+//
+// Next() returns the buffers of the destination, e.g. the plaintext segment
+// of the encrypting stream, and the data written to a buffer is passed to
+// the MAC before the destination processes it, so the data is not copied.
+class TeeMacOutputStream : public OutputStreamWithResult<std::string> {
+ public:
+  // Constructs a stream that writes to 'destination' and computes a MAC with
+  // 'mac', e.g. a StatefulHmacBoringSsl as used by StreamingMacImpl.
+  TeeMacOutputStream(std::unique_ptr<crypto::tink::OutputStream> destination,
+                     std::unique_ptr<subtle::StatefulMac> mac);
+
+  // Returns a stream that writes to 'destination' and computes the
+  // 'hash_type' digest of the data.
+  static crypto::tink::util::StatusOr<std::unique_ptr<TeeMacOutputStream>>
+  NewWithHash(std::unique_ptr<crypto::tink::OutputStream> destination,
+              subtle::HashType hash_type);
+
+  ~TeeMacOutputStream() override {}
+
+  void BackUp(int count) override;
+
+  // Returns the number of bytes written so far.
+  int64_t Position() const override;
+
+ protected:
+  // Closes the destination and returns the MAC of the data.
+  crypto::tink::util::StatusOr<std::string> CloseStreamAndComputeResult()
+      override;
+
+  crypto::tink::util::StatusOr<int> NextBuffer(void** data) override;
+
+ private:
+  // Passes the data written to the current buffer to the MAC.
+  void UpdateMac();
+
+  util::Status status_;
+  std::unique_ptr<crypto::tink::OutputStream> destination_;
+  std::unique_ptr<subtle::StatefulMac> mac_;
+  const char* buffer_;  // the current buffer of the destination
+  int count_in_buffer_;  // # bytes in buffer_ written by the caller
+};
+
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_UTIL_TEE_MAC_OUTPUT_STREAM_H_
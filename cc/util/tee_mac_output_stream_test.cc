@@ -0,0 +1,199 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "tink/util/tee_mac_output_stream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
+#include "openssl/sha.h"
+#include "tink/output_stream.h"
+#include "tink/subtle/common_enums.h"
+#include "tink/subtle/random.h"
+#include "tink/subtle/stateful_hmac_boringssl.h"
+#include "tink/subtle/streaming_aead_encrypting_stream.h"
+#include "tink/subtle/test_util.h"
+#include "tink/util/ostream_output_stream.h"
+#include "tink/util/secret_data.h"
+#include "tink/util/status.h"
+#include "tink/util/test_matchers.h"
+
+namespace crypto {
+namespace tink {
+namespace util {
+namespace {
+
+using ::crypto::tink::subtle::HashType;
+using ::crypto::tink::subtle::test::DummyStreamSegmentEncrypter;
+using ::crypto::tink::subtle::test::WriteToStream;
+using ::crypto::tink::test::IsOk;
+using ::crypto::tink::test::StatusIs;
+
+std::string Sha256(const std::string& data) {
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const uint8_t*>(data.data()), data.size(), digest);
+  return std::string(reinterpret_cast<char*>(digest), sizeof(digest));
+}
+
+TEST(TeeMacOutputStreamTest, Hash) {
+  for (int size : {0, 1, 10, 100, 1000, 10000, 100000}) {
+    for (int buffer_size : {1, 10, 1000, 100000}) {
+      SCOPED_TRACE(absl::StrCat("size = ", size,
+                                ", buffer_size = ", buffer_size));
+      std::string data = subtle::Random::GetRandomBytes(size);
+      auto ct_stream = absl::make_unique<std::stringstream>();
+      auto ct_buf = ct_stream->rdbuf();
+      auto output_stream_result = TeeMacOutputStream::NewWithHash(
+          absl::make_unique<OstreamOutputStream>(std::move(ct_stream),
+                                                 buffer_size),
+          HashType::SHA256);
+      ASSERT_THAT(output_stream_result.status(), IsOk());
+      auto output_stream = std::move(output_stream_result.ValueOrDie());
+      EXPECT_THAT(WriteToStream(output_stream.get(), data), IsOk());
+      EXPECT_EQ(output_stream->Position(), size);
+      EXPECT_EQ(ct_buf->str(), data);
+      auto digest_result = output_stream->GetResult();
+      ASSERT_THAT(digest_result.status(), IsOk());
+      EXPECT_EQ(digest_result.ValueOrDie(), Sha256(data));
+    }
+  }
+}
+
+TEST(TeeMacOutputStreamTest, Mac) {
+  util::SecretData key =
+      util::SecretDataFromStringView(subtle::Random::GetRandomBytes(32));
+  std::string data = subtle::Random::GetRandomBytes(10000);
+  auto mac_result = subtle::StatefulHmacBoringSsl::New(HashType::SHA256,
+                                                       /*tag_size=*/16, key);
+  ASSERT_THAT(mac_result.status(), IsOk());
+  auto expected_mac = std::move(mac_result.ValueOrDie());
+  ASSERT_THAT(expected_mac->Update(data), IsOk());
+
+  auto tee_mac_result = subtle::StatefulHmacBoringSsl::New(
+      HashType::SHA256, /*tag_size=*/16, key);
+  ASSERT_THAT(tee_mac_result.status(), IsOk());
+  auto ct_stream = absl::make_unique<std::stringstream>();
+  auto ct_buf = ct_stream->rdbuf();
+  TeeMacOutputStream output_stream(
+      absl::make_unique<OstreamOutputStream>(std::move(ct_stream), 100),
+      std::move(tee_mac_result.ValueOrDie()));
+  EXPECT_THAT(WriteToStream(&output_stream, data, /*close_stream=*/false),
+              IsOk());
+  auto mac = output_stream.CloseAndGetResult();
+  ASSERT_THAT(mac.status(), IsOk());
+  EXPECT_EQ(mac.ValueOrDie(), expected_mac->Finalize().ValueOrDie());
+  EXPECT_EQ(ct_buf->str(), data);
+}
+
+TEST(TeeMacOutputStreamTest, BackUpAndPosition) {
+  auto ct_stream = absl::make_unique<std::stringstream>();
+  auto ct_buf = ct_stream->rdbuf();
+  auto output_stream = std::move(
+      TeeMacOutputStream::NewWithHash(
+          absl::make_unique<OstreamOutputStream>(std::move(ct_stream)),
+          HashType::SHA256)
+          .ValueOrDie());
+  void* buffer;
+  auto next_result = output_stream->Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  int buffer_size = next_result.ValueOrDie();
+  EXPECT_EQ(output_stream->Position(), buffer_size);
+  std::memset(buffer, 'a', 10);
+  output_stream->BackUp(buffer_size - 10);
+  EXPECT_EQ(output_stream->Position(), 10);
+  output_stream->BackUp(buffer_size);  // cannot back up beyond the buffer
+  EXPECT_EQ(output_stream->Position(), 0);
+
+  next_result = output_stream->Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  std::memset(buffer, 'b', 5);
+  output_stream->BackUp(next_result.ValueOrDie() - 5);
+  EXPECT_EQ(output_stream->Position(), 5);
+  auto digest_result = output_stream->CloseAndGetResult();
+  ASSERT_THAT(digest_result.status(), IsOk());
+  EXPECT_EQ(digest_result.ValueOrDie(), Sha256("bbbbb"));
+  EXPECT_EQ(ct_buf->str(), "bbbbb");
+
+  // The stream cannot be used after Close().
+  EXPECT_THAT(output_stream->Next(&buffer).status(),
+              StatusIs(util::error::FAILED_PRECONDITION));
+  EXPECT_THAT(output_stream->Close(),
+              StatusIs(util::error::FAILED_PRECONDITION));
+}
+
+TEST(TeeMacOutputStreamTest, HashIntoEncryptingStream) {
+  int pt_segment_size = 64 * 1024;
+  int header_size = 32;
+  auto ct_stream = absl::make_unique<std::stringstream>();
+  auto ct_buf = ct_stream->rdbuf();
+  auto enc_stream_result = subtle::StreamingAeadEncryptingStream::New(
+      absl::make_unique<DummyStreamSegmentEncrypter>(
+          pt_segment_size, header_size, /* ct_offset = */ 0),
+      absl::make_unique<OstreamOutputStream>(std::move(ct_stream)));
+  ASSERT_THAT(enc_stream_result.status(), IsOk());
+  auto output_stream_result = TeeMacOutputStream::NewWithHash(
+      std::move(enc_stream_result.ValueOrDie()), HashType::SHA256);
+  ASSERT_THAT(output_stream_result.status(), IsOk());
+  auto output_stream = std::move(output_stream_result.ValueOrDie());
+
+  // The buffers are the plaintext segments of the encrypting stream.
+  void* buffer;
+  auto next_result = output_stream->Next(&buffer);
+  ASSERT_THAT(next_result.status(), IsOk());
+  EXPECT_EQ(next_result.ValueOrDie(), pt_segment_size - header_size);
+  output_stream->BackUp(next_result.ValueOrDie());
+
+  std::string data = subtle::Random::GetRandomBytes(1000000);
+  EXPECT_THAT(WriteToStream(output_stream.get(), data), IsOk());
+  auto digest_result = output_stream->GetResult();
+  ASSERT_THAT(digest_result.status(), IsOk());
+  EXPECT_EQ(digest_result.ValueOrDie(), Sha256(data));
+
+  std::string plaintext;
+  std::string ct = ct_buf->str();
+  // Strips the header and the segment tags of the dummy encryption.
+  const int tag_size = DummyStreamSegmentEncrypter::kSegmentTagSize;
+  int pos = header_size;
+  int segment_size = pt_segment_size - header_size;
+  while (pos < ct.size()) {
+    int size = std::min<int>(segment_size, ct.size() - pos - tag_size);
+    plaintext += ct.substr(pos, size);
+    pos += size + tag_size;
+    segment_size = pt_segment_size;
+  }
+  EXPECT_EQ(plaintext, data);
+}
+
+TEST(TeeMacOutputStreamTest, UnknownHash) {
+  EXPECT_THAT(TeeMacOutputStream::NewWithHash(
+                  absl::make_unique<OstreamOutputStream>(
+                      absl::make_unique<std::stringstream>()),
+                  HashType::UNKNOWN_HASH)
+                  .status(),
+              StatusIs(util::error::UNIMPLEMENTED));
+}
+
+}  // namespace
+}  // namespace util
+}  // namespace tink
+}  // namespace crypto
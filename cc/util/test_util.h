@@ -675,6 +675,10 @@ class DummyStatefulMac : public subtle::StatefulMac {
   util::StatusOr<std::string> Finalize() override {
     return dummy_aead_.Encrypt("", buffer_);
   }
+  util::Status Reset() override {
+    buffer_.clear();
+    return util::OkStatus();
+  }
 
  private:
   DummyAead dummy_aead_;
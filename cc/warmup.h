@@ -0,0 +1,124 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef TINK_WARMUP_H_
+#define TINK_WARMUP_H_
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "tink/aead.h"
+#include "tink/deterministic_aead.h"
+#include "tink/hybrid_decrypt.h"
+#include "tink/hybrid_encrypt.h"
+#include "tink/keyset_handle.h"
+#include "tink/mac.h"
+#include "tink/public_key_sign.h"
+#include "tink/public_key_verify.h"
+#include "tink/util/statusor.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+
+///////////////////////////////////////////////////////////////////////////////
+// Warm-up of wrapped primitives before they serve traffic.
+//
+// The first operations with a new primitive are slower than later ones: code
+// and tables are paged in, lazily initialized state in BoringSSL and in Tink
+// is built, and primitives obtained with KeysetHandle::GetLazyPrimitive()
+// only create the primitives of non-primary keys when those are first used.
+// Warmup() moves this cost to startup by exercising 'primitive', the wrapped
+// primitive of the keyset described by 'keyset_info', once per key:
+//
+//  * Operations that produce output (encrypt, compute a MAC, sign) are done
+//    once on a fixed dummy message with the primary key, and their output is
+//    checked where the primitive can do so (decrypt, verify the MAC).
+//  * For every enabled key, an operation that consumes output (decrypt,
+//    verify) is done on dummy data with the output prefix of that key. It
+//    fails, but routes to the primitive of that key and creates it if the
+//    primitive is lazy. Keys with the RAW output prefix are reached together
+//    by dummy data without a prefix.
+//
+// No secret data is used, and nothing is written. Returns how long the
+// warm-up took, or an error if an operation with the primary key failed,
+// which usually means that the keyset cannot serve traffic.
+//
+// Prefork servers, which create their primitives in a parent process and
+// fork() workers that use them, can keep the memory of the primitives shared
+// between the processes as follows:
+//
+//  * Create the primitives in the parent with KeysetHandle::GetPrimitive()
+//    or GetCachedPrimitive(), and warm them up there. The primitive sets the
+//    Registry hands to the wrappers are frozen, so operations read them
+//    without locking, and Warmup() creates the primitives of lazy keys, so
+//    that the workers do not each create their own copies.
+//  * In the workers, keep using the pointers obtained in the parent. Copying
+//    a std::shared_ptr, as GetCachedPrimitive() and AtomicPrimitive::Get()
+//    do on every call, writes its reference count and copies the page that
+//    holds it into each worker.
+//
+// Random values need no preparation: BoringSSL reseeds its generator in the
+// child, and the nonce pools of subtle::Random and the nonces of
+// subtle::CounterNonceGenerator are renewed after fork(), so that parent and
+// workers never use the same nonces.
+crypto::tink::util::StatusOr<absl::Duration> Warmup(
+    const Aead& primitive, const google::crypto::tink::KeysetInfo& keyset_info);
+
+crypto::tink::util::StatusOr<absl::Duration> Warmup(
+    const DeterministicAead& primitive,
+    const google::crypto::tink::KeysetInfo& keyset_info);
+
+crypto::tink::util::StatusOr<absl::Duration> Warmup(
+    const Mac& primitive, const google::crypto::tink::KeysetInfo& keyset_info);
+
+// Signs the dummy message, but cannot verify the signature.
+crypto::tink::util::StatusOr<absl::Duration> Warmup(
+    const PublicKeySign& primitive,
+    const google::crypto::tink::KeysetInfo& keyset_info);
+
+crypto::tink::util::StatusOr<absl::Duration> Warmup(
+    const PublicKeyVerify& primitive,
+    const google::crypto::tink::KeysetInfo& keyset_info);
+
+// Encrypts the dummy message, but cannot decrypt it.
+crypto::tink::util::StatusOr<absl::Duration> Warmup(
+    const HybridEncrypt& primitive,
+    const google::crypto::tink::KeysetInfo& keyset_info);
+
+crypto::tink::util::StatusOr<absl::Duration> Warmup(
+    const HybridDecrypt& primitive,
+    const google::crypto::tink::KeysetInfo& keyset_info);
+
+// Creates the primitive KeysetHandle::GetCachedPrimitive<P>() returns for
+// 'keyset_handle', if it was not created yet, and warms it up. The returned
+// duration includes the creation.
+template <class P>
+crypto::tink::util::StatusOr<absl::Duration> WarmupCachedPrimitive(
+    const KeysetHandle& keyset_handle) {
+  absl::Time start = absl::Now();
+  auto primitive_result = keyset_handle.GetCachedPrimitive<P>();
+  if (!primitive_result.ok()) return primitive_result.status();
+  auto warmup_result =
+      Warmup(*primitive_result.ValueOrDie(), keyset_handle.GetKeysetInfo());
+  if (!warmup_result.ok()) return warmup_result.status();
+  return absl::Now() - start;
+}
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_WARMUP_H_
@@ -28,6 +28,7 @@
 #   TINK_INCLUDE_DIRS list of global include paths.
 #   TINK_CXX_STANDARD C++ standard to enforce, 11 for now.
 #   TINK_BUILD_TESTS flag, set to false to disable tests (default false).
+#   TINK_BUILD_BENCHMARKS flag, set to true to build benchmarks (default false).
 #
 # Sensible defaults are provided for all variables, except TINK_MODULE, which is
 # defined by calls to tink_module(). Please don't alter it directly.
@@ -199,6 +200,53 @@ function(tink_cc_test)
   endif()
 endfunction(tink_cc_test)
 
+# Declare a Tink benchmark using Google Benchmark, with a syntax similar to
+# Bazel.
+#
+# Parameters:
+#   NAME base name of the benchmark.
+#   SRCS list of benchmark source files, headers included.
+#   DEPS list of dependencies, see tink_cc_library above.
+#
+# Benchmarks are only built if TINK_BUILD_BENCHMARKS is set, and are not
+# registered as tests. Each benchmark produces a build target named
+# tink_benchmark_<MODULE>_<NAME>.
+#
+function(tink_cc_benchmark)
+  cmake_parse_arguments(PARSE_ARGV 0 tink_cc_benchmark
+    ""
+    "NAME"
+    "SRCS;DEPS"
+  )
+
+  if (NOT TINK_BUILD_BENCHMARKS)
+    return()
+  endif()
+
+  if (NOT DEFINED TINK_MODULE)
+    message(FATAL_ERROR "TINK_MODULE not defined")
+  endif()
+
+  STRING(REPLACE "::" "__" _ESCAPED_TINK_MODULE ${TINK_MODULE})
+
+  set(_target_name
+      "tink_benchmark_${_ESCAPED_TINK_MODULE}_${tink_cc_benchmark_NAME}")
+
+  add_executable(${_target_name}
+    ${tink_cc_benchmark_SRCS}
+  )
+
+  target_link_libraries(${_target_name}
+    benchmark_main
+    ${tink_cc_benchmark_DEPS}
+  )
+
+  set_property(TARGET ${_target_name}
+               PROPERTY FOLDER "${TINK_IDE_FOLDER}/Benchmarks")
+  set_property(TARGET ${_target_name} PROPERTY CXX_STANDARD ${TINK_CXX_STANDARD})
+  set_property(TARGET ${_target_name} PROPERTY CXX_STANDARD_REQUIRED true)
+endfunction(tink_cc_benchmark)
+
 # Declare a C++ Proto library.
 #
 # Parameters:
@@ -44,6 +44,17 @@ http_archive(
   SHA256 a7db7d1295ce46b93f3d1a90dbbc55a48409c00d19684fcd87823037add88118
 )
 
+if (TINK_BUILD_BENCHMARKS)
+  set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "Tink dependency override" FORCE)
+  set(BENCHMARK_ENABLE_GTEST_TESTS OFF CACHE BOOL "Tink dependency override" FORCE)
+
+  http_archive(
+    NAME com_github_google_benchmark
+    URL https://github.com/google/benchmark/archive/0baacde3618ca617da95375e0af13ce1baadea47.zip
+    SHA256 62e2f2e6d8a744d67e4bbc212fcfd06647080de4253c97ad5c6749e09faf2cb0
+  )
+endif()
+
 http_archive(
   NAME com_google_absl
   URL https://github.com/abseil/abseil-cpp/archive/64461421222f8be8663c50e8e82c91c3f95a0d3c.zip
@@ -85,6 +96,10 @@ http_archive(
 add_library(rapidjson INTERFACE)
 target_include_directories(rapidjson INTERFACE "${rapidjson_SOURCE_DIR}")
 
+# zlib, for the compressing streams in cc/util. Like the zlib support of
+# protobuf, this uses the system installation.
+find_package(ZLIB REQUIRED)
+
 set(protobuf_BUILD_TESTS OFF CACHE BOOL "Tink dependency override" FORCE)
 set(protobuf_BUILD_EXAMPLES OFF CACHE BOOL "Tink dependency override" FORCE)
 
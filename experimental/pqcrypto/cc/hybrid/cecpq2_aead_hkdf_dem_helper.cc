@@ -19,14 +19,17 @@
 #include <utility>
 
 #include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
 #include "tink/aead.h"
 #include "tink/deterministic_aead.h"
-#include "tink/registry.h"
+#include "tink/subtle/aes_gcm_boringssl.h"
+#include "tink/subtle/aes_siv_boringssl.h"
+#include "tink/subtle/xchacha20_poly1305_boringssl.h"
 #include "tink/util/errors.h"
-#include "tink/util/istream_input_stream.h"
-#include "tink/util/protobuf_helper.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/statusor.h"
+#include "proto/aes_gcm.pb.h"
+#include "proto/aes_siv.pb.h"
 #include "proto/tink.pb.h"
 
 namespace crypto {
@@ -34,16 +37,34 @@ namespace tink {
 namespace {
 
 using ::crypto::tink::subtle::AeadOrDaead;
+using ::google::crypto::tink::AesGcmKeyFormat;
+using ::google::crypto::tink::AesSivKeyFormat;
 using ::google::crypto::tink::KeyTemplate;
 
-// Internal implementaton of the Cecpq2AeadHkdfDemHelper class, parametrized by
-// the Primitive used for data encapsulation (i.e Aead or DeterministicAead).
+enum DemKeyType {
+  AES_GCM_KEY,
+  XCHACHA20_POLY1305_KEY,
+  AES_SIV_KEY,
+};
+
 template <class EncryptionPrimitive>
+util::StatusOr<std::unique_ptr<AeadOrDaead>> ToAeadOrDaead(
+    util::StatusOr<std::unique_ptr<EncryptionPrimitive>> primitive_or) {
+  if (!primitive_or.ok()) return primitive_or.status();
+  return absl::make_unique<AeadOrDaead>(std::move(primitive_or.ValueOrDie()));
+}
+
+// Internal implementaton of the Cecpq2AeadHkdfDemHelper class. The key is
+// the prefix of the seed which the key manager of the DEM would derive from
+// it; the primitive is built from it directly with the subtle implementation
+// the key manager uses, without key protos, input streams and the registry.
 class Cecpq2AeadHkdfDemHelperImpl : public Cecpq2AeadHkdfDemHelper {
  public:
-  explicit Cecpq2AeadHkdfDemHelperImpl(
-      const google::crypto::tink::KeyTemplate& key_template)
-      : key_template_(key_template) {}
+  Cecpq2AeadHkdfDemHelperImpl(DemKeyType key_type, uint32_t key_size,
+                              uint32_t key_material_size)
+      : key_type_(key_type),
+        key_size_(key_size),
+        key_material_size_(key_material_size) {}
 
   crypto::tink::util::StatusOr<
       std::unique_ptr<crypto::tink::subtle::AeadOrDaead>>
@@ -53,37 +74,33 @@ class Cecpq2AeadHkdfDemHelperImpl : public Cecpq2AeadHkdfDemHelper {
                           "Seed length is smaller than 32 bytes "
                           "and thus not post-quantum secure.");
     }
-    std::string seed_str(util::SecretDataAsStringView(seed));
-    util::IstreamInputStream input_stream{
-        absl::make_unique<std::stringstream>(seed_str)};
-    auto key_or = internal::RegistryImpl::GlobalInstance().DeriveKey(
-        key_template_, &input_stream);
-    if (!key_or.ok()) return key_or.status();
-    auto key = std::move(key_or).ValueOrDie();
-    util::StatusOr<std::unique_ptr<EncryptionPrimitive>> primitive_or =
-        Registry::GetPrimitive<EncryptionPrimitive>(key);
-    if (!primitive_or.ok()) return primitive_or.status();
-    return absl::make_unique<AeadOrDaead>(std::move(primitive_or.ValueOrDie()));
+    if (seed.size() < key_size_) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "Seed is shorter than the DEM key.");
+    }
+    util::SecretData key = util::SecretDataFromStringView(
+        util::SecretDataAsStringView(seed).substr(0, key_size_));
+    switch (key_type_) {
+      case AES_GCM_KEY:
+        return ToAeadOrDaead(subtle::AesGcmBoringSsl::New(key));
+      case XCHACHA20_POLY1305_KEY:
+        return ToAeadOrDaead(
+            subtle::XChacha20Poly1305BoringSsl::New(std::move(key)));
+      case AES_SIV_KEY:
+        return ToAeadOrDaead(subtle::AesSivBoringSsl::New(key));
+    }
+    return util::Status(util::error::INTERNAL, "Unknown DEM key type.");
   }
 
   crypto::tink::util::StatusOr<uint32_t> GetKeyMaterialSize() const override {
-    absl::string_view dem_type_url = key_template_.type_url();
-    // For AES-SIV, two keys of 32 bytes each are needed
-    if (dem_type_url == "type.googleapis.com/google.crypto.tink.AesSivKey") {
-      return 64;
-    } else if (
-        dem_type_url == "type.googleapis.com/google.crypto.tink.AesGcmKey" ||
-        dem_type_url ==
-            "type.googleapis.com/google.crypto.tink.XChaCha20Poly1305Key") {
-      return 32;
-    } else {
-      return ToStatusF(util::error::INVALID_ARGUMENT,
-                       "Unsupported DEM key type '%s'.", dem_type_url);
-    }
+    return key_material_size_;
   }
 
  private:
-  const google::crypto::tink::KeyTemplate key_template_;
+  const DemKeyType key_type_;
+  // The number of bytes of the seed used as key.
+  const uint32_t key_size_;
+  const uint32_t key_material_size_;
 };
 }  // namespace
 
@@ -91,15 +108,28 @@ class Cecpq2AeadHkdfDemHelperImpl : public Cecpq2AeadHkdfDemHelper {
 util::StatusOr<std::unique_ptr<const Cecpq2AeadHkdfDemHelper>>
 Cecpq2AeadHkdfDemHelper::New(const KeyTemplate& dem_key_template) {
   const std::string& dem_type_url = dem_key_template.type_url();
-  if (dem_type_url == "type.googleapis.com/google.crypto.tink.AesGcmKey" ||
-      dem_type_url ==
-          "type.googleapis.com/google.crypto.tink.XChaCha20Poly1305Key") {
-    return {
-        absl::make_unique<Cecpq2AeadHkdfDemHelperImpl<Aead>>(dem_key_template)};
+  if (dem_type_url == "type.googleapis.com/google.crypto.tink.AesGcmKey") {
+    AesGcmKeyFormat key_format;
+    if (!key_format.ParseFromString(dem_key_template.value())) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "Invalid AesGcmKeyFormat in DEM key template");
+    }
+    return {absl::make_unique<Cecpq2AeadHkdfDemHelperImpl>(
+        AES_GCM_KEY, key_format.key_size(), 32)};
+  } else if (dem_type_url ==
+             "type.googleapis.com/google.crypto.tink.XChaCha20Poly1305Key") {
+    return {absl::make_unique<Cecpq2AeadHkdfDemHelperImpl>(
+        XCHACHA20_POLY1305_KEY, 32, 32)};
   } else if (dem_type_url ==
              "type.googleapis.com/google.crypto.tink.AesSivKey") {
-    return {absl::make_unique<Cecpq2AeadHkdfDemHelperImpl<DeterministicAead>>(
-        dem_key_template)};
+    AesSivKeyFormat key_format;
+    if (!key_format.ParseFromString(dem_key_template.value())) {
+      return util::Status(util::error::INVALID_ARGUMENT,
+                          "Invalid AesSivKeyFormat in DEM key template");
+    }
+    // For AES-SIV, two keys of 32 bytes each are needed
+    return {absl::make_unique<Cecpq2AeadHkdfDemHelperImpl>(
+        AES_SIV_KEY, key_format.key_size(), 64)};
   }
   return ToStatusF(util::error::INVALID_ARGUMENT,
                    "Unsupported DEM key type '%s'.", dem_type_url);
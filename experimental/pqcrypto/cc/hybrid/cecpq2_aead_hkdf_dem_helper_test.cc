@@ -23,6 +23,7 @@
 #include "tink/config/tink_config.h"
 #include "tink/daead/aes_siv_key_manager.h"
 #include "tink/registry.h"
+#include "tink/subtle/aes_gcm_boringssl.h"
 #include "tink/util/secret_data.h"
 #include "tink/util/test_matchers.h"
 #include "tink/util/test_util.h"
@@ -90,6 +91,32 @@ TEST(Cecpq2AeadHkdfDemHelperTest, DemHelperWithAesGcmKeyType) {
               IsOk());
 }
 
+TEST(Cecpq2AeadHkdfDemHelperTest, DemKeyIsPrefixOfSeed) {
+  google::crypto::tink::AesGcmKeyFormat key_format;
+  key_format.set_key_size(16);
+  google::crypto::tink::KeyTemplate dem_key_template;
+  dem_key_template.set_type_url(
+      "type.googleapis.com/google.crypto.tink.AesGcmKey");
+  dem_key_template.set_value(key_format.SerializeAsString());
+
+  auto dem_helper_or = Cecpq2AeadHkdfDemHelper::New(dem_key_template);
+  ASSERT_THAT(dem_helper_or.status(), IsOk());
+  std::string seed = test::HexDecodeOrDie(
+      "000102030405060708090a0b0c0d0e0f"
+      "101112131415161718191a1b1c1d1e1f");
+  auto dem_or = dem_helper_or.ValueOrDie()->GetAeadOrDaead(
+      util::SecretDataFromStringView(seed));
+  ASSERT_THAT(dem_or.status(), IsOk());
+  auto ciphertext_or = dem_or.ValueOrDie()->Encrypt("test_plaintext", "ad");
+  ASSERT_THAT(ciphertext_or.status(), IsOk());
+
+  auto aead_or = subtle::AesGcmBoringSsl::New(
+      util::SecretDataFromStringView(seed.substr(0, 16)));
+  ASSERT_THAT(aead_or.status(), IsOk());
+  EXPECT_THAT(aead_or.ValueOrDie()->Decrypt(ciphertext_or.ValueOrDie(), "ad"),
+              test::IsOkAndHolds("test_plaintext"));
+}
+
 TEST(Cecpq2AeadHkdfDemHelperTest, DemHelperWithAesSivKeyType) {
   google::crypto::tink::AesSivKeyFormat key_format;
   key_format.set_key_size(64);
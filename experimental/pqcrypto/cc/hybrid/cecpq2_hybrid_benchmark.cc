@@ -0,0 +1,133 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Compares CECPQ2 hybrid encryption with ECIES over X25519 with the same (or
+// the closest available) DEM. For small payloads the KEM dominates, so the
+// results of the smallest payload sizes show the cost of the HRSS part.
+
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "tink/benchmarks/benchmark_util.h"
+#include "tink/hybrid/hybrid_key_templates.h"
+#include "tink/hybrid_decrypt.h"
+#include "tink/hybrid_encrypt.h"
+#include "tink/util/status.h"
+#include "pqcrypto/cc/hybrid/cecpq2_hybrid_config.h"
+#include "pqcrypto/cc/hybrid/cecpq2_hybrid_key_templates.h"
+#include "proto/tink.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace benchmarks {
+namespace {
+
+using ::google::crypto::tink::KeyTemplate;
+
+constexpr char kContextInfo[] = "benchmark context info";
+
+// Registers the CECPQ2 key managers, which TinkConfig does not contain, once.
+util::Status RegisterCecpq2() {
+  static const util::Status* status =
+      new util::Status(Cecpq2HybridConfigRegister());
+  return *status;
+}
+
+void BM_HybridEncrypt(benchmark::State& state,
+                      const KeyTemplate& (*key_template)()) {
+  util::Status status = RegisterCecpq2();
+  if (!status.ok()) return SkipWithError(&state, status);
+  auto encrypter_result =
+      SharedPrimitive<HybridEncrypt>(key_template(), /*public_key=*/true);
+  if (!encrypter_result.ok()) {
+    return SkipWithError(&state, encrypter_result.status());
+  }
+  const HybridEncrypt& encrypter = *encrypter_result.ValueOrDie();
+  std::string plaintext = Payload(state.range(0));
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto ciphertext = encrypter.Encrypt(plaintext, kContextInfo);
+      if (!ciphertext.ok()) return SkipWithError(&state, ciphertext.status());
+      benchmark::DoNotOptimize(ciphertext.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, plaintext.size());
+}
+
+void BM_HybridDecrypt(benchmark::State& state,
+                      const KeyTemplate& (*key_template)()) {
+  util::Status status = RegisterCecpq2();
+  if (!status.ok()) return SkipWithError(&state, status);
+  auto encrypter_result =
+      SharedPrimitive<HybridEncrypt>(key_template(), /*public_key=*/true);
+  if (!encrypter_result.ok()) {
+    return SkipWithError(&state, encrypter_result.status());
+  }
+  auto decrypter_result = SharedPrimitive<HybridDecrypt>(key_template());
+  if (!decrypter_result.ok()) {
+    return SkipWithError(&state, decrypter_result.status());
+  }
+  const HybridDecrypt& decrypter = *decrypter_result.ValueOrDie();
+  auto ciphertext_result = encrypter_result.ValueOrDie()->Encrypt(
+      Payload(state.range(0)), kContextInfo);
+  if (!ciphertext_result.ok()) {
+    return SkipWithError(&state, ciphertext_result.status());
+  }
+  const std::string& ciphertext = ciphertext_result.ValueOrDie();
+
+  {
+    AllocationCounter allocations(&state);
+    for (auto _ : state) {
+      auto plaintext = decrypter.Decrypt(ciphertext, kContextInfo);
+      if (!plaintext.ok()) return SkipWithError(&state, plaintext.status());
+      benchmark::DoNotOptimize(plaintext.ValueOrDie());
+    }
+  }
+  SetThroughput(&state, state.range(0));
+}
+
+#define TINK_HYBRID_BENCHMARK(template_name, template_function)            \
+  BENCHMARK_CAPTURE(BM_HybridEncrypt, template_name, &template_function)   \
+      ->Apply(PayloadSizesAndThreads);                                     \
+  BENCHMARK_CAPTURE(BM_HybridDecrypt, template_name, &template_function)   \
+      ->Apply(PayloadSizesAndThreads)
+
+TINK_HYBRID_BENCHMARK(
+    Cecpq2X25519HkdfHmacSha256Aes256Gcm,
+    Cecpq2HybridKeyTemplateX25519HkdfHmacSha256Aes256Gcm);
+TINK_HYBRID_BENCHMARK(
+    EciesX25519HkdfHmacSha256Aes128Gcm,
+    HybridKeyTemplates::EciesX25519HkdfHmacSha256Aes128Gcm);
+TINK_HYBRID_BENCHMARK(
+    Cecpq2X25519HkdfHmacSha256XChaCha20Poly1305,
+    Cecpq2HybridKeyTemplateX25519HkdfHmacSha256XChaCha20Poly1305);
+TINK_HYBRID_BENCHMARK(
+    EciesX25519HkdfHmacSha256XChaCha20Poly1305,
+    HybridKeyTemplates::EciesX25519HkdfHmacSha256XChaCha20Poly1305);
+TINK_HYBRID_BENCHMARK(
+    Cecpq2X25519HkdfHmacSha256DeterministicAesSiv,
+    Cecpq2HybridKeyTemplateX25519HkdfHmacSha256DeterministicAesSiv);
+TINK_HYBRID_BENCHMARK(
+    EciesX25519HkdfHmacSha256DeterministicAesSiv,
+    HybridKeyTemplates::EciesX25519HkdfHmacSha256DeterministicAesSiv);
+
+}  // namespace
+}  // namespace benchmarks
+}  // namespace tink
+}  // namespace crypto
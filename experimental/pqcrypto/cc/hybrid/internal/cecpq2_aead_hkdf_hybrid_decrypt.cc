@@ -82,41 +82,42 @@ util::StatusOr<std::unique_ptr<HybridDecrypt>> Cecpq2AeadHkdfHybridDecrypt::New(
           private_key.public_key().params().dem_params().aead_dem());
   if (!dem_result.ok()) return dem_result.status();
 
-  return {absl::WrapUnique(new Cecpq2AeadHkdfHybridDecrypt(
-      private_key.public_key().params(), std::move(kem_result).ValueOrDie(),
-      std::move(dem_result).ValueOrDie()))};
-}
-
-util::StatusOr<std::string> Cecpq2AeadHkdfHybridDecrypt::Decrypt(
-    absl::string_view ciphertext, absl::string_view context_info) const {
+  const google::crypto::tink::Cecpq2AeadHkdfParams& params =
+      private_key.public_key().params();
   util::StatusOr<uint32_t> cecpq2_header_size_result =
       subtle::EcUtil::EncodingSizeInBytes(
-          util::Enums::ProtoToSubtle(
-              recipient_key_params_.kem_params().curve_type()),
-          util::Enums::ProtoToSubtle(
-              recipient_key_params_.kem_params().ec_point_format()));
+          util::Enums::ProtoToSubtle(params.kem_params().curve_type()),
+          util::Enums::ProtoToSubtle(params.kem_params().ec_point_format()));
   if (!cecpq2_header_size_result.ok())
     return cecpq2_header_size_result.status();
   uint32_t cecpq2_header_size =
       cecpq2_header_size_result.ValueOrDie() + HRSS_CIPHERTEXT_BYTES;
-  if (ciphertext.size() < cecpq2_header_size) {
-    return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too short");
-  }
 
   // Get the key material size based on the DEM type_url.
   util::StatusOr<uint32_t> key_material_size_or =
-      dem_helper_->GetKeyMaterialSize();
+      dem_result.ValueOrDie()->GetKeyMaterialSize();
   if (!key_material_size_or.ok()) return key_material_size_or.status();
-  uint32_t key_material_size = key_material_size_or.ValueOrDie();
+
+  return {absl::WrapUnique(new Cecpq2AeadHkdfHybridDecrypt(
+      params, std::move(kem_result).ValueOrDie(),
+      std::move(dem_result).ValueOrDie(), cecpq2_header_size,
+      key_material_size_or.ValueOrDie()))};
+}
+
+util::StatusOr<std::string> Cecpq2AeadHkdfHybridDecrypt::Decrypt(
+    absl::string_view ciphertext, absl::string_view context_info) const {
+  if (ciphertext.size() < cecpq2_header_size_) {
+    return util::Status(util::error::INVALID_ARGUMENT, "ciphertext too short");
+  }
 
   // Use KEM to get a symmetric key.
   util::StatusOr<util::SecretData> symmetric_key_result =
       recipient_kem_->GenerateKey(
-          absl::string_view(ciphertext).substr(0, cecpq2_header_size),
+          absl::string_view(ciphertext).substr(0, cecpq2_header_size_),
           util::Enums::ProtoToSubtle(
               recipient_key_params_.kem_params().hkdf_hash_type()),
           recipient_key_params_.kem_params().hkdf_salt(), context_info,
-          key_material_size,
+          key_material_size_,
           util::Enums::ProtoToSubtle(
               recipient_key_params_.kem_params().ec_point_format()));
   if (!symmetric_key_result.ok()) return symmetric_key_result.status();
@@ -131,7 +132,7 @@ util::StatusOr<std::string> Cecpq2AeadHkdfHybridDecrypt::Decrypt(
 
   // Do the actual decryption using the AEAD-primitive.
   util::StatusOr<std::string> decrypt_result = aead_or_daead->Decrypt(
-      ciphertext.substr(cecpq2_header_size), "");  // empty aad
+      ciphertext.substr(cecpq2_header_size_), "");  // empty aad
   if (!decrypt_result.ok()) return decrypt_result.status();
 
   return decrypt_result.ValueOrDie();
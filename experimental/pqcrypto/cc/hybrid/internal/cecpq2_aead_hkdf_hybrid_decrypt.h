@@ -17,6 +17,7 @@
 #ifndef THIRD_PARTY_TINK_EXPERIMENTAL_PQCRYPTO_CC_HYBRID_INTERNAL_CECPQ2_AEAD_HKDF_HYBRID_DECRYPT_H_
 #define THIRD_PARTY_TINK_EXPERIMENTAL_PQCRYPTO_CC_HYBRID_INTERNAL_CECPQ2_AEAD_HKDF_HYBRID_DECRYPT_H_
 
+#include <cstdint>
 #include <memory>
 #include <utility>
 
@@ -47,14 +48,21 @@ class Cecpq2AeadHkdfHybridDecrypt : public HybridDecrypt {
   Cecpq2AeadHkdfHybridDecrypt(
       const google::crypto::tink::Cecpq2AeadHkdfParams& recipient_key_params,
       std::unique_ptr<const subtle::Cecpq2HkdfRecipientKemBoringSsl> kem,
-      std::unique_ptr<const Cecpq2AeadHkdfDemHelper> dem_helper)
+      std::unique_ptr<const Cecpq2AeadHkdfDemHelper> dem_helper,
+      uint32_t cecpq2_header_size, uint32_t key_material_size)
       : recipient_key_params_(recipient_key_params),
         recipient_kem_(std::move(kem)),
-        dem_helper_(std::move(dem_helper)) {}
+        dem_helper_(std::move(dem_helper)),
+        cecpq2_header_size_(cecpq2_header_size),
+        key_material_size_(key_material_size) {}
 
   google::crypto::tink::Cecpq2AeadHkdfParams recipient_key_params_;
   std::unique_ptr<const subtle::Cecpq2HkdfRecipientKemBoringSsl> recipient_kem_;
   std::unique_ptr<const Cecpq2AeadHkdfDemHelper> dem_helper_;
+  // Size of the KEM part of the ciphertexts, and size of the DEM key derived
+  // from it; both only depend on the key parameters, so New() computes them.
+  const uint32_t cecpq2_header_size_;
+  const uint32_t key_material_size_;
 };
 
 }  // namespace tink
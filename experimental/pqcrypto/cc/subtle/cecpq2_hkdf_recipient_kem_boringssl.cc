@@ -67,9 +67,22 @@ Cecpq2HkdfX25519RecipientKemBoringSsl::New(
     return util::Status(util::error::INVALID_ARGUMENT,
                         "priv has unexpected length");
   }
+  if (hrss_private_key_seed.size() != HRSS_GENERATE_KEY_BYTES) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "hrss_private_key_seed has unexpected length");
+  }
+
+  // Regenerate the HRSS key pair from the seed. The public key is not needed
+  // for decapsulation.
+  util::SecretUniquePtr<struct HRSS_private_key> hrss_private_key =
+      util::MakeSecretUniquePtr<struct HRSS_private_key>();
+  struct HRSS_public_key hrss_public_key;
+  HRSS_generate_key(&hrss_public_key, hrss_private_key.get(),
+                    hrss_private_key_seed.data());
+
   // If all input parameters are ok, create a CECPQ2 Recipient KEM instance
   return {absl::WrapUnique(new Cecpq2HkdfX25519RecipientKemBoringSsl(
-      std::move(ec_private_key), std::move(hrss_private_key_seed)))};
+      std::move(ec_private_key), std::move(hrss_private_key)))};
 }
 
 crypto::tink::util::StatusOr<util::SecretData>
@@ -98,17 +111,10 @@ Cecpq2HkdfX25519RecipientKemBoringSsl::GenerateKey(
   X25519(x25519_shared_secret.data(), private_key_x25519_.data(),
          reinterpret_cast<const uint8_t*>(kem_bytes.data()));
 
-  // Regenerate HRSS key pair from seed
-  util::SecretUniquePtr<struct HRSS_private_key> hrss_private_key =
-      util::MakeSecretUniquePtr<struct HRSS_private_key>();
-  struct HRSS_public_key hrss_public_key;
-  HRSS_generate_key(&hrss_public_key, hrss_private_key.get(),
-                    private_key_hrss_seed_.data());
-
   // Recover HRSS shared secret from kem_bytes and private key
   util::SecretData hrss_shared_secret(HRSS_KEY_BYTES);
   HRSS_decap(reinterpret_cast<uint8_t*>(hrss_shared_secret.data()),
-             hrss_private_key.get(),
+             private_key_hrss_.get(),
              reinterpret_cast<const uint8_t*>(kem_bytes.data() +
                                               X25519_PUBLIC_VALUE_LEN),
              HRSS_CIPHERTEXT_BYTES);
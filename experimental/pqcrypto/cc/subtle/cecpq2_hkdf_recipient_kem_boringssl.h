@@ -110,13 +110,15 @@ class Cecpq2HkdfX25519RecipientKemBoringSsl
   // The private constructor only takes the X25519 and HRSS private keys and
   // assign them to the class private members.
   explicit Cecpq2HkdfX25519RecipientKemBoringSsl(
-      util::SecretData ec_private_key, util::SecretData hrss_private_key_seed)
+      util::SecretData ec_private_key,
+      util::SecretUniquePtr<struct HRSS_private_key> hrss_private_key)
       : private_key_x25519_(std::move(ec_private_key)),
-        private_key_hrss_seed_(std::move(hrss_private_key_seed)) {}
+        private_key_hrss_(std::move(hrss_private_key)) {}
 
-  // X25519 and HRSS private key containers
+  // X25519 and HRSS private key containers. The HRSS private key is generated
+  // from its seed once, in New(), instead of for every decapsulation.
   util::SecretData private_key_x25519_;
-  util::SecretData private_key_hrss_seed_;
+  util::SecretUniquePtr<struct HRSS_private_key> private_key_hrss_;
 };
 
 }  // namespace subtle
@@ -160,6 +160,26 @@ TEST(Cecpq2HkdfRecipientKemBoringSslTest, TestUnsupportedCurve) {
             status_or_recipient_kem.status().error_code());
 }
 
+// This test checks that an HRSS private key seed of the wrong size is
+// rejected when the KEM is created.
+TEST(Cecpq2HkdfRecipientKemBoringSslTest, TestInvalidHrssSeedSize) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+
+  util::SecretData hrss_private_key_seed =
+      util::SecretDataFromStringView(test::HexDecodeOrDie(kHrssKeyGenEntropy));
+  hrss_private_key_seed.pop_back();
+  auto status_or_recipient_kem = Cecpq2HkdfRecipientKemBoringSsl::New(
+      EllipticCurveType::CURVE25519,
+      util::SecretDataFromStringView(
+          test::HexDecodeOrDie(kCecpq2X25519PrivateKeyHex)),
+      std::move(hrss_private_key_seed));
+  EXPECT_THAT(status_or_recipient_kem.status(),
+              StatusIs(util::error::INVALID_ARGUMENT,
+                       HasSubstr("hrss_private_key_seed")));
+}
+
 // This test checks that an error is triggered if an output key lenth smaller
 // than 32 bytes is specified.
 TEST(Cecpq2HkdfRecipientKemBoringSslTest, TestNotPostQuantumSecureKeyLength) {
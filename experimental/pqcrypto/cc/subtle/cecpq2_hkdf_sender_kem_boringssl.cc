@@ -16,6 +16,8 @@
 
 #include "pqcrypto/cc/subtle/cecpq2_hkdf_sender_kem_boringssl.h"
 
+#include <utility>
+
 #include "absl/memory/memory.h"
 #include "absl/strings/str_cat.h"
 #include "openssl/bn.h"
@@ -51,12 +53,9 @@ Cecpq2HkdfSenderKemBoringSsl::New(subtle::EllipticCurveType curve,
 }
 
 Cecpq2HkdfX25519SenderKemBoringSsl::Cecpq2HkdfX25519SenderKemBoringSsl(
-    const absl::string_view peer_ec_pubx,
-    const absl::string_view marshalled_hrss_pub) {
-  peer_public_key_x25519_ =
-      reinterpret_cast<const uint8_t*>(peer_ec_pubx.data());
-  peer_marshalled_public_key_hrss_ =
-      reinterpret_cast<const uint8_t*>(marshalled_hrss_pub.data());
+    const absl::string_view peer_ec_pubx) {
+  peer_ec_pubx.copy(reinterpret_cast<char*>(peer_public_key_x25519_),
+                    X25519_PUBLIC_VALUE_LEN);
 }
 
 // static
@@ -84,10 +83,19 @@ Cecpq2HkdfX25519SenderKemBoringSsl::New(
                         "marshalled_hrss_pub has unexpected length");
   }
 
-  // If input parameters are ok, create a CECPQ2 Sender KEM instance
-  std::unique_ptr<const Cecpq2HkdfSenderKemBoringSsl> sender_kem(
-      new Cecpq2HkdfX25519SenderKemBoringSsl(pubx, marshalled_hrss_pub));
-  return std::move(sender_kem);
+  // If input parameters are ok, create a CECPQ2 Sender KEM instance and
+  // recover the internal HRSS public key representation from the marshalled
+  // version
+  std::unique_ptr<Cecpq2HkdfX25519SenderKemBoringSsl> sender_kem(
+      new Cecpq2HkdfX25519SenderKemBoringSsl(pubx));
+  if (!HRSS_parse_public_key(
+          &sender_kem->peer_public_key_hrss_,
+          reinterpret_cast<const uint8_t*>(marshalled_hrss_pub.data()))) {
+    return util::Status(util::error::INVALID_ARGUMENT,
+                        "marshalled_hrss_pub is not a valid HRSS public key");
+  }
+  return {std::unique_ptr<const Cecpq2HkdfSenderKemBoringSsl>(
+      std::move(sender_kem))};
 }
 
 util::StatusOr<std::unique_ptr<const Cecpq2HkdfSenderKemBoringSsl::KemKey>>
@@ -128,11 +136,6 @@ Cecpq2HkdfX25519SenderKemBoringSsl::GenerateKey(
   std::string hrss_kem_bytes;
   subtle::ResizeStringUninitialized(&hrss_kem_bytes, HRSS_CIPHERTEXT_BYTES);
 
-  // Recover the internal HRSS public key representation from marshalled version
-  struct HRSS_public_key peer_public_key_hrss;
-  HRSS_parse_public_key(&peer_public_key_hrss,
-                        peer_marshalled_public_key_hrss_);
-
   // Generate entropy to be used in encaps
   util::SecretData encaps_entropy =
       crypto::tink::subtle::Random::GetRandomKeyBytes(HRSS_ENCAP_BYTES);
@@ -142,18 +145,20 @@ Cecpq2HkdfX25519SenderKemBoringSsl::GenerateKey(
   HRSS_encap(const_cast<uint8_t*>(
              reinterpret_cast<const uint8_t*>(hrss_kem_bytes.data())),
              reinterpret_cast<uint8_t*>(hrss_shared_secret.data()),
-             &peer_public_key_hrss, encaps_entropy.data());
+             &peer_public_key_hrss_, encaps_entropy.data());
 
   // Concatenate the two kem_bytes
-  std::string kem_bytes(x25519_kem_bytes);
-  kem_bytes += hrss_kem_bytes;
-
-  // Concatenate the two shared secrets with the two kem_bytes
-  std::string kem_bytes_and_shared_secrets = absl::StrCat(
-      kem_bytes, util::SecretDataAsStringView(x25519_shared_secret),
-      util::SecretDataAsStringView(hrss_shared_secret));
-  util::SecretData ikm =
-      util::SecretDataFromStringView(kem_bytes_and_shared_secrets);
+  std::string kem_bytes = absl::StrCat(x25519_kem_bytes, hrss_kem_bytes);
+
+  // Concatenate the two shared secrets with the two kem_bytes, directly into
+  // the secret input keying material
+  util::SecretData ikm;
+  ikm.reserve(kem_bytes.size() + x25519_shared_secret.size() +
+              hrss_shared_secret.size());
+  ikm.insert(ikm.end(), kem_bytes.begin(), kem_bytes.end());
+  ikm.insert(ikm.end(), x25519_shared_secret.begin(),
+             x25519_shared_secret.end());
+  ikm.insert(ikm.end(), hrss_shared_secret.begin(), hrss_shared_secret.end());
 
   // Compute the symmetric key from the two shared secrets, kem_bytes, hkdf_salt
   // and hkdf_info using HKDF
@@ -162,10 +167,11 @@ Cecpq2HkdfX25519SenderKemBoringSsl::GenerateKey(
   if (!symmetric_key_or.ok()) {
     return symmetric_key_or.status();
   }
-  util::SecretData symmetric_key = symmetric_key_or.ValueOrDie();
+  util::SecretData symmetric_key = std::move(symmetric_key_or.ValueOrDie());
 
   // Return the produced pair kem_bytes and symmetric_key
-  return absl::make_unique<const KemKey>(kem_bytes, symmetric_key);
+  return absl::make_unique<const KemKey>(std::move(kem_bytes),
+                                         std::move(symmetric_key));
 }
 
 }  // namespace subtle
@@ -128,25 +128,20 @@ class Cecpq2HkdfX25519SenderKemBoringSsl : public Cecpq2HkdfSenderKemBoringSsl {
       crypto::tink::FipsCompatibility::kNotFips;
 
  private:
-  // The private constructor only takes the X25519 and HRSS public keys. The
-  // curve is not provided as a parameter here because the curve validation has
-  // already been made in the New() method defined above.
+  // The private constructor only takes the X25519 public key; the HRSS public
+  // key is parsed into 'peer_public_key_hrss_' by New(). The curve is not
+  // provided as a parameter here because the curve validation has already been
+  // made in the New() method defined above.
   explicit Cecpq2HkdfX25519SenderKemBoringSsl(
-      const absl::string_view peer_ec_pubx,
-      const absl::string_view marshalled_hrss_pub);
+      const absl::string_view peer_ec_pubx);
 
-  // X25519 and HRSS public key containers. We note that the BoringSSL
-  // implementation of HRSS requires that the HRSS public key is stored in the
-  // *marshalled* format. This is done by calling the HRSS_marshal_public_key
-  // function from BoringSSL (see the tests available in cecpq2_hkdf_sender_kem
-  // _boringssl_test.cc file that demonstrate this process). If this process is
-  // not done, the internal raw HRSS public key representation (using the struct
-  // HRSS_public_key data structure) might cause padding problems depending on
-  // the compiler options.
-  // Pointer to array of size X25519_PUBLIC_VALUE_LEN bytes
-  const uint8_t* peer_public_key_x25519_;
-  // Pointer to array of size HRSS_PUBLIC_KEY_BYTES bytes
-  const uint8_t* peer_marshalled_public_key_hrss_;
+  // X25519 and HRSS public key containers. The HRSS public key is given in the
+  // *marshalled* format produced by HRSS_marshal_public_key (see the tests
+  // available in cecpq2_hkdf_sender_kem_boringssl_test.cc file that
+  // demonstrate this process), and is parsed once when the KEM is created,
+  // so that GenerateKey() does not have to parse it for every encapsulation.
+  uint8_t peer_public_key_x25519_[X25519_PUBLIC_VALUE_LEN];
+  struct HRSS_public_key peer_public_key_hrss_;
 };
 
 }  // namespace subtle
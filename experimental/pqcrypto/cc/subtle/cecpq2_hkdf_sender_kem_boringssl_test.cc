@@ -277,6 +277,53 @@ TEST(Cecpq2HkdfSenderKemBoringSslTest, TestSenderRecipientFullFlowFailure) {
                 status_or_shared_secret.ValueOrDie())));
 }
 
+// This test checks that the KEM does not keep references to the public keys
+// it was created from, which may be destroyed right after New().
+TEST(Cecpq2HkdfSenderKemBoringSslTest, TestDoesNotReferenceInputKeys) {
+  if (kUseOnlyFips) {
+    GTEST_SKIP() << "Not supported in FIPS-only mode";
+  }
+  int out_len = 32;
+
+  auto statur_or_cecpq2_key =
+      pqc::GenerateCecpq2Keypair(EllipticCurveType::CURVE25519);
+  ASSERT_TRUE(statur_or_cecpq2_key.ok());
+  auto cecpq2_key_pair = std::move(statur_or_cecpq2_key).ValueOrDie();
+
+  std::unique_ptr<const Cecpq2HkdfSenderKemBoringSsl> sender_kem;
+  {
+    std::string pub_x = cecpq2_key_pair.x25519_key_pair.pub_x;
+    std::string hrss_pub =
+        cecpq2_key_pair.hrss_key_pair.hrss_public_key_marshaled;
+    auto status_or_sender_kem = Cecpq2HkdfSenderKemBoringSsl::New(
+        EllipticCurveType::CURVE25519, pub_x, "", hrss_pub);
+    ASSERT_TRUE(status_or_sender_kem.ok());
+    sender_kem = std::move(status_or_sender_kem.ValueOrDie());
+    // Overwrite the inputs before they are freed.
+    pub_x.assign(pub_x.size(), '\0');
+    hrss_pub.assign(hrss_pub.size(), '\0');
+  }
+
+  auto status_or_kem_key = sender_kem->GenerateKey(
+      HashType::SHA256, "salt", "info", out_len, EcPointFormat::COMPRESSED);
+  ASSERT_TRUE(status_or_kem_key.ok());
+  auto kem_key = std::move(status_or_kem_key.ValueOrDie());
+
+  auto status_or_recipient_kem = Cecpq2HkdfRecipientKemBoringSsl::New(
+      EllipticCurveType::CURVE25519, cecpq2_key_pair.x25519_key_pair.priv,
+      std::move(cecpq2_key_pair.hrss_key_pair.hrss_private_key_seed));
+  ASSERT_TRUE(status_or_recipient_kem.ok());
+  auto status_or_shared_secret =
+      status_or_recipient_kem.ValueOrDie()->GenerateKey(
+          kem_key->get_kem_bytes(), HashType::SHA256, "salt", "info", out_len,
+          EcPointFormat::COMPRESSED);
+  ASSERT_TRUE(status_or_shared_secret.ok());
+  EXPECT_EQ(test::HexEncode(
+                util::SecretDataAsStringView(kem_key->get_symmetric_key())),
+            test::HexEncode(util::SecretDataAsStringView(
+                status_or_shared_secret.ValueOrDie())));
+}
+
 }  // namespace
 }  // namespace subtle
 }  // namespace tink
@@ -0,0 +1,68 @@
+/**
+ * Copyright 2021 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ * The interface for streaming authenticated encryption with additional data. It encrypts and
+ * decrypts data of any size, e.g. large files, without holding all of it in memory: the data is
+ * read from an NSInputStream and written to an NSOutputStream piece by piece. (see
+ * https://eprint.iacr.org/2015/189.pdf)
+ *
+ * Both streams are opened if they are not already open. The output stream is closed once all data
+ * has been written; the input stream is left open. The methods block until all data is processed,
+ * so streams that are scheduled in a run loop must not be passed.
+ */
+@protocol TINKStreamingAead <NSObject>
+
+/**
+ * Encrypts the data read from @c plaintextStream with @c additionalData as additional
+ * authenticated data, and writes the resulting ciphertext to @c ciphertextStream.
+ *
+ * @param plaintextStream   The stream with the data to encrypt.
+ * @param ciphertextStream  The stream the ciphertext is written to.
+ * @param additionalData    Additional authenticated data. (optional)
+ * @return                  YES on success; NO in case of error.
+ */
+- (BOOL)encryptStream:(NSInputStream *)plaintextStream
+              toStream:(NSOutputStream *)ciphertextStream
+    withAdditionalData:(nullable NSData *)additionalData
+                 error:(NSError **)error;
+
+/**
+ * Decrypts the ciphertext read from @c ciphertextStream with @c additionalData as additional
+ * authenticated data, and writes the resulting plaintext to @c plaintextStream.
+ *
+ * Note that plaintext is written before the whole ciphertext is authenticated: if an error is
+ * returned, the data written to @c plaintextStream must be discarded.
+ *
+ * @param ciphertextStream  The stream with the data to decrypt.
+ * @param plaintextStream   The stream the plaintext is written to.
+ * @param additionalData    Additional authenticated data. (optional)
+ * @return                  YES on success; NO in case of error.
+ */
+- (BOOL)decryptStream:(NSInputStream *)ciphertextStream
+              toStream:(NSOutputStream *)plaintextStream
+    withAdditionalData:(nullable NSData *)additionalData
+                 error:(NSError **)error;
+
+@end
+
+NS_ASSUME_NONNULL_END
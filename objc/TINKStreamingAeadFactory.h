@@ -0,0 +1,69 @@
+/**
+ * Copyright 2021 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************
+ */
+
+#import <Foundation/Foundation.h>
+
+@class TINKKeysetHandle;
+@protocol TINKStreamingAead;
+
+NS_ASSUME_NONNULL_BEGIN;
+
+/**
+ * TINKStreamingAeadFactory allows for obtaining a TINKStreamingAead primitive from a
+ * TINKKeysetHandle.
+ *
+ * TINKStreamingAeadFactory gets primitives from the Registry, which can be initialized via
+ * TINKAllConfig. Here is an example how one can obtain and use a TINKStreamingAead primitive:
+ *
+ * NSError *error = nil;
+ * TINKAllConfig *config = [[TINKAllConfig alloc] initWithError:&error];
+ * if (!config || error) {
+ *   // handle error.
+ * }
+ *
+ * if (![TINKConfig registerConfig:config error:&error]) {
+ *   // handle error.
+ * }
+ *
+ * TINKKeysetHandle keysetHandle = ...;
+ * id<TINKStreamingAead> streamingAead =
+ *     [TINKStreamingAeadFactory primitiveWithKeysetHandle:keysetHandle error:&error];
+ * if (!streamingAead || error) {
+ *   // handle error.
+ * }
+ *
+ * NSInputStream *plaintextStream = [NSInputStream inputStreamWithURL:photoURL];
+ * NSOutputStream *ciphertextStream = [NSOutputStream outputStreamWithURL:uploadURL append:NO];
+ * NSData *additionalData = ...;
+ * if (![streamingAead encryptStream:plaintextStream
+ *                          toStream:ciphertextStream
+ *                withAdditionalData:additionalData
+ *                             error:&error]) {
+ *   // handle error.
+ * }
+ */
+@interface TINKStreamingAeadFactory : NSObject
+/**
+ * Returns an object that conforms to the TINKStreamingAead protocol. It uses key material from the
+ * keyset specified via @c keysetHandle.
+ */
++ (nullable id<TINKStreamingAead>)primitiveWithKeysetHandle:(TINKKeysetHandle *)keysetHandle
+                                                      error:(NSError **)error;
+@end
+
+NS_ASSUME_NONNULL_END;
@@ -0,0 +1,133 @@
+/**
+ * Copyright 2021 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************
+ */
+
+#import "objc/TINKStreamingAeadFactory.h"
+
+#import <XCTest/XCTest.h>
+
+#import "objc/TINKKeysetHandle.h"
+#import "objc/TINKStreamingAead.h"
+#import "objc/core/TINKKeysetHandle_Internal.h"
+
+#include "tink/keyset_handle.h"
+#include "tink/streamingaead/streaming_aead_config.h"
+#include "tink/streamingaead/streaming_aead_key_templates.h"
+#include "tink/util/status.h"
+#include "tink/util/test_keyset_handle.h"
+#include "proto/tink.pb.h"
+
+using crypto::tink::KeysetHandle;
+using crypto::tink::StreamingAeadConfig;
+using crypto::tink::StreamingAeadKeyTemplates;
+using crypto::tink::TestKeysetHandle;
+using google::crypto::tink::Keyset;
+
+@interface TINKStreamingAeadFactoryTest : XCTestCase
+@end
+
+@implementation TINKStreamingAeadFactoryTest
+
+- (void)setUp {
+  [super setUp];
+  XCTAssertTrue(StreamingAeadConfig::Register().ok());
+}
+
+- (TINKKeysetHandle *)newKeysetHandle {
+  auto st = KeysetHandle::GenerateNew(StreamingAeadKeyTemplates::Aes128GcmHkdf4KB());
+  XCTAssertTrue(st.ok());
+  return [[TINKKeysetHandle alloc] initWithCCKeysetHandle:std::move(st.ValueOrDie())];
+}
+
+- (NSData *)dataOfSize:(NSUInteger)size {
+  NSMutableData *data = [NSMutableData dataWithLength:size];
+  uint8_t *bytes = static_cast<uint8_t *>(data.mutableBytes);
+  for (NSUInteger i = 0; i < size; i++) {
+    bytes[i] = static_cast<uint8_t>(i * 7);
+  }
+  return data;
+}
+
+- (void)testEmptyKeyset {
+  Keyset keyset;
+  TINKKeysetHandle *handle =
+      [[TINKKeysetHandle alloc] initWithCCKeysetHandle:TestKeysetHandle::GetKeysetHandle(keyset)];
+  XCTAssertNotNil(handle);
+
+  NSError *error = nil;
+  id<TINKStreamingAead> streamingAead =
+      [TINKStreamingAeadFactory primitiveWithKeysetHandle:handle error:&error];
+  XCTAssertNil(streamingAead);
+  XCTAssertNotNil(error);
+  XCTAssertTrue(error.code == crypto::tink::util::error::INVALID_ARGUMENT);
+}
+
+- (void)testEncryptDecrypt {
+  NSError *error = nil;
+  id<TINKStreamingAead> streamingAead =
+      [TINKStreamingAeadFactory primitiveWithKeysetHandle:[self newKeysetHandle] error:&error];
+  XCTAssertNotNil(streamingAead);
+  XCTAssertNil(error);
+
+  NSData *aad = [@"some_aad" dataUsingEncoding:NSUTF8StringEncoding];
+  for (NSNumber *size in @[ @0, @10, @4096, @(1024 * 1024 + 17) ]) {
+    NSData *plaintext = [self dataOfSize:size.unsignedIntegerValue];
+
+    NSOutputStream *ciphertextStream = [NSOutputStream outputStreamToMemory];
+    XCTAssertTrue([streamingAead encryptStream:[NSInputStream inputStreamWithData:plaintext]
+                                      toStream:ciphertextStream
+                            withAdditionalData:aad
+                                         error:&error]);
+    XCTAssertNil(error);
+    NSData *ciphertext = [ciphertextStream propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
+    XCTAssertGreaterThan(ciphertext.length, plaintext.length);
+
+    NSOutputStream *plaintextStream = [NSOutputStream outputStreamToMemory];
+    XCTAssertTrue([streamingAead decryptStream:[NSInputStream inputStreamWithData:ciphertext]
+                                      toStream:plaintextStream
+                            withAdditionalData:aad
+                                         error:&error]);
+    XCTAssertNil(error);
+    NSData *decrypted = [plaintextStream propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
+    XCTAssertTrue([plaintext isEqualToData:decrypted]);
+  }
+}
+
+- (void)testDecryptWithWrongAdditionalData {
+  NSError *error = nil;
+  id<TINKStreamingAead> streamingAead =
+      [TINKStreamingAeadFactory primitiveWithKeysetHandle:[self newKeysetHandle] error:&error];
+  XCTAssertNotNil(streamingAead);
+
+  NSData *plaintext = [self dataOfSize:10000];
+  NSData *aad = [@"some_aad" dataUsingEncoding:NSUTF8StringEncoding];
+  NSOutputStream *ciphertextStream = [NSOutputStream outputStreamToMemory];
+  XCTAssertTrue([streamingAead encryptStream:[NSInputStream inputStreamWithData:plaintext]
+                                    toStream:ciphertextStream
+                          withAdditionalData:aad
+                                       error:&error]);
+  NSData *ciphertext = [ciphertextStream propertyForKey:NSStreamDataWrittenToMemoryStreamKey];
+
+  NSData *otherAad = [@"other_aad" dataUsingEncoding:NSUTF8StringEncoding];
+  XCTAssertFalse([streamingAead decryptStream:[NSInputStream inputStreamWithData:ciphertext]
+                                     toStream:[NSOutputStream outputStreamToMemory]
+                           withAdditionalData:otherAad
+                                        error:&error]);
+  XCTAssertNotNil(error);
+}
+
+@end
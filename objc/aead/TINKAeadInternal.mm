@@ -60,7 +60,7 @@
     return nil;
   }
 
-  return TINKStringToNSData(st.ValueOrDie());
+  return TINKStringToNSData(std::move(st.ValueOrDie()));
 }
 
 - (NSData *)decrypt:(NSData *)ciphertext
@@ -82,7 +82,7 @@
     return nil;
   }
 
-  return TINKStringToNSData(st.ValueOrDie());
+  return TINKStringToNSData(std::move(st.ValueOrDie()));
 }
 
 - (nullable crypto::tink::Aead *)ccAead {
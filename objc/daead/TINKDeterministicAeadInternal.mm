@@ -65,7 +65,7 @@
     return nil;
   }
 
-  return TINKStringToNSData(st.ValueOrDie());
+  return TINKStringToNSData(std::move(st.ValueOrDie()));
 }
 
 - (NSData *)decryptDeterministically:(NSData *)ciphertext
@@ -87,7 +87,7 @@
     return nil;
   }
 
-  return TINKStringToNSData(st.ValueOrDie());
+  return TINKStringToNSData(std::move(st.ValueOrDie()));
 }
 
 - (nullable crypto::tink::DeterministicAead *)ccDeterministicAead {
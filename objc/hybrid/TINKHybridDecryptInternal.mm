@@ -59,7 +59,7 @@
     return nil;
   }
 
-  return TINKStringToNSData(st.ValueOrDie());
+  return TINKStringToNSData(std::move(st.ValueOrDie()));
 }
 
 - (nullable crypto::tink::HybridDecrypt *)ccHybridDecrypt {
@@ -51,7 +51,7 @@
     return nil;
   }
 
-  return TINKStringToNSData(st.ValueOrDie());
+  return TINKStringToNSData(std::move(st.ValueOrDie()));
 }
 
 - (crypto::tink::PublicKeySign *)ccPublicKeySign {
@@ -0,0 +1,281 @@
+/**
+ * Copyright 2021 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ **************************************************************************
+ */
+
+#import "objc/streamingaead/TINKStreamingAeadInternal.h"
+
+#import <Foundation/Foundation.h>
+
+#import "objc/TINKStreamingAead.h"
+#import "objc/util/TINKErrors.h"
+#import "objc/util/TINKStrings.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
+#include "tink/input_stream.h"
+#include "tink/output_stream.h"
+#include "tink/streaming_aead.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+
+namespace {
+
+using crypto::tink::util::Status;
+using crypto::tink::util::StatusOr;
+
+// Size of the buffers through which data is read from and written to the Objective-C streams.
+constexpr int kBufferSize = 128 * 1024;
+
+Status StreamErrorToStatus(NSStream *stream, const char *operation) {
+  std::string message = std::string(operation) + " failed";
+  if (stream.streamError) {
+    message += ": ";
+    message += stream.streamError.localizedDescription.UTF8String;
+  }
+  return Status(crypto::tink::util::error::INTERNAL, message);
+}
+
+void OpenIfNeeded(NSStream *stream) {
+  if (stream.streamStatus == NSStreamStatusNotOpen) {
+    [stream open];
+  }
+}
+
+// An InputStream that reads from an NSInputStream.
+class NSInputStreamAdapter : public crypto::tink::InputStream {
+ public:
+  explicit NSInputStreamAdapter(NSInputStream *stream) : stream_(stream), buffer_(kBufferSize) {}
+
+  StatusOr<int> Next(const void **data) override {
+    if (!status_.ok()) return status_;
+    if (count_backedup_ > 0) {
+      *data = buffer_.data() + count_in_buffer_ - count_backedup_;
+      int count = count_backedup_;
+      position_ += count;
+      count_backedup_ = 0;
+      return count;
+    }
+    NSInteger count = [stream_ read:buffer_.data() maxLength:buffer_.size()];
+    if (count < 0) {
+      status_ = StreamErrorToStatus(stream_, "Reading");
+      return status_;
+    }
+    if (count == 0) {
+      status_ = Status(crypto::tink::util::error::OUT_OF_RANGE, "EOF");
+      return status_;
+    }
+    count_in_buffer_ = static_cast<int>(count);
+    position_ += count_in_buffer_;
+    *data = buffer_.data();
+    return count_in_buffer_;
+  }
+
+  void BackUp(int count) override {
+    if (!status_.ok() || count <= 0) return;
+    count = std::min(count, count_in_buffer_ - count_backedup_);
+    count_backedup_ += count;
+    position_ -= count;
+  }
+
+  int64_t Position() const override { return position_; }
+
+ private:
+  NSInputStream *stream_;
+  std::vector<uint8_t> buffer_;
+  Status status_;
+  int count_in_buffer_ = 0;
+  int count_backedup_ = 0;
+  int64_t position_ = 0;
+};
+
+// An OutputStream that writes to an NSOutputStream, which is closed by Close().
+class NSOutputStreamAdapter : public crypto::tink::OutputStream {
+ public:
+  explicit NSOutputStreamAdapter(NSOutputStream *stream) : stream_(stream), buffer_(kBufferSize) {}
+
+  ~NSOutputStreamAdapter() override { Close().IgnoreError(); }
+
+  StatusOr<int> Next(void **data) override {
+    if (!status_.ok()) return status_;
+    status_ = WriteBuffer();
+    if (!status_.ok()) return status_;
+    count_in_buffer_ = static_cast<int>(buffer_.size());
+    position_ += count_in_buffer_;
+    *data = buffer_.data();
+    return count_in_buffer_;
+  }
+
+  void BackUp(int count) override {
+    if (!status_.ok() || count <= 0) return;
+    count = std::min(count, count_in_buffer_);
+    count_in_buffer_ -= count;
+    position_ -= count;
+  }
+
+  Status Close() override {
+    if (!status_.ok()) return status_;
+    Status status = WriteBuffer();
+    [stream_ close];
+    status_ = Status(crypto::tink::util::error::FAILED_PRECONDITION, "Stream closed");
+    return status;
+  }
+
+  int64_t Position() const override { return position_; }
+
+ private:
+  // Writes the count_in_buffer_ bytes at the start of buffer_ to stream_.
+  Status WriteBuffer() {
+    int written = 0;
+    while (written < count_in_buffer_) {
+      NSInteger count = [stream_ write:buffer_.data() + written
+                             maxLength:count_in_buffer_ - written];
+      if (count <= 0) {
+        return StreamErrorToStatus(stream_, "Writing");
+      }
+      written += static_cast<int>(count);
+    }
+    count_in_buffer_ = 0;
+    return crypto::tink::util::OkStatus();
+  }
+
+  NSOutputStream *stream_;
+  std::vector<uint8_t> buffer_;
+  Status status_;
+  int count_in_buffer_ = 0;
+  int64_t position_ = 0;
+};
+
+// Copies all data from 'input' to 'output', and closes 'output'.
+Status CopyStream(crypto::tink::InputStream *input, crypto::tink::OutputStream *output) {
+  const void *in_data;
+  void *out_data;
+  int out_available = 0;
+  while (true) {
+    auto next_in = input->Next(&in_data);
+    if (next_in.status().error_code() == crypto::tink::util::error::OUT_OF_RANGE) break;
+    if (!next_in.ok()) return next_in.status();
+    absl::string_view remaining(static_cast<const char *>(in_data), next_in.ValueOrDie());
+    while (!remaining.empty()) {
+      if (out_available == 0) {
+        auto next_out = output->Next(&out_data);
+        if (!next_out.ok()) return next_out.status();
+        out_available = next_out.ValueOrDie();
+      }
+      int count = std::min<int>(out_available, remaining.size());
+      memcpy(out_data, remaining.data(), count);
+      out_data = static_cast<char *>(out_data) + count;
+      out_available -= count;
+      remaining.remove_prefix(count);
+    }
+  }
+  output->BackUp(out_available);
+  return output->Close();
+}
+
+absl::string_view NSDataToStringView(NSData *data) {
+  if (!data || data.length == 0) {
+    return absl::string_view();
+  }
+  return absl::string_view(static_cast<const char *>(data.bytes), data.length);
+}
+
+}  // namespace
+
+@implementation TINKStreamingAeadInternal {
+  std::unique_ptr<crypto::tink::StreamingAead> _ccStreamingAead;
+}
+
+- (instancetype)initWithCCStreamingAead:
+    (std::unique_ptr<crypto::tink::StreamingAead>)ccStreamingAead {
+  self = [super init];
+  if (self) {
+    _ccStreamingAead = std::move(ccStreamingAead);
+  }
+  return self;
+}
+
+- (void)dealloc {
+  _ccStreamingAead.reset();
+}
+
+- (BOOL)encryptStream:(NSInputStream *)plaintextStream
+              toStream:(NSOutputStream *)ciphertextStream
+    withAdditionalData:(NSData *)additionalData
+                 error:(NSError **)error {
+  OpenIfNeeded(plaintextStream);
+  OpenIfNeeded(ciphertextStream);
+  auto st = _ccStreamingAead->NewEncryptingStream(
+      absl::make_unique<NSOutputStreamAdapter>(ciphertextStream),
+      NSDataToStringView(additionalData));
+  if (!st.ok()) {
+    if (error) {
+      *error = TINKStatusToError(st.status());
+    }
+    return NO;
+  }
+  NSInputStreamAdapter plaintext(plaintextStream);
+  Status status = CopyStream(&plaintext, st.ValueOrDie().get());
+  if (!status.ok()) {
+    if (error) {
+      *error = TINKStatusToError(status);
+    }
+    return NO;
+  }
+  return YES;
+}
+
+- (BOOL)decryptStream:(NSInputStream *)ciphertextStream
+              toStream:(NSOutputStream *)plaintextStream
+    withAdditionalData:(NSData *)additionalData
+                 error:(NSError **)error {
+  OpenIfNeeded(ciphertextStream);
+  OpenIfNeeded(plaintextStream);
+  auto st = _ccStreamingAead->NewDecryptingStream(
+      absl::make_unique<NSInputStreamAdapter>(ciphertextStream),
+      NSDataToStringView(additionalData));
+  if (!st.ok()) {
+    if (error) {
+      *error = TINKStatusToError(st.status());
+    }
+    return NO;
+  }
+  NSOutputStreamAdapter plaintext(plaintextStream);
+  Status status = CopyStream(st.ValueOrDie().get(), &plaintext);
+  if (!status.ok()) {
+    if (error) {
+      *error = TINKStatusToError(status);
+    }
+    return NO;
+  }
+  return YES;
+}
+
+- (nullable crypto::tink::StreamingAead *)ccStreamingAead {
+  if (!_ccStreamingAead) {
+    return nil;
+  }
+  return _ccStreamingAead.get();
+}
+
+@end
@@ -26,7 +26,10 @@ NSString* TINKStringPieceToNSString(absl::string_view s);
 /** Converts a C++ std::string to NSString. */
 NSString* TINKStringToNSString(std::string s);
 
-/** Converts a C++ std::string to NSData. */
+/**
+ * Converts a C++ std::string to NSData. The NSData takes over the buffer of @c s instead of copying
+ * it, so callers should move strings they no longer need into this function.
+ */
 NSData* TINKStringToNSData(std::string s);
 
 /** Converts a absl::string_view to NSData. */
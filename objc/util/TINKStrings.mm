@@ -22,6 +22,9 @@
 
 #import "objc/util/TINKErrors.h"
 
+#include <string>
+#include <utility>
+
 #include "absl/strings/string_view.h"
 
 NSString* TINKStringPieceToNSString(absl::string_view s) {
@@ -33,7 +36,17 @@ NSString* TINKStringToNSString(std::string s) {
 }
 
 NSData* TINKStringToNSData(std::string s) {
-  return [NSData dataWithBytes:s.data() length:s.size()];
+  if (s.empty()) {
+    return [NSData data];
+  }
+  // The string is moved to the heap and deleted when the NSData is deallocated, so that a large
+  // result (e.g. a ciphertext) is not held twice in memory.
+  std::string* owned = new std::string(std::move(s));
+  return [[NSData alloc] initWithBytesNoCopy:&(*owned)[0]
+                                      length:owned->size()
+                                 deallocator:^(void* bytes, NSUInteger length) {
+                                   delete owned;
+                                 }];
 }
 
 NSData* TINKStringViewToNSData(absl::string_view s) {
@@ -20,6 +20,8 @@ from __future__ import division
 from __future__ import print_function
 
 import abc
+import asyncio
+from typing import List, Sequence
 
 # Special imports
 import six
@@ -68,3 +70,87 @@ class Aead(object):
       tink.TinkError if the decryption fails.
     """
     raise NotImplementedError()
+
+  def encrypt_batch(self,
+                    plaintexts: Sequence[bytes],
+                    associated_data: Sequence[bytes],
+                    num_threads: int = 1) -> List[bytes]:
+    """Encrypts each plaintext with the matching associated_data element.
+
+    Implementations backed by C++ process the whole batch in one call with the
+    GIL released. This default implementation calls encrypt() for each
+    element.
+
+    Args:
+      plaintexts: A sequence of bytes-like objects to be encrypted.
+      associated_data: A sequence of bytes-like objects of the same length.
+      num_threads: The number of threads the batch may be split over.
+    Returns:
+      The list of ciphertexts, in the order of plaintexts.
+    Raises:
+      tink.TinkError if any of the encryptions fails.
+    """
+    del num_threads  # Unused.
+    if len(plaintexts) != len(associated_data):
+      raise ValueError(
+          'plaintexts and associated_data must have the same length')
+    return [self.encrypt(p, a) for p, a in zip(plaintexts, associated_data)]
+
+  def decrypt_batch(self,
+                    ciphertexts: Sequence[bytes],
+                    associated_data: Sequence[bytes],
+                    num_threads: int = 1) -> List[bytes]:
+    """Decrypts each ciphertext with the matching associated_data element.
+
+    Args:
+      ciphertexts: A sequence of bytes-like objects to be decrypted.
+      associated_data: A sequence of bytes-like objects of the same length.
+      num_threads: The number of threads the batch may be split over.
+    Returns:
+      The list of plaintexts, in the order of ciphertexts.
+    Raises:
+      tink.TinkError if any of the decryptions fails.
+    """
+    del num_threads  # Unused.
+    if len(ciphertexts) != len(associated_data):
+      raise ValueError(
+          'ciphertexts and associated_data must have the same length')
+    return [self.decrypt(c, a) for c, a in zip(ciphertexts, associated_data)]
+
+  async def encrypt_async(self, plaintext: bytes,
+                          associated_data: bytes) -> bytes:
+    """Encrypts plaintext with associated_data without blocking the loop.
+
+    Implementations backed by a C++ AsyncAead, such as the KMS AEADs, complete
+    the result from the C++ callback. This default implementation runs
+    encrypt() in the default executor of the running event loop.
+
+    Args:
+      plaintext: bytes. The data to be encrypted.
+      associated_data: bytes. The associated data, that will be authenticated.
+    Returns:
+      the resulting ciphertext as bytes.
+    Raises:
+      tink.TinkError if the encryption fails.
+    """
+    loop = asyncio.get_running_loop()
+    return await loop.run_in_executor(None, self.encrypt, plaintext,
+                                      associated_data)
+
+  async def decrypt_async(self, ciphertext: bytes,
+                          associated_data: bytes) -> bytes:
+    """Decrypts ciphertext with associated_data without blocking the loop.
+
+    See encrypt_async().
+
+    Args:
+      ciphertext: bytes. The data to be decrypted.
+      associated_data: bytes. The associated data.
+    Returns:
+      the resulting plaintext as bytes.
+    Raises:
+      tink.TinkError if the decryption fails.
+    """
+    loop = asyncio.get_running_loop()
+    return await loop.run_in_executor(None, self.decrypt, ciphertext,
+                                      associated_data)
@@ -19,6 +19,9 @@ from __future__ import division
 # Placeholder for import for type annotations
 from __future__ import print_function
 
+import asyncio
+from typing import Callable, List, Sequence
+
 from tink import core
 from tink.aead import _aead
 from tink.aead import _aead_wrapper
@@ -39,6 +42,81 @@ class AeadCcToPyWrapper(_aead.Aead):
   def decrypt(self, plaintext: bytes, associated_data: bytes) -> bytes:
     return self._aead.decrypt(plaintext, associated_data)
 
+  def encrypt_batch(self,
+                    plaintexts: Sequence[bytes],
+                    associated_data: Sequence[bytes],
+                    num_threads: int = 1) -> List[bytes]:
+    if len(plaintexts) != len(associated_data):
+      raise ValueError(
+          'plaintexts and associated_data must have the same length')
+    return self._encrypt_batch(plaintexts, associated_data, num_threads)
+
+  def decrypt_batch(self,
+                    ciphertexts: Sequence[bytes],
+                    associated_data: Sequence[bytes],
+                    num_threads: int = 1) -> List[bytes]:
+    if len(ciphertexts) != len(associated_data):
+      raise ValueError(
+          'ciphertexts and associated_data must have the same length')
+    return self._decrypt_batch(ciphertexts, associated_data, num_threads)
+
+  @core.use_tink_errors
+  def _encrypt_batch(self, plaintexts, associated_data, num_threads):
+    return self._aead.encrypt_batch(plaintexts, associated_data, num_threads)
+
+  @core.use_tink_errors
+  def _decrypt_batch(self, ciphertexts, associated_data, num_threads):
+    return self._aead.decrypt_batch(ciphertexts, associated_data, num_threads)
+
+  async def encrypt_async(self, plaintext: bytes,
+                          associated_data: bytes) -> bytes:
+    if not self._aead.supports_async():
+      return await super(AeadCcToPyWrapper,
+                         self).encrypt_async(plaintext, associated_data)
+    return await _await_cc_call(
+        lambda done: self._aead.encrypt_async(plaintext, associated_data, done))
+
+  async def decrypt_async(self, ciphertext: bytes,
+                          associated_data: bytes) -> bytes:
+    if not self._aead.supports_async():
+      return await super(AeadCcToPyWrapper,
+                         self).decrypt_async(ciphertext, associated_data)
+    return await _await_cc_call(
+        lambda done: self._aead.decrypt_async(ciphertext, associated_data, done))
+
+
+async def _await_cc_call(start: Callable[[Callable[..., None]], None]) -> bytes:
+  """Awaits an asynchronous C++ call which 'start' starts with a callback.
+
+  The callback may run on any thread, so it hands the result over to the
+  event loop, and the loop is not blocked while the call is pending.
+
+  Args:
+    start: Starts the call, with the callback as its argument.
+  Returns:
+    The result of the call.
+  Raises:
+    tink.TinkError if the call fails.
+  """
+  loop = asyncio.get_running_loop()
+  future = loop.create_future()
+
+  def complete(result, error_code, error_message):
+    if future.done():  # Cancelled meanwhile.
+      return
+    if result is None:
+      future.set_exception(
+          core.TinkError('{} (error code {})'.format(error_message,
+                                                     error_code)))
+    else:
+      future.set_result(result)
+
+  def done(result, error_code, error_message):
+    loop.call_soon_threadsafe(complete, result, error_code, error_message)
+
+  core.use_tink_errors(start)(done)
+  return await future
+
 
 def register() -> None:
   """Registers all AEAD key managers and AEAD wrapper in the Registry."""
@@ -19,7 +19,7 @@ from __future__ import division
 # Placeholder for import for type annotations
 from __future__ import print_function
 
-from typing import Type
+from typing import List, Optional, Sequence, Type
 from absl import logging
 
 from tink import core
@@ -39,7 +39,7 @@ class _WrappedAead(_aead.Aead):
 
   def decrypt(self, ciphertext: bytes, associated_data: bytes) -> bytes:
     if len(ciphertext) > core.crypto_format.NON_RAW_PREFIX_SIZE:
-      prefix = ciphertext[:core.crypto_format.NON_RAW_PREFIX_SIZE]
+      prefix = bytes(ciphertext[:core.crypto_format.NON_RAW_PREFIX_SIZE])
       ciphertext_no_prefix = ciphertext[core.crypto_format.NON_RAW_PREFIX_SIZE:]
       for entry in self._primitive_set.primitive_from_identifier(prefix):
         try:
@@ -57,6 +57,77 @@ class _WrappedAead(_aead.Aead):
     # nothing works.
     raise core.TinkError('Decryption failed.')
 
+  async def encrypt_async(self, plaintext: bytes,
+                          associated_data: bytes) -> bytes:
+    primary = self._primitive_set.primary()
+    return primary.identifier + await primary.primitive.encrypt_async(
+        plaintext, associated_data)
+
+  async def decrypt_async(self, ciphertext: bytes,
+                          associated_data: bytes) -> bytes:
+    if len(ciphertext) > core.crypto_format.NON_RAW_PREFIX_SIZE:
+      prefix = bytes(ciphertext[:core.crypto_format.NON_RAW_PREFIX_SIZE])
+      ciphertext_no_prefix = ciphertext[core.crypto_format.NON_RAW_PREFIX_SIZE:]
+      for entry in self._primitive_set.primitive_from_identifier(prefix):
+        try:
+          return await entry.primitive.decrypt_async(ciphertext_no_prefix,
+                                                     associated_data)
+        except core.TinkError as e:
+          logging.info(
+              'ciphertext prefix matches a key, but cannot decrypt: %s', e)
+    # Let's try all RAW keys.
+    for entry in self._primitive_set.raw_primitives():
+      try:
+        return await entry.primitive.decrypt_async(ciphertext, associated_data)
+      except core.TinkError as e:
+        pass
+    # nothing works.
+    raise core.TinkError('Decryption failed.')
+
+  def encrypt_batch(self,
+                    plaintexts: Sequence[bytes],
+                    associated_data: Sequence[bytes],
+                    num_threads: int = 1) -> List[bytes]:
+    primary = self._primitive_set.primary()
+    ciphertexts = primary.primitive.encrypt_batch(plaintexts, associated_data,
+                                                  num_threads)
+    if not primary.identifier:
+      return ciphertexts
+    return [primary.identifier + c for c in ciphertexts]
+
+  def decrypt_batch(self,
+                    ciphertexts: Sequence[bytes],
+                    associated_data: Sequence[bytes],
+                    num_threads: int = 1) -> List[bytes]:
+    if len(ciphertexts) != len(associated_data):
+      raise ValueError(
+          'ciphertexts and associated_data must have the same length')
+    # Fast path: all ciphertexts were made with the primary key, as is the
+    # case for data encrypted since the last key rotation.
+    primary = self._primitive_set.primary()
+    stripped = _strip_prefixes(ciphertexts, primary.identifier)
+    if stripped is not None:
+      try:
+        return primary.primitive.decrypt_batch(stripped, associated_data,
+                                               num_threads)
+      except core.TinkError as e:
+        logging.info('batch does not decrypt with the primary key: %s', e)
+    return [self.decrypt(c, a) for c, a in zip(ciphertexts, associated_data)]
+
+
+def _strip_prefixes(ciphertexts: Sequence[bytes],
+                    prefix: bytes) -> Optional[List[bytes]]:
+  """Removes prefix from all ciphertexts, or returns None if one lacks it."""
+  if not prefix:
+    return list(ciphertexts)
+  n = len(prefix)
+  stripped = []
+  for c in ciphertexts:
+    if len(c) <= n or bytes(c[:n]) != prefix:
+      return None
+    stripped.append(c[n:])
+  return stripped
+
 
 class AeadWrapper(core.PrimitiveWrapper[_aead.Aead, _aead.Aead]):
   """AeadWrapper is the implementation of PrimitiveWrapper for Aead.
@@ -19,6 +19,8 @@ from __future__ import division
 # Placeholder for import for type annotations
 from __future__ import print_function
 
+import asyncio
+
 from absl.testing import absltest
 from absl.testing import parameterized
 import tink
@@ -44,6 +46,16 @@ class AeadWrapperTest(parameterized.TestCase):
     self.assertEqual(primitive.decrypt(ciphertext, b'associated_data'),
                      b'plaintext')
 
+  @parameterized.parameters([AEAD_TEMPLATE, RAW_AEAD_TEMPLATE])
+  def test_encrypt_decrypt_buffers(self, template):
+    keyset_handle = tink.new_keyset_handle(template)
+    primitive = keyset_handle.primitive(aead.Aead)
+    ciphertext = primitive.encrypt(
+        bytearray(b'plaintext'), memoryview(b'associated_data'))
+    plaintext = primitive.decrypt(
+        memoryview(ciphertext), bytearray(b'associated_data'))
+    self.assertEqual(plaintext, b'plaintext')
+
   @parameterized.parameters([AEAD_TEMPLATE, RAW_AEAD_TEMPLATE])
   def test_decrypt_unknown_ciphertext_fails(self, template):
     unknown_handle = tink.new_keyset_handle(template)
@@ -66,6 +78,53 @@ class AeadWrapperTest(parameterized.TestCase):
     with self.assertRaises(tink.TinkError):
       primitive.decrypt(ciphertext, b'wrong_associated_data')
 
+  @parameterized.parameters([AEAD_TEMPLATE, RAW_AEAD_TEMPLATE])
+  def test_encrypt_decrypt_async(self, template):
+    keyset_handle = tink.new_keyset_handle(template)
+    primitive = keyset_handle.primitive(aead.Aead)
+
+    async def encrypt_decrypt():
+      ciphertext = await primitive.encrypt_async(b'plaintext',
+                                                 b'associated_data')
+      self.assertEqual(primitive.decrypt(ciphertext, b'associated_data'),
+                       b'plaintext')
+      with self.assertRaises(tink.TinkError):
+        await primitive.decrypt_async(ciphertext, b'wrong_associated_data')
+      return await primitive.decrypt_async(ciphertext, b'associated_data')
+
+    self.assertEqual(asyncio.run(encrypt_decrypt()), b'plaintext')
+
+  @parameterized.parameters([(AEAD_TEMPLATE, 1), (RAW_AEAD_TEMPLATE, 1),
+                             (AEAD_TEMPLATE, 3)])
+  def test_encrypt_decrypt_batch(self, template, num_threads):
+    keyset_handle = tink.new_keyset_handle(template)
+    primitive = keyset_handle.primitive(aead.Aead)
+    plaintexts = [b'plaintext %d' % i for i in range(10)]
+    ads = [b'ad %d' % i for i in range(10)]
+    ciphertexts = primitive.encrypt_batch(plaintexts, ads, num_threads)
+    self.assertLen(ciphertexts, 10)
+    for ciphertext, plaintext, ad in zip(ciphertexts, plaintexts, ads):
+      self.assertEqual(primitive.decrypt(ciphertext, ad), plaintext)
+    self.assertEqual(
+        primitive.decrypt_batch(ciphertexts, ads, num_threads), plaintexts)
+    with self.assertRaises(tink.TinkError):
+      primitive.decrypt_batch(ciphertexts, ads[::-1], num_threads)
+    with self.assertRaises(ValueError):
+      primitive.encrypt_batch(plaintexts, ads[1:], num_threads)
+
+  def test_decrypt_batch_after_key_rotation(self):
+    builder = keyset_builder.new_keyset_builder()
+    older_key_id = builder.add_new_key(AEAD_TEMPLATE)
+    builder.set_primary_key(older_key_id)
+    p1 = builder.keyset_handle().primitive(aead.Aead)
+    newer_key_id = builder.add_new_key(AEAD_TEMPLATE)
+    builder.set_primary_key(newer_key_id)
+    p2 = builder.keyset_handle().primitive(aead.Aead)
+
+    ciphertexts = [p1.encrypt(b'old', b'ad'), p2.encrypt(b'new', b'ad')]
+    self.assertEqual(
+        p2.decrypt_batch(ciphertexts, [b'ad', b'ad']), [b'old', b'new'])
+
   @parameterized.parameters([(AEAD_TEMPLATE, AEAD_TEMPLATE),
                              (RAW_AEAD_TEMPLATE, AEAD_TEMPLATE),
                              (AEAD_TEMPLATE, RAW_AEAD_TEMPLATE),
@@ -19,6 +19,7 @@ from __future__ import division
 from __future__ import print_function
 
 import struct
+from typing import Tuple
 
 from tink.proto import tink_pb2
 from tink import core
@@ -59,11 +60,39 @@ class KmsEnvelopeAead(_aead.Aead):
     # Wrap DEK key values with remote
     encrypted_dek = self.remote_aead.encrypt(dek.value, b'')
 
+    return self._envelope_ciphertext(encrypted_dek, ciphertext)
+
+  def decrypt(self, ciphertext: bytes, associated_data: bytes) -> bytes:
+    encrypted_dek_bytes, ct_bytes = self._split_ciphertext(ciphertext)
+
+    # Decrypt DEK with remote AEAD
+    dek_bytes = self.remote_aead.decrypt(encrypted_dek_bytes, b'')
+
+    return self._dek_aead(dek_bytes).decrypt(ct_bytes, associated_data)
+
+  async def encrypt_async(self, plaintext: bytes,
+                          associated_data: bytes) -> bytes:
+    # Only the remote AEAD waits on I/O; the payload is encrypted locally.
+    dek = core.Registry.new_key_data(self.key_template)
+    dek_aead = core.Registry.primitive(dek, _aead.Aead)
+    ciphertext = dek_aead.encrypt(plaintext, associated_data)
+    encrypted_dek = await self.remote_aead.encrypt_async(dek.value, b'')
+    return self._envelope_ciphertext(encrypted_dek, ciphertext)
+
+  async def decrypt_async(self, ciphertext: bytes,
+                          associated_data: bytes) -> bytes:
+    encrypted_dek_bytes, ct_bytes = self._split_ciphertext(ciphertext)
+    dek_bytes = await self.remote_aead.decrypt_async(encrypted_dek_bytes, b'')
+    return self._dek_aead(dek_bytes).decrypt(ct_bytes, associated_data)
+
+  def _envelope_ciphertext(self, encrypted_dek: bytes,
+                           ciphertext: bytes) -> bytes:
     # Construct ciphertext, DEK length encoded as big endian
     enc_dek_len = struct.pack('>I', len(encrypted_dek))
     return enc_dek_len + encrypted_dek + ciphertext
 
-  def decrypt(self, ciphertext: bytes, associated_data: bytes) -> bytes:
+  def _split_ciphertext(self, ciphertext: bytes) -> Tuple[bytes, bytes]:
+    """Returns the encrypted DEK and the payload of ciphertext."""
     ct_len = len(ciphertext)
 
     # Recover DEK length
@@ -76,19 +105,16 @@ class KmsEnvelopeAead(_aead.Aead):
     if dek_len > (ct_len - self.DEK_LEN_BYTES) or dek_len < 0:
       raise core.TinkError
 
-    # Decrypt DEK with remote AEAD
     encrypted_dek_bytes = ciphertext[self.DEK_LEN_BYTES:self.DEK_LEN_BYTES +
                                      dek_len]
-    dek_bytes = self.remote_aead.decrypt(encrypted_dek_bytes, b'')
+    # Extract ciphertext payload
+    ct_bytes = ciphertext[self.DEK_LEN_BYTES + dek_len:]
+    return encrypted_dek_bytes, ct_bytes
 
+  def _dek_aead(self, dek_bytes: bytes) -> _aead.Aead:
     # Get AEAD primitive based on DEK
     dek = tink_pb2.KeyData()
     dek.type_url = self.key_template.type_url
     dek.value = dek_bytes
     dek.key_material_type = tink_pb2.KeyData.SYMMETRIC
-    dek_aead = core.Registry.primitive(dek, _aead.Aead)
-
-    # Extract ciphertext payload and decrypt
-    ct_bytes = ciphertext[self.DEK_LEN_BYTES + dek_len:]
-
-    return dek_aead.decrypt(ct_bytes, associated_data)
+    return core.Registry.primitive(dek, _aead.Aead)
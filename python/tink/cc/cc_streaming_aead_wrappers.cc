@@ -16,8 +16,11 @@
 
 #include "tink/cc/cc_streaming_aead_wrappers.h"
 
+#include "absl/memory/memory.h"
 #include "tink/input_stream.h"
 #include "tink/output_stream.h"
+#include "tink/util/file_input_stream.h"
+#include "tink/util/file_output_stream.h"
 
 namespace crypto {
 namespace tink {
@@ -58,5 +61,28 @@ util::StatusOr<std::unique_ptr<InputStreamAdapter>> NewCcDecryptingStream(
   return absl::make_unique<InputStreamAdapter>(std::move(result.ValueOrDie()));
 }
 
+util::StatusOr<std::unique_ptr<OutputStreamAdapter>> NewCcEncryptingStreamToFd(
+    StreamingAead* streaming_aead, absl::string_view aad,
+    int ciphertext_destination_fd) {
+  auto result = streaming_aead->NewEncryptingStream(
+      absl::make_unique<util::FileOutputStream>(ciphertext_destination_fd),
+      aad);
+  if (!result.ok()) {
+    return result.status();
+  }
+  return absl::make_unique<OutputStreamAdapter>(std::move(result.ValueOrDie()));
+}
+
+util::StatusOr<std::unique_ptr<InputStreamAdapter>> NewCcDecryptingStreamFromFd(
+    StreamingAead* streaming_aead, absl::string_view aad,
+    int ciphertext_source_fd) {
+  auto result = streaming_aead->NewDecryptingStream(
+      absl::make_unique<util::FileInputStream>(ciphertext_source_fd), aad);
+  if (!result.ok()) {
+    return result.status();
+  }
+  return absl::make_unique<InputStreamAdapter>(std::move(result.ValueOrDie()));
+}
+
 }  // namespace tink
 }  // namespace crypto
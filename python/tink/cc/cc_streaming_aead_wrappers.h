@@ -53,6 +53,21 @@ util::StatusOr<std::unique_ptr<InputStreamAdapter>> NewCcDecryptingStream(
     StreamingAead* streaming_aead, const absl::string_view aad,
     std::shared_ptr<PythonFileObjectAdapter> ciphertext_source);
 
+// Like NewCcEncryptingStream, but writes the ciphertext directly to the file
+// descriptor 'ciphertext_destination_fd' through a FileOutputStream, without
+// going through Python. The stream takes ownership of the descriptor and
+// closes it when the returned stream is closed.
+util::StatusOr<std::unique_ptr<OutputStreamAdapter>> NewCcEncryptingStreamToFd(
+    StreamingAead* streaming_aead, const absl::string_view aad,
+    int ciphertext_destination_fd);
+
+// Like NewCcDecryptingStream, but reads the ciphertext directly from the file
+// descriptor 'ciphertext_source_fd' through a FileInputStream, starting at
+// its current offset. The stream takes ownership of the descriptor.
+util::StatusOr<std::unique_ptr<InputStreamAdapter>> NewCcDecryptingStreamFromFd(
+    StreamingAead* streaming_aead, const absl::string_view aad,
+    int ciphertext_source_fd);
+
 }  // namespace tink
 }  // namespace crypto
 
@@ -16,6 +16,10 @@
 
 #include "tink/cc/cc_streaming_aead_wrappers.h"
 
+#include <unistd.h>
+
+#include <string>
+
 #include "gtest/gtest.h"
 #include "tink/cc/test_util.h"
 
@@ -47,6 +51,36 @@ TEST(CcStreamingAeadWrappersTest, BasicNewCcDecryptingStream) {
   EXPECT_TRUE(result.status().ok());
 }
 
+TEST(CcStreamingAeadWrappersTest, EncryptDecryptWithFileDescriptors) {
+  DummyStreamingAead dummy_saead = DummyStreamingAead("Some streaming AEAD");
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+
+  auto enc_result =
+      NewCcEncryptingStreamToFd(&dummy_saead, "associated data", fds[1]);
+  ASSERT_TRUE(enc_result.status().ok());
+  auto& encrypting_stream = enc_result.ValueOrDie();
+  auto write_result = encrypting_stream->Write("some plaintext");
+  ASSERT_TRUE(write_result.ok());
+  EXPECT_EQ(write_result.ValueOrDie(), 14);
+  ASSERT_TRUE(encrypting_stream->Close().ok());
+
+  auto dec_result =
+      NewCcDecryptingStreamFromFd(&dummy_saead, "associated data", fds[0]);
+  ASSERT_TRUE(dec_result.status().ok());
+  auto& decrypting_stream = dec_result.ValueOrDie();
+  std::string plaintext;
+  while (true) {
+    auto read_result = decrypting_stream->Read(-1);
+    if (!read_result.ok()) {
+      EXPECT_EQ(read_result.status().error_code(), util::error::OUT_OF_RANGE);
+      break;
+    }
+    plaintext += read_result.ValueOrDie();
+  }
+  EXPECT_EQ(plaintext, "some plaintext");
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
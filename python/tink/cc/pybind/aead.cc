@@ -16,12 +16,54 @@
 
 #include "tink/aead.h"
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "pybind11/pybind11.h"
+#include "tink/async_aead.h"
 #include "tink/util/statusor.h"
+#include "tink/cc/pybind/batch.h"
+#include "tink/cc/pybind/buffer_view.h"
 #include "tink/cc/pybind/status_casters.h"
 
 namespace crypto {
 namespace tink {
+namespace {
+
+// Returns a callback for AsyncAead which calls the Python callable 'done'
+// with (result, error code, error message): the result as bytes and 0 and ""
+// on success, and None, the code and the message of the status otherwise.
+// The callback may run on any thread; it takes the GIL to call 'done'.
+AsyncAead::Callback ToAsyncCallback(pybind11::function done) {
+  namespace py = pybind11;
+  // The callback, and with it 'done', may be destroyed on any thread, but
+  // Python objects may only be released with the GIL held.
+  std::shared_ptr<py::object> callable(
+      new py::object(std::move(done)), [](py::object* callable) {
+        py::gil_scoped_acquire gil;
+        delete callable;
+      });
+  return [callable](util::StatusOr<std::string> result) {
+    py::gil_scoped_acquire gil;
+    try {
+      if (result.ok()) {
+        (*callable)(py::bytes(result.ValueOrDie()), 0, "");
+      } else {
+        (*callable)(py::none(),
+                    static_cast<int>(result.status().CanonicalCode()),
+                    result.status().error_message());
+      }
+    } catch (py::error_already_set& e) {
+      // There is no caller to raise the exception to.
+      e.restore();
+      PyErr_WriteUnraisable(callable->ptr());
+    }
+  };
+}
+
+}  // namespace
 
 void PybindRegisterAead(pybind11::module* module) {
   namespace py = pybind11;
@@ -38,11 +80,13 @@ void PybindRegisterAead(pybind11::module* module) {
 
       .def(
           "encrypt",
-          [](const Aead& self, const py::bytes& plaintext,
-             const py::bytes& associated_data) -> util::StatusOr<py::bytes> {
-            // TODO(b/145925674)
-            return self.Encrypt(std::string(plaintext),
-                                std::string(associated_data));
+          [](const Aead& self, const py::buffer& plaintext,
+             const py::buffer& associated_data) -> util::StatusOr<py::bytes> {
+            BufferView pt(plaintext);
+            BufferView ad(associated_data);
+            return ToPyBytes(CallWithoutGil([&]() {
+              return self.Encrypt(pt.view(), ad.view());
+            }));
           },
           py::arg("plaintext"), py::arg("associated_data"),
           "Encrypts 'plaintext' with 'associated_data' as associated data, "
@@ -51,18 +95,144 @@ void PybindRegisterAead(pybind11::module* module) {
           "of the associated data, but does not guarantee its secrecy.")
       .def(
           "decrypt",
-          [](const Aead& self, const py::bytes& ciphertext,
-             const py::bytes& associated_data) -> util::StatusOr<py::bytes> {
-            // TODO(b/145925674)
-            return self.Decrypt(std::string(ciphertext),
-                                std::string(associated_data));
+          [](const Aead& self, const py::buffer& ciphertext,
+             const py::buffer& associated_data) -> util::StatusOr<py::bytes> {
+            BufferView ct(ciphertext);
+            BufferView ad(associated_data);
+            return ToPyBytes(CallWithoutGil([&]() {
+              return self.Decrypt(ct.view(), ad.view());
+            }));
           },
           py::arg("ciphertext"), py::arg("associated_data"),
           "Decrypts 'ciphertext' with 'associated_data' as associated data, "
           "and returns the resulting plaintext. "
           "The decryption verifies the authenticity and integrity "
           "of the associated data, but there are no guarantees wrt. secrecy "
-          "of that data.");
+          "of that data.")
+      .def(
+          "encrypt_batch",
+          [](const Aead& self, const py::sequence& plaintexts,
+             const py::sequence& associated_data,
+             int num_threads) -> util::StatusOr<py::list> {
+            BufferViewSequence pts(plaintexts);
+            BufferViewSequence ads(associated_data);
+            if (pts.views().size() != ads.views().size()) {
+              return util::Status(
+                  util::error::INVALID_ARGUMENT,
+                  "plaintexts and associated_data must have the same size");
+            }
+            std::string ciphertexts;
+            std::vector<int64_t> offsets;
+            util::Status status = CallWithoutGil([&]() {
+              return RunBatch(
+                  pts.views().size(), num_threads,
+                  [&](size_t begin, size_t end, std::string* values,
+                      std::vector<int64_t>* value_offsets) {
+                    return self.EncryptBatch(
+                        pts.views().subspan(begin, end - begin),
+                        ads.views().subspan(begin, end - begin), values,
+                        value_offsets);
+                  },
+                  &ciphertexts, &offsets);
+            });
+            if (!status.ok()) return status;
+            return ToPyBytesList(ciphertexts, offsets);
+          },
+          py::arg("plaintexts"), py::arg("associated_data"),
+          py::arg("num_threads") = 1,
+          "Encrypts each of 'plaintexts' with the corresponding element of "
+          "'associated_data', and returns the list of ciphertexts. The batch "
+          "is processed with the GIL released, split over 'num_threads' "
+          "threads.")
+      .def(
+          "decrypt_batch",
+          [](const Aead& self, const py::sequence& ciphertexts,
+             const py::sequence& associated_data,
+             int num_threads) -> util::StatusOr<py::list> {
+            BufferViewSequence cts(ciphertexts);
+            BufferViewSequence ads(associated_data);
+            if (cts.views().size() != ads.views().size()) {
+              return util::Status(
+                  util::error::INVALID_ARGUMENT,
+                  "ciphertexts and associated_data must have the same size");
+            }
+            std::string plaintexts;
+            std::vector<int64_t> offsets;
+            util::Status status = CallWithoutGil([&]() {
+              return RunBatch(
+                  cts.views().size(), num_threads,
+                  [&](size_t begin, size_t end, std::string* values,
+                      std::vector<int64_t>* value_offsets) {
+                    return self.DecryptBatch(
+                        cts.views().subspan(begin, end - begin),
+                        ads.views().subspan(begin, end - begin), values,
+                        value_offsets);
+                  },
+                  &plaintexts, &offsets);
+            });
+            if (!status.ok()) return status;
+            return ToPyBytesList(plaintexts, offsets);
+          },
+          py::arg("ciphertexts"), py::arg("associated_data"),
+          py::arg("num_threads") = 1,
+          "Decrypts each of 'ciphertexts' with the corresponding element of "
+          "'associated_data', and returns the list of plaintexts. Fails if "
+          "any of the ciphertexts does not decrypt.")
+      .def(
+          "supports_async",
+          [](const Aead& self) {
+            return dynamic_cast<const AsyncAead*>(&self) != nullptr;
+          },
+          "Returns True if the primitive implements the C++ AsyncAead "
+          "interface, i.e. encrypt_async() and decrypt_async() do not wait "
+          "for the result, e.g. of a remote KMS.")
+      .def(
+          "encrypt_async",
+          [](const Aead& self, const py::buffer& plaintext,
+             const py::buffer& associated_data,
+             py::function done) -> util::Status {
+            auto* async_aead = dynamic_cast<const AsyncAead*>(&self);
+            if (async_aead == nullptr) {
+              return util::Status(util::error::UNIMPLEMENTED,
+                                  "The primitive does not support AsyncAead");
+            }
+            BufferView pt(plaintext);
+            BufferView ad(associated_data);
+            AsyncAead::Callback callback = ToAsyncCallback(std::move(done));
+            CallWithoutGil([&]() {
+              async_aead->EncryptAsync(pt.view(), ad.view(),
+                                       std::move(callback));
+            });
+            return util::OkStatus();
+          },
+          py::arg("plaintext"), py::arg("associated_data"), py::arg("done"),
+          "Starts encrypting 'plaintext' with 'associated_data' as associated "
+          "data, and returns without waiting for the result. 'done' is called "
+          "exactly once with (ciphertext, 0, '') or (None, error code, error "
+          "message), possibly on another thread. Pending operations must "
+          "complete before the interpreter exits.")
+      .def(
+          "decrypt_async",
+          [](const Aead& self, const py::buffer& ciphertext,
+             const py::buffer& associated_data,
+             py::function done) -> util::Status {
+            auto* async_aead = dynamic_cast<const AsyncAead*>(&self);
+            if (async_aead == nullptr) {
+              return util::Status(util::error::UNIMPLEMENTED,
+                                  "The primitive does not support AsyncAead");
+            }
+            BufferView ct(ciphertext);
+            BufferView ad(associated_data);
+            AsyncAead::Callback callback = ToAsyncCallback(std::move(done));
+            CallWithoutGil([&]() {
+              async_aead->DecryptAsync(ct.view(), ad.view(),
+                                       std::move(callback));
+            });
+            return util::OkStatus();
+          },
+          py::arg("ciphertext"), py::arg("associated_data"), py::arg("done"),
+          "Starts decrypting 'ciphertext' with 'associated_data' as associated "
+          "data, like encrypt_async().");
 }
 
 }  // namespace tink
@@ -0,0 +1,123 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_PYTHON_TINK_CC_PYBIND_BATCH_H_
+#define TINK_PYTHON_TINK_CC_PYBIND_BATCH_H_
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "pybind11/pybind11.h"
+#include "tink/util/status.h"
+#include "tink/cc/pybind/buffer_view.h"
+
+namespace crypto {
+namespace tink {
+
+// Views on the elements of a Python sequence of buffer-protocol objects, such
+// as a list of bytes or a numpy object array. Must be constructed and
+// destroyed with the GIL held; the views may be used without it.
+class BufferViewSequence {
+ public:
+  explicit BufferViewSequence(const pybind11::sequence& sequence) {
+    views_.reserve(sequence.size());
+    for (pybind11::handle item : sequence) {
+      buffers_.emplace_back(item.cast<pybind11::buffer>());
+      views_.push_back(buffers_.back().view());
+    }
+  }
+
+  BufferViewSequence(const BufferViewSequence&) = delete;
+  BufferViewSequence& operator=(const BufferViewSequence&) = delete;
+
+  absl::Span<const absl::string_view> views() const { return views_; }
+
+ private:
+  std::deque<BufferView> buffers_;
+  std::vector<absl::string_view> views_;
+};
+
+// A batch operation on the input elements [begin, end), which stores its
+// results back to back in 'values' and their boundaries in 'offsets', i.e. in
+// the layout used by the batch methods of the primitives.
+using BatchFunction =
+    std::function<util::Status(size_t begin, size_t end, std::string* values,
+                               std::vector<int64_t>* offsets)>;
+
+// Runs 'f' on 'size' input elements, which are split into up to
+// 'num_threads' contiguous chunks processed concurrently, and concatenates
+// the results. Fails if any of the chunks fails. Should be called without the
+// GIL.
+inline util::Status RunBatch(size_t size, int num_threads,
+                             const BatchFunction& f, std::string* values,
+                             std::vector<int64_t>* offsets) {
+  size_t num_chunks = std::min<size_t>(std::max(num_threads, 1),
+                                       std::max<size_t>(size, 1));
+  if (num_chunks == 1) return f(0, size, values, offsets);
+
+  size_t chunk_size = (size + num_chunks - 1) / num_chunks;
+  std::vector<std::string> chunk_values(num_chunks);
+  std::vector<std::vector<int64_t>> chunk_offsets(num_chunks);
+  std::vector<util::Status> statuses(num_chunks);
+  auto run_chunk = [&](size_t i) {
+    size_t begin = std::min(size, i * chunk_size);
+    size_t end = std::min(size, begin + chunk_size);
+    statuses[i] = f(begin, end, &chunk_values[i], &chunk_offsets[i]);
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(num_chunks - 1);
+  for (size_t i = 1; i < num_chunks; i++) {
+    threads.emplace_back(run_chunk, i);
+  }
+  run_chunk(0);
+  for (std::thread& thread : threads) thread.join();
+
+  values->clear();
+  offsets->assign(1, 0);
+  offsets->reserve(size + 1);
+  for (size_t i = 0; i < num_chunks; i++) {
+    if (!statuses[i].ok()) return statuses[i];
+    int64_t base = values->size();
+    values->append(chunk_values[i]);
+    for (size_t j = 1; j < chunk_offsets[i].size(); j++) {
+      offsets->push_back(base + chunk_offsets[i][j]);
+    }
+  }
+  return util::OkStatus();
+}
+
+// Returns the elements of 'values' delimited by 'offsets' as a list of Python
+// bytes. Must be called with the GIL held.
+inline pybind11::list ToPyBytesList(const std::string& values,
+                                    const std::vector<int64_t>& offsets) {
+  pybind11::list result;
+  for (size_t i = 0; i + 1 < offsets.size(); i++) {
+    result.append(pybind11::bytes(values.data() + offsets[i],
+                                  offsets[i + 1] - offsets[i]));
+  }
+  return result;
+}
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_PYTHON_TINK_CC_PYBIND_BATCH_H_
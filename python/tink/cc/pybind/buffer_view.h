@@ -0,0 +1,81 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TINK_PYTHON_TINK_CC_PYBIND_BUFFER_VIEW_H_
+#define TINK_PYTHON_TINK_CC_PYBIND_BUFFER_VIEW_H_
+
+#include <string>
+#include <utility>
+
+#include "absl/strings/string_view.h"
+#include "pybind11/pybind11.h"
+#include "tink/util/statusor.h"
+
+namespace crypto {
+namespace tink {
+
+// Read-only view on a Python object which supports the buffer protocol,
+// such as bytes, bytearray or memoryview. The bindings use it to pass data
+// to the C++ primitives without copying it.
+//
+// The view stays valid while the BufferView exists, also after the GIL has
+// been released. Concurrently modifying a mutable buffer (e.g. a bytearray)
+// from another Python thread is not prevented, in the same way as for any
+// other C extension which reads a buffer without holding the GIL.
+class BufferView {
+ public:
+  // Must be called with the GIL held. Throws pybind11::error_already_set if
+  // 'buffer' does not expose a contiguous buffer.
+  explicit BufferView(const pybind11::buffer& buffer) {
+    if (PyObject_GetBuffer(buffer.ptr(), &view_, PyBUF_SIMPLE) != 0) {
+      throw pybind11::error_already_set();
+    }
+  }
+
+  BufferView(const BufferView&) = delete;
+  BufferView& operator=(const BufferView&) = delete;
+
+  // Must be called with the GIL held.
+  ~BufferView() { PyBuffer_Release(&view_); }
+
+  absl::string_view view() const {
+    return absl::string_view(static_cast<const char*>(view_.buf),
+                             static_cast<size_t>(view_.len));
+  }
+
+ private:
+  Py_buffer view_;
+};
+
+// Runs 'f' with the GIL released. 'f' must not touch any Python object.
+template <typename F>
+auto CallWithoutGil(F f) -> decltype(f()) {
+  pybind11::gil_scoped_release release;
+  return f();
+}
+
+// Converts the result of a primitive to Python bytes. Must be called with
+// the GIL held.
+inline util::StatusOr<pybind11::bytes> ToPyBytes(
+    const util::StatusOr<std::string>& result) {
+  if (!result.ok()) return result.status();
+  return pybind11::bytes(result.ValueOrDie());
+}
+
+}  // namespace tink
+}  // namespace crypto
+
+#endif  // TINK_PYTHON_TINK_CC_PYBIND_BUFFER_VIEW_H_
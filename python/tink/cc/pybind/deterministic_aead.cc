@@ -16,8 +16,13 @@
 
 #include "tink/deterministic_aead.h"
 
+#include <string>
+#include <vector>
+
 #include "pybind11/pybind11.h"
 #include "tink/util/statusor.h"
+#include "tink/cc/pybind/batch.h"
+#include "tink/cc/pybind/buffer_view.h"
 #include "tink/cc/pybind/status_casters.h"
 
 namespace crypto {
@@ -51,22 +56,76 @@ void PybindRegisterDeterministicAead(pybind11::module* module) {
 
       .def(
           "encrypt_deterministically",
-          [](const DeterministicAead& self, const py::bytes& plaintext,
-             const py::bytes& associated_data) -> util::StatusOr<py::bytes> {
-            // TODO(b/145925674)
-            return self.EncryptDeterministically(std::string(plaintext),
-                                                 std::string(associated_data));
+          [](const DeterministicAead& self, const py::buffer& plaintext,
+             const py::buffer& associated_data) -> util::StatusOr<py::bytes> {
+            BufferView pt(plaintext);
+            BufferView ad(associated_data);
+            return ToPyBytes(CallWithoutGil([&]() {
+              return self.EncryptDeterministically(pt.view(), ad.view());
+            }));
           },
           py::arg("plaintext"), py::arg("associated_data"))
       .def(
           "decrypt_deterministically",
-          [](const DeterministicAead& self, const py::bytes& ciphertext,
-             const py::bytes& associated_data) -> util::StatusOr<py::bytes> {
-            // TODO(b/145925674)
-            return self.DecryptDeterministically(std::string(ciphertext),
-                                                 std::string(associated_data));
+          [](const DeterministicAead& self, const py::buffer& ciphertext,
+             const py::buffer& associated_data) -> util::StatusOr<py::bytes> {
+            BufferView ct(ciphertext);
+            BufferView ad(associated_data);
+            return ToPyBytes(CallWithoutGil([&]() {
+              return self.DecryptDeterministically(ct.view(), ad.view());
+            }));
+          },
+          py::arg("ciphertext"), py::arg("associated_data"))
+      .def(
+          "encrypt_deterministically_batch",
+          [](const DeterministicAead& self, const py::sequence& plaintexts,
+             const py::buffer& associated_data,
+             int num_threads) -> util::StatusOr<py::list> {
+            BufferViewSequence pts(plaintexts);
+            BufferView ad(associated_data);
+            std::string ciphertexts;
+            std::vector<int64_t> offsets;
+            util::Status status = CallWithoutGil([&]() {
+              return RunBatch(
+                  pts.views().size(), num_threads,
+                  [&](size_t begin, size_t end, std::string* values,
+                      std::vector<int64_t>* value_offsets) {
+                    return self.EncryptDeterministicallyBatch(
+                        pts.views().subspan(begin, end - begin), ad.view(),
+                        values, value_offsets);
+                  },
+                  &ciphertexts, &offsets);
+            });
+            if (!status.ok()) return status;
+            return ToPyBytesList(ciphertexts, offsets);
+          },
+          py::arg("plaintexts"), py::arg("associated_data"),
+          py::arg("num_threads") = 1)
+      .def(
+          "decrypt_deterministically_batch",
+          [](const DeterministicAead& self, const py::sequence& ciphertexts,
+             const py::buffer& associated_data,
+             int num_threads) -> util::StatusOr<py::list> {
+            BufferViewSequence cts(ciphertexts);
+            BufferView ad(associated_data);
+            std::string plaintexts;
+            std::vector<int64_t> offsets;
+            util::Status status = CallWithoutGil([&]() {
+              return RunBatch(
+                  cts.views().size(), num_threads,
+                  [&](size_t begin, size_t end, std::string* values,
+                      std::vector<int64_t>* value_offsets) {
+                    return self.DecryptDeterministicallyBatch(
+                        cts.views().subspan(begin, end - begin), ad.view(),
+                        values, value_offsets);
+                  },
+                  &plaintexts, &offsets);
+            });
+            if (!status.ok()) return status;
+            return ToPyBytesList(plaintexts, offsets);
           },
-          py::arg("ciphertext"), py::arg("associated_data"));
+          py::arg("ciphertexts"), py::arg("associated_data"),
+          py::arg("num_threads") = 1);
 }
 
 }  // namespace tink
@@ -18,6 +18,7 @@
 
 #include "pybind11/pybind11.h"
 #include "tink/util/statusor.h"
+#include "tink/cc/pybind/buffer_view.h"
 #include "tink/cc/pybind/status_casters.h"
 
 namespace crypto {
@@ -32,11 +33,13 @@ void PybindRegisterHybridDecrypt(pybind11::module* module) {
   py::class_<HybridDecrypt>(m, "HybridDecrypt")
       .def(
           "decrypt",
-          [](const HybridDecrypt& self, const py::bytes& ciphertext,
-             const py::bytes& context_info) -> util::StatusOr<py::bytes> {
-            // TODO(b/145925674)
-            return self.Decrypt(std::string(ciphertext),
-                                std::string(context_info));
+          [](const HybridDecrypt& self, const py::buffer& ciphertext,
+             const py::buffer& context_info) -> util::StatusOr<py::bytes> {
+            BufferView ct(ciphertext);
+            BufferView info(context_info);
+            return ToPyBytes(CallWithoutGil([&]() {
+              return self.Decrypt(ct.view(), info.view());
+            }));
           },
           py::arg("ciphertext"), py::arg("context_info"));
 }
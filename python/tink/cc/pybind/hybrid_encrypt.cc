@@ -18,6 +18,7 @@
 
 #include "pybind11/pybind11.h"
 #include "tink/util/statusor.h"
+#include "tink/cc/pybind/buffer_view.h"
 #include "tink/cc/pybind/status_casters.h"
 
 namespace crypto {
@@ -31,11 +32,13 @@ void PybindRegisterHybridEncrypt(pybind11::module* module) {
   py::class_<HybridEncrypt>(m, "HybridEncrypt")
       .def(
           "encrypt",
-          [](const HybridEncrypt& self, const py::bytes& plaintext,
-             const py::bytes& context_info) -> util::StatusOr<py::bytes> {
-            // TODO(b/145925674)
-            return self.Encrypt(std::string(plaintext),
-                                std::string(context_info));
+          [](const HybridEncrypt& self, const py::buffer& plaintext,
+             const py::buffer& context_info) -> util::StatusOr<py::bytes> {
+            BufferView pt(plaintext);
+            BufferView info(context_info);
+            return ToPyBytes(CallWithoutGil([&]() {
+              return self.Encrypt(pt.view(), info.view());
+            }));
           },
           py::arg("plaintext"), py::arg("context_info"));
 }
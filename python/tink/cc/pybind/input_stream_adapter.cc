@@ -17,6 +17,7 @@
 #include "tink/cc/input_stream_adapter.h"
 
 #include "pybind11/pybind11.h"
+#include "tink/cc/pybind/buffer_view.h"
 #include "tink/cc/pybind/status_casters.h"
 
 namespace crypto {
@@ -28,11 +29,16 @@ void PybindRegisterInputStreamAdapter(pybind11::module* module) {
 
 
   // TODO(b/146492561): Reduce the number of complicated lambdas.
+  // The GIL is released while decrypting; reading the ciphertext from a
+  // Python file object reacquires it (see python_file_object_adapter.cc).
   py::class_<InputStreamAdapter>(m, "InputStreamAdapter")
       .def(
           "read",
-          [](InputStreamAdapter *self, int64_t size)
-              -> util::StatusOr<py::bytes> { return self->Read(size); },
+          [](InputStreamAdapter *self,
+             int64_t size) -> util::StatusOr<py::bytes> {
+            return ToPyBytes(
+                CallWithoutGil([&]() { return self->Read(size); }));
+          },
           py::arg("size"));
 }
 
@@ -16,8 +16,13 @@
 
 #include "tink/mac.h"
 
+#include <string>
+#include <vector>
+
 #include "pybind11/pybind11.h"
 #include "tink/util/status.h"
+#include "tink/cc/pybind/batch.h"
+#include "tink/cc/pybind/buffer_view.h"
 #include "tink/cc/pybind/status_casters.h"
 
 namespace crypto {
@@ -39,24 +44,53 @@ void PybindRegisterMac(pybind11::module* module) {
       .def(
           "compute_mac",
           [](const Mac& self,
-             const py::bytes& data) -> util::StatusOr<py::bytes> {
-            // TODO(b/145925674)
-            return self.ComputeMac(std::string(data));
+             const py::buffer& data) -> util::StatusOr<py::bytes> {
+            BufferView data_view(data);
+            return ToPyBytes(CallWithoutGil(
+                [&]() { return self.ComputeMac(data_view.view()); }));
           },
           py::arg("data"),
           "Computes and returns the message authentication code (MAC) for "
           "'data'.")
       .def(
           "verify_mac",
-          [](const Mac& self, const py::bytes& mac,
-             const py::bytes& data) -> util::Status {
-            // TODO(b/145925674)
-            return self.VerifyMac(std::string(mac), std::string(data));
+          [](const Mac& self, const py::buffer& mac,
+             const py::buffer& data) -> util::Status {
+            BufferView mac_view(mac);
+            BufferView data_view(data);
+            return CallWithoutGil([&]() {
+              return self.VerifyMac(mac_view.view(), data_view.view());
+            });
           },
           py::arg("mac"), py::arg("data"),
           "Verifies if 'mac' is a correct authentication code (MAC) for "
           "'data'. "
-          "Raises a StatusNotOk exception if the verification fails.");
+          "Raises a StatusNotOk exception if the verification fails.")
+      .def(
+          "compute_mac_batch",
+          [](const Mac& self, const py::sequence& data,
+             int num_threads) -> util::StatusOr<py::list> {
+            BufferViewSequence messages(data);
+            std::string macs;
+            std::vector<int64_t> offsets;
+            util::Status status = CallWithoutGil([&]() {
+              return RunBatch(
+                  messages.views().size(), num_threads,
+                  [&](size_t begin, size_t end, std::string* values,
+                      std::vector<int64_t>* value_offsets) {
+                    return self.ComputeMacBatch(
+                        messages.views().subspan(begin, end - begin), values,
+                        value_offsets);
+                  },
+                  &macs, &offsets);
+            });
+            if (!status.ok()) return status;
+            return ToPyBytesList(macs, offsets);
+          },
+          py::arg("data"), py::arg("num_threads") = 1,
+          "Computes the MACs for each of 'data', and returns them as a list. "
+          "The batch is processed with the GIL released, split over "
+          "'num_threads' threads.");
 }
 
 }  // namespace tink
@@ -17,6 +17,7 @@
 #include "tink/cc/output_stream_adapter.h"
 
 #include "pybind11/pybind11.h"
+#include "tink/cc/pybind/buffer_view.h"
 #include "tink/cc/pybind/status_casters.h"
 
 namespace crypto {
@@ -27,15 +28,20 @@ void PybindRegisterOutputStreamAdapter(pybind11::module* module) {
   py::module& m = *module;
 
   // TODO(b/146492561): Reduce the number of complicated lambdas.
+  // The GIL is released while encrypting; writing the ciphertext to a Python
+  // file object reacquires it (see python_file_object_adapter.cc).
   py::class_<OutputStreamAdapter>(m, "OutputStreamAdapter")
       .def(
           "write",
           [](OutputStreamAdapter* self,
-             const py::bytes& data) -> util::StatusOr<int64_t> {
-            return self->Write(std::string(data));
+             const py::buffer& data) -> util::StatusOr<int64_t> {
+            BufferView data_view(data);
+            return CallWithoutGil(
+                [&]() { return self->Write(data_view.view()); });
           },
           py::arg("data"))
-      .def("close", &OutputStreamAdapter::Close);
+      .def("close", &OutputStreamAdapter::Close,
+           py::call_guard<py::gil_scoped_release>());
 }
 
 }  // namespace tink
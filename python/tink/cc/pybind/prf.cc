@@ -16,9 +16,14 @@
 
 #include "tink/cc/pybind/prf.h"
 
+#include <string>
+#include <vector>
+
 #include "pybind11/pybind11.h"
 #include "tink/prf/prf_set.h"
 #include "tink/util/statusor.h"
+#include "tink/cc/pybind/batch.h"
+#include "tink/cc/pybind/buffer_view.h"
 #include "tink/cc/pybind/status_casters.h"
 
 namespace crypto {
@@ -33,13 +38,47 @@ void PybindRegisterPrf(pybind11::module* module) {
       // only need the function "compute_primary".
       .def(
           "compute",
-          [](const Prf& self, const py::bytes& input_data,
+          [](const Prf& self, const py::buffer& input_data,
              size_t output_length) -> util::StatusOr<py::bytes> {
-            // TODO(b/145925674)
-            return self.Compute(std::string(input_data), output_length);
+            BufferView input(input_data);
+            return ToPyBytes(CallWithoutGil([&]() {
+              return self.Compute(input.view(), output_length);
+            }));
           },
           py::arg("input_data"), py::arg("output_length"),
-          "Computes the value of the primary (and only) PRF.");
+          "Computes the value of the primary (and only) PRF.")
+      .def(
+          "compute_batch",
+          [](const Prf& self, const py::sequence& inputs, size_t output_length,
+             int num_threads) -> util::StatusOr<py::list> {
+            BufferViewSequence input_views(inputs);
+            std::string outputs;
+            std::vector<int64_t> offsets;
+            util::Status status = CallWithoutGil([&]() {
+              return RunBatch(
+                  input_views.views().size(), num_threads,
+                  [&](size_t begin, size_t end, std::string* values,
+                      std::vector<int64_t>* value_offsets) -> util::Status {
+                    util::Status compute_status = self.ComputeBatch(
+                        input_views.views().subspan(begin, end - begin),
+                        output_length, values);
+                    if (!compute_status.ok()) return compute_status;
+                    value_offsets->clear();
+                    for (size_t i = begin; i <= end; i++) {
+                      value_offsets->push_back((i - begin) * output_length);
+                    }
+                    return util::OkStatus();
+                  },
+                  &outputs, &offsets);
+            });
+            if (!status.ok()) return status;
+            return ToPyBytesList(outputs, offsets);
+          },
+          py::arg("inputs"), py::arg("output_length"),
+          py::arg("num_threads") = 1,
+          "Computes the PRF on each of 'inputs', and returns the list of "
+          "outputs. The batch is processed with the GIL released, split over "
+          "'num_threads' threads.");
 }
 
 }  // namespace tink
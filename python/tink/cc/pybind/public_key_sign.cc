@@ -18,6 +18,7 @@
 
 #include "pybind11/pybind11.h"
 #include "tink/util/statusor.h"
+#include "tink/cc/pybind/buffer_view.h"
 #include "tink/cc/pybind/status_casters.h"
 
 namespace crypto {
@@ -42,9 +43,10 @@ void PybindRegisterPublicKeySign(pybind11::module* module) {
       .def(
           "sign",
           [](const PublicKeySign& self,
-             const py::bytes& data) -> util::StatusOr<py::bytes> {
-            // TODO(b/145925674)
-            return self.Sign(std::string(data));
+             const py::buffer& data) -> util::StatusOr<py::bytes> {
+            BufferView data_view(data);
+            return ToPyBytes(
+                CallWithoutGil([&]() { return self.Sign(data_view.view()); }));
           },
           py::arg("data"), "Computes the signature for 'data'.");
 }
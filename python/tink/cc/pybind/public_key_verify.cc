@@ -18,6 +18,7 @@
 
 #include "pybind11/pybind11.h"
 #include "tink/util/status.h"
+#include "tink/cc/pybind/buffer_view.h"
 #include "tink/cc/pybind/status_casters.h"
 
 namespace crypto {
@@ -41,10 +42,13 @@ void PybindRegisterPublicKeyVerify(pybind11::module* module) {
 
       .def(
           "verify",
-          [](const PublicKeyVerify& self, const py::bytes& signature,
-             const py::bytes& data) -> util::Status {
-            // TODO(b/145925674)
-            return self.Verify(std::string(signature), std::string(data));
+          [](const PublicKeyVerify& self, const py::buffer& signature,
+             const py::buffer& data) -> util::Status {
+            BufferView signature_view(signature);
+            BufferView data_view(data);
+            return CallWithoutGil([&]() {
+              return self.Verify(signature_view.view(), data_view.view());
+            });
           },
           py::arg("signature"), py::arg("data"),
           "Verifies that signature is a digital signature for data.");
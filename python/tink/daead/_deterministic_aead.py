@@ -20,6 +20,7 @@ from __future__ import division
 from __future__ import print_function
 
 import abc
+from typing import List, Sequence
 
 # Special imports
 import six
@@ -59,3 +60,28 @@ class DeterministicAead(object):
   def decrypt_deterministically(self, ciphertext: bytes,
                                 associated_data: bytes) -> bytes:
     raise NotImplementedError()
+
+  def encrypt_deterministically_batch(self,
+                                      plaintexts: Sequence[bytes],
+                                      associated_data: bytes,
+                                      num_threads: int = 1) -> List[bytes]:
+    """Encrypts each of plaintexts with the same associated_data.
+
+    Implementations backed by C++ process the whole batch in one call with the
+    GIL released, split over num_threads threads. This default implementation
+    calls encrypt_deterministically() for each element.
+    """
+    del num_threads  # Unused.
+    return [
+        self.encrypt_deterministically(p, associated_data) for p in plaintexts
+    ]
+
+  def decrypt_deterministically_batch(self,
+                                      ciphertexts: Sequence[bytes],
+                                      associated_data: bytes,
+                                      num_threads: int = 1) -> List[bytes]:
+    """Decrypts each of ciphertexts with the same associated_data."""
+    del num_threads  # Unused.
+    return [
+        self.decrypt_deterministically(c, associated_data) for c in ciphertexts
+    ]
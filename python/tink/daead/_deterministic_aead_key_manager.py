@@ -19,6 +19,8 @@ from __future__ import division
 # Placeholder for import for type annotations
 from __future__ import print_function
 
+from typing import List, Sequence
+
 from tink import core
 from tink.cc.pybind import tink_bindings
 from tink.daead import _deterministic_aead
@@ -43,6 +45,22 @@ class _DeterministicAeadCcToPyWrapper(_deterministic_aead.DeterministicAead):
     return self._deterministic_aead.decrypt_deterministically(
         ciphertext, associated_data)
 
+  @core.use_tink_errors
+  def encrypt_deterministically_batch(self,
+                                      plaintexts: Sequence[bytes],
+                                      associated_data: bytes,
+                                      num_threads: int = 1) -> List[bytes]:
+    return self._deterministic_aead.encrypt_deterministically_batch(
+        plaintexts, associated_data, num_threads)
+
+  @core.use_tink_errors
+  def decrypt_deterministically_batch(self,
+                                      ciphertexts: Sequence[bytes],
+                                      associated_data: bytes,
+                                      num_threads: int = 1) -> List[bytes]:
+    return self._deterministic_aead.decrypt_deterministically_batch(
+        ciphertexts, associated_data, num_threads)
+
 
 def register():
   """Registers all Hybrid key managers and wrapper in the Python Registry."""
@@ -19,7 +19,7 @@ from __future__ import division
 # Placeholder for import for type annotations
 from __future__ import print_function
 
-from typing import Type
+from typing import List, Optional, Sequence, Type
 from absl import logging
 
 from tink import core
@@ -41,7 +41,7 @@ class _WrappedDeterministicAead(_deterministic_aead.DeterministicAead):
   def decrypt_deterministically(self, ciphertext: bytes,
                                 associated_data: bytes) -> bytes:
     if len(ciphertext) > core.crypto_format.NON_RAW_PREFIX_SIZE:
-      prefix = ciphertext[:core.crypto_format.NON_RAW_PREFIX_SIZE]
+      prefix = bytes(ciphertext[:core.crypto_format.NON_RAW_PREFIX_SIZE])
       ciphertext_no_prefix = ciphertext[core.crypto_format.NON_RAW_PREFIX_SIZE:]
       for entry in self._primitive_set.primitive_from_identifier(prefix):
         try:
@@ -60,6 +60,48 @@ class _WrappedDeterministicAead(_deterministic_aead.DeterministicAead):
     # nothing works.
     raise core.TinkError('Decryption failed.')
 
+  def encrypt_deterministically_batch(self,
+                                      plaintexts: Sequence[bytes],
+                                      associated_data: bytes,
+                                      num_threads: int = 1) -> List[bytes]:
+    primary = self._primitive_set.primary()
+    ciphertexts = primary.primitive.encrypt_deterministically_batch(
+        plaintexts, associated_data, num_threads)
+    if not primary.identifier:
+      return ciphertexts
+    return [primary.identifier + c for c in ciphertexts]
+
+  def decrypt_deterministically_batch(self,
+                                      ciphertexts: Sequence[bytes],
+                                      associated_data: bytes,
+                                      num_threads: int = 1) -> List[bytes]:
+    # Fast path: all ciphertexts were made with the primary key.
+    primary = self._primitive_set.primary()
+    stripped = _strip_prefixes(ciphertexts, primary.identifier)
+    if stripped is not None:
+      try:
+        return primary.primitive.decrypt_deterministically_batch(
+            stripped, associated_data, num_threads)
+      except core.TinkError as e:
+        logging.info('batch does not decrypt with the primary key: %s', e)
+    return [
+        self.decrypt_deterministically(c, associated_data) for c in ciphertexts
+    ]
+
+
+def _strip_prefixes(ciphertexts: Sequence[bytes],
+                    prefix: bytes) -> Optional[List[bytes]]:
+  """Removes prefix from all ciphertexts, or returns None if one lacks it."""
+  if not prefix:
+    return list(ciphertexts)
+  n = len(prefix)
+  stripped = []
+  for c in ciphertexts:
+    if len(c) <= n or bytes(c[:n]) != prefix:
+      return None
+    stripped.append(c[n:])
+  return stripped
+
 
 class DeterministicAeadWrapper(
     core.PrimitiveWrapper[_deterministic_aead.DeterministicAead,
@@ -70,6 +70,24 @@ class AeadWrapperTest(parameterized.TestCase):
     with self.assertRaises(tink.TinkError):
       primitive.decrypt_deterministically(ciphertext, b'wrong_associated_data')
 
+  @parameterized.parameters([(DAEAD_TEMPLATE, 1), (RAW_DAEAD_TEMPLATE, 1),
+                             (DAEAD_TEMPLATE, 3)])
+  def test_encrypt_decrypt_batch(self, template, num_threads):
+    keyset_handle = tink.new_keyset_handle(template)
+    primitive = keyset_handle.primitive(daead.DeterministicAead)
+    plaintexts = [b'plaintext %d' % i for i in range(10)]
+    ciphertexts = primitive.encrypt_deterministically_batch(
+        plaintexts, b'ad', num_threads)
+    self.assertEqual(ciphertexts, [
+        primitive.encrypt_deterministically(p, b'ad') for p in plaintexts
+    ])
+    self.assertEqual(
+        primitive.decrypt_deterministically_batch(ciphertexts, b'ad',
+                                                  num_threads), plaintexts)
+    with self.assertRaises(tink.TinkError):
+      primitive.decrypt_deterministically_batch(ciphertexts, b'wrong ad',
+                                                num_threads)
+
   @parameterized.parameters([(DAEAD_TEMPLATE, DAEAD_TEMPLATE),
                              (RAW_DAEAD_TEMPLATE, DAEAD_TEMPLATE),
                              (DAEAD_TEMPLATE, RAW_DAEAD_TEMPLATE),
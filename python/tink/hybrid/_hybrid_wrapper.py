@@ -35,7 +35,7 @@ class _WrappedHybridDecrypt(_hybrid_decrypt.HybridDecrypt):
 
   def decrypt(self, ciphertext: bytes, context_info: bytes) -> bytes:
     if len(ciphertext) > core.crypto_format.NON_RAW_PREFIX_SIZE:
-      prefix = ciphertext[:core.crypto_format.NON_RAW_PREFIX_SIZE]
+      prefix = bytes(ciphertext[:core.crypto_format.NON_RAW_PREFIX_SIZE])
       ciphertext_no_prefix = ciphertext[core.crypto_format.NON_RAW_PREFIX_SIZE:]
       for entry in self._primitive_set.primitive_from_identifier(prefix):
         try:
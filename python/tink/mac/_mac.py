@@ -19,6 +19,7 @@ from __future__ import division
 from __future__ import print_function
 
 import abc
+from typing import List, Sequence
 
 # Special imports
 import six
@@ -58,3 +59,24 @@ class Mac(object):
       verification fails.
     """
     raise NotImplementedError()
+
+  def compute_mac_batch(self,
+                        data: Sequence[bytes],
+                        num_threads: int = 1) -> List[bytes]:
+    """Computes the MACs for each element of data.
+
+    Implementations backed by C++ process the whole batch in one call with the
+    GIL released. This default implementation calls compute_mac() for each
+    element.
+
+    Args:
+      data: A sequence of bytes-like objects.
+      num_threads: The number of threads the batch may be split over.
+    Returns:
+      The list of MACs, in the order of data.
+    Raises:
+      google3.third_party.tink.python.tink.tink_error.TinkError if any of the
+      computations fails.
+    """
+    del num_threads  # Unused.
+    return [self.compute_mac(d) for d in data]
@@ -18,6 +18,8 @@ from __future__ import division
 # Placeholder for import for type annotations
 from __future__ import print_function
 
+from typing import List, Sequence
+
 from tink import core
 from tink.cc.pybind import tink_bindings
 from tink.mac import _mac
@@ -38,6 +40,12 @@ class _MacCcToPyWrapper(_mac.Mac):
   def verify_mac(self, mac_value: bytes, data: bytes) -> None:
     self._cc_mac.verify_mac(mac_value, data)
 
+  @core.use_tink_errors
+  def compute_mac_batch(self,
+                        data: Sequence[bytes],
+                        num_threads: int = 1) -> List[bytes]:
+    return self._cc_mac.compute_mac_batch(data, num_threads)
+
 
 def register():
   tink_bindings.register()
@@ -19,7 +19,7 @@ from __future__ import division
 # Placeholder for import for type annotations
 from __future__ import print_function
 
-from typing import Type
+from typing import List, Sequence, Type
 from absl import logging
 
 
@@ -38,21 +38,32 @@ class _WrappedMac(_mac.Mac):
     primary = self._primitive_set.primary()
     if primary.output_prefix_type == tink_pb2.LEGACY:
       return primary.identifier + primary.primitive.compute_mac(
-          data + core.crypto_format.LEGACY_START_BYTE)
+          bytes(data) + core.crypto_format.LEGACY_START_BYTE)
     else:
       return primary.identifier + primary.primitive.compute_mac(data)
 
+  def compute_mac_batch(self,
+                        data: Sequence[bytes],
+                        num_threads: int = 1) -> List[bytes]:
+    primary = self._primitive_set.primary()
+    if primary.output_prefix_type == tink_pb2.LEGACY:
+      data = [bytes(d) + core.crypto_format.LEGACY_START_BYTE for d in data]
+    macs = primary.primitive.compute_mac_batch(data, num_threads)
+    if not primary.identifier:
+      return macs
+    return [primary.identifier + m for m in macs]
+
   def verify_mac(self, mac_value: bytes, data: bytes) -> None:
     if len(mac_value) <= core.crypto_format.NON_RAW_PREFIX_SIZE:
       # This also rejects raw MAC with size of 4 bytes or fewer. Those MACs are
       # clearly insecure, thus should be discouraged.
       raise core.TinkError('tag too short')
-    prefix = mac_value[:core.crypto_format.NON_RAW_PREFIX_SIZE]
+    prefix = bytes(mac_value[:core.crypto_format.NON_RAW_PREFIX_SIZE])
     mac_no_prefix = mac_value[core.crypto_format.NON_RAW_PREFIX_SIZE:]
     for entry in self._primitive_set.primitive_from_identifier(prefix):
       try:
         if entry.output_prefix_type == tink_pb2.LEGACY:
-          entry.primitive.verify_mac(mac_no_prefix, data + b'\x00')
+          entry.primitive.verify_mac(mac_no_prefix, bytes(data) + b'\x00')
         else:
           entry.primitive.verify_mac(mac_no_prefix, data)
         # If there is no exception, the MAC is valid and we can return.
@@ -46,6 +46,16 @@ class MacWrapperTest(parameterized.TestCase):
     # No exception raised, no return value.
     self.assertIsNone(primitive.verify_mac(tag, b'data'))
 
+  @parameterized.parameters([MAC_TEMPLATE,
+                             RAW_MAC_TEMPLATE,
+                             LEGACY_MAC_TEMPLATE])
+  def test_compute_mac_batch(self, template):
+    keyset_handle = tink.new_keyset_handle(template)
+    primitive = keyset_handle.primitive(mac.Mac)
+    data = [b'data %d' % i for i in range(10)]
+    tags = primitive.compute_mac_batch(data, num_threads=3)
+    self.assertEqual(tags, [primitive.compute_mac(d) for d in data])
+
   @parameterized.parameters([MAC_TEMPLATE,
                              RAW_MAC_TEMPLATE,
                              LEGACY_MAC_TEMPLATE])
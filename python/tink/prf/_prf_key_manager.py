@@ -19,6 +19,8 @@ from __future__ import division
 # Placeholder for import for type annotations
 from __future__ import print_function
 
+from typing import List, Sequence
+
 from tink import core
 from tink.cc.pybind import tink_bindings
 from tink.prf import _prf_set
@@ -35,6 +37,13 @@ class PrfCcToPyWrapper(_prf_set.Prf):
   def compute(self, input_data: bytes, output_length: int) -> bytes:
     return self._cc_primitive.compute(input_data, output_length)
 
+  @core.use_tink_errors
+  def compute_batch(self,
+                    inputs: Sequence[bytes],
+                    output_length: int,
+                    num_threads: int = 1) -> List[bytes]:
+    return self._cc_primitive.compute_batch(inputs, output_length, num_threads)
+
 
 def register() -> None:
   """Registers all PrfSet key managers and PrfSet wrapper in the Registry."""
@@ -19,7 +19,7 @@ from __future__ import division
 from __future__ import print_function
 
 import abc
-from typing import Mapping
+from typing import List, Mapping, Sequence
 # Special imports
 import six
 
@@ -66,6 +66,26 @@ class Prf(object):
     """
     raise NotImplementedError()
 
+  def compute_batch(self,
+                    inputs: Sequence[bytes],
+                    output_length: int,
+                    num_threads: int = 1) -> List[bytes]:
+    """Computes the PRF on each element of inputs.
+
+    Implementations backed by C++ process the whole batch in one call with the
+    GIL released. This default implementation calls compute() for each
+    element.
+
+    Args:
+      inputs: A sequence of bytes-like objects.
+      output_length: The desired length of each output in bytes.
+      num_threads: The number of threads the batch may be split over.
+    Returns:
+      The list of the first output_length bytes of the PRF of each input.
+    """
+    del num_threads  # Unused.
+    return [self.compute(i, output_length) for i in inputs]
+
 
 @six.add_metaclass(abc.ABCMeta)
 class PrfSet(object):
@@ -42,6 +42,14 @@ class PrfSetWrapperTest(absltest.TestCase):
     self.assertLen(prfs, 1)
     self.assertEqual(prfs[key_id].compute(b'input', output_length=31), output)
 
+  def test_compute_batch(self):
+    keyset_handle = tink.new_keyset_handle(TEMPLATE)
+    primary = keyset_handle.primitive(prf.PrfSet).primary()
+    inputs = [b'input %d' % i for i in range(10)]
+    outputs = primary.compute_batch(inputs, output_length=31, num_threads=3)
+    self.assertEqual(outputs,
+                     [primary.compute(i, output_length=31) for i in inputs])
+
   def test_invalid_length_fails(self):
     keyset_handle = tink.new_keyset_handle(TEMPLATE)
     primitive = keyset_handle.primitive(prf.PrfSet)
@@ -50,7 +50,7 @@ class _WrappedPublicKeySign(_public_key_sign.PublicKeySign):
 
     sign_data = data
     if primary.output_prefix_type == tink_pb2.LEGACY:
-      sign_data = sign_data + b'\x00'
+      sign_data = bytes(sign_data) + b'\x00'
 
     return primary.identifier + primary.primitive.sign(sign_data)
 
@@ -97,13 +97,13 @@ class _WrappedPublicKeyVerify(_public_key_verify.PublicKeyVerify):
       # We're not aware of any schemes that output signatures that small.
       raise core.TinkError('signature too short')
 
-    key_id = signature[:core.crypto_format.NON_RAW_PREFIX_SIZE]
+    key_id = bytes(signature[:core.crypto_format.NON_RAW_PREFIX_SIZE])
     raw_sig = signature[core.crypto_format.NON_RAW_PREFIX_SIZE:]
 
     for entry in self._primitive_set.primitive_from_identifier(key_id):
       try:
         if entry.output_prefix_type == tink_pb2.LEGACY:
-          entry.primitive.verify(raw_sig, data + b'\x00')
+          entry.primitive.verify(raw_sig, bytes(data) + b'\x00')
         else:
           entry.primitive.verify(raw_sig, data)
         # Signature is valid, we can return
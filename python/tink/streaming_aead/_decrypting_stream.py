@@ -54,10 +54,19 @@ class RawDecryptingStream(io.RawIOBase):
     self._close_ciphertext_source = close_ciphertext_source
     if not ciphertext_source.readable():
       raise ValueError('ciphertext_source must be readable')
-    cc_ciphertext_source = _file_object_adapter.FileObjectAdapter(
-        ciphertext_source)
-    self._input_stream_adapter = self._get_input_stream_adapter(
-        stream_aead, associated_data, cc_ciphertext_source)
+    # C++ reads regular files directly, but the position of ciphertext_source
+    # is then undefined. This is only done if it is closed at the end anyway.
+    fd = None
+    if close_ciphertext_source:
+      fd = _file_object_adapter.dup_file_descriptor(ciphertext_source)
+    if fd is not None:
+      self._input_stream_adapter = self._get_input_stream_adapter_from_fd(
+          stream_aead, associated_data, fd)
+    else:
+      cc_ciphertext_source = _file_object_adapter.FileObjectAdapter(
+          ciphertext_source)
+      self._input_stream_adapter = self._get_input_stream_adapter(
+          stream_aead, associated_data, cc_ciphertext_source)
 
   @staticmethod
   @core.use_tink_errors
@@ -66,6 +75,13 @@ class RawDecryptingStream(io.RawIOBase):
     return tink_bindings.new_cc_decrypting_stream(
         cc_primitive, aad, source)
 
+  @staticmethod
+  @core.use_tink_errors
+  def _get_input_stream_adapter_from_fd(cc_primitive, aad, source_fd):
+    """Implemented as a separate method to ensure correct error transform."""
+    return tink_bindings.new_cc_decrypting_stream_from_fd(
+        cc_primitive, aad, source_fd)
+
   @core.use_tink_errors
   def _read_from_input_stream_adapter(self, size: int) -> bytes:
     """Implemented as a separate method to ensure correct error transform."""
@@ -37,6 +37,13 @@ def _new_cc_encrypting_stream(cc_primitive, aad, destination):
       cc_primitive, aad, destination)
 
 
+@core.use_tink_errors
+def _new_cc_encrypting_stream_to_fd(cc_primitive, aad, destination_fd):
+  """Implemented as a separate function to ensure correct error transform."""
+  return tink_bindings.new_cc_encrypting_stream_to_fd(
+      cc_primitive, aad, destination_fd)
+
+
 class RawEncryptingStream(io.RawIOBase):
   """A file-like object which wraps writes to an underlying file-like object.
 
@@ -62,10 +69,19 @@ class RawEncryptingStream(io.RawIOBase):
     super(RawEncryptingStream, self).__init__()
     if not ciphertext_destination.writable():
       raise ValueError('ciphertext_destination must be writable')
-    cc_ciphertext_destination = _file_object_adapter.FileObjectAdapter(
-        ciphertext_destination)
-    self._cc_encrypting_stream = _new_cc_encrypting_stream(
-        stream_aead, associated_data, cc_ciphertext_destination)
+    # If the destination is a regular file, C++ writes to it directly, and
+    # ciphertext_destination is only closed at the end.
+    self._fd_destination = None
+    fd = _file_object_adapter.dup_file_descriptor(ciphertext_destination)
+    if fd is not None:
+      self._fd_destination = ciphertext_destination
+      self._cc_encrypting_stream = _new_cc_encrypting_stream_to_fd(
+          stream_aead, associated_data, fd)
+    else:
+      cc_ciphertext_destination = _file_object_adapter.FileObjectAdapter(
+          ciphertext_destination)
+      self._cc_encrypting_stream = _new_cc_encrypting_stream(
+          stream_aead, associated_data, cc_ciphertext_destination)
 
   @core.use_tink_errors
   def _write_to_cc_encrypting_stream(self, b: bytes) -> int:
@@ -106,7 +122,11 @@ class RawEncryptingStream(io.RawIOBase):
     if self.closed:  # pylint:disable=using-constant-test
       return
     self.flush()
-    self._close_cc_encrypting_stream()
+    try:
+      self._close_cc_encrypting_stream()
+    finally:
+      if self._fd_destination is not None:
+        self._fd_destination.close()
     super(RawEncryptingStream, self).close()
 
   def writable(self) -> bool:
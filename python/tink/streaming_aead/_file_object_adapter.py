@@ -23,10 +23,50 @@ from __future__ import division
 from __future__ import print_function
 
 import io
-from typing import BinaryIO
+import os
+import stat
+from typing import BinaryIO, Optional
 
 from tink.cc.pybind import tink_bindings
 
+# Binary file objects whose file descriptor may be used directly by C++.
+_FILE_TYPES = (io.FileIO, io.BufferedReader, io.BufferedWriter,
+               io.BufferedRandom)
+
+
+def dup_file_descriptor(file_object: BinaryIO) -> Optional[int]:
+  """Returns a duplicate of the descriptor of file_object, if it has one.
+
+  This lets C++ read and write regular files directly, without calling back
+  into Python for every chunk. Any data buffered in file_object is flushed
+  first, and the offset of the returned descriptor is set to the current
+  position of file_object. The caller owns the returned descriptor.
+
+  Args:
+    file_object: A binary file object.
+
+  Returns:
+    A new file descriptor, or None if file_object is not a regular file.
+  """
+  if not isinstance(file_object, _FILE_TYPES):
+    return None
+  try:
+    fd = file_object.fileno()
+    if not stat.S_ISREG(os.fstat(fd).st_mode):
+      return None
+    if file_object.writable():
+      file_object.flush()
+    position = file_object.tell()
+    new_fd = os.dup(fd)
+  except (OSError, ValueError):
+    return None
+  try:
+    os.lseek(new_fd, position, os.SEEK_SET)
+  except OSError:
+    os.close(new_fd)
+    return None
+  return new_fd
+
 
 class FileObjectAdapter(tink_bindings.PythonFileObjectAdapter):
   """Adapts a Python file object for use in C++."""
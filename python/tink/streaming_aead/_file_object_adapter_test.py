@@ -18,6 +18,7 @@ from __future__ import division
 from __future__ import print_function
 
 import io
+import os
 
 from absl.testing import absltest
 from absl.testing.absltest import mock
@@ -121,6 +122,40 @@ class FileObjectAdapterTest(absltest.TestCase):
 
     self.assertEqual(adapter.read(10), b'')
 
+  def test_dup_file_descriptor_of_bytes_io(self):
+    self.assertIsNone(
+        _file_object_adapter.dup_file_descriptor(io.BytesIO(b'something')))
+
+  def test_dup_file_descriptor_of_pipe(self):
+    read_fd, write_fd = os.pipe()
+    with open(read_fd, 'rb') as r, open(write_fd, 'wb') as w:
+      self.assertIsNone(_file_object_adapter.dup_file_descriptor(r))
+      self.assertIsNone(_file_object_adapter.dup_file_descriptor(w))
+
+  def test_dup_file_descriptor_writer_flushes_and_keeps_position(self):
+    filename = os.path.join(self.create_tempdir().full_path, 'file')
+    with open(filename, 'wb') as file_object:
+      file_object.write(b'something')
+      fd = _file_object_adapter.dup_file_descriptor(file_object)
+      self.assertIsNotNone(fd)
+      self.assertNotEqual(fd, file_object.fileno())
+      os.write(fd, b'123')
+      os.close(fd)
+    with open(filename, 'rb') as file_object:
+      self.assertEqual(file_object.read(), b'something123')
+
+  def test_dup_file_descriptor_reader_keeps_position(self):
+    filename = os.path.join(self.create_tempdir().full_path, 'file')
+    with open(filename, 'wb') as file_object:
+      file_object.write(b'something123')
+    with open(filename, 'rb') as file_object:
+      # Buffered readers read ahead, so the descriptor is past position 9.
+      self.assertEqual(file_object.read(9), b'something')
+      fd = _file_object_adapter.dup_file_descriptor(file_object)
+      self.assertIsNotNone(fd)
+      self.assertEqual(os.read(fd, 10), b'123')
+      os.close(fd)
+
 
 if __name__ == '__main__':
   absltest.main()
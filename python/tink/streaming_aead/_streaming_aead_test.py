@@ -60,6 +60,25 @@ class StreamingAeadTest(absltest.TestCase):
       self.assertTrue(src.closed)
       self.assertEqual(output, long_plaintext)
 
+  def test_encrypt_decrypt_after_header(self):
+    primitive = get_primitive()
+    long_plaintext = b' '.join(b'%d' % i for i in range(100 * 1000))
+    aad = b'associated_data'
+    with tempfile.TemporaryDirectory() as tmpdirname:
+      filename = os.path.join(tmpdirname, 'encrypted_file_with_header')
+      dest = open(filename, 'wb')
+      dest.write(b'header')
+      with primitive.new_encrypting_stream(dest, aad) as es:
+        es.write(long_plaintext)
+      self.assertTrue(dest.closed)
+
+      src = open(filename, 'rb')
+      self.assertEqual(src.read(6), b'header')
+      with primitive.new_decrypting_stream(src, aad) as ds:
+        output = ds.read()
+      self.assertTrue(src.closed)
+      self.assertEqual(output, long_plaintext)
+
   def test_encrypt_decrypt_raw(self):
     primitive = get_primitive()
     long_plaintext = b' '.join(b'%d' % i for i in range(100 * 1000))
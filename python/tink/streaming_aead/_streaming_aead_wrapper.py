@@ -27,6 +27,12 @@ from tink.streaming_aead import _rewindable_input_stream
 from tink.streaming_aead import _streaming_aead
 
 
+# Chunk size of the buffered streams returned to the user. Data is passed to
+# C++ in chunks of this size, so that the per-call overhead and the GIL
+# handoffs are amortized over many bytes.
+_BUFFER_SIZE = 1024 * 1024
+
+
 class _DecryptingStreamWrapper(io.RawIOBase):
   """A file-like object which decrypts reads from an underlying object.
 
@@ -146,13 +152,13 @@ class _WrappedStreamingAead(_streaming_aead.StreamingAead):
                             associated_data: bytes) -> BinaryIO:
     raw = self._primitive_set.primary().primitive.new_raw_encrypting_stream(
         ciphertext_destination, associated_data)
-    return cast(BinaryIO, io.BufferedWriter(raw))
+    return cast(BinaryIO, io.BufferedWriter(raw, _BUFFER_SIZE))
 
   def new_decrypting_stream(self, ciphertext_source: BinaryIO,
                             associated_data: bytes) -> BinaryIO:
     raw = _DecryptingStreamWrapper(self._primitive_set, ciphertext_source,
                                    associated_data)
-    return cast(BinaryIO, io.BufferedReader(raw))
+    return cast(BinaryIO, io.BufferedReader(raw, _BUFFER_SIZE))
 
 
 class StreamingAeadWrapper(
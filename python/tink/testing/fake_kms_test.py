@@ -18,6 +18,8 @@ from __future__ import division
 # Placeholder for import for type annotations
 from __future__ import print_function
 
+import asyncio
+
 from absl.testing import absltest
 import tink
 from tink import aead
@@ -58,5 +60,28 @@ class FakeKmsTest(absltest.TestCase):
     self.assertEqual(primitive.decrypt(ciphertext, associated_data), plaintext)
 
 
+  def test_fake_kms_envelope_encrypt_decrypt_async(self):
+    # The C++ envelope AEAD implements AsyncAead.
+    template = aead.aead_key_templates.create_kms_envelope_aead_key_template(
+        kek_uri=KEY_URI,
+        dek_template=aead.aead_key_templates.AES128_GCM)
+    keyset_handle = tink.new_keyset_handle(template)
+    primitive = keyset_handle.primitive(aead.Aead)
+
+    async def encrypt_decrypt():
+      ciphertexts = await asyncio.gather(*[
+          primitive.encrypt_async(b'plaintext %d' % i, b'associated_data')
+          for i in range(10)
+      ])
+      for i, ciphertext in enumerate(ciphertexts):
+        self.assertEqual(
+            await primitive.decrypt_async(ciphertext, b'associated_data'),
+            b'plaintext %d' % i)
+      with self.assertRaises(tink.TinkError):
+        await primitive.decrypt_async(ciphertexts[0], b'wrong_associated_data')
+
+    asyncio.run(encrypt_decrypt())
+
+
 if __name__ == '__main__':
   absltest.main()
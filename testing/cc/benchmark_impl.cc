@@ -0,0 +1,317 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+// Implementation of a Benchmark Service.
+#include "benchmark_impl.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "tink/aead.h"
+#include "tink/binary_keyset_reader.h"
+#include "tink/cleartext_keyset_handle.h"
+#include "tink/deterministic_aead.h"
+#include "tink/hybrid_decrypt.h"
+#include "tink/hybrid_encrypt.h"
+#include "tink/keyset_handle.h"
+#include "tink/mac.h"
+#include "tink/prf/prf_set.h"
+#include "tink/public_key_sign.h"
+#include "tink/public_key_verify.h"
+#include "tink/subtle/random.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "proto/testing/testing_api.grpc.pb.h"
+
+namespace tink_testing_api {
+
+using ::crypto::tink::BinaryKeysetReader;
+using ::crypto::tink::CleartextKeysetHandle;
+using ::crypto::tink::KeysetHandle;
+using ::crypto::tink::subtle::Random;
+using ::crypto::tink::util::StatusOr;
+using ::grpc::ServerContext;
+
+namespace {
+
+namespace util = ::crypto::tink::util;
+
+// Limits protecting the server from requests that would make it unusable.
+constexpr int kMaxConcurrency = 256;
+constexpr int kMaxPayloadSize = 64 * 1024 * 1024;
+constexpr int64_t kMaxIterations = 100 * 1000 * 1000;
+
+constexpr char kAssociatedData[] = "benchmark associated data";
+constexpr int kPrfOutputLength = 16;
+
+// One operation of a primitive, which the benchmark runs repeatedly.
+using Operation = std::function<util::Status()>;
+
+template <class P>
+StatusOr<std::shared_ptr<P>> GetPrimitive(const KeysetHandle& handle) {
+  auto primitive_result = handle.GetPrimitive<P>();
+  if (!primitive_result.ok()) return primitive_result.status();
+  return std::shared_ptr<P>(std::move(primitive_result.ValueOrDie()));
+}
+
+template <class P>
+StatusOr<std::shared_ptr<P>> GetPublicPrimitive(const KeysetHandle& handle) {
+  auto public_handle_result = handle.GetPublicKeysetHandle();
+  if (!public_handle_result.ok()) return public_handle_result.status();
+  return GetPrimitive<P>(*public_handle_result.ValueOrDie());
+}
+
+// Returns the operation to benchmark. Inputs that the operation consumes,
+// e.g. the ciphertext for decryption, are computed once up front.
+StatusOr<Operation> NewOperation(const KeysetHandle& handle,
+                                 BenchmarkOperation operation,
+                                 const std::string& payload) {
+  switch (operation) {
+    case AEAD_ENCRYPT:
+    case AEAD_DECRYPT: {
+      auto aead_result = GetPrimitive<crypto::tink::Aead>(handle);
+      if (!aead_result.ok()) return aead_result.status();
+      std::shared_ptr<crypto::tink::Aead> aead = aead_result.ValueOrDie();
+      if (operation == AEAD_ENCRYPT) {
+        return Operation([aead, payload]() {
+          return aead->Encrypt(payload, kAssociatedData).status();
+        });
+      }
+      auto ciphertext_result = aead->Encrypt(payload, kAssociatedData);
+      if (!ciphertext_result.ok()) return ciphertext_result.status();
+      std::string ciphertext = ciphertext_result.ValueOrDie();
+      return Operation([aead, ciphertext]() {
+        return aead->Decrypt(ciphertext, kAssociatedData).status();
+      });
+    }
+    case DETERMINISTIC_AEAD_ENCRYPT:
+    case DETERMINISTIC_AEAD_DECRYPT: {
+      auto daead_result =
+          GetPrimitive<crypto::tink::DeterministicAead>(handle);
+      if (!daead_result.ok()) return daead_result.status();
+      std::shared_ptr<crypto::tink::DeterministicAead> daead =
+          daead_result.ValueOrDie();
+      if (operation == DETERMINISTIC_AEAD_ENCRYPT) {
+        return Operation([daead, payload]() {
+          return daead->EncryptDeterministically(payload, kAssociatedData)
+              .status();
+        });
+      }
+      auto ciphertext_result =
+          daead->EncryptDeterministically(payload, kAssociatedData);
+      if (!ciphertext_result.ok()) return ciphertext_result.status();
+      std::string ciphertext = ciphertext_result.ValueOrDie();
+      return Operation([daead, ciphertext]() {
+        return daead->DecryptDeterministically(ciphertext, kAssociatedData)
+            .status();
+      });
+    }
+    case MAC_COMPUTE:
+    case MAC_VERIFY: {
+      auto mac_result = GetPrimitive<crypto::tink::Mac>(handle);
+      if (!mac_result.ok()) return mac_result.status();
+      std::shared_ptr<crypto::tink::Mac> mac = mac_result.ValueOrDie();
+      if (operation == MAC_COMPUTE) {
+        return Operation(
+            [mac, payload]() { return mac->ComputeMac(payload).status(); });
+      }
+      auto tag_result = mac->ComputeMac(payload);
+      if (!tag_result.ok()) return tag_result.status();
+      std::string tag = tag_result.ValueOrDie();
+      return Operation(
+          [mac, tag, payload]() { return mac->VerifyMac(tag, payload); });
+    }
+    case HYBRID_ENCRYPT:
+    case HYBRID_DECRYPT: {
+      auto encrypt_result =
+          GetPublicPrimitive<crypto::tink::HybridEncrypt>(handle);
+      if (!encrypt_result.ok()) return encrypt_result.status();
+      std::shared_ptr<crypto::tink::HybridEncrypt> hybrid_encrypt =
+          encrypt_result.ValueOrDie();
+      if (operation == HYBRID_ENCRYPT) {
+        return Operation([hybrid_encrypt, payload]() {
+          return hybrid_encrypt->Encrypt(payload, kAssociatedData).status();
+        });
+      }
+      auto decrypt_result = GetPrimitive<crypto::tink::HybridDecrypt>(handle);
+      if (!decrypt_result.ok()) return decrypt_result.status();
+      std::shared_ptr<crypto::tink::HybridDecrypt> hybrid_decrypt =
+          decrypt_result.ValueOrDie();
+      auto ciphertext_result =
+          hybrid_encrypt->Encrypt(payload, kAssociatedData);
+      if (!ciphertext_result.ok()) return ciphertext_result.status();
+      std::string ciphertext = ciphertext_result.ValueOrDie();
+      return Operation([hybrid_decrypt, ciphertext]() {
+        return hybrid_decrypt->Decrypt(ciphertext, kAssociatedData).status();
+      });
+    }
+    case SIGNATURE_SIGN:
+    case SIGNATURE_VERIFY: {
+      auto sign_result = GetPrimitive<crypto::tink::PublicKeySign>(handle);
+      if (!sign_result.ok()) return sign_result.status();
+      std::shared_ptr<crypto::tink::PublicKeySign> signer =
+          sign_result.ValueOrDie();
+      if (operation == SIGNATURE_SIGN) {
+        return Operation(
+            [signer, payload]() { return signer->Sign(payload).status(); });
+      }
+      auto verify_result =
+          GetPublicPrimitive<crypto::tink::PublicKeyVerify>(handle);
+      if (!verify_result.ok()) return verify_result.status();
+      std::shared_ptr<crypto::tink::PublicKeyVerify> verifier =
+          verify_result.ValueOrDie();
+      auto signature_result = signer->Sign(payload);
+      if (!signature_result.ok()) return signature_result.status();
+      std::string signature = signature_result.ValueOrDie();
+      return Operation([verifier, signature, payload]() {
+        return verifier->Verify(signature, payload);
+      });
+    }
+    case PRF_COMPUTE: {
+      auto prf_set_result = GetPrimitive<crypto::tink::PrfSet>(handle);
+      if (!prf_set_result.ok()) return prf_set_result.status();
+      std::shared_ptr<crypto::tink::PrfSet> prf_set =
+          prf_set_result.ValueOrDie();
+      return Operation([prf_set, payload]() {
+        return prf_set->ComputePrimary(payload, kPrfOutputLength).status();
+      });
+    }
+    default:
+      return util::Status(
+          crypto::tink::util::error::INVALID_ARGUMENT,
+          absl::StrCat("Unsupported benchmark operation ", operation));
+  }
+}
+
+// Returns the latency below which the fraction 'quantile' of the sorted
+// 'latencies' lies.
+int64_t Percentile(const std::vector<int64_t>& latencies, double quantile) {
+  if (latencies.empty()) return 0;
+  size_t rank = static_cast<size_t>(std::ceil(quantile * latencies.size()));
+  return latencies[std::min(latencies.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+}  // namespace
+
+// Runs an operation repeatedly and measures it.
+::grpc::Status BenchmarkImpl::Run(ServerContext* context,
+                                  const BenchmarkRequest* request,
+                                  BenchmarkResponse* response) {
+  if (request->iterations() <= 0 || request->iterations() > kMaxIterations) {
+    response->set_err(absl::StrCat("iterations must be in [1, ",
+                                   kMaxIterations, "]"));
+    return ::grpc::Status::OK;
+  }
+  if (request->concurrency() <= 0 || request->concurrency() > kMaxConcurrency) {
+    response->set_err(absl::StrCat("concurrency must be in [1, ",
+                                   kMaxConcurrency, "]"));
+    return ::grpc::Status::OK;
+  }
+  if (request->payload_size() < 0 ||
+      request->payload_size() > kMaxPayloadSize) {
+    response->set_err(absl::StrCat("payload_size must be in [0, ",
+                                   kMaxPayloadSize, "]"));
+    return ::grpc::Status::OK;
+  }
+  auto reader_result = BinaryKeysetReader::New(request->keyset());
+  if (!reader_result.ok()) {
+    response->set_err(reader_result.status().error_message());
+    return ::grpc::Status::OK;
+  }
+  auto handle_result =
+      CleartextKeysetHandle::Read(std::move(reader_result.ValueOrDie()));
+  if (!handle_result.ok()) {
+    response->set_err(handle_result.status().error_message());
+    return ::grpc::Status::OK;
+  }
+  std::string payload = Random::GetRandomBytes(request->payload_size());
+  auto operation_result = NewOperation(*handle_result.ValueOrDie(),
+                                       request->operation(), payload);
+  if (!operation_result.ok()) {
+    response->set_err(operation_result.status().error_message());
+    return ::grpc::Status::OK;
+  }
+  const Operation& operation = operation_result.ValueOrDie();
+
+  // Each thread runs its share of the iterations, recording the latency of
+  // every operation, and stops at the first failure.
+  const int concurrency = request->concurrency();
+  std::vector<std::vector<int64_t>> latencies(concurrency);
+  std::vector<util::Status> statuses(concurrency);
+  auto run_thread = [&](int thread_index) {
+    int64_t iterations = request->iterations() / concurrency +
+                         (thread_index < request->iterations() % concurrency);
+    latencies[thread_index].reserve(iterations);
+    for (int64_t i = 0; i < iterations; i++) {
+      auto start = std::chrono::steady_clock::now();
+      util::Status status = operation();
+      auto end = std::chrono::steady_clock::now();
+      if (!status.ok()) {
+        statuses[thread_index] = status;
+        return;
+      }
+      latencies[thread_index].push_back(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+              .count());
+    }
+  };
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  threads.reserve(concurrency - 1);
+  for (int i = 1; i < concurrency; i++) threads.emplace_back(run_thread, i);
+  run_thread(0);
+  for (std::thread& thread : threads) thread.join();
+  int64_t elapsed_nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+  for (const util::Status& status : statuses) {
+    if (!status.ok()) {
+      response->set_err(status.error_message());
+      return ::grpc::Status::OK;
+    }
+  }
+
+  std::vector<int64_t> all_latencies;
+  all_latencies.reserve(request->iterations());
+  for (const std::vector<int64_t>& thread_latencies : latencies) {
+    all_latencies.insert(all_latencies.end(), thread_latencies.begin(),
+                         thread_latencies.end());
+  }
+  std::sort(all_latencies.begin(), all_latencies.end());
+  double elapsed_seconds = std::max<int64_t>(elapsed_nanos, 1) / 1e9;
+  auto* output = response->mutable_output();
+  output->set_iterations(request->iterations());
+  output->set_elapsed_nanos(elapsed_nanos);
+  output->set_operations_per_second(request->iterations() / elapsed_seconds);
+  output->set_bytes_per_second(request->iterations() *
+                               static_cast<double>(request->payload_size()) /
+                               elapsed_seconds);
+  output->set_p50_latency_nanos(Percentile(all_latencies, 0.5));
+  output->set_p99_latency_nanos(Percentile(all_latencies, 0.99));
+  output->set_p999_latency_nanos(Percentile(all_latencies, 0.999));
+  return ::grpc::Status::OK;
+}
+
+}  // namespace tink_testing_api
@@ -0,0 +1,185 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include "benchmark_impl.h"
+
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "tink/aead/aead_key_templates.h"
+#include "tink/binary_keyset_writer.h"
+#include "tink/cleartext_keyset_handle.h"
+#include "tink/config/tink_config.h"
+#include "tink/mac/mac_key_templates.h"
+#include "tink/signature/signature_key_templates.h"
+#include "proto/testing/testing_api.grpc.pb.h"
+
+namespace crypto {
+namespace tink {
+namespace {
+
+using ::crypto::tink::AeadKeyTemplates;
+using ::crypto::tink::BinaryKeysetWriter;
+using ::crypto::tink::CleartextKeysetHandle;
+using ::crypto::tink::KeysetHandle;
+using ::google::crypto::tink::KeyTemplate;
+using ::testing::Eq;
+using ::testing::Ge;
+using ::testing::Gt;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Not;
+using ::tink_testing_api::BenchmarkRequest;
+using ::tink_testing_api::BenchmarkResponse;
+
+std::string KeysetFromTemplate(const KeyTemplate& key_template) {
+  auto handle_result = KeysetHandle::GenerateNew(key_template);
+  EXPECT_TRUE(handle_result.ok());
+  std::stringbuf keyset;
+  auto writer_result =
+      BinaryKeysetWriter::New(absl::make_unique<std::ostream>(&keyset));
+  EXPECT_TRUE(writer_result.ok());
+
+  auto status = CleartextKeysetHandle::Write(writer_result.ValueOrDie().get(),
+                                             *handle_result.ValueOrDie());
+  EXPECT_TRUE(status.ok());
+  return keyset.str();
+}
+
+class BenchmarkImplTest : public ::testing::Test {
+ protected:
+  static void SetUpTestSuite() { ASSERT_TRUE(TinkConfig::Register().ok()); }
+};
+
+void ExpectValidOutput(const BenchmarkResponse& response, int iterations) {
+  EXPECT_THAT(response.err(), IsEmpty());
+  EXPECT_THAT(response.output().iterations(), Eq(iterations));
+  EXPECT_THAT(response.output().elapsed_nanos(), Gt(0));
+  EXPECT_THAT(response.output().operations_per_second(), Gt(0));
+  EXPECT_THAT(response.output().p50_latency_nanos(), Gt(0));
+  EXPECT_THAT(response.output().p99_latency_nanos(),
+              Ge(response.output().p50_latency_nanos()));
+  EXPECT_THAT(response.output().p999_latency_nanos(),
+              Ge(response.output().p99_latency_nanos()));
+}
+
+TEST_F(BenchmarkImplTest, AeadEncryptAndDecrypt) {
+  tink_testing_api::BenchmarkImpl benchmark;
+  BenchmarkRequest request;
+  request.set_keyset(KeysetFromTemplate(AeadKeyTemplates::Aes128Gcm()));
+  request.set_payload_size(100);
+  request.set_iterations(50);
+  request.set_concurrency(3);
+
+  for (auto operation :
+       {tink_testing_api::AEAD_ENCRYPT, tink_testing_api::AEAD_DECRYPT}) {
+    request.set_operation(operation);
+    BenchmarkResponse response;
+    EXPECT_TRUE(benchmark.Run(nullptr, &request, &response).ok());
+    ExpectValidOutput(response, 50);
+    EXPECT_THAT(response.output().bytes_per_second(), Gt(0));
+  }
+}
+
+TEST_F(BenchmarkImplTest, MacComputeAndVerify) {
+  tink_testing_api::BenchmarkImpl benchmark;
+  BenchmarkRequest request;
+  request.set_keyset(KeysetFromTemplate(MacKeyTemplates::HmacSha256()));
+  request.set_payload_size(16);
+  request.set_iterations(20);
+  request.set_concurrency(1);
+
+  for (auto operation :
+       {tink_testing_api::MAC_COMPUTE, tink_testing_api::MAC_VERIFY}) {
+    request.set_operation(operation);
+    BenchmarkResponse response;
+    EXPECT_TRUE(benchmark.Run(nullptr, &request, &response).ok());
+    ExpectValidOutput(response, 20);
+  }
+}
+
+TEST_F(BenchmarkImplTest, SignatureWithPrivateKeyset) {
+  tink_testing_api::BenchmarkImpl benchmark;
+  BenchmarkRequest request;
+  request.set_keyset(
+      KeysetFromTemplate(SignatureKeyTemplates::EcdsaP256()));
+  request.set_payload_size(16);
+  request.set_iterations(10);
+  request.set_concurrency(2);
+
+  for (auto operation : {tink_testing_api::SIGNATURE_SIGN,
+                         tink_testing_api::SIGNATURE_VERIFY}) {
+    request.set_operation(operation);
+    BenchmarkResponse response;
+    EXPECT_TRUE(benchmark.Run(nullptr, &request, &response).ok());
+    ExpectValidOutput(response, 10);
+  }
+}
+
+TEST_F(BenchmarkImplTest, WrongPrimitiveFails) {
+  tink_testing_api::BenchmarkImpl benchmark;
+  BenchmarkRequest request;
+  request.set_keyset(KeysetFromTemplate(AeadKeyTemplates::Aes128Gcm()));
+  request.set_operation(tink_testing_api::MAC_COMPUTE);
+  request.set_iterations(1);
+  request.set_concurrency(1);
+  BenchmarkResponse response;
+
+  EXPECT_TRUE(benchmark.Run(nullptr, &request, &response).ok());
+  EXPECT_THAT(response.err(), Not(IsEmpty()));
+}
+
+TEST_F(BenchmarkImplTest, BadKeysetFails) {
+  tink_testing_api::BenchmarkImpl benchmark;
+  BenchmarkRequest request;
+  request.set_keyset("bad keyset");
+  request.set_operation(tink_testing_api::AEAD_ENCRYPT);
+  request.set_iterations(1);
+  request.set_concurrency(1);
+  BenchmarkResponse response;
+
+  EXPECT_TRUE(benchmark.Run(nullptr, &request, &response).ok());
+  EXPECT_THAT(response.err(), Not(IsEmpty()));
+}
+
+TEST_F(BenchmarkImplTest, InvalidParametersFail) {
+  tink_testing_api::BenchmarkImpl benchmark;
+  BenchmarkRequest request;
+  request.set_keyset(KeysetFromTemplate(AeadKeyTemplates::Aes128Gcm()));
+  request.set_operation(tink_testing_api::AEAD_ENCRYPT);
+  request.set_iterations(10);
+  request.set_concurrency(0);
+  BenchmarkResponse response;
+
+  EXPECT_TRUE(benchmark.Run(nullptr, &request, &response).ok());
+  EXPECT_THAT(response.err(), HasSubstr("concurrency"));
+
+  request.set_concurrency(1);
+  request.set_iterations(0);
+  EXPECT_TRUE(benchmark.Run(nullptr, &request, &response).ok());
+  EXPECT_THAT(response.err(), HasSubstr("iterations"));
+
+  request.set_iterations(10);
+  request.set_operation(tink_testing_api::UNKNOWN_BENCHMARK_OPERATION);
+  EXPECT_TRUE(benchmark.Run(nullptr, &request, &response).ok());
+  EXPECT_THAT(response.err(), HasSubstr("Unsupported"));
+}
+
+}  // namespace
+}  // namespace tink
+}  // namespace crypto
@@ -79,14 +79,14 @@ using ::grpc::Status;
     response->set_err(prf_set_result.status().error_message());
     return ::grpc::Status::OK;
   }
-  auto prfs = prf_set_result.ValueOrDie()->GetPrfs();
-  auto prf_it = prfs.find(request->key_id());
-  if (prf_it == prfs.end()) {
+  crypto::tink::Prf* prf =
+      prf_set_result.ValueOrDie()->GetPrf(request->key_id());
+  if (prf == nullptr) {
     response->set_err("Unknown key ID.");
     return ::grpc::Status::OK;
   }
   auto compute_result =
-      prf_it->second->Compute(request->input_data(), request->output_length());
+      prf->Compute(request->input_data(), request->output_length());
   if (!compute_result.ok()) {
     response->set_err(compute_result.status().error_message());
     return ::grpc::Status::OK;
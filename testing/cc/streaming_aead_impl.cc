@@ -17,9 +17,19 @@
 // Implementation of a StreamingAEAD Service.
 #include "streaming_aead_impl.h"
 
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/string_view.h"
 #include "tink/streaming_aead.h"
 #include "tink/binary_keyset_reader.h"
 #include "tink/cleartext_keyset_handle.h"
+#include "tink/input_stream.h"
+#include "tink/output_stream.h"
 #include "tink/util/istream_input_stream.h"
 #include "tink/util/ostream_output_stream.h"
 #include "tink/util/status.h"
@@ -32,11 +42,167 @@ namespace tinkutil = ::crypto::tink::util;
 using ::crypto::tink::BinaryKeysetReader;
 using ::crypto::tink::CleartextKeysetHandle;
 using ::crypto::tink::InputStream;
+using ::crypto::tink::OutputStream;
 using ::crypto::tink::util::IstreamInputStream;
 using ::crypto::tink::util::OstreamOutputStream;
 using ::grpc::ServerContext;
 using ::grpc::Status;
 
+namespace {
+
+constexpr int kDefaultResponseChunkSize = 64 * 1024;
+
+// Returns the StreamingAead primitive of the serialized keyset.
+tinkutil::StatusOr<std::unique_ptr<crypto::tink::StreamingAead>>
+NewStreamingAead(const std::string& keyset) {
+  auto reader_result = BinaryKeysetReader::New(keyset);
+  if (!reader_result.ok()) return reader_result.status();
+  auto handle_result =
+      CleartextKeysetHandle::Read(std::move(reader_result.ValueOrDie()));
+  if (!handle_result.ok()) return handle_result.status();
+  return handle_result.ValueOrDie()->GetPrimitive<crypto::tink::StreamingAead>();
+}
+
+int ResponseChunkSize(const StreamingAeadStreamRequest& request) {
+  return request.response_chunk_size() > 0 ? request.response_chunk_size()
+                                           : kDefaultResponseChunkSize;
+}
+
+void WriteError(StreamingAeadStreamImpl::Stream* stream,
+                const std::string& error) {
+  StreamingAeadStreamResponse response;
+  response.set_err(error);
+  stream->Write(response);
+}
+
+// An OutputStream which writes its data to the responses of 'stream', in
+// chunks of 'chunk_size' bytes.
+class ResponseOutputStream : public OutputStream {
+ public:
+  ResponseOutputStream(StreamingAeadStreamImpl::Stream* stream,
+                       int chunk_size)
+      : stream_(stream), buffer_(chunk_size, '\0') {}
+
+  tinkutil::StatusOr<int> Next(void** data) override {
+    if (closed_) {
+      return tinkutil::Status(tinkutil::error::FAILED_PRECONDITION,
+                              "stream is closed");
+    }
+    if (buffered_ == buffer_.size()) {
+      auto status = Flush();
+      if (!status.ok()) return status;
+    }
+    *data = &buffer_[buffered_];
+    int size = buffer_.size() - buffered_;
+    buffered_ = buffer_.size();
+    return size;
+  }
+
+  void BackUp(int count) override {
+    buffered_ -= std::min(static_cast<size_t>(std::max(0, count)), buffered_);
+  }
+
+  tinkutil::Status Close() override {
+    if (closed_) return tinkutil::OkStatus();
+    closed_ = true;
+    return Flush();
+  }
+
+  int64_t Position() const override { return written_ + buffered_; }
+
+ private:
+  tinkutil::Status Flush() {
+    if (buffered_ == 0) return tinkutil::OkStatus();
+    StreamingAeadStreamResponse response;
+    response.set_chunk(buffer_.data(), buffered_);
+    written_ += buffered_;
+    buffered_ = 0;
+    if (!stream_->Write(response)) {
+      return tinkutil::Status(tinkutil::error::UNAVAILABLE,
+                              "could not write the response");
+    }
+    return tinkutil::OkStatus();
+  }
+
+  StreamingAeadStreamImpl::Stream* const stream_;
+  std::string buffer_;
+  size_t buffered_ = 0;
+  int64_t written_ = 0;
+  bool closed_ = false;
+};
+
+// An InputStream which reads its data from the requests of 'stream',
+// starting with 'first_chunk'.
+class RequestInputStream : public InputStream {
+ public:
+  RequestInputStream(StreamingAeadStreamImpl::Stream* stream,
+                     std::string first_chunk)
+      : stream_(stream), chunk_(std::move(first_chunk)) {}
+
+  tinkutil::StatusOr<int> Next(const void** data) override {
+    if (backed_up_ > 0) {
+      *data = &chunk_[chunk_.size() - backed_up_];
+      int size = backed_up_;
+      position_ += backed_up_;
+      backed_up_ = 0;
+      return size;
+    }
+    // The first chunk is returned from the first call.
+    if (!first_chunk_read_ && !chunk_.empty()) {
+      first_chunk_read_ = true;
+    } else {
+      StreamingAeadStreamRequest request;
+      do {
+        if (!stream_->Read(&request)) {
+          chunk_.clear();
+          return tinkutil::Status(tinkutil::error::OUT_OF_RANGE,
+                                  "end of stream");
+        }
+      } while (request.chunk().empty());
+      chunk_ = std::move(*request.mutable_chunk());
+      first_chunk_read_ = true;
+    }
+    *data = chunk_.data();
+    position_ += chunk_.size();
+    return chunk_.size();
+  }
+
+  void BackUp(int count) override {
+    int backed_up = std::min(std::max(0, count),
+                             static_cast<int>(chunk_.size()) - backed_up_);
+    backed_up_ += backed_up;
+    position_ -= backed_up;
+  }
+
+  int64_t Position() const override { return position_; }
+
+ private:
+  StreamingAeadStreamImpl::Stream* const stream_;
+  std::string chunk_;
+  bool first_chunk_read_ = false;
+  // The number of bytes at the end of chunk_ which were backed up.
+  int backed_up_ = 0;
+  int64_t position_ = 0;
+};
+
+// Writes all of 'data' to 'output_stream'.
+tinkutil::Status WriteAll(OutputStream* output_stream,
+                          absl::string_view data) {
+  while (!data.empty()) {
+    void* buffer;
+    auto next_result = output_stream->Next(&buffer);
+    if (!next_result.ok()) return next_result.status();
+    int size = std::min(static_cast<size_t>(next_result.ValueOrDie()),
+                        data.size());
+    memcpy(buffer, data.data(), size);
+    output_stream->BackUp(next_result.ValueOrDie() - size);
+    data.remove_prefix(size);
+  }
+  return tinkutil::OkStatus();
+}
+
+}  // namespace
+
 // Encrypts a message
 ::grpc::Status StreamingAeadImpl::Encrypt(
     grpc::ServerContext* context,
@@ -165,4 +331,83 @@ using ::grpc::Status;
   return ::grpc::Status::OK;
 }
 
+// Encrypts the chunks of the requests
+::grpc::Status StreamingAeadStreamImpl::EncryptStream(Stream* stream) {
+  StreamingAeadStreamRequest request;
+  if (!stream->Read(&request)) return ::grpc::Status::OK;
+  auto streaming_aead_result = NewStreamingAead(request.keyset());
+  if (!streaming_aead_result.ok()) {
+    WriteError(stream, streaming_aead_result.status().error_message());
+    return ::grpc::Status::OK;
+  }
+  auto encrypting_stream_result =
+      streaming_aead_result.ValueOrDie()->NewEncryptingStream(
+          absl::make_unique<ResponseOutputStream>(stream,
+                                                  ResponseChunkSize(request)),
+          request.associated_data());
+  if (!encrypting_stream_result.ok()) {
+    WriteError(stream, encrypting_stream_result.status().error_message());
+    return ::grpc::Status::OK;
+  }
+  auto encrypting_stream = std::move(encrypting_stream_result.ValueOrDie());
+  do {
+    auto status = WriteAll(encrypting_stream.get(), request.chunk());
+    if (!status.ok()) {
+      WriteError(stream, status.error_message());
+      return ::grpc::Status::OK;
+    }
+  } while (stream->Read(&request));
+  auto close_status = encrypting_stream->Close();
+  if (!close_status.ok()) {
+    WriteError(stream, close_status.error_message());
+  }
+  return ::grpc::Status::OK;
+}
+
+// Decrypts the chunks of the requests
+::grpc::Status StreamingAeadStreamImpl::DecryptStream(Stream* stream) {
+  StreamingAeadStreamRequest request;
+  if (!stream->Read(&request)) return ::grpc::Status::OK;
+  auto streaming_aead_result = NewStreamingAead(request.keyset());
+  if (!streaming_aead_result.ok()) {
+    WriteError(stream, streaming_aead_result.status().error_message());
+    return ::grpc::Status::OK;
+  }
+  auto decrypting_stream_result =
+      streaming_aead_result.ValueOrDie()->NewDecryptingStream(
+          absl::make_unique<RequestInputStream>(
+              stream, std::move(*request.mutable_chunk())),
+          request.associated_data());
+  if (!decrypting_stream_result.ok()) {
+    WriteError(stream, decrypting_stream_result.status().error_message());
+    return ::grpc::Status::OK;
+  }
+  auto decrypting_stream = std::move(decrypting_stream_result.ValueOrDie());
+  ResponseOutputStream plaintext(stream, ResponseChunkSize(request));
+  const void* buffer;
+  while (true) {
+    auto next_result = decrypting_stream->Next(&buffer);
+    if (next_result.status().error_code() == tinkutil::error::OUT_OF_RANGE) {
+      // End of stream.
+      break;
+    }
+    if (!next_result.ok()) {
+      WriteError(stream, next_result.status().error_message());
+      return ::grpc::Status::OK;
+    }
+    auto status = WriteAll(
+        &plaintext, absl::string_view(reinterpret_cast<const char*>(buffer),
+                                      next_result.ValueOrDie()));
+    if (!status.ok()) {
+      WriteError(stream, status.error_message());
+      return ::grpc::Status::OK;
+    }
+  }
+  auto close_status = plaintext.Close();
+  if (!close_status.ok()) {
+    WriteError(stream, close_status.error_message());
+  }
+  return ::grpc::Status::OK;
+}
+
 }  // namespace tink_testing_api
@@ -37,6 +37,32 @@ class StreamingAeadImpl final : public StreamingAead::Service {
                        StreamingAeadDecryptResponse* response) override;
 };
 
+// A StreamingAeadStream Service.
+class StreamingAeadStreamImpl final : public StreamingAeadStream::Service {
+ public:
+  using Stream =
+      grpc::ServerReaderWriterInterface<StreamingAeadStreamResponse,
+                                        StreamingAeadStreamRequest>;
+
+  grpc::Status Encrypt(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriter<StreamingAeadStreamResponse,
+                               StreamingAeadStreamRequest>* stream) override {
+    return EncryptStream(stream);
+  }
+
+  grpc::Status Decrypt(
+      grpc::ServerContext* context,
+      grpc::ServerReaderWriter<StreamingAeadStreamResponse,
+                               StreamingAeadStreamRequest>* stream) override {
+    return DecryptStream(stream);
+  }
+
+  // Same as Encrypt() and Decrypt(), on any stream.
+  grpc::Status EncryptStream(Stream* stream);
+  grpc::Status DecryptStream(Stream* stream);
+};
+
 }  // namespace tink_testing_api
 
 #endif  // TINK_TESTING_SERIVCES_STREAMING_AEAD_IMPL_H_
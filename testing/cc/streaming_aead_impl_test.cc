@@ -16,6 +16,10 @@
 
 #include "streaming_aead_impl.h"
 
+#include <deque>
+#include <string>
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "tink/streamingaead/streaming_aead_config.h"
@@ -38,6 +42,9 @@ using ::tink_testing_api::StreamingAeadDecryptRequest;
 using ::tink_testing_api::StreamingAeadEncryptRequest;
 using ::tink_testing_api::StreamingAeadEncryptResponse;
 using ::tink_testing_api::StreamingAeadDecryptResponse;
+using ::tink_testing_api::StreamingAeadStreamImpl;
+using ::tink_testing_api::StreamingAeadStreamRequest;
+using ::tink_testing_api::StreamingAeadStreamResponse;
 
 using crypto::tink::KeysetHandle;
 using google::crypto::tink::KeyTemplate;
@@ -117,6 +124,133 @@ TEST_F(StreamingAeadImplTest, DecryptBadCiphertextFail) {
   EXPECT_THAT(dec_response.err(), Not(IsEmpty()));
 }
 
+// A stream which reads the given requests and records the responses.
+class FakeStream : public StreamingAeadStreamImpl::Stream {
+ public:
+  explicit FakeStream(const std::vector<StreamingAeadStreamRequest>& requests)
+      : requests_(requests.begin(), requests.end()) {}
+
+  void SendInitialMetadata() override {}
+
+  bool Write(const StreamingAeadStreamResponse& response,
+             grpc::WriteOptions options) override {
+    responses_.push_back(response);
+    return true;
+  }
+
+  bool NextMessageSize(uint32_t* size) override {
+    if (requests_.empty()) return false;
+    *size = requests_.front().ByteSizeLong();
+    return true;
+  }
+
+  bool Read(StreamingAeadStreamRequest* request) override {
+    if (requests_.empty()) return false;
+    *request = requests_.front();
+    requests_.pop_front();
+    return true;
+  }
+
+  const std::vector<StreamingAeadStreamResponse>& responses() const {
+    return responses_;
+  }
+
+ private:
+  std::deque<StreamingAeadStreamRequest> requests_;
+  std::vector<StreamingAeadStreamResponse> responses_;
+};
+
+// Splits 'data' into requests with chunks of 'chunk_size' bytes, the first
+// of which carries the keyset.
+std::vector<StreamingAeadStreamRequest> GetRequests(
+    const std::string& keyset, const std::string& data, int chunk_size,
+    int response_chunk_size) {
+  std::vector<StreamingAeadStreamRequest> requests;
+  for (size_t pos = 0; pos == 0 || pos < data.size(); pos += chunk_size) {
+    StreamingAeadStreamRequest request;
+    if (pos == 0) {
+      request.set_keyset(keyset);
+      request.set_associated_data("ad");
+      request.set_response_chunk_size(response_chunk_size);
+    }
+    request.set_chunk(data.substr(pos, chunk_size));
+    requests.push_back(request);
+  }
+  return requests;
+}
+
+std::string GetChunks(const std::vector<StreamingAeadStreamResponse>& responses,
+                      int chunk_size) {
+  std::string data;
+  for (int i = 0; i < responses.size(); i++) {
+    EXPECT_THAT(responses[i].err(), IsEmpty());
+    if (i + 1 < responses.size()) {
+      EXPECT_EQ(chunk_size, responses[i].chunk().size());
+    }
+    data += responses[i].chunk();
+  }
+  return data;
+}
+
+TEST_F(StreamingAeadImplTest, StreamEncryptDecryptSuccess) {
+  StreamingAeadStreamImpl streaming_aead;
+  std::string keyset = ValidKeyset();
+  std::string plaintext;
+  for (int i = 0; i < 10000; i++) plaintext += std::to_string(i);
+
+  FakeStream enc_stream(GetRequests(keyset, plaintext, 1000, 3000));
+  EXPECT_TRUE(streaming_aead.EncryptStream(&enc_stream).ok());
+  std::string ciphertext = GetChunks(enc_stream.responses(), 3000);
+  EXPECT_GT(ciphertext.size(), plaintext.size());
+
+  FakeStream dec_stream(GetRequests(keyset, ciphertext, 777, 5000));
+  EXPECT_TRUE(streaming_aead.DecryptStream(&dec_stream).ok());
+  EXPECT_THAT(GetChunks(dec_stream.responses(), 5000), Eq(plaintext));
+
+  // The ciphertext is compatible with the unary service.
+  tink_testing_api::StreamingAeadImpl unary_streaming_aead;
+  StreamingAeadDecryptRequest dec_request;
+  dec_request.set_keyset(keyset);
+  dec_request.set_ciphertext(ciphertext);
+  dec_request.set_associated_data("ad");
+  StreamingAeadDecryptResponse dec_response;
+  EXPECT_TRUE(unary_streaming_aead.Decrypt(nullptr, &dec_request,
+                                           &dec_response).ok());
+  EXPECT_THAT(dec_response.err(), IsEmpty());
+  EXPECT_THAT(dec_response.plaintext(), Eq(plaintext));
+}
+
+TEST_F(StreamingAeadImplTest, StreamEncryptDecryptEmptySuccess) {
+  StreamingAeadStreamImpl streaming_aead;
+  std::string keyset = ValidKeyset();
+
+  FakeStream enc_stream(GetRequests(keyset, "", 1000, 0));
+  EXPECT_TRUE(streaming_aead.EncryptStream(&enc_stream).ok());
+  std::string ciphertext = GetChunks(enc_stream.responses(), 64 * 1024);
+  EXPECT_THAT(ciphertext, Not(IsEmpty()));
+
+  FakeStream dec_stream(GetRequests(keyset, ciphertext, 1000, 0));
+  EXPECT_TRUE(streaming_aead.DecryptStream(&dec_stream).ok());
+  EXPECT_THAT(dec_stream.responses(), IsEmpty());
+}
+
+TEST_F(StreamingAeadImplTest, StreamEncryptBadKeysetFail) {
+  StreamingAeadStreamImpl streaming_aead;
+  FakeStream enc_stream(GetRequests("bad keyset", "Plain text", 1000, 0));
+  EXPECT_TRUE(streaming_aead.EncryptStream(&enc_stream).ok());
+  ASSERT_EQ(1, enc_stream.responses().size());
+  EXPECT_THAT(enc_stream.responses()[0].err(), Not(IsEmpty()));
+}
+
+TEST_F(StreamingAeadImplTest, StreamDecryptBadCiphertextFail) {
+  StreamingAeadStreamImpl streaming_aead;
+  FakeStream dec_stream(
+      GetRequests(ValidKeyset(), std::string(10000, 'x'), 1000, 0));
+  EXPECT_TRUE(streaming_aead.DecryptStream(&dec_stream).ok());
+  ASSERT_FALSE(dec_stream.responses().empty());
+  EXPECT_THAT(dec_stream.responses().back().err(), Not(IsEmpty()));
+}
+
 }  // namespace
 }  // namespace tink
 }  // namespace crypto
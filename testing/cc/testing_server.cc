@@ -24,6 +24,7 @@
 #include "tink/util/fake_kms_client.h"
 #include "proto/testing/testing_api.grpc.pb.h"
 #include "aead_impl.h"
+#include "benchmark_impl.h"
 #include "deterministic_aead_impl.h"
 #include "hybrid_impl.h"
 #include "keyset_impl.h"
@@ -75,8 +76,10 @@ void RunServer() {
   tink_testing_api::MacImpl mac;
   tink_testing_api::SignatureImpl signature;
   tink_testing_api::StreamingAeadImpl streaming_aead;
+  tink_testing_api::StreamingAeadStreamImpl streaming_aead_stream;
   tink_testing_api::PrfSetImpl prf_set;
   tink_testing_api::JwtImpl jwt;
+  tink_testing_api::BenchmarkImpl benchmark;
 
   grpc::ServerBuilder builder;
   builder.AddListeningPort(
@@ -91,7 +94,9 @@ void RunServer() {
   builder.RegisterService(&signature);
   builder.RegisterService(&prf_set);
   builder.RegisterService(&streaming_aead);
+  builder.RegisterService(&streaming_aead_stream);
   builder.RegisterService(&jwt);
+  builder.RegisterService(&benchmark);
 
   std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
   std::cout << "Server listening on " << server_address << std::endl;
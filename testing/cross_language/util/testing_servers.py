@@ -26,7 +26,7 @@ from typing import List, Text
 from absl import logging
 import grpc
 import portpicker
-
+import tink
 from tink.proto import tink_pb2
 from proto.testing import testing_api_pb2
 from proto.testing import testing_api_pb2_grpc
@@ -70,6 +70,7 @@ _PRIMITIVE_STUBS = {
     'signature': testing_api_pb2_grpc.SignatureStub,
     'prf': testing_api_pb2_grpc.PrfSetStub,
     'jwt': testing_api_pb2_grpc.JwtStub,
+    'benchmark': testing_api_pb2_grpc.BenchmarkStub,
 }
 
 # All primitives.
@@ -84,6 +85,7 @@ SUPPORTED_LANGUAGES_BY_PRIMITIVE = {
     'signature': ['cc', 'go', 'java', 'python'],
     'prf': ['cc', 'java', 'go', 'python'],
     'jwt': ['cc', 'java', 'python'],
+    'benchmark': ['cc'],
 }
 
 
@@ -124,6 +126,7 @@ class _TestingServers():
     self._signature_stub = {}
     self._prf_stub = {}
     self._jwt_stub = {}
+    self._benchmark_stub = {}
     for lang in LANGUAGES:
       port = portpicker.pick_unused_port()
       cmd = _server_cmd(lang, port)
@@ -194,6 +197,9 @@ class _TestingServers():
   def jwt_stub(self, lang) -> testing_api_pb2_grpc.JwtStub:
     return self._jwt_stub[lang]
 
+  def benchmark_stub(self, lang) -> testing_api_pb2_grpc.BenchmarkStub:
+    return self._benchmark_stub[lang]
+
   def metadata_stub(self, lang) -> testing_api_pb2_grpc.MetadataStub:
     return self._metadata_stub[lang]
 
@@ -346,3 +352,24 @@ def jwt_public_key_verify(lang: Text,
   """Returns a JwtPublicKeyVerify primitive, implemented in lang."""
   global _ts
   return _primitives.JwtPublicKeyVerify(lang, _ts.jwt_stub(lang), keyset)
+
+
+def run_benchmark(
+    lang: Text,
+    keyset: bytes,
+    operation: testing_api_pb2.BenchmarkOperation,
+    payload_size: int,
+    iterations: int,
+    concurrency: int = 1) -> testing_api_pb2.BenchmarkResponse.Output:
+  """Runs operation with keyset on the server of lang, returns the results."""
+  global _ts
+  request = testing_api_pb2.BenchmarkRequest(
+      keyset=keyset,
+      operation=operation,
+      payload_size=payload_size,
+      iterations=iterations,
+      concurrency=concurrency)
+  response = _ts.benchmark_stub(lang).Run(request)
+  if response.err:
+    raise tink.TinkError(response.err)
+  return response.output
@@ -0,0 +1,265 @@
+// Copyright 2021 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/strings/numbers.h"
+#include "absl/strings/string_view.h"
+#include "tink/aead.h"
+#include "tink/crypto_format.h"
+#include "tink/keyset_handle.h"
+#include "tink/util/status.h"
+#include "tink/util/statusor.h"
+#include "testing/cc/cli_util.h"
+#include "proto/tink.pb.h"
+
+using crypto::tink::Aead;
+using crypto::tink::CryptoFormat;
+using crypto::tink::KeysetHandle;
+using crypto::tink::util::Status;
+using google::crypto::tink::KeysetInfo;
+
+namespace {
+
+// Number of records that are read, re-encrypted and written at once.
+constexpr int kBatchSize = 4096;
+
+// Records are limited to this size, to detect corrupted length prefixes.
+constexpr uint32_t kMaxRecordSize = 256 * 1024 * 1024;
+
+// Reads a record, i.e. a 4 byte big-endian length followed by that many
+// bytes, from 'input' into 'record'. Returns false at the end of the input,
+// and exits on errors.
+bool ReadRecord(std::istream* input, std::string* record) {
+  unsigned char length_bytes[4];
+  input->read(reinterpret_cast<char*>(length_bytes), sizeof(length_bytes));
+  if (input->gcount() == 0 && input->eof()) return false;
+  if (input->gcount() != sizeof(length_bytes)) {
+    std::clog << "Truncated record length." << std::endl;
+    exit(1);
+  }
+  uint32_t length = (static_cast<uint32_t>(length_bytes[0]) << 24) |
+                    (static_cast<uint32_t>(length_bytes[1]) << 16) |
+                    (static_cast<uint32_t>(length_bytes[2]) << 8) |
+                    static_cast<uint32_t>(length_bytes[3]);
+  if (length > kMaxRecordSize) {
+    std::clog << "Record of " << length << " bytes is too large." << std::endl;
+    exit(1);
+  }
+  record->resize(length);
+  input->read(&(*record)[0], length);
+  if (static_cast<uint32_t>(input->gcount()) != length) {
+    std::clog << "Truncated record." << std::endl;
+    exit(1);
+  }
+  return true;
+}
+
+void WriteRecord(const std::string& record, std::ostream* output) {
+  uint32_t length = record.size();
+  const char length_bytes[4] = {static_cast<char>(length >> 24),
+                                static_cast<char>(length >> 16),
+                                static_cast<char>(length >> 8),
+                                static_cast<char>(length)};
+  output->write(length_bytes, sizeof(length_bytes));
+  output->write(record.data(), record.size());
+}
+
+// Returns the output prefix of the primary key of 'keyset_handle', which
+// is empty if the primary key is a RAW key.
+std::string GetPrimaryPrefix(const KeysetHandle& keyset_handle) {
+  KeysetInfo keyset_info = keyset_handle.GetKeysetInfo();
+  for (const auto& key_info : keyset_info.key_info()) {
+    if (key_info.key_id() != keyset_info.primary_key_id()) continue;
+    auto prefix_result = CryptoFormat::GetOutputPrefix(key_info);
+    if (!prefix_result.ok()) {
+      std::clog << "Getting the output prefix of the primary key failed: "
+                << prefix_result.status().error_message() << std::endl;
+      exit(1);
+    }
+    return prefix_result.ValueOrDie();
+  }
+  std::clog << "The keyset has no primary key." << std::endl;
+  exit(1);
+}
+
+// Re-encrypts the records in [begin, end) of 'records' that do not start
+// with 'primary_prefix', or all of them if 'primary_prefix' is empty.
+// Returns the number of re-encrypted records, or the first error.
+crypto::tink::util::StatusOr<int64_t> ReencryptRecords(
+    const Aead& aead, absl::string_view primary_prefix,
+    absl::string_view associated_data, std::vector<std::string>* records,
+    size_t begin, size_t end) {
+  int64_t reencrypted = 0;
+  for (size_t i = begin; i < end; i++) {
+    std::string& record = (*records)[i];
+    if (!primary_prefix.empty() &&
+        absl::string_view(record).substr(0, primary_prefix.size()) ==
+            primary_prefix) {
+      continue;
+    }
+    auto decrypt_result = aead.Decrypt(record, associated_data);
+    if (!decrypt_result.ok()) return decrypt_result.status();
+    auto encrypt_result =
+        aead.Encrypt(decrypt_result.ValueOrDie(), associated_data);
+    if (!encrypt_result.ok()) return encrypt_result.status();
+    record = std::move(encrypt_result.ValueOrDie());
+    reencrypted++;
+  }
+  return reencrypted;
+}
+
+}  // namespace
+
+// A command-line utility for rotating the key of AEAD-ciphertexts.
+// It reads ciphertext records from input-file, and writes them in the same
+// order to output-file. Records that are not encrypted with the primary key
+// of the keyset are decrypted with the keyset and encrypted with its primary
+// key. If the primary key has an output prefix, records with that prefix
+// are copied without decrypting them; with a RAW primary key all records
+// are re-encrypted.
+// Each record is a 4 byte big-endian length followed by the ciphertext.
+// It requires 5 arguments:
+//   keyset-file:  name of the file with the keyset, which must contain the
+//                 old keys and the new primary key
+//   input-file:  name of the file with the ciphertext records
+//   associated-data-file:  name of the file containing associated data,
+//                          which is the same for all records
+//   output-file:  name of the file for the resulting ciphertext records
+//   num-threads:  number of threads that re-encrypt records
+int main(int argc, char** argv) {
+  int num_threads = 0;
+  if (argc != 6 || !absl::SimpleAtoi(argv[5], &num_threads) ||
+      num_threads <= 0) {
+    std::clog << "Usage: " << argv[0]
+              << " keyset-file input-file associated-data-file output-file "
+              << "num-threads\n";
+    exit(1);
+  }
+  std::string keyset_filename(argv[1]);
+  std::string input_filename(argv[2]);
+  std::string associated_data_file(argv[3]);
+  std::string output_filename(argv[4]);
+  std::clog << "Using keyset from file " << keyset_filename
+            << " to re-encrypt the records of file " << input_filename
+            << " with associated data from file " << associated_data_file
+            << ".\n" << "The resulting records will be written to file "
+            << output_filename << std::endl;
+
+  // Init Tink;
+  CliUtil::InitTink();
+
+  // Read the keyset.
+  std::unique_ptr<KeysetHandle> keyset_handle =
+      CliUtil::ReadKeyset(keyset_filename);
+  std::string primary_prefix = GetPrimaryPrefix(*keyset_handle);
+  if (primary_prefix.empty()) {
+    std::clog << "The primary key is a RAW key, re-encrypting all records.\n";
+  }
+
+  // Get the primitive.
+  auto primitive_result = keyset_handle->GetPrimitive<Aead>();
+  if (!primitive_result.ok()) {
+    std::clog << "Getting AEAD-primitive from the factory failed: "
+              << primitive_result.status().error_message() << std::endl;
+    exit(1);
+  }
+  std::unique_ptr<Aead> aead = std::move(primitive_result.ValueOrDie());
+
+  std::string associated_data = CliUtil::Read(associated_data_file);
+  std::ifstream input(input_filename,
+                      std::ifstream::in | std::ifstream::binary);
+  if (!input.is_open()) {
+    std::clog << "Could not open " << input_filename << std::endl;
+    exit(1);
+  }
+  std::ofstream output(output_filename,
+                       std::ofstream::out | std::ofstream::binary);
+  if (!output.is_open()) {
+    std::clog << "Could not open " << output_filename << std::endl;
+    exit(1);
+  }
+
+  // Re-encrypt the records in batches, each batch split among the threads.
+  auto start = std::chrono::steady_clock::now();
+  int64_t total_records = 0;
+  int64_t total_reencrypted = 0;
+  int64_t total_bytes = 0;
+  std::vector<std::string> records(kBatchSize);
+  bool at_end = false;
+  while (!at_end) {
+    size_t batch_size = 0;
+    while (batch_size < records.size() &&
+           ReadRecord(&input, &records[batch_size])) {
+      total_bytes += records[batch_size].size();
+      batch_size++;
+    }
+    at_end = batch_size < records.size();
+    if (batch_size == 0) break;
+
+    size_t per_thread = (batch_size + num_threads - 1) / num_threads;
+    std::vector<crypto::tink::util::StatusOr<int64_t>> results(
+        num_threads, Status(crypto::tink::util::error::UNKNOWN, "not run"));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      size_t begin = std::min(batch_size, t * per_thread);
+      size_t end = std::min(batch_size, begin + per_thread);
+      threads.emplace_back([&, t, begin, end]() {
+        results[t] = ReencryptRecords(*aead, primary_prefix, associated_data,
+                                      &records, begin, end);
+      });
+    }
+    for (auto& thread : threads) thread.join();
+    for (const auto& result : results) {
+      if (!result.ok()) {
+        std::clog << "Error while re-encrypting the records starting at "
+                  << "record " << total_records << ": "
+                  << result.status().error_message() << std::endl;
+        exit(1);
+      }
+      total_reencrypted += result.ValueOrDie();
+    }
+    for (size_t i = 0; i < batch_size; i++) {
+      WriteRecord(records[i], &output);
+    }
+    if (!output) {
+      std::clog << "Error while writing " << output_filename << std::endl;
+      exit(1);
+    }
+    total_records += batch_size;
+
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    std::clog << "Processed " << total_records << " records ("
+              << total_reencrypted << " re-encrypted), "
+              << total_records / seconds << " records/s, "
+              << total_bytes / (1024.0 * 1024.0) / seconds << " MiB/s.\n";
+  }
+  output.close();
+  if (!output) {
+    std::clog << "Error while writing " << output_filename << std::endl;
+    exit(1);
+  }
+  std::clog << "All done.\n";
+  return 0;
+}